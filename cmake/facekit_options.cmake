@@ -22,4 +22,121 @@ OPTION(WITH_DOCS "Build doxygen documentation" OFF)
 # Build examples
 OPTION(WITH_EXAMPLES "Build examples executable" OFF)
 # Build unit test
-OPTION(WITH_TESTS "Build unit test targets" ON)
\ No newline at end of file
+OPTION(WITH_TESTS "Build unit test targets" ON)
+# Build microbenchmarks (Google Benchmark), default off
+OPTION(WITH_BENCHMARKS "Build facekit_benchmarks target" OFF)
+# Performance gate (facekit_perf_check), baseline recorded with facekit_perf_baseline
+SET(FACEKIT_PERF_BASELINE "${FACEKIT_SOURCE_DIR}/bench/baseline.json" CACHE FILEPATH "Benchmark baseline compared by facekit_perf_check")
+SET(FACEKIT_PERF_TOLERANCE 0.1 CACHE STRING "Relative slowdown tolerated by facekit_perf_check")
+SET(FACEKIT_PERF_THRESHOLDS "${FACEKIT_SOURCE_DIR}/bench/perf_thresholds.txt" CACHE FILEPATH "Per benchmark tolerances of facekit_perf_check")
+SET(FACEKIT_PERF_REPETITIONS 5 CACHE STRING "Repetitions of each benchmark run by facekit_perf_check")
+# Most verbose log level compiled in, 0 (error) to 5 (debug2)
+SET(FACEKIT_LOG_COMPILED_LEVEL 5 CACHE STRING "Most verbose log level compiled in, 0 (error) to 5 (debug2)")
+ADD_DEFINITIONS(-DFACEKIT_LOG_COMPILED_LEVEL=${FACEKIT_LOG_COMPILED_LEVEL})
+# Scoped tracing zones (FACEKIT_TRACE_SCOPE), compiled out when OFF
+OPTION(WITH_TRACING "Compile tracing zones in" ON)
+IF(NOT WITH_TRACING)
+  ADD_DEFINITIONS(-DFACEKIT_NO_TRACE)
+ENDIF(NOT WITH_TRACING)
+# io_uring backend for BatchFileReader (Linux only, detected at configure time)
+OPTION(WITH_IO_URING "Use io_uring for batched file reads when available" ON)
+# Remote file systems (http, https, s3) backed by libcurl
+OPTION(WITH_REMOTE_FS "Build HTTP/S3 file systems when libcurl is available" ON)
+# SIMD code paths in the vendored codecs (libjpeg-turbo needs nasm/yasm)
+OPTION(WITH_SIMD_CODECS "Build libjpeg-turbo and libpng with SIMD optimizations" ON)
+# WebP image codec backed by libwebp
+OPTION(WITH_WEBP "Build WebP codec when libwebp is available" ON)
+# Zstandard / LZ4 compression of serialized matrices (zlib is always built)
+OPTION(WITH_ZSTD "Compress matrices with zstd when libzstd is available" ON)
+OPTION(WITH_LZ4 "Compress matrices with lz4 when liblz4 is available" ON)
+# GPU backend (cuBLAS) for DeviceLinearAlgebra / DevicePCAModel
+OPTION(WITH_CUDA "Build the GPU linear algebra backend when the CUDA toolkit is available" ON)
+# ---[ Performance
+# Single precision pipeline: intermediate sums kept in double only for
+# headroom (i.e. mesh centroid) stay in float, and implicit float to double
+# promotions are reported (GCC / Clang)
+OPTION(WITH_FLOAT_ONLY "Keep float instantiations free of double precision arithmetic" OFF)
+IF(WITH_FLOAT_ONLY)
+  ADD_DEFINITIONS(-DFACEKIT_FLOAT_ONLY)
+  IF(NOT MSVC)
+    add_compile_options(-Wdouble-promotion)
+  ENDIF(NOT MSVC)
+ENDIF(WITH_FLOAT_ONLY)
+# Link time optimization, lets templates (LinearAlgebra, Mesh, Camera, ...)
+# be inlined across translation units
+OPTION(FACEKIT_ENABLE_LTO "Enable link time optimization" OFF)
+# Profile guided optimization: configure with FACEKIT_PGO_GENERATE, build and
+# run the `facekit_pgo_train` target (benchmark suite), then reconfigure the
+# same build folder with FACEKIT_PGO_USE and rebuild
+OPTION(FACEKIT_PGO_GENERATE "Instrument the build to collect an execution profile" OFF)
+OPTION(FACEKIT_PGO_USE "Optimize with the profile collected by FACEKIT_PGO_GENERATE" OFF)
+SET(FACEKIT_PGO_DIR "${CMAKE_BINARY_DIR}/pgo" CACHE PATH "Where execution profiles are stored")
+# Target architecture (i.e. native, haswell, x86-64-v3, armv8.2-a; AVX2 or
+# AVX512 for MSVC), empty for the compiler default. Binaries may then not run
+# on older CPUs, kernels selected at runtime (CpuInfo) are not affected.
+SET(FACEKIT_ARCH "" CACHE STRING "Target architecture passed to -march (/arch for MSVC)")
+mark_as_advanced(FACEKIT_PGO_DIR)
+IF(FACEKIT_PGO_GENERATE AND FACEKIT_PGO_USE)
+  MESSAGE(FATAL_ERROR "FACEKIT_PGO_GENERATE and FACEKIT_PGO_USE are exclusive")
+ENDIF(FACEKIT_PGO_GENERATE AND FACEKIT_PGO_USE)
+
+###############################################################################
+# Apply the performance options, called once the compiler specific flags are
+# set.
+macro(FACEKIT_APPLY_PERFORMANCE_OPTIONS)
+  SET(_perf_link_flags "")
+  # Architecture
+  IF(NOT "${FACEKIT_ARCH}" STREQUAL "")
+    IF(MSVC)
+      add_compile_options("/arch:${FACEKIT_ARCH}")
+    ELSE(MSVC)
+      add_compile_options("-march=${FACEKIT_ARCH}")
+    ENDIF(MSVC)
+    MESSAGE(STATUS "Target architecture: ${FACEKIT_ARCH}")
+  ENDIF(NOT "${FACEKIT_ARCH}" STREQUAL "")
+  # LTO
+  IF(FACEKIT_ENABLE_LTO)
+    IF(POLICY CMP0069)
+      cmake_policy(SET CMP0069 NEW)
+    ENDIF(POLICY CMP0069)
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT _ipo_ok OUTPUT _ipo_msg LANGUAGES CXX)
+    IF(_ipo_ok)
+      SET(CMAKE_INTERPROCEDURAL_OPTIMIZATION ON)
+      MESSAGE(STATUS "Link time optimization enabled")
+    ELSE(_ipo_ok)
+      MESSAGE(WARNING "Link time optimization not supported: ${_ipo_msg}")
+    ENDIF(_ipo_ok)
+  ENDIF(FACEKIT_ENABLE_LTO)
+  # PGO
+  IF(FACEKIT_PGO_GENERATE OR FACEKIT_PGO_USE)
+    file(MAKE_DIRECTORY "${FACEKIT_PGO_DIR}")
+    IF(FACEKIT_PGO_GENERATE AND NOT WITH_BENCHMARKS)
+      MESSAGE(STATUS "WITH_BENCHMARKS is OFF, run a representative workload to collect the profile")
+    ENDIF(FACEKIT_PGO_GENERATE AND NOT WITH_BENCHMARKS)
+    IF(CMAKE_COMPILER_IS_GNUCXX)
+      IF(FACEKIT_PGO_GENERATE)
+        SET(_pgo_flags "-fprofile-generate=${FACEKIT_PGO_DIR} -fprofile-update=atomic")
+      ELSE(FACEKIT_PGO_GENERATE)
+        SET(_pgo_flags "-fprofile-use=${FACEKIT_PGO_DIR} -fprofile-correction -Wno-missing-profile")
+      ENDIF(FACEKIT_PGO_GENERATE)
+    ELSEIF(CMAKE_COMPILER_IS_CLANG)
+      IF(FACEKIT_PGO_GENERATE)
+        SET(_pgo_flags "-fprofile-instr-generate=${FACEKIT_PGO_DIR}/facekit-%p.profraw")
+      ELSE(FACEKIT_PGO_GENERATE)
+        SET(_pgo_flags "-fprofile-instr-use=${FACEKIT_PGO_DIR}/facekit.profdata -Wno-profile-instr-unprofiled")
+      ENDIF(FACEKIT_PGO_GENERATE)
+    ELSE(CMAKE_COMPILER_IS_GNUCXX)
+      MESSAGE(WARNING "Profile guided optimization is only supported with GCC and Clang")
+      SET(_pgo_flags "")
+    ENDIF(CMAKE_COMPILER_IS_GNUCXX)
+    SET(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} ${_pgo_flags}")
+    SET(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} ${_pgo_flags}")
+    SET(_perf_link_flags "${_perf_link_flags} ${_pgo_flags}")
+  ENDIF(FACEKIT_PGO_GENERATE OR FACEKIT_PGO_USE)
+  IF(NOT "${_perf_link_flags}" STREQUAL "")
+    SET(CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} ${_perf_link_flags}")
+    SET(CMAKE_SHARED_LINKER_FLAGS "${CMAKE_SHARED_LINKER_FLAGS} ${_perf_link_flags}")
+    SET(CMAKE_MODULE_LINKER_FLAGS "${CMAKE_MODULE_LINKER_FLAGS} ${_perf_link_flags}")
+  ENDIF(NOT "${_perf_link_flags}" STREQUAL "")
+endmacro(FACEKIT_APPLY_PERFORMANCE_OPTIONS)
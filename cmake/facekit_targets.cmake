@@ -382,6 +382,116 @@ macro(FACEKIT_ADD_EXAMPLE _name)
     endif(WIN32 AND MSVC)
 endmacro(FACEKIT_ADD_EXAMPLE)
 
+###############################################################################
+# Add benchmark sources to the `facekit_benchmarks` target. Sources are
+# collected while the modules are configured, the executable itself is created
+# by FACEKIT_ADD_BENCHMARK_TARGET once every module has been processed.
+# _name The benchmark name.
+# ARGN :
+#    FILES the source files for the benchmark
+#    LINK_WITH link benchmark executable with libraries
+macro(FACEKIT_ADD_BENCHMARK _name)
+    set(options)
+    set(oneValueArgs)
+    set(multiValueArgs FILES LINK_WITH)
+    cmake_parse_arguments(FACEKIT_ADD_BENCHMARK "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN} )
+    foreach(_file ${FACEKIT_ADD_BENCHMARK_FILES})
+      get_filename_component(_abs_file ${_file} ABSOLUTE)
+      set_property(GLOBAL APPEND PROPERTY FACEKIT_BENCHMARK_FILES ${_abs_file})
+    endforeach(_file)
+    set_property(GLOBAL APPEND PROPERTY FACEKIT_BENCHMARK_LINK_WITH ${FACEKIT_ADD_BENCHMARK_LINK_WITH})
+endmacro(FACEKIT_ADD_BENCHMARK)
+
+###############################################################################
+# Add a standalone benchmark driver, an executable with its own `main` (i.e.
+# end-to-end throughput measurements) named `facekit_bench_<_name>`.
+# _name The driver name.
+# ARGN :
+#    FILES the source files for the driver
+#    LINK_WITH link driver executable with libraries
+macro(FACEKIT_ADD_BENCHMARK_DRIVER _name)
+    set(options)
+    set(oneValueArgs)
+    set(multiValueArgs FILES LINK_WITH)
+    cmake_parse_arguments(FACEKIT_ADD_BENCHMARK_DRIVER "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN} )
+    add_executable(facekit_bench_${_name} ${FACEKIT_ADD_BENCHMARK_DRIVER_FILES})
+    target_include_directories(facekit_bench_${_name} PRIVATE ${FACEKIT_OUTPUT_PROTO_DIR})
+    target_link_libraries(facekit_bench_${_name} PRIVATE ${FACEKIT_ADD_BENCHMARK_DRIVER_LINK_WITH} ${CLANG_LIBRARIES})
+    if(NOT (WIN32 AND MSVC))
+      target_link_libraries(facekit_bench_${_name} PRIVATE pthread)
+    endif()
+endmacro(FACEKIT_ADD_BENCHMARK_DRIVER)
+
+###############################################################################
+# Create the `facekit_benchmarks` executable from the sources registered with
+# FACEKIT_ADD_BENCHMARK. Requires Google Benchmark. Also adds the
+# `facekit_perf_check` gate and `facekit_perf_baseline` targets, comparing
+# against / recording FACEKIT_PERF_BASELINE.
+macro(FACEKIT_ADD_BENCHMARK_TARGET)
+    get_property(_bm_files GLOBAL PROPERTY FACEKIT_BENCHMARK_FILES)
+    get_property(_bm_libs GLOBAL PROPERTY FACEKIT_BENCHMARK_LINK_WITH)
+    IF(_bm_files)
+      FIND_PACKAGE(benchmark REQUIRED)
+      list(REMOVE_DUPLICATES _bm_libs)
+      add_executable(facekit_benchmarks ${_bm_files})
+      target_include_directories(facekit_benchmarks PRIVATE ${FACEKIT_OUTPUT_PROTO_DIR})
+      target_link_libraries(facekit_benchmarks PRIVATE ${_bm_libs} benchmark::benchmark_main ${CLANG_LIBRARIES})
+      if(NOT (WIN32 AND MSVC))
+        target_link_libraries(facekit_benchmarks PRIVATE pthread)
+      endif()
+      # Training run for profile guided optimization
+      IF(FACEKIT_PGO_GENERATE)
+        SET(_pgo_merge "")
+        IF(CMAKE_COMPILER_IS_CLANG)
+          FIND_PROGRAM(LLVM_PROFDATA_EXECUTABLE NAMES llvm-profdata)
+          IF(LLVM_PROFDATA_EXECUTABLE)
+            SET(_pgo_merge COMMAND ${CMAKE_COMMAND} -E chdir "${FACEKIT_PGO_DIR}" sh -c "${LLVM_PROFDATA_EXECUTABLE} merge -output=facekit.profdata *.profraw")
+          ELSE(LLVM_PROFDATA_EXECUTABLE)
+            MESSAGE(WARNING "llvm-profdata not found, profiles will need to be merged manually")
+          ENDIF(LLVM_PROFDATA_EXECUTABLE)
+        ENDIF(CMAKE_COMPILER_IS_CLANG)
+        add_custom_target(facekit_pgo_train
+                          COMMAND facekit_benchmarks
+                          ${_pgo_merge}
+                          WORKING_DIRECTORY "${FACEKIT_BINARY_DIR}"
+                          DEPENDS facekit_benchmarks
+                          COMMENT "Collecting execution profile in ${FACEKIT_PGO_DIR}")
+      ENDIF(FACEKIT_PGO_GENERATE)
+      # Performance gate: run the suite and compare it against the baseline,
+      # fails on regressions. `facekit_perf_baseline` records a new baseline.
+      IF(TARGET facekit_bench_perf_check)
+        SET(_perf_report "${FACEKIT_BINARY_DIR}/perf/current.json")
+        SET(_perf_run facekit_benchmarks
+                      --benchmark_out=${_perf_report}
+                      --benchmark_out_format=json
+                      --benchmark_repetitions=${FACEKIT_PERF_REPETITIONS}
+                      --benchmark_report_aggregates_only=true)
+        SET(_perf_thresholds "")
+        IF(EXISTS "${FACEKIT_PERF_THRESHOLDS}")
+          SET(_perf_thresholds -f "${FACEKIT_PERF_THRESHOLDS}")
+        ENDIF(EXISTS "${FACEKIT_PERF_THRESHOLDS}")
+        add_custom_target(facekit_perf_check
+                          COMMAND ${CMAKE_COMMAND} -E make_directory "${FACEKIT_BINARY_DIR}/perf"
+                          COMMAND ${_perf_run}
+                          COMMAND facekit_bench_perf_check -b "${FACEKIT_PERF_BASELINE}" -c "${_perf_report}" -t ${FACEKIT_PERF_TOLERANCE} ${_perf_thresholds}
+                          WORKING_DIRECTORY "${FACEKIT_BINARY_DIR}"
+                          DEPENDS facekit_benchmarks facekit_bench_perf_check
+                          COMMENT "Comparing benchmarks against ${FACEKIT_PERF_BASELINE}"
+                          VERBATIM)
+        add_custom_target(facekit_perf_baseline
+                          COMMAND ${CMAKE_COMMAND} -E make_directory "${FACEKIT_BINARY_DIR}/perf"
+                          COMMAND ${_perf_run}
+                          COMMAND ${CMAKE_COMMAND} -E copy "${_perf_report}" "${FACEKIT_PERF_BASELINE}"
+                          WORKING_DIRECTORY "${FACEKIT_BINARY_DIR}"
+                          DEPENDS facekit_benchmarks
+                          COMMENT "Recording benchmark baseline in ${FACEKIT_PERF_BASELINE}"
+                          VERBATIM)
+      ENDIF(TARGET facekit_bench_perf_check)
+    ENDIF(_bm_files)
+    set_property(GLOBAL PROPERTY FACEKIT_BENCHMARK_FILES "")
+    set_property(GLOBAL PROPERTY FACEKIT_BENCHMARK_LINK_WITH "")
+endmacro(FACEKIT_ADD_BENCHMARK_TARGET)
+
 ###############################################################################
 # Add compile flags to a target (because CMake doesn't provide something so
 # common itself).
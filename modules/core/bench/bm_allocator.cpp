@@ -0,0 +1,86 @@
+/**
+ *  @file   bm_allocator.cpp
+ *  @brief Microbenchmark for allocator throughput
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   07.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "facekit/core/mem/allocator.hpp"
+#include "facekit/core/mem/arena_allocator.hpp"
+
+namespace FK = FaceKit;
+
+/** Allocation alignment used by the benchmarks */
+static constexpr size_t kAlignment = 64;
+
+/** Allocate / release one block of `range(0)` bytes from a named allocator */
+static void BM_AllocatorRoundTrip(benchmark::State& state,
+                                  const std::string& name) {
+  FK::Allocator* a = FK::GetAllocator(name);
+  if (a == nullptr) {
+    state.SkipWithError(("Allocator not registered: " + name).c_str());
+    return;
+  }
+  const size_t sz = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    void* ptr = a->AllocateRaw(sz, kAlignment);
+    benchmark::DoNotOptimize(ptr);
+    a->DeallocateRaw(sz, ptr);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_AllocatorRoundTrip, default, "default_cpu_allocator")
+    ->RangeMultiplier(16)->Range(16, 1 << 24);
+BENCHMARK_CAPTURE(BM_AllocatorRoundTrip, pooled, "pooled_cpu_allocator")
+    ->RangeMultiplier(16)->Range(16, 1 << 24);
+BENCHMARK_CAPTURE(BM_AllocatorRoundTrip, huge_page, "huge_page_allocator")
+    ->RangeMultiplier(16)->Range(1 << 12, 1 << 24);
+
+/** Allocate a batch of 256 blocks then release them, mimic temporaries */
+static void BM_AllocatorBatch(benchmark::State& state,
+                              const std::string& name) {
+  FK::Allocator* a = FK::GetAllocator(name);
+  if (a == nullptr) {
+    state.SkipWithError(("Allocator not registered: " + name).c_str());
+    return;
+  }
+  const size_t sz = static_cast<size_t>(state.range(0));
+  std::vector<void*> ptrs(256, nullptr);
+  for (auto _ : state) {
+    for (auto& p : ptrs) {
+      p = a->AllocateRaw(sz, kAlignment);
+    }
+    benchmark::ClobberMemory();
+    for (auto& p : ptrs) {
+      a->DeallocateRaw(sz, p);
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * ptrs.size());
+}
+BENCHMARK_CAPTURE(BM_AllocatorBatch, default, "default_cpu_allocator")
+    ->RangeMultiplier(16)->Range(16, 1 << 16);
+BENCHMARK_CAPTURE(BM_AllocatorBatch, pooled, "pooled_cpu_allocator")
+    ->RangeMultiplier(16)->Range(16, 1 << 16);
+
+/** Same batch served by an arena, released at once with `Reset` */
+static void BM_ArenaAllocatorBatch(benchmark::State& state) {
+  FK::ArenaAllocator arena;
+  const size_t sz = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    for (int k = 0; k < 256; ++k) {
+      void* ptr = arena.AllocateRaw(sz, kAlignment);
+      benchmark::DoNotOptimize(ptr);
+    }
+    arena.Reset();
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * 256);
+}
+BENCHMARK(BM_ArenaAllocatorBatch)->RangeMultiplier(16)->Range(16, 1 << 12);
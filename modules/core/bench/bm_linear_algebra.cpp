@@ -0,0 +1,82 @@
+/**
+ *  @file   bm_linear_algebra.cpp
+ *  @brief Microbenchmark for LinearAlgebra Gemv/Gemm
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   07.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include "benchmark/benchmark.h"
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/math/linear_algebra.hpp"
+#include "facekit/core/sys/perf_counter.hpp"
+
+namespace FK = FaceKit;
+
+/** Seed used to generate fixture data, keep runs comparable */
+static constexpr uint64_t kSeed = 0x5EED;
+
+/** Fill a matrix with reproducible normally distributed values */
+template<typename T>
+static cv::Mat RandomMat(const int rows, const int cols) {
+  cv::Mat m(rows, cols, cv::DataType<T>::type);
+  cv::RNG rng(kSeed);
+  rng.fill(m, cv::RNG::NORMAL, T(0.0), T(1.0));
+  return m;
+}
+
+/**
+ *  Gemv, y = Ax with A [N x N]. Hardware counters of the calling thread are
+ *  reported per iteration when available, a low IPC with many LLC misses
+ *  indicates the product is memory-bound.
+ */
+template<typename T>
+static void BM_Gemv(benchmark::State& state) {
+  using LA = FK::LinearAlgebra<T>;
+  using TType = typename LA::TransposeType;
+  const int n = static_cast<int>(state.range(0));
+  const bool trans = state.range(1) != 0;
+  cv::Mat A = RandomMat<T>(n, n);
+  cv::Mat x = RandomMat<T>(n, 1);
+  cv::Mat y = cv::Mat::zeros(n, 1, cv::DataType<T>::type);
+  const TType ta = trans ? TType::kTranspose : TType::kNoTranspose;
+  FK::PerfCounterRegion counters;
+  for (auto _ : state) {
+    LA::Gemv(A, ta, T(1.0), x, T(0.0), &y);
+    benchmark::DoNotOptimize(y.data);
+  }
+  counters.Stop().Export(double(state.iterations()), &state.counters);
+  state.SetBytesProcessed(int64_t(state.iterations()) * n * n * sizeof(T));
+  state.SetItemsProcessed(int64_t(state.iterations()) * 2 * n * n);
+}
+BENCHMARK_TEMPLATE(BM_Gemv, float)
+    ->ArgsProduct({{64, 256, 1024, 4096}, {0, 1}});
+BENCHMARK_TEMPLATE(BM_Gemv, double)
+    ->ArgsProduct({{64, 256, 1024, 4096}, {0, 1}});
+
+/** Gemm, C = AB with A, B [N x N] */
+template<typename T>
+static void BM_Gemm(benchmark::State& state) {
+  using LA = FK::LinearAlgebra<T>;
+  using TType = typename LA::TransposeType;
+  const int n = static_cast<int>(state.range(0));
+  cv::Mat A = RandomMat<T>(n, n);
+  cv::Mat B = RandomMat<T>(n, n);
+  cv::Mat C = cv::Mat::zeros(n, n, cv::DataType<T>::type);
+  for (auto _ : state) {
+    LA::Gemm(A,
+             TType::kNoTranspose,
+             T(1.0),
+             B,
+             TType::kNoTranspose,
+             T(0.0),
+             &C);
+    benchmark::DoNotOptimize(C.data);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * 2 * n * n * n);
+}
+BENCHMARK_TEMPLATE(BM_Gemm, float)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_TEMPLATE(BM_Gemm, double)->RangeMultiplier(4)->Range(16, 1024);
@@ -0,0 +1,80 @@
+/**
+ *  @file   bm_nd_array.cpp
+ *  @brief Microbenchmark for NDArray creation and slicing
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   07.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "facekit/core/nd_array.hpp"
+
+namespace FK = FaceKit;
+
+/** Allocate a [N x N] array */
+static void BM_NDArrayCreate(benchmark::State& state) {
+  const size_t n = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    FK::NDArray array(FK::DataType::kFloat, {n, n});
+    benchmark::DoNotOptimize(array);
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * n * n * sizeof(float));
+}
+BENCHMARK(BM_NDArrayCreate)->RangeMultiplier(4)->Range(8, 2048);
+
+/** Build an array from a list of values */
+static void BM_NDArrayWithValues(benchmark::State& state) {
+  const size_t n = static_cast<size_t>(state.range(0));
+  std::vector<float> values(n);
+  for (size_t k = 0; k < n; ++k) {
+    values[k] = static_cast<float>(k);
+  }
+  for (auto _ : state) {
+    auto array = FK::NDArray::WithValues<float>(values);
+    benchmark::DoNotOptimize(array);
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * n * sizeof(float));
+}
+BENCHMARK(BM_NDArrayWithValues)->RangeMultiplier(8)->Range(64, 1 << 20);
+
+/** Slice along the first axis, no copy expected */
+static void BM_NDArraySlice(benchmark::State& state) {
+  const size_t n = static_cast<size_t>(state.range(0));
+  FK::NDArray array(FK::DataType::kFloat, {n, 64});
+  for (auto _ : state) {
+    auto slice = array.Slice(n / 4, 3 * n / 4);
+    benchmark::DoNotOptimize(slice);
+  }
+}
+BENCHMARK(BM_NDArraySlice)->RangeMultiplier(8)->Range(64, 1 << 14);
+
+/** Strided view, every other row / column */
+static void BM_NDArrayView(benchmark::State& state) {
+  using Range = FK::NDArray::Range;
+  const size_t n = static_cast<size_t>(state.range(0));
+  FK::NDArray array(FK::DataType::kFloat, {n, n});
+  for (auto _ : state) {
+    auto view = array.View({Range(0, n, 2), Range(0, n, 2)});
+    benchmark::DoNotOptimize(view);
+  }
+}
+BENCHMARK(BM_NDArrayView)->RangeMultiplier(8)->Range(64, 4096);
+
+/** Deep copy of a strided view into a contiguous array */
+static void BM_NDArrayDeepCopyView(benchmark::State& state) {
+  using Range = FK::NDArray::Range;
+  const size_t n = static_cast<size_t>(state.range(0));
+  FK::NDArray array(FK::DataType::kFloat, {n, n});
+  auto view = array.View({Range(0, n, 2), Range(0, n, 2)});
+  FK::NDArray dst;
+  for (auto _ : state) {
+    view.DeepCopy(&dst);
+    benchmark::DoNotOptimize(dst);
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) *
+                          (n / 2) * (n / 2) * sizeof(float));
+}
+BENCHMARK(BM_NDArrayDeepCopyView)->RangeMultiplier(4)->Range(64, 4096);
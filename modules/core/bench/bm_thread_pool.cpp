@@ -0,0 +1,95 @@
+/**
+ *  @file   bm_thread_pool.cpp
+ *  @brief Microbenchmark for ThreadPool enqueue latency
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   07.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "facekit/core/thread_pool.hpp"
+
+namespace FK = FaceKit;
+using TaskPriority = FK::ThreadPool::TaskPriority;
+
+/** Round trip: enqueue an empty task and wait for its result */
+static void BM_ThreadPoolEnqueueWait(benchmark::State& state) {
+  auto& pool = FK::ThreadPool::Get();
+  for (auto _ : state) {
+    auto f = pool.Enqueue(TaskPriority::kNormal, []() { return 1; });
+    benchmark::DoNotOptimize(f.get());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ThreadPoolEnqueueWait)->UseRealTime();
+
+/** Enqueue a burst of `range(0)` tasks, then wait for all of them */
+static void BM_ThreadPoolEnqueueBurst(benchmark::State& state) {
+  auto& pool = FK::ThreadPool::Get();
+  const int n = static_cast<int>(state.range(0));
+  std::vector<std::future<int>> futures;
+  futures.reserve(n);
+  for (auto _ : state) {
+    for (int k = 0; k < n; ++k) {
+      futures.push_back(pool.Enqueue(TaskPriority::kNormal,
+                                     [](const int& i) { return i; },
+                                     k));
+    }
+    for (auto& f : futures) {
+      benchmark::DoNotOptimize(f.get());
+    }
+    futures.clear();
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n);
+}
+BENCHMARK(BM_ThreadPoolEnqueueBurst)->RangeMultiplier(8)->Range(8, 4096)
+    ->UseRealTime();
+
+/** Fire-and-forget submission, completion tracked by a counter */
+static void BM_ThreadPoolSubmit(benchmark::State& state) {
+  auto& pool = FK::ThreadPool::Get();
+  const int n = static_cast<int>(state.range(0));
+  std::atomic<int> done(0);
+  for (auto _ : state) {
+    done.store(0, std::memory_order_relaxed);
+    for (int k = 0; k < n; ++k) {
+      pool.Submit(TaskPriority::kNormal, [&done]() {
+        done.fetch_add(1, std::memory_order_release);
+      });
+    }
+    while (done.load(std::memory_order_acquire) != n) {
+      if (!pool.RunPendingTask()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n);
+}
+BENCHMARK(BM_ThreadPoolSubmit)->RangeMultiplier(8)->Range(8, 4096)
+    ->UseRealTime();
+
+/** ParallelFor over `range(0)` elements with trivial body */
+static void BM_ThreadPoolParallelFor(benchmark::State& state) {
+  auto& pool = FK::ThreadPool::Get();
+  const size_t n = static_cast<size_t>(state.range(0));
+  std::vector<float> data(n, 1.f);
+  for (auto _ : state) {
+    pool.ParallelFor(0, n, 0, [&data](const size_t& b, const size_t& e) {
+      for (size_t i = b; i < e; ++i) {
+        data[i] *= 1.0001f;
+      }
+    });
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n);
+}
+BENCHMARK(BM_ThreadPoolParallelFor)->RangeMultiplier(16)->Range(1 << 10, 1 << 22)
+    ->UseRealTime();
@@ -0,0 +1,333 @@
+/**
+ *  @file   perf_check.cpp
+ *  @brief  Compare a Google Benchmark JSON report against a stored baseline
+ *          and flag the benchmarks that got slower than a tolerance. Exit
+ *          code is non zero if any regression is found, to gate changes.
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/util/json_util.h"
+
+#include "facekit/core/cmd_parser.hpp"
+#include "facekit/core/logger.hpp"
+#include "benchmark_report.pb.h"
+
+namespace FK = FaceKit;
+
+/**
+ *  @struct Measure
+ *  @brief  Time of one benchmark in a report
+ */
+struct Measure {
+  /** Time per iteration in nanoseconds */
+  double time = 0.0;
+  /** The benchmark reported an error */
+  bool error = false;
+};
+
+/** Measures in order of appearance */
+using Report = std::vector<std::pair<std::string, Measure>>;
+
+/**
+ *  @struct Threshold
+ *  @brief  Tolerance of the benchmarks whose name starts with `prefix`
+ */
+struct Threshold {
+  /** Benchmark name prefix */
+  std::string prefix;
+  /** Relative slowdown tolerated */
+  double tolerance;
+};
+
+/**
+ *  @name   UnitToNs
+ *  @fn     static double UnitToNs(const std::string& unit)
+ *  @brief  Nanoseconds in a Google Benchmark time unit
+ */
+static double UnitToNs(const std::string& unit) {
+  if (unit == "us") {
+    return 1e3;
+  } else if (unit == "ms") {
+    return 1e6;
+  } else if (unit == "s") {
+    return 1e9;
+  }
+  return 1.0;
+}
+
+/**
+ *  @name   Median
+ *  @fn     static double Median(std::vector<double>* v)
+ *  @brief  Median of `v`, sorted in place
+ */
+static double Median(std::vector<double>* v) {
+  if (v->empty()) {
+    return 0.0;
+  }
+  std::sort(v->begin(), v->end());
+  const size_t n = v->size();
+  return n % 2 ? (*v)[n / 2] : 0.5 * ((*v)[n / 2 - 1] + (*v)[n / 2]);
+}
+
+/**
+ *  @name   LoadReport
+ *  @fn     static int LoadReport(const std::string& path, const bool& cpu,
+                                  Report* report)
+ *  @brief  Load a JSON report. Benchmarks run with repetitions are reduced
+ *          to their median, the `median` aggregate is used if present.
+ *  @param[in] path   Report file
+ *  @param[in] cpu    Use CPU time instead of wall time
+ *  @param[out] report  Time of each benchmark
+ *  @return -1 if error, 0 otherwise
+ */
+static int LoadReport(const std::string& path,
+                      const bool& cpu,
+                      Report* report) {
+  std::ifstream stream(path.c_str());
+  if (!stream.is_open()) {
+    FACEKIT_LOG_ERROR("Unable to open " << path);
+    return -1;
+  }
+  std::stringstream content;
+  content << stream.rdbuf();
+  FK::BenchmarkReportProto proto;
+  google::protobuf::util::JsonParseOptions options;
+  options.ignore_unknown_fields = true;
+  const auto s = google::protobuf::util::JsonStringToMessage(content.str(),
+                                                             &proto,
+                                                             options);
+  if (!s.ok()) {
+    FACEKIT_LOG_ERROR("Unable to parse " << path << ": " << s.ToString());
+    return -1;
+  }
+  // Gather repetitions and aggregates of each benchmark
+  std::unordered_map<std::string, size_t> index;
+  std::vector<std::vector<double>> repetitions;
+  std::vector<std::pair<bool, double>> medians;
+  report->clear();
+  for (const auto& run : proto.benchmarks()) {
+    const std::string& name = run.run_name().empty() ?
+                              run.name() :
+                              run.run_name();
+    auto it = index.find(name);
+    if (it == index.end()) {
+      it = index.emplace(name, report->size()).first;
+      report->emplace_back(name, Measure());
+      repetitions.emplace_back();
+      medians.emplace_back(false, 0.0);
+    }
+    Measure& m = (*report)[it->second].second;
+    m.error |= run.error_occurred();
+    const double t = (cpu ? run.cpu_time() : run.real_time()) *
+                     UnitToNs(run.time_unit());
+    if (run.run_type() == "aggregate") {
+      if (run.aggregate_name() == "median") {
+        medians[it->second] = std::make_pair(true, t);
+      }
+    } else if (!run.error_occurred()) {
+      repetitions[it->second].push_back(t);
+    }
+  }
+  for (size_t k = 0; k < report->size(); ++k) {
+    (*report)[k].second.time = medians[k].first ?
+                               medians[k].second :
+                               Median(&repetitions[k]);
+  }
+  return 0;
+}
+
+/**
+ *  @name   LoadThresholds
+ *  @fn     static int LoadThresholds(const std::string& path,
+                                      std::vector<Threshold>* thresholds)
+ *  @brief  Load per benchmark tolerances, one `<prefix> <tolerance>` pair
+ *          per line, `#` starts a comment
+ *  @return -1 if error, 0 otherwise
+ */
+static int LoadThresholds(const std::string& path,
+                          std::vector<Threshold>* thresholds) {
+  std::ifstream stream(path.c_str());
+  if (!stream.is_open()) {
+    FACEKIT_LOG_ERROR("Unable to open " << path);
+    return -1;
+  }
+  std::string line;
+  size_t n_line = 0;
+  while (std::getline(stream, line)) {
+    n_line += 1;
+    line = line.substr(0, line.find('#'));
+    std::istringstream str(line);
+    Threshold t;
+    if (!(str >> t.prefix)) {
+      continue;
+    }
+    if (!(str >> t.tolerance) || t.tolerance < 0.0) {
+      FACEKIT_LOG_ERROR("Invalid threshold at " << path << ":" << n_line);
+      return -1;
+    }
+    thresholds->push_back(t);
+  }
+  return 0;
+}
+
+/**
+ *  @name   Tolerance
+ *  @fn     static double Tolerance(const std::string& name,
+                                    const std::vector<Threshold>& thresholds,
+                                    const double& fallback)
+ *  @brief  Tolerance of a benchmark, the longest matching prefix wins
+ */
+static double Tolerance(const std::string& name,
+                        const std::vector<Threshold>& thresholds,
+                        const double& fallback) {
+  double tolerance = fallback;
+  size_t longest = 0;
+  for (const auto& t : thresholds) {
+    if (t.prefix.size() > longest && name.compare(0,
+                                                  t.prefix.size(),
+                                                  t.prefix) == 0) {
+      longest = t.prefix.size();
+      tolerance = t.tolerance;
+    }
+  }
+  return tolerance;
+}
+
+/**
+ *  @name   FormatTime
+ *  @fn     static std::string FormatTime(const double& ns)
+ *  @brief  Human readable time
+ */
+static std::string FormatTime(const double& ns) {
+  static const char* kUnits[] = {"ns", "us", "ms", "s"};
+  double v = ns;
+  size_t u = 0;
+  while (v >= 1000.0 && u < 3) {
+    v /= 1000.0;
+    u += 1;
+  }
+  std::ostringstream str;
+  str << std::fixed << std::setprecision(v < 10.0 ? 2 : 1) << v << " "
+      << kUnits[u];
+  return str.str();
+}
+
+int main(const int argc, const char** argv) {
+  using ArgState = FK::CmdLineParser::ArgState;
+  FK::CmdLineParser parser;
+  parser.AddArgument("-b", ArgState::kNeeded, "Baseline JSON report");
+  parser.AddArgument("-c", ArgState::kNeeded, "Current JSON report");
+  double tolerance = 0.1;
+  parser.AddArgument("-t",
+                     ArgState::kOptional,
+                     "Relative slowdown tolerated (default: 0.1)",
+                     &tolerance);
+  parser.AddArgument("-f",
+                     ArgState::kOptional,
+                     "Per benchmark tolerances, `<prefix> <tolerance>` lines");
+  parser.AddArgument("-m",
+                     ArgState::kOptional,
+                     "Compared time, `real` or `cpu` (default: real)");
+  int err = parser.ParseCmdLine(argc, argv);
+  if (err) {
+    FACEKIT_LOG_ERROR("Unable to parse command line!");
+    return err;
+  }
+  std::string baseline_path, current_path, thresholds_path, metric;
+  parser.HasArgument("-b", &baseline_path);
+  parser.HasArgument("-c", &current_path);
+  parser.HasArgument("-f", &thresholds_path);
+  parser.HasArgument("-m", &metric);
+  const bool cpu = metric == "cpu";
+  std::vector<Threshold> thresholds;
+  Report baseline, current;
+  if ((!thresholds_path.empty() &&
+       LoadThresholds(thresholds_path, &thresholds) != 0) ||
+      LoadReport(baseline_path, cpu, &baseline) != 0 ||
+      LoadReport(current_path, cpu, &current) != 0) {
+    return -1;
+  }
+
+  // Compare, in the order of the current report
+  std::unordered_map<std::string, const Measure*> base;
+  size_t width = 9;
+  for (const auto& b : baseline) {
+    base.emplace(b.first, &b.second);
+    width = std::max(width, b.first.size());
+  }
+  for (const auto& c : current) {
+    width = std::max(width, c.first.size());
+  }
+  size_t n_regression = 0, n_improvement = 0, n_new = 0, n_error = 0;
+  std::cout << std::left << std::setw(width + 2) << "Benchmark"
+            << std::right << std::setw(12) << "Baseline"
+            << std::setw(12) << "Current" << std::setw(10) << "Delta"
+            << "  Status" << std::endl;
+  for (const auto& c : current) {
+    std::cout << std::left << std::setw(width + 2) << c.first << std::right;
+    const auto it = base.find(c.first);
+    const Measure* ref = nullptr;
+    if (it != base.end()) {
+      ref = it->second;
+      base.erase(it);
+    }
+    if (c.second.error) {
+      n_error += 1;
+      std::cout << std::setw(34) << "" << "  ERROR" << std::endl;
+      continue;
+    }
+    if (ref == nullptr || ref->error || ref->time <= 0.0) {
+      n_new += 1;
+      std::cout << std::setw(12) << "-"
+                << std::setw(12) << FormatTime(c.second.time)
+                << std::setw(10) << "-" << "  NEW" << std::endl;
+      continue;
+    }
+    const double delta = (c.second.time - ref->time) / ref->time;
+    const double limit = Tolerance(c.first, thresholds, tolerance);
+    const char* status = "OK";
+    if (delta > limit) {
+      status = "REGRESSION";
+      n_regression += 1;
+    } else if (delta < -limit) {
+      status = "IMPROVED";
+      n_improvement += 1;
+    }
+    std::ostringstream pct;
+    pct << std::showpos << std::fixed << std::setprecision(1)
+        << 100.0 * delta << "%";
+    std::cout << std::setw(12) << FormatTime(ref->time)
+              << std::setw(12) << FormatTime(c.second.time)
+              << std::setw(10) << pct.str() << "  " << status << std::endl;
+  }
+  // Benchmarks gone since the baseline was recorded
+  for (const auto& b : baseline) {
+    if (base.count(b.first)) {
+      std::cout << std::left << std::setw(width + 2) << b.first
+                << std::right << std::setw(12) << FormatTime(b.second.time)
+                << std::setw(12) << "-" << std::setw(10) << "-"
+                << "  MISSING" << std::endl;
+    }
+  }
+  std::cout << std::endl << current.size() << " benchmarks, "
+            << n_regression << " regressions, " << n_improvement
+            << " improvements, " << n_new << " new, " << n_error
+            << " errors, " << base.size() << " missing (tolerance "
+            << 100.0 * tolerance << "%, " << (cpu ? "cpu" : "real")
+            << " time)" << std::endl;
+  return (n_regression > 0 || n_error > 0) ? 1 : 0;
+}
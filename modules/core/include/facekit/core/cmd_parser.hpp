@@ -10,6 +10,7 @@
 #ifndef __FACEKIT_CMD_PARSER__
 #define __FACEKIT_CMD_PARSER__
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -23,7 +24,12 @@ namespace FaceKit {
   
 /**
  *  @class  CmdLineParser
- *  @brief  Utility class to parse command line argument
+ *  @brief  Utility class to parse command line argument. Arguments can be
+ *          bound to a typed variable (i.e. a field of the tool's
+ *          configuration struct), values are then converted and validated
+ *          once while parsing. Values can also come from a configuration
+ *          file. Once parsed, the bound variables are plain data and can be
+ *          read concurrently without touching the parser.
  *  @author Christophe Ecabert
  *  @date   12/11/15
  */
@@ -57,6 +63,11 @@ class FK_EXPORTS CmdLineParser {
     ArgState state;
     /** Description */
     std::string description;
+    /** Value has been given, on the command line or in a configuration
+        file */
+    bool present = false;
+    /** Convert the value into the bound variable, empty if not bound */
+    std::function<bool(const std::string&)> assign;
 
     /**
      *  @name Args
@@ -118,16 +129,57 @@ class FK_EXPORTS CmdLineParser {
                   const ArgState& state,
                   const std::string& description);
 
+  /**
+   *  @name AddArgument
+   *  @fn template<typename T> int AddArgument(const std::string& key,
+                                               const ArgState& state,
+                                               const std::string& description,
+                                               T* value)
+   *  @brief  Add an argument bound to a variable. Its value is converted
+   *          once while parsing and parsing fails if it is not a valid `T`.
+   *          `value` is left untouched if the argument is not given, so it
+   *          holds the default.
+   *  @param[in]  key         Char flag indicating for this argument
+   *  @param[in]  state       Argument's state #ArgState
+   *  @param[in]  description Description of the arguments
+   *  @param[out] value       Bound variable, must outlive the parsing. One of
+   *                          `int`, `int64_t`, `size_t`, `float`, `double`,
+   *                          `bool` (true/false, 1/0, yes/no, on/off) or
+   *                          `std::string`
+   *  @tparam T   Value type
+   *  @return Return -1 of key already set, 0 otherwise
+   */
+  template<typename T>
+  int AddArgument(const std::string& key,
+                  const ArgState& state,
+                  const std::string& description,
+                  T* value);
+
   /**
    *  @name ParseCmdLine
    *  @fn int ParseCmdLine(const int argc, const char** argv)
-   *  @brief  Parse command line argument
+   *  @brief  Parse command line argument. Values given on the command line
+   *          override the ones read by `ParseConfigFile`, required arguments
+   *          can be given by either.
    *  @param[in]  argc  Number of element in the command line
    *  @param[in]  argv  Elements in the command line
    *  @return -1 If error, 0 otherwise
    */
   int ParseCmdLine(const int argc, const char** argv);
 
+  /**
+   *  @name ParseConfigFile
+   *  @fn int ParseConfigFile(const std::string& path)
+   *  @brief  Read argument values from a file, one `<key> <value>` pair per
+   *          line where the key may omit its leading '-' and the value runs
+   *          to the end of the line. `#` starts a comment. Call before
+   *          `ParseCmdLine` so the command line takes precedence.
+   *  @param[in]  path  Configuration file
+   *  @return -1 If the file can not be read, holds an unknown key or an
+   *          invalid value, 0 otherwise
+   */
+  int ParseConfigFile(const std::string& path);
+
   /**
    *  @name HasArgument
    *  @fn bool HasArgument(const std::string& key, std::string* value) const;
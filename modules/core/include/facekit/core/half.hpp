@@ -0,0 +1,175 @@
+/**
+ *  @file   half.hpp
+ *  @brief IEEE 754 half precision floating point storage type
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   06.03.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_HALF__
+#define __FACEKIT_HALF__
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @name   FloatToHalfBits
+ *  @fn     inline uint16_t FloatToHalfBits(const float& value)
+ *  @brief  Convert a float into half precision bits, round to nearest even.
+ *          Overflow gives infinity, NaN are preserved (quiet).
+ *  @param[in] value  Value to convert
+ *  @return Half precision bits
+ */
+inline uint16_t FloatToHalfBits(const float& value) {
+  uint32_t f;
+  std::memcpy(&f, &value, sizeof(f));
+  const uint32_t sign = f & 0x80000000u;
+  f ^= sign;
+  uint16_t h;
+  if (f >= (143u << 23)) {
+    // Inf / NaN / Overflow
+    h = f > (255u << 23) ? 0x7E00u : 0x7C00u;
+  } else if (f < (113u << 23)) {
+    // Subnormal / zero, let the FPU do the rounding
+    const uint32_t magic_u = 126u << 23;
+    float magic, fv;
+    std::memcpy(&magic, &magic_u, sizeof(magic));
+    std::memcpy(&fv, &f, sizeof(fv));
+    fv += magic;
+    std::memcpy(&f, &fv, sizeof(f));
+    h = static_cast<uint16_t>(f - magic_u);
+  } else {
+    // Normal, rebias exponent + round to nearest even
+    const uint32_t odd = (f >> 13) & 1u;
+    f -= 112u << 23;
+    f += 0xFFFu + odd;
+    h = static_cast<uint16_t>(f >> 13);
+  }
+  return static_cast<uint16_t>(h | (sign >> 16));
+}
+
+/**
+ *  @name   HalfBitsToFloat
+ *  @fn     inline float HalfBitsToFloat(const uint16_t& bits)
+ *  @brief  Convert half precision bits into float (exact)
+ *  @param[in] bits Half precision bits
+ *  @return Float value
+ */
+inline float HalfBitsToFloat(const uint16_t& bits) {
+  const uint32_t shifted_exp = 0x7C00u << 13;
+  uint32_t o = (bits & 0x7FFFu) << 13;
+  const uint32_t exp = shifted_exp & o;
+  o += 112u << 23;
+  if (exp == shifted_exp) {
+    // Inf / NaN
+    o += 112u << 23;
+  } else if (exp == 0) {
+    // Subnormal / zero, renormalize
+    const uint32_t magic_u = 113u << 23;
+    float magic, fv;
+    o += 1u << 23;
+    std::memcpy(&magic, &magic_u, sizeof(magic));
+    std::memcpy(&fv, &o, sizeof(fv));
+    fv -= magic;
+    std::memcpy(&o, &fv, sizeof(o));
+  }
+  o |= static_cast<uint32_t>(bits & 0x8000u) << 16;
+  float f;
+  std::memcpy(&f, &o, sizeof(f));
+  return f;
+}
+
+/**
+ *  @name   FloatToBFloat16Bits
+ *  @fn     inline uint16_t FloatToBFloat16Bits(const float& value)
+ *  @brief  Convert a float into bfloat16 bits (upper half of the float),
+ *          round to nearest even. NaN are preserved (quiet).
+ *  @param[in] value  Value to convert
+ *  @return bfloat16 bits
+ */
+inline uint16_t FloatToBFloat16Bits(const float& value) {
+  uint32_t f;
+  std::memcpy(&f, &value, sizeof(f));
+  if ((f & 0x7FFFFFFFu) > 0x7F800000u) {
+    return static_cast<uint16_t>((f >> 16) | 0x40u);
+  }
+  f += 0x7FFFu + ((f >> 16) & 1u);
+  return static_cast<uint16_t>(f >> 16);
+}
+
+/**
+ *  @name   BFloat16BitsToFloat
+ *  @fn     inline float BFloat16BitsToFloat(const uint16_t& bits)
+ *  @brief  Convert bfloat16 bits into float (exact)
+ *  @param[in] bits bfloat16 bits
+ *  @return Float value
+ */
+inline float BFloat16BitsToFloat(const uint16_t& bits) {
+  const uint32_t o = static_cast<uint32_t>(bits) << 16;
+  float f;
+  std::memcpy(&f, &o, sizeof(f));
+  return f;
+}
+
+/**
+ *  @struct  Half
+ *  @brief  Half precision floating point number (16 bits). Storage type only,
+ *          arithmetic is done in float through the implicit conversion.
+ *  @author Christophe Ecabert
+ *  @date   06.03.18
+ *  @ingroup core
+ */
+struct Half {
+  /**
+   *  @name   Half
+   *  @fn     Half(void) = default
+   *  @brief  Constructor, uninitialized like any built-in type
+   */
+  Half(void) = default;
+
+  /**
+   *  @name   Half
+   *  @fn     template<typename T> explicit Half(const T& value)
+   *  @brief  Constructor from any arithmetic type
+   *  @param[in] value  Value to convert
+   */
+  template<typename T>
+  explicit Half(const T& value) :
+          bits(FloatToHalfBits(static_cast<float>(value))) {}
+
+  /**
+   *  @name   FromBits
+   *  @fn     static Half FromBits(const uint16_t& bits)
+   *  @brief  Create from raw bits
+   *  @param[in] bits Half precision bits
+   *  @return Half number
+   */
+  static Half FromBits(const uint16_t& bits) {
+    Half h;
+    h.bits = bits;
+    return h;
+  }
+
+  /**
+   *  @name   operator float
+   *  @fn     operator float(void) const
+   *  @brief  Convert to single precision
+   */
+  operator float(void) const {
+    return HalfBitsToFloat(bits);
+  }
+
+  /** Raw bits */
+  uint16_t bits;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_HALF__ */
@@ -0,0 +1,267 @@
+/**
+ *  @file   inline_task.hpp
+ *  @brief Move-only callable wrapper with small buffer storage
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   17.12.17
+ *    Copyright © 2017 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_INLINE_TASK__
+#define __FACEKIT_INLINE_TASK__
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "facekit/core/library_export.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  InlineTask
+ *  @brief  Type-erased, move-only `void()` callable. Callables small enough
+ *          are stored inline, which avoids the heap allocation done by
+ *          `std::function`. Larger ones fall back to the heap.
+ *  @author Christophe Ecabert
+ *  @date   17.12.17
+ *  @ingroup core
+ */
+class FK_EXPORTS InlineTask {
+ public:
+
+  /** Size of the inline storage, the whole object spans one cache line */
+  static constexpr std::size_t kInlineSize = 64 - sizeof(void*);
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   InlineTask
+   *  @fn     InlineTask(void)
+   *  @brief  Constructor, create an empty task
+   */
+  InlineTask(void) : ops_(nullptr) {}
+
+  /**
+   *  @name   InlineTask
+   *  @fn     InlineTask(F&& fn)
+   *  @brief  Constructor, wrap a given callable
+   *  @param[in] fn Callable to wrap
+   *  @tparam F Callable type, invocable as `void()`
+   */
+  template<typename F,
+           typename = typename std::enable_if<!std::is_same<
+                        typename std::decay<F>::type,
+                        InlineTask>::value>::type>
+  InlineTask(F&& fn) : ops_(nullptr) {
+    using Fcn = typename std::decay<F>::type;
+    using Impl = OpsImpl<Fcn, IsInline<Fcn>::value>;
+    Impl::Create(&storage_, std::forward<F>(fn));
+    ops_ = &Impl::ops;
+  }
+
+  /**
+   *  @name   InlineTask
+   *  @fn     InlineTask(const InlineTask& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  InlineTask(const InlineTask& other) = delete;
+
+  /**
+   *  @name   InlineTask
+   *  @fn     InlineTask(InlineTask&& other)
+   *  @brief  Move constructor
+   *  @param[in] other  Object to move from
+   */
+  InlineTask(InlineTask&& other) : ops_(other.ops_) {
+    if (ops_) {
+      ops_->move(&storage_, &other.storage_);
+      other.ops_ = nullptr;
+    }
+  }
+
+  /**
+   *  @name   operator=
+   *  @fn     InlineTask& operator=(const InlineTask& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  InlineTask& operator=(const InlineTask& rhs) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     InlineTask& operator=(InlineTask&& rhs)
+   *  @brief  Move assignment operator
+   *  @param[in] rhs  Object to move-assign from
+   *  @return Newly moved-assign object
+   */
+  InlineTask& operator=(InlineTask&& rhs) {
+    if (this != &rhs) {
+      this->Reset();
+      if (rhs.ops_) {
+        rhs.ops_->move(&storage_, &rhs.storage_);
+        ops_ = rhs.ops_;
+        rhs.ops_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  /**
+   *  @name   ~InlineTask
+   *  @fn     ~InlineTask(void)
+   *  @brief  Destructor
+   */
+  ~InlineTask(void) {
+    this->Reset();
+  }
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   operator()
+   *  @fn     void operator()(void)
+   *  @brief  Invoke the wrapped callable, task must not be empty
+   */
+  void operator()(void) {
+    ops_->invoke(&storage_);
+  }
+
+  /**
+   *  @name   Reset
+   *  @fn     void Reset(void)
+   *  @brief  Release the wrapped callable
+   */
+  void Reset(void) {
+    if (ops_) {
+      ops_->destroy(&storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  /**
+   *  @name   operator bool
+   *  @fn     explicit operator bool(void) const
+   *  @brief  Indicate if a callable is wrapped
+   */
+  explicit operator bool(void) const {
+    return ops_ != nullptr;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+
+  /** Storage type */
+  using Storage = typename std::aligned_storage<kInlineSize,
+                                                alignof(std::max_align_t)>::type;
+
+  /**
+   *  @struct  Ops
+   *  @brief  Operations table for a given callable type
+   */
+  struct Ops {
+    /** Call */
+    void (*invoke)(Storage* s);
+    /** Move from `src` into uninitialized `dst` and destroy `src` */
+    void (*move)(Storage* dst, Storage* src);
+    /** Destroy */
+    void (*destroy)(Storage* s);
+  };
+
+  /**
+   *  @struct  IsInline
+   *  @brief  Indicate if a callable of type `F` fits into the inline storage
+   *  @tparam F Callable type
+   */
+  template<typename F>
+  struct IsInline {
+    /** Result */
+    static constexpr bool value = sizeof(F) <= kInlineSize &&
+                                  alignof(F) <= alignof(Storage) &&
+                                  std::is_nothrow_move_constructible<F>::value;
+  };
+
+  /**
+   *  @struct  OpsImpl
+   *  @brief  Operation for callable stored inline
+   *  @tparam F Callable type
+   *  @tparam Inline  Indicate if storage is inline or on the heap
+   */
+  template<typename F, bool Inline>
+  struct OpsImpl {
+    template<typename U>
+    static void Create(Storage* s, U&& fn) {
+      new (s) F(std::forward<U>(fn));
+    }
+    static void Invoke(Storage* s) {
+      (*reinterpret_cast<F*>(s))();
+    }
+    static void Move(Storage* dst, Storage* src) {
+      F* f = reinterpret_cast<F*>(src);
+      new (dst) F(std::move(*f));
+      f->~F();
+    }
+    static void Destroy(Storage* s) {
+      reinterpret_cast<F*>(s)->~F();
+    }
+    /** Operation table */
+    static const Ops ops;
+  };
+
+  /**
+   *  @struct  OpsImpl
+   *  @brief  Operation for callable stored on the heap
+   *  @tparam F Callable type
+   */
+  template<typename F>
+  struct OpsImpl<F, false> {
+    template<typename U>
+    static void Create(Storage* s, U&& fn) {
+      *reinterpret_cast<F**>(s) = new F(std::forward<U>(fn));
+    }
+    static void Invoke(Storage* s) {
+      (**reinterpret_cast<F**>(s))();
+    }
+    static void Move(Storage* dst, Storage* src) {
+      *reinterpret_cast<F**>(dst) = *reinterpret_cast<F**>(src);
+    }
+    static void Destroy(Storage* s) {
+      delete *reinterpret_cast<F**>(s);
+    }
+    /** Operation table */
+    static const Ops ops;
+  };
+
+  /** Operation table of the wrapped callable, nullptr if empty */
+  const Ops* ops_;
+  /** Callable storage */
+  Storage storage_;
+};
+
+template<typename F, bool Inline>
+const InlineTask::Ops InlineTask::OpsImpl<F, Inline>::ops = {
+  &InlineTask::OpsImpl<F, Inline>::Invoke,
+  &InlineTask::OpsImpl<F, Inline>::Move,
+  &InlineTask::OpsImpl<F, Inline>::Destroy
+};
+
+template<typename F>
+const InlineTask::Ops InlineTask::OpsImpl<F, false>::ops = {
+  &InlineTask::OpsImpl<F, false>::Invoke,
+  &InlineTask::OpsImpl<F, false>::Move,
+  &InlineTask::OpsImpl<F, false>::Destroy
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_INLINE_TASK__ */
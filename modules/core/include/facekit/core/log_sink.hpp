@@ -0,0 +1,271 @@
+/**
+ *  @file   log_sink.hpp
+ *  @brief  Logger's output destinations: plain text, JSON lines, compact
+ *          binary records and size based rotating files
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   05.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_LOG_SINK__
+#define __FACEKIT_LOG_SINK__
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/logger.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Forward declaration */
+class FileSystem;
+
+/**
+ *  @class  StreamLogSink
+ *  @brief  Human readable sink, `file:line: LEVEL : message` per line
+ *  @author Christophe Ecabert
+ *  @date   05.09.18
+ *  @ingroup core
+ */
+class FK_EXPORTS StreamLogSink : public LogSink {
+ public:
+  /**
+   *  @name   StreamLogSink
+   *  @fn     explicit StreamLogSink(std::ostream& stream)
+   *  @brief  Constructor
+   *  @param[in] stream Where to write, must outlive the sink
+   */
+  explicit StreamLogSink(std::ostream& stream) : stream_(stream) {}
+
+  /**
+   *  @name   Write
+   *  @fn     void Write(const Logger::Record& record) override
+   *  @brief  Write a single record
+   *  @param[in] record  Record to write
+   */
+  void Write(const Logger::Record& record) override;
+
+  /**
+   *  @name   Flush
+   *  @fn     void Flush(void) override
+   *  @brief  Flush underlying stream
+   */
+  void Flush(void) override;
+
+ private:
+  /** Output */
+  std::ostream& stream_;
+};
+
+/**
+ *  @class  JsonLogSink
+ *  @brief  Structured sink, one JSON object per line:
+ *          `{"level":"INFO","ts":<ns>,"tid":<id>,"file":"..","line":<n>,
+ *          "msg":".."}`
+ *  @author Christophe Ecabert
+ *  @date   05.09.18
+ *  @ingroup core
+ */
+class FK_EXPORTS JsonLogSink : public LogSink {
+ public:
+  /**
+   *  @name   JsonLogSink
+   *  @fn     explicit JsonLogSink(std::ostream& stream)
+   *  @brief  Constructor
+   *  @param[in] stream Where to write, must outlive the sink
+   */
+  explicit JsonLogSink(std::ostream& stream) : stream_(stream) {}
+
+  /**
+   *  @name   Write
+   *  @fn     void Write(const Logger::Record& record) override
+   *  @brief  Write a single record
+   *  @param[in] record  Record to write
+   */
+  void Write(const Logger::Record& record) override;
+
+  /**
+   *  @name   Flush
+   *  @fn     void Flush(void) override
+   *  @brief  Flush underlying stream
+   */
+  void Flush(void) override;
+
+ private:
+  /** Output */
+  std::ostream& stream_;
+};
+
+/**
+ *  @class  BinaryLogSink
+ *  @brief  Compact sink, length prefixed records in host byte order:
+ *          `u32 size | u8 level | i64 ts | u64 tid | i32 line |
+ *          u32 n | file[n] | u32 m | msg[m]`, size excludes itself.
+ *  @author Christophe Ecabert
+ *  @date   05.09.18
+ *  @ingroup core
+ */
+class FK_EXPORTS BinaryLogSink : public LogSink {
+ public:
+  /**
+   *  @name   BinaryLogSink
+   *  @fn     explicit BinaryLogSink(std::ostream& stream)
+   *  @brief  Constructor
+   *  @param[in] stream Where to write, opened in binary mode, must outlive
+   *                    the sink
+   */
+  explicit BinaryLogSink(std::ostream& stream) : stream_(stream) {}
+
+  /**
+   *  @name   Write
+   *  @fn     void Write(const Logger::Record& record) override
+   *  @brief  Write a single record
+   *  @param[in] record  Record to write
+   */
+  void Write(const Logger::Record& record) override;
+
+  /**
+   *  @name   Flush
+   *  @fn     void Flush(void) override
+   *  @brief  Flush underlying stream
+   */
+  void Flush(void) override;
+
+  /**
+   *  @name   Decode
+   *  @fn     static bool Decode(std::istream& stream, Logger::Record* record,
+                                 std::string* file)
+   *  @brief  Read back a record written by this sink
+   *  @param[in] stream  Stream to read from
+   *  @param[out] record Decoded record, `file` points into `file` string
+   *  @param[out] file   Storage for the source file name
+   *  @return False if no complete record is available
+   */
+  static bool Decode(std::istream& stream,
+                     Logger::Record* record,
+                     std::string* file);
+
+ private:
+  /** Output */
+  std::ostream& stream_;
+  /** Encoding buffer */
+  std::string buffer_;
+};
+
+/**
+ *  @class  RotatingFileLogSink
+ *  @brief  Sink writing into a file which is rotated once it reaches a given
+ *          size: `path` -> `path.1` -> ... -> `path.<max_files>`, the oldest
+ *          being deleted.
+ *  @author Christophe Ecabert
+ *  @date   05.09.18
+ *  @ingroup core
+ */
+class FK_EXPORTS RotatingFileLogSink : public LogSink {
+ public:
+
+  /**
+   *  @enum   Format
+   *  @brief  Record encoding
+   */
+  enum class Format : char {
+    /** Same as StreamLogSink */
+    kText,
+    /** Same as JsonLogSink */
+    kJson,
+    /** Same as BinaryLogSink */
+    kBinary
+  };
+
+  /**
+   *  @name   RotatingFileLogSink
+   *  @fn     RotatingFileLogSink(const std::string& path,
+                                  const size_t& max_size,
+                                  const size_t& max_files,
+                                  const Format& format,
+                                  FileSystem* fs = nullptr)
+   *  @brief  Constructor, appends to `path` if it already exists
+   *  @param[in] path       Active log file
+   *  @param[in] max_size   Size in bytes triggering a rotation
+   *  @param[in] max_files  Number of rotated files kept
+   *  @param[in] format     Record encoding
+   *  @param[in] fs         File system used for rotation, platform's default
+   *                        if nullptr
+   */
+  RotatingFileLogSink(const std::string& path,
+                      const size_t& max_size,
+                      const size_t& max_files,
+                      const Format& format,
+                      FileSystem* fs = nullptr);
+
+  /**
+   *  @name   ~RotatingFileLogSink
+   *  @fn     ~RotatingFileLogSink(void) override
+   *  @brief  Destructor
+   */
+  ~RotatingFileLogSink(void) override;
+
+  /**
+   *  @name   Write
+   *  @fn     void Write(const Logger::Record& record) override
+   *  @brief  Write a single record, rotate first if it would overflow the
+   *          active file
+   *  @param[in] record  Record to write
+   */
+  void Write(const Logger::Record& record) override;
+
+  /**
+   *  @name   Flush
+   *  @fn     void Flush(void) override
+   *  @brief  Flush active file
+   */
+  void Flush(void) override;
+
+  /**
+   *  @name   is_open
+   *  @fn     bool is_open(void) const
+   *  @brief  Indicate if the active file could be opened
+   *  @return True if opened
+   */
+  bool is_open(void) const {
+    return file_.is_open();
+  }
+
+ private:
+  /**
+   *  @name   Rotate
+   *  @fn     void Rotate(void)
+   *  @brief  Shift existing files and restart an empty active file
+   */
+  void Rotate(void);
+
+  /** Active file path */
+  std::string path_;
+  /** Rotation threshold */
+  size_t max_size_;
+  /** Number of rotated files kept */
+  size_t max_files_;
+  /** File system */
+  FileSystem* fs_;
+  /** Active file */
+  std::ofstream file_;
+  /** Active file size */
+  size_t size_;
+  /** Single record buffer */
+  std::ostringstream buffer_;
+  /** Record encoder writing into `buffer_` */
+  std::unique_ptr<LogSink> encoder_;
+};
+
+}  // namespace FaceKit
+#endif  // __FACEKIT_LOG_SINK__
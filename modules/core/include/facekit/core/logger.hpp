@@ -10,8 +10,17 @@
 #ifndef __FACEKIT_LOGGER__
 #define __FACEKIT_LOGGER__
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "facekit/core/library_export.hpp"
 
@@ -46,30 +55,54 @@
 #define LOG_GRAY
 #endif
 
+/**
+ * Most verbose level compiled in, messages above it (see Logger::Level) are
+ * removed by the preprocessor: 0 keeps errors only, 2 removes every debug
+ * message, 5 keeps everything.
+ */
+#ifndef FACEKIT_LOG_COMPILED_LEVEL
+#define FACEKIT_LOG_COMPILED_LEVEL 5
+#endif
+
+/** Emit a log, arguments are only evaluated if the level is active */
+#define FACEKIT_LOG_IMPL(lvl, msg) \
+(!FaceKit::Logger::Instance().IsActive(FaceKit::Logger::Level::lvl) ? \
+ (void)0 : \
+ FaceKit::Logger::Instance().Log(FaceKit::Logger::Level::lvl, __FILE__, \
+ __LINE__, FaceKit::Logger::LogData<FaceKit::Logger::None>() << msg))
+
 /** Error Log */
-#define FACEKIT_LOG_ERROR(msg) \
-(FaceKit::Logger::Instance().Log(FaceKit::Logger::Level::kError, __FILE__, __LINE__,\
-FaceKit::Logger::LogData<FaceKit::Logger::None>() << msg))
+#define FACEKIT_LOG_ERROR(msg) FACEKIT_LOG_IMPL(kError, msg)
 /** Warning Log */
-#define FACEKIT_LOG_WARNING(msg) \
-(FaceKit::Logger::Instance().Log(FaceKit::Logger::Level::kWarning, __FILE__, \
- __LINE__, FaceKit::Logger::LogData<FaceKit::Logger::None>() << msg))
+#if FACEKIT_LOG_COMPILED_LEVEL >= 1
+#define FACEKIT_LOG_WARNING(msg) FACEKIT_LOG_IMPL(kWarning, msg)
+#else
+#define FACEKIT_LOG_WARNING(msg) ((void)0)
+#endif
 /** Info Log */
-#define FACEKIT_LOG_INFO(msg) \
-(FaceKit::Logger::Instance().Log(FaceKit::Logger::Level::kInfo, __FILE__, __LINE__, \
- FaceKit::Logger::LogData<FaceKit::Logger::None>() << msg))
+#if FACEKIT_LOG_COMPILED_LEVEL >= 2
+#define FACEKIT_LOG_INFO(msg) FACEKIT_LOG_IMPL(kInfo, msg)
+#else
+#define FACEKIT_LOG_INFO(msg) ((void)0)
+#endif
 /** Debug Log */
-#define FACEKIT_LOG_DEBUG(msg) \
-(FaceKit::Logger::Instance().Log(FaceKit::Logger::Level::kDebug, __FILE__, __LINE__,\
- FaceKit::Logger::LogData<FaceKit::Logger::None>() << msg))
+#if FACEKIT_LOG_COMPILED_LEVEL >= 3
+#define FACEKIT_LOG_DEBUG(msg) FACEKIT_LOG_IMPL(kDebug, msg)
+#else
+#define FACEKIT_LOG_DEBUG(msg) ((void)0)
+#endif
 /** Debug level 1 Log */
-#define FACEKIT_LOG_DEBUG1(msg) \
-(FaceKit::Logger::Instance().Log(FaceKit::Logger::Level::kDebug1, __FILE__, __LINE__,\
- FaceKit::Logger::LogData<FaceKit::Logger::None>() << msg))
+#if FACEKIT_LOG_COMPILED_LEVEL >= 4
+#define FACEKIT_LOG_DEBUG1(msg) FACEKIT_LOG_IMPL(kDebug1, msg)
+#else
+#define FACEKIT_LOG_DEBUG1(msg) ((void)0)
+#endif
 /** Debug level 2 Log */
-#define FACEKIT_LOG_DEBUG2(msg) \
-(FaceKit::Logger::Instance().Log(FaceKit::Logger::Level::kDebug2, __FILE__, __LINE__,\
- FaceKit::Logger::LogData<FaceKit::Logger::None>() << msg))
+#if FACEKIT_LOG_COMPILED_LEVEL >= 5
+#define FACEKIT_LOG_DEBUG2(msg) FACEKIT_LOG_IMPL(kDebug2, msg)
+#else
+#define FACEKIT_LOG_DEBUG2(msg) ((void)0)
+#endif
 
 
 /**
@@ -78,10 +111,22 @@ FaceKit::Logger::LogData<FaceKit::Logger::None>() << msg))
  */
 namespace FaceKit {
 
+/** Forward declaration */
+class LogSink;
+
 /**
  * @class   Logger
  * @brief   Logging tool
  *          Based on : http://stackoverflow.com/questions/19415845/
+ *          Messages are formatted by the calling thread. In synchronous mode
+ *          (default) they are written right away under a lock. In
+ *          asynchronous mode they are pushed into a bounded lock-free queue
+ *          owned by the calling thread and a background thread drains every
+ *          queue into the sink, flushing once per batch. Order is kept per
+ *          thread. Asynchronous mode can be enabled with the
+ *          `FACEKIT_LOG_ASYNC` environment variable. Messages go to a text
+ *          sink on the stream given to `Instance` unless another `LogSink` is
+ *          installed (see log_sink.hpp).
  * @ingroup core
  * @author  Christophe Ecabert
  * @date    19/08/2017
@@ -111,6 +156,20 @@ class FK_EXPORTS Logger {
     kDebug2
   };
 
+  /**
+   * @enum  DropPolicy
+   * @brief Behaviour when a thread's queue is full in asynchronous mode
+   */
+  enum class DropPolicy : char {
+    /** Wait until the background thread makes room */
+    kBlock,
+    /** Discard the message, latency-critical threads never wait */
+    kDrop
+  };
+
+  /** Default number of pending messages per thread */
+  static constexpr size_t kDefaultQueueCapacity = 1024;
+
   /** Conversion from Level to string */
   static constexpr const char* LvlToStr[]  = {LOG_RED "ERROR" LOG_RESET,
                                               LOG_YELLOW "WARNING" LOG_RESET,
@@ -119,6 +178,25 @@ class FK_EXPORTS Logger {
                                               LOG_GRAY "DEBUG1" LOG_RESET,
                                               LOG_GRAY "DEBUG2" LOG_RESET};
 
+  /**
+   * @struct    Record
+   * @brief     Single log entry handed over to a sink
+   */
+  struct Record {
+    /** Level */
+    Level level;
+    /** Monotonic timestamp in nanoseconds */
+    int64_t timestamp;
+    /** Emitting thread identifier */
+    uint64_t thread_id;
+    /** Source file, static storage */
+    const char* file;
+    /** Source line */
+    int line;
+    /** Message */
+    std::string message;
+  };
+
   /**
    * @struct    None
    * @brief     Empty log data
@@ -208,35 +286,64 @@ class FK_EXPORTS Logger {
            const int line,
            LogData<List>&& data)   {
     // Header, only if enable and with proper level
-    if (enable_ && level <= log_level_) {
-      stream_ << file << ":" << line << ": ";
-      stream_ << Logger::LvlToStr[level] << " : ";
-      stream_ << std::string(level > kDebug ? level - kDebug : 0, '\t');
+    if (IsActive(level)) {
       // Message
-      Write(std::move(data.list));
-      // Close
-      stream_ << std::endl;
+      std::ostringstream& stream = Logger::Buffer();
+      Write(stream, std::move(data.list));
+      // Hand over to the sink
+      Submit(level, file, line, stream);
     }
   }
 
   /**
    * @name  Write
-   * @fn    void Write(std::pair<First, Last>&& data)
+   * @fn    void Write(std::ostream& stream, std::pair<First, Last>&& data)
    * @brief Dump data into a given stream
+   * @param[in] stream  Stream to write in
    * @param[in] data    Data to output
    */
   template<typename First,  typename Last>
-  void Write(std::pair<First, Last>&& data) {
-    Write(std::move(data.first));
-    stream_ << data.second;
+  void Write(std::ostream& stream, std::pair<First, Last>&& data) {
+    Write(stream, std::move(data.first));
+    stream << data.second;
   }
 
   /**
    * @name  Write
-   * @fn    void Write(None)
+   * @fn    void Write(std::ostream& stream, None)
    * @brief Empty dump
+   * @param[in] stream  Stream to write in
+   */
+  void Write(std::ostream& stream, None);
+
+  /**
+   * @name  Flush
+   * @fn    void Flush(void)
+   * @brief Write every pending message and flush the sink
+   */
+  void Flush(void);
+
+  /**
+   * @name  set_sink
+   * @fn    void set_sink(const std::shared_ptr<LogSink>& sink)
+   * @brief Define where records are written, pending messages are written
+   *        into the previous sink first.
+   * @param[in] sink    Sink, nullptr restores the text sink on the stream
+   *                    given to `Instance`
+   */
+  void set_sink(const std::shared_ptr<LogSink>& sink);
+
+  /**
+   * @name  IsActive
+   * @fn    bool IsActive(const Level level) const
+   * @brief Indicate if a message of a given level would be recorded, checked
+   *        by the logging macros before evaluating any argument.
+   * @param[in] level   Level of logging
+   * @return    True if logging is enabled for this level
    */
-  void Write(None);
+  bool IsActive(const Level level) const {
+    return enable_ && level <= log_level_;
+  }
 
   /**
    * @name  Enable
@@ -285,29 +392,197 @@ class FK_EXPORTS Logger {
     return log_level_;
   }
 
+  /**
+   * @name  set_async
+   * @fn    void set_async(const bool& async)
+   * @brief Switch between synchronous and asynchronous mode. Pending
+   *        messages are written when going back to synchronous mode.
+   * @param[in] async   True for asynchronous logging
+   */
+  void set_async(const bool& async);
+
+  /**
+   * @name  is_async
+   * @fn    bool is_async(void) const
+   * @brief Indicate if asynchronous mode is enabled
+   * @return    True if asynchronous
+   */
+  bool is_async(void) const {
+    return async_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @name  set_drop_policy
+   * @fn    void set_drop_policy(const DropPolicy& policy)
+   * @brief Define what happens when a thread's queue is full
+   * @param[in] policy  Drop policy
+   */
+  void set_drop_policy(const DropPolicy& policy) {
+    drop_policy_.store(policy, std::memory_order_relaxed);
+  }
+
+  /**
+   * @name  get_drop_policy
+   * @fn    DropPolicy get_drop_policy(void) const
+   * @brief Provide current drop policy
+   * @return    Drop policy
+   */
+  DropPolicy get_drop_policy(void) const {
+    return drop_policy_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @name  set_queue_capacity
+   * @fn    void set_queue_capacity(const size_t& capacity)
+   * @brief Define the number of pending messages per thread, applies to
+   *        threads logging for the first time after the call.
+   * @param[in] capacity    Queue capacity, at least 1
+   */
+  void set_queue_capacity(const size_t& capacity) {
+    queue_capacity_.store(capacity > 0 ? capacity : 1,
+                          std::memory_order_relaxed);
+  }
+
+  /**
+   * @name  get_n_dropped
+   * @fn    size_t get_n_dropped(void) const
+   * @brief Number of messages discarded since the logger creation
+   * @return    Number of dropped messages
+   */
+  size_t get_n_dropped(void) const {
+    return n_dropped_.load(std::memory_order_relaxed);
+  }
+
 
 #pragma mark -
 #pragma mark Private
 
  private:
 
+  /** Per-thread single producer / single consumer queue */
+  class Queue;
+  /** Thread's ownership of its queue */
+  friend struct QueueHolder;
+
   /**
    * @name  Logger
-   * @fn    explicit Logger(void)
+   * @fn    explicit Logger(std::ostream& stream)
    * @brief Constructor
    * @param[in] stream  Where output logging message
    */
-  explicit Logger(std::ostream& stream) : stream_(stream),
-                                          enable_(true),
-                                          log_level_(kDebug) {}
+  explicit Logger(std::ostream& stream);
+
+  /**
+   * @name  ~Logger
+   * @fn    ~Logger(void)
+   * @brief Destructor, write pending messages
+   */
+  ~Logger(void);
+
+  /**
+   * @name  Buffer
+   * @fn    static std::ostringstream& Buffer(void)
+   * @brief Calling thread's formatting buffer, emptied
+   * @return    Buffer
+   */
+  static std::ostringstream& Buffer(void);
+
+  /**
+   * @name  Submit
+   * @fn    void Submit(const Level level, const char* file, const int line,
+                        std::ostringstream& message)
+   * @brief Write a record or queue it in asynchronous mode
+   * @param[in] level   Level of logging
+   * @param[in] file    File from where the log has been emitted
+   * @param[in] line    Line number where log has been emitted
+   * @param[in] message Formatted message
+   */
+  void Submit(const Level level,
+              const char* file,
+              const int line,
+              std::ostringstream& message);
+
+  /**
+   * @name  Drain
+   * @fn    void Drain(void)
+   * @brief Write every queued message into the stream
+   */
+  void Drain(void);
+
+  /**
+   * @name  Run
+   * @fn    void Run(void)
+   * @brief Background thread's loop
+   */
+  void Run(void);
 
-  /** Where data will be output */
+  /** Stream used by the default sink */
   std::ostream& stream_;
+  /** Where records are written */
+  std::shared_ptr<LogSink> sink_;
   /** Enable/Disable flag */
   bool enable_;
   /** Logging level */
   Level log_level_;
+  /** Serialize access to sink_ */
+  std::mutex sink_mutex_;
+  /** Asynchronous flag */
+  std::atomic<bool> async_;
+  /** Drop policy */
+  std::atomic<DropPolicy> drop_policy_;
+  /** Capacity of newly created queues */
+  std::atomic<size_t> queue_capacity_;
+  /** Number of dropped messages */
+  std::atomic<size_t> n_dropped_;
+  /** Number of dropped messages already reported */
+  size_t n_dropped_reported_;
+  /** Queues of every thread that logged in asynchronous mode */
+  std::vector<std::shared_ptr<Queue>> queues_;
+  /** Protect queues_ */
+  std::mutex queues_mutex_;
+  /** Background thread */
+  std::thread worker_;
+  /** Background thread running flag */
+  bool running_;
+  /** Protect running_ */
+  std::mutex worker_mutex_;
+  /** Wake up background thread */
+  std::condition_variable worker_cv_;
+  /** Serialize mode changes */
+  std::mutex mode_mutex_;
+};
+
+/**
+ * @class   LogSink
+ * @brief   Destination of log records. Calls are serialized by the logger.
+ * @ingroup core
+ * @author  Christophe Ecabert
+ * @date    05/09/2018
+ */
+class FK_EXPORTS LogSink {
+ public:
+  /**
+   * @name  ~LogSink
+   * @fn    virtual ~LogSink(void) = default
+   * @brief Destructor
+   */
+  virtual ~LogSink(void) = default;
+
+  /**
+   * @name  Write
+   * @fn    virtual void Write(const Logger::Record& record) = 0
+   * @brief Write a single record
+   * @param[in] record  Record to write
+   */
+  virtual void Write(const Logger::Record& record) = 0;
+
+  /**
+   * @name  Flush
+   * @fn    virtual void Flush(void)
+   * @brief Push buffered records to the underlying device
+   */
+  virtual void Flush(void) {}
 };
-  
+
 }  // namespace FaceKit
 #endif //__FACEKIT_LOGGER__
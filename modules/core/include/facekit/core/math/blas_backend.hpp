@@ -0,0 +1,212 @@
+/**
+ *  @file   blas_backend.hpp
+ *  @brief Query the BLAS implementation resolved at load time and control
+ *         the number of threads it uses
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   22.08.18
+ *    Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_BLAS_BACKEND__
+#define __FACEKIT_BLAS_BACKEND__
+
+#include <mutex>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  BlasBackend
+ *  @brief  BLAS implementation used by `LinearAlgebra`. The backend is the
+ *          cblas provider picked by the dynamic loader (i.e. swapped by
+ *          preloading / relinking another library), it is detected once at
+ *          first use by looking for its threading entry points.
+ *          The initial number of threads can be given through the
+ *          `FACEKIT_BLAS_NUM_THREADS` environment variable.
+ *  @author Christophe Ecabert
+ *  @date   22.08.18
+ *  @ingroup core
+ */
+class FK_EXPORTS BlasBackend {
+ public:
+
+  /**
+   *  @enum   Type
+   *  @brief  List of known BLAS implementations
+   */
+  enum class Type : char {
+    /** Reference (netlib) or unknown, single threaded implementation */
+    kReference,
+    /** OpenBLAS */
+    kOpenBLAS,
+    /** Intel Math Kernel Library */
+    kMKL,
+    /** BLIS */
+    kBLIS,
+    /** Apple Accelerate framework */
+    kAccelerate
+  };
+
+  /**
+   *  @class  SerialScope
+   *  @brief  Force BLAS to run single threaded while at least one scope is
+   *          alive. Used when BLAS calls are already issued concurrently
+   *          (i.e. from `ThreadPool` workers) to avoid oversubscription.
+   *          Scopes can be nested and created from several threads.
+   *  @author Christophe Ecabert
+   *  @date   22.08.18
+   *  @ingroup core
+   */
+  class FK_EXPORTS SerialScope {
+   public:
+    /**
+     *  @name   SerialScope
+     *  @fn     SerialScope(void)
+     *  @brief  Constructor, switch BLAS to a single thread
+     */
+    SerialScope(void);
+
+    /**
+     *  @name   SerialScope
+     *  @fn     SerialScope(const SerialScope& other) = delete
+     *  @brief  Copy constructor
+     */
+    SerialScope(const SerialScope& other) = delete;
+
+    /**
+     *  @name   operator=
+     *  @fn     SerialScope& operator=(const SerialScope& rhs) = delete
+     *  @brief  Assignment operator
+     */
+    SerialScope& operator=(const SerialScope& rhs) = delete;
+
+    /**
+     *  @name   ~SerialScope
+     *  @fn     ~SerialScope(void)
+     *  @brief  Destructor, restore number of threads when it is the last
+     *          active scope
+     */
+    ~SerialScope(void);
+  };
+
+  /**
+   *  @name   Get
+   *  @fn     static BlasBackend& Get(void)
+   *  @brief  Singleton accessor
+   *  @return BLAS backend
+   */
+  static BlasBackend& Get(void);
+
+  /**
+   *  @name   BlasBackend
+   *  @fn     BlasBackend(const BlasBackend& other) = delete
+   *  @brief  Copy constructor
+   */
+  BlasBackend(const BlasBackend& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     BlasBackend& operator=(const BlasBackend& rhs) = delete
+   *  @brief  Assignment operator
+   */
+  BlasBackend& operator=(const BlasBackend& rhs) = delete;
+
+  /**
+   *  @name   type
+   *  @fn     Type type(void) const
+   *  @brief  Detected implementation
+   *  @return Backend type
+   */
+  Type type(void) const {
+    return type_;
+  }
+
+  /**
+   *  @name   Name
+   *  @fn     const char* Name(void) const
+   *  @brief  Readable name of the detected implementation
+   *  @return Backend name
+   */
+  const char* Name(void) const;
+
+  /**
+   *  @name   SupportThreadControl
+   *  @fn     bool SupportThreadControl(void) const
+   *  @brief  Indicate if the number of threads can be changed at runtime
+   *  @return True if `SetNumThreads` has an effect
+   */
+  bool SupportThreadControl(void) const {
+    return set_threads_ != nullptr;
+  }
+
+  /**
+   *  @name   SetNumThreads
+   *  @fn     Status SetNumThreads(const int& n)
+   *  @brief  Define how many threads BLAS can use. When called while a
+   *          `SerialScope` is active, the value is applied once the last
+   *          scope is released.
+   *  @param[in] n  Number of threads, 0 selects the number of cores
+   *  @return Status of the operation, `kUnimplemented` if the backend does
+   *          not expose thread control.
+   */
+  Status SetNumThreads(const int& n);
+
+  /**
+   *  @name   GetNumThreads
+   *  @fn     int GetNumThreads(void) const
+   *  @brief  Number of threads BLAS currently uses
+   *  @return Number of threads
+   */
+  int GetNumThreads(void) const;
+
+ private:
+  /** Setter signature */
+  using SetThreadFcn = void(*)(int);
+  /** Getter signature */
+  using GetThreadFcn = int(*)(void);
+
+  /**
+   *  @name   BlasBackend
+   *  @fn     BlasBackend(void)
+   *  @brief  Constructor, detect backend
+   */
+  BlasBackend(void);
+
+  /**
+   *  @name   EnterSerial
+   *  @fn     void EnterSerial(void)
+   *  @brief  Register a new active `SerialScope`
+   */
+  void EnterSerial(void);
+
+  /**
+   *  @name   LeaveSerial
+   *  @fn     void LeaveSerial(void)
+   *  @brief  Release an active `SerialScope`
+   */
+  void LeaveSerial(void);
+
+  /** Detected backend */
+  Type type_;
+  /** Threads setter, nullptr if not supported */
+  SetThreadFcn set_threads_;
+  /** Threads getter, nullptr if not supported */
+  GetThreadFcn get_threads_;
+  /** Number of threads requested by the user */
+  int n_threads_;
+  /** Number of active serial scopes */
+  int n_serial_;
+  /** Synchronization */
+  mutable std::mutex mutex_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_BLAS_BACKEND__ */
@@ -0,0 +1,400 @@
+/**
+ *  @file   device_linear_algebra.hpp
+ *  @brief  GPU (CUDA / cuBLAS) counterpart of `LinearAlgebra` for large
+ *          matrix products
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_DEVICE_LINEAR_ALGEBRA__
+#define __FACEKIT_DEVICE_LINEAR_ALGEBRA__
+
+#include <cstddef>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/math/linear_algebra.hpp"
+#include "facekit/core/status.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  DeviceStream
+ *  @brief  Queue of asynchronous device operations (CUDA stream) with its own
+ *          cuBLAS handle. Operations issued on one stream run in order,
+ *          operations on different streams may overlap (i.e. transfers of
+ *          one batch with the product of another). Everything device related
+ *          is only available when FaceKit is built with CUDA, otherwise
+ *          operations return `kUnimplemented`.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup core
+ */
+class FK_EXPORTS DeviceStream {
+ public:
+
+  /**
+   *  @name   IsAvailable
+   *  @fn     static bool IsAvailable(void)
+   *  @brief  Indicate if FaceKit is built with CUDA and a device is present
+   */
+  static bool IsAvailable(void);
+
+  /**
+   *  @name   DeviceStream
+   *  @fn     DeviceStream(void)
+   *  @brief  Constructor, the stream is created by `Init`
+   */
+  DeviceStream(void);
+
+  /**
+   *  @name   DeviceStream
+   *  @fn     DeviceStream(const DeviceStream& other) = delete
+   *  @brief  Copy constructor
+   */
+  DeviceStream(const DeviceStream& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     DeviceStream& operator=(const DeviceStream& rhs) = delete
+   *  @brief  Assignment operator
+   */
+  DeviceStream& operator=(const DeviceStream& rhs) = delete;
+
+  /**
+   *  @name   ~DeviceStream
+   *  @fn     ~DeviceStream(void)
+   *  @brief  Destructor, wait for pending operations
+   */
+  ~DeviceStream(void);
+
+  /**
+   *  @name   Init
+   *  @fn     Status Init(void)
+   *  @brief  Create the stream and its cuBLAS handle, does nothing if
+   *          already created
+   *  @return `kUnimplemented` without CUDA, `kInternalError` if the device
+   *          can not be initialized
+   */
+  Status Init(void);
+
+  /**
+   *  @name   Synchronize
+   *  @fn     Status Synchronize(void)
+   *  @brief  Wait until every operation issued on the stream is done
+   *  @return Error of the first failed operation if any
+   */
+  Status Synchronize(void);
+
+  /**
+   *  @name   native_stream
+   *  @fn     void* native_stream(void) const
+   *  @brief  Underlying `cudaStream_t`
+   */
+  void* native_stream(void) const {
+    return stream_;
+  }
+
+  /**
+   *  @name   native_handle
+   *  @fn     void* native_handle(void) const
+   *  @brief  Underlying `cublasHandle_t`, bound to the stream
+   */
+  void* native_handle(void) const {
+    return handle_;
+  }
+
+ private:
+  /** CUDA stream */
+  void* stream_;
+  /** cuBLAS handle */
+  void* handle_;
+};
+
+/**
+ *  @class  PinnedBuffer
+ *  @brief  Page-locked host memory. Transfers from / to pinned memory are
+ *          asynchronous and run at full bus bandwidth, transfers from
+ *          pageable memory are staged by the driver and block the host.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup core
+ */
+class FK_EXPORTS PinnedBuffer {
+ public:
+
+  /**
+   *  @name   PinnedBuffer
+   *  @fn     PinnedBuffer(void)
+   *  @brief  Constructor, empty buffer
+   */
+  PinnedBuffer(void) : data_(nullptr), size_(0) {}
+
+  /**
+   *  @name   PinnedBuffer
+   *  @fn     PinnedBuffer(const PinnedBuffer& other) = delete
+   *  @brief  Copy constructor
+   */
+  PinnedBuffer(const PinnedBuffer& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     PinnedBuffer& operator=(const PinnedBuffer& rhs) = delete
+   *  @brief  Assignment operator
+   */
+  PinnedBuffer& operator=(const PinnedBuffer& rhs) = delete;
+
+  /**
+   *  @name   ~PinnedBuffer
+   *  @fn     ~PinnedBuffer(void)
+   *  @brief  Destructor
+   */
+  ~PinnedBuffer(void);
+
+  /**
+   *  @name   Resize
+   *  @fn     Status Resize(const size_t& size)
+   *  @brief  Make room for at least \p size bytes, content is not preserved
+   *          when the buffer grows
+   *  @param[in] size   Size in bytes
+   *  @return `kUnimplemented` without CUDA, `kInternalError` if the
+   *          allocation fails
+   */
+  Status Resize(const size_t& size);
+
+  /**
+   *  @name   data
+   *  @fn     void* data(void) const
+   *  @brief  Host pointer
+   */
+  void* data(void) const {
+    return data_;
+  }
+
+  /**
+   *  @name   size
+   *  @fn     size_t size(void) const
+   *  @brief  Allocated size in bytes
+   */
+  size_t size(void) const {
+    return size_;
+  }
+
+ private:
+  /** Host memory */
+  void* data_;
+  /** Allocated size */
+  size_t size_;
+};
+
+/**
+ *  @class  DeviceMatrix
+ *  @brief  Row major matrix resident in device memory, same layout as a
+ *          continuous `cv::Mat`. Memory is reused when the matrix is
+ *          recreated with fewer elements.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup core
+ *  @tparam T Data type
+ */
+template<typename T>
+class FK_EXPORTS DeviceMatrix {
+ public:
+
+  /**
+   *  @name   DeviceMatrix
+   *  @fn     DeviceMatrix(void)
+   *  @brief  Constructor, empty matrix
+   */
+  DeviceMatrix(void) : data_(nullptr), rows_(0), cols_(0), capacity_(0) {}
+
+  /**
+   *  @name   DeviceMatrix
+   *  @fn     DeviceMatrix(DeviceMatrix&& other)
+   *  @brief  Move constructor
+   */
+  DeviceMatrix(DeviceMatrix&& other);
+
+  /**
+   *  @name   operator=
+   *  @fn     DeviceMatrix& operator=(DeviceMatrix&& rhs)
+   *  @brief  Move assignment operator
+   */
+  DeviceMatrix& operator=(DeviceMatrix&& rhs);
+
+  /**
+   *  @name   DeviceMatrix
+   *  @fn     DeviceMatrix(const DeviceMatrix& other) = delete
+   *  @brief  Copy constructor
+   */
+  DeviceMatrix(const DeviceMatrix& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     DeviceMatrix& operator=(const DeviceMatrix& rhs) = delete
+   *  @brief  Assignment operator
+   */
+  DeviceMatrix& operator=(const DeviceMatrix& rhs) = delete;
+
+  /**
+   *  @name   ~DeviceMatrix
+   *  @fn     ~DeviceMatrix(void)
+   *  @brief  Destructor
+   */
+  ~DeviceMatrix(void);
+
+  /**
+   *  @name   Create
+   *  @fn     Status Create(const int& rows, const int& cols)
+   *  @brief  Shape the matrix, allocates only if the current memory is too
+   *          small
+   *  @param[in] rows   Number of rows
+   *  @param[in] cols   Number of columns
+   *  @return `kUnimplemented` without CUDA, `kInternalError` if the
+   *          allocation fails
+   */
+  Status Create(const int& rows, const int& cols);
+
+  /**
+   *  @name   Upload
+   *  @fn     Status Upload(const cv::Mat& matrix)
+   *  @brief  Copy a host matrix of type T, blocking
+   *  @param[in] matrix Host matrix
+   *  @return `kInvalidArgument` if \p matrix is not of type T
+   */
+  Status Upload(const cv::Mat& matrix);
+
+  /**
+   *  @name   Upload
+   *  @fn     Status Upload(const T* src, DeviceStream* stream)
+   *  @brief  Queue the copy of `rows() * cols()` elements from the host,
+   *          asynchronous if \p src is pinned (see `PinnedBuffer`)
+   *  @param[in] src        Host data, must stay valid until the stream is
+   *                        synchronized
+   *  @param[in] stream     Stream to queue the copy on
+   *  @return Error if the copy can not be queued
+   */
+  Status Upload(const T* src, DeviceStream* stream);
+
+  /**
+   *  @name   Download
+   *  @fn     Status Download(cv::Mat* matrix) const
+   *  @brief  Copy the matrix to the host, blocking
+   *  @param[out] matrix    Host matrix
+   *  @return Error if the copy fails
+   */
+  Status Download(cv::Mat* matrix) const;
+
+  /**
+   *  @name   Download
+   *  @fn     Status Download(T* dst, DeviceStream* stream) const
+   *  @brief  Queue the copy of `rows() * cols()` elements to the host,
+   *          asynchronous if \p dst is pinned (see `PinnedBuffer`)
+   *  @param[out] dst       Host data, valid once the stream is synchronized
+   *  @param[in] stream     Stream to queue the copy on
+   *  @return Error if the copy can not be queued
+   */
+  Status Download(T* dst, DeviceStream* stream) const;
+
+  /**
+   *  @name   rows
+   *  @fn     int rows(void) const
+   *  @brief  Number of rows
+   */
+  int rows(void) const {
+    return rows_;
+  }
+
+  /**
+   *  @name   cols
+   *  @fn     int cols(void) const
+   *  @brief  Number of columns
+   */
+  int cols(void) const {
+    return cols_;
+  }
+
+  /**
+   *  @name   empty
+   *  @fn     bool empty(void) const
+   *  @brief  Indicate if the matrix has no element
+   */
+  bool empty(void) const {
+    return rows_ == 0 || cols_ == 0;
+  }
+
+  /**
+   *  @name   data
+   *  @fn     T* data(void) const
+   *  @brief  Device pointer
+   */
+  T* data(void) const {
+    return data_;
+  }
+
+ private:
+  /** Device memory */
+  T* data_;
+  /** Number of rows */
+  int rows_;
+  /** Number of columns */
+  int cols_;
+  /** Allocated number of elements */
+  size_t capacity_;
+};
+
+/**
+ *  @class  DeviceLinearAlgebra
+ *  @brief  cuBLAS wrapper for `DeviceMatrix`, same conventions as
+ *          `LinearAlgebra` (row major, C = a * op(A) op(B) + b * C)
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup core
+ *  @tparam T Data type
+ */
+template<typename T>
+class FK_EXPORTS DeviceLinearAlgebra {
+ public:
+  /** Operation on matrix */
+  using TransposeType = typename LinearAlgebra<T>::TransposeType;
+
+  /**
+   *  @name   Gemm
+   *  @fn     static Status Gemm(const DeviceMatrix<T>& A,
+                                 const TransposeType trans_a,
+                                 const T alpha,
+                                 const DeviceMatrix<T>& B,
+                                 const TransposeType trans_b,
+                                 const T beta,
+                                 DeviceMatrix<T>* C,
+                                 DeviceStream* stream)
+   *  @brief  Queue the product between two matrices
+   *          C = a * AB + b * C
+   *  @param[in] A         Matrix A
+   *  @param[in] trans_a   Transpose flag indicator for A
+   *  @param[in] alpha     Alpha coefficient
+   *  @param[in] B         Matrix B
+   *  @param[in] trans_b   Transpose flag indicator for B
+   *  @param[in] beta      Beta coefficient
+   *  @param[in,out] C     Resulting matrix, shaped if needed
+   *  @param[in] stream    Stream to queue the product on
+   *  @return `kInvalidArgument` if dimensions do not agree
+   */
+  static Status Gemm(const DeviceMatrix<T>& A,
+                     const TransposeType trans_a,
+                     const T alpha,
+                     const DeviceMatrix<T>& B,
+                     const TransposeType trans_b,
+                     const T beta,
+                     DeviceMatrix<T>* C,
+                     DeviceStream* stream);
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_DEVICE_LINEAR_ALGEBRA__ */
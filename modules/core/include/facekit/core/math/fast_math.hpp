@@ -0,0 +1,192 @@
+/**
+ *  @file   fast_math.hpp
+ *  @brief  Approximated math functions for normalization-heavy loops and
+ *          policies selecting between exact and approximated versions
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   29.08.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_FAST_MATH__
+#define __FACEKIT_FAST_MATH__
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FACEKIT_FAST_MATH_SSE
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define FACEKIT_FAST_MATH_NEON
+#include <arm_neon.h>
+#endif
+
+#include "facekit/core/library_export.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @namespace  FastMath
+ *  @brief      Approximated elementary functions. They are branch-free (up
+ *              to selects) so that loops using them can be vectorized.
+ *              Maximum errors are measured over the whole input domain.
+ */
+namespace FastMath {
+
+/**
+ *  @name   RsqrtEstimate
+ *  @fn     inline float RsqrtEstimate(const float x)
+ *  @brief  Hardware estimate of 1 / sqrt(x), ~12 bits
+ *  @param[in] x  Value
+ *  @return Estimate
+ */
+inline float RsqrtEstimate(const float x) {
+#if defined(FACEKIT_FAST_MATH_SSE)
+  return _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+#elif defined(FACEKIT_FAST_MATH_NEON)
+  return vget_lane_f32(vrsqrte_f32(vdup_n_f32(x)), 0);
+#else
+  return 1.f / std::sqrt(x);
+#endif
+}
+
+/**
+ *  @name   Rsqrt
+ *  @fn     inline float Rsqrt(const float x)
+ *  @brief  Approximate 1 / sqrt(x) with a hardware estimate refined by one
+ *          Newton-Raphson step. Relative error < 5e-7. Gives NaN for x = 0.
+ *  @param[in] x  Value, x >= 0
+ *  @return 1 / sqrt(x)
+ */
+inline float Rsqrt(const float x) {
+  const float y = RsqrtEstimate(x);
+  return y * (1.5f - 0.5f * x * y * y);
+}
+
+/**
+ *  @name   Rsqrt
+ *  @fn     inline double Rsqrt(const double x)
+ *  @brief  Approximate 1 / sqrt(x) from the single precision estimate
+ *          refined by two Newton-Raphson steps. Relative error < 1e-13.
+ *          Gives NaN for x = 0. Values outside of float range fall back to
+ *          the exact computation.
+ *  @param[in] x  Value, x >= 0
+ *  @return 1 / sqrt(x)
+ */
+inline double Rsqrt(const double x) {
+  if (x < 1e-37 || x > 1e37) {
+    return x == 0.0 ? std::numeric_limits<double>::quiet_NaN() :
+                      1.0 / std::sqrt(x);
+  }
+  double y = static_cast<double>(RsqrtEstimate(static_cast<float>(x)));
+  y = y * (1.5 - 0.5 * x * y * y);
+  return y * (1.5 - 0.5 * x * y * y);
+}
+
+/**
+ *  @name   Acos
+ *  @fn     inline T Acos(const T x)
+ *  @brief  Approximate arc cosine with a cubic polynomial (Abramowitz &
+ *          Stegun 4.4.45). Absolute error < 7e-5 rad. Inputs are clamped to
+ *          [-1, 1].
+ *  @param[in] x  Value
+ *  @return acos(x) in [0, pi]
+ *  @tparam T Data type
+ */
+template<typename T>
+inline T Acos(const T x) {
+  const T ax = std::min(std::abs(x), T(1.0));
+  const T p = ((T(-0.0187293) * ax + T(0.0742610)) * ax - T(0.2121144)) * ax +
+              T(1.5707288);
+  const T r = p * std::sqrt(T(1.0) - ax);
+  return x < T(0.0) ? T(3.14159265358979323846) - r : r;
+}
+
+/**
+ *  @name   Atan2
+ *  @fn     inline T Atan2(const T y, const T x)
+ *  @brief  Approximate atan2 with a degree 9 odd polynomial on [0, 1]
+ *          (Abramowitz & Stegun 4.4.49) and octant reconstruction. Absolute
+ *          error < 1.2e-5 rad. Atan2(0, 0) = 0.
+ *  @param[in] y  Ordinate
+ *  @param[in] x  Abscissa
+ *  @return atan2(y, x) in [-pi, pi]
+ *  @tparam T Data type
+ */
+template<typename T>
+inline T Atan2(const T y, const T x) {
+  const T ax = std::abs(x);
+  const T ay = std::abs(y);
+  const T hi = std::max(ax, ay);
+  const T lo = std::min(ax, ay);
+  const T a = hi > T(0.0) ? lo / hi : T(0.0);
+  const T s = a * a;
+  T r = ((((T(0.0208351) * s - T(0.0851330)) * s + T(0.1801410)) * s -
+         T(0.3302995)) * s + T(0.9998660)) * a;
+  r = ay > ax ? T(1.57079632679489661923) - r : r;
+  r = x < T(0.0) ? T(3.14159265358979323846) - r : r;
+  return y < T(0.0) ? -r : r;
+}
+
+}  // namespace FastMath
+
+/**
+ *  @struct PreciseMathPolicy
+ *  @brief  Math policy using the standard library
+ *  @ingroup core
+ */
+struct PreciseMathPolicy {
+  /** Results match the standard library */
+  static constexpr bool kExact = true;
+  /** 1 / sqrt(x) */
+  template<typename T>
+  static T Rsqrt(const T x) {
+    return T(1.0) / std::sqrt(x);
+  }
+  /** acos(x) */
+  template<typename T>
+  static T Acos(const T x) {
+    return std::acos(x);
+  }
+  /** atan2(y, x) */
+  template<typename T>
+  static T Atan2(const T y, const T x) {
+    return std::atan2(y, x);
+  }
+};
+
+/**
+ *  @struct FastMathPolicy
+ *  @brief  Math policy using `FastMath` approximations
+ *  @ingroup core
+ */
+struct FastMathPolicy {
+  /** Results are approximated */
+  static constexpr bool kExact = false;
+  /** 1 / sqrt(x) */
+  template<typename T>
+  static T Rsqrt(const T x) {
+    return FastMath::Rsqrt(x);
+  }
+  /** acos(x) */
+  template<typename T>
+  static T Acos(const T x) {
+    return FastMath::Acos(x);
+  }
+  /** atan2(y, x) */
+  template<typename T>
+  static T Atan2(const T y, const T x) {
+    return FastMath::Atan2(y, x);
+  }
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_FAST_MATH__ */
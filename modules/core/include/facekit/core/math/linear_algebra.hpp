@@ -11,9 +11,17 @@
 #ifndef __FACEKIT_LINEAR_ALGEBRA__
 #define __FACEKIT_LINEAR_ALGEBRA__
 
-#include "opencv2/core/core.hpp"
+#include <vector>
 
 #include "facekit/core/library_export.hpp"
+#include "facekit/core/math/quantized_matrix.hpp"
+#include "facekit/core/nd_array.hpp"
+#include "facekit/core/status.hpp"
+
+/** Forward declaration, include OpenCV to use the cv::Mat interface */
+namespace cv {
+class Mat;
+}  // namespace cv
 
 /**
  *  @namespace  FaceKit
@@ -141,6 +149,31 @@ class FK_EXPORTS LinearAlgebra {
                    const cv::Mat& x,
                    const T beta,
                    cv::Mat* y);
+
+  /**
+   *  @name   Gemv
+   *  @fn void Gemv(const QuantizedMatrix& A,
+                    const TransposeType trans_a,
+                    const T alpha,
+                    const cv::Mat& x,
+                    const T beta,
+                    cv::Mat* y)
+   *  @brief  Multiplies a reduced precision matrix by a vector
+   *          Y = a * Ax + b Y. Elements of A are widened on the fly and
+   *          accumulated in single precision.
+   *  @param[in] A        Quantized matrix A
+   *  @param[in] trans_a  Indicate if A is transpose or not
+   *  @param[in] alpha    Scaling factor alpha
+   *  @param[in] x        Vector X
+   *  @param[in] beta     Scaling factor beta
+   *  @param[in,out] y    Output vector
+   */
+  static void Gemv(const QuantizedMatrix& A,
+                   const TransposeType trans_a,
+                   const T alpha,
+                   const cv::Mat& x,
+                   const T beta,
+                   cv::Mat* y);
   
   /**
    *  @name   Gemm
@@ -169,6 +202,120 @@ class FK_EXPORTS LinearAlgebra {
                    const T beta,
                    cv::Mat* C);
     
+  /**
+   *  @name   GemvBatched
+   *  @fn void GemvBatched(const cv::Mat& A,
+                           const TransposeType trans_a,
+                           const T alpha,
+                           const cv::Mat& X,
+                           const T beta,
+                           cv::Mat* Y)
+   *  @brief  Multiplies a batch of matrices by a batch of vectors (strided
+   *          form). For each `i` in [0, X.rows):
+   *          Y_i = a * A_i x_i + b Y_i
+   *          Dispatched to batched BLAS routines when available, otherwise
+   *          items are processed concurrently on the default `ThreadPool`.
+   *  @param[in] A        Matrices A_i stacked vertically, i.e. A.rows must be a
+   *                      multiple of the batch size
+   *  @param[in] trans_a  Indicate if A_i are transpose or not
+   *  @param[in] alpha    Scaling factor alpha
+   *  @param[in] X        Vectors x_i, one per row
+   *  @param[in] beta     Scaling factor beta
+   *  @param[in,out] Y    Output vectors y_i, one per row
+   */
+  static void GemvBatched(const cv::Mat& A,
+                          const TransposeType trans_a,
+                          const T alpha,
+                          const cv::Mat& X,
+                          const T beta,
+                          cv::Mat* Y);
+
+  /**
+   *  @name   GemvBatched
+   *  @fn void GemvBatched(const std::vector<cv::Mat>& A,
+                           const TransposeType trans_a,
+                           const T alpha,
+                           const std::vector<cv::Mat>& x,
+                           const T beta,
+                           std::vector<cv::Mat>* y)
+   *  @brief  Multiplies a list of matrices by a list of vectors, matrices can
+   *          have different dimensions.
+   *          y[i] = a * A[i] x[i] + b y[i]
+   *  @param[in] A        List of matrices
+   *  @param[in] trans_a  Indicate if A[i] are transpose or not
+   *  @param[in] alpha    Scaling factor alpha
+   *  @param[in] x        List of vectors, same size as `A`
+   *  @param[in] beta     Scaling factor beta
+   *  @param[in,out] y    Output vectors
+   */
+  static void GemvBatched(const std::vector<cv::Mat>& A,
+                          const TransposeType trans_a,
+                          const T alpha,
+                          const std::vector<cv::Mat>& x,
+                          const T beta,
+                          std::vector<cv::Mat>* y);
+
+  /**
+   *  @name   GemmBatched
+   *  @fn void GemmBatched(const cv::Mat& A,
+                           const TransposeType trans_a,
+                           const T alpha,
+                           const cv::Mat& B,
+                           const TransposeType trans_b,
+                           const T beta,
+                           const int batch,
+                           cv::Mat* C)
+   *  @brief  Compute the product between two batches of matrices (strided
+   *          form). For each `i` in [0, batch):
+   *          C_i = a * A_i B_i + b * C_i
+   *          Dispatched to batched BLAS routines when available, otherwise
+   *          items are processed concurrently on the default `ThreadPool`.
+   *  @param[in] A         Matrices A_i stacked vertically
+   *  @param[in] trans_a   Transpose flag indicator for A_i
+   *  @param[in] alpha     Alpha coefficient
+   *  @param[in] B         Matrices B_i stacked vertically
+   *  @param[in] trans_b   Transpose flag indicator for B_i
+   *  @param[in] beta      Beta coefficient
+   *  @param[in] batch     Number of products
+   *  @param[in,out] C     Resulting matrices C_i stacked vertically
+   */
+  static void GemmBatched(const cv::Mat& A,
+                          const TransposeType trans_a,
+                          const T alpha,
+                          const cv::Mat& B,
+                          const TransposeType trans_b,
+                          const T beta,
+                          const int batch,
+                          cv::Mat* C);
+
+  /**
+   *  @name   GemmBatched
+   *  @fn void GemmBatched(const std::vector<cv::Mat>& A,
+                           const TransposeType trans_a,
+                           const T alpha,
+                           const std::vector<cv::Mat>& B,
+                           const TransposeType trans_b,
+                           const T beta,
+                           std::vector<cv::Mat>* C)
+   *  @brief  Compute the product between two lists of matrices, products can
+   *          have different dimensions.
+   *          C[i] = a * A[i] B[i] + b * C[i]
+   *  @param[in] A         List of matrices A
+   *  @param[in] trans_a   Transpose flag indicator for A[i]
+   *  @param[in] alpha     Alpha coefficient
+   *  @param[in] B         List of matrices B, same size as `A`
+   *  @param[in] trans_b   Transpose flag indicator for B[i]
+   *  @param[in] beta      Beta coefficient
+   *  @param[in,out] C     Resulting matrices
+   */
+  static void GemmBatched(const std::vector<cv::Mat>& A,
+                          const TransposeType trans_a,
+                          const T alpha,
+                          const std::vector<cv::Mat>& B,
+                          const TransposeType trans_b,
+                          const T beta,
+                          std::vector<cv::Mat>* C);
+
   /**
    * @name  Sbmv
    * @fn    static void Sbmv(const cv::Mat& A, const T alpha, const cv::Mat& x,
@@ -188,6 +335,116 @@ class FK_EXPORTS LinearAlgebra {
                    const T alpha,
                    const cv::Mat& x,
                    const T beta, cv::Mat* y);
+
+#pragma mark -
+#pragma mark BLAS on NDArray
+
+  /**
+   *  @name L2Norm
+   *  @fn T L2Norm(const NDArray& vector)
+   *  @brief  Compute the L2 norm of a vector. Strided views are processed in
+   *          place as long as their elements are evenly spaced.
+   *  @param[in]  vector  Vector to compute the norm
+   *  @return L2 Norm
+   */
+  static T L2Norm(const NDArray& vector);
+
+  /**
+   *  @name Axpy
+   *  @fn void Axpy(const NDArray& A, const T alpha, NDArray* B)
+   *  @brief  Compute : B := alpha * A + B. \p B is reallocated with the
+   *          dimensions of \p A if it does not hold as many elements or
+   *          can not be written in place.
+   *  @param[in]      A         Vector/Matrix A
+   *  @param[in]      alpha     Alpha scaling factor
+   *  @param[in,out]  B         Vector/Matrix B
+   */
+  static void Axpy(const NDArray& A, const T alpha, NDArray* B);
+
+  /**
+   *  @name   Dot
+   *  @fn T Dot(const NDArray& a, const NDArray& b)
+   *  @brief  Compute the dot product between two vectors \p a and \p b
+   *  @param[in]  a  Vector A
+   *  @param[in]  b  Vector B
+   *  @return Dot product
+   */
+  static T Dot(const NDArray& a, const NDArray& b);
+
+  /**
+   *  @name   Gemv
+   *  @fn void Gemv(const NDArray& A,
+                    const TransposeType trans_a,
+                    const T alpha,
+                    const NDArray& x,
+                    const T beta,
+                    NDArray* y)
+   *  @brief  Multiplies a matrix by a vector
+   *          Y = a * Ax + b Y
+   *          Row major and transposed views of \p A are used without copy,
+   *          \p y is reallocated as a rank-1 array if it does not match the
+   *          output length or can not be written in place.
+   *  @param[in] A        Matrix A, rank-2
+   *  @param[in] trans_a  Indicate if A is transpose or not
+   *  @param[in] alpha    Scaling factor alpha
+   *  @param[in] x        Vector X
+   *  @param[in] beta     Scaling factor beta
+   *  @param[in,out] y    Output vector
+   */
+  static void Gemv(const NDArray& A,
+                   const TransposeType trans_a,
+                   const T alpha,
+                   const NDArray& x,
+                   const T beta,
+                   NDArray* y);
+
+  /**
+   *  @name   Gemm
+   *  @fn void Gemm(const NDArray& A,
+                     const TransposeType trans_a,
+                     const T alpha,
+                     const NDArray& B,
+                     const TransposeType trans_b,
+                     const T beta,
+                     NDArray* C)
+   *  @brief  Compute the product between two matrices
+   *          C = a * AB + b * C
+   *          Row major and transposed views are used without copy, \p C is
+   *          reallocated if its dimensions do not match or if it can not be
+   *          written in place.
+   *  @param[in] A         Matrix A, rank-2
+   *  @param[in] trans_a   Transpose flag indicator for A
+   *  @param[in] alpha     Alpha coefficient
+   *  @param[in] B         Matrix B, rank-2
+   *  @param[in] trans_b   Transpose flag indicator for B
+   *  @param[in] beta      Beta coefficient
+   *  @param[in,out] C     Resulting matrix
+   */
+  static void Gemm(const NDArray& A,
+                   const TransposeType trans_a,
+                   const T alpha,
+                   const NDArray& B,
+                   const TransposeType trans_b,
+                   const T beta,
+                   NDArray* C);
+
+  /**
+   * @name  Sbmv
+   * @fn    static void Sbmv(const NDArray& A, const T alpha, const NDArray& x,
+                             const T beta, NDArray* y)
+   * @brief Perform matrix-vector operation :  y := alpha*A*x + beta*y
+   *        Support only diagonal matrix, i.e. element-wise vector
+   *        multiplication
+   * @param[in] A       Vector of element on the matrix's diagonal
+   * @param[in] alpha   Scaling factor
+   * @param[in] x       Vector
+   * @param[in] beta    Scaling factor
+   * @param[in, out] y  Output
+   */
+  static void Sbmv(const NDArray& A,
+                   const T alpha,
+                   const NDArray& x,
+                   const T beta, NDArray* y);
     
 #pragma mark -
 #pragma mark LAPACK
@@ -267,6 +524,212 @@ class FK_EXPORTS LinearAlgebra {
      *  @throw  std::runtime_error()
      */
     static void SquareLinearSolverCall(square_lin_solver_params& p);
+
+    /**
+     *  @name   SquareFactorCall
+     *  @fn inline void SquareFactorCall(square_lin_solver_params& p)
+     *  @brief  Interface for lapack LU factorization call (getrf), factors
+     *          are stored in place of `k_a`
+     *  @throw  std::runtime_error()
+     */
+    static void SquareFactorCall(square_lin_solver_params& p);
+
+    /**
+     *  @name   SquareSolveFactoredCall
+     *  @fn inline void SquareSolveFactoredCall(square_lin_solver_params& p)
+     *  @brief  Interface for lapack call solving with a previously computed
+     *          LU factorization (getrs)
+     *  @throw  std::runtime_error()
+     */
+    static void SquareSolveFactoredCall(square_lin_solver_params& p);
+
+    /**
+     * @struct  cholesky_solver_params
+     * @brief   Structure including all parameters for linear solver Ax = B
+     *          where A is symmetric positive definite
+     */
+    struct cholesky_solver_params {
+      /** Triangle of A being used, 'U' or 'L' */
+      char k_uplo;
+      /** Number of linear equation */
+      int k_n;
+      /** Number of right hand side, i.e. number of column in matrix B */
+      int k_nrhs;
+      /** Matrix A [N x N] */
+      T* k_a;
+      /** Leading direction in A */
+      int k_lda;
+      /** Right hand side - Matrix B */
+      T* k_b;
+      /** Leading direction in B */
+      int k_ldb;
+      /** Info - output */
+      int k_info;
+    };
+
+    /**
+     *  @name   CholeskyFactorCall
+     *  @fn inline void CholeskyFactorCall(cholesky_solver_params& p)
+     *  @brief  Interface for lapack Cholesky factorization call (potrf),
+     *          factor is stored in place of `k_a`
+     *  @throw  std::runtime_error()
+     */
+    static void CholeskyFactorCall(cholesky_solver_params& p);
+
+    /**
+     *  @name   CholeskySolveFactoredCall
+     *  @fn inline void CholeskySolveFactoredCall(cholesky_solver_params& p)
+     *  @brief  Interface for lapack call solving with a previously computed
+     *          Cholesky factorization (potrs)
+     *  @throw  std::runtime_error()
+     */
+    static void CholeskySolveFactoredCall(cholesky_solver_params& p);
+
+    /**
+     * @struct  svd_params
+     * @brief   Structure including all parameters for singular value
+     *          decomposition A = U S V' (gesdd)
+     */
+    struct svd_params {
+      /** Which part of U / V' to compute */
+      char k_jobz;
+      /** Number of rows in matrix A */
+      int k_m;
+      /** Number of cols in matrix A */
+      int k_n;
+      /** Matrix A data, destroyed */
+      T* k_a;
+      /** Leading direction of A */
+      int k_lda;
+      /** Singular values, descending order */
+      T* k_s;
+      /** Left singular vectors */
+      T* k_u;
+      /** Leading direction of U */
+      int k_ldu;
+      /** Right singular vectors, transposed */
+      T* k_vt;
+      /** Leading direction of V' */
+      int k_ldvt;
+      /** Workspace */
+      T* k_work;
+      /** Workspace size */
+      int k_lwork;
+      /** Integer workspace [8 * min(m, n)] */
+      int* k_iwork;
+      /** Info */
+      int k_info;
+    };
+
+    /**
+     *  @name   SvdCall
+     *  @fn inline void SvdCall(svd_params& p)
+     *  @brief  Interface for lapack divide and conquer SVD call (gesdd)
+     *  @throw  std::runtime_error()
+     */
+    static void SvdCall(svd_params& p);
+
+    /**
+     * @struct  sym_eig_params
+     * @brief   Structure including all parameters for eigen decomposition of
+     *          a symmetric matrix (syevr)
+     */
+    struct sym_eig_params {
+      /** Compute eigenvectors ('V') or not ('N') */
+      char k_jobz;
+      /** Range of eigenvalues to find, 'A' for all of them */
+      char k_range;
+      /** Triangle of A being used, 'U' or 'L' */
+      char k_uplo;
+      /** Dimension of A */
+      int k_n;
+      /** Matrix A data, destroyed */
+      T* k_a;
+      /** Leading direction of A */
+      int k_lda;
+      /** Lower bound of eigenvalues interval, used when range is 'V' */
+      T k_vl;
+      /** Upper bound of eigenvalues interval, used when range is 'V' */
+      T k_vu;
+      /** Index of the smallest eigenvalue, used when range is 'I' */
+      int k_il;
+      /** Index of the largest eigenvalue, used when range is 'I' */
+      int k_iu;
+      /** Absolute error tolerance, <= 0 for machine precision */
+      T k_abstol;
+      /** Number of eigenvalues found - output */
+      int k_found;
+      /** Eigenvalues, ascending order */
+      T* k_w;
+      /** Eigenvectors, stored in column */
+      T* k_z;
+      /** Leading direction of Z */
+      int k_ldz;
+      /** Support of eigenvectors [2 * N] */
+      int* k_isuppz;
+      /** Workspace */
+      T* k_work;
+      /** Workspace size */
+      int k_lwork;
+      /** Integer workspace */
+      int* k_iwork;
+      /** Integer workspace size */
+      int k_liwork;
+      /** Info */
+      int k_info;
+    };
+
+    /**
+     *  @name   SymEigCall
+     *  @fn inline void SymEigCall(sym_eig_params& p)
+     *  @brief  Interface for lapack symmetric eigen decomposition call
+     *          (syevr)
+     *  @throw  std::runtime_error()
+     */
+    static void SymEigCall(sym_eig_params& p);
+
+    /**
+     * @struct  qr_params
+     * @brief   Structure including all parameters for QR decomposition
+     *          (geqrf / orgqr)
+     */
+    struct qr_params {
+      /** Number of rows in matrix A */
+      int k_m;
+      /** Number of cols in matrix A */
+      int k_n;
+      /** Number of elementary reflectors */
+      int k_k;
+      /** Matrix A data, replaced by R and the reflectors */
+      T* k_a;
+      /** Leading direction of A */
+      int k_lda;
+      /** Scalar factors of the reflectors [min(m, n)] */
+      T* k_tau;
+      /** Workspace */
+      T* k_work;
+      /** Workspace size */
+      int k_lwork;
+      /** Info */
+      int k_info;
+    };
+
+    /**
+     *  @name   QrCall
+     *  @fn inline void QrCall(qr_params& p)
+     *  @brief  Interface for lapack QR factorization call (geqrf)
+     *  @throw  std::runtime_error()
+     */
+    static void QrCall(qr_params& p);
+
+    /**
+     *  @name   QrFormQCall
+     *  @fn inline void QrFormQCall(qr_params& p)
+     *  @brief  Interface for lapack call generating Q from the reflectors
+     *          computed by `QrCall` (orgqr)
+     *  @throw  std::runtime_error()
+     */
+    static void QrFormQCall(qr_params& p);
   };
     
 #pragma mark Linear Solver
@@ -338,9 +801,265 @@ class FK_EXPORTS LinearAlgebra {
      *  @param[out] x  Solution
      */
     void Solve(const cv::Mat& A, const cv::Mat& b, cv::Mat* x);
+
+    /**
+     *  @name Factorize
+     *  @fn Status Factorize(const cv::Mat& A)
+     *  @brief  Compute and keep the LU decomposition of \p A, to be used by
+     *          subsequent calls to `SolveFactored`
+     *  @param[in]  A  Square matrix A
+     *  @return Status of the operation, error if A is singular
+     */
+    Status Factorize(const cv::Mat& A);
+
+    /**
+     *  @name SolveFactored
+     *  @fn Status SolveFactored(const cv::Mat& b, cv::Mat* x)
+     *  @brief  Solve Ax = B with the decomposition computed by the last call
+     *          to `Factorize` or `Solve`
+     *  @param[in]  b  Matrix B, stored in column
+     *  @param[out] x  Solution
+     *  @return Status of the operation
+     */
+    Status SolveFactored(const cv::Mat& b, cv::Mat* x);
+
    private:
+    /**
+     *  @name Allocate
+     *  @fn void Allocate(const int& n, const int& nrhs)
+     *  @brief  Adapt buffers to a given system size, memory is reused when
+     *          dimensions do not change
+     *  @param[in] n    Number of equations
+     *  @param[in] nrhs Number of right hand side
+     */
+    void Allocate(const int& n, const int& nrhs);
+
     /** Solver configuration */
     typename Lapack::square_lin_solver_params p_;
+    /** Indicate if `p_.k_a` holds a valid factorization */
+    bool factorized_;
+  };
+
+  /**
+   *  @class CholeskySolver
+   *  @brief  Linear solver class for symmetric positive definite system
+   *          (i.e. normal equations J'J x = J'r). Solve Ax = B using Cholesky
+   *          decomposition on A, roughly half the cost of the LU path.
+   */
+  class CholeskySolver {
+   public:
+
+    /**
+     *  @name   CholeskySolver
+     *  @fn CholeskySolver(void)
+     *  @brief  Constructor
+     */
+    CholeskySolver(void);
+
+    /**
+     *  @name   ~CholeskySolver
+     *  @fn ~CholeskySolver(void)
+     *  @brief  Destructor
+     */
+    ~CholeskySolver(void);
+
+    /**
+     *  @name Solve
+     *  @fn void Solve(const cv::Mat& A, const cv::Mat& b, cv::Mat* x)
+     *  @brief  Solve Ax = B, \p x is empty if A is not positive definite
+     *  @param[in]  A  Symmetric positive definite matrix A
+     *  @param[in]  b  Matrix B, stored in column
+     *  @param[out] x  Solution
+     */
+    void Solve(const cv::Mat& A, const cv::Mat& b, cv::Mat* x);
+
+    /**
+     *  @name Factorize
+     *  @fn Status Factorize(const cv::Mat& A)
+     *  @brief  Compute and keep the Cholesky decomposition of \p A, to be
+     *          used by subsequent calls to `SolveFactored`
+     *  @param[in]  A  Symmetric positive definite matrix A
+     *  @return Status of the operation, error if A is not positive definite
+     */
+    Status Factorize(const cv::Mat& A);
+
+    /**
+     *  @name SolveFactored
+     *  @fn Status SolveFactored(const cv::Mat& b, cv::Mat* x)
+     *  @brief  Solve Ax = B with the decomposition computed by the last call
+     *          to `Factorize` or `Solve`
+     *  @param[in]  b  Matrix B, stored in column
+     *  @param[out] x  Solution
+     *  @return Status of the operation
+     */
+    Status SolveFactored(const cv::Mat& b, cv::Mat* x);
+
+   private:
+    /**
+     *  @name Allocate
+     *  @fn void Allocate(const int& n, const int& nrhs)
+     *  @brief  Adapt buffers to a given system size, memory is reused when
+     *          dimensions do not change
+     *  @param[in] n    Number of equations
+     *  @param[in] nrhs Number of right hand side
+     */
+    void Allocate(const int& n, const int& nrhs);
+
+    /** Solver configuration */
+    typename Lapack::cholesky_solver_params p_;
+    /** Indicate if `p_.k_a` holds a valid factorization */
+    bool factorized_;
+  };
+
+#pragma mark Decompositions
+
+  /**
+   *  @class QR
+   *  @brief  Thin QR decomposition A = QR of a matrix with more rows than
+   *          columns. Workspace is kept across calls with the same
+   *          dimensions.
+   */
+  class QR {
+   public:
+
+    /**
+     *  @name   QR
+     *  @fn QR(void)
+     *  @brief  Constructor
+     */
+    QR(void);
+
+    /**
+     *  @name   ~QR
+     *  @fn ~QR(void)
+     *  @brief  Destructor
+     */
+    ~QR(void);
+
+    /**
+     *  @name Compute
+     *  @fn Status Compute(const cv::Mat& A, cv::Mat* Q, cv::Mat* R)
+     *  @brief  Decompose \p A [m x n], m >= n
+     *  @param[in]  A  Matrix to decompose
+     *  @param[out] Q  Matrix with orthonormal columns [m x n]
+     *  @param[out] R  Upper triangular matrix [n x n], can be nullptr
+     *  @return Status of the operation
+     */
+    Status Compute(const cv::Mat& A, cv::Mat* Q, cv::Mat* R);
+
+   private:
+    /** Decomposition parameters */
+    typename Lapack::qr_params p_;
+  };
+
+  /**
+   *  @class SVD
+   *  @brief  Singular value decomposition A = U S V' based on the divide and
+   *          conquer algorithm, plus randomized truncated decomposition for
+   *          large data matrices. Workspace is kept across calls with the
+   *          same dimensions.
+   */
+  class SVD {
+   public:
+
+    /**
+     *  @name   SVD
+     *  @fn SVD(void)
+     *  @brief  Constructor
+     */
+    SVD(void);
+
+    /**
+     *  @name   ~SVD
+     *  @fn ~SVD(void)
+     *  @brief  Destructor
+     */
+    ~SVD(void);
+
+    /**
+     *  @name Compute
+     *  @fn Status Compute(const cv::Mat& A, cv::Mat* U, cv::Mat* S,
+                           cv::Mat* Vt)
+     *  @brief  Thin decomposition of \p A [m x n], with k = min(m, n)
+     *  @param[in]  A   Matrix to decompose
+     *  @param[out] U   Left singular vectors, stored in column [m x k]
+     *  @param[out] S   Singular values, descending order [k x 1]
+     *  @param[out] Vt  Right singular vectors, stored in row [k x n]
+     *  @return Status of the operation
+     */
+    Status Compute(const cv::Mat& A, cv::Mat* U, cv::Mat* S, cv::Mat* Vt);
+
+    /**
+     *  @name Truncated
+     *  @fn Status Truncated(const cv::Mat& A, const int rank,
+                             const int oversampling, const int n_iter,
+                             cv::Mat* U, cv::Mat* S, cv::Mat* Vt)
+     *  @brief  Approximate the \p rank leading singular triplets of \p A
+     *          with a randomized range finder (Halko et al.). Only products
+     *          with \p A and small dense decompositions are needed, which
+     *          suits tall data matrices.
+     *  @param[in]  A             Matrix to decompose [m x n]
+     *  @param[in]  rank          Number of singular triplets wanted
+     *  @param[in]  oversampling  Extra random samples, improves accuracy
+     *  @param[in]  n_iter        Number of power iterations, improves
+     *                            accuracy when the spectrum decays slowly
+     *  @param[out] U   Left singular vectors, stored in column [m x rank]
+     *  @param[out] S   Singular values, descending order [rank x 1]
+     *  @param[out] Vt  Right singular vectors, stored in row [rank x n]
+     *  @return Status of the operation
+     */
+    Status Truncated(const cv::Mat& A,
+                     const int rank,
+                     const int oversampling,
+                     const int n_iter,
+                     cv::Mat* U,
+                     cv::Mat* S,
+                     cv::Mat* Vt);
+
+   private:
+    /** Decomposition parameters */
+    typename Lapack::svd_params p_;
+  };
+
+  /**
+   *  @class SymmetricEigen
+   *  @brief  Eigen decomposition of a symmetric matrix (i.e. covariance).
+   *          Workspace is kept across calls with the same dimensions.
+   */
+  class SymmetricEigen {
+   public:
+
+    /**
+     *  @name   SymmetricEigen
+     *  @fn SymmetricEigen(void)
+     *  @brief  Constructor
+     */
+    SymmetricEigen(void);
+
+    /**
+     *  @name   ~SymmetricEigen
+     *  @fn ~SymmetricEigen(void)
+     *  @brief  Destructor
+     */
+    ~SymmetricEigen(void);
+
+    /**
+     *  @name Compute
+     *  @fn Status Compute(const cv::Mat& A, cv::Mat* values,
+                           cv::Mat* vectors)
+     *  @brief  Decompose symmetric \p A [n x n], same convention as
+     *          `cv::eigen`
+     *  @param[in]  A       Symmetric matrix
+     *  @param[out] values  Eigenvalues, descending order [n x 1]
+     *  @param[out] vectors Eigenvectors, stored in row [n x n], can be
+     *                      nullptr
+     *  @return Status of the operation
+     */
+    Status Compute(const cv::Mat& A, cv::Mat* values, cv::Mat* vectors);
+
+   private:
+    /** Decomposition parameters */
+    typename Lapack::sym_eig_params p_;
   };
 };
   
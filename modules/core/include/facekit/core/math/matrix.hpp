@@ -16,6 +16,7 @@
 
 #include "facekit/core/library_export.hpp"
 #include "facekit/core/math/vector.hpp"
+#include "facekit/core/math/point_transform.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -63,38 +64,27 @@ class FK_EXPORTS Matrix3 {
 
   /**
    *  @name Matrix3
-   *  @fn Matrix3(const Matrix3& other)
-   *  @brief  Copy Construcotr
+   *  @fn Matrix3(const Matrix3& other) = default
+   *  @brief  Copy Construcotr, trivial
    *  @param[in]  other  Object to copy from
    */
-  Matrix3(const Matrix3& other) {
-    memcpy(reinterpret_cast<void*>(&m_[0]),
-           reinterpret_cast<const void*>(&other.m_[0]),
-           9 * sizeof(T));
-  }
+  Matrix3(const Matrix3& other) = default;
 
   /**
    *  @name operator=
-   *  @fn Matrix3& operator=(const Matrix3& rhs)
-   *  @brief  Assignment operator
+   *  @fn Matrix3& operator=(const Matrix3& rhs) = default
+   *  @brief  Assignment operator, trivial
    *  @param[in]  rhs  Object to assign from
    *  @return Newly assigned object
    */
-  Matrix3& operator=(const Matrix3& rhs) {
-    if ( this != &rhs) {
-      memcpy(reinterpret_cast<void*>(&m_[0]),
-             reinterpret_cast<const void*>(&rhs.m_[0]),
-             9 * sizeof(T));
-    }
-    return *this;
-  }
+  Matrix3& operator=(const Matrix3& rhs) = default;
 
   /**
    *  @name ~Matrix3
-   *  @fn ~Matrix3(void)
+   *  @fn ~Matrix3(void) = default
    *  @brief  Destrucotr
    */
-  ~Matrix3(void) {}
+  ~Matrix3(void) = default;
 
 #pragma mark -
 #pragma mark Usage
@@ -195,36 +185,36 @@ class FK_EXPORTS Matrix3 {
 
   /**
    *  @name operator()(
-   *  @fn T& operator()(const int row, const int col)
+   *  @fn T& operator()(const int row, const int col) noexcept
    *  @brief  Row/Col matrix accessor
    *  @param[in]  row Index of the row
    *  @param[in]  col Index of the column
    *  @return Reference to the selected location
    */
-  T& operator()(const int row, const int col) {
+  T& operator()(const int row, const int col) noexcept {
     return m_[col * 3 + row];
   }
 
   /**
    *  @name operator()(
-   *  @fn const T& operator()(const int row, const int col) const
+   *  @fn const T& operator()(const int row, const int col) const noexcept
    *  @brief  Row/Col matrix accessor
    *  @param[in]  row Index of the row
    *  @param[in]  col Index of the column
    *  @return Reference to the selected location
    */
-  const T& operator()(const int row, const int col) const {
+  const T& operator()(const int row, const int col) const noexcept {
     return m_[col * 3 + row];
   }
 
   /**
    *  @name operator*
-   *  @fn Matrix3 operator*(const Matrix3& rhs) const
+   *  @fn Matrix3 operator*(const Matrix3& rhs) const noexcept
    *  @brief  Matrix multiplication
    *  @param[in]  rhs Right hand sign matrix
    *  @return Matrix product
    */
-  Matrix3 operator*(const Matrix3& rhs) const {
+  Matrix3 operator*(const Matrix3& rhs) const noexcept {
     Matrix3 M;
     M[0] = m_[0] * rhs[0] + m_[3] * rhs[1] + m_[6] * rhs[2];
     M[1] = m_[1] * rhs[0] + m_[4] * rhs[1] + m_[7] * rhs[2];
@@ -240,12 +230,12 @@ class FK_EXPORTS Matrix3 {
 
   /**
    *  @name operator*
-   *  @fn Vector3<T> operator*(const Vector3<T>& rhs) const
+   *  @fn Vector3<T> operator*(const Vector3<T>& rhs) const noexcept
    *  @brief  Multiply by a Vector3
    *  @param[in]  rhs Right hand sign vector
    *  @return Matrix-Vector product
    */
-  Vector3<T> operator*(const Vector3<T>& rhs) const {
+  Vector3<T> operator*(const Vector3<T>& rhs) const noexcept {
     Vector3<T> v;
     v.x_ = m_[0] * rhs.x_ + m_[3] * rhs.y_ + m_[6] * rhs.z_;
     v.y_ = m_[1] * rhs.x_ + m_[4] * rhs.y_ + m_[7] * rhs.z_;
@@ -255,12 +245,12 @@ class FK_EXPORTS Matrix3 {
 
   /**
    *  @name operator*
-   *  @fn Matrix3 operator*(const T s) const
+   *  @fn Matrix3 operator*(const T s) const noexcept
    *  @brief  Multiply by a scalar
    *  @param[in]  s Scalar to multiply by
    *  @return Scaled Matrix
    */
-  Matrix3<T> operator*(const T s) const {
+  Matrix3<T> operator*(const T s) const noexcept {
     Matrix3 M;
     #pragma unroll
     for (int i = 0; i < 9; ++i) {
@@ -271,12 +261,12 @@ class FK_EXPORTS Matrix3 {
 
   /**
    *  @name operator+
-   *  @fn Matrix3 operator+(const Matrix3& rhs) const
+   *  @fn Matrix3 operator+(const Matrix3& rhs) const noexcept
    *  @brief  Add another Matrix3
    *  @param[in]  rhs Right hand sign matrix
    *  @return Matrix addition
    */
-  Matrix3 operator+(const Matrix3& rhs) const {
+  Matrix3 operator+(const Matrix3& rhs) const noexcept {
     Matrix3 M;
     #pragma unroll
     for (int i = 0; i < 9; ++i) {
@@ -287,12 +277,12 @@ class FK_EXPORTS Matrix3 {
 
   /**
    *  @name operator-
-   *  @fn Matrix3 operator-(const Matrix3& rhs) const
+   *  @fn Matrix3 operator-(const Matrix3& rhs) const noexcept
    *  @brief  Subtract another Matrix3
    *  @param[in]  rhs Right hand sign matrix
    *  @return Matrix subtraction
    */
-  Matrix3 operator-(const Matrix3& rhs) const {
+  Matrix3 operator-(const Matrix3& rhs) const noexcept {
     Matrix3 M;
     #pragma unroll
     for (int i = 0; i < 9; ++i) {
@@ -301,14 +291,57 @@ class FK_EXPORTS Matrix3 {
     return M;
   }
 
+  /**
+   *  @name operator+=
+   *  @fn Matrix3& operator+=(const Matrix3& rhs) noexcept
+   *  @brief  In-place addition of another Matrix3
+   *  @param[in]  rhs Right hand sign matrix
+   *  @return Updated matrix
+   */
+  Matrix3& operator+=(const Matrix3& rhs) noexcept {
+    for (int i = 0; i < 9; ++i) {
+      m_[i] += rhs.m_[i];
+    }
+    return *this;
+  }
+
+  /**
+   *  @name operator*=
+   *  @fn Matrix3& operator*=(const T s) noexcept
+   *  @brief  In-place multiplication by a scalar
+   *  @param[in]  s Scalar to multiply by
+   *  @return Updated matrix
+   */
+  Matrix3& operator*=(const T s) noexcept {
+    for (int i = 0; i < 9; ++i) {
+      m_[i] *= s;
+    }
+    return *this;
+  }
+
+  /**
+   *  @name AddScaled
+   *  @fn Matrix3& AddScaled(const Matrix3& rhs, const T s) noexcept
+   *  @brief  In-place `this += rhs * s`, without temporary
+   *  @param[in]  rhs Matrix to add
+   *  @param[in]  s   Scale applied to `rhs`
+   *  @return Updated matrix
+   */
+  Matrix3& AddScaled(const Matrix3& rhs, const T s) noexcept {
+    for (int i = 0; i < 9; ++i) {
+      m_[i] += rhs.m_[i] * s;
+    }
+    return *this;
+  }
+
   /**
    *  @name operator=
-   *  @fn Matrix3& operator=(const T s)
+   *  @fn Matrix3& operator=(const T s) noexcept
    *  @brief  Assignment operator
    *  @param[in]  s Scalar to assign to this matrix
    *  @return
    */
-  Matrix3& operator=(const T s) {
+  Matrix3& operator=(const T s) noexcept {
     #pragma unroll
     for (int i = 0 ; i < 9 ; ++i) {
       m_[i] = s;
@@ -318,23 +351,23 @@ class FK_EXPORTS Matrix3 {
 
   /**
    *  @name operator[]
-   *  @fn T& operator[](const int idx)
+   *  @fn T& operator[](const int idx) noexcept
    *  @brief  Operator to linearly access element stored in column major flavor
    *  @param[in]  idx Index to reach
    *  @return Reference to the selected element
    */
-  T& operator[](const int idx) {
+  T& operator[](const int idx) noexcept {
     return m_[idx];
   }
 
   /**
    *  @name operator[]
-   *  @fn const T& operator[](const int idx) const
+   *  @fn const T& operator[](const int idx) const noexcept
    *  @brief  Operator to linearly access element stored in row major flavor
    *  @param[in]  idx Index to reach
    *  @return Reference to the selected element
    */
-  const T& operator[](const int idx) const {
+  const T& operator[](const int idx) const noexcept {
     return m_[idx];
   }
 
@@ -404,38 +437,27 @@ public:
 
   /**
    *  @name Matrix4
-   *  @fn Matrix4(const Matrix4& other)
-   *  @brief  Copy Construcotr
+   *  @fn Matrix4(const Matrix4& other) = default
+   *  @brief  Copy Construcotr, trivial
    *  @param[in]  other  Object to copy from
    */
-  Matrix4(const Matrix4& other) {
-    memcpy(reinterpret_cast<void*>(&m_[0]),
-           reinterpret_cast<const void*>(&other.m_[0]),
-           16 * sizeof(T));
-  }
+  Matrix4(const Matrix4& other) = default;
 
   /**
    *  @name operator=
-   *  @fn Matrix4& operator=(const Matrix4& rhs)
-   *  @brief  Assignment operator
+   *  @fn Matrix4& operator=(const Matrix4& rhs) = default
+   *  @brief  Assignment operator, trivial
    *  @param[in]  rhs  Object to assign from
    *  @return Newly assigned object
    */
-  Matrix4& operator=(const Matrix4& rhs) {
-    if ( this != &rhs) {
-      memcpy(reinterpret_cast<void*>(&m_[0]),
-             reinterpret_cast<const void*>(&rhs.m_[0]),
-             16 * sizeof(T));
-    }
-    return *this;
-  }
+  Matrix4& operator=(const Matrix4& rhs) = default;
 
   /**
    *  @name ~Matrix4
-   *  @fn ~Matrix4(void)
+   *  @fn ~Matrix4(void) = default
    *  @brief  Destrucotr
    */
-  ~Matrix4(void) {}
+  ~Matrix4(void) = default;
 
 #pragma mark -
 #pragma mark Usage
@@ -587,36 +609,36 @@ public:
 
   /**
    *  @name operator()(
-   *  @fn T& operator()(const int row, const int col)
+   *  @fn T& operator()(const int row, const int col) noexcept
    *  @brief  Row/Col matrix accessor
    *  @param[in]  row Index of the row
    *  @param[in]  col Index of the column
    *  @return Reference to the selected location
    */
-  T& operator()(const int row, const int col) {
+  T& operator()(const int row, const int col) noexcept {
     return m_[col * 4 + row];
   }
 
   /**
    *  @name operator()(
-   *  @fn const T& operator()(const int row, const int col) const
+   *  @fn const T& operator()(const int row, const int col) const noexcept
    *  @brief  Row/Col matrix accessor
    *  @param[in]  row Index of the row
    *  @param[in]  col Index of the column
    *  @return Reference to the selected location
    */
-  const T& operator()(const int row, const int col) const {
+  const T& operator()(const int row, const int col) const noexcept {
     return m_[col * 4 + row];
   }
 
   /**
    *  @name operator*
-   *  @fn Matrix4 operator*(const Matrix4& rhs) const
+   *  @fn Matrix4 operator*(const Matrix4& rhs) const noexcept
    *  @brief  Matrix multiplication
    *  @param[in]  rhs Right hand sign matrix
    *  @return Matrix product
    */
-  Matrix4 operator*(const Matrix4& rhs) const {
+  Matrix4 operator*(const Matrix4& rhs) const noexcept {
     Matrix4 M;
     M[0] = m_[0] * rhs[0] + m_[4] * rhs[1] + m_[8] * rhs[2] + m_[12] * rhs[3];
     M[1] = m_[1] * rhs[0] + m_[5] * rhs[1] + m_[9] * rhs[2] + m_[13] * rhs[3];
@@ -639,12 +661,12 @@ public:
 
   /**
    *  @name operator*
-   *  @fn Vector4<T> operator*(const Vector4<T>& rhs) const
+   *  @fn Vector4<T> operator*(const Vector4<T>& rhs) const noexcept
    *  @brief  Multiply by a Vector3
    *  @param[in]  rhs Right hand sign vector
    *  @return Matrix-Vector product
    */
-  Vector4<T> operator*(const Vector4<T>& rhs) const {
+  Vector4<T> operator*(const Vector4<T>& rhs) const noexcept {
     Vector4<T> v;
     v.x_ = m_[0] * rhs.x_ + m_[4] * rhs.y_ + m_[8] * rhs.z_ + m_[12] * rhs.w_;
     v.y_ = m_[1] * rhs.x_ + m_[5] * rhs.y_ + m_[9] * rhs.z_ + m_[13] * rhs.w_;
@@ -653,14 +675,36 @@ public:
     return v;
   }
 
+  /**
+   *  @name TransformPoints
+   *  @fn void TransformPoints(const T* in, T* out, const size_t& n,
+                               const bool& parallel = false) const
+   *  @brief  Apply the affine part of the matrix to `n` points stored as
+   *          interleaved (x, y, z) triplets, the last row is ignored.
+   *          Available for float and double.
+   *  @param[in]  in        Input points, 3 * `n` elements
+   *  @param[out] out       Output points, 3 * `n` elements, can be `in`
+   *  @param[in]  n         Number of points
+   *  @param[in]  parallel  Split large batches over the default thread pool
+   */
+  void TransformPoints(const T* in,
+                       T* out,
+                       const size_t& n,
+                       const bool& parallel = false) const {
+    const T r[9] = {m_[0], m_[1], m_[2],
+                    m_[4], m_[5], m_[6],
+                    m_[8], m_[9], m_[10]};
+    FaceKit::TransformPoints(&r[0], &m_[12], in, out, n, parallel);
+  }
+
   /**
    *  @name operator*
-   *  @fn Matrix4 operator*(const T s) const
+   *  @fn Matrix4 operator*(const T s) const noexcept
    *  @brief  Multiply by a scalar
    *  @param[in]  s Scalar to multiply by
    *  @return Scaled Matrix
    */
-  Matrix4<T> operator*(const T s) const {
+  Matrix4<T> operator*(const T s) const noexcept {
     Matrix4 M;
     #pragma unroll
     for (int i = 0; i < 16; ++i) {
@@ -671,12 +715,12 @@ public:
 
   /**
    *  @name operator+
-   *  @fn Matrix4 operator+(const Matrix4& rhs) const
+   *  @fn Matrix4 operator+(const Matrix4& rhs) const noexcept
    *  @brief  Add another Matrix4
    *  @param[in]  rhs Right hand sign matrix
    *  @return Matrix addition
    */
-  Matrix4 operator+(const Matrix4& rhs) const {
+  Matrix4 operator+(const Matrix4& rhs) const noexcept {
     Matrix4 M;
     #pragma unroll
     for (int i = 0; i < 16; ++i) {
@@ -687,12 +731,12 @@ public:
 
   /**
    *  @name operator-
-   *  @fn Matrix4 operator-(const Matrix4& rhs) const
+   *  @fn Matrix4 operator-(const Matrix4& rhs) const noexcept
    *  @brief  Subtract another Matrix4
    *  @param[in]  rhs Right hand sign matrix
    *  @return Matrix subtraction
    */
-  Matrix4 operator-(const Matrix4& rhs) const {
+  Matrix4 operator-(const Matrix4& rhs) const noexcept {
     Matrix4 M;
     #pragma unroll
     for (int i = 0; i < 16; ++i) {
@@ -703,12 +747,12 @@ public:
 
   /**
    *  @name operator=
-   *  @fn Matrix4& operator=(const T s)
+   *  @fn Matrix4& operator=(const T s) noexcept
    *  @brief  Assignment operator
    *  @param[in]  s Scalar to assign to this matrix
    *  @return Newly assigned operator
    */
-  Matrix4& operator=(const T s) {
+  Matrix4& operator=(const T s) noexcept {
     #pragma unroll
     for (int i = 0 ; i < 16 ; ++i) {
       m_[i] = s;
@@ -718,23 +762,23 @@ public:
 
   /**
    *  @name operator[]
-   *  @fn T& operator[](const int idx)
+   *  @fn T& operator[](const int idx) noexcept
    *  @brief  Operator to linearly access element stored in column major flavor
    *  @param[in]  idx Index to reach
    *  @return Reference to the selected element
    */
-  T& operator[](const int idx) {
+  T& operator[](const int idx) noexcept {
     return m_[idx];
   }
 
   /**
    *  @name operator[]
-   *  @fn const T& operator[](const int idx) const
+   *  @fn const T& operator[](const int idx) const noexcept
    *  @brief  Operator to linearly access element stored in row major flavor
    *  @param[in]  idx Index to reach
    *  @return Reference to the selected element
    */
-  const T& operator[](const int idx) const {
+  const T& operator[](const int idx) const noexcept {
     return m_[idx];
   }
   
@@ -0,0 +1,348 @@
+/**
+ *  @file   nd_array_ops.hpp
+ *  @brief  Element-wise operations on NDArray with runtime selected SIMD
+ *          kernels and lazy expressions
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   05.03.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_ND_ARRAY_OPS__
+#define __FACEKIT_ND_ARRAY_OPS__
+
+#include <string>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/nd_array.hpp"
+#include "facekit/core/status.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  NDArrayOps
+ *  @brief  Element-wise kernels over NDArray. Float and double kernels use
+ *          the widest SIMD instruction set supported by the CPU (AVX2,
+ *          SSE2 or NEON), detected once at runtime. Other numeric types use
+ *          plain loops. Half precision arrays are only supported by
+ *          conversions.
+ *  @author Christophe Ecabert
+ *  @date   05.03.18
+ *  @ingroup core
+ *  @details Operands must have the same type and dimensions, `out` is
+ *           resized if needed and can alias one of the inputs. Strided
+ *           inputs are gathered into a contiguous copy first.
+ */
+class FK_EXPORTS NDArrayOps {
+ public:
+
+  /**
+   *  @enum   SimdLevel
+   *  @brief  Instruction set used by the kernels
+   */
+  enum class SimdLevel : char {
+    /** Plain C++ */
+    kScalar,
+    /** x86 SSE2 */
+    kSse2,
+    /** x86 AVX2 + FMA */
+    kAvx2,
+    /** ARM NEON */
+    kNeon
+  };
+
+  /**
+   *  @name   Add
+   *  @fn     static Status Add(const NDArray& a, const NDArray& b,
+                                NDArray* out)
+   *  @brief  Compute out = a + b
+   *  @param[in] a    First operand
+   *  @param[in] b    Second operand
+   *  @param[out] out Result
+   *  @return kInvalidArgument if operands do not match or type is not
+   *          numeric
+   */
+  static Status Add(const NDArray& a, const NDArray& b, NDArray* out);
+
+  /**
+   *  @name   Mul
+   *  @fn     static Status Mul(const NDArray& a, const NDArray& b,
+                                NDArray* out)
+   *  @brief  Compute out = a * b
+   *  @param[in] a    First operand
+   *  @param[in] b    Second operand
+   *  @param[out] out Result
+   *  @return kInvalidArgument if operands do not match or type is not
+   *          numeric
+   */
+  static Status Mul(const NDArray& a, const NDArray& b, NDArray* out);
+
+  /**
+   *  @name   Fma
+   *  @fn     static Status Fma(const NDArray& a, const NDArray& b,
+                                const NDArray& c, NDArray* out)
+   *  @brief  Compute out = a * b + c in a single pass
+   *  @param[in] a    First operand
+   *  @param[in] b    Second operand
+   *  @param[in] c    Third operand
+   *  @param[out] out Result
+   *  @return kInvalidArgument if operands do not match or type is not
+   *          numeric
+   */
+  static Status Fma(const NDArray& a,
+                    const NDArray& b,
+                    const NDArray& c,
+                    NDArray* out);
+
+  /**
+   *  @name   Scale
+   *  @fn     static Status Scale(const NDArray& a, const double& alpha,
+                                  const double& beta, NDArray* out)
+   *  @brief  Compute out = alpha * a + beta
+   *  @param[in] a      Operand
+   *  @param[in] alpha  Scaling factor
+   *  @param[in] beta   Offset
+   *  @param[out] out   Result
+   *  @return kInvalidArgument if type is not numeric
+   */
+  static Status Scale(const NDArray& a,
+                      const double& alpha,
+                      const double& beta,
+                      NDArray* out);
+
+  /**
+   *  @name   Clamp
+   *  @fn     static Status Clamp(const NDArray& a, const double& lo,
+                                  const double& hi, NDArray* out)
+   *  @brief  Compute out = min(max(a, lo), hi)
+   *  @param[in] a    Operand
+   *  @param[in] lo   Lower bound
+   *  @param[in] hi   Upper bound
+   *  @param[out] out Result
+   *  @return kInvalidArgument if type is not numeric or lo > hi
+   */
+  static Status Clamp(const NDArray& a,
+                      const double& lo,
+                      const double& hi,
+                      NDArray* out);
+
+  /**
+   *  @name   Convert
+   *  @fn     static Status Convert(const NDArray& a, const DataType& type,
+                                    NDArray* out)
+   *  @brief  Convert array to another numeric type (static_cast semantic)
+   *  @param[in] a    Operand
+   *  @param[in] type Target type
+   *  @param[out] out Result, can not alias `a`
+   *  @return kInvalidArgument if one of the types is not numeric
+   */
+  static Status Convert(const NDArray& a, const DataType& type, NDArray* out);
+
+  /**
+   *  @name   Convert
+   *  @fn     static Status Convert(const NDArray& a, const DataType& type,
+                                    const double& alpha, const double& beta,
+                                    NDArray* out)
+   *  @brief  Compute out = saturate(alpha * a + beta) converted to `type`.
+   *          Integers are rounded to nearest and clamped to their range.
+   *          uint8/uint16/half <-> float use vectorized kernels computing in
+   *          single precision, other pairs compute in double precision.
+   *  @param[in] a      Operand
+   *  @param[in] type   Target type
+   *  @param[in] alpha  Scaling factor
+   *  @param[in] beta   Offset
+   *  @param[out] out   Result, can not alias `a`
+   *  @return kInvalidArgument if one of the types is not numeric
+   */
+  static Status Convert(const NDArray& a,
+                        const DataType& type,
+                        const double& alpha,
+                        const double& beta,
+                        NDArray* out);
+
+  /**
+   *  @name   simd_level
+   *  @fn     static SimdLevel simd_level(void)
+   *  @brief  Instruction set selected for this CPU
+   *  @return SIMD level
+   */
+  static SimdLevel simd_level(void);
+
+  /**
+   *  @name   simd_name
+   *  @fn     static std::string simd_name(void)
+   *  @brief  Name of the instruction set selected for this CPU
+   *  @return SIMD name
+   */
+  static std::string simd_name(void);
+};
+
+#pragma mark -
+#pragma mark Lazy expression
+
+namespace internal {
+
+/** Leaf of an expression, contiguous array */
+template<typename T>
+struct LeafExpr {
+  const T* data;
+  T operator[](const size_t& i) const { return data[i]; }
+};
+
+/** Constant of an expression */
+template<typename T>
+struct ConstExpr {
+  T value;
+  T operator[](const size_t&) const { return value; }
+};
+
+/** Addition */
+struct AddOp {
+  template<typename T>
+  static T Apply(const T& a, const T& b) { return a + b; }
+};
+
+/** Subtraction */
+struct SubOp {
+  template<typename T>
+  static T Apply(const T& a, const T& b) { return a - b; }
+};
+
+/** Multiplication */
+struct MulOp {
+  template<typename T>
+  static T Apply(const T& a, const T& b) { return a * b; }
+};
+
+/** Binary node of an expression */
+template<typename T, typename Op, typename L, typename R>
+struct BinaryExpr {
+  L lhs;
+  R rhs;
+  T operator[](const size_t& i) const { return Op::Apply(lhs[i], rhs[i]); }
+};
+
+}  // namespace internal
+
+/**
+ *  @class  LazyExpr
+ *  @brief  Element-wise expression evaluated in a single pass without
+ *          temporaries, i.e. `Lazy<float>(a) * Lazy<float>(b) + c`. Operands
+ *          must outlive the expression.
+ *  @author Christophe Ecabert
+ *  @date   05.03.18
+ *  @ingroup core
+ *  @tparam T Data type
+ *  @tparam E Expression node
+ */
+template<typename T, typename E>
+class LazyExpr {
+ public:
+
+  /**
+   *  @name   LazyExpr
+   *  @fn     LazyExpr(const E& expr, const NDArrayDims& dims,
+                       const bool& valid)
+   *  @brief  Constructor
+   *  @param[in] expr   Expression node
+   *  @param[in] dims   Dimensions of the result
+   *  @param[in] valid  False if operands do not match
+   */
+  LazyExpr(const E& expr,
+           const NDArrayDims& dims,
+           const bool& valid) : expr_(expr), dims_(dims), valid_(valid) {}
+
+  /**
+   *  @name   Eval
+   *  @fn     Status Eval(NDArray* out) const
+   *  @brief  Evaluate expression into `out`, resized if needed
+   *  @param[out] out Result
+   *  @return kInvalidArgument if operands do not match
+   */
+  Status Eval(NDArray* out) const {
+    if (!valid_) {
+      return Status(Status::Type::kInvalidArgument,
+                    "Operands are not contiguous or do not match");
+    }
+    if (out->type() != DataTypeToEnum<T>::v() || !out->IsContiguous() ||
+        out->dimensions() != dims_) {
+      out->Resize(DataTypeToEnum<T>::v(), dims_);
+    }
+    T* dst = out->AsFlat<T>().data();
+    const size_t n = dims_.n_elems();
+    for (size_t i = 0; i < n; ++i) {
+      dst[i] = expr_[i];
+    }
+    return Status();
+  }
+
+  /** Expression node */
+  const E& expr(void) const { return expr_; }
+  /** Dimensions */
+  const NDArrayDims& dims(void) const { return dims_; }
+  /** Validity */
+  bool valid(void) const { return valid_; }
+
+ private:
+  /** Expression */
+  E expr_;
+  /** Dimensions */
+  NDArrayDims dims_;
+  /** Operands validity */
+  bool valid_;
+};
+
+/**
+ *  @name   Lazy
+ *  @fn     LazyExpr<T, internal::LeafExpr<T>> Lazy(const NDArray& array)
+ *  @brief  Start a lazy expression from an array
+ *  @tparam T Data type, must match array's type
+ *  @param[in] array  Contiguous array
+ *  @return Expression
+ */
+template<typename T>
+LazyExpr<T, internal::LeafExpr<T>> Lazy(const NDArray& array) {
+  const bool valid = array.type() == DataTypeToEnum<T>::v() &&
+                     array.IsContiguous() && array.IsInitialized();
+  internal::LeafExpr<T> leaf{valid ? array.AsFlat<T>().data() : nullptr};
+  return LazyExpr<T, internal::LeafExpr<T>>(leaf, array.dimensions(), valid);
+}
+
+/** Combine two expressions */
+#define FACEKIT_LAZY_BINARY(OP, NODE)                                         \
+template<typename T, typename L, typename R>                                  \
+LazyExpr<T, internal::BinaryExpr<T, NODE, L, R>>                              \
+operator OP(const LazyExpr<T, L>& lhs, const LazyExpr<T, R>& rhs) {           \
+  using Node = internal::BinaryExpr<T, NODE, L, R>;                           \
+  const bool valid = lhs.valid() && rhs.valid() &&                            \
+                     lhs.dims() == rhs.dims();                                \
+  return LazyExpr<T, Node>(Node{lhs.expr(), rhs.expr()}, lhs.dims(), valid);  \
+}                                                                             \
+template<typename T, typename L>                                              \
+LazyExpr<T, internal::BinaryExpr<T, NODE, L, internal::ConstExpr<T>>>         \
+operator OP(const LazyExpr<T, L>& lhs, const T& rhs) {                        \
+  using Node = internal::BinaryExpr<T, NODE, L, internal::ConstExpr<T>>;      \
+  return LazyExpr<T, Node>(Node{lhs.expr(), internal::ConstExpr<T>{rhs}},     \
+                           lhs.dims(), lhs.valid());                          \
+}                                                                             \
+template<typename T, typename R>                                              \
+LazyExpr<T, internal::BinaryExpr<T, NODE, internal::ConstExpr<T>, R>>         \
+operator OP(const T& lhs, const LazyExpr<T, R>& rhs) {                        \
+  using Node = internal::BinaryExpr<T, NODE, internal::ConstExpr<T>, R>;      \
+  return LazyExpr<T, Node>(Node{internal::ConstExpr<T>{lhs}, rhs.expr()},     \
+                           rhs.dims(), rhs.valid());                          \
+}
+
+FACEKIT_LAZY_BINARY(+, internal::AddOp)
+FACEKIT_LAZY_BINARY(-, internal::SubOp)
+FACEKIT_LAZY_BINARY(*, internal::MulOp)
+
+#undef FACEKIT_LAZY_BINARY
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_ND_ARRAY_OPS__ */
@@ -0,0 +1,190 @@
+/**
+ *  @file   philox.hpp
+ *  @brief  Counter-based random number generator (Philox4x32-10)
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   08.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_PHILOX__
+#define __FACEKIT_PHILOX__
+
+#include <cstdint>
+#include <limits>
+
+#include "facekit/core/library_export.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  Philox4x32
+ *  @brief  Philox4x32-10 generator (Salmon et al., "Parallel random numbers:
+ *          as easy as 1, 2, 3"). Outputs are a bijection of a 128-bit
+ *          counter under a 64-bit key, hence any (key, stream) pair gives an
+ *          independent sequence and seeking is free: seeding costs nothing
+ *          compared to `std::mt19937`, so a generator can be rekeyed for
+ *          every work item (i.e. per sample) to get results independent of
+ *          the thread schedule. Satisfies UniformRandomBitGenerator, works
+ *          with the `<random>` distributions.
+ *  @author Christophe Ecabert
+ *  @date   08.11.18
+ *  @ingroup core
+ */
+class FK_EXPORTS Philox4x32 {
+ public:
+  /** Output type */
+  using result_type = uint32_t;
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   Philox4x32
+   *  @fn     explicit Philox4x32(const uint64_t& key = 0,
+                                  const uint64_t& stream = 0)
+   *  @brief  Constructor
+   *  @param[in] key    Key, i.e. global seed
+   *  @param[in] stream Sequence selector, i.e. work item identifier
+   */
+  explicit Philox4x32(const uint64_t& key = 0, const uint64_t& stream = 0) {
+    this->Seed(key, stream);
+  }
+
+  /**
+   *  @name   Seed
+   *  @fn     void Seed(const uint64_t& key, const uint64_t& stream = 0)
+   *  @brief  Select the sequence \p stream under \p key and rewind it
+   *  @param[in] key    Key, i.e. global seed
+   *  @param[in] stream Sequence selector, i.e. work item identifier
+   */
+  void Seed(const uint64_t& key, const uint64_t& stream = 0) {
+    key_[0] = static_cast<uint32_t>(key);
+    key_[1] = static_cast<uint32_t>(key >> 32);
+    ctr_[0] = 0;
+    ctr_[1] = 0;
+    ctr_[2] = static_cast<uint32_t>(stream);
+    ctr_[3] = static_cast<uint32_t>(stream >> 32);
+    idx_ = 4;
+  }
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   operator()
+   *  @fn     result_type operator()(void)
+   *  @brief  Next 32-bit value of the sequence
+   */
+  result_type operator()(void) {
+    if (idx_ == 4) {
+      Block(ctr_, key_, out_);
+      // 64-bit position, the upper words select the stream
+      if (++ctr_[0] == 0) {
+        ++ctr_[1];
+      }
+      idx_ = 0;
+    }
+    return out_[idx_++];
+  }
+
+  /**
+   *  @name   discard
+   *  @fn     void discard(uint64_t n)
+   *  @brief  Skip \p n values
+   */
+  void discard(uint64_t n) {
+    while (n > 0 && idx_ != 4) {
+      ++idx_;
+      --n;
+    }
+    // Jump over whole blocks
+    uint64_t pos = (uint64_t(ctr_[1]) << 32) | ctr_[0];
+    pos += n / 4;
+    ctr_[0] = static_cast<uint32_t>(pos);
+    ctr_[1] = static_cast<uint32_t>(pos >> 32);
+    for (uint64_t k = 0; k < n % 4; ++k) {
+      (*this)();
+    }
+  }
+
+  /**
+   *  @name   Block
+   *  @fn     static void Block(const uint32_t ctr[4], const uint32_t key[2],
+                                uint32_t out[4])
+   *  @brief  Philox4x32-10 bijection of a single counter
+   *  @param[in] ctr  Counter
+   *  @param[in] key  Key
+   *  @param[out] out Random block
+   */
+  static void Block(const uint32_t ctr[4],
+                    const uint32_t key[2],
+                    uint32_t out[4]) {
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int r = 0; r < 10; ++r) {
+      const uint64_t p0 = uint64_t(kMul0) * c0;
+      const uint64_t p1 = uint64_t(kMul1) * c2;
+      const uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+      const uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+      c1 = static_cast<uint32_t>(p1);
+      c3 = static_cast<uint32_t>(p0);
+      c0 = n0;
+      c2 = n2;
+      k0 += kWeyl0;
+      k1 += kWeyl1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+  }
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   min
+   *  @fn     static constexpr result_type min(void)
+   *  @brief  Smallest value generated
+   */
+  static constexpr result_type min(void) {
+    return 0;
+  }
+
+  /**
+   *  @name   max
+   *  @fn     static constexpr result_type max(void)
+   *  @brief  Largest value generated
+   */
+  static constexpr result_type max(void) {
+    return std::numeric_limits<result_type>::max();
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Round multipliers */
+  static constexpr uint32_t kMul0 = 0xD2511F53;
+  static constexpr uint32_t kMul1 = 0xCD9E8D57;
+  /** Key schedule increments */
+  static constexpr uint32_t kWeyl0 = 0x9E3779B9;
+  static constexpr uint32_t kWeyl1 = 0xBB67AE85;
+
+  /** Key */
+  uint32_t key_[2];
+  /** Counter, position in the low words, stream in the high ones */
+  uint32_t ctr_[4];
+  /** Current block */
+  uint32_t out_[4];
+  /** Next value in the current block, 4 if exhausted */
+  int idx_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_PHILOX__ */
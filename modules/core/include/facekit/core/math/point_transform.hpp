@@ -0,0 +1,83 @@
+/**
+ *  @file   point_transform.hpp
+ *  @brief  Rigid / affine transformation of batches of 3D points
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   27.08.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_POINT_TRANSFORM__
+#define __FACEKIT_POINT_TRANSFORM__
+
+#include <cstddef>
+
+#include "facekit/core/library_export.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @name   TransformPoints
+ *  @fn     void TransformPoints(const T* r, const T* t, const T* in, T* out,
+                                 const size_t& n, const bool& parallel)
+ *  @brief  Compute out_i = R * in_i + t for `n` points stored as interleaved
+ *          (x, y, z) triplets. Points are processed by blocks, transposed to
+ *          structure of arrays and transformed with the SIMD kernels picked
+ *          at runtime.
+ *  @param[in] r        Column-major 3x3 matrix
+ *  @param[in] t        Translation, 3 elements
+ *  @param[in] in       Input points, 3 * `n` elements
+ *  @param[out] out     Output points, 3 * `n` elements, can be `in`
+ *  @param[in] n        Number of points
+ *  @param[in] parallel If true, large batches are split over the default
+ *                      thread pool
+ *  @tparam T Data type, float or double
+ *  @ingroup core
+ */
+template<typename T>
+FK_EXPORTS void TransformPoints(const T* r,
+                                const T* t,
+                                const T* in,
+                                T* out,
+                                const size_t& n,
+                                const bool& parallel);
+
+/**
+ *  @name   TransformPointsSoa
+ *  @fn     void TransformPointsSoa(const T* r, const T* t, const T* x,
+                                    const T* y, const T* z, T* ox, T* oy,
+                                    T* oz, const size_t& n)
+ *  @brief  Compute o_i = R * v_i + t for `n` points stored as separated x, y
+ *          and z streams (structure of arrays), with the SIMD kernels picked
+ *          at runtime. Building block for callers that already work on
+ *          blocks of points and chain other SoA kernels.
+ *  @param[in] r    Column-major 3x3 matrix
+ *  @param[in] t    Translation, 3 elements
+ *  @param[in] x    Input x components, `n` elements
+ *  @param[in] y    Input y components, `n` elements
+ *  @param[in] z    Input z components, `n` elements
+ *  @param[out] ox  Output x components, can be `x`
+ *  @param[out] oy  Output y components, can be `y`
+ *  @param[out] oz  Output z components, can be `z`
+ *  @param[in] n    Number of points
+ *  @tparam T Data type, float or double
+ *  @ingroup core
+ */
+template<typename T>
+FK_EXPORTS void TransformPointsSoa(const T* r,
+                                   const T* t,
+                                   const T* x,
+                                   const T* y,
+                                   const T* z,
+                                   T* ox,
+                                   T* oy,
+                                   T* oz,
+                                   const size_t& n);
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_POINT_TRANSFORM__ */
@@ -0,0 +1,200 @@
+/**
+ *  @file   quantized_matrix.hpp
+ *  @brief  Dense matrix stored in reduced precision (fp16, bf16, int8) with
+ *          matrix-vector products accumulating in single precision
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   03.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_QUANTIZED_MATRIX__
+#define __FACEKIT_QUANTIZED_MATRIX__
+
+#include <cstdint>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  QuantizedMatrix
+ *  @brief  Row-major dense matrix stored in reduced precision to cut memory
+ *          bandwidth of matrix-vector products, typically a PCA basis.
+ *          Every column carries a scale factor: A(i, j) = q(i, j) * s(j).
+ *          Int8 storage uses symmetric per-column quantization, half
+ *          precision formats use a unit scale. Elements are widened on the
+ *          fly and accumulated in single precision.
+ *  @author Christophe Ecabert
+ *  @date   03.09.18
+ *  @ingroup core
+ */
+class FK_EXPORTS QuantizedMatrix {
+ public:
+
+  /**
+   *  @enum   Format
+   *  @brief  Storage format
+   */
+  enum class Format : char {
+    /** IEEE 754 half precision */
+    kFloat16,
+    /** bfloat16, upper half of a float */
+    kBFloat16,
+    /** Signed 8 bits with per-column scale */
+    kInt8
+  };
+
+  /**
+   *  @name   QuantizedMatrix
+   *  @fn     QuantizedMatrix(void)
+   *  @brief  Constructor
+   */
+  QuantizedMatrix(void);
+
+  /**
+   *  @name   Quantize
+   *  @fn     Status Quantize(const float* data, const int& rows,
+                              const int& cols, const Format& format)
+   *  @brief  Convert a row-major single precision matrix
+   *  @param[in] data   Matrix, rows x cols elements
+   *  @param[in] rows   Number of rows
+   *  @param[in] cols   Number of columns
+   *  @param[in] format Storage format
+   *  @return kInvalidArgument if dimensions are negative
+   */
+  Status Quantize(const float* data,
+                  const int& rows,
+                  const int& cols,
+                  const Format& format);
+
+  /**
+   *  @name   Quantize
+   *  @fn     Status Quantize(const double* data, const int& rows,
+                              const int& cols, const Format& format)
+   *  @brief  Convert a row-major double precision matrix
+   *  @param[in] data   Matrix, rows x cols elements
+   *  @param[in] rows   Number of rows
+   *  @param[in] cols   Number of columns
+   *  @param[in] format Storage format
+   *  @return kInvalidArgument if dimensions are negative
+   */
+  Status Quantize(const double* data,
+                  const int& rows,
+                  const int& cols,
+                  const Format& format);
+
+  /**
+   *  @name   Dequantize
+   *  @fn     void Dequantize(float* data) const
+   *  @brief  Expand into a row-major single precision matrix
+   *  @param[out] data  Matrix, rows x cols elements
+   */
+  void Dequantize(float* data) const;
+
+  /**
+   *  @name   Gemv
+   *  @fn     void Gemv(const bool& trans, const float& alpha, const float* x,
+                        const float& beta, float* y) const
+   *  @brief  Matrix-vector product y = alpha * op(A) * x + beta * y, rows
+   *          are split over the default thread pool for large matrices.
+   *  @param[in] trans  If true op(A) = A', otherwise op(A) = A
+   *  @param[in] alpha  Scaling factor for the product
+   *  @param[in] x      Input vector, cols (rows if transposed) elements
+   *  @param[in] beta   Scaling factor for y, if 0 `y` is not read
+   *  @param[in,out] y  Output vector, rows (cols if transposed) elements,
+   *                    must not alias `x`
+   */
+  void Gemv(const bool& trans,
+            const float& alpha,
+            const float* x,
+            const float& beta,
+            float* y) const;
+
+  /**
+   *  @name   rows
+   *  @fn     int rows(void) const
+   *  @brief  Number of rows
+   *  @return Number of rows
+   */
+  int rows(void) const {
+    return rows_;
+  }
+
+  /**
+   *  @name   cols
+   *  @fn     int cols(void) const
+   *  @brief  Number of columns
+   *  @return Number of columns
+   */
+  int cols(void) const {
+    return cols_;
+  }
+
+  /**
+   *  @name   format
+   *  @fn     Format format(void) const
+   *  @brief  Storage format
+   *  @return Format
+   */
+  Format format(void) const {
+    return format_;
+  }
+
+  /**
+   *  @name   scale
+   *  @fn     const std::vector<float>& scale(void) const
+   *  @brief  Per-column scale factors
+   *  @return Scales
+   */
+  const std::vector<float>& scale(void) const {
+    return scale_;
+  }
+
+  /**
+   *  @name   ElementSize
+   *  @fn     size_t ElementSize(void) const
+   *  @brief  Number of bytes per stored element
+   *  @return 2 for half precision formats, 1 for int8
+   */
+  size_t ElementSize(void) const {
+    return format_ == Format::kInt8 ? 1 : 2;
+  }
+
+ private:
+  /**
+   *  @name   QuantizeImpl
+   *  @fn     template<typename T> Status QuantizeImpl(const T* data,
+                                                       const int& rows,
+                                                       const int& cols,
+                                                       const Format& format)
+   *  @brief  Convert a row-major matrix
+   *  @tparam T Source data type
+   */
+  template<typename T>
+  Status QuantizeImpl(const T* data,
+                      const int& rows,
+                      const int& cols,
+                      const Format& format);
+
+  /** Number of rows */
+  int rows_;
+  /** Number of columns */
+  int cols_;
+  /** Storage format */
+  Format format_;
+  /** Per-column scale */
+  std::vector<float> scale_;
+  /** Quantized data, row-major */
+  std::vector<uint8_t> data_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_QUANTIZED_MATRIX__ */
@@ -11,6 +11,8 @@
 #ifndef __FACEKIT_quaternion__
 #define __FACEKIT_quaternion__
 
+#include <cstddef>
+
 #include "facekit/core/library_export.hpp"
 #include "facekit/core/math/vector.hpp"
 #include "facekit/core/math/matrix.hpp"
@@ -54,27 +56,20 @@ class FK_EXPORTS Quaternion {
   
   /**
    *  @name Quaternion
-   *  @fn Quaternion(const Quaternion& other)
+   *  @fn Quaternion(const Quaternion& other) = default
    *  @brief  Copy constructor
    *  @param[in]  other Object to copy from
    */
-  Quaternion(const Quaternion& other) : q_(other.q_), v_(other.v_) {
-  }
+  Quaternion(const Quaternion& other) = default;
   
   /**
    *  @name operator=
-   *  @fn Quaternion& operator=(const Quaternion& rhs)
+   *  @fn Quaternion& operator=(const Quaternion& rhs) = default
    *  @brief  Assignment operator
    *  @param[in]  rhs Object to assign from
    *  @return Newly assigned object
    */
-  Quaternion& operator=(const Quaternion& rhs) {
-    if (this != &rhs) {
-      q_ = rhs.q_;
-      v_ = rhs.v_;
-    }
-    return *this;
-  }
+  Quaternion& operator=(const Quaternion& rhs) = default;
   
   /**
    *  @name Quaternion
@@ -95,45 +90,45 @@ class FK_EXPORTS Quaternion {
   
   /**
    *  @name ~Quaternion
-   *  @fn ~Quaternion(void)
+   *  @fn ~Quaternion(void) = default
    *  @brief  Destructor
    */
-  ~Quaternion(void) {}
+  ~Quaternion(void) = default;
   
 #pragma mark -
 #pragma mark Operator
   
   /**
    *  @name operator+
-   *  @fn Quaternion operator+(const Quaternion& rhs)
+   *  @fn Quaternion operator+(const Quaternion& rhs) const noexcept
    *  @brief  Addition operator
    *  @param[in]  rhs Quaternion to add
    *  @return Addition result
    */
-  Quaternion operator+(const Quaternion& rhs) {
+  Quaternion operator+(const Quaternion& rhs) const noexcept {
     return Quaternion(q_ + rhs.q_, v_ + rhs.v_);
   }
   
   /**
    *  @name operator-
-   *  @fn Quaternion operator-(const Quaternion& rhs)
-   *  @brief  Addition operator
-   *  @param[in]  rhs Quaternion to add
-   *  @return Addition result
+   *  @fn Quaternion operator-(const Quaternion& rhs) const noexcept
+   *  @brief  Subtraction operator
+   *  @param[in]  rhs Quaternion to subtract
+   *  @return Subtraction result
    */
-  Quaternion operator-(const Quaternion& rhs) {
+  Quaternion operator-(const Quaternion& rhs) const noexcept {
     return Quaternion(q_ - rhs.q_, v_ - rhs.v_);
   }
   
   /**
    *  @name operator*
-   *  @fn Quaternion operator*(const Quaternion& rhs)
-   *  @brief  Multiplication operator
+   *  @fn Quaternion operator*(const Quaternion& rhs) const noexcept
+   *  @brief  Multiplication operator (Hamilton product)
    *  @param[in]  rhs Quaternion to multiply
    *  @return Multiply result
    */
-  Quaternion operator*(const Quaternion& rhs) {
-    return Quaternion((q_ * rhs.q_) + (v_ * rhs.v_),
+  Quaternion operator*(const Quaternion& rhs) const noexcept {
+    return Quaternion((q_ * rhs.q_) - (v_ * rhs.v_),
                       (v_ ^ rhs.v_) + (rhs.v_ * q_) + (v_ * rhs.q_));
   }
   
@@ -146,17 +141,17 @@ class FK_EXPORTS Quaternion {
    *  @brief  In place conjugate (i.e. q.v = -q.v)
    */
   void InPlaceConjugate(void) {
-    v_ = -v_;
+    v_ *= T(-1.0);
   }
   
   /**
    *  @name Conjugate
-   *  @fn void Conjugate(void)
+   *  @fn Quaternion Conjugate(void) const
    *  @brief  Conjugate (i.e. q.v = -q.v)
    *  @return Return conjugate quaternion
    */
-  Quaternion& Conjugate(void) {
-    return Quaternion(q_, -v_);
+  Quaternion Conjugate(void) const {
+    return Quaternion(q_, v_ * T(-1.0));
   }
   
   /**
@@ -198,11 +193,11 @@ class FK_EXPORTS Quaternion {
   
   /**
    *  @name ToRotationMatrix
-   *  @fn void ToRotationMatrix(Matrix3<T>* m)
+   *  @fn void ToRotationMatrix(Matrix3<T>* m) const
    *  @brief  Transform quaternion to rotation matrix
    *  @param[out] m Rotation matrix
    */
-  void ToRotationMatrix(Matrix3<T>* m) {
+  void ToRotationMatrix(Matrix3<T>* m) const {
     const T qq0 = q_ * q_;
     const T qq1 = v_.x_ * v_.x_;
     const T qq2 = v_.y_ * v_.y_;
@@ -221,11 +216,11 @@ class FK_EXPORTS Quaternion {
   
   /**
    *  @name ToRotationMatrix
-   *  @fn void ToRotationMatrix(Matrix4<T>* m)
+   *  @fn void ToRotationMatrix(Matrix4<T>* m) const
    *  @brief  Transform quaternion to rotation matrix
    *  @param[out] m Rotation matrix
    */
-  void ToRotationMatrix(Matrix4<T>* m) {
+  void ToRotationMatrix(Matrix4<T>* m) const {
     const T qq0 = q_ * q_;
     const T qq1 = v_.x_ * v_.x_;
     const T qq2 = v_.y_ * v_.y_;
@@ -249,6 +244,74 @@ class FK_EXPORTS Quaternion {
     mm[15] = T(1.0);
   }
   
+  /**
+   *  @name RotatePoints
+   *  @fn void RotatePoints(const T* in, T* out, const size_t& n,
+                            const bool& parallel = false) const
+   *  @brief  Rotate `n` points stored as interleaved (x, y, z) triplets. The
+   *          quaternion is expected to be normalized, it is converted once
+   *          to a rotation matrix. Available for float and double.
+   *  @param[in]  in        Input points, 3 * `n` elements
+   *  @param[out] out       Output points, 3 * `n` elements, can be `in`
+   *  @param[in]  n         Number of points
+   *  @param[in]  parallel  Split large batches over the default thread pool
+   */
+  void RotatePoints(const T* in,
+                    T* out,
+                    const size_t& n,
+                    const bool& parallel = false) const {
+    Matrix3<T> rot;
+    this->ToRotationMatrix(&rot);
+    const T t[3] = {T(0.0), T(0.0), T(0.0)};
+    FaceKit::TransformPoints(rot.data(), &t[0], in, out, n, parallel);
+  }
+
+#pragma mark -
+#pragma mark Batch
+
+  /**
+   *  @name ComposeBatch
+   *  @fn static void ComposeBatch(const Quaternion* a, const Quaternion* b,
+                                   Quaternion* out, const size_t& n)
+   *  @brief  Compute out_i = a_i * b_i for `n` pairs of quaternions. Arrays
+   *          are processed by blocks transposed to structure of arrays, the
+   *          products are therefore vectorized. Available for float and
+   *          double.
+   *  @param[in]  a   Left hand side quaternions
+   *  @param[in]  b   Right hand side quaternions
+   *  @param[out] out Products, can be `a` or `b`
+   *  @param[in]  n   Number of quaternions
+   */
+  static void ComposeBatch(const Quaternion* a,
+                           const Quaternion* b,
+                           Quaternion* out,
+                           const size_t& n);
+
+  /**
+   *  @name NormalizeBatch
+   *  @fn static void NormalizeBatch(Quaternion* q, const size_t& n)
+   *  @brief  Normalize `n` quaternions in place. Available for float and
+   *          double.
+   *  @param[in,out] q  Quaternions to normalize
+   *  @param[in]     n  Number of quaternions
+   */
+  static void NormalizeBatch(Quaternion* q, const size_t& n);
+
+  /**
+   *  @name ToRotationMatrixBatch
+   *  @fn static void ToRotationMatrixBatch(const Quaternion* q,
+                                            Matrix3<T>* m, const size_t& n)
+   *  @brief  Convert `n` normalized quaternions to rotation matrices, same
+   *          convention as `ToRotationMatrix`. Available for float and
+   *          double.
+   *  @param[in]  q Quaternions
+   *  @param[out] m Rotation matrices
+   *  @param[in]  n Number of quaternions
+   */
+  static void ToRotationMatrixBatch(const Quaternion* q,
+                                    Matrix3<T>* m,
+                                    const size_t& n);
+  
 #pragma mark -
 #pragma mark Members
 
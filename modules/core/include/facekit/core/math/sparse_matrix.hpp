@@ -0,0 +1,355 @@
+/**
+ *  @file   sparse_matrix.hpp
+ *  @brief  Compressed sparse row matrix, sparse products and conjugate
+ *          gradient solver
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   31.08.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_SPARSE_MATRIX__
+#define __FACEKIT_SPARSE_MATRIX__
+
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  SparseMatrix
+ *  @brief  Sparse matrix stored in compressed sparse row (CSR) format. The
+ *          compressed sparse column (CSC) representation of a matrix is the
+ *          CSR representation of its transpose, see `Transpose`.
+ *          Products are split over the default thread pool for large
+ *          matrices. Dense operands are row-major buffers.
+ *  @author Christophe Ecabert
+ *  @date   31.08.18
+ *  @ingroup core
+ *  @tparam T Data type, float or double
+ */
+template<typename T>
+class FK_EXPORTS SparseMatrix {
+ public:
+
+  /**
+   *  @struct Triplet
+   *  @brief  Non-zero entry (row, col, value)
+   */
+  struct Triplet {
+    /** Row index */
+    int row;
+    /** Column index */
+    int col;
+    /** Value */
+    T value;
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   SparseMatrix
+   *  @fn     SparseMatrix(void)
+   *  @brief  Constructor
+   */
+  SparseMatrix(void);
+
+  /**
+   *  @name   SparseMatrix
+   *  @fn     SparseMatrix(const int& rows, const int& cols)
+   *  @brief  Constructor, create an empty (all zeros) matrix
+   *  @param[in] rows Number of rows
+   *  @param[in] cols Number of columns
+   */
+  SparseMatrix(const int& rows, const int& cols);
+
+  /**
+   *  @name   FromTriplets
+   *  @fn     Status FromTriplets(const int& rows, const int& cols,
+                                  const std::vector<Triplet>& triplets)
+   *  @brief  Build matrix from a list of entries in any order, duplicated
+   *          entries are summed.
+   *  @param[in] rows     Number of rows
+   *  @param[in] cols     Number of columns
+   *  @param[in] triplets Non-zero entries
+   *  @return kInvalidArgument if an entry is out of bounds
+   */
+  Status FromTriplets(const int& rows,
+                      const int& cols,
+                      const std::vector<Triplet>& triplets);
+
+  /**
+   *  @name   Transpose
+   *  @fn     void Transpose(SparseMatrix* out) const
+   *  @brief  Compute the transpose, i.e. the CSC representation of this
+   *          matrix.
+   *  @param[out] out Transposed matrix
+   */
+  void Transpose(SparseMatrix* out) const;
+
+  /**
+   *  @name   Diagonal
+   *  @fn     void Diagonal(std::vector<T>* diag) const
+   *  @brief  Extract the main diagonal
+   *  @param[out] diag  Diagonal, min(rows, cols) elements
+   */
+  void Diagonal(std::vector<T>* diag) const;
+
+  /**
+   *  @name   ToDense
+   *  @fn     void ToDense(T* dense, const int& ld) const
+   *  @brief  Expand into a row-major dense buffer
+   *  @param[out] dense Buffer of at least rows * ld elements
+   *  @param[in] ld     Leading dimension of `dense`, >= cols
+   */
+  void ToDense(T* dense, const int& ld) const;
+
+#pragma mark -
+#pragma mark Products
+
+  /**
+   *  @name   Spmv
+   *  @fn     void Spmv(const T& alpha, const T* x, const T& beta,
+                        T* y) const
+   *  @brief  Sparse matrix - dense vector product, y = alpha * A * x +
+   *          beta * y
+   *  @param[in] alpha      Scaling factor for the product
+   *  @param[in] x          Vector of `cols` elements
+   *  @param[in] beta       Scaling factor for `y`, if 0 `y` is not read
+   *  @param[in,out] y      Vector of `rows` elements, must not alias `x`
+   */
+  void Spmv(const T& alpha, const T* x, const T& beta, T* y) const;
+
+  /**
+   *  @name   Spmm
+   *  @fn     void Spmm(const T& alpha, const T* b, const int& k,
+                        const int& ldb, const T& beta, T* c,
+                        const int& ldc) const
+   *  @brief  Sparse matrix - dense matrix product, C = alpha * A * B +
+   *          beta * C
+   *  @param[in] alpha    Scaling factor for the product
+   *  @param[in] b        Row-major dense matrix [cols x k]
+   *  @param[in] k        Number of columns in B and C
+   *  @param[in] ldb      Leading dimension of B, >= k
+   *  @param[in] beta     Scaling factor for C, if 0 C is not read
+   *  @param[in,out] c    Row-major dense matrix [rows x k], must not alias B
+   *  @param[in] ldc      Leading dimension of C, >= k
+   */
+  void Spmm(const T& alpha,
+            const T* b,
+            const int& k,
+            const int& ldb,
+            const T& beta,
+            T* c,
+            const int& ldc) const;
+
+  /**
+   *  @name   Multiply
+   *  @fn     static Status Multiply(const SparseMatrix& a,
+                                     const SparseMatrix& b,
+                                     SparseMatrix* c)
+   *  @brief  Sparse matrix - sparse matrix product, C = A * B
+   *  @param[in] a    Left operand
+   *  @param[in] b    Right operand
+   *  @param[out] c   Product, must not be `a` or `b`
+   *  @return kInvalidArgument if dimensions do not match
+   */
+  static Status Multiply(const SparseMatrix& a,
+                         const SparseMatrix& b,
+                         SparseMatrix* c);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   rows
+   *  @fn     int rows(void) const
+   *  @brief  Number of rows
+   *  @return Number of rows
+   */
+  int rows(void) const {
+    return rows_;
+  }
+
+  /**
+   *  @name   cols
+   *  @fn     int cols(void) const
+   *  @brief  Number of columns
+   *  @return Number of columns
+   */
+  int cols(void) const {
+    return cols_;
+  }
+
+  /**
+   *  @name   nnz
+   *  @fn     int nnz(void) const
+   *  @brief  Number of stored entries
+   *  @return Number of non-zeros
+   */
+  int nnz(void) const {
+    return static_cast<int>(values_.size());
+  }
+
+  /**
+   *  @name   row_ptr
+   *  @fn     const std::vector<int>& row_ptr(void) const
+   *  @brief  Row offsets, `rows + 1` elements
+   *  @return Row offsets
+   */
+  const std::vector<int>& row_ptr(void) const {
+    return row_ptr_;
+  }
+
+  /**
+   *  @name   col_idx
+   *  @fn     const std::vector<int>& col_idx(void) const
+   *  @brief  Column index of each entry, sorted within a row
+   *  @return Column indices
+   */
+  const std::vector<int>& col_idx(void) const {
+    return col_idx_;
+  }
+
+  /**
+   *  @name   values
+   *  @fn     const std::vector<T>& values(void) const
+   *  @brief  Value of each entry
+   *  @return Values
+   */
+  const std::vector<T>& values(void) const {
+    return values_;
+  }
+
+  /**
+   *  @name   values
+   *  @fn     std::vector<T>& values(void)
+   *  @brief  Value of each entry, can be updated in place without changing
+   *          the sparsity pattern
+   *  @return Values
+   */
+  std::vector<T>& values(void) {
+    return values_;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Number of rows */
+  int rows_;
+  /** Number of columns */
+  int cols_;
+  /** Row offsets */
+  std::vector<int> row_ptr_;
+  /** Column indices */
+  std::vector<int> col_idx_;
+  /** Values */
+  std::vector<T> values_;
+};
+
+/**
+ *  @class  ConjugateGradient
+ *  @brief  Jacobi preconditioned conjugate gradient solver for sparse
+ *          symmetric positive definite systems A * x = b. Working buffers
+ *          are kept between calls.
+ *  @author Christophe Ecabert
+ *  @date   31.08.18
+ *  @ingroup core
+ *  @tparam T Data type, float or double
+ */
+template<typename T>
+class FK_EXPORTS ConjugateGradient {
+ public:
+
+  /**
+   *  @name   ConjugateGradient
+   *  @fn     ConjugateGradient(void)
+   *  @brief  Constructor, at most 1000 iterations with a relative
+   *          tolerance of 1e-6
+   */
+  ConjugateGradient(void);
+
+  /**
+   *  @name   Solve
+   *  @fn     Status Solve(const SparseMatrix<T>& a, const T* b, T* x)
+   *  @brief  Solve A * x = b
+   *  @param[in] a      Symmetric positive definite matrix
+   *  @param[in] b      Right hand side, `rows` elements
+   *  @param[in,out] x  Initial guess on input, solution on output
+   *  @return kInvalidArgument if `a` is not square, kInternalError if the
+   *          solver did not converge within the iteration budget
+   */
+  Status Solve(const SparseMatrix<T>& a, const T* b, T* x);
+
+  /**
+   *  @name   set_max_iterations
+   *  @fn     void set_max_iterations(const int& n)
+   *  @brief  Define the maximum number of iterations
+   *  @param[in] n  Number of iterations
+   */
+  void set_max_iterations(const int& n) {
+    max_iter_ = n;
+  }
+
+  /**
+   *  @name   set_tolerance
+   *  @fn     void set_tolerance(const T& tol)
+   *  @brief  Define the stopping criterion |r| <= tol * |b|
+   *  @param[in] tol  Relative tolerance
+   */
+  void set_tolerance(const T& tol) {
+    tol_ = tol;
+  }
+
+  /**
+   *  @name   iterations
+   *  @fn     int iterations(void) const
+   *  @brief  Number of iterations performed by the last call to `Solve`
+   *  @return Number of iterations
+   */
+  int iterations(void) const {
+    return iter_;
+  }
+
+  /**
+   *  @name   residual
+   *  @fn     T residual(void) const
+   *  @brief  Relative residual |r| / |b| reached by the last call to
+   *          `Solve`
+   *  @return Relative residual
+   */
+  T residual(void) const {
+    return residual_;
+  }
+
+ private:
+  /** Maximum number of iterations */
+  int max_iter_;
+  /** Relative tolerance */
+  T tol_;
+  /** Iterations performed */
+  int iter_;
+  /** Relative residual reached */
+  T residual_;
+  /** Residual */
+  std::vector<T> r_;
+  /** Preconditioned residual */
+  std::vector<T> z_;
+  /** Search direction */
+  std::vector<T> p_;
+  /** A * p */
+  std::vector<T> q_;
+  /** Inverse of the diagonal */
+  std::vector<T> inv_diag_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_SPARSE_MATRIX__ */
@@ -17,6 +17,7 @@
 
 #include "facekit/core/library_export.hpp"
 #include "facekit/core/math/type_comparator.hpp"
+#include "facekit/core/math/fast_math.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -43,51 +44,42 @@ struct FK_EXPORTS Vector2 {
 
   /**
    *  @name Vector2
-   *  @fn Vector2(void)
+   *  @fn constexpr Vector2(void) noexcept
    *  @brief  Constructor
    */
-  Vector2(void) : x_(0), y_(0) {}
+  constexpr Vector2(void) noexcept : x_(0), y_(0) {}
 
   /**
    *  @name Vector2
-   *  @fn Vector2(const T x, const T y)
+   *  @fn constexpr Vector2(const T x, const T y) noexcept
    *  @brief  Constructor
    *  @param[in]  x   X component
    *  @param[in]  y   Y component
    */
-  Vector2(const T x, const T y) : x_(x), y_(y) {}
+  constexpr Vector2(const T x, const T y) noexcept : x_(x), y_(y) {}
 
   /**
    *  @name Vector2
-   *  @fn Vector2(const Vector2& other)
-   *  @brief  Copy constructor
+   *  @fn Vector2(const Vector2& other) = default
+   *  @brief  Copy constructor, trivial
    */
-  Vector2(const Vector2& other) {
-    x_ = other.x_;
-    y_ = other.y_;
-  }
+  Vector2(const Vector2& other) = default;
 
   /**
    *  @name operator=
-   *  @fn Vector2& operator=(const Vector2& rhs)
-   *  @brief  Assignment operator
+   *  @fn Vector2& operator=(const Vector2& rhs) = default
+   *  @brief  Assignment operator, trivial
    *  @param[in]  rhs Object to assign from
    *  @return Newly assigned object
    */
-  Vector2& operator=(const Vector2& rhs) {
-    if (this != &rhs) {
-      x_ = rhs.x_;
-      y_ = rhs.y_;
-    }
-    return *this;
-  }
+  Vector2& operator=(const Vector2& rhs) = default;
 
   /**
    *  @name Vector2
-   *  @fn ~Vector2(void)
+   *  @fn ~Vector2(void) = default
    *  @brief  Destructor
    */
-  ~Vector2(void) {}
+  ~Vector2(void) = default;
 
 #pragma mark -
 #pragma mark Usage
@@ -104,17 +96,28 @@ struct FK_EXPORTS Vector2 {
 
   /**
    *  @name Normalize
-   *  @fn void Normalize(void)
-   *  @brief  Normalize to unit length
+   *  @fn template<typename Math> void Normalize(void)
+   *  @brief  Normalize to unit length, null vector becomes NaN
+   *  @tparam Math  Math policy, `FastMathPolicy` uses an approximated
+   *                reciprocal square root
    */
+  template<typename Math = PreciseMathPolicy>
   void Normalize(void) {
-    const T length = this->Norm();
-    if (length != T(0.0)) {
-      x_ /= length;
-      y_ /= length;
+    if (Math::kExact) {
+      const T length = this->Norm();
+      if (length != T(0.0)) {
+        x_ /= length;
+        y_ /= length;
+      } else {
+        x_ = std::numeric_limits<T>::quiet_NaN();
+        y_ = std::numeric_limits<T>::quiet_NaN();
+      }
     } else {
-      x_ = std::numeric_limits<T>::quiet_NaN();
-      y_ = std::numeric_limits<T>::quiet_NaN();
+      // Rsqrt(0) gives NaN
+      const T sq = x_ * x_ + y_ * y_;
+      const T inv = Math::Rsqrt(sq);
+      x_ *= inv;
+      y_ *= inv;
     }
   }
 
@@ -123,12 +126,12 @@ struct FK_EXPORTS Vector2 {
 
   /**
    *  @name operator+=
-   *  @fn Vector2& operator+=(const Vector2& rhs)
+   *  @fn Vector2& operator+=(const Vector2& rhs) noexcept
    *  @brief  Addition operator
    *  @param[in]  rhs Vector to add
    *  @return Updated vector
    */
-  Vector2& operator+=(const Vector2& rhs) {
+  Vector2& operator+=(const Vector2& rhs) noexcept {
     x_ += rhs.x_;
     y_ += rhs.y_;
     return *this;
@@ -136,12 +139,12 @@ struct FK_EXPORTS Vector2 {
 
   /**
    *  @name operator+=
-   *  @fn Vector2& operator+=(const T value)
+   *  @fn Vector2& operator+=(const T value) noexcept
    *  @brief  Addition operator
    *  @param[in]  value Value to add
    *  @return Updated vector
    */
-  Vector2& operator+=(const T value) {
+  Vector2& operator+=(const T value) noexcept {
     x_ += value;
     y_ += value;
     return *this;
@@ -149,12 +152,12 @@ struct FK_EXPORTS Vector2 {
 
   /**
    *  @name operator-=
-   *  @fn Vector2& operator-=(const Vector2& rhs)
+   *  @fn Vector2& operator-=(const Vector2& rhs) noexcept
    *  @brief  Substraction operator
    *  @param[in]  rhs Vector substract
    *  @return Updated vector
    */
-  Vector2& operator-=(const Vector2& rhs) {
+  Vector2& operator-=(const Vector2& rhs) noexcept {
     x_ -= rhs.x_;
     y_ -= rhs.y_;
     return *this;
@@ -162,12 +165,12 @@ struct FK_EXPORTS Vector2 {
 
   /**
    *  @name operator-=
-   *  @fn Vector2& operator-=(const T value)
+   *  @fn Vector2& operator-=(const T value) noexcept
    *  @brief  Substraction operator
    *  @param[in]  value Value to substract
    *  @return Updated vector
    */
-  Vector2& operator-=(const T value) {
+  Vector2& operator-=(const T value) noexcept {
     x_ -= value;
     y_ -= value;
     return *this;
@@ -175,12 +178,12 @@ struct FK_EXPORTS Vector2 {
 
   /**
    *  @name operator*=
-   *  @fn Vector2& operator*=(const T value)
+   *  @fn Vector2& operator*=(const T value) noexcept
    *  @brief  Multiplaction operator
    *  @param[in]  value Value to multiply by
    *  @return Updated vector
    */
-  Vector2& operator*=(const T value) {
+  Vector2& operator*=(const T value) noexcept {
     x_ *= value;
     y_ *= value;
     return *this;
@@ -188,12 +191,12 @@ struct FK_EXPORTS Vector2 {
 
   /**
    *  @name operator/=
-   *  @fn Vector2& operator/=(const T value)
+   *  @fn Vector2& operator/=(const T value) noexcept
    *  @brief  Division operator
    *  @param[in]  value Value to divide by
    *  @return Updated vector
    */
-  Vector2& operator/=(const T value) {
+  Vector2& operator/=(const T value) noexcept {
     if (value != T(0)) {
       x_ /= value;
       y_ /= value;
@@ -328,54 +331,44 @@ struct FK_EXPORTS Vector3 {
 
   /**
    *  @name Vector3
-   *  @fn Vector3(void)
+   *  @fn constexpr Vector3(void) noexcept
    *  @brief  Constructor
    */
-  Vector3(void) : x_(0), y_(0), z_(0) {}
+  constexpr Vector3(void) noexcept : x_(0), y_(0), z_(0) {}
 
   /**
    *  @name Vector3
-   *  @fn Vector3(const T x, const T y, const T z)
+   *  @fn constexpr Vector3(const T x, const T y, const T z) noexcept
    *  @brief  Constructor
    *  @param[in]  x   X component
    *  @param[in]  y   Y component
    *  @param[in]  z   Z component
    */
-  Vector3(const T x, const T y, const T z) : x_(x), y_(y), z_(z) {}
+  constexpr Vector3(const T x, const T y, const T z) noexcept :
+          x_(x), y_(y), z_(z) {}
 
   /**
    *  @name Vector3
-   *  @fn Vector3(const Vector3& other)
-   *  @brief  Copy constructor
+   *  @fn Vector3(const Vector3& other) = default
+   *  @brief  Copy constructor, trivial
    */
-  Vector3(const Vector3& other) {
-    x_ = other.x_;
-    y_ = other.y_;
-    z_ = other.z_;
-  }
+  Vector3(const Vector3& other) = default;
 
   /**
    *  @name operator=
-   *  @fn Vector3& operator=(const Vector3& rhs)
-   *  @brief  Assignment operator
+   *  @fn Vector3& operator=(const Vector3& rhs) = default
+   *  @brief  Assignment operator, trivial
    *  @param[in]  rhs Object to assign from
    *  @return Newly assigned object
    */
-  Vector3& operator=(const Vector3& rhs) {
-    if (this != &rhs) {
-      x_ = rhs.x_;
-      y_ = rhs.y_;
-      z_ = rhs.z_;
-    }
-    return *this;
-  }
+  Vector3& operator=(const Vector3& rhs) = default;
 
   /**
    *  @name ~Vector3
-   *  @fn ~Vector3(void)
+   *  @fn ~Vector3(void) = default
    *  @brief  Destructor
    */
-  ~Vector3(void) {}
+  ~Vector3(void) = default;
 
 #pragma mark -
 #pragma mark Usage
@@ -392,19 +385,31 @@ struct FK_EXPORTS Vector3 {
 
   /**
    *  @name Normalize
-   *  @fn void Normalize(void)
-   *  @brief  Normalize to unit length
+   *  @fn template<typename Math> void Normalize(void)
+   *  @brief  Normalize to unit length, null vector becomes NaN
+   *  @tparam Math  Math policy, `FastMathPolicy` uses an approximated
+   *                reciprocal square root
    */
+  template<typename Math = PreciseMathPolicy>
   void Normalize(void) {
-    const T length = this->Norm();
-    if (length != T(0.0)) {
-      x_ /= length;
-      y_ /= length;
-      z_ /= length;
+    if (Math::kExact) {
+      const T length = this->Norm();
+      if (length != T(0.0)) {
+        x_ /= length;
+        y_ /= length;
+        z_ /= length;
+      } else {
+        x_ = std::numeric_limits<T>::quiet_NaN();
+        y_ = std::numeric_limits<T>::quiet_NaN();
+        z_ = std::numeric_limits<T>::quiet_NaN();
+      }
     } else {
-      x_ = std::numeric_limits<T>::quiet_NaN();
-      y_ = std::numeric_limits<T>::quiet_NaN();
-      z_ = std::numeric_limits<T>::quiet_NaN();
+      // Rsqrt(0) gives NaN
+      const T sq = x_ * x_ + y_ * y_ + z_ * z_;
+      const T inv = Math::Rsqrt(sq);
+      x_ *= inv;
+      y_ *= inv;
+      z_ *= inv;
     }
   }
 
@@ -413,12 +418,12 @@ struct FK_EXPORTS Vector3 {
 
   /**
    *  @name operator+=
-   *  @fn Vector3& operator+=(const Vector3& rhs)
+   *  @fn Vector3& operator+=(const Vector3& rhs) noexcept
    *  @brief  Addition operator
    *  @param[in]  rhs Vector to add
    *  @return Updated vector
    */
-  Vector3& operator+=(const Vector3& rhs) {
+  Vector3& operator+=(const Vector3& rhs) noexcept {
     x_ += rhs.x_;
     y_ += rhs.y_;
     z_ += rhs.z_;
@@ -427,12 +432,12 @@ struct FK_EXPORTS Vector3 {
 
   /**
    *  @name operator+=
-   *  @fn Vector3& operator+=(const T value)
+   *  @fn Vector3& operator+=(const T value) noexcept
    *  @brief  Addition operator
    *  @param[in]  value Value to add
    *  @return Updated vector
    */
-  Vector3& operator+=(const T value) {
+  Vector3& operator+=(const T value) noexcept {
     x_ += value;
     y_ += value;
     z_ += value;
@@ -441,12 +446,12 @@ struct FK_EXPORTS Vector3 {
 
   /**
    *  @name operator-=
-   *  @fn Vector3& operator-=(const Vector3& rhs)
+   *  @fn Vector3& operator-=(const Vector3& rhs) noexcept
    *  @brief  Substraction operator
    *  @param[in]  rhs Vector substract
    *  @return Updated vector
    */
-  Vector3& operator-=(const Vector3& rhs) {
+  Vector3& operator-=(const Vector3& rhs) noexcept {
     x_ -= rhs.x_;
     y_ -= rhs.y_;
     z_ -= rhs.z_;
@@ -455,12 +460,12 @@ struct FK_EXPORTS Vector3 {
 
   /**
    *  @name operator-=
-   *  @fn Vector3& operator-=(const T value)
+   *  @fn Vector3& operator-=(const T value) noexcept
    *  @brief  Substraction operator
    *  @param[in]  value Value to substract
    *  @return Updated vector
    */
-  Vector3& operator-=(const T value) {
+  Vector3& operator-=(const T value) noexcept {
     x_ -= value;
     y_ -= value;
     z_ -= value;
@@ -469,12 +474,12 @@ struct FK_EXPORTS Vector3 {
 
   /**
    *  @name operator*=
-   *  @fn Vector3& operator*=(const T value)
+   *  @fn Vector3& operator*=(const T value) noexcept
    *  @brief  Multiplaction operator
    *  @param[in]  value Value to multiply by
    *  @return Updated vector
    */
-  Vector3& operator*=(const T value) {
+  Vector3& operator*=(const T value) noexcept {
     x_ *= value;
     y_ *= value;
     z_ *= value;
@@ -483,12 +488,12 @@ struct FK_EXPORTS Vector3 {
 
   /**
    *  @name operator/=
-   *  @fn Vector3& operator/=(const T value)
+   *  @fn Vector3& operator/=(const T value) noexcept
    *  @brief  Division operator
    *  @param[in]  value Value to divide by
    *  @return Updated vector
    */
-  Vector3& operator/=(const T value) {
+  Vector3& operator/=(const T value) noexcept {
     if (value != T(0)) {
       x_ /= value;
       y_ /= value;
@@ -501,6 +506,37 @@ struct FK_EXPORTS Vector3 {
     return *this;
   }
 
+  /**
+   *  @name AddScaled
+   *  @fn Vector3& AddScaled(const Vector3& v, const T s) noexcept
+   *  @brief  In-place `this += v * s`, without temporary
+   *  @param[in]  v   Vector to add
+   *  @param[in]  s   Scale applied to `v`
+   *  @return Updated vector
+   */
+  Vector3& AddScaled(const Vector3& v, const T s) noexcept {
+    x_ += v.x_ * s;
+    y_ += v.y_ * s;
+    z_ += v.z_ * s;
+    return *this;
+  }
+
+  /**
+   *  @name Fma
+   *  @fn Vector3& Fma(const Vector3& a, const T s, const Vector3& b) noexcept
+   *  @brief  In-place `this = a * s + b`, without temporary
+   *  @param[in]  a   Vector to scale
+   *  @param[in]  s   Scale applied to `a`
+   *  @param[in]  b   Vector to add
+   *  @return Updated vector
+   */
+  Vector3& Fma(const Vector3& a, const T s, const Vector3& b) noexcept {
+    x_ = a.x_ * s + b.x_;
+    y_ = a.y_ * s + b.y_;
+    z_ = a.z_ * s + b.z_;
+    return *this;
+  }
+
   /**
    *  @name operator==
    *  @fn bool operator==(const Vector3& rhs)
@@ -627,60 +663,46 @@ struct FK_EXPORTS Vector4 {
 
   /**
    *  @name Vector4
-   *  @fn Vector4(void)
+   *  @fn constexpr Vector4(void) noexcept
    *  @brief  Constructor
    */
-  Vector4(void) : x_(0), y_(0), z_(0), w_(0) {}
+  constexpr Vector4(void) noexcept : x_(0), y_(0), z_(0), w_(0) {}
 
   /**
    *  @name Vector4
-   *  @fn Vector4(const T x, const T y, const T z, const T w)
+   *  @fn constexpr Vector4(const T x, const T y, const T z,
+                             const T w) noexcept
    *  @brief  Constructor
    *  @param[in]  x   X component
    *  @param[in]  y   Y component
    *  @param[in]  z   Z component
    *  @param[in]  w   W component
    */
-  Vector4(const T x, const T y, const T z, const T w) : x_(x),
-  y_(y),
-  z_(z),
-  w_(w) {}
+  constexpr Vector4(const T x, const T y, const T z, const T w) noexcept :
+          x_(x), y_(y), z_(z), w_(w) {}
 
   /**
    *  @name Vector4
-   *  @fn Vector4(const Vector4& other)
-   *  @brief  Copy constructor
+   *  @fn Vector4(const Vector4& other) = default
+   *  @brief  Copy constructor, trivial
    */
-  Vector4(const Vector4& other) {
-    x_ = other.x_;
-    y_ = other.y_;
-    z_ = other.z_;
-    w_ = other.w_;
-  }
+  Vector4(const Vector4& other) = default;
 
   /**
    *  @name operator=
-   *  @fn Vector4& operator=(const Vector4& rhs)
-   *  @brief  Assignment operator
+   *  @fn Vector4& operator=(const Vector4& rhs) = default
+   *  @brief  Assignment operator, trivial
    *  @param[in]  rhs Object to assign from
    *  @return Newly assigned object
    */
-  Vector4& operator=(const Vector4& rhs) {
-    if (this != &rhs) {
-      x_ = rhs.x_;
-      y_ = rhs.y_;
-      z_ = rhs.z_;
-      w_ = rhs.w_;
-    }
-    return *this;
-  }
+  Vector4& operator=(const Vector4& rhs) = default;
 
   /**
    *  @name ~Vector4
-   *  @fn ~Vector4(void)
+   *  @fn ~Vector4(void) = default
    *  @brief  Destructor
    */
-  ~Vector4(void) {}
+  ~Vector4(void) = default;
 
 #pragma mark -
 #pragma mark Usage
@@ -697,21 +719,34 @@ struct FK_EXPORTS Vector4 {
 
   /**
    *  @name Normalize
-   *  @fn void Normalize(void)
-   *  @brief  Normalize to unit length
+   *  @fn template<typename Math> void Normalize(void)
+   *  @brief  Normalize to unit length, null vector becomes NaN
+   *  @tparam Math  Math policy, `FastMathPolicy` uses an approximated
+   *                reciprocal square root
    */
+  template<typename Math = PreciseMathPolicy>
   void Normalize(void) {
-    const T length = this->Norm();
-    if (length != T(0.0)) {
-      x_ /= length;
-      y_ /= length;
-      z_ /= length;
-      w_ /= length;
+    if (Math::kExact) {
+      const T length = this->Norm();
+      if (length != T(0.0)) {
+        x_ /= length;
+        y_ /= length;
+        z_ /= length;
+        w_ /= length;
+      } else {
+        x_ = std::numeric_limits<T>::quiet_NaN();
+        y_ = std::numeric_limits<T>::quiet_NaN();
+        z_ = std::numeric_limits<T>::quiet_NaN();
+        w_ = std::numeric_limits<T>::quiet_NaN();
+      }
     } else {
-      x_ = std::numeric_limits<T>::quiet_NaN();
-      y_ = std::numeric_limits<T>::quiet_NaN();
-      z_ = std::numeric_limits<T>::quiet_NaN();
-      w_ = std::numeric_limits<T>::quiet_NaN();
+      // Rsqrt(0) gives NaN
+      const T sq = x_ * x_ + y_ * y_ + z_ * z_ + w_ * w_;
+      const T inv = Math::Rsqrt(sq);
+      x_ *= inv;
+      y_ *= inv;
+      z_ *= inv;
+      w_ *= inv;
     }
   }
 
@@ -720,12 +755,12 @@ struct FK_EXPORTS Vector4 {
 
   /**
    *  @name operator+=
-   *  @fn Vector4& operator+=(const Vector4& rhs)
+   *  @fn Vector4& operator+=(const Vector4& rhs) noexcept
    *  @brief  Addition operator
    *  @param[in]  rhs Vector to add
    *  @return Updated vector
    */
-  Vector4& operator+=(const Vector4& rhs) {
+  Vector4& operator+=(const Vector4& rhs) noexcept {
     x_ += rhs.x_;
     y_ += rhs.y_;
     z_ += rhs.z_;
@@ -735,12 +770,12 @@ struct FK_EXPORTS Vector4 {
 
   /**
    *  @name operator+=
-   *  @fn Vector4& operator+=(const T value)
+   *  @fn Vector4& operator+=(const T value) noexcept
    *  @brief  Addition operator
    *  @param[in]  value Value to add
    *  @return Updated vector
    */
-  Vector4& operator+=(const T value) {
+  Vector4& operator+=(const T value) noexcept {
     x_ += value;
     y_ += value;
     z_ += value;
@@ -750,12 +785,12 @@ struct FK_EXPORTS Vector4 {
 
   /**
    *  @name operator-=
-   *  @fn Vector4& operator-=(const Vector4& rhs)
+   *  @fn Vector4& operator-=(const Vector4& rhs) noexcept
    *  @brief  Substraction operator
    *  @param[in]  rhs Vector substract
    *  @return Updated vector
    */
-  Vector4& operator-=(const Vector4& rhs) {
+  Vector4& operator-=(const Vector4& rhs) noexcept {
     x_ -= rhs.x_;
     y_ -= rhs.y_;
     z_ -= rhs.z_;
@@ -765,12 +800,12 @@ struct FK_EXPORTS Vector4 {
 
   /**
    *  @name operator-=
-   *  @fn Vector4& operator-=(const T value)
+   *  @fn Vector4& operator-=(const T value) noexcept
    *  @brief  Substraction operator
    *  @param[in]  value Value to substract
    *  @return Updated vector
    */
-  Vector4& operator-=(const T value) {
+  Vector4& operator-=(const T value) noexcept {
     x_ -= value;
     y_ -= value;
     z_ -= value;
@@ -780,12 +815,12 @@ struct FK_EXPORTS Vector4 {
 
   /**
    *  @name operator*=
-   *  @fn Vector4& operator*=(const T value)
+   *  @fn Vector4& operator*=(const T value) noexcept
    *  @brief  Multiplaction operator
    *  @param[in]  value Value to multiply by
    *  @return Updated vector
    */
-  Vector4& operator*=(const T value) {
+  Vector4& operator*=(const T value) noexcept {
     x_ *= value;
     y_ *= value;
     z_ *= value;
@@ -795,12 +830,12 @@ struct FK_EXPORTS Vector4 {
 
   /**
    *  @name operator/=
-   *  @fn Vector4& operator/=(const T value)
+   *  @fn Vector4& operator/=(const T value) noexcept
    *  @brief  Division operator
    *  @param[in]  value Value to divide by
    *  @return Updated vector
    */
-  Vector4& operator/=(const T value) {
+  Vector4& operator/=(const T value) noexcept {
     if (value != T(0)) {
       x_ /= value;
       y_ /= value;
@@ -930,39 +965,46 @@ struct FK_EXPORTS Vector4 {
 
 /** Addition */
 template<typename T>
-FK_EXPORTS Vector2<T> operator+(const Vector2<T>& lhs, const Vector2<T>& rhs) {
+constexpr FK_EXPORTS Vector2<T> operator+(const Vector2<T>& lhs,
+                                          const Vector2<T>& rhs) noexcept {
   return Vector2<T>(lhs.x_ + rhs.x_, lhs.y_ + rhs.y_);
 }
 template<typename T>
-FK_EXPORTS Vector2<T> operator+(const Vector2<T>& lhs, const T v) {
+constexpr FK_EXPORTS Vector2<T> operator+(const Vector2<T>& lhs,
+                                          const T v) noexcept {
   return Vector2<T>(lhs.x_ + v, lhs.y_ + v);
 }
 
 /** Substraction */
 template<typename T>
-FK_EXPORTS Vector2<T> operator-(const Vector2<T>& lhs, const Vector2<T>& rhs) {
+constexpr FK_EXPORTS Vector2<T> operator-(const Vector2<T>& lhs,
+                                          const Vector2<T>& rhs) noexcept {
   return Vector2<T>(lhs.x_ - rhs.x_, lhs.y_ - rhs.y_);
 }
 template<typename T>
-FK_EXPORTS Vector2<T> operator-(const Vector2<T>& lhs, const T v) {
+constexpr FK_EXPORTS Vector2<T> operator-(const Vector2<T>& lhs,
+                                          const T v) noexcept {
   return Vector2<T>(lhs.x_ - v, lhs.y_ - v);
 }
 
 /** Scalar product */
 template<typename T>
-FK_EXPORTS Vector2<T> operator*(const Vector2<T>& lhs, const T scalar) {
+constexpr FK_EXPORTS Vector2<T> operator*(const Vector2<T>& lhs,
+                                          const T scalar) noexcept {
   return Vector2<T>(lhs.x_ * scalar, lhs.y_ * scalar);
 }
 
 /** Division product */
 template<typename T>
-FK_EXPORTS Vector2<T> operator/(const Vector2<T>& lhs, const T scalar) {
+constexpr FK_EXPORTS Vector2<T> operator/(const Vector2<T>& lhs,
+                                          const T scalar) noexcept {
   return Vector2<T>(lhs.x_ / scalar, lhs.y_ / scalar);
 }
 
 /** Dot product */
 template<typename T>
-FK_EXPORTS T operator*(const Vector2<T>& lhs, const Vector2<T>& rhs) {
+constexpr FK_EXPORTS T operator*(const Vector2<T>& lhs,
+                                 const Vector2<T>& rhs) noexcept {
   return (lhs.x_ * rhs.x_) + (lhs.y_ * rhs.y_);
 }
 
@@ -971,82 +1013,103 @@ FK_EXPORTS T operator*(const Vector2<T>& lhs, const Vector2<T>& rhs) {
 
 /** Addition */
 template<typename T>
-FK_EXPORTS Vector3<T> operator+(const Vector3<T>& lhs, const Vector3<T>& rhs) {
+constexpr FK_EXPORTS Vector3<T> operator+(const Vector3<T>& lhs,
+                                          const Vector3<T>& rhs) noexcept {
   return Vector3<T>(lhs.x_ + rhs.x_, lhs.y_ + rhs.y_, lhs.z_ + rhs.z_);
 }
 template<typename T>
-FK_EXPORTS Vector3<T> operator+(const Vector3<T>& lhs, const T v) {
+constexpr FK_EXPORTS Vector3<T> operator+(const Vector3<T>& lhs,
+                                          const T v) noexcept {
   return Vector3<T>(lhs.x_ + v, lhs.y_ + v, lhs.z_ + v);
 }
 
 /** Substraction */
 template<typename T>
-FK_EXPORTS Vector3<T> operator-(const Vector3<T>& lhs, const Vector3<T>& rhs) {
+constexpr FK_EXPORTS Vector3<T> operator-(const Vector3<T>& lhs,
+                                          const Vector3<T>& rhs) noexcept {
   return Vector3<T>(lhs.x_ - rhs.x_, lhs.y_ - rhs.y_, lhs.z_ - rhs.z_);
 }
 template<typename T>
-FK_EXPORTS Vector3<T> operator-(const Vector3<T>& lhs, const T v) {
+constexpr FK_EXPORTS Vector3<T> operator-(const Vector3<T>& lhs,
+                                          const T v) noexcept {
   return Vector3<T>(lhs.x_ - v, lhs.y_ - v, lhs.z_ - v);
 }
 
 /** Scalar product */
 template<typename T>
-FK_EXPORTS Vector3<T> operator*(const Vector3<T>& lhs, const T scalar) {
+constexpr FK_EXPORTS Vector3<T> operator*(const Vector3<T>& lhs,
+                                          const T scalar) noexcept {
   return Vector3<T>(lhs.x_ * scalar, lhs.y_ * scalar, lhs.z_ * scalar);
 }
 
 /** Division product */
 template<typename T>
-FK_EXPORTS Vector3<T> operator/(const Vector3<T>& lhs, const T scalar) {
+constexpr FK_EXPORTS Vector3<T> operator/(const Vector3<T>& lhs,
+                                          const T scalar) noexcept {
   return Vector3<T>(lhs.x_ / scalar, lhs.y_ / scalar, lhs.z_ / scalar);
 }
 
 /** Dot product */
 template<typename T>
-FK_EXPORTS T operator*(const Vector3<T>& lhs, const Vector3<T>& rhs) {
+constexpr FK_EXPORTS T operator*(const Vector3<T>& lhs,
+                                 const Vector3<T>& rhs) noexcept {
   return (lhs.x_ * rhs.x_) + (lhs.y_ * rhs.y_) + (lhs.z_ * rhs.z_);
 }
 
 /** Cross product */
 template<typename T>
-FK_EXPORTS Vector3<T> operator^(const Vector3<T>& lhs, const Vector3<T>& rhs) {
+constexpr FK_EXPORTS Vector3<T> operator^(const Vector3<T>& lhs,
+                                          const Vector3<T>& rhs) noexcept {
   return Vector3<T>(lhs.y_ * rhs.z_ - rhs.y_ * lhs.z_,
                     lhs.z_ * rhs.x_ - rhs.z_ * lhs.x_,
                     lhs.x_ * rhs.y_ - rhs.x_ * lhs.y_);
 }
 
+/** Scale and add, a * s + b */
+template<typename T>
+constexpr FK_EXPORTS Vector3<T> Fma(const Vector3<T>& a,
+                                    const T s,
+                                    const Vector3<T>& b) noexcept {
+  return Vector3<T>(a.x_ * s + b.x_, a.y_ * s + b.y_, a.z_ * s + b.z_);
+}
+
 #pragma mark -
-#pragma mark Vector3 operator
+#pragma mark Vector4 operator
 
 /** Addition */
 template<typename T>
-FK_EXPORTS Vector4<T> operator+(const Vector4<T>& lhs, const Vector4<T>& rhs) {
+constexpr FK_EXPORTS Vector4<T> operator+(const Vector4<T>& lhs,
+                                          const Vector4<T>& rhs) noexcept {
   return Vector4<T>(lhs.x_ + rhs.x_,
                     lhs.y_ + rhs.y_,
                     lhs.z_ + rhs.z_,
                     lhs.w_ + rhs.w_);
 }
 template<typename T>
-FK_EXPORTS Vector4<T> operator+(const Vector4<T>& lhs, const T v) {
+constexpr FK_EXPORTS Vector4<T> operator+(const Vector4<T>& lhs,
+                                          const T v) noexcept {
   return Vector4<T>(lhs.x_ + v, lhs.y_ + v, lhs.z_ + v, lhs.w_ + v);
 }
 
 /** Substraction */
 template<typename T>
-FK_EXPORTS Vector4<T> operator-(const Vector4<T>& lhs, const Vector4<T>& rhs) {
+constexpr FK_EXPORTS Vector4<T> operator-(const Vector4<T>& lhs,
+                                          const Vector4<T>& rhs) noexcept {
   return Vector4<T>(lhs.x_ - rhs.x_,
                     lhs.y_ - rhs.y_,
                     lhs.z_ - rhs.z_,
                     lhs.w_ - rhs.w_);
 }
 template<typename T>
-FK_EXPORTS Vector4<T> operator-(const Vector4<T>& lhs, const T v) {
+constexpr FK_EXPORTS Vector4<T> operator-(const Vector4<T>& lhs,
+                                          const T v) noexcept {
   return Vector4<T>(lhs.x_ - v, lhs.y_ - v, lhs.z_ - v, lhs.w_ - v);
 }
 
 /** Scalar product */
 template<typename T>
-FK_EXPORTS Vector4<T> operator*(const Vector4<T>& lhs, const T scalar) {
+constexpr FK_EXPORTS Vector4<T> operator*(const Vector4<T>& lhs,
+                                          const T scalar) noexcept {
   return Vector4<T>(lhs.x_ * scalar,
                     lhs.y_ * scalar,
                     lhs.z_ * scalar,
@@ -1055,7 +1118,8 @@ FK_EXPORTS Vector4<T> operator*(const Vector4<T>& lhs, const T scalar) {
 
 /** Division product */
 template<typename T>
-FK_EXPORTS Vector4<T> operator/(const Vector4<T>& lhs, const T scalar) {
+constexpr FK_EXPORTS Vector4<T> operator/(const Vector4<T>& lhs,
+                                          const T scalar) noexcept {
   return Vector4<T>(lhs.x_ / scalar,
                     lhs.y_ / scalar,
                     lhs.z_ / scalar,
@@ -1064,7 +1128,8 @@ FK_EXPORTS Vector4<T> operator/(const Vector4<T>& lhs, const T scalar) {
 
 /** Dot product */
 template<typename T>
-FK_EXPORTS T operator*(const Vector4<T>& lhs, const Vector4<T>& rhs) {
+constexpr FK_EXPORTS T operator*(const Vector4<T>& lhs,
+                                 const Vector4<T>& rhs) noexcept {
   return ((lhs.x_ * rhs.x_) +
           (lhs.y_ * rhs.y_) +
           (lhs.z_ * rhs.z_) +
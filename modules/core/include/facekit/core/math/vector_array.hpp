@@ -0,0 +1,348 @@
+/**
+ *  @file   vector_array.hpp
+ *  @brief  Batch of 3D vectors stored as structure of arrays
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   24.08.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_VECTOR_ARRAY__
+#define __FACEKIT_VECTOR_ARRAY__
+
+#include <cstddef>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/core/math/vector.hpp"
+#include "facekit/core/math/matrix.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  Vector3Array
+ *  @brief  Collection of `Vector3` stored as three separated, aligned
+ *          streams (x, y, z). Batch operations run on the SIMD kernels
+ *          selected by `NDArrayOps` for the current CPU.
+ *  @author Christophe Ecabert
+ *  @date   24.08.18
+ *  @ingroup core
+ *  @tparam T Data type, float or double
+ */
+template<typename T>
+class FK_EXPORTS Vector3Array {
+ public:
+
+  /** Alignment of each stream, in bytes */
+  static constexpr size_t kAlignment = 64;
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   Vector3Array
+   *  @fn     Vector3Array(void)
+   *  @brief  Constructor
+   */
+  Vector3Array(void);
+
+  /**
+   *  @name   Vector3Array
+   *  @fn     explicit Vector3Array(const size_t& n)
+   *  @brief  Constructor, create `n` null vectors
+   *  @param[in] n  Number of vectors
+   */
+  explicit Vector3Array(const size_t& n);
+
+  /**
+   *  @name   Vector3Array
+   *  @fn     explicit Vector3Array(const std::vector<Vector3<T>>& vectors)
+   *  @brief  Constructor, convert from array of structures
+   *  @param[in] vectors  Vectors to copy
+   */
+  explicit Vector3Array(const std::vector<Vector3<T>>& vectors);
+
+  /**
+   *  @name   Vector3Array
+   *  @fn     Vector3Array(const Vector3Array& other)
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  Vector3Array(const Vector3Array& other);
+
+  /**
+   *  @name   Vector3Array
+   *  @fn     Vector3Array(Vector3Array&& other)
+   *  @brief  Move constructor
+   *  @param[in] other  Object to move from
+   */
+  Vector3Array(Vector3Array&& other);
+
+  /**
+   *  @name   operator=
+   *  @fn     Vector3Array& operator=(const Vector3Array& rhs)
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  Vector3Array& operator=(const Vector3Array& rhs);
+
+  /**
+   *  @name   operator=
+   *  @fn     Vector3Array& operator=(Vector3Array&& rhs)
+   *  @brief  Move-assignment operator
+   *  @param[in] rhs  Object to move-assign from
+   *  @return Newly moved-assign object
+   */
+  Vector3Array& operator=(Vector3Array&& rhs);
+
+  /**
+   *  @name   ~Vector3Array
+   *  @fn     ~Vector3Array(void)
+   *  @brief  Destructor
+   */
+  ~Vector3Array(void);
+
+  /**
+   *  @name   Resize
+   *  @fn     void Resize(const size_t& n)
+   *  @brief  Change the number of vectors, existing ones are kept and new
+   *          ones are null.
+   *  @param[in] n  Number of vectors
+   */
+  void Resize(const size_t& n);
+
+#pragma mark -
+#pragma mark Conversion
+
+  /**
+   *  @name   FromAoS
+   *  @fn     void FromAoS(const Vector3<T>* vectors, const size_t& n)
+   *  @brief  Initialize from an array of structures
+   *  @param[in] vectors  Vectors to copy
+   *  @param[in] n        Number of vectors
+   */
+  void FromAoS(const Vector3<T>* vectors, const size_t& n);
+
+  /**
+   *  @name   FromAoS
+   *  @fn     void FromAoS(const std::vector<Vector3<T>>& vectors)
+   *  @brief  Initialize from an array of structures
+   *  @param[in] vectors  Vectors to copy
+   */
+  void FromAoS(const std::vector<Vector3<T>>& vectors) {
+    this->FromAoS(vectors.data(), vectors.size());
+  }
+
+  /**
+   *  @name   ToAoS
+   *  @fn     void ToAoS(Vector3<T>* vectors) const
+   *  @brief  Export to an array of structures
+   *  @param[out] vectors Buffer of `size()` vectors
+   */
+  void ToAoS(Vector3<T>* vectors) const;
+
+  /**
+   *  @name   ToAoS
+   *  @fn     void ToAoS(std::vector<Vector3<T>>* vectors) const
+   *  @brief  Export to an array of structures
+   *  @param[out] vectors Vectors, resized if needed
+   */
+  void ToAoS(std::vector<Vector3<T>>* vectors) const {
+    vectors->resize(size_);
+    this->ToAoS(vectors->data());
+  }
+
+#pragma mark -
+#pragma mark Batch operations
+
+  /**
+   *  @name   Add
+   *  @fn     Status Add(const Vector3Array& rhs)
+   *  @brief  Element-wise addition, this = this + rhs
+   *  @param[in] rhs  Vectors to add
+   *  @return kInvalidArgument if sizes do not match
+   */
+  Status Add(const Vector3Array& rhs);
+
+  /**
+   *  @name   Scale
+   *  @fn     void Scale(const T& s)
+   *  @brief  Multiply every vector by a scalar
+   *  @param[in] s  Scaling factor
+   */
+  void Scale(const T& s);
+
+  /**
+   *  @name   Dot
+   *  @fn     Status Dot(const Vector3Array& rhs, std::vector<T>* out) const
+   *  @brief  Element-wise dot product
+   *  @param[in] rhs  Second operand
+   *  @param[out] out Dot products, resized if needed
+   *  @return kInvalidArgument if sizes do not match
+   */
+  Status Dot(const Vector3Array& rhs, std::vector<T>* out) const;
+
+  /**
+   *  @name   Cross
+   *  @fn     Status Cross(const Vector3Array& rhs, Vector3Array* out) const
+   *  @brief  Element-wise cross product, out = this ^ rhs
+   *  @param[in] rhs  Second operand
+   *  @param[out] out Cross products, can be `this` or `rhs`
+   *  @return kInvalidArgument if sizes do not match
+   */
+  Status Cross(const Vector3Array& rhs, Vector3Array* out) const;
+
+  /**
+   *  @name   Normalize
+   *  @fn     void Normalize(void)
+   *  @brief  Normalize every vector to unit length, null vectors become NaN
+   *          as with `Vector3::Normalize`.
+   */
+  void Normalize(void);
+
+  /**
+   *  @name   Transform
+   *  @fn     void Transform(const Matrix3<T>& m, Vector3Array* out) const
+   *  @brief  Apply a linear transformation, out[i] = m * this[i]
+   *  @param[in] m    Transformation
+   *  @param[out] out Transformed vectors, can be `this`
+   */
+  void Transform(const Matrix3<T>& m, Vector3Array* out) const;
+
+  /**
+   *  @name   Transform
+   *  @fn     void Transform(const Matrix4<T>& m, Vector3Array* out) const
+   *  @brief  Apply an affine transformation to points, out[i] = R * this[i]
+   *          + t. The last row of `m` is ignored (i.e. no perspective
+   *          division).
+   *  @param[in] m    Transformation
+   *  @param[out] out Transformed points, can be `this`
+   */
+  void Transform(const Matrix4<T>& m, Vector3Array* out) const;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   Get
+   *  @fn     Vector3<T> Get(const size_t& i) const
+   *  @brief  Gather the i-th vector
+   *  @param[in] i  Index
+   *  @return Vector
+   */
+  Vector3<T> Get(const size_t& i) const {
+    return Vector3<T>(data_[i], data_[stride_ + i], data_[2 * stride_ + i]);
+  }
+
+  /**
+   *  @name   Set
+   *  @fn     void Set(const size_t& i, const Vector3<T>& v)
+   *  @brief  Scatter the i-th vector
+   *  @param[in] i  Index
+   *  @param[in] v  Vector
+   */
+  void Set(const size_t& i, const Vector3<T>& v) {
+    data_[i] = v.x_;
+    data_[stride_ + i] = v.y_;
+    data_[2 * stride_ + i] = v.z_;
+  }
+
+  /**
+   *  @name   size
+   *  @fn     size_t size(void) const
+   *  @brief  Number of vectors
+   *  @return Number of vectors
+   */
+  size_t size(void) const {
+    return size_;
+  }
+
+  /**
+   *  @name   x
+   *  @fn     T* x(void)
+   *  @brief  X stream
+   *  @return Pointer to the first x component
+   */
+  T* x(void) {
+    return data_;
+  }
+
+  /**
+   *  @name   x
+   *  @fn     const T* x(void) const
+   *  @brief  X stream
+   *  @return Pointer to the first x component
+   */
+  const T* x(void) const {
+    return data_;
+  }
+
+  /**
+   *  @name   y
+   *  @fn     T* y(void)
+   *  @brief  Y stream
+   *  @return Pointer to the first y component
+   */
+  T* y(void) {
+    return data_ + stride_;
+  }
+
+  /**
+   *  @name   y
+   *  @fn     const T* y(void) const
+   *  @brief  Y stream
+   *  @return Pointer to the first y component
+   */
+  const T* y(void) const {
+    return data_ + stride_;
+  }
+
+  /**
+   *  @name   z
+   *  @fn     T* z(void)
+   *  @brief  Z stream
+   *  @return Pointer to the first z component
+   */
+  T* z(void) {
+    return data_ + 2 * stride_;
+  }
+
+  /**
+   *  @name   z
+   *  @fn     const T* z(void) const
+   *  @brief  Z stream
+   *  @return Pointer to the first z component
+   */
+  const T* z(void) const {
+    return data_ + 2 * stride_;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+
+  /**
+   *  @name   Allocate
+   *  @fn     void Allocate(const size_t& n)
+   *  @brief  Allocate room for `n` vectors, previous content is lost
+   *  @param[in] n  Number of vectors
+   */
+  void Allocate(const size_t& n);
+
+  /** Streams, x / y / z one after the other */
+  T* data_;
+  /** Number of vectors */
+  size_t size_;
+  /** Distance between two streams, multiple of the alignment */
+  size_t stride_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_VECTOR_ARRAY__ */
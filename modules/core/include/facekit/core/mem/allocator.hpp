@@ -12,8 +12,15 @@
 #define __FACEKIT_ALLOCATOR__
 
 #include <cstdlib>
+#include <cstdint>
 #include <string>
 #include <limits>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "facekit/core/library_export.hpp"
 #include "facekit/core/types.hpp"
@@ -56,6 +63,24 @@ class FK_EXPORTS AllocatorStatistic {
    */
   std::string ToString(void) const;
   
+  /** Maximum number of allocation tags, tag 0 stands for untagged */
+  static constexpr size_t kMaxTag = 32;
+
+  /**
+   *  @struct  TagStatistic
+   *  @brief  Statistics of allocations done under a given tag
+   */
+  struct TagStatistic {
+    /** Tag's name */
+    std::string name;
+    /** Number of allocation performed under this tag */
+    size_t n_alloc;
+    /** Number of byte currently being used under this tag */
+    size_t used_bytes;
+    /** Largest memory usage for this tag */
+    size_t max_used_bytes;
+  };
+
   /** Number of allocation performed by this allocator */
   size_t n_alloc;
   /** Total number of byte currently being used by this allocator */
@@ -64,6 +89,199 @@ class FK_EXPORTS AllocatorStatistic {
   size_t max_used_bytes;
   /** Largest memory block allocated by this allocator */
   size_t max_alloc_size;
+  /** Per tag statistics, only tags with at least one allocation */
+  std::vector<TagStatistic> tags;
+};
+
+/**
+ *  @class  AllocatorStatisticCollector
+ *  @brief  Collect allocation statistics without global lock. Allocation
+ *          counts and largest block are kept in per-thread slots merged on
+ *          read, memory usage and its peak are tracked per tag with atomics.
+ *  @author Christophe Ecabert
+ *  @date   14.02.18
+ *  @ingroup core
+ *  @details The tag of a tagged allocation is remembered until it is
+ *           released so that it is accounted correctly even if released by
+ *           another thread or under another tag.
+ */
+class FK_EXPORTS AllocatorStatisticCollector {
+ public:
+
+  /**
+   *  @name   AllocatorStatisticCollector
+   *  @fn     AllocatorStatisticCollector(void)
+   *  @brief  Constructor
+   */
+  AllocatorStatisticCollector(void);
+
+  /**
+   *  @name   AllocatorStatisticCollector
+   *  @fn     AllocatorStatisticCollector(const AllocatorStatisticCollector&
+                                                                other) = delete
+   *  @brief  Copy constructor
+   *  @param[in]  other Object to copy from
+   */
+  AllocatorStatisticCollector(const AllocatorStatisticCollector& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     AllocatorStatisticCollector& operator=(
+                             const AllocatorStatisticCollector& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  AllocatorStatisticCollector&
+  operator=(const AllocatorStatisticCollector& rhs) = delete;
+
+  /**
+   *  @name   ~AllocatorStatisticCollector
+   *  @fn     ~AllocatorStatisticCollector(void)
+   *  @brief  Destructor
+   */
+  ~AllocatorStatisticCollector(void);
+
+  /**
+   *  @name   Allocate
+   *  @fn     void Allocate(const size_t& size, void* ptr)
+   *  @brief  Record an allocation under the calling thread's current tag
+   *  @param[in] size Size of the memory block in bytes
+   *  @param[in] ptr  Memory block
+   */
+  void Allocate(const size_t& size, void* ptr);
+
+  /**
+   *  @name   Deallocate
+   *  @fn     void Deallocate(const size_t& size, void* ptr)
+   *  @brief  Record a deallocation
+   *  @param[in] size Size of the memory block in bytes
+   *  @param[in] ptr  Memory block
+   */
+  void Deallocate(const size_t& size, void* ptr);
+
+  /**
+   *  @name   Gather
+   *  @fn     void Gather(AllocatorStatistic* stats) const
+   *  @brief  Merge collected statistics
+   *  @param[out] stats   Merged statistics
+   */
+  void Gather(AllocatorStatistic* stats) const;
+
+  /**
+   *  @name   Clear
+   *  @fn     void Clear(void)
+   *  @brief  Reset statistics
+   */
+  void Clear(void);
+
+ private:
+  /** Per thread counters */
+  struct Slot;
+  /** Tag of live tagged allocations */
+  struct TagMap;
+
+  /**
+   *  @name   GetSlot
+   *  @fn     Slot* GetSlot(void)
+   *  @brief  Counters of the calling thread
+   *  @return Slot
+   */
+  Slot* GetSlot(void);
+
+  /** Unique identifier, never reused */
+  uint64_t id_;
+  /** Synchronization */
+  mutable std::mutex lock_;
+  /** Thread's slots */
+  std::unordered_map<std::thread::id, Slot*> slots_;
+  /** Memory usage per tag */
+  std::atomic<int64_t> used_[AllocatorStatistic::kMaxTag];
+  /** Peak usage per tag */
+  std::atomic<int64_t> peak_[AllocatorStatistic::kMaxTag];
+  /** Total memory usage */
+  std::atomic<int64_t> used_total_;
+  /** Total peak usage */
+  std::atomic<int64_t> peak_total_;
+  /** Number of live tagged allocations */
+  std::atomic<size_t> n_tagged_;
+  /** Tag of live tagged allocations */
+  std::unique_ptr<TagMap> tag_map_;
+};
+
+/**
+ *  @name   RegisterAllocationTag
+ *  @fn     int RegisterAllocationTag(const std::string& name)
+ *  @brief  Get identifier of a given allocation tag, registering it if needed
+ *  @param[in] name Tag's name (i.e. "mesh", "image", ...)
+ *  @return Tag identifier, 0 (untagged) if too many tags are registered
+ */
+int RegisterAllocationTag(const std::string& name);
+
+/**
+ *  @name   AllocationTagName
+ *  @fn     std::string AllocationTagName(const int& tag)
+ *  @brief  Name of a given allocation tag
+ *  @param[in] tag  Tag identifier
+ *  @return Tag's name
+ */
+std::string AllocationTagName(const int& tag);
+
+/**
+ *  @class  ScopedAllocationTag
+ *  @brief  Tag allocations done by the calling thread while in scope. Scopes
+ *          can be nested.
+ *  @author Christophe Ecabert
+ *  @date   14.02.18
+ *  @ingroup core
+ */
+class FK_EXPORTS ScopedAllocationTag {
+ public:
+
+  /**
+   *  @name   ScopedAllocationTag
+   *  @fn     explicit ScopedAllocationTag(const std::string& name)
+   *  @brief  Constructor
+   *  @param[in] name Tag's name
+   */
+  explicit ScopedAllocationTag(const std::string& name);
+
+  /**
+   *  @name   ScopedAllocationTag
+   *  @fn     explicit ScopedAllocationTag(const int& tag)
+   *  @brief  Constructor
+   *  @param[in] tag  Tag identifier from `RegisterAllocationTag`
+   */
+  explicit ScopedAllocationTag(const int& tag);
+
+  /**
+   *  @name   ScopedAllocationTag
+   *  @fn     ScopedAllocationTag(const ScopedAllocationTag& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in]  other Object to copy from
+   */
+  ScopedAllocationTag(const ScopedAllocationTag& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     ScopedAllocationTag& operator=(const ScopedAllocationTag& rhs)
+                                                                      = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  ScopedAllocationTag& operator=(const ScopedAllocationTag& rhs) = delete;
+
+  /**
+   *  @name   ~ScopedAllocationTag
+   *  @fn     ~ScopedAllocationTag(void)
+   *  @brief  Destructor, restore previous tag
+   */
+  ~ScopedAllocationTag(void);
+
+ private:
+  /** Tag active before this scope */
+  int previous_;
 };
   
 /**
@@ -263,10 +481,19 @@ inline void Allocator::CallDTor(const size_t& n_element, std::string* t_ptr) {
  */
 void EnableAllocatorStatistics(const bool& enable);
   
+/**
+ *  @name   AllocatorStatisticsEnabled
+ *  @fn     bool AllocatorStatisticsEnabled(void)
+ *  @brief  Indicate if allocation statistics are filled
+ *  @return True if enabled
+ */
+bool AllocatorStatisticsEnabled(void);
+  
 /**
  *  @name   DefaultCpuAllocator
  *  @fn     Allocator* DefaultCpuAllocator(void)
- *  @brief  Provide default allocator for CPU usage
+ *  @brief  Provide default allocator for CPU usage. The pooled allocator is
+ *          used unless `FACEKIT_CPU_ALLOCATOR` names another registered one.
  *  @return CPU Allocator
  */
 Allocator* DefaultCpuAllocator(void);
@@ -279,6 +506,15 @@ Allocator* DefaultCpuAllocator(void);
  *  @return corresponding allocator or nullptr of it does not excist
  */
 Allocator* GetAllocator(const std::string& name);
+
+/**
+ *  @name   GetAllocator
+ *  @fn     Allocator* GetAllocator(const char* name)
+ *  @brief  Search for an allocator of a given name without allocating
+ *  @param[in] name Allocator's name
+ *  @return corresponding allocator or nullptr of it does not excist
+ */
+Allocator* GetAllocator(const char* name);
   
   
 }  // namespace FaceKit
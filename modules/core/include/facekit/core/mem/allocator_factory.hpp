@@ -11,7 +11,7 @@
 #ifndef __FACEKIT_ALLOCATOR_FACTORY__
 #define __FACEKIT_ALLOCATOR_FACTORY__
 
-#include <unordered_map>
+#include <string>
 
 #include "facekit/core/library_export.hpp"
 #include "facekit/core/status.hpp"
@@ -83,17 +83,51 @@ class FK_EXPORTS AllocatorFactory {
 #pragma mark -
 #pragma mark Usage
   
+  /**
+   *  @name   Creator
+   *  @brief  Build an allocator on first use, called once
+   */
+  using Creator = Allocator* (*)(void);
+
+  /** Maximum number of registered allocators */
+  static constexpr size_t kMaxAllocator = 32;
+
   /**
    *  @name   Register
-   *  @fn     void Register(const std::string& name, Allocator* allocator)
-   *  @brief  Add a new allocator in the factory
-   *  @param[in]  name  Allocator's name
-   *  @param[in]  allocator Allocator to register, factory does not take the 
+   *  @fn     static int Register(const char* name, Creator creator)
+   *  @brief  Add a new allocator in the factory, built on first request.
+   *          Does not allocate nor touch any singleton, therefore it is
+   *          cheap to call from static constructors.
+   *  @param[in]  name    Allocator's name, must outlive the factory (i.e.
+   *                      string literal)
+   *  @param[in]  creator Build the allocator, the factory does not take the
+   *                      ownership
+   *  @return -1 if name already taken or too many allocators, 0 otherwise
+   */
+  static int Register(const char* name, Creator creator);
+
+  /**
+   *  @name   Register
+   *  @fn     static int Register(const char* name, Allocator* allocator)
+   *  @brief  Add an existing allocator in the factory
+   *  @param[in]  name  Allocator's name, must outlive the factory (i.e.
+   *                    string literal)
+   *  @param[in]  allocator Allocator to register, factory does not take the
    *              ownership
-   *  @return -1 if name already taken, 0 otherwise
+   *  @return -1 if name already taken or too many allocators, 0 otherwise
    */
-  int Register(const std::string& name, Allocator* allocator);
-  
+  static int Register(const char* name, Allocator* allocator);
+
+  /**
+   *  @name   GetAllocator
+   *  @fn     Allocator* GetAllocator(const char* name) const
+   *  @brief  Search for a given allocator, built on first request. Does not
+   *          allocate beside building the allocator.
+   *  @param[in]  name  Allocator's name to search for
+   *  @return Allocator instance or nullptr if `name` is not in the factory
+   */
+  Allocator* GetAllocator(const char* name) const;
+
   /**
    *  @name   GetAllocator
    *  @fn     Allocator* GetAllocator(const std::string& name) const
@@ -101,7 +135,9 @@ class FK_EXPORTS AllocatorFactory {
    *  @param[in]  name  Allocator's name to search for
    *  @return Allocator instance or nullptr if `name` is not in the factory
    */
-  Allocator* GetAllocator(const std::string& name) const;
+  Allocator* GetAllocator(const std::string& name) const {
+    return this->GetAllocator(name.c_str());
+  }
   
 #pragma mark -
 #pragma mark Private
@@ -113,9 +149,6 @@ class FK_EXPORTS AllocatorFactory {
    *  @brief  Constructor
    */
   AllocatorFactory(void) = default;
-  
-  /** Registered allocators */
-  std::unordered_map<std::string, Allocator*> allocators_;
 };
   
 /**
@@ -130,16 +163,14 @@ class FK_EXPORTS AllocatorProxy {
  
   /**
    *  @name   AllocatorProxy
-   *  @fn     AllocatorProxy(const std::string& name, Allocator* allocator)
+   *  @fn     AllocatorProxy(const char* name,
+                             AllocatorFactory::Creator creator)
    *  @brief  Constructor
-   *  @param[in]  name      Allocator's name
-   *  @param[in]  allocator Allocator to register, no ownership taken
+   *  @param[in]  name    Allocator's name
+   *  @param[in]  creator Build the allocator on first use
    */
-  AllocatorProxy(const std::string& name, Allocator* allocator) {
-    if(AllocatorFactory::Get().Register(name, allocator)) {
-      Status s(Status::Type::kInvalidArgument,
-               "Allocator with name '" + name + "' is already registered");
-    }
+  AllocatorProxy(const char* name, AllocatorFactory::Creator creator) {
+    AllocatorFactory::Register(name, creator);
   }
 };
 
@@ -159,10 +190,15 @@ class FK_EXPORTS AllocatorProxy {
   
 /**
  *  @def REGISTER_ALLOCATOR_UNIQ
- *  @brief  Create unique allocator proxy
+ *  @brief  Create unique allocator proxy, the allocator itself is built on
+ *          first request
  */
-#define REGISTER_ALLOCATOR_UNIQ(cnt, name, allocator) \
-  static AllocatorProxy register_allocator_##cnt(name, new allocator)
+#define REGISTER_ALLOCATOR_UNIQ(cnt, name, allocator)             \
+  static Allocator* create_allocator_##cnt(void) {                \
+    return new allocator();                                       \
+  }                                                               \
+  static AllocatorProxy register_allocator_##cnt(name,            \
+                                                 &create_allocator_##cnt)
   
   
 }  // namespace FaceKit
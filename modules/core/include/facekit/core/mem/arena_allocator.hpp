@@ -0,0 +1,270 @@
+/**
+ *  @file   arena_allocator.hpp
+ *  @brief Bump allocator drawing from large chunks, released all at once.
+ *          Meant for scratch memory living for one iteration / frame.
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   24.02.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_ARENA_ALLOCATOR__
+#define __FACEKIT_ARENA_ALLOCATOR__
+
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/mem/allocator.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  ArenaAllocator
+ *  @brief  Bump allocator drawing from large chunks. Deallocation is a no-op,
+ *          memory is given back at once with `Rewind`/`Reset` (usually through
+ *          a `ScopedArena`). Chunks are kept for later reuse until `Release`
+ *          is called or the arena is destroyed.
+ *  @author Christophe Ecabert
+ *  @date   24.02.18
+ *  @ingroup core
+ *  @details Objects with non-trivial destructor (i.e. std::string) still need
+ *           to be deallocated before rewinding.
+ */
+class FK_EXPORTS ArenaAllocator : public Allocator {
+public:
+
+  /** Default chunk size */
+  static constexpr size_t kDefaultChunkSize = size_t(1) << 20;
+
+  /**
+   *  @struct  Mark
+   *  @brief  Position within the arena
+   */
+  struct Mark {
+    /** Chunk index */
+    size_t chunk;
+    /** Offset within the chunk */
+    size_t offset;
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   ArenaAllocator
+   *  @fn     explicit ArenaAllocator(const size_t& chunk_size,
+                                      Allocator* backing)
+   *  @brief  Constructor
+   *  @param[in] chunk_size Size of the chunks requested to `backing`
+   *  @param[in] backing    Allocator providing the chunks, if nullptr use the
+   *                        default CPU allocator
+   */
+  explicit ArenaAllocator(const size_t& chunk_size = kDefaultChunkSize,
+                          Allocator* backing = nullptr);
+
+  /**
+   *  @name   ArenaAllocator
+   *  @fn     ArenaAllocator(const ArenaAllocator& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in]  other Object to copy from
+   */
+  ArenaAllocator(const ArenaAllocator& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     ArenaAllocator& operator=(const ArenaAllocator& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  ArenaAllocator& operator=(const ArenaAllocator& rhs) = delete;
+
+  /**
+   *  @name   ~ArenaAllocator
+   *  @fn     ~ArenaAllocator(void) override
+   *  @brief  Destructor, give chunks back to backing allocator
+   */
+  ~ArenaAllocator(void) override;
+
+  /**
+   *  @name   Name
+   *  @fn     std::string Name(void) const override
+   *  @brief  Give allocator's name
+   */
+  std::string Name(void) const override {
+    return "arena_allocator";
+  }
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   AllocateRaw
+   *  @fn     void* AllocateRaw(const size_t& size,
+   *          const size_t& alignment) override
+   *  @brief  Allocate a block of memory of a given size with specific
+   *          alignment. Alignment must be a power of 2 and minimum of
+   *          sizeof(void*)
+   *  @param[in]  size      Size of the memory block in bytes
+   *  @param[in]  alignment Desired memory alignment
+   *  @return Pointer to memory block or nullptr if failed.
+   */
+  void* AllocateRaw(const size_t& size, const size_t& alignment) override;
+
+  /**
+   *  @name   DeallocateRaw
+   *  @fn     void DeallocateRaw(void* ptr) override
+   *  @brief  Release a block of memory pointed by `ptr`, no-op memory is
+   *          recovered on `Rewind`.
+   *  @param[in]  size  Size of the memory block in bytes
+   *  @param[in]  ptr   Pointer to memory block
+   */
+  void DeallocateRaw(const size_t& size, void* ptr) override;
+
+  /**
+   *  @name   GetMark
+   *  @fn     Mark GetMark(void)
+   *  @brief  Current position within the arena
+   *  @return Mark to rewind to
+   */
+  Mark GetMark(void);
+
+  /**
+   *  @name   Rewind
+   *  @fn     void Rewind(const Mark& mark)
+   *  @brief  Give back everything allocated after `mark`
+   *  @param[in] mark Position to go back to
+   */
+  void Rewind(const Mark& mark);
+
+  /**
+   *  @name   Reset
+   *  @fn     void Reset(void)
+   *  @brief  Give back everything, chunks are kept for reuse
+   */
+  void Reset(void);
+
+  /**
+   *  @name   Release
+   *  @fn     void Release(void)
+   *  @brief  Give back everything and return chunks to backing allocator
+   */
+  void Release(void);
+
+  /**
+   *  @name   GatherStatistics
+   *  @fn     void GatherStatistics(AllocatorStatistic* stats) override
+   *  @brief  Provide statistics for this allocator
+   *  @param[out] stats   Object filled with statistics from this allocator
+   */
+  void GatherStatistics(AllocatorStatistic* stats) override;
+
+  /**
+   *  @name   ClearStatistics
+   *  @fn     void ClearStatistics(void) override
+   *  @brief  Clear allocator's statistics
+   */
+  void ClearStatistics(void) override;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   capacity
+   *  @fn     size_t capacity(void)
+   *  @brief  Total size of the chunks held by the arena
+   *  @return Capacity in bytes
+   */
+  size_t capacity(void);
+
+private:
+
+  /**
+   *  @struct  Chunk
+   *  @brief  Memory chunk
+   */
+  struct Chunk {
+    /** Memory */
+    uint8_t* data;
+    /** Size in bytes */
+    size_t size;
+  };
+
+  /** Chunk size */
+  size_t chunk_size_;
+  /** Allocator providing the chunks */
+  Allocator* backing_;
+  /** Chunks */
+  std::vector<Chunk> chunks_;
+  /** Chunk currently used */
+  size_t current_;
+  /** Offset within the current chunk */
+  size_t offset_;
+  /** Mutex */
+  std::mutex lock_;
+  /** Statistics */
+  AllocatorStatisticCollector stats_;
+};
+
+/**
+ *  @class  ScopedArena
+ *  @brief  Rewind an arena to its position at construction time when it goes
+ *          out of scope. Scopes can be nested.
+ *  @author Christophe Ecabert
+ *  @date   24.02.18
+ *  @ingroup core
+ */
+class FK_EXPORTS ScopedArena {
+public:
+
+  /**
+   *  @name   ScopedArena
+   *  @fn     explicit ScopedArena(ArenaAllocator* arena)
+   *  @brief  Constructor
+   *  @param[in] arena  Arena to rewind at the end of the scope
+   */
+  explicit ScopedArena(ArenaAllocator* arena) : arena_(arena),
+                                                mark_(arena->GetMark()) {}
+
+  /**
+   *  @name   ScopedArena
+   *  @fn     ScopedArena(const ScopedArena& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in]  other Object to copy from
+   */
+  ScopedArena(const ScopedArena& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     ScopedArena& operator=(const ScopedArena& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  ScopedArena& operator=(const ScopedArena& rhs) = delete;
+
+  /**
+   *  @name   ~ScopedArena
+   *  @fn     ~ScopedArena(void)
+   *  @brief  Destructor, rewind the arena
+   */
+  ~ScopedArena(void) {
+    arena_->Rewind(mark_);
+  }
+
+private:
+  /** Arena */
+  ArenaAllocator* arena_;
+  /** Position at construction */
+  ArenaAllocator::Mark mark_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_ARENA_ALLOCATOR__ */
@@ -0,0 +1,127 @@
+/**
+ *  @file   cv_allocator.hpp
+ *  @brief Route OpenCV matrix allocations through FaceKit allocators
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_CV_ALLOCATOR__
+#define __FACEKIT_CV_ALLOCATOR__
+
+#include <cstddef>
+
+#include "facekit/core/library_export.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Forward declaration */
+class Allocator;
+
+/**
+ *  @class  CvAllocator
+ *  @brief  Hook OpenCV's default matrix allocator so that `cv::Mat` data
+ *          created by a thread comes from the FaceKit allocator selected for
+ *          that thread (i.e. `pooled_cpu_allocator`). Threads without one,
+ *          and matrices wrapping user data, keep OpenCV's allocator. Memory
+ *          is given back to the allocator that provided it, whichever thread
+ *          releases the last reference. The hook is installed the first time
+ *          an allocator is selected.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup core
+ */
+class FK_EXPORTS CvAllocator {
+ public:
+
+  /** Alignment of the matrices' data */
+  static constexpr size_t kAlignment = 64;
+
+  /**
+   *  @name   Pooled
+   *  @fn     static Allocator* Pooled(void)
+   *  @brief  Pooled CPU allocator, the usual choice for temporaries
+   *  @return Allocator registered as `pooled_cpu_allocator`
+   */
+  static Allocator* Pooled(void);
+
+  /**
+   *  @name   GetThreadAllocator
+   *  @fn     static Allocator* GetThreadAllocator(void)
+   *  @brief  Allocator used by the calling thread
+   *  @return Allocator or nullptr if OpenCV's one is used
+   */
+  static Allocator* GetThreadAllocator(void);
+
+  /**
+   *  @name   SetThreadAllocator
+   *  @fn     static Allocator* SetThreadAllocator(Allocator* allocator)
+   *  @brief  Select the allocator used by the calling thread. Matrices
+   *          allocated with it may outlive the selection but not the
+   *          allocator itself, nor a rewind of an arena.
+   *  @param[in] allocator  Allocator, nullptr to go back to OpenCV's one
+   *  @return Previously selected allocator
+   */
+  static Allocator* SetThreadAllocator(Allocator* allocator);
+};
+
+/**
+ *  @class  ScopedCvAllocator
+ *  @brief  Select the allocator of the calling thread's matrices until the
+ *          end of the scope. Scopes can be nested.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup core
+ */
+class FK_EXPORTS ScopedCvAllocator {
+ public:
+
+  /**
+   *  @name   ScopedCvAllocator
+   *  @fn     explicit ScopedCvAllocator(Allocator* allocator)
+   *  @brief  Constructor
+   *  @param[in] allocator  Allocator to use within the scope
+   */
+  explicit ScopedCvAllocator(Allocator* allocator) :
+          prev_(CvAllocator::SetThreadAllocator(allocator)) {}
+
+  /**
+   *  @name   ScopedCvAllocator
+   *  @fn     ScopedCvAllocator(const ScopedCvAllocator& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in]  other Object to copy from
+   */
+  ScopedCvAllocator(const ScopedCvAllocator& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     ScopedCvAllocator& operator=(const ScopedCvAllocator& rhs)
+                                                                    = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  ScopedCvAllocator& operator=(const ScopedCvAllocator& rhs) = delete;
+
+  /**
+   *  @name   ~ScopedCvAllocator
+   *  @fn     ~ScopedCvAllocator(void)
+   *  @brief  Destructor, restore the previous allocator
+   */
+  ~ScopedCvAllocator(void) {
+    CvAllocator::SetThreadAllocator(prev_);
+  }
+
+ private:
+  /** Allocator selected before the scope */
+  Allocator* prev_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_CV_ALLOCATOR__ */
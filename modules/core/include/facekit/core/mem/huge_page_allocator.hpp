@@ -0,0 +1,161 @@
+/**
+ *  @file   huge_page_allocator.hpp
+ *  @brief Allocator backing large buffers with huge pages, optionally bound
+ *          to a given NUMA node.
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   26.02.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_HUGE_PAGE_ALLOCATOR__
+#define __FACEKIT_HUGE_PAGE_ALLOCATOR__
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/mem/allocator.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  HugePageAllocator
+ *  @brief  Allocator for large, long lived buffers (i.e. model bases). Blocks
+ *          of at least `kMinHugeSize` bytes are mapped directly from the
+ *          system, aligned on `kHugePageSize` and backed by huge pages when
+ *          available. Smaller blocks go to the regular aligned malloc.
+ *  @author Christophe Ecabert
+ *  @date   26.02.18
+ *  @ingroup core
+ *  @details On Linux, transparent huge pages are requested with
+ *           `madvise(MADV_HUGEPAGE)`. Explicit huge pages (`MAP_HUGETLB`) are
+ *           tried first when `FACEKIT_HUGETLB` is set in the environment.
+ *           Memory can be placed preferably on a NUMA node. Other platforms
+ *           fall back to regular aligned allocation.
+ */
+class FK_EXPORTS HugePageAllocator : public Allocator {
+public:
+
+  /** Huge page size */
+  static constexpr size_t kHugePageSize = size_t(2) << 20;
+  /** Smallest block mapped with huge pages */
+  static constexpr size_t kMinHugeSize = size_t(1) << 20;
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   HugePageAllocator
+   *  @fn     explicit HugePageAllocator(const int& numa_node = -1)
+   *  @brief  Constructor
+   *  @param[in] numa_node  NUMA node on which memory is placed preferably,
+   *                        -1 for no preference
+   */
+  explicit HugePageAllocator(const int& numa_node = -1);
+
+  /**
+   *  @name   HugePageAllocator
+   *  @fn     HugePageAllocator(const HugePageAllocator& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in]  other Object to copy from
+   */
+  HugePageAllocator(const HugePageAllocator& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     HugePageAllocator& operator=(const HugePageAllocator& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  HugePageAllocator& operator=(const HugePageAllocator& rhs) = delete;
+
+  /**
+   *  @name   ~HugePageAllocator
+   *  @fn     ~HugePageAllocator(void) override
+   *  @brief  Destructor
+   */
+  ~HugePageAllocator(void) override;
+
+  /**
+   *  @name   Name
+   *  @fn     std::string Name(void) const override
+   *  @brief  Give allocator's name
+   */
+  std::string Name(void) const override {
+    return "huge_page_allocator";
+  }
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   AllocateRaw
+   *  @fn     void* AllocateRaw(const size_t& size,
+   *          const size_t& alignment) override
+   *  @brief  Allocate a block of memory of a given size with specific
+   *          alignment. Alignment must be a power of 2 and minimum of
+   *          sizeof(void*)
+   *  @param[in]  size      Size of the memory block in bytes
+   *  @param[in]  alignment Desired memory alignment
+   *  @return Pointer to memory block or nullptr if failed.
+   */
+  void* AllocateRaw(const size_t& size, const size_t& alignment) override;
+
+  /**
+   *  @name   DeallocateRaw
+   *  @fn     void DeallocateRaw(void* ptr) override
+   *  @brief  Release a block of memory pointed by `ptr`
+   *  @param[in]  size  Size of the memory block in bytes
+   *  @param[in]  ptr   Pointer to memory block
+   */
+  void DeallocateRaw(const size_t& size, void* ptr) override;
+
+  /**
+   *  @name   GatherStatistics
+   *  @fn     void GatherStatistics(AllocatorStatistic* stats) override
+   *  @brief  Provide statistics for this allocator
+   *  @param[out] stats   Object filled with statistics from this allocator
+   */
+  void GatherStatistics(AllocatorStatistic* stats) override;
+
+  /**
+   *  @name   ClearStatistics
+   *  @fn     void ClearStatistics(void) override
+   *  @brief  Clear allocator's statistics
+   */
+  void ClearStatistics(void) override;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   numa_node
+   *  @fn     int numa_node(void) const
+   *  @brief  NUMA node on which memory is placed
+   *  @return Node index or -1 if no preference
+   */
+  int numa_node(void) const {
+    return numa_node_;
+  }
+
+  /**
+   *  @name   IsSupported
+   *  @fn     static bool IsSupported(void)
+   *  @brief  Indicate if the platform can provide huge pages
+   *  @return True if supported, false if falling back to regular pages
+   */
+  static bool IsSupported(void);
+
+private:
+  /** NUMA node */
+  int numa_node_;
+  /** Statistics */
+  AllocatorStatisticCollector stats_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_HUGE_PAGE_ALLOCATOR__ */
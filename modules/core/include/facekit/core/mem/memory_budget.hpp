@@ -0,0 +1,360 @@
+/**
+ *  @file   memory_budget.hpp
+ *  @brief  Memory budget shared by the stages of a pipeline, producers
+ *          block once it is reached
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_MEMORY_BUDGET__
+#define __FACEKIT_MEMORY_BUDGET__
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+#include "facekit/core/library_export.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Forward declaration */
+class Allocator;
+class ThreadPool;
+
+/**
+ *  @class  MemoryBudget
+ *  @brief  Bound the memory held by the stages of a pipeline. Producers
+ *          acquire a token for the buffers they bring in and block while the
+ *          budget is reached. Downstream stages adjust or charge tokens for
+ *          what they derive without ever blocking, and hand them over along
+ *          with their data. Memory is given back when the last token goes
+ *          away, which wakes up the blocked producers. Since only producers
+ *          wait, and they wait while holding no token, the pipeline can not
+ *          deadlock on its own budget.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup core
+ *  @details When an allocator is tracked and statistics are enabled (see
+ *           `EnableAllocatorStatistics`), the usage is the largest of the
+ *           reserved bytes and the bytes in use reported by the allocator,
+ *           so that memory allocated without token is accounted as well.
+ *           A request is always granted when nothing is reserved, a buffer
+ *           larger than the budget therefore goes through alone.
+ */
+class FK_EXPORTS MemoryBudget {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /**
+   *  @class  Token
+   *  @brief  Bytes reserved in a budget, given back on destruction. Tokens
+   *          can be moved across threads but must not outlive their budget.
+   */
+  class FK_EXPORTS Token {
+   public:
+    /**
+     *  @name   Token
+     *  @fn     Token(void)
+     *  @brief  Constructor, empty token
+     */
+    Token(void) : budget_(nullptr), bytes_(0) {}
+
+    /**
+     *  @name   Token
+     *  @fn     Token(Token&& other)
+     *  @brief  Move constructor
+     *  @param[in] other  Token to move from, left empty
+     */
+    Token(Token&& other) : budget_(other.budget_), bytes_(other.bytes_) {
+      other.budget_ = nullptr;
+      other.bytes_ = 0;
+    }
+
+    /**
+     *  @name   operator=
+     *  @fn     Token& operator=(Token&& rhs)
+     *  @brief  Move assignment, bytes held so far are given back
+     *  @param[in] rhs  Token to move from, left empty
+     *  @return Newly assigned token
+     */
+    Token& operator=(Token&& rhs);
+
+    /**
+     *  @name   Token
+     *  @fn     Token(const Token& other) = delete
+     *  @brief  Copy constructor
+     */
+    Token(const Token& other) = delete;
+
+    /**
+     *  @name   operator=
+     *  @fn     Token& operator=(const Token& rhs) = delete
+     *  @brief  Assignment operator
+     */
+    Token& operator=(const Token& rhs) = delete;
+
+    /**
+     *  @name   ~Token
+     *  @fn     ~Token(void)
+     *  @brief  Destructor, give the bytes back
+     */
+    ~Token(void) {
+      this->Release();
+    }
+
+    /**
+     *  @name   Resize
+     *  @fn     void Resize(const size_t& bytes)
+     *  @brief  Account for \p bytes instead of the current amount without
+     *          waiting, the budget can be exceeded. Used by stages once the
+     *          size of what they produced is known.
+     *  @param[in] bytes  New amount, the token must not be empty
+     */
+    void Resize(const size_t& bytes);
+
+    /**
+     *  @name   Release
+     *  @fn     void Release(void)
+     *  @brief  Give the bytes back, the token is left empty
+     */
+    void Release(void);
+
+    /**
+     *  @name   bytes
+     *  @fn     size_t bytes(void) const
+     *  @brief  Bytes held
+     */
+    size_t bytes(void) const {
+      return bytes_;
+    }
+
+    /**
+     *  @name   operator bool
+     *  @fn     explicit operator bool(void) const
+     *  @brief  Indicate if the token is bound to a budget
+     */
+    explicit operator bool(void) const {
+      return budget_ != nullptr;
+    }
+
+   private:
+    friend class MemoryBudget;
+
+    /** Budget the bytes come from */
+    MemoryBudget* budget_;
+    /** Bytes held */
+    size_t bytes_;
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   Global
+   *  @fn     static MemoryBudget& Global(void)
+   *  @brief  Process-wide budget. Its limit is read from
+   *          `FACEKIT_MEMORY_BUDGET` (bytes, `K`, `M` or `G` suffix allowed),
+   *          unlimited if not set. It tracks `DefaultCpuAllocator()`.
+   */
+  static MemoryBudget& Global(void);
+
+  /**
+   *  @name   MemoryBudget
+   *  @fn     explicit MemoryBudget(const size_t& limit = 0)
+   *  @brief  Constructor
+   *  @param[in] limit  Budget in bytes, 0 for unlimited (usage is still
+   *                    tracked)
+   */
+  explicit MemoryBudget(const size_t& limit = 0);
+
+  /**
+   *  @name   MemoryBudget
+   *  @fn     MemoryBudget(const MemoryBudget& other) = delete
+   *  @brief  Copy constructor
+   */
+  MemoryBudget(const MemoryBudget& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     MemoryBudget& operator=(const MemoryBudget& rhs) = delete
+   *  @brief  Assignment operator
+   */
+  MemoryBudget& operator=(const MemoryBudget& rhs) = delete;
+
+  /**
+   *  @name   ~MemoryBudget
+   *  @fn     ~MemoryBudget(void) = default
+   *  @brief  Destructor, every token must have been released
+   */
+  ~MemoryBudget(void) = default;
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   Acquire
+   *  @fn     void Acquire(const size_t& bytes, Token* token)
+   *  @brief  Reserve \p bytes, blocks while they do not fit in the budget
+   *  @param[in] bytes  Amount to reserve
+   *  @param[out] token Reservation, bytes it held before are given back
+   */
+  void Acquire(const size_t& bytes, Token* token);
+
+  /**
+   *  @name   Acquire
+   *  @fn     void Acquire(const size_t& bytes, ThreadPool* pool,
+                           Token* token)
+   *  @brief  Reserve \p bytes, running pending tasks of \p pool while they
+   *          do not fit in the budget. To be used from tasks of a pool
+   *          whose other tasks release the budget, waiting would otherwise
+   *          starve them.
+   *  @param[in] bytes  Amount to reserve
+   *  @param[in] pool   Pool to help while waiting
+   *  @param[out] token Reservation, bytes it held before are given back
+   */
+  void Acquire(const size_t& bytes, ThreadPool* pool, Token* token);
+
+  /**
+   *  @name   TryAcquire
+   *  @fn     bool TryAcquire(const size_t& bytes, Token* token)
+   *  @brief  Reserve \p bytes if they fit in the budget
+   *  @param[in] bytes  Amount to reserve
+   *  @param[out] token Reservation, bytes it held before are given back
+   *  @return True if reserved, \p token is left untouched otherwise
+   */
+  bool TryAcquire(const size_t& bytes, Token* token);
+
+  /**
+   *  @name   Charge
+   *  @fn     void Charge(const size_t& bytes, Token* token)
+   *  @brief  Account for \p bytes already allocated without waiting, the
+   *          budget can be exceeded. Producers blocked meanwhile wait for
+   *          them to be released.
+   *  @param[in] bytes  Amount to account for
+   *  @param[out] token Reservation, bytes it held before are given back
+   */
+  void Charge(const size_t& bytes, Token* token);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   limit
+   *  @fn     size_t limit(void) const
+   *  @brief  Budget in bytes, 0 if unlimited
+   */
+  size_t limit(void) const;
+
+  /**
+   *  @name   set_limit
+   *  @fn     void set_limit(const size_t& limit)
+   *  @brief  Change the budget, producers waiting are woken up
+   *  @param[in] limit  Budget in bytes, 0 for unlimited
+   */
+  void set_limit(const size_t& limit);
+
+  /**
+   *  @name   set_allocator
+   *  @fn     void set_allocator(Allocator* allocator)
+   *  @brief  Account for the bytes in use reported by \p allocator's
+   *          statistics as well. Producers then poll for memory released
+   *          without token.
+   *  @param[in] allocator  Allocator to track, nullptr to only count tokens
+   */
+  void set_allocator(Allocator* allocator);
+
+  /**
+   *  @name   used
+   *  @fn     size_t used(void) const
+   *  @brief  Memory in use, see class details
+   */
+  size_t used(void) const;
+
+  /**
+   *  @name   reserved
+   *  @fn     size_t reserved(void) const
+   *  @brief  Bytes held by tokens
+   */
+  size_t reserved(void) const;
+
+  /**
+   *  @name   peak
+   *  @fn     size_t peak(void) const
+   *  @brief  Largest amount held by tokens
+   */
+  size_t peak(void) const;
+
+  /**
+   *  @name   n_wait
+   *  @fn     size_t n_wait(void) const
+   *  @brief  Number of acquisitions that had to wait
+   */
+  size_t n_wait(void) const;
+
+  /**
+   *  @name   exhausted
+   *  @fn     bool exhausted(void) const
+   *  @brief  Indicate if the budget is reached, producers that do not wait
+   *          on it can poll this before bringing in new data
+   */
+  bool exhausted(void) const;
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /**
+   *  @name   Usage
+   *  @fn     size_t Usage(void) const
+   *  @brief  Memory in use, the lock must be held
+   */
+  size_t Usage(void) const;
+
+  /**
+   *  @name   Fits
+   *  @fn     bool Fits(const size_t& bytes) const
+   *  @brief  Indicate if \p bytes can be granted, the lock must be held
+   */
+  bool Fits(const size_t& bytes) const;
+
+  /**
+   *  @name   Grant
+   *  @fn     void Grant(const size_t& bytes, Token* token)
+   *  @brief  Reserve \p bytes into \p token, the lock must be held and the
+   *          token empty
+   */
+  void Grant(const size_t& bytes, Token* token);
+
+  /**
+   *  @name   Return
+   *  @fn     void Return(const size_t& bytes)
+   *  @brief  Give \p bytes back and wake up waiting producers
+   */
+  void Return(const size_t& bytes);
+
+  /** Budget, 0 if unlimited */
+  size_t limit_;
+  /** Bytes held by tokens */
+  size_t reserved_;
+  /** Largest amount held by tokens */
+  size_t peak_;
+  /** Number of acquisitions that waited */
+  size_t n_wait_;
+  /** Allocator whose usage is tracked */
+  Allocator* allocator_;
+  /** Synchronization */
+  mutable std::mutex lock_;
+  /** Signaled when bytes are given back or the limit changes */
+  std::condition_variable cond_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_MEMORY_BUDGET__ */
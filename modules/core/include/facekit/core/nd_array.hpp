@@ -11,7 +11,10 @@
 #ifndef __FACEKIT_ND_ARRAY__
 #define __FACEKIT_ND_ARRAY__
 
+#include <atomic>
 #include <cassert>
+#include <functional>
+#include <iosfwd>
 #include <vector>
 #include <type_traits>
 #include <string>
@@ -24,6 +27,18 @@
 #include "facekit/core/mem/allocator.hpp"
 #include "facekit/core/type_traits.hpp"
 
+/** Forward declaration, include "opencv2/core/core.hpp" to use interop */
+namespace cv {
+class Mat;
+}  // namespace cv
+
+/** Forward declaration */
+namespace google {
+namespace protobuf {
+class Arena;
+}  // namespace protobuf
+}  // namespace google
+
 /**
  *  @namespace  FaceKit
  *  @brief      Development space
@@ -85,13 +100,52 @@ class FK_EXPORTS NDArrayBuffer : public RefCounter {
   T* base(void) const {
     return reinterpret_cast<T*>(data());
   }
+
+  /**
+   *  @name   IncAlias
+   *  @fn     void IncAlias(void)
+   *  @brief  Add a reference that deliberately aliases the data (i.e. view,
+   *          OpenCV matrix). Aliases do not trigger copy-on-write.
+   */
+  void IncAlias(void) {
+    aliases_.fetch_add(1, std::memory_order_relaxed);
+    this->Inc();
+  }
+
+  /**
+   *  @name   DecAlias
+   *  @fn     bool DecAlias(void)
+   *  @brief  Release a reference added with `IncAlias`
+   *  @return True if the buffer has been destroyed
+   */
+  bool DecAlias(void) {
+    aliases_.fetch_sub(1, std::memory_order_relaxed);
+    return this->Dec();
+  }
+
+  /**
+   *  @name   IsShared
+   *  @fn     bool IsShared(void) const
+   *  @brief  Indicate if more than one array owns this buffer, aliases are
+   *          not taken into account.
+   *  @return True if shared
+   */
+  bool IsShared(void) const {
+    return this->Count() > 1 + aliases_.load(std::memory_order_acquire);
+  }
+
+ private:
+  /** Number of references being aliases */
+  std::atomic<std::int_fast32_t> aliases_{0};
 };
 
 
 /**
  *  @class  NDArray
  *  @brief  Representation of a n-dimension array storing values of a
- *          given types.
+ *          given types. Copies share the buffer until one of them is
+ *          accessed for writing (copy-on-write), views always alias their
+ *          parent.
  *  @author Christophe Ecabert
  *  @date   23.02.18
  *  @ingroup core
@@ -99,6 +153,28 @@ class FK_EXPORTS NDArrayBuffer : public RefCounter {
 class FK_EXPORTS NDArray {
  public:
 
+  /** Marker for the end of an axis */
+  static constexpr size_t kAll = static_cast<size_t>(-1);
+
+  /**
+   *  @struct  Range
+   *  @brief  Selection along one axis: [start, stop) with a given step
+   */
+  struct Range {
+    /** Full axis */
+    Range(void) : start(0), stop(kAll), step(1) {}
+    /** Sub range */
+    Range(const size_t& start,
+          const size_t& stop,
+          const size_t& step = 1) : start(start), stop(stop), step(step) {}
+    /** First index */
+    size_t start;
+    /** Past-the-end index, clamped to axis dimension */
+    size_t stop;
+    /** Step between selected indices, must be > 0 */
+    size_t step;
+  };
+
 #pragma mark -
 #pragma mark Initialization
 
@@ -144,7 +220,8 @@ class FK_EXPORTS NDArray {
   /**
    *  @name   NDArray
    *  @fn     NDArray(const NDArray& other)
-   *  @brief  Copy constructor
+   *  @brief  Copy constructor, the buffer is shared until one of the arrays
+   *          is accessed through a non-const accessor.
    *  @param[in] other  Object to copy from
    */
   NDArray(const NDArray& other);
@@ -160,7 +237,8 @@ class FK_EXPORTS NDArray {
   /**
    *  @name   operator=
    *  @fn     NDArray& operator=(const NDArray& rhs)
-   *  @brief  Copy Assignment operator
+   *  @brief  Copy Assignment operator, the buffer is shared until one of the
+   *          arrays is accessed through a non-const accessor.
    *  @param[in] rhs  Object to assign from
    *  @return Newly assigned object
    */
@@ -185,7 +263,8 @@ class FK_EXPORTS NDArray {
   /**
    *  @name   Resize
    *  @fn     void Resize(const DataType& type, const NDArrayDims& dims)
-   *  @brief  Resize the NDArray to new dimensions/type
+   *  @brief  Resize the NDArray to new dimensions/type. A buffer shared with
+   *          another array is replaced by a new one.
    */
   void Resize(const DataType& type, const NDArrayDims& dims);
 
@@ -206,6 +285,18 @@ class FK_EXPORTS NDArray {
    */
   void ToProto(NDArrayProto* proto) const;
 
+  /**
+   *  @name   ToProto
+   *  @fn     NDArrayProto* ToProto(google::protobuf::Arena* arena) const
+   *  @brief  Export the NDArray to a Protocol buffer object allocated on a
+   *          given arena. Reusing the same arena for a batch of messages
+   *          avoids one heap allocation per message and field.
+   *  @param[in] arena  Arena owning the message, if nullptr the message is
+   *                    allocated on the heap and owned by the caller
+   *  @return Protocol Buffer Object
+   */
+  NDArrayProto* ToProto(google::protobuf::Arena* arena) const;
+
   /**
    *  @name   FromProto
    *  @fn     Status FromProto(const NDArrayProto& proto)
@@ -225,6 +316,153 @@ class FK_EXPORTS NDArray {
    */
   Status FromProto(const NDArrayProto& proto, Allocator* allocator);
 
+  /**
+   *  @name   FromProto
+   *  @fn     Status FromProto(NDArrayProto* proto)
+   *  @brief  Fill this NDArray by taking over the data bytes of a given
+   *          Protocol Buffer Object (heap or arena allocated), `proto` data
+   *          is left empty. Numeric payloads are aliased without any copy
+   *          when suitably aligned.
+   *  @param[in,out] proto  Protobuf object holding NDArray
+   *  @return Operation status
+   */
+  Status FromProto(NDArrayProto* proto);
+
+  /**
+   *  @name   FromProto
+   *  @fn     Status FromProto(NDArrayProto* proto, Allocator* allocator)
+   *  @brief  Fill this NDArray by taking over the data bytes of a given
+   *          Protocol Buffer Object, see `FromProto(NDArrayProto*)`
+   *  @param[in,out] proto  Protobuf object holding NDArray
+   *  @param[in] allocator  Memory allocator used when the payload has to be
+   *                        copied
+   *  @return Operation status
+   */
+  Status FromProto(NDArrayProto* proto, Allocator* allocator);
+
+  /** Maximum payload size of a chunk in a stream, in bytes */
+  static constexpr size_t kStreamChunkSize = 4 << 20;
+
+  /**
+   *  @name   Write
+   *  @fn     Status Write(std::ostream& stream) const
+   *  @brief  Serialize the array into a stream without building an
+   *          intermediate protobuf message. Layout is a length-prefixed
+   *          NDArrayProto header (no data) followed by length-prefixed raw
+   *          chunks of at most `kStreamChunkSize` bytes and an empty chunk.
+   *  @param[in] stream Binary stream to write into
+   *  @return Operation status
+   */
+  Status Write(std::ostream& stream) const;
+
+  /**
+   *  @name   Write
+   *  @fn     Status Write(const int& fd) const
+   *  @brief  Serialize the array into a file descriptor, see
+   *          `Write(std::ostream&)`
+   *  @param[in] fd File descriptor open for writing
+   *  @return Operation status
+   */
+  Status Write(const int& fd) const;
+
+  /**
+   *  @name   Read
+   *  @fn     Status Read(std::istream& stream)
+   *  @brief  Fill this array from a stream written by `Write`. Chunks are read
+   *          directly into the array's buffer.
+   *  @param[in] stream Binary stream to read from
+   *  @return Operation status
+   */
+  Status Read(std::istream& stream);
+
+  /**
+   *  @name   Read
+   *  @fn     Status Read(std::istream& stream, Allocator* allocator)
+   *  @brief  Fill this array from a stream written by `Write`. Chunks are read
+   *          directly into the array's buffer.
+   *  @param[in] stream     Binary stream to read from
+   *  @param[in] allocator  Memory allocator to use
+   *  @return Operation status
+   */
+  Status Read(std::istream& stream, Allocator* allocator);
+
+  /**
+   *  @name   Read
+   *  @fn     Status Read(const int& fd)
+   *  @brief  Fill this array from a file descriptor, see
+   *          `Read(std::istream&)`
+   *  @param[in] fd File descriptor open for reading
+   *  @return Operation status
+   */
+  Status Read(const int& fd);
+
+  /**
+   *  @name   Read
+   *  @fn     Status Read(const int& fd, Allocator* allocator)
+   *  @brief  Fill this array from a file descriptor, see
+   *          `Read(std::istream&)`
+   *  @param[in] fd         File descriptor open for reading
+   *  @param[in] allocator  Memory allocator to use
+   *  @return Operation status
+   */
+  Status Read(const int& fd, Allocator* allocator);
+
+  /**
+   *  @enum   MapMode
+   *  @brief  How a file is mapped into memory
+   */
+  enum class MapMode : char {
+    /** Shared read-only mapping, writing into the array is not allowed */
+    kReadOnly,
+    /** Private mapping, modifications are not written back to the file */
+    kCopyOnWrite
+  };
+
+  /**
+   *  @name   MapFile
+   *  @fn     Status MapFile(const std::string& path, const DataType& type,
+                             const NDArrayDims& dims, const size_t& offset = 0,
+                             const MapMode& mode = MapMode::kReadOnly)
+   *  @brief  Back this NDArray with a memory-mapped region of a file holding
+   *          raw data. Pages are loaded on demand and shared between every
+   *          process mapping the same file.
+   *  @param[in] path   Path to the file
+   *  @param[in] type   Data type stored in the file, can not be kString
+   *  @param[in] dims   Array dimensions
+   *  @param[in] offset Position of the first element in the file in bytes,
+   *                    must be a multiple of the element size
+   *  @param[in] mode   Mapping mode
+   *  @return Operation status
+   */
+  Status MapFile(const std::string& path,
+                 const DataType& type,
+                 const NDArrayDims& dims,
+                 const size_t& offset = 0,
+                 const MapMode& mode = MapMode::kReadOnly);
+
+  /**
+   *  @name   AsCvMat
+   *  @fn     Status AsCvMat(cv::Mat* mat) const
+   *  @brief  Expose this array as an OpenCV matrix sharing the same buffer.
+   *          The buffer stays alive as long as either of them references it.
+   *          Rank-1 arrays map to a column, rank-2 to a matrix and rank-3
+   *          arrays (h, w, c) to a `c` channels matrix.
+   *  @param[out] mat Matrix sharing this array's buffer
+   *  @return kInvalidArgument if type or rank can not be represented
+   */
+  Status AsCvMat(cv::Mat* mat) const;
+
+  /**
+   *  @name   FromCvMat
+   *  @fn     Status FromCvMat(const cv::Mat& mat)
+   *  @brief  Back this array with the buffer of a continuous OpenCV matrix,
+   *          without copy. Multi-channels matrices give rank-3 arrays.
+   *  @param[in] mat  Matrix to share the buffer with
+   *  @return kInvalidArgument if `mat` is not continuous or its depth is not
+   *          supported
+   */
+  Status FromCvMat(const cv::Mat& mat);
+
   /**
    *  @name   WithScalar
    *  @fn     static NDArray WithScalar(const T& value)
@@ -291,6 +529,57 @@ class FK_EXPORTS NDArray {
    */
   NDArray Slice(const size_t& start, const size_t& stop) const;
 
+  /**
+   *  @name   View
+   *  @fn     NDArray View(const std::vector<Range>& ranges) const
+   *  @brief  Create a strided view of this array, without copy. Axes without
+   *          range are fully selected.
+   *  @param[in] ranges Selection for the first `ranges.size()` axes
+   *  @return View sharing this array's buffer
+   */
+  NDArray View(const std::vector<Range>& ranges) const;
+
+  /**
+   *  @name   Select
+   *  @fn     NDArray Select(const size_t& axis, const size_t& index) const
+   *  @brief  Pick a single index along an axis (i.e. one channel) and drop
+   *          that axis, without copy.
+   *  @param[in] axis   Axis to select from
+   *  @param[in] index  Index to pick
+   *  @return View of rank `dims() - 1`
+   */
+  NDArray Select(const size_t& axis, const size_t& index) const;
+
+  /**
+   *  @name   Permute
+   *  @fn     NDArray Permute(const std::vector<size_t>& axes) const
+   *  @brief  Reorder axes without copy, axis `i` of the view is axis
+   *          `axes[i]` of this array.
+   *  @param[in] axes Permutation of [0, dims())
+   *  @return Permuted view
+   */
+  NDArray Permute(const std::vector<size_t>& axes) const;
+
+  /**
+   *  @name   Transpose
+   *  @fn     NDArray Transpose(void) const
+   *  @brief  Reverse axes order without copy (i.e. matrix transpose)
+   *  @return Transposed view
+   */
+  NDArray Transpose(void) const;
+
+  /**
+   *  @name   IsContiguous
+   *  @fn     bool IsContiguous(void) const
+   *  @brief  Indicate if elements are laid out contiguously in row-major
+   *          order. Views are not necessarily contiguous, `DeepCopy` gives a
+   *          contiguous array.
+   *  @return True if contiguous
+   */
+  bool IsContiguous(void) const {
+    return strides_.empty();
+  }
+
   /**
    *  @name   AsScalar
    *  @tparam T Data type
@@ -336,11 +625,24 @@ class FK_EXPORTS NDArray {
   template<typename T, size_t NDIMS>
   typename NDATypes<T, NDIMS>::NDArray AsNDArray(void);
 
+  /**
+   *  @name   AsFixed
+   *  @tparam T     Data type
+   *  @tparam DIMS  Array dimensions known at compile time
+   *  @fn     FixedNDArrayMap<T, DIMS...> AsFixed(void)
+   *  @brief  Access the array's data with compile-time dimensions. The array
+   *          must be contiguous and its dimensions must match `DIMS`.
+   *  @return Array mapped with fixed dimensions
+   */
+  template<typename T, size_t... DIMS>
+  FixedNDArrayMap<T, DIMS...> AsFixed(void);
+
   /**
    *  @name   AsFlat
    *  @tparam T Data type
    *  @fn     typename NDATypes<T>::Flat AsFlat(void)
-   *  @brief  Access the array's data as a flatten array.
+   *  @brief  Access the array's data as a flatten array, array must be
+   *          contiguous.
    *  @return Array mapped as a flatten array
    */
   template<typename T>
@@ -391,11 +693,24 @@ class FK_EXPORTS NDArray {
   template<typename T, size_t NDIMS>
   typename NDATypes<T, NDIMS>::ConstNDArray AsNDArray(void) const;
 
+  /**
+   *  @name   AsFixed
+   *  @tparam T     Data type
+   *  @tparam DIMS  Array dimensions known at compile time
+   *  @fn     FixedNDArrayMap<const T, DIMS...> AsFixed(void) const
+   *  @brief  Access the array's data with compile-time dimensions. The array
+   *          must be contiguous and its dimensions must match `DIMS`.
+   *  @return Array mapped with fixed dimensions
+   */
+  template<typename T, size_t... DIMS>
+  FixedNDArrayMap<const T, DIMS...> AsFixed(void) const;
+
   /**
    *  @name   AsFlat
    *  @tparam T Data type
    *  @fn     typename NDATypes<T>::ConstFlat AsFlat(void) const
-   *  @brief  Access the array's data as a flatten array.
+   *  @brief  Access the array's data as a flatten array, array must be
+   *          contiguous.
    *  @return Array mapped as a flatten array
    */
   template<typename T>
@@ -444,6 +759,15 @@ class FK_EXPORTS NDArray {
     return dims_.dim_size(axis);
   }
 
+  /**
+   *  @name   strides
+   *  @fn     std::vector<size_t> strides(void) const
+   *  @brief  Distance in elements between two consecutive indices along each
+   *          axis
+   *  @return Axis strides
+   */
+  std::vector<size_t> strides(void) const;
+
   /**
    *  @name   n_elems
    *  @fn     size_t n_elems(void) const
@@ -469,12 +793,68 @@ class FK_EXPORTS NDArray {
   template<typename T>
   T* Base(void) const;
 
+  /**
+   *  @name   MakeUnique
+   *  @fn     void MakeUnique(void)
+   *  @brief  Ensure this array is the only owner of its buffer before
+   *          writing into it, clone the data if it is shared (copy-on-write).
+   */
+  void MakeUnique(void);
+
+  /**
+   *  @name   Detach
+   *  @fn     void Detach(void)
+   *  @brief  Replace the buffer with a private contiguous copy
+   */
+  void Detach(void);
+
+  /**
+   *  @name   MakeView
+   *  @fn     NDArray MakeView(const NDArrayDims& dims,
+                               const std::vector<size_t>& strides,
+                               const size_t& offset) const
+   *  @brief  Create a view sharing this array's buffer
+   *  @param[in] dims     View dimensions
+   *  @param[in] strides  View strides, in elements
+   *  @param[in] offset   Position of the first element of the view
+   *  @return View
+   */
+  NDArray MakeView(const NDArrayDims& dims,
+                   const std::vector<size_t>& strides,
+                   const size_t& offset) const;
+
+  /** Write `n` bytes somewhere, return false on error */
+  using ByteSink = std::function<bool(const char*, const size_t&)>;
+  /** Read exactly `n` bytes from somewhere, return false on error */
+  using ByteSource = std::function<bool(char*, const size_t&)>;
+
+  /**
+   *  @name   WriteStream
+   *  @fn     Status WriteStream(const ByteSink& sink) const
+   *  @brief  Serialize the array into a sink, see `Write(std::ostream&)`
+   *  @param[in] sink Where to write bytes
+   *  @return Operation status
+   */
+  Status WriteStream(const ByteSink& sink) const;
+
+  /**
+   *  @name   ReadStream
+   *  @fn     Status ReadStream(const ByteSource& source, Allocator* allocator)
+   *  @brief  Fill this array from a source, see `Read(std::istream&)`
+   *  @param[in] source     Where to read bytes from
+   *  @param[in] allocator  Memory allocator to use
+   *  @return Operation status
+   */
+  Status ReadStream(const ByteSource& source, Allocator* allocator);
+
   /** Buffer*/
-  NDArrayBuffer* buffer_;
+  RefPtr<NDArrayBuffer> buffer_;
   /** Allocator */
   Allocator* allocator_;
   /** Dimensions */
   NDArrayDims dims_;
+  /** Strides of a non-contiguous view, empty when contiguous */
+  std::vector<size_t> strides_;
   /** Data type */
   DataType type_;
 };
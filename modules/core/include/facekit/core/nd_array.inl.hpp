@@ -126,10 +126,8 @@ struct Initializer<std::string> {
 inline NDArray::NDArray(const NDArray& other) : buffer_(other.buffer_),
 allocator_(other.allocator_),
 dims_(other.dims_),
+strides_(other.strides_),
 type_(other.type_) {
-  if(buffer_) {
-    buffer_->Inc(); // Buffer increase ref counter
-  }
 }
 
 /*
@@ -138,11 +136,11 @@ type_(other.type_) {
  *  @brief  Move constructor
  *  @param[in] other  Object to move from
  */
-inline NDArray::NDArray(NDArray&& other) : buffer_(other.buffer_),
+inline NDArray::NDArray(NDArray&& other) : buffer_(std::move(other.buffer_)),
 allocator_(other.allocator_),
 dims_(std::move(other.dims_)),
+strides_(std::move(other.strides_)),
 type_(other.type_) {
-  other.buffer_ = nullptr;
 }
 
 /*
@@ -156,17 +154,9 @@ inline NDArray& NDArray::operator=(const NDArray& rhs) {
   if (this != &rhs) {
     type_ = rhs.type_;
     dims_ = rhs.dims_;
-    if (buffer_ != rhs.buffer_) {
-      // Is a buffer attach to this ? If yes decrease ref counter
-      if(buffer_) {
-        buffer_->Dec();
-      }
-      // Define new buffer from other
-      buffer_ = rhs.buffer_;
-      if (buffer_) {
-        buffer_->Inc(); // Increase ref counter
-      }
-    }
+    strides_ = rhs.strides_;
+    // Share buffer, counter untouched if already the same
+    buffer_ = rhs.buffer_;
     // Take allocator has well
     allocator_ = rhs.allocator_;
   }
@@ -184,13 +174,9 @@ inline NDArray& NDArray::operator=(NDArray&& rhs) {
   if(this != &rhs) {
     type_ = rhs.type_;
     dims_ = std::move(rhs.dims_);
-    // Is a buffer attach to this ? If yes decrease ref counter
-    if(buffer_) {
-      buffer_->Dec();
-    }
-    // Define new buffer from other, take ownership
-    buffer_ = rhs.buffer_;
-    rhs.buffer_ = nullptr;
+    strides_ = std::move(rhs.strides_);
+    // Take ownership of other's buffer, release ours
+    buffer_ = std::move(rhs.buffer_);
     // Take allocator has well
     allocator_ = rhs.allocator_;
     rhs.allocator_ = nullptr;
@@ -261,7 +247,8 @@ inline NDArray NDArray::WithValues(const std::vector<T>& values,
 template<typename T>
 typename NDATypes<T>::Scalar NDArray::AsScalar(void) {
   assert(dims() == 0);
-  return typename NDATypes<T>::Scalar(dims_, Base<T>());
+  this->MakeUnique();
+  return typename NDATypes<T>::Scalar(dims_, strides_, Base<T>());
 }
 
 /*
@@ -275,7 +262,8 @@ typename NDATypes<T>::Scalar NDArray::AsScalar(void) {
 template<typename T>
 typename NDATypes<T>::Vector NDArray::AsVector(void) {
   assert(dims() == 1);
-  return typename NDATypes<T>::Vector(dims_, Base<T>());
+  this->MakeUnique();
+  return typename NDATypes<T>::Vector(dims_, strides_, Base<T>());
 }
 
 /*
@@ -289,7 +277,8 @@ typename NDATypes<T>::Vector NDArray::AsVector(void) {
 template<typename T>
 typename NDATypes<T>::Matrix NDArray::AsMatrix(void) {
   assert(dims() == 2);
-  return typename NDATypes<T>::Matrix(dims_, Base<T>());
+  this->MakeUnique();
+  return typename NDATypes<T>::Matrix(dims_, strides_, Base<T>());
 }
 
 /*
@@ -304,7 +293,29 @@ typename NDATypes<T>::Matrix NDArray::AsMatrix(void) {
 template<typename T, size_t NDIMS>
 typename NDATypes<T, NDIMS>::NDArray NDArray::AsNDArray(void) {
   assert(dims() > 2);
-  return typename NDATypes<T, NDIMS>::NDArray(dims_, Base<T>());
+  this->MakeUnique();
+  return typename NDATypes<T, NDIMS>::NDArray(dims_, strides_, Base<T>());
+}
+
+/*
+ *  @name   AsFixed
+ *  @tparam T     Data type
+ *  @tparam DIMS  Array dimensions known at compile time
+ *  @fn     FixedNDArrayMap<T, DIMS...> AsFixed(void)
+ *  @brief  Access the array's data with compile-time dimensions. The array
+ *          must be contiguous and its dimensions must match `DIMS`.
+ *  @return Array mapped with fixed dimensions
+ */
+template<typename T, size_t... DIMS>
+FixedNDArrayMap<T, DIMS...> NDArray::AsFixed(void) {
+  assert(IsContiguous() && dims() == sizeof...(DIMS));
+#ifndef NDEBUG
+  for (size_t i = 0; i < sizeof...(DIMS); ++i) {
+    assert(dim_size(i) == internal::FixedShape<DIMS...>::Dim(i));
+  }
+#endif
+  this->MakeUnique();
+  return FixedNDArrayMap<T, DIMS...>(Base<T>());
 }
 
 /*
@@ -316,6 +327,8 @@ typename NDATypes<T, NDIMS>::NDArray NDArray::AsNDArray(void) {
  */
 template<typename T>
 typename NDATypes<T>::Flat NDArray::AsFlat(void) {
+  assert(IsContiguous());
+  this->MakeUnique();
   return typename NDATypes<T>::Flat(Base<T>(), dims_.n_elems());
 }
 
@@ -330,7 +343,7 @@ typename NDATypes<T>::Flat NDArray::AsFlat(void) {
 template<typename T>
 typename NDATypes<T>::ConstScalar NDArray::AsScalar(void) const {
   assert(dims() == 0);
-  return typename NDATypes<T>::ConstScalar(dims_, Base<const T>());
+  return typename NDATypes<T>::ConstScalar(dims_, strides_, Base<const T>());
 
 }
 
@@ -345,7 +358,7 @@ typename NDATypes<T>::ConstScalar NDArray::AsScalar(void) const {
 template<typename T>
 typename NDATypes<T>::ConstVector NDArray::AsVector(void) const {
   assert(dims() == 1);
-  return typename NDATypes<T>::ConstVector(dims_, Base<const T>());
+  return typename NDATypes<T>::ConstVector(dims_, strides_, Base<const T>());
 }
 
 /*
@@ -359,7 +372,7 @@ typename NDATypes<T>::ConstVector NDArray::AsVector(void) const {
 template<typename T>
 typename NDATypes<T>::ConstMatrix NDArray::AsMatrix(void) const {
   assert(dims() == 2);
-  return typename NDATypes<T>::ConstMatrix(dims_, Base<const T>());
+  return typename NDATypes<T>::ConstMatrix(dims_, strides_, Base<const T>());
 }
 
 /*
@@ -374,7 +387,27 @@ typename NDATypes<T>::ConstMatrix NDArray::AsMatrix(void) const {
 template<typename T, size_t NDIMS>
 typename NDATypes<T, NDIMS>::ConstNDArray NDArray::AsNDArray(void) const {
   assert(dims() > 2);
-  return typename NDATypes<T, NDIMS>::ConstNDArray(dims_, Base<const T>());
+  return typename NDATypes<T, NDIMS>::ConstNDArray(dims_, strides_, Base<const T>());
+}
+
+/*
+ *  @name   AsFixed
+ *  @tparam T     Data type
+ *  @tparam DIMS  Array dimensions known at compile time
+ *  @fn     FixedNDArrayMap<const T, DIMS...> AsFixed(void) const
+ *  @brief  Access the array's data with compile-time dimensions. The array
+ *          must be contiguous and its dimensions must match `DIMS`.
+ *  @return Array mapped with fixed dimensions
+ */
+template<typename T, size_t... DIMS>
+FixedNDArrayMap<const T, DIMS...> NDArray::AsFixed(void) const {
+  assert(IsContiguous() && dims() == sizeof...(DIMS));
+#ifndef NDEBUG
+  for (size_t i = 0; i < sizeof...(DIMS); ++i) {
+    assert(dim_size(i) == internal::FixedShape<DIMS...>::Dim(i));
+  }
+#endif
+  return FixedNDArrayMap<const T, DIMS...>(Base<const T>());
 }
 
 /*
@@ -386,6 +419,7 @@ typename NDATypes<T, NDIMS>::ConstNDArray NDArray::AsNDArray(void) const {
  */
 template<typename T>
 typename NDATypes<T>::ConstFlat NDArray::AsFlat(void) const {
+  assert(IsContiguous());
   return typename NDATypes<T>::ConstFlat(Base<const T>(), dims_.n_elems());
 }
 
@@ -404,4 +438,16 @@ inline T* NDArray::Base(void) const {
   return buffer_ == nullptr ? nullptr : buffer_->base<T>();
 }
 
+/*
+ *  @name   MakeUnique
+ *  @fn     void MakeUnique(void)
+ *  @brief  Ensure this array is the only owner of its buffer before
+ *          writing into it, clone the data if it is shared (copy-on-write).
+ */
+inline void NDArray::MakeUnique(void) {
+  if (buffer_ != nullptr && buffer_->IsShared()) {
+    this->Detach();
+  }
+}
+
 #endif  // __FACEKIT_ND_ARRAY_INL__
@@ -13,6 +13,7 @@
 
 #include <initializer_list>
 #include <array>
+#include <limits>
 #include <vector>
 
 #include "facekit/core/library_export.hpp"
@@ -29,7 +30,9 @@ class NDArrayDimsProto;
   
 /**
  *  @class  NDArrayDims
- *  @brief  Dimensions representation for NDArray
+ *  @brief  Dimensions representation for NDArray. Up to `kMaxDim` axes are
+ *          stored inline together with the number of elements, therefore
+ *          creating / copying dimensions never allocates.
  *  @author Christophe Ecabert
  *  @date   14.02.18
  *  @ingroup core
@@ -160,7 +163,7 @@ class FK_EXPORTS NDArrayDims {
   /**
    *  @name   dims
    *  @fn     size_t dims(void) const
-   *  @brief  Number of dimension in the array. 0 <= dims() < kMaxDim
+   *  @brief  Number of dimension in the array. 0 <= dims() <= kMaxDim
    *  @return Number of dimensions
    */
   size_t dims(void) const {
@@ -193,7 +196,7 @@ class FK_EXPORTS NDArrayDims {
    *  @return List of dimensions
    */
   std::vector<size_t> dim_sizes(void) const {
-    return std::vector<size_t>(dims_.begin(), dims_.begin() + kMaxDim);
+    return std::vector<size_t>(dims_.begin(), dims_.begin() + dims());
   }
   
   /**
@@ -205,6 +208,36 @@ class FK_EXPORTS NDArrayDims {
   size_t n_elems(void) const {
     return n_elem_;
   }
+
+  /**
+   *  @name   operator==
+   *  @fn     bool operator==(const NDArrayDims& rhs) const
+   *  @brief  Check if two dimensions have the same rank and axes
+   *  @param[in] rhs Dimensions to compare with
+   *  @return True if identical
+   */
+  bool operator==(const NDArrayDims& rhs) const {
+    if (dims() != rhs.dims() || n_elem_ != rhs.n_elem_) {
+      return false;
+    }
+    for (size_t i = 0; i < dims(); ++i) {
+      if (dims_[i] != rhs.dims_[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   *  @name   operator!=
+   *  @fn     bool operator!=(const NDArrayDims& rhs) const
+   *  @brief  Check if two dimensions are different
+   *  @param[in] rhs Dimensions to compare with
+   *  @return True if different
+   */
+  bool operator!=(const NDArrayDims& rhs) const {
+    return !(*this == rhs);
+  }
   
 #pragma mark -
 #pragma mark Private
@@ -218,9 +251,9 @@ class FK_EXPORTS NDArrayDims {
   void ComputeNElement(void);
   
   /** Maximum number of dimensions */
-  static constexpr size_t kMaxDim = 4;
-  /** Actual dimensions */
-  std::array<size_t, 5> dims_;
+  static constexpr size_t kMaxDim = 6;
+  /** Actual dimensions, last entry holds the rank */
+  std::array<size_t, kMaxDim + 1> dims_;
   /** Number of element in the array */
   size_t n_elem_;
 };
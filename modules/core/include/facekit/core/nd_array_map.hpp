@@ -11,8 +11,10 @@
 #ifndef __FACEKIT_ND_ARRAY_MAP__
 #define __FACEKIT_ND_ARRAY_MAP__
 
+#include <cassert>
 #include <cstdlib>
 #include <array>
+#include <vector>
 #include <initializer_list>
 #include <type_traits>
 
@@ -57,6 +59,31 @@ class FK_EXPORTS NDArrayMap {
     ComputeSteps();
   }
   
+  /**
+   *  @name   NDArrayMap
+   *  @fn     NDArrayMap(const NDArrayDims& dims,
+                         const std::vector<size_t>& strides, T* ptr)
+   *  @brief  Constructor for strided (non-contiguous) buffer
+   *  @param[in] dims     NDArray dimensions descriptor
+   *  @param[in] strides  Distance in elements between two consecutive
+   *                      indices along each axis, empty for contiguous
+   *                      row-major layout
+   *  @param[in] ptr      Pointer to the raw buffer to map
+   */
+  NDArrayMap(const NDArrayDims& dims,
+             const std::vector<size_t>& strides,
+             T* ptr) : n_dims_(NDIMS), n_elem_(1), data_(ptr) {
+    assert(dims.dims() == n_dims_);
+    assert(strides.empty() || strides.size() == n_dims_);
+    for (size_t i = 0; i < dims.dims(); ++i) {
+      dims_[i] = dims.dim_size(i);
+    }
+    ComputeSteps();
+    for (size_t i = 0; i < strides.size(); ++i) {
+      steps_[i] = strides[i];
+    }
+  }
+
   /**
    *  @name   NDArrayMap
    *  @fn     NDArrayMap(T* ptr, Dims&&... dims)
@@ -101,6 +128,62 @@ class FK_EXPORTS NDArrayMap {
    */
   template<typename... Indexes>
   T& operator()(const size_t& index, const Indexes... indexes);
+
+  /**
+   *  @name   ptr
+   *  @fn     T* ptr(void) const
+   *  @brief  Pointer to the first element
+   *  @return Mapped pointer
+   */
+  T* ptr(void) const {
+    return data_;
+  }
+
+  /**
+   *  @name   ptr
+   *  @fn     T* ptr(const size_t& index, const Indexes... indexes) const
+   *  @brief  Pointer to the first element of the sub-array selected by the
+   *          leading indices i,j,... (i.e. `ptr(i)` on a matrix is row `i`)
+   *  @param[in] index  First index i (head)
+   *  @param[in] indexes List of remaining leading indexes j,... (tail)
+   *  @return Pointer to the sub-array
+   */
+  template<typename... Indexes>
+  T* ptr(const size_t& index, const Indexes... indexes) const {
+    static_assert(sizeof...(indexes) < NDIMS,
+                  "Too many indices to select a sub-array");
+    return data_ + FlatIndex(0, index, indexes...);
+  }
+
+  /**
+   *  @name   row
+   *  @fn     T* row(const Indexes... indexes) const
+   *  @brief  Pointer to the innermost line selected by the `NDIMS - 1`
+   *          leading indices, contiguous if `stride(NDIMS - 1) == 1`
+   *  @param[in] indexes  Leading indices
+   *  @return Pointer to the line
+   */
+  template<typename... Indexes>
+  T* row(const Indexes... indexes) const {
+    static_assert(sizeof...(indexes) + 1 == NDIMS,
+                  "Row requires rank - 1 indices");
+    return ptr(indexes...);
+  }
+
+  /**
+   *  @name   plane
+   *  @fn     T* plane(const Indexes... indexes) const
+   *  @brief  Pointer to the plane formed by the last two axes, selected by
+   *          the `NDIMS - 2` leading indices
+   *  @param[in] indexes  Leading indices
+   *  @return Pointer to the plane
+   */
+  template<typename... Indexes>
+  T* plane(const Indexes... indexes) const {
+    static_assert(sizeof...(indexes) + 2 == NDIMS,
+                  "Plane requires rank - 2 indices");
+    return ptr(indexes...);
+  }
   
 #pragma mark -
 #pragma mark Accessors
@@ -125,6 +208,34 @@ class FK_EXPORTS NDArrayMap {
     return dims_[axis];
   }
   
+  /**
+   *  @name   stride
+   *  @fn     size_t stride(const size_t& axis) const
+   *  @brief  Distance in elements between two consecutive indices along a
+   *          given `axis`
+   *  @return Axis stride
+   */
+  size_t stride(const size_t& axis) const {
+    return steps_[axis];
+  }
+
+  /**
+   *  @name   is_contiguous
+   *  @fn     bool is_contiguous(void) const
+   *  @brief  Indicate if mapped elements are contiguous in row-major order
+   *  @return True if contiguous
+   */
+  bool is_contiguous(void) const {
+    size_t n = 1;
+    for (size_t i = NDIMS; i > 0; --i) {
+      if (dims_[i - 1] != 1 && steps_[i - 1] != n) {
+        return false;
+      }
+      n *= dims_[i - 1];
+    }
+    return true;
+  }
+
   /**
    *  @name   size
    *  @fn     size_t size(void) const
@@ -298,5 +409,229 @@ inline T& NDArrayMap<T, NDIMS>::operator()(const size_t& index,
   return data_[idx];
 }
 
+#pragma mark -
+#pragma mark Fixed dimensions
+
+namespace internal {
+
+/**
+ *  @struct  FixedSize
+ *  @brief  Number of elements of a compile-time shape
+ *  @tparam DIMS  Dimensions
+ */
+template<size_t... DIMS>
+struct FixedSize;
+
+template<>
+struct FixedSize<> {
+  static constexpr size_t value = 1;
+};
+
+template<size_t D, size_t... DIMS>
+struct FixedSize<D, DIMS...> {
+  static constexpr size_t value = D * FixedSize<DIMS...>::value;
+};
+
+/**
+ *  @struct  FixedShape
+ *  @brief  Constexpr dimensions, strides and flat index of a compile-time
+ *          row-major shape
+ *  @tparam DIMS  Dimensions
+ */
+template<size_t... DIMS>
+struct FixedShape;
+
+template<>
+struct FixedShape<> {
+  static constexpr size_t Index(void) {
+    return 0;
+  }
+  static constexpr size_t Dim(const size_t&) {
+    return 0;
+  }
+  static constexpr size_t Stride(const size_t&) {
+    return 0;
+  }
+};
+
+template<size_t D, size_t... DIMS>
+struct FixedShape<D, DIMS...> {
+  /** Stride of this axis */
+  static constexpr size_t kStride = FixedSize<DIMS...>::value;
+
+  /** No more indices, remaining axes start at 0 */
+  static constexpr size_t Index(void) {
+    return 0;
+  }
+
+  /** Flat index of the leading indices, folds to a multiply-add chain */
+  template<typename... Indexes>
+  static constexpr size_t Index(const size_t& index,
+                                const Indexes... indexes) {
+    return (assert(index < D), index * kStride) +
+           FixedShape<DIMS...>::Index(indexes...);
+  }
+
+  /** Dimension of a given axis */
+  static constexpr size_t Dim(const size_t& axis) {
+    return axis == 0 ? D : FixedShape<DIMS...>::Dim(axis - 1);
+  }
+
+  /** Stride of a given axis */
+  static constexpr size_t Stride(const size_t& axis) {
+    return axis == 0 ? kStride : FixedShape<DIMS...>::Stride(axis - 1);
+  }
+};
+
+}  // namespace internal
+
+/**
+ *  @class  FixedNDArrayMap
+ *  @brief  Raw buffer interface with dimensions known at compile time, i.e.
+ *          `FixedNDArrayMap<float, 3, 480, 640>`. Strides are constexpr and
+ *          element access folds to a single multiply-add chain. Only
+ *          contiguous row-major buffers can be mapped.
+ *  @author Christophe Ecabert
+ *  @date   07.03.18
+ *  @tparam T     Data type
+ *  @tparam DIMS  Dimensions of each axis
+ *  @ingroup core
+ */
+template<typename T, size_t... DIMS>
+class FK_EXPORTS FixedNDArrayMap {
+ public:
+  /** Rank */
+  static constexpr size_t kRank = sizeof...(DIMS);
+  /** Number of elements */
+  static constexpr size_t kSize = internal::FixedSize<DIMS...>::value;
+
+  /**
+   *  @name   FixedNDArrayMap
+   *  @fn     explicit FixedNDArrayMap(T* ptr)
+   *  @brief  Constructor
+   *  @param[in] ptr  Pointer to the raw buffer to map
+   */
+  explicit FixedNDArrayMap(T* ptr) : data_(ptr) {}
+
+  /**
+   *  @name   operator()
+   *  @fn     T& operator()(const Indexes... indexes) const
+   *  @brief  Access element at position indexed: i,j,k,...
+   *  @param[in] indexes  One index per axis
+   *  @return Value stored at the given position
+   */
+  template<typename... Indexes>
+  T& operator()(const Indexes... indexes) const {
+    static_assert(sizeof...(indexes) == kRank,
+                  "Number of indices used to access a NDArray coefficient must"
+                  " be equal to the rank of the NDArray.");
+    return data_[internal::FixedShape<DIMS...>::Index(indexes...)];
+  }
+
+  /**
+   *  @name   ptr
+   *  @fn     T* ptr(const Indexes... indexes) const
+   *  @brief  Pointer to the first element of the sub-array selected by the
+   *          leading indices
+   *  @param[in] indexes  Leading indices
+   *  @return Pointer to the sub-array
+   */
+  template<typename... Indexes>
+  T* ptr(const Indexes... indexes) const {
+    static_assert(sizeof...(indexes) <= kRank,
+                  "Too many indices to select a sub-array");
+    return data_ + internal::FixedShape<DIMS...>::Index(indexes...);
+  }
+
+  /**
+   *  @name   row
+   *  @fn     T* row(const Indexes... indexes) const
+   *  @brief  Pointer to the innermost line selected by the `rank - 1`
+   *          leading indices
+   *  @param[in] indexes  Leading indices
+   *  @return Pointer to the line
+   */
+  template<typename... Indexes>
+  T* row(const Indexes... indexes) const {
+    static_assert(sizeof...(indexes) + 1 == kRank,
+                  "Row requires rank - 1 indices");
+    return ptr(indexes...);
+  }
+
+  /**
+   *  @name   plane
+   *  @fn     T* plane(const Indexes... indexes) const
+   *  @brief  Pointer to the plane formed by the last two axes
+   *  @param[in] indexes  Leading indices
+   *  @return Pointer to the plane
+   */
+  template<typename... Indexes>
+  T* plane(const Indexes... indexes) const {
+    static_assert(sizeof...(indexes) + 2 == kRank,
+                  "Plane requires rank - 2 indices");
+    return ptr(indexes...);
+  }
+
+  /**
+   *  @name   rank
+   *  @fn     static constexpr size_t rank(void)
+   *  @brief  Give mapped array rank
+   *  @return NDArray's rank
+   */
+  static constexpr size_t rank(void) {
+    return kRank;
+  }
+
+  /**
+   *  @name   dim_size
+   *  @fn     static constexpr size_t dim_size(const size_t& axis)
+   *  @brief  Dimension for a given `axis`
+   *  @return Axis dimension
+   */
+  static constexpr size_t dim_size(const size_t& axis) {
+    return internal::FixedShape<DIMS...>::Dim(axis);
+  }
+
+  /**
+   *  @name   stride
+   *  @fn     static constexpr size_t stride(const size_t& axis)
+   *  @brief  Distance in elements between two consecutive indices along a
+   *          given `axis`
+   *  @return Axis stride
+   */
+  static constexpr size_t stride(const size_t& axis) {
+    return internal::FixedShape<DIMS...>::Stride(axis);
+  }
+
+  /**
+   *  @name   size
+   *  @fn     static constexpr size_t size(void)
+   *  @brief  Give NDArray total size/elements
+   *  @return Total number of element in the mapped buffer
+   */
+  static constexpr size_t size(void) {
+    return kSize;
+  }
+
+  /**
+   *  @name   data
+   *  @fn     T* data(void) const
+   *  @brief  Access to the mapped raw buffer
+   *  @return Mapped pointer
+   */
+  T* data(void) const {
+    return data_;
+  }
+
+ private:
+  /** Reference to buffer */
+  T* data_;
+};
+
+template<typename T, size_t... DIMS>
+constexpr size_t FixedNDArrayMap<T, DIMS...>::kRank;
+template<typename T, size_t... DIMS>
+constexpr size_t FixedNDArrayMap<T, DIMS...>::kSize;
+
 }  // namespace FaceKit
 #endif /* __FACEKIT_ND_ARRAY_MAP__ */
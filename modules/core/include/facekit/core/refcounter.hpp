@@ -13,6 +13,9 @@
 
 #include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
 
 #include "facekit/core/library_export.hpp"
 
@@ -78,6 +81,14 @@ class FK_EXPORTS RefCounter {
    */
   bool IsOne(void) const;
   
+  /**
+   *  @name   Count
+   *  @fn     std::int_fast32_t Count(void) const
+   *  @brief  Current value of the reference counter
+   *  @return Number of references
+   */
+  std::int_fast32_t Count(void) const;
+  
  protected:
   
   /**
@@ -111,7 +122,7 @@ inline RefCounter::RefCounter(void) : cnt_(1) {}
  *          instantiated (only subclass can)
  */
 inline RefCounter::~RefCounter(void) {
-  assert(cnt_.load() == 0); 
+  assert(cnt_.load(std::memory_order_relaxed) == 0);
 }
 
 /*
@@ -120,7 +131,8 @@ inline RefCounter::~RefCounter(void) {
  *  @brief  Increment reference counter by 1
  */
 inline void RefCounter::Inc(void) {
-  assert(cnt_.load() >= 1);
+  assert(cnt_.load(std::memory_order_relaxed) >= 1);
+  // New references are always made from an existing one, no ordering needed
   cnt_.fetch_add(1, std::memory_order_relaxed);
 }
 
@@ -131,9 +143,12 @@ inline void RefCounter::Inc(void) {
  *  @return True if reached 0 (call destructor), False otherwise
  */
 inline bool RefCounter::Dec(void) {
-  assert(cnt_.load() > 0);
-  if (this->IsOne() || cnt_.fetch_sub(1) == 1) {
-    cnt_.store(0);
+  assert(cnt_.load(std::memory_order_relaxed) > 0);
+  // Sole owner skips the read-modify-write. Otherwise release our writes to
+  // the object and acquire the other owners' ones before destroying it.
+  if (this->IsOne() || cnt_.fetch_sub(1, std::memory_order_release) == 1) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    cnt_.store(0, std::memory_order_relaxed);
     delete this;
     return true;
   } else {
@@ -152,5 +167,275 @@ inline bool RefCounter::IsOne(void) const {
   return cnt_.load(std::memory_order_acquire) == 1;
 }
 
+/*
+ *  @name   Count
+ *  @fn     std::int_fast32_t Count(void) const
+ *  @brief  Current value of the reference counter
+ *  @return Number of references
+ */
+inline std::int_fast32_t RefCounter::Count(void) const {
+  return cnt_.load(std::memory_order_acquire);
+}
+
+/**
+ *  @class  RefPtr
+ *  @brief  Intrusive smart pointer over a `RefCounter`. Copies add a reference,
+ *          moves transfer it without touching the counter and destruction
+ *          releases it.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup core
+ *  @tparam T Object type, subclass of `RefCounter`
+ */
+template<typename T>
+class RefPtr {
+ public:
+
+  /**
+   *  @name   RefPtr
+   *  @fn     RefPtr(void) noexcept
+   *  @brief  Constructor, empty
+   */
+  RefPtr(void) noexcept : ptr_(nullptr) {}
+
+  /**
+   *  @name   RefPtr
+   *  @fn     RefPtr(std::nullptr_t) noexcept
+   *  @brief  Constructor, empty
+   */
+  RefPtr(std::nullptr_t) noexcept : ptr_(nullptr) {}
+
+  /**
+   *  @name   RefPtr
+   *  @fn     explicit RefPtr(T* ptr) noexcept
+   *  @brief  Constructor, adopt the reference owned by the caller (i.e. the
+   *          one of a newly created object). See `Share` to add one.
+   *  @param[in] ptr  Object to take ownership of, can be nullptr
+   */
+  explicit RefPtr(T* ptr) noexcept : ptr_(ptr) {}
+
+  /**
+   *  @name   RefPtr
+   *  @fn     RefPtr(const RefPtr& other) noexcept
+   *  @brief  Copy constructor, add a reference
+   *  @param[in] other  Object to copy from
+   */
+  RefPtr(const RefPtr& other) noexcept : ptr_(other.ptr_) {
+    if (ptr_) {
+      ptr_->Inc();
+    }
+  }
+
+  /**
+   *  @name   RefPtr
+   *  @fn     RefPtr(const RefPtr<U>& other) noexcept
+   *  @brief  Converting copy constructor, add a reference
+   *  @param[in] other  Object to copy from
+   *  @tparam U Type convertible to T
+   */
+  template<typename U>
+  RefPtr(const RefPtr<U>& other) noexcept : ptr_(other.get()) {
+    if (ptr_) {
+      ptr_->Inc();
+    }
+  }
+
+  /**
+   *  @name   RefPtr
+   *  @fn     RefPtr(RefPtr&& other) noexcept
+   *  @brief  Move constructor, steal the reference
+   *  @param[in] other  Object to move from, empty afterward
+   */
+  RefPtr(RefPtr&& other) noexcept : ptr_(other.release()) {}
+
+  /**
+   *  @name   RefPtr
+   *  @fn     RefPtr(RefPtr<U>&& other) noexcept
+   *  @brief  Converting move constructor, steal the reference
+   *  @param[in] other  Object to move from, empty afterward
+   *  @tparam U Type convertible to T
+   */
+  template<typename U>
+  RefPtr(RefPtr<U>&& other) noexcept : ptr_(other.release()) {}
+
+  /**
+   *  @name   operator=
+   *  @fn     RefPtr& operator=(const RefPtr& rhs) noexcept
+   *  @brief  Copy assignment, does not touch the counter if both point to the
+   *          same object
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  RefPtr& operator=(const RefPtr& rhs) noexcept {
+    if (ptr_ != rhs.ptr_) {
+      RefPtr(rhs).swap(*this);
+    }
+    return *this;
+  }
+
+  /**
+   *  @name   operator=
+   *  @fn     RefPtr& operator=(RefPtr&& rhs) noexcept
+   *  @brief  Move assignment, steal the reference
+   *  @param[in] rhs  Object to move from, empty afterward
+   *  @return Newly assigned object
+   */
+  RefPtr& operator=(RefPtr&& rhs) noexcept {
+    RefPtr(std::move(rhs)).swap(*this);
+    return *this;
+  }
+
+  /**
+   *  @name   operator=
+   *  @fn     RefPtr& operator=(std::nullptr_t) noexcept
+   *  @brief  Release the reference
+   *  @return Empty object
+   */
+  RefPtr& operator=(std::nullptr_t) noexcept {
+    this->reset();
+    return *this;
+  }
+
+  /**
+   *  @name   ~RefPtr
+   *  @fn     ~RefPtr(void)
+   *  @brief  Destructor, release the reference
+   */
+  ~RefPtr(void) {
+    if (ptr_) {
+      ptr_->Dec();
+    }
+  }
+
+  /**
+   *  @name   Share
+   *  @fn     static RefPtr Share(T* ptr) noexcept
+   *  @brief  Add a reference to an object owned somewhere else
+   *  @param[in] ptr  Object to share, can be nullptr
+   *  @return Smart pointer holding the new reference
+   */
+  static RefPtr Share(T* ptr) noexcept {
+    if (ptr) {
+      ptr->Inc();
+    }
+    return RefPtr(ptr);
+  }
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   reset
+   *  @fn     void reset(T* ptr = nullptr) noexcept
+   *  @brief  Release the current reference and adopt `ptr`'s one
+   *  @param[in] ptr  Object to take ownership of
+   */
+  void reset(T* ptr = nullptr) noexcept {
+    RefPtr(ptr).swap(*this);
+  }
+
+  /**
+   *  @name   release
+   *  @fn     T* release(void) noexcept
+   *  @brief  Give up the reference without releasing it, the caller becomes
+   *          responsible for calling `Dec`
+   *  @return Object
+   */
+  T* release(void) noexcept {
+    T* ptr = ptr_;
+    ptr_ = nullptr;
+    return ptr;
+  }
+
+  /**
+   *  @name   swap
+   *  @fn     void swap(RefPtr& other) noexcept
+   *  @brief  Exchange content with another pointer
+   *  @param[in,out] other  Pointer to swap with
+   */
+  void swap(RefPtr& other) noexcept {
+    std::swap(ptr_, other.ptr_);
+  }
+
+  /**
+   *  @name   get
+   *  @fn     T* get(void) const noexcept
+   *  @brief  Raw pointer
+   */
+  T* get(void) const noexcept {
+    return ptr_;
+  }
+
+  /**
+   *  @name   operator->
+   *  @fn     T* operator->(void) const noexcept
+   *  @brief  Member access
+   */
+  T* operator->(void) const noexcept {
+    return ptr_;
+  }
+
+  /**
+   *  @name   operator*
+   *  @fn     T& operator*(void) const noexcept
+   *  @brief  Dereference
+   */
+  T& operator*(void) const noexcept {
+    return *ptr_;
+  }
+
+  /**
+   *  @name   operator bool
+   *  @fn     explicit operator bool(void) const noexcept
+   *  @brief  Indicate if the pointer is not empty
+   */
+  explicit operator bool(void) const noexcept {
+    return ptr_ != nullptr;
+  }
+
+ private:
+  /** Object */
+  T* ptr_;
+};
+
+/** Equality */
+template<typename T, typename U>
+inline bool operator==(const RefPtr<T>& lhs, const RefPtr<U>& rhs) noexcept {
+  return lhs.get() == rhs.get();
+}
+
+/** Inequality */
+template<typename T, typename U>
+inline bool operator!=(const RefPtr<T>& lhs, const RefPtr<U>& rhs) noexcept {
+  return lhs.get() != rhs.get();
+}
+
+/** Equality with nullptr */
+template<typename T>
+inline bool operator==(const RefPtr<T>& lhs, std::nullptr_t) noexcept {
+  return lhs.get() == nullptr;
+}
+
+/** Inequality with nullptr */
+template<typename T>
+inline bool operator!=(const RefPtr<T>& lhs, std::nullptr_t) noexcept {
+  return lhs.get() != nullptr;
+}
+
+/**
+ *  @name   MakeRef
+ *  @fn     RefPtr<T> MakeRef(Args&&... args)
+ *  @brief  Create a reference counted object
+ *  @param[in] args Constructor's arguments
+ *  @tparam T Object type
+ *  @tparam Args Constructor's arguments type
+ *  @return Smart pointer owning the only reference
+ *  @ingroup core
+ */
+template<typename T, typename... Args>
+inline RefPtr<T> MakeRef(Args&&... args) {
+  return RefPtr<T>(new T(std::forward<Args>(args)...));
+}
+
 }  // namespace FaceKit
 #endif /* __FACEKIT_REFCOUNTER__ */
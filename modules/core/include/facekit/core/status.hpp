@@ -14,6 +14,8 @@
 
 #include <string>
 #include <iostream>
+#include <memory>
+#include <utility>
 
 #include "facekit/core/library_export.hpp"
 
@@ -26,7 +28,9 @@ namespace FaceKit {
 /**
  *  @class  Status
  *  @brief  Indicator of success or failure of functions. Strip and adapted from
- *          Tensorflow
+ *          Tensorflow. A successful status holds no heap state, creating,
+ *          copying and checking it does not allocate. The error code and
+ *          message are allocated only on failure.
  *  @author Christophe Ecabert
  *  @date   20.02.18
  *  @ingroup core
@@ -77,24 +81,53 @@ class FK_EXPORTS Status {
    *  @param[in] other  Object to copy from
    */
   Status(const Status& other);
+
+  /**
+   *  @name   Status
+   *  @fn     Status(Status&& other) noexcept
+   *  @brief  Move Constructor
+   *  @param[in] other  Object to move from, left in success state
+   */
+  Status(Status&& other) noexcept = default;
   
   /**
    *  @name   Status
-   *  @fn     Status(const Type& type, const std::string& msg)
+   *  @fn     Status(const Type& type, std::string msg)
    *  @brief  Constructor
    *  @param[in] type Type of error/status
-   *  @param[in] msg  Message explaining what went wrong (error description)
+   *  @param[in] msg  Message explaining what went wrong (error description),
+   *                  moved into the error state
    */
-  Status(const Type& type, const std::string& msg);
+  Status(const Type& type, std::string msg);
+
+  /**
+   *  @name   OK
+   *  @fn     static Status OK(void)
+   *  @brief  Successful status, does not allocate
+   *  @return Status without error
+   */
+  static Status OK(void) {
+    return Status();
+  }
   
   /**
    *  @name   operator=
    *  @fn Status& operator=(const Status& other)
-   *  @brief  Assignment operator
+   *  @brief  Assignment operator, keeps the first error encountered: only a
+   *          successful status takes over an error
    *  @param[in] other  Object to assign from
    *  @return Newly assigned object
    */
   Status& operator=(const Status& other);
+
+  /**
+   *  @name   operator=
+   *  @fn Status& operator=(Status&& other) noexcept
+   *  @brief  Move assignment operator, same semantic as the copy
+   *  @param[in] other  Object to move from
+   *  @return Newly assigned object
+   */
+  Status& operator=(Status&& other) noexcept;
     
   /**
    *  @name   ~Status
@@ -146,27 +179,27 @@ class FK_EXPORTS Status {
    *  @return True if no error, false otherwise
    */
   bool Good(void) const {
-    return err_ == Type::kOk;
+    return state_ == nullptr;
   }
     
   /**
    *  @name   Code
-   *  @fn     const Type& Code(void) const
+   *  @fn     Type Code(void) const
    *  @brief  Provide error code
    *  @return Error code for this status
    */
-  const Type& Code(void) const {
-    return err_;
+  Type Code(void) const {
+    return state_ ? state_->code : Type::kOk;
   }
     
   /**
    *  @name   Message
    *  @fn     const std::string& Message(void) const
    *  @brief  Give messge associated with this Status.
-   *  @return Error description
+   *  @return Error description, empty on success
    */
   const std::string& Message(void) const {
-    return msg_;
+    return state_ ? state_->msg : EmptyMessage();
   }
     
   /**
@@ -181,11 +214,28 @@ class FK_EXPORTS Status {
   
 #pragma mark -
 #pragma mark Private
-  private:
+ private:
+
+  /**
+   *  @struct State
+   *  @brief  Error state, only allocated on failure
+   */
+  struct State {
     /** Error code */
-    Type err_;
+    Type code;
     /** Message description */
-    std::string msg_;
+    std::string msg;
+  };
+
+  /**
+   *  @name   EmptyMessage
+   *  @fn     static const std::string& EmptyMessage(void)
+   *  @brief  Message of successful status
+   */
+  static const std::string& EmptyMessage(void);
+
+  /** Error state, nullptr on success */
+  std::unique_ptr<State> state_;
 };
   
 #pragma mark -
@@ -196,7 +246,7 @@ class FK_EXPORTS Status {
  *  @fn     Status(void)
  *  @brief  Constructor
  */
-inline Status::Status(void) : err_(Type::kOk), msg_("") {}
+inline Status::Status(void) = default;
 
 /*
  *  @name   Status
@@ -204,8 +254,8 @@ inline Status::Status(void) : err_(Type::kOk), msg_("") {}
  *  @brief  Copy Constructor
  *  @param[in] other  Object to copy from
  */
-inline Status::Status(const Status& other) : err_(other.err_),
-                                             msg_(other.msg_) {}
+inline Status::Status(const Status& other) :
+        state_(other.state_ ? new State(*other.state_) : nullptr) {}
   
 /*
  *  @name   operator=
@@ -215,9 +265,22 @@ inline Status::Status(const Status& other) : err_(other.err_),
  *  @return Newly assigned object
  */
 inline Status& Status::operator=(const Status& other) {
-  if (this != &other && err_ != other.err_ && err_ == Type::kOk) {
-    err_ = other.err_;
-    msg_ = other.msg_;
+  if (state_ == nullptr && other.state_ != nullptr) {
+    state_.reset(new State(*other.state_));
+  }
+  return *this;
+}
+
+/*
+ *  @name   operator=
+ *  @fn Status& operator=(Status&& other) noexcept
+ *  @brief  Move assignment operator, same semantic as the copy
+ *  @param[in] other  Object to move from
+ *  @return Newly assigned object
+ */
+inline Status& Status::operator=(Status&& other) noexcept {
+  if (state_ == nullptr && other.state_ != nullptr) {
+    state_ = std::move(other.state_);
   }
   return *this;
 }
@@ -228,8 +291,7 @@ inline Status& Status::operator=(const Status& other) {
  *  @brief  Reset a status
  */
 inline void Status::Clear(void) {
-  err_ = Type::kOk;
-  msg_ = "";
+  state_.reset();
 }
   
 /*
@@ -240,7 +302,9 @@ inline void Status::Clear(void) {
  *  @return True if both object are equal, false otherwise
  */
 inline bool Status::operator==(const Status& rhs) const {
-  return err_ == rhs.err_ && msg_ == rhs.msg_;
+  return state_ == rhs.state_ ||
+         (state_ && rhs.state_ && state_->code == rhs.state_->code &&
+          state_->msg == rhs.state_->msg);
 }
 
 /*
@@ -0,0 +1,263 @@
+/**
+ *  @file   batch_file_reader.hpp
+ *  @brief Read a batch of whole files asynchronously. Uses io_uring on Linux
+ *         when available and falls back to the thread pool otherwise.
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   11.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_BATCH_FILE_READER__
+#define __FACEKIT_BATCH_FILE_READER__
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <iostream>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/core/nd_array.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Forward declaration */
+class Allocator;
+class ThreadPool;
+
+/**
+ *  @class  BatchFileReader
+ *  @brief  Load a list of files in memory, reads are overlapped and each
+ *          file is reported as soon as it completes. Content is stored in a
+ *          one dimensional `kUInt8` NDArray allocated with the reader's
+ *          allocator (pooled by default).
+ *  @author Christophe Ecabert
+ *  @date   11.10.18
+ *  @ingroup core
+ */
+class FK_EXPORTS BatchFileReader {
+ public:
+
+  /**
+   *  @enum   Backend
+   *  @brief  I/O backend
+   */
+  enum class Backend : char {
+    /** io_uring if supported by the kernel, thread pool otherwise */
+    kAuto,
+    /** Linux io_uring, falls back to `kThreadPool` if not available */
+    kIoUring,
+    /** Blocking positional reads dispatched on the thread pool */
+    kThreadPool
+  };
+
+  /**
+   *  @struct Options
+   *  @brief  Reader configuration
+   */
+  struct Options {
+    /** Requested backend */
+    Backend backend = Backend::kAuto;
+    /** Maximum number of files read at once */
+    size_t queue_depth = 32;
+    /** Allocator for the file content, nullptr use `pooled_cpu_allocator` */
+    Allocator* allocator = nullptr;
+    /** Pool used by the `kThreadPool` backend, nullptr use the global pool */
+    ThreadPool* pool = nullptr;
+  };
+
+  /**
+   *  @name   Callback
+   *  @brief  Invoked once per file with its position in the batch, the read
+   *          status and its content. Calls are serialized but may come from
+   *          any thread.
+   */
+  using Callback = std::function<void(const size_t& index,
+                                      const Status& status,
+                                      NDArray&& content)>;
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   BatchFileReader
+   *  @fn     BatchFileReader(void)
+   *  @brief  Constructor with default options
+   */
+  BatchFileReader(void);
+
+  /**
+   *  @name   BatchFileReader
+   *  @fn     explicit BatchFileReader(const Options& options)
+   *  @brief  Constructor
+   *  @param[in] options  Reader configuration
+   */
+  explicit BatchFileReader(const Options& options);
+
+  /**
+   *  @name   BatchFileReader
+   *  @fn     BatchFileReader(const BatchFileReader& other) = delete
+   *  @brief  Copy constructor
+   */
+  BatchFileReader(const BatchFileReader& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     BatchFileReader& operator=(const BatchFileReader& rhs) = delete
+   *  @brief  Assignment operator
+   */
+  BatchFileReader& operator=(const BatchFileReader& rhs) = delete;
+
+  /**
+   *  @name   ~BatchFileReader
+   *  @fn     ~BatchFileReader(void)
+   *  @brief  Destructor
+   */
+  ~BatchFileReader(void);
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   Read
+   *  @fn     Status Read(const std::vector<std::string>& paths,
+                          const Callback& callback)
+   *  @brief  Read every file in `paths`, `callback` is invoked as each read
+   *          completes. Returns once all files have been reported.
+   *  @param[in] paths    Files to read
+   *  @param[in] callback Completion callback
+   *  @return kGood if every file has been read, first error otherwise
+   */
+  Status Read(const std::vector<std::string>& paths, const Callback& callback);
+
+  /**
+   *  @name   Read
+   *  @fn     Status Read(const std::vector<std::string>& paths,
+                          std::vector<NDArray>* contents)
+   *  @brief  Read every file in `paths` and gather their content in order
+   *  @param[in] paths    Files to read
+   *  @param[out] contents  Content of each file
+   *  @return kGood if every file has been read, first error otherwise
+   */
+  Status Read(const std::vector<std::string>& paths,
+              std::vector<NDArray>* contents);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   backend
+   *  @fn     Backend backend(void) const
+   *  @brief  Backend actually in use
+   */
+  Backend backend(void) const {
+    return backend_;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** io_uring instance */
+  struct Ring;
+
+  /**
+   *  @name   ReadRing
+   *  @fn     Status ReadRing(const std::vector<std::string>& paths,
+                              const Callback& callback)
+   *  @brief  io_uring backend
+   */
+  Status ReadRing(const std::vector<std::string>& paths,
+                  const Callback& callback);
+
+  /**
+   *  @name   ReadPool
+   *  @fn     Status ReadPool(const std::vector<std::string>& paths,
+                              const Callback& callback)
+   *  @brief  Thread pool backend
+   */
+  Status ReadPool(const std::vector<std::string>& paths,
+                  const Callback& callback);
+
+  /** Configuration */
+  Options options_;
+  /** Backend in use */
+  Backend backend_;
+  /** Ring, nullptr when using the thread pool */
+  Ring* ring_;
+};
+
+/**
+ *  @class  MemoryStream
+ *  @brief  Read-only `std::istream` over the content of an NDArray, without
+ *          copy. Used to feed file content loaded by `BatchFileReader` into
+ *          stream based decoders (i.e. `Image::Load(std::istream&)`).
+ *  @author Christophe Ecabert
+ *  @date   11.10.18
+ *  @ingroup core
+ */
+class FK_EXPORTS MemoryStream : public std::istream {
+ private:
+
+  /**
+   *  @class  MemoryStreambuf
+   *  @brief  Stream buffer over a fixed memory block
+   */
+  class MemoryStreambuf : public std::basic_streambuf<char> {
+   public:
+
+    /**
+     *  @name   MemoryStreambuf
+     *  @fn     MemoryStreambuf(const char* data, const size_t& size)
+     *  @brief  Constructor
+     */
+    MemoryStreambuf(const char* data, const size_t& size);
+
+   protected:
+
+    /**
+     *  @name   seekoff
+     *  @brief  C.f. C++ standard section 27.6.3.4.2
+     */
+    pos_type seekoff(off_type off,
+                     std::ios_base::seekdir dir,
+                     std::ios_base::openmode which) override;
+
+    /**
+     *  @name   seekpos
+     *  @brief  C.f. C++ standard section 27.6.3.4.2
+     */
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+  };
+
+ public:
+
+  /**
+   *  @name   MemoryStream
+   *  @fn     explicit MemoryStream(const NDArray& content)
+   *  @brief  Constructor, keep a reference on `content` while alive
+   *  @param[in] content  Contiguous `kUInt8` array to stream
+   */
+  explicit MemoryStream(const NDArray& content);
+
+  /**
+   *  @name   ~MemoryStream
+   *  @fn     ~MemoryStream(void) override = default
+   *  @brief  Destructor
+   */
+  ~MemoryStream(void) override = default;
+
+ private:
+  /** Streamed array */
+  NDArray content_;
+  /** Stream buffer */
+  MemoryStreambuf buffer_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_BATCH_FILE_READER__ */
@@ -0,0 +1,239 @@
+/**
+ *  @file   cpu_info.hpp
+ *  @brief Runtime detection of the CPU instruction sets and kernel dispatch
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_CPU_INFO__
+#define __FACEKIT_CPU_INFO__
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/utils/enum_bitmask_operator.hpp"
+
+/**
+ *  @def  FK_TARGET
+ *  @brief  Compile a single function for a given instruction set (i.e.
+ *          `FK_TARGET("avx2,fma")`) without changing the flags of the whole
+ *          translation unit. Such function must only be called once
+ *          `CpuInfo` reports the matching features. Empty when the compiler
+ *          does not support it, `FK_HAS_TARGET` tells if it is available.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define FK_HAS_TARGET
+#define FK_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FK_TARGET(isa)
+#endif
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/**
+ *  @class  CpuInfo
+ *  @brief  Instruction sets supported by the CPU and the OS, detected once on
+ *          first use. Kernels compiled for several instruction sets (either
+ *          in separate translation units with their own flags or with
+ *          `FK_TARGET`) are picked once with `Select` and kept in a table.
+ *          The environment variable `FACEKIT_CPU_LEVEL` (scalar, sse4.2,
+ *          avx2, avx512) caps the detected level, i.e. to test fallbacks.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup core
+ */
+class FK_EXPORTS CpuInfo {
+ public:
+  
+#pragma mark -
+#pragma mark Type definition
+  
+  /**
+   *  @enum   Feature
+   *  @brief  Individual instruction set extensions
+   */
+  enum class Feature : uint32_t {
+    /** None */
+    kNone = 0,
+    /** x86 SSE2 */
+    kSse2 = 0x01,
+    /** x86 SSSE3 */
+    kSsse3 = 0x02,
+    /** x86 SSE4.1 */
+    kSse41 = 0x04,
+    /** x86 SSE4.2 */
+    kSse42 = 0x08,
+    /** x86 AVX */
+    kAvx = 0x10,
+    /** x86 AVX2 */
+    kAvx2 = 0x20,
+    /** x86 fused multiply-add */
+    kFma = 0x40,
+    /** x86 half precision conversions */
+    kF16c = 0x80,
+    /** x86 AVX-512 foundation */
+    kAvx512f = 0x100,
+    /** x86 AVX-512 byte and word */
+    kAvx512bw = 0x200,
+    /** x86 AVX-512 vector length */
+    kAvx512vl = 0x400,
+    /** ARM NEON */
+    kNeon = 0x800
+  };
+  
+  /**
+   *  @enum   Level
+   *  @brief  Group of features kernels are written for, ordered
+   */
+  enum class Level : char {
+    /** Plain C++ */
+    kScalar = 0,
+    /** ARM NEON */
+    kNeon,
+    /** x86 up to SSE4.2 */
+    kSse42,
+    /** x86 AVX2 + FMA + F16C */
+    kAvx2,
+    /** x86 AVX-512 F/BW/VL on top of AVX2 */
+    kAvx512
+  };
+  
+#pragma mark -
+#pragma mark Usage
+  
+  /**
+   *  @name   Get
+   *  @fn     static const CpuInfo& Get(void)
+   *  @brief  Features of the CPU this process runs on
+   *  @return CPU information
+   */
+  static const CpuInfo& Get(void);
+  
+  /**
+   *  @name   Has
+   *  @fn     bool Has(const Feature& features) const
+   *  @brief  Check if all the given features are supported
+   *  @param[in] features Features, combined with `|`
+   *  @return True if all are supported
+   */
+  bool Has(const Feature& features) const;
+  
+  /**
+   *  @name   Supports
+   *  @fn     bool Supports(const Level& level) const
+   *  @brief  Check if kernels written for a given level can run
+   *  @param[in] level  Level
+   *  @return True if supported
+   */
+  bool Supports(const Level& level) const;
+  
+  /**
+   *  @name   Select
+   *  @fn     template<typename Fn> Fn Select(const Fn& fallback,
+                  std::initializer_list<std::pair<Level, Fn>> candidates) const
+   *  @brief  Pick the candidate of the highest supported level
+   *  @param[in] fallback   Used when no candidate is supported
+   *  @param[in] candidates Implementations with their level, null ones are
+   *                        skipped (i.e. not part of the build)
+   *  @return Selected implementation
+   *  @tparam Fn Function pointer or kernel table type
+   */
+  template<typename Fn>
+  Fn Select(const Fn& fallback,
+            std::initializer_list<std::pair<Level, Fn>> candidates) const {
+    Fn fn = fallback;
+    Level best = Level::kScalar;
+    for (const auto& c : candidates) {
+      if (c.second && this->Supports(c.first) && c.first >= best) {
+        fn = c.second;
+        best = c.first;
+      }
+    }
+    return fn;
+  }
+  
+#pragma mark -
+#pragma mark Accessors
+  
+  /**
+   *  @name   features
+   *  @fn     const Feature& features(void) const
+   *  @brief  Supported features
+   */
+  const Feature& features(void) const {
+    return features_;
+  }
+  
+  /**
+   *  @name   level
+   *  @fn     const Level& level(void) const
+   *  @brief  Highest supported level
+   */
+  const Level& level(void) const {
+    return level_;
+  }
+  
+  /**
+   *  @name   vendor
+   *  @fn     const std::string& vendor(void) const
+   *  @brief  CPU vendor string, empty if unknown
+   */
+  const std::string& vendor(void) const {
+    return vendor_;
+  }
+  
+  /**
+   *  @name   LevelName
+   *  @fn     static const char* LevelName(const Level& level)
+   *  @brief  Human readable name of a level
+   *  @param[in] level  Level
+   *  @return Name
+   */
+  static const char* LevelName(const Level& level);
+  
+#pragma mark -
+#pragma mark Private
+ private:
+  
+  /**
+   *  @name   CpuInfo
+   *  @fn     CpuInfo(void)
+   *  @brief  Constructor, detect the features
+   */
+  CpuInfo(void);
+  
+  /** Supported features */
+  Feature features_;
+  /** Highest supported level */
+  Level level_;
+  /** Vendor */
+  std::string vendor_;
+};
+  
+/** Enable bitmask operators for features */
+ENABLE_BITMASK_OPERATORS(CpuInfo::Feature);
+
+/*
+ *  @name   Has
+ *  @fn     bool Has(const Feature& features) const
+ *  @brief  Check if all the given features are supported
+ *  @param[in] features Features, combined with `|`
+ *  @return True if all are supported
+ */
+inline bool CpuInfo::Has(const Feature& features) const {
+  return (features_ & features) == features;
+}
+  
+}  // namespace FaceKit
+#endif /* __FACEKIT_CPU_INFO__ */
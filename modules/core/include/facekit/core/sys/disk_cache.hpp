@@ -0,0 +1,282 @@
+/**
+ *  @file   disk_cache.hpp
+ *  @brief Content-addressed on-disk cache for derived artifacts (i.e.
+ *         processed meshes, resized images). Entries are keyed by a hash of
+ *         their inputs and parameters, and bounded in size with an LRU
+ *         policy.
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   24.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_DISK_CACHE__
+#define __FACEKIT_DISK_CACHE__
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Forward declaration */
+class FileSystem;
+
+/**
+ *  @class  CacheKey
+ *  @brief  Incremental 128 bits hash of everything an artifact derives from
+ *          (input bytes, parameters, version of the producer). Not a
+ *          cryptographic hash.
+ *  @author Christophe Ecabert
+ *  @date   24.10.18
+ *  @ingroup core
+ */
+class FK_EXPORTS CacheKey {
+ public:
+
+  /**
+   *  @name   CacheKey
+   *  @fn     CacheKey(void)
+   *  @brief  Constructor
+   */
+  CacheKey(void);
+
+  /**
+   *  @name   Add
+   *  @fn     CacheKey& Add(const void* data, const size_t& n)
+   *  @brief  Hash raw bytes
+   *  @param[in] data Bytes
+   *  @param[in] n    Number of bytes
+   *  @return Key, for chaining
+   */
+  CacheKey& Add(const void* data, const size_t& n);
+
+  /**
+   *  @name   Add
+   *  @fn     CacheKey& Add(const std::string& str)
+   *  @brief  Hash a string, its length is included so consecutive strings
+   *          can not alias
+   *  @param[in] str  String
+   *  @return Key, for chaining
+   */
+  CacheKey& Add(const std::string& str);
+
+  /**
+   *  @name   Add
+   *  @fn     template<typename T> CacheKey& Add(const T& value)
+   *  @brief  Hash an arithmetic or enum parameter
+   *  @tparam T Parameter type
+   *  @param[in] value  Parameter
+   *  @return Key, for chaining
+   */
+  template<typename T>
+  typename std::enable_if<std::is_arithmetic<T>::value ||
+                          std::is_enum<T>::value, CacheKey&>::type
+  Add(const T& value) {
+    return this->Add(&value, sizeof(T));
+  }
+
+  /**
+   *  @name   ToString
+   *  @fn     std::string ToString(void) const
+   *  @brief  Digest of everything added so far, 32 hexadecimal characters
+   *  @return Digest
+   */
+  std::string ToString(void) const;
+
+ private:
+  /**
+   *  @name   Update
+   *  @fn     void Update(const uint64_t& word)
+   *  @brief  Mix one 8 bytes word in the state
+   */
+  void Update(const uint64_t& word);
+
+  /** Hash lanes */
+  uint64_t h_[2];
+  /** Bytes not yet mixed */
+  uint8_t tail_[8];
+  /** Number of bytes in `tail_` */
+  size_t n_tail_;
+  /** Total number of bytes */
+  uint64_t length_;
+};
+
+/**
+ *  @class  DiskCache
+ *  @brief  Directory of artifacts named after their `CacheKey`. Entries are
+ *          written to a temporary file then published with
+ *          `FileSystem::RenameFile`, therefore readers (other processes
+ *          included) never see partial entries. Once the total size goes
+ *          over the limit, least recently used entries are deleted. Recency
+ *          is tracked in memory, entries found on disk when opening are
+ *          ordered by modification time.
+ *  @author Christophe Ecabert
+ *  @date   24.10.18
+ *  @ingroup core
+ */
+class FK_EXPORTS DiskCache {
+ public:
+
+  /**
+   *  @name   DiskCache
+   *  @fn     DiskCache(void)
+   *  @brief  Constructor
+   */
+  DiskCache(void);
+
+  /**
+   *  @name   DiskCache
+   *  @fn     DiskCache(const DiskCache& other) = delete
+   *  @brief  Copy constructor
+   */
+  DiskCache(const DiskCache& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     DiskCache& operator=(const DiskCache& rhs) = delete
+   *  @brief  Copy assignment
+   */
+  DiskCache& operator=(const DiskCache& rhs) = delete;
+
+  /**
+   *  @name   Open
+   *  @fn     Status Open(const std::string& dir, const size_t& max_size)
+   *  @brief  Open (or create) a cache directory, index existing entries and
+   *          delete leftovers of interrupted writes
+   *  @param[in] dir      Cache directory
+   *  @param[in] max_size Maximum size of the entries in bytes
+   *  @return Operation status
+   */
+  Status Open(const std::string& dir, const size_t& max_size);
+
+  /**
+   *  @name   Lookup
+   *  @fn     Status Lookup(const std::string& key, std::string* data)
+   *  @brief  Load an entry and mark it as recently used
+   *  @param[in] key    Entry key, see `CacheKey::ToString`
+   *  @param[out] data  Entry content
+   *  @return kNotFound on cache miss
+   */
+  Status Lookup(const std::string& key, std::string* data);
+
+  /**
+   *  @name   Insert
+   *  @fn     Status Insert(const std::string& key, const void* data,
+                            const size_t& n)
+   *  @brief  Store an entry, replacing any previous one with the same key,
+   *          then evict entries to stay within the size limit
+   *  @param[in] key  Entry key, see `CacheKey::ToString`
+   *  @param[in] data Entry content
+   *  @param[in] n    Content size in bytes
+   *  @return kInvalidArgument if the entry alone exceeds the limit
+   */
+  Status Insert(const std::string& key, const void* data, const size_t& n);
+
+  /**
+   *  @name   Insert
+   *  @fn     Status Insert(const std::string& key, const std::string& data)
+   *  @brief  Store an entry, see `Insert(const std::string&, const void*,
+   *          const size_t&)`
+   *  @param[in] key  Entry key
+   *  @param[in] data Entry content
+   *  @return Operation status
+   */
+  Status Insert(const std::string& key, const std::string& data) {
+    return this->Insert(key, data.data(), data.size());
+  }
+
+  /**
+   *  @name   Remove
+   *  @fn     Status Remove(const std::string& key)
+   *  @brief  Delete an entry
+   *  @param[in] key  Entry key
+   *  @return kNotFound if absent
+   */
+  Status Remove(const std::string& key);
+
+  /**
+   *  @name   size
+   *  @fn     size_t size(void) const
+   *  @brief  Total size of the entries in bytes
+   */
+  size_t size(void) const;
+
+  /**
+   *  @name   n_entry
+   *  @fn     size_t n_entry(void) const
+   *  @brief  Number of entries
+   */
+  size_t n_entry(void) const;
+
+ private:
+
+  /**
+   *  @struct Entry
+   *  @brief  Indexed entry
+   */
+  struct Entry {
+    /** Key */
+    std::string key;
+    /** Size in bytes */
+    size_t size;
+  };
+
+  /** Entries, most recently used first */
+  using EntryList = std::list<Entry>;
+
+  /**
+   *  @name   EntryPath
+   *  @fn     std::string EntryPath(const std::string& key) const
+   *  @brief  Path of an entry
+   */
+  std::string EntryPath(const std::string& key) const;
+
+  /**
+   *  @name   Drop
+   *  @fn     void Drop(EntryList::iterator it)
+   *  @brief  Remove an entry from the index, lock must be held
+   */
+  void Drop(EntryList::iterator it);
+
+  /**
+   *  @name   Evict
+   *  @fn     void Evict(void)
+   *  @brief  Delete least recently used entries until the total size fits,
+   *          lock must be held
+   */
+  void Evict(void);
+
+  /** Cache directory */
+  std::string dir_;
+  /** File system holding the directory */
+  FileSystem* fs_;
+  /** Size limit */
+  size_t max_size_;
+  /** Current size */
+  size_t size_;
+  /** Recency list */
+  EntryList lru_;
+  /** Key to position in `lru_` */
+  std::unordered_map<std::string, EntryList::iterator> index_;
+  /** Random token making temporary files unique across processes */
+  uint64_t token_;
+  /** Temporary files counter */
+  size_t n_tmp_;
+  /** Index lock */
+  mutable std::mutex lock_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_DISK_CACHE__ */
@@ -12,9 +12,12 @@
 #ifndef __FACEKIT_FILE_SYSTEM__
 #define __FACEKIT_FILE_SYSTEM__
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <limits>
+#include <functional>
+#include <memory>
 
 
 #include "facekit/core/status.hpp"
@@ -24,6 +27,9 @@
  *  @brief      Development space
  */
 namespace FaceKit {
+
+/** Forward declaration */
+class ThreadPool;
   
 /**
  *  @struct  FileProperty
@@ -37,6 +43,8 @@ struct FK_EXPORTS FileProperty {
   size_t size = std::numeric_limits<size_t>::max();
   /** Directory flags */
   bool is_dir = false;
+  /** Last modification, seconds since epoch, 0 if not supported */
+  int64_t mtime = 0;
   
   /**
    *  @name   FileProperty
@@ -60,6 +68,109 @@ struct FK_EXPORTS FileProperty {
   ~FileProperty(void) = default;
 };
   
+/**
+ *  @class  ReadOnlyMemoryRegion
+ *  @brief  Read-only view of a file's content mapped in memory. The mapping
+ *          lives as long as the object.
+ *  @author Christophe Ecabert
+ *  @date   08.09.18
+ *  @ingroup core
+ */
+class FK_EXPORTS ReadOnlyMemoryRegion {
+ public:
+  /**
+   *  @name   ~ReadOnlyMemoryRegion
+   *  @fn     virtual ~ReadOnlyMemoryRegion(void) = default
+   *  @brief  Destructor, unmap the region
+   */
+  virtual ~ReadOnlyMemoryRegion(void) = default;
+
+  /**
+   *  @name   data
+   *  @fn     virtual const void* data(void) const = 0
+   *  @brief  Start of the mapped region, nullptr for empty file
+   *  @return Mapped address
+   */
+  virtual const void* data(void) const = 0;
+
+  /**
+   *  @name   length
+   *  @fn     virtual size_t length(void) const = 0
+   *  @brief  Size of the mapped region in bytes
+   *  @return Region's length
+   */
+  virtual size_t length(void) const = 0;
+};
+
+/**
+ *  @class  RandomAccessFile
+ *  @brief  File opened for positional reads. Reads do not share a cursor,
+ *          therefore they can be issued concurrently from several threads.
+ *  @author Christophe Ecabert
+ *  @date   08.09.18
+ *  @ingroup core
+ */
+class FK_EXPORTS RandomAccessFile {
+ public:
+
+  /**
+   *  @struct  ReadRequest
+   *  @brief  One read of a vectored request
+   */
+  struct ReadRequest {
+    /** Position in the file */
+    size_t offset = 0;
+    /** Number of bytes to read */
+    size_t size = 0;
+    /** Destination, at least `size` bytes */
+    char* buffer = nullptr;
+    /** Number of bytes actually read */
+    size_t n_read = 0;
+  };
+
+  /**
+   *  @name   ~RandomAccessFile
+   *  @fn     virtual ~RandomAccessFile(void) = default
+   *  @brief  Destructor, close the file
+   */
+  virtual ~RandomAccessFile(void) = default;
+
+  /**
+   *  @name   Read
+   *  @fn     virtual Status Read(const size_t& offset, const size_t& n,
+                                  char* buffer, size_t* n_read) const = 0
+   *  @brief  Read up to `n` bytes starting at `offset` into `buffer`
+   *  @param[in] offset   Position in the file
+   *  @param[in] n        Number of bytes to read
+   *  @param[out] buffer  Destination, at least `n` bytes
+   *  @param[out] n_read  Number of bytes actually read
+   *  @return kGood, kOutOfRange if fewer than `n` bytes were available or
+   *          error code
+   */
+  virtual Status Read(const size_t& offset,
+                      const size_t& n,
+                      char* buffer,
+                      size_t* n_read) const = 0;
+
+  /**
+   *  @name   ReadV
+   *  @fn     virtual Status ReadV(std::vector<ReadRequest>* requests) const
+   *  @brief  Serve a list of reads at arbitrary offsets in one call
+   *  @param[in,out] requests List of reads, `n_read` is filled for each
+   *  @return kGood or the first error encountered
+   */
+  virtual Status ReadV(std::vector<ReadRequest>* requests) const;
+
+  /**
+   *  @name   Size
+   *  @fn     virtual Status Size(size_t* size) const = 0
+   *  @brief  Query the file size in bytes
+   *  @param[out] size  File's size
+   *  @return Status of the operation
+   */
+  virtual Status Size(size_t* size) const = 0;
+};
+
 /**
  *  @class  FileSystem
  *  @brief  A generic interface for accessing a file system
@@ -128,13 +239,82 @@ class FK_EXPORTS FileSystem {
    *  @fn     virtual Status ListDirRecursively(const std::string& dir,
    *                                 std::vector<std::string>* files)
    *  @brief  List the content of a given directory `dir` and follow the 
-   *          arborescence in order to list all files
+   *          arborescence in order to list all files. Sub-directories are
+   *          scanned in parallel (see `WalkDir`), the order is unspecified.
    *  @param[in] dir  Directory to scan
    *  @param[out] files List of files/dirs in `dir`
    *  @return kGood or Error code
    */
   virtual Status ListDirRecursively(const std::string& dir,
                                     std::vector<std::string>* files);
+
+  /**
+   *  @struct  DirEntry
+   *  @brief  Directory entry with its type
+   */
+  struct DirEntry {
+    /** Path of the entry */
+    std::string path;
+    /** Directory flag, symbolic links are followed */
+    bool is_dir = false;
+  };
+
+  /**
+   *  @name   ListDirEntries
+   *  @fn     virtual Status ListDirEntries(const std::string& dir,
+                                            std::vector<DirEntry>* entries)
+   *  @brief  List the content of a given directory `dir` with the type of
+   *          each entry. The default queries `FileProp` for every entry,
+   *          file systems override it with batch listings reporting types
+   *          directly.
+   *  @param[in] dir  Directory to scan
+   *  @param[out] entries List of entries in `dir`
+   *  @return kGood or Error code
+   */
+  virtual Status ListDirEntries(const std::string& dir,
+                                std::vector<DirEntry>* entries);
+
+  /**
+   *  @struct  WalkOptions
+   *  @brief  Configuration of a parallel directory walk
+   */
+  struct WalkOptions {
+    /** Extensions of interest (i.e. ".jpg"), empty means every file */
+    std::vector<std::string> extensions;
+    /** Glob patterns matched against file names (i.e. "img_*.png"), see
+     `Path::Match`. Empty means every file, otherwise a file is reported if
+     it matches one of them as well as the extensions */
+    std::vector<std::string> patterns;
+    /** Maximum number of directories listed concurrently, 0 means the size
+     of the pool */
+    size_t max_concurrency = 0;
+    /** Pool used to list directories, nullptr means the default pool */
+    ThreadPool* pool = nullptr;
+  };
+
+  /**
+   *  Callback invoked for each file found by `WalkDir`. Calls are serialized
+   *  but can come from any worker of the pool. Returning false stops the walk
+   */
+  using WalkCallback = std::function<bool(const std::string& file)>;
+
+  /**
+   *  @name   WalkDir
+   *  @fn     virtual Status WalkDir(const std::string& dir,
+                                     const WalkOptions& options,
+                                     const WalkCallback& callback)
+   *  @brief  Walk the arborescence below `dir`, sub-directories are listed
+   *          concurrently on a `ThreadPool` with `ListDirEntries`. Files
+   *          matching the extensions and patterns are streamed to `callback` as soon as they are found, in no
+   *          particular order. Returns once the whole tree has been visited.
+   *  @param[in] dir      Directory to scan
+   *  @param[in] options  Walk configuration
+   *  @param[in] callback Function called for every matching file
+   *  @return kGood or the first error encountered
+   */
+  virtual Status WalkDir(const std::string& dir,
+                         const WalkOptions& options,
+                         const WalkCallback& callback);
   
   /**
    *  @name   FileProp
@@ -231,6 +411,30 @@ class FK_EXPORTS FileSystem {
    *  @return Status of the operation
    */
   virtual Status CopyFile(const std::string& src, const std::string& dst);
+
+  /**
+   *  @name   NewRandomAccessFile
+   *  @fn     virtual Status NewRandomAccessFile(const std::string& filename,
+                              std::unique_ptr<RandomAccessFile>* file)
+   *  @brief  Open a file for positional reads
+   *  @param[in] filename File to open
+   *  @param[out] file    Opened file
+   *  @return Status of the operation, kUnimplemented if not supported
+   */
+  virtual Status NewRandomAccessFile(const std::string& filename,
+                                     std::unique_ptr<RandomAccessFile>* file);
+
+  /**
+   *  @name   NewReadOnlyMemoryRegion
+   *  @fn     virtual Status NewReadOnlyMemoryRegion(const std::string& filename,
+                              std::unique_ptr<ReadOnlyMemoryRegion>* region)
+   *  @brief  Map the whole content of a file in memory, read-only
+   *  @param[in] filename File to map
+   *  @param[out] region  Mapped region
+   *  @return Status of the operation, kUnimplemented if not supported
+   */
+  virtual Status NewReadOnlyMemoryRegion(const std::string& filename,
+                                 std::unique_ptr<ReadOnlyMemoryRegion>* region);
 };
   
 /**
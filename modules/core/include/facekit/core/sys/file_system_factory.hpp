@@ -83,6 +83,17 @@ class FK_EXPORTS FileSystemFactory {
    *  @return File system instance or nullptr.
    */
   FileSystem* Retrieve(const std::string& name) const;
+
+  /**
+   *  @name   RetrieveForPath
+   *  @fn     FileSystem* RetrieveForPath(const std::string& path) const
+   *  @brief  Retrieve the file system handling `path` based on its scheme
+   *          (i.e. `s3://bucket/key`, `https://host/file`). Paths without
+   *          scheme go to the local file system.
+   *  @param[in] path Path or URI to access
+   *  @return File system instance or nullptr if the scheme is not registered
+   */
+  FileSystem* RetrieveForPath(const std::string& path) const;
   
 #pragma mark -
 #pragma mark Private
@@ -0,0 +1,421 @@
+/**
+ *  @file   http_file_system.hpp
+ *  @brief Read-only access to remote files over HTTP(S) and S3 compatible
+ *         object storage. Reads are served from a block cache fed by ranged
+ *         GETs with read-ahead, whole files are downloaded in parallel parts.
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   13.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_HTTP_FILE_SYSTEM__
+#define __FACEKIT_HTTP_FILE_SYSTEM__
+
+#include <string>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/sys/file_system.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  HttpFileSystem
+ *  @brief  Read-only file system for `http://` and `https://` URIs. Modifying
+ *          operations report kUnimplemented.
+ *  @author Christophe Ecabert
+ *  @date   13.10.18
+ *  @ingroup core
+ */
+class FK_EXPORTS HttpFileSystem : public FileSystem {
+ public:
+
+  /**
+   *  @struct Options
+   *  @brief  Transfer / cache configuration
+   */
+  struct Options {
+    /** Cache block size in bytes, unit of the ranged GETs */
+    size_t block_size = 4 * (1 << 20);
+    /** Maximum number of bytes kept in the block cache */
+    size_t cache_size = 256 * (1 << 20);
+    /** Number of blocks prefetched ahead of sequential reads */
+    size_t read_ahead = 2;
+    /** Part size for parallel whole-file downloads */
+    size_t part_size = 8 * (1 << 20);
+    /** Number of retries for failing requests (network errors, 5xx) */
+    size_t max_retries = 3;
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   HttpFileSystem
+   *  @fn     HttpFileSystem(void)
+   *  @brief  Constructor with default options
+   */
+  HttpFileSystem(void);
+
+  /**
+   *  @name   HttpFileSystem
+   *  @fn     explicit HttpFileSystem(const Options& options)
+   *  @brief  Constructor
+   *  @param[in] options  Transfer / cache configuration
+   */
+  explicit HttpFileSystem(const Options& options);
+
+  /**
+   *  @name   ~HttpFileSystem
+   *  @fn     ~HttpFileSystem(void) override
+   *  @brief  Destructor, wait for pending read-ahead
+   */
+  ~HttpFileSystem(void) override;
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   NormalizePath
+   *  @fn     std::string NormalizePath(const std::string& path) override
+   *  @brief  URIs are used as is
+   *  @param[in] path URI to normalize
+   *  @return Normalized URI
+   */
+  std::string NormalizePath(const std::string& path) override;
+
+  /**
+   *  @name   FileExist
+   *  @fn     Status FileExist(const std::string& filename) override
+   *  @brief  Check if a given URI exists
+   *  @param[in] filename URI to check existence
+   *  @return kGood of kNotFound
+   */
+  Status FileExist(const std::string& filename) override;
+
+  /**
+   *  @name   ListDir
+   *  @fn     Status ListDir(const std::string& dir,
+   *                                 std::vector<std::string>* files) override
+   *  @brief  HTTP does not support listing
+   *  @return kUnimplemented
+   */
+  Status ListDir(const std::string& dir,
+                 std::vector<std::string>* files) override;
+
+  /**
+   *  @name   FileProp
+   *  @fn     Status FileProp(const std::string& filename,
+   *                                  FileProperty* prop) override
+   *  @brief  Gather file properties for a given URI
+   *  @param[in] filename URI to the file
+   *  @param[out] prop    File's properties
+   *  @return kGood, kNotFound or error code.
+   */
+  Status FileProp(const std::string& filename, FileProperty* prop) override;
+
+  /**
+   *  @name   DeleteFile
+   *  @fn     Status DeleteFile(const std::string& filename) override
+   *  @brief  Read-only file system
+   *  @return kUnimplemented
+   */
+  Status DeleteFile(const std::string& filename) override;
+
+  /**
+   *  @name   CreateDir
+   *  @fn     Status CreateDir(const std::string& dir) override
+   *  @brief  Read-only file system
+   *  @return kUnimplemented
+   */
+  Status CreateDir(const std::string& dir) override;
+
+  /**
+   *  @name   DeleteDir
+   *  @fn     Status DeleteDir(const std::string& dir) override
+   *  @brief  Read-only file system
+   *  @return kUnimplemented
+   */
+  Status DeleteDir(const std::string& dir) override;
+
+  /**
+   *  @name   RenameFile
+   *  @fn     Status RenameFile(const std::string& src,
+   *                                    const std::string& dst) override
+   *  @brief  Read-only file system
+   *  @return kUnimplemented
+   */
+  Status RenameFile(const std::string& src, const std::string& dst) override;
+
+  /**
+   *  @name   QueryFileSize
+   *  @fn     Status QueryFileSize(const std::string& filename, size_t* size) override
+   *  @brief  Gather file size in bytes (`HEAD` request)
+   *  @param[in] filename URI to query size
+   *  @param[out] size    File's size
+   *  @return Status of the operation
+   */
+  Status QueryFileSize(const std::string& filename, size_t* size) override;
+
+  /**
+   *  @name   CopyFile
+   *  @fn     Status CopyFile(const std::string& src, const std::string& dst) override
+   *  @brief  Download remote `src` into local file `dst`
+   *  @param[in] src  URI to download
+   *  @param[in] dst  Local destination
+   *  @return Status of the operation
+   */
+  Status CopyFile(const std::string& src, const std::string& dst) override;
+
+  /**
+   *  @name   NewRandomAccessFile
+   *  @fn     Status NewRandomAccessFile(const std::string& filename,
+                      std::unique_ptr<RandomAccessFile>* file) override
+   *  @brief  Open a remote file, reads are served from the block cache with
+   *          read-ahead on sequential access
+   *  @param[in] filename URI to open
+   *  @param[out] file    Opened file
+   *  @return Status of the operation
+   */
+  Status NewRandomAccessFile(const std::string& filename,
+                             std::unique_ptr<RandomAccessFile>* file) override;
+
+  /**
+   *  @name   NewReadOnlyMemoryRegion
+   *  @fn     Status NewReadOnlyMemoryRegion(const std::string& filename,
+                      std::unique_ptr<ReadOnlyMemoryRegion>* region) override
+   *  @brief  Download the whole file in memory, parts are fetched in parallel
+   *  @param[in] filename URI to download
+   *  @param[out] region  Downloaded content
+   *  @return Status of the operation
+   */
+  Status NewReadOnlyMemoryRegion(const std::string& filename,
+                       std::unique_ptr<ReadOnlyMemoryRegion>* region) override;
+
+  /**
+   *  @name   ReadRange
+   *  @fn     Status ReadRange(const std::string& uri, const size_t& offset,
+                               const size_t& n, char* buffer, size_t* n_read)
+   *  @brief  Ranged GET, bypass the cache
+   *  @param[in] uri      Remote file
+   *  @param[in] offset   First byte
+   *  @param[in] n        Number of bytes
+   *  @param[out] buffer  Destination, at least `n` bytes
+   *  @param[out] n_read  Number of bytes received
+   *  @return Status of the operation
+   */
+  Status ReadRange(const std::string& uri,
+                   const size_t& offset,
+                   const size_t& n,
+                   char* buffer,
+                   size_t* n_read);
+
+#pragma mark -
+#pragma mark Protected
+ protected:
+
+  /**
+   *  @struct Request
+   *  @brief  HTTP request description
+   */
+  struct Request {
+    /** Method (GET/HEAD) */
+    std::string method;
+    /** Full URL */
+    std::string url;
+    /** Extra headers, "Name: value" */
+    std::vector<std::string> headers;
+  };
+
+  /**
+   *  @name   PrepareRequest
+   *  @fn     virtual Status PrepareRequest(const std::string& uri,
+                                            const std::string& query,
+                                            Request* request)
+   *  @brief  Convert `uri` into an URL and add the headers needed to access
+   *          it (i.e. authentication). `request->method` is already set.
+   *  @param[in] uri      Resource
+   *  @param[in] query    Canonical query string, can be empty
+   *  @param[in,out] request  Request to complete
+   *  @return Status of the operation
+   */
+  virtual Status PrepareRequest(const std::string& uri,
+                                const std::string& query,
+                                Request* request);
+
+  /**
+   *  @name   Perform
+   *  @fn     Status Perform(const Request& request, std::string* body,
+                             char* buffer, const size_t& capacity,
+                             const size_t& skip, size_t* n_body, long* code)
+   *  @brief  Run a request with retries. The body goes into `buffer` when
+   *          provided (at most `capacity` bytes), `body` otherwise.
+   *  @param[in] request  Request to run
+   *  @param[out] body    Response body, can be nullptr
+   *  @param[out] buffer  Fixed size destination, can be nullptr
+   *  @param[in] capacity Size of `buffer`
+   *  @param[in] skip     Leading bytes to drop if the server answers a ranged
+   *                      request with the full content (200)
+   *  @param[out] n_body  Number of bytes received
+   *  @param[out] code    HTTP status code
+   *  @return kGood, kNotFound (404) or error code
+   */
+  Status Perform(const Request& request,
+                 std::string* body,
+                 char* buffer,
+                 const size_t& capacity,
+                 const size_t& skip,
+                 size_t* n_body,
+                 long* code);
+
+  /**
+   *  @name   Head
+   *  @fn     Status Head(const std::string& uri, size_t* size)
+   *  @brief  `HEAD` request, provide resource's size
+   *  @param[in] uri    Resource
+   *  @param[out] size  Content length
+   *  @return kGood, kNotFound or error code
+   */
+  Status Head(const std::string& uri, size_t* size);
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Block cache */
+  class BlockCache;
+  /** Cached remote file */
+  class HttpRandomAccessFile;
+
+  /** Configuration */
+  Options options_;
+  /** Shared block cache */
+  BlockCache* cache_;
+};
+
+/**
+ *  @class  S3FileSystem
+ *  @brief  Read-only file system for `s3://bucket/key` URIs. The endpoint is
+ *          taken from `S3_ENDPOINT` (path-style addressing), defaults to AWS
+ *          in `AWS_REGION`. Requests are signed (SigV4) when
+ *          `AWS_ACCESS_KEY_ID` / `AWS_SECRET_ACCESS_KEY` are defined.
+ *  @author Christophe Ecabert
+ *  @date   13.10.18
+ *  @ingroup core
+ */
+class FK_EXPORTS S3FileSystem : public HttpFileSystem {
+ public:
+
+  /**
+   *  @name   S3FileSystem
+   *  @fn     S3FileSystem(void)
+   *  @brief  Constructor with default options
+   */
+  S3FileSystem(void);
+
+  /**
+   *  @name   S3FileSystem
+   *  @fn     explicit S3FileSystem(const Options& options)
+   *  @brief  Constructor
+   *  @param[in] options  Transfer / cache configuration
+   */
+  explicit S3FileSystem(const Options& options);
+
+  /**
+   *  @name   ~S3FileSystem
+   *  @fn     ~S3FileSystem(void) override = default
+   *  @brief  Destructor
+   */
+  ~S3FileSystem(void) override = default;
+
+  /**
+   *  @name   ListDir
+   *  @fn     Status ListDir(const std::string& dir,
+   *                                 std::vector<std::string>* files) override
+   *  @brief  List objects and common prefixes directly under `dir`
+   *  @param[in] dir  Prefix to scan (`s3://bucket/prefix`)
+   *  @param[out] files List of objects/prefixes in `dir`
+   *  @return kGood or Error code
+   */
+  Status ListDir(const std::string& dir,
+                 std::vector<std::string>* files) override;
+
+  /**
+   *  @name   FileProp
+   *  @fn     Status FileProp(const std::string& filename,
+   *                                  FileProperty* prop) override
+   *  @brief  Gather object properties, a non-empty prefix is a directory
+   *  @param[in] filename Object URI
+   *  @param[out] prop    Object's properties
+   *  @return kGood, kNotFound or error code.
+   */
+  Status FileProp(const std::string& filename, FileProperty* prop) override;
+
+  /**
+   *  @name   SignRequest
+   *  @fn     static std::string SignRequest(const std::string& method,
+                      const std::string& host, const std::string& path,
+                      const std::string& query, const std::string& amz_date,
+                      const std::string& region, const std::string& key_id,
+                      const std::string& secret, const std::string& token)
+   *  @brief  Compute the SigV4 `Authorization` header value for a request
+   *          with an unsigned payload
+   *  @param[in] method   HTTP method
+   *  @param[in] host     Host header value
+   *  @param[in] path     URI-encoded path
+   *  @param[in] query    Canonical query string
+   *  @param[in] amz_date Timestamp, `YYYYMMDDTHHMMSSZ`
+   *  @param[in] region   Region
+   *  @param[in] key_id   Access key id
+   *  @param[in] secret   Secret access key
+   *  @param[in] token    Session token, can be empty
+   *  @return Authorization header value, empty if signing is not supported
+   */
+  static std::string SignRequest(const std::string& method,
+                                 const std::string& host,
+                                 const std::string& path,
+                                 const std::string& query,
+                                 const std::string& amz_date,
+                                 const std::string& region,
+                                 const std::string& key_id,
+                                 const std::string& secret,
+                                 const std::string& token);
+
+#pragma mark -
+#pragma mark Protected
+ protected:
+
+  /**
+   *  @name   PrepareRequest
+   *  @fn     Status PrepareRequest(const std::string& uri,
+                                    const std::string& query,
+                                    Request* request) override
+   *  @brief  Map `s3://bucket/key` on the endpoint and sign the request
+   */
+  Status PrepareRequest(const std::string& uri,
+                        const std::string& query,
+                        Request* request) override;
+
+#pragma mark -
+#pragma mark Private
+ private:
+
+  /**
+   *  @name   ListObjects
+   *  @fn     Status ListObjects(const std::string& dir, const size_t& max_keys,
+                                 std::vector<std::string>* files)
+   *  @brief  `ListObjectsV2` with '/' delimiter, follow continuation tokens
+   *          until `max_keys` entries are gathered (0 for all)
+   */
+  Status ListObjects(const std::string& dir,
+                     const size_t& max_keys,
+                     std::vector<std::string>* files);
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_HTTP_FILE_SYSTEM__ */
@@ -0,0 +1,268 @@
+/**
+ *  @file   perf_counter.hpp
+ *  @brief  Hardware performance counters (cycles, instructions, cache and
+ *          branch misses) of the calling thread
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_PERF_COUNTER__
+#define __FACEKIT_PERF_COUNTER__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  PerfCounters
+ *  @brief  Group of hardware counters attached to the thread that opened it,
+ *          backed by `perf_event_open` on Linux. Counters the CPU (or the
+ *          kernel's `perf_event_paranoid` setting) does not allow are left
+ *          out, other platforms have none. Values are scaled if the kernel
+ *          had to multiplex the counters.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup core
+ */
+class FK_EXPORTS PerfCounters {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /**
+   *  @enum   Counter
+   *  @brief  List of hardware counters
+   */
+  enum Counter : size_t {
+    /** CPU cycles */
+    kCycles = 0,
+    /** Retired instructions */
+    kInstructions = 1,
+    /** Last level cache misses */
+    kLLCMisses = 2,
+    /** Mispredicted branches */
+    kBranchMisses = 3,
+    /** Number of counters */
+    kNCounter = 4
+  };
+
+  /**
+   *  @struct Sample
+   *  @brief  Counter values, or their difference between two reads
+   */
+  struct Sample {
+    /** Values, indexed by `Counter` */
+    uint64_t value[kNCounter] = {0, 0, 0, 0};
+    /** Bit `k` is set if counter `k` is available */
+    uint32_t valid = 0;
+
+    /**
+     *  @name   Has
+     *  @fn     bool Has(const Counter& counter) const
+     *  @brief  Indicate if a given counter is available
+     */
+    bool Has(const Counter& counter) const {
+      return (valid >> counter) & 1;
+    }
+
+    /**
+     *  @name   operator-
+     *  @fn     Sample operator-(const Sample& rhs) const
+     *  @brief  Counts between two reads of the same group
+     */
+    Sample operator-(const Sample& rhs) const {
+      Sample s;
+      s.valid = valid & rhs.valid;
+      for (size_t k = 0; k < kNCounter; ++k) {
+        s.value[k] = value[k] - rhs.value[k];
+      }
+      return s;
+    }
+
+    /**
+     *  @name   Ipc
+     *  @fn     double Ipc(void) const
+     *  @brief  Instructions per cycle, 0 if not available
+     */
+    double Ipc(void) const {
+      return (Has(kCycles) && Has(kInstructions) && value[kCycles] != 0) ?
+             double(value[kInstructions]) / double(value[kCycles]) :
+             0.0;
+    }
+
+    /**
+     *  @name   Export
+     *  @fn     template<typename Map> void Export(const double& n,
+                                                   Map* counters) const
+     *  @brief  Add the available counters, divided by `n`, to a
+     *          string-keyed map (i.e. `benchmark::State::counters`) under
+     *          their `Name`, along with the IPC
+     *  @param[in] n          Normalization, i.e. number of iterations
+     *  @param[out] counters  Map to fill
+     *  @tparam Map Map type, values must be constructible from double
+     */
+    template<typename Map>
+    void Export(const double& n, Map* counters) const {
+      for (size_t k = 0; k < kNCounter; ++k) {
+        if (Has(Counter(k))) {
+          (*counters)[Name(Counter(k))] = double(value[k]) / n;
+        }
+      }
+      if (Has(kCycles) && Has(kInstructions)) {
+        (*counters)["ipc"] = this->Ipc();
+      }
+    }
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   PerfCounters
+   *  @fn     PerfCounters(void)
+   *  @brief  Constructor, see `Open`
+   */
+  PerfCounters(void);
+
+  /**
+   *  @name   PerfCounters
+   *  @fn     PerfCounters(const PerfCounters& other) = delete
+   *  @brief  Copy constructor
+   */
+  PerfCounters(const PerfCounters& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     PerfCounters& operator=(const PerfCounters& rhs) = delete
+   *  @brief  Copy assignment
+   */
+  PerfCounters& operator=(const PerfCounters& rhs) = delete;
+
+  /**
+   *  @name   ~PerfCounters
+   *  @fn     ~PerfCounters(void)
+   *  @brief  Destructor, release the counters
+   */
+  ~PerfCounters(void);
+
+  /**
+   *  @name   ThreadCounters
+   *  @fn     static PerfCounters* ThreadCounters(void)
+   *  @brief  Counters of the calling thread, opened on first call
+   *  @return Counters or nullptr if none is available
+   */
+  static PerfCounters* ThreadCounters(void);
+
+  /**
+   *  @name   Name
+   *  @fn     static const char* Name(const Counter& counter)
+   *  @brief  Counter's name
+   */
+  static const char* Name(const Counter& counter);
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   Open
+   *  @fn     Status Open(void)
+   *  @brief  Start counting for the calling thread, only this thread can be
+   *          measured afterwards
+   *  @return kUnimplemented if the platform has no counters, kInternalError
+   *          if none could be opened
+   */
+  Status Open(void);
+
+  /**
+   *  @name   Close
+   *  @fn     void Close(void)
+   *  @brief  Release the counters
+   */
+  void Close(void);
+
+  /**
+   *  @name   Read
+   *  @fn     Status Read(Sample* sample) const
+   *  @brief  Read current values, counts between two points are obtained by
+   *          subtracting two samples
+   *  @param[out] sample  Counter values
+   *  @return kInternalError if not open or the read failed
+   */
+  Status Read(Sample* sample) const;
+
+  /**
+   *  @name   IsOpen
+   *  @fn     bool IsOpen(void) const
+   *  @brief  Indicate if at least one counter is counting
+   */
+  bool IsOpen(void) const {
+    return leader_ >= 0;
+  }
+
+ private:
+  /** Group leader, -1 if closed */
+  int leader_;
+  /** Descriptors, -1 if unavailable */
+  int fd_[kNCounter];
+  /** Counter of each group member, in read order */
+  Counter order_[kNCounter];
+  /** Number of group members */
+  size_t n_open_;
+};
+
+/**
+ *  @class  PerfCounterRegion
+ *  @brief  Measure the calling thread's counters from construction until
+ *          `Stop`, i.e. around a benchmark loop. Does nothing if the thread
+ *          has no counters.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup core
+ */
+class FK_EXPORTS PerfCounterRegion {
+ public:
+  /**
+   *  @name   PerfCounterRegion
+   *  @fn     PerfCounterRegion(void)
+   *  @brief  Constructor, start measuring
+   */
+  PerfCounterRegion(void) : counters_(PerfCounters::ThreadCounters()) {
+    if (counters_ && !counters_->Read(&start_).Good()) {
+      counters_ = nullptr;
+    }
+  }
+
+  /**
+   *  @name   Stop
+   *  @fn     PerfCounters::Sample Stop(void) const
+   *  @brief  Counts since construction, empty if not available
+   */
+  PerfCounters::Sample Stop(void) const {
+    PerfCounters::Sample stop;
+    if (counters_ && counters_->Read(&stop).Good()) {
+      return stop - start_;
+    }
+    return PerfCounters::Sample();
+  }
+
+ private:
+  /** Thread's counters, nullptr if not available */
+  PerfCounters* counters_;
+  /** Values at construction */
+  PerfCounters::Sample start_;
+};
+
+}  // namespace FaceKit
+#endif  // __FACEKIT_PERF_COUNTER__
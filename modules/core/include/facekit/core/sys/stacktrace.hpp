@@ -343,7 +343,10 @@ private:
 /**
  *  @class  StackTrace
  *  @brief  Create a trace of the current stack for debugging purpose. Would 
- *          typically be used in within expection context.
+ *          typically be used in within expection context. Only the raw
+ *          program counters are recorded at construction, frames are
+ *          symbolized the first time they are needed (i.e. `Resolve`,
+ *          `ToString`) therefore capturing a trace on an error path is cheap.
  *  @author Christophe Ecabert
  *  @date   10.07.18
  *  @ingroup core
@@ -400,10 +403,19 @@ class FK_EXPORTS StackTrace {
 #pragma mark -
 #pragma mark Usage
   
+  /**
+   *  @name   Resolve
+   *  @fn     Status Resolve(void)
+   *  @brief  Symbolize the frames in place, does nothing if already done
+   *  @return Status of the operations
+   */
+  Status Resolve(void);
+
   /**
    *  @name   ToString
    *  @fn     void ToString(std::string* str) const
-   *  @brief  Convert the trace into a readable string
+   *  @brief  Convert the trace into a readable string. An unresolved trace is
+   *          symbolized on a copy, the trace itself is left untouched.
    *  @param[out] str  String holding formatted stack trace, or empty if
    *                   something went wrong.
    *  @return Status of the operations
@@ -427,27 +439,51 @@ class FK_EXPORTS StackTrace {
    *  @return Trace's length
    */
   size_t Size(void) const {
-    return frames_.size();
+    return pcs_.size();
+  }
+
+  /**
+   *  @name   IsResolved
+   *  @fn     bool IsResolved(void) const
+   *  @brief  Indicate if the frames have been symbolized
+   *  return  True if resolved, false otherwise
+   */
+  bool IsResolved(void) const {
+    return resolved_;
+  }
+
+  /**
+   *  @name   Address
+   *  @fn     const void* Address(const size_t& k) const
+   *  @brief  Program counter of the frame at position `k`
+   *  @param[in] k  Position of the frame to access
+   *  @return Frame's address
+   */
+  const void* Address(const size_t& k) const {
+    return pcs_.at(k);
   }
   
   /**
    *  @name   At
    *  @fn     StackTraceFrame& At(const size_t& k)
-   *  @brief  Provide access to the frame at position `k` (read/write)
+   *  @brief  Provide access to the frame at position `k` (read/write), the
+   *          frames are created from the program counters on first access.
    *  @param[in] k  Position of the frame to access
    *  @return Frame's instance
    */
-  StackTraceFrame& At(const size_t& k) {
-    return frames_.at(k);
-  }
+  StackTraceFrame& At(const size_t& k);
   
 #pragma mark -
 #pragma mark Private
  private:
-  /** Stack frames */
+  /** Program counters */
+  std::vector<void*> pcs_;
+  /** Stack frames, empty until first accessed */
   std::vector<StackTraceFrame> frames_;
   /** Indicate if stack trace has been properly queried */
   bool trace_valid_;
+  /** Indicate if the frames have been symbolized */
+  bool resolved_;
 };
   
   
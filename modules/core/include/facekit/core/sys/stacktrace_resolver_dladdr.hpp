@@ -13,6 +13,10 @@
 #ifndef __FACEKIT_STACKTRACE_RESOLVER_DLADDR__
 #define __FACEKIT_STACKTRACE_RESOLVER_DLADDR__
 
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
 #include "facekit/core/library_export.hpp"
 #include "facekit/core/sys/stacktrace_resolver.hpp"
 
@@ -24,7 +28,9 @@ namespace FaceKit {
   
 /**
  *  @class  ResolverDlAddr
- *  @brief  Stack trace resolver based on DlAddr posix function
+ *  @brief  Stack trace resolver based on DlAddr posix function. Symbols are
+ *          cached per address, therefore recurring traces (i.e. same error
+ *          raised in a loop) are symbolized once.
  *  @author Christophe Ecabert
  *  @date   10.07.18
  *  @ingroup core
@@ -54,7 +60,31 @@ class FK_EXPORTS ResolverDlAddr : public StackTraceResolver {
    *  @return Status of the operation.
    */
   Status Resolve(StackTrace* trace);
-  
+
+ private:
+
+  /**
+   *  @struct Symbol
+   *  @brief  Resolved information for one address
+   */
+  struct Symbol {
+    /** Executable or shared-object file */
+    std::string library_name;
+    /** Mangled symbol name */
+    std::string mangled_symbol_name;
+    /** Demangled symbol name, mangled if demangling failed */
+    std::string symbol_name;
+    /** Offset from the symbol */
+    size_t offset;
+  };
+
+  /** Maximum number of cached addresses, cache is flushed when reached */
+  static constexpr size_t kMaxCacheSize = 4096;
+
+  /** Resolved symbols */
+  std::unordered_map<const void*, Symbol> cache_;
+  /** Cache guard */
+  std::mutex lock_;
 };
   
 }  // namespace FaceKit
@@ -67,6 +67,20 @@ class FK_EXPORTS WindowsFileSystem : public FileSystem {
    */
   Status ListDir(const std::string& dir,
                  std::vector<std::string>* files) override;
+
+  /**
+   *  @name   ListDirEntries
+   *  @fn     Status ListDirEntries(const std::string& dir,
+                                    std::vector<DirEntry>* entries) override
+   *  @brief  List the content of a given directory `dir` with the type of
+   *          each entry, read with `FindFirstFileEx` large
+   *          fetches. Types come from the listing attributes.
+   *  @param[in] dir  Directory to scan
+   *  @param[out] entries List of entries in `dir`
+   *  @return kGood or Error code
+   */
+  Status ListDirEntries(const std::string& dir,
+                        std::vector<DirEntry>* entries) override;
   
   /**
    *  @name   FileProp
@@ -126,6 +140,30 @@ class FK_EXPORTS WindowsFileSystem : public FileSystem {
    *  @return Status of the operation
    */
   Status QueryFileSize(const std::string& filename, size_t* size) override;
+
+  /**
+   *  @name   NewRandomAccessFile
+   *  @fn     Status NewRandomAccessFile(const std::string& filename,
+                      std::unique_ptr<RandomAccessFile>* file) override
+   *  @brief  Open a file for positional reads (`ReadFile` + `OVERLAPPED`)
+   *  @param[in] filename File to open
+   *  @param[out] file    Opened file
+   *  @return Status of the operation
+   */
+  Status NewRandomAccessFile(const std::string& filename,
+                             std::unique_ptr<RandomAccessFile>* file) override;
+
+  /**
+   *  @name   NewReadOnlyMemoryRegion
+   *  @fn     Status NewReadOnlyMemoryRegion(const std::string& filename,
+                      std::unique_ptr<ReadOnlyMemoryRegion>* region) override
+   *  @brief  Map the whole content of a file in memory (`MapViewOfFile`)
+   *  @param[in] filename File to map
+   *  @param[out] region  Mapped region
+   *  @return Status of the operation
+   */
+  Status NewReadOnlyMemoryRegion(const std::string& filename,
+                       std::unique_ptr<ReadOnlyMemoryRegion>* region) override;
   
   /**
    *  @name   Utf8ToWString
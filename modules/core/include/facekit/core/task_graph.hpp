@@ -0,0 +1,232 @@
+/**
+ *  @file   task_graph.hpp
+ *  @brief Dependency graph of tasks executed on a thread pool
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   17.12.17
+ *    Copyright © 2017 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_TASK_GRAPH__
+#define __FACEKIT_TASK_GRAPH__
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/core/thread_pool.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+// Forward declaration
+class TaskGroup;
+
+/**
+ *  @class  TaskGraph
+ *  @brief  Directed acyclic graph of tasks. A node is released onto the pool
+ *          as soon as all its dependencies are completed, independent
+ *          branches (i.e. stages of different frames) overlap automatically.
+ *  @author Christophe Ecabert
+ *  @date   17.12.17
+ *  @ingroup core
+ *  @details The graph can be run several times. Execution time of each node
+ *           is measured, the critical path of the last run can be queried
+ *           afterward.
+ */
+class FK_EXPORTS TaskGraph {
+ public:
+
+#pragma mark -
+#pragma mark Type Definition
+
+  /** Node identifier */
+  using NodeId = std::size_t;
+
+  /** Node function */
+  using Function = std::function<void(void)>;
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   TaskGraph
+   *  @fn     TaskGraph(void)
+   *  @brief  Constructor, nodes run on the default pool
+   */
+  TaskGraph(void);
+
+  /**
+   *  @name   TaskGraph
+   *  @fn     explicit TaskGraph(ThreadPool* pool)
+   *  @brief  Constructor
+   *  @param[in] pool Pool on which nodes run
+   */
+  explicit TaskGraph(ThreadPool* pool);
+
+  /**
+   *  @name   TaskGraph
+   *  @fn     TaskGraph(const TaskGraph& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  TaskGraph(const TaskGraph& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     TaskGraph& operator=(const TaskGraph& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  TaskGraph& operator=(const TaskGraph& rhs) = delete;
+
+  /**
+   *  @name   ~TaskGraph
+   *  @fn     ~TaskGraph(void)
+   *  @brief  Destructor
+   */
+  ~TaskGraph(void);
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   AddNode
+   *  @fn     NodeId AddNode(const std::string& name, Function&& fn)
+   *  @brief  Add a new node to the graph
+   *  @param[in] name Node's name, used for reporting
+   *  @param[in] fn   Work performed by the node
+   *  @return Node identifier
+   */
+  NodeId AddNode(const std::string& name, Function&& fn);
+
+  /**
+   *  @name   AddDependency
+   *  @fn     Status AddDependency(const NodeId& before, const NodeId& after)
+   *  @brief  Indicate that `after` can only start once `before` is completed
+   *  @param[in] before Node to be completed first
+   *  @param[in] after  Node depending on `before`
+   *  @return kOk if successful, kInvalidArgument if one of the node does not
+   *          exist or if the edge is a self loop
+   */
+  Status AddDependency(const NodeId& before, const NodeId& after);
+
+  /**
+   *  @name   Run
+   *  @fn     Status Run(void)
+   *  @brief  Execute the whole graph and wait for its completion. The calling
+   *          thread runs pending tasks while waiting.
+   *  @return kOk if successful, kInvalidArgument if the graph has a cycle,
+   *          kInternalError if one of the node raised an exception, the
+   *          remaining nodes are skipped in that case.
+   */
+  Status Run(void);
+
+  /**
+   *  @name   CriticalPath
+   *  @fn     double CriticalPath(std::vector<NodeId>* path) const
+   *  @brief  Compute the longest chain of dependent nodes of the last run,
+   *          weighted by the measured execution time.
+   *  @param[out] path  Nodes along the critical path, in execution order
+   *  @return Critical path length in ms
+   */
+  double CriticalPath(std::vector<NodeId>* path) const;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   size
+   *  @fn     std::size_t size(void) const
+   *  @brief  Number of nodes in the graph
+   *  @return Graph size
+   */
+  std::size_t size(void) const {
+    return nodes_.size();
+  }
+
+  /**
+   *  @name   name
+   *  @fn     const std::string& name(const NodeId& node) const
+   *  @brief  Name of a given node
+   *  @param[in] node Node identifier
+   *  @return Node's name
+   */
+  const std::string& name(const NodeId& node) const {
+    return nodes_[node]->name;
+  }
+
+  /**
+   *  @name   time
+   *  @fn     double time(const NodeId& node) const
+   *  @brief  Execution time of a given node during the last run
+   *  @param[in] node Node identifier
+   *  @return Execution time in ms
+   */
+  double time(const NodeId& node) const {
+    return nodes_[node]->time;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+
+  /**
+   *  @struct  Node
+   *  @brief  Graph's node
+   */
+  struct Node {
+    /** Name */
+    std::string name;
+    /** Work */
+    Function fn;
+    /** Nodes depending on this one */
+    std::vector<NodeId> successors;
+    /** Nodes this one depends on */
+    std::vector<NodeId> predecessors;
+    /** Number of dependencies not completed yet during a run */
+    std::atomic<std::size_t> remaining;
+    /** Execution time of the last run, in ms */
+    double time;
+  };
+
+  /**
+   *  @name   Release
+   *  @fn     void Release(const NodeId& node, TaskGroup* group)
+   *  @brief  Submit a node whose dependencies are all completed
+   *  @param[in] node   Node to submit
+   *  @param[in] group  Group tracking the run
+   */
+  void Release(const NodeId& node, TaskGroup* group);
+
+  /**
+   *  @name   Sort
+   *  @fn     bool Sort(std::vector<NodeId>* order) const
+   *  @brief  Topological sort of the graph
+   *  @param[out] order Nodes in an order compatible with the dependencies
+   *  @return False if the graph has a cycle
+   */
+  bool Sort(std::vector<NodeId>* order) const;
+
+  /** Pool */
+  ThreadPool* pool_;
+  /** Nodes */
+  std::vector<std::unique_ptr<Node>> nodes_;
+  /** Synchronization */
+  std::mutex lock_;
+  /** Error raised during the last run */
+  std::string error_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_TASK_GRAPH__ */
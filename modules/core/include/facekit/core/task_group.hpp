@@ -0,0 +1,216 @@
+/**
+ *  @file   task_group.hpp
+ *  @brief Group of tasks running on a thread pool that can be waited on or
+ *         cancelled as a whole
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   17.12.17
+ *    Copyright © 2017 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_TASK_GROUP__
+#define __FACEKIT_TASK_GROUP__
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/thread_pool.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  TaskGroup
+ *  @brief  Set of tasks that can be waited on or cancelled together.
+ *  @author Christophe Ecabert
+ *  @date   17.12.17
+ *  @ingroup core
+ *  @details A thread blocked in `Wait` runs other pending tasks of the pool
+ *           instead of sleeping, therefore groups can be nested inside pool's
+ *           tasks without deadlocking. The first exception raised by a task
+ *           cancels the group and is rethrown by `Wait`.
+ */
+class FK_EXPORTS TaskGroup {
+ public:
+
+  /** Task priority */
+  using TaskPriority = ThreadPool::TaskPriority;
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   TaskGroup
+   *  @fn     TaskGroup(void)
+   *  @brief  Constructor, tasks run on the default pool
+   */
+  TaskGroup(void);
+
+  /**
+   *  @name   TaskGroup
+   *  @fn     explicit TaskGroup(ThreadPool* pool)
+   *  @brief  Constructor
+   *  @param[in] pool Pool on which tasks run
+   */
+  explicit TaskGroup(ThreadPool* pool);
+
+  /**
+   *  @name   TaskGroup
+   *  @fn     TaskGroup(const TaskGroup& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  TaskGroup(const TaskGroup& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     TaskGroup& operator=(const TaskGroup& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  TaskGroup& operator=(const TaskGroup& rhs) = delete;
+
+  /**
+   *  @name   ~TaskGroup
+   *  @fn     ~TaskGroup(void)
+   *  @brief  Destructor, wait for running tasks. Pending errors are
+   *          discarded.
+   */
+  ~TaskGroup(void);
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   Run
+   *  @fn     void Run(F&& fn, const TaskPriority& priority)
+   *  @brief  Add a task to the group
+   *  @param[in] fn       Task with the signature `void(void)`
+   *  @param[in] priority Task's priority
+   *  @tparam F Callable type
+   */
+  template<typename F>
+  void Run(F&& fn, const TaskPriority& priority = TaskPriority::kNormal);
+
+  /**
+   *  @name   Wait
+   *  @fn     void Wait(void)
+   *  @brief  Wait till every task of the group is completed or skipped,
+   *          running other pending tasks meanwhile. Rethrow the first error
+   *          raised by a task. The group can be reused afterward.
+   */
+  void Wait(void);
+
+  /**
+   *  @name   Cancel
+   *  @fn     void Cancel(void)
+   *  @brief  Skip tasks that have not started yet. Running tasks can poll
+   *          `is_cancelled` to stop early.
+   */
+  void Cancel(void);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   is_cancelled
+   *  @fn     bool is_cancelled(void) const
+   *  @brief  Indicate if the group has been cancelled
+   *  @return True if cancelled
+   */
+  bool is_cancelled(void) const {
+    return cancelled_.load();
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+
+  /**
+   *  @struct  GroupTask
+   *  @brief  Wrapper tracking completion of a group's task
+   *  @tparam F Callable type
+   */
+  template<typename F>
+  struct GroupTask {
+    /** Owning group */
+    TaskGroup* group;
+    /** Task */
+    F fn;
+
+    void operator()(void) {
+      if (!group->is_cancelled()) {
+        try {
+          fn();
+        } catch (...) {
+          group->SetError(std::current_exception());
+        }
+      }
+      group->Done();
+    }
+  };
+
+  /**
+   *  @name   SetError
+   *  @fn     void SetError(std::exception_ptr error)
+   *  @brief  Record an error raised by a task and cancel the group
+   *  @param[in] error  Error raised
+   */
+  void SetError(std::exception_ptr error);
+
+  /**
+   *  @name   Done
+   *  @fn     void Done(void)
+   *  @brief  Signal completion of one task
+   */
+  void Done(void);
+
+  /** Pool */
+  ThreadPool* pool_;
+  /** Number of tasks not completed yet */
+  std::atomic<std::size_t> pending_;
+  /** Cancellation flag */
+  std::atomic<bool> cancelled_;
+  /** First error raised */
+  std::exception_ptr error_;
+  /** Synchronization */
+  std::mutex lock_;
+  /** Completion signal */
+  std::condition_variable cond_;
+};
+
+#pragma mark -
+#pragma mark Implementation
+
+/*
+ *  @name   Run
+ *  @fn     void Run(F&& fn, const TaskPriority& priority)
+ *  @brief  Add a task to the group
+ *  @param[in] fn       Task with the signature `void(void)`
+ *  @param[in] priority Task's priority
+ *  @tparam F Callable type
+ */
+template<typename F>
+void TaskGroup::Run(F&& fn, const TaskPriority& priority) {
+  using Fcn = typename std::decay<F>::type;
+  pending_.fetch_add(1);
+  try {
+    pool_->Submit(priority, GroupTask<Fcn>{this, std::forward<F>(fn)});
+  } catch (...) {
+    this->Done();
+    throw;
+  }
+}
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_TASK_GROUP__ */
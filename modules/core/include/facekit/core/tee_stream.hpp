@@ -13,9 +13,17 @@
 #ifndef __FACEKIT_TEE_STREAM__
 #define __FACEKIT_TEE_STREAM__
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
+#include "facekit/core/library_export.hpp"
+
 /**
  *  @namespace  FaceKit
  *  @brief      Development space
@@ -114,6 +122,239 @@ class TeeStream : public std::ostream {
    *  @param[in] stream Stream to link with where mirrored data will be dumped
    */
   void LinkStream(std::ostream& stream);
+
+ private:
+  /** Mirroring buffer */
+  TeeStreambuf buffer_;
+};
+
+/**
+ *  @class  AsyncTeeStream
+ *  @brief  Mirroring stream writing synchronously to a primary stream (i.e.
+ *          console) while a background thread drains a copy into a
+ *          secondary stream (i.e. file or socket). The copy goes through a
+ *          bounded lock-free byte ring, the writer never waits on the
+ *          secondary device unless the ring is full and the policy is
+ *          `kBlock`. Flushing the stream (i.e. `std::endl`) only flushes
+ *          the primary, the secondary is drained and flushed periodically or
+ *          when the ring fills up. `Flush` waits for the secondary. Like any
+ *          `std::ostream`, a single thread writes at a time.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup core
+ */
+class FK_EXPORTS AsyncTeeStream : public std::ostream {
+ public:
+
+  /**
+   *  @enum   DropPolicy
+   *  @brief  Behaviour when the ring is full
+   */
+  enum class DropPolicy : char {
+    /** Wait until the background thread makes room */
+    kBlock,
+    /** Discard the secondary copy, the primary is always written */
+    kDrop
+  };
+
+  /** Default ring capacity in bytes */
+  static constexpr size_t kDefaultCapacity = 1 << 16;
+
+  /**
+   *  @name   AsyncTeeStream
+   *  @fn     AsyncTeeStream(std::ostream& primary, std::ostream& secondary,
+                             const size_t& capacity = kDefaultCapacity,
+                             const DropPolicy& policy = DropPolicy::kBlock)
+   *  @brief  Constructor, start the background thread
+   *  @param[in] primary    Stream written synchronously
+   *  @param[in] secondary  Stream written by the background thread, must not
+   *                        be used elsewhere while linked
+   *  @param[in] capacity   Ring size in bytes, rounded up to a power of two
+   *  @param[in] policy     Behaviour when the ring is full
+   */
+  AsyncTeeStream(std::ostream& primary,
+                 std::ostream& secondary,
+                 const size_t& capacity = kDefaultCapacity,
+                 const DropPolicy& policy = DropPolicy::kBlock);
+
+  /**
+   *  @name   AsyncTeeStream
+   *  @fn     AsyncTeeStream(const AsyncTeeStream& other) = delete
+   *  @brief  Copy constructor
+   */
+  AsyncTeeStream(const AsyncTeeStream& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     AsyncTeeStream& operator=(const AsyncTeeStream& rhs) = delete
+   *  @brief  Copy assignment
+   */
+  AsyncTeeStream& operator=(const AsyncTeeStream& rhs) = delete;
+
+  /**
+   *  @name   ~AsyncTeeStream
+   *  @fn     ~AsyncTeeStream() override = default
+   *  @brief  Destructor, drain pending data and stop the background thread
+   */
+  ~AsyncTeeStream() override = default;
+
+  /**
+   *  @name   Flush
+   *  @fn     void Flush()
+   *  @brief  Flush both streams, wait until the secondary has received and
+   *          flushed everything written so far
+   */
+  void Flush();
+
+  /**
+   *  @name   n_dropped
+   *  @fn     size_t n_dropped() const
+   *  @brief  Number of bytes discarded from the secondary copy with
+   *          `DropPolicy::kDrop`
+   */
+  size_t n_dropped() const {
+    return buffer_.n_dropped();
+  }
+
+ private:
+
+  /**
+   *  @class  AsyncTeeStreambuf
+   *  @brief  Stream buffer batching writes in a small put area before
+   *          forwarding them to the primary and the ring
+   *  @author Christophe Ecabert
+   *  @date   15.11.18
+   *  @ingroup core
+   */
+  class AsyncTeeStreambuf : public std::basic_streambuf<char> {
+   private:
+    /** Base type */
+    using base_t = std::basic_streambuf<char>;
+
+   public:
+    /** Integer type */
+    using int_type = typename base_t::int_type;
+    /** Traits type */
+    using traits_type = typename base_t::traits_type;
+
+    /**
+     *  @name   AsyncTeeStreambuf
+     *  @fn     AsyncTeeStreambuf(std::streambuf* primary,
+                                  std::streambuf* secondary,
+                                  const size_t& capacity,
+                                  const DropPolicy& policy)
+     *  @brief  Constructor, start the background thread
+     */
+    AsyncTeeStreambuf(std::streambuf* primary,
+                      std::streambuf* secondary,
+                      const size_t& capacity,
+                      const DropPolicy& policy);
+
+    /**
+     *  @name   ~AsyncTeeStreambuf
+     *  @fn     ~AsyncTeeStreambuf() override
+     *  @brief  Destructor, drain pending data and stop the background thread
+     */
+    ~AsyncTeeStreambuf() override;
+
+    /**
+     *  @name   Flush
+     *  @fn     void Flush()
+     *  @brief  See `AsyncTeeStream::Flush`
+     */
+    void Flush();
+
+    /**
+     *  @name   overflow
+     *  @fn     int_type overflow(int_type c) override
+     *  @brief  C.f. C++ standard section 27.5.2.4.5
+     */
+    int_type overflow(int_type c) override;
+
+    /**
+     *  @name   sync
+     *  @fn     int sync() override
+     *  @brief  Forward buffered data and flush the primary
+     *  @return -1 on failure
+     */
+    int sync() override;
+
+    /**
+     *  @name   n_dropped
+     *  @fn     size_t n_dropped() const
+     *  @brief  Number of bytes discarded from the secondary copy
+     */
+    size_t n_dropped() const {
+      return n_dropped_.load(std::memory_order_relaxed);
+    }
+
+   private:
+
+    /**
+     *  @name   Forward
+     *  @fn     bool Forward()
+     *  @brief  Write the put area into the primary and the ring
+     *  @return False if the primary failed
+     */
+    bool Forward();
+
+    /**
+     *  @name   Push
+     *  @fn     void Push(const char* data, size_t n)
+     *  @brief  Copy data into the ring, producer side
+     */
+    void Push(const char* data, size_t n);
+
+    /**
+     *  @name   Drain
+     *  @fn     void Drain()
+     *  @brief  Write pending data into the secondary and flush it, consumer
+     *          side
+     */
+    void Drain();
+
+    /**
+     *  @name   Run
+     *  @fn     void Run()
+     *  @brief  Background thread's loop
+     */
+    void Run();
+
+    /** Size of the put area */
+    static constexpr size_t kPutSize = 256;
+
+    /** Put area */
+    char put_[kPutSize];
+    /** Stream written synchronously */
+    std::streambuf* primary_;
+    /** Stream written by the background thread */
+    std::streambuf* secondary_;
+    /** Ring */
+    std::unique_ptr<char[]> ring_;
+    /** Ring size minus one, power of two */
+    size_t mask_;
+    /** Full ring policy */
+    DropPolicy policy_;
+    /** Bytes written into the ring, only modified by the producer */
+    std::atomic<size_t> head_;
+    /** Bytes read from the ring, only modified by the consumer */
+    std::atomic<size_t> tail_;
+    /** Bytes written and flushed into the secondary */
+    std::atomic<size_t> synced_;
+    /** Number of dropped bytes */
+    std::atomic<size_t> n_dropped_;
+    /** Background thread */
+    std::thread worker_;
+    /** Background thread running flag */
+    bool running_;
+    /** Protect running_ */
+    std::mutex worker_mutex_;
+    /** Wake up background thread */
+    std::condition_variable worker_cv_;
+  };
+
+  /** Buffer */
+  AsyncTeeStreambuf buffer_;
 };
   
 }  // namespace FaceKit
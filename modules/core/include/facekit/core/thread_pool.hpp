@@ -16,12 +16,18 @@
 #include <thread>
 #include <functional>
 #include <future>
-#include <queue>
-#include <deque>
 #include <memory>
 #include <utility>
+#include <atomic>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <string>
+#include <array>
+#include <cstdint>
 
 #include "facekit/core/library_export.hpp"
+#include "facekit/core/inline_task.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -29,12 +35,81 @@
  */
 namespace FaceKit {
 
+/**
+ *  @class  ThreadPoolStatistic
+ *  @brief  Gather statistics for a thread pool
+ *  @author Christophe Ecabert
+ *  @date   17.12.17
+ *  @ingroup core
+ */
+class FK_EXPORTS ThreadPoolStatistic {
+ public:
+
+  /** Number of histogram's bins, bin `k` holds durations in
+   [2^(k-1), 2^k) us, first one below 1us and last one everything above */
+  static constexpr std::size_t kNBin = 20;
+
+  /** Histogram type */
+  using Histogram = std::array<std::size_t, kNBin>;
+
+  /**
+   *  @name   ThreadPoolStatistic
+   *  @fn     ThreadPoolStatistic(void)
+   *  @brief  Constructor
+   */
+  ThreadPoolStatistic(void);
+
+  /**
+   *  @name   Clear
+   *  @fn     void Clear(void)
+   *  @brief  Reset statistics
+   */
+  void Clear(void);
+
+  /**
+   *  @name   ToString
+   *  @fn     std::string ToString(void) const
+   *  @brief  Convert statistics to a readable string
+   *  @return String formatted statistics
+   */
+  std::string ToString(void) const;
+
+  /** Number of tasks enqueued */
+  std::size_t n_enqueued;
+  /** Number of tasks executed */
+  std::size_t n_executed;
+  /** Number of tasks taken from another worker's queue */
+  std::size_t n_stolen;
+  /** Number of tasks waiting to be picked up */
+  std::size_t queue_depth;
+  /** Histogram of the time between enqueue and start */
+  Histogram wait_time;
+  /** Histogram of the execution time */
+  Histogram run_time;
+  /** Number of tasks executed by each worker */
+  std::vector<std::size_t> worker_executed;
+  /** Time spent running tasks by each worker, in ms */
+  std::vector<double> worker_busy;
+  /** Time spent waiting for tasks by each worker, in ms */
+  std::vector<double> worker_idle;
+};
+
 /**
  *  @class  ThreadPool
- *  @brief  Lightweight thread pool
+ *  @brief  Lightweight work-stealing thread pool.
  *  @author Christophe Ecabert
  *  @date   17.12.17
  *  @ingroup core
+ *  @details Each worker owns one deque per priority level. Tasks submitted
+ *           from inside a worker are pushed onto its own deque (LIFO for the
+ *           owner), tasks submitted from outside go through a global
+ *           injection queue. Idle workers steal from the front of a random
+ *           victim's deque. Higher priority tasks are always looked up first.
+ *           Tasks are stored inline in ring buffers and future's shared
+ *           states come from a pool, submission does not allocate in steady
+ *           state.
+ *           Pools can be created on their own or through the named registry
+ *           (`Get`). Workers can be restricted to a CPU set or a NUMA node.
  */
 class FK_EXPORTS ThreadPool {
  public:
@@ -55,15 +130,90 @@ class FK_EXPORTS ThreadPool {
     kHigh
   };
 
+  /** Number of priority level */
+  static constexpr std::size_t kNPriority = 3;
+
+  /**
+   *  @struct  Options
+   *  @brief  Pool configuration
+   *  @author Christophe Ecabert
+   *  @date   17.12.17
+   *  @ingroup core
+   */
+  struct Options {
+    /**
+     *  @name   Options
+     *  @fn     explicit Options(const std::size_t& size = 0)
+     *  @brief  Constructor
+     *  @param[in] size Number of workers
+     */
+    explicit Options(const std::size_t& size = 0) : size(size),
+                                                    name("default"),
+                                                    numa_node(-1),
+                                                    pin_workers(false) {}
+
+    /** Number of workers, if 0 taken from `FACEKIT_NUM_THREADS` or from the
+     hardware (size of the CPU set if any) */
+    std::size_t size;
+    /** Pool name, used for registry lookup and worker thread's name */
+    std::string name;
+    /** CPUs workers are allowed to run on, empty means no restriction */
+    std::vector<int> cpus;
+    /** NUMA node workers are bound to, -1 means no restriction. Combined
+     with `cpus` if both are given */
+    int numa_node;
+    /** If true, each worker is pinned to a single CPU of the set (round-robin)
+     otherwise all workers share the whole set */
+    bool pin_workers;
+  };
+
 #pragma mark -
 #pragma mark Initialization
 
   /**
    *  @name   Get
-   *  @fn     static ThreadPool& Get(const std::size_t& size = 4)
-   *  @brief  Singleton accessor
+   *  @fn     static ThreadPool& Get(const std::size_t& size = 0)
+   *  @brief  Default pool accessor. Created on first call, `size` is ignored
+   *          afterward.
+   *  @param[in] size Number of workers, 0 for automatic selection
+   *  @return Default pool
+   */
+  static ThreadPool& Get(const std::size_t& size = 0);
+
+  /**
+   *  @name   Get
+   *  @fn     static ThreadPool& Get(const Options& options)
+   *  @brief  Registry accessor. Return the pool named `options.name`, create
+   *          it with `options` if it does not exist yet.
+   *  @param[in] options  Pool configuration
+   *  @return Pool with the given name
+   */
+  static ThreadPool& Get(const Options& options);
+
+  /**
+   *  @name   Find
+   *  @fn     static ThreadPool* Find(const std::string& name)
+   *  @brief  Look for a registered pool
+   *  @param[in] name Pool's name
+   *  @return Pool or nullptr if no pool has been registered under `name`
    */
-  static ThreadPool& Get(const std::size_t& size = 4);
+  static ThreadPool* Find(const std::string& name);
+
+  /**
+   *  @name   ThreadPool
+   *  @fn     explicit ThreadPool(const std::size_t& size)
+   *  @brief  Constructor
+   *  @param[in]  size  Pool size, 0 for automatic selection
+   */
+  explicit ThreadPool(const std::size_t& size);
+
+  /**
+   *  @name   ThreadPool
+   *  @fn     explicit ThreadPool(const Options& options)
+   *  @brief  Constructor
+   *  @param[in]  options  Pool configuration
+   */
+  explicit ThreadPool(const Options& options);
 
   /**
    *  @name   ThreadPool
@@ -101,8 +251,8 @@ class FK_EXPORTS ThreadPool {
 
   /**
    *  @name   ~ThreadPool
-   *  @fn     ~ThreadPool(void) = default
-   *  @brief  Destructor
+   *  @fn     ~ThreadPool(void)
+   *  @brief  Destructor, wait till all pending tasks are completed
    */
   ~ThreadPool(void);
 
@@ -124,110 +274,512 @@ class FK_EXPORTS ThreadPool {
   auto Enqueue(const TaskPriority& priority, F&& f, Args&&... args)
   -> std::future<typename std::result_of<F(Args...)>::type>;
 
+  /**
+   *  @name Submit
+   *  @fn void Submit(const TaskPriority& priority, F&& f, Args&&... args)
+   *  @brief  Add a fire-and-forget job to the processing queue. No future is
+   *          created, exceptions thrown by the job are logged and discarded.
+   *  @param[in] priority Task's priority
+   *  @param[in] f        Function to call
+   *  @param[in] args     Function's argument
+   */
+  template<typename F, typename... Args>
+  void Submit(const TaskPriority& priority, F&& f, Args&&... args);
+
+  /**
+   *  @name   ParallelFor
+   *  @fn     void ParallelFor(const std::size_t& begin, const std::size_t& end,
+                               const std::size_t& grain, F&& fn)
+   *  @brief  Split the range [begin, end) into chunks of `grain` elements
+   *          and process them concurrently. The calling thread takes part in
+   *          the processing, therefore it can safely be called from within a
+   *          worker (i.e. nested parallelism).
+   *  @param[in] begin  First index
+   *  @param[in] end    Past-the-end index
+   *  @param[in] grain  Chunk size, if 0 it is selected automatically
+   *  @param[in] fn     Function called for each chunk with the signature
+   *                    `void(const std::size_t& first, const std::size_t& last)`
+   *  @tparam F Callable type
+   */
+  template<typename F>
+  void ParallelFor(const std::size_t& begin,
+                   const std::size_t& end,
+                   const std::size_t& grain,
+                   F&& fn);
+
+  /**
+   *  @name   ParallelReduce
+   *  @fn     T ParallelReduce(const std::size_t& begin, const std::size_t& end,
+                               const std::size_t& grain, const T& identity,
+                               F&& fn, R&& reduce)
+   *  @brief  Split the range [begin, end) into chunks of `grain` elements,
+   *          compute a partial result for each of them concurrently and
+   *          combine them. Partial results are combined in range order,
+   *          the outcome does not depend on the scheduling.
+   *  @param[in] begin    First index
+   *  @param[in] end      Past-the-end index
+   *  @param[in] grain    Chunk size, if 0 it is selected automatically
+   *  @param[in] identity Identity element of the reduction
+   *  @param[in] fn       Function computing the partial result of one chunk
+   *                      with the signature
+   *                      `T(const std::size_t& first, const std::size_t& last)`
+   *  @param[in] reduce   Function combining two partial results with the
+   *                      signature `T(const T& a, const T& b)`
+   *  @tparam T Result type
+   *  @tparam F Chunk callable type
+   *  @tparam R Reduction callable type
+   *  @return Reduced value
+   */
+  template<typename T, typename F, typename R>
+  T ParallelReduce(const std::size_t& begin,
+                   const std::size_t& end,
+                   const std::size_t& grain,
+                   const T& identity,
+                   F&& fn,
+                   R&& reduce);
+
+  /**
+   *  @name   RunPendingTask
+   *  @fn     bool RunPendingTask(void)
+   *  @brief  Run one pending task on the calling thread if any. Used to help
+   *          the pool while waiting on something instead of blocking.
+   *  @return True if a task has been run, false if none was pending
+   */
+  bool RunPendingTask(void);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   size
+   *  @fn     std::size_t size(void) const
+   *  @brief  Number of workers in the pool
+   *  @return Pool size
+   */
+  std::size_t size(void) const {
+    return workers_.size();
+  }
+
+  /**
+   *  @name   name
+   *  @fn     const std::string& name(void) const
+   *  @brief  Pool's name
+   *  @return Name
+   */
+  const std::string& name(void) const {
+    return name_;
+  }
+
+  /**
+   *  @name   worker_index
+   *  @fn     int worker_index(void) const
+   *  @brief  Index of the calling thread within this pool
+   *  @return Worker index or -1 if the caller is not one of this pool's
+   *          workers
+   */
+  int worker_index(void) const;
+
+#pragma mark -
+#pragma mark Statistics
+
+  /**
+   *  @name   EnableStatistics
+   *  @fn     void EnableStatistics(const bool& enable)
+   *  @brief  Toggle timing statistics (latency, execution and idle time).
+   *          Task counters are always collected.
+   *  @param[in]  enable  Indicate if timings are collected or not
+   */
+  void EnableStatistics(const bool& enable) {
+    timing_ = enable;
+  }
+
+  /**
+   *  @name   GatherStatistics
+   *  @fn     void GatherStatistics(ThreadPoolStatistic* stats) const
+   *  @brief  Aggregate per-thread counters
+   *  @param[out] stats   Object filled with statistics from this pool
+   */
+  void GatherStatistics(ThreadPoolStatistic* stats) const;
+
+  /**
+   *  @name   ClearStatistics
+   *  @fn     void ClearStatistics(void)
+   *  @brief  Clear pool's statistics
+   */
+  void ClearStatistics(void);
+
 #pragma mark -
 #pragma mark Private
  private:
 
   /** Task type */
-  using Task = std::pair<TaskPriority, std::function<void()>>;
+  using Task = InlineTask;
+
+  /** Counter type */
+  using Counter = std::atomic<std::uint64_t>;
 
   /**
-   *  @struct  TaskComparator
-   *  @brief  Functor sorting task by priority
+   *  @struct  Job
+   *  @brief  Queued task
+   */
+  struct Job {
+    /** Task */
+    Task task;
+    /** Enqueue time in ns, 0 if timings are not collected */
+    std::int64_t stamp;
+  };
+
+  /**
+   *  @struct  Counters
+   *  @brief  Statistics collected by one thread
+   */
+  struct Counters {
+    /** Tasks enqueued */
+    Counter n_enqueued;
+    /** Tasks executed */
+    Counter n_executed;
+    /** Tasks stolen */
+    Counter n_stolen;
+    /** Time spent running tasks, ns */
+    Counter busy;
+    /** Time spent waiting for tasks, ns */
+    Counter idle;
+    /** Wait time histogram */
+    Counter wait_time[ThreadPoolStatistic::kNBin];
+    /** Execution time histogram */
+    Counter run_time[ThreadPoolStatistic::kNBin];
+
+    /**
+     *  @name   Counters
+     *  @fn     Counters(void)
+     *  @brief  Constructor
+     */
+    Counters(void);
+
+    /**
+     *  @name   Clear
+     *  @fn     void Clear(void)
+     *  @brief  Reset counters
+     */
+    void Clear(void);
+  };
+
+  /** Function processing the range [first, last) on a type-erased context */
+  using RangeFcn = void (*)(void* ctx,
+                            const std::size_t& first,
+                            const std::size_t& last);
+
+  /**
+   *  @name   RangeTrampoline
+   *  @fn     static void RangeTrampoline(void* ctx, const std::size_t& first,
+                                          const std::size_t& last)
+   *  @brief  Forward a range to a callable of type `F` stored in `ctx`
+   *  @tparam F Callable type
+   */
+  template<typename F>
+  static void RangeTrampoline(void* ctx,
+                              const std::size_t& first,
+                              const std::size_t& last) {
+    (*static_cast<F*>(ctx))(first, last);
+  }
+
+  /**
+   *  @class  TaskQueue
+   *  @brief  Double ended task queue stored in a growing ring buffer. Owner
+   *          works on the back, thieves on the front. Capacity is never
+   *          released, pushing and popping do not allocate in steady state.
    *  @author Christophe Ecabert
    *  @date   17.12.17
    *  @ingroup core
    */
-  struct TaskComparator {
+  class TaskQueue {
+   public:
+
+    /**
+     *  @name   TaskQueue
+     *  @fn     TaskQueue(void)
+     *  @brief  Constructor
+     */
+    TaskQueue(void);
+
+    /**
+     *  @name   PushBack
+     *  @fn     void PushBack(Job&& job)
+     *  @brief  Add a job at the back of the queue
+     *  @param[in] job  Job to add
+     */
+    void PushBack(Job&& job);
 
     /**
-     *  @name   operator()
-     *  @fn     bool operator()(const TaskPriority& lhs,
-     const TaskPriority& rhs) const
-     *  @brief  Compare two task prioty
+     *  @name   PopBack
+     *  @fn     bool PopBack(Job* job)
+     *  @brief  Take the most recently added job (owner side)
+     *  @param[out] job Job taken
+     *  @return True if a job has been taken, false if queue is empty
      */
-    bool operator()(const Task& lhs, const Task& rhs) const {
-      return lhs.first > rhs.first;
+    bool PopBack(Job* job);
+
+    /**
+     *  @name   PopFront
+     *  @fn     bool PopFront(Job* job)
+     *  @brief  Take the oldest job (thief / injection side)
+     *  @param[out] job Job taken
+     *  @return True if a job has been taken, false if queue is empty
+     */
+    bool PopFront(Job* job);
+
+   private:
+    /** Jobs, capacity is a power of two */
+    std::vector<Job> jobs_;
+    /** Position of the first task */
+    std::size_t head_;
+    /** Number of tasks in the queue */
+    std::size_t size_;
+    /** Synchronization */
+    std::mutex lock_;
+  };
+
+  /**
+   *  @struct  StateAllocator
+   *  @brief  Allocator drawing future's shared states from the pool's block
+   *          cache instead of the system allocator.
+   *  @author Christophe Ecabert
+   *  @date   17.12.17
+   *  @ingroup core
+   *  @tparam T Value type
+   */
+  template<typename T>
+  struct StateAllocator {
+    /** Value type */
+    using value_type = T;
+
+    /** Rebind */
+    template<typename U>
+    struct rebind {
+      /** Rebinded type */
+      using other = StateAllocator<U>;
+    };
+
+    StateAllocator(void) = default;
+
+    template<typename U>
+    StateAllocator(const StateAllocator<U>& other) {}
+
+    T* allocate(const std::size_t n) {
+      return static_cast<T*>(ThreadPool::AllocateState(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, const std::size_t n) {
+      ThreadPool::ReleaseState(ptr, n * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const StateAllocator<U>& rhs) const {
+      return true;
+    }
+
+    template<typename U>
+    bool operator!=(const StateAllocator<U>& rhs) const {
+      return false;
     }
   };
 
-  /** Priority queue type */
-  using PriorityQueue = std::priority_queue<Task,
-                                            std::deque<Task>,
-                                            ThreadPool::TaskComparator>;
+  /**
+   *  @struct  PromiseTask
+   *  @brief  Callable running a bound function and forwarding its outcome to
+   *          a promise.
+   *  @author Christophe Ecabert
+   *  @date   17.12.17
+   *  @ingroup core
+   *  @tparam R Return type
+   *  @tparam Fn  Bound function type
+   */
+  template<typename R, typename Fn>
+  struct PromiseTask {
+    /** Result holder */
+    std::promise<R> promise;
+    /** Function */
+    Fn fn;
+
+    void operator()(void) {
+      try {
+        promise.set_value(fn());
+      } catch (...) {
+        promise.set_exception(std::current_exception());
+      }
+    }
+  };
 
   /**
-   *  @name   ThreadPool
-   *  @fn     ThreadPool(const std::size_t& size)
-   *  @brief  Constructor
-   *  @param[in]  size  Pool size
+   *  @struct  PromiseTask
+   *  @brief  Callable running a bound function and forwarding its outcome to
+   *          a promise. Specialization for function without return value.
+   *  @author Christophe Ecabert
+   *  @date   17.12.17
+   *  @ingroup core
+   *  @tparam Fn  Bound function type
+   */
+  template<typename Fn>
+  struct PromiseTask<void, Fn> {
+    /** Result holder */
+    std::promise<void> promise;
+    /** Function */
+    Fn fn;
+
+    void operator()(void) {
+      try {
+        fn();
+        promise.set_value();
+      } catch (...) {
+        promise.set_exception(std::current_exception());
+      }
+    }
+  };
+
+  /**
+   *  @name   AllocateState
+   *  @fn     static void* AllocateState(const std::size_t& size)
+   *  @brief  Get a block of at least `size` bytes from the block cache
+   *  @param[in] size Number of bytes needed
+   *  @return Memory block
+   */
+  static void* AllocateState(const std::size_t& size);
+
+  /**
+   *  @name   ReleaseState
+   *  @fn     static void ReleaseState(void* ptr, const std::size_t& size)
+   *  @brief  Give back a block obtained with `AllocateState`
+   *  @param[in] ptr  Memory block
+   *  @param[in] size Number of bytes requested at allocation time
+   */
+  static void ReleaseState(void* ptr, const std::size_t& size);
+
+  /**
+   *  @struct  Worker
+   *  @brief  Per worker state
+   *  @author Christophe Ecabert
+   *  @date   17.12.17
+   *  @ingroup core
+   */
+  struct Worker {
+    /** Local queues, one per priority level */
+    TaskQueue queues[kNPriority];
+    /** Random state used to select victims */
+    unsigned int seed;
+    /** CPUs the worker is allowed to run on, empty if not restricted */
+    std::vector<int> cpus;
+    /** Statistics */
+    Counters counters;
+    /** Thread */
+    std::thread thread;
+  };
+
+  /**
+   *  @name   Push
+   *  @fn     void Push(const TaskPriority& priority, Task&& task)
+   *  @brief  Push a task either on the caller local queue if it belongs to
+   *          this pool or on the global injection queue otherwise.
+   *  @param[in] priority Task's priority
+   *  @param[in] task     Task to schedule
+   */
+  void Push(const TaskPriority& priority, Task&& task);
+
+  /**
+   *  @name   ChunkSize
+   *  @fn     std::size_t ChunkSize(const std::size_t& n,
+                                    const std::size_t& grain) const
+   *  @brief  Select the number of elements processed by one chunk
+   *  @param[in] n      Range length
+   *  @param[in] grain  User defined grain, 0 for automatic selection
+   *  @return Chunk size
+   */
+  std::size_t ChunkSize(const std::size_t& n, const std::size_t& grain) const;
+
+  /**
+   *  @name   ParallelForImpl
+   *  @fn     void ParallelForImpl(const std::size_t& begin,
+                                   const std::size_t& end,
+                                   const std::size_t& grain,
+                                   RangeFcn fcn, void* ctx)
+   *  @brief  Type-erased implementation of `ParallelFor`
+   *  @param[in] begin  First index
+   *  @param[in] end    Past-the-end index
+   *  @param[in] grain  Chunk size, if 0 it is selected automatically
+   *  @param[in] fcn    Range function
+   *  @param[in] ctx    Context given to `fcn`
+   */
+  void ParallelForImpl(const std::size_t& begin,
+                       const std::size_t& end,
+                       const std::size_t& grain,
+                       RangeFcn fcn,
+                       void* ctx);
+
+  /**
+   *  @name   Pop
+   *  @fn     bool Pop(const int& index, Job* job)
+   *  @brief  Look for a job to run, priority first, then local queue,
+   *          global queue and finally steal from other workers.
+   *  @param[in] index  Index of the worker looking for job
+   *  @param[out] job   Job found
+   *  @return True if a job has been found, false otherwise
+   */
+  bool Pop(const int& index, Job* job);
+
+  /**
+   *  @name   Execute
+   *  @fn     void Execute(const int& index, Job* job)
+   *  @brief  Run a job and release it right away
+   *  @param[in] index  Index of the worker running the job, -1 if external
+   *  @param[in,out] job  Job to run
+   */
+  void Execute(const int& index, Job* job);
+
+  /**
+   *  @name   GetCounters
+   *  @fn     Counters& GetCounters(const int& index)
+   *  @brief  Statistics slot of a given thread
+   *  @param[in] index  Worker index, -1 for external threads
+   *  @return Counters
+   */
+  Counters& GetCounters(const int& index) {
+    return index >= 0 ? workers_[index]->counters : external_;
+  }
+
+  /**
+   *  @name   Run
+   *  @fn     void Run(const int& index)
+   *  @brief  Worker main loop
+   *  @param[in] index  Worker's index
    */
-  ThreadPool(const std::size_t& size);
+  void Run(const int& index);
 
+  /** Name */
+  std::string name_;
   /** Workers */
-  std::vector<std::thread> workers_;
-  /** Task queue */
-  PriorityQueue queue_;
-  /** Synchronization - Enqueue task */
-  std::mutex queue_lock_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  /** Global injection queues for external submitter, one per priority */
+  TaskQueue global_[kNPriority];
+  /** Number of task waiting to be picked up */
+  std::atomic<std::size_t> n_pending_;
+  /** Number of workers sleeping */
+  std::atomic<std::size_t> n_sleeping_;
   /** Synchronization - Conditional signal */
   std::mutex cond_lock_;
   /** Conditional variable */
   std::condition_variable cond_;
   /** Stop flag */
-  bool stop_;
+  std::atomic<bool> stop_;
+  /** Statistics of non-worker threads */
+  Counters external_;
+  /** Timing collection flag */
+  std::atomic<bool> timing_;
 };
 
 #pragma mark -
 #pragma mark Implementation
 
 /*
- *  @name   Get
- *  @fn     static ThreadPool& Get(const std::size_t& size = 4)
- *  @brief  Singleton accessor
- */
-ThreadPool& ThreadPool::Get(const std::size_t& size /*= 4*/) {
-  static ThreadPool pool(size);
-  return pool;
-}
-
-/*
- *  @name   ThreadPool
- *  @fn     ThreadPool(const std::size_t& size)
- *  @brief  Constructor
- *  @param[in]  size  Pool size
- */
-ThreadPool::ThreadPool(const std::size_t& size) : stop_(false) {
-  // Initialize workers
-  for (std::size_t i = 0; i < size; ++i) {
-    workers_.emplace_back([this](){
-      // Loop forever
-      while(true) {
-        // Get task
-        std::function<void()> task;
-        // Wait till some tasks are pending or if we stop
-        {
-          std::unique_lock<std::mutex> lock(this->cond_lock_);
-          this->cond_.wait(lock, [this](void) {
-            return this->stop_ || !this->queue_.empty();
-          });
-          // Stopping ?
-          if (this->stop_ && this->queue_.empty()) {
-            return;
-          }
-          // Queue not empty, pick pending job
-          task = std::move(this->queue_.top().second);
-          this->queue_.pop();
-        }
-        // Execute task
-        task();
-      }
-    });
-  }
-}
-
-/*
- *  @name
+ *  @name Enqueue
  *  @brief  Add job to the processing queue
  *  @param[in] priority Task's priority
  *  @param[in] f        Function to call
@@ -240,42 +792,105 @@ auto ThreadPool::Enqueue(const TaskPriority& priority, F&& f, Args&&... args)
 -> std::future<typename std::result_of<F(Args...)>::type> {
   // Fcn return type
   using rtype = typename std::result_of<F(Args...)>::type;
-  // Create task
-  auto task = std::make_shared<std::packaged_task<rtype()>>(std::bind(std::forward<F>(f),
-                                                                      std::forward<Args>(args)...));
+  using Bound = decltype(std::bind(std::forward<F>(f),
+                                   std::forward<Args>(args)...));
+  // Create task, shared state comes from the block cache and the task is
+  // stored inline
+  std::promise<rtype> promise(std::allocator_arg, StateAllocator<rtype>());
   // Define return object
-  auto res = task->get_future();
+  auto res = promise.get_future();
   // Add to queue
-  {
-    std::unique_lock<std::mutex> lock(this->queue_lock_);
-    if (this->stop_) {
-      throw std::runtime_error("Error, try to add task on stopped pool");
-    }
-    this->queue_.emplace(priority, [task](void){ (*task)();});
-  }
-  // Signal new job
-  this->cond_.notify_one();
+  this->Push(priority,
+             Task(PromiseTask<rtype, Bound>{std::move(promise),
+                                            std::bind(std::forward<F>(f),
+                                                      std::forward<Args>(args)...)}));
   // Return future object
   return res;
 }
 
 /*
- *  @name   ~ThreadPool
- *  @fn     ~ThreadPool(void)
- *  @brief  Destructor
+ *  @name Submit
+ *  @fn void Submit(const TaskPriority& priority, F&& f, Args&&... args)
+ *  @brief  Add a fire-and-forget job to the processing queue.
+ *  @param[in] priority Task's priority
+ *  @param[in] f        Function to call
+ *  @param[in] args     Function's argument
+ */
+template<typename F, typename... Args>
+void ThreadPool::Submit(const TaskPriority& priority, F&& f, Args&&... args) {
+  this->Push(priority, Task(std::bind(std::forward<F>(f),
+                                      std::forward<Args>(args)...)));
+}
+
+/*
+ *  @name   ParallelFor
+ *  @fn     void ParallelFor(const std::size_t& begin, const std::size_t& end,
+                             const std::size_t& grain, F&& fn)
+ *  @brief  Split the range [begin, end) into chunks of `grain` elements
+ *          and process them concurrently.
+ *  @param[in] begin  First index
+ *  @param[in] end    Past-the-end index
+ *  @param[in] grain  Chunk size, if 0 it is selected automatically
+ *  @param[in] fn     Function called for each chunk
  */
-ThreadPool::~ThreadPool(void) {
-  // Stop queue
-  {
-    std::unique_lock<std::mutex> lock(this->queue_lock_);
-    this->stop_ = true;
+template<typename F>
+void ThreadPool::ParallelFor(const std::size_t& begin,
+                             const std::size_t& end,
+                             const std::size_t& grain,
+                             F&& fn) {
+  using Fcn = typename std::remove_reference<F>::type;
+  using MutableFcn = typename std::remove_const<Fcn>::type;
+  this->ParallelForImpl(begin,
+                        end,
+                        grain,
+                        &ThreadPool::RangeTrampoline<Fcn>,
+                        static_cast<void*>(const_cast<MutableFcn*>(&fn)));
+}
+
+/*
+ *  @name   ParallelReduce
+ *  @fn     T ParallelReduce(const std::size_t& begin, const std::size_t& end,
+                             const std::size_t& grain, const T& identity,
+                             F&& fn, R&& reduce)
+ *  @brief  Split the range [begin, end) into chunks of `grain` elements,
+ *          compute a partial result for each of them concurrently and
+ *          combine them in range order.
+ *  @param[in] begin    First index
+ *  @param[in] end      Past-the-end index
+ *  @param[in] grain    Chunk size, if 0 it is selected automatically
+ *  @param[in] identity Identity element of the reduction
+ *  @param[in] fn       Function computing the partial result of one chunk
+ *  @param[in] reduce   Function combining two partial results
+ *  @return Reduced value
+ */
+template<typename T, typename F, typename R>
+T ThreadPool::ParallelReduce(const std::size_t& begin,
+                             const std::size_t& end,
+                             const std::size_t& grain,
+                             const T& identity,
+                             F&& fn,
+                             R&& reduce) {
+  if (end <= begin) {
+    return identity;
   }
-  // Signal all waiting thread to run
-  this->cond_.notify_all();
-  // Wait till all threads are done
-  for (std::thread& thr : this->workers_) {
-    thr.join();
+  // Split range, one partial result per chunk
+  const std::size_t n = end - begin;
+  const std::size_t chunk = this->ChunkSize(n, grain);
+  const std::size_t n_chunk = (n + chunk - 1) / chunk;
+  std::vector<T> partials(n_chunk, identity);
+  this->ParallelFor(0, n_chunk, 1, [&](const std::size_t& first,
+                                       const std::size_t& last) {
+    for (std::size_t c = first; c < last; ++c) {
+      const std::size_t b = begin + c * chunk;
+      partials[c] = fn(b, std::min(end, b + chunk));
+    }
+  });
+  // Combine
+  T res = identity;
+  for (std::size_t c = 0; c < n_chunk; ++c) {
+    res = reduce(res, partials[c]);
   }
+  return res;
 }
 
 }  // namespace FaceKit
@@ -0,0 +1,359 @@
+/**
+ *  @file   trace.hpp
+ *  @brief  Scoped tracing zones recorded into per-thread buffers and exported
+ *          into Chrome's trace event format (chrome://tracing, Perfetto)
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   06.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_TRACE__
+#define __FACEKIT_TRACE__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/core/sys/perf_counter.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  Tracer
+ *  @brief  Collect timed zones emitted by `FACEKIT_TRACE_SCOPE`. Each thread
+ *          appends into its own buffer, nothing is recorded unless tracing is
+ *          enabled either with `Enable` or with the `FACEKIT_TRACE`
+ *          environment variable. Zones can also capture the hardware
+ *          counters of their thread (see `EnableCounters`).
+ *  @author Christophe Ecabert
+ *  @date   06.09.18
+ *  @ingroup core
+ */
+class FK_EXPORTS Tracer {
+ public:
+
+  /** Default maximum number of events kept per thread */
+  static constexpr size_t kDefaultBufferCapacity = 1 << 20;
+
+  /**
+   *  @struct Event
+   *  @brief  Completed zone
+   */
+  struct Event {
+    /** Zone name, static storage */
+    const char* name;
+    /** Start time, ns */
+    int64_t start;
+    /** Duration, ns */
+    int64_t duration;
+    /** Hardware counts within the zone, none if not captured */
+    PerfCounters::Sample counters;
+  };
+
+  /**
+   *  @name   Get
+   *  @fn     static Tracer& Get(void)
+   *  @brief  Tracer single instance
+   *  @return Tracer
+   */
+  static Tracer& Get(void);
+
+  /**
+   *  @name   Tracer
+   *  @fn     Tracer(const Tracer& other) = delete
+   *  @brief  Copy constructor
+   */
+  Tracer(const Tracer& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     Tracer& operator=(const Tracer& rhs) = delete
+   *  @brief  Copy assignment
+   */
+  Tracer& operator=(const Tracer& rhs) = delete;
+
+  /**
+   *  @name   IsEnabled
+   *  @fn     static bool IsEnabled(void)
+   *  @brief  Indicate if zones are recorded
+   *  @return True if enabled
+   */
+  static bool IsEnabled(void) {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   *  @name   Enable
+   *  @fn     static void Enable(const bool& enable)
+   *  @brief  Start / stop recording
+   *  @param[in] enable True to record zones
+   */
+  static void Enable(const bool& enable) {
+    enabled_.store(enable, std::memory_order_relaxed);
+  }
+
+  /**
+   *  @name   CountersEnabled
+   *  @fn     static bool CountersEnabled(void)
+   *  @brief  Indicate if zones capture hardware counters
+   *  @return True if enabled
+   */
+  static bool CountersEnabled(void) {
+    return counters_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   *  @name   EnableCounters
+   *  @fn     static void EnableCounters(const bool& enable)
+   *  @brief  Capture hardware counters (see `PerfCounters`) in recorded
+   *          zones, two extra reads per zone. Also enabled with the
+   *          `FACEKIT_TRACE_COUNTERS` environment variable.
+   *  @param[in] enable True to capture counters
+   */
+  static void EnableCounters(const bool& enable) {
+    counters_.store(enable, std::memory_order_relaxed);
+  }
+
+  /**
+   *  @name   Now
+   *  @fn     static int64_t Now(void)
+   *  @brief  Monotonic time
+   *  @return Time in ns
+   */
+  static int64_t Now(void) {
+    using Clock = std::chrono::steady_clock;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now().time_since_epoch()).count();
+  }
+
+  /**
+   *  @name   Record
+   *  @fn     void Record(const char* name, const int64_t& start,
+                          const int64_t& stop)
+   *  @brief  Add a completed zone to the calling thread's buffer
+   *  @param[in] name   Zone name, static storage
+   *  @param[in] start  Start time, ns
+   *  @param[in] stop   Stop time, ns
+   */
+  void Record(const char* name, const int64_t& start, const int64_t& stop);
+
+  /**
+   *  @name   Record
+   *  @fn     void Record(const char* name, const int64_t& start,
+                          const int64_t& stop,
+                          const PerfCounters::Sample& counters)
+   *  @brief  Add a completed zone with its hardware counts to the calling
+   *          thread's buffer
+   *  @param[in] name     Zone name, static storage
+   *  @param[in] start    Start time, ns
+   *  @param[in] stop     Stop time, ns
+   *  @param[in] counters Counts within the zone
+   */
+  void Record(const char* name,
+              const int64_t& start,
+              const int64_t& stop,
+              const PerfCounters::Sample& counters);
+
+  /**
+   *  @name   SetThreadName
+   *  @fn     void SetThreadName(const std::string& name)
+   *  @brief  Label the calling thread in exported traces
+   *  @param[in] name   Thread's name
+   */
+  void SetThreadName(const std::string& name);
+
+  /**
+   *  @name   Clear
+   *  @fn     void Clear(void)
+   *  @brief  Drop every recorded event
+   */
+  void Clear(void);
+
+  /**
+   *  @name   Size
+   *  @fn     size_t Size(void) const
+   *  @brief  Number of recorded events over all threads
+   *  @return Number of events
+   */
+  size_t Size(void) const;
+
+  /**
+   *  @name   set_buffer_capacity
+   *  @fn     void set_buffer_capacity(const size_t& capacity)
+   *  @brief  Maximum number of events kept per thread, later events are
+   *          dropped
+   *  @param[in] capacity   Capacity
+   */
+  void set_buffer_capacity(const size_t& capacity) {
+    capacity_.store(capacity, std::memory_order_relaxed);
+  }
+
+  /**
+   *  @name   get_n_dropped
+   *  @fn     size_t get_n_dropped(void) const
+   *  @brief  Number of events dropped because a buffer was full
+   *  @return Number of dropped events
+   */
+  size_t get_n_dropped(void) const {
+    return n_dropped_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   *  @name   ExportChromeTrace
+   *  @fn     Status ExportChromeTrace(std::ostream& stream) const
+   *  @brief  Write recorded events as Chrome trace event JSON, loadable by
+   *          chrome://tracing and ui.perfetto.dev. Hardware counts are
+   *          given as event arguments.
+   *  @param[in] stream Output stream
+   *  @return kInternalError if the stream is in a bad state
+   */
+  Status ExportChromeTrace(std::ostream& stream) const;
+
+  /**
+   *  @name   ExportChromeTrace
+   *  @fn     Status ExportChromeTrace(const std::string& filename) const
+   *  @brief  Write recorded events as Chrome trace event JSON into a file
+   *  @param[in] filename   Output file
+   *  @return kInvalidArgument if the file can not be opened
+   */
+  Status ExportChromeTrace(const std::string& filename) const;
+
+ private:
+  /** Forward declaration */
+  struct Buffer;
+
+  /**
+   *  @name   Tracer
+   *  @fn     Tracer(void)
+   *  @brief  Constructor
+   */
+  Tracer(void);
+
+  /**
+   *  @name   ThreadBuffer
+   *  @fn     Buffer& ThreadBuffer(void)
+   *  @brief  Calling thread's buffer, registered on first use
+   *  @return Buffer
+   */
+  Buffer& ThreadBuffer(void);
+
+  /** Recording flag */
+  static std::atomic<bool> enabled_;
+  /** Counter capture flag */
+  static std::atomic<bool> counters_;
+  /** Per thread capacity */
+  std::atomic<size_t> capacity_;
+  /** Dropped events */
+  std::atomic<size_t> n_dropped_;
+  /** Thread buffers, kept after thread exit until cleared */
+  std::vector<std::shared_ptr<Buffer>> buffers_;
+  /** Protect buffers_ */
+  mutable std::mutex buffers_mutex_;
+  /** Next thread identifier */
+  std::atomic<uint32_t> next_tid_;
+  /** Time origin of exported traces, ns */
+  int64_t origin_;
+};
+
+/**
+ *  @class  TraceScope
+ *  @brief  RAII zone, recorded when going out of scope if tracing was enabled
+ *          when entering it. Captures the thread's hardware counters if
+ *          requested and available.
+ *  @author Christophe Ecabert
+ *  @date   06.09.18
+ *  @ingroup core
+ */
+class TraceScope {
+ public:
+  /**
+   *  @name   TraceScope
+   *  @fn     explicit TraceScope(const char* name)
+   *  @brief  Constructor, open zone
+   *  @param[in] name   Zone name, static storage
+   */
+  explicit TraceScope(const char* name) :
+    name_(name),
+    start_(0),
+    counters_(nullptr) {
+    if (Tracer::IsEnabled()) {
+      if (Tracer::CountersEnabled()) {
+        counters_ = PerfCounters::ThreadCounters();
+        if (counters_ && !counters_->Read(&start_counters_).Good()) {
+          counters_ = nullptr;
+        }
+      }
+      start_ = Tracer::Now();
+    }
+  }
+
+  /**
+   *  @name   TraceScope
+   *  @fn     TraceScope(const TraceScope& other) = delete
+   *  @brief  Copy constructor
+   */
+  TraceScope(const TraceScope& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     TraceScope& operator=(const TraceScope& rhs) = delete
+   *  @brief  Copy assignment
+   */
+  TraceScope& operator=(const TraceScope& rhs) = delete;
+
+  /**
+   *  @name   ~TraceScope
+   *  @fn     ~TraceScope(void)
+   *  @brief  Destructor, close zone
+   */
+  ~TraceScope(void) {
+    if (start_ != 0) {
+      const int64_t stop = Tracer::Now();
+      PerfCounters::Sample stop_counters;
+      if (counters_ && counters_->Read(&stop_counters).Good()) {
+        Tracer::Get().Record(name_, start_, stop,
+                             stop_counters - start_counters_);
+      } else {
+        Tracer::Get().Record(name_, start_, stop);
+      }
+    }
+  }
+
+ private:
+  /** Name */
+  const char* name_;
+  /** Start time, 0 if not recorded */
+  int64_t start_;
+  /** Thread's counters, nullptr if not captured */
+  PerfCounters* counters_;
+  /** Counters when entering the zone */
+  PerfCounters::Sample start_counters_;
+};
+
+}  // namespace FaceKit
+
+#define FACEKIT_TRACE_CONCAT_IMPL(a, b) a##b
+#define FACEKIT_TRACE_CONCAT(a, b) FACEKIT_TRACE_CONCAT_IMPL(a, b)
+
+/** Time the enclosing scope, `name` must have static storage */
+#ifndef FACEKIT_NO_TRACE
+#define FACEKIT_TRACE_SCOPE(name)                                             \
+  FaceKit::TraceScope FACEKIT_TRACE_CONCAT(facekit_trace_, __LINE__)(name)
+#else
+#define FACEKIT_TRACE_SCOPE(name) ((void)0)
+#endif
+
+#endif  // __FACEKIT_TRACE__
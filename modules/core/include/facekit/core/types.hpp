@@ -13,6 +13,8 @@
 
 #include <string>
 
+#include "facekit/core/half.hpp"
+
 /**
  *  @namespace  FaceKit
  *  @brief      Development space
@@ -50,7 +52,9 @@ enum class DataType : int {
   /** Bool */
   kBool = 11,
   /** String */
-  kString = 12
+  kString = 12,
+  /** Half - 16bits */
+  kHalf = 13
 };
   
 /**
@@ -180,6 +184,8 @@ SPECIALIZE_TYPE_AND_ENUM(double, DataType::kDouble, sizeof(double));
 SPECIALIZE_TYPE_AND_ENUM(bool, DataType::kBool, sizeof(bool));
 /** string Specialization */
 SPECIALIZE_TYPE_AND_ENUM(std::string, DataType::kString, sizeof(std::string));
+/** Half Specialization */
+SPECIALIZE_TYPE_AND_ENUM(Half, DataType::kHalf, sizeof(Half));
   
 #undef SPECIALIZE_TYPE_AND_ENUM
   
@@ -15,6 +15,8 @@
 #include <cstdint>
 #include <string>
 
+#include "facekit/core/utils/string_view.hpp"
+
 /**
  *  @namespace  FaceKit
  *  @brief      Development space
@@ -87,11 +89,27 @@ class Scanner {
   
   /**
    *  @name   Scanner
-   *  @fn     explicit Scanner(const std::string& str)
-   *  @brief  Constructor
+   *  @fn     explicit Scanner(const StringView& str)
+   *  @brief  Constructor. The input is not copied, it must outlive the
+   *          scanner and any view returned by `Result`.
    *  @param[in] str  String to parse
    */
-  explicit Scanner(const std::string& str);
+  explicit Scanner(const StringView& str);
+
+  /**
+   *  @name   Scanner
+   *  @fn     explicit Scanner(const char* str)
+   *  @brief  Constructor
+   *  @param[in] str  Null-terminated string to parse
+   */
+  explicit Scanner(const char* str) : Scanner(StringView(str)) {}
+
+  /**
+   *  @name   Scanner
+   *  @fn     Scanner(std::string&& str) = delete
+   *  @brief  Scanning a temporary would leave dangling pointers
+   */
+  Scanner(std::string&& str) = delete;
   
   /**
    *  @name   Scanner
@@ -133,23 +151,23 @@ class Scanner {
   
   /**
    *  @name   ZeroOrOneLiteral
-   *  @fn     Scanner& ZeroOrOneLiteral(const std::string& s)
+   *  @fn     Scanner& ZeroOrOneLiteral(const StringView& s)
    *  @brief  Consume the next s.size() characters of the input, if they match 
    *          `s`. If they don't match `s`, this is a no-op.
    *  @param[in] s  Literal to match
    *  @return This scanner
    */
-  Scanner& ZeroOrOneLiteral(const std::string& s);
+  Scanner& ZeroOrOneLiteral(const StringView& s);
   
   /**
    *  @name   OneLiteral
-   *  @fn     Scanner& OneLiteral(const std::string& s)
+   *  @fn     Scanner& OneLiteral(const StringView& s)
    *  @brief  Consume the next s.size() characters of the input, if they match
    *          `s`. If they don't match `s`, then Result will return false.
    *  @param[in] s  Literal to match
    *  @return This scanner
    */
-  Scanner& OneLiteral(const std::string& s);
+  Scanner& OneLiteral(const StringView& s);
   
   /**
    *  @name   Any
@@ -244,6 +262,17 @@ class Scanner {
    *  @return True if successfully matched, false otherwise.
    */
   bool Result(std::string* remaining = nullptr, std::string* capture = nullptr);
+
+  /**
+   *  @name   Result
+   *  @fn     bool Result(StringView* remaining, StringView* capture)
+   *  @brief  Same as `Result(std::string*, std::string*)` without copy, the
+   *          outputs are views into the scanned input.
+   *  @param[out] remaining Part of the string that as not been scanned
+   *  @param[out] capture   Part of the string that has been captured.
+   *  @return True if successfully matched, false otherwise.
+   */
+  bool Result(StringView* remaining, StringView* capture);
   
   
 #pragma mark -
@@ -269,12 +298,12 @@ class Scanner {
   
   /**
    *  @name   Consume
-   *  @fn     bool Consume(const std::string& s)
+   *  @fn     bool Consume(const StringView& s)
    *  @brief  Check if `s` match with the current position of the scanner. 
    *  @param[in]  s String to be matched
    *  @return True if `s` matched, false otherwise
    */
-  bool Consume(const std::string& s);
+  bool Consume(const StringView& s);
   
   /**
    *  @name   IsLetter
@@ -322,8 +351,6 @@ class Scanner {
    */
   static bool Matches(const CharType& type, const char& c);
 
-  /** String to be scanned */
-  std::string str_;
   /** Begining of the scanning region */
   const char* begin_;
   /** End of the scanning region */
@@ -350,7 +377,7 @@ class Scanner {
  *  @param[in] c  Char to control
  *  @return True if letter, false otherwise
  */
-bool Scanner::IsLetter(const char& c) {
+inline bool Scanner::IsLetter(const char& c) {
   return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
 }
 
@@ -361,7 +388,7 @@ bool Scanner::IsLetter(const char& c) {
  *  @param[in] c  Char to control
  *  @return True if lower letter, false otherwise
  */
-bool Scanner::IsLowerLetter(const char& c) {
+inline bool Scanner::IsLowerLetter(const char& c) {
   return c >= 'a' && c <= 'z';
 }
 
@@ -372,7 +399,7 @@ bool Scanner::IsLowerLetter(const char& c) {
  *  @param[in] c  Char to control
  *  @return True if number, false otherwise
  */
-bool Scanner::IsNumber(const char& c) {
+inline bool Scanner::IsNumber(const char& c) {
   return c >= '0' && c <= '9';
 }
 
@@ -383,7 +410,7 @@ bool Scanner::IsNumber(const char& c) {
  *  @param[in] c  Char to control
  *  @return True if space, false otherwise
  */
-bool Scanner::IsSpace(const char& c) {
+inline bool Scanner::IsSpace(const char& c) {
   return (c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
           c == '\r');
 }
@@ -396,7 +423,7 @@ bool Scanner::IsSpace(const char& c) {
  *  @param[in] c    Char to control
  *  @return True if match, false otherwise
  */
-bool Scanner::Matches(const CharType& type, const char& c) {
+inline bool Scanner::Matches(const CharType& type, const char& c) {
   switch (type) {
     case CharType::kAll:
       return true;
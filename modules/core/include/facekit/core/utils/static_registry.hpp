@@ -0,0 +1,142 @@
+/**
+ *  @file   static_registry.hpp
+ *  @brief  Fixed capacity, append-only registry usable from static
+ *          constructors without any allocation
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_STATIC_REGISTRY__
+#define __FACEKIT_STATIC_REGISTRY__
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  StaticRegistry
+ *  @brief  Append-only array of at most `N` entries. The constructor is
+ *          `constexpr`, therefore a registry with static storage duration is
+ *          constant-initialized: it is usable before any static constructor
+ *          runs and never needs a singleton to be built first. Entries are
+ *          published with release semantic, lookups are lock-free and do
+ *          not allocate.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup core
+ *  @tparam T Entry type, trivially copyable (i.e. pointers or plain structs)
+ *  @tparam N Capacity
+ */
+template<typename T, size_t N>
+class StaticRegistry {
+ public:
+
+  static_assert(std::is_trivially_copyable<T>::value,
+                "StaticRegistry entries must be trivially copyable");
+
+  /**
+   *  @name   StaticRegistry
+   *  @fn     constexpr StaticRegistry(void)
+   *  @brief  Constructor, empty registry
+   */
+  constexpr StaticRegistry(void) : entries_{}, size_(0), writer_(false) {}
+
+  /**
+   *  @name   StaticRegistry
+   *  @fn     StaticRegistry(const StaticRegistry& other) = delete
+   *  @brief  Copy constructor
+   */
+  StaticRegistry(const StaticRegistry& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     StaticRegistry& operator=(const StaticRegistry& rhs) = delete
+   *  @brief  Assignment operator
+   */
+  StaticRegistry& operator=(const StaticRegistry& rhs) = delete;
+
+  /**
+   *  @name   Add
+   *  @fn     bool Add(const T& entry)
+   *  @brief  Append an entry, concurrent calls are serialized
+   *  @param[in] entry  Entry to add
+   *  @return false if the registry is full
+   */
+  bool Add(const T& entry) {
+    while (writer_.exchange(true, std::memory_order_acquire)) {
+    }
+    const size_t n = size_.load(std::memory_order_relaxed);
+    const bool added = n < N;
+    if (added) {
+      entries_[n] = entry;
+      size_.store(n + 1, std::memory_order_release);
+    }
+    writer_.store(false, std::memory_order_release);
+    return added;
+  }
+
+  /**
+   *  @name   FindIf
+   *  @fn     template<typename Pred> const T* FindIf(Pred pred) const
+   *  @brief  First entry, in registration order, satisfying `pred`
+   *  @param[in] pred Predicate, called with `const T&`
+   *  @return Entry or nullptr if none matches
+   */
+  template<typename Pred>
+  const T* FindIf(Pred pred) const {
+    const size_t n = size_.load(std::memory_order_acquire);
+    for (size_t k = 0; k < n; ++k) {
+      if (pred(entries_[k])) {
+        return &entries_[k];
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   *  @name   size
+   *  @fn     size_t size(void) const
+   *  @brief  Number of entries
+   */
+  size_t size(void) const {
+    return size_.load(std::memory_order_acquire);
+  }
+
+  /**
+   *  @name   operator[]
+   *  @fn     const T& operator[](const size_t& k) const
+   *  @brief  Entry at position `k`, must be lower than `size()`
+   */
+  const T& operator[](const size_t& k) const {
+    return entries_[k];
+  }
+
+  /**
+   *  @name   capacity
+   *  @fn     static constexpr size_t capacity(void)
+   *  @brief  Maximum number of entries
+   */
+  static constexpr size_t capacity(void) {
+    return N;
+  }
+
+ private:
+  /** Entries */
+  T entries_[N];
+  /** Number of published entries */
+  std::atomic<size_t> size_;
+  /** Registration in progress */
+  std::atomic<bool> writer_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_STATIC_REGISTRY__ */
@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "facekit/core/library_export.hpp"
+#include "facekit/core/utils/string_view.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -66,6 +67,26 @@ bool IsAbsolute(const std::string& path);
  */
 std::string Dirname(const std::string& path);
 
+/**
+ *  @name   Dirname
+ *  @fn     StringView Dirname(const StringView& path)
+ *  @brief  Same as `Dirname(const std::string&)` without allocation, the
+ *          returned view points into `path`.
+ *  @param[in] path Path to file
+ *  @return Complete file's directory or empty view.
+ */
+StringView FK_EXPORTS Dirname(const StringView& path);
+
+/**
+ *  @name   Dirname
+ *  @fn     std::string Dirname(const char* path)
+ *  @brief  Disambiguate null-terminated string, see
+ *          `Dirname(const std::string&)`
+ */
+inline std::string Dirname(const char* path) {
+  return Dirname(StringView(path)).ToString();
+}
+
 
 /**
  *  @name   Basename
@@ -78,6 +99,26 @@ std::string Dirname(const std::string& path);
  */
 std::string Basename(const std::string& path);
 
+/**
+ *  @name   Basename
+ *  @fn     StringView Basename(const StringView& path)
+ *  @brief  Same as `Basename(const std::string&)` without allocation, the
+ *          returned view points into `path`.
+ *  @param[in] path Path to file
+ *  @return File name
+ */
+StringView FK_EXPORTS Basename(const StringView& path);
+
+/**
+ *  @name   Basename
+ *  @fn     std::string Basename(const char* path)
+ *  @brief  Disambiguate null-terminated string, see
+ *          `Basename(const std::string&)`
+ */
+inline std::string Basename(const char* path) {
+  return Basename(StringView(path)).ToString();
+}
+
 /**
  *  @name   Extension
  *  @fn     std::string Extension(const std::string& path)
@@ -87,6 +128,26 @@ std::string Basename(const std::string& path);
  *  @return File's extension or empty string
  */
 std::string Extension(const std::string& path);
+
+/**
+ *  @name   Extension
+ *  @fn     StringView Extension(const StringView& path)
+ *  @brief  Same as `Extension(const std::string&)` without allocation, the
+ *          returned view points into `path`.
+ *  @param[in] path Path to file
+ *  @return File's extension or empty view
+ */
+StringView FK_EXPORTS Extension(const StringView& path);
+
+/**
+ *  @name   Extension
+ *  @fn     std::string Extension(const char* path)
+ *  @brief  Disambiguate null-terminated string, see
+ *          `Extension(const std::string&)`
+ */
+inline std::string Extension(const char* path) {
+  return Extension(StringView(path)).ToString();
+}
   
 /**
  *  @name   Clean
@@ -109,6 +170,46 @@ std::string Clean(const std::string& path);
  */
 void SplitComponent(const std::string& path, std::string* dir,
                     std::string* file, std::string* ext);
+
+/**
+ *  @name SplitComponent
+ *  @fn void SplitComponent(const StringView& path, StringView* dir,
+                            StringView* file, StringView* ext)
+ *  @brief  Split path into directory + file + extension without allocation.
+ *          Outputs are views into `path` which must outlive them.
+ *  @param[in]  path  Path where to extract data
+ *  @param[out] dir   Extracted directory, skipped if nullptr
+ *  @param[out] file  Extracted filename, skipped if nullptr
+ *  @param[out] ext   Extracted extension, skipped if nullptr
+ */
+void FK_EXPORTS SplitComponent(const StringView& path, StringView* dir,
+                               StringView* file, StringView* ext);
+
+/**
+ *  @name ParseURI
+ *  @fn void ParseURI(const std::string& uri, std::string* scheme,
+                      std::string* host, std::string* path)
+ *  @brief  Split `uri` of the form `scheme://host/path`. When there is no
+ *          scheme, `scheme` and `host` are empty and `path` is `uri`.
+ *  @param[in]  uri     URI to split
+ *  @param[out] scheme  Extracted scheme, skipped if nullptr
+ *  @param[out] host    Extracted host (i.e. bucket), skipped if nullptr
+ *  @param[out] path    Extracted path, starts with '/', skipped if nullptr
+ */
+void FK_EXPORTS ParseURI(const std::string& uri, std::string* scheme,
+                         std::string* host, std::string* path);
+
+/**
+ *  @name Match
+ *  @fn bool Match(const StringView& pattern, const StringView& name)
+ *  @brief  Check if `name` matches a glob `pattern`: `*` matches any
+ *          sequence, `?` any character, `[abc]`, `[a-z]` and `[!a-z]` a
+ *          set of characters. Similar to python `fnmatch.fnmatchcase`.
+ *  @param[in]  pattern Glob pattern (i.e. `img_*.jp*g`)
+ *  @param[in]  name    Name to test, usually a file name
+ *  @return True if `name` matches
+ */
+bool FK_EXPORTS Match(const StringView& pattern, const StringView& name);
   
 }  // namespace Path
 
@@ -130,6 +231,19 @@ namespace String {
  */
 void FK_EXPORTS Split(const std::string& string, const std::string delimiter,
                       std::vector<std::string>* parts);
+
+/**
+ *  @name Split
+ *  @fn void Split(const StringView& string, const StringView& delimiter,
+                   std::vector<StringView>* parts);
+ *  @brief  Split a given \p string into views for a specific delimiter. The
+ *          parts point into \p string which must outlive them.
+ *  @param[in]  string    String to split
+ *  @param[in]  delimiter Delimiter
+ *  @param[out] parts     Splitted parts
+ */
+void FK_EXPORTS Split(const StringView& string, const StringView& delimiter,
+                      std::vector<StringView>* parts);
   
 /**
  *  @name   LeadingZero
@@ -0,0 +1,338 @@
+/**
+ *  @file   string_view.hpp
+ *  @brief  Non-owning reference to a sequence of characters. Subset of C++17's
+ *          `std::string_view` usable with C++11.
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_STRING_VIEW__
+#define __FACEKIT_STRING_VIEW__
+
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <algorithm>
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  StringView
+ *  @brief  Non-owning, read-only view into a sequence of characters. The
+ *          referenced data must outlive the view. Member names follow
+ *          `std::string_view` to ease the switch once C++17 is available.
+ *  @author Christophe Ecabert
+ *  @date   15.10.18
+ *  @ingroup core
+ */
+class StringView {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /** Iterator */
+  using const_iterator = const char*;
+  /** Invalid position */
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+#pragma mark -
+#pragma mark Initialisation
+
+  /**
+   *  @name   StringView
+   *  @fn     StringView(void)
+   *  @brief  Constructor, empty view
+   */
+  StringView(void) : data_(nullptr), size_(0) {}
+
+  /**
+   *  @name   StringView
+   *  @fn     StringView(const char* data, const size_t& size)
+   *  @brief  Constructor
+   *  @param[in] data Pointer to the first character
+   *  @param[in] size Number of characters
+   */
+  StringView(const char* data, const size_t& size) : data_(data),
+                                                     size_(size) {}
+
+  /**
+   *  @name   StringView
+   *  @fn     StringView(const char* str)
+   *  @brief  Constructor from null-terminated string
+   *  @param[in] str  Null-terminated string
+   */
+  StringView(const char* str) : data_(str),
+                                size_(str ? std::strlen(str) : 0) {}
+
+  /**
+   *  @name   StringView
+   *  @fn     StringView(const std::string& str)
+   *  @brief  Constructor from string. `str` must outlive the view.
+   *  @param[in] str  String to reference
+   */
+  StringView(const std::string& str) : data_(str.data()),
+                                       size_(str.size()) {}
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   data
+   *  @fn     const char* data(void) const
+   *  @brief  Pointer to the first character, not null-terminated
+   */
+  const char* data(void) const {
+    return data_;
+  }
+
+  /**
+   *  @name   size
+   *  @fn     size_t size(void) const
+   *  @brief  Number of characters
+   */
+  size_t size(void) const {
+    return size_;
+  }
+
+  /**
+   *  @name   length
+   *  @fn     size_t length(void) const
+   *  @brief  Number of characters
+   */
+  size_t length(void) const {
+    return size_;
+  }
+
+  /**
+   *  @name   empty
+   *  @fn     bool empty(void) const
+   *  @brief  Indicate if the view is empty
+   */
+  bool empty(void) const {
+    return size_ == 0;
+  }
+
+  /**
+   *  @name   begin
+   *  @fn     const_iterator begin(void) const
+   *  @brief  Iterator to the first character
+   */
+  const_iterator begin(void) const {
+    return data_;
+  }
+
+  /**
+   *  @name   end
+   *  @fn     const_iterator end(void) const
+   *  @brief  Iterator past the last character
+   */
+  const_iterator end(void) const {
+    return data_ + size_;
+  }
+
+  /**
+   *  @name   operator[]
+   *  @fn     const char& operator[](const size_t& i) const
+   *  @brief  Access the i-th character, no bound check
+   */
+  const char& operator[](const size_t& i) const {
+    return data_[i];
+  }
+
+  /**
+   *  @name   front
+   *  @fn     const char& front(void) const
+   *  @brief  First character, view must not be empty
+   */
+  const char& front(void) const {
+    return data_[0];
+  }
+
+  /**
+   *  @name   back
+   *  @fn     const char& back(void) const
+   *  @brief  Last character, view must not be empty
+   */
+  const char& back(void) const {
+    return data_[size_ - 1];
+  }
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   remove_prefix
+   *  @fn     void remove_prefix(const size_t& n)
+   *  @brief  Move the start of the view forward by `n` characters
+   *  @param[in] n  Number of characters to drop, must be <= size()
+   */
+  void remove_prefix(const size_t& n) {
+    data_ += n;
+    size_ -= n;
+  }
+
+  /**
+   *  @name   remove_suffix
+   *  @fn     void remove_suffix(const size_t& n)
+   *  @brief  Move the end of the view backward by `n` characters
+   *  @param[in] n  Number of characters to drop, must be <= size()
+   */
+  void remove_suffix(const size_t& n) {
+    size_ -= n;
+  }
+
+  /**
+   *  @name   substr
+   *  @fn     StringView substr(const size_t& pos, size_t n = npos) const
+   *  @brief  View on the sub-range [pos, pos + n), clamped to the view's size
+   *  @param[in] pos  Position of the first character
+   *  @param[in] n    Number of characters
+   *  @return Sub-view
+   */
+  StringView substr(const size_t& pos, size_t n = npos) const {
+    const size_t p = std::min(pos, size_);
+    return StringView(data_ + p, std::min(n, size_ - p));
+  }
+
+  /**
+   *  @name   find
+   *  @fn     size_t find(const char& c, const size_t& pos = 0) const
+   *  @brief  Position of the first `c` at or after `pos`
+   *  @return Position or npos if not found
+   */
+  size_t find(const char& c, const size_t& pos = 0) const {
+    if (pos >= size_) {
+      return npos;
+    }
+    const void* p = std::memchr(data_ + pos, c, size_ - pos);
+    return p ? static_cast<const char*>(p) - data_ : npos;
+  }
+
+  /**
+   *  @name   find
+   *  @fn     size_t find(const StringView& s, const size_t& pos = 0) const
+   *  @brief  Position of the first occurence of `s` at or after `pos`
+   *  @return Position or npos if not found
+   */
+  size_t find(const StringView& s, const size_t& pos = 0) const {
+    if (pos > size_ || s.size_ > size_ - pos) {
+      return npos;
+    }
+    const char* it = std::search(data_ + pos, end(), s.begin(), s.end());
+    return it != end() || s.empty() ? it - data_ : npos;
+  }
+
+  /**
+   *  @name   rfind
+   *  @fn     size_t rfind(const char& c, size_t pos = npos) const
+   *  @brief  Position of the last `c` at or before `pos`
+   *  @return Position or npos if not found
+   */
+  size_t rfind(const char& c, size_t pos = npos) const {
+    if (size_ == 0) {
+      return npos;
+    }
+    for (size_t i = std::min(pos, size_ - 1) + 1; i > 0; --i) {
+      if (data_[i - 1] == c) {
+        return i - 1;
+      }
+    }
+    return npos;
+  }
+
+  /**
+   *  @name   compare
+   *  @fn     int compare(const StringView& other) const
+   *  @brief  Lexicographical comparison
+   *  @return Negative, zero or positive value like `std::string::compare`
+   */
+  int compare(const StringView& other) const {
+    const size_t n = std::min(size_, other.size_);
+    const int r = n ? std::memcmp(data_, other.data_, n) : 0;
+    if (r != 0) {
+      return r;
+    }
+    return size_ < other.size_ ? -1 : (size_ > other.size_ ? 1 : 0);
+  }
+
+  /**
+   *  @name   starts_with
+   *  @fn     bool starts_with(const StringView& s) const
+   *  @brief  Check if the view begins with `s`
+   */
+  bool starts_with(const StringView& s) const {
+    return size_ >= s.size_ &&
+           (s.size_ == 0 || std::memcmp(data_, s.data_, s.size_) == 0);
+  }
+
+  /**
+   *  @name   ends_with
+   *  @fn     bool ends_with(const StringView& s) const
+   *  @brief  Check if the view ends with `s`
+   */
+  bool ends_with(const StringView& s) const {
+    return size_ >= s.size_ &&
+           (s.size_ == 0 ||
+            std::memcmp(data_ + size_ - s.size_, s.data_, s.size_) == 0);
+  }
+
+  /**
+   *  @name   ToString
+   *  @fn     std::string ToString(void) const
+   *  @brief  Copy the referenced characters into a new string
+   */
+  std::string ToString(void) const {
+    return size_ ? std::string(data_, size_) : std::string();
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** First character */
+  const char* data_;
+  /** Number of characters */
+  size_t size_;
+};
+
+/**
+ *  @name   operator==
+ *  @brief  Equality comparison
+ */
+inline bool operator==(const StringView& lhs, const StringView& rhs) {
+  return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+
+/**
+ *  @name   operator!=
+ *  @brief  Inequality comparison
+ */
+inline bool operator!=(const StringView& lhs, const StringView& rhs) {
+  return !(lhs == rhs);
+}
+
+/**
+ *  @name   operator<
+ *  @brief  Lexicographical ordering
+ */
+inline bool operator<(const StringView& lhs, const StringView& rhs) {
+  return lhs.compare(rhs) < 0;
+}
+
+/**
+ *  @name   operator<<
+ *  @brief  Write the referenced characters into a given stream
+ */
+inline std::ostream& operator<<(std::ostream& out, const StringView& s) {
+  return out.write(s.data(), s.size());
+}
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_STRING_VIEW__ */
@@ -9,10 +9,13 @@
  */
 
 #include <mutex>
+#include <cstdlib>
+#include <algorithm>
 
 #include "facekit/core/mem/allocator.hpp"
 #include "facekit/core/mem/allocator_factory.hpp"
 #include "facekit/core/mem/memory.hpp"
+#include "facekit/core/logger.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -42,6 +45,7 @@ void AllocatorStatistic::Clear(void) {
   used_bytes = 0;
   max_used_bytes = 0;
   max_alloc_size = 0;
+  tags.clear();
 }
   
 /*
@@ -56,9 +60,361 @@ std::string AllocatorStatistic::ToString(void) const {
   str += "Max used:      "  + std::to_string(max_used_bytes) + "\n";
   str += "#Allocs:       "  + std::to_string(n_alloc) + "\n";
   str += "Max allocated: "  + std::to_string(max_alloc_size) + "\n";
+  for (const auto& t : tags) {
+    str += "  [" + t.name + "] used: " + std::to_string(t.used_bytes) +
+           ", max used: " + std::to_string(t.max_used_bytes) +
+           ", #allocs: " + std::to_string(t.n_alloc) + "\n";
+  }
   return str;
 }
   
+#pragma mark -
+#pragma mark Allocation Tags
+
+// Maximum number of tags
+constexpr size_t AllocatorStatistic::kMaxTag;
+
+/** Registered tag's names, protected by `tag_lock` */
+static std::vector<std::string>& TagNames(void) {
+  static std::vector<std::string> names(1, "untagged");
+  return names;
+}
+/** Tag registration mutex */
+static std::mutex tag_lock;
+/** Tag currently active on the calling thread */
+static thread_local int current_tag = 0;
+
+/*
+ *  @name   RegisterAllocationTag
+ *  @fn     int RegisterAllocationTag(const std::string& name)
+ *  @brief  Get identifier of a given allocation tag, registering it if needed
+ *  @param[in] name Tag's name (i.e. "mesh", "image", ...)
+ *  @return Tag identifier, 0 (untagged) if too many tags are registered
+ */
+int RegisterAllocationTag(const std::string& name) {
+  std::lock_guard<std::mutex> l(tag_lock);
+  auto& names = TagNames();
+  auto it = std::find(names.begin(), names.end(), name);
+  if (it != names.end()) {
+    return static_cast<int>(it - names.begin());
+  }
+  if (names.size() >= AllocatorStatistic::kMaxTag) {
+    FACEKIT_LOG_WARNING("Too many allocation tags, " << name <<
+                        " is not tracked");
+    return 0;
+  }
+  names.push_back(name);
+  return static_cast<int>(names.size() - 1);
+}
+
+/*
+ *  @name   AllocationTagName
+ *  @fn     std::string AllocationTagName(const int& tag)
+ *  @brief  Name of a given allocation tag
+ *  @param[in] tag  Tag identifier
+ *  @return Tag's name
+ */
+std::string AllocationTagName(const int& tag) {
+  std::lock_guard<std::mutex> l(tag_lock);
+  const auto& names = TagNames();
+  return tag >= 0 && size_t(tag) < names.size() ? names[tag] : "unknown";
+}
+
+/*
+ *  @name   ScopedAllocationTag
+ *  @fn     explicit ScopedAllocationTag(const std::string& name)
+ *  @brief  Constructor
+ *  @param[in] name Tag's name
+ */
+ScopedAllocationTag::ScopedAllocationTag(const std::string& name) :
+  ScopedAllocationTag(RegisterAllocationTag(name)) {
+}
+
+/*
+ *  @name   ScopedAllocationTag
+ *  @fn     explicit ScopedAllocationTag(const int& tag)
+ *  @brief  Constructor
+ *  @param[in] tag  Tag identifier from `RegisterAllocationTag`
+ */
+ScopedAllocationTag::ScopedAllocationTag(const int& tag) :
+  previous_(current_tag) {
+  current_tag = tag;
+}
+
+/*
+ *  @name   ~ScopedAllocationTag
+ *  @fn     ~ScopedAllocationTag(void)
+ *  @brief  Destructor, restore previous tag
+ */
+ScopedAllocationTag::~ScopedAllocationTag(void) {
+  current_tag = previous_;
+}
+
+#pragma mark -
+#pragma mark Statistic Collector
+
+/**
+ *  @struct  Slot
+ *  @brief  Counters owned by a single thread, only written by it
+ */
+struct AllocatorStatisticCollector::Slot {
+  /** Number of allocation per tag */
+  std::atomic<uint64_t> n_alloc[AllocatorStatistic::kMaxTag];
+  /** Largest block */
+  std::atomic<uint64_t> max_alloc_size;
+
+  /** Constructor */
+  Slot(void) {
+    this->Clear();
+  }
+
+  /** Reset counters */
+  void Clear(void) {
+    for (auto& n : n_alloc) {
+      n.store(0, std::memory_order_relaxed);
+    }
+    max_alloc_size.store(0, std::memory_order_relaxed);
+  }
+};
+
+/**
+ *  @struct  TagMap
+ *  @brief  Tag of live tagged allocations, split into independently locked
+ *          stripes to limit contention.
+ */
+struct AllocatorStatisticCollector::TagMap {
+  /** Number of stripes */
+  static constexpr size_t kNStripe = 16;
+
+  /**
+   *  @struct  Stripe
+   *  @brief  Part of the map
+   */
+  struct Stripe {
+    /** Mutex */
+    std::mutex lock;
+    /** Block -> tag */
+    std::unordered_map<void*, int> tags;
+  };
+
+  /** Stripes */
+  Stripe stripes[kNStripe];
+
+  /** Stripe in charge of a given block */
+  Stripe& Get(void* ptr) {
+    // Blocks are at least 8 bytes aligned, drop the low bits
+    const uintptr_t h = reinterpret_cast<uintptr_t>(ptr) >> 6;
+    return stripes[(h ^ (h >> 7)) % kNStripe];
+  }
+};
+
+/** Next collector identifier, 0 marks an empty cache entry */
+static std::atomic<uint64_t> collector_next_id(1);
+
+/**
+ *  @struct  SlotCacheEntry
+ *  @brief  Entry in thread's slot cache
+ */
+struct SlotCacheEntry {
+  /** Collector's id */
+  uint64_t id;
+  /** Slot for this collector */
+  void* slot;
+};
+/** Size of the per thread slot cache */
+static constexpr size_t kSlotCacheSize = 16;
+/** Per thread direct-mapped cache of slots, avoid taking the lock */
+static thread_local SlotCacheEntry slot_cache[kSlotCacheSize];
+
+/**
+ *  @name   UpdateMax
+ *  @fn     template<typename T> static void UpdateMax(std::atomic<T>* value,
+                                                       const T& v)
+ *  @brief  Atomically set `value` to max(value, v)
+ *  @param[in,out] value  Value to update
+ *  @param[in] v  Candidate
+ */
+template<typename T>
+static void UpdateMax(std::atomic<T>* value, const T& v) {
+  T prev = value->load(std::memory_order_relaxed);
+  while (v > prev &&
+         !value->compare_exchange_weak(prev, v, std::memory_order_relaxed)) {
+  }
+}
+
+/*
+ *  @name   AllocatorStatisticCollector
+ *  @fn     AllocatorStatisticCollector(void)
+ *  @brief  Constructor
+ */
+AllocatorStatisticCollector::AllocatorStatisticCollector(void) :
+  id_(collector_next_id.fetch_add(1)),
+  used_total_(0),
+  peak_total_(0),
+  n_tagged_(0),
+  tag_map_(new TagMap()) {
+  for (size_t i = 0; i < AllocatorStatistic::kMaxTag; ++i) {
+    used_[i].store(0, std::memory_order_relaxed);
+    peak_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+/*
+ *  @name   ~AllocatorStatisticCollector
+ *  @fn     ~AllocatorStatisticCollector(void)
+ *  @brief  Destructor
+ */
+AllocatorStatisticCollector::~AllocatorStatisticCollector(void) {
+  for (auto& s : slots_) {
+    delete s.second;
+  }
+}
+
+/*
+ *  @name   Allocate
+ *  @fn     void Allocate(const size_t& size, void* ptr)
+ *  @brief  Record an allocation under the calling thread's current tag
+ *  @param[in] size Size of the memory block in bytes
+ *  @param[in] ptr  Memory block
+ */
+void AllocatorStatisticCollector::Allocate(const size_t& size, void* ptr) {
+  const int tag = (current_tag > 0 &&
+                   size_t(current_tag) < AllocatorStatistic::kMaxTag ?
+                   current_tag :
+                   0);
+  Slot* slot = this->GetSlot();
+  // Single writer, no need for atomic read-modify-write
+  auto& n = slot->n_alloc[tag];
+  n.store(n.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  if (size > slot->max_alloc_size.load(std::memory_order_relaxed)) {
+    slot->max_alloc_size.store(size, std::memory_order_relaxed);
+  }
+  const int64_t sz = static_cast<int64_t>(size);
+  UpdateMax(&peak_total_, used_total_.fetch_add(sz,
+                                                std::memory_order_relaxed) + sz);
+  if (tag != 0) {
+    UpdateMax(&peak_[tag], used_[tag].fetch_add(sz,
+                                                std::memory_order_relaxed) + sz);
+    auto& stripe = tag_map_->Get(ptr);
+    std::lock_guard<std::mutex> l(stripe.lock);
+    if (stripe.tags.emplace(ptr, tag).second) {
+      n_tagged_.fetch_add(1, std::memory_order_relaxed);
+    }
+  } else {
+    used_[0].fetch_add(sz, std::memory_order_relaxed);
+  }
+}
+
+/*
+ *  @name   Deallocate
+ *  @fn     void Deallocate(const size_t& size, void* ptr)
+ *  @brief  Record a deallocation
+ *  @param[in] size Size of the memory block in bytes
+ *  @param[in] ptr  Memory block
+ */
+void AllocatorStatisticCollector::Deallocate(const size_t& size, void* ptr) {
+  int tag = 0;
+  if (n_tagged_.load(std::memory_order_relaxed) != 0) {
+    auto& stripe = tag_map_->Get(ptr);
+    std::lock_guard<std::mutex> l(stripe.lock);
+    auto it = stripe.tags.find(ptr);
+    if (it != stripe.tags.end()) {
+      tag = it->second;
+      stripe.tags.erase(it);
+      n_tagged_.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+  const int64_t sz = static_cast<int64_t>(size);
+  used_total_.fetch_sub(sz, std::memory_order_relaxed);
+  used_[tag].fetch_sub(sz, std::memory_order_relaxed);
+}
+
+/*
+ *  @name   Gather
+ *  @fn     void Gather(AllocatorStatistic* stats) const
+ *  @brief  Merge collected statistics
+ *  @param[out] stats   Merged statistics
+ */
+void AllocatorStatisticCollector::Gather(AllocatorStatistic* stats) const {
+  // Blocks allocated while statistics were disabled can drive usage negative
+  auto clamp = [](const int64_t& v) -> size_t {
+    return v > 0 ? static_cast<size_t>(v) : 0;
+  };
+  uint64_t n_alloc[AllocatorStatistic::kMaxTag] = {0};
+  uint64_t max_alloc = 0;
+  {
+    std::lock_guard<std::mutex> l(lock_);
+    for (const auto& s : slots_) {
+      for (size_t i = 0; i < AllocatorStatistic::kMaxTag; ++i) {
+        n_alloc[i] += s.second->n_alloc[i].load(std::memory_order_relaxed);
+      }
+      max_alloc = std::max(max_alloc, s.second->max_alloc_size.load(
+                                                   std::memory_order_relaxed));
+    }
+  }
+  stats->Clear();
+  for (size_t i = 0; i < AllocatorStatistic::kMaxTag; ++i) {
+    stats->n_alloc += n_alloc[i];
+    if (i != 0 && n_alloc[i] != 0) {
+      AllocatorStatistic::TagStatistic t;
+      t.name = AllocationTagName(static_cast<int>(i));
+      t.n_alloc = n_alloc[i];
+      t.used_bytes = clamp(used_[i].load(std::memory_order_relaxed));
+      t.max_used_bytes = clamp(peak_[i].load(std::memory_order_relaxed));
+      stats->tags.push_back(t);
+    }
+  }
+  stats->used_bytes = clamp(used_total_.load(std::memory_order_relaxed));
+  stats->max_used_bytes = clamp(peak_total_.load(std::memory_order_relaxed));
+  stats->max_alloc_size = max_alloc;
+}
+
+/*
+ *  @name   Clear
+ *  @fn     void Clear(void)
+ *  @brief  Reset statistics
+ */
+void AllocatorStatisticCollector::Clear(void) {
+  {
+    std::lock_guard<std::mutex> l(lock_);
+    for (auto& s : slots_) {
+      s.second->Clear();
+    }
+  }
+  for (size_t i = 0; i < AllocatorStatistic::kMaxTag; ++i) {
+    used_[i].store(0, std::memory_order_relaxed);
+    peak_[i].store(0, std::memory_order_relaxed);
+  }
+  used_total_.store(0, std::memory_order_relaxed);
+  peak_total_.store(0, std::memory_order_relaxed);
+  for (auto& stripe : tag_map_->stripes) {
+    std::lock_guard<std::mutex> l(stripe.lock);
+    n_tagged_.fetch_sub(stripe.tags.size(), std::memory_order_relaxed);
+    stripe.tags.clear();
+  }
+}
+
+/*
+ *  @name   GetSlot
+ *  @fn     Slot* GetSlot(void)
+ *  @brief  Counters of the calling thread
+ *  @return Slot
+ */
+AllocatorStatisticCollector::Slot* AllocatorStatisticCollector::GetSlot(void) {
+  SlotCacheEntry& e = slot_cache[id_ % kSlotCacheSize];
+  if (e.id == id_) {
+    return reinterpret_cast<Slot*>(e.slot);
+  }
+  std::lock_guard<std::mutex> l(lock_);
+  Slot*& slot = slots_[std::this_thread::get_id()];
+  if (!slot) {
+    slot = new Slot();
+  }
+  e.id = id_;
+  e.slot = slot;
+  return slot;
+}
+
 #pragma mark -
 #pragma mark Allocator
   
@@ -73,7 +429,7 @@ constexpr size_t Allocator::kDefaultAlignment;
 Allocator::~Allocator(void) = default;
   
 // Flag indicating if statistics are filled or not
-static bool allocator_gather_stats = false;
+static std::atomic<bool> allocator_gather_stats(false);
   
 /*
  *  @name   EnableAllocatorStatistics
@@ -82,7 +438,17 @@ static bool allocator_gather_stats = false;
  *  @param[in]  enable  Indicate if statistics are filled or not
  */
 void EnableAllocatorStatistics(const bool& enable) {
-  allocator_gather_stats = enable;
+  allocator_gather_stats.store(enable, std::memory_order_relaxed);
+}
+
+/*
+ *  @name   AllocatorStatisticsEnabled
+ *  @fn     bool AllocatorStatisticsEnabled(void)
+ *  @brief  Indicate if allocation statistics are filled
+ *  @return True if enabled
+ */
+bool AllocatorStatisticsEnabled(void) {
+  return allocator_gather_stats.load(std::memory_order_relaxed);
 }
   
 #pragma mark -
@@ -157,13 +523,8 @@ class CpuAllocator : public Allocator {
    */
   void* AllocateRaw(const size_t& size, const size_t& alignment) override {
     void* ptr = Mem::MallocAligned(size, alignment);
-    if (allocator_gather_stats ) {
-      std::lock_guard<std::mutex> l(lock_);
-      ++stats_.n_alloc;
-      stats_.used_bytes += size;
-      stats_.max_used_bytes = std::max(stats_.max_used_bytes,
-                                       stats_.used_bytes);
-      stats_.max_alloc_size = std::max(stats_.max_alloc_size, size);
+    if (ptr && AllocatorStatisticsEnabled()) {
+      stats_.Allocate(size, ptr);
     }
     return ptr;
   };
@@ -176,9 +537,8 @@ class CpuAllocator : public Allocator {
    *  @param[in]  ptr   Pointer to memory block
    */
   void DeallocateRaw(const size_t& size, void* ptr) override {
-    if (allocator_gather_stats) {
-      std::lock_guard<std::mutex> l(lock_);
-      stats_.used_bytes -= size;
+    if (ptr && AllocatorStatisticsEnabled()) {
+      stats_.Deallocate(size, ptr);
     }
     Mem::FreeAligned(ptr);
   }
@@ -190,8 +550,7 @@ class CpuAllocator : public Allocator {
    *  @param[out] stats   Object filled with statistics from this allocator
    */
   void GatherStatistics(AllocatorStatistic* stats) override {
-    std::lock_guard<std::mutex> l(lock_);
-    *stats = stats_;
+    stats_.Gather(stats);
   }
   
   /**
@@ -200,25 +559,45 @@ class CpuAllocator : public Allocator {
    *  @brief  Clear allocator's statistics
    */
   void ClearStatistics(void) override {
-    std::lock_guard<std::mutex> l(lock_);
     stats_.Clear();
   }
   
  private:
-  /** Mutex */
-  std::mutex lock_;
   /** Statistics */
-  AllocatorStatistic stats_;
+  AllocatorStatisticCollector stats_;
 };
   
+/**
+ *  @name   SelectDefaultCpuAllocator
+ *  @fn     static Allocator* SelectDefaultCpuAllocator(void)
+ *  @brief  Pick the allocator named by `FACEKIT_CPU_ALLOCATOR` if set,
+ *          otherwise the pooled one, falling back to the plain CPU allocator
+ *  @return CPU Allocator
+ */
+static Allocator* SelectDefaultCpuAllocator(void) {
+  auto& factory = AllocatorFactory::Get();
+  const char* name = std::getenv("FACEKIT_CPU_ALLOCATOR");
+  if (name) {
+    Allocator* a = factory.GetAllocator(name);
+    if (a) {
+      return a;
+    }
+    FACEKIT_LOG_WARNING("Unknown allocator: " << name << ", use default");
+  }
+  Allocator* a = factory.GetAllocator("pooled_cpu_allocator");
+  return a ? a : factory.GetAllocator("default_cpu_allocator");
+}
+
 /*
  *  @name   DefaultCpuAllocator
  *  @fn     Allocator* DefaultCpuAllocator(void)
- *  @brief  Provide default allocator for CPU usage
+ *  @brief  Provide default allocator for CPU usage. The pooled allocator is
+ *          used unless `FACEKIT_CPU_ALLOCATOR` names another registered one.
  *  @return CPU Allocator
  */
 Allocator* DefaultCpuAllocator(void) {
-  return AllocatorFactory::Get().GetAllocator("default_cpu_allocator");
+  static Allocator* allocator = SelectDefaultCpuAllocator();
+  return allocator;
 }
   
 /*
@@ -229,6 +608,17 @@ Allocator* DefaultCpuAllocator(void) {
  *  @return corresponding allocator or nullptr of it does not excist
  */
 Allocator* GetAllocator(const std::string& name) {
+  return AllocatorFactory::Get().GetAllocator(name.c_str());
+}
+
+/*
+ *  @name   GetAllocator
+ *  @fn     Allocator* GetAllocator(const char* name)
+ *  @brief  Search for an allocator of a given name without allocating
+ *  @param[in] name Allocator's name
+ *  @return corresponding allocator or nullptr of it does not excist
+ */
+Allocator* GetAllocator(const char* name) {
   return AllocatorFactory::Get().GetAllocator(name);
 }
   
@@ -8,13 +8,73 @@
  *  Copyright © 2018 Christophe Ecabert. All rights reserved.
  */
 
+#include <cstring>
+#include <mutex>
+
 #include "facekit/core/mem/allocator_factory.hpp"
+#include "facekit/core/utils/static_registry.hpp"
 
 /**
  *  @namespace  FaceKit
  *  @brief      Development space
  */
 namespace FaceKit {
+
+/**
+ *  @struct AllocatorEntry
+ *  @brief  Registered allocator
+ */
+struct AllocatorEntry {
+  /** Name */
+  const char* name;
+  /** Builder, nullptr if registered already built */
+  AllocatorFactory::Creator creator;
+};
+
+/** Registered allocators, constant-initialized */
+static StaticRegistry<AllocatorEntry,
+                      AllocatorFactory::kMaxAllocator> registry;
+/** Instance of each entry, nullptr until first request */
+static std::atomic<Allocator*> instances[AllocatorFactory::kMaxAllocator];
+/** Serialize registrations */
+static std::mutex registry_lock;
+
+/**
+ *  @name   Find
+ *  @fn     static const AllocatorEntry* Find(const char* name)
+ *  @brief  Search for a registered allocator
+ *  @param[in] name Allocator's name
+ *  @return Entry or nullptr if unknown
+ */
+static const AllocatorEntry* Find(const char* name) {
+  return registry.FindIf([name](const AllocatorEntry& e) {
+    return std::strcmp(e.name, name) == 0;
+  });
+}
+
+/**
+ *  @name   Add
+ *  @fn     static int Add(const char* name,
+                           AllocatorFactory::Creator creator,
+                           Allocator* allocator)
+ *  @brief  Register an allocator
+ *  @return -1 if name already taken or too many allocators, 0 otherwise
+ */
+static int Add(const char* name,
+               AllocatorFactory::Creator creator,
+               Allocator* allocator) {
+  std::lock_guard<std::mutex> lock(registry_lock);
+  if (Find(name) != nullptr) {
+    return -1;
+  }
+  const size_t idx = registry.size();
+  if (idx == registry.capacity()) {
+    return -1;
+  }
+  instances[idx].store(allocator, std::memory_order_release);
+  registry.Add(AllocatorEntry{name, creator});
+  return 0;
+}
   
 #pragma mark -
 #pragma mark Initialization
@@ -32,35 +92,58 @@ AllocatorFactory& AllocatorFactory::Get() {
   
 #pragma mark -
 #pragma mark Usage
+
+/*
+ *  @name   Register
+ *  @fn     static int Register(const char* name, Creator creator)
+ *  @brief  Add a new allocator in the factory, built on first request
+ *  @param[in]  name    Allocator's name, must outlive the factory
+ *  @param[in]  creator Build the allocator
+ *  @return -1 if name already taken or too many allocators, 0 otherwise
+ */
+int AllocatorFactory::Register(const char* name, Creator creator) {
+  return Add(name, creator, nullptr);
+}
   
 /*
  *  @name   Register
- *  @fn     void Register(const std::string& name, Allocator* allocator)
- *  @brief  Add a new allocator in the factory
- *  @param[in]  name  Allocator's name
+ *  @fn     static int Register(const char* name, Allocator* allocator)
+ *  @brief  Add an existing allocator in the factory
+ *  @param[in]  name  Allocator's name, must outlive the factory
  *  @param[in]  allocator Allocator to register, factory does not take the
  *              ownership
- *  @return -1 if name already taken, 0 otherwise
+ *  @return -1 if name already taken or too many allocators, 0 otherwise
  */
-int AllocatorFactory::Register(const std::string& name,
-                               Allocator* allocator) {
-  // Name already used ?
-  auto it = allocators_.emplace(name, allocator);
-  return it.second ? 0 : -1;
+int AllocatorFactory::Register(const char* name, Allocator* allocator) {
+  return Add(name, nullptr, allocator);
 }
 
 /*
  *  @name   GetAllocator
- *  @fn     Allocator* GetAllocator(const std::string& name) const
- *  @brief  Search for a given allocator
+ *  @fn     Allocator* GetAllocator(const char* name) const
+ *  @brief  Search for a given allocator, built on first request
  *  @param[in]  name  Allocator's name to search for
  *  @return Allocator instance or nullptr if `name` is not in the factory
  */
-Allocator* AllocatorFactory::GetAllocator(const std::string& name) const {
-  auto it = allocators_.find(name);
-  return it == allocators_.end() ? nullptr : it->second;
+Allocator* AllocatorFactory::GetAllocator(const char* name) const {
+  const AllocatorEntry* e = Find(name);
+  if (e == nullptr) {
+    return nullptr;
+  }
+  std::atomic<Allocator*>& instance = instances[e - &registry[0]];
+  Allocator* a = instance.load(std::memory_order_acquire);
+  if (a == nullptr) {
+    // Racing threads build their own, the first published wins
+    Allocator* built = e->creator();
+    if (instance.compare_exchange_strong(a,
+                                         built,
+                                         std::memory_order_acq_rel)) {
+      a = built;
+    } else {
+      delete built;
+    }
+  }
+  return a;
 }
-  
-  
-  
+
 }  // namespace FaceKit
@@ -0,0 +1,201 @@
+/**
+ *  @file   arena_allocator.cpp
+ *  @brief Bump allocator drawing from large chunks, released all at once.
+ *          Meant for scratch memory living for one iteration / frame.
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   24.02.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+
+#include "facekit/core/mem/arena_allocator.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Alignment of the chunks */
+static constexpr size_t kChunkAlignment = 64;
+
+// Default chunk size
+constexpr size_t ArenaAllocator::kDefaultChunkSize;
+
+/*
+ *  @name   ArenaAllocator
+ *  @fn     explicit ArenaAllocator(const size_t& chunk_size,
+                                    Allocator* backing)
+ *  @brief  Constructor
+ *  @param[in] chunk_size Size of the chunks requested to `backing`
+ *  @param[in] backing    Allocator providing the chunks, if nullptr use the
+ *                        default CPU allocator
+ */
+ArenaAllocator::ArenaAllocator(const size_t& chunk_size,
+                               Allocator* backing) :
+  chunk_size_(chunk_size),
+  backing_(backing ? backing : DefaultCpuAllocator()),
+  current_(0),
+  offset_(0) {
+}
+
+/*
+ *  @name   ~ArenaAllocator
+ *  @fn     ~ArenaAllocator(void) override
+ *  @brief  Destructor, give chunks back to backing allocator
+ */
+ArenaAllocator::~ArenaAllocator(void) {
+  this->Release();
+}
+
+/*
+ *  @name   AllocateRaw
+ *  @fn     void* AllocateRaw(const size_t& size,
+ *          const size_t& alignment) override
+ *  @brief  Allocate a block of memory of a given size with specific
+ *          alignment. Alignment must be a power of 2 and minimum of
+ *          sizeof(void*)
+ *  @param[in]  size      Size of the memory block in bytes
+ *  @param[in]  alignment Desired memory alignment
+ *  @return Pointer to memory block or nullptr if failed.
+ */
+void* ArenaAllocator::AllocateRaw(const size_t& size,
+                                  const size_t& alignment) {
+  std::lock_guard<std::mutex> l(lock_);
+  void* ptr = nullptr;
+  // Look into current chunk and the ones left over by a previous rewind
+  while (current_ < chunks_.size()) {
+    const Chunk& c = chunks_[current_];
+    const uintptr_t base = reinterpret_cast<uintptr_t>(c.data);
+    const uintptr_t p = (base + offset_ + alignment - 1) & ~(alignment - 1);
+    if (p + size <= base + c.size) {
+      ptr = reinterpret_cast<void*>(p);
+      offset_ = (p + size) - base;
+      break;
+    }
+    if (current_ + 1 == chunks_.size()) {
+      break;
+    }
+    ++current_;
+    offset_ = 0;
+  }
+  if (!ptr) {
+    // Need a new chunk, large enough for the request
+    const size_t n = std::max(chunk_size_, size + alignment);
+    void* data = backing_->AllocateRaw(n, std::max(alignment, kChunkAlignment));
+    if (!data) {
+      return nullptr;
+    }
+    chunks_.push_back(Chunk{reinterpret_cast<uint8_t*>(data), n});
+    current_ = chunks_.size() - 1;
+    ptr = data;
+    offset_ = size;
+  }
+  if (AllocatorStatisticsEnabled()) {
+    stats_.Allocate(size, ptr);
+  }
+  return ptr;
+}
+
+/*
+ *  @name   DeallocateRaw
+ *  @fn     void DeallocateRaw(void* ptr) override
+ *  @brief  Release a block of memory pointed by `ptr`, no-op memory is
+ *          recovered on `Rewind`.
+ *  @param[in]  size  Size of the memory block in bytes
+ *  @param[in]  ptr   Pointer to memory block
+ */
+void ArenaAllocator::DeallocateRaw(const size_t& size, void* ptr) {
+  if (ptr && AllocatorStatisticsEnabled()) {
+    stats_.Deallocate(size, ptr);
+  }
+}
+
+/*
+ *  @name   GetMark
+ *  @fn     Mark GetMark(void)
+ *  @brief  Current position within the arena
+ *  @return Mark to rewind to
+ */
+ArenaAllocator::Mark ArenaAllocator::GetMark(void) {
+  std::lock_guard<std::mutex> l(lock_);
+  return Mark{current_, offset_};
+}
+
+/*
+ *  @name   Rewind
+ *  @fn     void Rewind(const Mark& mark)
+ *  @brief  Give back everything allocated after `mark`
+ *  @param[in] mark Position to go back to
+ */
+void ArenaAllocator::Rewind(const Mark& mark) {
+  std::lock_guard<std::mutex> l(lock_);
+  if (mark.chunk < current_ ||
+      (mark.chunk == current_ && mark.offset < offset_)) {
+    current_ = mark.chunk;
+    offset_ = mark.offset;
+  }
+}
+
+/*
+ *  @name   Reset
+ *  @fn     void Reset(void)
+ *  @brief  Give back everything, chunks are kept for reuse
+ */
+void ArenaAllocator::Reset(void) {
+  this->Rewind(Mark{0, 0});
+}
+
+/*
+ *  @name   Release
+ *  @fn     void Release(void)
+ *  @brief  Give back everything and return chunks to backing allocator
+ */
+void ArenaAllocator::Release(void) {
+  std::lock_guard<std::mutex> l(lock_);
+  for (auto& c : chunks_) {
+    backing_->DeallocateRaw(c.size, c.data);
+  }
+  chunks_.clear();
+  current_ = 0;
+  offset_ = 0;
+}
+
+/*
+ *  @name   GatherStatistics
+ *  @fn     void GatherStatistics(AllocatorStatistic* stats) override
+ *  @brief  Provide statistics for this allocator
+ *  @param[out] stats   Object filled with statistics from this allocator
+ */
+void ArenaAllocator::GatherStatistics(AllocatorStatistic* stats) {
+  stats_.Gather(stats);
+}
+
+/*
+ *  @name   ClearStatistics
+ *  @fn     void ClearStatistics(void) override
+ *  @brief  Clear allocator's statistics
+ */
+void ArenaAllocator::ClearStatistics(void) {
+  stats_.Clear();
+}
+
+/*
+ *  @name   capacity
+ *  @fn     size_t capacity(void)
+ *  @brief  Total size of the chunks held by the arena
+ *  @return Capacity in bytes
+ */
+size_t ArenaAllocator::capacity(void) {
+  std::lock_guard<std::mutex> l(lock_);
+  size_t n = 0;
+  for (const auto& c : chunks_) {
+    n += c.size;
+  }
+  return n;
+}
+
+}  // namespace FaceKit
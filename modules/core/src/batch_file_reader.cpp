@@ -0,0 +1,605 @@
+/**
+ *  @file   batch_file_reader.cpp
+ *  @brief Read a batch of whole files asynchronously. Uses io_uring on Linux
+ *         when available and falls back to the thread pool otherwise.
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   11.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#if defined(__APPLE__) || defined(__linux__)
+#define IS_POSIX
+#endif
+
+#ifdef FACEKIT_HAS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+
+#include "facekit/core/sys/batch_file_reader.hpp"
+#include "facekit/core/sys/file_system.hpp"
+#include "facekit/core/sys/file_system_factory.hpp"
+#include "facekit/core/mem/allocator.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/logger.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#pragma mark -
+#pragma mark io_uring
+
+#ifdef FACEKIT_HAS_IO_URING
+
+/**
+ *  @struct Ring
+ *  @brief  Minimal io_uring wrapper (submission/completion queues mapped in
+ *          user space), talks to the kernel through raw syscalls.
+ */
+struct BatchFileReader::Ring {
+  /** Ring file descriptor */
+  int fd = -1;
+  /** Mapped submission queue ring */
+  void* sq_ptr = MAP_FAILED;
+  /** Submission queue ring size */
+  size_t sq_size = 0;
+  /** Mapped completion queue ring, may alias `sq_ptr` */
+  void* cq_ptr = MAP_FAILED;
+  /** Completion queue ring size */
+  size_t cq_size = 0;
+  /** Submission queue entries */
+  io_uring_sqe* sqes = nullptr;
+  /** Number of submission queue entries */
+  unsigned sq_entries = 0;
+  /** Submission queue head/tail/mask/array */
+  unsigned* sq_head = nullptr;
+  unsigned* sq_tail = nullptr;
+  unsigned* sq_mask = nullptr;
+  unsigned* sq_array = nullptr;
+  /** Completion queue head/tail/mask/entries */
+  unsigned* cq_head = nullptr;
+  unsigned* cq_tail = nullptr;
+  unsigned* cq_mask = nullptr;
+  io_uring_cqe* cqes = nullptr;
+  /** Entries filled but not yet passed to the kernel */
+  unsigned to_submit = 0;
+
+  /**
+   *  @name   Init
+   *  @brief  Create the ring with `entries` slots
+   *  @return True on success
+   */
+  bool Init(const unsigned& entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+      return false;
+    }
+    sq_entries = params.sq_entries;
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_map) {
+      sq_size = std::max(sq_size, cq_size);
+    }
+    sq_ptr = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq_ptr == MAP_FAILED) {
+      return false;
+    }
+    if (single_map) {
+      cq_ptr = sq_ptr;
+    } else {
+      cq_ptr = mmap(nullptr, cq_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+      if (cq_ptr == MAP_FAILED) {
+        return false;
+      }
+    }
+    void* sqe_ptr = mmap(nullptr, sq_entries * sizeof(io_uring_sqe),
+                         PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         fd, IORING_OFF_SQES);
+    if (sqe_ptr == MAP_FAILED) {
+      return false;
+    }
+    sqes = reinterpret_cast<io_uring_sqe*>(sqe_ptr);
+    char* sq = reinterpret_cast<char*>(sq_ptr);
+    char* cq = reinterpret_cast<char*>(cq_ptr);
+    sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  /**
+   *  @name   ~Ring
+   *  @brief  Destructor, unmap queues and close the ring
+   */
+  ~Ring(void) {
+    if (sqes) {
+      munmap(sqes, sq_entries * sizeof(io_uring_sqe));
+    }
+    if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) {
+      munmap(cq_ptr, cq_size);
+    }
+    if (sq_ptr != MAP_FAILED) {
+      munmap(sq_ptr, sq_size);
+    }
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+
+  /**
+   *  @name   PushRead
+   *  @brief  Queue a vectored read of `iov` from `file` at `offset`
+   */
+  void PushRead(const int& file,
+                const iovec* iov,
+                const size_t& offset,
+                const uint64_t& tag) {
+    const unsigned tail = *sq_tail;
+    const unsigned idx = tail & *sq_mask;
+    io_uring_sqe* sqe = &sqes[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = file;
+    sqe->addr = reinterpret_cast<uint64_t>(iov);
+    sqe->len = 1;
+    sqe->off = offset;
+    sqe->user_data = tag;
+    sq_array[idx] = idx;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    to_submit += 1;
+  }
+
+  /**
+   *  @name   Enter
+   *  @brief  Submit queued entries and wait for at least `wait` completions
+   *  @return 0 on success, -errno otherwise
+   */
+  int Enter(const unsigned& wait) {
+    while (true) {
+      int r = static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit,
+                                       wait, IORING_ENTER_GETEVENTS,
+                                       nullptr, 0));
+      if (r >= 0) {
+        to_submit -= std::min(to_submit, static_cast<unsigned>(r));
+        return 0;
+      }
+      if (errno != EINTR) {
+        return -errno;
+      }
+    }
+  }
+
+  /**
+   *  @name   Reap
+   *  @brief  Pop one completion if any
+   *  @return True if `cqe` has been filled
+   */
+  bool Reap(io_uring_cqe* cqe) {
+    const unsigned head = *cq_head;
+    if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+      return false;
+    }
+    *cqe = cqes[head & *cq_mask];
+    __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+};
+
+/**
+ *  @struct RingRead
+ *  @brief  In-flight io_uring file read
+ */
+struct RingRead {
+  /** Index in the batch */
+  size_t index;
+  /** File descriptor */
+  int fd;
+  /** File size */
+  size_t size;
+  /** Bytes read so far */
+  size_t done;
+  /** Destination */
+  NDArray content;
+  /** Pending chunk */
+  iovec iov;
+};
+
+#else
+
+/**
+ *  @struct Ring
+ *  @brief  Placeholder when io_uring is not available
+ */
+struct BatchFileReader::Ring {};
+
+#endif
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   BatchFileReader
+ *  @fn     BatchFileReader(void)
+ *  @brief  Constructor with default options
+ */
+BatchFileReader::BatchFileReader(void) : BatchFileReader(Options()) {}
+
+/*
+ *  @name   BatchFileReader
+ *  @fn     explicit BatchFileReader(const Options& options)
+ *  @brief  Constructor
+ *  @param[in] options  Reader configuration
+ */
+BatchFileReader::BatchFileReader(const Options& options) :
+        options_(options),
+        backend_(Backend::kThreadPool),
+        ring_(nullptr) {
+  options_.queue_depth = std::max(options_.queue_depth, size_t(1));
+  if (options_.allocator == nullptr) {
+    options_.allocator = GetAllocator("pooled_cpu_allocator");
+  }
+#ifdef FACEKIT_HAS_IO_URING
+  if (options_.backend != Backend::kThreadPool) {
+    Ring* ring = new Ring();
+    if (ring->Init(static_cast<unsigned>(options_.queue_depth))) {
+      ring_ = ring;
+      backend_ = Backend::kIoUring;
+    } else {
+      // Kernel too old or io_uring disabled (i.e. seccomp)
+      FACEKIT_LOG_DEBUG("io_uring not available, use thread pool backend");
+      delete ring;
+    }
+  }
+#endif
+}
+
+/*
+ *  @name   ~BatchFileReader
+ *  @fn     ~BatchFileReader(void)
+ *  @brief  Destructor
+ */
+BatchFileReader::~BatchFileReader(void) {
+  delete ring_;
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Read
+ *  @fn     Status Read(const std::vector<std::string>& paths,
+                        const Callback& callback)
+ *  @brief  Read every file in `paths`, `callback` is invoked as each read
+ *          completes. Returns once all files have been reported.
+ *  @param[in] paths    Files to read
+ *  @param[in] callback Completion callback
+ *  @return kGood if every file has been read, first error otherwise
+ */
+Status BatchFileReader::Read(const std::vector<std::string>& paths,
+                             const Callback& callback) {
+  if (backend_ == Backend::kIoUring) {
+    return this->ReadRing(paths, callback);
+  }
+  return this->ReadPool(paths, callback);
+}
+
+/*
+ *  @name   Read
+ *  @fn     Status Read(const std::vector<std::string>& paths,
+                        std::vector<NDArray>* contents)
+ *  @brief  Read every file in `paths` and gather their content in order
+ *  @param[in] paths    Files to read
+ *  @param[out] contents  Content of each file
+ *  @return kGood if every file has been read, first error otherwise
+ */
+Status BatchFileReader::Read(const std::vector<std::string>& paths,
+                             std::vector<NDArray>* contents) {
+  contents->clear();
+  contents->resize(paths.size());
+  return this->Read(paths, [contents](const size_t& index,
+                                      const Status& status,
+                                      NDArray&& content) {
+    (*contents)[index] = std::move(content);
+  });
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ *  @name   ReadRing
+ *  @fn     Status ReadRing(const std::vector<std::string>& paths,
+                            const Callback& callback)
+ *  @brief  io_uring backend
+ */
+Status BatchFileReader::ReadRing(const std::vector<std::string>& paths,
+                                 const Callback& callback) {
+#ifdef FACEKIT_HAS_IO_URING
+  Status status;
+  // Slots are reused, their address is handed over to the kernel
+  std::vector<RingRead> slots(std::min(static_cast<size_t>(ring_->sq_entries),
+                                       std::max(paths.size(), size_t(1))));
+  std::vector<size_t> free_slots;
+  for (size_t k = slots.size(); k > 0; --k) {
+    free_slots.push_back(k - 1);
+  }
+  // Report file `index` and release its slot
+  auto report = [&](const size_t& slot, const Status& s) {
+    RingRead& r = slots[slot];
+    if (!s.Good() && status.Good()) {
+      status = s;
+    }
+    close(r.fd);
+    callback(r.index, s, std::move(r.content));
+    r.content = NDArray();
+    free_slots.push_back(slot);
+  };
+  size_t next = 0;
+  size_t in_flight = 0;
+  while (next < paths.size() || in_flight > 0) {
+    // Open as many files as there are free slots
+    while (next < paths.size() && !free_slots.empty()) {
+      const size_t index = next++;
+      int fd = open(paths[index].c_str(), O_RDONLY);
+      struct stat sbuf;
+      if (fd < 0 || fstat(fd, &sbuf) != 0) {
+        if (fd >= 0) {
+          close(fd);
+        }
+        Status s(Status::Type::kNotFound, "Can not open: " + paths[index]);
+        if (status.Good()) {
+          status = s;
+        }
+        callback(index, s, NDArray());
+        continue;
+      }
+      const size_t slot = free_slots.back();
+      free_slots.pop_back();
+      RingRead& r = slots[slot];
+      r.index = index;
+      r.fd = fd;
+      r.size = static_cast<size_t>(sbuf.st_size);
+      r.done = 0;
+      r.content = NDArray(DataType::kUInt8, {r.size}, options_.allocator);
+      if (r.size == 0) {
+        report(slot, Status());
+        continue;
+      }
+      r.iov.iov_base = r.content.AsFlat<uint8_t>().data();
+      r.iov.iov_len = r.size;
+      ring_->PushRead(fd, &r.iov, 0, slot);
+      in_flight += 1;
+    }
+    if (in_flight == 0) {
+      continue;
+    }
+    // Submit and wait for at least one completion
+    int err = ring_->Enter(1);
+    if (err < 0) {
+      // Ring unusable, drain remaining reads synchronously
+      Status s(Status::Type::kInternalError,
+               std::string("io_uring_enter failed: ") + std::strerror(-err));
+      for (size_t k = 0; k < slots.size(); ++k) {
+        if (std::find(free_slots.begin(), free_slots.end(), k) ==
+            free_slots.end()) {
+          report(k, s);
+        }
+      }
+      in_flight = 0;
+      // Remaining files go through the thread pool
+      std::vector<std::string> rest(paths.begin() + next, paths.end());
+      const size_t offset = next;
+      Status ps = this->ReadPool(rest, [&](const size_t& index,
+                                           const Status& s,
+                                           NDArray&& content) {
+        callback(offset + index, s, std::move(content));
+      });
+      next = paths.size();
+      if (status.Good()) {
+        status = ps;
+      }
+      break;
+    }
+    io_uring_cqe cqe;
+    while (ring_->Reap(&cqe)) {
+      const size_t slot = static_cast<size_t>(cqe.user_data);
+      RingRead& r = slots[slot];
+      if (cqe.res < 0 && cqe.res != -EINTR && cqe.res != -EAGAIN) {
+        in_flight -= 1;
+        report(slot, Status(Status::Type::kInternalError,
+                            "Can not read: " + paths[r.index] + ": " +
+                            std::strerror(-cqe.res)));
+        continue;
+      }
+      if (cqe.res == 0) {
+        // File shrunk while reading
+        in_flight -= 1;
+        report(slot, Status(Status::Type::kOutOfRange,
+                            "Read less bytes than requested in: " +
+                            paths[r.index]));
+        continue;
+      }
+      r.done += cqe.res > 0 ? static_cast<size_t>(cqe.res) : 0;
+      if (r.done < r.size) {
+        // Short read, queue the remaining part
+        r.iov.iov_base = r.content.AsFlat<uint8_t>().data() + r.done;
+        r.iov.iov_len = r.size - r.done;
+        ring_->PushRead(r.fd, &r.iov, r.done, slot);
+      } else {
+        in_flight -= 1;
+        report(slot, Status());
+      }
+    }
+  }
+  return status;
+#else
+  return Status(Status::Type::kUnimplemented, "Not supported");
+#endif
+}
+
+/*
+ *  @name   ReadPool
+ *  @fn     Status ReadPool(const std::vector<std::string>& paths,
+                            const Callback& callback)
+ *  @brief  Thread pool backend
+ */
+Status BatchFileReader::ReadPool(const std::vector<std::string>& paths,
+                                 const Callback& callback) {
+  using TaskPriority = ThreadPool::TaskPriority;
+#ifdef IS_POSIX
+  FileSystem* fs = FileSystemFactory::Get().Retrieve("Posix");
+#else
+  FileSystem* fs = FileSystemFactory::Get().Retrieve("Windows");
+#endif
+  ThreadPool& pool = options_.pool ? *options_.pool : ThreadPool::Get();
+  const size_t limit = options_.queue_depth;
+  Allocator* allocator = options_.allocator;
+  Status status;
+  size_t in_flight = 0;
+  std::mutex mutex;
+  std::mutex cb_mutex;
+  std::condition_variable cond;
+  // Read one file entirely
+  auto load = [&](const size_t& index) {
+    std::unique_ptr<RandomAccessFile> file;
+    NDArray content;
+    size_t size = 0;
+    Status s = fs->NewRandomAccessFile(paths[index], &file);
+    if (s.Good()) {
+      s = file->Size(&size);
+    }
+    if (s.Good()) {
+      content = NDArray(DataType::kUInt8, {size}, allocator);
+      if (size > 0) {
+        size_t n_read = 0;
+        char* ptr = reinterpret_cast<char*>(content.AsFlat<uint8_t>().data());
+        s = file->Read(0, size, ptr, &n_read);
+      }
+    }
+    if (!s.Good()) {
+      content = NDArray();
+    }
+    {
+      std::lock_guard<std::mutex> lock(cb_mutex);
+      callback(index, s, std::move(content));
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!s.Good() && status.Good()) {
+      status = s;
+    }
+    in_flight -= 1;
+    cond.notify_all();
+  };
+  // Dispatch reads, at most `limit` at once. The calling thread helps the
+  // pool while waiting so the batch can be read from within a worker
+  std::unique_lock<std::mutex> lock(mutex);
+  size_t next = 0;
+  while (next < paths.size() || in_flight > 0) {
+    while (next < paths.size() && in_flight < limit) {
+      in_flight += 1;
+      pool.Submit(TaskPriority::kNormal, load, next++);
+    }
+    lock.unlock();
+    const bool helped = pool.RunPendingTask();
+    lock.lock();
+    if (!helped) {
+      cond.wait(lock, [&]() {
+        return in_flight == 0 || (next < paths.size() && in_flight < limit);
+      });
+    }
+  }
+  return status;
+}
+
+#pragma mark -
+#pragma mark MemoryStream
+
+/*
+ *  @name   MemoryStreambuf
+ *  @fn     MemoryStreambuf(const char* data, const size_t& size)
+ *  @brief  Constructor
+ */
+MemoryStream::MemoryStreambuf::MemoryStreambuf(const char* data,
+                                               const size_t& size) {
+  char* begin = const_cast<char*>(data);
+  this->setg(begin, begin, begin + size);
+}
+
+/*
+ *  @name   seekoff
+ *  @brief  C.f. C++ standard section 27.6.3.4.2
+ */
+MemoryStream::MemoryStreambuf::pos_type
+MemoryStream::MemoryStreambuf::seekoff(off_type off,
+                                       std::ios_base::seekdir dir,
+                                       std::ios_base::openmode which) {
+  char* pos = nullptr;
+  if (dir == std::ios_base::beg) {
+    pos = this->eback() + off;
+  } else if (dir == std::ios_base::cur) {
+    pos = this->gptr() + off;
+  } else {
+    pos = this->egptr() + off;
+  }
+  if (!(which & std::ios_base::in) ||
+      pos < this->eback() ||
+      pos > this->egptr()) {
+    return pos_type(off_type(-1));
+  }
+  this->setg(this->eback(), pos, this->egptr());
+  return pos_type(pos - this->eback());
+}
+
+/*
+ *  @name   seekpos
+ *  @brief  C.f. C++ standard section 27.6.3.4.2
+ */
+MemoryStream::MemoryStreambuf::pos_type
+MemoryStream::MemoryStreambuf::seekpos(pos_type pos,
+                                       std::ios_base::openmode which) {
+  return this->seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+/*
+ *  @name   MemoryStream
+ *  @fn     explicit MemoryStream(const NDArray& content)
+ *  @brief  Constructor, keep a reference on `content` while alive
+ *  @param[in] content  Contiguous array to stream
+ */
+MemoryStream::MemoryStream(const NDArray& content) :
+        std::istream(nullptr),
+        content_(content),
+        buffer_(content_.n_elems() ?
+                reinterpret_cast<const char*>(content_.AsFlat<uint8_t>().data()) :
+                nullptr,
+                content_.n_elems()) {
+  this->rdbuf(&buffer_);
+}
+
+}  // namespace FaceKit
@@ -0,0 +1,263 @@
+/**
+ *  @file   blas_backend.cpp
+ *  @brief Query the BLAS implementation resolved at load time and control
+ *         the number of threads it uses
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   22.08.18
+ *    Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#if defined(__APPLE__) || defined(__linux__)
+#include <dlfcn.h>    // for dlsym
+#define IS_POSIX
+#endif
+
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+
+#include "facekit/core/math/blas_backend.hpp"
+#include "facekit/core/logger.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+namespace internal {
+
+/**
+ *  @name   LookupSymbol
+ *  @fn     F LookupSymbol(const char* name)
+ *  @brief  Search for a symbol in the libraries already loaded
+ *  @param[in] name Symbol's name
+ *  @tparam F Function pointer type
+ *  @return Function pointer or nullptr if not found
+ */
+template<typename F>
+F LookupSymbol(const char* name) {
+#ifdef IS_POSIX
+  return reinterpret_cast<F>(dlsym(RTLD_DEFAULT, name));
+#else
+  return nullptr;
+#endif
+}
+
+/** BLIS uses `dim_t` (int64) for thread count */
+static void (*bli_set_threads)(int64_t) = nullptr;
+static int64_t (*bli_get_threads)(void) = nullptr;
+
+/**
+ *  @name   BlisSetNumThreads
+ *  @fn     void BlisSetNumThreads(int n)
+ *  @brief  Adapt BLIS setter to the common signature
+ *  @param[in] n  Number of threads
+ */
+void BlisSetNumThreads(int n) {
+  bli_set_threads(static_cast<int64_t>(n));
+}
+
+/**
+ *  @name   BlisGetNumThreads
+ *  @fn     int BlisGetNumThreads(void)
+ *  @brief  Adapt BLIS getter to the common signature
+ *  @return Number of threads
+ */
+int BlisGetNumThreads(void) {
+  return static_cast<int>(bli_get_threads());
+}
+
+/**
+ *  @name   HardwareThreads
+ *  @fn     int HardwareThreads(void)
+ *  @brief  Number of hardware threads, at least one
+ *  @return Number of threads
+ */
+int HardwareThreads(void) {
+  const int n = static_cast<int>(std::thread::hardware_concurrency());
+  return n > 0 ? n : 1;
+}
+
+}  // namespace internal
+
+#pragma mark -
+#pragma mark SerialScope
+
+/*
+ *  @name   SerialScope
+ *  @fn     SerialScope(void)
+ *  @brief  Constructor, switch BLAS to a single thread
+ */
+BlasBackend::SerialScope::SerialScope(void) {
+  BlasBackend::Get().EnterSerial();
+}
+
+/*
+ *  @name   ~SerialScope
+ *  @fn     ~SerialScope(void)
+ *  @brief  Destructor, restore number of threads when it is the last
+ *          active scope
+ */
+BlasBackend::SerialScope::~SerialScope(void) {
+  BlasBackend::Get().LeaveSerial();
+}
+
+#pragma mark -
+#pragma mark BlasBackend
+
+/*
+ *  @name   Get
+ *  @fn     static BlasBackend& Get(void)
+ *  @brief  Singleton accessor
+ *  @return BLAS backend
+ */
+BlasBackend& BlasBackend::Get(void) {
+  static BlasBackend backend;
+  return backend;
+}
+
+/*
+ *  @name   BlasBackend
+ *  @fn     BlasBackend(void)
+ *  @brief  Constructor, detect backend
+ */
+BlasBackend::BlasBackend(void) : type_(Type::kReference),
+                                 set_threads_(nullptr),
+                                 get_threads_(nullptr),
+                                 n_threads_(1),
+                                 n_serial_(0) {
+  using internal::LookupSymbol;
+  // MKL first since it can also export OpenBLAS compatibility symbols
+  set_threads_ = LookupSymbol<SetThreadFcn>("MKL_Set_Num_Threads");
+  get_threads_ = LookupSymbol<GetThreadFcn>("MKL_Get_Max_Threads");
+  if (set_threads_ && get_threads_) {
+    type_ = Type::kMKL;
+  } else {
+    set_threads_ = LookupSymbol<SetThreadFcn>("openblas_set_num_threads");
+    get_threads_ = LookupSymbol<GetThreadFcn>("openblas_get_num_threads");
+    if (set_threads_ && get_threads_) {
+      type_ = Type::kOpenBLAS;
+    } else {
+      using BliSet = void(*)(int64_t);
+      using BliGet = int64_t(*)(void);
+      internal::bli_set_threads =
+              LookupSymbol<BliSet>("bli_thread_set_num_threads");
+      internal::bli_get_threads =
+              LookupSymbol<BliGet>("bli_thread_get_num_threads");
+      if (internal::bli_set_threads && internal::bli_get_threads) {
+        type_ = Type::kBLIS;
+        set_threads_ = &internal::BlisSetNumThreads;
+        get_threads_ = &internal::BlisGetNumThreads;
+      } else {
+        set_threads_ = nullptr;
+        get_threads_ = nullptr;
+#ifdef __APPLE__
+        // Accelerate manages its own threads, no public control
+        type_ = Type::kAccelerate;
+#endif
+      }
+    }
+  }
+  if (get_threads_) {
+    n_threads_ = get_threads_();
+    // User defined value ?
+    const char* env = std::getenv("FACEKIT_BLAS_NUM_THREADS");
+    if (env) {
+      const int n = std::atoi(env);
+      if (n > 0) {
+        n_threads_ = n;
+        set_threads_(n_threads_);
+      } else {
+        FACEKIT_LOG_WARNING("Invalid FACEKIT_BLAS_NUM_THREADS value: " << env);
+      }
+    }
+  } else if (type_ == Type::kAccelerate) {
+    n_threads_ = internal::HardwareThreads();
+  }
+}
+
+/*
+ *  @name   Name
+ *  @fn     const char* Name(void) const
+ *  @brief  Readable name of the detected implementation
+ *  @return Backend name
+ */
+const char* BlasBackend::Name(void) const {
+  switch (type_) {
+    case Type::kOpenBLAS: return "OpenBLAS";
+    case Type::kMKL: return "MKL";
+    case Type::kBLIS: return "BLIS";
+    case Type::kAccelerate: return "Accelerate";
+    default: return "Reference";
+  }
+}
+
+/*
+ *  @name   SetNumThreads
+ *  @fn     Status SetNumThreads(const int& n)
+ *  @brief  Define how many threads BLAS can use. When called while a
+ *          `SerialScope` is active, the value is applied once the last
+ *          scope is released.
+ *  @param[in] n  Number of threads, 0 selects the number of cores
+ *  @return Status of the operation, `kUnimplemented` if the backend does
+ *          not expose thread control.
+ */
+Status BlasBackend::SetNumThreads(const int& n) {
+  if (n < 0) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Number of threads must be positive");
+  }
+  if (!set_threads_) {
+    return Status(Status::Type::kUnimplemented,
+                  std::string(Name()) + " does not support thread control");
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  n_threads_ = n == 0 ? internal::HardwareThreads() : n;
+  if (n_serial_ == 0) {
+    set_threads_(n_threads_);
+  }
+  return Status();
+}
+
+/*
+ *  @name   GetNumThreads
+ *  @fn     int GetNumThreads(void) const
+ *  @brief  Number of threads BLAS currently uses
+ *  @return Number of threads
+ */
+int BlasBackend::GetNumThreads(void) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (get_threads_) {
+    return get_threads_();
+  }
+  return n_serial_ > 0 ? 1 : n_threads_;
+}
+
+/*
+ *  @name   EnterSerial
+ *  @fn     void EnterSerial(void)
+ *  @brief  Register a new active `SerialScope`
+ */
+void BlasBackend::EnterSerial(void) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (n_serial_++ == 0 && set_threads_ && n_threads_ != 1) {
+    set_threads_(1);
+  }
+}
+
+/*
+ *  @name   LeaveSerial
+ *  @fn     void LeaveSerial(void)
+ *  @brief  Release an active `SerialScope`
+ */
+void BlasBackend::LeaveSerial(void) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (--n_serial_ == 0 && set_threads_ && n_threads_ != 1) {
+    set_threads_(n_threads_);
+  }
+}
+
+}  // namespace FaceKit
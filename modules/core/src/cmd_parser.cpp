@@ -7,10 +7,18 @@
  *  Copyright (c) 2016 Christophe Ecabert. All rights reserved.
  */
 
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <limits>
+#include <sstream>
 
 #include "facekit/core/cmd_parser.hpp"
+#include "facekit/core/logger.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -41,6 +49,116 @@ bool CmdOptionExists(const char** begin,
                      const char** end,
                      const std::string& option);
 
+#pragma mark -
+#pragma mark Conversion
+
+/*
+ *  @name   ParseValue
+ *  @brief  Convert a whole string into a value
+ *  @param[in]  str     String to convert
+ *  @param[out] value   Converted value, untouched on failure
+ *  @return True if \p str holds a valid value
+ */
+static bool ParseValue(const std::string& str, int64_t* value) {
+  char* end = nullptr;
+  errno = 0;
+  const long long v = std::strtoll(str.c_str(), &end, 10);
+  if (str.empty() || *end != '\0' || errno == ERANGE) {
+    return false;
+  }
+  *value = static_cast<int64_t>(v);
+  return true;
+}
+
+/*
+ *  @name   ParseValue
+ *  @brief  Convert a whole string into a integer
+ */
+static bool ParseValue(const std::string& str, int* value) {
+  int64_t v;
+  if (!ParseValue(str, &v) || v < std::numeric_limits<int>::min() ||
+      v > std::numeric_limits<int>::max()) {
+    return false;
+  }
+  *value = static_cast<int>(v);
+  return true;
+}
+
+/*
+ *  @name   ParseValue
+ *  @brief  Convert a whole string into a non-negative size
+ */
+static bool ParseValue(const std::string& str, size_t* value) {
+  char* end = nullptr;
+  errno = 0;
+  if (str.empty() || str[0] == '-') {
+    return false;
+  }
+  const unsigned long long v = std::strtoull(str.c_str(), &end, 10);
+  if (*end != '\0' || errno == ERANGE ||
+      v > std::numeric_limits<size_t>::max()) {
+    return false;
+  }
+  *value = static_cast<size_t>(v);
+  return true;
+}
+
+/*
+ *  @name   ParseValue
+ *  @brief  Convert a whole string into a double precision number
+ */
+static bool ParseValue(const std::string& str, double* value) {
+  char* end = nullptr;
+  errno = 0;
+  const double v = std::strtod(str.c_str(), &end);
+  if (str.empty() || *end != '\0' || errno == ERANGE) {
+    return false;
+  }
+  *value = v;
+  return true;
+}
+
+/*
+ *  @name   ParseValue
+ *  @brief  Convert a whole string into a single precision number
+ */
+static bool ParseValue(const std::string& str, float* value) {
+  char* end = nullptr;
+  errno = 0;
+  const float v = std::strtof(str.c_str(), &end);
+  if (str.empty() || *end != '\0' || errno == ERANGE) {
+    return false;
+  }
+  *value = v;
+  return true;
+}
+
+/*
+ *  @name   ParseValue
+ *  @brief  Convert a whole string into a boolean: true/false, 1/0, yes/no or on/off
+ */
+static bool ParseValue(const std::string& str, bool* value) {
+  std::string s = str;
+  std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+  if (s == "1" || s == "true" || s == "yes" || s == "on") {
+    *value = true;
+  } else if (s == "0" || s == "false" || s == "no" || s == "off") {
+    *value = false;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/*
+ *  @name   ParseValue
+ *  @brief  Convert a whole string into a string, always valid
+ */
+static bool ParseValue(const std::string& str, std::string* value) {
+  *value = str;
+  return true;
+}
+
 #pragma mark -
 #pragma mark Initialization
 
@@ -96,6 +214,34 @@ int CmdLineParser::AddArgument(const std::string& key,
   return error;
 }
 
+/*
+ *  @name AddArgument
+ *  @fn template<typename T> int AddArgument(const std::string& key,
+                                             const ArgState& state,
+                                             const std::string& description,
+                                             T* value)
+ *  @brief  Add an argument bound to a variable, converted once while
+ *          parsing
+ *  @param[in]  key         Char flag indicating for this argument
+ *  @param[in]  state       Argument's state #ArgState
+ *  @param[in]  description Description of the arguments
+ *  @param[out] value       Bound variable
+ *  @return Return -1 of key already set, 0 otherwise
+ */
+template<typename T>
+int CmdLineParser::AddArgument(const std::string& key,
+                               const ArgState& state,
+                               const std::string& description,
+                               T* value) {
+  int error = this->AddArgument(key, state, description);
+  if (!error) {
+    argument_.back()->assign = [value](const std::string& str) -> bool {
+      return ParseValue(str, value);
+    };
+  }
+  return error;
+}
+
 /*
  *  @name ParseCmdLine
  *  @fn int ParseCmdLine(const int argc, const char** argv)
@@ -117,13 +263,26 @@ int CmdLineParser::ParseCmdLine(const int argc, const char** argv) {
       // Argument present ?
       if (FaceKit::CmdOptionExists(argv, argv + argc, (*arg_it)->key)) {
         // Yes, get value
-        (*arg_it)->value = FaceKit::GetCmdOption(argv,
-                                              argv + argc,
-                                              (*arg_it)->key);
+        const char* value = FaceKit::GetCmdOption(argv,
+                                                  argv + argc,
+                                                  (*arg_it)->key);
+        if (value == nullptr) {
+          FACEKIT_LOG_ERROR("Missing value for " << (*arg_it)->key);
+          error = -1;
+          break;
+        }
+        (*arg_it)->value = value;
+        if ((*arg_it)->assign && !(*arg_it)->assign((*arg_it)->value)) {
+          FACEKIT_LOG_ERROR("Invalid value for " << (*arg_it)->key << ": "
+                            << (*arg_it)->value);
+          error = -1;
+          break;
+        }
+        (*arg_it)->present = true;
         error = 0;
       } else {
-        // Missing, optional ?
-        if ((*arg_it)->state == ArgState::kOptional) {
+        // Missing, optional or given by a configuration file ?
+        if ((*arg_it)->state == ArgState::kOptional || (*arg_it)->present) {
           error = 0;
         } else {
           error = -1;
@@ -135,6 +294,55 @@ int CmdLineParser::ParseCmdLine(const int argc, const char** argv) {
   return error;
 }
 
+/*
+ *  @name ParseConfigFile
+ *  @fn int ParseConfigFile(const std::string& path)
+ *  @brief  Read argument values from a file, one `<key> <value>` pair per
+ *          line, `#` starts a comment
+ *  @param[in]  path  Configuration file
+ *  @return -1 If the file can not be read, holds an unknown key or an
+ *          invalid value, 0 otherwise
+ */
+int CmdLineParser::ParseConfigFile(const std::string& path) {
+  std::ifstream stream(path.c_str());
+  if (!stream.is_open()) {
+    FACEKIT_LOG_ERROR("Unable to open " << path);
+    return -1;
+  }
+  std::string line;
+  size_t n_line = 0;
+  while (std::getline(stream, line)) {
+    n_line += 1;
+    line = line.substr(0, line.find('#'));
+    std::istringstream str(line);
+    std::string key, value;
+    if (!(str >> key)) {
+      continue;
+    }
+    std::getline(str >> std::ws, value);
+    value.erase(value.find_last_not_of(" \t\r") + 1);
+    key = key[0] == '-' ? key : "-" + key;
+    auto it = std::find_if(argument_.begin(),
+                           argument_.end(),
+                           [&](const Args* arg) -> bool {
+                             return arg->key == key;
+                           });
+    if (it == argument_.end() || key == "-h") {
+      FACEKIT_LOG_ERROR("Unknown option " << key << " at " << path << ":"
+                        << n_line);
+      return -1;
+    }
+    if ((*it)->assign && !(*it)->assign(value)) {
+      FACEKIT_LOG_ERROR("Invalid value for " << key << " at " << path << ":"
+                        << n_line << ": " << value);
+      return -1;
+    }
+    (*it)->value = value;
+    (*it)->present = true;
+  }
+  return 0;
+}
+
 /*
  *  @name HasArgument
  *  @fn bool HasArgument(const std::string& key, std::string* value) const;
@@ -150,7 +358,7 @@ bool CmdLineParser::HasArgument(const std::string& key, std::string* value) cons
                            argument_.end(),
                            [&](const Args* arg) ->bool {
                              bool ret = arg->key == key;
-                             if (ret) {
+                             if (ret && value) {
                                *value = arg->value;
                              }
                              return ret;
@@ -207,4 +415,43 @@ bool CmdOptionExists(const char** begin,
   return std::find(begin, end, option) != end;
 }
 
+#pragma mark -
+#pragma mark Explicit Instantiation
+
+/** Integer */
+template int CmdLineParser::AddArgument(const std::string&,
+                                        const ArgState&,
+                                        const std::string&,
+                                        int*);
+/** 64 bits integer */
+template int CmdLineParser::AddArgument(const std::string&,
+                                        const ArgState&,
+                                        const std::string&,
+                                        int64_t*);
+/** Size */
+template int CmdLineParser::AddArgument(const std::string&,
+                                        const ArgState&,
+                                        const std::string&,
+                                        size_t*);
+/** Float */
+template int CmdLineParser::AddArgument(const std::string&,
+                                        const ArgState&,
+                                        const std::string&,
+                                        float*);
+/** Double */
+template int CmdLineParser::AddArgument(const std::string&,
+                                        const ArgState&,
+                                        const std::string&,
+                                        double*);
+/** Boolean */
+template int CmdLineParser::AddArgument(const std::string&,
+                                        const ArgState&,
+                                        const std::string&,
+                                        bool*);
+/** String */
+template int CmdLineParser::AddArgument(const std::string&,
+                                        const ArgState&,
+                                        const std::string&,
+                                        std::string*);
+
 }  // namespace CHlib
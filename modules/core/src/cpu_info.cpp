@@ -0,0 +1,240 @@
+/**
+ *  @file   cpu_info.cpp
+ *  @brief Runtime detection of the CPU instruction sets and kernel dispatch
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define FK_X86
+#include <intrin.h>
+#include <immintrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && \
+      (defined(__x86_64__) || defined(__i386__))
+#define FK_X86
+#include <cpuid.h>
+#endif
+
+#include "facekit/core/sys/cpu_info.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+using Feature = CpuInfo::Feature;
+using Level = CpuInfo::Level;
+  
+/** Features required by each level, indexed by `Level` */
+static const Feature kLevelFeatures[] = {
+  Feature::kNone,
+  Feature::kNeon,
+  Feature::kSse2 | Feature::kSsse3 | Feature::kSse41 | Feature::kSse42,
+  Feature::kSse2 | Feature::kSsse3 | Feature::kSse41 | Feature::kSse42 |
+  Feature::kAvx | Feature::kAvx2 | Feature::kFma | Feature::kF16c,
+  Feature::kSse2 | Feature::kSsse3 | Feature::kSse41 | Feature::kSse42 |
+  Feature::kAvx | Feature::kAvx2 | Feature::kFma | Feature::kF16c |
+  Feature::kAvx512f | Feature::kAvx512bw | Feature::kAvx512vl
+};
+  
+#ifdef FK_X86
+/**
+ *  @name   Cpuid
+ *  @fn     static void Cpuid(const uint32_t& leaf, const uint32_t& sub,
+                              uint32_t* regs)
+ *  @brief  Query cpuid
+ *  @param[in] leaf   Leaf
+ *  @param[in] sub    Sub-leaf
+ *  @param[out] regs  eax, ebx, ecx, edx
+ */
+static void Cpuid(const uint32_t& leaf, const uint32_t& sub, uint32_t* regs) {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuidex(info, static_cast<int>(leaf), static_cast<int>(sub));
+  std::memcpy(regs, info, sizeof(info));
+#else
+  __cpuid_count(leaf, sub, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/**
+ *  @name   Xcr0
+ *  @fn     static uint64_t Xcr0(void)
+ *  @brief  Register states saved by the OS, needs OSXSAVE
+ *  @return XCR0
+ */
+static uint64_t Xcr0(void) {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif
+  
+/**
+ *  @name   Detect
+ *  @fn     static Feature Detect(std::string* vendor)
+ *  @brief  Detect the features supported by the CPU and enabled by the OS
+ *  @param[out] vendor  CPU vendor
+ *  @return Features
+ */
+static Feature Detect(std::string* vendor) {
+  Feature f = Feature::kNone;
+#ifdef FK_X86
+  uint32_t r[4];
+  Cpuid(0, 0, r);
+  const uint32_t max_leaf = r[0];
+  char name[13];
+  std::memcpy(name, &r[1], 4);
+  std::memcpy(name + 4, &r[3], 4);
+  std::memcpy(name + 8, &r[2], 4);
+  name[12] = '\0';
+  *vendor = name;
+  if (max_leaf < 1) {
+    return f;
+  }
+  Cpuid(1, 0, r);
+  const uint32_t ecx = r[2];
+  const uint32_t edx = r[3];
+  auto set = [&](const bool& cond, const Feature& feature) {
+    if (cond) {
+      f = f | feature;
+    }
+  };
+  set(edx & (1u << 26), Feature::kSse2);
+  set(ecx & (1u << 9), Feature::kSsse3);
+  set(ecx & (1u << 19), Feature::kSse41);
+  set(ecx & (1u << 20), Feature::kSse42);
+  // AVX registers need to be saved by the OS as well
+  const bool osxsave = (ecx & (1u << 27)) != 0;
+  const uint64_t xcr0 = osxsave ? Xcr0() : 0;
+  const bool ymm = (xcr0 & 0x6) == 0x6;
+  const bool zmm = (xcr0 & 0xE6) == 0xE6;
+  if (ymm) {
+    set(ecx & (1u << 28), Feature::kAvx);
+    set(ecx & (1u << 12), Feature::kFma);
+    set(ecx & (1u << 29), Feature::kF16c);
+  }
+  if (max_leaf >= 7) {
+    Cpuid(7, 0, r);
+    const uint32_t ebx = r[1];
+    if (ymm) {
+      set(ebx & (1u << 5), Feature::kAvx2);
+    }
+    if (zmm) {
+      set(ebx & (1u << 16), Feature::kAvx512f);
+      set(ebx & (1u << 30), Feature::kAvx512bw);
+      set(ebx & (1u << 31), Feature::kAvx512vl);
+    }
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  // Part of the baseline the library is compiled for
+  f = Feature::kNeon;
+  *vendor = "ARM";
+#endif
+  return f;
+}
+  
+/**
+ *  @name   ParseLevel
+ *  @fn     static bool ParseLevel(const char* str, Level* level)
+ *  @brief  Convert the value of `FACEKIT_CPU_LEVEL`
+ *  @param[in] str      Value
+ *  @param[out] level   Level
+ *  @return True if recognized
+ */
+static bool ParseLevel(const char* str, Level* level) {
+  static const std::pair<const char*, Level> kNames[] = {
+    {"scalar", Level::kScalar},
+    {"neon", Level::kNeon},
+    {"sse4.2", Level::kSse42},
+    {"avx2", Level::kAvx2},
+    {"avx512", Level::kAvx512}
+  };
+  for (const auto& n : kNames) {
+    if (std::strcmp(str, n.first) == 0) {
+      *level = n.second;
+      return true;
+    }
+  }
+  return false;
+}
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+/*
+ *  @name   CpuInfo
+ *  @fn     CpuInfo(void)
+ *  @brief  Constructor, detect the features
+ */
+CpuInfo::CpuInfo(void) : features_(Feature::kNone), level_(Level::kScalar) {
+  features_ = Detect(&vendor_);
+  // User cap, features above it are hidden as well
+  Level cap;
+  const char* env = std::getenv("FACEKIT_CPU_LEVEL");
+  if (env != nullptr && ParseLevel(env, &cap)) {
+    features_ = features_ & kLevelFeatures[static_cast<int>(cap)];
+  }
+  // Highest level whose features are all there
+  for (int l = static_cast<int>(Level::kAvx512); l > 0; --l) {
+    if (this->Has(kLevelFeatures[l])) {
+      level_ = static_cast<Level>(l);
+      break;
+    }
+  }
+}
+  
+#pragma mark -
+#pragma mark Usage
+  
+/*
+ *  @name   Get
+ *  @fn     static const CpuInfo& Get(void)
+ *  @brief  Features of the CPU this process runs on
+ *  @return CPU information
+ */
+const CpuInfo& CpuInfo::Get(void) {
+  static const CpuInfo info;
+  return info;
+}
+  
+/*
+ *  @name   Supports
+ *  @fn     bool Supports(const Level& level) const
+ *  @brief  Check if kernels written for a given level can run
+ *  @param[in] level  Level
+ *  @return True if supported
+ */
+bool CpuInfo::Supports(const Level& level) const {
+  return this->Has(kLevelFeatures[static_cast<int>(level)]);
+}
+  
+/*
+ *  @name   LevelName
+ *  @fn     static const char* LevelName(const Level& level)
+ *  @brief  Human readable name of a level
+ *  @param[in] level  Level
+ *  @return Name
+ */
+const char* CpuInfo::LevelName(const Level& level) {
+  switch (level) {
+    case Level::kNeon: return "NEON";
+    case Level::kSse42: return "SSE4.2";
+    case Level::kAvx2: return "AVX2";
+    case Level::kAvx512: return "AVX-512";
+    default: return "Scalar";
+  }
+}
+  
+}  // namespace FaceKit
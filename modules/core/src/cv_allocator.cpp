@@ -0,0 +1,173 @@
+/**
+ *  @file   cv_allocator.cpp
+ *  @brief Route OpenCV matrix allocations through FaceKit allocators
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <mutex>
+
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/mem/allocator.hpp"
+#include "facekit/core/mem/allocator_factory.hpp"
+#include "facekit/core/mem/cv_allocator.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+constexpr size_t CvAllocator::kAlignment;
+
+/** Allocator selected by the calling thread */
+static thread_local Allocator* thread_allocator = nullptr;
+
+#pragma mark -
+#pragma mark OpenCV Allocator
+
+/**
+ *  @class  DispatchMatAllocator
+ *  @brief  OpenCV default allocator forwarding to the calling thread's
+ *          allocator. The allocator that provided the data is attached to
+ *          `UMatData::userdata`, matrices from the fallback allocator never
+ *          come back here.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup core
+ */
+class DispatchMatAllocator : public cv::MatAllocator {
+ public:
+
+  /**
+   *  @name   DispatchMatAllocator
+   *  @fn     explicit DispatchMatAllocator(cv::MatAllocator* fallback)
+   *  @brief  Constructor
+   *  @param[in] fallback Allocator used without thread allocator
+   */
+  explicit DispatchMatAllocator(cv::MatAllocator* fallback) :
+          fallback_(fallback) {}
+
+  /**
+   *  @name   allocate
+   *  @brief  Allocate a new matrix with the thread's allocator, dense steps
+   */
+  cv::UMatData* allocate(int dims,
+                         const int* sizes,
+                         int type,
+                         void* data,
+                         size_t* step,
+                         int flags,
+                         cv::UMatUsageFlags usage) const override {
+    Allocator* alloc = thread_allocator;
+    if (alloc == nullptr || data != nullptr) {
+      return fallback_->allocate(dims, sizes, type, data, step, flags, usage);
+    }
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; --i) {
+      if (step) {
+        step[i] = total;
+      }
+      total *= static_cast<size_t>(sizes[i]);
+    }
+    void* ptr = alloc->AllocateRaw(total, CvAllocator::kAlignment);
+    if (ptr == nullptr) {
+      return fallback_->allocate(dims, sizes, type, data, step, flags, usage);
+    }
+    cv::UMatData* u = new cv::UMatData(this);
+    u->data = u->origdata = static_cast<uchar*>(ptr);
+    u->size = total;
+    u->userdata = alloc;
+    return u;
+  }
+
+  /**
+   *  @name   allocate
+   *  @brief  Allocate data for an existing UMatData, host memory is already
+   *          there
+   */
+  bool allocate(cv::UMatData* data,
+                int flags,
+                cv::UMatUsageFlags usage) const override {
+    return data != nullptr;
+  }
+
+  /**
+   *  @name   deallocate
+   *  @brief  Give the data back to the allocator that provided it
+   */
+  void deallocate(cv::UMatData* data) const override {
+    if (!data) {
+      return;
+    }
+    CV_Assert(data->urefcount == 0 && data->refcount == 0);
+    Allocator* alloc = static_cast<Allocator*>(data->userdata);
+    alloc->DeallocateRaw(data->size, data->origdata);
+    delete data;
+  }
+
+ private:
+  /** Allocator used without thread allocator */
+  cv::MatAllocator* fallback_;
+};
+
+/**
+ *  @name   InstallHook
+ *  @fn     static void InstallHook(void)
+ *  @brief  Make the dispatching allocator OpenCV's default one, once
+ */
+static void InstallHook(void) {
+  static std::once_flag flag;
+  std::call_once(flag, []() {
+    // Never destroyed, matrices may be released during static destruction
+    auto* hook = new DispatchMatAllocator(cv::Mat::getDefaultAllocator());
+    cv::Mat::setDefaultAllocator(hook);
+  });
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Pooled
+ *  @fn     static Allocator* Pooled(void)
+ *  @brief  Pooled CPU allocator, the usual choice for temporaries
+ *  @return Allocator registered as `pooled_cpu_allocator`
+ */
+Allocator* CvAllocator::Pooled(void) {
+  static Allocator* pooled =
+          AllocatorFactory::Get().GetAllocator("pooled_cpu_allocator");
+  return pooled;
+}
+
+/*
+ *  @name   GetThreadAllocator
+ *  @fn     static Allocator* GetThreadAllocator(void)
+ *  @brief  Allocator used by the calling thread
+ *  @return Allocator or nullptr if OpenCV's one is used
+ */
+Allocator* CvAllocator::GetThreadAllocator(void) {
+  return thread_allocator;
+}
+
+/*
+ *  @name   SetThreadAllocator
+ *  @fn     static Allocator* SetThreadAllocator(Allocator* allocator)
+ *  @brief  Select the allocator used by the calling thread
+ *  @param[in] allocator  Allocator, nullptr to go back to OpenCV's one
+ *  @return Previously selected allocator
+ */
+Allocator* CvAllocator::SetThreadAllocator(Allocator* allocator) {
+  if (allocator) {
+    InstallHook();
+  }
+  Allocator* prev = thread_allocator;
+  thread_allocator = allocator;
+  return prev;
+}
+
+}  // namespace FaceKit
@@ -0,0 +1,525 @@
+/**
+ *  @file   device_linear_algebra.cpp
+ *  @brief  GPU (CUDA / cuBLAS) counterpart of `LinearAlgebra` for large
+ *          matrix products
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#ifdef FACEKIT_HAS_CUDA
+#include <cuda_runtime.h>
+#include <cublas_v2.h>
+#endif
+
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/math/device_linear_algebra.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#ifndef FACEKIT_HAS_CUDA
+/**
+ *  @name   NoDevice
+ *  @fn     static Status NoDevice(void)
+ *  @brief  Error returned by every device operation without CUDA
+ */
+static Status NoDevice(void) {
+  return Status(Status::Type::kUnimplemented, "FaceKit built without CUDA");
+}
+#else
+/**
+ *  @name   CheckCuda
+ *  @fn     static Status CheckCuda(const cudaError_t& err, const char* what)
+ *  @brief  Convert a CUDA runtime error
+ *  @param[in] err    Error code
+ *  @param[in] what   Failed operation
+ */
+static Status CheckCuda(const cudaError_t& err, const char* what) {
+  if (err == cudaSuccess) {
+    return Status();
+  }
+  return Status(Status::Type::kInternalError,
+                std::string(what) + ": " + cudaGetErrorString(err));
+}
+
+/**
+ *  @name   CheckBlas
+ *  @fn     static Status CheckBlas(const cublasStatus_t& err,
+                                    const char* what)
+ *  @brief  Convert a cuBLAS error
+ *  @param[in] err    Error code
+ *  @param[in] what   Failed operation
+ */
+static Status CheckBlas(const cublasStatus_t& err, const char* what) {
+  if (err == CUBLAS_STATUS_SUCCESS) {
+    return Status();
+  }
+  return Status(Status::Type::kInternalError,
+                std::string(what) + ": cuBLAS error " +
+                std::to_string(static_cast<int>(err)));
+}
+
+/**
+ *  @name   CublasGemm
+ *  @brief  Type dispatch of the cuBLAS column major product
+ */
+static cublasStatus_t CublasGemm(cublasHandle_t handle,
+                                 cublasOperation_t trans_a,
+                                 cublasOperation_t trans_b,
+                                 int m, int n, int k,
+                                 const float* alpha,
+                                 const float* A, int lda,
+                                 const float* B, int ldb,
+                                 const float* beta,
+                                 float* C, int ldc) {
+  return cublasSgemm(handle, trans_a, trans_b, m, n, k, alpha, A, lda, B, ldb,
+                     beta, C, ldc);
+}
+static cublasStatus_t CublasGemm(cublasHandle_t handle,
+                                 cublasOperation_t trans_a,
+                                 cublasOperation_t trans_b,
+                                 int m, int n, int k,
+                                 const double* alpha,
+                                 const double* A, int lda,
+                                 const double* B, int ldb,
+                                 const double* beta,
+                                 double* C, int ldc) {
+  return cublasDgemm(handle, trans_a, trans_b, m, n, k, alpha, A, lda, B, ldb,
+                     beta, C, ldc);
+}
+#endif
+
+#pragma mark -
+#pragma mark DeviceStream
+
+/*
+ *  @name   IsAvailable
+ *  @fn     static bool IsAvailable(void)
+ *  @brief  Indicate if FaceKit is built with CUDA and a device is present
+ */
+bool DeviceStream::IsAvailable(void) {
+#ifdef FACEKIT_HAS_CUDA
+  static const bool available = []() {
+    int n = 0;
+    return cudaGetDeviceCount(&n) == cudaSuccess && n > 0;
+  }();
+  return available;
+#else
+  return false;
+#endif
+}
+
+/*
+ *  @name   DeviceStream
+ *  @fn     DeviceStream(void)
+ *  @brief  Constructor, the stream is created by `Init`
+ */
+DeviceStream::DeviceStream(void) : stream_(nullptr), handle_(nullptr) {}
+
+/*
+ *  @name   ~DeviceStream
+ *  @fn     ~DeviceStream(void)
+ *  @brief  Destructor, wait for pending operations
+ */
+DeviceStream::~DeviceStream(void) {
+#ifdef FACEKIT_HAS_CUDA
+  if (stream_ != nullptr) {
+    cudaStreamSynchronize(static_cast<cudaStream_t>(stream_));
+  }
+  if (handle_ != nullptr) {
+    cublasDestroy(static_cast<cublasHandle_t>(handle_));
+  }
+  if (stream_ != nullptr) {
+    cudaStreamDestroy(static_cast<cudaStream_t>(stream_));
+  }
+#endif
+}
+
+/*
+ *  @name   Init
+ *  @fn     Status Init(void)
+ *  @brief  Create the stream and its cuBLAS handle, does nothing if
+ *          already created
+ *  @return `kUnimplemented` without CUDA, `kInternalError` if the device
+ *          can not be initialized
+ */
+Status DeviceStream::Init(void) {
+#ifdef FACEKIT_HAS_CUDA
+  if (handle_ != nullptr) {
+    return Status();
+  }
+  if (!IsAvailable()) {
+    return Status(Status::Type::kInternalError, "No CUDA device");
+  }
+  cudaStream_t stream = nullptr;
+  Status status = CheckCuda(cudaStreamCreateWithFlags(&stream,
+                                                      cudaStreamNonBlocking),
+                            "cudaStreamCreate");
+  if (!status.Good()) {
+    return status;
+  }
+  stream_ = stream;
+  cublasHandle_t handle = nullptr;
+  status = CheckBlas(cublasCreate(&handle), "cublasCreate");
+  if (status.Good()) {
+    handle_ = handle;
+    status = CheckBlas(cublasSetStream(handle, stream), "cublasSetStream");
+  }
+  return status;
+#else
+  return NoDevice();
+#endif
+}
+
+/*
+ *  @name   Synchronize
+ *  @fn     Status Synchronize(void)
+ *  @brief  Wait until every operation issued on the stream is done
+ *  @return Error of the first failed operation if any
+ */
+Status DeviceStream::Synchronize(void) {
+#ifdef FACEKIT_HAS_CUDA
+  if (stream_ == nullptr) {
+    return Status(Status::Type::kInvalidArgument, "Stream not initialized");
+  }
+  return CheckCuda(cudaStreamSynchronize(static_cast<cudaStream_t>(stream_)),
+                   "cudaStreamSynchronize");
+#else
+  return NoDevice();
+#endif
+}
+
+#pragma mark -
+#pragma mark PinnedBuffer
+
+/*
+ *  @name   ~PinnedBuffer
+ *  @fn     ~PinnedBuffer(void)
+ *  @brief  Destructor
+ */
+PinnedBuffer::~PinnedBuffer(void) {
+#ifdef FACEKIT_HAS_CUDA
+  if (data_ != nullptr) {
+    cudaFreeHost(data_);
+  }
+#endif
+}
+
+/*
+ *  @name   Resize
+ *  @fn     Status Resize(const size_t& size)
+ *  @brief  Make room for at least \p size bytes, content is not preserved
+ *          when the buffer grows
+ *  @param[in] size   Size in bytes
+ *  @return `kUnimplemented` without CUDA, `kInternalError` if the
+ *          allocation fails
+ */
+Status PinnedBuffer::Resize(const size_t& size) {
+#ifdef FACEKIT_HAS_CUDA
+  if (size <= size_) {
+    return Status();
+  }
+  if (data_ != nullptr) {
+    cudaFreeHost(data_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+  Status status = CheckCuda(cudaMallocHost(&data_, size), "cudaMallocHost");
+  if (status.Good()) {
+    size_ = size;
+  } else {
+    data_ = nullptr;
+  }
+  return status;
+#else
+  return NoDevice();
+#endif
+}
+
+#pragma mark -
+#pragma mark DeviceMatrix
+
+/*
+ *  @name   DeviceMatrix
+ *  @fn     DeviceMatrix(DeviceMatrix&& other)
+ *  @brief  Move constructor
+ */
+template<typename T>
+DeviceMatrix<T>::DeviceMatrix(DeviceMatrix&& other) :
+        data_(other.data_),
+        rows_(other.rows_),
+        cols_(other.cols_),
+        capacity_(other.capacity_) {
+  other.data_ = nullptr;
+  other.rows_ = 0;
+  other.cols_ = 0;
+  other.capacity_ = 0;
+}
+
+/*
+ *  @name   operator=
+ *  @fn     DeviceMatrix& operator=(DeviceMatrix&& rhs)
+ *  @brief  Move assignment operator
+ */
+template<typename T>
+DeviceMatrix<T>& DeviceMatrix<T>::operator=(DeviceMatrix&& rhs) {
+  if (this != &rhs) {
+    std::swap(data_, rhs.data_);
+    std::swap(rows_, rhs.rows_);
+    std::swap(cols_, rhs.cols_);
+    std::swap(capacity_, rhs.capacity_);
+  }
+  return *this;
+}
+
+/*
+ *  @name   ~DeviceMatrix
+ *  @fn     ~DeviceMatrix(void)
+ *  @brief  Destructor
+ */
+template<typename T>
+DeviceMatrix<T>::~DeviceMatrix(void) {
+#ifdef FACEKIT_HAS_CUDA
+  if (data_ != nullptr) {
+    cudaFree(data_);
+  }
+#endif
+}
+
+/*
+ *  @name   Create
+ *  @fn     Status Create(const int& rows, const int& cols)
+ *  @brief  Shape the matrix, allocates only if the current memory is too
+ *          small
+ *  @param[in] rows   Number of rows
+ *  @param[in] cols   Number of columns
+ *  @return `kUnimplemented` without CUDA, `kInternalError` if the
+ *          allocation fails
+ */
+template<typename T>
+Status DeviceMatrix<T>::Create(const int& rows, const int& cols) {
+#ifdef FACEKIT_HAS_CUDA
+  if (rows < 0 || cols < 0) {
+    return Status(Status::Type::kInvalidArgument, "Negative dimension");
+  }
+  const size_t n = static_cast<size_t>(rows) * static_cast<size_t>(cols);
+  if (n > capacity_) {
+    if (data_ != nullptr) {
+      cudaFree(data_);
+      data_ = nullptr;
+      capacity_ = 0;
+    }
+    void* ptr = nullptr;
+    Status status = CheckCuda(cudaMalloc(&ptr, n * sizeof(T)), "cudaMalloc");
+    if (!status.Good()) {
+      rows_ = 0;
+      cols_ = 0;
+      return status;
+    }
+    data_ = static_cast<T*>(ptr);
+    capacity_ = n;
+  }
+  rows_ = rows;
+  cols_ = cols;
+  return Status();
+#else
+  return NoDevice();
+#endif
+}
+
+/*
+ *  @name   Upload
+ *  @fn     Status Upload(const cv::Mat& matrix)
+ *  @brief  Copy a host matrix of type T, blocking
+ *  @param[in] matrix Host matrix
+ *  @return `kInvalidArgument` if \p matrix is not of type T
+ */
+template<typename T>
+Status DeviceMatrix<T>::Upload(const cv::Mat& matrix) {
+#ifdef FACEKIT_HAS_CUDA
+  if (matrix.type() != cv::DataType<T>::type) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Matrix must be of the device matrix's type");
+  }
+  const cv::Mat src = matrix.isContinuous() ? matrix : matrix.clone();
+  Status status = this->Create(src.rows, src.cols);
+  if (status.Good()) {
+    status = CheckCuda(cudaMemcpy(data_,
+                                  src.data,
+                                  src.total() * sizeof(T),
+                                  cudaMemcpyHostToDevice),
+                       "cudaMemcpy");
+  }
+  return status;
+#else
+  return NoDevice();
+#endif
+}
+
+/*
+ *  @name   Upload
+ *  @fn     Status Upload(const T* src, DeviceStream* stream)
+ *  @brief  Queue the copy of `rows() * cols()` elements from the host,
+ *          asynchronous if \p src is pinned (see `PinnedBuffer`)
+ *  @param[in] src        Host data, must stay valid until the stream is
+ *                        synchronized
+ *  @param[in] stream     Stream to queue the copy on
+ *  @return Error if the copy can not be queued
+ */
+template<typename T>
+Status DeviceMatrix<T>::Upload(const T* src, DeviceStream* stream) {
+#ifdef FACEKIT_HAS_CUDA
+  const size_t n = static_cast<size_t>(rows_) * static_cast<size_t>(cols_);
+  auto s = static_cast<cudaStream_t>(stream->native_stream());
+  return CheckCuda(cudaMemcpyAsync(data_,
+                                   src,
+                                   n * sizeof(T),
+                                   cudaMemcpyHostToDevice,
+                                   s),
+                   "cudaMemcpyAsync");
+#else
+  return NoDevice();
+#endif
+}
+
+/*
+ *  @name   Download
+ *  @fn     Status Download(cv::Mat* matrix) const
+ *  @brief  Copy the matrix to the host, blocking
+ *  @param[out] matrix    Host matrix
+ *  @return Error if the copy fails
+ */
+template<typename T>
+Status DeviceMatrix<T>::Download(cv::Mat* matrix) const {
+#ifdef FACEKIT_HAS_CUDA
+  matrix->create(rows_, cols_, cv::DataType<T>::type);
+  return CheckCuda(cudaMemcpy(matrix->data,
+                              data_,
+                              matrix->total() * sizeof(T),
+                              cudaMemcpyDeviceToHost),
+                   "cudaMemcpy");
+#else
+  return NoDevice();
+#endif
+}
+
+/*
+ *  @name   Download
+ *  @fn     Status Download(T* dst, DeviceStream* stream) const
+ *  @brief  Queue the copy of `rows() * cols()` elements to the host,
+ *          asynchronous if \p dst is pinned (see `PinnedBuffer`)
+ *  @param[out] dst       Host data, valid once the stream is synchronized
+ *  @param[in] stream     Stream to queue the copy on
+ *  @return Error if the copy can not be queued
+ */
+template<typename T>
+Status DeviceMatrix<T>::Download(T* dst, DeviceStream* stream) const {
+#ifdef FACEKIT_HAS_CUDA
+  const size_t n = static_cast<size_t>(rows_) * static_cast<size_t>(cols_);
+  auto s = static_cast<cudaStream_t>(stream->native_stream());
+  return CheckCuda(cudaMemcpyAsync(dst,
+                                   data_,
+                                   n * sizeof(T),
+                                   cudaMemcpyDeviceToHost,
+                                   s),
+                   "cudaMemcpyAsync");
+#else
+  return NoDevice();
+#endif
+}
+
+#pragma mark -
+#pragma mark DeviceLinearAlgebra
+
+/*
+ *  @name   Gemm
+ *  @fn     static Status Gemm(const DeviceMatrix<T>& A,
+                               const TransposeType trans_a,
+                               const T alpha,
+                               const DeviceMatrix<T>& B,
+                               const TransposeType trans_b,
+                               const T beta,
+                               DeviceMatrix<T>* C,
+                               DeviceStream* stream)
+ *  @brief  Queue the product between two matrices
+ *          C = a * AB + b * C
+ *  @param[in] A         Matrix A
+ *  @param[in] trans_a   Transpose flag indicator for A
+ *  @param[in] alpha     Alpha coefficient
+ *  @param[in] B         Matrix B
+ *  @param[in] trans_b   Transpose flag indicator for B
+ *  @param[in] beta      Beta coefficient
+ *  @param[in,out] C     Resulting matrix, shaped if needed
+ *  @param[in] stream    Stream to queue the product on
+ *  @return `kInvalidArgument` if dimensions do not agree
+ */
+template<typename T>
+Status DeviceLinearAlgebra<T>::Gemm(const DeviceMatrix<T>& A,
+                                    const TransposeType trans_a,
+                                    const T alpha,
+                                    const DeviceMatrix<T>& B,
+                                    const TransposeType trans_b,
+                                    const T beta,
+                                    DeviceMatrix<T>* C,
+                                    DeviceStream* stream) {
+#ifdef FACEKIT_HAS_CUDA
+  const bool ta = trans_a != TransposeType::kNoTranspose;
+  const bool tb = trans_b != TransposeType::kNoTranspose;
+  const int out_row = ta ? A.cols() : A.rows();
+  const int out_col = tb ? B.rows() : B.cols();
+  const int K = ta ? A.rows() : A.cols();
+  if (K != (tb ? B.cols() : B.rows())) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Inner dimensions do not agree");
+  }
+  if (stream == nullptr || stream->native_handle() == nullptr) {
+    return Status(Status::Type::kInvalidArgument, "Stream not initialized");
+  }
+  Status status = C->Create(out_row, out_col);
+  if (!status.Good() || C->empty()) {
+    return status;
+  }
+  // Row major C = op(A) op(B) is column major C^T = op(B)^T op(A)^T
+  auto handle = static_cast<cublasHandle_t>(stream->native_handle());
+  return CheckBlas(CublasGemm(handle,
+                              tb ? CUBLAS_OP_T : CUBLAS_OP_N,
+                              ta ? CUBLAS_OP_T : CUBLAS_OP_N,
+                              out_col,
+                              out_row,
+                              K,
+                              &alpha,
+                              B.data(),
+                              std::max(B.cols(), 1),
+                              A.data(),
+                              std::max(A.cols(), 1),
+                              &beta,
+                              C->data(),
+                              C->cols()),
+                   "cublasGemm");
+#else
+  return NoDevice();
+#endif
+}
+
+#pragma mark -
+#pragma mark Explicit Instantiation
+
+/** Float */
+template class DeviceMatrix<float>;
+template class DeviceLinearAlgebra<float>;
+/** Double */
+template class DeviceMatrix<double>;
+template class DeviceLinearAlgebra<double>;
+
+}  // namespace FaceKit
@@ -0,0 +1,438 @@
+/**
+ *  @file   disk_cache.cpp
+ *  @brief Content-addressed on-disk cache for derived artifacts (i.e.
+ *         processed meshes, resized images). Entries are keyed by a hash of
+ *         their inputs and parameters, and bounded in size with an LRU
+ *         policy.
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   24.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "facekit/core/sys/disk_cache.hpp"
+#include "facekit/core/sys/file_system.hpp"
+#include "facekit/core/sys/file_system_factory.hpp"
+#include "facekit/core/utils/string.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#pragma mark -
+#pragma mark Key
+
+/** Multiplicative constants, from MurmurHash3 */
+static constexpr uint64_t kKeyC1 = 0x87C37B91114253D5ULL;
+static constexpr uint64_t kKeyC2 = 0x4CF5AD432745937FULL;
+
+/**
+ *  @name   Rotl
+ *  @fn     static inline uint64_t Rotl(const uint64_t& x, const int& r)
+ *  @brief  Rotate left
+ */
+static inline uint64_t Rotl(const uint64_t& x, const int& r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+/**
+ *  @name   Fmix
+ *  @fn     static inline uint64_t Fmix(uint64_t k)
+ *  @brief  Final avalanche
+ */
+static inline uint64_t Fmix(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xFF51AFD7ED558CCDULL;
+  k ^= k >> 33;
+  k *= 0xC4CEB9FE1A85EC53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+/*
+ *  @name   CacheKey
+ *  @fn     CacheKey(void)
+ *  @brief  Constructor
+ */
+CacheKey::CacheKey(void) : h_{0x9E3779B97F4A7C15ULL, 0xD6E8FEB86659FD93ULL},
+                           n_tail_(0),
+                           length_(0) {
+}
+
+/*
+ *  @name   Update
+ *  @fn     void Update(const uint64_t& word)
+ *  @brief  Mix one 8 bytes word in the state
+ */
+void CacheKey::Update(const uint64_t& word) {
+  // Both lanes see every word with different constants, cheap enough to
+  // hash large inputs (i.e. image bytes)
+  uint64_t k1 = Rotl(word * kKeyC1, 31) * kKeyC2;
+  uint64_t k2 = Rotl(word * kKeyC2, 33) * kKeyC1;
+  h_[0] = (Rotl(h_[0] ^ k1, 27) + h_[1]) * 5 + 0x52DCE729;
+  h_[1] = (Rotl(h_[1] ^ k2, 31) + h_[0]) * 5 + 0x38495AB5;
+}
+
+/*
+ *  @name   Add
+ *  @fn     CacheKey& Add(const void* data, const size_t& n)
+ *  @brief  Hash raw bytes
+ *  @param[in] data Bytes
+ *  @param[in] n    Number of bytes
+ *  @return Key, for chaining
+ */
+CacheKey& CacheKey::Add(const void* data, const size_t& n) {
+  const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data);
+  size_t k = 0;
+  length_ += n;
+  // Complete pending word
+  if (n_tail_ > 0) {
+    while (n_tail_ < 8 && k < n) {
+      tail_[n_tail_++] = ptr[k++];
+    }
+    if (n_tail_ < 8) {
+      return *this;
+    }
+    uint64_t word;
+    std::memcpy(&word, tail_, 8);
+    this->Update(word);
+    n_tail_ = 0;
+  }
+  // Whole words
+  for (; k + 8 <= n; k += 8) {
+    uint64_t word;
+    std::memcpy(&word, ptr + k, 8);
+    this->Update(word);
+  }
+  // Remainder
+  for (; k < n; ++k) {
+    tail_[n_tail_++] = ptr[k];
+  }
+  return *this;
+}
+
+/*
+ *  @name   Add
+ *  @fn     CacheKey& Add(const std::string& str)
+ *  @brief  Hash a string, its length is included so consecutive strings
+ *          can not alias
+ *  @param[in] str  String
+ *  @return Key, for chaining
+ */
+CacheKey& CacheKey::Add(const std::string& str) {
+  const uint64_t n = str.size();
+  this->Add(&n, sizeof(n));
+  return this->Add(str.data(), str.size());
+}
+
+/*
+ *  @name   ToString
+ *  @fn     std::string ToString(void) const
+ *  @brief  Digest of everything added so far, 32 hexadecimal characters
+ *  @return Digest
+ */
+std::string CacheKey::ToString(void) const {
+  // Finalize a copy, more bytes can still be added afterwards
+  CacheKey key(*this);
+  uint64_t last = 0;
+  std::memcpy(&last, key.tail_, key.n_tail_);
+  key.Update(last ^ (static_cast<uint64_t>(key.n_tail_) << 56));
+  uint64_t h1 = key.h_[0] ^ length_;
+  uint64_t h2 = key.h_[1] ^ length_;
+  h1 += h2;
+  h2 += h1;
+  h1 = Fmix(h1);
+  h2 = Fmix(h2);
+  h1 += h2;
+  h2 += h1;
+  static const char* hex = "0123456789abcdef";
+  std::string digest(32, '0');
+  for (int i = 0; i < 16; ++i) {
+    digest[15 - i] = hex[(h1 >> (4 * i)) & 0xF];
+    digest[31 - i] = hex[(h2 >> (4 * i)) & 0xF];
+  }
+  return digest;
+}
+
+#pragma mark -
+#pragma mark Cache
+
+/** Extension of published entries */
+static const char* kEntryExt = "fkc";
+/** Extension of entries being written */
+static const char* kTmpExt = "tmp";
+/** Age after which a temporary file is considered abandoned, in seconds */
+static constexpr int64_t kTmpMaxAge = 3600;
+
+/*
+ *  @name   DiskCache
+ *  @fn     DiskCache(void)
+ *  @brief  Constructor
+ */
+DiskCache::DiskCache(void) : fs_(nullptr),
+                             max_size_(0),
+                             size_(0),
+                             token_(0),
+                             n_tmp_(0) {
+}
+
+/*
+ *  @name   Open
+ *  @fn     Status Open(const std::string& dir, const size_t& max_size)
+ *  @brief  Open (or create) a cache directory, index existing entries and
+ *          delete leftovers of interrupted writes
+ *  @param[in] dir      Cache directory
+ *  @param[in] max_size Maximum size of the entries in bytes
+ *  @return Operation status
+ */
+Status DiskCache::Open(const std::string& dir, const size_t& max_size) {
+  FileSystem* fs = FileSystemFactory::Get().RetrieveForPath(dir);
+  if (fs == nullptr) {
+    return Status(Status::Type::kUnimplemented,
+                  "No file system registered for: " + dir);
+  }
+  Status s = fs->CreateDirRecursively(dir);
+  std::vector<std::string> files;
+  if (s.Good()) {
+    s = fs->ListDir(dir, &files);
+  }
+  if (!s.Good()) {
+    return s;
+  }
+  // Gather entries
+  struct Found {
+    std::string key;
+    size_t size;
+    int64_t mtime;
+  };
+  std::vector<Found> found;
+  const int64_t now = static_cast<int64_t>(std::time(nullptr));
+  for (const auto& path : files) {
+    const std::string name = Path::Basename(path);
+    const std::string ext = Path::Extension(name);
+    FileProperty prop;
+    if (!fs->FileProp(path, &prop).Good() || prop.is_dir) {
+      continue;
+    }
+    if (ext == kEntryExt) {
+      found.push_back({name.substr(0, name.size() - ext.size() - 1),
+                       prop.size,
+                       prop.mtime});
+    } else if (ext == kTmpExt && now - prop.mtime > kTmpMaxAge) {
+      fs->DeleteFile(path);
+    }
+  }
+  // Most recent first
+  std::stable_sort(found.begin(), found.end(),
+                   [](const Found& a, const Found& b) {
+                     return a.mtime > b.mtime;
+                   });
+  std::lock_guard<std::mutex> lock(lock_);
+  dir_ = dir;
+  fs_ = fs;
+  max_size_ = max_size;
+  size_ = 0;
+  lru_.clear();
+  index_.clear();
+  std::random_device rd;
+  token_ = (static_cast<uint64_t>(rd()) << 32) | rd();
+  for (const auto& e : found) {
+    lru_.push_back(Entry{e.key, e.size});
+    index_[e.key] = std::prev(lru_.end());
+    size_ += e.size;
+  }
+  this->Evict();
+  return s;
+}
+
+/*
+ *  @name   Lookup
+ *  @fn     Status Lookup(const std::string& key, std::string* data)
+ *  @brief  Load an entry and mark it as recently used
+ *  @param[in] key    Entry key, see `CacheKey::ToString`
+ *  @param[out] data  Entry content
+ *  @return kNotFound on cache miss
+ */
+Status DiskCache::Lookup(const std::string& key, std::string* data) {
+  if (fs_ == nullptr) {
+    return Status(Status::Type::kInvalidArgument, "Cache is not opened");
+  }
+  // Entries published by other processes are not indexed yet, always ask
+  // the file system
+  std::unique_ptr<RandomAccessFile> file;
+  size_t size = 0;
+  Status s = fs_->NewRandomAccessFile(this->EntryPath(key), &file);
+  if (s.Good()) {
+    s = file->Size(&size);
+  }
+  if (s.Good()) {
+    data->resize(size);
+    size_t n_read = 0;
+    s = size > 0 ? file->Read(0, size, &(*data)[0], &n_read) : s;
+    if (s.Good() && n_read != size) {
+      s = Status(Status::Type::kInternalError, "Truncated entry: " + key);
+    }
+  }
+  std::lock_guard<std::mutex> lock(lock_);
+  auto it = index_.find(key);
+  if (!s.Good()) {
+    // Evicted by another process
+    if (it != index_.end()) {
+      this->Drop(it->second);
+    }
+    return Status(Status::Type::kNotFound, "Cache miss: " + key);
+  }
+  if (it == index_.end()) {
+    lru_.push_front(Entry{key, size});
+    index_[key] = lru_.begin();
+    size_ += size;
+    this->Evict();
+  } else {
+    lru_.splice(lru_.begin(), lru_, it->second);
+  }
+  return s;
+}
+
+/*
+ *  @name   Insert
+ *  @fn     Status Insert(const std::string& key, const void* data,
+                          const size_t& n)
+ *  @brief  Store an entry, replacing any previous one with the same key,
+ *          then evict entries to stay within the size limit
+ *  @param[in] key  Entry key, see `CacheKey::ToString`
+ *  @param[in] data Entry content
+ *  @param[in] n    Content size in bytes
+ *  @return kInvalidArgument if the entry alone exceeds the limit
+ */
+Status DiskCache::Insert(const std::string& key,
+                         const void* data,
+                         const size_t& n) {
+  if (fs_ == nullptr) {
+    return Status(Status::Type::kInvalidArgument, "Cache is not opened");
+  }
+  if (n > max_size_) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Entry larger than the cache: " + key);
+  }
+  std::string tmp;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    tmp = Path::Join(dir_, key + "." + std::to_string(token_) + "." +
+                     std::to_string(n_tmp_++) + "." + kTmpExt);
+  }
+  // Write aside, then publish atomically
+  std::ofstream stream(tmp.c_str(), std::ios_base::binary);
+  stream.write(reinterpret_cast<const char*>(data), n);
+  stream.close();
+  if (!stream.good()) {
+    fs_->DeleteFile(tmp);
+    return Status(Status::Type::kInternalError,
+                  "Error while writing entry: " + tmp);
+  }
+  Status s = fs_->RenameFile(tmp, this->EntryPath(key));
+  if (!s.Good()) {
+    fs_->DeleteFile(tmp);
+    return s;
+  }
+  std::lock_guard<std::mutex> lock(lock_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    this->Drop(it->second);
+  }
+  lru_.push_front(Entry{key, n});
+  index_[key] = lru_.begin();
+  size_ += n;
+  this->Evict();
+  return s;
+}
+
+/*
+ *  @name   Remove
+ *  @fn     Status Remove(const std::string& key)
+ *  @brief  Delete an entry
+ *  @param[in] key  Entry key
+ *  @return kNotFound if absent
+ */
+Status DiskCache::Remove(const std::string& key) {
+  if (fs_ == nullptr) {
+    return Status(Status::Type::kInvalidArgument, "Cache is not opened");
+  }
+  std::lock_guard<std::mutex> lock(lock_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    this->Drop(it->second);
+  }
+  Status s = fs_->DeleteFile(this->EntryPath(key));
+  if (!s.Good()) {
+    return Status(Status::Type::kNotFound, "No entry: " + key);
+  }
+  return s;
+}
+
+/*
+ *  @name   size
+ *  @fn     size_t size(void) const
+ *  @brief  Total size of the entries in bytes
+ */
+size_t DiskCache::size(void) const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return size_;
+}
+
+/*
+ *  @name   n_entry
+ *  @fn     size_t n_entry(void) const
+ *  @brief  Number of entries
+ */
+size_t DiskCache::n_entry(void) const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return lru_.size();
+}
+
+/*
+ *  @name   EntryPath
+ *  @fn     std::string EntryPath(const std::string& key) const
+ *  @brief  Path of an entry
+ */
+std::string DiskCache::EntryPath(const std::string& key) const {
+  return Path::Join(dir_, key + "." + kEntryExt);
+}
+
+/*
+ *  @name   Drop
+ *  @fn     void Drop(EntryList::iterator it)
+ *  @brief  Remove an entry from the index, lock must be held
+ */
+void DiskCache::Drop(EntryList::iterator it) {
+  size_ -= it->size;
+  index_.erase(it->key);
+  lru_.erase(it);
+}
+
+/*
+ *  @name   Evict
+ *  @fn     void Evict(void)
+ *  @brief  Delete least recently used entries until the total size fits,
+ *          lock must be held
+ */
+void DiskCache::Evict(void) {
+  while (size_ > max_size_ && !lru_.empty()) {
+    auto it = std::prev(lru_.end());
+    // Might already be gone if shared with another process
+    fs_->DeleteFile(this->EntryPath(it->key));
+    this->Drop(it);
+  }
+}
+
+}  // namespace FaceKit
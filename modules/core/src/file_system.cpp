@@ -11,11 +11,15 @@
 
 #include <fstream>
 #include <stack>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
 #include <algorithm>
 
 #include "facekit/core/sys/file_system.hpp"
 #include "facekit/core/sys/file_system_factory.hpp"
 #include "facekit/core/utils/string.hpp"
+#include "facekit/core/thread_pool.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -98,39 +102,194 @@ Status FileSystem::IsDirectory(const std::string& dir) {
  *  @fn     virtual Status ListDirRecursively(const std::string& dir,
  *                                 std::vector<std::string>* files)
  *  @brief  List the content of a given directory `dir` and follow the
- *          arborescence in order to list all files
+ *          arborescence in order to list all files. Sub-directories are
+ *          scanned in parallel (see `WalkDir`), the order is unspecified.
  *  @param[in] dir  Directory to scan
  *  @param[out] files List of files/dirs in `dir`
  *  @return kGood or Error code
  */
 Status FileSystem::ListDirRecursively(const std::string& dir,
                                       std::vector<std::string>* files) {
-  std::stack<std::string> stack;
-  stack.push(NormalizePath(dir));
-  // Loop recursively, using stack to avoid function call overhead.
+  // Callbacks are serialized by the walk, no need for extra locking
+  return this->WalkDir(dir,
+                       WalkOptions(),
+                       [files](const std::string& f) {
+                         files->push_back(f);
+                         return true;
+                       });
+}
+
+/*
+ *  @name   ListDirEntries
+ *  @fn     virtual Status ListDirEntries(const std::string& dir,
+                                          std::vector<DirEntry>* entries)
+ *  @brief  List the content of a given directory `dir` with the type of
+ *          each entry. The default queries `FileProp` for every entry,
+ *          file systems override it with batch listings reporting types
+ *          directly.
+ *  @param[in] dir  Directory to scan
+ *  @param[out] entries List of entries in `dir`
+ *  @return kGood or Error code
+ */
+Status FileSystem::ListDirEntries(const std::string& dir,
+                                  std::vector<DirEntry>* entries) {
+  std::vector<std::string> content;
+  Status s = this->ListDir(dir, &content);
+  entries->clear();
+  if (s.Good()) {
+    entries->resize(content.size());
+    FileProperty prop;
+    for (size_t k = 0; k < content.size(); ++k) {
+      (*entries)[k].is_dir = this->FileProp(content[k], &prop).Good() &&
+                             prop.is_dir;
+      (*entries)[k].path = std::move(content[k]);
+    }
+  }
+  return s;
+}
+
+/**
+ *  @struct WalkState
+ *  @brief  Shared state of a parallel directory walk
+ */
+struct WalkState {
+  /** Directories waiting to be listed */
+  std::deque<std::string> pending;
+  /** Number of directories being listed */
+  size_t in_flight = 0;
+  /** First error encountered */
   Status status;
-  while (!stack.empty()) {
-    auto folder = stack.top();
-    stack.pop();
-    // Scan content
-    std::vector<std::string> content;
-    status = ListDir(folder, &content);
-    if (!status.Good()) {
-      // Somthing went wrong, -> stop recursion
-      break;
+  /** Stop flag, set on error or when the callback asks for it */
+  bool stop = false;
+  /** Protect the fields above */
+  std::mutex mutex;
+  /** Signaled when a listing is done */
+  std::condition_variable cond;
+  /** Serialize user's callback */
+  std::mutex cb_mutex;
+  /** Callback asked to stop, protected by `cb_mutex` */
+  bool cb_stop = false;
+};
+
+/**
+ *  @name   HasExtension
+ *  @brief  Check if a given `file` ends with one of the `extensions`
+ */
+static bool HasExtension(const std::string& file,
+                         const std::vector<std::string>& extensions) {
+  if (extensions.empty()) {
+    return true;
+  }
+  for (const auto& ext : extensions) {
+    if (file.size() >= ext.size() &&
+        file.compare(file.size() - ext.size(), ext.size(), ext) == 0) {
+      return true;
     }
-    // Check files/folders
-    for (const auto& entry : content) {
-      if (IsDirectory(entry).Good()) {
-        // Add it to the stack
-        stack.push(entry);
-      } else {
-        // Add to output
-        files->push_back(entry);
+  }
+  return false;
+}
+
+/**
+ *  @name   MatchPattern
+ *  @brief  Check if the name of a given `file` matches one of the glob
+ *          `patterns`
+ */
+static bool MatchPattern(const std::string& file,
+                         const std::vector<std::string>& patterns) {
+  if (patterns.empty()) {
+    return true;
+  }
+  const StringView name = Path::Basename(StringView(file));
+  for (const auto& pattern : patterns) {
+    if (Path::Match(pattern, name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ *  @name   WalkDir
+ *  @fn     virtual Status WalkDir(const std::string& dir,
+                                   const WalkOptions& options,
+                                   const WalkCallback& callback)
+ *  @brief  Walk the arborescence below `dir`, sub-directories are listed
+ *          concurrently on a `ThreadPool` with `ListDirEntries`. Files
+ *          matching the extensions and patterns are streamed to `callback` as soon as they are found, in no
+ *          particular order. Returns once the whole tree has been visited.
+ *  @param[in] dir      Directory to scan
+ *  @param[in] options  Walk configuration
+ *  @param[in] callback Function called for every matching file
+ *  @return kGood or the first error encountered
+ */
+Status FileSystem::WalkDir(const std::string& dir,
+                           const WalkOptions& options,
+                           const WalkCallback& callback) {
+  using TaskPriority = ThreadPool::TaskPriority;
+  ThreadPool& pool = options.pool ? *options.pool : ThreadPool::Get();
+  const size_t limit = options.max_concurrency ?
+                       options.max_concurrency :
+                       std::max(pool.size(), size_t(1));
+  WalkState state;
+  state.pending.push_back(NormalizePath(dir));
+  // List one directory, sub-directories are queued, files are reported
+  auto list = [this, &state, &options, &callback](const std::string& folder) {
+    std::vector<DirEntry> content;
+    std::vector<std::string> sub_dirs;
+    Status s = this->ListDirEntries(folder, &content);
+    bool stop = false;
+    if (s.Good()) {
+      for (auto& entry : content) {
+        if (entry.is_dir) {
+          sub_dirs.push_back(std::move(entry.path));
+        } else if (HasExtension(entry.path, options.extensions) &&
+                   MatchPattern(entry.path, options.patterns)) {
+          std::lock_guard<std::mutex> lock(state.cb_mutex);
+          if (state.cb_stop || !callback(entry.path)) {
+            state.cb_stop = true;
+            stop = true;
+            break;
+          }
+        }
       }
     }
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!s.Good() && state.status.Good()) {
+      state.status = s;
+    }
+    state.stop |= stop || !s.Good();
+    state.pending.insert(state.pending.end(),
+                         sub_dirs.begin(),
+                         sub_dirs.end());
+    state.in_flight -= 1;
+    state.cond.notify_all();
+  };
+  // Dispatch listings, at most `limit` at once. The calling thread helps the
+  // pool while waiting so the walk can run from within a worker
+  std::unique_lock<std::mutex> lock(state.mutex);
+  while (true) {
+    while (!state.stop && !state.pending.empty() && state.in_flight < limit) {
+      std::string folder = std::move(state.pending.front());
+      state.pending.pop_front();
+      state.in_flight += 1;
+      pool.Submit(TaskPriority::kNormal, list, std::move(folder));
+    }
+    if (state.in_flight == 0 && (state.stop || state.pending.empty())) {
+      break;
+    }
+    lock.unlock();
+    const bool helped = pool.RunPendingTask();
+    lock.lock();
+    if (!helped) {
+      state.cond.wait(lock, [&state, limit]() {
+        return state.in_flight == 0 ||
+               (!state.stop &&
+                !state.pending.empty() &&
+                state.in_flight < limit);
+      });
+    }
   }
-  return status;
+  return state.status;
 }
   
 /*
@@ -256,6 +415,55 @@ Status FileSystem::CopyFile(const std::string& src, const std::string& dst) {
   return status;
 }
   
+/*
+ *  @name   NewRandomAccessFile
+ *  @fn     virtual Status NewRandomAccessFile(const std::string& filename,
+                            std::unique_ptr<RandomAccessFile>* file)
+ *  @brief  Open a file for positional reads
+ *  @param[in] filename File to open
+ *  @param[out] file    Opened file
+ *  @return Status of the operation, kUnimplemented if not supported
+ */
+Status FileSystem::NewRandomAccessFile(const std::string& filename,
+                                      std::unique_ptr<RandomAccessFile>* file) {
+  return Status(Status::Type::kUnimplemented, "Not supported");
+}
+
+/*
+ *  @name   NewReadOnlyMemoryRegion
+ *  @fn     virtual Status NewReadOnlyMemoryRegion(const std::string& filename,
+                            std::unique_ptr<ReadOnlyMemoryRegion>* region)
+ *  @brief  Map the whole content of a file in memory, read-only
+ *  @param[in] filename File to map
+ *  @param[out] region  Mapped region
+ *  @return Status of the operation, kUnimplemented if not supported
+ */
+Status FileSystem::NewReadOnlyMemoryRegion(const std::string& filename,
+                                 std::unique_ptr<ReadOnlyMemoryRegion>* region) {
+  return Status(Status::Type::kUnimplemented, "Not supported");
+}
+
+#pragma mark -
+#pragma mark RandomAccessFile
+
+/*
+ *  @name   ReadV
+ *  @fn     virtual Status ReadV(std::vector<ReadRequest>* requests) const
+ *  @brief  Serve a list of reads at arbitrary offsets in one call
+ *  @param[in,out] requests List of reads, `n_read` is filled for each
+ *  @return kGood or the first error encountered
+ */
+Status RandomAccessFile::ReadV(std::vector<ReadRequest>* requests) const {
+  Status status;
+  for (auto& r : *requests) {
+    status = this->Read(r.offset, r.size, r.buffer, &r.n_read);
+    if (!status.Good()) {
+      break;
+    }
+  }
+  return status;
+}
+
 #pragma mark -
 #pragma mark Proxy
   
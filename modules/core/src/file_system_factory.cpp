@@ -8,7 +8,12 @@
  *  Copyright © 2018 Christophe Ecabert. All rights reserved.
  */
 
+#if defined(__APPLE__) || defined(__linux__)
+#define IS_POSIX
+#endif
+
 #include "facekit/core/sys/file_system_factory.hpp"
+#include "facekit/core/utils/string.hpp"
 #include "facekit/core/logger.hpp"
 
 /**
@@ -74,6 +79,28 @@ FileSystem* FileSystemFactory::Retrieve(const std::string& name) const {
   }
   return fs;
 }
+
+/*
+ *  @name   RetrieveForPath
+ *  @fn     FileSystem* RetrieveForPath(const std::string& path) const
+ *  @brief  Retrieve the file system handling `path` based on its scheme
+ *          (i.e. `s3://bucket/key`, `https://host/file`). Paths without
+ *          scheme go to the local file system.
+ *  @param[in] path Path or URI to access
+ *  @return File system instance or nullptr if the scheme is not registered
+ */
+FileSystem* FileSystemFactory::RetrieveForPath(const std::string& path) const {
+  std::string scheme;
+  Path::ParseURI(path, &scheme, nullptr, nullptr);
+  if (scheme.empty() || scheme == "file") {
+#ifdef IS_POSIX
+    return this->Retrieve("Posix");
+#else
+    return this->Retrieve("Windows");
+#endif
+  }
+  return this->Retrieve(scheme);
+}
   
 }  // namespace FaceKit
 
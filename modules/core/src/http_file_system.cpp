@@ -0,0 +1,1146 @@
+/**
+ *  @file   http_file_system.cpp
+ *  @brief Read-only access to remote files over HTTP(S) and S3 compatible
+ *         object storage. Reads are served from a block cache fed by ranged
+ *         GETs with read-ahead, whole files are downloaded in parallel parts.
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   13.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <curl/curl.h>
+#ifdef FACEKIT_HAS_OPENSSL
+#include <openssl/hmac.h>
+#include <openssl/sha.h>
+#endif
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "facekit/core/sys/http_file_system.hpp"
+#include "facekit/core/sys/file_system_factory.hpp"
+#include "facekit/core/utils/string.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/logger.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#pragma mark -
+#pragma mark Utility
+
+/**
+ *  @struct Sink
+ *  @brief  Destination of a response body
+ */
+struct Sink {
+  /** Handle, used to query the status code */
+  CURL* handle;
+  /** Growing destination */
+  std::string* body;
+  /** Fixed destination */
+  char* buffer;
+  /** Fixed destination capacity */
+  size_t capacity;
+  /** Bytes to drop when the server ignores the range */
+  size_t skip;
+  /** Received bytes */
+  size_t n;
+  /** Body start has been checked */
+  bool started;
+};
+
+/**
+ *  @name   WriteCallback
+ *  @brief  curl body callback
+ */
+static size_t WriteCallback(char* ptr, size_t size, size_t nmemb, void* user) {
+  Sink* sink = reinterpret_cast<Sink*>(user);
+  size_t length = size * nmemb;
+  const size_t total = length;
+  if (!sink->started) {
+    // Full content (200) returned for a ranged request, skip leading part
+    long code = 0;
+    curl_easy_getinfo(sink->handle, CURLINFO_RESPONSE_CODE, &code);
+    if (code != 200) {
+      sink->skip = 0;
+    }
+    sink->started = true;
+  }
+  if (sink->skip > 0) {
+    const size_t s = std::min(sink->skip, length);
+    sink->skip -= s;
+    ptr += s;
+    length -= s;
+  }
+  if (sink->body != nullptr) {
+    sink->body->append(ptr, length);
+    sink->n += length;
+  } else if (sink->buffer != nullptr) {
+    const size_t n = std::min(length, sink->capacity - sink->n);
+    std::memcpy(sink->buffer + sink->n, ptr, n);
+    sink->n += n;
+  }
+  return total;
+}
+
+/**
+ *  @name   UriEncode
+ *  @brief  Percent-encode `str`, '/' is kept when `keep_slash` is set
+ */
+static std::string UriEncode(const std::string& str, const bool& keep_slash) {
+  static const char* kHex = "0123456789ABCDEF";
+  std::string out;
+  for (const char c : str) {
+    if (std::isalnum(static_cast<unsigned char>(c)) ||
+        c == '-' || c == '_' || c == '.' || c == '~' ||
+        (keep_slash && c == '/')) {
+      out += c;
+    } else {
+      const unsigned char u = static_cast<unsigned char>(c);
+      out += '%';
+      out += kHex[u >> 4];
+      out += kHex[u & 0x0F];
+    }
+  }
+  return out;
+}
+
+/**
+ *  @name   XmlValues
+ *  @brief  Content of every `<tag>...</tag>` element in `xml`, entities are
+ *          decoded
+ */
+static std::vector<std::string> XmlValues(const std::string& xml,
+                                          const std::string& tag) {
+  std::vector<std::string> values;
+  const std::string open = "<" + tag + ">";
+  const std::string close = "</" + tag + ">";
+  size_t pos = xml.find(open);
+  while (pos != std::string::npos) {
+    const size_t start = pos + open.size();
+    const size_t end = xml.find(close, start);
+    if (end == std::string::npos) {
+      break;
+    }
+    std::string v = xml.substr(start, end - start);
+    static const char* kEntities[][2] = {{"&lt;", "<"}, {"&gt;", ">"},
+                                          {"&quot;", "\""}, {"&apos;", "'"},
+                                          {"&amp;", "&"}};
+    for (const auto& e : kEntities) {
+      size_t p = 0;
+      while ((p = v.find(e[0], p)) != std::string::npos) {
+        v.replace(p, std::strlen(e[0]), e[1]);
+        p += 1;
+      }
+    }
+    values.push_back(v);
+    pos = xml.find(open, end + close.size());
+  }
+  return values;
+}
+
+/**
+ *  @name   GetEnv
+ *  @brief  Environment variable or `value` if not defined
+ */
+static std::string GetEnv(const char* name, const std::string& value) {
+  const char* v = std::getenv(name);
+  return (v != nullptr && v[0] != '\0') ? std::string(v) : value;
+}
+
+#pragma mark -
+#pragma mark Block cache
+
+/**
+ *  @class  BlockCache
+ *  @brief  LRU cache of fixed size blocks shared by every file opened on a
+ *          file system. Concurrent requests for the same block are merged.
+ */
+class HttpFileSystem::BlockCache {
+ public:
+  /** Cached block */
+  using Block = std::shared_ptr<const std::string>;
+  /** Block loader */
+  using Fetch = std::function<Status(std::string*)>;
+
+  /**
+   *  @name   BlockCache
+   *  @brief  Constructor
+   *  @param[in] capacity Maximum number of bytes kept
+   */
+  explicit BlockCache(const size_t& capacity) : capacity_(capacity),
+                                                size_(0),
+                                                pending_(0) {}
+
+  /**
+   *  @name   Get
+   *  @brief  Get block `key`, call `fetch` on miss
+   */
+  Status Get(const std::string& key, const Fetch& fetch, Block* block) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      auto it = entries_.find(key);
+      if (it != entries_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        *block = it->second.block;
+        return Status();
+      }
+      if (in_flight_.count(key) == 0) {
+        break;
+      }
+      cond_.wait(lock);
+    }
+    // Miss, load it outside the lock
+    in_flight_.insert(key);
+    lock.unlock();
+    std::shared_ptr<std::string> data = std::make_shared<std::string>();
+    Status s = fetch(data.get());
+    lock.lock();
+    in_flight_.erase(key);
+    if (s.Good()) {
+      lru_.push_front(key);
+      entries_[key] = Entry{data, lru_.begin()};
+      size_ += data->size();
+      // Evict least recently used, always keep the latest block
+      while (size_ > capacity_ && lru_.size() > 1) {
+        auto last = entries_.find(lru_.back());
+        size_ -= last->second.block->size();
+        entries_.erase(last);
+        lru_.pop_back();
+      }
+      *block = data;
+    }
+    cond_.notify_all();
+    return s;
+  }
+
+  /**
+   *  @name   Prefetch
+   *  @brief  Load block `key` in the background if not already there
+   */
+  void Prefetch(const std::string& key, const Fetch& fetch) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (entries_.count(key) || in_flight_.count(key)) {
+        return;
+      }
+      pending_ += 1;
+    }
+    ThreadPool::Get().Submit(ThreadPool::TaskPriority::kLow,
+                             [this, key, fetch]() {
+      Block block;
+      this->Get(key, fetch, &block);
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_ -= 1;
+      cond_.notify_all();
+    });
+  }
+
+  /**
+   *  @name   Wait
+   *  @brief  Wait for background loads to complete
+   */
+  void Wait(void) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this]() { return pending_ == 0; });
+  }
+
+ private:
+  /**
+   *  @struct Entry
+   *  @brief  Cached block + position in the LRU list
+   */
+  struct Entry {
+    /** Data */
+    Block block;
+    /** LRU position */
+    std::list<std::string>::iterator lru;
+  };
+
+  /** Lock */
+  std::mutex mutex_;
+  /** Signal load completion */
+  std::condition_variable cond_;
+  /** Cached blocks */
+  std::unordered_map<std::string, Entry> entries_;
+  /** Blocks being loaded */
+  std::unordered_set<std::string> in_flight_;
+  /** Usage order, most recent first */
+  std::list<std::string> lru_;
+  /** Maximum size */
+  size_t capacity_;
+  /** Current size */
+  size_t size_;
+  /** Background loads */
+  size_t pending_;
+};
+
+#pragma mark -
+#pragma mark Files
+
+/**
+ *  @class  HttpRandomAccessFile
+ *  @brief  Remote file read through the block cache
+ */
+class HttpFileSystem::HttpRandomAccessFile : public RandomAccessFile {
+ public:
+  /**
+   *  @name   HttpRandomAccessFile
+   *  @brief  Constructor
+   */
+  HttpRandomAccessFile(HttpFileSystem* fs,
+                       const std::string& uri,
+                       const size_t& size) :
+          fs_(fs),
+          uri_(uri),
+          size_(size),
+          next_offset_(0) {}
+
+  /**
+   *  @name   Read
+   *  @brief  Read up to `n` bytes starting at `offset` into `buffer`
+   */
+  Status Read(const size_t& offset,
+              const size_t& n,
+              char* buffer,
+              size_t* n_read) const override {
+    *n_read = 0;
+    const size_t bsize = fs_->options_.block_size;
+    const size_t end = std::min(offset + n, size_);
+    size_t last = offset / bsize;
+    for (size_t pos = offset; pos < end;) {
+      const size_t b = pos / bsize;
+      BlockCache::Block block;
+      Status s = fs_->cache_->Get(this->Key(b), this->Fetcher(b), &block);
+      if (!s.Good()) {
+        return s;
+      }
+      const size_t start = pos - b * bsize;
+      const size_t len = std::min(end - pos, block->size() - start);
+      std::memcpy(buffer + (pos - offset), block->data() + start, len);
+      pos += len;
+      *n_read += len;
+      last = b;
+    }
+    // Sequential access, load the following blocks in the background
+    const size_t prev = next_offset_.exchange(offset + *n_read);
+    if (prev == offset) {
+      for (size_t k = 1; k <= fs_->options_.read_ahead; ++k) {
+        if ((last + k) * bsize < size_) {
+          fs_->cache_->Prefetch(this->Key(last + k), this->Fetcher(last + k));
+        }
+      }
+    }
+    if (*n_read < n) {
+      return Status(Status::Type::kOutOfRange,
+                    "Read less bytes than requested in: " + uri_);
+    }
+    return Status();
+  }
+
+  /**
+   *  @name   Size
+   *  @brief  Query the file size in bytes
+   */
+  Status Size(size_t* size) const override {
+    *size = size_;
+    return Status();
+  }
+
+ private:
+  /**
+   *  @name   Key
+   *  @brief  Cache key of block `b`
+   */
+  std::string Key(const size_t& b) const {
+    return uri_ + "#" + std::to_string(b);
+  }
+
+  /**
+   *  @name   Fetcher
+   *  @brief  Loader for block `b`, does not depend on `this` since it can
+   *          outlive the file when used for read-ahead
+   */
+  BlockCache::Fetch Fetcher(const size_t& b) const {
+    HttpFileSystem* fs = fs_;
+    const std::string uri = uri_;
+    const size_t start = b * fs_->options_.block_size;
+    const size_t len = std::min(fs_->options_.block_size, size_ - start);
+    return [fs, uri, start, len](std::string* data) {
+      data->resize(len);
+      size_t n_read = 0;
+      Status s = fs->ReadRange(uri, start, len, &(*data)[0], &n_read);
+      data->resize(n_read);
+      if (s.Good() && n_read < len) {
+        return Status(Status::Type::kOutOfRange,
+                      "Read less bytes than requested in: " + uri);
+      }
+      return s;
+    };
+  }
+
+  /** File system */
+  HttpFileSystem* fs_;
+  /** Remote file */
+  std::string uri_;
+  /** Remote size */
+  size_t size_;
+  /** End of the previous read, detect sequential access */
+  mutable std::atomic<size_t> next_offset_;
+};
+
+/**
+ *  @class  HeapMemoryRegion
+ *  @brief  Downloaded file content
+ */
+class HeapMemoryRegion : public ReadOnlyMemoryRegion {
+ public:
+  /**
+   *  @name   HeapMemoryRegion
+   *  @brief  Constructor, take ownership of `data`
+   */
+  HeapMemoryRegion(char* data, const size_t& length) : data_(data),
+                                                        length_(length) {}
+
+  /**
+   *  @name   data
+   *  @brief  Start of the region
+   */
+  const void* data(void) const override {
+    return data_.get();
+  }
+
+  /**
+   *  @name   length
+   *  @brief  Size of the region in bytes
+   */
+  size_t length(void) const override {
+    return length_;
+  }
+
+ private:
+  /** Content */
+  std::unique_ptr<char[]> data_;
+  /** Size */
+  size_t length_;
+};
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   HttpFileSystem
+ *  @fn     HttpFileSystem(void)
+ *  @brief  Constructor with default options
+ */
+HttpFileSystem::HttpFileSystem(void) : HttpFileSystem(Options()) {}
+
+/*
+ *  @name   HttpFileSystem
+ *  @fn     explicit HttpFileSystem(const Options& options)
+ *  @brief  Constructor
+ *  @param[in] options  Transfer / cache configuration
+ */
+HttpFileSystem::HttpFileSystem(const Options& options) :
+        options_(options),
+        cache_(new BlockCache(options.cache_size)) {
+  options_.block_size = std::max(options_.block_size, size_t(1));
+  options_.part_size = std::max(options_.part_size, size_t(1));
+  static std::once_flag init;
+  std::call_once(init, []() { curl_global_init(CURL_GLOBAL_DEFAULT); });
+}
+
+/*
+ *  @name   ~HttpFileSystem
+ *  @fn     ~HttpFileSystem(void) override
+ *  @brief  Destructor, wait for pending read-ahead
+ */
+HttpFileSystem::~HttpFileSystem(void) {
+  cache_->Wait();
+  delete cache_;
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   NormalizePath
+ *  @fn     std::string NormalizePath(const std::string& path) override
+ *  @brief  URIs are used as is
+ *  @param[in] path URI to normalize
+ *  @return Normalized URI
+ */
+std::string HttpFileSystem::NormalizePath(const std::string& path) {
+  return path;
+}
+
+/*
+ *  @name   FileExist
+ *  @fn     Status FileExist(const std::string& filename) override
+ *  @brief  Check if a given URI exists
+ *  @param[in] filename URI to check existence
+ *  @return kGood of kNotFound
+ */
+Status HttpFileSystem::FileExist(const std::string& filename) {
+  size_t size = 0;
+  return this->Head(filename, &size);
+}
+
+/*
+ *  @name   ListDir
+ *  @fn     Status ListDir(const std::string& dir,
+ *                                 std::vector<std::string>* files) override
+ *  @brief  HTTP does not support listing
+ *  @return kUnimplemented
+ */
+Status HttpFileSystem::ListDir(const std::string& dir,
+                               std::vector<std::string>* files) {
+  return Status(Status::Type::kUnimplemented, "Not supported");
+}
+
+/*
+ *  @name   FileProp
+ *  @fn     Status FileProp(const std::string& filename,
+ *                                  FileProperty* prop) override
+ *  @brief  Gather file properties for a given URI
+ *  @param[in] filename URI to the file
+ *  @param[out] prop    File's properties
+ *  @return kGood, kNotFound or error code.
+ */
+Status HttpFileSystem::FileProp(const std::string& filename,
+                                FileProperty* prop) {
+  size_t size = 0;
+  Status s = this->Head(filename, &size);
+  if (s.Good()) {
+    prop->size = size;
+    prop->is_dir = false;
+  }
+  return s;
+}
+
+/*
+ *  @name   DeleteFile
+ *  @fn     Status DeleteFile(const std::string& filename) override
+ *  @brief  Read-only file system
+ *  @return kUnimplemented
+ */
+Status HttpFileSystem::DeleteFile(const std::string& filename) {
+  return Status(Status::Type::kUnimplemented, "Read-only file system");
+}
+
+/*
+ *  @name   CreateDir
+ *  @fn     Status CreateDir(const std::string& dir) override
+ *  @brief  Read-only file system
+ *  @return kUnimplemented
+ */
+Status HttpFileSystem::CreateDir(const std::string& dir) {
+  return Status(Status::Type::kUnimplemented, "Read-only file system");
+}
+
+/*
+ *  @name   DeleteDir
+ *  @fn     Status DeleteDir(const std::string& dir) override
+ *  @brief  Read-only file system
+ *  @return kUnimplemented
+ */
+Status HttpFileSystem::DeleteDir(const std::string& dir) {
+  return Status(Status::Type::kUnimplemented, "Read-only file system");
+}
+
+/*
+ *  @name   RenameFile
+ *  @fn     Status RenameFile(const std::string& src,
+ *                                    const std::string& dst) override
+ *  @brief  Read-only file system
+ *  @return kUnimplemented
+ */
+Status HttpFileSystem::RenameFile(const std::string& src,
+                                  const std::string& dst) {
+  return Status(Status::Type::kUnimplemented, "Read-only file system");
+}
+
+/*
+ *  @name   QueryFileSize
+ *  @fn     Status QueryFileSize(const std::string& filename, size_t* size) override
+ *  @brief  Gather file size in bytes (`HEAD` request)
+ *  @param[in] filename URI to query size
+ *  @param[out] size    File's size
+ *  @return Status of the operation
+ */
+Status HttpFileSystem::QueryFileSize(const std::string& filename,
+                                     size_t* size) {
+  return this->Head(filename, size);
+}
+
+/*
+ *  @name   CopyFile
+ *  @fn     Status CopyFile(const std::string& src, const std::string& dst) override
+ *  @brief  Download remote `src` into local file `dst`
+ *  @param[in] src  URI to download
+ *  @param[in] dst  Local destination
+ *  @return Status of the operation
+ */
+Status HttpFileSystem::CopyFile(const std::string& src,
+                                const std::string& dst) {
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  Status s = this->NewReadOnlyMemoryRegion(src, &region);
+  if (!s.Good()) {
+    return s;
+  }
+  std::ofstream out(dst.c_str(), std::ios_base::out | std::ios_base::binary);
+  out.write(reinterpret_cast<const char*>(region->data()), region->length());
+  if (!out.good()) {
+    return Status(Status::Type::kInternalError,
+                  "Error while copy data to: " + dst);
+  }
+  return Status();
+}
+
+/*
+ *  @name   NewRandomAccessFile
+ *  @fn     Status NewRandomAccessFile(const std::string& filename,
+                    std::unique_ptr<RandomAccessFile>* file) override
+ *  @brief  Open a remote file, reads are served from the block cache with
+ *          read-ahead on sequential access
+ *  @param[in] filename URI to open
+ *  @param[out] file    Opened file
+ *  @return Status of the operation
+ */
+Status HttpFileSystem::NewRandomAccessFile(const std::string& filename,
+                                      std::unique_ptr<RandomAccessFile>* file) {
+  size_t size = 0;
+  Status s = this->Head(filename, &size);
+  if (s.Good()) {
+    file->reset(new HttpRandomAccessFile(this, filename, size));
+  }
+  return s;
+}
+
+/*
+ *  @name   NewReadOnlyMemoryRegion
+ *  @fn     Status NewReadOnlyMemoryRegion(const std::string& filename,
+                    std::unique_ptr<ReadOnlyMemoryRegion>* region) override
+ *  @brief  Download the whole file in memory, parts are fetched in parallel
+ *  @param[in] filename URI to download
+ *  @param[out] region  Downloaded content
+ *  @return Status of the operation
+ */
+Status HttpFileSystem::NewReadOnlyMemoryRegion(const std::string& filename,
+                                 std::unique_ptr<ReadOnlyMemoryRegion>* region) {
+  size_t size = 0;
+  Status status = this->Head(filename, &size);
+  if (!status.Good()) {
+    return status;
+  }
+  std::unique_ptr<char[]> data(new char[std::max(size, size_t(1))]);
+  const size_t psize = options_.part_size;
+  const size_t n_part = (size + psize - 1) / psize;
+  std::mutex mutex;
+  char* ptr = data.get();
+  ThreadPool::Get().ParallelFor(0, n_part, 1, [&](const size_t& first,
+                                                  const size_t& last) {
+    for (size_t p = first; p < last; ++p) {
+      const size_t start = p * psize;
+      const size_t len = std::min(psize, size - start);
+      size_t n_read = 0;
+      Status s = this->ReadRange(filename, start, len, ptr + start, &n_read);
+      if (s.Good() && n_read < len) {
+        s = Status(Status::Type::kOutOfRange,
+                   "Read less bytes than requested in: " + filename);
+      }
+      if (!s.Good()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        status = s;
+      }
+    }
+  });
+  if (status.Good()) {
+    region->reset(new HeapMemoryRegion(data.release(), size));
+  }
+  return status;
+}
+
+/*
+ *  @name   ReadRange
+ *  @fn     Status ReadRange(const std::string& uri, const size_t& offset,
+                             const size_t& n, char* buffer, size_t* n_read)
+ *  @brief  Ranged GET, bypass the cache
+ *  @param[in] uri      Remote file
+ *  @param[in] offset   First byte
+ *  @param[in] n        Number of bytes
+ *  @param[out] buffer  Destination, at least `n` bytes
+ *  @param[out] n_read  Number of bytes received
+ *  @return Status of the operation
+ */
+Status HttpFileSystem::ReadRange(const std::string& uri,
+                                 const size_t& offset,
+                                 const size_t& n,
+                                 char* buffer,
+                                 size_t* n_read) {
+  *n_read = 0;
+  if (n == 0) {
+    return Status();
+  }
+  Request req;
+  req.method = "GET";
+  Status s = this->PrepareRequest(uri, "", &req);
+  if (!s.Good()) {
+    return s;
+  }
+  req.headers.push_back("Range: bytes=" + std::to_string(offset) + "-" +
+                        std::to_string(offset + n - 1));
+  // Drop the leading part if the server answers with the full content
+  long code = 0;
+  return this->Perform(req, nullptr, buffer, n, offset, n_read, &code);
+}
+
+#pragma mark -
+#pragma mark Protected
+
+/*
+ *  @name   PrepareRequest
+ *  @fn     virtual Status PrepareRequest(const std::string& uri,
+                                          const std::string& query,
+                                          Request* request)
+ *  @brief  Convert `uri` into an URL and add the headers needed to access
+ *          it (i.e. authentication). `request->method` is already set.
+ *  @param[in] uri      Resource
+ *  @param[in] query    Canonical query string, can be empty
+ *  @param[in,out] request  Request to complete
+ *  @return Status of the operation
+ */
+Status HttpFileSystem::PrepareRequest(const std::string& uri,
+                                      const std::string& query,
+                                      Request* request) {
+  request->url = query.empty() ? uri : uri + "?" + query;
+  return Status();
+}
+
+/*
+ *  @name   Perform
+ *  @fn     Status Perform(const Request& request, std::string* body,
+                           char* buffer, const size_t& capacity,
+                           const size_t& skip, size_t* n_body, long* code)
+ *  @brief  Run a request with retries. The body goes into `buffer` when
+ *          provided (at most `capacity` bytes), `body` otherwise.
+ *  @param[in] request  Request to run
+ *  @param[out] body    Response body, can be nullptr
+ *  @param[out] buffer  Fixed size destination, can be nullptr
+ *  @param[in] capacity Size of `buffer`
+ *  @param[in] skip     Leading bytes to drop if the server answers a ranged
+ *                      request with the full content (200)
+ *  @param[out] n_body  Number of bytes received
+ *  @param[out] code    HTTP status code
+ *  @return kGood, kNotFound (404) or error code
+ */
+Status HttpFileSystem::Perform(const Request& request,
+                               std::string* body,
+                               char* buffer,
+                               const size_t& capacity,
+                               const size_t& skip,
+                               size_t* n_body,
+                               long* code) {
+  CURL* handle = curl_easy_init();
+  if (handle == nullptr) {
+    return Status(Status::Type::kInternalError, "Can not create curl handle");
+  }
+  curl_slist* headers = nullptr;
+  for (const auto& h : request.headers) {
+    headers = curl_slist_append(headers, h.c_str());
+  }
+  CURLcode res = CURLE_OK;
+  for (size_t attempt = 0; attempt <= options_.max_retries; ++attempt) {
+    if (attempt > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100 << attempt));
+    }
+    Sink sink{handle, body, buffer, capacity, skip, 0, false};
+    if (body != nullptr) {
+      body->clear();
+    }
+    curl_easy_reset(handle);
+    curl_easy_setopt(handle, CURLOPT_URL, request.url.c_str());
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &sink);
+    if (request.method == "HEAD") {
+      curl_easy_setopt(handle, CURLOPT_NOBODY, 1L);
+    } else if (request.method != "GET") {
+      curl_easy_setopt(handle, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+    }
+    res = curl_easy_perform(handle);
+    *code = 0;
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, code);
+    *n_body = sink.n;
+    // Retry on transport error or server side error
+    if (res == CURLE_OK && *code < 500) {
+      break;
+    }
+  }
+  curl_slist_free_all(headers);
+  curl_easy_cleanup(handle);
+  if (res != CURLE_OK) {
+    return Status(Status::Type::kInternalError,
+                  std::string(curl_easy_strerror(res)) + ": " + request.url);
+  }
+  if (*code == 404) {
+    return Status(Status::Type::kNotFound, "Not found: " + request.url);
+  }
+  if (*code == 416) {
+    return Status(Status::Type::kOutOfRange, "Invalid range: " + request.url);
+  }
+  if (*code < 200 || *code >= 300) {
+    return Status(Status::Type::kInternalError,
+                  "HTTP " + std::to_string(*code) + ": " + request.url);
+  }
+  return Status();
+}
+
+/*
+ *  @name   Head
+ *  @fn     Status Head(const std::string& uri, size_t* size)
+ *  @brief  `HEAD` request, provide resource's size
+ *  @param[in] uri    Resource
+ *  @param[out] size  Content length
+ *  @return kGood, kNotFound or error code
+ */
+Status HttpFileSystem::Head(const std::string& uri, size_t* size) {
+  Request req;
+  req.method = "HEAD";
+  Status s = this->PrepareRequest(uri, "", &req);
+  if (!s.Good()) {
+    return s;
+  }
+  CURL* handle = curl_easy_init();
+  if (handle == nullptr) {
+    return Status(Status::Type::kInternalError, "Can not create curl handle");
+  }
+  curl_slist* headers = nullptr;
+  for (const auto& h : req.headers) {
+    headers = curl_slist_append(headers, h.c_str());
+  }
+  CURLcode res = CURLE_OK;
+  long code = 0;
+  curl_off_t length = -1;
+  for (size_t attempt = 0; attempt <= options_.max_retries; ++attempt) {
+    if (attempt > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100 << attempt));
+    }
+    curl_easy_reset(handle);
+    curl_easy_setopt(handle, CURLOPT_URL, req.url.c_str());
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_NOBODY, 1L);
+    res = curl_easy_perform(handle);
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &code);
+    curl_easy_getinfo(handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+    if (res == CURLE_OK && code < 500) {
+      break;
+    }
+  }
+  curl_slist_free_all(headers);
+  curl_easy_cleanup(handle);
+  if (res != CURLE_OK) {
+    return Status(Status::Type::kInternalError,
+                  std::string(curl_easy_strerror(res)) + ": " + req.url);
+  }
+  if (code == 404) {
+    return Status(Status::Type::kNotFound, "Not found: " + uri);
+  }
+  if (code < 200 || code >= 300 || length < 0) {
+    return Status(Status::Type::kInternalError,
+                  "HTTP " + std::to_string(code) + ": " + req.url);
+  }
+  *size = static_cast<size_t>(length);
+  return Status();
+}
+
+#pragma mark -
+#pragma mark S3
+
+/*
+ *  @name   S3FileSystem
+ *  @fn     S3FileSystem(void)
+ *  @brief  Constructor with default options
+ */
+S3FileSystem::S3FileSystem(void) : HttpFileSystem() {}
+
+/*
+ *  @name   S3FileSystem
+ *  @fn     explicit S3FileSystem(const Options& options)
+ *  @brief  Constructor
+ *  @param[in] options  Transfer / cache configuration
+ */
+S3FileSystem::S3FileSystem(const Options& options) : HttpFileSystem(options) {}
+
+/*
+ *  @name   ListDir
+ *  @fn     Status ListDir(const std::string& dir,
+ *                                 std::vector<std::string>* files) override
+ *  @brief  List objects and common prefixes directly under `dir`
+ *  @param[in] dir  Prefix to scan (`s3://bucket/prefix`)
+ *  @param[out] files List of objects/prefixes in `dir`
+ *  @return kGood or Error code
+ */
+Status S3FileSystem::ListDir(const std::string& dir,
+                             std::vector<std::string>* files) {
+  return this->ListObjects(dir, 0, files);
+}
+
+/*
+ *  @name   FileProp
+ *  @fn     Status FileProp(const std::string& filename,
+ *                                  FileProperty* prop) override
+ *  @brief  Gather object properties, a non-empty prefix is a directory
+ *  @param[in] filename Object URI
+ *  @param[out] prop    Object's properties
+ *  @return kGood, kNotFound or error code.
+ */
+Status S3FileSystem::FileProp(const std::string& filename,
+                              FileProperty* prop) {
+  size_t size = 0;
+  Status s = this->Head(filename, &size);
+  if (s.Good()) {
+    prop->size = size;
+    prop->is_dir = false;
+    return s;
+  }
+  if (s.Code() != Status::Type::kNotFound) {
+    return s;
+  }
+  // No object, may be a prefix
+  std::vector<std::string> content;
+  Status ls = this->ListObjects(filename, 1, &content);
+  if (ls.Good() && !content.empty()) {
+    prop->size = 0;
+    prop->is_dir = true;
+    return ls;
+  }
+  return s;
+}
+
+/*
+ *  @name   SignRequest
+ *  @fn     static std::string SignRequest(const std::string& method,
+                    const std::string& host, const std::string& path,
+                    const std::string& query, const std::string& amz_date,
+                    const std::string& region, const std::string& key_id,
+                    const std::string& secret, const std::string& token)
+ *  @brief  Compute the SigV4 `Authorization` header value for a request
+ *          with an unsigned payload
+ *  @return Authorization header value, empty if signing is not supported
+ */
+std::string S3FileSystem::SignRequest(const std::string& method,
+                                      const std::string& host,
+                                      const std::string& path,
+                                      const std::string& query,
+                                      const std::string& amz_date,
+                                      const std::string& region,
+                                      const std::string& key_id,
+                                      const std::string& secret,
+                                      const std::string& token) {
+#ifdef FACEKIT_HAS_OPENSSL
+  auto hex = [](const unsigned char* data, const size_t& n) {
+    static const char* kHex = "0123456789abcdef";
+    std::string out;
+    for (size_t k = 0; k < n; ++k) {
+      out += kHex[data[k] >> 4];
+      out += kHex[data[k] & 0x0F];
+    }
+    return out;
+  };
+  auto hmac = [](const std::string& key, const std::string& msg) {
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+         reinterpret_cast<const unsigned char*>(msg.data()), msg.size(),
+         md, &len);
+    return std::string(reinterpret_cast<char*>(md), len);
+  };
+  const std::string date = amz_date.substr(0, 8);
+  const std::string scope = date + "/" + region + "/s3/aws4_request";
+  std::string headers = "host:" + host + "\n" +
+                        "x-amz-content-sha256:UNSIGNED-PAYLOAD\n" +
+                        "x-amz-date:" + amz_date + "\n";
+  std::string signed_headers = "host;x-amz-content-sha256;x-amz-date";
+  if (!token.empty()) {
+    headers += "x-amz-security-token:" + token + "\n";
+    signed_headers += ";x-amz-security-token";
+  }
+  const std::string canonical = method + "\n" + path + "\n" + query + "\n" +
+                                headers + "\n" + signed_headers + "\n" +
+                                "UNSIGNED-PAYLOAD";
+  unsigned char digest[SHA256_DIGEST_LENGTH];
+  SHA256(reinterpret_cast<const unsigned char*>(canonical.data()),
+         canonical.size(), digest);
+  const std::string to_sign = "AWS4-HMAC-SHA256\n" + amz_date + "\n" + scope +
+                              "\n" + hex(digest, SHA256_DIGEST_LENGTH);
+  std::string key = hmac("AWS4" + secret, date);
+  key = hmac(key, region);
+  key = hmac(key, "s3");
+  key = hmac(key, "aws4_request");
+  const std::string sig = hmac(key, to_sign);
+  return "AWS4-HMAC-SHA256 Credential=" + key_id + "/" + scope +
+         ", SignedHeaders=" + signed_headers + ", Signature=" +
+         hex(reinterpret_cast<const unsigned char*>(sig.data()), sig.size());
+#else
+  return "";
+#endif
+}
+
+/*
+ *  @name   PrepareRequest
+ *  @fn     Status PrepareRequest(const std::string& uri,
+                                  const std::string& query,
+                                  Request* request) override
+ *  @brief  Map `s3://bucket/key` on the endpoint and sign the request
+ */
+Status S3FileSystem::PrepareRequest(const std::string& uri,
+                                    const std::string& query,
+                                    Request* request) {
+  std::string bucket, key;
+  Path::ParseURI(uri, nullptr, &bucket, &key);
+  if (bucket.empty()) {
+    return Status(Status::Type::kInvalidArgument, "Invalid S3 URI: " + uri);
+  }
+  const std::string region = GetEnv("AWS_REGION",
+                                    GetEnv("AWS_DEFAULT_REGION", "us-east-1"));
+  std::string endpoint = GetEnv("S3_ENDPOINT",
+                                "https://s3." + region + ".amazonaws.com");
+  while (!endpoint.empty() && endpoint.back() == '/') {
+    endpoint.pop_back();
+  }
+  std::string scheme, host;
+  Path::ParseURI(endpoint, &scheme, &host, nullptr);
+  if (scheme.empty()) {
+    endpoint = "https://" + endpoint;
+    Path::ParseURI(endpoint, &scheme, &host, nullptr);
+  }
+  // Path-style addressing
+  const std::string path = "/" + bucket + UriEncode(key, true);
+  request->url = endpoint + path + (query.empty() ? "" : "?" + query);
+  const std::string key_id = GetEnv("AWS_ACCESS_KEY_ID", "");
+  const std::string secret = GetEnv("AWS_SECRET_ACCESS_KEY", "");
+  if (!key_id.empty() && !secret.empty()) {
+    const std::string token = GetEnv("AWS_SESSION_TOKEN", "");
+    char amz_date[32];
+    std::time_t now = std::time(nullptr);
+    std::tm utc;
+    gmtime_r(&now, &utc);
+    std::strftime(amz_date, sizeof(amz_date), "%Y%m%dT%H%M%SZ", &utc);
+    std::string auth = SignRequest(request->method, host, path, query,
+                                   amz_date, region, key_id, secret, token);
+    if (auth.empty()) {
+      return Status(Status::Type::kUnimplemented,
+                    "Request signing not supported, built without OpenSSL");
+    }
+    request->headers.push_back(std::string("x-amz-date: ") + amz_date);
+    request->headers.push_back("x-amz-content-sha256: UNSIGNED-PAYLOAD");
+    if (!token.empty()) {
+      request->headers.push_back("x-amz-security-token: " + token);
+    }
+    request->headers.push_back("Authorization: " + auth);
+  }
+  return Status();
+}
+
+/*
+ *  @name   ListObjects
+ *  @fn     Status ListObjects(const std::string& dir, const size_t& max_keys,
+                               std::vector<std::string>* files)
+ *  @brief  `ListObjectsV2` with '/' delimiter, follow continuation tokens
+ *          until `max_keys` entries are gathered (0 for all)
+ */
+Status S3FileSystem::ListObjects(const std::string& dir,
+                                 const size_t& max_keys,
+                                 std::vector<std::string>* files) {
+  files->clear();
+  std::string bucket, prefix;
+  Path::ParseURI(dir, nullptr, &bucket, &prefix);
+  // Drop leading '/', prefix is a directory
+  if (!prefix.empty()) {
+    prefix = prefix.substr(1);
+  }
+  if (!prefix.empty() && prefix.back() != '/') {
+    prefix += '/';
+  }
+  const std::string root = "s3://" + bucket + "/";
+  std::string token;
+  do {
+    // Parameters sorted by name, canonical form used for signing
+    std::string query;
+    if (!token.empty()) {
+      query += "continuation-token=" + UriEncode(token, false) + "&";
+    }
+    query += "delimiter=%2F&list-type=2";
+    if (max_keys > 0) {
+      query += "&max-keys=" + std::to_string(max_keys);
+    }
+    query += "&prefix=" + UriEncode(prefix, false);
+    Request req;
+    req.method = "GET";
+    Status s = this->PrepareRequest("s3://" + bucket, query, &req);
+    std::string body;
+    size_t n_body = 0;
+    long code = 0;
+    if (s.Good()) {
+      s = this->Perform(req, &body, nullptr, 0, 0, &n_body, &code);
+    }
+    if (!s.Good()) {
+      return s;
+    }
+    for (const auto& c : XmlValues(body, "Contents")) {
+      for (const auto& k : XmlValues(c, "Key")) {
+        if (k != prefix) {
+          files->push_back(root + k);
+        }
+      }
+    }
+    for (const auto& c : XmlValues(body, "CommonPrefixes")) {
+      for (auto p : XmlValues(c, "Prefix")) {
+        while (!p.empty() && p.back() == '/') {
+          p.pop_back();
+        }
+        files->push_back(root + p);
+      }
+    }
+    auto truncated = XmlValues(body, "IsTruncated");
+    auto next = XmlValues(body, "NextContinuationToken");
+    token = (!truncated.empty() && truncated[0] == "true" && !next.empty()) ?
+            next[0] : "";
+  } while (!token.empty() && (max_keys == 0 || files->size() < max_keys));
+  return Status();
+}
+
+/**
+ *  @class  HttpsFileSystem
+ *  @brief  Same as HttpFileSystem, registered for the `https` scheme
+ */
+class HttpsFileSystem : public HttpFileSystem {};
+
+// Register file systems
+REGISTER_FILE_SYSTEM("http", HttpFileSystem);
+REGISTER_FILE_SYSTEM("https", HttpsFileSystem);
+REGISTER_FILE_SYSTEM("s3", S3FileSystem);
+
+}  // namespace FaceKit
@@ -0,0 +1,250 @@
+/**
+ *  @file   huge_page_allocator.cpp
+ *  @brief Allocator backing large buffers with huge pages, optionally bound
+ *          to a given NUMA node.
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   26.02.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "facekit/core/mem/huge_page_allocator.hpp"
+#include "facekit/core/mem/allocator_factory.hpp"
+#include "facekit/core/mem/memory.hpp"
+#include "facekit/core/logger.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+// Page sizes
+constexpr size_t HugePageAllocator::kHugePageSize;
+constexpr size_t HugePageAllocator::kMinHugeSize;
+
+#if defined(__linux__)
+
+/** `mbind` policy, placement is a preference, fall back to other nodes */
+static constexpr int kMpolPreferred = 1;
+/** Number of NUMA nodes supported by the mask */
+static constexpr size_t kMaxNumaNode = 1024;
+
+/**
+ *  @name   RoundUp
+ *  @fn     static size_t RoundUp(const size_t& size, const size_t& n)
+ *  @brief  Round `size` up to a multiple of `n` (power of two)
+ *  @param[in] size Value to round
+ *  @param[in] n    Multiple
+ *  @return Rounded value
+ */
+static size_t RoundUp(const size_t& size, const size_t& n) {
+  return (size + n - 1) & ~(n - 1);
+}
+
+/**
+ *  @name   BindToNode
+ *  @fn     static void BindToNode(void* ptr, const size_t& size,
+                                   const int& node)
+ *  @brief  Place a mapping preferably on a given NUMA node, must be called
+ *          before the pages are touched.
+ *  @param[in] ptr  Start of the mapping
+ *  @param[in] size Length of the mapping
+ *  @param[in] node NUMA node
+ */
+static void BindToNode(void* ptr, const size_t& size, const int& node) {
+#if defined(SYS_mbind)
+  constexpr size_t kBits = sizeof(unsigned long) * 8;
+  unsigned long mask[kMaxNumaNode / kBits] = {0};
+  mask[node / kBits] = 1UL << (node % kBits);
+  if (syscall(SYS_mbind, ptr, size, kMpolPreferred, mask,
+              kMaxNumaNode + 1, 0) != 0) {
+    FACEKIT_LOG_WARNING("Can not bind memory to NUMA node " << node);
+  }
+#endif
+}
+
+/**
+ *  @name   MapHuge
+ *  @fn     static void* MapHuge(const size_t& size, const size_t& alignment,
+                                 const int& node)
+ *  @brief  Map an anonymous region of `RoundUp(size, kHugePageSize)` bytes
+ *          backed by huge pages if possible
+ *  @param[in] size       Requested size
+ *  @param[in] alignment  Requested alignment
+ *  @param[in] node       NUMA node, -1 for no preference
+ *  @return Start of the mapping or nullptr on failure
+ */
+static void* MapHuge(const size_t& size,
+                     const size_t& alignment,
+                     const int& node) {
+  const size_t huge = HugePageAllocator::kHugePageSize;
+  const size_t len = RoundUp(size, huge);
+  const int prot = PROT_READ | PROT_WRITE;
+  const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  void* ptr = nullptr;
+#if defined(MAP_HUGETLB)
+  // Explicit huge pages, need pages reserved by the administrator
+  static const bool use_hugetlb = std::getenv("FACEKIT_HUGETLB") != nullptr;
+  if (use_hugetlb && alignment <= huge) {
+    ptr = mmap(nullptr, len, prot, flags | MAP_HUGETLB, -1, 0);
+    if (ptr == MAP_FAILED) {
+      ptr = nullptr;
+    }
+  }
+#endif
+  if (!ptr) {
+    // Over-map to align on huge page boundary, then trim both ends
+    const size_t align = std::max(alignment, huge);
+    const size_t total = len + align;
+    void* raw = mmap(nullptr, total, prot, flags, -1, 0);
+    if (raw == MAP_FAILED) {
+      return nullptr;
+    }
+    const uintptr_t base = reinterpret_cast<uintptr_t>(raw);
+    const uintptr_t start = RoundUp(base, align);
+    if (start > base) {
+      munmap(raw, start - base);
+    }
+    if (base + total > start + len) {
+      munmap(reinterpret_cast<void*>(start + len), base + total - start - len);
+    }
+    ptr = reinterpret_cast<void*>(start);
+#if defined(MADV_HUGEPAGE)
+    madvise(ptr, len, MADV_HUGEPAGE);
+#endif
+  }
+  if (node >= 0 && size_t(node) < kMaxNumaNode) {
+    BindToNode(ptr, len, node);
+  }
+  return ptr;
+}
+
+#endif
+
+/*
+ *  @name   HugePageAllocator
+ *  @fn     explicit HugePageAllocator(const int& numa_node = -1)
+ *  @brief  Constructor
+ *  @param[in] numa_node  NUMA node on which memory is placed preferably,
+ *                        -1 for no preference
+ */
+HugePageAllocator::HugePageAllocator(const int& numa_node) :
+  numa_node_(numa_node) {
+}
+
+/*
+ *  @name   ~HugePageAllocator
+ *  @fn     ~HugePageAllocator(void) override
+ *  @brief  Destructor
+ */
+HugePageAllocator::~HugePageAllocator(void) = default;
+
+/*
+ *  @name   AllocateRaw
+ *  @fn     void* AllocateRaw(const size_t& size,
+ *          const size_t& alignment) override
+ *  @brief  Allocate a block of memory of a given size with specific
+ *          alignment. Alignment must be a power of 2 and minimum of
+ *          sizeof(void*)
+ *  @param[in]  size      Size of the memory block in bytes
+ *  @param[in]  alignment Desired memory alignment
+ *  @return Pointer to memory block or nullptr if failed.
+ */
+void* HugePageAllocator::AllocateRaw(const size_t& size,
+                                     const size_t& alignment) {
+  void* ptr = nullptr;
+#if defined(__linux__)
+  if (size >= kMinHugeSize) {
+    ptr = MapHuge(size, alignment, numa_node_);
+  } else {
+    ptr = Mem::MallocAligned(size, alignment);
+  }
+#else
+  ptr = Mem::MallocAligned(size, alignment);
+#endif
+  if (ptr && AllocatorStatisticsEnabled()) {
+    stats_.Allocate(size, ptr);
+  }
+  return ptr;
+}
+
+/*
+ *  @name   DeallocateRaw
+ *  @fn     void DeallocateRaw(void* ptr) override
+ *  @brief  Release a block of memory pointed by `ptr`
+ *  @param[in]  size  Size of the memory block in bytes
+ *  @param[in]  ptr   Pointer to memory block
+ */
+void HugePageAllocator::DeallocateRaw(const size_t& size, void* ptr) {
+  if (!ptr) {
+    return;
+  }
+  if (AllocatorStatisticsEnabled()) {
+    stats_.Deallocate(size, ptr);
+  }
+#if defined(__linux__)
+  if (size >= kMinHugeSize) {
+    munmap(ptr, RoundUp(size, kHugePageSize));
+  } else {
+    Mem::FreeAligned(ptr);
+  }
+#else
+  Mem::FreeAligned(ptr);
+#endif
+}
+
+/*
+ *  @name   GatherStatistics
+ *  @fn     void GatherStatistics(AllocatorStatistic* stats) override
+ *  @brief  Provide statistics for this allocator
+ *  @param[out] stats   Object filled with statistics from this allocator
+ */
+void HugePageAllocator::GatherStatistics(AllocatorStatistic* stats) {
+  stats_.Gather(stats);
+}
+
+/*
+ *  @name   ClearStatistics
+ *  @fn     void ClearStatistics(void) override
+ *  @brief  Clear allocator's statistics
+ */
+void HugePageAllocator::ClearStatistics(void) {
+  stats_.Clear();
+}
+
+/*
+ *  @name   IsSupported
+ *  @fn     static bool IsSupported(void)
+ *  @brief  Indicate if the platform can provide huge pages
+ *  @return True if supported, false if falling back to regular pages
+ */
+bool HugePageAllocator::IsSupported(void) {
+#if defined(__linux__)
+  std::ifstream stream("/sys/kernel/mm/transparent_hugepage/enabled");
+  std::string mode;
+  if (stream.is_open() && std::getline(stream, mode)) {
+    return mode.find("[never]") == std::string::npos;
+  }
+  return std::getenv("FACEKIT_HUGETLB") != nullptr;
+#else
+  return false;
+#endif
+}
+
+// Register huge page allocator
+REGISTER_ALLOCATOR("huge_page_allocator", HugePageAllocator);
+
+}  // namespace FaceKit
@@ -13,6 +13,11 @@
 typedef __CLPK_integer  lapack_int;
 typedef __CLPK_real lapack_flt;
 typedef __CLPK_doublereal lapack_dbl;
+#elif defined(FACEKIT_USE_MKL)
+// Intel MKL, provides batched BLAS extensions
+#include "mkl.h"
+typedef float lapack_flt;
+typedef double lapack_dbl;
 #else
 // Include proper file for Linux/Win32 -> OpenBLAS
 #include "cblas.h"
@@ -21,8 +26,16 @@ typedef float lapack_flt;
 typedef double lapack_dbl;
 #endif
 
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include "opencv2/core/core.hpp"
+
 #include "facekit/core/math/linear_algebra.hpp"
+#include "facekit/core/math/blas_backend.hpp"
 #include "facekit/core/logger.hpp"
+#include "facekit/core/thread_pool.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -464,6 +477,79 @@ void LinearAlgebra<double>::Gemv(const cv::Mat& A,
               1);
 }
 
+/*
+ *  @name   Gemv
+ *  @fn void Gemv(const QuantizedMatrix& A,
+                  const TransposeType trans_a,
+                  const T alpha,
+                  const cv::Mat& x,
+                  const T beta,
+                  cv::Mat* y)
+ *  @brief  Multiplies a reduced precision matrix by a vector
+ *          Y = a * Ax + b Y. Elements of A are widened on the fly and
+ *          accumulated in single precision.
+ *  @param[in] A        Quantized matrix A
+ *  @param[in] trans_a  Indicate if A is transpose or not
+ *  @param[in] alpha    Scaling factor alpha
+ *  @param[in] x        Vector X
+ *  @param[in] beta     Scaling factor beta
+ *  @param[in,out] y    Output vector
+ */
+template<typename T>
+void LinearAlgebra<T>::Gemv(const QuantizedMatrix& A,
+                            const TransposeType trans_a,
+                            const T alpha,
+                            const cv::Mat& x,
+                            const T beta,
+                            cv::Mat* y) {
+  // stub
+}
+template<>
+void LinearAlgebra<float>::Gemv(const QuantizedMatrix& A,
+                                const TransposeType trans_a,
+                                const float alpha,
+                                const cv::Mat& x,
+                                const float beta,
+                                cv::Mat* y) {
+  assert(x.type() == CV_32FC1 && x.isContinuous());
+  const bool trans = trans_a != TransposeType::kNoTranspose;
+  assert((trans ? A.rows() : A.cols()) == std::max(x.cols, x.rows));
+  y->create(trans ? A.cols() : A.rows(), 1, CV_32FC1);
+  A.Gemv(trans,
+         alpha,
+         reinterpret_cast<const float*>(x.data),
+         beta,
+         reinterpret_cast<float*>(y->data));
+}
+template<>
+void LinearAlgebra<double>::Gemv(const QuantizedMatrix& A,
+                                 const TransposeType trans_a,
+                                 const double alpha,
+                                 const cv::Mat& x,
+                                 const double beta,
+                                 cv::Mat* y) {
+  assert(x.type() == CV_64FC1 && x.isContinuous());
+  const bool trans = trans_a != TransposeType::kNoTranspose;
+  const int n_in = trans ? A.rows() : A.cols();
+  const int n_out = trans ? A.cols() : A.rows();
+  assert(n_in == std::max(x.cols, x.rows));
+  y->create(n_out, 1, CV_64FC1);
+  // Products run in single precision, convert operands
+  const double* px = reinterpret_cast<const double*>(x.data);
+  double* py = reinterpret_cast<double*>(y->data);
+  std::vector<float> xf(px, px + n_in);
+  std::vector<float> yf(n_out, 0.f);
+  if (beta != 0.0) {
+    yf.assign(py, py + n_out);
+  }
+  A.Gemv(trans,
+         static_cast<float>(alpha),
+         xf.data(),
+         static_cast<float>(beta),
+         yf.data());
+  std::copy(yf.begin(), yf.end(), py);
+}
+
 #pragma mark -
 #pragma mark Gemm
 
@@ -569,6 +655,510 @@ void LinearAlgebra<double>::Gemm(const cv::Mat& A,
               C->cols);
 }
   
+#pragma mark -
+#pragma mark Batched Gemv / Gemm
+
+namespace internal {
+
+/**
+ *  @struct Blas
+ *  @brief  Type dispatch for the BLAS routines used by batched and NDArray
+ *          operations
+ *  @tparam T Data type
+ */
+template<typename T>
+struct Blas;
+
+template<>
+struct Blas<float> {
+  /** Single y = alpha * op(A) * x + beta * y, row major */
+  static void Gemv(const CBLAS_TRANSPOSE trans, const int m, const int n,
+                   const float alpha, const float* a, const int lda,
+                   const float* x, const float beta, float* y) {
+    cblas_sgemv(CBLAS_ORDER::CblasRowMajor, trans, m, n, alpha, a, lda, x, 1,
+                beta, y, 1);
+  }
+  /** Single C = alpha * op(A) * op(B) + beta * C, row major */
+  static void Gemm(const CBLAS_TRANSPOSE trans_a,
+                   const CBLAS_TRANSPOSE trans_b,
+                   const int m, const int n, const int k, const float alpha,
+                   const float* a, const int lda, const float* b,
+                   const int ldb, const float beta, float* c, const int ldc) {
+    cblas_sgemm(CBLAS_ORDER::CblasRowMajor, trans_a, trans_b, m, n, k, alpha,
+                a, lda, b, ldb, beta, c, ldc);
+  }
+  /** Single y = alpha * op(A) * x + beta * y, strided vectors */
+  static void Gemv(const CBLAS_TRANSPOSE trans, const int m, const int n,
+                   const float alpha, const float* a, const int lda,
+                   const float* x, const int incx, const float beta,
+                   float* y, const int incy) {
+    cblas_sgemv(CBLAS_ORDER::CblasRowMajor, trans, m, n, alpha, a, lda, x,
+                incx, beta, y, incy);
+  }
+  /** Euclidean norm of a strided vector */
+  static float Nrm2(const int n, const float* x, const int incx) {
+    return cblas_snrm2(n, x, incx);
+  }
+  /** y = alpha * x + y, strided vectors */
+  static void Axpy(const int n, const float alpha, const float* x,
+                   const int incx, float* y, const int incy) {
+    cblas_saxpy(n, alpha, x, incx, y, incy);
+  }
+  /** Dot product of two strided vectors */
+  static float Dot(const int n, const float* x, const int incx,
+                   const float* y, const int incy) {
+    return cblas_sdot(n, x, incx, y, incy);
+  }
+  /** y = alpha * diag(a) * x + beta * y, strided vectors */
+  static void Sbmv(const int n, const float alpha, const float* a,
+                   const int lda, const float* x, const int incx,
+                   const float beta, float* y, const int incy) {
+    cblas_ssbmv(CBLAS_ORDER::CblasRowMajor, CBLAS_UPLO::CblasUpper, n, 0,
+                alpha, a, lda, x, incx, beta, y, incy);
+  }
+#ifdef FACEKIT_USE_MKL
+  /** Strided batch of Gemv */
+  static void GemvStrided(const CBLAS_TRANSPOSE trans, const int m,
+                          const int n, const float alpha, const float* a,
+                          const int lda, const int stride_a, const float* x,
+                          const int stride_x, const float beta, float* y,
+                          const int stride_y, const int batch) {
+    cblas_sgemv_batch_strided(CBLAS_ORDER::CblasRowMajor, trans, m, n, alpha,
+                              a, lda, stride_a, x, 1, stride_x, beta, y, 1,
+                              stride_y, batch);
+  }
+  /** Strided batch of Gemm */
+  static void GemmStrided(const CBLAS_TRANSPOSE trans_a,
+                          const CBLAS_TRANSPOSE trans_b, const int m,
+                          const int n, const int k, const float alpha,
+                          const float* a, const int lda, const int stride_a,
+                          const float* b, const int ldb, const int stride_b,
+                          const float beta, float* c, const int ldc,
+                          const int stride_c, const int batch) {
+    cblas_sgemm_batch_strided(CBLAS_ORDER::CblasRowMajor, trans_a, trans_b, m,
+                              n, k, alpha, a, lda, stride_a, b, ldb, stride_b,
+                              beta, c, ldc, stride_c, batch);
+  }
+  /** Grouped batch of Gemv, one group per item */
+  static void GemvGroup(const CBLAS_TRANSPOSE* trans, const int* m,
+                        const int* n, const float* alpha, const float** a,
+                        const int* lda, const float** x, const int* inc,
+                        const float* beta, float** y, const int batch,
+                        const int* group_size) {
+    cblas_sgemv_batch(CBLAS_ORDER::CblasRowMajor, trans, m, n, alpha, a, lda,
+                      x, inc, beta, y, inc, batch, group_size);
+  }
+  /** Grouped batch of Gemm, one group per item */
+  static void GemmGroup(const CBLAS_TRANSPOSE* trans_a,
+                        const CBLAS_TRANSPOSE* trans_b, const int* m,
+                        const int* n, const int* k, const float* alpha,
+                        const float** a, const int* lda, const float** b,
+                        const int* ldb, const float* beta, float** c,
+                        const int* ldc, const int batch,
+                        const int* group_size) {
+    cblas_sgemm_batch(CBLAS_ORDER::CblasRowMajor, trans_a, trans_b, m, n, k,
+                      alpha, a, lda, b, ldb, beta, c, ldc, batch, group_size);
+  }
+#endif
+};
+
+template<>
+struct Blas<double> {
+  /** Single y = alpha * op(A) * x + beta * y, row major */
+  static void Gemv(const CBLAS_TRANSPOSE trans, const int m, const int n,
+                   const double alpha, const double* a, const int lda,
+                   const double* x, const double beta, double* y) {
+    cblas_dgemv(CBLAS_ORDER::CblasRowMajor, trans, m, n, alpha, a, lda, x, 1,
+                beta, y, 1);
+  }
+  /** Single C = alpha * op(A) * op(B) + beta * C, row major */
+  static void Gemm(const CBLAS_TRANSPOSE trans_a,
+                   const CBLAS_TRANSPOSE trans_b,
+                   const int m, const int n, const int k, const double alpha,
+                   const double* a, const int lda, const double* b,
+                   const int ldb, const double beta, double* c,
+                   const int ldc) {
+    cblas_dgemm(CBLAS_ORDER::CblasRowMajor, trans_a, trans_b, m, n, k, alpha,
+                a, lda, b, ldb, beta, c, ldc);
+  }
+  /** Single y = alpha * op(A) * x + beta * y, strided vectors */
+  static void Gemv(const CBLAS_TRANSPOSE trans, const int m, const int n,
+                   const double alpha, const double* a, const int lda,
+                   const double* x, const int incx, const double beta,
+                   double* y, const int incy) {
+    cblas_dgemv(CBLAS_ORDER::CblasRowMajor, trans, m, n, alpha, a, lda, x,
+                incx, beta, y, incy);
+  }
+  /** Euclidean norm of a strided vector */
+  static double Nrm2(const int n, const double* x, const int incx) {
+    return cblas_dnrm2(n, x, incx);
+  }
+  /** y = alpha * x + y, strided vectors */
+  static void Axpy(const int n, const double alpha, const double* x,
+                   const int incx, double* y, const int incy) {
+    cblas_daxpy(n, alpha, x, incx, y, incy);
+  }
+  /** Dot product of two strided vectors */
+  static double Dot(const int n, const double* x, const int incx,
+                    const double* y, const int incy) {
+    return cblas_ddot(n, x, incx, y, incy);
+  }
+  /** y = alpha * diag(a) * x + beta * y, strided vectors */
+  static void Sbmv(const int n, const double alpha, const double* a,
+                   const int lda, const double* x, const int incx,
+                   const double beta, double* y, const int incy) {
+    cblas_dsbmv(CBLAS_ORDER::CblasRowMajor, CBLAS_UPLO::CblasUpper, n, 0,
+                alpha, a, lda, x, incx, beta, y, incy);
+  }
+#ifdef FACEKIT_USE_MKL
+  /** Strided batch of Gemv */
+  static void GemvStrided(const CBLAS_TRANSPOSE trans, const int m,
+                          const int n, const double alpha, const double* a,
+                          const int lda, const int stride_a, const double* x,
+                          const int stride_x, const double beta, double* y,
+                          const int stride_y, const int batch) {
+    cblas_dgemv_batch_strided(CBLAS_ORDER::CblasRowMajor, trans, m, n, alpha,
+                              a, lda, stride_a, x, 1, stride_x, beta, y, 1,
+                              stride_y, batch);
+  }
+  /** Strided batch of Gemm */
+  static void GemmStrided(const CBLAS_TRANSPOSE trans_a,
+                          const CBLAS_TRANSPOSE trans_b, const int m,
+                          const int n, const int k, const double alpha,
+                          const double* a, const int lda, const int stride_a,
+                          const double* b, const int ldb, const int stride_b,
+                          const double beta, double* c, const int ldc,
+                          const int stride_c, const int batch) {
+    cblas_dgemm_batch_strided(CBLAS_ORDER::CblasRowMajor, trans_a, trans_b, m,
+                              n, k, alpha, a, lda, stride_a, b, ldb, stride_b,
+                              beta, c, ldc, stride_c, batch);
+  }
+  /** Grouped batch of Gemv, one group per item */
+  static void GemvGroup(const CBLAS_TRANSPOSE* trans, const int* m,
+                        const int* n, const double* alpha, const double** a,
+                        const int* lda, const double** x, const int* inc,
+                        const double* beta, double** y, const int batch,
+                        const int* group_size) {
+    cblas_dgemv_batch(CBLAS_ORDER::CblasRowMajor, trans, m, n, alpha, a, lda,
+                      x, inc, beta, y, inc, batch, group_size);
+  }
+  /** Grouped batch of Gemm, one group per item */
+  static void GemmGroup(const CBLAS_TRANSPOSE* trans_a,
+                        const CBLAS_TRANSPOSE* trans_b, const int* m,
+                        const int* n, const int* k, const double* alpha,
+                        const double** a, const int* lda, const double** b,
+                        const int* ldb, const double* beta, double** c,
+                        const int* ldc, const int batch,
+                        const int* group_size) {
+    cblas_dgemm_batch(CBLAS_ORDER::CblasRowMajor, trans_a, trans_b, m, n, k,
+                      alpha, a, lda, b, ldb, beta, c, ldc, batch, group_size);
+  }
+#endif
+};
+
+/**
+ *  @name   ForEachItem
+ *  @fn     void ForEachItem(const int& batch, F&& fn)
+ *  @brief  Call `fn(i)` for every item of a batch, concurrently on the
+ *          default pool when there is more than one item. BLAS runs single
+ *          threaded meanwhile to avoid oversubscribing the cores.
+ *  @param[in] batch  Number of items
+ *  @param[in] fn     Callable with the signature `void(const size_t& i)`
+ *  @tparam F Callable type
+ */
+template<typename F>
+void ForEachItem(const int& batch, F&& fn) {
+  if (batch == 1) {
+    fn(0);
+  } else if (batch > 1) {
+    BlasBackend::SerialScope serial;
+    ThreadPool::Get().ParallelFor(0,
+                                  static_cast<size_t>(batch),
+                                  0,
+                                  [&](const size_t& first,
+                                      const size_t& last) {
+      for (size_t i = first; i < last; ++i) {
+        fn(i);
+      }
+    });
+  }
+}
+
+}  // namespace internal
+
+/*
+ *  @name   GemvBatched
+ *  @fn void GemvBatched(const cv::Mat& A,
+                         const TransposeType trans_a,
+                         const T alpha,
+                         const cv::Mat& X,
+                         const T beta,
+                         cv::Mat* Y)
+ *  @brief  Multiplies a batch of matrices by a batch of vectors (strided
+ *          form). For each `i` in [0, X.rows):
+ *          Y_i = a * A_i x_i + b Y_i
+ *  @param[in] A        Matrices A_i stacked vertically, i.e. A.rows must be a
+ *                      multiple of the batch size
+ *  @param[in] trans_a  Indicate if A_i are transpose or not
+ *  @param[in] alpha    Scaling factor alpha
+ *  @param[in] X        Vectors x_i, one per row
+ *  @param[in] beta     Scaling factor beta
+ *  @param[in,out] Y    Output vectors y_i, one per row
+ */
+template<typename T>
+void LinearAlgebra<T>::GemvBatched(const cv::Mat& A,
+                                   const TransposeType trans_a,
+                                   const T alpha,
+                                   const cv::Mat& X,
+                                   const T beta,
+                                   cv::Mat* Y) {
+  assert((A.type() == cv::DataType<T>::type) &&
+         (X.type() == cv::DataType<T>::type));
+  const int batch = X.rows;
+  assert(batch > 0 && (A.rows % batch) == 0);
+  const int m = A.rows / batch;
+  const int n = A.cols;
+  const bool no_trans = trans_a == TransposeType::kNoTranspose;
+  const int len_x = no_trans ? n : m;
+  const int len_y = no_trans ? m : n;
+  assert(X.cols == len_x);
+  //Take care for output
+  Y->create(batch, len_y, A.type());
+  const auto trans = static_cast<CBLAS_TRANSPOSE>(trans_a);
+  const T* a = reinterpret_cast<const T*>(A.data);
+  const T* x = reinterpret_cast<const T*>(X.data);
+  T* y = reinterpret_cast<T*>(Y->data);
+#ifdef FACEKIT_USE_MKL
+  internal::Blas<T>::GemvStrided(trans, m, n, alpha, a, n, m * n, x, len_x,
+                                 beta, y, len_y, batch);
+#else
+  internal::ForEachItem(batch, [&](const size_t& i) {
+    internal::Blas<T>::Gemv(trans, m, n, alpha, a + i * m * n, n,
+                            x + i * len_x, beta, y + i * len_y);
+  });
+#endif
+}
+
+/*
+ *  @name   GemvBatched
+ *  @fn void GemvBatched(const std::vector<cv::Mat>& A,
+                         const TransposeType trans_a,
+                         const T alpha,
+                         const std::vector<cv::Mat>& x,
+                         const T beta,
+                         std::vector<cv::Mat>* y)
+ *  @brief  Multiplies a list of matrices by a list of vectors, matrices can
+ *          have different dimensions.
+ *          y[i] = a * A[i] x[i] + b y[i]
+ *  @param[in] A        List of matrices
+ *  @param[in] trans_a  Indicate if A[i] are transpose or not
+ *  @param[in] alpha    Scaling factor alpha
+ *  @param[in] x        List of vectors, same size as `A`
+ *  @param[in] beta     Scaling factor beta
+ *  @param[in,out] y    Output vectors
+ */
+template<typename T>
+void LinearAlgebra<T>::GemvBatched(const std::vector<cv::Mat>& A,
+                                   const TransposeType trans_a,
+                                   const T alpha,
+                                   const std::vector<cv::Mat>& x,
+                                   const T beta,
+                                   std::vector<cv::Mat>* y) {
+  assert(A.size() == x.size());
+  const int batch = static_cast<int>(A.size());
+  const bool no_trans = trans_a == TransposeType::kNoTranspose;
+  // Outputs are created upfront, workers only fill them
+  y->resize(A.size());
+  for (size_t i = 0; i < A.size(); ++i) {
+    assert((A[i].type() == cv::DataType<T>::type) &&
+           (x[i].type() == cv::DataType<T>::type));
+    assert((no_trans ? A[i].cols : A[i].rows) ==
+           std::max(x[i].cols, x[i].rows));
+    (*y)[i].create(no_trans ? A[i].rows : A[i].cols, 1, A[i].type());
+  }
+  const auto trans = static_cast<CBLAS_TRANSPOSE>(trans_a);
+#ifdef FACEKIT_USE_MKL
+  std::vector<CBLAS_TRANSPOSE> p_trans(A.size(), trans);
+  std::vector<int> p_m(A.size()), p_n(A.size()), p_inc(A.size(), 1);
+  std::vector<int> p_size(A.size(), 1);
+  std::vector<T> p_alpha(A.size(), alpha), p_beta(A.size(), beta);
+  std::vector<const T*> p_a(A.size()), p_x(A.size());
+  std::vector<T*> p_y(A.size());
+  for (size_t i = 0; i < A.size(); ++i) {
+    p_m[i] = A[i].rows;
+    p_n[i] = A[i].cols;
+    p_a[i] = reinterpret_cast<const T*>(A[i].data);
+    p_x[i] = reinterpret_cast<const T*>(x[i].data);
+    p_y[i] = reinterpret_cast<T*>((*y)[i].data);
+  }
+  if (batch > 0) {
+    internal::Blas<T>::GemvGroup(p_trans.data(), p_m.data(), p_n.data(),
+                                 p_alpha.data(), p_a.data(), p_n.data(),
+                                 p_x.data(), p_inc.data(), p_beta.data(),
+                                 p_y.data(), batch, p_size.data());
+  }
+#else
+  internal::ForEachItem(batch, [&](const size_t& i) {
+    internal::Blas<T>::Gemv(trans,
+                            A[i].rows,
+                            A[i].cols,
+                            alpha,
+                            reinterpret_cast<const T*>(A[i].data),
+                            A[i].cols,
+                            reinterpret_cast<const T*>(x[i].data),
+                            beta,
+                            reinterpret_cast<T*>((*y)[i].data));
+  });
+#endif
+}
+
+/*
+ *  @name   GemmBatched
+ *  @fn void GemmBatched(const cv::Mat& A,
+                         const TransposeType trans_a,
+                         const T alpha,
+                         const cv::Mat& B,
+                         const TransposeType trans_b,
+                         const T beta,
+                         const int batch,
+                         cv::Mat* C)
+ *  @brief  Compute the product between two batches of matrices (strided
+ *          form). For each `i` in [0, batch):
+ *          C_i = a * A_i B_i + b * C_i
+ *  @param[in] A         Matrices A_i stacked vertically
+ *  @param[in] trans_a   Transpose flag indicator for A_i
+ *  @param[in] alpha     Alpha coefficient
+ *  @param[in] B         Matrices B_i stacked vertically
+ *  @param[in] trans_b   Transpose flag indicator for B_i
+ *  @param[in] beta      Beta coefficient
+ *  @param[in] batch     Number of products
+ *  @param[in,out] C     Resulting matrices C_i stacked vertically
+ */
+template<typename T>
+void LinearAlgebra<T>::GemmBatched(const cv::Mat& A,
+                                   const TransposeType trans_a,
+                                   const T alpha,
+                                   const cv::Mat& B,
+                                   const TransposeType trans_b,
+                                   const T beta,
+                                   const int batch,
+                                   cv::Mat* C) {
+  assert((A.type() == cv::DataType<T>::type) &&
+         (B.type() == cv::DataType<T>::type));
+  assert(batch > 0 && (A.rows % batch) == 0 && (B.rows % batch) == 0);
+  // Dimensions of a single item
+  const int a_rows = A.rows / batch;
+  const int b_rows = B.rows / batch;
+  const bool no_trans_a = trans_a == TransposeType::kNoTranspose;
+  const bool no_trans_b = trans_b == TransposeType::kNoTranspose;
+  const int out_row = no_trans_a ? a_rows : A.cols;
+  const int out_col = no_trans_b ? B.cols : b_rows;
+  const int K = no_trans_a ? A.cols : a_rows;
+  assert(K == (no_trans_b ? b_rows : B.cols));
+  C->create(batch * out_row, out_col, A.type());
+  const auto ta = static_cast<CBLAS_TRANSPOSE>(trans_a);
+  const auto tb = static_cast<CBLAS_TRANSPOSE>(trans_b);
+  const int stride_a = a_rows * A.cols;
+  const int stride_b = b_rows * B.cols;
+  const int stride_c = out_row * out_col;
+  const T* a = reinterpret_cast<const T*>(A.data);
+  const T* b = reinterpret_cast<const T*>(B.data);
+  T* c = reinterpret_cast<T*>(C->data);
+#ifdef FACEKIT_USE_MKL
+  internal::Blas<T>::GemmStrided(ta, tb, out_row, out_col, K, alpha,
+                                 a, A.cols, stride_a,
+                                 b, B.cols, stride_b,
+                                 beta, c, out_col, stride_c, batch);
+#else
+  internal::ForEachItem(batch, [&](const size_t& i) {
+    internal::Blas<T>::Gemm(ta, tb, out_row, out_col, K, alpha,
+                            a + i * stride_a, A.cols,
+                            b + i * stride_b, B.cols,
+                            beta, c + i * stride_c, out_col);
+  });
+#endif
+}
+
+/*
+ *  @name   GemmBatched
+ *  @fn void GemmBatched(const std::vector<cv::Mat>& A,
+                         const TransposeType trans_a,
+                         const T alpha,
+                         const std::vector<cv::Mat>& B,
+                         const TransposeType trans_b,
+                         const T beta,
+                         std::vector<cv::Mat>* C)
+ *  @brief  Compute the product between two lists of matrices, products can
+ *          have different dimensions.
+ *          C[i] = a * A[i] B[i] + b * C[i]
+ *  @param[in] A         List of matrices A
+ *  @param[in] trans_a   Transpose flag indicator for A[i]
+ *  @param[in] alpha     Alpha coefficient
+ *  @param[in] B         List of matrices B, same size as `A`
+ *  @param[in] trans_b   Transpose flag indicator for B[i]
+ *  @param[in] beta      Beta coefficient
+ *  @param[in,out] C     Resulting matrices
+ */
+template<typename T>
+void LinearAlgebra<T>::GemmBatched(const std::vector<cv::Mat>& A,
+                                   const TransposeType trans_a,
+                                   const T alpha,
+                                   const std::vector<cv::Mat>& B,
+                                   const TransposeType trans_b,
+                                   const T beta,
+                                   std::vector<cv::Mat>* C) {
+  assert(A.size() == B.size());
+  const int batch = static_cast<int>(A.size());
+  const bool no_trans_a = trans_a == TransposeType::kNoTranspose;
+  const bool no_trans_b = trans_b == TransposeType::kNoTranspose;
+  // Outputs are created upfront, workers only fill them
+  std::vector<int> p_m(A.size()), p_n(A.size()), p_k(A.size());
+  C->resize(A.size());
+  for (size_t i = 0; i < A.size(); ++i) {
+    assert((A[i].type() == cv::DataType<T>::type) &&
+           (B[i].type() == cv::DataType<T>::type));
+    p_m[i] = no_trans_a ? A[i].rows : A[i].cols;
+    p_n[i] = no_trans_b ? B[i].cols : B[i].rows;
+    p_k[i] = no_trans_a ? A[i].cols : A[i].rows;
+    assert(p_k[i] == (no_trans_b ? B[i].rows : B[i].cols));
+    (*C)[i].create(p_m[i], p_n[i], A[i].type());
+  }
+  const auto ta = static_cast<CBLAS_TRANSPOSE>(trans_a);
+  const auto tb = static_cast<CBLAS_TRANSPOSE>(trans_b);
+#ifdef FACEKIT_USE_MKL
+  std::vector<CBLAS_TRANSPOSE> p_ta(A.size(), ta), p_tb(A.size(), tb);
+  std::vector<int> p_lda(A.size()), p_ldb(A.size()), p_size(A.size(), 1);
+  std::vector<T> p_alpha(A.size(), alpha), p_beta(A.size(), beta);
+  std::vector<const T*> p_a(A.size()), p_b(A.size());
+  std::vector<T*> p_c(A.size());
+  for (size_t i = 0; i < A.size(); ++i) {
+    p_lda[i] = A[i].cols;
+    p_ldb[i] = B[i].cols;
+    p_a[i] = reinterpret_cast<const T*>(A[i].data);
+    p_b[i] = reinterpret_cast<const T*>(B[i].data);
+    p_c[i] = reinterpret_cast<T*>((*C)[i].data);
+  }
+  if (batch > 0) {
+    internal::Blas<T>::GemmGroup(p_ta.data(), p_tb.data(), p_m.data(),
+                                 p_n.data(), p_k.data(), p_alpha.data(),
+                                 p_a.data(), p_lda.data(), p_b.data(),
+                                 p_ldb.data(), p_beta.data(), p_c.data(),
+                                 p_n.data(), batch, p_size.data());
+  }
+#else
+  internal::ForEachItem(batch, [&](const size_t& i) {
+    internal::Blas<T>::Gemm(ta, tb, p_m[i], p_n[i], p_k[i], alpha,
+                            reinterpret_cast<const T*>(A[i].data),
+                            A[i].cols,
+                            reinterpret_cast<const T*>(B[i].data),
+                            B[i].cols,
+                            beta,
+                            reinterpret_cast<T*>((*C)[i].data),
+                            p_n[i]);
+  });
+#endif
+}
+
 #pragma mark -
 #pragma mark Sbmv
   
@@ -657,6 +1247,441 @@ void LinearAlgebra<double>::Sbmv(const cv::Mat& A,
               inc);
 }
   
+#pragma mark -
+#pragma mark BLAS on NDArray
+
+namespace internal {
+
+/**
+ *  @name   VectorStride
+ *  @fn     bool VectorStride(const NDArray& array, int* inc)
+ *  @brief  Check if the elements of an array are evenly spaced in memory,
+ *          i.e. if it can be given to BLAS as a strided vector
+ *  @param[in]  array Array to check
+ *  @param[out] inc   Distance between two consecutive elements
+ *  @return True if evenly spaced
+ */
+bool VectorStride(const NDArray& array, int* inc) {
+  *inc = 1;
+  if (array.IsContiguous()) {
+    return true;
+  }
+  if (array.dims() > 2) {
+    return false;
+  }
+  // Ignore unit axes, the remaining ones must chain up
+  const std::vector<size_t> strides = array.strides();
+  size_t expected = 0;
+  for (size_t k = array.dims(); k > 0; --k) {
+    const size_t axis = k - 1;
+    const size_t dim = array.dim_size(axis);
+    if (dim == 1) {
+      continue;
+    }
+    if (expected == 0) {
+      *inc = static_cast<int>(strides[axis]);
+    } else if (strides[axis] != expected) {
+      return false;
+    }
+    expected = strides[axis] * dim;
+  }
+  return true;
+}
+
+/**
+ *  @name   ConstData
+ *  @fn     const T* ConstData(const NDArray& array)
+ *  @brief  Address of the first element of a contiguous array or of a
+ *          rank-1/rank-2 view
+ *  @param[in] array  Array to access
+ *  @tparam T Data type
+ *  @return Address of the first element
+ */
+template<typename T>
+const T* ConstData(const NDArray& array) {
+  if (array.IsContiguous()) {
+    return array.AsFlat<T>().data();
+  }
+  return array.dims() == 1 ?
+         array.AsVector<T>().data() :
+         array.AsMatrix<T>().data();
+}
+
+/**
+ *  @name   MutableData
+ *  @fn     T* MutableData(NDArray* array)
+ *  @brief  Writable address of the first element of a contiguous array or of
+ *          a rank-1/rank-2 view. Shared buffer are cloned first
+ *  @param[in] array  Array to access
+ *  @tparam T Data type
+ *  @return Address of the first element
+ */
+template<typename T>
+T* MutableData(NDArray* array) {
+  if (array->IsContiguous()) {
+    return array->AsFlat<T>().data();
+  }
+  return array->dims() == 1 ?
+         array->AsVector<T>().data() :
+         array->AsMatrix<T>().data();
+}
+
+/**
+ *  @name   InputVector
+ *  @fn     const T* InputVector(const NDArray& array, NDArray* buffer,
+                                 int* inc)
+ *  @brief  Give a BLAS compatible vector for a given array. Unevenly spaced
+ *          views are copied into `buffer`.
+ *  @param[in]  array   Array to access
+ *  @param[out] buffer  Storage for contiguous copy, if needed
+ *  @param[out] inc     Distance between two consecutive elements
+ *  @tparam T Data type
+ *  @return Address of the first element
+ */
+template<typename T>
+const T* InputVector(const NDArray& array, NDArray* buffer, int* inc) {
+  assert(array.type() == DataTypeToEnum<T>::v());
+  if (VectorStride(array, inc)) {
+    return ConstData<T>(array);
+  }
+  array.DeepCopy(buffer);
+  *inc = 1;
+  return buffer->AsFlat<T>().data();
+}
+
+/**
+ *  @name   OutputVector
+ *  @fn     T* OutputVector(const size_t& n, const NDArrayDims& dims,
+                            NDArray* array, int* inc)
+ *  @brief  Give a writable BLAS vector of `n` elements. The array is
+ *          reallocated with `dims` if it does not hold `n` elements of type
+ *          `T` evenly spaced.
+ *  @param[in]  n     Number of elements
+ *  @param[in]  dims  Dimensions to use when reallocating
+ *  @param[in,out] array  Array to write into
+ *  @param[out] inc   Distance between two consecutive elements
+ *  @tparam T Data type
+ *  @return Address of the first element
+ */
+template<typename T>
+T* OutputVector(const size_t& n,
+                const NDArrayDims& dims,
+                NDArray* array,
+                int* inc) {
+  if (array->type() == DataTypeToEnum<T>::v() &&
+      array->n_elems() == n &&
+      VectorStride(*array, inc)) {
+    // Writing may clone a shared buffer into a contiguous one
+    T* data = MutableData<T>(array);
+    VectorStride(*array, inc);
+    return data;
+  }
+  array->Resize(DataTypeToEnum<T>::v(), dims);
+  *inc = 1;
+  return MutableData<T>(array);
+}
+
+/**
+ *  @name   MatrixLayout
+ *  @fn     bool MatrixLayout(const NDArray& array, bool* flip, int* ld)
+ *  @brief  Check if a rank-2 array can be given to row major BLAS routines.
+ *          This is the case when its rows are contiguous (`flip` = false) or
+ *          when its columns are (i.e. transposed view, `flip` = true).
+ *  @param[in]  array Array to check
+ *  @param[out] flip  Indicate if the array is stored transposed
+ *  @param[out] ld    Leading dimension of the storage
+ *  @return True if the layout is usable as is
+ */
+bool MatrixLayout(const NDArray& array, bool* flip, int* ld) {
+  assert(array.dims() == 2);
+  const size_t rows = array.dim_size(0);
+  const size_t cols = array.dim_size(1);
+  const std::vector<size_t> strides = array.strides();
+  if (cols == 1 || strides[1] == 1) {
+    const size_t lead = rows == 1 ? cols : strides[0];
+    *flip = false;
+    *ld = static_cast<int>(std::max(lead, size_t(1)));
+    return lead >= cols;
+  }
+  if (rows == 1 || strides[0] == 1) {
+    const size_t lead = strides[1];
+    *flip = true;
+    *ld = static_cast<int>(std::max(lead, size_t(1)));
+    return lead >= rows;
+  }
+  return false;
+}
+
+/**
+ *  @name   InputMatrix
+ *  @fn     const T* InputMatrix(const NDArray& array, NDArray* buffer,
+                                 bool* flip, int* ld)
+ *  @brief  Give a BLAS compatible matrix for a given rank-2 array. Views
+ *          with neither contiguous rows nor columns are copied into `buffer`.
+ *  @param[in]  array   Array to access
+ *  @param[out] buffer  Storage for contiguous copy, if needed
+ *  @param[out] flip    Indicate if the matrix is stored transposed
+ *  @param[out] ld      Leading dimension of the storage
+ *  @tparam T Data type
+ *  @return Address of the first element
+ */
+template<typename T>
+const T* InputMatrix(const NDArray& array,
+                     NDArray* buffer,
+                     bool* flip,
+                     int* ld) {
+  assert(array.type() == DataTypeToEnum<T>::v());
+  if (MatrixLayout(array, flip, ld)) {
+    return ConstData<T>(array);
+  }
+  array.DeepCopy(buffer);
+  *flip = false;
+  *ld = static_cast<int>(std::max(array.dim_size(1), size_t(1)));
+  return buffer->AsFlat<T>().data();
+}
+
+/**
+ *  @name   ToCblas
+ *  @fn     CBLAS_TRANSPOSE ToCblas(const bool& transpose)
+ *  @brief  Convert transpose flag into BLAS enum
+ *  @param[in] transpose  True if transposed
+ *  @return BLAS transpose flag
+ */
+inline CBLAS_TRANSPOSE ToCblas(const bool& transpose) {
+  return transpose ? CBLAS_TRANSPOSE::CblasTrans :
+                     CBLAS_TRANSPOSE::CblasNoTrans;
+}
+
+}  // namespace internal
+
+/*
+ *  @name L2Norm
+ *  @fn T L2Norm(const NDArray& vector)
+ *  @brief  Compute the L2 norm of a vector. Strided views are processed in
+ *          place as long as their elements are evenly spaced.
+ *  @param[in]  vector  Vector to compute the norm
+ *  @return L2 Norm
+ */
+template<typename T>
+T LinearAlgebra<T>::L2Norm(const NDArray& vector) {
+  NDArray buffer;
+  int inc;
+  const T* x = internal::InputVector<T>(vector, &buffer, &inc);
+  return internal::Blas<T>::Nrm2(static_cast<int>(vector.n_elems()), x, inc);
+}
+
+/*
+ *  @name Axpy
+ *  @fn void Axpy(const NDArray& A, const T alpha, NDArray* B)
+ *  @brief  Compute : B := alpha * A + B. \p B is reallocated with the
+ *          dimensions of \p A if it does not hold as many elements or
+ *          can not be written in place.
+ *  @param[in]      A         Vector/Matrix A
+ *  @param[in]      alpha     Alpha scaling factor
+ *  @param[in,out]  B         Vector/Matrix B
+ */
+template<typename T>
+void LinearAlgebra<T>::Axpy(const NDArray& A, const T alpha, NDArray* B) {
+  NDArray buffer;
+  int inc_a, inc_b;
+  const T* a = internal::InputVector<T>(A, &buffer, &inc_a);
+  T* b = internal::OutputVector<T>(A.n_elems(), A.dimensions(), B, &inc_b);
+  internal::Blas<T>::Axpy(static_cast<int>(A.n_elems()),
+                          alpha,
+                          a,
+                          inc_a,
+                          b,
+                          inc_b);
+}
+
+/*
+ *  @name   Dot
+ *  @fn T Dot(const NDArray& a, const NDArray& b)
+ *  @brief  Compute the dot product between two vectors \p a and \p b
+ *  @param[in]  a  Vector A
+ *  @param[in]  b  Vector B
+ *  @return Dot product
+ */
+template<typename T>
+T LinearAlgebra<T>::Dot(const NDArray& a, const NDArray& b) {
+  assert(a.n_elems() == b.n_elems());
+  NDArray buffer_a, buffer_b;
+  int inc_a, inc_b;
+  const T* pa = internal::InputVector<T>(a, &buffer_a, &inc_a);
+  const T* pb = internal::InputVector<T>(b, &buffer_b, &inc_b);
+  return internal::Blas<T>::Dot(static_cast<int>(a.n_elems()),
+                                pa,
+                                inc_a,
+                                pb,
+                                inc_b);
+}
+
+/*
+ *  @name   Gemv
+ *  @fn void Gemv(const NDArray& A,
+                  const TransposeType trans_a,
+                  const T alpha,
+                  const NDArray& x,
+                  const T beta,
+                  NDArray* y)
+ *  @brief  Multiplies a matrix by a vector
+ *          Y = a * Ax + b Y
+ *  @param[in] A        Matrix A, rank-2
+ *  @param[in] trans_a  Indicate if A is transpose or not
+ *  @param[in] alpha    Scaling factor alpha
+ *  @param[in] x        Vector X
+ *  @param[in] beta     Scaling factor beta
+ *  @param[in,out] y    Output vector
+ */
+template<typename T>
+void LinearAlgebra<T>::Gemv(const NDArray& A,
+                            const TransposeType trans_a,
+                            const T alpha,
+                            const NDArray& x,
+                            const T beta,
+                            NDArray* y) {
+  assert(A.dims() == 2);
+  const bool trans = trans_a == TransposeType::kTranspose ||
+                     trans_a == TransposeType::kConjTranspose;
+  const size_t rows = A.dim_size(0);
+  const size_t cols = A.dim_size(1);
+  const size_t n_out = trans ? cols : rows;
+  assert(x.n_elems() == (trans ? rows : cols));
+  // Inputs
+  NDArray buffer_a, buffer_x;
+  bool flip;
+  int lda, inc_x, inc_y;
+  const T* a = internal::InputMatrix<T>(A, &buffer_a, &flip, &lda);
+  const T* px = internal::InputVector<T>(x, &buffer_x, &inc_x);
+  // Output
+  T* py = internal::OutputVector<T>(n_out, {n_out}, y, &inc_y);
+  // Transposed storage -> swap dimensions and flag
+  const int m = static_cast<int>(flip ? cols : rows);
+  const int n = static_cast<int>(flip ? rows : cols);
+  internal::Blas<T>::Gemv(internal::ToCblas(trans != flip),
+                          m,
+                          n,
+                          alpha,
+                          a,
+                          lda,
+                          px,
+                          inc_x,
+                          beta,
+                          py,
+                          inc_y);
+}
+
+/*
+ *  @name   Gemm
+ *  @fn void Gemm(const NDArray& A,
+                   const TransposeType trans_a,
+                   const T alpha,
+                   const NDArray& B,
+                   const TransposeType trans_b,
+                   const T beta,
+                   NDArray* C)
+ *  @brief  Compute the product between two matrices
+ *          C = a * AB + b * C
+ *  @param[in] A         Matrix A, rank-2
+ *  @param[in] trans_a   Transpose flag indicator for A
+ *  @param[in] alpha     Alpha coefficient
+ *  @param[in] B         Matrix B, rank-2
+ *  @param[in] trans_b   Transpose flag indicator for B
+ *  @param[in] beta      Beta coefficient
+ *  @param[in,out] C     Resulting matrix
+ */
+template<typename T>
+void LinearAlgebra<T>::Gemm(const NDArray& A,
+                            const TransposeType trans_a,
+                            const T alpha,
+                            const NDArray& B,
+                            const TransposeType trans_b,
+                            const T beta,
+                            NDArray* C) {
+  assert(A.dims() == 2 && B.dims() == 2);
+  const bool ta = trans_a == TransposeType::kTranspose ||
+                  trans_a == TransposeType::kConjTranspose;
+  const bool tb = trans_b == TransposeType::kTranspose ||
+                  trans_b == TransposeType::kConjTranspose;
+  const size_t m = ta ? A.dim_size(1) : A.dim_size(0);
+  const size_t k = ta ? A.dim_size(0) : A.dim_size(1);
+  const size_t n = tb ? B.dim_size(0) : B.dim_size(1);
+  assert(k == (tb ? B.dim_size(1) : B.dim_size(0)));
+  // Inputs
+  NDArray buffer_a, buffer_b;
+  bool flip_a, flip_b, flip_c = false;
+  int lda, ldb, ldc = static_cast<int>(std::max(n, size_t(1)));
+  const T* pa = internal::InputMatrix<T>(A, &buffer_a, &flip_a, &lda);
+  const T* pb = internal::InputMatrix<T>(B, &buffer_b, &flip_b, &ldb);
+  // Output, written in place if rows or columns are contiguous
+  const NDArrayDims dims = {m, n};
+  if (C->type() != DataTypeToEnum<T>::v() ||
+      C->dimensions() != dims ||
+      !internal::MatrixLayout(*C, &flip_c, &ldc)) {
+    C->Resize(DataTypeToEnum<T>::v(), dims);
+    flip_c = false;
+    ldc = static_cast<int>(std::max(n, size_t(1)));
+  }
+  // Writing may clone a shared buffer into a contiguous one
+  T* pc = internal::MutableData<T>(C);
+  internal::MatrixLayout(*C, &flip_c, &ldc);
+  if (!flip_c) {
+    internal::Blas<T>::Gemm(internal::ToCblas(ta != flip_a),
+                            internal::ToCblas(tb != flip_b),
+                            static_cast<int>(m),
+                            static_cast<int>(n),
+                            static_cast<int>(k),
+                            alpha, pa, lda, pb, ldb,
+                            beta, pc, ldc);
+  } else {
+    // C stored transposed, compute C' = op(B)' * op(A)'
+    internal::Blas<T>::Gemm(internal::ToCblas(tb == flip_b),
+                            internal::ToCblas(ta == flip_a),
+                            static_cast<int>(n),
+                            static_cast<int>(m),
+                            static_cast<int>(k),
+                            alpha, pb, ldb, pa, lda,
+                            beta, pc, ldc);
+  }
+}
+
+/*
+ * @name  Sbmv
+ * @fn    static void Sbmv(const NDArray& A, const T alpha, const NDArray& x,
+                           const T beta, NDArray* y)
+ * @brief Perform matrix-vector operation :  y := alpha*A*x + beta*y
+ *        Support only diagonal matrix, i.e. element-wise vector
+ *        multiplication
+ * @param[in] A       Vector of element on the matrix's diagonal
+ * @param[in] alpha   Scaling factor
+ * @param[in] x       Vector
+ * @param[in] beta    Scaling factor
+ * @param[in, out] y  Output
+ */
+template<typename T>
+void LinearAlgebra<T>::Sbmv(const NDArray& A,
+                            const T alpha,
+                            const NDArray& x,
+                            const T beta,
+                            NDArray* y) {
+  assert(A.n_elems() == x.n_elems());
+  NDArray buffer_a, buffer_x;
+  int inc_a, inc_x, inc_y;
+  const T* pa = internal::InputVector<T>(A, &buffer_a, &inc_a);
+  const T* px = internal::InputVector<T>(x, &buffer_x, &inc_x);
+  T* py = internal::OutputVector<T>(x.n_elems(), x.dimensions(), y, &inc_y);
+  // Diagonal band matrix, k = 0 -> element i at a[i * lda]
+  internal::Blas<T>::Sbmv(static_cast<int>(x.n_elems()),
+                          alpha,
+                          pa,
+                          inc_a,
+                          px,
+                          inc_x,
+                          beta,
+                          py,
+                          inc_y);
+}
+
 #pragma mark -
 #pragma mark LAPACK
   
@@ -710,6 +1735,12 @@ void LinearAlgebra<double>::Lapack::LinearSolverCall(lin_solver_params& p) {
  */
 template<typename T>
 LinearAlgebra<T>::LinearSolver::LinearSolver(void) {
+  p_.k_m = 0;
+  p_.k_n = 0;
+  p_.k_nrhs = 0;
+  p_.k_lda = 0;
+  p_.k_ldb = 0;
+  p_.k_lwork = 0;
   p_.k_a = nullptr;
   p_.k_b = nullptr;
   p_.k_work = nullptr;
@@ -851,12 +1882,95 @@ SquareLinearSolverCall(square_lin_solver_params& p) {
 }
   
 /*
- *  @name   SquareLinearSolver
- *  @fn SquareLinearSolver(void)
+ *  @name   SquareFactorCall
+ *  @fn inline void SquareFactorCall(square_lin_solver_params& p)
+ *  @brief  Interface for lapack LU factorization call (getrf), factors
+ *          are stored in place of `k_a`
+ *  @throw  std::runtime_error()
+ */
+template<typename T>
+void LinearAlgebra<T>::Lapack::
+SquareFactorCall(square_lin_solver_params& p) {
+  throw std::runtime_error("Error Unsupported Type");
+}
+
+template<>
+void LinearAlgebra<float>::Lapack::
+SquareFactorCall(square_lin_solver_params& p) {
+  sgetrf_(&p.k_n,
+          &p.k_n,
+          (lapack_flt*)p.k_a,
+          &p.k_lda,
+          (lapack_int*)p.k_ipiv,
+          &p.k_info);
+}
+
+template<>
+void LinearAlgebra<double>::Lapack::
+SquareFactorCall(square_lin_solver_params& p) {
+  dgetrf_(&p.k_n,
+          &p.k_n,
+          (lapack_dbl*)p.k_a,
+          &p.k_lda,
+          (lapack_int*)p.k_ipiv,
+          &p.k_info);
+}
+
+/*
+ *  @name   SquareSolveFactoredCall
+ *  @fn inline void SquareSolveFactoredCall(square_lin_solver_params& p)
+ *  @brief  Interface for lapack call solving with a previously computed
+ *          LU factorization (getrs)
+ *  @throw  std::runtime_error()
+ */
+template<typename T>
+void LinearAlgebra<T>::Lapack::
+SquareSolveFactoredCall(square_lin_solver_params& p) {
+  throw std::runtime_error("Error Unsupported Type");
+}
+
+template<>
+void LinearAlgebra<float>::Lapack::
+SquareSolveFactoredCall(square_lin_solver_params& p) {
+  char trans = 'N';
+  sgetrs_(&trans,
+          &p.k_n,
+          &p.k_nrhs,
+          (lapack_flt*)p.k_a,
+          &p.k_lda,
+          (lapack_int*)p.k_ipiv,
+          (lapack_flt*)p.k_b,
+          &p.k_ldb,
+          &p.k_info);
+}
+
+template<>
+void LinearAlgebra<double>::Lapack::
+SquareSolveFactoredCall(square_lin_solver_params& p) {
+  char trans = 'N';
+  dgetrs_(&trans,
+          &p.k_n,
+          &p.k_nrhs,
+          (lapack_dbl*)p.k_a,
+          &p.k_lda,
+          (lapack_int*)p.k_ipiv,
+          (lapack_dbl*)p.k_b,
+          &p.k_ldb,
+          &p.k_info);
+}
+  
+/*
+ *  @name   SquareLinearSolver
+ *  @fn SquareLinearSolver(void)
  *  @brief  Constructor
  */
 template<typename T>
-LinearAlgebra<T>::SquareLinearSolver::SquareLinearSolver(void) {
+LinearAlgebra<T>::SquareLinearSolver::SquareLinearSolver(void) :
+        factorized_(false) {
+  p_.k_n = 0;
+  p_.k_nrhs = 0;
+  p_.k_lda = 0;
+  p_.k_ldb = 0;
   p_.k_a = nullptr;
   p_.k_ipiv = nullptr;
   p_.k_b = nullptr;
@@ -897,24 +2011,7 @@ void LinearAlgebra<T>::SquareLinearSolver::Solve(const cv::Mat& A,
                                                  cv::Mat* x) {
   assert(A.rows == A.cols);
   // Init
-  if (p_.k_n != A.rows ||
-      p_.k_lda != A.rows ||
-      p_.k_nrhs != b.cols) {
-    // Release ressources if necessary
-    if (p_.k_a) { delete[] p_.k_a; }
-    if (p_.k_b) { delete[] p_.k_b; }
-    if (p_.k_ipiv) { delete[] p_.k_ipiv; }
-    // Define dimensions
-    p_.k_n = A.rows; //Column-major system
-    p_.k_lda = A.rows;
-    p_.k_nrhs = b.cols;
-    p_.k_ldb = p_.k_n;
-    // Init arrays
-    p_.k_a = new T[p_.k_n * p_.k_n];
-    p_.k_b = new T[p_.k_ldb * p_.k_nrhs];
-    p_.k_ipiv = new int[p_.k_n];
-  }
-  
+  this->Allocate(A.rows, b.cols);
   //Convert to column major memory layout for A
   cv::Mat tmp_a = cv::Mat(A.cols,
                           A.rows,
@@ -930,6 +2027,8 @@ void LinearAlgebra<T>::SquareLinearSolver::Solve(const cv::Mat& A,
   //Done, Solve the problem
   p_.k_info = 0;
   Lapack::SquareLinearSolverCall(p_);
+  // LU factors + pivots are left in place, can be reused by SolveFactored
+  factorized_ = p_.k_info == 0;
   // Retrieve results
   if (p_.k_info == 0) {
     cv::Mat buff(p_.k_nrhs, p_.k_ldb, cv::DataType<T>::type, p_.k_b);
@@ -939,8 +2038,938 @@ void LinearAlgebra<T>::SquareLinearSolver::Solve(const cv::Mat& A,
     *x = cv::Mat();
   }
 }
+
+/*
+ *  @name Factorize
+ *  @fn Status Factorize(const cv::Mat& A)
+ *  @brief  Compute and keep the LU decomposition of \p A, to be used by
+ *          subsequent calls to `SolveFactored`
+ *  @param[in]  A  Square matrix A
+ *  @return Status of the operation, error if A is singular
+ */
+template<typename T>
+Status LinearAlgebra<T>::SquareLinearSolver::Factorize(const cv::Mat& A) {
+  assert(A.rows == A.cols);
+  this->Allocate(A.rows, std::max(p_.k_nrhs, 1));
+  //Convert to column major memory layout for A
+  cv::Mat tmp_a = cv::Mat(A.cols,
+                          A.rows,
+                          cv::DataType<T>::type,
+                          p_.k_a);
+  tmp_a = A.t();
+  p_.k_info = 0;
+  Lapack::SquareFactorCall(p_);
+  factorized_ = p_.k_info == 0;
+  if (!factorized_) {
+    return Status(Status::Type::kInvalidArgument, "Matrix is singular");
+  }
+  return Status();
+}
+
+/*
+ *  @name SolveFactored
+ *  @fn Status SolveFactored(const cv::Mat& b, cv::Mat* x)
+ *  @brief  Solve Ax = B with the decomposition computed by the last call
+ *          to `Factorize` or `Solve`
+ *  @param[in]  b  Matrix B, stored in column
+ *  @param[out] x  Solution
+ *  @return Status of the operation
+ */
+template<typename T>
+Status LinearAlgebra<T>::SquareLinearSolver::SolveFactored(const cv::Mat& b,
+                                                           cv::Mat* x) {
+  if (!factorized_) {
+    return Status(Status::Type::kInvalidArgument,
+                  "No factorization available, call Factorize first");
+  }
+  if (b.rows != p_.k_n) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Right hand side does not match factorized system");
+  }
+  this->Allocate(p_.k_n, b.cols);
+  //Convert to column major memory layout for B
+  cv::Mat tmp_b = cv::Mat(b.cols,
+                          b.rows,
+                          cv::DataType<T>::type,
+                          p_.k_b);
+  tmp_b = b.t();
+  p_.k_info = 0;
+  Lapack::SquareSolveFactoredCall(p_);
+  if (p_.k_info != 0) {
+    *x = cv::Mat();
+    return Status(Status::Type::kInternalError, "Unable to solve system");
+  }
+  cv::Mat buff(p_.k_nrhs, p_.k_ldb, cv::DataType<T>::type, p_.k_b);
+  *x = buff.t();
+  return Status();
+}
+
+/*
+ *  @name Allocate
+ *  @fn void Allocate(const int& n, const int& nrhs)
+ *  @brief  Adapt buffers to a given system size, memory is reused when
+ *          dimensions do not change
+ *  @param[in] n    Number of equations
+ *  @param[in] nrhs Number of right hand side
+ */
+template<typename T>
+void LinearAlgebra<T>::SquareLinearSolver::Allocate(const int& n,
+                                                    const int& nrhs) {
+  if (p_.k_n != n) {
+    // Release ressources if necessary
+    if (p_.k_a) { delete[] p_.k_a; }
+    if (p_.k_ipiv) { delete[] p_.k_ipiv; }
+    // Define dimensions, column-major system
+    p_.k_n = n;
+    p_.k_lda = n;
+    p_.k_a = new T[n * n];
+    p_.k_ipiv = new int[n];
+    factorized_ = false;
+  }
+  if (p_.k_ldb != n || p_.k_nrhs != nrhs) {
+    if (p_.k_b) { delete[] p_.k_b; }
+    p_.k_nrhs = nrhs;
+    p_.k_ldb = n;
+    p_.k_b = new T[n * nrhs];
+  }
+}
+
+#pragma mark Cholesky Solver
+
+/*
+ *  @name   CholeskyFactorCall
+ *  @fn inline void CholeskyFactorCall(cholesky_solver_params& p)
+ *  @brief  Interface for lapack Cholesky factorization call (potrf),
+ *          factor is stored in place of `k_a`
+ *  @throw  std::runtime_error()
+ */
+template<typename T>
+void LinearAlgebra<T>::Lapack::
+CholeskyFactorCall(cholesky_solver_params& p) {
+  throw std::runtime_error("Error Unsupported Type");
+}
+
+template<>
+void LinearAlgebra<float>::Lapack::
+CholeskyFactorCall(cholesky_solver_params& p) {
+  spotrf_(&p.k_uplo,
+          &p.k_n,
+          (lapack_flt*)p.k_a,
+          &p.k_lda,
+          &p.k_info);
+}
+
+template<>
+void LinearAlgebra<double>::Lapack::
+CholeskyFactorCall(cholesky_solver_params& p) {
+  dpotrf_(&p.k_uplo,
+          &p.k_n,
+          (lapack_dbl*)p.k_a,
+          &p.k_lda,
+          &p.k_info);
+}
+
+/*
+ *  @name   CholeskySolveFactoredCall
+ *  @fn inline void CholeskySolveFactoredCall(cholesky_solver_params& p)
+ *  @brief  Interface for lapack call solving with a previously computed
+ *          Cholesky factorization (potrs)
+ *  @throw  std::runtime_error()
+ */
+template<typename T>
+void LinearAlgebra<T>::Lapack::
+CholeskySolveFactoredCall(cholesky_solver_params& p) {
+  throw std::runtime_error("Error Unsupported Type");
+}
+
+template<>
+void LinearAlgebra<float>::Lapack::
+CholeskySolveFactoredCall(cholesky_solver_params& p) {
+  spotrs_(&p.k_uplo,
+          &p.k_n,
+          &p.k_nrhs,
+          (lapack_flt*)p.k_a,
+          &p.k_lda,
+          (lapack_flt*)p.k_b,
+          &p.k_ldb,
+          &p.k_info);
+}
+
+template<>
+void LinearAlgebra<double>::Lapack::
+CholeskySolveFactoredCall(cholesky_solver_params& p) {
+  dpotrs_(&p.k_uplo,
+          &p.k_n,
+          &p.k_nrhs,
+          (lapack_dbl*)p.k_a,
+          &p.k_lda,
+          (lapack_dbl*)p.k_b,
+          &p.k_ldb,
+          &p.k_info);
+}
+
+/*
+ *  @name   CholeskySolver
+ *  @fn CholeskySolver(void)
+ *  @brief  Constructor
+ */
+template<typename T>
+LinearAlgebra<T>::CholeskySolver::CholeskySolver(void) : factorized_(false) {
+  p_.k_uplo = 'L';
+  p_.k_n = 0;
+  p_.k_nrhs = 0;
+  p_.k_lda = 0;
+  p_.k_ldb = 0;
+  p_.k_a = nullptr;
+  p_.k_b = nullptr;
+}
+
+/*
+ *  @name   ~CholeskySolver
+ *  @fn ~CholeskySolver(void)
+ *  @brief  Destructor
+ */
+template<typename T>
+LinearAlgebra<T>::CholeskySolver::~CholeskySolver(void) {
+  if (p_.k_a) {
+    delete[] p_.k_a;
+    p_.k_a = nullptr;
+  }
+  if (p_.k_b) {
+    delete[] p_.k_b;
+    p_.k_b = nullptr;
+  }
+}
+
+/*
+ *  @name Solve
+ *  @fn void Solve(const cv::Mat& A, const cv::Mat& b, cv::Mat* x)
+ *  @brief  Solve Ax = B, \p x is empty if A is not positive definite
+ *  @param[in]  A  Symmetric positive definite matrix A
+ *  @param[in]  b  Matrix B, stored in column
+ *  @param[out] x  Solution
+ */
+template<typename T>
+void LinearAlgebra<T>::CholeskySolver::Solve(const cv::Mat& A,
+                                             const cv::Mat& b,
+                                             cv::Mat* x) {
+  Status s = this->Factorize(A);
+  if (s.Good()) {
+    s = this->SolveFactored(b, x);
+  }
+  if (!s.Good()) {
+    FACEKIT_LOG_INFO("Solver can not find a solution to the provided system");
+    *x = cv::Mat();
+  }
+}
+
+/*
+ *  @name Factorize
+ *  @fn Status Factorize(const cv::Mat& A)
+ *  @brief  Compute and keep the Cholesky decomposition of \p A, to be
+ *          used by subsequent calls to `SolveFactored`
+ *  @param[in]  A  Symmetric positive definite matrix A
+ *  @return Status of the operation, error if A is not positive definite
+ */
+template<typename T>
+Status LinearAlgebra<T>::CholeskySolver::Factorize(const cv::Mat& A) {
+  assert(A.rows == A.cols);
+  this->Allocate(A.rows, std::max(p_.k_nrhs, 1));
+  // A is symmetric, row and column major layout are identical
+  cv::Mat tmp_a(A.rows, A.cols, cv::DataType<T>::type, p_.k_a);
+  A.copyTo(tmp_a);
+  p_.k_info = 0;
+  Lapack::CholeskyFactorCall(p_);
+  factorized_ = p_.k_info == 0;
+  if (!factorized_) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Matrix is not positive definite");
+  }
+  return Status();
+}
+
+/*
+ *  @name SolveFactored
+ *  @fn Status SolveFactored(const cv::Mat& b, cv::Mat* x)
+ *  @brief  Solve Ax = B with the decomposition computed by the last call
+ *          to `Factorize` or `Solve`
+ *  @param[in]  b  Matrix B, stored in column
+ *  @param[out] x  Solution
+ *  @return Status of the operation
+ */
+template<typename T>
+Status LinearAlgebra<T>::CholeskySolver::SolveFactored(const cv::Mat& b,
+                                                       cv::Mat* x) {
+  if (!factorized_) {
+    return Status(Status::Type::kInvalidArgument,
+                  "No factorization available, call Factorize first");
+  }
+  if (b.rows != p_.k_n) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Right hand side does not match factorized system");
+  }
+  this->Allocate(p_.k_n, b.cols);
+  //Convert to column major memory layout for B
+  cv::Mat tmp_b = cv::Mat(b.cols,
+                          b.rows,
+                          cv::DataType<T>::type,
+                          p_.k_b);
+  tmp_b = b.t();
+  p_.k_info = 0;
+  Lapack::CholeskySolveFactoredCall(p_);
+  if (p_.k_info != 0) {
+    *x = cv::Mat();
+    return Status(Status::Type::kInternalError, "Unable to solve system");
+  }
+  cv::Mat buff(p_.k_nrhs, p_.k_ldb, cv::DataType<T>::type, p_.k_b);
+  *x = buff.t();
+  return Status();
+}
+
+/*
+ *  @name Allocate
+ *  @fn void Allocate(const int& n, const int& nrhs)
+ *  @brief  Adapt buffers to a given system size, memory is reused when
+ *          dimensions do not change
+ *  @param[in] n    Number of equations
+ *  @param[in] nrhs Number of right hand side
+ */
+template<typename T>
+void LinearAlgebra<T>::CholeskySolver::Allocate(const int& n,
+                                                const int& nrhs) {
+  if (p_.k_n != n) {
+    if (p_.k_a) { delete[] p_.k_a; }
+    p_.k_n = n;
+    p_.k_lda = n;
+    p_.k_a = new T[n * n];
+    factorized_ = false;
+  }
+  if (p_.k_ldb != n || p_.k_nrhs != nrhs) {
+    if (p_.k_b) { delete[] p_.k_b; }
+    p_.k_nrhs = nrhs;
+    p_.k_ldb = n;
+    p_.k_b = new T[n * nrhs];
+  }
+}
   
   
+#pragma mark Decompositions
+
+/*
+ *  @name   SvdCall
+ *  @fn inline void SvdCall(svd_params& p)
+ *  @brief  Interface for lapack divide and conquer SVD call (gesdd)
+ *  @throw  std::runtime_error()
+ */
+template<typename T>
+void LinearAlgebra<T>::Lapack::SvdCall(svd_params& p) {
+  throw std::runtime_error("Error Unsupported Type");
+}
+
+template<>
+void LinearAlgebra<float>::Lapack::SvdCall(svd_params& p) {
+  sgesdd_(&p.k_jobz,
+          &p.k_m,
+          &p.k_n,
+          (lapack_flt*)p.k_a,
+          &p.k_lda,
+          (lapack_flt*)p.k_s,
+          (lapack_flt*)p.k_u,
+          &p.k_ldu,
+          (lapack_flt*)p.k_vt,
+          &p.k_ldvt,
+          (lapack_flt*)p.k_work,
+          &p.k_lwork,
+          (lapack_int*)p.k_iwork,
+          &p.k_info);
+}
+
+template<>
+void LinearAlgebra<double>::Lapack::SvdCall(svd_params& p) {
+  dgesdd_(&p.k_jobz,
+          &p.k_m,
+          &p.k_n,
+          (lapack_dbl*)p.k_a,
+          &p.k_lda,
+          (lapack_dbl*)p.k_s,
+          (lapack_dbl*)p.k_u,
+          &p.k_ldu,
+          (lapack_dbl*)p.k_vt,
+          &p.k_ldvt,
+          (lapack_dbl*)p.k_work,
+          &p.k_lwork,
+          (lapack_int*)p.k_iwork,
+          &p.k_info);
+}
+
+/*
+ *  @name   SymEigCall
+ *  @fn inline void SymEigCall(sym_eig_params& p)
+ *  @brief  Interface for lapack symmetric eigen decomposition call
+ *          (syevr)
+ *  @throw  std::runtime_error()
+ */
+template<typename T>
+void LinearAlgebra<T>::Lapack::SymEigCall(sym_eig_params& p) {
+  throw std::runtime_error("Error Unsupported Type");
+}
+
+template<>
+void LinearAlgebra<float>::Lapack::SymEigCall(sym_eig_params& p) {
+  ssyevr_(&p.k_jobz,
+          &p.k_range,
+          &p.k_uplo,
+          &p.k_n,
+          (lapack_flt*)p.k_a,
+          &p.k_lda,
+          (lapack_flt*)&p.k_vl,
+          (lapack_flt*)&p.k_vu,
+          &p.k_il,
+          &p.k_iu,
+          (lapack_flt*)&p.k_abstol,
+          &p.k_found,
+          (lapack_flt*)p.k_w,
+          (lapack_flt*)p.k_z,
+          &p.k_ldz,
+          (lapack_int*)p.k_isuppz,
+          (lapack_flt*)p.k_work,
+          &p.k_lwork,
+          (lapack_int*)p.k_iwork,
+          &p.k_liwork,
+          &p.k_info);
+}
+
+template<>
+void LinearAlgebra<double>::Lapack::SymEigCall(sym_eig_params& p) {
+  dsyevr_(&p.k_jobz,
+          &p.k_range,
+          &p.k_uplo,
+          &p.k_n,
+          (lapack_dbl*)p.k_a,
+          &p.k_lda,
+          (lapack_dbl*)&p.k_vl,
+          (lapack_dbl*)&p.k_vu,
+          &p.k_il,
+          &p.k_iu,
+          (lapack_dbl*)&p.k_abstol,
+          &p.k_found,
+          (lapack_dbl*)p.k_w,
+          (lapack_dbl*)p.k_z,
+          &p.k_ldz,
+          (lapack_int*)p.k_isuppz,
+          (lapack_dbl*)p.k_work,
+          &p.k_lwork,
+          (lapack_int*)p.k_iwork,
+          &p.k_liwork,
+          &p.k_info);
+}
+
+/*
+ *  @name   QrCall
+ *  @fn inline void QrCall(qr_params& p)
+ *  @brief  Interface for lapack QR factorization call (geqrf)
+ *  @throw  std::runtime_error()
+ */
+template<typename T>
+void LinearAlgebra<T>::Lapack::QrCall(qr_params& p) {
+  throw std::runtime_error("Error Unsupported Type");
+}
+
+template<>
+void LinearAlgebra<float>::Lapack::QrCall(qr_params& p) {
+  sgeqrf_(&p.k_m,
+          &p.k_n,
+          (lapack_flt*)p.k_a,
+          &p.k_lda,
+          (lapack_flt*)p.k_tau,
+          (lapack_flt*)p.k_work,
+          &p.k_lwork,
+          &p.k_info);
+}
+
+template<>
+void LinearAlgebra<double>::Lapack::QrCall(qr_params& p) {
+  dgeqrf_(&p.k_m,
+          &p.k_n,
+          (lapack_dbl*)p.k_a,
+          &p.k_lda,
+          (lapack_dbl*)p.k_tau,
+          (lapack_dbl*)p.k_work,
+          &p.k_lwork,
+          &p.k_info);
+}
+
+/*
+ *  @name   QrFormQCall
+ *  @fn inline void QrFormQCall(qr_params& p)
+ *  @brief  Interface for lapack call generating Q from the reflectors
+ *          computed by `QrCall` (orgqr)
+ *  @throw  std::runtime_error()
+ */
+template<typename T>
+void LinearAlgebra<T>::Lapack::QrFormQCall(qr_params& p) {
+  throw std::runtime_error("Error Unsupported Type");
+}
+
+template<>
+void LinearAlgebra<float>::Lapack::QrFormQCall(qr_params& p) {
+  sorgqr_(&p.k_m,
+          &p.k_n,
+          &p.k_k,
+          (lapack_flt*)p.k_a,
+          &p.k_lda,
+          (lapack_flt*)p.k_tau,
+          (lapack_flt*)p.k_work,
+          &p.k_lwork,
+          &p.k_info);
+}
+
+template<>
+void LinearAlgebra<double>::Lapack::QrFormQCall(qr_params& p) {
+  dorgqr_(&p.k_m,
+          &p.k_n,
+          &p.k_k,
+          (lapack_dbl*)p.k_a,
+          &p.k_lda,
+          (lapack_dbl*)p.k_tau,
+          (lapack_dbl*)p.k_work,
+          &p.k_lwork,
+          &p.k_info);
+}
+
+/*
+ *  @name   QR
+ *  @fn QR(void)
+ *  @brief  Constructor
+ */
+template<typename T>
+LinearAlgebra<T>::QR::QR(void) {
+  p_.k_m = 0;
+  p_.k_n = 0;
+  p_.k_k = 0;
+  p_.k_lda = 0;
+  p_.k_lwork = 0;
+  p_.k_a = nullptr;
+  p_.k_tau = nullptr;
+  p_.k_work = nullptr;
+}
+
+/*
+ *  @name   ~QR
+ *  @fn ~QR(void)
+ *  @brief  Destructor
+ */
+template<typename T>
+LinearAlgebra<T>::QR::~QR(void) {
+  if (p_.k_a) {
+    delete[] p_.k_a;
+  }
+  if (p_.k_tau) {
+    delete[] p_.k_tau;
+  }
+  if (p_.k_work) {
+    delete[] p_.k_work;
+  }
+}
+
+/*
+ *  @name Compute
+ *  @fn Status Compute(const cv::Mat& A, cv::Mat* Q, cv::Mat* R)
+ *  @brief  Decompose \p A [m x n], m >= n
+ *  @param[in]  A  Matrix to decompose
+ *  @param[out] Q  Matrix with orthonormal columns [m x n]
+ *  @param[out] R  Upper triangular matrix [n x n], can be nullptr
+ *  @return Status of the operation
+ */
+template<typename T>
+Status LinearAlgebra<T>::QR::Compute(const cv::Mat& A, cv::Mat* Q, cv::Mat* R) {
+  assert(A.type() == cv::DataType<T>::type);
+  if (A.rows < A.cols) {
+    return Status(Status::Type::kInvalidArgument,
+                  "QR needs at least as many rows as columns");
+  }
+  if (p_.k_m != A.rows || p_.k_n != A.cols) {
+    // Release ressources if necessary
+    if (p_.k_a) { delete[] p_.k_a; }
+    if (p_.k_tau) { delete[] p_.k_tau; }
+    if (p_.k_work) { delete[] p_.k_work; }
+    // Define dimensions, column-major system
+    p_.k_m = A.rows;
+    p_.k_n = A.cols;
+    p_.k_k = A.cols;
+    p_.k_lda = A.rows;
+    p_.k_a = new T[p_.k_m * p_.k_n];
+    p_.k_tau = new T[p_.k_n];
+    // Query workspace size, shared by both calls
+    T wsize = T(0.0);
+    p_.k_work = &wsize;
+    p_.k_lwork = -1;
+    Lapack::QrCall(p_);
+    int lwork = static_cast<int>(wsize);
+    Lapack::QrFormQCall(p_);
+    lwork = std::max(lwork, static_cast<int>(wsize));
+    p_.k_lwork = std::max(lwork, 1);
+    p_.k_work = new T[p_.k_lwork];
+  }
+  //Convert to column major memory layout for A
+  cv::Mat tmp_a = cv::Mat(A.cols, A.rows, cv::DataType<T>::type, p_.k_a);
+  tmp_a = A.t();
+  p_.k_info = 0;
+  Lapack::QrCall(p_);
+  if (p_.k_info != 0) {
+    return Status(Status::Type::kInternalError, "QR factorization failed");
+  }
+  // Extract R, upper triangle of column major A
+  if (R) {
+    R->create(p_.k_n, p_.k_n, cv::DataType<T>::type);
+    for (int i = 0; i < p_.k_n; ++i) {
+      T* row = R->ptr<T>(i);
+      for (int j = 0; j < p_.k_n; ++j) {
+        row[j] = j >= i ? p_.k_a[j * p_.k_lda + i] : T(0.0);
+      }
+    }
+  }
+  // Form Q
+  Lapack::QrFormQCall(p_);
+  if (p_.k_info != 0) {
+    return Status(Status::Type::kInternalError, "QR, can not form Q");
+  }
+  cv::Mat buff(p_.k_n, p_.k_m, cv::DataType<T>::type, p_.k_a);
+  *Q = buff.t();
+  return Status();
+}
+
+/*
+ *  @name   SVD
+ *  @fn SVD(void)
+ *  @brief  Constructor
+ */
+template<typename T>
+LinearAlgebra<T>::SVD::SVD(void) {
+  p_.k_jobz = 'S';
+  p_.k_m = 0;
+  p_.k_n = 0;
+  p_.k_lda = 0;
+  p_.k_ldu = 0;
+  p_.k_ldvt = 0;
+  p_.k_lwork = 0;
+  p_.k_a = nullptr;
+  p_.k_s = nullptr;
+  p_.k_u = nullptr;
+  p_.k_vt = nullptr;
+  p_.k_work = nullptr;
+  p_.k_iwork = nullptr;
+}
+
+/*
+ *  @name   ~SVD
+ *  @fn ~SVD(void)
+ *  @brief  Destructor
+ */
+template<typename T>
+LinearAlgebra<T>::SVD::~SVD(void) {
+  if (p_.k_a) {
+    delete[] p_.k_a;
+  }
+  if (p_.k_s) {
+    delete[] p_.k_s;
+  }
+  if (p_.k_u) {
+    delete[] p_.k_u;
+  }
+  if (p_.k_vt) {
+    delete[] p_.k_vt;
+  }
+  if (p_.k_work) {
+    delete[] p_.k_work;
+  }
+  if (p_.k_iwork) {
+    delete[] p_.k_iwork;
+  }
+}
+
+/*
+ *  @name Compute
+ *  @fn Status Compute(const cv::Mat& A, cv::Mat* U, cv::Mat* S,
+                       cv::Mat* Vt)
+ *  @brief  Thin decomposition of \p A [m x n], with k = min(m, n)
+ *  @param[in]  A   Matrix to decompose
+ *  @param[out] U   Left singular vectors, stored in column [m x k]
+ *  @param[out] S   Singular values, descending order [k x 1]
+ *  @param[out] Vt  Right singular vectors, stored in row [k x n]
+ *  @return Status of the operation
+ */
+template<typename T>
+Status LinearAlgebra<T>::SVD::Compute(const cv::Mat& A,
+                                      cv::Mat* U,
+                                      cv::Mat* S,
+                                      cv::Mat* Vt) {
+  assert(A.type() == cv::DataType<T>::type);
+  // Row major A is seen as column major A', decompose A' = V S U' instead,
+  // then U' and V' come out already in row major order
+  const int k = std::min(A.rows, A.cols);
+  if (p_.k_m != A.cols || p_.k_n != A.rows) {
+    // Release ressources if necessary
+    if (p_.k_a) { delete[] p_.k_a; }
+    if (p_.k_s) { delete[] p_.k_s; }
+    if (p_.k_u) { delete[] p_.k_u; }
+    if (p_.k_vt) { delete[] p_.k_vt; }
+    if (p_.k_work) { delete[] p_.k_work; }
+    if (p_.k_iwork) { delete[] p_.k_iwork; }
+    // Define dimensions
+    p_.k_m = A.cols;
+    p_.k_n = A.rows;
+    p_.k_lda = p_.k_m;
+    p_.k_ldu = p_.k_m;
+    p_.k_ldvt = k;
+    p_.k_a = new T[p_.k_m * p_.k_n];
+    p_.k_s = new T[k];
+    p_.k_u = new T[p_.k_ldu * k];
+    p_.k_vt = new T[p_.k_ldvt * p_.k_n];
+    p_.k_iwork = new int[8 * k];
+    // Query workspace size
+    T wsize = T(0.0);
+    p_.k_work = &wsize;
+    p_.k_lwork = -1;
+    Lapack::SvdCall(p_);
+    p_.k_lwork = std::max(static_cast<int>(wsize), 1);
+    p_.k_work = new T[p_.k_lwork];
+  }
+  cv::Mat tmp_a(A.rows, A.cols, cv::DataType<T>::type, p_.k_a);
+  A.copyTo(tmp_a);
+  p_.k_info = 0;
+  Lapack::SvdCall(p_);
+  if (p_.k_info != 0) {
+    return Status(Status::Type::kInternalError, "SVD did not converge");
+  }
+  cv::Mat(k, 1, cv::DataType<T>::type, p_.k_s).copyTo(*S);
+  if (U) {
+    cv::Mat(A.rows, k, cv::DataType<T>::type, p_.k_vt).copyTo(*U);
+  }
+  if (Vt) {
+    cv::Mat(k, A.cols, cv::DataType<T>::type, p_.k_u).copyTo(*Vt);
+  }
+  return Status();
+}
+
+/*
+ *  @name Truncated
+ *  @fn Status Truncated(const cv::Mat& A, const int rank,
+                         const int oversampling, const int n_iter,
+                         cv::Mat* U, cv::Mat* S, cv::Mat* Vt)
+ *  @brief  Approximate the \p rank leading singular triplets of \p A
+ *          with a randomized range finder (Halko et al.). Only products
+ *          with \p A and small dense decompositions are needed, which
+ *          suits tall data matrices.
+ *  @param[in]  A             Matrix to decompose [m x n]
+ *  @param[in]  rank          Number of singular triplets wanted
+ *  @param[in]  oversampling  Extra random samples, improves accuracy
+ *  @param[in]  n_iter        Number of power iterations, improves
+ *                            accuracy when the spectrum decays slowly
+ *  @param[out] U   Left singular vectors, stored in column [m x rank]
+ *  @param[out] S   Singular values, descending order [rank x 1]
+ *  @param[out] Vt  Right singular vectors, stored in row [rank x n]
+ *  @return Status of the operation
+ */
+template<typename T>
+Status LinearAlgebra<T>::SVD::Truncated(const cv::Mat& A,
+                                        const int rank,
+                                        const int oversampling,
+                                        const int n_iter,
+                                        cv::Mat* U,
+                                        cv::Mat* S,
+                                        cv::Mat* Vt) {
+  using TType = typename LinearAlgebra<T>::TransposeType;
+  assert(A.type() == cv::DataType<T>::type);
+  const int k = std::min(A.rows, A.cols);
+  if (rank <= 0 || rank > k || oversampling < 0) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Rank must be in [1, min(rows, cols)]");
+  }
+  const int l = std::min(rank + oversampling, k);
+  // Gaussian test matrix, fixed seed for reproducible models
+  std::mt19937 gen(0x5EED);
+  std::normal_distribution<T> dist(T(0.0), T(1.0));
+  cv::Mat omega(A.cols, l, cv::DataType<T>::type);
+  T* ptr = omega.ptr<T>(0);
+  for (int i = 0; i < A.cols * l; ++i) {
+    ptr[i] = dist(gen);
+  }
+  // Sample range of A, orthonormalize between power iterations
+  Status s;
+  QR qr_m, qr_n;
+  cv::Mat Y, Z, Q;
+  LinearAlgebra<T>::Gemm(A, TType::kNoTranspose, T(1.0),
+                         omega, TType::kNoTranspose, T(0.0), &Y);
+  s = qr_m.Compute(Y, &Q, nullptr);
+  for (int it = 0; it < n_iter && s.Good(); ++it) {
+    LinearAlgebra<T>::Gemm(A, TType::kTranspose, T(1.0),
+                           Q, TType::kNoTranspose, T(0.0), &Z);
+    s = qr_n.Compute(Z, &Q, nullptr);
+    if (s.Good()) {
+      LinearAlgebra<T>::Gemm(A, TType::kNoTranspose, T(1.0),
+                             Q, TType::kNoTranspose, T(0.0), &Y);
+      s = qr_m.Compute(Y, &Q, nullptr);
+    }
+  }
+  if (!s.Good()) {
+    return s;
+  }
+  // Project onto range, B = Q'A [l x n], and decompose the small problem
+  cv::Mat B, Ub;
+  LinearAlgebra<T>::Gemm(Q, TType::kTranspose, T(1.0),
+                         A, TType::kNoTranspose, T(0.0), &B);
+  s = this->Compute(B, &Ub, S, Vt);
+  if (!s.Good()) {
+    return s;
+  }
+  // Lift back + keep leading triplets
+  if (U) {
+    cv::Mat ub = Ub.colRange(0, rank).clone();
+    LinearAlgebra<T>::Gemm(Q, TType::kNoTranspose, T(1.0),
+                           ub, TType::kNoTranspose, T(0.0), U);
+  }
+  *S = S->rowRange(0, rank).clone();
+  if (Vt) {
+    *Vt = Vt->rowRange(0, rank).clone();
+  }
+  return Status();
+}
+
+/*
+ *  @name   SymmetricEigen
+ *  @fn SymmetricEigen(void)
+ *  @brief  Constructor
+ */
+template<typename T>
+LinearAlgebra<T>::SymmetricEigen::SymmetricEigen(void) {
+  p_.k_jobz = 'V';
+  p_.k_range = 'A';
+  p_.k_uplo = 'L';
+  p_.k_n = 0;
+  p_.k_lda = 0;
+  p_.k_vl = T(0.0);
+  p_.k_vu = T(0.0);
+  p_.k_il = 0;
+  p_.k_iu = 0;
+  p_.k_abstol = T(0.0);
+  p_.k_ldz = 0;
+  p_.k_lwork = 0;
+  p_.k_liwork = 0;
+  p_.k_a = nullptr;
+  p_.k_w = nullptr;
+  p_.k_z = nullptr;
+  p_.k_isuppz = nullptr;
+  p_.k_work = nullptr;
+  p_.k_iwork = nullptr;
+}
+
+/*
+ *  @name   ~SymmetricEigen
+ *  @fn ~SymmetricEigen(void)
+ *  @brief  Destructor
+ */
+template<typename T>
+LinearAlgebra<T>::SymmetricEigen::~SymmetricEigen(void) {
+  if (p_.k_a) {
+    delete[] p_.k_a;
+  }
+  if (p_.k_w) {
+    delete[] p_.k_w;
+  }
+  if (p_.k_z) {
+    delete[] p_.k_z;
+  }
+  if (p_.k_isuppz) {
+    delete[] p_.k_isuppz;
+  }
+  if (p_.k_work) {
+    delete[] p_.k_work;
+  }
+  if (p_.k_iwork) {
+    delete[] p_.k_iwork;
+  }
+}
+
+/*
+ *  @name Compute
+ *  @fn Status Compute(const cv::Mat& A, cv::Mat* values,
+                       cv::Mat* vectors)
+ *  @brief  Decompose symmetric \p A [n x n], same convention as
+ *          `cv::eigen`
+ *  @param[in]  A       Symmetric matrix
+ *  @param[out] values  Eigenvalues, descending order [n x 1]
+ *  @param[out] vectors Eigenvectors, stored in row [n x n], can be
+ *                      nullptr
+ *  @return Status of the operation
+ */
+template<typename T>
+Status LinearAlgebra<T>::SymmetricEigen::Compute(const cv::Mat& A,
+                                                 cv::Mat* values,
+                                                 cv::Mat* vectors) {
+  assert(A.type() == cv::DataType<T>::type);
+  if (A.rows != A.cols) {
+    return Status(Status::Type::kInvalidArgument, "Matrix must be square");
+  }
+  const char jobz = vectors ? 'V' : 'N';
+  if (p_.k_n != A.rows || p_.k_jobz != jobz) {
+    // Release ressources if necessary
+    if (p_.k_a) { delete[] p_.k_a; }
+    if (p_.k_w) { delete[] p_.k_w; }
+    if (p_.k_z) { delete[] p_.k_z; }
+    if (p_.k_isuppz) { delete[] p_.k_isuppz; }
+    if (p_.k_work) { delete[] p_.k_work; }
+    if (p_.k_iwork) { delete[] p_.k_iwork; }
+    // Define dimensions
+    p_.k_jobz = jobz;
+    p_.k_n = A.rows;
+    p_.k_lda = p_.k_n;
+    p_.k_ldz = p_.k_n;
+    p_.k_a = new T[p_.k_n * p_.k_n];
+    p_.k_w = new T[p_.k_n];
+    p_.k_z = new T[p_.k_n * p_.k_n];
+    p_.k_isuppz = new int[2 * p_.k_n];
+    // Query workspace sizes
+    T wsize = T(0.0);
+    int iwsize = 0;
+    p_.k_work = &wsize;
+    p_.k_iwork = &iwsize;
+    p_.k_lwork = -1;
+    p_.k_liwork = -1;
+    Lapack::SymEigCall(p_);
+    p_.k_lwork = std::max(static_cast<int>(wsize), 1);
+    p_.k_liwork = std::max(iwsize, 1);
+    p_.k_work = new T[p_.k_lwork];
+    p_.k_iwork = new int[p_.k_liwork];
+  }
+  // A is symmetric, row and column major layout are identical
+  cv::Mat tmp_a(A.rows, A.cols, cv::DataType<T>::type, p_.k_a);
+  A.copyTo(tmp_a);
+  p_.k_info = 0;
+  Lapack::SymEigCall(p_);
+  if (p_.k_info != 0) {
+    return Status(Status::Type::kInternalError,
+                  "Eigen decomposition did not converge");
+  }
+  // Lapack gives ascending order, flip to match cv::eigen
+  const int n = p_.k_n;
+  values->create(n, 1, cv::DataType<T>::type);
+  T* v_ptr = values->ptr<T>(0);
+  for (int i = 0; i < n; ++i) {
+    v_ptr[i] = p_.k_w[n - 1 - i];
+  }
+  if (vectors) {
+    vectors->create(n, n, cv::DataType<T>::type);
+    for (int i = 0; i < n; ++i) {
+      std::memcpy(reinterpret_cast<void*>(vectors->ptr<T>(i)),
+                  reinterpret_cast<const void*>(&p_.k_z[(n - 1 - i) * n]),
+                  n * sizeof(T));
+    }
+  }
+  return Status();
+}
+
+  
 #pragma mark -
 #pragma mark Explicit Instantiation
   
@@ -0,0 +1,362 @@
+/**
+ *  @file   log_sink.cpp
+ *  @brief  Logger's output destinations: plain text, JSON lines, compact
+ *          binary records and size based rotating files
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   05.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#if defined(__APPLE__) || defined(__linux__)
+#define IS_POSIX
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "facekit/core/log_sink.hpp"
+#include "facekit/core/sys/file_system.hpp"
+#include "facekit/core/sys/file_system_factory.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Level names without color codes */
+static constexpr const char* kLevelName[] = {"ERROR",
+                                             "WARNING",
+                                             "INFO",
+                                             "DEBUG",
+                                             "DEBUG1",
+                                             "DEBUG2"};
+
+/**
+ *  @name   WriteJsonString
+ *  @fn     static void WriteJsonString(std::ostream& stream, const char* str,
+                                        const size_t& n)
+ *  @brief  Write a quoted and escaped JSON string
+ *  @param[in] stream Output stream
+ *  @param[in] str    String to write
+ *  @param[in] n      String length
+ */
+static void WriteJsonString(std::ostream& stream,
+                            const char* str,
+                            const size_t& n) {
+  stream << '"';
+  for (size_t k = 0; k < n; ++k) {
+    const char c = str[k];
+    switch (c) {
+      case '"': stream << "\\\"";
+        break;
+      case '\\': stream << "\\\\";
+        break;
+      case '\n': stream << "\\n";
+        break;
+      case '\r': stream << "\\r";
+        break;
+      case '\t': stream << "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char esc[7];
+          std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+          stream << esc;
+        } else {
+          stream << c;
+        }
+    }
+  }
+  stream << '"';
+}
+
+/**
+ *  @name   Append
+ *  @fn     static void Append(std::string* buffer, const T& value)
+ *  @brief  Append raw bytes of a value
+ *  @tparam T Value type
+ */
+template<typename T>
+static void Append(std::string* buffer, const T& value) {
+  buffer->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/**
+ *  @name   Extract
+ *  @fn     static bool Extract(const std::string& buffer, size_t* pos,
+                                T* value)
+ *  @brief  Read raw bytes of a value
+ *  @return False if buffer is too short
+ *  @tparam T Value type
+ */
+template<typename T>
+static bool Extract(const std::string& buffer, size_t* pos, T* value) {
+  if (buffer.size() - *pos < sizeof(T)) {
+    return false;
+  }
+  std::memcpy(value, &buffer[*pos], sizeof(T));
+  *pos += sizeof(T);
+  return true;
+}
+
+#pragma mark -
+#pragma mark Text
+
+/*
+ *  @name   Write
+ *  @fn     void Write(const Logger::Record& record) override
+ *  @brief  Write a single record
+ *  @param[in] record  Record to write
+ */
+void StreamLogSink::Write(const Logger::Record& record) {
+  const int lvl = record.level;
+  stream_ << record.file << ":" << record.line << ": ";
+  stream_ << Logger::LvlToStr[lvl] << " : ";
+  stream_ << std::string(lvl > Logger::kDebug ? lvl - Logger::kDebug : 0,
+                         '\t');
+  stream_ << record.message << '\n';
+}
+
+/*
+ *  @name   Flush
+ *  @fn     void Flush(void) override
+ *  @brief  Flush underlying stream
+ */
+void StreamLogSink::Flush(void) {
+  stream_.flush();
+}
+
+#pragma mark -
+#pragma mark JSON
+
+/*
+ *  @name   Write
+ *  @fn     void Write(const Logger::Record& record) override
+ *  @brief  Write a single record
+ *  @param[in] record  Record to write
+ */
+void JsonLogSink::Write(const Logger::Record& record) {
+  stream_ << "{\"level\":\"" << kLevelName[record.level] << "\",\"ts\":";
+  stream_ << record.timestamp << ",\"tid\":" << record.thread_id;
+  stream_ << ",\"file\":";
+  WriteJsonString(stream_, record.file, std::strlen(record.file));
+  stream_ << ",\"line\":" << record.line << ",\"msg\":";
+  WriteJsonString(stream_, record.message.data(), record.message.size());
+  stream_ << "}\n";
+}
+
+/*
+ *  @name   Flush
+ *  @fn     void Flush(void) override
+ *  @brief  Flush underlying stream
+ */
+void JsonLogSink::Flush(void) {
+  stream_.flush();
+}
+
+#pragma mark -
+#pragma mark Binary
+
+/*
+ *  @name   Write
+ *  @fn     void Write(const Logger::Record& record) override
+ *  @brief  Write a single record
+ *  @param[in] record  Record to write
+ */
+void BinaryLogSink::Write(const Logger::Record& record) {
+  const uint32_t n_file = static_cast<uint32_t>(std::strlen(record.file));
+  const uint32_t n_msg = static_cast<uint32_t>(record.message.size());
+  buffer_.clear();
+  Append(&buffer_, uint32_t(0));
+  Append(&buffer_, static_cast<uint8_t>(record.level));
+  Append(&buffer_, static_cast<int64_t>(record.timestamp));
+  Append(&buffer_, static_cast<uint64_t>(record.thread_id));
+  Append(&buffer_, static_cast<int32_t>(record.line));
+  Append(&buffer_, n_file);
+  buffer_.append(record.file, n_file);
+  Append(&buffer_, n_msg);
+  buffer_.append(record.message);
+  // Patch size
+  const uint32_t size = static_cast<uint32_t>(buffer_.size() -
+                                              sizeof(uint32_t));
+  std::memcpy(&buffer_[0], &size, sizeof(size));
+  stream_.write(buffer_.data(), buffer_.size());
+}
+
+/*
+ *  @name   Flush
+ *  @fn     void Flush(void) override
+ *  @brief  Flush underlying stream
+ */
+void BinaryLogSink::Flush(void) {
+  stream_.flush();
+}
+
+/*
+ *  @name   Decode
+ *  @fn     static bool Decode(std::istream& stream, Logger::Record* record,
+                               std::string* file)
+ *  @brief  Read back a record written by this sink
+ *  @param[in] stream  Stream to read from
+ *  @param[out] record Decoded record, `file` points into `file` string
+ *  @param[out] file   Storage for the source file name
+ *  @return False if no complete record is available
+ */
+bool BinaryLogSink::Decode(std::istream& stream,
+                           Logger::Record* record,
+                           std::string* file) {
+  uint32_t size = 0;
+  if (!stream.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+    return false;
+  }
+  std::string buff(size, '\0');
+  if (!stream.read(&buff[0], size)) {
+    return false;
+  }
+  size_t pos = 0;
+  uint8_t lvl = 0;
+  int64_t ts = 0;
+  uint64_t tid = 0;
+  int32_t line = 0;
+  uint32_t n_file = 0, n_msg = 0;
+  bool ok = Extract(buff, &pos, &lvl) && Extract(buff, &pos, &ts) &&
+            Extract(buff, &pos, &tid) && Extract(buff, &pos, &line) &&
+            Extract(buff, &pos, &n_file) && buff.size() - pos >= n_file;
+  if (!ok || lvl > Logger::kDebug2) {
+    return false;
+  }
+  file->assign(buff, pos, n_file);
+  pos += n_file;
+  if (!Extract(buff, &pos, &n_msg) || buff.size() - pos < n_msg) {
+    return false;
+  }
+  record->level = static_cast<Logger::Level>(lvl);
+  record->timestamp = ts;
+  record->thread_id = tid;
+  record->file = file->c_str();
+  record->line = line;
+  record->message.assign(buff, pos, n_msg);
+  return true;
+}
+
+#pragma mark -
+#pragma mark Rotating file
+
+/*
+ *  @name   RotatingFileLogSink
+ *  @fn     RotatingFileLogSink(const std::string& path,
+                                const size_t& max_size,
+                                const size_t& max_files,
+                                const Format& format,
+                                FileSystem* fs = nullptr)
+ *  @brief  Constructor, appends to `path` if it already exists
+ *  @param[in] path       Active log file
+ *  @param[in] max_size   Size in bytes triggering a rotation
+ *  @param[in] max_files  Number of rotated files kept
+ *  @param[in] format     Record encoding
+ *  @param[in] fs         File system used for rotation, platform's default
+ *                        if nullptr
+ */
+RotatingFileLogSink::RotatingFileLogSink(const std::string& path,
+                                         const size_t& max_size,
+                                         const size_t& max_files,
+                                         const Format& format,
+                                         FileSystem* fs) :
+  path_(path),
+  max_size_(max_size),
+  max_files_(max_files),
+  fs_(fs),
+  size_(0) {
+  if (fs_ == nullptr) {
+#ifdef IS_POSIX
+    fs_ = FileSystemFactory::Get().Retrieve("Posix");
+#else
+    fs_ = FileSystemFactory::Get().Retrieve("Windows");
+#endif
+  }
+  switch (format) {
+    case Format::kText: encoder_.reset(new StreamLogSink(buffer_));
+      break;
+    case Format::kJson: encoder_.reset(new JsonLogSink(buffer_));
+      break;
+    case Format::kBinary: encoder_.reset(new BinaryLogSink(buffer_));
+      break;
+  }
+  if (fs_->FileExist(path_).Good()) {
+    fs_->QueryFileSize(path_, &size_);
+  }
+  file_.open(path_.c_str(), std::ios_base::out |
+                            std::ios_base::app |
+                            std::ios_base::binary);
+}
+
+/*
+ *  @name   ~RotatingFileLogSink
+ *  @fn     ~RotatingFileLogSink(void) override
+ *  @brief  Destructor
+ */
+RotatingFileLogSink::~RotatingFileLogSink(void) {
+  file_.flush();
+}
+
+/*
+ *  @name   Write
+ *  @fn     void Write(const Logger::Record& record) override
+ *  @brief  Write a single record, rotate first if it would overflow the
+ *          active file
+ *  @param[in] record  Record to write
+ */
+void RotatingFileLogSink::Write(const Logger::Record& record) {
+  buffer_.str("");
+  encoder_->Write(record);
+  const std::string data = buffer_.str();
+  if (size_ > 0 && size_ + data.size() > max_size_) {
+    this->Rotate();
+  }
+  file_.write(data.data(), data.size());
+  size_ += data.size();
+}
+
+/*
+ *  @name   Flush
+ *  @fn     void Flush(void) override
+ *  @brief  Flush active file
+ */
+void RotatingFileLogSink::Flush(void) {
+  file_.flush();
+}
+
+/*
+ *  @name   Rotate
+ *  @fn     void Rotate(void)
+ *  @brief  Shift existing files and restart an empty active file
+ */
+void RotatingFileLogSink::Rotate(void) {
+  file_.close();
+  if (max_files_ == 0) {
+    fs_->DeleteFile(path_);
+  } else {
+    const std::string last = path_ + "." + std::to_string(max_files_);
+    if (fs_->FileExist(last).Good()) {
+      fs_->DeleteFile(last);
+    }
+    for (size_t k = max_files_ - 1; k > 0; --k) {
+      const std::string src = path_ + "." + std::to_string(k);
+      if (fs_->FileExist(src).Good()) {
+        fs_->RenameFile(src, path_ + "." + std::to_string(k + 1));
+      }
+    }
+    fs_->RenameFile(path_, path_ + ".1");
+  }
+  file_.clear();
+  file_.open(path_.c_str(), std::ios_base::out |
+                            std::ios_base::trunc |
+                            std::ios_base::binary);
+  size_ = 0;
+}
+
+}  // namespace FaceKit
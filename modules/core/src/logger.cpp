@@ -8,16 +8,132 @@
  *  Copyright (c) 2017 Christophe Ecabert. All rights reserved.
  */
 
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+
 #include "facekit/core/logger.hpp"
+#include "facekit/core/log_sink.hpp"
 
 /**
  *  @namespace  FaceKit
  *  @brief      Development space
  */
 namespace FaceKit {
-  
+
 /** Conversion from level enumerate to string */
 constexpr const char* Logger::LvlToStr[];
+/** Default queue capacity */
+constexpr size_t Logger::kDefaultQueueCapacity;
+
+/** Period at which the background thread drains the queues */
+static constexpr std::chrono::milliseconds kDrainPeriod(10);
+
+/**
+ * @class   Queue
+ * @brief   Bounded lock-free ring of records, written by one thread and
+ *          read by whoever holds the sink lock.
+ */
+class Logger::Queue {
+ public:
+  /**
+   * @name  Queue
+   * @fn    explicit Queue(const size_t& capacity)
+   * @brief Constructor
+   * @param[in] capacity    Maximum number of pending records
+   */
+  explicit Queue(const size_t& capacity) : slots_(capacity),
+                                           head_(0),
+                                           tail_(0),
+                                           closed_(false) {}
+
+  /**
+   * @name  Push
+   * @fn    bool Push(Record&& record)
+   * @brief Add a record, producer side
+   * @param[in] record  Record to add, left untouched on failure
+   * @return    False if the queue is full
+   */
+  bool Push(Record&& record) {
+    const size_t h = head_.load(std::memory_order_relaxed);
+    if (h - tail_.load(std::memory_order_acquire) == slots_.size()) {
+      return false;
+    }
+    slots_[h % slots_.size()] = std::move(record);
+    head_.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @name  Pop
+   * @fn    size_t Pop(LogSink* sink)
+   * @brief Write every pending record into a sink, consumer side
+   * @param[in] sink    Output sink
+   * @return    Number of written records
+   */
+  size_t Pop(LogSink* sink) {
+    size_t t = tail_.load(std::memory_order_relaxed);
+    const size_t h = head_.load(std::memory_order_acquire);
+    const size_t n = h - t;
+    for (; t < h; ++t) {
+      Record& rec = slots_[t % slots_.size()];
+      sink->Write(rec);
+      rec.message.clear();
+    }
+    tail_.store(h, std::memory_order_release);
+    return n;
+  }
+
+  /**
+   * @name  Size
+   * @fn    size_t Size(void) const
+   * @brief Number of pending records
+   * @return    Size
+   */
+  size_t Size(void) const {
+    return head_.load(std::memory_order_acquire) -
+           tail_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @name  Capacity
+   * @fn    size_t Capacity(void) const
+   * @brief Maximum number of pending records
+   * @return    Capacity
+   */
+  size_t Capacity(void) const {
+    return slots_.size();
+  }
+
+  /** Records */
+  std::vector<Record> slots_;
+  /** Next slot to write, only modified by the producer */
+  std::atomic<size_t> head_;
+  /** Next slot to read, only modified by the consumer */
+  std::atomic<size_t> tail_;
+  /** Set when the producer thread exits */
+  std::atomic<bool> closed_;
+};
+
+/**
+ * @struct  QueueHolder
+ * @brief   Thread's ownership of its queue, flags it on thread exit so the
+ *          consumer can release it once emptied.
+ */
+struct QueueHolder {
+  /** Queue */
+  std::shared_ptr<Logger::Queue> queue;
+
+  /** Destructor */
+  ~QueueHolder(void) {
+    if (queue) {
+      queue->closed_.store(true, std::memory_order_release);
+    }
+  }
+};
+
+/** Calling thread's queue */
+static thread_local QueueHolder thread_queue;
 
 #pragma mark -
 #pragma mark Initialization
@@ -35,16 +151,73 @@ Logger& Logger::Instance(std::ostream& stream) {
   return logger;
 }
 
+/*
+ * @name  Logger
+ * @fn    explicit Logger(std::ostream& stream)
+ * @brief Constructor
+ * @param[in] stream  Where output logging message
+ */
+Logger::Logger(std::ostream& stream) : stream_(stream),
+                                       sink_(new StreamLogSink(stream)),
+                                       enable_(true),
+                                       log_level_(kDebug),
+                                       async_(false),
+                                       drop_policy_(DropPolicy::kBlock),
+                                       queue_capacity_(kDefaultQueueCapacity),
+                                       n_dropped_(0),
+                                       n_dropped_reported_(0),
+                                       running_(false) {
+  const char* env = std::getenv("FACEKIT_LOG_ASYNC");
+  if (env != nullptr && std::atoi(env) > 0) {
+    this->set_async(true);
+  }
+}
+
+/*
+ * @name  ~Logger
+ * @fn    ~Logger(void)
+ * @brief Destructor, write pending messages
+ */
+Logger::~Logger(void) {
+  this->set_async(false);
+}
+
 #pragma mark -
 #pragma mark Usage
 
 /*
- * @name
- * @fn
+ * @name  Write
+ * @fn    void Write(std::ostream& stream, None)
  * @brief Empty dump
- * @param[in] data
+ * @param[in] stream  Stream to write in
+ */
+void Logger::Write(std::ostream& stream, None) {
+}
+
+/*
+ * @name  Flush
+ * @fn    void Flush(void)
+ * @brief Write every pending message and flush the sink
  */
-void Logger::Write(None) {
+void Logger::Flush(void) {
+  this->Drain();
+  std::lock_guard<std::mutex> lock(sink_mutex_);
+  sink_->Flush();
+}
+
+/*
+ * @name  set_sink
+ * @fn    void set_sink(const std::shared_ptr<LogSink>& sink)
+ * @brief Define where records are written, pending messages are written
+ *        into the previous sink first.
+ * @param[in] sink    Sink, nullptr restores the text sink on the stream
+ *                    given to `Instance`
+ */
+void Logger::set_sink(const std::shared_ptr<LogSink>& sink) {
+  this->Drain();
+  std::lock_guard<std::mutex> lock(sink_mutex_);
+  sink_->Flush();
+  sink_ = sink ? sink : std::make_shared<StreamLogSink>(stream_);
 }
 
 /*
@@ -64,4 +237,168 @@ void Logger::Enable(void) {
 void Logger::Disable(void) {
   enable_ = false;
 }
+
+/*
+ * @name  set_async
+ * @fn    void set_async(const bool& async)
+ * @brief Switch between synchronous and asynchronous mode. Pending
+ *        messages are written when going back to synchronous mode.
+ * @param[in] async   True for asynchronous logging
+ */
+void Logger::set_async(const bool& async) {
+  std::lock_guard<std::mutex> mode_lock(mode_mutex_);
+  if (async == async_.load()) {
+    return;
+  }
+  if (async) {
+    running_ = true;
+    worker_ = std::thread(&Logger::Run, this);
+    async_.store(true);
+  } else {
+    async_.store(false);
+    {
+      std::lock_guard<std::mutex> lock(worker_mutex_);
+      running_ = false;
+    }
+    worker_cv_.notify_one();
+    worker_.join();
+    this->Drain();
+  }
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ * @name  Buffer
+ * @fn    static std::ostringstream& Buffer(void)
+ * @brief Calling thread's formatting buffer, emptied
+ * @return    Buffer
+ */
+std::ostringstream& Logger::Buffer(void) {
+  static thread_local std::ostringstream buffer;
+  buffer.str("");
+  buffer.clear();
+  return buffer;
+}
+
+/*
+ * @name  Submit
+ * @fn    void Submit(const Level level, const char* file, const int line,
+                      std::ostringstream& message)
+ * @brief Write a record or queue it in asynchronous mode
+ * @param[in] level   Level of logging
+ * @param[in] file    File from where the log has been emitted
+ * @param[in] line    Line number where log has been emitted
+ * @param[in] message Formatted message
+ */
+void Logger::Submit(const Level level,
+                    const char* file,
+                    const int line,
+                    std::ostringstream& message) {
+  using Clock = std::chrono::steady_clock;
+  static thread_local const uint64_t thread_id =
+          std::hash<std::thread::id>()(std::this_thread::get_id());
+  Record rec;
+  rec.level = level;
+  rec.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          Clock::now().time_since_epoch()).count();
+  rec.thread_id = thread_id;
+  rec.file = file;
+  rec.line = line;
+  rec.message = message.str();
+  if (!async_.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    sink_->Write(rec);
+    sink_->Flush();
+    return;
+  }
+  // First asynchronous message of this thread, register its queue
+  if (!thread_queue.queue) {
+    const size_t capacity = queue_capacity_.load(std::memory_order_relaxed);
+    thread_queue.queue = std::make_shared<Queue>(capacity);
+    std::lock_guard<std::mutex> lock(queues_mutex_);
+    queues_.push_back(thread_queue.queue);
+  }
+  Queue& queue = *thread_queue.queue;
+  while (!queue.Push(std::move(rec))) {
+    if (drop_policy_.load(std::memory_order_relaxed) == DropPolicy::kDrop) {
+      n_dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    worker_cv_.notify_one();
+    std::this_thread::yield();
+  }
+  // Wake up consumer early when filling up
+  if (queue.Size() > queue.Capacity() / 2) {
+    worker_cv_.notify_one();
+  }
+}
+
+/*
+ * @name  Drain
+ * @fn    void Drain(void)
+ * @brief Write every queued record into the sink
+ */
+void Logger::Drain(void) {
+  std::vector<std::shared_ptr<Queue>> queues;
+  {
+    std::lock_guard<std::mutex> lock(queues_mutex_);
+    queues = queues_;
+  }
+  std::lock_guard<std::mutex> lock(sink_mutex_);
+  size_t n = 0;
+  bool release = false;
+  for (const auto& q : queues) {
+    // Check closed before popping, nothing can be pushed once it is set
+    const bool closed = q->closed_.load(std::memory_order_acquire);
+    n += q->Pop(sink_.get());
+    release |= closed;
+  }
+  const size_t dropped = n_dropped_.load(std::memory_order_relaxed);
+  if (dropped != n_dropped_reported_) {
+    Record rec;
+    rec.level = kWarning;
+    rec.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    rec.thread_id = 0;
+    rec.file = __FILE__;
+    rec.line = __LINE__;
+    rec.message = "Logger: " + std::to_string(dropped - n_dropped_reported_) +
+                  " message(s) dropped";
+    sink_->Write(rec);
+    n_dropped_reported_ = dropped;
+    n += 1;
+  }
+  if (n > 0) {
+    sink_->Flush();
+  }
+  // Forget queues of exited threads, they are empty at this point
+  if (release) {
+    std::lock_guard<std::mutex> qlock(queues_mutex_);
+    for (auto it = queues_.begin(); it != queues_.end();) {
+      if ((*it)->closed_.load(std::memory_order_acquire) &&
+          (*it)->Size() == 0) {
+        it = queues_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+/*
+ * @name  Run
+ * @fn    void Run(void)
+ * @brief Background thread's loop
+ */
+void Logger::Run(void) {
+  std::unique_lock<std::mutex> lock(worker_mutex_);
+  while (running_) {
+    worker_cv_.wait_for(lock, kDrainPeriod);
+    lock.unlock();
+    this->Drain();
+    lock.lock();
+  }
+}
 }  // namespace FaceKit
@@ -0,0 +1,389 @@
+/**
+ *  @file   memory_budget.cpp
+ *  @brief  Memory budget shared by the stages of a pipeline, producers
+ *          block once it is reached
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+#include "facekit/core/mem/memory_budget.hpp"
+#include "facekit/core/mem/allocator.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/logger.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Polling period while memory allocated without token is tracked */
+static constexpr std::chrono::milliseconds kPollPeriod(1);
+
+/**
+ *  @name   LimitFromEnv
+ *  @fn     static size_t LimitFromEnv(void)
+ *  @brief  Parse `FACEKIT_MEMORY_BUDGET`, i.e. `1073741824`, `512M`, `4G`
+ *  @return Budget in bytes, 0 if not set or invalid
+ */
+static size_t LimitFromEnv(void) {
+  const char* env = std::getenv("FACEKIT_MEMORY_BUDGET");
+  if (env == nullptr) {
+    return 0;
+  }
+  char* end = nullptr;
+  const unsigned long long v = std::strtoull(env, &end, 10);
+  size_t shift = 0;
+  switch (*end) {
+    case '\0': break;
+    case 'k':
+    case 'K': shift = 10; ++end; break;
+    case 'm':
+    case 'M': shift = 20; ++end; break;
+    case 'g':
+    case 'G': shift = 30; ++end; break;
+    default: end = nullptr;
+  }
+  if (end == nullptr || end == env || *end != '\0') {
+    FACEKIT_LOG_WARNING("Invalid FACEKIT_MEMORY_BUDGET value: " << env);
+    return 0;
+  }
+  return static_cast<size_t>(v) << shift;
+}
+
+#pragma mark -
+#pragma mark Token
+
+/*
+ *  @name   operator=
+ *  @fn     Token& operator=(Token&& rhs)
+ *  @brief  Move assignment, bytes held so far are given back
+ *  @param[in] rhs  Token to move from, left empty
+ *  @return Newly assigned token
+ */
+MemoryBudget::Token& MemoryBudget::Token::operator=(Token&& rhs) {
+  if (this != &rhs) {
+    this->Release();
+    budget_ = rhs.budget_;
+    bytes_ = rhs.bytes_;
+    rhs.budget_ = nullptr;
+    rhs.bytes_ = 0;
+  }
+  return *this;
+}
+
+/*
+ *  @name   Resize
+ *  @fn     void Resize(const size_t& bytes)
+ *  @brief  Account for \p bytes instead of the current amount without
+ *          waiting, the budget can be exceeded
+ *  @param[in] bytes  New amount, the token must not be empty
+ */
+void MemoryBudget::Token::Resize(const size_t& bytes) {
+  if (bytes < bytes_) {
+    budget_->Return(bytes_ - bytes);
+  } else if (bytes > bytes_) {
+    std::lock_guard<std::mutex> lock(budget_->lock_);
+    budget_->reserved_ += bytes - bytes_;
+    budget_->peak_ = std::max(budget_->peak_, budget_->reserved_);
+  }
+  bytes_ = bytes;
+}
+
+/*
+ *  @name   Release
+ *  @fn     void Release(void)
+ *  @brief  Give the bytes back, the token is left empty
+ */
+void MemoryBudget::Token::Release(void) {
+  if (budget_ != nullptr) {
+    budget_->Return(bytes_);
+    budget_ = nullptr;
+    bytes_ = 0;
+  }
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   Global
+ *  @fn     static MemoryBudget& Global(void)
+ *  @brief  Process-wide budget, limit read from `FACEKIT_MEMORY_BUDGET`
+ */
+MemoryBudget& MemoryBudget::Global(void) {
+  static MemoryBudget* budget = [](void) {
+    auto* b = new MemoryBudget(LimitFromEnv());
+    b->set_allocator(DefaultCpuAllocator());
+    return b;
+  }();
+  return *budget;
+}
+
+/*
+ *  @name   MemoryBudget
+ *  @fn     explicit MemoryBudget(const size_t& limit = 0)
+ *  @brief  Constructor
+ *  @param[in] limit  Budget in bytes, 0 for unlimited
+ */
+MemoryBudget::MemoryBudget(const size_t& limit) : limit_(limit),
+                                                  reserved_(0),
+                                                  peak_(0),
+                                                  n_wait_(0),
+                                                  allocator_(nullptr) {
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Acquire
+ *  @fn     void Acquire(const size_t& bytes, Token* token)
+ *  @brief  Reserve \p bytes, blocks while they do not fit in the budget
+ *  @param[in] bytes  Amount to reserve
+ *  @param[out] token Reservation, bytes it held before are given back
+ */
+void MemoryBudget::Acquire(const size_t& bytes, Token* token) {
+  token->Release();
+  std::unique_lock<std::mutex> lock(lock_);
+  if (!this->Fits(bytes)) {
+    n_wait_ += 1;
+    while (!this->Fits(bytes)) {
+      if (allocator_ != nullptr) {
+        cond_.wait_for(lock, kPollPeriod);
+      } else {
+        cond_.wait(lock);
+      }
+    }
+  }
+  this->Grant(bytes, token);
+}
+
+/*
+ *  @name   Acquire
+ *  @fn     void Acquire(const size_t& bytes, ThreadPool* pool, Token* token)
+ *  @brief  Reserve \p bytes, running pending tasks of \p pool while they do
+ *          not fit in the budget
+ *  @param[in] bytes  Amount to reserve
+ *  @param[in] pool   Pool to help while waiting
+ *  @param[out] token Reservation, bytes it held before are given back
+ */
+void MemoryBudget::Acquire(const size_t& bytes,
+                           ThreadPool* pool,
+                           Token* token) {
+  token->Release();
+  std::unique_lock<std::mutex> lock(lock_);
+  if (!this->Fits(bytes)) {
+    n_wait_ += 1;
+    while (!this->Fits(bytes)) {
+      // Tasks of the pool may be the ones holding the budget
+      lock.unlock();
+      const bool helped = pool->RunPendingTask();
+      lock.lock();
+      if (!helped) {
+        cond_.wait_for(lock, kPollPeriod);
+      }
+    }
+  }
+  this->Grant(bytes, token);
+}
+
+/*
+ *  @name   TryAcquire
+ *  @fn     bool TryAcquire(const size_t& bytes, Token* token)
+ *  @brief  Reserve \p bytes if they fit in the budget
+ *  @param[in] bytes  Amount to reserve
+ *  @param[out] token Reservation, bytes it held before are given back
+ *  @return True if reserved, \p token is left untouched otherwise
+ */
+bool MemoryBudget::TryAcquire(const size_t& bytes, Token* token) {
+  // Bytes held by `token` may be what prevents the reservation
+  Token prev(std::move(*token));
+  std::lock_guard<std::mutex> lock(lock_);
+  if (prev) {
+    reserved_ -= prev.bytes_;
+  }
+  if (this->Fits(bytes)) {
+    this->Grant(bytes, token);
+    if (prev) {
+      prev.budget_ = nullptr;
+      cond_.notify_all();
+    }
+    return true;
+  }
+  // Put the previous reservation back as it was
+  if (prev) {
+    reserved_ += prev.bytes_;
+    *token = std::move(prev);
+  }
+  return false;
+}
+
+/*
+ *  @name   Charge
+ *  @fn     void Charge(const size_t& bytes, Token* token)
+ *  @brief  Account for \p bytes already allocated without waiting
+ *  @param[in] bytes  Amount to account for
+ *  @param[out] token Reservation, bytes it held before are given back
+ */
+void MemoryBudget::Charge(const size_t& bytes, Token* token) {
+  token->Release();
+  std::lock_guard<std::mutex> lock(lock_);
+  this->Grant(bytes, token);
+}
+
+#pragma mark -
+#pragma mark Accessors
+
+/*
+ *  @name   limit
+ *  @fn     size_t limit(void) const
+ *  @brief  Budget in bytes, 0 if unlimited
+ */
+size_t MemoryBudget::limit(void) const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return limit_;
+}
+
+/*
+ *  @name   set_limit
+ *  @fn     void set_limit(const size_t& limit)
+ *  @brief  Change the budget, producers waiting are woken up
+ *  @param[in] limit  Budget in bytes, 0 for unlimited
+ */
+void MemoryBudget::set_limit(const size_t& limit) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    limit_ = limit;
+  }
+  cond_.notify_all();
+}
+
+/*
+ *  @name   set_allocator
+ *  @fn     void set_allocator(Allocator* allocator)
+ *  @brief  Account for the bytes in use reported by \p allocator's
+ *          statistics as well
+ *  @param[in] allocator  Allocator to track, nullptr to only count tokens
+ */
+void MemoryBudget::set_allocator(Allocator* allocator) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    allocator_ = allocator;
+  }
+  cond_.notify_all();
+}
+
+/*
+ *  @name   used
+ *  @fn     size_t used(void) const
+ *  @brief  Memory in use
+ */
+size_t MemoryBudget::used(void) const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return this->Usage();
+}
+
+/*
+ *  @name   reserved
+ *  @fn     size_t reserved(void) const
+ *  @brief  Bytes held by tokens
+ */
+size_t MemoryBudget::reserved(void) const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return reserved_;
+}
+
+/*
+ *  @name   peak
+ *  @fn     size_t peak(void) const
+ *  @brief  Largest amount held by tokens
+ */
+size_t MemoryBudget::peak(void) const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return peak_;
+}
+
+/*
+ *  @name   n_wait
+ *  @fn     size_t n_wait(void) const
+ *  @brief  Number of acquisitions that had to wait
+ */
+size_t MemoryBudget::n_wait(void) const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return n_wait_;
+}
+
+/*
+ *  @name   exhausted
+ *  @fn     bool exhausted(void) const
+ *  @brief  Indicate if the budget is reached
+ */
+bool MemoryBudget::exhausted(void) const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return limit_ != 0 && this->Usage() >= limit_;
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ *  @name   Usage
+ *  @fn     size_t Usage(void) const
+ *  @brief  Memory in use, the lock must be held
+ */
+size_t MemoryBudget::Usage(void) const {
+  if (allocator_ != nullptr && AllocatorStatisticsEnabled()) {
+    AllocatorStatistic stats;
+    allocator_->GatherStatistics(&stats);
+    return std::max(reserved_, stats.used_bytes);
+  }
+  return reserved_;
+}
+
+/*
+ *  @name   Fits
+ *  @fn     bool Fits(const size_t& bytes) const
+ *  @brief  Indicate if \p bytes can be granted, the lock must be held
+ */
+bool MemoryBudget::Fits(const size_t& bytes) const {
+  // Nothing reserved, grant it whatever its size to guarantee progress
+  if (limit_ == 0 || reserved_ == 0) {
+    return true;
+  }
+  return this->Usage() + bytes <= limit_;
+}
+
+/*
+ *  @name   Grant
+ *  @fn     void Grant(const size_t& bytes, Token* token)
+ *  @brief  Reserve \p bytes into \p token, the lock must be held
+ */
+void MemoryBudget::Grant(const size_t& bytes, Token* token) {
+  reserved_ += bytes;
+  peak_ = std::max(peak_, reserved_);
+  token->budget_ = this;
+  token->bytes_ = bytes;
+}
+
+/*
+ *  @name   Return
+ *  @fn     void Return(const size_t& bytes)
+ *  @brief  Give \p bytes back and wake up waiting producers
+ */
+void MemoryBudget::Return(const size_t& bytes) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    reserved_ -= bytes;
+  }
+  cond_.notify_all();
+}
+
+}  // namespace FaceKit
@@ -11,7 +11,17 @@
 #include <iostream>
 #include <type_traits>
 #include <algorithm>
+#include <cerrno>
 
+#if defined(__APPLE__) || defined(__linux__)
+#define HAS_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "google/protobuf/arena.h"
 #include "google/protobuf/repeated_field.h"
 #include "google/protobuf/stubs/port.h"
 #include "nd_array.pb.h"
@@ -184,7 +194,7 @@ class SubBuffer : public NDArrayBuffer {
     T* root_end = buff->base<T>() + (buff->size() / sizeof(T));
     assert(this->base<T>() <= root_end);
     assert(this->base<T>() + n_elem <= root_end);
-    root_->Inc();
+    root_->IncAlias();
   }
 
   /**
@@ -246,7 +256,7 @@ class SubBuffer : public NDArrayBuffer {
    *  @brief  Destructor
    */
   ~SubBuffer(void) override {
-    root_->Dec();
+    root_->DecAlias();
   }
 
   /** Original buffer */
@@ -257,6 +267,264 @@ class SubBuffer : public NDArrayBuffer {
   size_t n_elem_;
 };
 
+#ifdef HAS_MMAP
+/**
+ *  @class  MappedBuffer
+ *  @brief  Buffer backed by a memory-mapped region of a file
+ *  @author Christophe Ecabert
+ *  @date   02.03.18
+ *  @ingroup core
+ */
+class MappedBuffer : public NDArrayBuffer {
+ public:
+
+  /**
+   *  @name   MappedBuffer
+   *  @fn     MappedBuffer(void* region, const size_t& length,
+                           const size_t& offset, const size_t& size)
+   *  @brief  Constructor, take ownership of the mapping
+   *  @param[in] region Start of the mapping (page aligned)
+   *  @param[in] length Length of the mapping in bytes
+   *  @param[in] offset Position of the data within the mapping
+   *  @param[in] size   Data size in bytes
+   */
+  MappedBuffer(void* region,
+               const size_t& length,
+               const size_t& offset,
+               const size_t& size) : region_(region),
+                                     length_(length),
+                                     data_(reinterpret_cast<char*>(region) +
+                                           offset),
+                                     size_(size) {
+  }
+
+  /**
+   *  @name   MappedBuffer
+   *  @fn     MappedBuffer(const MappedBuffer& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  MappedBuffer(const MappedBuffer& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     MappedBuffer& operator=(const MappedBuffer& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  MappedBuffer& operator=(const MappedBuffer& rhs) = delete;
+
+  /**
+   *  @name   data
+   *  @fn     void* data(void) const override
+   *  @brief  Pointer to the buffer storing data of a given `size` in bytes
+   *  @return Buffer address
+   */
+  void* data(void) const override {
+    return data_;
+  }
+
+  /**
+   *  @name   size
+   *  @fn     size_t size(void) const override
+   *  @brief  Buffer dimension in bytes
+   *  @return Number of bytes in the buffer
+   */
+  size_t size(void) const override {
+    return size_;
+  }
+
+  /**
+   *  @name   root
+   *  @fn     NDArrayBuffer* root(void) override
+   *  @brief  Provide reference to the buffer interface
+   */
+  NDArrayBuffer* root(void) override {
+    return this;
+  }
+
+#pragma mark Private
+ private:
+
+  /**
+   *  @name   ~MappedBuffer
+   *  @fn     ~MappedBuffer(void) override
+   *  @brief  Destructor, unmap the region
+   */
+  ~MappedBuffer(void) override {
+    munmap(region_, length_);
+  }
+
+  /** Mapped region */
+  void* region_;
+  /** Region length */
+  size_t length_;
+  /** Data */
+  void* data_;
+  /** Data size */
+  size_t size_;
+};
+#endif
+
+/**
+ *  @class  StringBuffer
+ *  @brief  Buffer taking over the bytes of a string (i.e. the payload of a
+ *          parsed protobuf object) without copying them
+ *  @author Christophe Ecabert
+ *  @date   26.10.18
+ *  @ingroup core
+ */
+class StringBuffer : public NDArrayBuffer {
+ public:
+
+  /**
+   *  @name   StringBuffer
+   *  @fn     explicit StringBuffer(std::string* bytes)
+   *  @brief  Constructor, swap the content of `bytes` into the buffer
+   *  @param[in,out] bytes  Bytes to take over, left empty
+   */
+  explicit StringBuffer(std::string* bytes) {
+    bytes_.swap(*bytes);
+  }
+
+  /**
+   *  @name   StringBuffer
+   *  @fn     StringBuffer(const StringBuffer& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  StringBuffer(const StringBuffer& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     StringBuffer& operator=(const StringBuffer& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  StringBuffer& operator=(const StringBuffer& rhs) = delete;
+
+  /**
+   *  @name   data
+   *  @fn     void* data(void) const override
+   *  @brief  Pointer to the buffer storing data of a given `size` in bytes
+   *  @return Buffer address
+   */
+  void* data(void) const override {
+    return const_cast<char*>(bytes_.data());
+  }
+
+  /**
+   *  @name   size
+   *  @fn     size_t size(void) const override
+   *  @brief  Buffer dimension in bytes
+   *  @return Number of bytes in the buffer
+   */
+  size_t size(void) const override {
+    return bytes_.size();
+  }
+
+  /**
+   *  @name   root
+   *  @fn     NDArrayBuffer* root(void) override
+   *  @brief  Provide reference to the buffer interface
+   */
+  NDArrayBuffer* root(void) override {
+    return this;
+  }
+
+#pragma mark Private
+ private:
+
+  /**
+   *  @name   ~StringBuffer
+   *  @fn     ~StringBuffer(void) override
+   *  @brief  Destructor
+   */
+  ~StringBuffer(void) override = default;
+
+  /** Bytes */
+  std::string bytes_;
+};
+
+#pragma mark -
+#pragma mark Strides utility function
+
+/**
+ *  @name   RowMajorStrides
+ *  @fn     static std::vector<size_t> RowMajorStrides(const NDArrayDims& dims)
+ *  @brief  Strides of a contiguous row-major array
+ *  @param[in] dims Array dimensions
+ *  @return Strides in elements
+ */
+static std::vector<size_t> RowMajorStrides(const NDArrayDims& dims) {
+  std::vector<size_t> strides(dims.dims());
+  size_t n = 1;
+  for (size_t i = dims.dims(); i > 0; --i) {
+    strides[i - 1] = n;
+    n *= dims.dim_size(i - 1);
+  }
+  return strides;
+}
+
+/**
+ *  @name   IsRowMajor
+ *  @fn     static bool IsRowMajor(const NDArrayDims& dims,
+                                   const std::vector<size_t>& strides)
+ *  @brief  Check if strides describe a contiguous row-major layout, axes of
+ *          size 1 are ignored
+ *  @param[in] dims     Array dimensions
+ *  @param[in] strides  Strides to check
+ *  @return True if contiguous
+ */
+static bool IsRowMajor(const NDArrayDims& dims,
+                       const std::vector<size_t>& strides) {
+  size_t n = 1;
+  for (size_t i = dims.dims(); i > 0; --i) {
+    if (dims.dim_size(i - 1) != 1 && strides[i - 1] != n) {
+      return false;
+    }
+    n *= dims.dim_size(i - 1);
+  }
+  return true;
+}
+
+/**
+ *  @name   StridedCopy
+ *  @fn     template<typename T> static void StridedCopy(const T* src,
+                                      const NDArrayDims& dims,
+                                      const std::vector<size_t>& strides,
+                                      T* dst)
+ *  @brief  Copy a strided array into a contiguous one
+ *  @param[in] src      Strided source
+ *  @param[in] dims     Array dimensions
+ *  @param[in] strides  Source strides
+ *  @param[out] dst     Contiguous destination
+ */
+template<typename T>
+static void StridedCopy(const T* src,
+                        const NDArrayDims& dims,
+                        const std::vector<size_t>& strides,
+                        T* dst) {
+  const size_t n_elem = dims.n_elems();
+  const size_t n_dims = dims.dims();
+  std::vector<size_t> index(n_dims, 0);
+  size_t offset = 0;
+  for (size_t k = 0; k < n_elem; ++k) {
+    *dst++ = src[offset];
+    // Next index, last axis first
+    for (size_t a = n_dims; a > 0; --a) {
+      if (++index[a - 1] < dims.dim_size(a - 1)) {
+        offset += strides[a - 1];
+        break;
+      }
+      offset -= (dims.dim_size(a - 1) - 1) * strides[a - 1];
+      index[a - 1] = 0;
+    }
+  }
+}
+
 #pragma mark -
 #pragma mark Proto utility function
 
@@ -299,7 +567,7 @@ struct ProtoStream {
    *  @return An NDArrayBuffer if everything went well, nullptr otherwise.
    */
   static NDArrayBuffer* Read(const NDArrayProto& src, const size_t& n, Allocator* alloc) {
-    auto data = src.data();
+    const auto& data = src.data();
     if (data.size() != n * sizeof(T)) {
       // Size miss match
       FACEKIT_LOG_DEBUG("Dimensions miss-match: provided" << n * sizeof(T) << " actual " << data.size());
@@ -346,7 +614,6 @@ struct ProtoStream<std::string> {
    *  @return An NDArrayBuffer if everything went well, nullptr otherwise.
    */
   static NDArrayBuffer* Read(const NDArrayProto& src, const size_t& n, Allocator* alloc) {
-    auto data = src.data();
     // Create buffer
     NDArrayBuffer* buffer = new Buffer<std::string>(n, alloc);
     std::string* ptr = buffer->base<std::string>();
@@ -381,6 +648,7 @@ DataType FromProtoToDataType(const ProtoDataType& dtype) {
     case ProtoDataType::kDouble: return DataType::kDouble;
     case ProtoDataType::kBool: return DataType::kBool;
     case ProtoDataType::kString: return DataType::kString;
+    case ProtoDataType::kHalf: return DataType::kHalf;
     default: return DataType::kUnknown;
   }
   return DataType::kUnknown;
@@ -407,6 +675,7 @@ ProtoDataType FromDataTypeToProto(const DataType& dtype) {
     case DataType::kDouble: return ProtoDataType::kDouble;
     case DataType::kBool: return ProtoDataType::kBool;
     case DataType::kString: return ProtoDataType::kString;
+    case DataType::kHalf: return ProtoDataType::kHalf;
     default: return ProtoDataType::kUnknown;
   }
   return ProtoDataType::kUnknown;
@@ -414,6 +683,86 @@ ProtoDataType FromDataTypeToProto(const DataType& dtype) {
   
   
 
+#pragma mark -
+#pragma mark Stream utility function
+
+/**
+ *  @name   WriteFrame
+ *  @fn     static bool WriteFrame(const std::function<bool(const char*,
+                                   const size_t&)>& sink, const char* data,
+                                   const size_t& n)
+ *  @brief  Write a varint length-prefixed frame
+ *  @param[in] sink Where to write
+ *  @param[in] data Frame payload
+ *  @param[in] n    Payload size in bytes, must fit in 32 bits
+ *  @return True if written successfully
+ */
+static bool WriteFrame(const std::function<bool(const char*,
+                                                const size_t&)>& sink,
+                       const char* data,
+                       const size_t& n) {
+  std::string size;
+  AddVarInt32(static_cast<uint32_t>(n), &size);
+  return sink(size.data(), size.size()) && (n == 0 || sink(data, n));
+}
+
+/**
+ *  @name   ReadFrameSize
+ *  @fn     static bool ReadFrameSize(const std::function<bool(char*,
+                                      const size_t&)>& source, uint32_t* size)
+ *  @brief  Read the varint length prefix of a frame
+ *  @param[in] source Where to read from
+ *  @param[out] size  Payload size in bytes
+ *  @return True if read successfully
+ */
+static bool ReadFrameSize(const std::function<bool(char*,
+                                                   const size_t&)>& source,
+                          uint32_t* size) {
+  uint32_t value = 0;
+  for (uint32_t shift = 0; shift <= 28; shift += 7) {
+    char c;
+    if (!source(&c, 1)) {
+      return false;
+    }
+    const uint32_t byte = static_cast<uint8_t>(c);
+    value |= (byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *size = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ *  @name   ReadChunks
+ *  @fn     static bool ReadChunks(const std::function<bool(char*,
+                                   const size_t&)>& source, char* dst,
+                                   const size_t& n)
+ *  @brief  Read frames directly into `dst` until the empty terminating frame
+ *  @param[in] source Where to read from
+ *  @param[out] dst   Destination buffer
+ *  @param[in] n      Expected number of bytes
+ *  @return True if exactly `n` bytes have been read
+ */
+static bool ReadChunks(const std::function<bool(char*,
+                                                const size_t&)>& source,
+                       char* dst,
+                       const size_t& n) {
+  size_t pos = 0;
+  uint32_t size = 0;
+  while (ReadFrameSize(source, &size)) {
+    if (size == 0) {
+      return pos == n;
+    }
+    if (size > n - pos || !source(dst + pos, size)) {
+      return false;
+    }
+    pos += size;
+  }
+  return false;
+}
+
 #pragma mark -
 #pragma mark Macro definition
   
@@ -442,6 +791,7 @@ ProtoDataType FromDataTypeToProto(const DataType& dtype) {
     CASE(double, ARG(CCODE))                                    \
     CASE(bool, ARG(CCODE))                                      \
     CASE(std::string, ARG(CCODE))                               \
+    CASE(Half, ARG(CCODE))                                      \
     case DataType::kUnknown:                                    \
       UNKNOWN;                                                  \
       break;                                                    \
@@ -454,6 +804,11 @@ ProtoDataType FromDataTypeToProto(const DataType& dtype) {
 #pragma mark -
 #pragma mark Initialization
 
+// End of axis marker
+constexpr size_t NDArray::kAll;
+// Stream chunk size
+constexpr size_t NDArray::kStreamChunkSize;
+
 /*
  *  @name   NDArray
  *  @fn     NDArray(void)
@@ -520,9 +875,6 @@ NDArray::NDArray(const DataType& type,
  *  @brief  Destructor
  */
 NDArray::~NDArray(void) {
-  if (buffer_) {
-    buffer_->Dec();
-  }
 }
 
 /*
@@ -536,12 +888,22 @@ void NDArray::DeepCopy(NDArray* other) const {
   // Init target
   other->Resize(type_, dims_);
   // Copy data
-  SWITCH_WITH_DEFAULT(type_,
-                      internal::Initializer<T>::FromArray(this->Base<const T>(),
-                                                          dims_.n_elems(),
-                                                          other->Base<T>()),
-                      FACEKIT_LOG_ERROR("Unknown data type: " << (int)type_),
-                      FACEKIT_LOG_ERROR("Data type not set"));
+  if (strides_.empty()) {
+    SWITCH_WITH_DEFAULT(type_,
+                        internal::Initializer<T>::FromArray(this->Base<const T>(),
+                                                            dims_.n_elems(),
+                                                            other->Base<T>()),
+                        FACEKIT_LOG_ERROR("Unknown data type: " << (int)type_),
+                        FACEKIT_LOG_ERROR("Data type not set"));
+  } else {
+    SWITCH_WITH_DEFAULT(type_,
+                        StridedCopy<T>(this->Base<const T>(),
+                                       dims_,
+                                       strides_,
+                                       other->Base<T>()),
+                        FACEKIT_LOG_ERROR("Unknown data type: " << (int)type_),
+                        FACEKIT_LOG_ERROR("Data type not set"));
+  }
 }
 
 /*
@@ -553,19 +915,23 @@ void NDArray::Resize(const DataType& type, const NDArrayDims& dims) {
   // Compute curr
   size_t size = dims_.n_elems() * DataTypeDynamicSize(type_);
   size_t wanted_size = dims.n_elems() * DataTypeDynamicSize(type);
-  if (buffer_ == nullptr || (size != wanted_size || type_ != type)) {
+  if (buffer_ == nullptr || (size != wanted_size || type_ != type) ||
+      !strides_.empty() || buffer_->IsShared()) {
     // Release current buffer if any
-    if (buffer_) {
-      buffer_->Dec();
-    }
+    buffer_ = nullptr;
     // Define type + size
     type_ = type;
     dims_ = dims;
+    strides_.clear();
     // Allocate buffer
     SWITCH_WITH_DEFAULT(type_,
-                        buffer_ = new Buffer<T>(dims_.n_elems(), allocator_),
+                        buffer_.reset(new Buffer<T>(dims_.n_elems(),
+                                                                allocator_)),
                         FACEKIT_LOG_ERROR("Unknown data type: " << (int)type_),
                         FACEKIT_LOG_ERROR("Data type not set"));
+  } else {
+    // Same storage, only the shape changes
+    dims_ = dims;
   }
 }
 
@@ -576,6 +942,12 @@ void NDArray::Resize(const DataType& type, const NDArrayDims& dims) {
  *  @param[out] proto Protocol Buffer Object to write into
  */
 void NDArray::ToProto(NDArrayProto* proto) const {
+  if (!strides_.empty()) {
+    // Serialize contiguous copy of the view
+    NDArray array(type_, dims_, allocator_);
+    this->DeepCopy(&array);
+    return array.ToProto(proto);
+  }
   proto->Clear();
   if (IsInitialized()) {
     // Do conversion
@@ -587,7 +959,8 @@ void NDArray::ToProto(NDArrayProto* proto) const {
     if (buffer_) {
       // Fill proto object
       SWITCH_WITH_DEFAULT(type_,
-                          ProtoStream<T>::Write(buffer_, dims_.n_elems(), proto),
+                          ProtoStream<T>::Write(buffer_.get(), dims_.n_elems(),
+                                                proto),
                           FACEKIT_LOG_ERROR("Unknown data type: " << (int)type_),
                           FACEKIT_LOG_ERROR("Data type not set"));
     }
@@ -596,6 +969,21 @@ void NDArray::ToProto(NDArrayProto* proto) const {
   }
 }
 
+/*
+ *  @name   ToProto
+ *  @fn     NDArrayProto* ToProto(google::protobuf::Arena* arena) const
+ *  @brief  Export the NDArray to a Protocol buffer object allocated on a
+ *          given arena.
+ *  @param[in] arena  Arena owning the message, if nullptr the message is
+ *                    allocated on the heap and owned by the caller
+ *  @return Protocol Buffer Object
+ */
+NDArrayProto* NDArray::ToProto(google::protobuf::Arena* arena) const {
+  auto* proto = google::protobuf::Arena::CreateMessage<NDArrayProto>(arena);
+  this->ToProto(proto);
+  return proto;
+}
+
 /*
  *  @name   FromProto
  *  @fn     Status FromProto(const NDArrayProto& proto)
@@ -644,13 +1032,390 @@ Status NDArray::FromProto(const NDArrayProto& proto, Allocator* allocator) {
   }
   // Reach here, data were read correctly -> Can init array content
   dims_ = dims;
+  strides_.clear();
   type_ = type;
   allocator_ = allocator;
-  if (buffer_) {
-    buffer_->Dec();
+  buffer_.reset(buff);
+  return Status();
+}
+
+/** Smallest payload taken over by `FromProto(NDArrayProto*)` */
+static constexpr size_t kMinAliasSize = 256;
+
+/** Size of the stack block backing the arena of stream headers */
+static constexpr size_t kHeaderArenaSize = 512;
+
+/*
+ *  @name   FromProto
+ *  @fn     Status FromProto(NDArrayProto* proto)
+ *  @brief  Fill this NDArray by taking over the data bytes of a given
+ *          Protocol Buffer Object, `proto` data is left empty.
+ *  @param[in,out] proto  Protobuf object holding NDArray
+ *  @return Operation status
+ */
+Status NDArray::FromProto(NDArrayProto* proto) {
+  return FromProto(proto, DefaultCpuAllocator());
+}
+
+/*
+ *  @name   FromProto
+ *  @fn     Status FromProto(NDArrayProto* proto, Allocator* allocator)
+ *  @brief  Fill this NDArray by taking over the data bytes of a given
+ *          Protocol Buffer Object, `proto` data is left empty.
+ *  @param[in,out] proto  Protobuf object holding NDArray
+ *  @param[in] allocator  Memory allocator used when the payload has to be
+ *                        copied
+ *  @return Operation status
+ */
+Status NDArray::FromProto(NDArrayProto* proto, Allocator* allocator) {
+  auto type = FromProtoToDataType(proto->type());
+  if (type == DataType::kUnknown || type == DataType::kString ||
+      !NDArrayDims::IsValid(proto->dims())) {
+    // Strings are decoded anyway, errors are reported by the copying path
+    return FromProto(*proto, allocator);
+  }
+  NDArrayDims dims(proto->dims());
+  const size_t elem_size = DataTypeDynamicSize(type);
+  std::string* data = proto->mutable_data();
+  // Bytes of an arena allocated message live on the heap as well, swapping
+  // them out is safe either way
+  // Small payloads may be stored inline in the string, they are copied
+  if (data->size() < kMinAliasSize ||
+      data->size() != dims.n_elems() * elem_size ||
+      reinterpret_cast<uintptr_t>(data->data()) % elem_size != 0) {
+    Status s = FromProto(*proto, allocator);
+    if (s.Good()) {
+      data->clear();
+    }
+    return s;
+  }
+  // Reach here, payload can be aliased -> Can init array content
+  dims_ = dims;
+  strides_.clear();
+  type_ = type;
+  allocator_ = allocator;
+  buffer_.reset(new StringBuffer(data));
+  return Status();
+}
+
+/*
+ *  @name   Write
+ *  @fn     Status Write(std::ostream& stream) const
+ *  @brief  Serialize the array into a stream without building an
+ *          intermediate protobuf message.
+ *  @param[in] stream Binary stream to write into
+ *  @return Operation status
+ */
+Status NDArray::Write(std::ostream& stream) const {
+  return WriteStream([&stream](const char* data, const size_t& n) {
+    stream.write(data, static_cast<std::streamsize>(n));
+    return stream.good();
+  });
+}
+
+/*
+ *  @name   Write
+ *  @fn     Status Write(const int& fd) const
+ *  @brief  Serialize the array into a file descriptor
+ *  @param[in] fd File descriptor open for writing
+ *  @return Operation status
+ */
+Status NDArray::Write(const int& fd) const {
+#ifdef HAS_MMAP
+  return WriteStream([fd](const char* data, const size_t& n) {
+    size_t done = 0;
+    while (done < n) {
+      const ssize_t w = ::write(fd, data + done, n - done);
+      if (w < 0 && errno == EINTR) {
+        continue;
+      }
+      if (w <= 0) {
+        return false;
+      }
+      done += static_cast<size_t>(w);
+    }
+    return true;
+  });
+#else
+  return Status(Status::Type::kUnimplemented,
+                "File descriptor streams not supported on this platform");
+#endif
+}
+
+/*
+ *  @name   Read
+ *  @fn     Status Read(std::istream& stream)
+ *  @brief  Fill this array from a stream written by `Write`.
+ *  @param[in] stream Binary stream to read from
+ *  @return Operation status
+ */
+Status NDArray::Read(std::istream& stream) {
+  return Read(stream, DefaultCpuAllocator());
+}
+
+/*
+ *  @name   Read
+ *  @fn     Status Read(std::istream& stream, Allocator* allocator)
+ *  @brief  Fill this array from a stream written by `Write`.
+ *  @param[in] stream     Binary stream to read from
+ *  @param[in] allocator  Memory allocator to use
+ *  @return Operation status
+ */
+Status NDArray::Read(std::istream& stream, Allocator* allocator) {
+  return ReadStream([&stream](char* data, const size_t& n) {
+    stream.read(data, static_cast<std::streamsize>(n));
+    return static_cast<size_t>(stream.gcount()) == n;
+  }, allocator);
+}
+
+/*
+ *  @name   Read
+ *  @fn     Status Read(const int& fd)
+ *  @brief  Fill this array from a file descriptor
+ *  @param[in] fd File descriptor open for reading
+ *  @return Operation status
+ */
+Status NDArray::Read(const int& fd) {
+  return Read(fd, DefaultCpuAllocator());
+}
+
+/*
+ *  @name   Read
+ *  @fn     Status Read(const int& fd, Allocator* allocator)
+ *  @brief  Fill this array from a file descriptor
+ *  @param[in] fd         File descriptor open for reading
+ *  @param[in] allocator  Memory allocator to use
+ *  @return Operation status
+ */
+Status NDArray::Read(const int& fd, Allocator* allocator) {
+#ifdef HAS_MMAP
+  return ReadStream([fd](char* data, const size_t& n) {
+    size_t done = 0;
+    while (done < n) {
+      const ssize_t r = ::read(fd, data + done, n - done);
+      if (r < 0 && errno == EINTR) {
+        continue;
+      }
+      if (r <= 0) {
+        return false;
+      }
+      done += static_cast<size_t>(r);
+    }
+    return true;
+  }, allocator);
+#else
+  return Status(Status::Type::kUnimplemented,
+                "File descriptor streams not supported on this platform");
+#endif
+}
+
+/*
+ *  @name   WriteStream
+ *  @fn     Status WriteStream(const ByteSink& sink) const
+ *  @brief  Serialize the array into a sink
+ *  @param[in] sink Where to write bytes
+ *  @return Operation status
+ */
+Status NDArray::WriteStream(const ByteSink& sink) const {
+  if (!strides_.empty()) {
+    // Serialize contiguous copy of the view
+    NDArray array(type_, dims_, allocator_);
+    this->DeepCopy(&array);
+    return array.WriteStream(sink);
+  }
+  if (type_ == DataType::kUnknown) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Can not write array without data type");
+  }
+  // Payload, strings are encoded first
+  const char* data = nullptr;
+  size_t n_bytes = 0;
+  std::string strings;
+  if (IsInitialized()) {
+    if (type_ == DataType::kString) {
+      EncodeStringList(Base<const std::string>(), dims_.n_elems(), &strings);
+      data = strings.data();
+      n_bytes = strings.size();
+    } else {
+      data = buffer_->base<const char>();
+      n_bytes = buffer_->size();
+    }
+  }
+  // Header, built on a stack backed arena
+  char block[kHeaderArenaSize];
+  google::protobuf::ArenaOptions options;
+  options.initial_block = block;
+  options.initial_block_size = sizeof(block);
+  google::protobuf::Arena arena(options);
+  auto* header = google::protobuf::Arena::CreateMessage<NDArrayProto>(&arena);
+  header->set_type(FromDataTypeToProto(type_));
+  dims_.ToProto(header->mutable_dims());
+  header->set_n_bytes(n_bytes);
+  std::string hdr;
+  header->SerializeToString(&hdr);
+  bool ok = WriteFrame(sink, hdr.data(), hdr.size());
+  // Chunks, written straight from the buffer
+  for (size_t k = 0; ok && k < n_bytes; k += kStreamChunkSize) {
+    ok = WriteFrame(sink, data + k, std::min(kStreamChunkSize, n_bytes - k));
+  }
+  ok = ok && WriteFrame(sink, nullptr, 0);
+  return ok ? Status() : Status(Status::Type::kInternalError,
+                                "Error while writing array into stream");
+}
+
+/*
+ *  @name   ReadStream
+ *  @fn     Status ReadStream(const ByteSource& source, Allocator* allocator)
+ *  @brief  Fill this array from a source
+ *  @param[in] source     Where to read bytes from
+ *  @param[in] allocator  Memory allocator to use
+ *  @return Operation status
+ */
+Status NDArray::ReadStream(const ByteSource& source, Allocator* allocator) {
+  // Header
+  uint32_t size = 0;
+  if (!ReadFrameSize(source, &size)) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Can not read array header from stream");
+  }
+  std::string hdr(size, '\0');
+  // Parsed on a stack backed arena
+  char block[kHeaderArenaSize];
+  google::protobuf::ArenaOptions options;
+  options.initial_block = block;
+  options.initial_block_size = sizeof(block);
+  google::protobuf::Arena arena(options);
+  auto& header = *google::protobuf::Arena::CreateMessage<NDArrayProto>(&arena);
+  if ((size > 0 && !source(&hdr[0], size)) || !header.ParseFromString(hdr)) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Can not read array header from stream");
+  }
+  auto type = FromProtoToDataType(header.type());
+  if (type == DataType::kUnknown) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Unknown data type in stream");
+  }
+  if (!NDArrayDims::IsValid(header.dims())) {
+    return Status(Status::Type::kInvalidArgument,
+                  "NDArray dimensions in stream are not valid");
+  }
+  NDArrayDims dims(header.dims());
+  const size_t n_elem = dims.n_elems();
+  const size_t n_bytes = static_cast<size_t>(header.n_bytes());
+  if (type != DataType::kString &&
+      n_bytes != 0 && n_bytes != n_elem * DataTypeDynamicSize(type)) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Dimensions miss-match between header and payload");
+  }
+  // Payload
+  NDArrayBuffer* buff = nullptr;
+  bool err = false;
+  if (type == DataType::kString) {
+    std::string strings(n_bytes, '\0');
+    err = !ReadChunks(source, n_bytes > 0 ? &strings[0] : nullptr, n_bytes);
+    if (!err && n_bytes > 0) {
+      buff = new Buffer<std::string>(n_elem, allocator);
+      std::string* ptr = buff->base<std::string>();
+      err = ptr == nullptr || !DecodeStringList(strings, n_elem, ptr);
+    }
+  } else if (n_bytes > 0) {
+    SWITCH_WITH_DEFAULT(type,
+                        buff = new Buffer<T>(n_elem, allocator),
+                        err = true,
+                        err = true);
+    char* ptr = buff ? buff->base<char>() : nullptr;
+    err = err || ptr == nullptr || !ReadChunks(source, ptr, n_bytes);
+  } else {
+    err = !ReadChunks(source, nullptr, 0);
+  }
+  if (err) {
+    if (buff) {
+      buff->Dec();
+    }
+    return Status(Status::Type::kInvalidArgument,
+                  "Error while reading array data from stream");
+  }
+  // Reach here, data were read correctly -> Can init array content
+  dims_ = dims;
+  strides_.clear();
+  type_ = type;
+  allocator_ = allocator;
+  buffer_.reset(buff);
+  return Status();
+}
+
+/*
+ *  @name   MapFile
+ *  @fn     Status MapFile(const std::string& path, const DataType& type,
+                           const NDArrayDims& dims, const size_t& offset = 0,
+                           const MapMode& mode = MapMode::kReadOnly)
+ *  @brief  Back this NDArray with a memory-mapped region of a file holding
+ *          raw data. Pages are loaded on demand and shared between every
+ *          process mapping the same file.
+ *  @param[in] path   Path to the file
+ *  @param[in] type   Data type stored in the file, can not be kString
+ *  @param[in] dims   Array dimensions
+ *  @param[in] offset Position of the first element in the file in bytes,
+ *                    must be a multiple of the element size
+ *  @param[in] mode   Mapping mode
+ *  @return Operation status
+ */
+Status NDArray::MapFile(const std::string& path,
+                        const DataType& type,
+                        const NDArrayDims& dims,
+                        const size_t& offset,
+                        const MapMode& mode) {
+#ifdef HAS_MMAP
+  if (type == DataType::kUnknown || type == DataType::kString) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Only fixed size data type can be mapped");
+  }
+  const size_t elem_size = DataTypeDynamicSize(type);
+  if (offset % elem_size != 0) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Offset is not aligned on element size");
   }
-  buffer_ = buff;
+  const size_t n_bytes = dims.n_elems() * elem_size;
+  NDArrayBuffer* buff = nullptr;
+  if (n_bytes > 0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return Status(Status::Type::kNotFound, "Can not open file: " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < offset + n_bytes) {
+      close(fd);
+      return Status(Status::Type::kOutOfRange,
+                    "File " + path + " is too small for the requested array");
+    }
+    // Mapping must start on a page boundary
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t start = offset - (offset % page);
+    const size_t length = n_bytes + (offset - start);
+    const bool cow = mode == MapMode::kCopyOnWrite;
+    void* region = mmap(nullptr,
+                        length,
+                        cow ? PROT_READ | PROT_WRITE : PROT_READ,
+                        cow ? MAP_PRIVATE : MAP_SHARED,
+                        fd,
+                        static_cast<off_t>(start));
+    // Mapping stays valid once the descriptor is closed
+    close(fd);
+    if (region == MAP_FAILED) {
+      return Status(Status::Type::kInternalError,
+                    "Can not map file: " + path);
+    }
+    buff = new MappedBuffer(region, length, offset - start, n_bytes);
+  }
+  dims_ = dims;
+  strides_.clear();
+  type_ = type;
+  buffer_.reset(buff);
   return Status();
+#else
+  return Status(Status::Type::kUnimplemented,
+                "Memory-mapped file are not supported on this platform");
+#endif
 }
 
 #pragma mark -
@@ -682,9 +1447,9 @@ NDArray NDArray::Slice(const size_t& start, const size_t& stop) const {
   assert(start >= 0);
   size_t dim0 = dim_size(0);
   assert(stop <= dim0);
-  // Ask for the whole array ? -> trivial case
-  if (start == 0 && stop == dim0) {
-    return *this;
+  // Strided array, go through generic view
+  if (!strides_.empty()) {
+    return this->View({Range(start, stop)});
   }
 
   // Create new array
@@ -700,7 +1465,9 @@ NDArray NDArray::Slice(const size_t& start, const size_t& stop) const {
     const size_t n_elem = dim0 * elem_per_dim0;
     if (buffer_) {
       SWITCH_WITH_DEFAULT(type_,
-                          array.buffer_ = new SubBuffer<T>(buffer_, delta, n_elem),
+                          array.buffer_.reset(new SubBuffer<T>(buffer_.get(),
+                                                                 delta,
+                                                                 n_elem)),
                           FACEKIT_LOG_ERROR("Unknown data type: " << (int)type_),
                           FACEKIT_LOG_ERROR("Data type not set"));
     }
@@ -708,6 +1475,155 @@ NDArray NDArray::Slice(const size_t& start, const size_t& stop) const {
   return array;
 }
 
+/*
+ *  @name   View
+ *  @fn     NDArray View(const std::vector<Range>& ranges) const
+ *  @brief  Create a strided view of this array, without copy. Axes without
+ *          range are fully selected.
+ *  @param[in] ranges Selection for the first `ranges.size()` axes
+ *  @return View sharing this array's buffer
+ */
+NDArray NDArray::View(const std::vector<Range>& ranges) const {
+  assert(ranges.size() <= dims());
+  NDArrayDims dims = dims_;
+  std::vector<size_t> strides = this->strides();
+  size_t offset = 0;
+  for (size_t a = 0; a < ranges.size(); ++a) {
+    const Range& r = ranges[a];
+    assert(r.step > 0);
+    const size_t stop = std::min(r.stop, dims_.dim_size(a));
+    const size_t n = r.start < stop ? (stop - r.start + r.step - 1) / r.step : 0;
+    if (n > 0) {
+      offset += r.start * strides[a];
+    }
+    dims.set_dim(a, n);
+    strides[a] *= r.step;
+  }
+  return this->MakeView(dims, strides, offset);
+}
+
+/*
+ *  @name   Select
+ *  @fn     NDArray Select(const size_t& axis, const size_t& index) const
+ *  @brief  Pick a single index along an axis (i.e. one channel) and drop
+ *          that axis, without copy.
+ *  @param[in] axis   Axis to select from
+ *  @param[in] index  Index to pick
+ *  @return View of rank `dims() - 1`
+ */
+NDArray NDArray::Select(const size_t& axis, const size_t& index) const {
+  assert(axis < dims() && index < dim_size(axis));
+  NDArrayDims dims = dims_;
+  std::vector<size_t> strides = this->strides();
+  const size_t offset = index * strides[axis];
+  dims.RemoveDim(axis);
+  strides.erase(strides.begin() + axis);
+  return this->MakeView(dims, strides, offset);
+}
+
+/*
+ *  @name   Permute
+ *  @fn     NDArray Permute(const std::vector<size_t>& axes) const
+ *  @brief  Reorder axes without copy, axis `i` of the view is axis
+ *          `axes[i]` of this array.
+ *  @param[in] axes Permutation of [0, dims())
+ *  @return Permuted view
+ */
+NDArray NDArray::Permute(const std::vector<size_t>& axes) const {
+  assert(axes.size() == dims());
+  const std::vector<size_t> src = this->strides();
+  NDArrayDims dims;
+  std::vector<size_t> strides(axes.size());
+  for (size_t i = 0; i < axes.size(); ++i) {
+    assert(axes[i] < src.size());
+    dims.AddDim(dims_.dim_size(axes[i]));
+    strides[i] = src[axes[i]];
+  }
+  return this->MakeView(dims, strides, 0);
+}
+
+/*
+ *  @name   Transpose
+ *  @fn     NDArray Transpose(void) const
+ *  @brief  Reverse axes order without copy (i.e. matrix transpose)
+ *  @return Transposed view
+ */
+NDArray NDArray::Transpose(void) const {
+  std::vector<size_t> axes(dims());
+  for (size_t i = 0; i < axes.size(); ++i) {
+    axes[i] = axes.size() - 1 - i;
+  }
+  return this->Permute(axes);
+}
+
+#pragma mark -
+#pragma mark Accessors
+
+/*
+ *  @name   strides
+ *  @fn     std::vector<size_t> strides(void) const
+ *  @brief  Distance in elements between two consecutive indices along each
+ *          axis
+ *  @return Axis strides
+ */
+std::vector<size_t> NDArray::strides(void) const {
+  return strides_.empty() ? RowMajorStrides(dims_) : strides_;
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ *  @name   Detach
+ *  @fn     void Detach(void)
+ *  @brief  Replace the buffer with a private contiguous copy
+ */
+void NDArray::Detach(void) {
+  NDArray copy(allocator_);
+  this->DeepCopy(&copy);
+  *this = std::move(copy);
+}
+
+/*
+ *  @name   MakeView
+ *  @fn     NDArray MakeView(const NDArrayDims& dims,
+                             const std::vector<size_t>& strides,
+                             const size_t& offset) const
+ *  @brief  Create a view sharing this array's buffer
+ *  @param[in] dims     View dimensions
+ *  @param[in] strides  View strides, in elements
+ *  @param[in] offset   Position of the first element of the view
+ *  @return View
+ */
+NDArray NDArray::MakeView(const NDArrayDims& dims,
+                          const std::vector<size_t>& strides,
+                          const size_t& offset) const {
+  NDArray array(allocator_);
+  array.type_ = type_;
+  array.dims_ = dims;
+  if (!IsRowMajor(dims, strides)) {
+    array.strides_ = strides;
+  }
+  if (buffer_) {
+    // Span from first to last element of the view
+    size_t n_elem = 0;
+    size_t start = 0;
+    if (dims.n_elems() > 0) {
+      n_elem = 1;
+      for (size_t a = 0; a < dims.dims(); ++a) {
+        n_elem += (dims.dim_size(a) - 1) * strides[a];
+      }
+      start = offset;
+    }
+    SWITCH_WITH_DEFAULT(type_,
+                        array.buffer_.reset(new SubBuffer<T>(buffer_.get(),
+                                                                 start,
+                                                                 n_elem)),
+                        FACEKIT_LOG_ERROR("Unknown data type: " << (int)type_),
+                        FACEKIT_LOG_ERROR("Data type not set"));
+  }
+  return array;
+}
 
 }  // namespace FaceKit
 
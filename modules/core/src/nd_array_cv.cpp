@@ -0,0 +1,318 @@
+/**
+ *  @file   nd_array_cv.cpp
+ *  @brief Zero-copy interoperability between NDArray and OpenCV matrices
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   03.03.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/nd_array.hpp"
+#include "facekit/core/logger.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#pragma mark -
+#pragma mark OpenCV Allocator
+
+/**
+ *  @class  NDArrayMatAllocator
+ *  @brief  OpenCV allocator used for matrices exposing an NDArrayBuffer. The
+ *          buffer is attached to `UMatData::userdata` and released once the
+ *          last matrix referencing it goes away. New allocations are
+ *          forwarded to the standard OpenCV allocator.
+ *  @author Christophe Ecabert
+ *  @date   03.03.18
+ *  @ingroup core
+ */
+class NDArrayMatAllocator : public cv::MatAllocator {
+ public:
+
+  /**
+   *  @name   allocate
+   *  @brief  Allocate a new matrix, forwarded to OpenCV's allocator
+   */
+  cv::UMatData* allocate(int dims,
+                         const int* sizes,
+                         int type,
+                         void* data,
+                         size_t* step,
+                         int flags,
+                         cv::UMatUsageFlags usage) const override {
+    return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step,
+                                                flags, usage);
+  }
+
+  /**
+   *  @name   allocate
+   *  @brief  Allocate data for an existing UMatData, forwarded to OpenCV's
+   *          allocator
+   */
+  bool allocate(cv::UMatData* data,
+                int flags,
+                cv::UMatUsageFlags usage) const override {
+    return cv::Mat::getStdAllocator()->allocate(data, flags, usage);
+  }
+
+  /**
+   *  @name   deallocate
+   *  @brief  Release NDArrayBuffer once no matrix references it anymore
+   */
+  void deallocate(cv::UMatData* data) const override {
+    if (!data) {
+      return;
+    }
+    if (data->refcount == 0 && data->urefcount == 0) {
+      reinterpret_cast<NDArrayBuffer*>(data->userdata)->DecAlias();
+      delete data;
+    }
+  }
+};
+
+/**
+ *  @name   MatAllocator
+ *  @fn     static NDArrayMatAllocator* MatAllocator(void)
+ *  @brief  Allocator shared by matrices created from NDArray
+ *  @return Allocator
+ */
+static NDArrayMatAllocator* MatAllocator(void) {
+  static NDArrayMatAllocator allocator;
+  return &allocator;
+}
+
+/**
+ *  @name   ToCvDepth
+ *  @fn     static int ToCvDepth(const DataType& type)
+ *  @brief  Convert data type to OpenCV depth
+ *  @param[in] type Data type
+ *  @return OpenCV depth or -1 if not supported
+ */
+static int ToCvDepth(const DataType& type) {
+  switch (type) {
+    case DataType::kInt8: return CV_8S;
+    case DataType::kUInt8: return CV_8U;
+    case DataType::kInt16: return CV_16S;
+    case DataType::kUInt16: return CV_16U;
+    case DataType::kInt32: return CV_32S;
+    case DataType::kFloat: return CV_32F;
+    case DataType::kDouble: return CV_64F;
+    default: return -1;
+  }
+}
+
+/**
+ *  @name   FromCvDepth
+ *  @fn     static DataType FromCvDepth(const int& depth)
+ *  @brief  Convert OpenCV depth to data type
+ *  @param[in] depth  OpenCV depth
+ *  @return Data type or kUnknown if not supported
+ */
+static DataType FromCvDepth(const int& depth) {
+  switch (depth) {
+    case CV_8S: return DataType::kInt8;
+    case CV_8U: return DataType::kUInt8;
+    case CV_16S: return DataType::kInt16;
+    case CV_16U: return DataType::kUInt16;
+    case CV_32S: return DataType::kInt32;
+    case CV_32F: return DataType::kFloat;
+    case CV_64F: return DataType::kDouble;
+    default: return DataType::kUnknown;
+  }
+}
+
+#pragma mark -
+#pragma mark NDArrayBuffer
+
+/**
+ *  @class  CvMatBuffer
+ *  @brief  Buffer holding a reference on an OpenCV matrix's data
+ *  @author Christophe Ecabert
+ *  @date   03.03.18
+ *  @ingroup core
+ */
+class CvMatBuffer : public NDArrayBuffer {
+ public:
+
+  /**
+   *  @name   CvMatBuffer
+   *  @fn     explicit CvMatBuffer(const cv::Mat& mat)
+   *  @brief  Constructor, share `mat`'s data
+   *  @param[in] mat  Continuous matrix
+   */
+  explicit CvMatBuffer(const cv::Mat& mat) : mat_(mat) {
+  }
+
+  /**
+   *  @name   CvMatBuffer
+   *  @fn     CvMatBuffer(const CvMatBuffer& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  CvMatBuffer(const CvMatBuffer& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     CvMatBuffer& operator=(const CvMatBuffer& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  CvMatBuffer& operator=(const CvMatBuffer& rhs) = delete;
+
+  /**
+   *  @name   data
+   *  @fn     void* data(void) const override
+   *  @brief  Pointer to the buffer storing data of a given `size` in bytes
+   *  @return Buffer address
+   */
+  void* data(void) const override {
+    return mat_.data;
+  }
+
+  /**
+   *  @name   size
+   *  @fn     size_t size(void) const override
+   *  @brief  Buffer dimension in bytes
+   *  @return Number of bytes in the buffer
+   */
+  size_t size(void) const override {
+    return mat_.total() * mat_.elemSize();
+  }
+
+  /**
+   *  @name   root
+   *  @fn     NDArrayBuffer* root(void) override
+   *  @brief  Provide reference to the buffer interface
+   */
+  NDArrayBuffer* root(void) override {
+    return this;
+  }
+
+#pragma mark Private
+ private:
+
+  /**
+   *  @name   ~CvMatBuffer
+   *  @fn     ~CvMatBuffer(void) override
+   *  @brief  Destructor, release reference on the matrix
+   */
+  ~CvMatBuffer(void) override = default;
+
+  /** Matrix */
+  cv::Mat mat_;
+};
+
+#pragma mark -
+#pragma mark NDArray
+
+/*
+ *  @name   AsCvMat
+ *  @fn     Status AsCvMat(cv::Mat* mat) const
+ *  @brief  Expose this array as an OpenCV matrix sharing the same buffer.
+ *          The buffer stays alive as long as either of them references it.
+ *          Rank-1 arrays map to a column, rank-2 to a matrix and rank-3
+ *          arrays (h, w, c) to a `c` channels matrix.
+ *  @param[out] mat Matrix sharing this array's buffer
+ *  @return kInvalidArgument if type or rank can not be represented
+ */
+Status NDArray::AsCvMat(cv::Mat* mat) const {
+  const int depth = ToCvDepth(type_);
+  if (depth < 0) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Data type has no OpenCV equivalent");
+  }
+  if (!IsContiguous()) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Only contiguous array can be mapped to OpenCV matrix");
+  }
+  if (!IsInitialized()) {
+    mat->release();
+    return Status();
+  }
+  int rows = 1, cols = 1, cn = 1;
+  switch (dims_.dims()) {
+    case 0: break;
+    case 1: rows = static_cast<int>(dims_.dim_size(0));
+      break;
+    case 2: rows = static_cast<int>(dims_.dim_size(0));
+      cols = static_cast<int>(dims_.dim_size(1));
+      break;
+    case 3: rows = static_cast<int>(dims_.dim_size(0));
+      cols = static_cast<int>(dims_.dim_size(1));
+      cn = static_cast<int>(dims_.dim_size(2));
+      if (cn > CV_CN_MAX) {
+        return Status(Status::Type::kInvalidArgument,
+                      "Too many channels for OpenCV matrix");
+      }
+      break;
+    default:
+      return Status(Status::Type::kInvalidArgument,
+                    "Only arrays up to rank-3 can be mapped to OpenCV matrix");
+  }
+  // Wrap buffer and attach it to the matrix, released by `MatAllocator`
+  cv::Mat m(rows, cols, CV_MAKETYPE(depth, cn), buffer_->data());
+  cv::UMatData* u = new cv::UMatData(MatAllocator());
+  u->data = u->origdata = m.data;
+  u->size = m.total() * m.elemSize();
+  u->userdata = buffer_.get();
+  u->refcount = 1;
+  buffer_->IncAlias();
+  m.u = u;
+  m.allocator = MatAllocator();
+  *mat = m;
+  return Status();
+}
+
+/*
+ *  @name   FromCvMat
+ *  @fn     Status FromCvMat(const cv::Mat& mat)
+ *  @brief  Back this array with the buffer of a continuous OpenCV matrix,
+ *          without copy. Multi-channels matrices give rank-3 arrays.
+ *  @param[in] mat  Matrix to share the buffer with
+ *  @return kInvalidArgument if `mat` is not continuous or its depth is not
+ *          supported
+ */
+Status NDArray::FromCvMat(const cv::Mat& mat) {
+  const DataType type = FromCvDepth(mat.depth());
+  if (type == DataType::kUnknown) {
+    return Status(Status::Type::kInvalidArgument,
+                  "OpenCV depth not supported");
+  }
+  if (mat.empty() || !mat.isContinuous()) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Only non-empty continuous matrix can be shared");
+  }
+  NDArrayDims dims;
+  for (int i = 0; i < mat.dims; ++i) {
+    dims.AddDim(static_cast<size_t>(mat.size[i]));
+  }
+  if (mat.channels() > 1) {
+    dims.AddDim(static_cast<size_t>(mat.channels()));
+  }
+  // Matrix coming from an NDArray, share the original buffer directly
+  RefPtr<NDArrayBuffer> buff;
+  const size_t n_bytes = mat.total() * mat.elemSize();
+  if (mat.u && mat.u->currAllocator == MatAllocator()) {
+    auto* b = reinterpret_cast<NDArrayBuffer*>(mat.u->userdata);
+    if (b->data() == mat.data && b->size() == n_bytes) {
+      buff = RefPtr<NDArrayBuffer>::Share(b);
+    }
+  }
+  if (!buff) {
+    buff.reset(new CvMatBuffer(mat));
+  }
+  buffer_ = std::move(buff);
+  dims_ = dims;
+  strides_.clear();
+  type_ = type;
+  return Status();
+}
+
+}  // namespace FaceKit
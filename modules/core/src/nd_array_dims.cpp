@@ -33,7 +33,9 @@ namespace FaceKit {
  *  @fn     NDArrayDims(void)
  *  @brief  Constructor
  */
-NDArrayDims::NDArrayDims(void) : dims_({0, 0, 0, 0, 0}), n_elem_(1) {}
+NDArrayDims::NDArrayDims(void) : n_elem_(1) {
+  dims_.fill(0);
+}
   
 /*
  *  @name   NDArrayDims
@@ -134,20 +136,14 @@ void NDArrayDims::AddDim(const size_t& dim) {
  *  @param[in]  axis  Dimension to remove
  */
 void NDArrayDims::RemoveDim(const size_t& axis) {
-  if (axis < kMaxDim) {
-    std::vector<size_t> dim(kMaxDim + 1, 0);
-    auto it = dim.begin();
-    // Copy only dimensions not being remove
-    const size_t& d = dims_[kMaxDim];
-    for (size_t i = 0; i < d; ++i) {
-      if (i != axis) {
-        *it = dims_[i];
-        ++it;
-      }
+  size_t& d = dims_[kMaxDim];
+  if (axis < d) {
+    // Shift remaining dimensions in place
+    for (size_t i = axis + 1; i < d; ++i) {
+      dims_[i - 1] = dims_[i];
     }
-    // Update dimensions
-    dim[kMaxDim] = dims_[kMaxDim] - 1;
-    std::move(dim.begin(), dim.end(), dims_.begin());
+    d -= 1;
+    dims_[d] = 0;
     this->ComputeNElement();
   }
 }
@@ -158,7 +154,7 @@ void NDArrayDims::RemoveDim(const size_t& axis) {
  *  @brief  Clear dimensions stored
  */
 void NDArrayDims::Clear(void) {
-  dims_ = {0, 0, 0, 0, 0};
+  dims_.fill(0);
   n_elem_ = 1;
 }
   
@@ -0,0 +1,890 @@
+/**
+ *  @file   nd_array_ops.cpp
+ *  @brief  Element-wise operations on NDArray with runtime selected SIMD
+ *          kernels and lazy expressions
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   05.03.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define HAS_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAS_NEON
+#include <arm_neon.h>
+#endif
+
+#include "facekit/core/math/nd_array_ops.hpp"
+#include "facekit/core/sys/cpu_info.hpp"
+#include "nd_array_ops_kernels.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+namespace internal {
+
+#pragma mark -
+#pragma mark Vector traits
+
+/** Plain C++ traits, one element at a time */
+template<typename T>
+struct ScalarTraits {
+  using Type = T;
+  using Reg = T;
+  static constexpr size_t kWidth = 1;
+  static Reg Load(const T* p) { return *p; }
+  static void Store(T* p, const Reg& v) { *p = v; }
+  static Reg Set(const T& v) { return v; }
+  static Reg Add(const Reg& a, const Reg& b) { return a + b; }
+  static Reg Mul(const Reg& a, const Reg& b) { return a * b; }
+  static Reg Fma(const Reg& a, const Reg& b, const Reg& c) {
+    return a * b + c;
+  }
+  static Reg Min(const Reg& a, const Reg& b) { return b < a ? b : a; }
+  static Reg Max(const Reg& a, const Reg& b) { return a < b ? b : a; }
+  static Reg Sub(const Reg& a, const Reg& b) { return a - b; }
+  static Reg Div(const Reg& a, const Reg& b) { return a / b; }
+  static Reg Sqrt(const Reg& a) { return std::sqrt(a); }
+};
+
+#ifdef HAS_SSE2
+/** SSE2 single precision traits */
+struct Sse2F32 {
+  using Type = float;
+  using Reg = __m128;
+  static constexpr size_t kWidth = 4;
+  static Reg Load(const float* p) { return _mm_loadu_ps(p); }
+  static void Store(float* p, const Reg& v) { _mm_storeu_ps(p, v); }
+  static Reg Set(const float& v) { return _mm_set1_ps(v); }
+  static Reg Add(const Reg& a, const Reg& b) { return _mm_add_ps(a, b); }
+  static Reg Mul(const Reg& a, const Reg& b) { return _mm_mul_ps(a, b); }
+  static Reg Fma(const Reg& a, const Reg& b, const Reg& c) {
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+  }
+  static Reg Min(const Reg& a, const Reg& b) { return _mm_min_ps(a, b); }
+  static Reg Max(const Reg& a, const Reg& b) { return _mm_max_ps(a, b); }
+  static Reg Sub(const Reg& a, const Reg& b) { return _mm_sub_ps(a, b); }
+  static Reg Div(const Reg& a, const Reg& b) { return _mm_div_ps(a, b); }
+  static Reg Sqrt(const Reg& a) { return _mm_sqrt_ps(a); }
+};
+
+/** SSE2 double precision traits */
+struct Sse2F64 {
+  using Type = double;
+  using Reg = __m128d;
+  static constexpr size_t kWidth = 2;
+  static Reg Load(const double* p) { return _mm_loadu_pd(p); }
+  static void Store(double* p, const Reg& v) { _mm_storeu_pd(p, v); }
+  static Reg Set(const double& v) { return _mm_set1_pd(v); }
+  static Reg Add(const Reg& a, const Reg& b) { return _mm_add_pd(a, b); }
+  static Reg Mul(const Reg& a, const Reg& b) { return _mm_mul_pd(a, b); }
+  static Reg Fma(const Reg& a, const Reg& b, const Reg& c) {
+    return _mm_add_pd(_mm_mul_pd(a, b), c);
+  }
+  static Reg Min(const Reg& a, const Reg& b) { return _mm_min_pd(a, b); }
+  static Reg Max(const Reg& a, const Reg& b) { return _mm_max_pd(a, b); }
+  static Reg Sub(const Reg& a, const Reg& b) { return _mm_sub_pd(a, b); }
+  static Reg Div(const Reg& a, const Reg& b) { return _mm_div_pd(a, b); }
+  static Reg Sqrt(const Reg& a) { return _mm_sqrt_pd(a); }
+};
+
+/** Load 4 x uint8 as float */
+static __m128 Sse2LoadU8(const uint8_t* src) {
+  int32_t w;
+  std::memcpy(&w, src, sizeof(w));
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i v = _mm_unpacklo_epi8(_mm_cvtsi32_si128(w), zero);
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+}
+
+/** Load 4 x uint16 as float */
+static __m128 Sse2LoadU16(const uint16_t* src) {
+  const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, _mm_setzero_si128()));
+}
+
+/** Round 4 floats clamped to [0, hi] to int32 */
+static __m128i Sse2RoundClamp(const __m128& v, const __m128& hi) {
+  return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), hi));
+}
+
+static void Sse2U8ToF32(const uint8_t* src, const float alpha,
+                        const float beta, float* dst, const size_t& n) {
+  const __m128 va = _mm_set1_ps(alpha);
+  const __m128 vb = _mm_set1_ps(beta);
+  const size_t nv = n - (n % 4);
+  size_t i = 0;
+  for (; i < nv; i += 4) {
+    _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(Sse2LoadU8(src + i), va),
+                                      vb));
+  }
+  ScaleConvert<uint8_t, float, float>(src + i, alpha, beta, dst + i, n - i);
+}
+
+static void Sse2U16ToF32(const uint16_t* src, const float alpha,
+                         const float beta, float* dst, const size_t& n) {
+  const __m128 va = _mm_set1_ps(alpha);
+  const __m128 vb = _mm_set1_ps(beta);
+  const size_t nv = n - (n % 4);
+  size_t i = 0;
+  for (; i < nv; i += 4) {
+    _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(Sse2LoadU16(src + i), va),
+                                      vb));
+  }
+  ScaleConvert<uint16_t, float, float>(src + i, alpha, beta, dst + i, n - i);
+}
+
+static void Sse2F32ToU8(const float* src, const float alpha,
+                        const float beta, uint8_t* dst, const size_t& n) {
+  const __m128 va = _mm_set1_ps(alpha);
+  const __m128 vb = _mm_set1_ps(beta);
+  const __m128 hi = _mm_set1_ps(255.f);
+  const size_t nv = n - (n % 8);
+  size_t i = 0;
+  for (; i < nv; i += 8) {
+    const __m128 v0 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i), va), vb);
+    const __m128 v1 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), va),
+                                 vb);
+    const __m128i w = _mm_packs_epi32(Sse2RoundClamp(v0, hi),
+                                      Sse2RoundClamp(v1, hi));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(w, w));
+  }
+  ScaleConvert<float, uint8_t, float>(src + i, alpha, beta, dst + i, n - i);
+}
+
+static void Sse2F32ToU16(const float* src, const float alpha,
+                         const float beta, uint16_t* dst, const size_t& n) {
+  const __m128 va = _mm_set1_ps(alpha);
+  const __m128 vb = _mm_set1_ps(beta);
+  const __m128 hi = _mm_set1_ps(65535.f);
+  // No unsigned saturation for 32 bits in SSE2, shift into int16 range
+  const __m128i shift32 = _mm_set1_epi32(32768);
+  const __m128i shift16 = _mm_set1_epi16(-32768);
+  const size_t nv = n - (n % 8);
+  size_t i = 0;
+  for (; i < nv; i += 8) {
+    const __m128 v0 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i), va), vb);
+    const __m128 v1 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), va),
+                                 vb);
+    const __m128i r0 = _mm_sub_epi32(Sse2RoundClamp(v0, hi), shift32);
+    const __m128i r1 = _mm_sub_epi32(Sse2RoundClamp(v1, hi), shift32);
+    const __m128i w = _mm_xor_si128(_mm_packs_epi32(r0, r1), shift16);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), w);
+  }
+  ScaleConvert<float, uint16_t, float>(src + i, alpha, beta, dst + i, n - i);
+}
+#endif
+
+#ifdef HAS_NEON
+/** NEON single precision traits */
+struct NeonF32 {
+  using Type = float;
+  using Reg = float32x4_t;
+  static constexpr size_t kWidth = 4;
+  static Reg Load(const float* p) { return vld1q_f32(p); }
+  static void Store(float* p, const Reg& v) { vst1q_f32(p, v); }
+  static Reg Set(const float& v) { return vdupq_n_f32(v); }
+  static Reg Add(const Reg& a, const Reg& b) { return vaddq_f32(a, b); }
+  static Reg Mul(const Reg& a, const Reg& b) { return vmulq_f32(a, b); }
+  static Reg Fma(const Reg& a, const Reg& b, const Reg& c) {
+    return vmlaq_f32(c, a, b);
+  }
+  static Reg Min(const Reg& a, const Reg& b) { return vminq_f32(a, b); }
+  static Reg Max(const Reg& a, const Reg& b) { return vmaxq_f32(a, b); }
+  static Reg Sub(const Reg& a, const Reg& b) { return vsubq_f32(a, b); }
+#if defined(__aarch64__)
+  static Reg Div(const Reg& a, const Reg& b) { return vdivq_f32(a, b); }
+  static Reg Sqrt(const Reg& a) { return vsqrtq_f32(a); }
+#endif
+};
+
+#if defined(__aarch64__)
+/** NEON double precision traits */
+struct NeonF64 {
+  using Type = double;
+  using Reg = float64x2_t;
+  static constexpr size_t kWidth = 2;
+  static Reg Load(const double* p) { return vld1q_f64(p); }
+  static void Store(double* p, const Reg& v) { vst1q_f64(p, v); }
+  static Reg Set(const double& v) { return vdupq_n_f64(v); }
+  static Reg Add(const Reg& a, const Reg& b) { return vaddq_f64(a, b); }
+  static Reg Mul(const Reg& a, const Reg& b) { return vmulq_f64(a, b); }
+  static Reg Fma(const Reg& a, const Reg& b, const Reg& c) {
+    return vfmaq_f64(c, a, b);
+  }
+  static Reg Min(const Reg& a, const Reg& b) { return vminq_f64(a, b); }
+  static Reg Max(const Reg& a, const Reg& b) { return vmaxq_f64(a, b); }
+  static Reg Sub(const Reg& a, const Reg& b) { return vsubq_f64(a, b); }
+  static Reg Div(const Reg& a, const Reg& b) { return vdivq_f64(a, b); }
+  static Reg Sqrt(const Reg& a) { return vsqrtq_f64(a); }
+};
+#endif
+#endif
+
+#pragma mark -
+#pragma mark Dispatch
+
+/**
+ *  @struct  KernelSet
+ *  @brief  Kernels selected for this CPU
+ */
+struct KernelSet {
+  /** Instruction set */
+  NDArrayOps::SimdLevel level;
+  /** Single precision */
+  OpsKernels<float> f32;
+  /** Double precision */
+  OpsKernels<double> f64;
+  /** Conversions */
+  ConvertKernels cvt;
+  /** Single precision structure of arrays */
+  SoaKernels<float> soa32;
+  /** Double precision structure of arrays */
+  SoaKernels<double> soa64;
+  /** Quantized rows */
+  QuantKernels quant;
+
+  /** Constructor, pick the widest available instruction set */
+  KernelSet(void) : level(NDArrayOps::SimdLevel::kScalar),
+                    f32(SimdKernels<ScalarTraits<float>>::Table()),
+                    f64(SimdKernels<ScalarTraits<double>>::Table()),
+                    cvt(ConvertKernels::Scalar()),
+                    soa32(SimdSoaKernels<ScalarTraits<float>>::Table()),
+                    soa64(SimdSoaKernels<ScalarTraits<double>>::Table()),
+                    quant(QuantKernels::Scalar()) {
+#ifdef HAS_SSE2
+    level = NDArrayOps::SimdLevel::kSse2;
+    f32 = SimdKernels<Sse2F32>::Table();
+    f64 = SimdKernels<Sse2F64>::Table();
+    cvt.u8_to_f32 = &Sse2U8ToF32;
+    cvt.u16_to_f32 = &Sse2U16ToF32;
+    cvt.f32_to_u8 = &Sse2F32ToU8;
+    cvt.f32_to_u16 = &Sse2F32ToU16;
+    soa32 = SimdSoaKernels<Sse2F32>::Table();
+    soa64 = SimdSoaKernels<Sse2F64>::Table();
+#endif
+#ifdef HAS_NEON
+    level = NDArrayOps::SimdLevel::kNeon;
+    f32 = SimdKernels<NeonF32>::Table();
+#if defined(__aarch64__)
+    f64 = SimdKernels<NeonF64>::Table();
+    soa32 = SimdSoaKernels<NeonF32>::Table();
+    soa64 = SimdSoaKernels<NeonF64>::Table();
+#endif
+#endif
+    using Feature = CpuInfo::Feature;
+    if (CpuInfo::Get().Has(Feature::kAvx2 | Feature::kFma | Feature::kF16c)) {
+      OpsKernels<float> k32;
+      OpsKernels<double> k64;
+      ConvertKernels kcvt;
+      SoaKernels<float> ks32;
+      SoaKernels<double> ks64;
+      QuantKernels kq;
+      if (Avx2Kernels(&k32, &k64, &kcvt, &ks32, &ks64, &kq)) {
+        level = NDArrayOps::SimdLevel::kAvx2;
+        f32 = k32;
+        f64 = k64;
+        cvt = kcvt;
+        soa32 = ks32;
+        soa64 = ks64;
+        quant = kq;
+      }
+    }
+  }
+};
+
+/**
+ *  @name   Kernels
+ *  @fn     static const KernelSet& Kernels(void)
+ *  @brief  Kernels selected for this CPU, detected on first use
+ *  @return Kernels
+ */
+static const KernelSet& Kernels(void) {
+  static const KernelSet kernels;
+  return kernels;
+}
+
+/**
+ *  @struct  Typed
+ *  @brief  Kernels for a given type, generic types use plain loops
+ *  @tparam T Data type
+ */
+template<typename T>
+struct Typed {
+  static OpsKernels<T> Get(void) {
+    return SimdKernels<ScalarTraits<T>>::Table();
+  }
+};
+
+template<>
+struct Typed<float> {
+  static OpsKernels<float> Get(void) {
+    return Kernels().f32;
+  }
+};
+
+template<>
+struct Typed<double> {
+  static OpsKernels<double> Get(void) {
+    return Kernels().f64;
+  }
+};
+
+/*
+ *  @name   SelectedSoaKernels
+ *  @fn     template<typename T> const SoaKernels<T>& SelectedSoaKernels(void)
+ *  @brief  Structure of arrays kernels picked for this CPU
+ *  @tparam T Data type, float or double
+ *  @return Kernels
+ */
+template<>
+const SoaKernels<float>& SelectedSoaKernels<float>(void) {
+  return Kernels().soa32;
+}
+template<>
+const SoaKernels<double>& SelectedSoaKernels<double>(void) {
+  return Kernels().soa64;
+}
+
+/*
+ *  @name   SelectedOpsKernels
+ *  @fn     template<typename T> const OpsKernels<T>& SelectedOpsKernels(void)
+ *  @brief  Element-wise kernels picked for this CPU
+ *  @tparam T Data type, float or double
+ *  @return Kernels
+ */
+template<>
+const OpsKernels<float>& SelectedOpsKernels<float>(void) {
+  return Kernels().f32;
+}
+template<>
+const OpsKernels<double>& SelectedOpsKernels<double>(void) {
+  return Kernels().f64;
+}
+
+/*
+ *  @name   SelectedQuantKernels
+ *  @fn     const QuantKernels& SelectedQuantKernels(void)
+ *  @brief  Quantized kernels picked for this CPU
+ *  @return Kernels
+ */
+const QuantKernels& SelectedQuantKernels(void) {
+  return Kernels().quant;
+}
+
+}  // namespace internal
+
+#pragma mark -
+#pragma mark Utility function
+
+/** Dispatch over numeric types */
+#define NUMERIC_CASE(TYPE, CASE_CODE)   \
+  case DataTypeToEnum<TYPE>::value: {   \
+    using T = TYPE;                     \
+    CASE_CODE;                          \
+  }                                     \
+    break;
+/** Run `CCODE` with `T` set to the numeric type of `TYPE_ENUM` */
+#define NUMERIC_SWITCH(TYPE_ENUM, CCODE, DEFAULT)                   \
+  switch(TYPE_ENUM) {                                               \
+    NUMERIC_CASE(int8_t, CCODE)                                     \
+    NUMERIC_CASE(uint8_t, CCODE)                                    \
+    NUMERIC_CASE(int16_t, CCODE)                                    \
+    NUMERIC_CASE(uint16_t, CCODE)                                   \
+    NUMERIC_CASE(int32_t, CCODE)                                    \
+    NUMERIC_CASE(uint32_t, CCODE)                                   \
+    NUMERIC_CASE(int64_t, CCODE)                                    \
+    NUMERIC_CASE(uint64_t, CCODE)                                   \
+    NUMERIC_CASE(float, CCODE)                                      \
+    NUMERIC_CASE(double, CCODE)                                     \
+    default:                                                        \
+      DEFAULT;                                                      \
+      break;                                                        \
+  }
+
+/** Dispatch over types supported by conversions */
+#define CONVERT_SWITCH(TYPE_ENUM, CCODE, DEFAULT)                   \
+  switch(TYPE_ENUM) {                                               \
+    NUMERIC_CASE(int8_t, CCODE)                                     \
+    NUMERIC_CASE(uint8_t, CCODE)                                    \
+    NUMERIC_CASE(int16_t, CCODE)                                    \
+    NUMERIC_CASE(uint16_t, CCODE)                                   \
+    NUMERIC_CASE(int32_t, CCODE)                                    \
+    NUMERIC_CASE(uint32_t, CCODE)                                   \
+    NUMERIC_CASE(int64_t, CCODE)                                    \
+    NUMERIC_CASE(uint64_t, CCODE)                                   \
+    NUMERIC_CASE(float, CCODE)                                      \
+    NUMERIC_CASE(double, CCODE)                                     \
+    NUMERIC_CASE(Half, CCODE)                                       \
+    default:                                                        \
+      DEFAULT;                                                      \
+      break;                                                        \
+  }
+
+/**
+ *  @name   IsNumeric
+ *  @fn     static bool IsNumeric(const DataType& type)
+ *  @brief  Check if a type is supported by the kernels
+ *  @param[in] type Data type
+ *  @return True if numeric
+ */
+static bool IsNumeric(const DataType& type) {
+  return type != DataType::kUnknown &&
+         type != DataType::kBool &&
+         type != DataType::kString &&
+         type != DataType::kHalf;
+}
+
+/**
+ *  @name   IsConvertible
+ *  @fn     static bool IsConvertible(const DataType& type)
+ *  @brief  Check if a type is supported by the conversions
+ *  @param[in] type Data type
+ *  @return True if numeric or half
+ */
+static bool IsConvertible(const DataType& type) {
+  return IsNumeric(type) || type == DataType::kHalf;
+}
+
+/**
+ *  @name   CheckOperands
+ *  @fn     static Status CheckOperands(const NDArray& a, const NDArray& b)
+ *  @brief  Check that two operands have same type and dimensions
+ *  @param[in] a  First operand
+ *  @param[in] b  Second operand
+ *  @return kInvalidArgument if they do not match
+ */
+static Status CheckOperands(const NDArray& a, const NDArray& b) {
+  if (!IsNumeric(a.type())) {
+    return Status(Status::Type::kInvalidArgument, "Type is not numeric");
+  }
+  if (a.type() != b.type()) {
+    return Status(Status::Type::kInvalidArgument, "Types do not match");
+  }
+  if (a.dimensions() != b.dimensions()) {
+    return Status(Status::Type::kInvalidArgument, "Dimensions do not match");
+  }
+  return Status();
+}
+
+/**
+ *  @name   Contiguous
+ *  @fn     static const NDArray& Contiguous(const NDArray& a, NDArray* tmp)
+ *  @brief  Give a contiguous version of `a`, copied into `tmp` if needed
+ *  @param[in] a    Array
+ *  @param[in] tmp  Storage for the copy
+ *  @return Contiguous array
+ */
+static const NDArray& Contiguous(const NDArray& a, NDArray* tmp) {
+  if (a.IsContiguous()) {
+    return a;
+  }
+  a.DeepCopy(tmp);
+  return *tmp;
+}
+
+/**
+ *  @name   PrepareOutput
+ *  @fn     static void PrepareOutput(const NDArray& a, NDArray* out)
+ *  @brief  Make `out` a contiguous array with `a`'s type and dimensions
+ *  @param[in] a      Reference array
+ *  @param[out] out   Array to prepare
+ */
+static void PrepareOutput(const NDArray& a, NDArray* out) {
+  if (out->type() != a.type() || !out->IsContiguous() ||
+      !out->IsInitialized() ||
+      out->dimensions() != a.dimensions()) {
+    out->Resize(a.type(), a.dimensions());
+  }
+}
+
+/**
+ *  @name   Data
+ *  @fn     template<typename T> static const T* Data(const NDArray& a)
+ *  @brief  Contiguous data of an array
+ *  @param[in] a  Array
+ *  @return Data pointer
+ */
+template<typename T>
+static const T* Data(const NDArray& a) {
+  return a.AsFlat<T>().data();
+}
+
+#pragma mark -
+#pragma mark Operations
+
+/*
+ *  @name   Add
+ *  @fn     static Status Add(const NDArray& a, const NDArray& b,
+                              NDArray* out)
+ *  @brief  Compute out = a + b
+ *  @param[in] a    First operand
+ *  @param[in] b    Second operand
+ *  @param[out] out Result
+ *  @return kInvalidArgument if operands do not match or type is not
+ *          numeric
+ */
+Status NDArrayOps::Add(const NDArray& a, const NDArray& b, NDArray* out) {
+  Status s = CheckOperands(a, b);
+  if (s.Good() && a.n_elems() > 0) {
+    NDArray ta, tb;
+    const NDArray& ca = Contiguous(a, &ta);
+    const NDArray& cb = Contiguous(b, &tb);
+    PrepareOutput(ca, out);
+    NUMERIC_SWITCH(a.type(),
+                   internal::Typed<T>::Get().add(Data<T>(ca),
+                                                 Data<T>(cb),
+                                                 out->AsFlat<T>().data(),
+                                                 a.n_elems()),
+                   );
+  }
+  return s;
+}
+
+/*
+ *  @name   Mul
+ *  @fn     static Status Mul(const NDArray& a, const NDArray& b,
+                              NDArray* out)
+ *  @brief  Compute out = a * b
+ *  @param[in] a    First operand
+ *  @param[in] b    Second operand
+ *  @param[out] out Result
+ *  @return kInvalidArgument if operands do not match or type is not
+ *          numeric
+ */
+Status NDArrayOps::Mul(const NDArray& a, const NDArray& b, NDArray* out) {
+  Status s = CheckOperands(a, b);
+  if (s.Good() && a.n_elems() > 0) {
+    NDArray ta, tb;
+    const NDArray& ca = Contiguous(a, &ta);
+    const NDArray& cb = Contiguous(b, &tb);
+    PrepareOutput(ca, out);
+    NUMERIC_SWITCH(a.type(),
+                   internal::Typed<T>::Get().mul(Data<T>(ca),
+                                                 Data<T>(cb),
+                                                 out->AsFlat<T>().data(),
+                                                 a.n_elems()),
+                   );
+  }
+  return s;
+}
+
+/*
+ *  @name   Fma
+ *  @fn     static Status Fma(const NDArray& a, const NDArray& b,
+                              const NDArray& c, NDArray* out)
+ *  @brief  Compute out = a * b + c in a single pass
+ *  @param[in] a    First operand
+ *  @param[in] b    Second operand
+ *  @param[in] c    Third operand
+ *  @param[out] out Result
+ *  @return kInvalidArgument if operands do not match or type is not
+ *          numeric
+ */
+Status NDArrayOps::Fma(const NDArray& a,
+                       const NDArray& b,
+                       const NDArray& c,
+                       NDArray* out) {
+  Status s = CheckOperands(a, b);
+  if (s.Good()) {
+    s = CheckOperands(a, c);
+  }
+  if (s.Good() && a.n_elems() > 0) {
+    NDArray ta, tb, tc;
+    const NDArray& ca = Contiguous(a, &ta);
+    const NDArray& cb = Contiguous(b, &tb);
+    const NDArray& cc = Contiguous(c, &tc);
+    PrepareOutput(ca, out);
+    NUMERIC_SWITCH(a.type(),
+                   internal::Typed<T>::Get().fma(Data<T>(ca),
+                                                 Data<T>(cb),
+                                                 Data<T>(cc),
+                                                 out->AsFlat<T>().data(),
+                                                 a.n_elems()),
+                   );
+  }
+  return s;
+}
+
+/*
+ *  @name   Scale
+ *  @fn     static Status Scale(const NDArray& a, const double& alpha,
+                                const double& beta, NDArray* out)
+ *  @brief  Compute out = alpha * a + beta
+ *  @param[in] a      Operand
+ *  @param[in] alpha  Scaling factor
+ *  @param[in] beta   Offset
+ *  @param[out] out   Result
+ *  @return kInvalidArgument if type is not numeric
+ */
+Status NDArrayOps::Scale(const NDArray& a,
+                         const double& alpha,
+                         const double& beta,
+                         NDArray* out) {
+  if (!IsNumeric(a.type())) {
+    return Status(Status::Type::kInvalidArgument, "Type is not numeric");
+  }
+  if (a.n_elems() > 0) {
+    NDArray ta;
+    const NDArray& ca = Contiguous(a, &ta);
+    PrepareOutput(ca, out);
+    NUMERIC_SWITCH(a.type(),
+                   internal::Typed<T>::Get().scale(Data<T>(ca),
+                                                   static_cast<T>(alpha),
+                                                   static_cast<T>(beta),
+                                                   out->AsFlat<T>().data(),
+                                                   a.n_elems()),
+                   );
+  }
+  return Status();
+}
+
+/*
+ *  @name   Clamp
+ *  @fn     static Status Clamp(const NDArray& a, const double& lo,
+                                const double& hi, NDArray* out)
+ *  @brief  Compute out = min(max(a, lo), hi)
+ *  @param[in] a    Operand
+ *  @param[in] lo   Lower bound
+ *  @param[in] hi   Upper bound
+ *  @param[out] out Result
+ *  @return kInvalidArgument if type is not numeric or lo > hi
+ */
+Status NDArrayOps::Clamp(const NDArray& a,
+                         const double& lo,
+                         const double& hi,
+                         NDArray* out) {
+  if (!IsNumeric(a.type())) {
+    return Status(Status::Type::kInvalidArgument, "Type is not numeric");
+  }
+  if (lo > hi) {
+    return Status(Status::Type::kInvalidArgument, "Lower bound > upper bound");
+  }
+  if (a.n_elems() > 0) {
+    NDArray ta;
+    const NDArray& ca = Contiguous(a, &ta);
+    PrepareOutput(ca, out);
+    NUMERIC_SWITCH(a.type(),
+                   internal::Typed<T>::Get().clamp(Data<T>(ca),
+                                                   static_cast<T>(lo),
+                                                   static_cast<T>(hi),
+                                                   out->AsFlat<T>().data(),
+                                                   a.n_elems()),
+                   );
+  }
+  return Status();
+}
+
+/**
+ *  @name   CastCopy
+ *  @fn     template<typename S, typename D> static void CastCopy(const S* src,
+                                                    D* dst, const size_t& n)
+ *  @brief  Copy `n` elements with static_cast
+ *  @param[in] src  Source
+ *  @param[out] dst Destination
+ *  @param[in] n    Number of elements
+ */
+template<typename S, typename D>
+static void CastCopy(const S* src, D* dst, const size_t& n) {
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = static_cast<D>(src[i]);
+  }
+}
+
+/**
+ *  @name   ConvertTo
+ *  @fn     template<typename D> static void ConvertTo(const NDArray& a,
+                                                       D* dst)
+ *  @brief  Convert a contiguous array into a buffer of type D
+ *  @param[in] a    Contiguous array
+ *  @param[out] dst Destination
+ */
+template<typename D>
+static void ConvertTo(const NDArray& a, D* dst) {
+  CONVERT_SWITCH(a.type(), CastCopy(Data<T>(a), dst, a.n_elems()), );
+}
+
+/**
+ *  @name   ScaleConvertTo
+ *  @fn     template<typename D> static void ScaleConvertTo(const NDArray& a,
+                                                const double& alpha,
+                                                const double& beta, D* dst)
+ *  @brief  Convert a contiguous array into a buffer of type D with scaling,
+ *          computed in double precision
+ *  @param[in] a      Contiguous array
+ *  @param[in] alpha  Scaling factor
+ *  @param[in] beta   Offset
+ *  @param[out] dst   Destination
+ */
+template<typename D>
+static void ScaleConvertTo(const NDArray& a,
+                           const double& alpha,
+                           const double& beta,
+                           D* dst) {
+  CONVERT_SWITCH(a.type(),
+                 internal::ScaleConvert(Data<T>(a),
+                                        alpha,
+                                        beta,
+                                        dst,
+                                        a.n_elems()),
+                 );
+}
+
+/**
+ *  @name   FastConvert
+ *  @fn     static bool FastConvert(const NDArray& a, const float& alpha,
+                                    const float& beta, NDArray* out)
+ *  @brief  Run vectorized conversion kernel if one exists for the pair of
+ *          types (u8/u16/f16 <-> f32)
+ *  @param[in] a      Contiguous array
+ *  @param[in] alpha  Scaling factor
+ *  @param[in] beta   Offset
+ *  @param[out] out   Destination, already allocated
+ *  @return True if a kernel has been used
+ */
+static bool FastConvert(const NDArray& a,
+                        const float& alpha,
+                        const float& beta,
+                        NDArray* out) {
+  const internal::ConvertKernels& k = internal::Kernels().cvt;
+  const size_t n = a.n_elems();
+  const DataType src = a.type();
+  const DataType dst = out->type();
+  if (dst == DataType::kFloat) {
+    float* d = out->AsFlat<float>().data();
+    switch (src) {
+      case DataType::kUInt8:  k.u8_to_f32(Data<uint8_t>(a), alpha, beta, d, n);
+        return true;
+      case DataType::kUInt16: k.u16_to_f32(Data<uint16_t>(a), alpha, beta, d,
+                                           n);
+        return true;
+      case DataType::kHalf: k.f16_to_f32(Data<Half>(a), alpha, beta, d, n);
+        return true;
+      default: return false;
+    }
+  } else if (src == DataType::kFloat) {
+    const float* s = Data<float>(a);
+    switch (dst) {
+      case DataType::kUInt8: k.f32_to_u8(s, alpha, beta,
+                                         out->AsFlat<uint8_t>().data(), n);
+        return true;
+      case DataType::kUInt16: k.f32_to_u16(s, alpha, beta,
+                                           out->AsFlat<uint16_t>().data(), n);
+        return true;
+      case DataType::kHalf: k.f32_to_f16(s, alpha, beta,
+                                         out->AsFlat<Half>().data(), n);
+        return true;
+      default: return false;
+    }
+  }
+  return false;
+}
+
+/*
+ *  @name   Convert
+ *  @fn     static Status Convert(const NDArray& a, const DataType& type,
+                                  NDArray* out)
+ *  @brief  Convert array to another numeric type (static_cast semantic)
+ *  @param[in] a    Operand
+ *  @param[in] type Target type
+ *  @param[out] out Result, can not alias `a`
+ *  @return kInvalidArgument if one of the types is not numeric
+ */
+Status NDArrayOps::Convert(const NDArray& a,
+                           const DataType& type,
+                           NDArray* out) {
+  if (!IsConvertible(a.type()) || !IsConvertible(type)) {
+    return Status(Status::Type::kInvalidArgument, "Type is not numeric");
+  }
+  if (&a == out) {
+    return Status(Status::Type::kInvalidArgument, "Output can not alias input");
+  }
+  NDArray ta;
+  const NDArray& ca = Contiguous(a, &ta);
+  out->Resize(type, ca.dimensions());
+  if (ca.n_elems() > 0) {
+    CONVERT_SWITCH(type, ConvertTo<T>(ca, out->AsFlat<T>().data()), );
+  }
+  return Status();
+}
+
+/*
+ *  @name   Convert
+ *  @fn     static Status Convert(const NDArray& a, const DataType& type,
+                                  const double& alpha, const double& beta,
+                                  NDArray* out)
+ *  @brief  Compute out = saturate(alpha * a + beta) converted to `type`.
+ *          Integers are rounded to nearest and clamped to their range.
+ *          uint8/uint16/half <-> float use vectorized kernels computing in
+ *          single precision, other pairs compute in double precision.
+ *  @param[in] a      Operand
+ *  @param[in] type   Target type
+ *  @param[in] alpha  Scaling factor
+ *  @param[in] beta   Offset
+ *  @param[out] out   Result, can not alias `a`
+ *  @return kInvalidArgument if one of the types is not numeric
+ */
+Status NDArrayOps::Convert(const NDArray& a,
+                           const DataType& type,
+                           const double& alpha,
+                           const double& beta,
+                           NDArray* out) {
+  if (!IsConvertible(a.type()) || !IsConvertible(type)) {
+    return Status(Status::Type::kInvalidArgument, "Type is not numeric");
+  }
+  if (&a == out) {
+    return Status(Status::Type::kInvalidArgument, "Output can not alias input");
+  }
+  NDArray ta;
+  const NDArray& ca = Contiguous(a, &ta);
+  out->Resize(type, ca.dimensions());
+  if (ca.n_elems() > 0 &&
+      !FastConvert(ca, static_cast<float>(alpha), static_cast<float>(beta),
+                   out)) {
+    CONVERT_SWITCH(type,
+                   ScaleConvertTo<T>(ca, alpha, beta, out->AsFlat<T>().data()),
+                   );
+  }
+  return Status();
+}
+
+#pragma mark -
+#pragma mark Accessors
+
+/*
+ *  @name   simd_level
+ *  @fn     static SimdLevel simd_level(void)
+ *  @brief  Instruction set selected for this CPU
+ *  @return SIMD level
+ */
+NDArrayOps::SimdLevel NDArrayOps::simd_level(void) {
+  return internal::Kernels().level;
+}
+
+/*
+ *  @name   simd_name
+ *  @fn     static std::string simd_name(void)
+ *  @brief  Name of the instruction set selected for this CPU
+ *  @return SIMD name
+ */
+std::string NDArrayOps::simd_name(void) {
+  switch (simd_level()) {
+    case SimdLevel::kSse2: return "SSE2";
+    case SimdLevel::kAvx2: return "AVX2";
+    case SimdLevel::kNeon: return "NEON";
+    default: return "Scalar";
+  }
+}
+
+}  // namespace FaceKit
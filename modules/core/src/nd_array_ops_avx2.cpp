@@ -0,0 +1,290 @@
+/**
+ *  @file   nd_array_ops_avx2.cpp
+ *  @brief  AVX2 element-wise kernels, this file is compiled with
+ *          AVX2/FMA/F16C enabled and only called after runtime detection.
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   05.03.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#if defined(__AVX2__) && (defined(__F16C__) || defined(_MSC_VER))
+#include <immintrin.h>
+#endif
+
+#include "nd_array_ops_kernels.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+namespace internal {
+
+#if defined(__AVX2__) && (defined(__F16C__) || defined(_MSC_VER))
+
+/** AVX2 single precision traits */
+struct Avx2F32 {
+  using Type = float;
+  using Reg = __m256;
+  static constexpr size_t kWidth = 8;
+  static Reg Load(const float* p) { return _mm256_loadu_ps(p); }
+  static void Store(float* p, const Reg& v) { _mm256_storeu_ps(p, v); }
+  static Reg Set(const float& v) { return _mm256_set1_ps(v); }
+  static Reg Add(const Reg& a, const Reg& b) { return _mm256_add_ps(a, b); }
+  static Reg Mul(const Reg& a, const Reg& b) { return _mm256_mul_ps(a, b); }
+  static Reg Fma(const Reg& a, const Reg& b, const Reg& c) {
+    return _mm256_fmadd_ps(a, b, c);
+  }
+  static Reg Min(const Reg& a, const Reg& b) { return _mm256_min_ps(a, b); }
+  static Reg Max(const Reg& a, const Reg& b) { return _mm256_max_ps(a, b); }
+  static Reg Sub(const Reg& a, const Reg& b) { return _mm256_sub_ps(a, b); }
+  static Reg Div(const Reg& a, const Reg& b) { return _mm256_div_ps(a, b); }
+  static Reg Sqrt(const Reg& a) { return _mm256_sqrt_ps(a); }
+};
+
+/** AVX2 double precision traits */
+struct Avx2F64 {
+  using Type = double;
+  using Reg = __m256d;
+  static constexpr size_t kWidth = 4;
+  static Reg Load(const double* p) { return _mm256_loadu_pd(p); }
+  static void Store(double* p, const Reg& v) { _mm256_storeu_pd(p, v); }
+  static Reg Set(const double& v) { return _mm256_set1_pd(v); }
+  static Reg Add(const Reg& a, const Reg& b) { return _mm256_add_pd(a, b); }
+  static Reg Mul(const Reg& a, const Reg& b) { return _mm256_mul_pd(a, b); }
+  static Reg Fma(const Reg& a, const Reg& b, const Reg& c) {
+    return _mm256_fmadd_pd(a, b, c);
+  }
+  static Reg Min(const Reg& a, const Reg& b) { return _mm256_min_pd(a, b); }
+  static Reg Max(const Reg& a, const Reg& b) { return _mm256_max_pd(a, b); }
+  static Reg Sub(const Reg& a, const Reg& b) { return _mm256_sub_pd(a, b); }
+  static Reg Div(const Reg& a, const Reg& b) { return _mm256_div_pd(a, b); }
+  static Reg Sqrt(const Reg& a) { return _mm256_sqrt_pd(a); }
+};
+
+#pragma mark -
+#pragma mark Conversion
+
+/** Load 8 x uint8 as float */
+static __m256 LoadU8(const uint8_t* src) {
+  const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+  return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v));
+}
+
+/** Load 8 x uint16 as float */
+static __m256 LoadU16(const uint16_t* src) {
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(v));
+}
+
+/** Load 8 x half as float */
+static __m256 LoadF16(const Half* src) {
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  return _mm256_cvtph_ps(v);
+}
+
+/** Round 8 floats clamped to [0, hi] to int32 */
+static __m256i RoundClamp(const __m256& v, const __m256& hi) {
+  const __m256 c = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), hi);
+  return _mm256_cvtps_epi32(c);
+}
+
+static void U8ToF32(const uint8_t* src, const float alpha, const float beta,
+                    float* dst, const size_t& n) {
+  const __m256 va = _mm256_set1_ps(alpha);
+  const __m256 vb = _mm256_set1_ps(beta);
+  const size_t nv = n - (n % 8);
+  size_t i = 0;
+  for (; i < nv; i += 8) {
+    _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(LoadU8(src + i), va, vb));
+  }
+  ScaleConvert<uint8_t, float, float>(src + i, alpha, beta, dst + i, n - i);
+}
+
+static void U16ToF32(const uint16_t* src, const float alpha, const float beta,
+                     float* dst, const size_t& n) {
+  const __m256 va = _mm256_set1_ps(alpha);
+  const __m256 vb = _mm256_set1_ps(beta);
+  const size_t nv = n - (n % 8);
+  size_t i = 0;
+  for (; i < nv; i += 8) {
+    _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(LoadU16(src + i), va, vb));
+  }
+  ScaleConvert<uint16_t, float, float>(src + i, alpha, beta, dst + i, n - i);
+}
+
+static void F16ToF32(const Half* src, const float alpha, const float beta,
+                     float* dst, const size_t& n) {
+  const __m256 va = _mm256_set1_ps(alpha);
+  const __m256 vb = _mm256_set1_ps(beta);
+  const size_t nv = n - (n % 8);
+  size_t i = 0;
+  for (; i < nv; i += 8) {
+    _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(LoadF16(src + i), va, vb));
+  }
+  ScaleConvert<Half, float, float>(src + i, alpha, beta, dst + i, n - i);
+}
+
+static void F32ToU8(const float* src, const float alpha, const float beta,
+                    uint8_t* dst, const size_t& n) {
+  const __m256 va = _mm256_set1_ps(alpha);
+  const __m256 vb = _mm256_set1_ps(beta);
+  const __m256 hi = _mm256_set1_ps(255.f);
+  const size_t nv = n - (n % 8);
+  size_t i = 0;
+  for (; i < nv; i += 8) {
+    const __m256 v = _mm256_fmadd_ps(_mm256_loadu_ps(src + i), va, vb);
+    const __m256i r = RoundClamp(v, hi);
+    const __m128i w = _mm_packs_epi32(_mm256_castsi256_si128(r),
+                                      _mm256_extracti128_si256(r, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(w, w));
+  }
+  ScaleConvert<float, uint8_t, float>(src + i, alpha, beta, dst + i, n - i);
+}
+
+static void F32ToU16(const float* src, const float alpha, const float beta,
+                     uint16_t* dst, const size_t& n) {
+  const __m256 va = _mm256_set1_ps(alpha);
+  const __m256 vb = _mm256_set1_ps(beta);
+  const __m256 hi = _mm256_set1_ps(65535.f);
+  const size_t nv = n - (n % 8);
+  size_t i = 0;
+  for (; i < nv; i += 8) {
+    const __m256 v = _mm256_fmadd_ps(_mm256_loadu_ps(src + i), va, vb);
+    const __m256i r = RoundClamp(v, hi);
+    const __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(r),
+                                       _mm256_extracti128_si256(r, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), w);
+  }
+  ScaleConvert<float, uint16_t, float>(src + i, alpha, beta, dst + i, n - i);
+}
+
+static void F32ToF16(const float* src, const float alpha, const float beta,
+                     Half* dst, const size_t& n) {
+  const __m256 va = _mm256_set1_ps(alpha);
+  const __m256 vb = _mm256_set1_ps(beta);
+  const size_t nv = n - (n % 8);
+  size_t i = 0;
+  for (; i < nv; i += 8) {
+    const __m256 v = _mm256_fmadd_ps(_mm256_loadu_ps(src + i), va, vb);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+  }
+  ScaleConvert<float, Half, float>(src + i, alpha, beta, dst + i, n - i);
+}
+
+/** Widen 8 quantized elements to float */
+static __m256 LoadDeq(const Half* p) {
+  return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+static __m256 LoadDeq(const uint16_t* p) {
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(v), 16));
+}
+static __m256 LoadDeq(const int8_t* p) {
+  const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+  return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(v));
+}
+
+template<typename Q>
+static float QDot(const Q* a, const float* x, const size_t& n) {
+  // Two accumulators to hide the FMA latency
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  const size_t n16 = n - (n % 16);
+  size_t i = 0;
+  for (; i < n16; i += 16) {
+    acc0 = _mm256_fmadd_ps(LoadDeq(a + i), _mm256_loadu_ps(x + i), acc0);
+    acc1 = _mm256_fmadd_ps(LoadDeq(a + i + 8), _mm256_loadu_ps(x + i + 8),
+                           acc1);
+  }
+  if (n - i >= 8) {
+    acc0 = _mm256_fmadd_ps(LoadDeq(a + i), _mm256_loadu_ps(x + i), acc0);
+    i += 8;
+  }
+  acc0 = _mm256_add_ps(acc0, acc1);
+  __m128 r = _mm_add_ps(_mm256_castps256_ps128(acc0),
+                        _mm256_extractf128_ps(acc0, 1));
+  r = _mm_add_ps(r, _mm_movehl_ps(r, r));
+  r = _mm_add_ss(r, _mm_shuffle_ps(r, r, 1));
+  return _mm_cvtss_f32(r) + QuantDot<Q>(a + i, x + i, n - i);
+}
+
+template<typename Q>
+static void QAxpy(const Q* a, const float alpha, float* y, const size_t& n) {
+  const __m256 va = _mm256_set1_ps(alpha);
+  const size_t nv = n - (n % 8);
+  size_t i = 0;
+  for (; i < nv; i += 8) {
+    _mm256_storeu_ps(y + i, _mm256_fmadd_ps(LoadDeq(a + i),
+                                            va,
+                                            _mm256_loadu_ps(y + i)));
+  }
+  QuantAxpy<Q>(a + i, alpha, y + i, n - i);
+}
+
+/*
+ *  @name   Avx2Kernels
+ *  @fn     bool Avx2Kernels(OpsKernels<float>* f32, OpsKernels<double>* f64,
+                             ConvertKernels* cvt, SoaKernels<float>* soa32,
+                             SoaKernels<double>* soa64,
+                             QuantKernels* quant)
+ *  @brief  Provide AVX2 kernels, compiled separately with AVX2 enabled
+ *  @param[out] f32   Single precision kernels
+ *  @param[out] f64   Double precision kernels
+ *  @param[out] cvt   Conversion kernels (AVX2 + F16C)
+ *  @param[out] soa32 Single precision structure of arrays kernels
+ *  @param[out] soa64 Double precision structure of arrays kernels
+ *  @param[out] quant Quantized kernels
+ *  @return False if AVX2 kernels are not part of the build
+ */
+bool Avx2Kernels(OpsKernels<float>* f32,
+                 OpsKernels<double>* f64,
+                 ConvertKernels* cvt,
+                 SoaKernels<float>* soa32,
+                 SoaKernels<double>* soa64,
+                 QuantKernels* quant) {
+  *f32 = SimdKernels<Avx2F32>::Table();
+  *f64 = SimdKernels<Avx2F64>::Table();
+  *cvt = ConvertKernels{&U8ToF32, &U16ToF32, &F16ToF32,
+                        &F32ToU8, &F32ToU16, &F32ToF16};
+  *soa32 = SimdSoaKernels<Avx2F32>::Table();
+  *soa64 = SimdSoaKernels<Avx2F64>::Table();
+  *quant = QuantKernels{&QDot<Half>, &QDot<uint16_t>, &QDot<int8_t>,
+                        &QAxpy<Half>, &QAxpy<uint16_t>, &QAxpy<int8_t>};
+  return true;
+}
+
+#else
+
+/*
+ *  @name   Avx2Kernels
+ *  @fn     bool Avx2Kernels(OpsKernels<float>* f32, OpsKernels<double>* f64,
+                             ConvertKernels* cvt, SoaKernels<float>* soa32,
+                             SoaKernels<double>* soa64,
+                             QuantKernels* quant)
+ *  @brief  Provide AVX2 kernels, not available for this target
+ *  @param[out] f32   Single precision kernels
+ *  @param[out] f64   Double precision kernels
+ *  @param[out] cvt   Conversion kernels
+ *  @param[out] soa32 Single precision structure of arrays kernels
+ *  @param[out] soa64 Double precision structure of arrays kernels
+ *  @param[out] quant Quantized kernels
+ *  @return False
+ */
+bool Avx2Kernels(OpsKernels<float>* f32,
+                 OpsKernels<double>* f64,
+                 ConvertKernels* cvt,
+                 SoaKernels<float>* soa32,
+                 SoaKernels<double>* soa64,
+                 QuantKernels* quant) {
+  return false;
+}
+
+#endif
+
+}  // namespace internal
+}  // namespace FaceKit
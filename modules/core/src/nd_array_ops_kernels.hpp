@@ -0,0 +1,504 @@
+/**
+ *  @file   nd_array_ops_kernels.hpp
+ *  @brief  Private element-wise kernels shared by every instruction set. Each
+ *          translation unit instantiates them with its own vector traits and
+ *          compilation flags.
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   05.03.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_ND_ARRAY_OPS_KERNELS__
+#define __FACEKIT_ND_ARRAY_OPS_KERNELS__
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "facekit/core/half.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+namespace internal {
+
+/**
+ *  @struct  OpsKernels
+ *  @brief  Table of element-wise kernels for a given type
+ *  @tparam T Data type
+ */
+template<typename T>
+struct OpsKernels {
+  /** out = a + b */
+  void (*add)(const T* a, const T* b, T* out, const size_t& n);
+  /** out = a * b */
+  void (*mul)(const T* a, const T* b, T* out, const size_t& n);
+  /** out = a * b + c */
+  void (*fma)(const T* a, const T* b, const T* c, T* out, const size_t& n);
+  /** out = alpha * a + beta */
+  void (*scale)(const T* a, const T alpha, const T beta, T* out,
+                const size_t& n);
+  /** out = min(max(a, lo), hi) */
+  void (*clamp)(const T* a, const T lo, const T hi, T* out, const size_t& n);
+};
+
+/**
+ *  @struct  SimdKernels
+ *  @brief  Element-wise kernels written once on top of vector traits `V`
+ *          providing `Type`, `Reg`, `kWidth`, `Load`, `Store`, `Set`, `Add`,
+ *          `Mul`, `Fma`, `Min` and `Max`. Tails are processed with scalar
+ *          code.
+ *  @tparam V Vector traits
+ */
+template<typename V>
+struct SimdKernels {
+  /** Scalar type */
+  using T = typename V::Type;
+  /** Register type */
+  using R = typename V::Reg;
+
+  static void Add(const T* a, const T* b, T* out, const size_t& n) {
+    const size_t nv = n - (n % V::kWidth);
+    size_t i = 0;
+    for (; i < nv; i += V::kWidth) {
+      V::Store(out + i, V::Add(V::Load(a + i), V::Load(b + i)));
+    }
+    for (; i < n; ++i) {
+      out[i] = a[i] + b[i];
+    }
+  }
+
+  static void Mul(const T* a, const T* b, T* out, const size_t& n) {
+    const size_t nv = n - (n % V::kWidth);
+    size_t i = 0;
+    for (; i < nv; i += V::kWidth) {
+      V::Store(out + i, V::Mul(V::Load(a + i), V::Load(b + i)));
+    }
+    for (; i < n; ++i) {
+      out[i] = a[i] * b[i];
+    }
+  }
+
+  static void Fma(const T* a, const T* b, const T* c, T* out,
+                  const size_t& n) {
+    const size_t nv = n - (n % V::kWidth);
+    size_t i = 0;
+    for (; i < nv; i += V::kWidth) {
+      V::Store(out + i,
+               V::Fma(V::Load(a + i), V::Load(b + i), V::Load(c + i)));
+    }
+    for (; i < n; ++i) {
+      out[i] = a[i] * b[i] + c[i];
+    }
+  }
+
+  static void Scale(const T* a, const T alpha, const T beta, T* out,
+                    const size_t& n) {
+    const R va = V::Set(alpha);
+    const R vb = V::Set(beta);
+    const size_t nv = n - (n % V::kWidth);
+    size_t i = 0;
+    for (; i < nv; i += V::kWidth) {
+      V::Store(out + i, V::Fma(V::Load(a + i), va, vb));
+    }
+    for (; i < n; ++i) {
+      out[i] = alpha * a[i] + beta;
+    }
+  }
+
+  static void Clamp(const T* a, const T lo, const T hi, T* out,
+                    const size_t& n) {
+    const R vl = V::Set(lo);
+    const R vh = V::Set(hi);
+    const size_t nv = n - (n % V::kWidth);
+    size_t i = 0;
+    for (; i < nv; i += V::kWidth) {
+      V::Store(out + i, V::Min(V::Max(V::Load(a + i), vl), vh));
+    }
+    for (; i < n; ++i) {
+      const T v = a[i] < lo ? lo : a[i];
+      out[i] = v > hi ? hi : v;
+    }
+  }
+
+  /** Kernel table */
+  static OpsKernels<T> Table(void) {
+    return OpsKernels<T>{&Add, &Mul, &Fma, &Scale, &Clamp};
+  }
+};
+
+#pragma mark -
+#pragma mark Structure of arrays
+
+/**
+ *  @struct  SoaKernels
+ *  @brief  Table of kernels working on 3D vectors stored as separated x, y
+ *          and z streams
+ *  @tparam T Data type
+ */
+template<typename T>
+struct SoaKernels {
+  /** out = a . b */
+  void (*dot)(const T* ax, const T* ay, const T* az,
+              const T* bx, const T* by, const T* bz,
+              T* out, const size_t& n);
+  /** o = a ^ b */
+  void (*cross)(const T* ax, const T* ay, const T* az,
+                const T* bx, const T* by, const T* bz,
+                T* ox, T* oy, T* oz, const size_t& n);
+  /** v = v / |v|, NaN if |v| = 0 */
+  void (*normalize)(T* x, T* y, T* z, const size_t& n);
+  /** o = R * v + t, with R column-major 3x3. `o` can alias `v` */
+  void (*transform)(const T* r, const T* t,
+                    const T* x, const T* y, const T* z,
+                    T* ox, T* oy, T* oz, const size_t& n);
+};
+
+/**
+ *  @struct  SimdSoaKernels
+ *  @brief  Structure of arrays kernels written on top of vector traits `V`,
+ *          same requirements as `SimdKernels` plus `Sub`, `Div` and `Sqrt`.
+ *  @tparam V Vector traits
+ */
+template<typename V>
+struct SimdSoaKernels {
+  /** Scalar type */
+  using T = typename V::Type;
+  /** Register type */
+  using R = typename V::Reg;
+
+  static void Dot(const T* ax, const T* ay, const T* az,
+                  const T* bx, const T* by, const T* bz,
+                  T* out, const size_t& n) {
+    const size_t nv = n - (n % V::kWidth);
+    size_t i = 0;
+    for (; i < nv; i += V::kWidth) {
+      R d = V::Mul(V::Load(ax + i), V::Load(bx + i));
+      d = V::Fma(V::Load(ay + i), V::Load(by + i), d);
+      d = V::Fma(V::Load(az + i), V::Load(bz + i), d);
+      V::Store(out + i, d);
+    }
+    for (; i < n; ++i) {
+      out[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+    }
+  }
+
+  static void Cross(const T* ax, const T* ay, const T* az,
+                    const T* bx, const T* by, const T* bz,
+                    T* ox, T* oy, T* oz, const size_t& n) {
+    const size_t nv = n - (n % V::kWidth);
+    size_t i = 0;
+    for (; i < nv; i += V::kWidth) {
+      const R x0 = V::Load(ax + i), y0 = V::Load(ay + i), z0 = V::Load(az + i);
+      const R x1 = V::Load(bx + i), y1 = V::Load(by + i), z1 = V::Load(bz + i);
+      V::Store(ox + i, V::Sub(V::Mul(y0, z1), V::Mul(y1, z0)));
+      V::Store(oy + i, V::Sub(V::Mul(z0, x1), V::Mul(z1, x0)));
+      V::Store(oz + i, V::Sub(V::Mul(x0, y1), V::Mul(x1, y0)));
+    }
+    for (; i < n; ++i) {
+      const T x0 = ax[i], y0 = ay[i], z0 = az[i];
+      const T x1 = bx[i], y1 = by[i], z1 = bz[i];
+      ox[i] = y0 * z1 - y1 * z0;
+      oy[i] = z0 * x1 - z1 * x0;
+      oz[i] = x0 * y1 - x1 * y0;
+    }
+  }
+
+  static void Normalize(T* x, T* y, T* z, const size_t& n) {
+    const size_t nv = n - (n % V::kWidth);
+    size_t i = 0;
+    for (; i < nv; i += V::kWidth) {
+      const R vx = V::Load(x + i), vy = V::Load(y + i), vz = V::Load(z + i);
+      const R len = V::Sqrt(V::Fma(vz, vz, V::Fma(vy, vy, V::Mul(vx, vx))));
+      V::Store(x + i, V::Div(vx, len));
+      V::Store(y + i, V::Div(vy, len));
+      V::Store(z + i, V::Div(vz, len));
+    }
+    for (; i < n; ++i) {
+      const T len = std::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+      x[i] /= len;
+      y[i] /= len;
+      z[i] /= len;
+    }
+  }
+
+  static void Transform(const T* r, const T* t,
+                        const T* x, const T* y, const T* z,
+                        T* ox, T* oy, T* oz, const size_t& n) {
+    const R r0 = V::Set(r[0]), r1 = V::Set(r[1]), r2 = V::Set(r[2]);
+    const R r3 = V::Set(r[3]), r4 = V::Set(r[4]), r5 = V::Set(r[5]);
+    const R r6 = V::Set(r[6]), r7 = V::Set(r[7]), r8 = V::Set(r[8]);
+    const R t0 = V::Set(t[0]), t1 = V::Set(t[1]), t2 = V::Set(t[2]);
+    const size_t nv = n - (n % V::kWidth);
+    size_t i = 0;
+    for (; i < nv; i += V::kWidth) {
+      const R vx = V::Load(x + i), vy = V::Load(y + i), vz = V::Load(z + i);
+      const R px = V::Fma(r6, vz, V::Fma(r3, vy, V::Fma(r0, vx, t0)));
+      const R py = V::Fma(r7, vz, V::Fma(r4, vy, V::Fma(r1, vx, t1)));
+      const R pz = V::Fma(r8, vz, V::Fma(r5, vy, V::Fma(r2, vx, t2)));
+      V::Store(ox + i, px);
+      V::Store(oy + i, py);
+      V::Store(oz + i, pz);
+    }
+    for (; i < n; ++i) {
+      const T vx = x[i], vy = y[i], vz = z[i];
+      ox[i] = r[0] * vx + r[3] * vy + r[6] * vz + t[0];
+      oy[i] = r[1] * vx + r[4] * vy + r[7] * vz + t[1];
+      oz[i] = r[2] * vx + r[5] * vy + r[8] * vz + t[2];
+    }
+  }
+
+  /** Kernel table */
+  static SoaKernels<T> Table(void) {
+    return SoaKernels<T>{&Dot, &Cross, &Normalize, &Transform};
+  }
+};
+
+/**
+ *  @name   SelectedSoaKernels
+ *  @fn     template<typename T> const SoaKernels<T>& SelectedSoaKernels(void)
+ *  @brief  Structure of arrays kernels picked for this CPU, see
+ *          `NDArrayOps::simd_level()`
+ *  @tparam T Data type, float or double
+ *  @return Kernels
+ */
+template<typename T>
+const SoaKernels<T>& SelectedSoaKernels(void);
+template<>
+const SoaKernels<float>& SelectedSoaKernels<float>(void);
+template<>
+const SoaKernels<double>& SelectedSoaKernels<double>(void);
+
+/**
+ *  @name   SelectedOpsKernels
+ *  @fn     template<typename T> const OpsKernels<T>& SelectedOpsKernels(void)
+ *  @brief  Element-wise kernels picked for this CPU, see
+ *          `NDArrayOps::simd_level()`
+ *  @tparam T Data type, float or double
+ *  @return Kernels
+ */
+template<typename T>
+const OpsKernels<T>& SelectedOpsKernels(void);
+template<>
+const OpsKernels<float>& SelectedOpsKernels<float>(void);
+template<>
+const OpsKernels<double>& SelectedOpsKernels<double>(void);
+
+#pragma mark -
+#pragma mark Conversion
+
+/**
+ *  @struct  SaturateCast
+ *  @brief  Convert a value to `D`, integers are rounded to nearest (even)
+ *          and clamped to their range, NaN gives the lowest value.
+ *  @tparam D Destination type
+ *  @tparam Integral True if D is an integer
+ */
+template<typename D, bool Integral = std::is_integral<D>::value>
+struct SaturateCast {
+  template<typename S>
+  static D Cast(const S& v) {
+    const S lo = static_cast<S>(std::numeric_limits<D>::lowest());
+    const S hi = static_cast<S>(std::numeric_limits<D>::max());
+    if (!(v > lo)) {
+      return std::numeric_limits<D>::lowest();
+    }
+    if (v >= hi) {
+      return std::numeric_limits<D>::max();
+    }
+    return static_cast<D>(std::nearbyint(v));
+  }
+};
+
+template<typename D>
+struct SaturateCast<D, false> {
+  template<typename S>
+  static D Cast(const S& v) {
+    return static_cast<D>(v);
+  }
+};
+
+/**
+ *  @name   ScaleConvert
+ *  @fn     template<typename S, typename D, typename C> void ScaleConvert(
+                        const S* src, const C alpha, const C beta, D* dst,
+                        const size_t& n)
+ *  @brief  Compute dst = saturate(alpha * src + beta), arithmetic done in `C`
+ *  @param[in] src    Source
+ *  @param[in] alpha  Scaling factor
+ *  @param[in] beta   Offset
+ *  @param[out] dst   Destination
+ *  @param[in] n      Number of elements
+ */
+template<typename S, typename D, typename C>
+void ScaleConvert(const S* src, const C alpha, const C beta, D* dst,
+                  const size_t& n) {
+  for (size_t i = 0; i < n; ++i) {
+    const C v = alpha * static_cast<C>(src[i]) + beta;
+    dst[i] = SaturateCast<D>::Cast(v);
+  }
+}
+
+/**
+ *  @struct  ConvertKernels
+ *  @brief  Table of conversion kernels on the image path, computing
+ *          dst = saturate(alpha * src + beta) in single precision
+ */
+struct ConvertKernels {
+  /** uint8 -> float */
+  void (*u8_to_f32)(const uint8_t* src, const float alpha, const float beta,
+                    float* dst, const size_t& n);
+  /** uint16 -> float */
+  void (*u16_to_f32)(const uint16_t* src, const float alpha, const float beta,
+                     float* dst, const size_t& n);
+  /** half -> float */
+  void (*f16_to_f32)(const Half* src, const float alpha, const float beta,
+                     float* dst, const size_t& n);
+  /** float -> uint8 */
+  void (*f32_to_u8)(const float* src, const float alpha, const float beta,
+                    uint8_t* dst, const size_t& n);
+  /** float -> uint16 */
+  void (*f32_to_u16)(const float* src, const float alpha, const float beta,
+                     uint16_t* dst, const size_t& n);
+  /** float -> half */
+  void (*f32_to_f16)(const float* src, const float alpha, const float beta,
+                     Half* dst, const size_t& n);
+
+  /** Plain C++ kernels */
+  static ConvertKernels Scalar(void) {
+    return ConvertKernels{&ScaleConvert<uint8_t, float, float>,
+                          &ScaleConvert<uint16_t, float, float>,
+                          &ScaleConvert<Half, float, float>,
+                          &ScaleConvert<float, uint8_t, float>,
+                          &ScaleConvert<float, uint16_t, float>,
+                          &ScaleConvert<float, Half, float>};
+  }
+};
+
+#pragma mark -
+#pragma mark Quantized
+
+/**
+ *  @name   Dequantize
+ *  @fn     inline float Dequantize(const Q& q)
+ *  @brief  Widen a quantized storage element to float
+ *  @param[in] q  Stored element
+ *  @return Float value
+ */
+inline float Dequantize(const Half& q) {
+  return static_cast<float>(q);
+}
+inline float Dequantize(const uint16_t& q) {
+  return BFloat16BitsToFloat(q);
+}
+inline float Dequantize(const int8_t& q) {
+  return static_cast<float>(q);
+}
+
+/**
+ *  @name   QuantDot
+ *  @fn     float QuantDot(const Q* a, const float* x, const size_t& n)
+ *  @brief  Compute sum_i deq(a_i) * x_i in single precision
+ *  @param[in] a  Quantized vector
+ *  @param[in] x  Float vector
+ *  @param[in] n  Number of elements
+ *  @return Inner product
+ *  @tparam Q Storage type: Half, uint16_t (bfloat16) or int8_t
+ */
+template<typename Q>
+float QuantDot(const Q* a, const float* x, const size_t& n) {
+  float acc = 0.f;
+  for (size_t i = 0; i < n; ++i) {
+    acc += Dequantize(a[i]) * x[i];
+  }
+  return acc;
+}
+
+/**
+ *  @name   QuantAxpy
+ *  @fn     void QuantAxpy(const Q* a, const float alpha, float* y,
+                           const size_t& n)
+ *  @brief  Compute y_i += alpha * deq(a_i) in single precision
+ *  @param[in] a      Quantized vector
+ *  @param[in] alpha  Scaling factor
+ *  @param[in,out] y  Float vector
+ *  @param[in] n      Number of elements
+ *  @tparam Q Storage type: Half, uint16_t (bfloat16) or int8_t
+ */
+template<typename Q>
+void QuantAxpy(const Q* a, const float alpha, float* y, const size_t& n) {
+  for (size_t i = 0; i < n; ++i) {
+    y[i] += alpha * Dequantize(a[i]);
+  }
+}
+
+/**
+ *  @struct  QuantKernels
+ *  @brief  Table of kernels reading quantized rows (fp16, bf16, int8) and
+ *          accumulating in single precision
+ */
+struct QuantKernels {
+  /** sum deq(a) * x, fp16 */
+  float (*dot_f16)(const Half* a, const float* x, const size_t& n);
+  /** sum deq(a) * x, bf16 */
+  float (*dot_bf16)(const uint16_t* a, const float* x, const size_t& n);
+  /** sum deq(a) * x, int8 */
+  float (*dot_s8)(const int8_t* a, const float* x, const size_t& n);
+  /** y += alpha * deq(a), fp16 */
+  void (*axpy_f16)(const Half* a, const float alpha, float* y,
+                   const size_t& n);
+  /** y += alpha * deq(a), bf16 */
+  void (*axpy_bf16)(const uint16_t* a, const float alpha, float* y,
+                    const size_t& n);
+  /** y += alpha * deq(a), int8 */
+  void (*axpy_s8)(const int8_t* a, const float alpha, float* y,
+                  const size_t& n);
+
+  /** Plain C++ kernels */
+  static QuantKernels Scalar(void) {
+    return QuantKernels{&QuantDot<Half>, &QuantDot<uint16_t>,
+                        &QuantDot<int8_t>, &QuantAxpy<Half>,
+                        &QuantAxpy<uint16_t>, &QuantAxpy<int8_t>};
+  }
+};
+
+/**
+ *  @name   SelectedQuantKernels
+ *  @fn     const QuantKernels& SelectedQuantKernels(void)
+ *  @brief  Quantized kernels picked for this CPU, see
+ *          `NDArrayOps::simd_level()`
+ *  @return Kernels
+ */
+const QuantKernels& SelectedQuantKernels(void);
+
+/**
+ *  @name   Avx2Kernels
+ *  @fn     bool Avx2Kernels(OpsKernels<float>* f32, OpsKernels<double>* f64,
+                             ConvertKernels* cvt, SoaKernels<float>* soa32,
+                             SoaKernels<double>* soa64,
+                             QuantKernels* quant)
+ *  @brief  Provide AVX2 kernels, compiled separately with AVX2 enabled
+ *  @param[out] f32   Single precision kernels
+ *  @param[out] f64   Double precision kernels
+ *  @param[out] cvt   Conversion kernels (AVX2 + F16C)
+ *  @param[out] soa32 Single precision structure of arrays kernels
+ *  @param[out] soa64 Double precision structure of arrays kernels
+ *  @param[out] quant Quantized kernels (AVX2 + F16C)
+ *  @return False if AVX2 kernels are not part of the build
+ */
+bool Avx2Kernels(OpsKernels<float>* f32,
+                 OpsKernels<double>* f64,
+                 ConvertKernels* cvt,
+                 SoaKernels<float>* soa32,
+                 SoaKernels<double>* soa64,
+                 QuantKernels* quant);
+
+}  // namespace internal
+}  // namespace FaceKit
+#endif /* __FACEKIT_ND_ARRAY_OPS_KERNELS__ */
@@ -0,0 +1,211 @@
+/**
+ *  @file   perf_counter.cpp
+ *  @brief  Hardware performance counters (cycles, instructions, cache and
+ *          branch misses) of the calling thread
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cstring>
+#include <memory>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "facekit/core/sys/perf_counter.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#if defined(__linux__)
+/** Hardware event of each counter, indexed by `PerfCounters::Counter` */
+static const uint64_t kEvents[] = {
+  PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_CACHE_MISSES,
+  PERF_COUNT_HW_BRANCH_MISSES
+};
+
+/**
+ *  @name   OpenEvent
+ *  @fn     static int OpenEvent(const uint64_t& event, const int& group)
+ *  @brief  Open a user space counter for the calling thread on any CPU
+ *  @param[in] event  Hardware event
+ *  @param[in] group  Group leader, -1 to create a new group
+ *  @return File descriptor, -1 on error
+ */
+static int OpenEvent(const uint64_t& event, const int& group) {
+  struct perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = event;
+  attr.disabled = group == -1 ? 1 : 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP |
+                     PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group,
+                                  0));
+}
+#endif
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   PerfCounters
+ *  @fn     PerfCounters(void)
+ *  @brief  Constructor, see `Open`
+ */
+PerfCounters::PerfCounters(void) : leader_(-1), n_open_(0) {
+  for (size_t k = 0; k < kNCounter; ++k) {
+    fd_[k] = -1;
+    order_[k] = kCycles;
+  }
+}
+
+/*
+ *  @name   ~PerfCounters
+ *  @fn     ~PerfCounters(void)
+ *  @brief  Destructor, release the counters
+ */
+PerfCounters::~PerfCounters(void) {
+  this->Close();
+}
+
+/*
+ *  @name   ThreadCounters
+ *  @fn     static PerfCounters* ThreadCounters(void)
+ *  @brief  Counters of the calling thread, opened on first call
+ *  @return Counters or nullptr if none is available
+ */
+PerfCounters* PerfCounters::ThreadCounters(void) {
+  // Opened once, a failure is not retried
+  static thread_local std::unique_ptr<PerfCounters> counters;
+  static thread_local bool init = false;
+  if (!init) {
+    init = true;
+    counters.reset(new PerfCounters());
+    if (!counters->Open().Good()) {
+      counters.reset();
+    }
+  }
+  return counters.get();
+}
+
+/*
+ *  @name   Name
+ *  @fn     static const char* Name(const Counter& counter)
+ *  @brief  Counter's name
+ */
+const char* PerfCounters::Name(const Counter& counter) {
+  switch (counter) {
+    case kCycles: return "cycles";
+    case kInstructions: return "instructions";
+    case kLLCMisses: return "llc_misses";
+    case kBranchMisses: return "branch_misses";
+    default: return "unknown";
+  }
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Open
+ *  @fn     Status Open(void)
+ *  @brief  Start counting for the calling thread, only this thread can be
+ *          measured afterwards
+ *  @return kUnimplemented if the platform has no counters, kInternalError
+ *          if none could be opened
+ */
+Status PerfCounters::Open(void) {
+  this->Close();
+#if defined(__linux__)
+  // The first counter available leads the group, the others are optional
+  for (size_t k = 0; k < kNCounter; ++k) {
+    const int fd = OpenEvent(kEvents[k], leader_);
+    if (fd >= 0) {
+      fd_[k] = fd;
+      order_[n_open_++] = Counter(k);
+      if (leader_ < 0) {
+        leader_ = fd;
+      }
+    }
+  }
+  if (leader_ < 0) {
+    return Status(Status::Type::kInternalError,
+                  "No hardware counter available (perf_event_paranoid?)");
+  }
+  ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return Status();
+#else
+  return Status(Status::Type::kUnimplemented,
+                "Hardware counters are not supported on this platform");
+#endif
+}
+
+/*
+ *  @name   Close
+ *  @fn     void Close(void)
+ *  @brief  Release the counters
+ */
+void PerfCounters::Close(void) {
+#if defined(__linux__)
+  for (size_t k = 0; k < kNCounter; ++k) {
+    if (fd_[k] >= 0) {
+      close(fd_[k]);
+      fd_[k] = -1;
+    }
+  }
+#endif
+  leader_ = -1;
+  n_open_ = 0;
+}
+
+/*
+ *  @name   Read
+ *  @fn     Status Read(Sample* sample) const
+ *  @brief  Read current values, counts between two points are obtained by
+ *          subtracting two samples
+ *  @param[out] sample  Counter values
+ *  @return kInternalError if not open or the read failed
+ */
+Status PerfCounters::Read(Sample* sample) const {
+  *sample = Sample();
+#if defined(__linux__)
+  if (leader_ >= 0) {
+    // Layout: nr, time enabled, time running, values
+    uint64_t buffer[3 + kNCounter];
+    const ssize_t n = read(leader_, buffer, sizeof(buffer));
+    if (n >= ssize_t(3 * sizeof(uint64_t)) && buffer[0] == n_open_) {
+      // Counters are multiplexed if the PMU is oversubscribed, extrapolate
+      const double scale = (buffer[2] != 0 && buffer[2] < buffer[1]) ?
+                           double(buffer[1]) / double(buffer[2]) :
+                           1.0;
+      for (size_t i = 0; i < n_open_; ++i) {
+        const uint64_t v = buffer[3 + i];
+        sample->value[order_[i]] = scale == 1.0 ? v : uint64_t(v * scale);
+        sample->valid |= 1u << order_[i];
+      }
+      return Status();
+    }
+  }
+#endif
+  return Status(Status::Type::kInternalError, "Unable to read counters");
+}
+
+}  // namespace FaceKit
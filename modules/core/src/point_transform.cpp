@@ -0,0 +1,162 @@
+/**
+ *  @file   point_transform.cpp
+ *  @brief  Rigid / affine transformation of batches of 3D points
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   27.08.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+
+#include "facekit/core/math/point_transform.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "nd_array_ops_kernels.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Number of points transposed at once, fits in L1 */
+static constexpr size_t kTransformBlock = 256;
+/** Number of points processed by one parallel task */
+static constexpr size_t kTransformGrain = 16 * kTransformBlock;
+
+/**
+ *  @name   TransformRange
+ *  @fn     static void TransformRange(const SoaKernels<T>& k, const T* r,
+                                       const T* t, const T* in, T* out,
+                                       const size_t& first,
+                                       const size_t& last)
+ *  @brief  Transform points [first, last) block by block
+ *  @param[in] k      Kernels
+ *  @param[in] r      Column-major 3x3 matrix
+ *  @param[in] t      Translation
+ *  @param[in] in     Input points
+ *  @param[out] out   Output points
+ *  @param[in] first  First point
+ *  @param[in] last   Past-the-end point
+ *  @tparam T Data type
+ */
+template<typename T>
+static void TransformRange(const internal::SoaKernels<T>& k,
+                           const T* r,
+                           const T* t,
+                           const T* in,
+                           T* out,
+                           const size_t& first,
+                           const size_t& last) {
+  alignas(64) T x[kTransformBlock];
+  alignas(64) T y[kTransformBlock];
+  alignas(64) T z[kTransformBlock];
+  for (size_t b = first; b < last; b += kTransformBlock) {
+    const size_t nb = std::min(kTransformBlock, last - b);
+    const T* src = in + 3 * b;
+    for (size_t i = 0; i < nb; ++i) {
+      x[i] = src[3 * i];
+      y[i] = src[3 * i + 1];
+      z[i] = src[3 * i + 2];
+    }
+    k.transform(r, t, x, y, z, x, y, z, nb);
+    T* dst = out + 3 * b;
+    for (size_t i = 0; i < nb; ++i) {
+      dst[3 * i] = x[i];
+      dst[3 * i + 1] = y[i];
+      dst[3 * i + 2] = z[i];
+    }
+  }
+}
+
+/*
+ *  @name   TransformPoints
+ *  @fn     void TransformPoints(const T* r, const T* t, const T* in, T* out,
+                                 const size_t& n, const bool& parallel)
+ *  @brief  Compute out_i = R * in_i + t for `n` points stored as interleaved
+ *          (x, y, z) triplets.
+ *  @param[in] r        Column-major 3x3 matrix
+ *  @param[in] t        Translation, 3 elements
+ *  @param[in] in       Input points, 3 * `n` elements
+ *  @param[out] out     Output points, 3 * `n` elements, can be `in`
+ *  @param[in] n        Number of points
+ *  @param[in] parallel If true, large batches are split over the default
+ *                      thread pool
+ *  @tparam T Data type, float or double
+ */
+template<typename T>
+void TransformPoints(const T* r,
+                     const T* t,
+                     const T* in,
+                     T* out,
+                     const size_t& n,
+                     const bool& parallel) {
+  const auto& k = internal::SelectedSoaKernels<T>();
+  if (parallel && n > kTransformGrain) {
+    ThreadPool::Get().ParallelFor(0,
+                                  n,
+                                  kTransformGrain,
+                                  [&](const size_t& first,
+                                      const size_t& last) {
+      TransformRange(k, r, t, in, out, first, last);
+    });
+  } else {
+    TransformRange(k, r, t, in, out, 0, n);
+  }
+}
+
+/*
+ *  @name   TransformPointsSoa
+ *  @fn     void TransformPointsSoa(const T* r, const T* t, const T* x,
+                                    const T* y, const T* z, T* ox, T* oy,
+                                    T* oz, const size_t& n)
+ *  @brief  Compute o_i = R * v_i + t for `n` points stored as separated x, y
+ *          and z streams (structure of arrays)
+ *  @param[in] r    Column-major 3x3 matrix
+ *  @param[in] t    Translation, 3 elements
+ *  @param[in] x    Input x components, `n` elements
+ *  @param[in] y    Input y components, `n` elements
+ *  @param[in] z    Input z components, `n` elements
+ *  @param[out] ox  Output x components, can be `x`
+ *  @param[out] oy  Output y components, can be `y`
+ *  @param[out] oz  Output z components, can be `z`
+ *  @param[in] n    Number of points
+ *  @tparam T Data type, float or double
+ */
+template<typename T>
+void TransformPointsSoa(const T* r,
+                        const T* t,
+                        const T* x,
+                        const T* y,
+                        const T* z,
+                        T* ox,
+                        T* oy,
+                        T* oz,
+                        const size_t& n) {
+  internal::SelectedSoaKernels<T>().transform(r, t, x, y, z, ox, oy, oz, n);
+}
+
+#pragma mark -
+#pragma mark Explicit Instantiation
+
+/** Float - TransformPoints */
+template void TransformPoints<float>(const float*, const float*,
+                                     const float*, float*,
+                                     const size_t&, const bool&);
+/** Double - TransformPoints */
+template void TransformPoints<double>(const double*, const double*,
+                                      const double*, double*,
+                                      const size_t&, const bool&);
+/** Float - TransformPointsSoa */
+template void TransformPointsSoa<float>(const float*, const float*,
+                                        const float*, const float*,
+                                        const float*, float*, float*, float*,
+                                        const size_t&);
+/** Double - TransformPointsSoa */
+template void TransformPointsSoa<double>(const double*, const double*,
+                                         const double*, const double*,
+                                         const double*, double*, double*,
+                                         double*, const size_t&);
+
+}  // namespace FaceKit
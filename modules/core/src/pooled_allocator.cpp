@@ -0,0 +1,403 @@
+/**
+ *  @file   pooled_allocator.cpp
+ *  @brief Size-class pooled memory allocator with per-thread caches
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   14.02.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "facekit/core/mem/allocator.hpp"
+#include "facekit/core/mem/allocator_factory.hpp"
+#include "facekit/core/mem/memory.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  PooledCpuAllocator
+ *  @brief  CPU allocator recycling memory blocks. Requests are rounded up to
+ *          a size class (four classes per power of two), released blocks are
+ *          kept in a per-thread cache first and then in a central free list
+ *          shared by all threads. Requests larger than `kMaxPooledSize` go
+ *          straight to the system.
+ *  @author Christophe Ecabert
+ *  @date   14.02.18
+ *  @ingroup core
+ */
+class PooledCpuAllocator : public Allocator {
+ public:
+
+  /** Smallest size class, also alignment of pooled blocks */
+  static constexpr size_t kMinClassSize = 64;
+  /** Largest size class */
+  static constexpr size_t kMaxPooledSize = size_t(1) << 26;
+  /** Number of size classes */
+  static constexpr size_t kNClass = 81;
+  /** Bytes a thread cache can hold per size class */
+  static constexpr size_t kThreadCacheBytes = size_t(8) << 20;
+  /** Bytes the central list can hold per size class */
+  static constexpr size_t kCentralBytes = size_t(256) << 20;
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   PooledCpuAllocator
+   *  @fn     PooledCpuAllocator(void) = default
+   *  @brief  Constructor
+   */
+  PooledCpuAllocator(void) = default;
+
+  /**
+   *  @name   PooledCpuAllocator
+   *  @fn     PooledCpuAllocator(const PooledCpuAllocator& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in]  other Object to copy from
+   */
+  PooledCpuAllocator(const PooledCpuAllocator& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     PooledCpuAllocator& operator=(const PooledCpuAllocator& rhs)
+                                                                    = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  PooledCpuAllocator& operator=(const PooledCpuAllocator& rhs) = delete;
+
+  /**
+   *  @name   ~PooledCpuAllocator
+   *  @fn     ~PooledCpuAllocator(void) override
+   *  @brief  Destructor
+   */
+  ~PooledCpuAllocator(void) override {
+    for (auto& c : central_) {
+      for (auto* p : c.blocks) {
+        Mem::FreeAligned(p);
+      }
+    }
+  }
+
+  /**
+   *  @name   Name
+   *  @fn     std::string Name(void) const override
+   *  @brief  Give allocator's name
+   */
+  std::string Name(void) const override {
+    return "pooled_cpu_allocator";
+  }
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   AllocateRaw
+   *  @fn     void* AllocateRaw(const size_t& size,
+                                const size_t& alignment) override
+   *  @brief  Allocate a block of memory of a given size with specific
+   *          alignment. Alignment must be a power of 2 and minimum of
+   *          sizeof(void*)
+   *  @param[in]  size      Size of the memory block in bytes
+   *  @param[in]  alignment Desired memory alignment
+   *  @return Pointer to memory block or nullptr if failed.
+   */
+  void* AllocateRaw(const size_t& size, const size_t& alignment) override {
+    void* ptr = nullptr;
+    if (size > kMaxPooledSize) {
+      ptr = Mem::MallocAligned(size, alignment);
+    } else {
+      const size_t k = SizeClass(size);
+      if (alignment <= kMinClassSize) {
+        ptr = this->Pop(k);
+      }
+      if (!ptr) {
+        // Allocate the whole class so the block can be recycled later
+        ptr = Mem::MallocAligned(ClassSize(k),
+                                 std::max(alignment, kMinClassSize));
+      }
+    }
+    if (ptr && AllocatorStatisticsEnabled()) {
+      stats_.Allocate(size, ptr);
+    }
+    return ptr;
+  }
+
+  /**
+   *  @name   DeallocateRaw
+   *  @fn     void DeallocateRaw(void* ptr) override
+   *  @brief  Release a block of memory pointed by `ptr`
+   *  @param[in]  size  Size of the memory block in bytes
+   *  @param[in]  ptr   Pointer to memory block
+   */
+  void DeallocateRaw(const size_t& size, void* ptr) override {
+    if (!ptr) {
+      return;
+    }
+    if (AllocatorStatisticsEnabled()) {
+      stats_.Deallocate(size, ptr);
+    }
+    if (size > kMaxPooledSize) {
+      Mem::FreeAligned(ptr);
+    } else {
+      this->Push(SizeClass(size), ptr);
+    }
+  }
+
+  /**
+   *  @name   GatherStatistics
+   *  @fn     virtual void GatherStatistics(AllocatorStatistic* stats)
+   *  @brief  Provide statistics for this allocator
+   *  @param[out] stats   Object filled with statistics from this allocator
+   */
+  void GatherStatistics(AllocatorStatistic* stats) override {
+    stats_.Gather(stats);
+  }
+
+  /**
+   *  @name   ClearStatistics
+   *  @fn     void ClearStatistics(void) override
+   *  @brief  Clear allocator's statistics
+   */
+  void ClearStatistics(void) override {
+    stats_.Clear();
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+
+  /**
+   *  @struct  ThreadCache
+   *  @brief  Blocks cached by one thread, flushed to central list on thread
+   *          exit
+   */
+  struct ThreadCache {
+    /** Allocator owning the blocks */
+    PooledCpuAllocator* owner = nullptr;
+    /** Free blocks per size class */
+    std::vector<void*> bins[kNClass];
+
+    /**
+     *  @name   ~ThreadCache
+     *  @fn     ~ThreadCache(void)
+     *  @brief  Destructor
+     */
+    ~ThreadCache(void) {
+      if (owner) {
+        for (size_t k = 0; k < kNClass; ++k) {
+          owner->Flush(k, &bins[k], bins[k].size());
+        }
+      }
+    }
+  };
+
+  /**
+   *  @struct  CentralList
+   *  @brief  Free blocks of one size class shared by all threads
+   */
+  struct CentralList {
+    /** Free blocks */
+    std::vector<void*> blocks;
+    /** Synchronization */
+    std::mutex lock;
+  };
+
+  /**
+   *  @name   SizeClass
+   *  @fn     static size_t SizeClass(const size_t& size)
+   *  @brief  Select the size class serving a given request
+   *  @param[in] size Request size in bytes, at most `kMaxPooledSize`
+   *  @return Size class index
+   */
+  static size_t SizeClass(const size_t& size) {
+    if (size <= kMinClassSize) {
+      return 0;
+    }
+    const size_t s = size - 1;
+    size_t msb = 0;
+    while ((s >> (msb + 1)) != 0) {
+      ++msb;
+    }
+    const size_t m = (s >> (msb - 2)) & 3;
+    return 1 + (msb - 6) * 4 + m;
+  }
+
+  /**
+   *  @name   ClassSize
+   *  @fn     static size_t ClassSize(const size_t& k)
+   *  @brief  Size of the blocks of a given class
+   *  @param[in] k  Size class index
+   *  @return Block size in bytes
+   */
+  static size_t ClassSize(const size_t& k) {
+    if (k == 0) {
+      return kMinClassSize;
+    }
+    const size_t msb = 6 + (k - 1) / 4;
+    const size_t m = (k - 1) % 4;
+    return (5 + m) << (msb - 2);
+  }
+
+  /**
+   *  @name   ThreadCapacity
+   *  @fn     static size_t ThreadCapacity(const size_t& k)
+   *  @brief  Number of blocks a thread cache can hold for a given class
+   *  @param[in] k  Size class index
+   *  @return Capacity
+   */
+  static size_t ThreadCapacity(const size_t& k) {
+    return std::max<size_t>(1,
+                            std::min<size_t>(64,
+                                             kThreadCacheBytes / ClassSize(k)));
+  }
+
+  /**
+   *  @name   CentralCapacity
+   *  @fn     static size_t CentralCapacity(const size_t& k)
+   *  @brief  Number of blocks the central list can hold for a given class
+   *  @param[in] k  Size class index
+   *  @return Capacity
+   */
+  static size_t CentralCapacity(const size_t& k) {
+    return std::max<size_t>(2,
+                            std::min<size_t>(1024,
+                                             kCentralBytes / ClassSize(k)));
+  }
+
+  /**
+   *  @name   GetThreadCache
+   *  @fn     ThreadCache* GetThreadCache(void)
+   *  @brief  Cache of the calling thread
+   *  @return Cache or nullptr if owned by another allocator instance
+   */
+  ThreadCache* GetThreadCache(void) {
+    static thread_local ThreadCache cache;
+    if (!cache.owner) {
+      cache.owner = this;
+    }
+    return cache.owner == this ? &cache : nullptr;
+  }
+
+  /**
+   *  @name   Pop
+   *  @fn     void* Pop(const size_t& k)
+   *  @brief  Take a free block of a given class, thread cache first then
+   *          central list (refilling half of the thread cache)
+   *  @param[in] k  Size class index
+   *  @return Block or nullptr if none are available
+   */
+  void* Pop(const size_t& k) {
+    ThreadCache* cache = this->GetThreadCache();
+    if (!cache) {
+      // Foreign cache, only use central list
+      std::lock_guard<std::mutex> l(central_[k].lock);
+      auto& blocks = central_[k].blocks;
+      if (blocks.empty()) {
+        return nullptr;
+      }
+      void* ptr = blocks.back();
+      blocks.pop_back();
+      return ptr;
+    }
+    auto& bin = cache->bins[k];
+    if (bin.empty()) {
+      // Refill by batch
+      std::lock_guard<std::mutex> l(central_[k].lock);
+      auto& blocks = central_[k].blocks;
+      const size_t n = std::min(blocks.size(),
+                                std::max<size_t>(1, ThreadCapacity(k) / 2));
+      bin.insert(bin.end(), blocks.end() - n, blocks.end());
+      blocks.resize(blocks.size() - n);
+    }
+    if (bin.empty()) {
+      return nullptr;
+    }
+    void* ptr = bin.back();
+    bin.pop_back();
+    return ptr;
+  }
+
+  /**
+   *  @name   Push
+   *  @fn     void Push(const size_t& k, void* ptr)
+   *  @brief  Give back a block of a given class, thread cache first, half of
+   *          it goes to the central list when full
+   *  @param[in] k    Size class index
+   *  @param[in] ptr  Block
+   */
+  void Push(const size_t& k, void* ptr) {
+    ThreadCache* cache = this->GetThreadCache();
+    if (!cache) {
+      std::vector<void*> one(1, ptr);
+      this->Flush(k, &one, 1);
+      return;
+    }
+    auto& bin = cache->bins[k];
+    bin.push_back(ptr);
+    const size_t cap = ThreadCapacity(k);
+    if (bin.size() > cap) {
+      this->Flush(k, &bin, std::max<size_t>(1, bin.size() - cap / 2));
+    }
+  }
+
+  /**
+   *  @name   Flush
+   *  @fn     void Flush(const size_t& k, std::vector<void*>* bin,
+                         const size_t& n)
+   *  @brief  Move the last `n` blocks of `bin` to the central list, blocks
+   *          exceeding its capacity are released to the system
+   *  @param[in] k        Size class index
+   *  @param[in,out] bin  Blocks to move from
+   *  @param[in] n        Number of blocks to move
+   */
+  void Flush(const size_t& k, std::vector<void*>* bin, const size_t& n) {
+    if (n == 0) {
+      return;
+    }
+    std::vector<void*> excess;
+    {
+      std::lock_guard<std::mutex> l(central_[k].lock);
+      auto& blocks = central_[k].blocks;
+      const size_t cap = CentralCapacity(k);
+      for (size_t i = bin->size() - n; i < bin->size(); ++i) {
+        if (blocks.size() < cap) {
+          blocks.push_back((*bin)[i]);
+        } else {
+          excess.push_back((*bin)[i]);
+        }
+      }
+    }
+    bin->resize(bin->size() - n);
+    for (auto* p : excess) {
+      Mem::FreeAligned(p);
+    }
+  }
+
+  /** Central free lists */
+  CentralList central_[kNClass];
+  /** Statistics */
+  AllocatorStatisticCollector stats_;
+};
+
+// Size class
+constexpr size_t PooledCpuAllocator::kMinClassSize;
+constexpr size_t PooledCpuAllocator::kMaxPooledSize;
+constexpr size_t PooledCpuAllocator::kNClass;
+constexpr size_t PooledCpuAllocator::kThreadCacheBytes;
+constexpr size_t PooledCpuAllocator::kCentralBytes;
+
+// Register pooled CPU
+REGISTER_ALLOCATOR("pooled_cpu_allocator", PooledCpuAllocator);
+
+}  // namespace FaceKit
@@ -15,10 +15,19 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstring>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 #endif
 
+#include <memory>
+
 #include "facekit/core/utils/string.hpp"
 #include "facekit/core/sys/posix_file_system.hpp"
 #include "facekit/core/sys/file_system_factory.hpp"
@@ -85,6 +94,126 @@ Status PosixFileSystem::ListDir(const std::string& dir,
 #endif
 }
   
+#ifdef IS_POSIX
+/**
+ *  @name   AddDirEntry
+ *  @fn     static void AddDirEntry(const std::string& dir, const char* name,
+                                    const unsigned char type,
+                                    std::vector<FileSystem::DirEntry>* entries)
+ *  @brief  Append a listed entry, skip `.` and `..`
+ *  @param[in] dir    Listed directory
+ *  @param[in] name   Entry name
+ *  @param[in] type   Entry type (`d_type`)
+ *  @param[out] entries Entries
+ */
+static void AddDirEntry(const std::string& dir,
+                        const char* name,
+                        const unsigned char type,
+                        std::vector<FileSystem::DirEntry>* entries) {
+  if (name[0] == '.' &&
+      (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+    return;
+  }
+  FileSystem::DirEntry entry;
+  entry.path = Path::Join(dir, name);
+  if (type == DT_DIR) {
+    entry.is_dir = true;
+  } else if (type == DT_LNK || type == DT_UNKNOWN) {
+    // Follow links, some file systems do not report types
+    struct stat sbuf;
+    entry.is_dir = stat(entry.path.c_str(), &sbuf) == 0 &&
+                   S_ISDIR(sbuf.st_mode);
+  }
+  entries->push_back(std::move(entry));
+}
+
+#ifdef __linux__
+/**
+ *  @struct LinuxDirent64
+ *  @brief  Record returned by `getdents64`
+ */
+struct LinuxDirent64 {
+  /** Inode */
+  uint64_t d_ino;
+  /** Offset of the next record */
+  int64_t d_off;
+  /** Record size */
+  unsigned short d_reclen;
+  /** Type */
+  unsigned char d_type;
+  /** Null terminated name */
+  char d_name[1];
+};
+
+/** Size of the `getdents64` buffer, several hundreds entries per call */
+static constexpr size_t kDirentBufferSize = 64 * 1024;
+#endif
+#endif
+
+/*
+ *  @name   ListDirEntries
+ *  @fn     Status ListDirEntries(const std::string& dir,
+                                  std::vector<DirEntry>* entries) override
+ *  @brief  List the content of a given directory `dir` with the type of
+ *          each entry, read in large batches with `getdents64` on Linux.
+ *          Types come from the listing, only symbolic links and unknown
+ *          types need a `stat`.
+ *  @param[in] dir  Directory to scan
+ *  @param[out] entries List of entries in `dir`
+ *  @return kGood or Error code
+ */
+Status PosixFileSystem::ListDirEntries(const std::string& dir,
+                                       std::vector<DirEntry>* entries) {
+#ifdef IS_POSIX
+  std::string fname = NormalizePath(dir);
+  entries->clear();
+#ifdef __linux__
+  int fd = open(fname.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    return Status(Status::Type::kInternalError,
+                  "Can not open directory: " + fname);
+  }
+  // 8 bytes aligned buffer
+  std::unique_ptr<uint64_t[]> buffer(new uint64_t[kDirentBufferSize / 8]);
+  char* buff = reinterpret_cast<char*>(buffer.get());
+  while (true) {
+    long n = syscall(SYS_getdents64, fd, buff, kDirentBufferSize);
+    if (n == 0) {
+      break;
+    } else if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      close(fd);
+      return Status(Status::Type::kInternalError,
+                    "Can not list directory: " + fname + ": " +
+                    std::strerror(errno));
+    }
+    for (long off = 0; off < n;) {
+      const auto* d = reinterpret_cast<const LinuxDirent64*>(buff + off);
+      AddDirEntry(fname, d->d_name, d->d_type, entries);
+      off += d->d_reclen;
+    }
+  }
+  close(fd);
+#else
+  DIR* dd = opendir(fname.c_str());
+  if (dd == nullptr) {
+    return Status(Status::Type::kInternalError,
+                  "Can not open directory: " + fname);
+  }
+  struct dirent* entry;
+  while ((entry = readdir(dd)) != nullptr) {
+    AddDirEntry(fname, entry->d_name, entry->d_type, entries);
+  }
+  closedir(dd);
+#endif
+  return Status();
+#else
+  return Status(Status::Type::kUnimplemented, "Not supported");
+#endif
+}
+
 /*
  *  @name   FileProp
  *  @fn     Status FileProp(const std::string& filename,
@@ -104,6 +233,7 @@ Status PosixFileSystem::FileProp(const std::string& filename,
   } else {
     // Stats structure
     prop->size = sbuf.st_size;
+    prop->mtime = static_cast<int64_t>(sbuf.st_mtime);
     prop->is_dir = S_ISDIR(sbuf.st_mode);
   }
   return Status();
@@ -222,6 +352,195 @@ Status PosixFileSystem::QueryFileSize(const std::string& filename,
 #endif
 }
   
+#ifdef IS_POSIX
+
+/**
+ *  @class  PosixRandomAccessFile
+ *  @brief  RandomAccessFile backed by `pread`
+ */
+class PosixRandomAccessFile : public RandomAccessFile {
+ public:
+  /**
+   *  @name   PosixRandomAccessFile
+   *  @brief  Constructor, take ownership of `fd`
+   */
+  PosixRandomAccessFile(const std::string& filename, const int fd) :
+          filename_(filename),
+          fd_(fd) {}
+
+  /**
+   *  @name   ~PosixRandomAccessFile
+   *  @brief  Destructor
+   */
+  ~PosixRandomAccessFile(void) override {
+    close(fd_);
+  }
+
+  /**
+   *  @name   Read
+   *  @brief  Read up to `n` bytes starting at `offset` into `buffer`
+   */
+  Status Read(const size_t& offset,
+              const size_t& n,
+              char* buffer,
+              size_t* n_read) const override {
+    size_t done = 0;
+    while (done < n) {
+      ssize_t r = pread(fd_, buffer + done, n - done, offset + done);
+      if (r > 0) {
+        done += static_cast<size_t>(r);
+      } else if (r == 0) {
+        break;    // End of file
+      } else if (errno != EINTR && errno != EAGAIN) {
+        *n_read = done;
+        return Status(Status::Type::kInternalError,
+                      "Can not read " + filename_ + ": " +
+                      std::strerror(errno));
+      }
+    }
+    *n_read = done;
+    if (done < n) {
+      return Status(Status::Type::kOutOfRange,
+                    "Read less bytes than requested in: " + filename_);
+    }
+    return Status();
+  }
+
+  /**
+   *  @name   Size
+   *  @brief  Query the file size in bytes
+   */
+  Status Size(size_t* size) const override {
+    struct stat sbuf;
+    if (fstat(fd_, &sbuf) != 0) {
+      return Status(Status::Type::kInternalError,
+                    "Can not access: " + filename_);
+    }
+    *size = static_cast<size_t>(sbuf.st_size);
+    return Status();
+  }
+
+ private:
+  /** File name */
+  std::string filename_;
+  /** File descriptor */
+  int fd_;
+};
+
+/**
+ *  @class  PosixReadOnlyMemoryRegion
+ *  @brief  ReadOnlyMemoryRegion backed by `mmap`
+ */
+class PosixReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
+ public:
+  /**
+   *  @name   PosixReadOnlyMemoryRegion
+   *  @brief  Constructor, take ownership of the mapping
+   */
+  PosixReadOnlyMemoryRegion(const void* address, const size_t& length) :
+          address_(address),
+          length_(length) {}
+
+  /**
+   *  @name   ~PosixReadOnlyMemoryRegion
+   *  @brief  Destructor
+   */
+  ~PosixReadOnlyMemoryRegion(void) override {
+    if (address_ != nullptr) {
+      munmap(const_cast<void*>(address_), length_);
+    }
+  }
+
+  /**
+   *  @name   data
+   *  @brief  Start of the mapped region
+   */
+  const void* data(void) const override {
+    return address_;
+  }
+
+  /**
+   *  @name   length
+   *  @brief  Size of the mapped region in bytes
+   */
+  size_t length(void) const override {
+    return length_;
+  }
+
+ private:
+  /** Mapped address */
+  const void* address_;
+  /** Mapped length */
+  size_t length_;
+};
+
+#endif
+
+/*
+ *  @name   NewRandomAccessFile
+ *  @fn     Status NewRandomAccessFile(const std::string& filename,
+                    std::unique_ptr<RandomAccessFile>* file) override
+ *  @brief  Open a file for positional reads (`pread`)
+ *  @param[in] filename File to open
+ *  @param[out] file    Opened file
+ *  @return Status of the operation
+ */
+Status PosixFileSystem::NewRandomAccessFile(const std::string& filename,
+                                      std::unique_ptr<RandomAccessFile>* file) {
+#ifdef IS_POSIX
+  auto fname = NormalizePath(filename);
+  int fd = open(fname.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return Status(Status::Type::kNotFound, "Can not open: " + fname);
+  }
+  file->reset(new PosixRandomAccessFile(fname, fd));
+  return Status();
+#else
+  return Status(Status::Type::kUnimplemented, "Not supported");
+#endif
+}
+
+/*
+ *  @name   NewReadOnlyMemoryRegion
+ *  @fn     Status NewReadOnlyMemoryRegion(const std::string& filename,
+                    std::unique_ptr<ReadOnlyMemoryRegion>* region) override
+ *  @brief  Map the whole content of a file in memory (`mmap`), read-only
+ *  @param[in] filename File to map
+ *  @param[out] region  Mapped region
+ *  @return Status of the operation
+ */
+Status PosixFileSystem::NewReadOnlyMemoryRegion(const std::string& filename,
+                                 std::unique_ptr<ReadOnlyMemoryRegion>* region) {
+#ifdef IS_POSIX
+  auto fname = NormalizePath(filename);
+  int fd = open(fname.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return Status(Status::Type::kNotFound, "Can not open: " + fname);
+  }
+  Status status;
+  struct stat sbuf;
+  if (fstat(fd, &sbuf) != 0) {
+    status = Status(Status::Type::kInternalError, "Can not access: " + fname);
+  } else if (sbuf.st_size == 0) {
+    // Nothing to map
+    region->reset(new PosixReadOnlyMemoryRegion(nullptr, 0));
+  } else {
+    const size_t length = static_cast<size_t>(sbuf.st_size);
+    void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+      status = Status(Status::Type::kInternalError, "Can not map: " + fname);
+    } else {
+      region->reset(new PosixReadOnlyMemoryRegion(address, length));
+    }
+  }
+  // Mapping stays valid once the descriptor is closed
+  close(fd);
+  return status;
+#else
+  return Status(Status::Type::kUnimplemented, "Not supported");
+#endif
+}
+  
 // Register file system
 REGISTER_FILE_SYSTEM("Posix", PosixFileSystem);
   
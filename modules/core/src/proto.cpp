@@ -166,31 +166,27 @@ void EncodeStringList(const std::string* list,
 bool DecodeStringList(const std::string& in,
                       const size_t& n,
                       std::string* str) {
-  // Get payload dimensions stored at the begin of the array
+  // Get payload dimensions stored at the begin of the array, decoded in
+  // place without copying the remaining buffer
   std::vector<uint32_t> dims(n, 0);
-  std::string src(in); // Copy data
+  const char* ptr = in.data();
+  const char* limit = ptr + in.size();
   int64_t length = 0;
   for (auto& d : dims) {
-    if(!RetrieveVarInt32(&src, &d)) {
+    ptr = DecodeVarInt32(ptr, limit, &d);
+    if (ptr == nullptr) {
       return false;
-    } else {
-      length += d;
     }
+    length += d;
   }
   // Check if we reach the end of the buffer
-  if (length != static_cast<int64_t>(src.size())) {
+  if (length != static_cast<int64_t>(limit - ptr)) {
     return false;
   }
-  
   std::string* data = str;
-  size_t shift = 0;
   for (size_t k = 0; k < n; ++k, ++data) {
-    auto& d = dims[k];
-    if (d > src.size()) {
-      return false; // Buffer too shord, ask for too large chunk of memory
-    }
-    data->assign(src.data() + shift, d);
-    shift += d;
+    data->assign(ptr, dims[k]);
+    ptr += dims[k];
   }
   return true;
 }
@@ -0,0 +1,278 @@
+/**
+ *  @file   quantized_matrix.cpp
+ *  @brief  Dense matrix stored in reduced precision (fp16, bf16, int8) with
+ *          matrix-vector products accumulating in single precision
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   03.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "facekit/core/math/quantized_matrix.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "nd_array_ops_kernels.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Minimum number of elements before products are split over threads */
+static constexpr size_t kParallelElements = 1 << 16;
+
+/**
+ *  @name   ForEachRange
+ *  @fn     static void ForEachRange(const size_t& n, const size_t& work,
+                                     const Func& func)
+ *  @brief  Call `func(first, last)` over [0, n), in parallel when the amount
+ *          of work is large enough.
+ *  @param[in] n    Number of items
+ *  @param[in] work Amount of work
+ *  @param[in] func Callable processing items [first, last)
+ *  @tparam Func Callable type
+ */
+template<typename Func>
+static void ForEachRange(const size_t& n, const size_t& work,
+                         const Func& func) {
+  if (work >= kParallelElements && n > 1) {
+    ThreadPool::Get().ParallelFor(0, n, 0, func);
+  } else {
+    func(0, n);
+  }
+}
+
+/**
+ *  @name   QuantizedGemv
+ *  @fn     static void QuantizedGemv(const Q* q, const std::vector<float>& s,
+                                      const int& rows, const int& cols,
+                                      const bool& trans, const float& alpha,
+                                      const float* x, const float& beta,
+                                      float* y, dot, axpy)
+ *  @brief  y = alpha * op(Q * diag(s)) * x + beta * y
+ *  @tparam Q Storage type
+ */
+template<typename Q>
+static void QuantizedGemv(const Q* q,
+                          const std::vector<float>& s,
+                          const int& rows,
+                          const int& cols,
+                          const bool& trans,
+                          const float& alpha,
+                          const float* x,
+                          const float& beta,
+                          float* y,
+                          float (*dot)(const Q*, const float*, const size_t&),
+                          void (*axpy)(const Q*, const float, float*,
+                                       const size_t&)) {
+  const size_t nr = static_cast<size_t>(rows);
+  const size_t nc = static_cast<size_t>(cols);
+  if (!trans) {
+    // Fold column scales into the input: A * x = Q * (s .* x)
+    std::vector<float> xs(nc);
+    for (size_t j = 0; j < nc; ++j) {
+      xs[j] = alpha * s[j] * x[j];
+    }
+    ForEachRange(nr, nr * nc, [&](const size_t& first, const size_t& last) {
+      for (size_t i = first; i < last; ++i) {
+        const float d = dot(q + i * nc, xs.data(), nc);
+        y[i] = beta == 0.f ? d : d + beta * y[i];
+      }
+    });
+  } else {
+    // A' * x = s .* (sum_i x_i * Q(i, :)), split over columns to avoid any
+    // reduction between threads
+    std::vector<float> acc(nc, 0.f);
+    ForEachRange(nc, nr * nc, [&](const size_t& first, const size_t& last) {
+      for (size_t i = 0; i < nr; ++i) {
+        axpy(q + i * nc + first, x[i], acc.data() + first, last - first);
+      }
+      for (size_t j = first; j < last; ++j) {
+        const float v = alpha * s[j] * acc[j];
+        y[j] = beta == 0.f ? v : v + beta * y[j];
+      }
+    });
+  }
+}
+
+/*
+ *  @name   QuantizedMatrix
+ *  @fn     QuantizedMatrix(void)
+ *  @brief  Constructor
+ */
+QuantizedMatrix::QuantizedMatrix(void) : rows_(0),
+                                         cols_(0),
+                                         format_(Format::kFloat16) {
+}
+
+/*
+ *  @name   Quantize
+ *  @fn     Status Quantize(const float* data, const int& rows,
+                            const int& cols, const Format& format)
+ *  @brief  Convert a row-major single precision matrix
+ *  @param[in] data   Matrix, rows x cols elements
+ *  @param[in] rows   Number of rows
+ *  @param[in] cols   Number of columns
+ *  @param[in] format Storage format
+ *  @return kInvalidArgument if dimensions are negative
+ */
+Status QuantizedMatrix::Quantize(const float* data,
+                                 const int& rows,
+                                 const int& cols,
+                                 const Format& format) {
+  return this->QuantizeImpl(data, rows, cols, format);
+}
+
+/*
+ *  @name   Quantize
+ *  @fn     Status Quantize(const double* data, const int& rows,
+                            const int& cols, const Format& format)
+ *  @brief  Convert a row-major double precision matrix
+ *  @param[in] data   Matrix, rows x cols elements
+ *  @param[in] rows   Number of rows
+ *  @param[in] cols   Number of columns
+ *  @param[in] format Storage format
+ *  @return kInvalidArgument if dimensions are negative
+ */
+Status QuantizedMatrix::Quantize(const double* data,
+                                 const int& rows,
+                                 const int& cols,
+                                 const Format& format) {
+  return this->QuantizeImpl(data, rows, cols, format);
+}
+
+/*
+ *  @name   QuantizeImpl
+ *  @fn     template<typename T> Status QuantizeImpl(const T* data,
+                                                     const int& rows,
+                                                     const int& cols,
+                                                     const Format& format)
+ *  @brief  Convert a row-major matrix
+ *  @tparam T Source data type
+ */
+template<typename T>
+Status QuantizedMatrix::QuantizeImpl(const T* data,
+                                     const int& rows,
+                                     const int& cols,
+                                     const Format& format) {
+  if (rows < 0 || cols < 0) {
+    return Status(Status::Type::kInvalidArgument, "Negative dimensions");
+  }
+  rows_ = rows;
+  cols_ = cols;
+  format_ = format;
+  const size_t nc = static_cast<size_t>(cols);
+  const size_t n = static_cast<size_t>(rows) * nc;
+  scale_.assign(nc, 1.f);
+  data_.resize(n * this->ElementSize());
+  switch (format) {
+    case Format::kFloat16: {
+      Half* dst = reinterpret_cast<Half*>(data_.data());
+      for (size_t k = 0; k < n; ++k) {
+        dst[k] = Half(static_cast<float>(data[k]));
+      }
+    }
+      break;
+
+    case Format::kBFloat16: {
+      uint16_t* dst = reinterpret_cast<uint16_t*>(data_.data());
+      for (size_t k = 0; k < n; ++k) {
+        dst[k] = FloatToBFloat16Bits(static_cast<float>(data[k]));
+      }
+    }
+      break;
+
+    case Format::kInt8: {
+      // Symmetric quantization, column's largest magnitude maps to 127
+      std::vector<T> amax(nc, T(0.0));
+      for (size_t k = 0; k < n; ++k) {
+        const size_t j = k % nc;
+        amax[j] = std::max(amax[j], std::abs(data[k]));
+      }
+      for (size_t j = 0; j < nc; ++j) {
+        scale_[j] = static_cast<float>(amax[j] / T(127.0));
+      }
+      int8_t* dst = reinterpret_cast<int8_t*>(data_.data());
+      for (size_t k = 0; k < n; ++k) {
+        const size_t j = k % nc;
+        const T v = amax[j] > T(0.0) ? T(127.0) * data[k] / amax[j] : T(0.0);
+        dst[k] = static_cast<int8_t>(std::lround(v));
+      }
+    }
+      break;
+  }
+  return Status();
+}
+
+/*
+ *  @name   Dequantize
+ *  @fn     void Dequantize(float* data) const
+ *  @brief  Expand into a row-major single precision matrix
+ *  @param[out] data  Matrix, rows x cols elements
+ */
+void QuantizedMatrix::Dequantize(float* data) const {
+  const size_t nc = static_cast<size_t>(cols_);
+  const size_t n = static_cast<size_t>(rows_) * nc;
+  for (size_t k = 0; k < n; ++k) {
+    float v = 0.f;
+    switch (format_) {
+      case Format::kFloat16:
+        v = internal::Dequantize(
+                reinterpret_cast<const Half*>(data_.data())[k]);
+        break;
+      case Format::kBFloat16:
+        v = internal::Dequantize(
+                reinterpret_cast<const uint16_t*>(data_.data())[k]);
+        break;
+      case Format::kInt8:
+        v = internal::Dequantize(
+                reinterpret_cast<const int8_t*>(data_.data())[k]);
+        break;
+    }
+    data[k] = v * scale_[k % nc];
+  }
+}
+
+/*
+ *  @name   Gemv
+ *  @fn     void Gemv(const bool& trans, const float& alpha, const float* x,
+                      const float& beta, float* y) const
+ *  @brief  Matrix-vector product y = alpha * op(A) * x + beta * y, rows
+ *          are split over the default thread pool for large matrices.
+ *  @param[in] trans  If true op(A) = A', otherwise op(A) = A
+ *  @param[in] alpha  Scaling factor for the product
+ *  @param[in] x      Input vector, cols (rows if transposed) elements
+ *  @param[in] beta   Scaling factor for y, if 0 `y` is not read
+ *  @param[in,out] y  Output vector, rows (cols if transposed) elements,
+ *                    must not alias `x`
+ */
+void QuantizedMatrix::Gemv(const bool& trans,
+                           const float& alpha,
+                           const float* x,
+                           const float& beta,
+                           float* y) const {
+  const auto& k = internal::SelectedQuantKernels();
+  switch (format_) {
+    case Format::kFloat16:
+      QuantizedGemv(reinterpret_cast<const Half*>(data_.data()), scale_,
+                    rows_, cols_, trans, alpha, x, beta, y,
+                    k.dot_f16, k.axpy_f16);
+      break;
+    case Format::kBFloat16:
+      QuantizedGemv(reinterpret_cast<const uint16_t*>(data_.data()), scale_,
+                    rows_, cols_, trans, alpha, x, beta, y,
+                    k.dot_bf16, k.axpy_bf16);
+      break;
+    case Format::kInt8:
+      QuantizedGemv(reinterpret_cast<const int8_t*>(data_.data()), scale_,
+                    rows_, cols_, trans, alpha, x, beta, y,
+                    k.dot_s8, k.axpy_s8);
+      break;
+  }
+}
+
+}  // namespace FaceKit
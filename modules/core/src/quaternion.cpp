@@ -0,0 +1,179 @@
+/**
+ *  @file   quaternion.cpp
+ *  @brief  Quaternion abstraction, batch kernels
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#include "facekit/core/math/quaternion.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Number of quaternions transposed at once, fits in L1 */
+static constexpr size_t kQuaternionBlock = 128;
+
+/**
+ *  @struct QuaternionBlock
+ *  @brief  Block of quaternions stored as structure of arrays
+ *  @tparam T Data type
+ */
+template<typename T>
+struct QuaternionBlock {
+  /** Real part */
+  alignas(64) T w[kQuaternionBlock];
+  /** Imaginary x */
+  alignas(64) T x[kQuaternionBlock];
+  /** Imaginary y */
+  alignas(64) T y[kQuaternionBlock];
+  /** Imaginary z */
+  alignas(64) T z[kQuaternionBlock];
+
+  /**
+   *  @name   Load
+   *  @fn     void Load(const Quaternion<T>* q, const size_t& n)
+   *  @brief  Transpose `n` quaternions into the block
+   */
+  void Load(const Quaternion<T>* q, const size_t& n) {
+    for (size_t i = 0; i < n; ++i) {
+      w[i] = q[i].q_;
+      x[i] = q[i].v_.x_;
+      y[i] = q[i].v_.y_;
+      z[i] = q[i].v_.z_;
+    }
+  }
+
+  /**
+   *  @name   Store
+   *  @fn     void Store(Quaternion<T>* q, const size_t& n) const
+   *  @brief  Transpose `n` quaternions back into array of structures
+   */
+  void Store(Quaternion<T>* q, const size_t& n) const {
+    for (size_t i = 0; i < n; ++i) {
+      q[i].q_ = w[i];
+      q[i].v_.x_ = x[i];
+      q[i].v_.y_ = y[i];
+      q[i].v_.z_ = z[i];
+    }
+  }
+};
+
+#pragma mark -
+#pragma mark Batch
+
+/*
+ *  @name ComposeBatch
+ *  @fn static void ComposeBatch(const Quaternion* a, const Quaternion* b,
+                                 Quaternion* out, const size_t& n)
+ *  @brief  Compute out_i = a_i * b_i for `n` pairs of quaternions.
+ *  @param[in]  a   Left hand side quaternions
+ *  @param[in]  b   Right hand side quaternions
+ *  @param[out] out Products, can be `a` or `b`
+ *  @param[in]  n   Number of quaternions
+ */
+template<typename T>
+void Quaternion<T>::ComposeBatch(const Quaternion* a,
+                                 const Quaternion* b,
+                                 Quaternion* out,
+                                 const size_t& n) {
+  QuaternionBlock<T> qa, qb, qo;
+  for (size_t s = 0; s < n; s += kQuaternionBlock) {
+    const size_t nb = std::min(kQuaternionBlock, n - s);
+    qa.Load(a + s, nb);
+    qb.Load(b + s, nb);
+    for (size_t i = 0; i < nb; ++i) {
+      qo.w[i] = (qa.w[i] * qb.w[i] - qa.x[i] * qb.x[i] -
+                 qa.y[i] * qb.y[i] - qa.z[i] * qb.z[i]);
+      qo.x[i] = (qa.w[i] * qb.x[i] + qa.x[i] * qb.w[i] +
+                 qa.y[i] * qb.z[i] - qa.z[i] * qb.y[i]);
+      qo.y[i] = (qa.w[i] * qb.y[i] + qa.y[i] * qb.w[i] +
+                 qa.z[i] * qb.x[i] - qa.x[i] * qb.z[i]);
+      qo.z[i] = (qa.w[i] * qb.z[i] + qa.z[i] * qb.w[i] +
+                 qa.x[i] * qb.y[i] - qa.y[i] * qb.x[i]);
+    }
+    qo.Store(out + s, nb);
+  }
+}
+
+/*
+ *  @name NormalizeBatch
+ *  @fn static void NormalizeBatch(Quaternion* q, const size_t& n)
+ *  @brief  Normalize `n` quaternions in place.
+ *  @param[in,out] q  Quaternions to normalize
+ *  @param[in]     n  Number of quaternions
+ */
+template<typename T>
+void Quaternion<T>::NormalizeBatch(Quaternion* q, const size_t& n) {
+  QuaternionBlock<T> qb;
+  for (size_t s = 0; s < n; s += kQuaternionBlock) {
+    const size_t nb = std::min(kQuaternionBlock, n - s);
+    qb.Load(q + s, nb);
+    for (size_t i = 0; i < nb; ++i) {
+      const T sn = (qb.w[i] * qb.w[i] + qb.x[i] * qb.x[i] +
+                    qb.y[i] * qb.y[i] + qb.z[i] * qb.z[i]);
+      const T is = T(1.0) / std::sqrt(sn);
+      qb.w[i] *= is;
+      qb.x[i] *= is;
+      qb.y[i] *= is;
+      qb.z[i] *= is;
+    }
+    qb.Store(q + s, nb);
+  }
+}
+
+/*
+ *  @name ToRotationMatrixBatch
+ *  @fn static void ToRotationMatrixBatch(const Quaternion* q,
+                                          Matrix3<T>* m, const size_t& n)
+ *  @brief  Convert `n` normalized quaternions to rotation matrices.
+ *  @param[in]  q Quaternions
+ *  @param[out] m Rotation matrices
+ *  @param[in]  n Number of quaternions
+ */
+template<typename T>
+void Quaternion<T>::ToRotationMatrixBatch(const Quaternion* q,
+                                          Matrix3<T>* m,
+                                          const size_t& n) {
+  static_assert(sizeof(Matrix3<T>) == 9 * sizeof(T),
+                "Matrix3 is expected to be packed");
+  QuaternionBlock<T> qb;
+  for (size_t s = 0; s < n; s += kQuaternionBlock) {
+    const size_t nb = std::min(kQuaternionBlock, n - s);
+    qb.Load(q + s, nb);
+    T* dst = m[s].data();
+    for (size_t i = 0; i < nb; ++i) {
+      const T w = qb.w[i], x = qb.x[i], y = qb.y[i], z = qb.z[i];
+      const T ww = w * w, xx = x * x, yy = y * y, zz = z * z;
+      T* mm = dst + 9 * i;
+      mm[0] = ww + xx - yy - zz;
+      mm[1] = T(2.0) * (x * y + w * z);
+      mm[2] = T(2.0) * (x * z - w * y);
+      mm[3] = T(2.0) * (x * y - w * z);
+      mm[4] = ww - xx + yy - zz;
+      mm[5] = T(2.0) * (y * z + w * x);
+      mm[6] = T(2.0) * (x * z + w * y);
+      mm[7] = T(2.0) * (y * z - w * x);
+      mm[8] = ww - xx - yy + zz;
+    }
+  }
+}
+
+#pragma mark -
+#pragma mark Explicit Instantiation
+
+/** Float */
+template class Quaternion<float>;
+/** Double */
+template class Quaternion<double>;
+
+}  // namespace FaceKit
@@ -9,6 +9,8 @@
  *  Copyright © 2018 Christophe Ecabert. All rights reserved.
  */
 
+#include <cstring>
+
 #include "facekit/core/utils/scanner.hpp"
 
 /**
@@ -28,16 +30,16 @@ namespace String {
   
 /*
  *  @name   Scanner
- *  @fn     explicit Scanner(const std::string& str)
- *  @brief  Constructor
+ *  @fn     explicit Scanner(const StringView& str)
+ *  @brief  Constructor. The input is not copied, it must outlive the
+ *          scanner and any view returned by `Result`.
  *  @param[in] str  String to parse
  */
-Scanner::Scanner(const std::string& str) : str_(str),
-                                           begin_(str_.data()),
-                                           end_(begin_ + str_.size()),
-                                           start_(nullptr),
-                                           stop_(nullptr),
-                                           error_(false) {
+Scanner::Scanner(const StringView& str) : begin_(str.data()),
+                                          end_(begin_ + str.size()),
+                                          start_(nullptr),
+                                          stop_(nullptr),
+                                          error_(false) {
   RestartCapture();
 }
   
@@ -64,26 +66,26 @@ Scanner& Scanner::One(const CharType& type) {
 
 /*
  *  @name   ZeroOrOneLiteral
- *  @fn     Scanner& ZeroOrOneLiteral(const std::string& s)
+ *  @fn     Scanner& ZeroOrOneLiteral(const StringView& s)
  *  @brief  Consume the next s.size() characters of the input, if they match
  *          `s`. If they don't match `s`, this is a no-op.
  *  @param[in] s  Literal to match
  *  @return This scanner
  */
-Scanner& Scanner::ZeroOrOneLiteral(const std::string& s) {
+Scanner& Scanner::ZeroOrOneLiteral(const StringView& s) {
   this->Consume(s);
   return *this;
 }
 
 /*
  *  @name   OneLiteral
- *  @fn     Scanner& OneLiteral(const std::string& s)
+ *  @fn     Scanner& OneLiteral(const StringView& s)
  *  @brief  Consume the next s.size() characters of the input, if they match
  *          `s`. If they don't match `s`, then Result will return false.
  *  @param[in] s  Literal to match
  *  @return This scanner
  */
-Scanner& Scanner::OneLiteral(const std::string& s) {
+Scanner& Scanner::OneLiteral(const StringView& s) {
   if (!this->Consume(s)) {
     return Error();
   }
@@ -225,6 +227,28 @@ bool Scanner::Result(std::string* remaining,
   }
   return !error_;
 }
+
+/*
+ *  @name   Result
+ *  @fn     bool Result(StringView* remaining, StringView* capture)
+ *  @brief  Same as `Result(std::string*, std::string*)` without copy, the
+ *          outputs are views into the scanned input.
+ *  @param[out] remaining Part of the string that as not been scanned
+ *  @param[out] capture   Part of the string that has been captured.
+ *  @return True if successfully matched, false otherwise.
+ */
+bool Scanner::Result(StringView* remaining, StringView* capture) {
+  if (!error_) {
+    if (remaining) {
+      *remaining = StringView(begin_, end_ - begin_);
+    }
+    if (capture) {
+      const char* end = stop_ == nullptr ? begin_ : stop_;
+      *capture = StringView(start_, end - start_);
+    }
+  }
+  return !error_;
+}
   
   
 #pragma mark -
@@ -277,16 +301,16 @@ Scanner& Scanner::Error(void) {
   
 /*
  *  @name   Consume
- *  @fn     bool Consume(const std::string& s)
+ *  @fn     bool Consume(const StringView& s)
  *  @brief  Check if `s` match with the current position of the scanner.
  *  @param[in]  s String to be matched
  *  @return True if `s` matched, false otherwise
  */
-bool Scanner::Consume(const std::string& s) {
+bool Scanner::Consume(const StringView& s) {
   bool match = false;
   // Check if `s` is smaller than the string being scan
-  if (s.length() <= (end_ - begin_)) {
-    match = std::string(begin_, s.length()) == s;
+  if (s.length() <= static_cast<size_t>(end_ - begin_)) {
+    match = s.empty() || std::memcmp(begin_, s.data(), s.length()) == 0;
     if (match) {
       begin_ += s.length();
     }
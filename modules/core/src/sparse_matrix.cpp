@@ -0,0 +1,474 @@
+/**
+ *  @file   sparse_matrix.cpp
+ *  @brief  Compressed sparse row matrix, sparse products and conjugate
+ *          gradient solver
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   31.08.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "facekit/core/math/sparse_matrix.hpp"
+#include "facekit/core/thread_pool.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Minimum number of non-zeros before products are split over threads */
+static constexpr int kParallelNnz = 1 << 15;
+
+/**
+ *  @name   ForEachRow
+ *  @fn     static void ForEachRow(const int& rows, const int& nnz,
+                                   const Func& func)
+ *  @brief  Call `func(first, last)` over row ranges, in parallel when the
+ *          amount of work is large enough.
+ *  @param[in] rows Number of rows
+ *  @param[in] nnz  Amount of work
+ *  @param[in] func Callable processing rows [first, last)
+ *  @tparam Func Callable type
+ */
+template<typename Func>
+static void ForEachRow(const int& rows, const int& nnz, const Func& func) {
+  if (nnz >= kParallelNnz && rows > 1) {
+    ThreadPool::Get().ParallelFor(0,
+                                  static_cast<size_t>(rows),
+                                  0,
+                                  [&](const size_t& first,
+                                      const size_t& last) {
+      func(static_cast<int>(first), static_cast<int>(last));
+    });
+  } else {
+    func(0, rows);
+  }
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   SparseMatrix
+ *  @fn     SparseMatrix(void)
+ *  @brief  Constructor
+ */
+template<typename T>
+SparseMatrix<T>::SparseMatrix(void) : rows_(0),
+                                      cols_(0),
+                                      row_ptr_(1, 0) {
+}
+
+/*
+ *  @name   SparseMatrix
+ *  @fn     SparseMatrix(const int& rows, const int& cols)
+ *  @brief  Constructor, create an empty (all zeros) matrix
+ *  @param[in] rows Number of rows
+ *  @param[in] cols Number of columns
+ */
+template<typename T>
+SparseMatrix<T>::SparseMatrix(const int& rows,
+                              const int& cols) : rows_(rows),
+                                                 cols_(cols),
+                                                 row_ptr_(rows + 1, 0) {
+}
+
+/*
+ *  @name   FromTriplets
+ *  @fn     Status FromTriplets(const int& rows, const int& cols,
+                                const std::vector<Triplet>& triplets)
+ *  @brief  Build matrix from a list of entries in any order, duplicated
+ *          entries are summed.
+ *  @param[in] rows     Number of rows
+ *  @param[in] cols     Number of columns
+ *  @param[in] triplets Non-zero entries
+ *  @return kInvalidArgument if an entry is out of bounds
+ */
+template<typename T>
+Status SparseMatrix<T>::FromTriplets(const int& rows,
+                                     const int& cols,
+                                     const std::vector<Triplet>& triplets) {
+  if (rows < 0 || cols < 0) {
+    return Status(Status::Type::kInvalidArgument, "Negative dimensions");
+  }
+  for (const auto& e : triplets) {
+    if (e.row < 0 || e.row >= rows || e.col < 0 || e.col >= cols) {
+      return Status(Status::Type::kInvalidArgument,
+                    "Triplet out of matrix bounds");
+    }
+  }
+  // Counting sort by row
+  std::vector<int> ptr(rows + 1, 0);
+  for (const auto& e : triplets) {
+    ptr[e.row + 1] += 1;
+  }
+  for (int r = 0; r < rows; ++r) {
+    ptr[r + 1] += ptr[r];
+  }
+  std::vector<int> cidx(triplets.size());
+  std::vector<T> val(triplets.size());
+  std::vector<int> pos(ptr.begin(), ptr.end() - 1);
+  for (const auto& e : triplets) {
+    const int p = pos[e.row]++;
+    cidx[p] = e.col;
+    val[p] = e.value;
+  }
+  // Sort columns within each row and merge duplicates
+  rows_ = rows;
+  cols_ = cols;
+  row_ptr_.assign(rows + 1, 0);
+  col_idx_.clear();
+  values_.clear();
+  col_idx_.reserve(triplets.size());
+  values_.reserve(triplets.size());
+  std::vector<int> order;
+  for (int r = 0; r < rows; ++r) {
+    order.resize(ptr[r + 1] - ptr[r]);
+    for (size_t i = 0; i < order.size(); ++i) {
+      order[i] = ptr[r] + static_cast<int>(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+      return cidx[a] < cidx[b];
+    });
+    for (const int& p : order) {
+      if (static_cast<int>(col_idx_.size()) > row_ptr_[r] &&
+          col_idx_.back() == cidx[p]) {
+        values_.back() += val[p];
+      } else {
+        col_idx_.push_back(cidx[p]);
+        values_.push_back(val[p]);
+      }
+    }
+    row_ptr_[r + 1] = static_cast<int>(col_idx_.size());
+  }
+  return Status();
+}
+
+/*
+ *  @name   Transpose
+ *  @fn     void Transpose(SparseMatrix* out) const
+ *  @brief  Compute the transpose, i.e. the CSC representation of this
+ *          matrix.
+ *  @param[out] out Transposed matrix
+ */
+template<typename T>
+void SparseMatrix<T>::Transpose(SparseMatrix* out) const {
+  out->rows_ = cols_;
+  out->cols_ = rows_;
+  out->row_ptr_.assign(cols_ + 1, 0);
+  out->col_idx_.resize(col_idx_.size());
+  out->values_.resize(values_.size());
+  for (const int& c : col_idx_) {
+    out->row_ptr_[c + 1] += 1;
+  }
+  for (int c = 0; c < cols_; ++c) {
+    out->row_ptr_[c + 1] += out->row_ptr_[c];
+  }
+  // Scanning rows in order keeps column indices sorted in the output
+  std::vector<int> pos(out->row_ptr_.begin(), out->row_ptr_.end() - 1);
+  for (int r = 0; r < rows_; ++r) {
+    for (int k = row_ptr_[r]; k < row_ptr_[r + 1]; ++k) {
+      const int p = pos[col_idx_[k]]++;
+      out->col_idx_[p] = r;
+      out->values_[p] = values_[k];
+    }
+  }
+}
+
+/*
+ *  @name   Diagonal
+ *  @fn     void Diagonal(std::vector<T>* diag) const
+ *  @brief  Extract the main diagonal
+ *  @param[out] diag  Diagonal, min(rows, cols) elements
+ */
+template<typename T>
+void SparseMatrix<T>::Diagonal(std::vector<T>* diag) const {
+  const int n = std::min(rows_, cols_);
+  diag->assign(n, T(0.0));
+  for (int r = 0; r < n; ++r) {
+    const auto first = col_idx_.begin() + row_ptr_[r];
+    const auto last = col_idx_.begin() + row_ptr_[r + 1];
+    const auto it = std::lower_bound(first, last, r);
+    if (it != last && *it == r) {
+      (*diag)[r] = values_[it - col_idx_.begin()];
+    }
+  }
+}
+
+/*
+ *  @name   ToDense
+ *  @fn     void ToDense(T* dense, const int& ld) const
+ *  @brief  Expand into a row-major dense buffer
+ *  @param[out] dense Buffer of at least rows * ld elements
+ *  @param[in] ld     Leading dimension of `dense`, >= cols
+ */
+template<typename T>
+void SparseMatrix<T>::ToDense(T* dense, const int& ld) const {
+  for (int r = 0; r < rows_; ++r) {
+    T* dst = dense + static_cast<size_t>(r) * ld;
+    std::fill(dst, dst + cols_, T(0.0));
+    for (int k = row_ptr_[r]; k < row_ptr_[r + 1]; ++k) {
+      dst[col_idx_[k]] = values_[k];
+    }
+  }
+}
+
+#pragma mark -
+#pragma mark Products
+
+/*
+ *  @name   Spmv
+ *  @fn     void Spmv(const T& alpha, const T* x, const T& beta,
+                      T* y) const
+ *  @brief  Sparse matrix - dense vector product, y = alpha * A * x +
+ *          beta * y
+ *  @param[in] alpha      Scaling factor for the product
+ *  @param[in] x          Vector of `cols` elements
+ *  @param[in] beta       Scaling factor for `y`, if 0 `y` is not read
+ *  @param[in,out] y      Vector of `rows` elements, must not alias `x`
+ */
+template<typename T>
+void SparseMatrix<T>::Spmv(const T& alpha,
+                           const T* x,
+                           const T& beta,
+                           T* y) const {
+  const int* ptr = row_ptr_.data();
+  const int* idx = col_idx_.data();
+  const T* val = values_.data();
+  ForEachRow(rows_, nnz(), [&](const int& first, const int& last) {
+    for (int r = first; r < last; ++r) {
+      T acc = T(0.0);
+      for (int k = ptr[r]; k < ptr[r + 1]; ++k) {
+        acc += val[k] * x[idx[k]];
+      }
+      y[r] = beta == T(0.0) ? alpha * acc : alpha * acc + beta * y[r];
+    }
+  });
+}
+
+/*
+ *  @name   Spmm
+ *  @fn     void Spmm(const T& alpha, const T* b, const int& k,
+                      const int& ldb, const T& beta, T* c,
+                      const int& ldc) const
+ *  @brief  Sparse matrix - dense matrix product, C = alpha * A * B +
+ *          beta * C
+ *  @param[in] alpha    Scaling factor for the product
+ *  @param[in] b        Row-major dense matrix [cols x k]
+ *  @param[in] k        Number of columns in B and C
+ *  @param[in] ldb      Leading dimension of B, >= k
+ *  @param[in] beta     Scaling factor for C, if 0 C is not read
+ *  @param[in,out] c    Row-major dense matrix [rows x k], must not alias B
+ *  @param[in] ldc      Leading dimension of C, >= k
+ */
+template<typename T>
+void SparseMatrix<T>::Spmm(const T& alpha,
+                           const T* b,
+                           const int& k,
+                           const int& ldb,
+                           const T& beta,
+                           T* c,
+                           const int& ldc) const {
+  const int* ptr = row_ptr_.data();
+  const int* idx = col_idx_.data();
+  const T* val = values_.data();
+  ForEachRow(rows_, nnz() * k, [&](const int& first, const int& last) {
+    for (int r = first; r < last; ++r) {
+      // Accumulate scaled rows of B, inner loop is contiguous
+      T* dst = c + static_cast<size_t>(r) * ldc;
+      if (beta == T(0.0)) {
+        std::fill(dst, dst + k, T(0.0));
+      } else if (beta != T(1.0)) {
+        for (int j = 0; j < k; ++j) {
+          dst[j] *= beta;
+        }
+      }
+      for (int p = ptr[r]; p < ptr[r + 1]; ++p) {
+        const T a = alpha * val[p];
+        const T* src = b + static_cast<size_t>(idx[p]) * ldb;
+        for (int j = 0; j < k; ++j) {
+          dst[j] += a * src[j];
+        }
+      }
+    }
+  });
+}
+
+/*
+ *  @name   Multiply
+ *  @fn     static Status Multiply(const SparseMatrix& a,
+                                   const SparseMatrix& b,
+                                   SparseMatrix* c)
+ *  @brief  Sparse matrix - sparse matrix product, C = A * B
+ *  @param[in] a    Left operand
+ *  @param[in] b    Right operand
+ *  @param[out] c   Product, must not be `a` or `b`
+ *  @return kInvalidArgument if dimensions do not match
+ */
+template<typename T>
+Status SparseMatrix<T>::Multiply(const SparseMatrix& a,
+                                 const SparseMatrix& b,
+                                 SparseMatrix* c) {
+  if (a.cols_ != b.rows_) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Dimensions mismatch for sparse product");
+  }
+  // Gustavson's algorithm: row i of C is a combination of rows of B, merged
+  // with a dense accumulator and a marker of the touched columns.
+  c->rows_ = a.rows_;
+  c->cols_ = b.cols_;
+  c->row_ptr_.assign(a.rows_ + 1, 0);
+  c->col_idx_.clear();
+  c->values_.clear();
+  std::vector<T> acc(b.cols_, T(0.0));
+  std::vector<int> marker(b.cols_, -1);
+  std::vector<int> touched;
+  for (int r = 0; r < a.rows_; ++r) {
+    touched.clear();
+    for (int p = a.row_ptr_[r]; p < a.row_ptr_[r + 1]; ++p) {
+      const int row_b = a.col_idx_[p];
+      const T va = a.values_[p];
+      for (int q = b.row_ptr_[row_b]; q < b.row_ptr_[row_b + 1]; ++q) {
+        const int col = b.col_idx_[q];
+        if (marker[col] != r) {
+          marker[col] = r;
+          acc[col] = T(0.0);
+          touched.push_back(col);
+        }
+        acc[col] += va * b.values_[q];
+      }
+    }
+    std::sort(touched.begin(), touched.end());
+    for (const int& col : touched) {
+      c->col_idx_.push_back(col);
+      c->values_.push_back(acc[col]);
+    }
+    c->row_ptr_[r + 1] = static_cast<int>(c->col_idx_.size());
+  }
+  return Status();
+}
+
+#pragma mark -
+#pragma mark Conjugate Gradient
+
+/*
+ *  @name   ConjugateGradient
+ *  @fn     ConjugateGradient(void)
+ *  @brief  Constructor, at most 1000 iterations with a relative
+ *          tolerance of 1e-6
+ */
+template<typename T>
+ConjugateGradient<T>::ConjugateGradient(void) : max_iter_(1000),
+                                                tol_(T(1e-6)),
+                                                iter_(0),
+                                                residual_(T(0.0)) {
+}
+
+/**
+ *  @name   Dot
+ *  @fn     static T Dot(const std::vector<T>& a, const T* b)
+ *  @brief  Inner product
+ *  @param[in] a  First vector
+ *  @param[in] b  Second vector, same length as `a`
+ *  @return <a, b>
+ *  @tparam T Data type
+ */
+template<typename T>
+static T Dot(const std::vector<T>& a, const T* b) {
+  T acc = T(0.0);
+  for (size_t i = 0; i < a.size(); ++i) {
+    acc += a[i] * b[i];
+  }
+  return acc;
+}
+
+/*
+ *  @name   Solve
+ *  @fn     Status Solve(const SparseMatrix<T>& a, const T* b, T* x)
+ *  @brief  Solve A * x = b
+ *  @param[in] a      Symmetric positive definite matrix
+ *  @param[in] b      Right hand side, `rows` elements
+ *  @param[in,out] x  Initial guess on input, solution on output
+ *  @return kInvalidArgument if `a` is not square, kInternalError if the
+ *          solver did not converge within the iteration budget
+ */
+template<typename T>
+Status ConjugateGradient<T>::Solve(const SparseMatrix<T>& a,
+                                   const T* b,
+                                   T* x) {
+  if (a.rows() != a.cols()) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Conjugate gradient requires a square matrix");
+  }
+  const size_t n = static_cast<size_t>(a.rows());
+  iter_ = 0;
+  residual_ = T(0.0);
+  // Jacobi preconditioner, null diagonal entries are left unscaled
+  a.Diagonal(&inv_diag_);
+  for (auto& d : inv_diag_) {
+    d = d != T(0.0) ? T(1.0) / d : T(1.0);
+  }
+  // r = b - A * x
+  r_.assign(b, b + n);
+  a.Spmv(T(-1.0), x, T(1.0), r_.data());
+  const T b_norm = std::sqrt(std::inner_product(b, b + n, b, T(0.0)));
+  if (b_norm == T(0.0)) {
+    std::fill(x, x + n, T(0.0));
+    return Status();
+  }
+  z_.resize(n);
+  q_.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    z_[i] = inv_diag_[i] * r_[i];
+  }
+  p_ = z_;
+  T rz = Dot(r_, z_.data());
+  residual_ = std::sqrt(Dot(r_, r_.data())) / b_norm;
+  while (residual_ > tol_ && iter_ < max_iter_) {
+    a.Spmv(T(1.0), p_.data(), T(0.0), q_.data());
+    const T pq = Dot(p_, q_.data());
+    if (pq <= T(0.0)) {
+      return Status(Status::Type::kInternalError,
+                    "Matrix is not positive definite");
+    }
+    const T alpha = rz / pq;
+    for (size_t i = 0; i < n; ++i) {
+      x[i] += alpha * p_[i];
+      r_[i] -= alpha * q_[i];
+      z_[i] = inv_diag_[i] * r_[i];
+    }
+    const T rz_next = Dot(r_, z_.data());
+    const T beta = rz_next / rz;
+    rz = rz_next;
+    for (size_t i = 0; i < n; ++i) {
+      p_[i] = z_[i] + beta * p_[i];
+    }
+    residual_ = std::sqrt(Dot(r_, r_.data())) / b_norm;
+    iter_ += 1;
+  }
+  if (residual_ > tol_) {
+    return Status(Status::Type::kInternalError,
+                  "Conjugate gradient did not converge");
+  }
+  return Status();
+}
+
+#pragma mark -
+#pragma mark Explicit Instantiation
+
+/** Float - SparseMatrix */
+template class SparseMatrix<float>;
+/** Double - SparseMatrix */
+template class SparseMatrix<double>;
+/** Float - ConjugateGradient */
+template class ConjugateGradient<float>;
+/** Double - ConjugateGradient */
+template class ConjugateGradient<double>;
+
+}  // namespace FaceKit
@@ -17,6 +17,7 @@
 #define IS_WINDOW
 #endif
 
+#include <algorithm>
 #include <sstream>
 #include <limits>
 
@@ -202,40 +203,35 @@ StackTrace::StackTrace(void) : StackTrace(0, StackTrace::kDefaultDepth_) {}
  *  @param[in]  skip  Number of level to skip before recording the trace
  *  @param[in]  depth Depth of the trace
  */
-StackTrace::StackTrace(const size_t& skip, const size_t& depth) {
+StackTrace::StackTrace(const size_t& skip,
+                       const size_t& depth) : trace_valid_(false),
+                                              resolved_(false) {
+  // Only the program counters are recorded, symbolization is deferred
 #ifdef IS_POSIX
   // storage array for stack trace address data
-  std::vector<void*> callstack(depth, nullptr);
+  pcs_.resize(depth + skip, nullptr);
   // retrieve current stack addresses
-  int n_call = backtrace(callstack.data(), static_cast<int>(callstack.size()));
-  if (n_call != 0) {
-    size_t sz = n_call > skip ? n_call - skip : 0;
-    frames_.reserve(sz);
-    for (size_t i = skip; i < n_call; ++i) {
-      auto frame = StackTraceFrame();
-      frame.set_address(callstack[i]);
-      frames_.push_back(frame);
-    }
+  const int n_call = backtrace(pcs_.data(), static_cast<int>(pcs_.size()));
+  if (n_call > 0) {
+    const size_t n = static_cast<size_t>(n_call);
+    const size_t first = std::min(skip, n);
+    pcs_.erase(pcs_.begin() + n, pcs_.end());
+    pcs_.erase(pcs_.begin(), pcs_.begin() + first);
     trace_valid_ = true;
+  } else {
+    pcs_.clear();
   }
 #else
   // storage array for stack trace address data
-  std::vector<void*> callstack(depth, nullptr);
+  pcs_.resize(depth, nullptr);
   const ULONG framesToSkip = skip;
   const ULONG framesToCapture = depth;
   const USHORT n_call = CaptureStackBackTrace(framesToSkip,
                                               framesToCapture,
-                                              callstack.data(),
+                                              pcs_.data(),
                                               nullptr);
-  if (n_call != 0) {
-    frames_.reserve(n_call);
-    for (size_t i = 0; i < n_call; ++i) {
-      auto frame = StackTraceFrame();
-      frame.set_address(callstack[i]);
-      frames_.push_back(frame);
-    }
-    trace_valid_ = true;
-  }
+  pcs_.resize(n_call);
+  trace_valid_ = n_call != 0;
 #endif
 }
   
@@ -255,27 +251,64 @@ constexpr size_t StackTrace::kDefaultDepth_;
  *  @return Status of the operations
  */
 Status StackTrace::ToString(std::string* str) const {
-  Status s;
-  if (trace_valid_) {
-    // Resolve trace
-    auto* resolver = get_stacktrace_resolver();
-    s = resolver->Resolve(const_cast<StackTrace*>(this));
-    if (s.Good()) {
-      // Dump to string
-      std::ostringstream stream;
-      stream << "Stack trace:" << std::endl;
-      for (size_t i = 0; i < frames_.size(); ++i) {
-        frames_[i].Print(stream, i, 1);
-      }
-      str->assign(stream.str());
-    } else {
+  if (!resolved_) {
+    // Symbolize a copy, keep this trace untouched (i.e. const / thread-safe)
+    StackTrace trace(*this);
+    Status s = trace.Resolve();
+    if (!s.Good()) {
       str->clear();
+      return s;
     }
-  } else {
-    str->clear();
-    s = Status(Status::Type::kInternalError, "No valid trace was generated");
+    return trace.ToString(str);
   }
+  // Dump to string
+  std::ostringstream stream;
+  stream << "Stack trace:" << std::endl;
+  for (size_t i = 0; i < frames_.size(); ++i) {
+    frames_[i].Print(stream, i, 1);
+  }
+  str->assign(stream.str());
+  return Status();
+}
+
+/*
+ *  @name   Resolve
+ *  @fn     Status Resolve(void)
+ *  @brief  Symbolize the frames in place, does nothing if already done
+ *  @return Status of the operations
+ */
+Status StackTrace::Resolve(void) {
+  if (!trace_valid_) {
+    return Status(Status::Type::kInternalError, "No valid trace was generated");
+  }
+  if (resolved_) {
+    return Status();
+  }
+  auto* resolver = get_stacktrace_resolver();
+  if (resolver == nullptr) {
+    return Status(Status::Type::kUnimplemented, "No stack trace resolver");
+  }
+  Status s = resolver->Resolve(this);
+  resolved_ = s.Good();
   return s;
 }
+
+/*
+ *  @name   At
+ *  @fn     StackTraceFrame& At(const size_t& k)
+ *  @brief  Provide access to the frame at position `k` (read/write), the
+ *          frames are created from the program counters on first access.
+ *  @param[in] k  Position of the frame to access
+ *  @return Frame's instance
+ */
+StackTraceFrame& StackTrace::At(const size_t& k) {
+  if (frames_.size() != pcs_.size()) {
+    frames_.resize(pcs_.size());
+    for (size_t i = 0; i < pcs_.size(); ++i) {
+      frames_[i].set_address(pcs_[i]);
+    }
+  }
+  return frames_.at(k);
+}
   
 }  // namespace FaceKit
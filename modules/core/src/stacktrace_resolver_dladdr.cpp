@@ -14,6 +14,7 @@
 #include <dlfcn.h>    // for dladdr
 #include <cxxabi.h>   // for __cxa_demangle
 #include <cstring>
+#include <utility>
 #define IS_POSIX
 #endif
 
@@ -37,45 +38,56 @@ Status ResolverDlAddr::Resolve(StackTrace* trace) {
 #ifdef IS_POSIX
   if (trace->IsTraceValid()) {
     Status s;
+    std::lock_guard<std::mutex> lock(lock_);
     // Goes through the stacks
     for (size_t k = 0; k < trace->Size(); ++k) {
       // Access element
       auto& frame = trace->At(k);
-      // Query info for this frame
-      Dl_info info;
-      std::memset(&info, 0, sizeof(info));
-      
-      // Ignore the status returned by 'dladdr' -- it returns 0 on failure, and
-      // doesn't set errno, and returns 0 sometimes when it succeeds.
-      dladdr(frame.get_address(), &info);
-      
-      if (!info.dli_fname) {
-        info.dli_fname = "";
-      }
-      if (!info.dli_sname) {
-        info.dli_sname = "";
-      }
-      
-      frame.set_library_name(info.dli_fname);
-      frame.set_mangled_symbol_name(info.dli_sname);
-      size_t offset = (size_t)frame.get_address() - (size_t)info.dli_saddr;
-      frame.set_offset(offset);
-      // Unmangle name, if possible
-      int rc = 0;
-      char* demangled = abi::__cxa_demangle(info.dli_sname,
-                                            nullptr,
-                                            nullptr,
-                                            &rc);
-      Mem::ScopedBuffer buffer(demangled);
-      frame.set_symbol_name(rc == 0 ? demangled : "");
-      
-      if (frame.get_symbol_name().empty()) {
-        // Either demangling was turned off, demangling just failed, or it was
-        // a static symbol.  For some reason, on Darwin, the demangler reduces
-        // static symbols to nothing.  If that happened, just use the mangled
-        // symbol name.
-        frame.set_symbol_name(frame.get_mangled_symbol_name());
+      auto it = cache_.find(frame.get_address());
+      if (it == cache_.end()) {
+        if (cache_.size() >= kMaxCacheSize) {
+          cache_.clear();
+        }
+        // Query info for this frame
+        Dl_info info;
+        std::memset(&info, 0, sizeof(info));
+
+        // Ignore the status returned by 'dladdr' -- it returns 0 on failure,
+        // and doesn't set errno, and returns 0 sometimes when it succeeds.
+        dladdr(frame.get_address(), &info);
+
+        if (!info.dli_fname) {
+          info.dli_fname = "";
+        }
+        if (!info.dli_sname) {
+          info.dli_sname = "";
+        }
+        Symbol sym;
+        sym.library_name = info.dli_fname;
+        sym.mangled_symbol_name = info.dli_sname;
+        sym.offset = (size_t)frame.get_address() - (size_t)info.dli_saddr;
+        // Unmangle name, if possible
+        int rc = 0;
+        char* demangled = abi::__cxa_demangle(info.dli_sname,
+                                              nullptr,
+                                              nullptr,
+                                              &rc);
+        Mem::ScopedBuffer buffer(demangled);
+        sym.symbol_name = rc == 0 ? demangled : "";
+        if (sym.symbol_name.empty()) {
+          // Either demangling was turned off, demangling just failed, or it
+          // was a static symbol.  For some reason, on Darwin, the demangler
+          // reduces static symbols to nothing.  If that happened, just use
+          // the mangled symbol name.
+          sym.symbol_name = sym.mangled_symbol_name;
+        }
+        it = cache_.emplace(frame.get_address(), std::move(sym)).first;
       }
+      const Symbol& sym = it->second;
+      frame.set_library_name(sym.library_name);
+      frame.set_mangled_symbol_name(sym.mangled_symbol_name);
+      frame.set_offset(sym.offset);
+      frame.set_symbol_name(sym.symbol_name);
     }
     return s;
   } else {
@@ -23,15 +23,26 @@ namespace FaceKit {
   
 /*
  *  @name   Status
- *  @fn     Status(const Type& type, const std::string& msg)
+ *  @fn     Status(const Type& type, std::string msg)
  *  @brief  Constructor
  *  @param[in] type Type of error/status
- *  @param[in] msg  Message explaining what went wrong (error description)
+ *  @param[in] msg  Message explaining what went wrong (error description),
+ *                  moved into the error state
  */
 Status::Status(const Type& type,
-               const std::string& msg) : err_(type), msg_(msg) {
+               std::string msg) : state_(new State{type, std::move(msg)}) {
   assert(type != Type::kOk);
 }
+
+/*
+ *  @name   EmptyMessage
+ *  @fn     static const std::string& EmptyMessage(void)
+ *  @brief  Message of successful status
+ */
+const std::string& Status::EmptyMessage(void) {
+  static const std::string msg;
+  return msg;
+}
   
 /*
  *  @name   ToString
@@ -41,10 +52,10 @@ Status::Status(const Type& type,
  */
 std::string Status::ToString(void) const {
   std::string str;
-  if (err_ == Type::kOk) {
+  if (state_ == nullptr) {
     str = "Ok";
   } else {
-    switch (err_) {
+    switch (state_->code) {
         case Type::kUnknown: str = "Unknown: ";
         break;
         case Type::kInvalidArgument: str = "Invalid argument: ";
@@ -59,10 +70,10 @@ std::string Status::ToString(void) const {
         break;
         case Type::kInternalError: str = "Internal error: ";
         break;
-      default:  str="Unknown code (" + std::to_string((int)err_) + "): ";
+      default:  str="Unknown code (" + std::to_string((int)state_->code) + "): ";
         break;
     }
-    str += msg_;
+    str += state_->msg;
   }
   return str;
 }
@@ -7,6 +7,8 @@
  *  Copyright © 2016 Christophe Ecabert. All rights reserved.
  */
 
+#include <cctype>
+
 #include "facekit/core/utils/string.hpp"
 
 /**
@@ -14,6 +16,9 @@
  *  @brief      Development space
  */
 namespace FaceKit {
+
+/** Out-of-class definition required by C++11 when odr-used */
+constexpr size_t StringView::npos;
   
 /**
  *  @namespace  Path
@@ -77,19 +82,31 @@ bool IsAbsolute(const std::string& path) {
  *  @return Complete file's directory or empty string.
  */
 std::string Dirname(const std::string& path) {
-  auto pos = path.rfind("/");
+  return Dirname(StringView(path)).ToString();
+}
+
+/*
+ *  @name   Dirname
+ *  @fn     StringView Dirname(const StringView& path)
+ *  @brief  Same as `Dirname(const std::string&)` without allocation, the
+ *          returned view points into `path`.
+ *  @param[in] path Path to file
+ *  @return Complete file's directory or empty view.
+ */
+StringView Dirname(const StringView& path) {
+  auto pos = path.rfind('/');
 #ifdef WIN32
-  if (pos == std::string::npos) {
-    pos = path.rfind("\\");
+  if (pos == StringView::npos) {
+    pos = path.rfind('\\');
   }
 #endif
-  if (pos == std::string::npos) {
+  if (pos == StringView::npos) {
     // No directory found
-    return "";
+    return StringView();
   }
-  // Check if path starts with '/'
+  // Check if path starts with '/', keep it
   if (pos == 0) {
-    return "/";
+    return path.substr(0, 1);
   }
   // Found something
   return path.substr(0, pos);
@@ -105,21 +122,29 @@ std::string Dirname(const std::string& path) {
  *  @return File name
  */
 std::string Basename(const std::string& path) {
-  auto pos = path.rfind("/");
+  return Basename(StringView(path)).ToString();
+}
+
+/*
+ *  @name   Basename
+ *  @fn     StringView Basename(const StringView& path)
+ *  @brief  Same as `Basename(const std::string&)` without allocation, the
+ *          returned view points into `path`.
+ *  @param[in] path Path to file
+ *  @return File name
+ */
+StringView Basename(const StringView& path) {
+  auto pos = path.rfind('/');
 #ifdef WIN32
-  if (pos == std::string::npos) {
-    pos = path.rfind("\\");
+  if (pos == StringView::npos) {
+    pos = path.rfind('\\');
   }
 #endif
-  if (pos == std::string::npos) {
+  if (pos == StringView::npos) {
     // No '/' found -> return path
     return path;
   }
-  // start with '/'
-  if (pos == 0) {
-    return path.substr(1);
-  }
-  // Else '/' in the middle
+  // '/' somewhere, take what follows
   return path.substr(pos + 1);
 }
   
@@ -132,11 +157,23 @@ std::string Basename(const std::string& path) {
  *  @return File's extension or empty string
  */
 std::string Extension(const std::string& path) {
-  auto pos = path.rfind(".");
-  if (pos != std::string::npos) {
+  return Extension(StringView(path)).ToString();
+}
+
+/*
+ *  @name   Extension
+ *  @fn     StringView Extension(const StringView& path)
+ *  @brief  Same as `Extension(const std::string&)` without allocation, the
+ *          returned view points into `path`.
+ *  @param[in] path Path to file
+ *  @return File's extension or empty view
+ */
+StringView Extension(const StringView& path) {
+  auto pos = path.rfind('.');
+  if (pos != StringView::npos) {
     return path.substr(pos + 1);
   } else {
-    return std::string();
+    return StringView();
   }
 }
   
@@ -239,18 +276,191 @@ std::string Clean(const std::string& path) {
  */
 void SplitComponent(const std::string& path, std::string* dir,
                     std::string* file, std::string* ext) {
+  StringView d, f, e;
+  SplitComponent(StringView(path),
+                 dir ? &d : nullptr,
+                 file ? &f : nullptr,
+                 ext ? &e : nullptr);
+  if (dir != nullptr) {
+    dir->assign(d.data(), d.size());
+  }
+  if (file != nullptr) {
+    file->assign(f.data(), f.size());
+  }
+  if (ext != nullptr) {
+    ext->assign(e.data(), e.size());
+  }
+}
+
+/*
+ *  @name SplitComponent
+ *  @fn void SplitComponent(const StringView& path, StringView* dir,
+                            StringView* file, StringView* ext)
+ *  @brief  Split path into directory + file + extension without allocation.
+ *          Outputs are views into `path` which must outlive them.
+ *  @param[in]  path  Path where to extract data
+ *  @param[out] dir   Extracted directory, skipped if nullptr
+ *  @param[out] file  Extracted filename, skipped if nullptr
+ *  @param[out] ext   Extracted extension, skipped if nullptr
+ */
+void SplitComponent(const StringView& path, StringView* dir,
+                    StringView* file, StringView* ext) {
   if (dir != nullptr) {
     *dir = Dirname(path);
   }
   if (file != nullptr) {
-    std::string filename = Basename(path);
-    auto pos = filename.rfind(".");
-    *file = pos != std::string::npos ? filename.substr(0, pos) : filename;
+    StringView filename = Basename(path);
+    auto pos = filename.rfind('.');
+    *file = pos != StringView::npos ? filename.substr(0, pos) : filename;
   }
   if (ext != nullptr) {
     *ext = Extension(path);
   }
 }
+
+/*
+ *  @name ParseURI
+ *  @fn void ParseURI(const std::string& uri, std::string* scheme,
+                      std::string* host, std::string* path)
+ *  @brief  Split `uri` of the form `scheme://host/path`. When there is no
+ *          scheme, `scheme` and `host` are empty and `path` is `uri`.
+ *  @param[in]  uri     URI to split
+ *  @param[out] scheme  Extracted scheme, skipped if nullptr
+ *  @param[out] host    Extracted host (i.e. bucket), skipped if nullptr
+ *  @param[out] path    Extracted path, starts with '/', skipped if nullptr
+ */
+void ParseURI(const std::string& uri, std::string* scheme,
+              std::string* host, std::string* path) {
+  std::string s, h, p;
+  auto pos = uri.find("://");
+  // Scheme must be [a-zA-Z][a-zA-Z0-9.+-]*
+  bool valid = pos != std::string::npos && pos > 0 && std::isalpha(uri[0]);
+  for (size_t k = 1; valid && k < pos; ++k) {
+    const char c = uri[k];
+    valid = std::isalnum(c) || c == '.' || c == '+' || c == '-';
+  }
+  if (!valid) {
+    p = uri;
+  } else {
+    s = uri.substr(0, pos);
+    auto start = pos + 3;
+    auto slash = uri.find('/', start);
+    if (slash == std::string::npos) {
+      h = uri.substr(start);
+    } else {
+      h = uri.substr(start, slash - start);
+      p = uri.substr(slash);
+    }
+  }
+  if (scheme != nullptr) {
+    *scheme = s;
+  }
+  if (host != nullptr) {
+    *host = h;
+  }
+  if (path != nullptr) {
+    *path = p;
+  }
+}
+
+/**
+ *  @name MatchSet
+ *  @fn static bool MatchSet(const StringView& pattern, size_t* pos,
+                             const char c, bool* match)
+ *  @brief  Match a character against the set starting at `pattern[*pos]`
+ *          (i.e. `[a-z]`)
+ *  @param[in]  pattern Glob pattern
+ *  @param[in,out] pos  Position of '[', moved after ']'
+ *  @param[in]  c       Character to test
+ *  @param[out] match   True if `c` belongs to the set
+ *  @return False if the set is not closed, '[' is then a regular character
+ */
+static bool MatchSet(const StringView& pattern,
+                     size_t* pos,
+                     const char c,
+                     bool* match) {
+  size_t k = *pos + 1;
+  bool negate = false;
+  if (k < pattern.size() && (pattern[k] == '!' || pattern[k] == '^')) {
+    negate = true;
+    k += 1;
+  }
+  bool found = false;
+  // ']' right after the opening is a member of the set
+  bool first = true;
+  while (k < pattern.size() && (first || pattern[k] != ']')) {
+    first = false;
+    if (k + 2 < pattern.size() && pattern[k + 1] == '-' &&
+        pattern[k + 2] != ']') {
+      found |= pattern[k] <= c && c <= pattern[k + 2];
+      k += 3;
+    } else {
+      found |= pattern[k] == c;
+      k += 1;
+    }
+  }
+  if (k >= pattern.size()) {
+    return false;
+  }
+  *pos = k + 1;
+  *match = found != negate;
+  return true;
+}
+
+/*
+ *  @name Match
+ *  @fn bool Match(const StringView& pattern, const StringView& name)
+ *  @brief  Check if `name` matches a glob `pattern`: `*` matches any
+ *          sequence, `?` any character, `[abc]`, `[a-z]` and `[!a-z]` a
+ *          set of characters. Similar to python `fnmatch.fnmatchcase`.
+ *  @param[in]  pattern Glob pattern (i.e. `img_*.jp*g`)
+ *  @param[in]  name    Name to test, usually a file name
+ *  @return True if `name` matches
+ */
+bool Match(const StringView& pattern, const StringView& name) {
+  // Greedy scan, backtrack to the last '*' on mismatch
+  size_t p = 0;
+  size_t n = 0;
+  size_t star_p = StringView::npos;
+  size_t star_n = 0;
+  while (n < name.size()) {
+    if (p < pattern.size()) {
+      const char pc = pattern[p];
+      if (pc == '*') {
+        star_p = p++;
+        star_n = n;
+        continue;
+      }
+      if (pc == '?') {
+        p += 1;
+        n += 1;
+        continue;
+      }
+      size_t next = p;
+      bool match = false;
+      if (pc == '[' && MatchSet(pattern, &next, name[n], &match)) {
+        if (match) {
+          p = next;
+          n += 1;
+          continue;
+        }
+      } else if (pc == name[n]) {
+        p += 1;
+        n += 1;
+        continue;
+      }
+    }
+    if (star_p == StringView::npos) {
+      return false;
+    }
+    p = star_p + 1;
+    n = ++star_n;
+  }
+  while (p < pattern.size() && pattern[p] == '*') {
+    p += 1;
+  }
+  return p == pattern.size();
+}
 }  // namespace Path
   
   
@@ -284,6 +494,36 @@ void Split(const std::string& string,
     }
   } while(idx != std::string::npos);
 }
+
+/*
+ *  @name Split
+ *  @fn void Split(const StringView& string, const StringView& delimiter,
+                   std::vector<StringView>* parts);
+ *  @brief  Split a given \p string into views for a specific delimiter. The
+ *          parts point into \p string which must outlive them.
+ *  @param[in]  string    String to split
+ *  @param[in]  delimiter Delimiter
+ *  @param[out] parts     Splitted parts
+ */
+void Split(const StringView& string,
+           const StringView& delimiter,
+           std::vector<StringView>* parts) {
+  if (delimiter.empty()) {
+    parts->push_back(string);
+    return;
+  }
+  std::size_t from = 0;
+  std::size_t idx;
+  do {
+    idx = string.find(delimiter, from);
+    if (idx != StringView::npos) {
+      parts->push_back(string.substr(from, idx - from));
+      from = idx + delimiter.length();
+    } else {
+      parts->push_back(string.substr(from));
+    }
+  } while(idx != StringView::npos);
+}
   
   
 }  // namespace String
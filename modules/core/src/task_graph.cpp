@@ -0,0 +1,239 @@
+/**
+ *  @file   task_graph.cpp
+ *  @brief Dependency graph of tasks executed on a thread pool
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   17.12.17
+ *  Copyright © 2017 Christophe Ecabert. All rights reserved.
+ */
+
+#include <chrono>
+#include <exception>
+
+#include "facekit/core/task_graph.hpp"
+#include "facekit/core/task_group.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   TaskGraph
+ *  @fn     TaskGraph(void)
+ *  @brief  Constructor, nodes run on the default pool
+ */
+TaskGraph::TaskGraph(void) : TaskGraph(&ThreadPool::Get()) {
+}
+
+/*
+ *  @name   TaskGraph
+ *  @fn     explicit TaskGraph(ThreadPool* pool)
+ *  @brief  Constructor
+ *  @param[in] pool Pool on which nodes run
+ */
+TaskGraph::TaskGraph(ThreadPool* pool) : pool_(pool) {
+}
+
+/*
+ *  @name   ~TaskGraph
+ *  @fn     ~TaskGraph(void)
+ *  @brief  Destructor
+ */
+TaskGraph::~TaskGraph(void) = default;
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   AddNode
+ *  @fn     NodeId AddNode(const std::string& name, Function&& fn)
+ *  @brief  Add a new node to the graph
+ *  @param[in] name Node's name, used for reporting
+ *  @param[in] fn   Work performed by the node
+ *  @return Node identifier
+ */
+TaskGraph::NodeId TaskGraph::AddNode(const std::string& name, Function&& fn) {
+  std::unique_ptr<Node> node(new Node());
+  node->name = name;
+  node->fn = std::move(fn);
+  node->remaining = 0;
+  node->time = 0.0;
+  nodes_.push_back(std::move(node));
+  return nodes_.size() - 1;
+}
+
+/*
+ *  @name   AddDependency
+ *  @fn     Status AddDependency(const NodeId& before, const NodeId& after)
+ *  @brief  Indicate that `after` can only start once `before` is completed
+ *  @param[in] before Node to be completed first
+ *  @param[in] after  Node depending on `before`
+ *  @return kOk if successful, kInvalidArgument if one of the node does not
+ *          exist or if the edge is a self loop
+ */
+Status TaskGraph::AddDependency(const NodeId& before, const NodeId& after) {
+  if (before >= nodes_.size() || after >= nodes_.size()) {
+    return Status(Status::Type::kInvalidArgument, "Unknown node");
+  }
+  if (before == after) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Node " + nodes_[before]->name + " can not depend on itself");
+  }
+  nodes_[before]->successors.push_back(after);
+  nodes_[after]->predecessors.push_back(before);
+  return Status();
+}
+
+/*
+ *  @name   Run
+ *  @fn     Status Run(void)
+ *  @brief  Execute the whole graph and wait for its completion. The calling
+ *          thread runs pending tasks while waiting.
+ *  @return kOk if successful, kInvalidArgument if the graph has a cycle,
+ *          kInternalError if one of the node raised an exception, the
+ *          remaining nodes are skipped in that case.
+ */
+Status TaskGraph::Run(void) {
+  std::vector<NodeId> order;
+  if (!this->Sort(&order)) {
+    return Status(Status::Type::kInvalidArgument, "Graph has a cycle");
+  }
+  // Reset state
+  for (auto& n : nodes_) {
+    n->remaining = n->predecessors.size();
+    n->time = 0.0;
+  }
+  error_.clear();
+  // Release roots, the rest follow as dependencies complete
+  TaskGroup group(pool_);
+  for (NodeId i = 0; i < nodes_.size(); ++i) {
+    if (nodes_[i]->predecessors.empty()) {
+      this->Release(i, &group);
+    }
+  }
+  group.Wait();
+  if (!error_.empty()) {
+    return Status(Status::Type::kInternalError, error_);
+  }
+  return Status();
+}
+
+/*
+ *  @name   CriticalPath
+ *  @fn     double CriticalPath(std::vector<NodeId>* path) const
+ *  @brief  Compute the longest chain of dependent nodes of the last run,
+ *          weighted by the measured execution time.
+ *  @param[out] path  Nodes along the critical path, in execution order
+ *  @return Critical path length in ms
+ */
+double TaskGraph::CriticalPath(std::vector<NodeId>* path) const {
+  path->clear();
+  std::vector<NodeId> order;
+  if (nodes_.empty() || !this->Sort(&order)) {
+    return 0.0;
+  }
+  // Longest path ending at each node
+  const NodeId none = nodes_.size();
+  std::vector<double> dist(nodes_.size(), 0.0);
+  std::vector<NodeId> prev(nodes_.size(), none);
+  NodeId last = order.front();
+  for (const auto& v : order) {
+    double best = 0.0;
+    for (const auto& u : nodes_[v]->predecessors) {
+      if (prev[v] == none || dist[u] > best) {
+        best = dist[u];
+        prev[v] = u;
+      }
+    }
+    dist[v] = best + nodes_[v]->time;
+    if (dist[v] > dist[last]) {
+      last = v;
+    }
+  }
+  // Backtrack
+  for (NodeId v = last; v != none; v = prev[v]) {
+    path->insert(path->begin(), v);
+  }
+  return dist[last];
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ *  @name   Release
+ *  @fn     void Release(const NodeId& node, TaskGroup* group)
+ *  @brief  Submit a node whose dependencies are all completed
+ *  @param[in] node   Node to submit
+ *  @param[in] group  Group tracking the run
+ */
+void TaskGraph::Release(const NodeId& node, TaskGroup* group) {
+  group->Run([this, node, group](void) {
+    using Clock = std::chrono::steady_clock;
+    Node* n = nodes_[node].get();
+    const auto start = Clock::now();
+    try {
+      if (n->fn) {
+        n->fn();
+      }
+    } catch (const std::exception& e) {
+      std::lock_guard<std::mutex> lock(lock_);
+      if (error_.empty()) {
+        error_ = "Node " + n->name + " failed: " + e.what();
+      }
+      group->Cancel();
+      return;
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(lock_);
+      if (error_.empty()) {
+        error_ = "Node " + n->name + " failed";
+      }
+      group->Cancel();
+      return;
+    }
+    const std::chrono::duration<double, std::milli> dt = Clock::now() - start;
+    n->time = dt.count();
+    // Release successors whose dependencies are all done. They are added to
+    // the group before this task completes, `Wait` can not return early
+    for (const auto& s : n->successors) {
+      if (nodes_[s]->remaining.fetch_sub(1) == 1) {
+        this->Release(s, group);
+      }
+    }
+  });
+}
+
+/*
+ *  @name   Sort
+ *  @fn     bool Sort(std::vector<NodeId>* order) const
+ *  @brief  Topological sort of the graph
+ *  @param[out] order Nodes in an order compatible with the dependencies
+ *  @return False if the graph has a cycle
+ */
+bool TaskGraph::Sort(std::vector<NodeId>* order) const {
+  // Kahn's algorithm
+  std::vector<std::size_t> deg(nodes_.size());
+  order->clear();
+  for (NodeId i = 0; i < nodes_.size(); ++i) {
+    deg[i] = nodes_[i]->predecessors.size();
+    if (deg[i] == 0) {
+      order->push_back(i);
+    }
+  }
+  for (std::size_t k = 0; k < order->size(); ++k) {
+    for (const auto& s : nodes_[(*order)[k]]->successors) {
+      if (--deg[s] == 0) {
+        order->push_back(s);
+      }
+    }
+  }
+  return order->size() == nodes_.size();
+}
+
+}  // namespace FaceKit
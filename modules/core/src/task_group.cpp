@@ -0,0 +1,136 @@
+/**
+ *  @file   task_group.cpp
+ *  @brief Group of tasks running on a thread pool that can be waited on or
+ *         cancelled as a whole
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   17.12.17
+ *  Copyright © 2017 Christophe Ecabert. All rights reserved.
+ */
+
+#include <chrono>
+
+#include "facekit/core/task_group.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   TaskGroup
+ *  @fn     TaskGroup(void)
+ *  @brief  Constructor, tasks run on the default pool
+ */
+TaskGroup::TaskGroup(void) : TaskGroup(&ThreadPool::Get()) {
+}
+
+/*
+ *  @name   TaskGroup
+ *  @fn     explicit TaskGroup(ThreadPool* pool)
+ *  @brief  Constructor
+ *  @param[in] pool Pool on which tasks run
+ */
+TaskGroup::TaskGroup(ThreadPool* pool) : pool_(pool),
+                                         pending_(0),
+                                         cancelled_(false) {
+}
+
+/*
+ *  @name   ~TaskGroup
+ *  @fn     ~TaskGroup(void)
+ *  @brief  Destructor, wait for running tasks. Pending errors are
+ *          discarded.
+ */
+TaskGroup::~TaskGroup(void) {
+  try {
+    this->Wait();
+  } catch (...) {
+    // Nobody to report to
+  }
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Wait
+ *  @fn     void Wait(void)
+ *  @brief  Wait till every task of the group is completed or skipped,
+ *          running other pending tasks meanwhile. Rethrow the first error
+ *          raised by a task. The group can be reused afterward.
+ */
+void TaskGroup::Wait(void) {
+  while (pending_.load() > 0) {
+    // Help the pool, one of the task may be ours
+    if (pool_->RunPendingTask()) {
+      continue;
+    }
+    // Nothing queued, remaining tasks are running somewhere. Do not sleep
+    // for ever, running tasks may enqueue new work we can help with.
+    std::unique_lock<std::mutex> lock(lock_);
+    cond_.wait_for(lock, std::chrono::milliseconds(1), [this](void) {
+      return pending_.load() == 0;
+    });
+  }
+  // Last task signal completion under the lock, acquire it before releasing
+  // the group
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    error = error_;
+    error_ = nullptr;
+    cancelled_ = false;
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+/*
+ *  @name   Cancel
+ *  @fn     void Cancel(void)
+ *  @brief  Skip tasks that have not started yet. Running tasks can poll
+ *          `is_cancelled` to stop early.
+ */
+void TaskGroup::Cancel(void) {
+  cancelled_ = true;
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ *  @name   SetError
+ *  @fn     void SetError(std::exception_ptr error)
+ *  @brief  Record an error raised by a task and cancel the group
+ *  @param[in] error  Error raised
+ */
+void TaskGroup::SetError(std::exception_ptr error) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!error_) {
+    error_ = error;
+  }
+  cancelled_ = true;
+}
+
+/*
+ *  @name   Done
+ *  @fn     void Done(void)
+ *  @brief  Signal completion of one task
+ */
+void TaskGroup::Done(void) {
+  // Decrement under the lock, the group may be destroyed as soon as the
+  // waiter sees no pending task
+  std::lock_guard<std::mutex> lock(lock_);
+  if (pending_.fetch_sub(1) == 1) {
+    cond_.notify_all();
+  }
+}
+
+}  // namespace FaceKit
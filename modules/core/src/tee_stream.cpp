@@ -10,6 +10,10 @@
  *  Copyright © 2018 Christophe Ecabert. All rights reserved.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
 #include "facekit/core/tee_stream.hpp"
 
 /**
@@ -68,5 +72,254 @@ int TeeStream::TeeStreambuf::sync() {
   
   
 #pragma mark Stream
+
+/*
+ *  @name   TeeStream
+ *  @fn     TeeStream()
+ *  @brief  Constructor
+ */
+TeeStream::TeeStream() : std::ostream(nullptr) {
+  this->rdbuf(&buffer_);
+}
+
+/*
+ *  @name   LinkStream
+ *  @fn     void LinkStream(std::ostream& stream)
+ *  @brief  Link with another stream (Aggregation)
+ *  @param[in] stream Stream to link with where mirrored data will be dumped
+ */
+void TeeStream::LinkStream(std::ostream& stream) {
+  stream.flush();
+  buffer_.InsertBuffer(stream.rdbuf());
+}
+
+#pragma mark -
+#pragma mark Async Streambuf
+
+/** Period at which the background thread drains the ring */
+static constexpr std::chrono::milliseconds kDrainPeriod(10);
+
+constexpr size_t AsyncTeeStream::kDefaultCapacity;
+constexpr size_t AsyncTeeStream::AsyncTeeStreambuf::kPutSize;
+
+/*
+ *  @name   AsyncTeeStreambuf
+ *  @fn     AsyncTeeStreambuf(std::streambuf* primary,
+                              std::streambuf* secondary,
+                              const size_t& capacity,
+                              const DropPolicy& policy)
+ *  @brief  Constructor, start the background thread
+ */
+AsyncTeeStream::AsyncTeeStreambuf::AsyncTeeStreambuf(std::streambuf* primary,
+                                                     std::streambuf* secondary,
+                                                     const size_t& capacity,
+                                                     const DropPolicy& policy) :
+        primary_(primary),
+        secondary_(secondary),
+        mask_(0),
+        policy_(policy),
+        head_(0),
+        tail_(0),
+        synced_(0),
+        n_dropped_(0),
+        running_(true) {
+  size_t size = kPutSize;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  ring_.reset(new char[size]);
+  mask_ = size - 1;
+  this->setp(put_, put_ + kPutSize);
+  worker_ = std::thread(&AsyncTeeStreambuf::Run, this);
+}
+
+/*
+ *  @name   ~AsyncTeeStreambuf
+ *  @fn     ~AsyncTeeStreambuf() override
+ *  @brief  Destructor, drain pending data and stop the background thread
+ */
+AsyncTeeStream::AsyncTeeStreambuf::~AsyncTeeStreambuf() {
+  this->Forward();
+  primary_->pubsync();
+  {
+    std::lock_guard<std::mutex> lock(worker_mutex_);
+    running_ = false;
+  }
+  worker_cv_.notify_one();
+  worker_.join();
+}
+
+/*
+ *  @name   Flush
+ *  @fn     void Flush()
+ *  @brief  See `AsyncTeeStream::Flush`
+ */
+void AsyncTeeStream::AsyncTeeStreambuf::Flush() {
+  this->Forward();
+  primary_->pubsync();
+  const size_t h = head_.load(std::memory_order_relaxed);
+  while (synced_.load(std::memory_order_acquire) < h) {
+    worker_cv_.notify_one();
+    std::this_thread::yield();
+  }
+}
+
+/*
+ *  @name   overflow
+ *  @fn     int_type overflow(int_type c) override
+ *  @brief  C.f. C++ standard section 27.5.2.4.5
+ */
+AsyncTeeStream::AsyncTeeStreambuf::int_type
+AsyncTeeStream::AsyncTeeStreambuf::overflow(int_type c) {
+  if (!this->Forward()) {
+    return traits_type::eof();
+  }
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *this->pptr() = traits_type::to_char_type(c);
+    this->pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+/*
+ *  @name   sync
+ *  @fn     int sync() override
+ *  @brief  Forward buffered data and flush the primary
+ *  @return -1 on failure
+ */
+int AsyncTeeStream::AsyncTeeStreambuf::sync() {
+  const bool ok = this->Forward();
+  return (primary_->pubsync() == 0 && ok) ? 0 : -1;
+}
+
+/*
+ *  @name   Forward
+ *  @fn     bool Forward()
+ *  @brief  Write the put area into the primary and the ring
+ *  @return False if the primary failed
+ */
+bool AsyncTeeStream::AsyncTeeStreambuf::Forward() {
+  const std::streamsize n = this->pptr() - this->pbase();
+  if (n == 0) {
+    return true;
+  }
+  const bool ok = primary_->sputn(this->pbase(), n) == n;
+  this->Push(this->pbase(), static_cast<size_t>(n));
+  this->setp(put_, put_ + kPutSize);
+  return ok;
+}
+
+/*
+ *  @name   Push
+ *  @fn     void Push(const char* data, size_t n)
+ *  @brief  Copy data into the ring, producer side
+ */
+void AsyncTeeStream::AsyncTeeStreambuf::Push(const char* data, size_t n) {
+  const size_t size = mask_ + 1;
+  size_t h = head_.load(std::memory_order_relaxed);
+  while (n > 0) {
+    const size_t room = size - (h - tail_.load(std::memory_order_acquire));
+    if (room == 0) {
+      if (policy_ == DropPolicy::kDrop) {
+        n_dropped_.fetch_add(n, std::memory_order_relaxed);
+        break;
+      }
+      worker_cv_.notify_one();
+      std::this_thread::yield();
+      continue;
+    }
+    // Copy in at most two pieces, the ring can wrap around
+    const size_t m = std::min(n, room);
+    const size_t first = std::min(m, size - (h & mask_));
+    std::memcpy(&ring_[h & mask_], data, first);
+    std::memcpy(&ring_[0], data + first, m - first);
+    h += m;
+    head_.store(h, std::memory_order_release);
+    data += m;
+    n -= m;
+  }
+  // Wake up consumer early when filling up
+  if (h - tail_.load(std::memory_order_relaxed) > size / 2) {
+    worker_cv_.notify_one();
+  }
+}
+
+/*
+ *  @name   Drain
+ *  @fn     void Drain()
+ *  @brief  Write pending data into the secondary and flush it, consumer side
+ */
+void AsyncTeeStream::AsyncTeeStreambuf::Drain() {
+  size_t t = tail_.load(std::memory_order_relaxed);
+  const size_t h = head_.load(std::memory_order_acquire);
+  if (t == h) {
+    return;
+  }
+  while (t < h) {
+    const size_t offset = t & mask_;
+    const size_t m = std::min(h - t, mask_ + 1 - offset);
+    secondary_->sputn(&ring_[offset], static_cast<std::streamsize>(m));
+    t += m;
+    // Release the room right away, the producer may be waiting
+    tail_.store(t, std::memory_order_release);
+  }
+  secondary_->pubsync();
+  synced_.store(h, std::memory_order_release);
+}
+
+/*
+ *  @name   Run
+ *  @fn     void Run()
+ *  @brief  Background thread's loop
+ */
+void AsyncTeeStream::AsyncTeeStreambuf::Run() {
+  std::unique_lock<std::mutex> lock(worker_mutex_);
+  while (running_) {
+    worker_cv_.wait_for(lock, kDrainPeriod);
+    lock.unlock();
+    this->Drain();
+    lock.lock();
+  }
+  lock.unlock();
+  // Producer is done, pick up what was written before stopping
+  this->Drain();
+}
+
+#pragma mark -
+#pragma mark Async Stream
+
+/*
+ *  @name   AsyncTeeStream
+ *  @fn     AsyncTeeStream(std::ostream& primary, std::ostream& secondary,
+                           const size_t& capacity = kDefaultCapacity,
+                           const DropPolicy& policy = DropPolicy::kBlock)
+ *  @brief  Constructor, start the background thread
+ *  @param[in] primary    Stream written synchronously
+ *  @param[in] secondary  Stream written by the background thread, must not
+ *                        be used elsewhere while linked
+ *  @param[in] capacity   Ring size in bytes, rounded up to a power of two
+ *  @param[in] policy     Behaviour when the ring is full
+ */
+AsyncTeeStream::AsyncTeeStream(std::ostream& primary,
+                               std::ostream& secondary,
+                               const size_t& capacity,
+                               const DropPolicy& policy) :
+        std::ostream(nullptr),
+        buffer_((primary.flush(), primary.rdbuf()),
+                (secondary.flush(), secondary.rdbuf()),
+                capacity,
+                policy) {
+  this->rdbuf(&buffer_);
+}
+
+/*
+ *  @name   Flush
+ *  @fn     void Flush()
+ *  @brief  Flush both streams, wait until the secondary has received and
+ *          flushed everything written so far
+ */
+void AsyncTeeStream::Flush() {
+  buffer_.Flush();
+}
   
 }  // namespace FaceKit
@@ -0,0 +1,1009 @@
+/**
+ *  @file   thread_pool.cpp
+ *  @brief Lightweight thread pool implementation using C++11
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   17.12.17
+ *  Copyright © 2017 Christophe Ecabert. All rights reserved.
+ */
+
+#include <exception>
+#include <new>
+#include <chrono>
+#include <map>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/logger.hpp"
+#include "facekit/core/trace.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @struct  ParallelForState
+ *  @brief  Shared state of one `ParallelFor` call. Chunks are claimed
+ *          dynamically by the caller and the helper tasks.
+ *  @author Christophe Ecabert
+ *  @date   17.12.17
+ *  @ingroup core
+ */
+struct ParallelForState {
+  /** Range function */
+  void (*fcn)(void*, const std::size_t&, const std::size_t&);
+  /** Range function context */
+  void* ctx;
+  /** First index */
+  std::size_t begin;
+  /** Past-the-end index */
+  std::size_t end;
+  /** Chunk size */
+  std::size_t chunk;
+  /** Number of chunks */
+  std::size_t n_chunk;
+  /** Next chunk to be processed */
+  std::atomic<std::size_t> next;
+  /** Number of chunks completed */
+  std::atomic<std::size_t> done;
+  /** Synchronization */
+  std::mutex lock;
+  /** Completion signal */
+  std::condition_variable cond;
+  /** First error raised by one of the chunk */
+  std::exception_ptr error;
+
+  /**
+   *  @name   Process
+   *  @fn     void Process(void)
+   *  @brief  Claim and process chunks till none are left
+   */
+  void Process(void) {
+    while (true) {
+      const std::size_t c = next.fetch_add(1);
+      if (c >= n_chunk) {
+        break;
+      }
+      const std::size_t first = begin + c * chunk;
+      const std::size_t last = std::min(end, first + chunk);
+      try {
+        fcn(ctx, first, last);
+      } catch (...) {
+        std::lock_guard<std::mutex> l(lock);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+      if (done.fetch_add(1) + 1 == n_chunk) {
+        std::lock_guard<std::mutex> l(lock);
+        cond.notify_all();
+      }
+    }
+  }
+};
+
+/** Pool the calling thread belongs to, if any */
+static thread_local ThreadPool* current_pool = nullptr;
+/** Index of the calling thread within `current_pool` */
+static thread_local int current_index = -1;
+
+/** Block sizes cached for future's shared states */
+static constexpr std::size_t kStateClass[] = {64, 128, 256, 512};
+/** Number of block size */
+static constexpr std::size_t kNStateClass = 4;
+/** Maximum number of blocks kept per size */
+static constexpr std::size_t kMaxCachedState = 1024;
+
+/**
+ *  @struct  StateCache
+ *  @brief  Free list of memory blocks of a given size
+ *  @author Christophe Ecabert
+ *  @date   17.12.17
+ *  @ingroup core
+ */
+struct StateCache {
+  /** Free blocks */
+  std::vector<void*> blocks;
+  /** Synchronization */
+  std::mutex lock;
+
+  /**
+   *  @name   ~StateCache
+   *  @fn     ~StateCache(void)
+   *  @brief  Destructor
+   */
+  ~StateCache(void) {
+    for (auto* b : blocks) {
+      ::operator delete(b);
+    }
+  }
+};
+
+/**
+ *  @name   GetStateCache
+ *  @fn     static StateCache* GetStateCache(const std::size_t& size,
+                                             std::size_t* block)
+ *  @brief  Select the cache serving blocks of a given size
+ *  @param[in] size   Number of bytes needed
+ *  @param[out] block Size of the blocks served by the cache
+ *  @return Cache or nullptr if size is too large to be cached
+ */
+static StateCache* GetStateCache(const std::size_t& size, std::size_t* block) {
+  static StateCache caches[kNStateClass];
+  for (std::size_t i = 0; i < kNStateClass; ++i) {
+    if (size <= kStateClass[i]) {
+      *block = kStateClass[i];
+      return &caches[i];
+    }
+  }
+  return nullptr;
+}
+
+/**
+ *  @name   ParseCpuList
+ *  @fn     static std::vector<int> ParseCpuList(const std::string& list)
+ *  @brief  Parse a kernel CPU list such as `0-3,8,10-11`
+ *  @param[in] list CPU list
+ *  @return CPU indices
+ */
+static std::vector<int> ParseCpuList(const std::string& list) {
+  std::vector<int> cpus;
+  std::stringstream stream(list);
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    if (range.empty()) {
+      continue;
+    }
+    const auto pos = range.find('-');
+    const int first = std::atoi(range.substr(0, pos).c_str());
+    const int last = pos == std::string::npos ?
+                     first :
+                     std::atoi(range.substr(pos + 1).c_str());
+    for (int c = first; c <= last; ++c) {
+      cpus.push_back(c);
+    }
+  }
+  return cpus;
+}
+
+/**
+ *  @name   NumaNodeCpus
+ *  @fn     static std::vector<int> NumaNodeCpus(const int& node)
+ *  @brief  Query the CPUs belonging to a given NUMA node
+ *  @param[in] node NUMA node index
+ *  @return CPU indices, empty if the node can not be queried
+ */
+static std::vector<int> NumaNodeCpus(const int& node) {
+  std::ifstream stream("/sys/devices/system/node/node" +
+                       std::to_string(node) +
+                       "/cpulist");
+  std::string list;
+  if (!stream.is_open() || !std::getline(stream, list)) {
+    FACEKIT_LOG_WARNING("Can not query CPUs of NUMA node " << node);
+    return std::vector<int>();
+  }
+  return ParseCpuList(list);
+}
+
+/**
+ *  @name   SelectCpus
+ *  @fn     static std::vector<int> SelectCpus(const ThreadPool::Options& opt)
+ *  @brief  Compute the CPU set workers are allowed to run on
+ *  @param[in] opt  Pool configuration
+ *  @return CPU indices, empty if not restricted
+ */
+static std::vector<int> SelectCpus(const ThreadPool::Options& opt) {
+  if (opt.numa_node < 0) {
+    return opt.cpus;
+  }
+  std::vector<int> cpus = NumaNodeCpus(opt.numa_node);
+  if (!opt.cpus.empty()) {
+    // Restrict node's CPUs
+    std::vector<int> sel;
+    for (const auto& c : cpus) {
+      if (std::find(opt.cpus.begin(), opt.cpus.end(), c) != opt.cpus.end()) {
+        sel.push_back(c);
+      }
+    }
+    if (sel.empty()) {
+      FACEKIT_LOG_WARNING("No requested CPU on NUMA node " << opt.numa_node <<
+                          ", use the whole node");
+    } else {
+      cpus.swap(sel);
+    }
+  }
+  return cpus;
+}
+
+/**
+ *  @name   SelectSize
+ *  @fn     static std::size_t SelectSize(const std::size_t& size,
+                                          const std::vector<int>& cpus)
+ *  @brief  Compute the number of workers
+ *  @param[in] size User defined size, 0 for automatic selection
+ *  @param[in] cpus CPU set workers are restricted to
+ *  @return Number of workers
+ */
+static std::size_t SelectSize(const std::size_t& size,
+                              const std::vector<int>& cpus) {
+  if (size > 0) {
+    return size;
+  }
+  const char* env = std::getenv("FACEKIT_NUM_THREADS");
+  if (env) {
+    const int n = std::atoi(env);
+    if (n > 0) {
+      return static_cast<std::size_t>(n);
+    }
+    FACEKIT_LOG_WARNING("Invalid FACEKIT_NUM_THREADS value: " << env);
+  }
+  if (!cpus.empty()) {
+    return cpus.size();
+  }
+  const unsigned int n = std::thread::hardware_concurrency();
+  return n > 0 ? n : 1;
+}
+
+/**
+ *  @name   ConfigureCurrentThread
+ *  @fn     static void ConfigureCurrentThread(const std::string& name,
+                                               const std::vector<int>& cpus)
+ *  @brief  Set name and affinity of the calling thread
+ *  @param[in] name Thread's name
+ *  @param[in] cpus CPUs the thread is allowed to run on, empty if not
+ *                  restricted
+ */
+static void ConfigureCurrentThread(const std::string& name,
+                                   const std::vector<int>& cpus) {
+#if defined(__linux__)
+  // Name limited to 16 chars including null terminator
+  pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+  if (!cpus.empty()) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const auto& c : cpus) {
+      CPU_SET(c, &set);
+    }
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+      FACEKIT_LOG_WARNING("Can not set affinity of thread " << name);
+    }
+  }
+#elif defined(__APPLE__)
+  pthread_setname_np(name.c_str());
+  if (!cpus.empty()) {
+    FACEKIT_LOG_WARNING("Thread affinity is not supported on this platform");
+  }
+#else
+  if (!cpus.empty()) {
+    FACEKIT_LOG_WARNING("Thread affinity is not supported on this platform");
+  }
+#endif
+}
+
+/**
+ *  @name   Now
+ *  @fn     static std::int64_t Now(void)
+ *  @brief  Monotonic time stamp
+ *  @return Time in ns
+ */
+static std::int64_t Now(void) {
+  using Clock = std::chrono::steady_clock;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    Clock::now().time_since_epoch()).count();
+}
+
+/**
+ *  @name   HistogramBin
+ *  @fn     static std::size_t HistogramBin(const std::int64_t& ns)
+ *  @brief  Select histogram's bin for a given duration
+ *  @param[in] ns Duration in ns
+ *  @return Bin index
+ */
+static std::size_t HistogramBin(const std::int64_t& ns) {
+  std::int64_t us = ns / 1000;
+  std::size_t bin = 0;
+  while (us > 0 && bin < ThreadPoolStatistic::kNBin - 1) {
+    us >>= 1;
+    ++bin;
+  }
+  return bin;
+}
+
+/**
+ *  @name   Bump
+ *  @fn     static void Bump(std::atomic<std::uint64_t>* counter,
+                             const std::uint64_t& value)
+ *  @brief  Increase a statistic counter
+ *  @param[in,out] counter  Counter to increase
+ *  @param[in] value  Increment
+ */
+static void Bump(std::atomic<std::uint64_t>* counter,
+                 const std::uint64_t& value) {
+  counter->fetch_add(value, std::memory_order_relaxed);
+}
+
+/**
+ *  @struct  PoolRegistry
+ *  @brief  Named pools
+ *  @author Christophe Ecabert
+ *  @date   17.12.17
+ *  @ingroup core
+ */
+struct PoolRegistry {
+  /** Pools */
+  std::map<std::string, std::unique_ptr<ThreadPool>> pools;
+  /** Synchronization */
+  std::mutex lock;
+
+  /**
+   *  @name   Get
+   *  @fn     static PoolRegistry& Get(void)
+   *  @brief  Singleton accessor
+   *  @return Registry
+   */
+  static PoolRegistry& Get(void) {
+    static PoolRegistry registry;
+    return registry;
+  }
+};
+
+// Number of priority level
+constexpr std::size_t ThreadPool::kNPriority;
+// Number of histogram's bins
+constexpr std::size_t ThreadPoolStatistic::kNBin;
+
+#pragma mark -
+#pragma mark ThreadPoolStatistic
+
+/*
+ *  @name   ThreadPoolStatistic
+ *  @fn     ThreadPoolStatistic(void)
+ *  @brief  Constructor
+ */
+ThreadPoolStatistic::ThreadPoolStatistic(void) {
+  this->Clear();
+}
+
+/*
+ *  @name   Clear
+ *  @fn     void Clear(void)
+ *  @brief  Reset statistics
+ */
+void ThreadPoolStatistic::Clear(void) {
+  n_enqueued = 0;
+  n_executed = 0;
+  n_stolen = 0;
+  queue_depth = 0;
+  wait_time.fill(0);
+  run_time.fill(0);
+  worker_executed.clear();
+  worker_busy.clear();
+  worker_idle.clear();
+}
+
+/**
+ *  @name   HistogramToString
+ *  @fn     static std::string HistogramToString(
+                                  const ThreadPoolStatistic::Histogram& hist)
+ *  @brief  Format non-empty bins as `<upper bound in us>:<count>`
+ *  @param[in] hist Histogram to format
+ *  @return String formatted histogram
+ */
+static std::string
+HistogramToString(const ThreadPoolStatistic::Histogram& hist) {
+  std::string str;
+  for (std::size_t k = 0; k < hist.size(); ++k) {
+    if (hist[k] == 0) {
+      continue;
+    }
+    str += k + 1 < hist.size() ? "<" + std::to_string(1ul << k) : ">inf";
+    str += ":" + std::to_string(hist[k]) + " ";
+  }
+  return str;
+}
+
+/*
+ *  @name   ToString
+ *  @fn     std::string ToString(void) const
+ *  @brief  Convert statistics to a readable string
+ *  @return String formatted statistics
+ */
+std::string ThreadPoolStatistic::ToString(void) const {
+  std::string str;
+  str += "Enqueued:      "  + std::to_string(n_enqueued) + "\n";
+  str += "Executed:      "  + std::to_string(n_executed) + "\n";
+  str += "Stolen:        "  + std::to_string(n_stolen) + "\n";
+  str += "Queue depth:   "  + std::to_string(queue_depth) + "\n";
+  str += "Wait [us]:     "  + HistogramToString(wait_time) + "\n";
+  str += "Run [us]:      "  + HistogramToString(run_time) + "\n";
+  for (std::size_t i = 0; i < worker_executed.size(); ++i) {
+    const double total = worker_busy[i] + worker_idle[i];
+    const double util = total > 0.0 ? 100.0 * worker_busy[i] / total : 0.0;
+    str += "Worker " + std::to_string(i) + ":      ";
+    str += std::to_string(worker_executed[i]) + " tasks, ";
+    str += std::to_string(worker_busy[i]) + "ms busy, ";
+    str += std::to_string(worker_idle[i]) + "ms idle, ";
+    str += std::to_string(util) + "% used\n";
+  }
+  return str;
+}
+
+#pragma mark -
+#pragma mark Counters
+
+/*
+ *  @name   Counters
+ *  @fn     Counters(void)
+ *  @brief  Constructor
+ */
+ThreadPool::Counters::Counters(void) {
+  this->Clear();
+}
+
+/*
+ *  @name   Clear
+ *  @fn     void Clear(void)
+ *  @brief  Reset counters
+ */
+void ThreadPool::Counters::Clear(void) {
+  n_enqueued = 0;
+  n_executed = 0;
+  n_stolen = 0;
+  busy = 0;
+  idle = 0;
+  for (std::size_t k = 0; k < ThreadPoolStatistic::kNBin; ++k) {
+    wait_time[k] = 0;
+    run_time[k] = 0;
+  }
+}
+// Inline task storage
+constexpr std::size_t InlineTask::kInlineSize;
+
+#pragma mark -
+#pragma mark TaskQueue
+
+/*
+ *  @name   TaskQueue
+ *  @fn     TaskQueue(void)
+ *  @brief  Constructor
+ */
+ThreadPool::TaskQueue::TaskQueue(void) : jobs_(64), head_(0), size_(0) {
+}
+
+/*
+ *  @name   PushBack
+ *  @fn     void PushBack(Job&& job)
+ *  @brief  Add a job at the back of the queue
+ *  @param[in] job  Job to add
+ */
+void ThreadPool::TaskQueue::PushBack(Job&& job) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (size_ == jobs_.size()) {
+    // Full, double capacity and unwrap jobs
+    std::vector<Job> jobs(2 * jobs_.size());
+    const std::size_t mask = jobs_.size() - 1;
+    for (std::size_t i = 0; i < size_; ++i) {
+      jobs[i] = std::move(jobs_[(head_ + i) & mask]);
+    }
+    jobs_.swap(jobs);
+    head_ = 0;
+  }
+  jobs_[(head_ + size_) & (jobs_.size() - 1)] = std::move(job);
+  ++size_;
+}
+
+/*
+ *  @name   PopBack
+ *  @fn     bool PopBack(Job* job)
+ *  @brief  Take the most recently added job (owner side)
+ *  @param[out] job Job taken
+ *  @return True if a job has been taken, false if queue is empty
+ */
+bool ThreadPool::TaskQueue::PopBack(Job* job) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (size_ == 0) {
+    return false;
+  }
+  --size_;
+  *job = std::move(jobs_[(head_ + size_) & (jobs_.size() - 1)]);
+  return true;
+}
+
+/*
+ *  @name   PopFront
+ *  @fn     bool PopFront(Job* job)
+ *  @brief  Take the oldest job (thief / injection side)
+ *  @param[out] job Job taken
+ *  @return True if a job has been taken, false if queue is empty
+ */
+bool ThreadPool::TaskQueue::PopFront(Job* job) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (size_ == 0) {
+    return false;
+  }
+  *job = std::move(jobs_[head_]);
+  head_ = (head_ + 1) & (jobs_.size() - 1);
+  --size_;
+  return true;
+}
+
+/*
+ *  @name   AllocateState
+ *  @fn     static void* AllocateState(const std::size_t& size)
+ *  @brief  Get a block of at least `size` bytes from the block cache
+ *  @param[in] size Number of bytes needed
+ *  @return Memory block
+ */
+void* ThreadPool::AllocateState(const std::size_t& size) {
+  std::size_t block = size;
+  StateCache* cache = GetStateCache(size, &block);
+  if (cache) {
+    std::lock_guard<std::mutex> lock(cache->lock);
+    if (!cache->blocks.empty()) {
+      void* ptr = cache->blocks.back();
+      cache->blocks.pop_back();
+      return ptr;
+    }
+  }
+  return ::operator new(block);
+}
+
+/*
+ *  @name   ReleaseState
+ *  @fn     static void ReleaseState(void* ptr, const std::size_t& size)
+ *  @brief  Give back a block obtained with `AllocateState`
+ *  @param[in] ptr  Memory block
+ *  @param[in] size Number of bytes requested at allocation time
+ */
+void ThreadPool::ReleaseState(void* ptr, const std::size_t& size) {
+  std::size_t block = size;
+  StateCache* cache = GetStateCache(size, &block);
+  if (cache) {
+    std::lock_guard<std::mutex> lock(cache->lock);
+    if (cache->blocks.size() < kMaxCachedState) {
+      cache->blocks.push_back(ptr);
+      return;
+    }
+  }
+  ::operator delete(ptr);
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   Get
+ *  @fn     static ThreadPool& Get(const std::size_t& size = 0)
+ *  @brief  Default pool accessor. Created on first call, `size` is ignored
+ *          afterward.
+ *  @param[in] size Number of workers, 0 for automatic selection
+ *  @return Default pool
+ */
+ThreadPool& ThreadPool::Get(const std::size_t& size) {
+  // Fast path, avoid registry lookup
+  static ThreadPool& pool = ThreadPool::Get(Options(size));
+  return pool;
+}
+
+/*
+ *  @name   Get
+ *  @fn     static ThreadPool& Get(const Options& options)
+ *  @brief  Registry accessor. Return the pool named `options.name`, create
+ *          it with `options` if it does not exist yet.
+ *  @param[in] options  Pool configuration
+ *  @return Pool with the given name
+ */
+ThreadPool& ThreadPool::Get(const Options& options) {
+  auto& reg = PoolRegistry::Get();
+  std::lock_guard<std::mutex> lock(reg.lock);
+  auto it = reg.pools.find(options.name);
+  if (it == reg.pools.end()) {
+    std::unique_ptr<ThreadPool> pool(new ThreadPool(options));
+    it = reg.pools.emplace(options.name, std::move(pool)).first;
+  }
+  return *(it->second);
+}
+
+/*
+ *  @name   Find
+ *  @fn     static ThreadPool* Find(const std::string& name)
+ *  @brief  Look for a registered pool
+ *  @param[in] name Pool's name
+ *  @return Pool or nullptr if no pool has been registered under `name`
+ */
+ThreadPool* ThreadPool::Find(const std::string& name) {
+  auto& reg = PoolRegistry::Get();
+  std::lock_guard<std::mutex> lock(reg.lock);
+  auto it = reg.pools.find(name);
+  return it != reg.pools.end() ? it->second.get() : nullptr;
+}
+
+/*
+ *  @name   ThreadPool
+ *  @fn     explicit ThreadPool(const std::size_t& size)
+ *  @brief  Constructor
+ *  @param[in]  size  Pool size, 0 for automatic selection
+ */
+ThreadPool::ThreadPool(const std::size_t& size) : ThreadPool(Options(size)) {
+}
+
+/*
+ *  @name   ThreadPool
+ *  @fn     explicit ThreadPool(const Options& options)
+ *  @brief  Constructor
+ *  @param[in]  options  Pool configuration
+ */
+ThreadPool::ThreadPool(const Options& options) : name_(options.name),
+                                                 n_pending_(0),
+                                                 n_sleeping_(0),
+                                                 stop_(false),
+                                                 timing_(false) {
+  const std::vector<int> cpus = SelectCpus(options);
+  const std::size_t size = SelectSize(options.size, cpus);
+  // Create workers state first, threads may steal from any of them as soon as
+  // they start
+  for (std::size_t i = 0; i < size; ++i) {
+    workers_.emplace_back(new Worker());
+    Worker* w = workers_.back().get();
+    w->seed = static_cast<unsigned int>(i * 2654435761u + 1u);
+    if (!cpus.empty()) {
+      if (options.pin_workers) {
+        w->cpus.push_back(cpus[i % cpus.size()]);
+      } else {
+        w->cpus = cpus;
+      }
+    }
+  }
+  // Start workers
+  for (std::size_t i = 0; i < size; ++i) {
+    const int idx = static_cast<int>(i);
+    workers_[i]->thread = std::thread([this, idx](void) {
+      ConfigureCurrentThread(this->name_ + "-" + std::to_string(idx),
+                             this->workers_[idx]->cpus);
+      this->Run(idx);
+    });
+  }
+}
+
+/*
+ *  @name   ~ThreadPool
+ *  @fn     ~ThreadPool(void)
+ *  @brief  Destructor, wait till all pending tasks are completed
+ */
+ThreadPool::~ThreadPool(void) {
+  // Stop queue
+  {
+    std::unique_lock<std::mutex> lock(this->cond_lock_);
+    this->stop_ = true;
+  }
+  // Signal all waiting thread to run
+  this->cond_.notify_all();
+  // Wait till all threads are done
+  for (auto& w : this->workers_) {
+    w->thread.join();
+  }
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   ChunkSize
+ *  @fn     std::size_t ChunkSize(const std::size_t& n,
+                                  const std::size_t& grain) const
+ *  @brief  Select the number of elements processed by one chunk
+ *  @param[in] n      Range length
+ *  @param[in] grain  User defined grain, 0 for automatic selection
+ *  @return Chunk size
+ */
+std::size_t ThreadPool::ChunkSize(const std::size_t& n,
+                                  const std::size_t& grain) const {
+  if (grain > 0) {
+    return grain;
+  }
+  // Few chunks per thread (workers + caller) to balance the load
+  const std::size_t n_target = 4 * (workers_.size() + 1);
+  return std::max<std::size_t>(1, (n + n_target - 1) / n_target);
+}
+
+/*
+ *  @name   ParallelForImpl
+ *  @fn     void ParallelForImpl(const std::size_t& begin,
+                                 const std::size_t& end,
+                                 const std::size_t& grain,
+                                 RangeFcn fcn, void* ctx)
+ *  @brief  Type-erased implementation of `ParallelFor`
+ *  @param[in] begin  First index
+ *  @param[in] end    Past-the-end index
+ *  @param[in] grain  Chunk size, if 0 it is selected automatically
+ *  @param[in] fcn    Range function
+ *  @param[in] ctx    Context given to `fcn`
+ */
+void ThreadPool::ParallelForImpl(const std::size_t& begin,
+                                 const std::size_t& end,
+                                 const std::size_t& grain,
+                                 RangeFcn fcn,
+                                 void* ctx) {
+  if (end <= begin) {
+    return;
+  }
+  const std::size_t n = end - begin;
+  const std::size_t chunk = this->ChunkSize(n, grain);
+  const std::size_t n_chunk = (n + chunk - 1) / chunk;
+  if (n_chunk == 1 || workers_.empty()) {
+    // Not worth going through the queues
+    fcn(ctx, begin, end);
+    return;
+  }
+  // Shared state, helpers starting after completion won't find any chunk left
+  // and return without touching `fcn`/`ctx`
+  auto state = std::allocate_shared<ParallelForState>(
+                                          StateAllocator<ParallelForState>());
+  state->fcn = fcn;
+  state->ctx = ctx;
+  state->begin = begin;
+  state->end = end;
+  state->chunk = chunk;
+  state->n_chunk = n_chunk;
+  state->next = 0;
+  state->done = 0;
+  const std::size_t n_helper = std::min(workers_.size(), n_chunk - 1);
+  for (std::size_t i = 0; i < n_helper; ++i) {
+    this->Push(TaskPriority::kNormal, [state](void) {
+      state->Process();
+    });
+  }
+  // Caller takes part in the processing, then wait for chunks still running
+  state->Process();
+  {
+    std::unique_lock<std::mutex> lock(state->lock);
+    state->cond.wait(lock, [&state](void) {
+      return state->done.load() == state->n_chunk;
+    });
+  }
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+}
+
+/*
+ *  @name   RunPendingTask
+ *  @fn     bool RunPendingTask(void)
+ *  @brief  Run one pending task on the calling thread if any. Used to help
+ *          the pool while waiting on something instead of blocking.
+ *  @return True if a task has been run, false if none was pending
+ */
+bool ThreadPool::RunPendingTask(void) {
+  Job job;
+  const int index = this->worker_index();
+  if (!this->Pop(index, &job)) {
+    return false;
+  }
+  this->Execute(index, &job);
+  return true;
+}
+
+#pragma mark -
+#pragma mark Accessors
+
+/*
+ *  @name   worker_index
+ *  @fn     int worker_index(void) const
+ *  @brief  Index of the calling thread within this pool
+ *  @return Worker index or -1 if the caller is not one of this pool's
+ *          workers
+ */
+int ThreadPool::worker_index(void) const {
+  return current_pool == this ? current_index : -1;
+}
+
+#pragma mark -
+#pragma mark Statistics
+
+/*
+ *  @name   GatherStatistics
+ *  @fn     void GatherStatistics(ThreadPoolStatistic* stats) const
+ *  @brief  Aggregate per-thread counters
+ *  @param[out] stats   Object filled with statistics from this pool
+ */
+void ThreadPool::GatherStatistics(ThreadPoolStatistic* stats) const {
+  stats->Clear();
+  stats->queue_depth = n_pending_.load();
+  auto accumulate = [stats](const Counters& c) {
+    stats->n_enqueued += c.n_enqueued.load(std::memory_order_relaxed);
+    stats->n_executed += c.n_executed.load(std::memory_order_relaxed);
+    stats->n_stolen += c.n_stolen.load(std::memory_order_relaxed);
+    for (std::size_t k = 0; k < ThreadPoolStatistic::kNBin; ++k) {
+      stats->wait_time[k] += c.wait_time[k].load(std::memory_order_relaxed);
+      stats->run_time[k] += c.run_time[k].load(std::memory_order_relaxed);
+    }
+  };
+  accumulate(external_);
+  for (const auto& w : workers_) {
+    const Counters& c = w->counters;
+    const auto relaxed = std::memory_order_relaxed;
+    accumulate(c);
+    stats->worker_executed.push_back(c.n_executed.load(relaxed));
+    stats->worker_busy.push_back(c.busy.load(relaxed) * 1e-6);
+    stats->worker_idle.push_back(c.idle.load(relaxed) * 1e-6);
+  }
+}
+
+/*
+ *  @name   ClearStatistics
+ *  @fn     void ClearStatistics(void)
+ *  @brief  Clear pool's statistics
+ */
+void ThreadPool::ClearStatistics(void) {
+  external_.Clear();
+  for (auto& w : workers_) {
+    w->counters.Clear();
+  }
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ *  @name   Push
+ *  @fn     void Push(const TaskPriority& priority, Task&& task)
+ *  @brief  Push a task either on the caller local queue if it belongs to
+ *          this pool or on the global injection queue otherwise.
+ *  @param[in] priority Task's priority
+ *  @param[in] task     Task to schedule
+ */
+void ThreadPool::Push(const TaskPriority& priority, Task&& task) {
+  if (this->stop_) {
+    throw std::runtime_error("Error, try to add task on stopped pool");
+  }
+  // Account for the task before it becomes visible, workers rely on this
+  // counter to decide whether they can go to sleep
+  n_pending_.fetch_add(1);
+  const std::size_t p = static_cast<std::size_t>(priority);
+  const int idx = this->worker_index();
+  Bump(&this->GetCounters(idx).n_enqueued, 1);
+  Job job;
+  job.task = std::move(task);
+  job.stamp = timing_.load(std::memory_order_relaxed) ? Now() : 0;
+  if (idx >= 0) {
+    workers_[idx]->queues[p].PushBack(std::move(job));
+  } else {
+    global_[p].PushBack(std::move(job));
+  }
+  // Wake up someone if needed
+  if (n_sleeping_.load() > 0) {
+    {
+      std::lock_guard<std::mutex> lock(cond_lock_);
+    }
+    cond_.notify_one();
+  }
+}
+
+/*
+ *  @name   Pop
+ *  @fn     bool Pop(const int& index, Job* job)
+ *  @brief  Look for a job to run, priority first, then local queue,
+ *          global queue and finally steal from other workers.
+ *  @param[in] index  Index of the worker looking for job
+ *  @param[out] job   Job found
+ *  @return True if a job has been found, false otherwise
+ */
+bool ThreadPool::Pop(const int& index, Job* job) {
+  const std::size_t n = workers_.size();
+  Worker* self = index >= 0 ? workers_[index].get() : nullptr;
+  for (std::size_t k = kNPriority; k > 0; --k) {
+    const std::size_t p = k - 1;
+    // Own queue
+    if (self && self->queues[p].PopBack(job)) {
+      n_pending_.fetch_sub(1);
+      return true;
+    }
+    // Injection queue
+    if (global_[p].PopFront(job)) {
+      n_pending_.fetch_sub(1);
+      return true;
+    }
+    // Steal from random victim
+    std::size_t start = 0;
+    if (self) {
+      // Xorshift
+      unsigned int& s = self->seed;
+      s ^= s << 13;
+      s ^= s >> 17;
+      s ^= s << 5;
+      start = s % n;
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::size_t v = (start + i) % n;
+      if (static_cast<int>(v) == index) {
+        continue;
+      }
+      if (workers_[v]->queues[p].PopFront(job)) {
+        n_pending_.fetch_sub(1);
+        Bump(&this->GetCounters(index).n_stolen, 1);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/*
+ *  @name   Execute
+ *  @fn     void Execute(const int& index, Job* job)
+ *  @brief  Run a job and release it right away
+ *  @param[in] index  Index of the worker running the job, -1 if external
+ *  @param[in,out] job  Job to run
+ */
+void ThreadPool::Execute(const int& index, Job* job) {
+  Counters& c = this->GetCounters(index);
+  const std::int64_t start = job->stamp != 0 ? Now() : 0;
+  // Futures carry their own error, only fire-and-forget tasks can end up here
+  try {
+    FACEKIT_TRACE_SCOPE("ThreadPool::Task");
+    job->task();
+  } catch (const std::exception& e) {
+    FACEKIT_LOG_ERROR("Unhandled exception in task: " << e.what());
+  } catch (...) {
+    FACEKIT_LOG_ERROR("Unhandled exception in task");
+  }
+  job->task.Reset();
+  Bump(&c.n_executed, 1);
+  if (start != 0) {
+    const std::int64_t run = Now() - start;
+    Bump(&c.wait_time[HistogramBin(start - job->stamp)], 1);
+    Bump(&c.run_time[HistogramBin(run)], 1);
+    Bump(&c.busy, static_cast<std::uint64_t>(run));
+  }
+}
+
+/*
+ *  @name   Run
+ *  @fn     void Run(const int& index)
+ *  @brief  Worker main loop
+ *  @param[in] index  Worker's index
+ */
+void ThreadPool::Run(const int& index) {
+  current_pool = this;
+  current_index = index;
+  Tracer::Get().SetThreadName(name_ + "/" + std::to_string(index));
+  Job job;
+  Counters& counters = this->GetCounters(index);
+  // Loop forever
+  while (true) {
+    if (this->Pop(index, &job)) {
+      this->Execute(index, &job);
+      continue;
+    }
+    // Nothing to do, wait till some tasks are pending or if we stop
+    const std::int64_t start = timing_.load(std::memory_order_relaxed) ?
+                               Now() : 0;
+    std::unique_lock<std::mutex> lock(this->cond_lock_);
+    n_sleeping_.fetch_add(1);
+    this->cond_.wait(lock, [this](void) {
+      return this->stop_ || this->n_pending_.load() > 0;
+    });
+    n_sleeping_.fetch_sub(1);
+    if (start != 0) {
+      Bump(&counters.idle, static_cast<std::uint64_t>(Now() - start));
+    }
+    // Stopping ?
+    if (this->stop_ && this->n_pending_.load() == 0) {
+      break;
+    }
+  }
+  current_pool = nullptr;
+  current_index = -1;
+}
+
+}  // namespace FaceKit
@@ -0,0 +1,299 @@
+/**
+ *  @file   trace.cpp
+ *  @brief  Scoped tracing zones recorded into per-thread buffers and exported
+ *          into Chrome's trace event format (chrome://tracing, Perfetto)
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   06.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include "facekit/core/trace.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Default maximum number of events kept per thread */
+constexpr size_t Tracer::kDefaultBufferCapacity;
+
+/**
+ *  @name   EnabledFromEnv
+ *  @fn     static bool EnabledFromEnv(const char* name)
+ *  @brief  Check a flag environment variable
+ *  @param[in] name   Variable, i.e. `FACEKIT_TRACE`
+ *  @return True if requested
+ */
+static bool EnabledFromEnv(const char* name) {
+  const char* env = std::getenv(name);
+  return env != nullptr && std::atoi(env) > 0;
+}
+
+/** Recording flag */
+std::atomic<bool> Tracer::enabled_(EnabledFromEnv("FACEKIT_TRACE"));
+/** Counter capture flag */
+std::atomic<bool> Tracer::counters_(EnabledFromEnv("FACEKIT_TRACE_COUNTERS"));
+
+/**
+ *  @struct Buffer
+ *  @brief  Events of a single thread. The mutex is only contended while
+ *          exporting or clearing.
+ */
+struct Tracer::Buffer {
+  /** Events */
+  std::vector<Event> events;
+  /** Protect events and name */
+  std::mutex mutex;
+  /** Thread identifier in exported traces */
+  uint32_t tid;
+  /** Thread name, can be empty */
+  std::string name;
+};
+
+/**
+ *  @name   WriteJsonString
+ *  @fn     static void WriteJsonString(std::ostream& stream,
+                                        const std::string& str)
+ *  @brief  Write a quoted JSON string, control characters are dropped
+ *  @param[in] stream Output stream
+ *  @param[in] str    String to write
+ */
+static void WriteJsonString(std::ostream& stream, const std::string& str) {
+  stream << '"';
+  for (const char c : str) {
+    if (c == '"' || c == '\\') {
+      stream << '\\' << c;
+    } else if (static_cast<unsigned char>(c) >= 0x20) {
+      stream << c;
+    }
+  }
+  stream << '"';
+}
+
+/**
+ *  @name   ToMicroseconds
+ *  @fn     static std::string ToMicroseconds(const int64_t& ns)
+ *  @brief  Format a duration in microseconds with nanosecond resolution
+ *  @param[in] ns Duration in ns
+ *  @return Formatted value
+ */
+static std::string ToMicroseconds(const int64_t& ns) {
+  char buff[32];
+  std::snprintf(buff, sizeof(buff), "%.3f", static_cast<double>(ns) * 1e-3);
+  return std::string(buff);
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   Get
+ *  @fn     static Tracer& Get(void)
+ *  @brief  Tracer single instance
+ *  @return Tracer
+ */
+Tracer& Tracer::Get(void) {
+  static Tracer tracer;
+  return tracer;
+}
+
+/*
+ *  @name   Tracer
+ *  @fn     Tracer(void)
+ *  @brief  Constructor
+ */
+Tracer::Tracer(void) : capacity_(kDefaultBufferCapacity),
+                       n_dropped_(0),
+                       next_tid_(1),
+                       origin_(Now()) {
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Record
+ *  @fn     void Record(const char* name, const int64_t& start,
+                        const int64_t& stop)
+ *  @brief  Add a completed zone to the calling thread's buffer
+ *  @param[in] name   Zone name, static storage
+ *  @param[in] start  Start time, ns
+ *  @param[in] stop   Stop time, ns
+ */
+void Tracer::Record(const char* name,
+                    const int64_t& start,
+                    const int64_t& stop) {
+  this->Record(name, start, stop, PerfCounters::Sample());
+}
+
+/*
+ *  @name   Record
+ *  @fn     void Record(const char* name, const int64_t& start,
+                        const int64_t& stop,
+                        const PerfCounters::Sample& counters)
+ *  @brief  Add a completed zone with its hardware counts to the calling
+ *          thread's buffer
+ *  @param[in] name     Zone name, static storage
+ *  @param[in] start    Start time, ns
+ *  @param[in] stop     Stop time, ns
+ *  @param[in] counters Counts within the zone
+ */
+void Tracer::Record(const char* name,
+                    const int64_t& start,
+                    const int64_t& stop,
+                    const PerfCounters::Sample& counters) {
+  Buffer& buffer = this->ThreadBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  if (buffer.events.size() < capacity_.load(std::memory_order_relaxed)) {
+    buffer.events.push_back({name, start, stop - start, counters});
+  } else {
+    n_dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+/*
+ *  @name   SetThreadName
+ *  @fn     void SetThreadName(const std::string& name)
+ *  @brief  Label the calling thread in exported traces
+ *  @param[in] name   Thread's name
+ */
+void Tracer::SetThreadName(const std::string& name) {
+  Buffer& buffer = this->ThreadBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  buffer.name = name;
+}
+
+/*
+ *  @name   Clear
+ *  @fn     void Clear(void)
+ *  @brief  Drop every recorded event
+ */
+void Tracer::Clear(void) {
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  for (auto it = buffers_.begin(); it != buffers_.end();) {
+    // Only referenced here once its thread has exited
+    if (it->use_count() == 1) {
+      it = buffers_.erase(it);
+    } else {
+      std::lock_guard<std::mutex> block((*it)->mutex);
+      (*it)->events.clear();
+      ++it;
+    }
+  }
+  n_dropped_.store(0, std::memory_order_relaxed);
+}
+
+/*
+ *  @name   Size
+ *  @fn     size_t Size(void) const
+ *  @brief  Number of recorded events over all threads
+ *  @return Number of events
+ */
+size_t Tracer::Size(void) const {
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  size_t n = 0;
+  for (const auto& b : buffers_) {
+    std::lock_guard<std::mutex> block(b->mutex);
+    n += b->events.size();
+  }
+  return n;
+}
+
+/*
+ *  @name   ExportChromeTrace
+ *  @fn     Status ExportChromeTrace(std::ostream& stream) const
+ *  @brief  Write recorded events as Chrome trace event JSON, loadable by
+ *          chrome://tracing and ui.perfetto.dev. Hardware counts are
+ *          given as event arguments.
+ *  @param[in] stream Output stream
+ *  @return kInternalError if the stream is in a bad state
+ */
+Status Tracer::ExportChromeTrace(std::ostream& stream) const {
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  stream << "{\"traceEvents\":[";
+  bool first = true;
+  for (const auto& b : buffers_) {
+    std::lock_guard<std::mutex> block(b->mutex);
+    if (!b->name.empty()) {
+      stream << (first ? "\n" : ",\n");
+      stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+      stream << b->tid << ",\"args\":{\"name\":";
+      WriteJsonString(stream, b->name);
+      stream << "}}";
+      first = false;
+    }
+    for (const auto& e : b->events) {
+      stream << (first ? "\n" : ",\n");
+      stream << "{\"name\":";
+      WriteJsonString(stream, e.name);
+      stream << ",\"cat\":\"facekit\",\"ph\":\"X\",\"ts\":";
+      stream << ToMicroseconds(e.start - origin_) << ",\"dur\":";
+      stream << ToMicroseconds(e.duration) << ",\"pid\":1,\"tid\":";
+      stream << b->tid;
+      if (e.counters.valid != 0) {
+        stream << ",\"args\":{";
+        const char* sep = "";
+        for (size_t k = 0; k < PerfCounters::kNCounter; ++k) {
+          const auto c = PerfCounters::Counter(k);
+          if (e.counters.Has(c)) {
+            stream << sep << '"' << PerfCounters::Name(c) << "\":";
+            stream << e.counters.value[k];
+            sep = ",";
+          }
+        }
+        stream << "}";
+      }
+      stream << "}";
+      first = false;
+    }
+  }
+  stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return stream.good() ?
+         Status() :
+         Status(Status::Type::kInternalError, "Error while writing trace");
+}
+
+/*
+ *  @name   ExportChromeTrace
+ *  @fn     Status ExportChromeTrace(const std::string& filename) const
+ *  @brief  Write recorded events as Chrome trace event JSON into a file
+ *  @param[in] filename   Output file
+ *  @return kInvalidArgument if the file can not be opened
+ */
+Status Tracer::ExportChromeTrace(const std::string& filename) const {
+  std::ofstream stream(filename.c_str());
+  if (!stream.is_open()) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Can not open file: " + filename);
+  }
+  return this->ExportChromeTrace(stream);
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ *  @name   ThreadBuffer
+ *  @fn     Buffer& ThreadBuffer(void)
+ *  @brief  Calling thread's buffer, registered on first use
+ *  @return Buffer
+ */
+Tracer::Buffer& Tracer::ThreadBuffer(void) {
+  static thread_local std::shared_ptr<Buffer> buffer;
+  if (!buffer) {
+    buffer = std::make_shared<Buffer>();
+    buffer->tid = next_tid_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    buffers_.push_back(buffer);
+  }
+  return *buffer;
+}
+
+}  // namespace FaceKit
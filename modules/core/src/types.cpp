@@ -54,6 +54,8 @@ std::string DataTypeToString(const DataType& type) {
       return "bool";
     case DataType::kString:
       return "string";
+    case DataType::kHalf:
+      return "half";
     default:
       FACEKIT_LOG_ERROR("unsupported data type");
       return "unsupported";
@@ -105,6 +107,9 @@ bool DataTypeFromString(const std::string& str, DataType* type) {
   } else if (str == "string") {
     *type = DataType::kString;
     return true;
+  } else if (str == "half") {
+    *type = DataType::kHalf;
+    return true;
   }
   return false;
 }
@@ -142,6 +147,8 @@ size_t DataTypeDynamicSize(const DataType& dtype) {
       return sizeof(bool);
     case DataType::kString:
       return sizeof(std::string);
+    case DataType::kHalf:
+      return sizeof(Half);
     default:
       FACEKIT_LOG_ERROR("unsupported data type");
       return std::numeric_limits<size_t>::max();
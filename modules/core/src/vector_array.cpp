@@ -0,0 +1,376 @@
+/**
+ *  @file   vector_array.cpp
+ *  @brief  Batch of 3D vectors stored as structure of arrays
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   24.08.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include "facekit/core/math/vector_array.hpp"
+#include "facekit/core/mem/memory.hpp"
+#include "nd_array_ops_kernels.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+template<typename T>
+constexpr size_t Vector3Array<T>::kAlignment;
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   Vector3Array
+ *  @fn     Vector3Array(void)
+ *  @brief  Constructor
+ */
+template<typename T>
+Vector3Array<T>::Vector3Array(void) : data_(nullptr), size_(0), stride_(0) {}
+
+/*
+ *  @name   Vector3Array
+ *  @fn     explicit Vector3Array(const size_t& n)
+ *  @brief  Constructor, create `n` null vectors
+ *  @param[in] n  Number of vectors
+ */
+template<typename T>
+Vector3Array<T>::Vector3Array(const size_t& n) : Vector3Array() {
+  this->Resize(n);
+}
+
+/*
+ *  @name   Vector3Array
+ *  @fn     explicit Vector3Array(const std::vector<Vector3<T>>& vectors)
+ *  @brief  Constructor, convert from array of structures
+ *  @param[in] vectors  Vectors to copy
+ */
+template<typename T>
+Vector3Array<T>::Vector3Array(const std::vector<Vector3<T>>& vectors) :
+        Vector3Array() {
+  this->FromAoS(vectors);
+}
+
+/*
+ *  @name   Vector3Array
+ *  @fn     Vector3Array(const Vector3Array& other)
+ *  @brief  Copy constructor
+ *  @param[in] other  Object to copy from
+ */
+template<typename T>
+Vector3Array<T>::Vector3Array(const Vector3Array& other) : Vector3Array() {
+  *this = other;
+}
+
+/*
+ *  @name   Vector3Array
+ *  @fn     Vector3Array(Vector3Array&& other)
+ *  @brief  Move constructor
+ *  @param[in] other  Object to move from
+ */
+template<typename T>
+Vector3Array<T>::Vector3Array(Vector3Array&& other) : data_(other.data_),
+                                                      size_(other.size_),
+                                                      stride_(other.stride_) {
+  other.data_ = nullptr;
+  other.size_ = 0;
+  other.stride_ = 0;
+}
+
+/*
+ *  @name   operator=
+ *  @fn     Vector3Array& operator=(const Vector3Array& rhs)
+ *  @brief  Assignment operator
+ *  @param[in] rhs  Object to assign from
+ *  @return Newly assigned object
+ */
+template<typename T>
+Vector3Array<T>& Vector3Array<T>::operator=(const Vector3Array& rhs) {
+  if (this != &rhs) {
+    this->Allocate(rhs.size_);
+    for (size_t k = 0; k < 3; ++k) {
+      std::memcpy(reinterpret_cast<void*>(data_ + k * stride_),
+                  reinterpret_cast<const void*>(rhs.data_ + k * rhs.stride_),
+                  size_ * sizeof(T));
+    }
+  }
+  return *this;
+}
+
+/*
+ *  @name   operator=
+ *  @fn     Vector3Array& operator=(Vector3Array&& rhs)
+ *  @brief  Move-assignment operator
+ *  @param[in] rhs  Object to move-assign from
+ *  @return Newly moved-assign object
+ */
+template<typename T>
+Vector3Array<T>& Vector3Array<T>::operator=(Vector3Array&& rhs) {
+  if (this != &rhs) {
+    std::swap(data_, rhs.data_);
+    std::swap(size_, rhs.size_);
+    std::swap(stride_, rhs.stride_);
+  }
+  return *this;
+}
+
+/*
+ *  @name   ~Vector3Array
+ *  @fn     ~Vector3Array(void)
+ *  @brief  Destructor
+ */
+template<typename T>
+Vector3Array<T>::~Vector3Array(void) {
+  Mem::FreeAligned(reinterpret_cast<void*>(data_));
+}
+
+/*
+ *  @name   Allocate
+ *  @fn     void Allocate(const size_t& n)
+ *  @brief  Allocate room for `n` vectors, previous content is lost
+ *  @param[in] n  Number of vectors
+ */
+template<typename T>
+void Vector3Array<T>::Allocate(const size_t& n) {
+  // Round each stream up to the alignment
+  constexpr size_t kStep = kAlignment / sizeof(T);
+  const size_t stride = ((n + kStep - 1) / kStep) * kStep;
+  if (stride != stride_ || data_ == nullptr) {
+    Mem::FreeAligned(reinterpret_cast<void*>(data_));
+    data_ = nullptr;
+    if (stride > 0) {
+      void* ptr = Mem::MallocAligned(3 * stride * sizeof(T), kAlignment);
+      if (ptr == nullptr) {
+        throw std::bad_alloc();
+      }
+      data_ = reinterpret_cast<T*>(ptr);
+    }
+    stride_ = stride;
+  }
+  size_ = n;
+}
+
+/*
+ *  @name   Resize
+ *  @fn     void Resize(const size_t& n)
+ *  @brief  Change the number of vectors, existing ones are kept and new
+ *          ones are null.
+ *  @param[in] n  Number of vectors
+ */
+template<typename T>
+void Vector3Array<T>::Resize(const size_t& n) {
+  if (n == size_) {
+    return;
+  }
+  Vector3Array<T> other;
+  other.Allocate(n);
+  const size_t n_keep = std::min(n, size_);
+  for (size_t k = 0; k < 3; ++k) {
+    T* dst = other.data_ + k * other.stride_;
+    if (n_keep > 0) {
+      std::memcpy(reinterpret_cast<void*>(dst),
+                  reinterpret_cast<const void*>(data_ + k * stride_),
+                  n_keep * sizeof(T));
+    }
+    std::fill(dst + n_keep, dst + n, T(0));
+  }
+  *this = std::move(other);
+}
+
+#pragma mark -
+#pragma mark Conversion
+
+/*
+ *  @name   FromAoS
+ *  @fn     void FromAoS(const Vector3<T>* vectors, const size_t& n)
+ *  @brief  Initialize from an array of structures
+ *  @param[in] vectors  Vectors to copy
+ *  @param[in] n        Number of vectors
+ */
+template<typename T>
+void Vector3Array<T>::FromAoS(const Vector3<T>* vectors, const size_t& n) {
+  this->Allocate(n);
+  T* px = this->x();
+  T* py = this->y();
+  T* pz = this->z();
+  for (size_t i = 0; i < n; ++i) {
+    px[i] = vectors[i].x_;
+    py[i] = vectors[i].y_;
+    pz[i] = vectors[i].z_;
+  }
+}
+
+/*
+ *  @name   ToAoS
+ *  @fn     void ToAoS(Vector3<T>* vectors) const
+ *  @brief  Export to an array of structures
+ *  @param[out] vectors Buffer of `size()` vectors
+ */
+template<typename T>
+void Vector3Array<T>::ToAoS(Vector3<T>* vectors) const {
+  const T* px = this->x();
+  const T* py = this->y();
+  const T* pz = this->z();
+  for (size_t i = 0; i < size_; ++i) {
+    vectors[i].x_ = px[i];
+    vectors[i].y_ = py[i];
+    vectors[i].z_ = pz[i];
+  }
+}
+
+#pragma mark -
+#pragma mark Batch operations
+
+/*
+ *  @name   Add
+ *  @fn     Status Add(const Vector3Array& rhs)
+ *  @brief  Element-wise addition, this = this + rhs
+ *  @param[in] rhs  Vectors to add
+ *  @return kInvalidArgument if sizes do not match
+ */
+template<typename T>
+Status Vector3Array<T>::Add(const Vector3Array& rhs) {
+  if (rhs.size_ != size_) {
+    return Status(Status::Type::kInvalidArgument, "Sizes do not match");
+  }
+  const auto& k = internal::SelectedOpsKernels<T>();
+  k.add(this->x(), rhs.x(), this->x(), size_);
+  k.add(this->y(), rhs.y(), this->y(), size_);
+  k.add(this->z(), rhs.z(), this->z(), size_);
+  return Status();
+}
+
+/*
+ *  @name   Scale
+ *  @fn     void Scale(const T& s)
+ *  @brief  Multiply every vector by a scalar
+ *  @param[in] s  Scaling factor
+ */
+template<typename T>
+void Vector3Array<T>::Scale(const T& s) {
+  const auto& k = internal::SelectedOpsKernels<T>();
+  k.scale(this->x(), s, T(0), this->x(), size_);
+  k.scale(this->y(), s, T(0), this->y(), size_);
+  k.scale(this->z(), s, T(0), this->z(), size_);
+}
+
+/*
+ *  @name   Dot
+ *  @fn     Status Dot(const Vector3Array& rhs, std::vector<T>* out) const
+ *  @brief  Element-wise dot product
+ *  @param[in] rhs  Second operand
+ *  @param[out] out Dot products, resized if needed
+ *  @return kInvalidArgument if sizes do not match
+ */
+template<typename T>
+Status Vector3Array<T>::Dot(const Vector3Array& rhs,
+                            std::vector<T>* out) const {
+  if (rhs.size_ != size_) {
+    return Status(Status::Type::kInvalidArgument, "Sizes do not match");
+  }
+  out->resize(size_);
+  internal::SelectedSoaKernels<T>().dot(this->x(), this->y(), this->z(),
+                                        rhs.x(), rhs.y(), rhs.z(),
+                                        out->data(), size_);
+  return Status();
+}
+
+/*
+ *  @name   Cross
+ *  @fn     Status Cross(const Vector3Array& rhs, Vector3Array* out) const
+ *  @brief  Element-wise cross product, out = this ^ rhs
+ *  @param[in] rhs  Second operand
+ *  @param[out] out Cross products, can be `this` or `rhs`
+ *  @return kInvalidArgument if sizes do not match
+ */
+template<typename T>
+Status Vector3Array<T>::Cross(const Vector3Array& rhs,
+                              Vector3Array* out) const {
+  if (rhs.size_ != size_) {
+    return Status(Status::Type::kInvalidArgument, "Sizes do not match");
+  }
+  if (out != this && out != &rhs) {
+    out->Allocate(size_);
+  }
+  internal::SelectedSoaKernels<T>().cross(this->x(), this->y(), this->z(),
+                                          rhs.x(), rhs.y(), rhs.z(),
+                                          out->x(), out->y(), out->z(),
+                                          size_);
+  return Status();
+}
+
+/*
+ *  @name   Normalize
+ *  @fn     void Normalize(void)
+ *  @brief  Normalize every vector to unit length, null vectors become NaN
+ *          as with `Vector3::Normalize`.
+ */
+template<typename T>
+void Vector3Array<T>::Normalize(void) {
+  internal::SelectedSoaKernels<T>().normalize(this->x(),
+                                              this->y(),
+                                              this->z(),
+                                              size_);
+}
+
+/*
+ *  @name   Transform
+ *  @fn     void Transform(const Matrix3<T>& m, Vector3Array* out) const
+ *  @brief  Apply a linear transformation, out[i] = m * this[i]
+ *  @param[in] m    Transformation
+ *  @param[out] out Transformed vectors, can be `this`
+ */
+template<typename T>
+void Vector3Array<T>::Transform(const Matrix3<T>& m, Vector3Array* out) const {
+  const T t[3] = {T(0), T(0), T(0)};
+  if (out != this) {
+    out->Allocate(size_);
+  }
+  internal::SelectedSoaKernels<T>().transform(m.data(), &t[0],
+                                              this->x(), this->y(), this->z(),
+                                              out->x(), out->y(), out->z(),
+                                              size_);
+}
+
+/*
+ *  @name   Transform
+ *  @fn     void Transform(const Matrix4<T>& m, Vector3Array* out) const
+ *  @brief  Apply an affine transformation to points, out[i] = R * this[i]
+ *          + t. The last row of `m` is ignored (i.e. no perspective
+ *          division).
+ *  @param[in] m    Transformation
+ *  @param[out] out Transformed points, can be `this`
+ */
+template<typename T>
+void Vector3Array<T>::Transform(const Matrix4<T>& m, Vector3Array* out) const {
+  // Split column-major 4x4 into rotation / translation
+  const T* d = m.data();
+  const T r[9] = {d[0], d[1], d[2], d[4], d[5], d[6], d[8], d[9], d[10]};
+  const T t[3] = {d[12], d[13], d[14]};
+  if (out != this) {
+    out->Allocate(size_);
+  }
+  internal::SelectedSoaKernels<T>().transform(&r[0], &t[0],
+                                              this->x(), this->y(), this->z(),
+                                              out->x(), out->y(), out->z(),
+                                              size_);
+}
+
+#pragma mark -
+#pragma mark Explicit Instantiation
+
+/** Float - Vector3Array */
+template class Vector3Array<float>;
+/** Double - Vector3Array */
+template class Vector3Array<double>;
+
+}  // namespace FaceKit
@@ -20,6 +20,7 @@
 #include <sys/types.h>
 #endif
 
+#include <algorithm>
 #include <locale>
 #include <codecvt>
 
@@ -75,23 +76,64 @@ Status WindowsFileSystem::FileExist(const std::string& filename) {
  */
 Status WindowsFileSystem::ListDir(const std::string& dir,
                                 std::vector<std::string>* files) {
-#ifdef IS_WINDOWS
+  std::vector<DirEntry> entries;
+  Status status = this->ListDirEntries(dir, &entries);
   files->clear();
+  files->reserve(entries.size());
+  for (auto& entry : entries) {
+    files->push_back(std::move(entry.path));
+  }
+  return status;
+}
+
+/*
+ *  @name   ListDirEntries
+ *  @fn     Status ListDirEntries(const std::string& dir,
+                                  std::vector<DirEntry>* entries) override
+ *  @brief  List the content of a given directory `dir` with the type of
+ *          each entry, read with `FindFirstFileEx` large fetches. Types come
+ *          from the listing attributes.
+ *  @param[in] dir  Directory to scan
+ *  @param[out] entries List of entries in `dir`
+ *  @return kGood or Error code
+ */
+Status WindowsFileSystem::ListDirEntries(const std::string& dir,
+                                         std::vector<DirEntry>* entries) {
+#ifdef IS_WINDOWS
+  entries->clear();
   std::string fdir = NormalizePath(dir);
-  std::wstring norm_dir = Utf8ToWString(fdir);
   // Define path
-  std::wstring path = norm_dir;
+  std::wstring path = Utf8ToWString(fdir);
   if (!path.empty() && path.back() != '\\' && path.back() != '/') {
     path += L"\\*";
   } else {
     path += L'*';
   }
-  
+  // Skip short names and ask for large batches
   WIN32_FIND_DATAW find_data;
-  HANDLE find_handle = ::FindFirstFileW(path.c_str(), &find_data);
-  
-  
-  return Status(Status::Type::kUnimplemented, "Not implemeted yet");
+  HANDLE find_handle = ::FindFirstFileExW(path.c_str(),
+                                          FindExInfoBasic,
+                                          &find_data,
+                                          FindExSearchNameMatch,
+                                          nullptr,
+                                          FIND_FIRST_EX_LARGE_FETCH);
+  if (find_handle == INVALID_HANDLE_VALUE) {
+    return Status(Status::Type::kInternalError,
+                  "Can not open directory: " + fdir);
+  }
+  do {
+    const std::wstring name = find_data.cFileName;
+    if (name == L"." || name == L"..") {
+      continue;
+    }
+    DirEntry entry;
+    entry.path = Path::Join(fdir, WStringToUtf8(name));
+    entry.is_dir = (find_data.dwFileAttributes &
+                    FILE_ATTRIBUTE_DIRECTORY) != 0;
+    entries->push_back(std::move(entry));
+  } while (::FindNextFileW(find_handle, &find_data));
+  ::FindClose(find_handle);
+  return Status();
 #else
   return Status(Status::Type::kUnimplemented, "Not supported");
 #endif
@@ -117,6 +159,7 @@ Status WindowsFileSystem::FileProp(const std::string& filename,
   } else {
     // Stats structure
     prop->size = sbuf.st_size;
+    prop->mtime = static_cast<int64_t>(sbuf.st_mtime);
     prop->is_dir = PathIsDirectoryW(wname.c_str());
   }
   return res;
@@ -232,6 +275,217 @@ Status WindowsFileSystem::QueryFileSize(const std::string& filename,
 #endif
 }
  
+#ifdef IS_WINDOWS
+
+/**
+ *  @class  WindowsRandomAccessFile
+ *  @brief  RandomAccessFile backed by `ReadFile` with explicit offsets
+ */
+class WindowsRandomAccessFile : public RandomAccessFile {
+ public:
+  /**
+   *  @name   WindowsRandomAccessFile
+   *  @brief  Constructor, take ownership of `handle`
+   */
+  WindowsRandomAccessFile(const std::string& filename, HANDLE handle) :
+          filename_(filename),
+          handle_(handle) {}
+
+  /**
+   *  @name   ~WindowsRandomAccessFile
+   *  @brief  Destructor
+   */
+  ~WindowsRandomAccessFile(void) override {
+    ::CloseHandle(handle_);
+  }
+
+  /**
+   *  @name   Read
+   *  @brief  Read up to `n` bytes starting at `offset` into `buffer`
+   */
+  Status Read(const size_t& offset,
+              const size_t& n,
+              char* buffer,
+              size_t* n_read) const override {
+    size_t done = 0;
+    while (done < n) {
+      OVERLAPPED overlapped = {0};
+      const uint64_t pos = static_cast<uint64_t>(offset + done);
+      overlapped.Offset = static_cast<DWORD>(pos & 0xFFFFFFFF);
+      overlapped.OffsetHigh = static_cast<DWORD>(pos >> 32);
+      const size_t chunk = std::min<size_t>(n - done, 0x7FFFFFFF);
+      DWORD r = 0;
+      if (!::ReadFile(handle_, buffer + done, static_cast<DWORD>(chunk), &r,
+                      &overlapped)) {
+        if (::GetLastError() == ERROR_HANDLE_EOF) {
+          break;
+        }
+        *n_read = done;
+        return Status(Status::Type::kInternalError,
+                      "Can not read: " + filename_);
+      }
+      if (r == 0) {
+        break;    // End of file
+      }
+      done += r;
+    }
+    *n_read = done;
+    if (done < n) {
+      return Status(Status::Type::kOutOfRange,
+                    "Read less bytes than requested in: " + filename_);
+    }
+    return Status();
+  }
+
+  /**
+   *  @name   Size
+   *  @brief  Query the file size in bytes
+   */
+  Status Size(size_t* size) const override {
+    LARGE_INTEGER fsize;
+    if (!::GetFileSizeEx(handle_, &fsize)) {
+      return Status(Status::Type::kInternalError,
+                    "Can not access: " + filename_);
+    }
+    *size = static_cast<size_t>(fsize.QuadPart);
+    return Status();
+  }
+
+ private:
+  /** File name */
+  std::string filename_;
+  /** File handle */
+  HANDLE handle_;
+};
+
+/**
+ *  @class  WindowsReadOnlyMemoryRegion
+ *  @brief  ReadOnlyMemoryRegion backed by `MapViewOfFile`
+ */
+class WindowsReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
+ public:
+  /**
+   *  @name   WindowsReadOnlyMemoryRegion
+   *  @brief  Constructor, take ownership of the view
+   */
+  WindowsReadOnlyMemoryRegion(const void* address, const size_t& length) :
+          address_(address),
+          length_(length) {}
+
+  /**
+   *  @name   ~WindowsReadOnlyMemoryRegion
+   *  @brief  Destructor
+   */
+  ~WindowsReadOnlyMemoryRegion(void) override {
+    if (address_ != nullptr) {
+      ::UnmapViewOfFile(address_);
+    }
+  }
+
+  /**
+   *  @name   data
+   *  @brief  Start of the mapped region
+   */
+  const void* data(void) const override {
+    return address_;
+  }
+
+  /**
+   *  @name   length
+   *  @brief  Size of the mapped region in bytes
+   */
+  size_t length(void) const override {
+    return length_;
+  }
+
+ private:
+  /** Mapped address */
+  const void* address_;
+  /** Mapped length */
+  size_t length_;
+};
+
+#endif
+
+/*
+ *  @name   NewRandomAccessFile
+ *  @fn     Status NewRandomAccessFile(const std::string& filename,
+                    std::unique_ptr<RandomAccessFile>* file) override
+ *  @brief  Open a file for positional reads (`ReadFile` + `OVERLAPPED`)
+ *  @param[in] filename File to open
+ *  @param[out] file    Opened file
+ *  @return Status of the operation
+ */
+Status WindowsFileSystem::NewRandomAccessFile(const std::string& filename,
+                                      std::unique_ptr<RandomAccessFile>* file) {
+#ifdef IS_WINDOWS
+  auto fname = NormalizePath(filename);
+  std::wstring wname = Utf8ToWString(fname);
+  HANDLE handle = ::CreateFileW(wname.c_str(), GENERIC_READ,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_READONLY,
+                                nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return Status(Status::Type::kNotFound, "Can not open: " + fname);
+  }
+  file->reset(new WindowsRandomAccessFile(fname, handle));
+  return Status();
+#else
+  return Status(Status::Type::kUnimplemented, "Not supported");
+#endif
+}
+
+/*
+ *  @name   NewReadOnlyMemoryRegion
+ *  @fn     Status NewReadOnlyMemoryRegion(const std::string& filename,
+                    std::unique_ptr<ReadOnlyMemoryRegion>* region) override
+ *  @brief  Map the whole content of a file in memory (`MapViewOfFile`)
+ *  @param[in] filename File to map
+ *  @param[out] region  Mapped region
+ *  @return Status of the operation
+ */
+Status WindowsFileSystem::NewReadOnlyMemoryRegion(const std::string& filename,
+                                 std::unique_ptr<ReadOnlyMemoryRegion>* region) {
+#ifdef IS_WINDOWS
+  auto fname = NormalizePath(filename);
+  std::wstring wname = Utf8ToWString(fname);
+  HANDLE handle = ::CreateFileW(wname.c_str(), GENERIC_READ,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_READONLY,
+                                nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return Status(Status::Type::kNotFound, "Can not open: " + fname);
+  }
+  Status status;
+  LARGE_INTEGER fsize;
+  if (!::GetFileSizeEx(handle, &fsize)) {
+    status = Status(Status::Type::kInternalError, "Can not access: " + fname);
+  } else if (fsize.QuadPart == 0) {
+    // Nothing to map
+    region->reset(new WindowsReadOnlyMemoryRegion(nullptr, 0));
+  } else {
+    HANDLE mapping = ::CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0,
+                                          nullptr);
+    const void* address = nullptr;
+    if (mapping != nullptr) {
+      address = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      // View keeps the mapping object alive
+      ::CloseHandle(mapping);
+    }
+    if (address == nullptr) {
+      status = Status(Status::Type::kInternalError, "Can not map: " + fname);
+    } else {
+      const size_t length = static_cast<size_t>(fsize.QuadPart);
+      region->reset(new WindowsReadOnlyMemoryRegion(address, length));
+    }
+  }
+  ::CloseHandle(handle);
+  return status;
+#else
+  return Status(Status::Type::kUnimplemented, "Not supported");
+#endif
+}
+ 
 /*
  *  @name   Utf8ToWString
  *  @fn     static std::wstring Utf8ToWString(const std::string& utf_str)
@@ -9,10 +9,17 @@
  */
 
 #include <vector>
+#include <thread>
+#include <cstdint>
+#include <cstring>
 
 #include "gtest/gtest.h"
 
 #include "facekit/core/mem/allocator.hpp"
+#include "facekit/core/mem/allocator_factory.hpp"
+#include "facekit/core/mem/arena_allocator.hpp"
+#include "facekit/core/mem/huge_page_allocator.hpp"
+#include "facekit/core/nd_array.hpp"
 #include "facekit/core/logger.hpp"
 
 /**
@@ -134,6 +141,250 @@ TEST(Allocator, CpuAllocatorMaxChunk) {
   EXPECT_EQ(ptr, nullptr);
 }
 
+TEST(Allocator, PooledAllocatorReuse) {
+  namespace FK = FaceKit;
+  auto* a = FK::GetAllocator("pooled_cpu_allocator");
+  ASSERT_NE(a, nullptr);
+  EXPECT_EQ(FK::DefaultCpuAllocator(), a);
+  // Released blocks are recycled for requests of the same size class
+  const size_t sizes[] = {1, 64, 65, 1000, 4096, 640 * 480 * 3};
+  for (const auto& sz : sizes) {
+    void* p0 = a->AllocateRaw(sz, 32);
+    ASSERT_NE(p0, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p0) % 64, 0);
+    a->DeallocateRaw(sz, p0);
+    void* p1 = a->AllocateRaw(sz, 32);
+    EXPECT_EQ(p0, p1);
+    a->DeallocateRaw(sz, p1);
+  }
+  // Large alignment
+  void* p = a->AllocateRaw(100, 256);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 256, 0);
+  a->DeallocateRaw(100, p);
+  // Above pooled limit
+  const size_t big = size_t(1) << 27;
+  p = a->AllocateRaw(big, 32);
+  EXPECT_NE(p, nullptr);
+  a->DeallocateRaw(big, p);
+}
+
+TEST(Allocator, PooledAllocatorThreads) {
+  namespace FK = FaceKit;
+  auto* a = FK::GetAllocator("pooled_cpu_allocator");
+  // Blocks allocated on one thread and released on another
+  std::vector<void*> ptrs(1000);
+  std::thread producer([&](void) {
+    for (size_t i = 0; i < ptrs.size(); ++i) {
+      ptrs[i] = a->AllocateRaw(128 + i, 32);
+      std::memset(ptrs[i], 0xAB, 128 + i);
+    }
+  });
+  producer.join();
+  std::vector<std::thread> consumers;
+  for (size_t t = 0; t < 4; ++t) {
+    consumers.emplace_back([&, t](void) {
+      for (size_t i = t; i < ptrs.size(); i += 4) {
+        a->DeallocateRaw(128 + i, ptrs[i]);
+        void* p = a->AllocateRaw(2048, 32);
+        std::memset(p, 0xCD, 2048);
+        a->DeallocateRaw(2048, p);
+      }
+    });
+  }
+  for (auto& c : consumers) {
+    c.join();
+  }
+}
+
+TEST(Allocator, ArenaAllocator) {
+  namespace FK = FaceKit;
+  FK::ArenaAllocator arena(4096);
+  EXPECT_EQ(arena.capacity(), 0);
+  // Bump allocations are contiguous and aligned
+  auto* p0 = reinterpret_cast<uint8_t*>(arena.AllocateRaw(100, 32));
+  auto* p1 = reinterpret_cast<uint8_t*>(arena.AllocateRaw(100, 32));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p0) % 64, 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p1) % 32, 0);
+  EXPECT_EQ(p1 - p0, 128);
+  EXPECT_EQ(arena.capacity(), 4096);
+  // Request larger than a chunk
+  void* p2 = arena.AllocateRaw(10000, 64);
+  EXPECT_NE(p2, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p2) % 64, 0);
+  EXPECT_EQ(arena.capacity(), 4096 + 10064);
+  // Everything back at once, chunks are reused
+  arena.Reset();
+  EXPECT_EQ(arena.AllocateRaw(100, 32), p0);
+  EXPECT_EQ(arena.AllocateRaw(10000, 64), p2);
+  EXPECT_EQ(arena.capacity(), 4096 + 10064);
+  arena.Release();
+  EXPECT_EQ(arena.capacity(), 0);
+}
+
+TEST(Allocator, ScopedArena) {
+  namespace FK = FaceKit;
+  FK::ArenaAllocator arena;
+  void* outer = arena.AllocateRaw(256, 32);
+  void* first = nullptr;
+  for (int k = 0; k < 3; ++k) {
+    // Per iteration scratch, same memory each time
+    FK::ScopedArena scope(&arena);
+    FK::NDArray jac(FK::DataType::kFloat, {64, 6}, &arena);
+    EXPECT_TRUE(jac.IsInitialized());
+    auto* data = jac.AsFlat<float>().data();
+    if (k == 0) {
+      first = data;
+    }
+    EXPECT_EQ(data, first);
+    {
+      FK::ScopedArena nested(&arena);
+      EXPECT_NE(arena.AllocateRaw(512, 32), nullptr);
+    }
+  }
+  // Outer allocation untouched
+  FK::ScopedArena scope(&arena);
+  void* next = arena.AllocateRaw(32, 32);
+  EXPECT_EQ(reinterpret_cast<uint8_t*>(next),
+            reinterpret_cast<uint8_t*>(outer) + 256);
+}
+
+TEST(Allocator, AllocationTags) {
+  namespace FK = FaceKit;
+  auto* a = FK::GetAllocator("default_cpu_allocator");
+  FK::EnableAllocatorStatistics(true);
+  a->ClearStatistics();
+  void* untagged = a->AllocateRaw(64, 32);
+  void* mesh = nullptr;
+  void* image = nullptr;
+  {
+    FK::ScopedAllocationTag tag("mesh");
+    mesh = a->AllocateRaw(1024, 32);
+    {
+      FK::ScopedAllocationTag nested("image");
+      image = a->AllocateRaw(4096, 32);
+    }
+    void* tmp = a->AllocateRaw(512, 32);
+    a->DeallocateRaw(512, tmp);
+  }
+  // Release outside of any scope, still accounted to its tag
+  a->DeallocateRaw(4096, image);
+  FK::AllocatorStatistic stats;
+  a->GatherStatistics(&stats);
+  EXPECT_EQ(stats.n_alloc, 4);
+  EXPECT_EQ(stats.used_bytes, 64 + 1024);
+  EXPECT_EQ(stats.max_used_bytes, 64 + 1024 + 4096 + 512);
+  EXPECT_EQ(stats.max_alloc_size, 4096);
+  ASSERT_EQ(stats.tags.size(), 2);
+  EXPECT_EQ(stats.tags[0].name, "mesh");
+  EXPECT_EQ(stats.tags[0].n_alloc, 2);
+  EXPECT_EQ(stats.tags[0].used_bytes, 1024);
+  EXPECT_EQ(stats.tags[0].max_used_bytes, 1024 + 512);
+  EXPECT_EQ(stats.tags[1].name, "image");
+  EXPECT_EQ(stats.tags[1].n_alloc, 1);
+  EXPECT_EQ(stats.tags[1].used_bytes, 0);
+  EXPECT_EQ(stats.tags[1].max_used_bytes, 4096);
+  a->DeallocateRaw(1024, mesh);
+  a->DeallocateRaw(64, untagged);
+  FK::EnableAllocatorStatistics(false);
+  a->ClearStatistics();
+}
+
+TEST(Allocator, StatisticsThreads) {
+  namespace FK = FaceKit;
+  auto* a = FK::GetAllocator("pooled_cpu_allocator");
+  FK::EnableAllocatorStatistics(true);
+  a->ClearStatistics();
+  // Counters from every thread are merged, blocks released by other threads
+  const size_t n = 500;
+  std::vector<std::vector<void*>> ptrs(4, std::vector<void*>(n));
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < ptrs.size(); ++t) {
+    workers.emplace_back([&, t](void) {
+      FK::ScopedAllocationTag tag("worker");
+      for (size_t i = 0; i < n; ++i) {
+        ptrs[t][i] = a->AllocateRaw(256 * (t + 1), 32);
+      }
+    });
+  }
+  for (auto& w : workers) {
+    w.join();
+  }
+  workers.clear();
+  for (size_t t = 0; t < ptrs.size(); ++t) {
+    workers.emplace_back([&, t](void) {
+      const auto& p = ptrs[(t + 1) % ptrs.size()];
+      for (size_t i = 0; i < n; ++i) {
+        a->DeallocateRaw(256 * (((t + 1) % ptrs.size()) + 1), p[i]);
+      }
+    });
+  }
+  for (auto& w : workers) {
+    w.join();
+  }
+  FK::AllocatorStatistic stats;
+  a->GatherStatistics(&stats);
+  EXPECT_EQ(stats.n_alloc, 4 * n);
+  EXPECT_EQ(stats.used_bytes, 0);
+  EXPECT_EQ(stats.max_used_bytes, n * 256 * (1 + 2 + 3 + 4));
+  EXPECT_EQ(stats.max_alloc_size, 4 * 256);
+  ASSERT_EQ(stats.tags.size(), 1);
+  EXPECT_EQ(stats.tags[0].n_alloc, 4 * n);
+  EXPECT_EQ(stats.tags[0].used_bytes, 0);
+  EXPECT_EQ(stats.tags[0].max_used_bytes, n * 256 * (1 + 2 + 3 + 4));
+  FK::EnableAllocatorStatistics(false);
+  a->ClearStatistics();
+}
+
+TEST(Allocator, HugePageAllocator) {
+  namespace FK = FaceKit;
+  auto* a = FK::GetAllocator("huge_page_allocator");
+  ASSERT_NE(a, nullptr);
+  // Small block, regular path
+  void* small = a->AllocateRaw(256, 32);
+  ASSERT_NE(small, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(small) % 32, 0);
+  std::memset(small, 0xAB, 256);
+  a->DeallocateRaw(256, small);
+  // Large block, huge page aligned
+  const size_t n = 3 * FK::HugePageAllocator::kHugePageSize + 100;
+  void* large = a->AllocateRaw(n, 64);
+  ASSERT_NE(large, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % 64, 0);
+  std::memset(large, 0xCD, n);
+  a->DeallocateRaw(n, large);
+  // Placement on node 0, must always exist
+  FK::HugePageAllocator node(0);
+  double* data = node.Allocate<double>(1 << 18);
+  ASSERT_NE(data, nullptr);
+  data[0] = 1.0;
+  data[(1 << 18) - 1] = 2.0;
+  EXPECT_EQ(data[0] + data[(1 << 18) - 1], 3.0);
+  node.Deallocate(1 << 18, data);
+}
+
+/** Number of allocators built by `CreateCounted` */
+static int n_created = 0;
+
+/** Build a plain CPU allocator and count it */
+static FaceKit::Allocator* CreateCounted(void) {
+  n_created += 1;
+  return FaceKit::GetAllocator("default_cpu_allocator");
+}
+
+TEST(Allocator, LazyRegistration) {
+  namespace FK = FaceKit;
+  EXPECT_EQ(FK::AllocatorFactory::Register("ut_lazy_allocator",
+                                           &CreateCounted), 0);
+  EXPECT_EQ(FK::AllocatorFactory::Register("ut_lazy_allocator",
+                                           &CreateCounted), -1);
+  // Built on first request only
+  EXPECT_EQ(n_created, 0);
+  FK::Allocator* a = FK::GetAllocator("ut_lazy_allocator");
+  EXPECT_EQ(a, FK::GetAllocator("default_cpu_allocator"));
+  EXPECT_EQ(FK::GetAllocator(std::string("ut_lazy_allocator")), a);
+  EXPECT_EQ(n_created, 1);
+  EXPECT_EQ(FK::GetAllocator("ut_unknown_allocator"), nullptr);
+}
 
 int main(int argc, char* argv[]) {
   // Init gtest framework
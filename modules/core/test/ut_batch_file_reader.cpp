@@ -0,0 +1,124 @@
+/**
+ *  @file   ut_batch_file_reader.cpp
+ *  @brief Unit test for batched asynchronous file reads
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   11.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/sys/batch_file_reader.hpp"
+#include "facekit/core/logger.hpp"
+
+namespace FK = FaceKit;
+
+class BatchFileReaderTest :
+        public ::testing::TestWithParam<FK::BatchFileReader::Backend> {
+ protected:
+  void SetUp(void) {
+    // File k holds k * 1000 + 1 bytes, with a pattern depending on k
+    for (size_t k = 0; k < 12; ++k) {
+      std::string p = "ut_batch_reader_" + std::to_string(k) + ".bin";
+      std::string data(k * 1000 + 1, 0);
+      for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>((i * 7 + k) & 0xFF);
+      }
+      std::ofstream(p, std::ios::binary).write(data.data(), data.size());
+      paths_.push_back(p);
+      contents_.push_back(data);
+    }
+  }
+
+  void TearDown(void) {
+    for (const auto& p : paths_) {
+      std::remove(p.c_str());
+    }
+  }
+
+  /** Files */
+  std::vector<std::string> paths_;
+  /** Expected content */
+  std::vector<std::string> contents_;
+};
+
+TEST_P(BatchFileReaderTest, Read) {
+  FK::BatchFileReader::Options opts;
+  opts.backend = GetParam();
+  opts.queue_depth = 4;
+  FK::BatchFileReader reader(opts);
+  if (GetParam() == FK::BatchFileReader::Backend::kThreadPool) {
+    EXPECT_EQ(reader.backend(), FK::BatchFileReader::Backend::kThreadPool);
+  }
+  std::vector<FK::NDArray> arrays;
+  FK::Status s = reader.Read(paths_, &arrays);
+  ASSERT_TRUE(s.Good()) << s.ToString();
+  ASSERT_EQ(arrays.size(), paths_.size());
+  for (size_t k = 0; k < arrays.size(); ++k) {
+    EXPECT_EQ(arrays[k].type(), FK::DataType::kUInt8);
+    ASSERT_EQ(arrays[k].n_elems(), contents_[k].size());
+    const auto* ptr = arrays[k].AsFlat<uint8_t>().data();
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(ptr),
+                          arrays[k].n_elems()), contents_[k]);
+  }
+}
+
+TEST_P(BatchFileReaderTest, Missing) {
+  FK::BatchFileReader::Options opts;
+  opts.backend = GetParam();
+  FK::BatchFileReader reader(opts);
+  std::vector<std::string> paths = {paths_[1], "ut_batch_reader_none.bin",
+                                    paths_[2]};
+  std::vector<bool> reported(paths.size(), false);
+  std::vector<bool> good(paths.size(), false);
+  FK::Status s = reader.Read(paths, [&](const size_t& index,
+                                        const FK::Status& status,
+                                        FK::NDArray&& content) {
+    reported[index] = true;
+    good[index] = status.Good();
+  });
+  EXPECT_FALSE(s.Good());
+  EXPECT_EQ(reported, std::vector<bool>(3, true));
+  EXPECT_EQ(good, std::vector<bool>({true, false, true}));
+}
+
+INSTANTIATE_TEST_CASE_P(Backends,
+                        BatchFileReaderTest,
+                        ::testing::Values(
+                          FK::BatchFileReader::Backend::kThreadPool,
+                          FK::BatchFileReader::Backend::kAuto));
+
+TEST(MemoryStream, Read) {
+  FK::NDArray array(FK::DataType::kUInt8, {6});
+  auto flat = array.AsFlat<uint8_t>();
+  for (int i = 0; i < 6; ++i) {
+    flat(i) = static_cast<uint8_t>('a' + i);
+  }
+  FK::MemoryStream stream(array);
+  char buff[4] = {0};
+  stream.read(buff, 3);
+  EXPECT_EQ(std::string(buff, 3), "abc");
+  stream.seekg(0, std::ios_base::end);
+  EXPECT_EQ(static_cast<int>(stream.tellg()), 6);
+  stream.seekg(4);
+  stream.read(buff, 2);
+  EXPECT_EQ(std::string(buff, 2), "ef");
+  stream.read(buff, 1);
+  EXPECT_TRUE(stream.eof());
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Disable logger
+  FaceKit::Logger::Instance().Disable();
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
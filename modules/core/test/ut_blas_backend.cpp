@@ -0,0 +1,89 @@
+/**
+ *  @file   ut_blas_backend.cpp
+ *  @brief Unit test for BLAS backend selection / threading control
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   22.08.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/math/blas_backend.hpp"
+#include "facekit/core/logger.hpp"
+
+TEST(BlasBackend, Detection) {
+  namespace FK = FaceKit;
+  auto& backend = FK::BlasBackend::Get();
+  EXPECT_EQ(&backend, &FK::BlasBackend::Get());
+  EXPECT_FALSE(std::string(backend.Name()).empty());
+  EXPECT_GE(backend.GetNumThreads(), 1);
+  EXPECT_FALSE(backend.SetNumThreads(-1).Good());
+}
+
+TEST(BlasBackend, NumThreads) {
+  namespace FK = FaceKit;
+  auto& backend = FK::BlasBackend::Get();
+  if (!backend.SupportThreadControl()) {
+    EXPECT_EQ(backend.SetNumThreads(2).Code(),
+              FK::Status::Type::kUnimplemented);
+    return;
+  }
+  const int n = backend.GetNumThreads();
+  EXPECT_TRUE(backend.SetNumThreads(2).Good());
+  EXPECT_EQ(backend.GetNumThreads(), 2);
+  EXPECT_TRUE(backend.SetNumThreads(n).Good());
+  EXPECT_EQ(backend.GetNumThreads(), n);
+}
+
+TEST(BlasBackend, SerialScope) {
+  namespace FK = FaceKit;
+  auto& backend = FK::BlasBackend::Get();
+  if (!backend.SupportThreadControl()) {
+    return;
+  }
+  const int n = backend.GetNumThreads();
+  EXPECT_TRUE(backend.SetNumThreads(3).Good());
+  {
+    FK::BlasBackend::SerialScope outer;
+    EXPECT_EQ(backend.GetNumThreads(), 1);
+    {
+      FK::BlasBackend::SerialScope inner;
+      EXPECT_EQ(backend.GetNumThreads(), 1);
+    }
+    // Still inside outer scope
+    EXPECT_EQ(backend.GetNumThreads(), 1);
+    // Deferred until the last scope is released
+    EXPECT_TRUE(backend.SetNumThreads(2).Good());
+    EXPECT_EQ(backend.GetNumThreads(), 1);
+  }
+  EXPECT_EQ(backend.GetNumThreads(), 2);
+  // Concurrent scopes
+  std::vector<std::thread> workers;
+  for (int i = 0; i < 8; ++i) {
+    workers.emplace_back([](void) {
+      for (int k = 0; k < 100; ++k) {
+        FaceKit::BlasBackend::SerialScope scope;
+      }
+    });
+  }
+  for (auto& w : workers) {
+    w.join();
+  }
+  EXPECT_EQ(backend.GetNumThreads(), 2);
+  EXPECT_TRUE(backend.SetNumThreads(n).Good());
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Disable logger
+  FaceKit::Logger::Instance().Disable();
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
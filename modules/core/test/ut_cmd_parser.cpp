@@ -8,7 +8,10 @@
  */
 
 #include <stdio.h>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <string>
 
 #include "gtest/gtest.h"
 
@@ -123,6 +126,114 @@ TEST(Parser, ArgsNeedAndOptionalPresent) {
   }
 }
 
+TEST(Parser, TypedArgs) {
+  struct Config {
+    int n = 1;
+    size_t size = 2;
+    float ratio = 0.5f;
+    double scale = 1.0;
+    bool verbose = false;
+    std::string name = "default";
+  } config;
+  CmdParser parser;
+  parser.AddArgument("-n", CmdParser::ArgState::kNeeded, "n", &config.n);
+  parser.AddArgument("-s", CmdParser::ArgState::kOptional, "s", &config.size);
+  parser.AddArgument("-r", CmdParser::ArgState::kOptional, "r", &config.ratio);
+  parser.AddArgument("-x", CmdParser::ArgState::kOptional, "x", &config.scale);
+  parser.AddArgument("-v", CmdParser::ArgState::kOptional, "v",
+                     &config.verbose);
+  parser.AddArgument("-o", CmdParser::ArgState::kOptional, "o", &config.name);
+  const char* argv[] = {"exec_name", "-n", "-12", "-r", "0.25", "-v", "on",
+                        "-o", "out"};
+  int e = parser.ParseCmdLine(9, argv);
+  EXPECT_EQ(e, 0);
+  EXPECT_EQ(config.n, -12);
+  EXPECT_EQ(config.size, 2u);
+  EXPECT_FLOAT_EQ(config.ratio, 0.25f);
+  EXPECT_DOUBLE_EQ(config.scale, 1.0);
+  EXPECT_TRUE(config.verbose);
+  EXPECT_EQ(config.name, "out");
+  // Raw value still available
+  std::string value;
+  parser.HasArgument("-n", &value);
+  EXPECT_EQ(value, "-12");
+}
+
+TEST(Parser, TypedArgsInvalid) {
+  int n = 3;
+  size_t size = 4;
+  bool flag = false;
+  {
+    CmdParser parser;
+    parser.AddArgument("-n", CmdParser::ArgState::kNeeded, "n", &n);
+    const char* argv[] = {"exec_name", "-n", "12abc"};
+    EXPECT_EQ(parser.ParseCmdLine(3, argv), -1);
+    EXPECT_EQ(n, 3);
+  }
+  {
+    CmdParser parser;
+    parser.AddArgument("-s", CmdParser::ArgState::kNeeded, "s", &size);
+    const char* argv[] = {"exec_name", "-s", "-1"};
+    EXPECT_EQ(parser.ParseCmdLine(3, argv), -1);
+    EXPECT_EQ(size, 4u);
+  }
+  {
+    CmdParser parser;
+    parser.AddArgument("-f", CmdParser::ArgState::kNeeded, "f", &flag);
+    const char* argv[] = {"exec_name", "-f", "maybe"};
+    EXPECT_EQ(parser.ParseCmdLine(3, argv), -1);
+  }
+  {
+    // Value missing at the end of the command line
+    CmdParser parser;
+    parser.AddArgument("-n", CmdParser::ArgState::kNeeded, "n", &n);
+    const char* argv[] = {"exec_name", "-n"};
+    EXPECT_EQ(parser.ParseCmdLine(2, argv), -1);
+  }
+}
+
+TEST(Parser, ConfigFile) {
+  const std::string path = "ut_cmd_parser.cfg";
+  {
+    std::ofstream stream(path.c_str());
+    stream << "# Tool configuration\n"
+           << "n 42\n"
+           << "\n"
+           << "-r 0.75   # trailing comment\n"
+           << "o path with spaces  \n";
+  }
+  int n = 0;
+  float ratio = 0.f;
+  std::string name;
+  CmdParser parser;
+  parser.AddArgument("-n", CmdParser::ArgState::kNeeded, "n", &n);
+  parser.AddArgument("-r", CmdParser::ArgState::kOptional, "r", &ratio);
+  parser.AddArgument("-o", CmdParser::ArgState::kOptional, "o", &name);
+  EXPECT_EQ(parser.ParseConfigFile(path), 0);
+  EXPECT_EQ(n, 42);
+  EXPECT_FLOAT_EQ(ratio, 0.75f);
+  EXPECT_EQ(name, "path with spaces");
+  // Required argument given by the file, command line takes precedence
+  const char* argv[] = {"exec_name", "-r", "0.5"};
+  EXPECT_EQ(parser.ParseCmdLine(3, argv), 0);
+  EXPECT_EQ(n, 42);
+  EXPECT_FLOAT_EQ(ratio, 0.5f);
+  // Unknown key and invalid value
+  {
+    std::ofstream stream(path.c_str());
+    stream << "z 1\n";
+  }
+  EXPECT_EQ(parser.ParseConfigFile(path), -1);
+  {
+    std::ofstream stream(path.c_str());
+    stream << "n one\n";
+  }
+  EXPECT_EQ(parser.ParseConfigFile(path), -1);
+  EXPECT_EQ(n, 42);
+  std::remove(path.c_str());
+  EXPECT_EQ(parser.ParseConfigFile(path), -1);
+}
+
 int main(int argc, const char * argv[]) {
   ::testing::InitGoogleTest(&argc, const_cast<char**>(argv));
   return RUN_ALL_TESTS();
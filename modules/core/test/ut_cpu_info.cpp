@@ -0,0 +1,90 @@
+/**
+ *  @file   ut_cpu_info.cpp
+ *  @brief Unit test for CPU features detection
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <iostream>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/sys/cpu_info.hpp"
+
+namespace FK = FaceKit;
+using Feature = FK::CpuInfo::Feature;
+using Level = FK::CpuInfo::Level;
+
+/** Detected level is consistent with the features */
+TEST(CpuInfo, Level) {
+  const auto& cpu = FK::CpuInfo::Get();
+  std::cout << "CPU: " << cpu.vendor() << ", level: "
+            << FK::CpuInfo::LevelName(cpu.level()) << std::endl;
+  EXPECT_TRUE(cpu.Has(Feature::kNone));
+  EXPECT_TRUE(cpu.Supports(Level::kScalar));
+  EXPECT_TRUE(cpu.Supports(cpu.level()));
+  if (cpu.Supports(Level::kAvx512)) {
+    EXPECT_TRUE(cpu.Supports(Level::kAvx2));
+  }
+  if (cpu.Supports(Level::kAvx2)) {
+    EXPECT_TRUE(cpu.Supports(Level::kSse42));
+    EXPECT_TRUE(cpu.Has(Feature::kAvx | Feature::kFma | Feature::kF16c));
+  }
+  EXPECT_FALSE(cpu.Has(Feature::kNeon) && cpu.Has(Feature::kSse2));
+}
+
+static int Scalar(void) { return 0; }
+static int Sse42(void) { return 1; }
+static int Avx2(void) { return 2; }
+
+/** Dispatch pick the highest supported candidate */
+TEST(CpuInfo, Select) {
+  using Fn = int (*)(void);
+  const auto& cpu = FK::CpuInfo::Get();
+  Fn fn = cpu.Select<Fn>(&Scalar, {{Level::kSse42, &Sse42},
+                                   {Level::kAvx2, &Avx2}});
+  int expected = 0;
+  if (cpu.Supports(Level::kAvx2)) {
+    expected = 2;
+  } else if (cpu.Supports(Level::kSse42)) {
+    expected = 1;
+  }
+  EXPECT_EQ(fn(), expected);
+  // Missing candidate falls back to the next one
+  fn = cpu.Select<Fn>(&Scalar, {{Level::kSse42, &Sse42},
+                                {Level::kAvx2, nullptr}});
+  EXPECT_EQ(fn(), cpu.Supports(Level::kSse42) ? 1 : 0);
+  // Unsupported everywhere
+  fn = cpu.Select<Fn>(&Scalar, {});
+  EXPECT_EQ(fn(), 0);
+}
+
+#ifdef FK_HAS_TARGET
+/** Same function compiled for AVX2 */
+FK_TARGET("avx2,fma")
+static float DotAvx2(const float* a, const float* b, const size_t& n) {
+  float s = 0.f;
+  for (size_t i = 0; i < n; ++i) {
+    s += a[i] * b[i];
+  }
+  return s;
+}
+
+/** Function level targeting */
+TEST(CpuInfo, Target) {
+  const float a[] = {1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f, 9.f};
+  if (FK::CpuInfo::Get().Supports(Level::kAvx2)) {
+    EXPECT_FLOAT_EQ(DotAvx2(a, a, 9), 285.f);
+  }
+}
+#endif
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
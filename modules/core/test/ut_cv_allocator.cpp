@@ -0,0 +1,105 @@
+/**
+ *  @file   ut_cv_allocator.cpp
+ *  @brief Unit test for OpenCV allocator hook
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cstdint>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/mem/allocator.hpp"
+#include "facekit/core/mem/cv_allocator.hpp"
+#include "facekit/core/mem/memory.hpp"
+
+namespace FK = FaceKit;
+
+/** Allocator counting its live blocks */
+class CountingAllocator : public FK::Allocator {
+ public:
+  std::string Name(void) const override {
+    return "counting_allocator";
+  }
+
+  void* AllocateRaw(const size_t& size, const size_t& alignment) override {
+    ++n_alloc;
+    return FK::Mem::MallocAligned(size, alignment);
+  }
+
+  void DeallocateRaw(const size_t& size, void* ptr) override {
+    ++n_free;
+    FK::Mem::FreeAligned(ptr);
+  }
+
+  int n_alloc = 0;
+  int n_free = 0;
+};
+
+TEST(CvAllocator, Scope) {
+  CountingAllocator alloc;
+  cv::Mat outside(16, 16, CV_32FC1);
+  EXPECT_EQ(FK::CvAllocator::GetThreadAllocator(), nullptr);
+  {
+    FK::ScopedCvAllocator scope(&alloc);
+    EXPECT_EQ(FK::CvAllocator::GetThreadAllocator(), &alloc);
+    cv::Mat a(32, 8, CV_64FC1);
+    cv::Mat b = a * 2.0;
+    EXPECT_EQ(alloc.n_alloc, 2);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a.data) % FK::CvAllocator::kAlignment,
+              0u);
+    EXPECT_TRUE(a.isContinuous());
+    // User data is never taken over
+    float buffer[4];
+    cv::Mat wrap(2, 2, CV_32FC1, buffer);
+    EXPECT_EQ(alloc.n_alloc, 2);
+  }
+  EXPECT_EQ(alloc.n_free, 2);
+  EXPECT_EQ(FK::CvAllocator::GetThreadAllocator(), nullptr);
+  cv::Mat after(16, 16, CV_32FC1);
+  EXPECT_EQ(alloc.n_alloc, 2);
+}
+
+TEST(CvAllocator, Escape) {
+  // Matrices outlive the scope and are released by another thread
+  CountingAllocator alloc;
+  cv::Mat m;
+  {
+    FK::ScopedCvAllocator scope(&alloc);
+    m.create(10, 10, CV_8UC3);
+  }
+  EXPECT_EQ(alloc.n_alloc, 1);
+  std::thread t([&m]() { m.release(); });
+  t.join();
+  EXPECT_EQ(alloc.n_free, 1);
+}
+
+TEST(CvAllocator, PerThread) {
+  CountingAllocator alloc;
+  FK::ScopedCvAllocator scope(&alloc);
+  std::thread t([]() {
+    EXPECT_EQ(FK::CvAllocator::GetThreadAllocator(), nullptr);
+    cv::Mat m(8, 8, CV_32FC1);
+  });
+  t.join();
+  EXPECT_EQ(alloc.n_alloc, 0);
+}
+
+TEST(CvAllocator, Pooled) {
+  ASSERT_NE(FK::CvAllocator::Pooled(), nullptr);
+  FK::ScopedCvAllocator scope(FK::CvAllocator::Pooled());
+  cv::Mat m(64, 64, CV_32FC1, cv::Scalar(1.f));
+  EXPECT_EQ(cv::sum(m)[0], 64.0 * 64.0);
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,130 @@
+/**
+ *  @file   ut_device_linear_algebra.cpp
+ *  @brief Unit test for DeviceLinearAlgebra class, GPU tests are skipped
+ *         when no device is available
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include "gtest/gtest.h"
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/math/device_linear_algebra.hpp"
+#include "facekit/core/math/linear_algebra.hpp"
+
+template<typename T>
+class DeviceLinearAlgebraUnitTest : public testing::Test {
+ public:
+  /**
+   *  @name DeviceLinearAlgebraUnitTest
+   *  @brief  Contructor
+   */
+  DeviceLinearAlgebraUnitTest(void) = default;
+};
+
+// List of type to test against
+typedef ::testing::Types<float, double> TypeToTest;
+// Provide list of tested type to basic test fixture
+TYPED_TEST_CASE(DeviceLinearAlgebraUnitTest, TypeToTest);
+
+/** Without a device every operation reports it */
+TYPED_TEST(DeviceLinearAlgebraUnitTest, Unavailable) {
+  namespace FK = FaceKit;
+  if (FK::DeviceStream::IsAvailable()) {
+    return;
+  }
+  FK::DeviceStream stream;
+  FK::PinnedBuffer buffer;
+  FK::DeviceMatrix<TypeParam> A;
+  EXPECT_FALSE(stream.Init().Good());
+  EXPECT_FALSE(buffer.Resize(64).Good());
+  EXPECT_FALSE(A.Create(4, 4).Good());
+  EXPECT_TRUE(A.empty());
+}
+
+/** Upload / download round trip */
+TYPED_TEST(DeviceLinearAlgebraUnitTest, Transfer) {
+  namespace FK = FaceKit;
+  if (!FK::DeviceStream::IsAvailable()) {
+    return;
+  }
+  cv::Mat A(23, 11, cv::DataType<TypeParam>::type);
+  cv::randn(A, TypeParam(0.0), TypeParam(1.0));
+  // Blocking
+  FK::DeviceMatrix<TypeParam> dA;
+  ASSERT_TRUE(dA.Upload(A).Good());
+  EXPECT_EQ(dA.rows(), 23);
+  EXPECT_EQ(dA.cols(), 11);
+  cv::Mat B;
+  ASSERT_TRUE(dA.Download(&B).Good());
+  EXPECT_EQ(cv::norm(A, B), 0.0);
+  // Wrong type
+  cv::Mat I(3, 3, CV_32SC1);
+  EXPECT_FALSE(dA.Upload(I).Good());
+  // Asynchronous through pinned memory
+  FK::DeviceStream stream;
+  FK::PinnedBuffer pinned;
+  ASSERT_TRUE(stream.Init().Good());
+  ASSERT_TRUE(pinned.Resize(A.total() * sizeof(TypeParam)).Good());
+  auto* host = static_cast<TypeParam*>(pinned.data());
+  ASSERT_TRUE(dA.Download(host, &stream).Good());
+  ASSERT_TRUE(stream.Synchronize().Good());
+  cv::Mat C(23, 11, cv::DataType<TypeParam>::type, host);
+  EXPECT_EQ(cv::norm(A, C), 0.0);
+}
+
+/** Gemm, compared against the host implementation */
+TYPED_TEST(DeviceLinearAlgebraUnitTest, Gemm) {
+  namespace FK = FaceKit;
+  using LA = FK::LinearAlgebra<TypeParam>;
+  using DLA = FK::DeviceLinearAlgebra<TypeParam>;
+  using TType = typename FK::LinearAlgebra<TypeParam>::TransposeType;
+  if (!FK::DeviceStream::IsAvailable()) {
+    return;
+  }
+  FK::DeviceStream stream;
+  ASSERT_TRUE(stream.Init().Good());
+  const TType types[] = {TType::kNoTranspose, TType::kTranspose};
+  for (const auto& ta : types) {
+    for (const auto& tb : types) {
+      cv::Mat A = ta == TType::kNoTranspose ?
+              cv::Mat(57, 33, cv::DataType<TypeParam>::type) :
+              cv::Mat(33, 57, cv::DataType<TypeParam>::type);
+      cv::Mat B = tb == TType::kNoTranspose ?
+              cv::Mat(33, 17, cv::DataType<TypeParam>::type) :
+              cv::Mat(17, 33, cv::DataType<TypeParam>::type);
+      cv::Mat C(57, 17, cv::DataType<TypeParam>::type);
+      cv::randn(A, TypeParam(0.0), TypeParam(1.0));
+      cv::randn(B, TypeParam(0.0), TypeParam(1.0));
+      cv::randn(C, TypeParam(0.0), TypeParam(1.0));
+      FK::DeviceMatrix<TypeParam> dA, dB, dC;
+      ASSERT_TRUE(dA.Upload(A).Good());
+      ASSERT_TRUE(dB.Upload(B).Good());
+      ASSERT_TRUE(dC.Upload(C).Good());
+      ASSERT_TRUE(DLA::Gemm(dA, ta, TypeParam(0.5), dB, tb, TypeParam(2.0),
+                            &dC, &stream).Good());
+      ASSERT_TRUE(stream.Synchronize().Good());
+      LA::Gemm(A, ta, TypeParam(0.5), B, tb, TypeParam(2.0), &C);
+      cv::Mat gpu_C;
+      ASSERT_TRUE(dC.Download(&gpu_C).Good());
+      TypeParam diff = (TypeParam)cv::norm(C, gpu_C) / C.total();
+      TypeParam thr = sizeof(TypeParam) == 4 ? 1e-6 : 1e-8;
+      EXPECT_LT(diff, thr);
+    }
+  }
+  // Inner dimensions mismatch
+  FK::DeviceMatrix<TypeParam> dA, dB, dC;
+  ASSERT_TRUE(dA.Create(4, 3).Good());
+  ASSERT_TRUE(dB.Create(4, 3).Good());
+  EXPECT_FALSE(DLA::Gemm(dA, TType::kNoTranspose, TypeParam(1.0), dB,
+                         TType::kNoTranspose, TypeParam(0.0), &dC,
+                         &stream).Good());
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,121 @@
+/**
+ *  @file   ut_disk_cache.cpp
+ *  @brief Unit test for content-addressed disk cache
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   24.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/sys/disk_cache.hpp"
+
+class DiskCacheTest : public ::testing::Test {
+ protected:
+  void SetUp(void) {
+    std::system("rm -rf ut_disk_cache");
+  }
+
+  void TearDown(void) {
+    std::system("rm -rf ut_disk_cache");
+  }
+};
+
+TEST(CacheKey, Digest) {
+  namespace FK = FaceKit;
+  // Same content, whatever the split
+  const std::string data = "The quick brown fox jumps over the lazy dog";
+  FK::CacheKey a, b, c;
+  a.Add(data.data(), data.size());
+  b.Add(data.data(), 5).Add(data.data() + 5, 11).Add(data.data() + 16, 27);
+  c.Add(data.data(), data.size() - 1);
+  EXPECT_EQ(a.ToString().size(), 32);
+  EXPECT_EQ(a.ToString(), b.ToString());
+  EXPECT_NE(a.ToString(), c.ToString());
+  // Parameters and strings
+  FK::CacheKey p1, p2, s1, s2;
+  p1.Add(data).Add(64).Add(0.5f);
+  p2.Add(data).Add(64).Add(0.25f);
+  EXPECT_NE(p1.ToString(), p2.ToString());
+  s1.Add(std::string("ab")).Add(std::string("c"));
+  s2.Add(std::string("a")).Add(std::string("bc"));
+  EXPECT_NE(s1.ToString(), s2.ToString());
+}
+
+TEST_F(DiskCacheTest, InsertLookup) {
+  namespace FK = FaceKit;
+  FK::DiskCache cache;
+  ASSERT_TRUE(cache.Open("ut_disk_cache", 1024).Good());
+  const std::string key = FK::CacheKey().Add(std::string("mesh")).ToString();
+  std::string data;
+  EXPECT_EQ(cache.Lookup(key, &data).Code(), FK::Status::Type::kNotFound);
+  EXPECT_TRUE(cache.Insert(key, std::string(100, 'x')).Good());
+  EXPECT_TRUE(cache.Lookup(key, &data).Good());
+  EXPECT_EQ(data, std::string(100, 'x'));
+  // Replace
+  EXPECT_TRUE(cache.Insert(key, std::string(10, 'y')).Good());
+  EXPECT_TRUE(cache.Lookup(key, &data).Good());
+  EXPECT_EQ(data, std::string(10, 'y'));
+  EXPECT_EQ(cache.size(), 10);
+  EXPECT_EQ(cache.n_entry(), 1);
+  // Too large
+  EXPECT_FALSE(cache.Insert("big", std::string(2048, 'z')).Good());
+  // Remove
+  EXPECT_TRUE(cache.Remove(key).Good());
+  EXPECT_FALSE(cache.Lookup(key, &data).Good());
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST_F(DiskCacheTest, Eviction) {
+  namespace FK = FaceKit;
+  FK::DiskCache cache;
+  ASSERT_TRUE(cache.Open("ut_disk_cache", 300).Good());
+  EXPECT_TRUE(cache.Insert("a", std::string(100, 'a')).Good());
+  EXPECT_TRUE(cache.Insert("b", std::string(100, 'b')).Good());
+  EXPECT_TRUE(cache.Insert("c", std::string(100, 'c')).Good());
+  // Touch `a`, `b` becomes the least recently used
+  std::string data;
+  EXPECT_TRUE(cache.Lookup("a", &data).Good());
+  EXPECT_TRUE(cache.Insert("d", std::string(100, 'd')).Good());
+  EXPECT_EQ(cache.n_entry(), 3);
+  EXPECT_EQ(cache.size(), 300);
+  EXPECT_FALSE(cache.Lookup("b", &data).Good());
+  EXPECT_TRUE(cache.Lookup("a", &data).Good());
+  EXPECT_TRUE(cache.Lookup("c", &data).Good());
+  EXPECT_TRUE(cache.Lookup("d", &data).Good());
+}
+
+TEST_F(DiskCacheTest, Reopen) {
+  namespace FK = FaceKit;
+  {
+    FK::DiskCache cache;
+    ASSERT_TRUE(cache.Open("ut_disk_cache", 1024).Good());
+    EXPECT_TRUE(cache.Insert("a", std::string(100, 'a')).Good());
+    EXPECT_TRUE(cache.Insert("b", std::string(200, 'b')).Good());
+  }
+  // Interrupted write from another process, recent so it is kept
+  std::ofstream("ut_disk_cache/c.1234.0.tmp") << "partial";
+  FK::DiskCache cache;
+  ASSERT_TRUE(cache.Open("ut_disk_cache", 1024).Good());
+  EXPECT_EQ(cache.n_entry(), 2);
+  EXPECT_EQ(cache.size(), 300);
+  std::string data;
+  EXPECT_TRUE(cache.Lookup("b", &data).Good());
+  EXPECT_EQ(data, std::string(200, 'b'));
+  EXPECT_FALSE(cache.Lookup("c", &data).Good());
+  // Smaller limit evicts on open
+  FK::DiskCache small;
+  ASSERT_TRUE(small.Open("ut_disk_cache", 250).Good());
+  EXPECT_EQ(small.n_entry(), 1);
+}
+
+int main(int argc, const char * argv[]) {
+  ::testing::InitGoogleTest(&argc, const_cast<char**>(argv));
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,93 @@
+/**
+ *  @file   ut_fast_math.cpp
+ *  @brief Unit test for approximated math functions
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   29.08.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cmath>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/math/fast_math.hpp"
+#include "facekit/core/math/vector.hpp"
+#include "facekit/core/logger.hpp"
+
+TEST(FastMath, Rsqrt) {
+  namespace FM = FaceKit::FastMath;
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> expo(-30.0, 30.0);
+  for (int i = 0; i < 100000; ++i) {
+    const double x = std::pow(10.0, expo(gen));
+    const float xf = static_cast<float>(x);
+    EXPECT_NEAR(FM::Rsqrt(xf) * std::sqrt(static_cast<double>(xf)),
+                1.0, 5e-7);
+    EXPECT_NEAR(FM::Rsqrt(x) * std::sqrt(x), 1.0, 1e-13);
+  }
+  EXPECT_TRUE(std::isnan(FM::Rsqrt(0.f)));
+  EXPECT_TRUE(std::isnan(FM::Rsqrt(0.0)));
+}
+
+TEST(FastMath, Acos) {
+  namespace FM = FaceKit::FastMath;
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  for (int i = 0; i < 100000; ++i) {
+    const double x = dist(gen);
+    EXPECT_NEAR(FM::Acos(x), std::acos(x), 7e-5);
+    EXPECT_NEAR(FM::Acos(static_cast<float>(x)), std::acos(x), 7e-5);
+  }
+  EXPECT_NEAR(FM::Acos(1.0), 0.0, 7e-5);
+  EXPECT_NEAR(FM::Acos(-1.0), std::acos(-1.0), 7e-5);
+  // Clamped
+  EXPECT_NEAR(FM::Acos(1.0 + 1e-7), 0.0, 7e-5);
+}
+
+TEST(FastMath, Atan2) {
+  namespace FM = FaceKit::FastMath;
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dist(-5.0, 5.0);
+  for (int i = 0; i < 100000; ++i) {
+    const double y = dist(gen);
+    const double x = dist(gen);
+    EXPECT_NEAR(FM::Atan2(y, x), std::atan2(y, x), 1.2e-5);
+  }
+  EXPECT_EQ(FM::Atan2(0.0, 0.0), 0.0);
+  EXPECT_NEAR(FM::Atan2(1.0, 0.0), std::atan2(1.0, 0.0), 1.2e-5);
+  EXPECT_NEAR(FM::Atan2(0.0, -1.0), std::atan2(0.0, -1.0), 1.2e-5);
+}
+
+TEST(FastMath, NormalizePolicy) {
+  namespace FK = FaceKit;
+  FK::Vector3<float> a(1.f, -2.f, 3.f);
+  FK::Vector3<float> b = a;
+  a.Normalize();
+  b.Normalize<FK::FastMathPolicy>();
+  EXPECT_NEAR(a.x_, b.x_, 1e-6f);
+  EXPECT_NEAR(a.y_, b.y_, 1e-6f);
+  EXPECT_NEAR(a.z_, b.z_, 1e-6f);
+  EXPECT_NEAR(b.Norm(), 1.f, 1e-6f);
+  // Null vector gives NaN for both policies
+  FK::Vector3<double> z0;
+  FK::Vector3<double> z1;
+  z0.Normalize();
+  z1.Normalize<FK::FastMathPolicy>();
+  EXPECT_TRUE(std::isnan(z0.x_));
+  EXPECT_TRUE(std::isnan(z1.x_));
+  FK::Vector4<double> c(1.0, 2.0, 3.0, 4.0);
+  c.Normalize<FK::FastMathPolicy>();
+  EXPECT_NEAR(c.Norm(), 1.0, 1e-12);
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Disable logger
+  FaceKit::Logger::Instance().Disable();
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
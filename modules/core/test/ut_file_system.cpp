@@ -9,12 +9,15 @@
  */
 
 #include <limits>
+#include <atomic>
+#include <algorithm>
 
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
 #include "facekit/core/sys/posix_file_system.hpp"
 #include "facekit/core/sys/file_system_factory.hpp"
+#include "facekit/core/thread_pool.hpp"
 
 
 class FileSystemTest : public ::testing::Test {
@@ -131,6 +134,92 @@ TEST_F(FileSystemTest, ListDir) {
   }
 }
 
+TEST_F(FileSystemTest, WalkDir) {
+  namespace FK = FaceKit;
+  using Options = FK::FileSystem::WalkOptions;
+  // Add some files with other extension
+  std::system("echo Img! >> ut_filesystem/subdir/img.jpg");
+  std::system("echo Img! >> ut_filesystem/to_rm/subdir/img.png");
+  { // Filter by extensions
+    std::vector<std::string> content;
+    Options opts;
+    opts.extensions = {".jpg", ".png"};
+    FK::Status s = fs_->WalkDir("ut_filesystem", opts,
+                                [&](const std::string& f) {
+                                  content.push_back(f);
+                                  return true;
+                                });
+    std::sort(content.begin(), content.end());
+    EXPECT_TRUE(s.Good());
+    EXPECT_THAT(content, testing::ElementsAre("ut_filesystem/subdir/img.jpg",
+                                              "ut_filesystem/to_rm/subdir/img.png"));
+  }
+  { // Filter by glob patterns
+    std::vector<std::string> content;
+    Options opts;
+    opts.patterns = {"img.*", "item[2-9].txt"};
+    FK::Status s = fs_->WalkDir("ut_filesystem", opts,
+                                [&](const std::string& f) {
+                                  content.push_back(f);
+                                  return true;
+                                });
+    std::sort(content.begin(), content.end());
+    EXPECT_TRUE(s.Good());
+    EXPECT_THAT(content, testing::ElementsAre("ut_filesystem/subdir/img.jpg",
+                                              "ut_filesystem/subdir/item2.txt",
+                                              "ut_filesystem/to_rm/subdir/img.png"));
+  }
+  { // Typed listing
+    std::vector<FK::FileSystem::DirEntry> entries;
+    FK::Status s = fs_->ListDirEntries("ut_filesystem/to_rm", &entries);
+    std::sort(entries.begin(), entries.end(),
+              [](const FK::FileSystem::DirEntry& a,
+                 const FK::FileSystem::DirEntry& b) {
+                return a.path < b.path;
+              });
+    EXPECT_TRUE(s.Good());
+    ASSERT_EQ(entries.size(), 2);
+    EXPECT_EQ(entries[0].path, "ut_filesystem/to_rm/remove_me.txt");
+    EXPECT_FALSE(entries[0].is_dir);
+    EXPECT_EQ(entries[1].path, "ut_filesystem/to_rm/subdir");
+    EXPECT_TRUE(entries[1].is_dir);
+  }
+  { // Bounded concurrency on a dedicated pool
+    FK::ThreadPool pool(4);
+    std::vector<std::string> content;
+    Options opts;
+    opts.extensions = {".txt"};
+    opts.max_concurrency = 1;
+    opts.pool = &pool;
+    FK::Status s = fs_->WalkDir("ut_filesystem", opts,
+                                [&](const std::string& f) {
+                                  content.push_back(f);
+                                  return true;
+                                });
+    EXPECT_TRUE(s.Good());
+    EXPECT_EQ(content.size(), 6);
+  }
+  { // Stop early
+    std::atomic<int> n(0);
+    FK::Status s = fs_->WalkDir("ut_filesystem", Options(),
+                                [&](const std::string& f) {
+                                  n += 1;
+                                  return false;
+                                });
+    EXPECT_TRUE(s.Good());
+    EXPECT_EQ(n.load(), 1);
+  }
+  { // Called from within a worker
+    auto& pool = FK::ThreadPool::Get();
+    auto f = pool.Enqueue(FK::ThreadPool::TaskPriority::kNormal, [&]() {
+      std::vector<std::string> content;
+      fs_->ListDirRecursively("ut_filesystem", &content);
+      return content.size();
+    });
+    EXPECT_EQ(f.get(), 8);
+  }
+}
+
 TEST_F(FileSystemTest, FileProperties) {
   namespace FK = FaceKit;
   
@@ -290,6 +379,80 @@ TEST_F(FileSystemTest, CopyFile) {
   }
 }
 
+TEST_F(FileSystemTest, RandomAccessFile) {
+  namespace FK = FaceKit;
+  
+  { // Existing, "HelloWorld!\n"
+    std::unique_ptr<FK::RandomAccessFile> file;
+    FK::Status s = fs_->NewRandomAccessFile("ut_filesystem/hello_world.txt",
+                                            &file);
+    ASSERT_TRUE(s.Good());
+    size_t sz = 0;
+    EXPECT_TRUE(file->Size(&sz).Good());
+    EXPECT_EQ(sz, 12);
+    // Positional read
+    char buffer[16] = {0};
+    size_t n_read = 0;
+    s = file->Read(5, 5, buffer, &n_read);
+    EXPECT_TRUE(s.Good());
+    EXPECT_EQ(n_read, 5);
+    EXPECT_EQ(std::string(buffer, n_read), "World");
+    // Past the end
+    FK::Status eof = file->Read(10, 6, buffer, &n_read);
+    EXPECT_EQ(eof.Code(), FK::Status::Type::kOutOfRange);
+    EXPECT_EQ(n_read, 2);
+    EXPECT_EQ(std::string(buffer, n_read), "!\n");
+    // Vectored read
+    char b0[5], b1[5];
+    std::vector<FK::RandomAccessFile::ReadRequest> reqs(2);
+    reqs[0].offset = 5;
+    reqs[0].size = 5;
+    reqs[0].buffer = b0;
+    reqs[1].offset = 0;
+    reqs[1].size = 5;
+    reqs[1].buffer = b1;
+    s = file->ReadV(&reqs);
+    EXPECT_TRUE(s.Good());
+    EXPECT_EQ(std::string(b0, reqs[0].n_read), "World");
+    EXPECT_EQ(std::string(b1, reqs[1].n_read), "Hello");
+  }
+  { // Not Existing
+    std::unique_ptr<FK::RandomAccessFile> file;
+    FK::Status s = fs_->NewRandomAccessFile("ut_filesystem/item4.txt", &file);
+    EXPECT_FALSE(s.Good());
+    EXPECT_EQ(file, nullptr);
+  }
+}
+
+TEST_F(FileSystemTest, ReadOnlyMemoryRegion) {
+  namespace FK = FaceKit;
+  
+  { // Existing
+    std::unique_ptr<FK::ReadOnlyMemoryRegion> region;
+    FK::Status s = fs_->NewReadOnlyMemoryRegion("ut_filesystem/foo_bar.txt",
+                                                &region);
+    ASSERT_TRUE(s.Good());
+    ASSERT_EQ(region->length(), 8);
+    const char* data = reinterpret_cast<const char*>(region->data());
+    EXPECT_EQ(std::string(data, region->length()), "FooBar!\n");
+  }
+  { // Empty file
+    std::system("touch ut_filesystem/empty/void.bin");
+    std::unique_ptr<FK::ReadOnlyMemoryRegion> region;
+    FK::Status s = fs_->NewReadOnlyMemoryRegion("ut_filesystem/empty/void.bin",
+                                                &region);
+    ASSERT_TRUE(s.Good());
+    EXPECT_EQ(region->length(), 0);
+    EXPECT_EQ(region->data(), nullptr);
+  }
+  { // Not Existing
+    std::unique_ptr<FK::ReadOnlyMemoryRegion> region;
+    FK::Status s = fs_->NewReadOnlyMemoryRegion("ut_filesystem/item4.txt",
+                                                &region);
+    EXPECT_FALSE(s.Good());
+  }
+}
+
 TEST(FileSystemFactory, Retrieve) {
   namespace FK = FaceKit;
   
@@ -277,6 +277,36 @@ TYPED_TEST(LinearAlgebraUnitTest, GemvTrans) {
   EXPECT_LT(diff, thr);
 }
 
+/** Gemv with reduced precision matrix */
+TYPED_TEST(LinearAlgebraUnitTest, GemvQuantized) {
+  using LA = FaceKit::LinearAlgebra<TypeParam>;
+  using TType = typename FaceKit::LinearAlgebra<TypeParam>::TransposeType;
+  using Format = FaceKit::QuantizedMatrix::Format;
+  // Define input to vector
+  cv::Mat A(57, 13, cv::DataType<TypeParam>::type);
+  cv::Mat x(13, 1, cv::DataType<TypeParam>::type);
+  cv::Mat y(57, 1, cv::DataType<TypeParam>::type);
+  cv::theRNG().state = static_cast<uint64_t>(cv::getTickCount());
+  cv::randn(A, TypeParam(0.0), TypeParam(1.0));
+  cv::randn(x, TypeParam(0.0), TypeParam(1.0));
+  cv::randn(y, TypeParam(0.0), TypeParam(1.0));
+  for (const auto fmt : {Format::kFloat16, Format::kBFloat16, Format::kInt8}) {
+    FaceKit::QuantizedMatrix qA;
+    ASSERT_TRUE(qA.Quantize(reinterpret_cast<const TypeParam*>(A.data),
+                            A.rows,
+                            A.cols,
+                            fmt).Good());
+    // Compute ground truth
+    cv::Mat gt_y = (TypeParam(0.5) * (A * x)) + (TypeParam(2.0) * y);
+    cv::Mat q_y = y.clone();
+    LA::Gemv(qA, TType::kNoTranspose, TypeParam(0.5), x, TypeParam(2.0), &q_y);
+    // Compare, error driven by the storage precision
+    TypeParam diff = (TypeParam)(cv::norm(gt_y, q_y) / cv::norm(gt_y));
+    TypeParam thr = fmt == Format::kFloat16 ? 2e-3 : 2e-2;
+    EXPECT_LT(diff, thr);
+  }
+}
+
 #pragma mark -
 #pragma mark Gemm
 
@@ -396,6 +426,106 @@ TYPED_TEST(LinearAlgebraUnitTest, Gemm_AtBt) {
   EXPECT_LT(diff, thr);
 }
 
+#pragma mark -
+#pragma mark Batched
+
+/** Strided Gemv batch */
+TYPED_TEST(LinearAlgebraUnitTest, GemvBatched) {
+  using LA = FaceKit::LinearAlgebra<TypeParam>;
+  using TType = typename FaceKit::LinearAlgebra<TypeParam>::TransposeType;
+  // 9 matrices of 7x5 stacked vertically, one vector per row of X
+  const int batch = 9;
+  cv::Mat A(batch * 7, 5, cv::DataType<TypeParam>::type);
+  cv::Mat X(batch, 5, cv::DataType<TypeParam>::type);
+  cv::Mat Y(batch, 7, cv::DataType<TypeParam>::type);
+  cv::theRNG().state = static_cast<uint64_t>(cv::getTickCount());
+  cv::randn(A, TypeParam(0.0), TypeParam(1.0));
+  cv::randn(X, TypeParam(0.0), TypeParam(1.0));
+  cv::randn(Y, TypeParam(0.0), TypeParam(1.0));
+  const TypeParam alpha = TypeParam(0.5);
+  const TypeParam beta = TypeParam(2.0);
+  // Compute ground truth, item per item
+  cv::Mat gt_y = Y.clone();
+  for (int i = 0; i < batch; ++i) {
+    cv::Mat Ai = A.rowRange(i * 7, (i + 1) * 7);
+    cv::Mat yi = (alpha * (Ai * X.row(i).t())) + (beta * Y.row(i).t());
+    cv::Mat res = yi.t();
+    res.copyTo(gt_y.row(i));
+  }
+  // Call batched version
+  LA::GemvBatched(A, TType::kNoTranspose, alpha, X, beta, &Y);
+  // Compare
+  TypeParam diff = (TypeParam)cv::norm(gt_y, Y) / gt_y.total();
+  TypeParam thr = sizeof(TypeParam) == 4 ? 1e-6 : 1e-8;
+  EXPECT_LT(diff, thr);
+
+  // List version, different sizes
+  std::vector<cv::Mat> As, xs, ys;
+  for (int i = 0; i < batch; ++i) {
+    As.emplace_back(3 + i, 4, cv::DataType<TypeParam>::type);
+    xs.emplace_back(3 + i, 1, cv::DataType<TypeParam>::type);
+    cv::randn(As.back(), TypeParam(0.0), TypeParam(1.0));
+    cv::randn(xs.back(), TypeParam(0.0), TypeParam(1.0));
+  }
+  LA::GemvBatched(As, TType::kTranspose, alpha, xs, TypeParam(0.0), &ys);
+  ASSERT_EQ(ys.size(), As.size());
+  for (int i = 0; i < batch; ++i) {
+    cv::Mat gt = alpha * (As[i].t() * xs[i]);
+    EXPECT_LT((TypeParam)cv::norm(gt, ys[i]) / gt.total(), thr);
+  }
+}
+
+/** Strided Gemm batch */
+TYPED_TEST(LinearAlgebraUnitTest, GemmBatched) {
+  using LA = FaceKit::LinearAlgebra<TypeParam>;
+  using TType = typename FaceKit::LinearAlgebra<TypeParam>::TransposeType;
+  // 6 products of (4x3)^T * 4x5 -> 3x5
+  const int batch = 6;
+  cv::Mat A(batch * 4, 3, cv::DataType<TypeParam>::type);
+  cv::Mat B(batch * 4, 5, cv::DataType<TypeParam>::type);
+  cv::Mat C(batch * 3, 5, cv::DataType<TypeParam>::type);
+  cv::theRNG().state = static_cast<uint64_t>(cv::getTickCount());
+  cv::randn(A, TypeParam(0.0), TypeParam(1.0));
+  cv::randn(B, TypeParam(0.0), TypeParam(1.0));
+  cv::randn(C, TypeParam(0.0), TypeParam(1.0));
+  const TypeParam alpha = TypeParam(1.5);
+  const TypeParam beta = TypeParam(-1.0);
+  // Compute ground truth
+  cv::Mat gt_C = C.clone();
+  for (int i = 0; i < batch; ++i) {
+    cv::Mat Ai = A.rowRange(i * 4, (i + 1) * 4);
+    cv::Mat Bi = B.rowRange(i * 4, (i + 1) * 4);
+    cv::Mat Ci = gt_C.rowRange(i * 3, (i + 1) * 3);
+    cv::Mat res = (alpha * (Ai.t() * Bi)) + (beta * Ci);
+    res.copyTo(Ci);
+  }
+  // Call batched version
+  LA::GemmBatched(A, TType::kTranspose, alpha,
+                  B, TType::kNoTranspose, beta,
+                  batch, &C);
+  // Compare
+  TypeParam diff = (TypeParam)cv::norm(gt_C, C) / gt_C.total();
+  TypeParam thr = sizeof(TypeParam) == 4 ? 1e-6 : 1e-8;
+  EXPECT_LT(diff, thr);
+
+  // List version, different sizes
+  std::vector<cv::Mat> As, Bs, Cs;
+  for (int i = 0; i < batch; ++i) {
+    As.emplace_back(2 + i, 6, cv::DataType<TypeParam>::type);
+    Bs.emplace_back(3 + i, 6, cv::DataType<TypeParam>::type);
+    cv::randn(As.back(), TypeParam(0.0), TypeParam(1.0));
+    cv::randn(Bs.back(), TypeParam(0.0), TypeParam(1.0));
+  }
+  LA::GemmBatched(As, TType::kNoTranspose, alpha,
+                  Bs, TType::kTranspose, TypeParam(0.0),
+                  &Cs);
+  ASSERT_EQ(Cs.size(), As.size());
+  for (int i = 0; i < batch; ++i) {
+    cv::Mat gt = alpha * (As[i] * Bs[i].t());
+    EXPECT_LT((TypeParam)cv::norm(gt, Cs[i]) / gt.total(), thr);
+  }
+}
+
 
 /** Sbmv */
 TYPED_TEST(LinearAlgebraUnitTest, Sbmv) {
@@ -420,6 +550,212 @@ TYPED_TEST(LinearAlgebraUnitTest, Sbmv) {
   EXPECT_LE(diff, thr);
 }
 
+#pragma mark -
+#pragma mark NDArray
+
+/**
+ *  @name   RandomArray
+ *  @fn     FaceKit::NDArray RandomArray(const FaceKit::NDArrayDims& dims)
+ *  @brief  Create an array filled with normally distributed values
+ *  @param[in] dims Array dimensions
+ *  @tparam T Data type
+ *  @return Random array
+ */
+template<typename T>
+FaceKit::NDArray RandomArray(const FaceKit::NDArrayDims& dims) {
+  using NDArray = FaceKit::NDArray;
+  static std::mt19937 gen(1234);
+  std::normal_distribution<T> dist(T(0.0), T(1.0));
+  NDArray array(FaceKit::DataTypeToEnum<T>::v(), dims);
+  auto flat = array.AsFlat<T>();
+  for (size_t i = 0; i < array.n_elems(); ++i) {
+    flat(i) = dist(gen);
+  }
+  return array;
+}
+
+/** Vector operations on strided views */
+TYPED_TEST(LinearAlgebraUnitTest, NDArrayVectorOps) {
+  using LA = FaceKit::LinearAlgebra<TypeParam>;
+  using NDArray = FaceKit::NDArray;
+  using Range = NDArray::Range;
+  const TypeParam thr = sizeof(TypeParam) == 4 ? 1e-4 : 1e-10;
+  NDArray a = RandomArray<TypeParam>({40});
+  NDArray m = RandomArray<TypeParam>({20, 7});
+  // Every other element and a column, evenly spaced -> no copy
+  NDArray va = a.View({Range(0, 40, 2)});
+  NDArray vb = m.Select(1, 3);
+  auto ma = va.AsVector<TypeParam>();
+  auto mb = m.AsMatrix<TypeParam>();
+  // L2Norm + Dot
+  TypeParam gt_dot = TypeParam(0.0), gt_nrm = TypeParam(0.0);
+  for (size_t i = 0; i < 20; ++i) {
+    gt_dot += ma(i) * mb(i, 3);
+    gt_nrm += ma(i) * ma(i);
+  }
+  EXPECT_NEAR(LA::L2Norm(va), std::sqrt(gt_nrm), thr);
+  EXPECT_NEAR(LA::Dot(va, vb), gt_dot, thr);
+  // Axpy writes through the view
+  NDArray ref;
+  m.DeepCopy(&ref);
+  LA::Axpy(va, TypeParam(2.0), &vb);
+  auto mref = ref.AsMatrix<TypeParam>();
+  auto cm = static_cast<const NDArray&>(m).AsMatrix<TypeParam>();
+  for (size_t i = 0; i < 20; ++i) {
+    EXPECT_NEAR(cm(i, 3), mref(i, 3) + TypeParam(2.0) * ma(i), thr);
+    EXPECT_EQ(cm(i, 2), mref(i, 2));
+  }
+  // Sbmv, non evenly spaced input is copied
+  NDArray d = m.View({Range(0, 20, 5), Range(0, 5)});
+  NDArray x = RandomArray<TypeParam>({4, 5});
+  NDArray y;
+  LA::Sbmv(d, TypeParam(1.5), x, TypeParam(0.0), &y);
+  ASSERT_EQ(y.dims(), 2);
+  auto md = static_cast<const NDArray&>(d).AsMatrix<TypeParam>();
+  auto mx = x.AsMatrix<TypeParam>();
+  auto my = y.AsMatrix<TypeParam>();
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t j = 0; j < 5; ++j) {
+      EXPECT_NEAR(my(i, j), TypeParam(1.5) * md(i, j) * mx(i, j), thr);
+    }
+  }
+}
+
+/** Gemv on contiguous and transposed arrays */
+TYPED_TEST(LinearAlgebraUnitTest, NDArrayGemv) {
+  using LA = FaceKit::LinearAlgebra<TypeParam>;
+  using TType = typename LA::TransposeType;
+  using NDArray = FaceKit::NDArray;
+  using Range = NDArray::Range;
+  const TypeParam thr = sizeof(TypeParam) == 4 ? 1e-4 : 1e-10;
+  NDArray A = RandomArray<TypeParam>({13, 9});
+  NDArray At = A.Transpose();
+  NDArray x = RandomArray<TypeParam>({9});
+  NDArray xt = RandomArray<TypeParam>({13});
+  auto mA = A.AsMatrix<TypeParam>();
+  auto mx = x.AsVector<TypeParam>();
+  auto mxt = xt.AsVector<TypeParam>();
+  std::vector<TypeParam> gt(13, TypeParam(0.0)), gt_t(9, TypeParam(0.0));
+  for (size_t i = 0; i < 13; ++i) {
+    for (size_t j = 0; j < 9; ++j) {
+      gt[i] += mA(i, j) * mx(j);
+      gt_t[j] += mA(i, j) * mxt(i);
+    }
+  }
+  // y = A * x, y = A' * x and (A')' * x
+  NDArray y, yt, ytt;
+  LA::Gemv(A, TType::kNoTranspose, TypeParam(1.0), x, TypeParam(0.0), &y);
+  LA::Gemv(A, TType::kTranspose, TypeParam(1.0), xt, TypeParam(0.0), &yt);
+  LA::Gemv(At, TType::kTranspose, TypeParam(1.0), x, TypeParam(0.0), &ytt);
+  ASSERT_EQ(y.n_elems(), 13);
+  ASSERT_EQ(yt.n_elems(), 9);
+  ASSERT_EQ(ytt.n_elems(), 13);
+  auto my = y.AsVector<TypeParam>();
+  auto myt = yt.AsVector<TypeParam>();
+  auto mytt = ytt.AsVector<TypeParam>();
+  for (size_t i = 0; i < 13; ++i) {
+    EXPECT_NEAR(my(i), gt[i], thr);
+    EXPECT_NEAR(mytt(i), gt[i], thr);
+  }
+  for (size_t j = 0; j < 9; ++j) {
+    EXPECT_NEAR(myt(j), gt_t[j], thr);
+  }
+  // Accumulate into a strided output in place
+  NDArray out = RandomArray<TypeParam>({26});
+  NDArray ref;
+  out.DeepCopy(&ref);
+  NDArray vout = out.View({Range(1, 26, 2)});
+  LA::Gemv(At, TType::kTranspose, TypeParam(2.0), x, TypeParam(1.0), &vout);
+  auto cout = static_cast<const NDArray&>(out).AsVector<TypeParam>();
+  auto mref = ref.AsVector<TypeParam>();
+  for (size_t i = 0; i < 13; ++i) {
+    EXPECT_NEAR(cout(2 * i + 1),
+                mref(2 * i + 1) + TypeParam(2.0) * gt[i],
+                thr);
+    EXPECT_EQ(cout(2 * i), mref(2 * i));
+  }
+}
+
+/** Gemm on contiguous, transposed and strided arrays */
+TYPED_TEST(LinearAlgebraUnitTest, NDArrayGemm) {
+  using LA = FaceKit::LinearAlgebra<TypeParam>;
+  using TType = typename LA::TransposeType;
+  using NDArray = FaceKit::NDArray;
+  using Range = NDArray::Range;
+  const TypeParam thr = sizeof(TypeParam) == 4 ? 1e-4 : 1e-10;
+  NDArray A = RandomArray<TypeParam>({11, 6});
+  NDArray B = RandomArray<TypeParam>({6, 8});
+  auto mA = A.AsMatrix<TypeParam>();
+  auto mB = B.AsMatrix<TypeParam>();
+  std::vector<TypeParam> gt(11 * 8, TypeParam(0.0));
+  for (size_t i = 0; i < 11; ++i) {
+    for (size_t j = 0; j < 8; ++j) {
+      for (size_t k = 0; k < 6; ++k) {
+        gt[i * 8 + j] += mA(i, k) * mB(k, j);
+      }
+    }
+  }
+  auto check = [&](const NDArray& C, const TypeParam& offset) {
+    ASSERT_EQ(C.dims(), 2);
+    ASSERT_EQ(C.dim_size(0), 11);
+    ASSERT_EQ(C.dim_size(1), 8);
+    auto mC = C.AsMatrix<TypeParam>();
+    for (size_t i = 0; i < 11; ++i) {
+      for (size_t j = 0; j < 8; ++j) {
+        EXPECT_NEAR(mC(i, j), gt[i * 8 + j] + offset, thr);
+      }
+    }
+  };
+  // Contiguous
+  NDArray C;
+  LA::Gemm(A, TType::kNoTranspose, TypeParam(1.0),
+           B, TType::kNoTranspose, TypeParam(0.0), &C);
+  check(C, TypeParam(0.0));
+  // Transposed views, C = (A')' * (B')'
+  NDArray At = A.Transpose();
+  NDArray Bt = B.Transpose();
+  NDArray Ct;
+  LA::Gemm(At, TType::kTranspose, TypeParam(1.0),
+           Bt, TType::kTranspose, TypeParam(0.0), &Ct);
+  check(Ct, TypeParam(0.0));
+  // Non-unit inner stride is copied
+  NDArray wide = RandomArray<TypeParam>({11, 12});
+  NDArray Aw = wide.View({Range(), Range(0, 12, 2)});
+  {
+    auto src = static_cast<const NDArray&>(A).AsMatrix<TypeParam>();
+    auto dst = Aw.AsMatrix<TypeParam>();
+    for (size_t i = 0; i < 11; ++i) {
+      for (size_t k = 0; k < 6; ++k) {
+        dst(i, k) = src(i, k);
+      }
+    }
+  }
+  NDArray Cw;
+  LA::Gemm(Aw, TType::kNoTranspose, TypeParam(1.0),
+           B, TType::kNoTranspose, TypeParam(0.0), &Cw);
+  check(Cw, TypeParam(0.0));
+  // Accumulate in place into a block of a larger array and into a
+  // transposed view
+  NDArray big(FaceKit::DataTypeToEnum<TypeParam>::v(), {15, 10});
+  for (size_t i = 0; i < big.n_elems(); ++i) {
+    big.AsFlat<TypeParam>()(i) = TypeParam(1.0);
+  }
+  NDArray block = big.View({Range(2, 13), Range(1, 9)});
+  LA::Gemm(A, TType::kNoTranspose, TypeParam(1.0),
+           B, TType::kNoTranspose, TypeParam(1.0), &block);
+  check(block, TypeParam(1.0));
+  auto mbig = static_cast<const NDArray&>(big).AsMatrix<TypeParam>();
+  EXPECT_NEAR(mbig(2, 1), gt[0] + TypeParam(1.0), thr);
+  EXPECT_EQ(mbig(0, 0), TypeParam(1.0));
+  NDArray store(FaceKit::DataTypeToEnum<TypeParam>::v(), {8, 11});
+  NDArray Cv = store.Transpose();
+  LA::Gemm(A, TType::kNoTranspose, TypeParam(1.0),
+           B, TType::kNoTranspose, TypeParam(0.0), &Cv);
+  check(Cv, TypeParam(0.0));
+  auto mstore = static_cast<const NDArray&>(store).AsMatrix<TypeParam>();
+  EXPECT_NEAR(mstore(7, 10), gt[10 * 8 + 7], thr);
+}
+
 #pragma mark -
 #pragma mark LAPACK
 
@@ -483,6 +819,185 @@ TYPED_TEST(LinearAlgebraUnitTest, SquareLinearSystem) {
   EXPECT_LE(diff, thr);
 }
 
+TYPED_TEST(LinearAlgebraUnitTest, SquareLinearSystemFactored) {
+  using SqLinSolver = typename FaceKit::LinearAlgebra<TypeParam>::SquareLinearSolver;
+  cv::Mat A(32, 32, cv::DataType<TypeParam>::type);
+  cv::Mat x(32, 3, cv::DataType<TypeParam>::type);
+  cv::theRNG().state = static_cast<uint64_t>(cv::getTickCount());
+  cv::randn(A, TypeParam(0.0), TypeParam(5.0));
+  cv::randn(x, TypeParam(0.0), TypeParam(5.0));
+  cv::Mat y = A * x;
+  // No factorization yet
+  SqLinSolver solver;
+  cv::Mat xhat;
+  EXPECT_FALSE(solver.SolveFactored(y, &xhat).Good());
+  // Factorize once, solve for each column then all of them
+  ASSERT_TRUE(solver.Factorize(A).Good());
+  TypeParam thr = sizeof(TypeParam) == 4 ? 1e-4 : 1e-12;
+  for (int i = 0; i < x.cols; ++i) {
+    EXPECT_TRUE(solver.SolveFactored(y.col(i), &xhat).Good());
+    TypeParam diff = (TypeParam)cv::norm(xhat - x.col(i)) / TypeParam(32.0);
+    EXPECT_LE(diff, thr);
+  }
+  EXPECT_TRUE(solver.SolveFactored(y, &xhat).Good());
+  TypeParam diff = (TypeParam)cv::norm(xhat - x) / (TypeParam)x.total();
+  EXPECT_LE(diff, thr);
+  // Dimensions mismatch
+  EXPECT_FALSE(solver.SolveFactored(y.rowRange(0, 10), &xhat).Good());
+  // Singular
+  cv::Mat S = cv::Mat::zeros(32, 32, cv::DataType<TypeParam>::type);
+  EXPECT_FALSE(solver.Factorize(S).Good());
+}
+
+TYPED_TEST(LinearAlgebraUnitTest, CholeskyLinearSystem) {
+  using CholSolver = typename FaceKit::LinearAlgebra<TypeParam>::CholeskySolver;
+  // Normal equations J'J x = J'r
+  cv::Mat J(120, 24, cv::DataType<TypeParam>::type);
+  cv::Mat x(24, 1, cv::DataType<TypeParam>::type);
+  cv::theRNG().state = static_cast<uint64_t>(cv::getTickCount());
+  cv::randn(J, TypeParam(0.0), TypeParam(1.0));
+  cv::randn(x, TypeParam(0.0), TypeParam(5.0));
+  cv::Mat A = J.t() * J;
+  cv::Mat y = A * x;
+  TypeParam thr = sizeof(TypeParam) == 4 ? 1e-3 : 1e-10;
+  // Solve, several times with the same dimensions
+  CholSolver solver;
+  cv::Mat xhat;
+  for (int k = 0; k < 3; ++k) {
+    solver.Solve(A, y, &xhat);
+    ASSERT_FALSE(xhat.empty());
+    TypeParam diff = (TypeParam)cv::norm(xhat - x) / (TypeParam)x.total();
+    EXPECT_LE(diff, thr);
+  }
+  // Reuse the factorization for another right hand side
+  cv::Mat x2(24, 2, cv::DataType<TypeParam>::type);
+  cv::randn(x2, TypeParam(0.0), TypeParam(5.0));
+  cv::Mat y2 = A * x2;
+  EXPECT_TRUE(solver.SolveFactored(y2, &xhat).Good());
+  TypeParam diff = (TypeParam)cv::norm(xhat - x2) / (TypeParam)x2.total();
+  EXPECT_LE(diff, thr);
+  // Not positive definite
+  cv::Mat N = -A;
+  EXPECT_FALSE(solver.Factorize(N).Good());
+  EXPECT_FALSE(solver.SolveFactored(y, &xhat).Good());
+  solver.Solve(N, y, &xhat);
+  EXPECT_TRUE(xhat.empty());
+}
+
+#pragma mark Decompositions
+
+TYPED_TEST(LinearAlgebraUnitTest, QRDecomposition) {
+  using QR = typename FaceKit::LinearAlgebra<TypeParam>::QR;
+  cv::Mat A(57, 13, cv::DataType<TypeParam>::type);
+  cv::theRNG().state = static_cast<uint64_t>(cv::getTickCount());
+  cv::randn(A, TypeParam(0.0), TypeParam(1.0));
+  QR qr;
+  cv::Mat Q, R;
+  TypeParam thr = sizeof(TypeParam) == 4 ? 1e-4 : 1e-12;
+  // Twice to go through the cached workspace
+  for (int k = 0; k < 2; ++k) {
+    ASSERT_TRUE(qr.Compute(A, &Q, &R).Good());
+    ASSERT_EQ(Q.rows, 57);
+    ASSERT_EQ(Q.cols, 13);
+    cv::Mat I = cv::Mat::eye(13, 13, cv::DataType<TypeParam>::type);
+    EXPECT_LE((TypeParam)cv::norm(Q.t() * Q - I) / TypeParam(I.total()), thr);
+    EXPECT_LE((TypeParam)cv::norm(Q * R - A) / TypeParam(A.total()), thr);
+    EXPECT_EQ(cv::countNonZero(R.colRange(0, 1).rowRange(1, 13)), 0);
+  }
+  // More columns than rows
+  EXPECT_FALSE(qr.Compute(A.t(), &Q, &R).Good());
+}
+
+TYPED_TEST(LinearAlgebraUnitTest, SVDDecomposition) {
+  using SVD = typename FaceKit::LinearAlgebra<TypeParam>::SVD;
+  cv::Mat A(43, 17, cv::DataType<TypeParam>::type);
+  cv::theRNG().state = static_cast<uint64_t>(cv::getTickCount());
+  cv::randn(A, TypeParam(0.0), TypeParam(1.0));
+  SVD svd;
+  cv::Mat U, S, Vt;
+  TypeParam thr = sizeof(TypeParam) == 4 ? 1e-4 : 1e-12;
+  // Tall and wide
+  for (int k = 0; k < 2; ++k) {
+    cv::Mat X = k == 0 ? A : cv::Mat(A.t());
+    ASSERT_TRUE(svd.Compute(X, &U, &S, &Vt).Good());
+    ASSERT_EQ(U.rows, X.rows);
+    ASSERT_EQ(U.cols, 17);
+    ASSERT_EQ(S.rows, 17);
+    ASSERT_EQ(Vt.rows, 17);
+    ASSERT_EQ(Vt.cols, X.cols);
+    for (int i = 1; i < S.rows; ++i) {
+      EXPECT_GE(S.at<TypeParam>(i - 1), S.at<TypeParam>(i));
+    }
+    cv::Mat Xhat = U * cv::Mat::diag(S) * Vt;
+    EXPECT_LE((TypeParam)cv::norm(Xhat - X) / TypeParam(X.total()), thr);
+  }
+}
+
+TYPED_TEST(LinearAlgebraUnitTest, TruncatedSVD) {
+  using SVD = typename FaceKit::LinearAlgebra<TypeParam>::SVD;
+  // Tall matrix with a decaying spectrum
+  const int m = 300, n = 40;
+  cv::Mat L(m, n, cv::DataType<TypeParam>::type);
+  cv::Mat R(n, n, cv::DataType<TypeParam>::type);
+  cv::theRNG().state = static_cast<uint64_t>(cv::getTickCount());
+  cv::randn(L, TypeParam(0.0), TypeParam(1.0));
+  cv::randn(R, TypeParam(0.0), TypeParam(1.0));
+  cv::Mat D = cv::Mat::zeros(n, n, cv::DataType<TypeParam>::type);
+  for (int i = 0; i < n; ++i) {
+    D.at<TypeParam>(i, i) = std::pow(TypeParam(0.5), TypeParam(i));
+  }
+  cv::Mat A = L * D * R;
+  SVD svd;
+  cv::Mat U, S, Vt, Ut, St, Vtt;
+  ASSERT_TRUE(svd.Compute(A, &U, &S, &Vt).Good());
+  ASSERT_TRUE(svd.Truncated(A, 6, 6, 2, &Ut, &St, &Vtt).Good());
+  ASSERT_EQ(Ut.rows, m);
+  ASSERT_EQ(Ut.cols, 6);
+  ASSERT_EQ(St.rows, 6);
+  ASSERT_EQ(Vtt.rows, 6);
+  ASSERT_EQ(Vtt.cols, n);
+  TypeParam thr = sizeof(TypeParam) == 4 ? 1e-3 : 1e-8;
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_NEAR(St.at<TypeParam>(i) / S.at<TypeParam>(i), TypeParam(1.0), thr);
+    // Same subspace, up to the sign
+    TypeParam d = (TypeParam)std::abs(Ut.col(i).dot(U.col(i)));
+    EXPECT_NEAR(d, TypeParam(1.0), thr);
+  }
+  // Invalid rank
+  EXPECT_FALSE(svd.Truncated(A, 0, 6, 2, &Ut, &St, &Vtt).Good());
+  EXPECT_FALSE(svd.Truncated(A, n + 1, 6, 2, &Ut, &St, &Vtt).Good());
+}
+
+TYPED_TEST(LinearAlgebraUnitTest, SymmetricEigenDecomposition) {
+  using Eigen = typename FaceKit::LinearAlgebra<TypeParam>::SymmetricEigen;
+  cv::Mat X(80, 21, cv::DataType<TypeParam>::type);
+  cv::theRNG().state = static_cast<uint64_t>(cv::getTickCount());
+  cv::randn(X, TypeParam(0.0), TypeParam(1.0));
+  cv::Mat C = X.t() * X;
+  Eigen eig;
+  cv::Mat values, vectors, gt_values, gt_vectors;
+  ASSERT_TRUE(eig.Compute(C, &values, &vectors).Good());
+  cv::eigen(C, gt_values, gt_vectors);
+  TypeParam thr = sizeof(TypeParam) == 4 ? 1e-3 : 1e-10;
+  ASSERT_EQ(values.rows, 21);
+  ASSERT_EQ(vectors.rows, 21);
+  for (int i = 0; i < 21; ++i) {
+    EXPECT_NEAR(values.at<TypeParam>(i) / gt_values.at<TypeParam>(i),
+                TypeParam(1.0),
+                thr);
+    // C v = lambda v
+    cv::Mat v = vectors.row(i).t();
+    cv::Mat r = C * v - values.at<TypeParam>(i) * v;
+    EXPECT_LE((TypeParam)cv::norm(r) / values.at<TypeParam>(i), thr);
+  }
+  // Eigenvalues only
+  cv::Mat values_only;
+  ASSERT_TRUE(eig.Compute(C, &values_only, nullptr).Good());
+  EXPECT_LE((TypeParam)cv::norm(values_only - values) / TypeParam(21.0), thr);
+  // Not square
+  EXPECT_FALSE(eig.Compute(X, &values, &vectors).Good());
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,129 @@
+/**
+ *  @file   ut_log_sink.cpp
+ *  @brief Unit test for structured log sinks
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   05.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/log_sink.hpp"
+#include "facekit/core/logger.hpp"
+
+namespace FK = FaceKit;
+
+/** Build a record */
+static FK::Logger::Record MakeRecord(const FK::Logger::Level& level,
+                                     const std::string& msg) {
+  FK::Logger::Record rec;
+  rec.level = level;
+  rec.timestamp = 123456789;
+  rec.thread_id = 42;
+  rec.file = "dir/file.cpp";
+  rec.line = 17;
+  rec.message = msg;
+  return rec;
+}
+
+/** Size of a file in bytes, 0 if missing */
+static size_t FileSize(const std::string& path) {
+  std::ifstream f(path.c_str(), std::ios_base::binary | std::ios_base::ate);
+  return f.is_open() ? static_cast<size_t>(f.tellg()) : 0;
+}
+
+TEST(LogSink, Json) {
+  std::ostringstream stream;
+  FK::JsonLogSink sink(stream);
+  sink.Write(MakeRecord(FK::Logger::kInfo, "say \"hi\"\n\tnow"));
+  EXPECT_EQ(stream.str(), "{\"level\":\"INFO\",\"ts\":123456789,\"tid\":42,"
+                          "\"file\":\"dir/file.cpp\",\"line\":17,"
+                          "\"msg\":\"say \\\"hi\\\"\\n\\tnow\"}\n");
+}
+
+TEST(LogSink, BinaryRoundTrip) {
+  std::stringstream stream;
+  FK::BinaryLogSink sink(stream);
+  sink.Write(MakeRecord(FK::Logger::kWarning, "first"));
+  sink.Write(MakeRecord(FK::Logger::kDebug2, std::string("a\0b", 3)));
+  FK::Logger::Record rec;
+  std::string file;
+  ASSERT_TRUE(FK::BinaryLogSink::Decode(stream, &rec, &file));
+  EXPECT_EQ(rec.level, FK::Logger::kWarning);
+  EXPECT_EQ(rec.timestamp, 123456789);
+  EXPECT_EQ(rec.thread_id, 42u);
+  EXPECT_EQ(std::string(rec.file), "dir/file.cpp");
+  EXPECT_EQ(rec.line, 17);
+  EXPECT_EQ(rec.message, "first");
+  ASSERT_TRUE(FK::BinaryLogSink::Decode(stream, &rec, &file));
+  EXPECT_EQ(rec.level, FK::Logger::kDebug2);
+  EXPECT_EQ(rec.message, std::string("a\0b", 3));
+  EXPECT_FALSE(FK::BinaryLogSink::Decode(stream, &rec, &file));
+}
+
+TEST(LogSink, Logger) {
+  std::ostringstream stream;
+  auto& logger = FK::Logger::Instance();
+  logger.Enable();
+  logger.set_log_level(FK::Logger::Level::kInfo);
+  logger.set_sink(std::make_shared<FK::JsonLogSink>(stream));
+  FACEKIT_LOG_INFO("Structured " << 3);
+  FACEKIT_LOG_DEBUG("Filtered out");
+  logger.set_sink(nullptr);
+  const std::string str = stream.str();
+  EXPECT_NE(str.find("\"level\":\"INFO\""), std::string::npos);
+  EXPECT_NE(str.find("\"msg\":\"Structured 3\""), std::string::npos);
+  EXPECT_NE(str.find("ut_log_sink.cpp"), std::string::npos);
+  EXPECT_EQ(str.find("Filtered out"), std::string::npos);
+  logger.Disable();
+}
+
+TEST(LogSink, RotatingFile) {
+  const std::string path = "ut_log_sink.log";
+  for (const auto& p : {path, path + ".1", path + ".2", path + ".3"}) {
+    std::remove(p.c_str());
+  }
+  const size_t max_size = 256;
+  {
+    using Format = FK::RotatingFileLogSink::Format;
+    FK::RotatingFileLogSink sink(path, max_size, 2, Format::kText);
+    ASSERT_TRUE(sink.is_open());
+    for (int i = 0; i < 100; ++i) {
+      sink.Write(MakeRecord(FK::Logger::kInfo,
+                            "Message number " + std::to_string(i)));
+    }
+    sink.Flush();
+  }
+  // Active file and two rotated files, each below the limit
+  EXPECT_GT(FileSize(path), 0u);
+  EXPECT_LE(FileSize(path), max_size);
+  EXPECT_GT(FileSize(path + ".1"), 0u);
+  EXPECT_LE(FileSize(path + ".1"), max_size);
+  EXPECT_GT(FileSize(path + ".2"), 0u);
+  EXPECT_EQ(FileSize(path + ".3"), 0u);
+  // Last message in the active file
+  std::ifstream f(path.c_str());
+  std::string content((std::istreambuf_iterator<char>(f)),
+                      std::istreambuf_iterator<char>());
+  EXPECT_NE(content.find("Message number 99"), std::string::npos);
+  for (const auto& p : {path, path + ".1", path + ".2"}) {
+    std::remove(p.c_str());
+  }
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Disable logger
+  FaceKit::Logger::Instance().Disable();
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
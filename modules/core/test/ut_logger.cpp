@@ -7,7 +7,10 @@
  *  Copyright (c) 2016 Christophe Ecabert. All rights reserved.
  */
 
+#include <cstdio>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -157,6 +160,100 @@ TEST(Logger, LoggerFilter) {
   EXPECT_EQ(log_part[3], " \tThis is level 1\n");
 }
 
+/** Count evaluations */
+static int EvalCounter(int* counter) {
+  *counter += 1;
+  return *counter;
+}
+
+TEST(Logger, LoggerLazyEvaluation) {
+  stream.str("");
+  int counter = 0;
+  FaceKit::Logger::Instance().set_log_level(FaceKit::Logger::Level::kInfo);
+  // Filtered level, argument not evaluated
+  FACEKIT_LOG_DEBUG("Value " << EvalCounter(&counter));
+  EXPECT_EQ(counter, 0);
+  EXPECT_TRUE(stream.str().empty());
+  // Disabled logger, argument not evaluated
+  FaceKit::Logger::Instance().Disable();
+  FACEKIT_LOG_ERROR("Value " << EvalCounter(&counter));
+  EXPECT_EQ(counter, 0);
+  FaceKit::Logger::Instance().Enable();
+  // Active level
+  FACEKIT_LOG_INFO("Value " << EvalCounter(&counter));
+  EXPECT_EQ(counter, 1);
+  EXPECT_FALSE(stream.str().empty());
+}
+
+TEST(Logger, LoggerAsync) {
+  stream.str("");
+  auto& logger = FaceKit::Logger::Instance();
+  logger.set_log_level(FaceKit::Logger::Level::kInfo);
+  logger.set_async(true);
+  EXPECT_TRUE(logger.is_async());
+  // Log from several threads
+  const int n_thread = 4;
+  const int n_msg = 500;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < n_thread; ++t) {
+    threads.emplace_back([t]() {
+      for (int i = 0; i < n_msg; ++i) {
+        FACEKIT_LOG_INFO("Thread " << t << " message " << i);
+      }
+    });
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  logger.Flush();
+  // Every line is complete and per-thread order is kept
+  std::vector<std::string> lines;
+  FaceKit::String::Split(stream.str(), "\n", &lines);
+  lines.pop_back();  // Empty part after last newline
+  EXPECT_EQ(lines.size(), n_thread * n_msg);
+  std::vector<int> next(n_thread, 0);
+  for (const auto& l : lines) {
+    int t = -1, i = -1;
+    const size_t pos = l.find("Thread ");
+    ASSERT_NE(pos, std::string::npos);
+    ASSERT_EQ(std::sscanf(l.c_str() + pos, "Thread %d message %d", &t, &i), 2);
+    ASSERT_TRUE(t >= 0 && t < n_thread);
+    EXPECT_EQ(i, next[t]);
+    next[t] = i + 1;
+  }
+  // Back to synchronous
+  logger.set_async(false);
+  EXPECT_FALSE(logger.is_async());
+}
+
+TEST(Logger, LoggerAsyncDrop) {
+  stream.str("");
+  auto& logger = FaceKit::Logger::Instance();
+  logger.set_log_level(FaceKit::Logger::Level::kInfo);
+  logger.set_queue_capacity(4);
+  logger.set_drop_policy(FaceKit::Logger::DropPolicy::kDrop);
+  logger.set_async(true);
+  const size_t dropped = logger.get_n_dropped();
+  const int n_msg = 2000;
+  std::thread th([]() {
+    for (int i = 0; i < n_msg; ++i) {
+      FACEKIT_LOG_INFO("Burst " << i);
+    }
+  });
+  th.join();
+  logger.set_async(false);
+  // Everything is either written or accounted as dropped
+  std::vector<std::string> lines;
+  FaceKit::String::Split(stream.str(), "\n", &lines);
+  size_t n_written = 0;
+  for (const auto& l : lines) {
+    n_written += l.find("Burst ") != std::string::npos ? 1 : 0;
+  }
+  EXPECT_EQ(n_written + (logger.get_n_dropped() - dropped), n_msg);
+  logger.set_drop_policy(FaceKit::Logger::DropPolicy::kBlock);
+  logger.set_queue_capacity(FaceKit::Logger::kDefaultQueueCapacity);
+}
+
 int main(int argc, char* argv[]) {
   // Create stringstream + Init log
   FaceKit::Logger::Instance(stream);  
@@ -0,0 +1,158 @@
+/**
+ *  @file   ut_memory_budget.cpp
+ *  @brief Unit test for memory budget
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/mem/memory_budget.hpp"
+#include "facekit/core/thread_pool.hpp"
+
+namespace FK = FaceKit;
+
+TEST(MemoryBudget, Unlimited) {
+  FK::MemoryBudget budget;
+  FK::MemoryBudget::Token a, b;
+  budget.Acquire(size_t(1) << 40, &a);
+  EXPECT_TRUE(budget.TryAcquire(size_t(1) << 40, &b));
+  EXPECT_EQ(budget.reserved(), size_t(2) << 40);
+  EXPECT_FALSE(budget.exhausted());
+  a.Release();
+  b.Release();
+  EXPECT_EQ(budget.reserved(), 0);
+  EXPECT_EQ(budget.peak(), size_t(2) << 40);
+  EXPECT_EQ(budget.n_wait(), 0);
+}
+
+TEST(MemoryBudget, TryAcquire) {
+  FK::MemoryBudget budget(100);
+  FK::MemoryBudget::Token a, b;
+  EXPECT_TRUE(budget.TryAcquire(60, &a));
+  EXPECT_FALSE(budget.TryAcquire(60, &b));
+  EXPECT_FALSE(b);
+  EXPECT_TRUE(budget.TryAcquire(40, &b));
+  EXPECT_TRUE(budget.exhausted());
+  // Bytes held by the token itself are available to it
+  EXPECT_TRUE(budget.TryAcquire(30, &b));
+  EXPECT_EQ(budget.reserved(), 90);
+  EXPECT_FALSE(budget.TryAcquire(50, &b));
+  EXPECT_EQ(b.bytes(), 30);
+  a.Release();
+  EXPECT_EQ(budget.reserved(), 30);
+}
+
+TEST(MemoryBudget, Oversize) {
+  FK::MemoryBudget budget(100);
+  FK::MemoryBudget::Token a, b;
+  // Granted alone, never blocks for ever
+  budget.Acquire(1000, &a);
+  EXPECT_EQ(a.bytes(), 1000);
+  EXPECT_FALSE(budget.TryAcquire(1, &b));
+}
+
+TEST(MemoryBudget, ResizeAndCharge) {
+  FK::MemoryBudget budget(100);
+  FK::MemoryBudget::Token a, b;
+  budget.Acquire(10, &a);
+  a.Resize(90);
+  budget.Charge(50, &b);
+  EXPECT_EQ(budget.reserved(), 140);
+  EXPECT_TRUE(budget.exhausted());
+  a.Resize(20);
+  EXPECT_EQ(budget.reserved(), 70);
+  // Moved tokens give their bytes back once
+  FK::MemoryBudget::Token c(std::move(a));
+  EXPECT_FALSE(a);
+  b = std::move(c);
+  EXPECT_EQ(budget.reserved(), 20);
+  b.Release();
+  EXPECT_EQ(budget.reserved(), 0);
+}
+
+TEST(MemoryBudget, Backpressure) {
+  FK::MemoryBudget budget(100);
+  std::atomic<size_t> max_used(0);
+  std::atomic<size_t> n_done(0);
+  std::vector<std::thread> producers;
+  for (int t = 0; t < 4; ++t) {
+    producers.emplace_back([&](void) {
+      for (int k = 0; k < 50; ++k) {
+        FK::MemoryBudget::Token token;
+        budget.Acquire(30, &token);
+        size_t used = budget.reserved();
+        size_t prev = max_used.load();
+        while (used > prev && !max_used.compare_exchange_weak(prev, used)) {
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        n_done += 1;
+      }
+    });
+  }
+  for (auto& p : producers) {
+    p.join();
+  }
+  EXPECT_EQ(n_done.load(), 200);
+  EXPECT_LE(max_used.load(), 100);
+  EXPECT_EQ(budget.reserved(), 0);
+}
+
+TEST(MemoryBudget, BlockUntilRelease) {
+  FK::MemoryBudget budget(100);
+  FK::MemoryBudget::Token a;
+  budget.Acquire(80, &a);
+  std::atomic<bool> granted(false);
+  std::thread producer([&](void) {
+    FK::MemoryBudget::Token b;
+    budget.Acquire(50, &b);
+    granted = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(granted.load());
+  budget.set_limit(200);
+  producer.join();
+  EXPECT_TRUE(granted.load());
+  EXPECT_EQ(budget.n_wait(), 1);
+}
+
+TEST(MemoryBudget, HelpPool) {
+  // Single worker busy, the token is released by a task queued behind
+  FK::ThreadPool pool(1);
+  FK::MemoryBudget budget(100);
+  FK::MemoryBudget::Token a, b;
+  budget.Acquire(80, &a);
+  std::atomic<bool> started(false);
+  std::atomic<bool> go(false);
+  pool.Submit(FK::ThreadPool::TaskPriority::kNormal, [&](void) {
+    started = true;
+    while (!go.load()) {
+      std::this_thread::yield();
+    }
+  });
+  pool.Submit(FK::ThreadPool::TaskPriority::kNormal, [&](void) {
+    a.Release();
+  });
+  while (!started.load()) {
+    std::this_thread::yield();
+  }
+  budget.Acquire(50, &pool, &b);
+  go = true;
+  EXPECT_EQ(b.bytes(), 50);
+  EXPECT_EQ(budget.reserved(), 50);
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
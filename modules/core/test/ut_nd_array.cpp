@@ -10,9 +10,13 @@
 
 #include <string>
 #include <vector>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
 
 #include "gtest/gtest.h"
 
+#include "google/protobuf/arena.h"
 #include "nd_array.pb.h"
 
 #include "facekit/core/nd_array.hpp"
@@ -373,6 +377,57 @@ TYPED_TEST(NDArrayTest, ShareBuffer) {
   EXPECT_FALSE(b1.ShareBuffer(a2));
 }
 
+TEST(NDArrayTest, CopyOnWrite) {
+  namespace FK = FaceKit;
+  auto a = FK::NDArray::WithValues<int32_t>({1, 2, 3, 4, 5, 6}, {3, 2});
+  // Copies share the buffer until written
+  FK::NDArray b = a;
+  FK::NDArray c;
+  c = a;
+  const FK::NDArray& cb = b;
+  EXPECT_EQ(cb.AsFlat<int32_t>()(0), 1);
+  EXPECT_TRUE(b.ShareBuffer(a));
+  EXPECT_TRUE(c.ShareBuffer(a));
+  // Write clones only the writer
+  b.AsFlat<int32_t>()(0) = -1;
+  EXPECT_FALSE(b.ShareBuffer(a));
+  EXPECT_TRUE(c.ShareBuffer(a));
+  EXPECT_EQ(a.AsFlat<int32_t>()(0), 1);
+  EXPECT_EQ(b.AsFlat<int32_t>()(0), -1);
+  EXPECT_EQ(b.AsFlat<int32_t>()(5), 6);
+  // Sole owner writes in place
+  const int32_t* data = b.AsFlat<int32_t>().data();
+  b.AsMatrix<int32_t>()(2, 1) = -6;
+  EXPECT_EQ(b.AsFlat<int32_t>().data(), data);
+  // Views alias their parent, writes go through
+  FK::NDArray d = a;
+  d.AsFlat<int32_t>()(0) = 0;
+  FK::NDArray row = d.Slice(1, 2);
+  row.AsMatrix<int32_t>()(0, 1) = 40;
+  FK::NDArray col = d.Select(1, 0);
+  col.AsVector<int32_t>()(2) = 50;
+  FK::NDArray all = d.Slice(0, 3);
+  all.AsMatrix<int32_t>()(0, 1) = 20;
+  EXPECT_EQ(d.AsMatrix<int32_t>()(0, 0), 0);
+  EXPECT_EQ(d.AsMatrix<int32_t>()(0, 1), 20);
+  EXPECT_EQ(d.AsMatrix<int32_t>()(1, 1), 40);
+  EXPECT_EQ(d.AsMatrix<int32_t>()(2, 0), 50);
+  EXPECT_EQ(a.AsMatrix<int32_t>()(1, 1), 4);
+  // Copy of a strided view becomes contiguous when written
+  FK::NDArray cc = col;
+  cc.AsVector<int32_t>()(0) = 7;
+  EXPECT_TRUE(cc.IsContiguous());
+  EXPECT_EQ(cc.AsVector<int32_t>()(1), 3);
+  EXPECT_EQ(cc.AsVector<int32_t>()(2), 50);
+  EXPECT_EQ(d.AsMatrix<int32_t>()(0, 0), 0);
+  // Resize does not touch the other owners
+  FK::NDArray e = a;
+  e.Resize(FK::DataType::kInt32, {2, 3});
+  EXPECT_FALSE(e.ShareBuffer(a));
+  EXPECT_EQ(e.dim_size(0), 2);
+  EXPECT_EQ(a.dim_size(0), 3);
+}
+
 TYPED_TEST(NDArrayTest, Slice) {
   namespace FK = FaceKit;
   using T = TypeParam;
@@ -392,6 +447,120 @@ TYPED_TEST(NDArrayTest, Slice) {
   EXPECT_EQ(map(0, 1), values[3]);
 }
 
+TEST(NDArrayTest, StridedView) {
+  namespace FK = FaceKit;
+  // 4 x 3 x 2 array, value = 100 * i + 10 * j + k
+  FK::NDArray array(FK::DataType::kInt32, {4, 3, 2});
+  auto map = array.AsNDArray<int32_t, 3>();
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      for (size_t k = 0; k < 2; ++k) {
+        map(i, j, k) = int32_t(100 * i + 10 * j + k);
+      }
+    }
+  }
+  // Multi-axis range with step
+  FK::NDArray view = array.View({{1, 4, 2}, {1, FK::NDArray::kAll}});
+  EXPECT_FALSE(view.IsContiguous());
+  EXPECT_EQ(view.dim_size(0), 2);
+  EXPECT_EQ(view.dim_size(1), 2);
+  EXPECT_EQ(view.dim_size(2), 2);
+  auto vmap = view.AsNDArray<int32_t, 3>();
+  EXPECT_EQ(vmap(0, 0, 0), 110);
+  EXPECT_EQ(vmap(1, 1, 1), 321);
+  // Write through the view
+  vmap(1, 0, 1) = -1;
+  EXPECT_EQ(map(3, 1, 1), -1);
+  // Select channel
+  FK::NDArray channel = array.Select(2, 1);
+  EXPECT_EQ(channel.dims(), 2);
+  EXPECT_EQ(channel.AsMatrix<int32_t>()(2, 2), 221);
+  EXPECT_EQ(channel.strides()[0], 6);
+  EXPECT_EQ(channel.strides()[1], 2);
+  // Transpose
+  FK::NDArray mat = array.Select(2, 0);
+  FK::NDArray tr = mat.Transpose();
+  EXPECT_EQ(tr.dim_size(0), 3);
+  EXPECT_EQ(tr.dim_size(1), 4);
+  EXPECT_EQ(tr.AsMatrix<int32_t>()(2, 1), 120);
+  // Permute
+  FK::NDArray perm = array.Permute({2, 0, 1});
+  EXPECT_EQ(perm.dim_size(0), 2);
+  auto pmap = perm.AsNDArray<int32_t, 3>();
+  EXPECT_EQ(pmap(1, 2, 0), 201);
+  // Deep copy is contiguous
+  FK::NDArray copy;
+  tr.DeepCopy(&copy);
+  EXPECT_TRUE(copy.IsContiguous());
+  auto flat = copy.AsFlat<int32_t>();
+  EXPECT_EQ(flat(0), 0);
+  EXPECT_EQ(flat(1), 100);
+  EXPECT_EQ(flat(4), 10);
+  // Slice of a view
+  FK::NDArray rows = tr.Slice(1, 3);
+  EXPECT_EQ(rows.AsMatrix<int32_t>()(1, 3), 320);
+  // Contiguous outer range stays contiguous
+  EXPECT_TRUE(array.View({{1, 3}}).IsContiguous());
+  // Serialization of a view
+  FaceKit::NDArrayProto proto;
+  channel.ToProto(&proto);
+  FK::NDArray restored;
+  ASSERT_TRUE(restored.FromProto(proto).Good());
+  EXPECT_EQ(restored.AsFlat<int32_t>()(5), 121);
+}
+
+TEST(NDArrayTest, MapFile) {
+  namespace FK = FaceKit;
+  // Write raw file with a small header
+  const std::string path = "ut_nd_array_map.bin";
+  std::vector<float> values(6000);
+  for (size_t k = 0; k < values.size(); ++k) {
+    values[k] = static_cast<float>(k) * 0.5f;
+  }
+  {
+    std::ofstream stream(path, std::ios::binary);
+    const int32_t header = 42;
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(values.data()),
+                 values.size() * sizeof(float));
+  }
+  // Read-only
+  {
+    FK::NDArray array;
+    auto s = array.MapFile(path, FK::DataType::kFloat, {3000, 2}, 4);
+    ASSERT_TRUE(s.Good());
+    EXPECT_TRUE(array.IsInitialized());
+    EXPECT_EQ(array.dim_size(0), 3000);
+    auto map = array.AsFlat<float>();
+    for (size_t k = 0; k < values.size(); ++k) {
+      EXPECT_EQ(map(k), values[k]);
+    }
+    // Slices share the mapping
+    FK::NDArray slice = array.Slice(1000, 1001);
+    EXPECT_EQ(slice.AsFlat<float>()(1), values[2001]);
+  }
+  // Copy-on-write, file is left untouched
+  {
+    FK::NDArray array;
+    auto s = array.MapFile(path, FK::DataType::kFloat, {6000}, 4,
+                           FK::NDArray::MapMode::kCopyOnWrite);
+    ASSERT_TRUE(s.Good());
+    array.AsFlat<float>()(0) = -1.f;
+    FK::NDArray other;
+    ASSERT_TRUE(other.MapFile(path, FK::DataType::kFloat, {6000}, 4).Good());
+    EXPECT_EQ(array.AsFlat<float>()(0), -1.f);
+    EXPECT_EQ(other.AsFlat<float>()(0), values[0]);
+  }
+  // Errors
+  FK::NDArray array;
+  EXPECT_FALSE(array.MapFile(path, FK::DataType::kString, {10}).Good());
+  EXPECT_FALSE(array.MapFile(path, FK::DataType::kFloat, {10}, 2).Good());
+  EXPECT_FALSE(array.MapFile(path, FK::DataType::kFloat, {6001}, 4).Good());
+  EXPECT_FALSE(array.MapFile("missing.bin", FK::DataType::kFloat, {1}).Good());
+  EXPECT_FALSE(array.IsInitialized());
+  std::remove(path.c_str());
+}
+
 TEST(NDArrayTest, ProtoUtils) {
   namespace FK = FaceKit;
 
@@ -512,6 +681,121 @@ TYPED_TEST(NDArrayTest, Proto) {
   ArrayComparator<T, CompType::kEqual>::Compare(array, p_array);
 }
 
+TEST(NDArrayTest, ProtoArena) {
+  namespace FK = FaceKit;
+  FK::NDArray array(FK::DataType::kFloat, {64, 8});
+  auto map = array.AsFlat<float>();
+  for (size_t k = 0; k < map.size(); ++k) {
+    map(k) = static_cast<float>(k) * 0.5f;
+  }
+  FK::NDArray strings(FK::DataType::kString, {2});
+  strings.AsFlat<std::string>()(0) = "face";
+  strings.AsFlat<std::string>()(1) = "kit";
+  // Several messages on the same arena
+  google::protobuf::Arena arena;
+  FK::NDArrayProto* p_array = array.ToProto(&arena);
+  FK::NDArrayProto* p_strings = strings.ToProto(&arena);
+  EXPECT_EQ(p_array->GetArena(), &arena);
+  EXPECT_EQ(p_strings->GetArena(), &arena);
+  // Payload is taken over
+  FK::NDArray res;
+  const char* bytes = p_array->data().data();
+  ASSERT_TRUE(res.FromProto(p_array).Good());
+  EXPECT_TRUE(p_array->data().empty());
+  EXPECT_EQ(reinterpret_cast<const char*>(res.AsFlat<float>().data()), bytes);
+  EXPECT_EQ(res.dim_size(0), 64);
+  EXPECT_EQ(res.dim_size(1), 8);
+  EXPECT_TRUE(std::equal(map.data(), map.data() + map.size(),
+                         res.AsFlat<float>().data()));
+  FK::NDArray r_str;
+  ASSERT_TRUE(r_str.FromProto(p_strings).Good());
+  EXPECT_EQ(r_str.AsFlat<std::string>()(0), "face");
+  EXPECT_EQ(r_str.AsFlat<std::string>()(1), "kit");
+  // Heap allocated message, small payload is copied
+  google::protobuf::Arena* heap = nullptr;
+  std::unique_ptr<FK::NDArrayProto> small(array.View({{0, 2}, {0, 8}})
+                                               .ToProto(heap));
+  FK::NDArray r_small;
+  ASSERT_TRUE(r_small.FromProto(small.get()).Good());
+  EXPECT_EQ(r_small.AsMatrix<float>()(1, 7), map(15));
+  // Invalid payload
+  FK::NDArrayProto bad;
+  array.ToProto(&bad);
+  bad.mutable_data()->resize(10);
+  EXPECT_FALSE(res.FromProto(&bad).Good());
+}
+
+TEST(NDArrayTest, Stream) {
+  namespace FK = FaceKit;
+  // Large enough to span several chunks
+  const size_t n = (FK::NDArray::kStreamChunkSize * 5) / (2 * sizeof(float));
+  FK::NDArray array(FK::DataType::kFloat, {n / 4, 4});
+  auto map = array.AsFlat<float>();
+  for (size_t k = 0; k < map.size(); ++k) {
+    map(k) = static_cast<float>(k % 1000) * 0.25f;
+  }
+  std::stringstream stream;
+  ASSERT_TRUE(array.Write(stream).Good());
+  FK::NDArray res;
+  ASSERT_TRUE(res.Read(stream).Good());
+  EXPECT_EQ(res.type(), FK::DataType::kFloat);
+  EXPECT_EQ(res.dim_size(0), n / 4);
+  EXPECT_EQ(res.dim_size(1), 4);
+  EXPECT_TRUE(std::equal(map.data(), map.data() + map.size(),
+                         res.AsFlat<float>().data()));
+  // Several arrays in the same stream, including views and strings
+  FK::NDArray strings(FK::DataType::kString, {3});
+  strings.AsFlat<std::string>()(0) = "face";
+  strings.AsFlat<std::string>()(2) = "kit";
+  FK::NDArray view = array.View({{10, 13}, {1, 3}});
+  std::stringstream multi;
+  ASSERT_TRUE(strings.Write(multi).Good());
+  ASSERT_TRUE(view.Write(multi).Good());
+  FK::NDArray r_str, r_view;
+  ASSERT_TRUE(r_str.Read(multi).Good());
+  ASSERT_TRUE(r_view.Read(multi).Good());
+  EXPECT_EQ(r_str.AsFlat<std::string>()(0), "face");
+  EXPECT_EQ(r_str.AsFlat<std::string>()(1), "");
+  EXPECT_EQ(r_str.AsFlat<std::string>()(2), "kit");
+  EXPECT_TRUE(r_view.IsContiguous());
+  EXPECT_EQ(r_view.dim_size(0), 3);
+  EXPECT_EQ(r_view.dim_size(1), 2);
+  EXPECT_EQ(r_view.AsMatrix<float>()(2, 1), view.AsMatrix<float>()(2, 1));
+  // Truncated stream
+  std::string raw = stream.str();
+  std::stringstream truncated(raw.substr(0, raw.size() / 2));
+  EXPECT_FALSE(res.Read(truncated).Good());
+  EXPECT_EQ(res.dim_size(0), n / 4);
+  // File descriptor
+  const std::string path = "ut_nd_array_stream.bin";
+  FILE* file = std::fopen(path.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  EXPECT_TRUE(view.Write(fileno(file)).Good());
+  std::fclose(file);
+  file = std::fopen(path.c_str(), "rb");
+  ASSERT_NE(file, nullptr);
+  FK::NDArray r_fd;
+  EXPECT_TRUE(r_fd.Read(fileno(file)).Good());
+  std::fclose(file);
+  std::remove(path.c_str());
+  EXPECT_EQ(r_fd.AsMatrix<float>()(1, 0), view.AsMatrix<float>()(1, 0));
+}
+
+TEST(NDArrayTest, AsFixed) {
+  namespace FK = FaceKit;
+  FK::NDArray array(FK::DataType::kFloat, {3, 4, 5});
+  auto flat = array.AsFlat<float>();
+  for (size_t k = 0; k < flat.size(); ++k) {
+    flat(k) = static_cast<float>(k);
+  }
+  auto map = array.AsFixed<float, 3, 4, 5>();
+  EXPECT_EQ(map(2, 1, 3), 48.f);
+  EXPECT_EQ(map.row(1, 2)[4], 34.f);
+  const FK::NDArray& carray = array;
+  auto cmap = carray.AsFixed<float, 3, 4, 5>();
+  EXPECT_EQ(cmap.plane(2)[0], 40.f);
+}
+
 int main(int argc, char* argv[]) {
   // Init gtest framework
   ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,81 @@
+/**
+ *  @file   ut_nd_array_cv.cpp
+ *  @brief Unit test for NDArray / OpenCV interoperability
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   03.03.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include "gtest/gtest.h"
+
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/nd_array.hpp"
+
+TEST(NDArrayCv, AsCvMat) {
+  namespace FK = FaceKit;
+  cv::Mat mat;
+  {
+    FK::NDArray array(FK::DataType::kFloat, {3, 4});
+    auto map = array.AsFlat<float>();
+    for (size_t k = 0; k < map.size(); ++k) {
+      map(k) = static_cast<float>(k);
+    }
+    ASSERT_TRUE(array.AsCvMat(&mat).Good());
+    EXPECT_EQ(mat.rows, 3);
+    EXPECT_EQ(mat.cols, 4);
+    EXPECT_EQ(mat.type(), CV_32FC1);
+    // Same buffer
+    EXPECT_EQ(reinterpret_cast<float*>(mat.data), map.data());
+  }
+  // Buffer still alive through the matrix
+  EXPECT_EQ(mat.at<float>(2, 3), 11.f);
+  // Image like array
+  FK::NDArray image(FK::DataType::kUInt8, {8, 6, 3});
+  cv::Mat img;
+  ASSERT_TRUE(image.AsCvMat(&img).Good());
+  EXPECT_EQ(img.type(), CV_8UC3);
+  EXPECT_EQ(img.cols, 6);
+  // Unsupported type
+  FK::NDArray u64(FK::DataType::kUInt64, {2});
+  EXPECT_FALSE(u64.AsCvMat(&img).Good());
+}
+
+TEST(NDArrayCv, FromCvMat) {
+  namespace FK = FaceKit;
+  FK::NDArray array;
+  {
+    cv::Mat mat(5, 2, CV_64FC1);
+    for (int i = 0; i < mat.rows; ++i) {
+      for (int j = 0; j < mat.cols; ++j) {
+        mat.at<double>(i, j) = i * 10 + j;
+      }
+    }
+    ASSERT_TRUE(array.FromCvMat(mat).Good());
+    EXPECT_EQ(array.dims(), 2);
+    EXPECT_EQ(array.dim_size(0), 5);
+    EXPECT_EQ(array.type(), FK::DataType::kDouble);
+    EXPECT_EQ(array.AsFlat<double>().data(),
+              reinterpret_cast<double*>(mat.data));
+  }
+  // Matrix data still alive through the array
+  EXPECT_EQ(array.AsMatrix<double>()(4, 1), 41.0);
+  // Round trip shares the original buffer
+  cv::Mat mat;
+  ASSERT_TRUE(array.AsCvMat(&mat).Good());
+  FK::NDArray other;
+  ASSERT_TRUE(other.FromCvMat(mat).Good());
+  EXPECT_TRUE(other.ShareBuffer(array));
+  // Non continuous region
+  cv::Mat big(10, 10, CV_32FC1);
+  EXPECT_FALSE(other.FromCvMat(big(cv::Rect(2, 2, 4, 4))).Good());
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
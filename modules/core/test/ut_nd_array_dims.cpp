@@ -104,6 +104,29 @@ TEST(NDArrayDims, AddRemoveDimension) {
   EXPECT_EQ(d.n_elems(), 600);
 }
 
+TEST(NDArrayDims, InlineStorage) {
+  namespace FK = FaceKit;
+  FK::NDArrayDims d({2, 3, 4, 5, 6, 7});
+  EXPECT_EQ(d.dims(), 6);
+  EXPECT_EQ(d.dim_size(5), 7);
+  EXPECT_EQ(d.n_elems(), 5040);
+  EXPECT_EQ(d.dim_sizes(), std::vector<size_t>({2, 3, 4, 5, 6, 7}));
+  // Full, extra dimension is ignored
+  d.AddDim(8);
+  EXPECT_EQ(d.dims(), 6);
+  // Remove last axis, out of range axis is ignored
+  d.RemoveDim(5);
+  d.RemoveDim(5);
+  EXPECT_EQ(d.dims(), 5);
+  EXPECT_EQ(d.n_elems(), 720);
+  // Comparison only looks at used axes
+  FK::NDArrayDims e({2, 3, 4, 5, 6});
+  EXPECT_TRUE(d == e);
+  e.set_dim(4, 1);
+  EXPECT_TRUE(d != e);
+  EXPECT_TRUE(FK::NDArrayDims({2, 3}) != FK::NDArrayDims({2, 3, 1}));
+}
+
 TEST(NDArrayDims, SetDimension) {
   namespace FK = FaceKit;
   FK::NDArrayDims d({25, 4});
@@ -160,6 +183,8 @@ TEST(NDArrayDims, Proto) {
   proto.add_dims()->set_size(4);
   proto.add_dims()->set_size(5);
   proto.add_dims()->set_size(6);
+  proto.add_dims()->set_size(7);
+  proto.add_dims()->set_size(8);
   d1.Clear();
   auto s = d1.FromProto(proto);
   EXPECT_EQ(s.Code(), FK::Status::Type::kInvalidArgument);
@@ -180,6 +180,69 @@ TYPED_TEST(NDArrayMapTest, Setter) {
 }
 
 
+/** Row / plane pointers */
+TYPED_TEST(NDArrayMapTest, Pointers) {
+  namespace FK = FaceKit;
+  typedef TypeParam T;
+  std::vector<T> buff(48, 0);
+  std::iota(buff.begin(), buff.end(), 1);
+  // Matrix
+  {
+    FK::NDArrayMap<T, 2> map(buff.data(), 6, 8);
+    EXPECT_EQ(map.ptr(), buff.data());
+    EXPECT_EQ(map.row(3), buff.data() + 24);
+    EXPECT_EQ(map.ptr(3), &map(3, 0));
+    EXPECT_EQ(map.plane(), buff.data());
+  }
+  // Rank-3
+  {
+    FK::NDArrayMap<T, 3> map(buff.data(), 2, 4, 6);
+    EXPECT_EQ(map.plane(1), buff.data() + 24);
+    EXPECT_EQ(map.row(1, 2), &map(1, 2, 0));
+    EXPECT_EQ(map.ptr(1, 2, 3), &map(1, 2, 3));
+    EXPECT_EQ(map.row(1, 2)[5], T(42));
+  }
+  // Strided
+  {
+    FK::NDArrayDims dims({3, 2});
+    FK::NDArrayMap<T, 2> map(dims, {1, 3}, buff.data());
+    EXPECT_EQ(map.row(2), buff.data() + 2);
+    EXPECT_EQ(map.row(2)[map.stride(1)], T(6));
+  }
+}
+
+/** Compile-time dimensions */
+TYPED_TEST(NDArrayMapTest, Fixed) {
+  namespace FK = FaceKit;
+  typedef TypeParam T;
+  std::vector<T> buff(48, 0);
+  std::iota(buff.begin(), buff.end(), 1);
+  using Map = FK::FixedNDArrayMap<T, 2, 4, 6>;
+  static_assert(Map::rank() == 3, "Wrong rank");
+  static_assert(Map::size() == 48, "Wrong size");
+  static_assert(Map::stride(0) == 24 && Map::stride(1) == 6 &&
+                Map::stride(2) == 1, "Wrong strides");
+  static_assert(Map::dim_size(1) == 4, "Wrong dimension");
+  Map map(buff.data());
+  FK::NDArrayMap<T, 3> dyn(buff.data(), 2, 4, 6);
+  for (size_t i = 0; i < 2; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      for (size_t k = 0; k < 6; ++k) {
+        EXPECT_EQ(&map(i, j, k), &dyn(i, j, k));
+      }
+    }
+  }
+  EXPECT_EQ(map(1, 1, 3), T(34));
+  map(0, 3, 5) = T(7);
+  EXPECT_EQ(buff[23], T(7));
+  EXPECT_EQ(map.plane(1), buff.data() + 24);
+  EXPECT_EQ(map.row(1, 2), buff.data() + 36);
+  EXPECT_EQ(map.ptr(), buff.data());
+  // Const
+  FK::FixedNDArrayMap<const T, 6, 8> cmap(buff.data());
+  EXPECT_EQ(cmap(5, 7), T(48));
+}
+
 int main(int argc, char* argv[]) {
   // Init gtest framework
   ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,275 @@
+/**
+ *  @file   ut_nd_array_ops.cpp
+ *  @brief Unit test for NDArray element-wise operations
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   05.03.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <numeric>
+#include <vector>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/math/nd_array_ops.hpp"
+
+namespace FK = FaceKit;
+
+template<typename T>
+class NDArrayOpsTest : public ::testing::Test {
+ public:
+};
+
+// List all types to test + register test
+typedef ::testing::Types<int8_t, uint8_t, int16_t, int32_t, int64_t, float, double> TypeToTest;
+TYPED_TEST_CASE(NDArrayOpsTest, TypeToTest);
+
+/** Fill array with 0, 1, 2, ... */
+template<typename T>
+void Iota(FK::NDArray* array, const T& start) {
+  auto flat = array->AsFlat<T>();
+  for (size_t i = 0; i < flat.size(); ++i) {
+    flat(i) = T(start + T(i % 10));
+  }
+}
+
+/** Add, Mul, Fma, odd size to exercise the tails */
+TYPED_TEST(NDArrayOpsTest, Arithmetic) {
+  typedef TypeParam T;
+  FK::NDArray a(FK::DataTypeToEnum<T>::v(), {3, 7});
+  FK::NDArray b(FK::DataTypeToEnum<T>::v(), {3, 7});
+  FK::NDArray c(FK::DataTypeToEnum<T>::v(), {3, 7});
+  Iota<T>(&a, T(0));
+  Iota<T>(&b, T(1));
+  Iota<T>(&c, T(2));
+  FK::NDArray out;
+  EXPECT_TRUE(FK::NDArrayOps::Add(a, b, &out).Good());
+  EXPECT_EQ(out.dim_size(0), 3);
+  EXPECT_EQ(out.dim_size(1), 7);
+  auto fa = a.AsFlat<T>();
+  auto fb = b.AsFlat<T>();
+  auto fc = c.AsFlat<T>();
+  for (size_t i = 0; i < a.n_elems(); ++i) {
+    EXPECT_EQ(out.AsFlat<T>()(i), T(fa(i) + fb(i)));
+  }
+  EXPECT_TRUE(FK::NDArrayOps::Mul(a, b, &out).Good());
+  for (size_t i = 0; i < a.n_elems(); ++i) {
+    EXPECT_EQ(out.AsFlat<T>()(i), T(fa(i) * fb(i)));
+  }
+  EXPECT_TRUE(FK::NDArrayOps::Fma(a, b, c, &out).Good());
+  for (size_t i = 0; i < a.n_elems(); ++i) {
+    EXPECT_EQ(out.AsFlat<T>()(i), T(fa(i) * fb(i) + fc(i)));
+  }
+  // In place
+  FK::NDArray inplace;
+  a.DeepCopy(&inplace);
+  EXPECT_TRUE(FK::NDArrayOps::Add(inplace, b, &inplace).Good());
+  for (size_t i = 0; i < a.n_elems(); ++i) {
+    EXPECT_EQ(inplace.AsFlat<T>()(i), T(fa(i) + fb(i)));
+  }
+}
+
+/** Scale + Clamp */
+TYPED_TEST(NDArrayOpsTest, ScaleClamp) {
+  typedef TypeParam T;
+  FK::NDArray a(FK::DataTypeToEnum<T>::v(), {37});
+  Iota<T>(&a, T(0));
+  auto fa = a.AsFlat<T>();
+  FK::NDArray out;
+  EXPECT_TRUE(FK::NDArrayOps::Scale(a, 2.0, 1.0, &out).Good());
+  for (size_t i = 0; i < a.n_elems(); ++i) {
+    EXPECT_EQ(out.AsFlat<T>()(i), T(T(2) * fa(i) + T(1)));
+  }
+  EXPECT_TRUE(FK::NDArrayOps::Clamp(a, 2.0, 6.0, &out).Good());
+  for (size_t i = 0; i < a.n_elems(); ++i) {
+    const T v = fa(i) < T(2) ? T(2) : (fa(i) > T(6) ? T(6) : fa(i));
+    EXPECT_EQ(out.AsFlat<T>()(i), v);
+  }
+  EXPECT_FALSE(FK::NDArrayOps::Clamp(a, 6.0, 2.0, &out).Good());
+}
+
+/** Convert */
+TEST(NDArrayOps, Convert) {
+  FK::NDArray a(FK::DataType::kFloat, {2, 5});
+  auto fa = a.AsFlat<float>();
+  for (size_t i = 0; i < a.n_elems(); ++i) {
+    fa(i) = float(i) * 1.5f;
+  }
+  FK::NDArray out;
+  EXPECT_TRUE(FK::NDArrayOps::Convert(a, FK::DataType::kInt32, &out).Good());
+  EXPECT_EQ(out.type(), FK::DataType::kInt32);
+  EXPECT_EQ(out.dim_size(1), 5);
+  for (size_t i = 0; i < a.n_elems(); ++i) {
+    EXPECT_EQ(out.AsFlat<int32_t>()(i), static_cast<int32_t>(fa(i)));
+  }
+  FK::NDArray back;
+  EXPECT_TRUE(FK::NDArrayOps::Convert(out, FK::DataType::kDouble, &back).Good());
+  EXPECT_EQ(back.AsFlat<double>()(3), 4.0);
+  // Not numeric
+  EXPECT_FALSE(FK::NDArrayOps::Convert(a, FK::DataType::kString, &out).Good());
+}
+
+/** Scaled conversion, image path */
+TEST(NDArrayOps, ConvertScale) {
+  // uint8 -> float normalization, odd size to exercise the tails
+  FK::NDArray img(FK::DataType::kUInt8, {5, 7, 3});
+  auto fi = img.AsFlat<uint8_t>();
+  for (size_t i = 0; i < img.n_elems(); ++i) {
+    fi(i) = uint8_t((i * 37) % 256);
+  }
+  FK::NDArray f;
+  EXPECT_TRUE(FK::NDArrayOps::Convert(img, FK::DataType::kFloat, 1.0 / 255.0,
+                                      -0.5, &f).Good());
+  EXPECT_EQ(f.type(), FK::DataType::kFloat);
+  EXPECT_EQ(f.dim_size(2), 3);
+  for (size_t i = 0; i < img.n_elems(); ++i) {
+    EXPECT_NEAR(f.AsFlat<float>()(i), fi(i) / 255.f - 0.5f, 1e-6f);
+  }
+  // Back to uint8, round trip is exact
+  FK::NDArray back;
+  EXPECT_TRUE(FK::NDArrayOps::Convert(f, FK::DataType::kUInt8, 255.0,
+                                      127.5, &back).Good());
+  for (size_t i = 0; i < img.n_elems(); ++i) {
+    EXPECT_EQ(back.AsFlat<uint8_t>()(i), fi(i));
+  }
+  // Saturation + rounding
+  FK::NDArray v(FK::DataType::kFloat, {11});
+  const float values[] = {-10.f, -0.4f, 0.5f, 1.5f, 2.5f, 254.6f, 300.f,
+                          70000.f, 12.f, 65535.4f, 3.49f};
+  std::copy(values, values + 11, v.AsFlat<float>().data());
+  const uint8_t exp_u8[] = {0, 0, 0, 2, 2, 255, 255, 255, 12, 255, 3};
+  EXPECT_TRUE(FK::NDArrayOps::Convert(v, FK::DataType::kUInt8, 1.0, 0.0,
+                                      &back).Good());
+  for (size_t i = 0; i < 11; ++i) {
+    EXPECT_EQ(back.AsFlat<uint8_t>()(i), exp_u8[i]);
+  }
+  const uint16_t exp_u16[] = {0, 0, 0, 2, 2, 255, 300, 65535, 12, 65535, 3};
+  EXPECT_TRUE(FK::NDArrayOps::Convert(v, FK::DataType::kUInt16, 1.0, 0.0,
+                                      &back).Good());
+  for (size_t i = 0; i < 11; ++i) {
+    EXPECT_EQ(back.AsFlat<uint16_t>()(i), exp_u16[i]);
+  }
+  // uint16 -> float
+  FK::NDArray w(FK::DataType::kUInt16, {13});
+  for (size_t i = 0; i < 13; ++i) {
+    w.AsFlat<uint16_t>()(i) = uint16_t(i * 5000);
+  }
+  EXPECT_TRUE(FK::NDArrayOps::Convert(w, FK::DataType::kFloat, 2.0, 1.0,
+                                      &f).Good());
+  for (size_t i = 0; i < 13; ++i) {
+    EXPECT_EQ(f.AsFlat<float>()(i), 2.f * float(i * 5000) + 1.f);
+  }
+  // Generic path, computed in double
+  FK::NDArray d;
+  EXPECT_TRUE(FK::NDArrayOps::Convert(w, FK::DataType::kInt16, 1.0, -30000.0,
+                                      &d).Good());
+  EXPECT_EQ(d.AsFlat<int16_t>()(0), -30000);
+  EXPECT_EQ(d.AsFlat<int16_t>()(12), 30000);
+  EXPECT_TRUE(FK::NDArrayOps::Convert(v, FK::DataType::kInt8, 1.0, 0.0,
+                                      &d).Good());
+  EXPECT_EQ(d.AsFlat<int8_t>()(0), -10);
+  EXPECT_EQ(d.AsFlat<int8_t>()(6), 127);
+}
+
+/** Half precision */
+TEST(NDArrayOps, ConvertHalf) {
+  FK::NDArray a(FK::DataType::kFloat, {3, 7});
+  auto fa = a.AsFlat<float>();
+  for (size_t i = 0; i < a.n_elems(); ++i) {
+    fa(i) = float(i) * 0.25f - 2.f;
+  }
+  FK::NDArray h;
+  EXPECT_TRUE(FK::NDArrayOps::Convert(a, FK::DataType::kHalf, 1.0, 0.0,
+                                      &h).Good());
+  EXPECT_EQ(h.type(), FK::DataType::kHalf);
+  EXPECT_EQ(h.AsFlat<FK::Half>()(0).bits, 0xC000);
+  FK::NDArray f;
+  EXPECT_TRUE(FK::NDArrayOps::Convert(h, FK::DataType::kFloat, 2.0, 0.0,
+                                      &f).Good());
+  for (size_t i = 0; i < a.n_elems(); ++i) {
+    EXPECT_EQ(f.AsFlat<float>()(i), 2.f * fa(i));
+  }
+  // Plain conversion through other types
+  FK::NDArray d;
+  EXPECT_TRUE(FK::NDArrayOps::Convert(h, FK::DataType::kDouble, &d).Good());
+  EXPECT_EQ(d.AsFlat<double>()(9), 0.25);
+  EXPECT_TRUE(FK::NDArrayOps::Convert(d, FK::DataType::kHalf, &h).Good());
+  EXPECT_EQ(float(h.AsFlat<FK::Half>()(9)), 0.25f);
+  // Arithmetic is not supported on half
+  FK::NDArray out;
+  EXPECT_FALSE(FK::NDArrayOps::Add(h, h, &out).Good());
+}
+
+/** Errors */
+TEST(NDArrayOps, Mismatch) {
+  FK::NDArray a(FK::DataType::kFloat, {2, 5});
+  FK::NDArray b(FK::DataType::kFloat, {5, 2});
+  FK::NDArray c(FK::DataType::kDouble, {2, 5});
+  FK::NDArray s(FK::DataType::kString, {2, 5});
+  FK::NDArray out;
+  EXPECT_FALSE(FK::NDArrayOps::Add(a, b, &out).Good());
+  EXPECT_FALSE(FK::NDArrayOps::Mul(a, c, &out).Good());
+  EXPECT_FALSE(FK::NDArrayOps::Fma(a, a, b, &out).Good());
+  EXPECT_FALSE(FK::NDArrayOps::Scale(s, 1.0, 0.0, &out).Good());
+}
+
+/** Strided operands */
+TEST(NDArrayOps, Strided) {
+  FK::NDArray a(FK::DataType::kFloat, {4, 6});
+  Iota<float>(&a, 0.f);
+  FK::NDArray tr = a.Transpose();
+  FK::NDArray b(FK::DataType::kFloat, {6, 4});
+  Iota<float>(&b, 1.f);
+  FK::NDArray out;
+  EXPECT_TRUE(FK::NDArrayOps::Add(tr, b, &out).Good());
+  EXPECT_TRUE(out.IsContiguous());
+  auto m = out.AsMatrix<float>();
+  auto am = a.AsMatrix<float>();
+  auto bm = b.AsMatrix<float>();
+  for (size_t i = 0; i < 6; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      EXPECT_EQ(m(i, j), am(j, i) + bm(i, j));
+    }
+  }
+}
+
+/** Lazy expression */
+TEST(NDArrayOps, Lazy) {
+  FK::NDArray a(FK::DataType::kFloat, {3, 11});
+  FK::NDArray b(FK::DataType::kFloat, {3, 11});
+  FK::NDArray c(FK::DataType::kFloat, {3, 11});
+  Iota<float>(&a, 0.f);
+  Iota<float>(&b, 1.f);
+  Iota<float>(&c, 2.f);
+  FK::NDArray out;
+  auto expr = FK::Lazy<float>(a) * FK::Lazy<float>(b) + FK::Lazy<float>(c) -
+              1.f;
+  EXPECT_TRUE(expr.Eval(&out).Good());
+  auto fa = a.AsFlat<float>();
+  auto fb = b.AsFlat<float>();
+  auto fc = c.AsFlat<float>();
+  for (size_t i = 0; i < a.n_elems(); ++i) {
+    EXPECT_EQ(out.AsFlat<float>()(i), fa(i) * fb(i) + fc(i) - 1.f);
+  }
+  // Mismatch
+  FK::NDArray d(FK::DataType::kFloat, {11, 3});
+  EXPECT_FALSE((FK::Lazy<float>(a) + FK::Lazy<float>(d)).Eval(&out).Good());
+  EXPECT_FALSE((FK::Lazy<double>(a) * 2.0).Eval(&out).Good());
+}
+
+/** Instruction set */
+TEST(NDArrayOps, SimdLevel) {
+  const std::string name = FK::NDArrayOps::simd_name();
+  EXPECT_FALSE(name.empty());
+  std::cout << "SIMD level: " << name << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
@@ -9,6 +9,7 @@
  */
 
 #include <limits>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -136,6 +137,89 @@ TEST(Path, Clean) {
   EXPECT_EQ(FK::Path::Clean("a/../../.."), "../..");
 }
 
+TEST(Path, ParseURI) {
+  namespace FK = FaceKit;
+
+  std::string scheme, host, path;
+  FK::Path::ParseURI("s3://bucket/dir/file.bin", &scheme, &host, &path);
+  EXPECT_EQ(scheme, "s3");
+  EXPECT_EQ(host, "bucket");
+  EXPECT_EQ(path, "/dir/file.bin");
+  FK::Path::ParseURI("http://localhost:8080", &scheme, &host, &path);
+  EXPECT_EQ(scheme, "http");
+  EXPECT_EQ(host, "localhost:8080");
+  EXPECT_EQ(path, "");
+  FK::Path::ParseURI("/tmp/a://b", &scheme, &host, &path);
+  EXPECT_EQ(scheme, "");
+  EXPECT_EQ(host, "");
+  EXPECT_EQ(path, "/tmp/a://b");
+  FK::Path::ParseURI("data/file.txt", &scheme, nullptr, &path);
+  EXPECT_EQ(scheme, "");
+  EXPECT_EQ(path, "data/file.txt");
+}
+
+TEST(Path, View) {
+  namespace FK = FaceKit;
+
+  const std::string path = "/data/images/face.0001.png";
+  FK::StringView dir, file, ext;
+  FK::Path::SplitComponent(path, &dir, &file, &ext);
+  EXPECT_EQ(dir, "/data/images");
+  EXPECT_EQ(file, "face.0001");
+  EXPECT_EQ(ext, "png");
+  // Outputs reference the input
+  EXPECT_EQ(dir.data(), path.data());
+  EXPECT_EQ(file.data(), path.data() + 13);
+  EXPECT_EQ(FK::Path::Dirname(FK::StringView("/Hello")), "/");
+  EXPECT_EQ(FK::Path::Basename(FK::StringView("foo/")), "");
+  EXPECT_EQ(FK::Path::Extension(FK::StringView("foo")), "");
+
+  std::vector<FK::StringView> parts;
+  FK::String::Split(FK::StringView("a::b::::c"), "::", &parts);
+  ASSERT_EQ(parts.size(), 4);
+  EXPECT_EQ(parts[0], "a");
+  EXPECT_EQ(parts[1], "b");
+  EXPECT_EQ(parts[2], "");
+  EXPECT_EQ(parts[3], "c");
+}
+
+TEST(Path, Match) {
+  namespace FK = FaceKit;
+  EXPECT_TRUE(FK::Path::Match("*.jpg", "face.jpg"));
+  EXPECT_FALSE(FK::Path::Match("*.jpg", "face.jpeg"));
+  EXPECT_TRUE(FK::Path::Match("*.jp*g", "face.jpeg"));
+  EXPECT_TRUE(FK::Path::Match("img_???.png", "img_001.png"));
+  EXPECT_FALSE(FK::Path::Match("img_???.png", "img_0001.png"));
+  EXPECT_TRUE(FK::Path::Match("img_[0-9]*", "img_7_left.png"));
+  EXPECT_FALSE(FK::Path::Match("img_[!0-9]*", "img_7_left.png"));
+  EXPECT_TRUE(FK::Path::Match("[]a]", "]"));
+  EXPECT_TRUE(FK::Path::Match("[ab", "[ab"));
+  EXPECT_TRUE(FK::Path::Match("*", ""));
+  EXPECT_TRUE(FK::Path::Match("a*b*c", "aXbYbZc"));
+  EXPECT_FALSE(FK::Path::Match("a*b*c", "aXbYbZ"));
+  EXPECT_FALSE(FK::Path::Match("", "a"));
+}
+
+TEST(StringView, Basic) {
+  namespace FK = FaceKit;
+
+  FK::StringView s("hello world");
+  EXPECT_EQ(s.size(), 11);
+  EXPECT_EQ(s.find('o'), 4);
+  EXPECT_EQ(s.rfind('o'), 7);
+  EXPECT_EQ(s.find("world"), 6);
+  EXPECT_EQ(s.find("xyz"), FK::StringView::npos);
+  EXPECT_EQ(s.substr(6), "world");
+  EXPECT_EQ(s.substr(20), "");
+  EXPECT_TRUE(s.starts_with("hell"));
+  EXPECT_TRUE(s.ends_with("world"));
+  EXPECT_TRUE(FK::StringView("abc") < FK::StringView("abd"));
+  EXPECT_TRUE(FK::StringView("ab") < FK::StringView("abc"));
+  EXPECT_EQ(s.ToString(), std::string("hello world"));
+  s.remove_prefix(6);
+  s.remove_suffix(1);
+  EXPECT_EQ(s, "worl");
+}
 
 int main(int argc, char* argv[]) {
   // Init gtest framework
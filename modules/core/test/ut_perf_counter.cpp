@@ -0,0 +1,89 @@
+/**
+ *  @file   ut_perf_counter.cpp
+ *  @brief Unit test for hardware performance counters
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/sys/perf_counter.hpp"
+
+namespace FK = FaceKit;
+using Counters = FK::PerfCounters;
+
+/** Some work the counters can see */
+static double Work(const int& n) {
+  volatile double acc = 0.0;
+  for (int i = 0; i < n; ++i) {
+    acc = acc + double(i % 7) * 0.5;
+  }
+  return acc;
+}
+
+TEST(PerfCounters, Sample) {
+  Counters::Sample a, b;
+  a.valid = (1u << Counters::kCycles) | (1u << Counters::kInstructions);
+  a.value[Counters::kCycles] = 300;
+  a.value[Counters::kInstructions] = 500;
+  b.valid = a.valid | (1u << Counters::kLLCMisses);
+  b.value[Counters::kCycles] = 100;
+  b.value[Counters::kInstructions] = 100;
+  const auto d = a - b;
+  EXPECT_TRUE(d.Has(Counters::kCycles));
+  EXPECT_FALSE(d.Has(Counters::kLLCMisses));
+  EXPECT_EQ(d.value[Counters::kCycles], 200u);
+  EXPECT_DOUBLE_EQ(d.Ipc(), 2.0);
+  std::map<std::string, double> map;
+  d.Export(2.0, &map);
+  EXPECT_EQ(map.size(), 3u);
+  EXPECT_DOUBLE_EQ(map["cycles"], 100.0);
+  EXPECT_DOUBLE_EQ(map["instructions"], 200.0);
+  EXPECT_DOUBLE_EQ(map["ipc"], 2.0);
+  EXPECT_DOUBLE_EQ(Counters::Sample().Ipc(), 0.0);
+}
+
+TEST(PerfCounters, Read) {
+  Counters counters;
+  Counters::Sample s;
+  EXPECT_FALSE(counters.Read(&s).Good());
+  if (!counters.Open().Good()) {
+    std::cout << "Hardware counters not available, skipped" << std::endl;
+    EXPECT_FALSE(counters.IsOpen());
+    return;
+  }
+  EXPECT_TRUE(counters.IsOpen());
+  Counters::Sample s0, s1;
+  ASSERT_TRUE(counters.Read(&s0).Good());
+  Work(100000);
+  ASSERT_TRUE(counters.Read(&s1).Good());
+  const auto d = s1 - s0;
+  EXPECT_NE(d.valid, 0u);
+  if (d.Has(Counters::kInstructions)) {
+    EXPECT_GT(d.value[Counters::kInstructions], 100000u);
+  }
+  counters.Close();
+  EXPECT_FALSE(counters.IsOpen());
+  EXPECT_FALSE(counters.Read(&s).Good());
+}
+
+TEST(PerfCounters, Region) {
+  FK::PerfCounterRegion region;
+  Work(1000);
+  const auto d = region.Stop();
+  EXPECT_EQ(d.valid != 0, Counters::ThreadCounters() != nullptr);
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
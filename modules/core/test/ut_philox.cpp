@@ -0,0 +1,118 @@
+/**
+ *  @file   ut_philox.cpp
+ *  @brief Unit test for counter-based random number generator
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   08.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/math/philox.hpp"
+
+TEST(Philox, KnownAnswer) {
+  // Random123 known answer vectors
+  using FaceKit::Philox4x32;
+  uint32_t out[4];
+  {
+    const uint32_t ctr[4] = {0, 0, 0, 0};
+    const uint32_t key[2] = {0, 0};
+    Philox4x32::Block(ctr, key, out);
+    EXPECT_EQ(out[0], 0x6627E8D5u);
+    EXPECT_EQ(out[1], 0xE169C58Du);
+    EXPECT_EQ(out[2], 0xBC57AC4Cu);
+    EXPECT_EQ(out[3], 0x9B00DBD8u);
+  }
+  {
+    const uint32_t ctr[4] = {0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF};
+    const uint32_t key[2] = {0xFFFFFFFF, 0xFFFFFFFF};
+    Philox4x32::Block(ctr, key, out);
+    EXPECT_EQ(out[0], 0x408F276Du);
+    EXPECT_EQ(out[1], 0x41C83B0Eu);
+    EXPECT_EQ(out[2], 0xA20BC7C6u);
+    EXPECT_EQ(out[3], 0x6D5451FDu);
+  }
+  {
+    const uint32_t ctr[4] = {0x243F6A88, 0x85A308D3, 0x13198A2E, 0x03707344};
+    const uint32_t key[2] = {0xA4093822, 0x299F31D0};
+    Philox4x32::Block(ctr, key, out);
+    EXPECT_EQ(out[0], 0xD16CFE09u);
+    EXPECT_EQ(out[1], 0x94FDCCEBu);
+    EXPECT_EQ(out[2], 0x5001E420u);
+    EXPECT_EQ(out[3], 0x24126EA1u);
+  }
+}
+
+TEST(Philox, Streams) {
+  using FaceKit::Philox4x32;
+  // Same key / stream, same sequence, also after reseeding
+  Philox4x32 a(42, 7);
+  Philox4x32 b(42, 7);
+  std::vector<uint32_t> seq;
+  for (int i = 0; i < 37; ++i) {
+    seq.push_back(a());
+    EXPECT_EQ(seq.back(), b());
+  }
+  a.Seed(42, 7);
+  for (int i = 0; i < 37; ++i) {
+    EXPECT_EQ(a(), seq[i]);
+  }
+  // Other stream or key differs
+  Philox4x32 c(42, 8);
+  Philox4x32 d(43, 7);
+  int n_same_c = 0;
+  int n_same_d = 0;
+  for (int i = 0; i < 37; ++i) {
+    const uint32_t v = seq[i];
+    n_same_c += c() == v;
+    n_same_d += d() == v;
+  }
+  EXPECT_LT(n_same_c, 2);
+  EXPECT_LT(n_same_d, 2);
+}
+
+TEST(Philox, Discard) {
+  using FaceKit::Philox4x32;
+  for (uint64_t n : {0, 1, 3, 4, 5, 13, 1000}) {
+    for (int offset : {0, 1, 2, 3}) {
+      Philox4x32 a(1, 2);
+      Philox4x32 b(1, 2);
+      for (int i = 0; i < offset; ++i) {
+        a();
+        b();
+      }
+      for (uint64_t i = 0; i < n; ++i) {
+        a();
+      }
+      b.discard(n);
+      EXPECT_EQ(a(), b());
+    }
+  }
+}
+
+TEST(Philox, Uniform) {
+  using FaceKit::Philox4x32;
+  Philox4x32 gen(123, 0);
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  const int n = 100000;
+  double mean = 0.0;
+  for (int i = 0; i < n; ++i) {
+    const double x = dist(gen);
+    EXPECT_GE(x, 0.0);
+    EXPECT_LT(x, 1.0);
+    mean += x;
+  }
+  EXPECT_NEAR(mean / n, 0.5, 5e-3);
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,136 @@
+/**
+ *  @file   ut_quantized_matrix.cpp
+ *  @brief Unit test for reduced precision matrix-vector products
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   03.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/math/quantized_matrix.hpp"
+#include "facekit/core/half.hpp"
+#include "facekit/core/logger.hpp"
+
+namespace FK = FaceKit;
+using Format = FK::QuantizedMatrix::Format;
+
+/** Random matrix with column dependent magnitude */
+static std::vector<float> RandomMatrix(const int& rows,
+                                       const int& cols,
+                                       const int& seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  std::vector<float> m(rows * cols);
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      m[i * cols + j] = dist(gen) * (1.f + 10.f * j);
+    }
+  }
+  return m;
+}
+
+/** Reference y = alpha * op(A) * x + beta * y in double precision */
+static std::vector<float> ReferenceGemv(const std::vector<float>& a,
+                                        const int& rows,
+                                        const int& cols,
+                                        const bool& trans,
+                                        const float& alpha,
+                                        const std::vector<float>& x,
+                                        const float& beta,
+                                        const std::vector<float>& y) {
+  const int n_out = trans ? cols : rows;
+  const int n_in = trans ? rows : cols;
+  std::vector<float> out(n_out);
+  for (int i = 0; i < n_out; ++i) {
+    double acc = 0.0;
+    for (int k = 0; k < n_in; ++k) {
+      const float v = trans ? a[k * cols + i] : a[i * cols + k];
+      acc += static_cast<double>(v) * x[k];
+    }
+    out[i] = static_cast<float>(alpha * acc + beta * y[i]);
+  }
+  return out;
+}
+
+TEST(QuantizedMatrix, BFloat16Conversion) {
+  EXPECT_EQ(FK::BFloat16BitsToFloat(FK::FloatToBFloat16Bits(1.f)), 1.f);
+  EXPECT_EQ(FK::BFloat16BitsToFloat(FK::FloatToBFloat16Bits(-2.5f)), -2.5f);
+  // Round to nearest even
+  EXPECT_EQ(FK::FloatToBFloat16Bits(1.f + 1.f / 256.f), 0x3F80);
+  EXPECT_EQ(FK::FloatToBFloat16Bits(1.f + 3.f / 256.f), 0x3F82);
+  EXPECT_TRUE(std::isnan(FK::BFloat16BitsToFloat(
+          FK::FloatToBFloat16Bits(std::nanf("")))));
+}
+
+TEST(QuantizedMatrix, Quantize) {
+  const int rows = 33, cols = 7;
+  const auto a = RandomMatrix(rows, cols, 1);
+  for (const auto fmt : {Format::kFloat16, Format::kBFloat16, Format::kInt8}) {
+    FK::QuantizedMatrix q;
+    ASSERT_TRUE(q.Quantize(a.data(), rows, cols, fmt).Good());
+    EXPECT_EQ(q.rows(), rows);
+    EXPECT_EQ(q.cols(), cols);
+    EXPECT_EQ(q.format(), fmt);
+    EXPECT_EQ(q.ElementSize(), fmt == Format::kInt8 ? 1 : 2);
+    std::vector<float> d(rows * cols);
+    q.Dequantize(d.data());
+    for (int i = 0; i < rows; ++i) {
+      for (int j = 0; j < cols; ++j) {
+        // Relative to the column range
+        const float range = 1.f + 10.f * j;
+        const float tol = fmt == Format::kFloat16 ? 1e-3f :
+                          fmt == Format::kBFloat16 ? 8e-3f : 5e-3f;
+        EXPECT_NEAR(d[i * cols + j], a[i * cols + j], tol * range);
+      }
+    }
+  }
+  FK::QuantizedMatrix q;
+  EXPECT_FALSE(q.Quantize(a.data(), -1, cols, Format::kInt8).Good());
+}
+
+TEST(QuantizedMatrix, Gemv) {
+  // Large enough to split over threads, odd sizes to hit the tails
+  const int rows = 3001, cols = 37;
+  const auto a = RandomMatrix(rows, cols, 2);
+  std::mt19937 gen(3);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  for (const auto fmt : {Format::kFloat16, Format::kBFloat16, Format::kInt8}) {
+    FK::QuantizedMatrix q;
+    ASSERT_TRUE(q.Quantize(a.data(), rows, cols, fmt).Good());
+    // Reference on the dequantized matrix, isolates the product from the
+    // quantization error
+    std::vector<float> d(rows * cols);
+    q.Dequantize(d.data());
+    for (const bool trans : {false, true}) {
+      const int n_in = trans ? rows : cols;
+      const int n_out = trans ? cols : rows;
+      std::vector<float> x(n_in), y(n_out);
+      for (auto& v : x) v = dist(gen);
+      for (auto& v : y) v = dist(gen);
+      for (const float beta : {0.f, 0.5f}) {
+        const auto e = ReferenceGemv(d, rows, cols, trans, 2.f, x, beta, y);
+        std::vector<float> out = y;
+        q.Gemv(trans, 2.f, x.data(), beta, out.data());
+        for (int i = 0; i < n_out; ++i) {
+          ASSERT_NEAR(out[i], e[i], 1e-4f * (std::abs(e[i]) + 10.f * n_in));
+        }
+      }
+    }
+  }
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Disable logger
+  FaceKit::Logger::Instance().Disable();
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,111 @@
+/**
+ *  @file   ut_quaternion.cpp
+ *  @brief Unit test for quaternion and its batch kernels
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cmath>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/math/quaternion.hpp"
+#include "facekit/core/logger.hpp"
+
+template<typename T>
+class QuaternionTest : public ::testing::Test {
+ public:
+  /** Random quaternions, size not multiple of the block size */
+  static std::vector<FaceKit::Quaternion<T>> Random(const size_t& n,
+                                                    const int& seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<T> dist(T(-1.0), T(1.0));
+    std::vector<FaceKit::Quaternion<T>> q(n);
+    for (auto& e : q) {
+      e = FaceKit::Quaternion<T>(dist(gen), FaceKit::Vector3<T>(dist(gen),
+                                                                dist(gen),
+                                                                dist(gen)));
+    }
+    return q;
+  }
+  /** Tolerance */
+  static T Tol(void) {
+    return sizeof(T) == 4 ? T(1e-5) : T(1e-12);
+  }
+};
+
+using Types = ::testing::Types<float, double>;
+TYPED_TEST_CASE(QuaternionTest, Types);
+
+TYPED_TEST(QuaternionTest, Composition) {
+  using T = TypeParam;
+  namespace FK = FaceKit;
+  static_assert(std::is_trivially_copyable<FK::Quaternion<T>>::value,
+                "Quaternion must be trivially copyable");
+  // R(a * b) == R(a) * R(b)
+  auto a = this->Random(2, 7);
+  a[0].Normalize();
+  a[1].Normalize();
+  FK::Matrix3<T> ra, rb, rab;
+  a[0].ToRotationMatrix(&ra);
+  a[1].ToRotationMatrix(&rb);
+  (a[0] * a[1]).ToRotationMatrix(&rab);
+  const FK::Vector3<T> p(T(0.3), T(-1.2), T(2.0));
+  const FK::Vector3<T> e = ra * (rb * p);
+  const FK::Vector3<T> r = rab * p;
+  EXPECT_NEAR(r.x_, e.x_, this->Tol());
+  EXPECT_NEAR(r.y_, e.y_, this->Tol());
+  EXPECT_NEAR(r.z_, e.z_, this->Tol());
+  // q * conj(q) == |q|^2
+  const auto qc = a[0] * a[0].Conjugate();
+  EXPECT_NEAR(qc.q_, T(1.0), this->Tol());
+  EXPECT_NEAR(qc.v_.Norm(), T(0.0), this->Tol());
+}
+
+TYPED_TEST(QuaternionTest, Batch) {
+  using T = TypeParam;
+  namespace FK = FaceKit;
+  const T tol = this->Tol();
+  const auto a = this->Random(301, 1);
+  const auto b = this->Random(301, 2);
+  // Compose
+  std::vector<FK::Quaternion<T>> out(a.size());
+  FK::Quaternion<T>::ComposeBatch(a.data(), b.data(), out.data(), a.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    const auto e = a[i] * b[i];
+    ASSERT_NEAR(out[i].q_, e.q_, tol);
+    ASSERT_NEAR(out[i].v_.x_, e.v_.x_, tol);
+    ASSERT_NEAR(out[i].v_.y_, e.v_.y_, tol);
+    ASSERT_NEAR(out[i].v_.z_, e.v_.z_, tol);
+  }
+  // Normalize, in place
+  FK::Quaternion<T>::NormalizeBatch(out.data(), out.size());
+  for (const auto& q : out) {
+    ASSERT_NEAR(q.Norm(), T(1.0), tol);
+  }
+  // Rotation matrices
+  std::vector<FK::Matrix3<T>> m(out.size());
+  FK::Quaternion<T>::ToRotationMatrixBatch(out.data(), m.data(), out.size());
+  for (size_t i = 0; i < out.size(); ++i) {
+    FK::Matrix3<T> e;
+    out[i].ToRotationMatrix(&e);
+    for (int k = 0; k < 9; ++k) {
+      ASSERT_NEAR(m[i][k], e[k], tol);
+    }
+  }
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Disable logger
+  FaceKit::Logger::Instance().Disable();
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
@@ -74,6 +74,16 @@ TEST_F(RefCounterTest, IsNotOne) {
   ref->Dec();
 }
 
+TEST_F(RefCounterTest, Count) {
+  Ref* ref = new Ref();
+  EXPECT_EQ(ref->Count(), 1);
+  ref->Inc();
+  EXPECT_EQ(ref->Count(), 2);
+  ref->Dec();
+  EXPECT_EQ(ref->Count(), 1);
+  ref->Dec();
+}
+
 TEST_F(RefCounterTest, RetValueDec) {
   Ref* ref = new Ref();
   ref->Inc();
@@ -81,6 +91,49 @@ TEST_F(RefCounterTest, RetValueDec) {
   EXPECT_TRUE(ref->Dec());
 }
 
+TEST_F(RefCounterTest, RefPtrAdopt) {
+  {
+    FaceKit::RefPtr<Ref> ptr(new Ref());
+    EXPECT_TRUE(ptr);
+    EXPECT_EQ(ptr->Count(), 1);
+  }
+  EXPECT_EQ(construction, 1);
+  EXPECT_EQ(destruction, 1);
+}
+
+TEST_F(RefCounterTest, RefPtrCopyMove) {
+  auto a = FaceKit::MakeRef<Ref>();
+  {
+    FaceKit::RefPtr<Ref> b(a);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(a->Count(), 2);
+    FaceKit::RefPtr<Ref> c(std::move(b));
+    EXPECT_FALSE(b);
+    EXPECT_EQ(a->Count(), 2);
+    c = a;
+    EXPECT_EQ(a->Count(), 2);
+  }
+  EXPECT_EQ(a->Count(), 1);
+  EXPECT_EQ(destruction, 0);
+  a = nullptr;
+  EXPECT_EQ(destruction, 1);
+}
+
+TEST_F(RefCounterTest, RefPtrShareRelease) {
+  Ref* ref = new Ref();
+  {
+    auto ptr = FaceKit::RefPtr<Ref>::Share(ref);
+    EXPECT_EQ(ref->Count(), 2);
+  }
+  EXPECT_EQ(ref->Count(), 1);
+  FaceKit::RefPtr<Ref> ptr(ref);
+  EXPECT_EQ(ptr.release(), ref);
+  EXPECT_EQ(ptr, nullptr);
+  EXPECT_EQ(destruction, 0);
+  ref->Dec();
+  EXPECT_EQ(destruction, 1);
+}
+
 int main(int argc, char* argv[]) {
   // Init gtest framework
   ::testing::InitGoogleTest(&argc, argv);
@@ -308,6 +308,30 @@ TEST(Scanner, FailedMAtch) {
   EXPECT_EQ("match", match);
 }
 
+TEST(Scanner, ViewResult) {
+  // Views point into the scanned input, no copy involved
+  const std::string input = "key = value";
+  FaceKit::StringView remain, match;
+  Scanner scan(input);
+  EXPECT_TRUE(scan
+              .Many(CharType::kLetter)
+              .StopCapture()
+              .AnySpace()
+              .OneLiteral(FaceKit::StringView("="))
+              .AnySpace()
+              .Result(&remain, &match));
+  EXPECT_EQ(match, "key");
+  EXPECT_EQ(remain, "value");
+  EXPECT_EQ(match.data(), input.data());
+  EXPECT_EQ(remain.data(), input.data() + 6);
+  // Scan a sub-range of a larger buffer
+  FaceKit::StringView sub = FaceKit::StringView(input).substr(6, 3);
+  EXPECT_TRUE(Scanner(sub).Many(CharType::kLetter).Eos().Result(&remain,
+                                                                 &match));
+  EXPECT_EQ(match, "val");
+  EXPECT_TRUE(remain.empty());
+}
+
 TEST_F(ScannerTest, AllCharType) {
   // Check all ascii char are generated
   EXPECT_EQ(256, CharTypeStr(CharType::kAll).size());
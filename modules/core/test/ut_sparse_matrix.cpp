@@ -0,0 +1,209 @@
+/**
+ *  @file   ut_sparse_matrix.cpp
+ *  @brief Unit test for sparse matrix and conjugate gradient solver
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   31.08.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/math/sparse_matrix.hpp"
+#include "facekit/core/logger.hpp"
+
+template<typename T>
+class SparseMatrixTest : public ::testing::Test {
+ public:
+  using Triplet = typename FaceKit::SparseMatrix<T>::Triplet;
+
+  /** Random sparse matrix, ~`density` of the entries set */
+  static std::vector<Triplet> Random(const int& rows,
+                                     const int& cols,
+                                     const double& density,
+                                     const int& seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<T> val(T(-1.0), T(1.0));
+    std::uniform_real_distribution<double> keep(0.0, 1.0);
+    std::vector<Triplet> t;
+    for (int r = 0; r < rows; ++r) {
+      for (int c = 0; c < cols; ++c) {
+        if (keep(gen) < density) {
+          t.push_back({r, c, val(gen)});
+        }
+      }
+    }
+    return t;
+  }
+
+  /** 1D Laplacian with Dirichlet boundaries, SPD */
+  static std::vector<Triplet> Laplacian(const int& n) {
+    std::vector<Triplet> t;
+    for (int i = 0; i < n; ++i) {
+      t.push_back({i, i, T(2.0)});
+      if (i > 0) {
+        t.push_back({i, i - 1, T(-1.0)});
+      }
+      if (i < n - 1) {
+        t.push_back({i, i + 1, T(-1.0)});
+      }
+    }
+    return t;
+  }
+
+  /** Tolerance */
+  static T Tol(void) {
+    return sizeof(T) == 4 ? T(1e-4) : T(1e-10);
+  }
+};
+
+using Types = ::testing::Types<float, double>;
+TYPED_TEST_CASE(SparseMatrixTest, Types);
+
+TYPED_TEST(SparseMatrixTest, Construction) {
+  using T = TypeParam;
+  namespace FK = FaceKit;
+  // Unordered with duplicates
+  std::vector<typename TestFixture::Triplet> t = {{2, 1, T(1.0)},
+                                                  {0, 2, T(3.0)},
+                                                  {0, 0, T(1.0)},
+                                                  {2, 1, T(2.0)},
+                                                  {1, 1, T(-1.0)}};
+  FK::SparseMatrix<T> m;
+  EXPECT_TRUE(m.FromTriplets(3, 4, t).Good());
+  EXPECT_EQ(m.rows(), 3);
+  EXPECT_EQ(m.cols(), 4);
+  EXPECT_EQ(m.nnz(), 4);
+  EXPECT_EQ(m.row_ptr(), std::vector<int>({0, 2, 3, 4}));
+  EXPECT_EQ(m.col_idx(), std::vector<int>({0, 2, 1, 1}));
+  EXPECT_EQ(m.values()[3], T(3.0));
+  // Diagonal
+  std::vector<T> d;
+  m.Diagonal(&d);
+  EXPECT_EQ(d, std::vector<T>({T(1.0), T(-1.0), T(0.0)}));
+  // Transpose matches dense transpose
+  FK::SparseMatrix<T> mt;
+  m.Transpose(&mt);
+  EXPECT_EQ(mt.rows(), 4);
+  EXPECT_EQ(mt.cols(), 3);
+  std::vector<T> dense(12), dense_t(12);
+  m.ToDense(dense.data(), 4);
+  mt.ToDense(dense_t.data(), 3);
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 4; ++c) {
+      EXPECT_EQ(dense[r * 4 + c], dense_t[c * 3 + r]);
+    }
+  }
+  // Out of bounds
+  t.push_back({3, 0, T(1.0)});
+  EXPECT_EQ(m.FromTriplets(3, 4, t).Code(), FK::Status::Type::kInvalidArgument);
+}
+
+TYPED_TEST(SparseMatrixTest, Products) {
+  using T = TypeParam;
+  namespace FK = FaceKit;
+  const T tol = TestFixture::Tol();
+  // Large enough to go through the parallel path
+  const int rows = 1500, cols = 700, k = 5;
+  FK::SparseMatrix<T> a;
+  ASSERT_TRUE(a.FromTriplets(rows,
+                             cols,
+                             TestFixture::Random(rows, cols, 0.05, 1)).Good());
+  std::vector<T> da(rows * cols);
+  a.ToDense(da.data(), cols);
+  std::mt19937 gen(2);
+  std::uniform_real_distribution<T> dist(T(-1.0), T(1.0));
+  std::vector<T> x(cols * k), y(rows * k);
+  for (auto& v : x) v = dist(gen);
+  for (auto& v : y) v = dist(gen);
+  // Spmv
+  std::vector<T> yv(y.begin(), y.begin() + rows);
+  a.Spmv(T(2.0), x.data(), T(0.5), yv.data());
+  for (int r = 0; r < rows; ++r) {
+    T e = T(0.0);
+    for (int c = 0; c < cols; ++c) {
+      e += da[r * cols + c] * x[c];
+    }
+    ASSERT_NEAR(yv[r], T(2.0) * e + T(0.5) * y[r], tol * 10);
+  }
+  // Spmm
+  std::vector<T> ym = y;
+  a.Spmm(T(1.0), x.data(), k, k, T(-1.0), ym.data(), k);
+  for (int r = 0; r < rows; ++r) {
+    for (int j = 0; j < k; ++j) {
+      T e = T(0.0);
+      for (int c = 0; c < cols; ++c) {
+        e += da[r * cols + c] * x[c * k + j];
+      }
+      ASSERT_NEAR(ym[r * k + j], e - y[r * k + j], tol * 10);
+    }
+  }
+  // Sparse * sparse
+  FK::SparseMatrix<T> b, c;
+  ASSERT_TRUE(b.FromTriplets(cols, 40, TestFixture::Random(cols,
+                                                           40,
+                                                           0.1,
+                                                           3)).Good());
+  ASSERT_TRUE(FK::SparseMatrix<T>::Multiply(a, b, &c).Good());
+  EXPECT_EQ(c.rows(), rows);
+  EXPECT_EQ(c.cols(), 40);
+  std::vector<T> db(cols * 40), dc(rows * 40);
+  b.ToDense(db.data(), 40);
+  c.ToDense(dc.data(), 40);
+  for (int r = 0; r < rows; ++r) {
+    for (int j = 0; j < 40; ++j) {
+      T e = T(0.0);
+      for (int p = 0; p < cols; ++p) {
+        e += da[r * cols + p] * db[p * 40 + j];
+      }
+      ASSERT_NEAR(dc[r * 40 + j], e, tol * 10);
+    }
+  }
+  EXPECT_FALSE(FK::SparseMatrix<T>::Multiply(b, b, &c).Good());
+}
+
+TYPED_TEST(SparseMatrixTest, ConjugateGradient) {
+  using T = TypeParam;
+  namespace FK = FaceKit;
+  const int n = 200;
+  FK::SparseMatrix<T> a;
+  ASSERT_TRUE(a.FromTriplets(n, n, TestFixture::Laplacian(n)).Good());
+  // b = A * x_ref
+  std::vector<T> x_ref(n), b(n), x(n, T(0.0));
+  for (int i = 0; i < n; ++i) {
+    x_ref[i] = std::sin(T(0.1) * i);
+  }
+  a.Spmv(T(1.0), x_ref.data(), T(0.0), b.data());
+  FK::ConjugateGradient<T> cg;
+  cg.set_tolerance(sizeof(T) == 4 ? T(1e-6) : T(1e-12));
+  EXPECT_TRUE(cg.Solve(a, b.data(), x.data()).Good());
+  EXPECT_GT(cg.iterations(), 0);
+  EXPECT_LE(cg.iterations(), n + 10);
+  for (int i = 0; i < n; ++i) {
+    EXPECT_NEAR(x[i], x_ref[i], sizeof(T) == 4 ? T(5e-2) : T(1e-6));
+  }
+  // Iteration budget exhausted
+  std::fill(x.begin(), x.end(), T(0.0));
+  cg.set_max_iterations(2);
+  EXPECT_EQ(cg.Solve(a, b.data(), x.data()).Code(),
+            FK::Status::Type::kInternalError);
+  EXPECT_EQ(cg.iterations(), 2);
+  // Not square
+  FK::SparseMatrix<T> r(3, 4);
+  EXPECT_EQ(cg.Solve(r, b.data(), x.data()).Code(),
+            FK::Status::Type::kInvalidArgument);
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Disable logger
+  FaceKit::Logger::Instance().Disable();
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
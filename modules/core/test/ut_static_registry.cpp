@@ -0,0 +1,94 @@
+/**
+ *  @file   ut_static_registry.cpp
+ *  @brief Unit test for static registry
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/utils/static_registry.hpp"
+
+namespace FK = FaceKit;
+
+/** Registry entry */
+struct Entry {
+  const char* name;
+  int value;
+};
+
+/** Filled by static constructors of this file */
+static FK::StaticRegistry<Entry, 4> registry;
+
+/** Register an entry at load time */
+struct Registerer {
+  Registerer(const char* name, const int value) {
+    registry.Add(Entry{name, value});
+  }
+};
+static Registerer first("first", 1);
+static Registerer second("second", 2);
+
+TEST(StaticRegistry, StaticRegistration) {
+  ASSERT_EQ(registry.size(), 2);
+  const Entry* e = registry.FindIf([](const Entry& e) {
+    return std::strcmp(e.name, "second") == 0;
+  });
+  ASSERT_NE(e, nullptr);
+  EXPECT_EQ(e->value, 2);
+  EXPECT_EQ(registry[0].value, 1);
+  EXPECT_EQ(registry.FindIf([](const Entry& e) {
+    return std::strcmp(e.name, "third") == 0;
+  }), nullptr);
+}
+
+TEST(StaticRegistry, Capacity) {
+  static FK::StaticRegistry<int, 3> reg;
+  EXPECT_EQ(reg.capacity(), 3);
+  EXPECT_TRUE(reg.Add(1));
+  EXPECT_TRUE(reg.Add(2));
+  EXPECT_TRUE(reg.Add(3));
+  EXPECT_FALSE(reg.Add(4));
+  EXPECT_EQ(reg.size(), 3);
+}
+
+TEST(StaticRegistry, ConcurrentAdd) {
+  static FK::StaticRegistry<int, 1024> reg;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([t]() {
+      for (int k = 0; k < 256; ++k) {
+        const int value = t * 256 + k;
+        EXPECT_TRUE(reg.Add(value));
+        // Published right away
+        EXPECT_NE(reg.FindIf([value](const int& v) { return v == value; }),
+                  nullptr);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(reg.size(), 1024);
+  std::vector<bool> seen(1024, false);
+  for (size_t k = 0; k < reg.size(); ++k) {
+    seen[reg[k]] = true;
+  }
+  for (size_t k = 0; k < seen.size(); ++k) {
+    EXPECT_TRUE(seen[k]);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
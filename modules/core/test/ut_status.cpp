@@ -8,6 +8,8 @@
  *  Copyright © 2018 Christophe Ecabert. All rights reserved.
  */
 
+#include <utility>
+
 #include "gtest/gtest.h"
 
 #include "facekit/core/status.hpp"
@@ -112,6 +114,46 @@ TEST(Status, ToString) {
   EXPECT_EQ(s9.ToString(), "Unknown code (-10): message");
 }
 
+TEST(Status, Ok) {
+  namespace FK = FaceKit;
+  using Type = FK::Status::Type;
+  FK::Status s = FK::Status::OK();
+  EXPECT_TRUE(s.Good());
+  EXPECT_EQ(s, FK::Status());
+  // No heap state
+  EXPECT_EQ(sizeof(FK::Status), sizeof(void*));
+  s.Clear();
+  EXPECT_TRUE(s.Good());
+  FK::Status err(Type::kNotFound, "message");
+  err.Clear();
+  EXPECT_EQ(err, FK::Status::OK());
+  EXPECT_EQ(err.Message(), "");
+}
+
+TEST(Status, Move) {
+  namespace FK = FaceKit;
+  using Type = FK::Status::Type;
+  FK::Status s1(Type::kNotFound, "message");
+  FK::Status s2(std::move(s1));
+  EXPECT_EQ(s2.Code(), Type::kNotFound);
+  EXPECT_EQ(s2.Message(), "message");
+  FK::Status s3;
+  s3 = std::move(s2);
+  EXPECT_EQ(s3.Code(), Type::kNotFound);
+  EXPECT_EQ(s3.Message(), "message");
+}
+
+TEST(Status, KeepFirstError) {
+  namespace FK = FaceKit;
+  using Type = FK::Status::Type;
+  FK::Status s(Type::kNotFound, "first");
+  s = FK::Status(Type::kInternalError, "second");
+  EXPECT_EQ(s.Code(), Type::kNotFound);
+  EXPECT_EQ(s.Message(), "first");
+  s = FK::Status::OK();
+  EXPECT_EQ(s.Code(), Type::kNotFound);
+}
+
 
 int main(int argc, char* argv[]) {
   // Init gtest framework
@@ -0,0 +1,110 @@
+/**
+ *  @file   ut_task_graph.cpp
+ *  @brief Unit test for task graph
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   17.12.17
+ *  Copyright © 2017 Christophe Ecabert. All rights reserved.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/task_graph.hpp"
+#include "facekit/core/logger.hpp"
+
+TEST(TaskGraph, Order) {
+  namespace FK = FaceKit;
+  // Several frames going through a 3 stages pipeline, stages of a frame are
+  // sequential, frames are independent
+  FK::TaskGraph graph;
+  const size_t n_frame = 16;
+  std::mutex lock;
+  std::vector<std::vector<int>> trace(n_frame);
+  for (size_t f = 0; f < n_frame; ++f) {
+    FK::TaskGraph::NodeId prev = 0;
+    for (int s = 0; s < 3; ++s) {
+      auto id = graph.AddNode("stage" + std::to_string(s),
+                              [&trace, &lock, f, s](void) {
+        std::lock_guard<std::mutex> l(lock);
+        trace[f].push_back(s);
+      });
+      if (s > 0) {
+        EXPECT_TRUE(graph.AddDependency(prev, id).Good());
+      }
+      prev = id;
+    }
+  }
+  EXPECT_EQ(graph.size(), 3 * n_frame);
+  // Can be run several times
+  for (int r = 0; r < 2; ++r) {
+    for (auto& t : trace) {
+      t.clear();
+    }
+    EXPECT_TRUE(graph.Run().Good());
+    for (const auto& t : trace) {
+      EXPECT_EQ(t, std::vector<int>({0, 1, 2}));
+    }
+  }
+}
+
+TEST(TaskGraph, Diamond) {
+  namespace FK = FaceKit;
+  FK::TaskGraph graph;
+  std::atomic<int> a(0), b(0), c(0), d(0);
+  auto na = graph.AddNode("a", [&](void) { a = 1; });
+  auto nb = graph.AddNode("b", [&](void) { b = a + 1; });
+  auto nc = graph.AddNode("c", [&](void) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    c = a + 2;
+  });
+  auto nd = graph.AddNode("d", [&](void) { d = b + c; });
+  EXPECT_TRUE(graph.AddDependency(na, nb).Good());
+  EXPECT_TRUE(graph.AddDependency(na, nc).Good());
+  EXPECT_TRUE(graph.AddDependency(nb, nd).Good());
+  EXPECT_TRUE(graph.AddDependency(nc, nd).Good());
+  EXPECT_TRUE(graph.Run().Good());
+  EXPECT_EQ(d.load(), 5);
+  // Critical path goes through the slow node
+  std::vector<FK::TaskGraph::NodeId> path;
+  double t = graph.CriticalPath(&path);
+  EXPECT_EQ(path, std::vector<FK::TaskGraph::NodeId>({na, nc, nd}));
+  EXPECT_GE(t, 20.0);
+  EXPECT_GE(graph.time(nc), 20.0);
+  EXPECT_EQ(graph.name(nc), "c");
+}
+
+TEST(TaskGraph, Error) {
+  namespace FK = FaceKit;
+  FK::TaskGraph graph;
+  bool called = false;
+  auto n0 = graph.AddNode("load", [](void) {
+    throw std::runtime_error("missing file");
+  });
+  auto n1 = graph.AddNode("save", [&called](void) { called = true; });
+  EXPECT_FALSE(graph.AddDependency(n0, n0).Good());
+  EXPECT_FALSE(graph.AddDependency(n0, 42).Good());
+  EXPECT_TRUE(graph.AddDependency(n0, n1).Good());
+  auto s = graph.Run();
+  EXPECT_EQ(s.Code(), FK::Status::Type::kInternalError);
+  EXPECT_FALSE(called);
+  // Cycle
+  EXPECT_TRUE(graph.AddDependency(n1, n0).Good());
+  EXPECT_EQ(graph.Run().Code(), FK::Status::Type::kInvalidArgument);
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Disable logger
+  FaceKit::Logger::Instance().Disable();
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
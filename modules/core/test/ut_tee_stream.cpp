@@ -0,0 +1,88 @@
+/**
+ *  @file   ut_tee_stream.cpp
+ *  @brief Unit test for mirroring streams
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/tee_stream.hpp"
+
+namespace FK = FaceKit;
+
+TEST(TeeStream, Mirror) {
+  std::ostringstream a, b;
+  FK::TeeStream tee;
+  tee.LinkStream(a);
+  tee.LinkStream(b);
+  tee << "value " << 42 << std::endl;
+  EXPECT_EQ(a.str(), "value 42\n");
+  EXPECT_EQ(b.str(), "value 42\n");
+}
+
+TEST(AsyncTeeStream, Mirror) {
+  std::ostringstream primary, secondary;
+  std::string expected;
+  {
+    FK::AsyncTeeStream tee(primary, secondary);
+    for (int i = 0; i < 1000; ++i) {
+      tee << "line " << i << "\n";
+      expected += "line " + std::to_string(i) + "\n";
+    }
+    tee.flush();
+    // Primary is written synchronously
+    EXPECT_EQ(primary.str(), expected);
+    tee.Flush();
+    EXPECT_EQ(secondary.str(), expected);
+    tee << "last";
+  }
+  // Pending data is drained on destruction
+  EXPECT_EQ(primary.str(), expected + "last");
+  EXPECT_EQ(secondary.str(), expected + "last");
+}
+
+TEST(AsyncTeeStream, SmallRing) {
+  // Ring much smaller than the data, the writer waits for the consumer
+  std::ostringstream primary, secondary;
+  const std::string chunk(1000, 'x');
+  {
+    FK::AsyncTeeStream tee(primary, secondary, 256);
+    for (int i = 0; i < 100; ++i) {
+      tee << chunk;
+    }
+  }
+  EXPECT_EQ(primary.str().size(), 100 * chunk.size());
+  EXPECT_EQ(secondary.str().size(), 100 * chunk.size());
+}
+
+TEST(AsyncTeeStream, Drop) {
+  std::ostringstream primary, secondary;
+  const std::string chunk(1000, 'x');
+  size_t n_dropped = 0;
+  {
+    using Policy = FK::AsyncTeeStream::DropPolicy;
+    FK::AsyncTeeStream tee(primary, secondary, 256, Policy::kDrop);
+    for (int i = 0; i < 100; ++i) {
+      tee << chunk;
+    }
+    tee.Flush();
+    n_dropped = tee.n_dropped();
+  }
+  // Primary is complete, secondary misses exactly the dropped bytes
+  EXPECT_EQ(primary.str().size(), 100 * chunk.size());
+  EXPECT_EQ(secondary.str().size() + n_dropped, 100 * chunk.size());
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,418 @@
+/**
+ *  @file   ut_thread_pool.cpp
+ *  @brief Unit test for thread pool
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   17.12.17
+ *  Copyright © 2017 Christophe Ecabert. All rights reserved.
+ */
+
+#include <vector>
+#include <atomic>
+#include <array>
+#include <memory>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/inline_task.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/task_group.hpp"
+#include "facekit/core/logger.hpp"
+
+TEST(ThreadPool, Enqueue) {
+  namespace FK = FaceKit;
+  using TaskPriority = FK::ThreadPool::TaskPriority;
+  auto& pool = FK::ThreadPool::Get();
+  // Launch job
+  std::vector<std::future<int>> tasks;
+  for (int i = 0; i < 1000; ++i) {
+    tasks.push_back(pool.Enqueue(TaskPriority::kNormal,
+                                 [](const int& k) { return k * k; },
+                                 i));
+  }
+  // Check results
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(tasks[i].get(), i * i);
+  }
+}
+
+TEST(ThreadPool, MixedPriority) {
+  namespace FK = FaceKit;
+  using TaskPriority = FK::ThreadPool::TaskPriority;
+  auto& pool = FK::ThreadPool::Get();
+  const TaskPriority prio[] = {TaskPriority::kLow,
+                               TaskPriority::kNormal,
+                               TaskPriority::kHigh};
+  std::atomic<int> cnt(0);
+  std::vector<std::future<void>> tasks;
+  for (int i = 0; i < 999; ++i) {
+    tasks.push_back(pool.Enqueue(prio[i % 3], [&cnt](void) { ++cnt; }));
+  }
+  for (auto& t : tasks) {
+    t.wait();
+  }
+  EXPECT_EQ(cnt.load(), 999);
+}
+
+TEST(ThreadPool, NestedEnqueue) {
+  namespace FK = FaceKit;
+  using TaskPriority = FK::ThreadPool::TaskPriority;
+  auto& pool = FK::ThreadPool::Get();
+  // Each outer task spawns inner tasks on its local queue, which are stolen by
+  // idle workers
+  std::atomic<int> cnt(0);
+  std::vector<std::future<std::vector<std::future<void>>>> outer;
+  for (int i = 0; i < 8; ++i) {
+    outer.push_back(pool.Enqueue(TaskPriority::kNormal, [&pool, &cnt](void) {
+      EXPECT_GE(pool.worker_index(), 0);
+      std::vector<std::future<void>> inner;
+      for (int k = 0; k < 100; ++k) {
+        inner.push_back(pool.Enqueue(TaskPriority::kNormal,
+                                     [&cnt](void) { ++cnt; }));
+      }
+      return inner;
+    }));
+  }
+  for (auto& o : outer) {
+    for (auto& i : o.get()) {
+      i.wait();
+    }
+  }
+  EXPECT_EQ(cnt.load(), 800);
+  EXPECT_EQ(pool.worker_index(), -1);
+}
+
+TEST(ThreadPool, ParallelFor) {
+  namespace FK = FaceKit;
+  auto& pool = FK::ThreadPool::Get();
+  const size_t grains[] = {0, 1, 7, 1000, 5000};
+  for (const auto& g : grains) {
+    std::vector<int> data(4321, 0);
+    pool.ParallelFor(0, data.size(), g, [&data](const size_t& first,
+                                                const size_t& last) {
+      for (size_t i = first; i < last; ++i) {
+        data[i] += static_cast<int>(i);
+      }
+    });
+    for (size_t i = 0; i < data.size(); ++i) {
+      EXPECT_EQ(data[i], static_cast<int>(i));
+    }
+  }
+  // Empty range
+  bool called = false;
+  pool.ParallelFor(10, 10, 0, [&called](const size_t&, const size_t&) {
+    called = true;
+  });
+  EXPECT_FALSE(called);
+}
+
+TEST(ThreadPool, NestedParallelFor) {
+  namespace FK = FaceKit;
+  auto& pool = FK::ThreadPool::Get();
+  std::vector<std::atomic<int>> data(64);
+  for (auto& d : data) {
+    d = 0;
+  }
+  pool.ParallelFor(0, data.size(), 1, [&](const size_t& first,
+                                          const size_t& last) {
+    for (size_t i = first; i < last; ++i) {
+      pool.ParallelFor(0, 100, 3, [&](const size_t& f, const size_t& l) {
+        data[i] += static_cast<int>(l - f);
+      });
+    }
+  });
+  for (const auto& d : data) {
+    EXPECT_EQ(d.load(), 100);
+  }
+}
+
+TEST(ThreadPool, ParallelForException) {
+  namespace FK = FaceKit;
+  auto& pool = FK::ThreadPool::Get();
+  EXPECT_THROW(pool.ParallelFor(0, 100, 1, [](const size_t& first,
+                                              const size_t&) {
+    if (first == 42) {
+      throw std::runtime_error("Error");
+    }
+  }), std::runtime_error);
+}
+
+TEST(ThreadPool, ParallelReduce) {
+  namespace FK = FaceKit;
+  auto& pool = FK::ThreadPool::Get();
+  const size_t n = 100000;
+  const size_t grains[] = {0, 1, 333, 2 * n};
+  for (const auto& g : grains) {
+    auto sum = pool.ParallelReduce<size_t>(0, n, g, 0,
+                                           [](const size_t& first,
+                                              const size_t& last) {
+      size_t s = 0;
+      for (size_t i = first; i < last; ++i) {
+        s += i;
+      }
+      return s;
+    }, [](const size_t& a, const size_t& b) {
+      return a + b;
+    });
+    EXPECT_EQ(sum, n * (n - 1) / 2);
+  }
+  // Empty range give identity
+  auto v = pool.ParallelReduce<int>(5, 5, 0, -1,
+                                    [](const size_t&, const size_t&) {
+    return 0;
+  }, [](const int& a, const int& b) { return a + b; });
+  EXPECT_EQ(v, -1);
+}
+
+TEST(ThreadPool, Registry) {
+  namespace FK = FaceKit;
+  using TaskPriority = FK::ThreadPool::TaskPriority;
+  EXPECT_EQ(FK::ThreadPool::Find("io"), nullptr);
+  FK::ThreadPool::Options opt(2);
+  opt.name = "io";
+  auto& io = FK::ThreadPool::Get(opt);
+  EXPECT_EQ(io.size(), 2);
+  EXPECT_EQ(io.name(), "io");
+  EXPECT_EQ(FK::ThreadPool::Find("io"), &io);
+  // Existing pool is returned, options ignored
+  opt.size = 5;
+  EXPECT_EQ(&FK::ThreadPool::Get(opt), &io);
+  EXPECT_NE(&FK::ThreadPool::Get(), &io);
+  EXPECT_EQ(FK::ThreadPool::Find("default"), &FK::ThreadPool::Get());
+  // Worker belongs to one pool only
+  auto f = io.Enqueue(TaskPriority::kNormal, [&io](void) {
+    return std::make_pair(io.worker_index(),
+                          FK::ThreadPool::Get().worker_index());
+  });
+  auto idx = f.get();
+  EXPECT_GE(idx.first, 0);
+  EXPECT_EQ(idx.second, -1);
+}
+
+TEST(ThreadPool, Standalone) {
+  namespace FK = FaceKit;
+  FK::ThreadPool::Options opt(3);
+  opt.name = "local";
+  opt.cpus = {0};
+  opt.pin_workers = true;
+  std::atomic<int> cnt(0);
+  {
+    FK::ThreadPool pool(opt);
+    EXPECT_EQ(pool.size(), 3);
+    EXPECT_EQ(FK::ThreadPool::Find("local"), nullptr);
+    pool.ParallelFor(0, 300, 1, [&cnt](const size_t&, const size_t&) {
+      ++cnt;
+    });
+#if defined(__linux__)
+    auto f = pool.Enqueue(FK::ThreadPool::TaskPriority::kNormal, [](void) {
+      return sched_getcpu();
+    });
+    EXPECT_EQ(f.get(), 0);
+#endif
+  }
+  EXPECT_EQ(cnt.load(), 300);
+}
+
+TEST(ThreadPool, Statistics) {
+  namespace FK = FaceKit;
+  using TaskPriority = FK::ThreadPool::TaskPriority;
+  FK::ThreadPool::Options opt(2);
+  opt.name = "stats";
+  FK::ThreadPool pool(opt);
+  pool.EnableStatistics(true);
+  std::vector<std::future<void>> tasks;
+  for (int i = 0; i < 100; ++i) {
+    tasks.push_back(pool.Enqueue(TaskPriority::kNormal, [](void) {}));
+  }
+  for (auto& t : tasks) {
+    t.wait();
+  }
+  // Completion of the future is signaled before the counters are updated
+  FK::ThreadPoolStatistic stats;
+  do {
+    std::this_thread::yield();
+    pool.GatherStatistics(&stats);
+  } while (stats.n_executed != 100);
+  EXPECT_EQ(stats.n_enqueued, 100);
+  EXPECT_EQ(stats.queue_depth, 0);
+  EXPECT_EQ(stats.worker_executed.size(), 2);
+  EXPECT_EQ(stats.worker_executed[0] + stats.worker_executed[1], 100);
+  size_t n_wait = 0, n_run = 0;
+  for (size_t k = 0; k < FK::ThreadPoolStatistic::kNBin; ++k) {
+    n_wait += stats.wait_time[k];
+    n_run += stats.run_time[k];
+  }
+  EXPECT_EQ(n_wait, 100);
+  EXPECT_EQ(n_run, 100);
+  EXPECT_NE(stats.ToString().find("Executed:      100"), std::string::npos);
+  // Reset
+  pool.ClearStatistics();
+  pool.GatherStatistics(&stats);
+  EXPECT_EQ(stats.n_enqueued, 0);
+  EXPECT_EQ(stats.n_executed, 0);
+}
+
+TEST(InlineTask, Storage) {
+  namespace FK = FaceKit;
+  // Small callable, stored inline
+  int cnt = 0;
+  FK::InlineTask t0([&cnt](void) { ++cnt; });
+  EXPECT_TRUE(static_cast<bool>(t0));
+  t0();
+  // Move transfers ownership
+  FK::InlineTask t1(std::move(t0));
+  EXPECT_FALSE(static_cast<bool>(t0));
+  t1();
+  EXPECT_EQ(cnt, 2);
+  // Large callable, stored on the heap
+  std::array<int, 64> big;
+  big.fill(1);
+  FK::InlineTask t2([big, &cnt](void) { cnt += big[63]; });
+  t1 = std::move(t2);
+  t1();
+  EXPECT_EQ(cnt, 3);
+  // Move-only callable get released with the task
+  auto ptr = std::make_shared<int>(0);
+  std::weak_ptr<int> wptr = ptr;
+  {
+    std::unique_ptr<std::shared_ptr<int>> p(new std::shared_ptr<int>(ptr));
+    ptr.reset();
+    struct MoveOnly {
+      std::unique_ptr<std::shared_ptr<int>> p;
+      void operator()(void) { ++(**p); }
+    };
+    FK::InlineTask t3(MoveOnly{std::move(p)});
+    t3();
+    EXPECT_EQ(*wptr.lock(), 1);
+  }
+  EXPECT_TRUE(wptr.expired());
+}
+
+TEST(ThreadPool, EnqueueException) {
+  namespace FK = FaceKit;
+  using TaskPriority = FK::ThreadPool::TaskPriority;
+  auto& pool = FK::ThreadPool::Get();
+  auto f = pool.Enqueue(TaskPriority::kNormal, [](void) -> int {
+    throw std::runtime_error("Error");
+  });
+  EXPECT_THROW(f.get(), std::runtime_error);
+}
+
+TEST(ThreadPool, Submit) {
+  namespace FK = FaceKit;
+  using TaskPriority = FK::ThreadPool::TaskPriority;
+  auto& pool = FK::ThreadPool::Get();
+  std::atomic<int> cnt(0);
+  const int n = 10000;
+  for (int i = 0; i < n; ++i) {
+    pool.Submit(TaskPriority::kNormal, [&cnt](const int& k) {
+      cnt += k;
+    }, 1);
+  }
+  // Exception in fire-and-forget task does not bring worker down
+  pool.Submit(TaskPriority::kHigh, [](void) {
+    throw std::runtime_error("Error");
+  });
+  // No future, wait on the counter
+  while (cnt.load() != n) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(cnt.load(), n);
+  // Worker still alive
+  auto f = pool.Enqueue(TaskPriority::kNormal, [](void) { return 1; });
+  EXPECT_EQ(f.get(), 1);
+}
+
+TEST(TaskGroup, Wait) {
+  namespace FK = FaceKit;
+  std::atomic<int> cnt(0);
+  FK::TaskGroup group;
+  for (int i = 0; i < 1000; ++i) {
+    group.Run([&cnt](void) { ++cnt; });
+  }
+  group.Wait();
+  EXPECT_EQ(cnt.load(), 1000);
+  // Reusable
+  group.Run([&cnt](void) { ++cnt; });
+  group.Wait();
+  EXPECT_EQ(cnt.load(), 1001);
+}
+
+TEST(TaskGroup, Nested) {
+  namespace FK = FaceKit;
+  // More blocking groups than workers, waiters help instead of sleeping
+  auto& pool = FK::ThreadPool::Get();
+  std::atomic<int> cnt(0);
+  FK::TaskGroup outer;
+  const int n_outer = static_cast<int>(4 * pool.size() + 1);
+  for (int i = 0; i < n_outer; ++i) {
+    outer.Run([&cnt](void) {
+      FK::TaskGroup inner;
+      for (int k = 0; k < 50; ++k) {
+        inner.Run([&cnt](void) { ++cnt; });
+      }
+      inner.Wait();
+    });
+  }
+  outer.Wait();
+  EXPECT_EQ(cnt.load(), n_outer * 50);
+}
+
+TEST(TaskGroup, Cancel) {
+  namespace FK = FaceKit;
+  FK::ThreadPool::Options opt(1);
+  opt.name = "cancel";
+  FK::ThreadPool pool(opt);
+  std::atomic<int> cnt(0);
+  std::atomic<bool> go(false);
+  FK::TaskGroup group(&pool);
+  // Block single worker, then cancel queued tasks. Injection queue is FIFO,
+  // counting tasks can not start before the blocking one
+  group.Run([&go](void) {
+    while (!go.load()) {
+      std::this_thread::yield();
+    }
+  });
+  for (int i = 0; i < 100; ++i) {
+    group.Run([&cnt](void) { ++cnt; });
+  }
+  group.Cancel();
+  EXPECT_TRUE(group.is_cancelled());
+  go = true;
+  group.Wait();
+  EXPECT_EQ(cnt.load(), 0);
+  EXPECT_FALSE(group.is_cancelled());
+}
+
+TEST(TaskGroup, Exception) {
+  namespace FK = FaceKit;
+  FK::TaskGroup group;
+  std::atomic<int> cnt(0);
+  for (int i = 0; i < 100; ++i) {
+    group.Run([i, &cnt](void) {
+      if (i == 42) {
+        throw std::runtime_error("Error");
+      }
+      ++cnt;
+    });
+  }
+  EXPECT_THROW(group.Wait(), std::runtime_error);
+  EXPECT_LE(cnt.load(), 99);
+  // Error cleared
+  group.Run([](void) {});
+  EXPECT_NO_THROW(group.Wait());
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Disable logger
+  FaceKit::Logger::Instance().Disable();
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
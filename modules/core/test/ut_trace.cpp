@@ -0,0 +1,137 @@
+/**
+ *  @file   ut_trace.cpp
+ *  @brief Unit test for scoped tracing zones
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   06.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/trace.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/logger.hpp"
+
+namespace FK = FaceKit;
+
+/** Count occurences of a pattern */
+static size_t Count(const std::string& str, const std::string& pattern) {
+  size_t n = 0;
+  for (size_t p = str.find(pattern); p != std::string::npos;
+       p = str.find(pattern, p + pattern.size())) {
+    ++n;
+  }
+  return n;
+}
+
+TEST(Trace, Disabled) {
+  auto& tracer = FK::Tracer::Get();
+  FK::Tracer::Enable(false);
+  tracer.Clear();
+  {
+    FACEKIT_TRACE_SCOPE("Disabled");
+  }
+  EXPECT_EQ(tracer.Size(), 0u);
+}
+
+TEST(Trace, Scopes) {
+  auto& tracer = FK::Tracer::Get();
+  tracer.Clear();
+  FK::Tracer::Enable(true);
+  const int n_thread = 3;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < n_thread; ++t) {
+    threads.emplace_back([]() {
+      FACEKIT_TRACE_SCOPE("Outer");
+      for (int i = 0; i < 10; ++i) {
+        FACEKIT_TRACE_SCOPE("Inner");
+      }
+    });
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  FK::Tracer::Enable(false);
+  EXPECT_EQ(tracer.Size(), static_cast<size_t>(n_thread * 11));
+  std::ostringstream stream;
+  ASSERT_TRUE(tracer.ExportChromeTrace(stream).Good());
+  const std::string str = stream.str();
+  EXPECT_EQ(str.find("{\"traceEvents\":["), 0u);
+  EXPECT_EQ(Count(str, "\"name\":\"Outer\""), static_cast<size_t>(n_thread));
+  EXPECT_EQ(Count(str, "\"name\":\"Inner\""),
+            static_cast<size_t>(n_thread * 10));
+  EXPECT_EQ(Count(str, "\"ph\":\"X\""), static_cast<size_t>(n_thread * 11));
+  // Buffers of exited threads are released
+  tracer.Clear();
+  EXPECT_EQ(tracer.Size(), 0u);
+}
+
+TEST(Trace, Capacity) {
+  auto& tracer = FK::Tracer::Get();
+  tracer.Clear();
+  tracer.set_buffer_capacity(5);
+  FK::Tracer::Enable(true);
+  for (int i = 0; i < 8; ++i) {
+    FACEKIT_TRACE_SCOPE("Capped");
+  }
+  FK::Tracer::Enable(false);
+  EXPECT_EQ(tracer.Size(), 5u);
+  EXPECT_EQ(tracer.get_n_dropped(), 3u);
+  tracer.set_buffer_capacity(FK::Tracer::kDefaultBufferCapacity);
+  tracer.Clear();
+}
+
+TEST(Trace, ThreadPool) {
+  auto& tracer = FK::Tracer::Get();
+  tracer.Clear();
+  FK::Tracer::Enable(true);
+  {
+    // Zone is closed after the result is published, wait for the workers
+    FK::ThreadPool pool(2);
+    auto f = pool.Enqueue(FK::ThreadPool::TaskPriority::kNormal,
+                          []() { return 1; });
+    EXPECT_EQ(f.get(), 1);
+  }
+  FK::Tracer::Enable(false);
+  std::ostringstream stream;
+  ASSERT_TRUE(tracer.ExportChromeTrace(stream).Good());
+  EXPECT_NE(stream.str().find("ThreadPool::Task"), std::string::npos);
+  tracer.Clear();
+}
+
+TEST(Trace, Counters) {
+  auto& tracer = FK::Tracer::Get();
+  tracer.Clear();
+  FK::Tracer::Enable(true);
+  FK::Tracer::EnableCounters(true);
+  {
+    FACEKIT_TRACE_SCOPE("Counted");
+  }
+  FK::Tracer::EnableCounters(false);
+  {
+    FACEKIT_TRACE_SCOPE("NotCounted");
+  }
+  FK::Tracer::Enable(false);
+  std::ostringstream stream;
+  ASSERT_TRUE(tracer.ExportChromeTrace(stream).Good());
+  // Counters are only present if the platform allows them
+  const size_t n = FK::PerfCounters::ThreadCounters() ? 1 : 0;
+  EXPECT_EQ(Count(stream.str(), "\"args\":{"), n);
+  tracer.Clear();
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Disable logger
+  FaceKit::Logger::Instance().Disable();
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
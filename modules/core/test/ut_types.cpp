@@ -8,7 +8,9 @@
  *  Copyright © 2018 Christophe Ecabert. All rights reserved.
  */
 
+#include <cmath>
 #include <limits>
+#include <type_traits>
 
 #include "gtest/gtest.h"
 
@@ -32,6 +34,7 @@ TEST(Types, DataTypeToString) {
   EXPECT_EQ(FK::DataTypeToString(FK::DataType::kDouble), "double");
   EXPECT_EQ(FK::DataTypeToString(FK::DataType::kBool), "bool");
   EXPECT_EQ(FK::DataTypeToString(FK::DataType::kString), "string");
+  EXPECT_EQ(FK::DataTypeToString(FK::DataType::kHalf), "half");
   EXPECT_EQ(FK::DataTypeToString((FK::DataType)32), "unsupported");
 }
 
@@ -63,6 +66,8 @@ TEST(Types, DataTypeFromString) {
   EXPECT_EQ(type, FK::DataType::kBool);
   EXPECT_TRUE(FK::DataTypeFromString("string", &type));
   EXPECT_EQ(type, FK::DataType::kString);
+  EXPECT_TRUE(FK::DataTypeFromString("half", &type));
+  EXPECT_EQ(type, FK::DataType::kHalf);
   // Wrong entry
   type = FK::DataType::kUnknown;
   EXPECT_FALSE(FK::DataTypeFromString("char", &type));
@@ -84,6 +89,7 @@ TEST(Types, IsDataTypeValid) {
   EXPECT_TRUE((bool)FK::IsDataTypeValid<double>::value);
   EXPECT_TRUE((bool)FK::IsDataTypeValid<bool>::value);
   EXPECT_TRUE((bool)FK::IsDataTypeValid<std::string>::value);
+  EXPECT_TRUE((bool)FK::IsDataTypeValid<FK::Half>::value);
   // Invalid
   struct MyStruct {
     int a;
@@ -107,6 +113,7 @@ TEST(Types, DataTypeToEnum) {
   EXPECT_EQ((DType)FK::DataTypeToEnum<double>::value, DType::kDouble);
   EXPECT_EQ((DType)FK::DataTypeToEnum<bool>::value, DType::kBool);
   EXPECT_EQ((DType)FK::DataTypeToEnum<std::string>::value, DType::kString);
+  EXPECT_EQ((DType)FK::DataTypeToEnum<FK::Half>::value, DType::kHalf);
 }
 
 TEST(Types, DataTypeSize) {
@@ -125,6 +132,7 @@ TEST(Types, DataTypeSize) {
   EXPECT_EQ((size_t)FK::DataTypeSize<DType::kDouble>::value, sizeof(double));
   EXPECT_EQ((size_t)FK::DataTypeSize<DType::kBool>::value, sizeof(bool));
   EXPECT_EQ((size_t)FK::DataTypeSize<DType::kString>::value, sizeof(std::string));
+  EXPECT_EQ((size_t)FK::DataTypeSize<DType::kHalf>::value, 2);
   // Invalid
   EXPECT_EQ((size_t)FK::DataTypeSize<(DType)20>::value, 0);
   EXPECT_EQ((size_t)FK::DataTypeSize<(DType)42>::value, 0);
@@ -147,6 +155,7 @@ TEST(Types, DataTypeDynamicSize) {
   EXPECT_EQ((size_t)FK::DataTypeDynamicSize(DType::kDouble), sizeof(double));
   EXPECT_EQ((size_t)FK::DataTypeDynamicSize(DType::kBool), sizeof(bool));
   EXPECT_EQ((size_t)FK::DataTypeDynamicSize(DType::kString), sizeof(std::string));
+  EXPECT_EQ((size_t)FK::DataTypeDynamicSize(DType::kHalf), 2);
   // Invalid
   EXPECT_EQ((size_t)FK::DataTypeDynamicSize((DType)20),
             std::numeric_limits<size_t>::max());
@@ -154,6 +163,33 @@ TEST(Types, DataTypeDynamicSize) {
             std::numeric_limits<size_t>::max());
 }
 
+TEST(Types, Half) {
+  namespace FK = FaceKit;
+  EXPECT_TRUE(std::is_trivial<FK::Half>::value);
+  // Exact values
+  EXPECT_EQ(FK::Half(1.f).bits, 0x3C00);
+  EXPECT_EQ(FK::Half(-2.f).bits, 0xC000);
+  EXPECT_EQ(FK::Half(65504.f).bits, 0x7BFF);
+  EXPECT_EQ(FK::Half(0.f).bits, 0x0000);
+  EXPECT_EQ(float(FK::Half::FromBits(0x3555)), 0.333251953125f);
+  // Subnormal
+  EXPECT_EQ(FK::Half(5.9604644775390625e-08f).bits, 0x0001);
+  EXPECT_EQ(float(FK::Half::FromBits(0x0001)), 5.9604644775390625e-08f);
+  // Rounding to nearest even, overflow, inf, nan
+  EXPECT_EQ(FK::Half(1.f + 1.f / 2048.f).bits, 0x3C00);
+  EXPECT_EQ(FK::Half(1.f + 3.f / 2048.f).bits, 0x3C02);
+  EXPECT_EQ(FK::Half(70000.f).bits, 0x7C00);
+  EXPECT_EQ(FK::Half(-std::numeric_limits<float>::infinity()).bits, 0xFC00);
+  EXPECT_TRUE(std::isnan(float(FK::Half(std::nanf("")))));
+  EXPECT_TRUE(std::isinf(float(FK::Half::FromBits(0x7C00))));
+  // Round trip of every finite half
+  for (uint32_t b = 0; b < 0x10000; ++b) {
+    if ((b & 0x7C00) != 0x7C00) {
+      const FK::Half h = FK::Half::FromBits(static_cast<uint16_t>(b));
+      EXPECT_EQ(FK::Half(float(h)).bits, h.bits);
+    }
+  }
+}
 
 int main(int argc, char* argv[]) {
   // Init gtest framework
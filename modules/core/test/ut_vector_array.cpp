@@ -0,0 +1,211 @@
+/**
+ *  @file   ut_vector_array.cpp
+ *  @brief Unit test for structure of arrays vectors
+ *  @ingroup core
+ *
+ *  @author Christophe Ecabert
+ *  @date   24.08.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "facekit/core/math/vector_array.hpp"
+#include "facekit/core/math/quaternion.hpp"
+#include "facekit/core/logger.hpp"
+
+template<typename T>
+class Vector3ArrayTest : public ::testing::Test {
+ public:
+  /** Random vectors, size not multiple of any SIMD width */
+  static std::vector<FaceKit::Vector3<T>> Random(const size_t& n,
+                                                 const int& seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<T> dist(T(-2.0), T(2.0));
+    std::vector<FaceKit::Vector3<T>> v(n);
+    for (auto& e : v) {
+      e = FaceKit::Vector3<T>(dist(gen), dist(gen), dist(gen));
+    }
+    return v;
+  }
+  /** Tolerance */
+  static T Tol(void) {
+    return sizeof(T) == 4 ? T(1e-5) : T(1e-12);
+  }
+};
+
+using Types = ::testing::Types<float, double>;
+TYPED_TEST_CASE(Vector3ArrayTest, Types);
+
+TYPED_TEST(Vector3ArrayTest, Layout) {
+  using T = TypeParam;
+  namespace FK = FaceKit;
+  const auto aos = TestFixture::Random(37, 1);
+  FK::Vector3Array<T> soa(aos);
+  ASSERT_EQ(soa.size(), aos.size());
+  // Aligned streams
+  const size_t align = FK::Vector3Array<T>::kAlignment;
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(soa.x()) % align, 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(soa.y()) % align, 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(soa.z()) % align, 0);
+  // Round trip
+  std::vector<FK::Vector3<T>> back;
+  soa.ToAoS(&back);
+  ASSERT_EQ(back.size(), aos.size());
+  for (size_t i = 0; i < aos.size(); ++i) {
+    EXPECT_EQ(back[i].x_, aos[i].x_);
+    EXPECT_EQ(back[i].y_, aos[i].y_);
+    EXPECT_EQ(back[i].z_, aos[i].z_);
+    EXPECT_EQ(soa.Get(i).z_, aos[i].z_);
+  }
+  // Resize keeps content, new entries are null
+  soa.Resize(40);
+  EXPECT_EQ(soa.Get(36).x_, aos[36].x_);
+  EXPECT_EQ(soa.Get(39).y_, T(0));
+  // Copy / move
+  FK::Vector3Array<T> copy(soa);
+  copy.Set(0, FK::Vector3<T>(T(1), T(2), T(3)));
+  EXPECT_EQ(soa.Get(0).x_, aos[0].x_);
+  FK::Vector3Array<T> moved(std::move(copy));
+  EXPECT_EQ(moved.Get(0).y_, T(2));
+  EXPECT_EQ(copy.size(), 0);
+}
+
+TYPED_TEST(Vector3ArrayTest, Arithmetic) {
+  using T = TypeParam;
+  namespace FK = FaceKit;
+  const auto a = TestFixture::Random(37, 2);
+  const auto b = TestFixture::Random(37, 3);
+  FK::Vector3Array<T> sa(a);
+  FK::Vector3Array<T> sb(b);
+  const T tol = TestFixture::Tol();
+  // Dot
+  std::vector<T> dot;
+  EXPECT_TRUE(sa.Dot(sb, &dot).Good());
+  ASSERT_EQ(dot.size(), a.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_NEAR(dot[i], a[i] * b[i], tol);
+  }
+  // Cross
+  FK::Vector3Array<T> c;
+  EXPECT_TRUE(sa.Cross(sb, &c).Good());
+  for (size_t i = 0; i < a.size(); ++i) {
+    const FK::Vector3<T> e = a[i] ^ b[i];
+    EXPECT_NEAR(c.Get(i).x_, e.x_, tol);
+    EXPECT_NEAR(c.Get(i).y_, e.y_, tol);
+    EXPECT_NEAR(c.Get(i).z_, e.z_, tol);
+  }
+  // Add + scale
+  EXPECT_TRUE(sa.Add(sb).Good());
+  sa.Scale(T(0.5));
+  for (size_t i = 0; i < a.size(); ++i) {
+    const FK::Vector3<T> e = (a[i] + b[i]) * T(0.5);
+    EXPECT_NEAR(sa.Get(i).x_, e.x_, tol);
+    EXPECT_NEAR(sa.Get(i).y_, e.y_, tol);
+    EXPECT_NEAR(sa.Get(i).z_, e.z_, tol);
+  }
+  // Normalize, null vector gives NaN
+  sa.Set(5, FK::Vector3<T>());
+  sa.Normalize();
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (i == 5) {
+      EXPECT_TRUE(std::isnan(sa.Get(i).x_));
+    } else {
+      EXPECT_NEAR(sa.Get(i).Norm(), T(1), tol);
+    }
+  }
+  // Size mismatch
+  FK::Vector3Array<T> small(3);
+  EXPECT_FALSE(sa.Add(small).Good());
+  EXPECT_FALSE(sa.Dot(small, &dot).Good());
+  EXPECT_FALSE(sa.Cross(small, &c).Good());
+}
+
+TYPED_TEST(Vector3ArrayTest, Transform) {
+  using T = TypeParam;
+  namespace FK = FaceKit;
+  const auto a = TestFixture::Random(37, 4);
+  const T tol = TestFixture::Tol();
+  // Rotation around z + translation
+  const T ct = std::cos(T(0.3));
+  const T st = std::sin(T(0.3));
+  FK::Matrix3<T> r;
+  r(0, 0) = ct; r(0, 1) = -st;
+  r(1, 0) = st; r(1, 1) = ct;
+  FK::Matrix4<T> m;
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      m(i, j) = r(i, j);
+    }
+  }
+  m(0, 3) = T(1); m(1, 3) = T(-2); m(2, 3) = T(0.5);
+  FK::Vector3Array<T> sa(a);
+  FK::Vector3Array<T> out;
+  sa.Transform(r, &out);
+  for (size_t i = 0; i < a.size(); ++i) {
+    const FK::Vector3<T> e = r * a[i];
+    EXPECT_NEAR(out.Get(i).x_, e.x_, tol);
+    EXPECT_NEAR(out.Get(i).y_, e.y_, tol);
+    EXPECT_NEAR(out.Get(i).z_, e.z_, tol);
+  }
+  // In place
+  sa.Transform(m, &sa);
+  for (size_t i = 0; i < a.size(); ++i) {
+    const FK::Vector3<T> e = r * a[i];
+    EXPECT_NEAR(sa.Get(i).x_, e.x_ + T(1), tol);
+    EXPECT_NEAR(sa.Get(i).y_, e.y_ - T(2), tol);
+    EXPECT_NEAR(sa.Get(i).z_, e.z_ + T(0.5), tol);
+  }
+}
+
+TYPED_TEST(Vector3ArrayTest, TransformPoints) {
+  using T = TypeParam;
+  namespace FK = FaceKit;
+  // Large enough to hit blocks tail and parallel path
+  const auto a = TestFixture::Random(20011, 5);
+  const T* in = reinterpret_cast<const T*>(a.data());
+  const T tol = TestFixture::Tol();
+  FK::Vector3<T> axis(T(0.2), T(-0.5), T(0.8));
+  axis.Normalize();
+  const FK::Quaternion<T> q(axis, T(0.7));
+  FK::Matrix3<T> r;
+  q.ToRotationMatrix(&r);
+  FK::Matrix4<T> m;
+  q.ToRotationMatrix(&m);
+  m(0, 3) = T(0.1); m(1, 3) = T(0.2); m(2, 3) = T(-0.3);
+  const FK::Vector3<T> t(T(0.1), T(0.2), T(-0.3));
+  for (const bool parallel : {false, true}) {
+    std::vector<FK::Vector3<T>> out(a.size());
+    T* po = reinterpret_cast<T*>(out.data());
+    m.TransformPoints(in, po, a.size(), parallel);
+    for (size_t i = 0; i < a.size(); ++i) {
+      const FK::Vector3<T> e = (r * a[i]) + t;
+      ASSERT_NEAR(out[i].x_, e.x_, tol);
+      ASSERT_NEAR(out[i].y_, e.y_, tol);
+      ASSERT_NEAR(out[i].z_, e.z_, tol);
+    }
+    // Rotation only, in place
+    out = a;
+    q.RotatePoints(po, po, a.size(), parallel);
+    for (size_t i = 0; i < a.size(); ++i) {
+      const FK::Vector3<T> e = r * a[i];
+      ASSERT_NEAR(out[i].x_, e.x_, tol);
+      ASSERT_NEAR(out[i].y_, e.y_, tol);
+      ASSERT_NEAR(out[i].z_, e.z_, tol);
+    }
+  }
+}
+
+int main(int argc, char* argv[]) {
+  // Init gtest framework
+  ::testing::InitGoogleTest(&argc, argv);
+  // Disable logger
+  FaceKit::Logger::Instance().Disable();
+  // Run unit test
+  return RUN_ALL_TESTS();
+}
@@ -8,6 +8,7 @@
  *  Copyright © 2017 Christophe Ecabert. All rights reserved.
  */
 
+#include <cstdlib>
 #include <iostream>
 
 #include "facekit/core/cmd_parser.hpp"
@@ -29,12 +30,37 @@ int main(const int argc, const char** argv) {
   parser.AddArgument("-o",
                      FaceKit::CmdLineParser::ArgState::kNeeded,
                      "Location where to output data");
+  parser.AddArgument("-s",
+                     FaceKit::CmdLineParser::ArgState::kOptional,
+                     "In memory, final outputs only (1: stream, 2: pipe)");
+  parser.AddArgument("-u",
+                     FaceKit::CmdLineParser::ArgState::kOptional,
+                     "Only augment new or modified inputs (1: enable)");
+  parser.AddArgument("-d",
+                     FaceKit::CmdLineParser::ArgState::kOptional,
+                     "Resample on an OpenCL device if any (1: enable)");
+  parser.AddArgument("-r",
+                     FaceKit::CmdLineParser::ArgState::kOptional,
+                     "Seconds between two statistics reports (0: end only)");
+  parser.AddArgument("-k",
+                     FaceKit::CmdLineParser::ArgState::kOptional,
+                     "Output sink with -s (dir (default), rec, tar)");
   int err = parser.ParseCmdLine(argc, argv);
   if (err == 0) {
     // Retrieve args
     std::string root_folder, output;
     parser.HasArgument("-i", &root_folder);
     parser.HasArgument("-o", &output);
+    std::string stream;
+    parser.HasArgument("-s", &stream);
+    std::string update;
+    parser.HasArgument("-u", &update);
+    std::string device;
+    parser.HasArgument("-d", &device);
+    std::string report;
+    parser.HasArgument("-r", &report);
+    std::string sink;
+    parser.HasArgument("-k", &sink);
     
     // Create augmentation engine
     FaceKit::AugmentationEngine engine;
@@ -46,9 +72,25 @@ int main(const int argc, const char** argv) {
                                            FK::ImgFlipCell::Direction::kBoth);
     FK::AugmentationEngine::AddImgInPlaneRotationCell(engine, 5.0, 5);
     FK::AugmentationEngine::AddImgCornerCropCell(engine, 300, 300);
+    engine.set_incremental(update == "1");
+    engine.set_device(device == "1");
+    if (!report.empty()) {
+      engine.set_report_interval(std::atof(report.c_str()));
+    }
+    if (sink == "rec") {
+      engine.set_sink(new FK::RecordShardSink());
+    } else if (sink == "tar") {
+      engine.set_sink(new FK::TarShardSink());
+    }
     if (err == 0) {
       // Do augmentation
-      engine.Run(output);
+      if (stream == "1") {
+        engine.RunStreaming(output);
+      } else if (stream == "2") {
+        engine.RunPipelined(output);
+      } else {
+        engine.Run(output);
+      }
       FACEKIT_LOG_INFO("Done");
     } else {
       FACEKIT_LOG_ERROR("No images founded in " + root_folder);
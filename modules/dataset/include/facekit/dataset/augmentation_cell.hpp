@@ -11,8 +11,15 @@
 #ifndef __FACEKIT_AUGMENTATION_CELL__
 #define __FACEKIT_AUGMENTATION_CELL__
 
-#include <vector>
+#include <cstdint>
+#include <ostream>
 #include <string>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/math/philox.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -27,9 +34,46 @@ namespace FaceKit {
  *  @date   24.10.2017
  *  @ingroup dataset
  */
-class AugmentationCell {
+class FK_EXPORTS AugmentationCell {
  public:
   
+#pragma mark -
+#pragma mark Type Definition
+  
+  /** Random generator used by the cells */
+  using Random = Philox4x32;
+  
+  /**
+   *  @struct Sample
+   *  @brief  Decoded image flowing through the cells when streaming, with
+   *          its annotations. Annotations are in pixel coordinates (origin
+   *          at the center of the top left pixel), geometric cells map them
+   *          with the same warp as the pixels.
+   */
+  struct Sample {
+    /** Image, BGR */
+    cv::Mat image;
+    /** File name without extension, each cell appends its own tag */
+    std::string name;
+    /** Landmarks */
+    std::vector<cv::Point2f> landmarks;
+    /** Bounding boxes, axis aligned */
+    std::vector<cv::Rect2f> bboxes;
+  };
+  
+  /**
+   *  @struct Warp
+   *  @brief  Affine mapping from an input image to one generated sample
+   */
+  struct Warp {
+    /** Maps input pixel coordinates to output pixel coordinates */
+    cv::Matx23d transform;
+    /** Output size */
+    cv::Size size;
+    /** Tag appended to the sample name */
+    std::string name;
+  };
+  
 #pragma mark -
 #pragma mark Initialization
   
@@ -58,6 +102,135 @@ class AugmentationCell {
                       const std::string& output,
                       std::vector<std::string>* generated) const = 0;
   
+  /**
+   *  @name   Transform
+   *  @fn     virtual int Transform(const Sample& input,
+                                    std::vector<Sample>* generated) const = 0
+   *  @brief  Run augmentation step on an image already in memory, nothing
+   *          is read from or written to disk. Reentrant.
+   *  @param[in]  input     Sample to augment
+   *  @param[out] generated Generated samples are appended to it
+   *  @return -1 if error, 0 otherwise
+   */
+  virtual int Transform(const Sample& input,
+                        std::vector<Sample>* generated) const = 0;
+  
+  /**
+   *  @name   Geometry
+   *  @fn     virtual int Geometry(const cv::Size& size,
+                                   std::vector<Warp>* warps) const
+   *  @brief  Describe the samples generated from an input of a given size
+   *          as affine warps, without touching pixels. Consecutive
+   *          geometric cells are fused by the engine into a single resample
+   *          per output. Must generate the same samples as `Transform`.
+   *  @param[in]  size  Input image size
+   *  @param[out] warps Warps are appended to it
+   *  @return -1 if error or the cell is not geometric, 0 otherwise
+   */
+  virtual int Geometry(const cv::Size&, std::vector<Warp>*) const {
+    return -1;
+  }
+  
+  /**
+   *  @name   Compose
+   *  @fn     static cv::Matx23d Compose(const cv::Matx23d& a,
+                                         const cv::Matx23d& b)
+   *  @brief  Affine transform applying \p b then \p a
+   */
+  static cv::Matx23d Compose(const cv::Matx23d& a, const cv::Matx23d& b) {
+    return cv::Matx23d(a(0, 0) * b(0, 0) + a(0, 1) * b(1, 0),
+                       a(0, 0) * b(0, 1) + a(0, 1) * b(1, 1),
+                       a(0, 0) * b(0, 2) + a(0, 1) * b(1, 2) + a(0, 2),
+                       a(1, 0) * b(0, 0) + a(1, 1) * b(1, 0),
+                       a(1, 0) * b(0, 1) + a(1, 1) * b(1, 1),
+                       a(1, 0) * b(0, 2) + a(1, 1) * b(1, 2) + a(1, 2));
+  }
+  
+  /**
+   *  @name   MapAnnotations
+   *  @fn     static void MapAnnotations(const cv::Matx23d& transform,
+                                         const Sample& input, Sample* output)
+   *  @brief  Map the annotations of \p input into \p output with the warp
+   *          that generated it. Landmarks and box corners go through a
+   *          single `cv::transform` each, boxes become the bounding box of
+   *          their mapped corners. Nothing is clipped to the output image.
+   *  @param[in]  transform Warp from \p input to \p output
+   *  @param[in]  input     Annotated sample
+   *  @param[out] output    Generated sample, its annotations are replaced
+   */
+  static void MapAnnotations(const cv::Matx23d& transform,
+                             const Sample& input,
+                             Sample* output);
+  
+  /**
+   *  @name   LoadAnnotations
+   *  @fn     static int LoadAnnotations(const std::string& path,
+                                         Sample* sample)
+   *  @brief  Load the landmarks of the image \p path from its sidecar file,
+   *          same path with the `pts` extension (ibug format, 0-based
+   *          coordinates). Images without sidecar have no landmarks.
+   *  @param[in]  path    Image path
+   *  @param[out] sample  Sample receiving the landmarks
+   *  @return -1 if the sidecar is malformed, 0 otherwise
+   */
+  static int LoadAnnotations(const std::string& path, Sample* sample);
+  
+  /**
+   *  @name   SaveAnnotations
+   *  @fn     static int SaveAnnotations(const std::string& path,
+                                         const Sample& sample)
+   *  @brief  Write the landmarks of \p sample into the sidecar file of the
+   *          image \p path, nothing is written if there are none
+   *  @param[in]  path    Image path
+   *  @param[in]  sample  Annotated sample
+   *  @return -1 if error, 0 otherwise
+   */
+  static int SaveAnnotations(const std::string& path, const Sample& sample);
+  
+  /**
+   *  @name   WriteAnnotations
+   *  @fn     static int WriteAnnotations(const Sample& sample,
+                                          std::ostream* stream)
+   *  @brief  Write the landmarks of \p sample in the sidecar format, used
+   *          by sinks embedding them next to the image
+   *  @param[in]  sample  Annotated sample
+   *  @param[out] stream  Where to write them
+   *  @return -1 if error, 0 otherwise
+   */
+  static int WriteAnnotations(const Sample& sample, std::ostream* stream);
+  
+  /**
+   *  @name   Generator
+   *  @fn     static Random& Generator(void)
+   *  @brief  Random generator of the calling thread used by every cell
+   */
+  static Random& Generator(void);
+  
+  /**
+   *  @name   Reseed
+   *  @fn     static void Reseed(const std::string& name)
+   *  @brief  Select the random stream of the sample \p name (i.e. file name
+   *          plus tags) under the global seed. Called before running a cell
+   *          on a sample, draws then only depend on (seed, image, sample)
+   *          and are identical whatever the thread or the run mode.
+   *  @param[in] name Name of the sample about to be transformed
+   */
+  static void Reseed(const std::string& name);
+  
+  /**
+   *  @name   SetSeed
+   *  @fn     static void SetSeed(const uint64_t& seed)
+   *  @brief  Set the global seed of the augmentations, 0 by default
+   */
+  static void SetSeed(const uint64_t& seed);
+  
+  /**
+   *  @name   seed
+   *  @fn     static uint64_t seed(void)
+   *  @brief  Global seed of the augmentations
+   */
+  static uint64_t seed(void);
+  
 #pragma mark -
 #pragma mark Accessors
   
@@ -67,6 +240,26 @@ class AugmentationCell {
    *  @brief  Provide name of the operation
    */
   virtual const char* name(void) const = 0;
+  
+  /**
+   *  @name   config
+   *  @fn     virtual std::string config(void) const
+   *  @brief  Describe the operation and its parameters, two cells with the
+   *          same configuration generate the same samples for a given seed
+   *          (i.e. used to detect stale outputs)
+   */
+  virtual std::string config(void) const {
+    return this->name();
+  }
+  
+  /**
+   *  @name   is_geometric
+   *  @fn     virtual bool is_geometric(void) const
+   *  @brief  Indicate if the cell implements `Geometry`
+   */
+  virtual bool is_geometric(void) const {
+    return false;
+  }
 };
   
 }  // namespace FaceKit
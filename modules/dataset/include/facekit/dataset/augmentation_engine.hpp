@@ -11,12 +11,17 @@
 #ifndef __FACEKIT_AUGMENTATION_ENGIN__
 #define __FACEKIT_AUGMENTATION_ENGIN__
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <utility>
 
 #include "facekit/core/library_export.hpp"
+#include "facekit/core/mem/memory_budget.hpp"
 #include "facekit/dataset/augmentation_cell.hpp"
+#include "facekit/dataset/augmentation_manifest.hpp"
+#include "facekit/dataset/augmentation_sink.hpp"
 #include "facekit/dataset/flip_cell.hpp"
 
 /**
@@ -183,15 +188,220 @@ class FK_EXPORTS AugmentationEngine {
    */
   void Run(const std::string& output);
   
+  /**
+   *  @name   RunStreaming
+   *  @fn     void RunStreaming(const std::string& output)
+   *  @brief  Run data augmentation chain in memory. Each input is decoded
+   *          once, pushed through every cell with `Transform` and only the
+   *          samples coming out of the last cell are handed to the sink,
+   *          which writes them into \p output on its own I/O threads.
+   *          Intermediate steps never touch the disk (unlike `Run` which
+   *          keeps them). Inputs are processed concurrently, peak memory is
+   *          bounded by the samples generated from one input per thread
+   *          plus the sink's queue, and by the memory budget (see
+   *          `set_memory_budget`).
+   *  @param[in] output Location where to store the generated data
+   */
+  void RunStreaming(const std::string& output);
+  
+  /**
+   *  @name   RunPipelined
+   *  @fn     void RunPipelined(const std::string& output,
+                              const size_t& capacity = 0)
+   *  @brief  Run data augmentation chain in memory as a pipeline: decoding,
+   *          every cell and encoding are stages linked by queues, each
+   *          stage is drained by up to one task per pool's worker. A sample
+   *          moves to the next stage as soon as it is generated, so sample
+   *          k can be in cell 2 while sample k + 1 is being decoded. At
+   *          most \p capacity inputs are in flight, a new input is decoded
+   *          only once all the samples derived from a previous one have
+   *          been handed to the sink (backpressure). Output is the same as
+   *          `RunStreaming`. Decoding also waits for the memory budget.
+   *  @param[in] output   Location where to store the generated data
+   *  @param[in] capacity Maximum number of inputs in flight, 0 selects
+   *                      twice the number of workers of the pool
+   */
+  void RunPipelined(const std::string& output, const size_t& capacity = 0);
+  
+#pragma mark -
+#pragma mark Accessors
+  
+  /**
+   *  @name   set_incremental
+   *  @fn     void set_incremental(const bool& incremental)
+   *  @brief  Enable incremental runs. Every run mode then records in the
+   *          output folder a manifest mapping each input (path and content
+   *          hash) to its generated samples, under the current cells'
+   *          configuration and seed. Inputs that did not change since the
+   *          previous run, and whose samples are all still there, are
+   *          skipped. Changing a cell or the seed regenerates everything.
+   *  @param[in] incremental  True to skip inputs already augmented
+   */
+  void set_incremental(const bool& incremental) {
+    incremental_ = incremental;
+  }
+  
+  /**
+   *  @name   set_device
+   *  @fn     void set_device(const bool& device)
+   *  @brief  Resample the geometric steps of the in-memory modes
+   *          (`RunStreaming`, `RunPipelined`) with OpenCL when a device is
+   *          available, on the CPU otherwise. Cells are unchanged, their
+   *          warps are executed on the device; color cells stay on the CPU.
+   *  @param[in] device True to use an OpenCL device if there is one
+   */
+  void set_device(const bool& device) {
+    device_ = device;
+  }
+  
+  /**
+   *  @name   set_report_interval
+   *  @fn     void set_report_interval(const double& interval)
+   *  @brief  Every run mode logs per stage statistics (throughput, cost per
+   *          image, queue wait, bytes read/written) every \p interval
+   *          seconds and once more when it completes. See
+   *          `AugmentationStats`.
+   *  @param[in] interval Time between two reports in second, 0 only keeps
+   *                      the final one
+   */
+  void set_report_interval(const double& interval) {
+    report_interval_ = interval;
+  }
+  
+  /**
+   *  @name   set_sink
+   *  @fn     void set_sink(AugmentationSink* sink)
+   *  @brief  Select where the in-memory modes (`RunStreaming`,
+   *          `RunPipelined`) write the final samples: one file per sample
+   *          (`DirectorySink`, default), record shards (`RecordShardSink`)
+   *          or tar shards (`TarShardSink`). `Run` always writes files since
+   *          the cells encode their own outputs. Incremental runs require a
+   *          directory sink.
+   *  @param[in] sink Output sink, the engine takes ownership. nullptr
+   *                  restores the default.
+   */
+  void set_sink(AugmentationSink* sink) {
+    sink_.reset(sink ? sink : new DirectorySink());
+  }
+
+  /**
+   *  @name   set_memory_budget
+   *  @fn     void set_memory_budget(MemoryBudget* budget)
+   *  @brief  Select the budget bounding the pixels held by the in-memory
+   *          modes. A decoded input waits for its share before being
+   *          augmented, the samples derived from it are charged without
+   *          waiting and release their share once written by the sink.
+   *  @param[in] budget Memory budget, not owned. nullptr restores
+   *                    `MemoryBudget::Global()`
+   */
+  void set_memory_budget(MemoryBudget* budget) {
+    budget_ = budget ? budget : &MemoryBudget::Global();
+  }
   
 #pragma mark -
 #pragma mark Private
   
  private:
+  /**
+   *  @name   Select
+   *  @fn     void Select(const std::string& dir, const char* mode,
+                          AugmentationManifest* manifest,
+                          std::vector<std::string>* input,
+                          std::vector<uint64_t>* hash) const
+   *  @brief  Select the inputs to augment. Without incremental runs every
+   *          input is selected, otherwise only the ones that are not up to
+   *          date in the manifest stored in \p dir.
+   *  @param[in] dir        Output folder, with trailing separator
+   *  @param[in] mode       Run mode, part of the configuration since modes
+   *                        do not write the same files
+   *  @param[out] manifest  Manifest of the previous run
+   *  @param[out] input     Inputs to augment
+   *  @param[out] hash      Content hash of each selected input, empty for
+   *                        non incremental runs
+   */
+  void Select(const std::string& dir,
+              const char* mode,
+              AugmentationManifest* manifest,
+              std::vector<std::string>* input,
+              std::vector<uint64_t>* hash) const;
+  
+  /**
+   *  @name   Finish
+   *  @fn     void Finish(const std::string& dir, const char* mode,
+                          const std::vector<std::string>& input,
+                          const std::vector<uint64_t>& hash,
+                          const std::vector<uint8_t>& failed,
+                          const size_t& n_error, AugmentationStats* stats,
+                          AugmentationManifest* manifest)
+   *  @brief  Close the sink once every sample has been handed over, report
+   *          and update the manifest of an in-memory run
+   *  @param[in] dir      Output folder, with trailing separator
+   *  @param[in] mode     Run mode
+   *  @param[in] input    Augmented inputs
+   *  @param[in] hash     Content hash of each input
+   *  @param[in] failed   Non zero for each input that failed before writing
+   *  @param[in] n_error  Number of failures before writing
+   *  @param[in] stats    Statistics of the run
+   *  @param[in,out] manifest Manifest to update
+   */
+  void Finish(const std::string& dir,
+              const char* mode,
+              const std::vector<std::string>& input,
+              const std::vector<uint64_t>& hash,
+              const std::vector<uint8_t>& failed,
+              const size_t& n_error,
+              AugmentationStats* stats,
+              AugmentationManifest* manifest);
+  
+  /**
+   *  @name   Commit
+   *  @fn     void Commit(const std::string& dir, const char* mode,
+                          const std::vector<std::string>& input,
+                          const std::vector<uint64_t>& hash,
+                          const std::vector<std::vector<std::string>>& output,
+                          const std::vector<uint8_t>& failed,
+                          AugmentationManifest* manifest) const
+   *  @brief  Record the samples generated for each input that succeeded and
+   *          save the manifest, nothing is done for non incremental runs
+   *  @param[in] dir      Output folder, with trailing separator
+   *  @param[in] mode     Run mode
+   *  @param[in] input    Augmented inputs
+   *  @param[in] hash     Content hash of each input
+   *  @param[in] output   Samples generated from each input
+   *  @param[in] failed   Non zero for each input that failed
+   *  @param[in,out] manifest Manifest to update
+   */
+  void Commit(const std::string& dir,
+              const char* mode,
+              const std::vector<std::string>& input,
+              const std::vector<uint64_t>& hash,
+              const std::vector<std::vector<std::string>>& output,
+              const std::vector<uint8_t>& failed,
+              AugmentationManifest* manifest) const;
+  
+  /**
+   *  @name   IsIncremental
+   *  @fn     bool IsIncremental(const std::string& mode) const
+   *  @brief  Indicate if a run in \p mode is incremental. The manifest tracks
+   *          files, therefore the in-memory modes need a directory sink.
+   *  @param[in] mode Run mode
+   */
+  bool IsIncremental(const std::string& mode) const;
+  
   /** Squential step for data generation */
   std::vector<std::pair<const AugmentationCell*, bool>> sequence_;
   /** Input data */
   std::vector<std::string> input_;
+  /** Skip inputs already augmented */
+  bool incremental_ = false;
+  /** Resample on an OpenCL device if available */
+  bool device_ = false;
+  /** Time between two statistics reports, second */
+  double report_interval_ = 10.0;
+  /** Destination of the samples of the in-memory modes */
+  std::unique_ptr<AugmentationSink> sink_{new DirectorySink()};
+  /** Memory budget of the in-memory modes */
+  MemoryBudget* budget_ = &MemoryBudget::Global();
 };
   
 }  // namespace FaceKit
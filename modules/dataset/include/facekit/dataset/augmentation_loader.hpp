@@ -0,0 +1,246 @@
+/**
+ *  @file   augmentation_loader.hpp
+ *  @brief Stream augmented batches for training, nothing is written on disk
+ *  @ingroup dataset
+ *
+ *  @author Christophe Ecabert
+ *  @date   07.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_AUGMENTATION_LOADER__
+#define __FACEKIT_AUGMENTATION_LOADER__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/nd_array.hpp"
+#include "facekit/dataset/augmentation_cell.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  AugmentationLoader
+ *  @brief  Draw augmented batches on demand. Every sample of an epoch is a
+ *          single random path through the registered cells: geometric
+ *          cells only pick a warp, composed and resampled once straight
+ *          into the batch at the requested size. A prefetch thread fills
+ *          the next batches on the global `ThreadPool` while the current
+ *          one is consumed. The augmentation of a sample only depends on
+ *          the seed, the epoch and its position, batches are reproducible
+ *          whatever the number of threads.
+ *  @author Christophe Ecabert
+ *  @date   07.11.18
+ *  @ingroup dataset
+ */
+class FK_EXPORTS AugmentationLoader {
+ public:
+
+#pragma mark -
+#pragma mark Type Definition
+
+  /**
+   *  @struct Options
+   *  @brief  Loader configuration
+   */
+  struct Options {
+    /** Number of samples per batch */
+    size_t batch_size = 32;
+    /** Sample width, the final sample is resized if needed */
+    size_t width = 224;
+    /** Sample height */
+    size_t height = 224;
+    /** Number of batches prepared in advance */
+    size_t n_prefetch = 2;
+    /** Base seed */
+    uint32_t seed = 0;
+    /** Shuffle inputs at every epoch */
+    bool shuffle = true;
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   AugmentationLoader
+   *  @fn     AugmentationLoader(const std::vector<std::string>& files,
+                                 const Options& options)
+   *  @brief  Constructor
+   *  @param[in] files    Images to draw samples from
+   *  @param[in] options  Configuration
+   */
+  AugmentationLoader(const std::vector<std::string>& files,
+                     const Options& options);
+
+  /**
+   *  @name   ~AugmentationLoader
+   *  @fn     ~AugmentationLoader(void)
+   *  @brief  Destructor, stop prefetching
+   */
+  ~AugmentationLoader(void);
+
+  /**
+   *  @name   AugmentationLoader
+   *  @fn     AugmentationLoader(const AugmentationLoader& other) = delete
+   *  @brief  Copy constructor
+   */
+  AugmentationLoader(const AugmentationLoader& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     AugmentationLoader& operator=(const AugmentationLoader& rhs)
+   *  @brief  Copy assignment operator
+   */
+  AugmentationLoader& operator=(const AugmentationLoader& rhs) = delete;
+
+  /**
+   *  @name   Register
+   *  @fn     void Register(const AugmentationCell* cell, const bool own_it)
+   *  @brief  Add new augmentation step, must be called before `StartEpoch`
+   *  @param[in]  cell    New augmentation step to add
+   *  @param[in]  own_it  Indicates if the loader take the ownership of the
+   *                      cell
+   */
+  void Register(const AugmentationCell* cell, const bool own_it);
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   StartEpoch
+   *  @fn     int StartEpoch(const size_t& epoch)
+   *  @brief  Shuffle the inputs for \p epoch and start prefetching its
+   *          batches. The last incomplete batch is dropped.
+   *  @param[in] epoch  Epoch index
+   *  @return -1 if there is not enough data for a batch, 0 otherwise
+   */
+  int StartEpoch(const size_t& epoch);
+
+  /**
+   *  @name   Next
+   *  @fn     bool Next(NDArray* batch, std::vector<size_t>* index = nullptr)
+   *  @brief  Get the next batch of the epoch, blocks till it is ready. The
+   *          batch is exchanged with a prefetch buffer, it is reallocated
+   *          only if \p batch does not already have the right shape.
+   *  @param[in,out] batch  Batch of type kUInt8 and shape [batch_size x
+   *                        height x width x 3], BGR
+   *  @param[out] index     Optional, position in `files` of each sample
+   *  @return False once every batch of the epoch has been consumed
+   */
+  bool Next(NDArray* batch, std::vector<size_t>* index = nullptr);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   n_batch
+   *  @fn     size_t n_batch(void) const
+   *  @brief  Number of batches per epoch
+   */
+  size_t n_batch(void) const {
+    return files_.size() / options_.batch_size;
+  }
+
+  /**
+   *  @name   n_error
+   *  @fn     size_t n_error(void) const
+   *  @brief  Number of samples that failed, left black in their batch
+   */
+  size_t n_error(void) const {
+    return n_error_.load();
+  }
+
+  /**
+   *  @name   options
+   *  @fn     const Options& options(void) const
+   *  @brief  Loader configuration
+   */
+  const Options& options(void) const {
+    return options_;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+
+  /**
+   *  @struct Slot
+   *  @brief  Prefetch buffer
+   */
+  struct Slot {
+    /** Samples */
+    NDArray batch;
+    /** Position in `files_` of each sample */
+    std::vector<size_t> index;
+    /** Filled and not consumed yet */
+    bool ready = false;
+  };
+
+  /**
+   *  @name   Stop
+   *  @fn     void Stop(void)
+   *  @brief  Stop the prefetch thread of the current epoch
+   */
+  void Stop(void);
+
+  /**
+   *  @name   Prefetch
+   *  @fn     void Prefetch(void)
+   *  @brief  Fill the batches of the current epoch, body of the prefetch
+   *          thread
+   */
+  void Prefetch(void);
+
+  /**
+   *  @name   Produce
+   *  @fn     int Produce(const size_t& file, const size_t& position,
+                          uint8_t* dst) const
+   *  @brief  Draw one augmented sample of \p file into \p dst
+   *  @param[in] file     Index in `files_`
+   *  @param[in] position Position of the sample in the epoch
+   *  @param[out] dst     Sample buffer [height x width x 3]
+   *  @return -1 if error, 0 otherwise
+   */
+  int Produce(const size_t& file, const size_t& position, uint8_t* dst) const;
+
+  /** Input images */
+  std::vector<std::string> files_;
+  /** Options */
+  Options options_;
+  /** Augmentation steps */
+  std::vector<std::pair<const AugmentationCell*, bool>> sequence_;
+  /** Current epoch */
+  size_t epoch_;
+  /** Input order of the current epoch */
+  std::vector<size_t> order_;
+  /** Prefetch buffers, batch `b` lives in slot `b % n_prefetch` */
+  std::vector<Slot> slots_;
+  /** Number of batches produced */
+  size_t produced_;
+  /** Number of batches consumed */
+  size_t consumed_;
+  /** Request the prefetch thread to stop */
+  bool stop_;
+  /** Prefetch thread */
+  std::thread worker_;
+  /** Synchronization */
+  std::mutex lock_;
+  /** Slot state changes */
+  std::condition_variable cond_;
+  /** Number of failed samples */
+  std::atomic<size_t> n_error_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_AUGMENTATION_LOADER__ */
@@ -0,0 +1,159 @@
+/**
+ *  @file   augmentation_manifest.hpp
+ *  @brief  Record of the samples generated from each input, allows
+ *          incremental augmentation runs
+ *  @ingroup dataset
+ *
+ *  @author Christophe Ecabert
+ *  @date   09.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_AUGMENTATION_MANIFEST__
+#define __FACEKIT_AUGMENTATION_MANIFEST__
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  AugmentationManifest
+ *  @brief  Map each input (path and content hash) to the samples generated
+ *          from it, under a given configuration (cells and seed). Stored as
+ *          text alongside the generated samples. An input is up to date if
+ *          its content did not change since its entry was recorded and all
+ *          its outputs are still on disk. Entries are only valid for the
+ *          configuration they were recorded with, loading a manifest of
+ *          another configuration gives an empty one.
+ *  @author Christophe Ecabert
+ *  @date   09.11.18
+ *  @ingroup dataset
+ */
+class FK_EXPORTS AugmentationManifest {
+ public:
+
+#pragma mark -
+#pragma mark Type Definition
+
+  /**
+   *  @struct Entry
+   *  @brief  Samples generated from an input
+   */
+  struct Entry {
+    /** Content hash of the input */
+    uint64_t hash = 0;
+    /** Path of the generated samples */
+    std::vector<std::string> outputs;
+  };
+
+  /** Name of the manifest file in the output folder */
+  static constexpr const char* kFilename = ".augmentation_manifest";
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   AugmentationManifest
+   *  @fn     explicit AugmentationManifest(const std::string& config)
+   *  @brief  Constructor
+   *  @param[in] config Configuration of the run (cells and seed)
+   */
+  explicit AugmentationManifest(const std::string& config);
+
+  /**
+   *  @name   Load
+   *  @fn     int Load(const std::string& path)
+   *  @brief  Load the entries stored in \p path. Entries recorded with
+   *          another configuration are dropped.
+   *  @param[in] path Manifest file
+   *  @return -1 if the file can not be read, 0 otherwise
+   */
+  int Load(const std::string& path);
+
+  /**
+   *  @name   Save
+   *  @fn     int Save(const std::string& path) const
+   *  @brief  Write the entries into \p path
+   *  @param[in] path Manifest file
+   *  @return -1 if error, 0 otherwise
+   */
+  int Save(const std::string& path) const;
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   HashFile
+   *  @fn     static int HashFile(const std::string& path, uint64_t* hash)
+   *  @brief  Content hash (FNV-1a, 64 bits) of a file
+   *  @param[in] path   File to hash
+   *  @param[out] hash  Hash
+   *  @return -1 if the file can not be read, 0 otherwise
+   */
+  static int HashFile(const std::string& path, uint64_t* hash);
+
+  /**
+   *  @name   IsUpToDate
+   *  @fn     bool IsUpToDate(const std::string& input,
+                              const uint64_t& hash) const
+   *  @brief  Check if the samples of \p input are already generated
+   *  @param[in] input  Input's path
+   *  @param[in] hash   Current content hash of the input
+   *  @return True if the input is unchanged and all its outputs exist
+   */
+  bool IsUpToDate(const std::string& input, const uint64_t& hash) const;
+
+  /**
+   *  @name   Update
+   *  @fn     void Update(const std::string& input, const uint64_t& hash,
+                          const std::vector<std::string>& outputs)
+   *  @brief  Record the samples generated from \p input
+   *  @param[in] input    Input's path
+   *  @param[in] hash     Content hash of the input
+   *  @param[in] outputs  Generated samples
+   */
+  void Update(const std::string& input,
+              const uint64_t& hash,
+              const std::vector<std::string>& outputs);
+
+  /**
+   *  @name   Retain
+   *  @fn     void Retain(const std::vector<std::string>& inputs)
+   *  @brief  Drop the entries of the inputs not listed in \p inputs (i.e.
+   *          removed from the dataset). Their samples are left on disk.
+   *  @param[in] inputs Current inputs
+   */
+  void Retain(const std::vector<std::string>& inputs);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   size
+   *  @fn     size_t size(void) const
+   *  @brief  Number of entries
+   */
+  size_t size(void) const {
+    return entries_.size();
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Fingerprint of the configuration */
+  uint64_t config_;
+  /** Entries, keyed by input's path */
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_AUGMENTATION_MANIFEST__ */
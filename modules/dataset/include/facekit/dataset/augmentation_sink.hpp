@@ -0,0 +1,593 @@
+/**
+ *  @file   augmentation_sink.hpp
+ *  @brief  Destination of the samples generated by an augmentation run
+ *  @ingroup dataset
+ *
+ *  @author Christophe Ecabert
+ *  @date   12.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_AUGMENTATION_SINK__
+#define __FACEKIT_AUGMENTATION_SINK__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/mem/memory_budget.hpp"
+#include "facekit/dataset/augmentation_cell.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Forward declaration */
+class AugmentationStats;
+
+/**
+ *  @class  AugmentationSink
+ *  @brief  Where the in-memory modes of `AugmentationEngine` put the final
+ *          samples. Workers hand samples over with `Push` and go back to
+ *          augmenting, encoding and writing happen on dedicated I/O
+ *          threads. The queue is bounded, `Push` blocks when the I/O
+ *          threads fall behind, therefore memory stays bounded.
+ *  @author Christophe Ecabert
+ *  @date   12.11.18
+ *  @ingroup dataset
+ */
+class FK_EXPORTS AugmentationSink {
+ public:
+
+#pragma mark -
+#pragma mark Type Definition
+
+  /** Sample */
+  using Sample = AugmentationCell::Sample;
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   AugmentationSink
+   *  @fn     AugmentationSink(const size_t& n_thread, const size_t& capacity)
+   *  @brief  Constructor
+   *  @param[in] n_thread Number of I/O threads
+   *  @param[in] capacity Maximum number of samples waiting to be written
+   */
+  AugmentationSink(const size_t& n_thread, const size_t& capacity);
+
+  /**
+   *  @name   ~AugmentationSink
+   *  @fn     virtual ~AugmentationSink(void)
+   *  @brief  Destructor, the sink must be closed
+   */
+  virtual ~AugmentationSink(void);
+
+  /**
+   *  @name   AugmentationSink
+   *  @fn     AugmentationSink(const AugmentationSink& other) = delete
+   *  @brief  Copy constructor
+   */
+  AugmentationSink(const AugmentationSink& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     AugmentationSink& operator=(const AugmentationSink& rhs) = delete
+   *  @brief  Copy assignment
+   */
+  AugmentationSink& operator=(const AugmentationSink& rhs) = delete;
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   Open
+   *  @fn     int Open(const std::string& dir, const size_t& n_input,
+                       AugmentationStats* stats, const size_t& stage)
+   *  @brief  Start a run, spawn the I/O threads
+   *  @param[in] dir      Output folder, with trailing separator
+   *  @param[in] n_input  Number of inputs of the run
+   *  @param[in] stats    Statistics, writes are accounted in \p stage
+   *  @param[in] stage    Stage index in \p stats
+   *  @return -1 if error, 0 otherwise
+   */
+  int Open(const std::string& dir,
+           const size_t& n_input,
+           AugmentationStats* stats,
+           const size_t& stage);
+
+  /**
+   *  @name   Push
+   *  @fn     void Push(const size_t& input, Sample&& sample,
+                        const std::string& ext)
+   *  @brief  Queue \p sample for writing, blocks while the queue is full
+   *  @param[in] input  Index of the input it derives from
+   *  @param[in] sample Sample to write
+   *  @param[in] ext    Image extension, selects the encoder
+   */
+  void Push(const size_t& input, Sample&& sample, const std::string& ext) {
+    this->Push(input, std::move(sample), ext, MemoryBudget::Token());
+  }
+
+  /**
+   *  @name   Push
+   *  @fn     void Push(const size_t& input, Sample&& sample,
+                        const std::string& ext, MemoryBudget::Token&& token)
+   *  @brief  Queue \p sample for writing along with the budget it holds,
+   *          given back once the sample is written
+   *  @param[in] input  Index of the input it derives from
+   *  @param[in] sample Sample to write
+   *  @param[in] ext    Image extension, selects the encoder
+   *  @param[in] token  Reservation of the sample's memory
+   */
+  void Push(const size_t& input,
+            Sample&& sample,
+            const std::string& ext,
+            MemoryBudget::Token&& token);
+
+  /**
+   *  @name   Close
+   *  @fn     int Close(void)
+   *  @brief  Write the pending samples, stop the I/O threads and finalize
+   *          the output
+   *  @return -1 if error, 0 otherwise
+   */
+  int Close(void);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   is_directory
+   *  @fn     virtual bool is_directory(void) const
+   *  @brief  Indicate if every sample is a file of its own, required by
+   *          incremental runs
+   */
+  virtual bool is_directory(void) const {
+    return false;
+  }
+
+  /**
+   *  @name   outputs
+   *  @fn     const std::vector<std::vector<std::string>>& outputs(void) const
+   *  @brief  Location of the samples written for each input, complete once
+   *          closed
+   */
+  const std::vector<std::vector<std::string>>& outputs(void) const {
+    return outputs_;
+  }
+
+  /**
+   *  @name   failed
+   *  @fn     const std::vector<uint8_t>& failed(void) const
+   *  @brief  Non zero for each input with a sample that could not be
+   *          written, complete once closed
+   */
+  const std::vector<uint8_t>& failed(void) const {
+    return failed_;
+  }
+
+  /**
+   *  @name   n_output
+   *  @fn     size_t n_output(void) const
+   *  @brief  Number of samples written
+   */
+  size_t n_output(void) const {
+    return n_output_.load();
+  }
+
+  /**
+   *  @name   n_error
+   *  @fn     size_t n_error(void) const
+   *  @brief  Number of samples that could not be written
+   */
+  size_t n_error(void) const {
+    return n_error_.load();
+  }
+
+#pragma mark -
+#pragma mark Protected
+ protected:
+
+  /**
+   *  @name   Prepare
+   *  @fn     virtual int Prepare(const std::string& dir) = 0
+   *  @brief  Get ready to write into \p dir
+   *  @return -1 if error, 0 otherwise
+   */
+  virtual int Prepare(const std::string& dir) = 0;
+
+  /**
+   *  @name   Write
+   *  @fn     virtual int Write(const Sample& sample, const std::string& ext,
+                                std::string* location, uint64_t* bytes) = 0
+   *  @brief  Encode and write \p sample, called concurrently by the I/O
+   *          threads
+   *  @param[in]  sample    Sample to write
+   *  @param[in]  ext       Image extension
+   *  @param[out] location  Where it has been written
+   *  @param[out] bytes     Number of bytes written
+   *  @return -1 if error, 0 otherwise
+   */
+  virtual int Write(const Sample& sample,
+                    const std::string& ext,
+                    std::string* location,
+                    uint64_t* bytes) = 0;
+
+  /**
+   *  @name   Finish
+   *  @fn     virtual int Finish(void) = 0
+   *  @brief  Flush and finalize the output, I/O threads are stopped
+   *  @return -1 if error, 0 otherwise
+   */
+  virtual int Finish(void) = 0;
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /**
+   *  @struct Item
+   *  @brief  Sample waiting to be written
+   */
+  struct Item {
+    /** Sample */
+    Sample sample;
+    /** Input it derives from */
+    size_t input;
+    /** Image extension */
+    std::string ext;
+    /** Time it entered the queue, ns */
+    int64_t queued;
+    /** Reservation of the sample's memory */
+    MemoryBudget::Token token;
+  };
+
+  /**
+   *  @name   Loop
+   *  @fn     void Loop(void)
+   *  @brief  Body of the I/O threads
+   */
+  void Loop(void);
+
+  /** Number of I/O threads */
+  size_t n_thread_;
+  /** Queue capacity */
+  size_t capacity_;
+  /** I/O threads */
+  std::vector<std::thread> workers_;
+  /** Pending samples */
+  std::deque<Item> queue_;
+  /** Request the I/O threads to stop once the queue is empty */
+  bool stop_;
+  /** Synchronization of the queue and the records */
+  std::mutex lock_;
+  /** Queue is not empty anymore */
+  std::condition_variable not_empty_;
+  /** Queue is not full anymore */
+  std::condition_variable not_full_;
+  /** Statistics */
+  AugmentationStats* stats_;
+  /** Stage accounting the writes */
+  size_t stage_;
+  /** Samples written for each input */
+  std::vector<std::vector<std::string>> outputs_;
+  /** Failure flag of each input */
+  std::vector<uint8_t> failed_;
+  /** Number of samples written */
+  std::atomic<size_t> n_output_;
+  /** Number of failures */
+  std::atomic<size_t> n_error_;
+};
+
+/**
+ *  @class  DirectorySink
+ *  @brief  One image file per sample, plus its landmarks sidecar, written
+ *          in the output folder.
+ *  @author Christophe Ecabert
+ *  @date   12.11.18
+ *  @ingroup dataset
+ */
+class FK_EXPORTS DirectorySink : public AugmentationSink {
+ public:
+  /**
+   *  @name   DirectorySink
+   *  @fn     explicit DirectorySink(const size_t& n_thread = 1,
+                                     const size_t& capacity = 64)
+   *  @brief  Constructor
+   *  @param[in] n_thread Number of I/O threads
+   *  @param[in] capacity Maximum number of samples waiting to be written
+   */
+  explicit DirectorySink(const size_t& n_thread = 1,
+                         const size_t& capacity = 64);
+
+  /**
+   *  @name   is_directory
+   *  @fn     bool is_directory(void) const override
+   *  @brief  Indicate if every sample is a file of its own
+   */
+  bool is_directory(void) const override {
+    return true;
+  }
+
+ protected:
+  /**
+   *  @name   Prepare
+   *  @fn     int Prepare(const std::string& dir) override
+   *  @brief  Get ready to write into \p dir
+   *  @return 0
+   */
+  int Prepare(const std::string& dir) override;
+
+  /**
+   *  @name   Write
+   *  @fn     int Write(const Sample& sample, const std::string& ext,
+                        std::string* location, uint64_t* bytes) override
+   *  @brief  Write \p sample as `<dir><name>.<ext>`
+   *  @return -1 if error, 0 otherwise
+   */
+  int Write(const Sample& sample,
+            const std::string& ext,
+            std::string* location,
+            uint64_t* bytes) override;
+
+  /**
+   *  @name   Finish
+   *  @fn     int Finish(void) override
+   *  @brief  Nothing to finalize
+   *  @return 0
+   */
+  int Finish(void) override;
+
+ private:
+  /** Output folder */
+  std::string dir_;
+};
+
+/**
+ *  @class  ShardSink
+ *  @brief  Pack the samples into a few large files, `<prefix>-NNNNN.<ext>`
+ *          in the output folder, instead of two files per sample. A new
+ *          shard is started once the current one exceeds the shard size.
+ *          Samples are encoded concurrently, appends are serialized. The
+ *          location recorded for a sample is its shard.
+ *  @author Christophe Ecabert
+ *  @date   12.11.18
+ *  @ingroup dataset
+ */
+class FK_EXPORTS ShardSink : public AugmentationSink {
+ public:
+  /**
+   *  @name   ShardSink
+   *  @fn     ShardSink(const std::string& prefix, const uint64_t& shard_size,
+                        const size_t& n_thread, const size_t& capacity)
+   *  @brief  Constructor
+   *  @param[in] prefix     Shard name prefix
+   *  @param[in] shard_size Shard size threshold, bytes
+   *  @param[in] n_thread   Number of I/O threads
+   *  @param[in] capacity   Maximum number of samples waiting to be written
+   */
+  ShardSink(const std::string& prefix,
+            const uint64_t& shard_size,
+            const size_t& n_thread,
+            const size_t& capacity);
+
+ protected:
+  /**
+   *  @name   Prepare
+   *  @fn     int Prepare(const std::string& dir) override
+   *  @brief  Get ready to write shards into \p dir
+   *  @return 0
+   */
+  int Prepare(const std::string& dir) override;
+
+  /**
+   *  @name   Write
+   *  @fn     int Write(const Sample& sample, const std::string& ext,
+                        std::string* location, uint64_t* bytes) override
+   *  @brief  Encode \p sample and append it to the current shard
+   *  @return -1 if error, 0 otherwise
+   */
+  int Write(const Sample& sample,
+            const std::string& ext,
+            std::string* location,
+            uint64_t* bytes) override;
+
+  /**
+   *  @name   Finish
+   *  @fn     int Finish(void) override
+   *  @brief  Close the current shard
+   *  @return -1 if error, 0 otherwise
+   */
+  int Finish(void) override;
+
+  /**
+   *  @name   Append
+   *  @fn     virtual uint64_t Append(const std::string& name,
+                                      const std::string& ext,
+                                      const std::vector<uint8_t>& image,
+                                      const std::string& annotation,
+                                      std::ostream* stream) = 0
+   *  @brief  Append a sample to a shard in the format's layout
+   *  @param[in] name       Sample name
+   *  @param[in] ext        Image extension
+   *  @param[in] image      Encoded image
+   *  @param[in] annotation Landmarks in the sidecar format, empty if none
+   *  @param[in,out] stream Shard
+   *  @return Number of bytes written
+   */
+  virtual uint64_t Append(const std::string& name,
+                          const std::string& ext,
+                          const std::vector<uint8_t>& image,
+                          const std::string& annotation,
+                          std::ostream* stream) = 0;
+
+  /**
+   *  @name   Trailer
+   *  @fn     virtual void Trailer(std::ostream* stream)
+   *  @brief  Terminate a shard before closing it
+   */
+  virtual void Trailer(std::ostream* /*stream*/) {}
+
+  /**
+   *  @name   extension
+   *  @fn     virtual const char* extension(void) const = 0
+   *  @brief  Shard extension
+   */
+  virtual const char* extension(void) const = 0;
+
+ private:
+  /**
+   *  @name   Roll
+   *  @fn     int Roll(void)
+   *  @brief  Close the current shard if any and open the next one
+   *  @return -1 if error, 0 otherwise
+   */
+  int Roll(void);
+
+  /** Shard name prefix */
+  std::string prefix_;
+  /** Shard size threshold */
+  uint64_t shard_size_;
+  /** Output folder */
+  std::string dir_;
+  /** Current shard */
+  std::ofstream stream_;
+  /** Path of the current shard */
+  std::string path_;
+  /** Index of the next shard */
+  size_t index_;
+  /** Size of the current shard */
+  uint64_t size_;
+  /** Synchronization of the appends */
+  std::mutex shard_lock_;
+};
+
+/**
+ *  @class  RecordShardSink
+ *  @brief  Shards of length-prefixed records (`.rec`). A record is the
+ *          sample name, the encoded image and its landmarks (sidecar
+ *          format, may be empty), each one preceded by its size as a little
+ *          endian uint64.
+ *  @author Christophe Ecabert
+ *  @date   12.11.18
+ *  @ingroup dataset
+ */
+class FK_EXPORTS RecordShardSink : public ShardSink {
+ public:
+  /**
+   *  @name   RecordShardSink
+   *  @fn     explicit RecordShardSink(const std::string& prefix = "samples",
+                               const uint64_t& shard_size = 1ULL << 30,
+                               const size_t& n_thread = 1,
+                               const size_t& capacity = 64)
+   *  @brief  Constructor
+   *  @param[in] prefix     Shard name prefix
+   *  @param[in] shard_size Shard size threshold, bytes
+   *  @param[in] n_thread   Number of I/O threads
+   *  @param[in] capacity   Maximum number of samples waiting to be written
+   */
+  explicit RecordShardSink(const std::string& prefix = "samples",
+                           const uint64_t& shard_size = 1ULL << 30,
+                           const size_t& n_thread = 1,
+                           const size_t& capacity = 64);
+
+ protected:
+  /**
+   *  @name   Append
+   *  @fn     uint64_t Append(const std::string& name, const std::string& ext,
+                              const std::vector<uint8_t>& image,
+                              const std::string& annotation,
+                              std::ostream* stream) override
+   *  @brief  Append a record
+   *  @return Number of bytes written
+   */
+  uint64_t Append(const std::string& name,
+                  const std::string& ext,
+                  const std::vector<uint8_t>& image,
+                  const std::string& annotation,
+                  std::ostream* stream) override;
+
+  /**
+   *  @name   extension
+   *  @fn     const char* extension(void) const override
+   *  @brief  Shard extension
+   */
+  const char* extension(void) const override {
+    return "rec";
+  }
+};
+
+/**
+ *  @class  TarShardSink
+ *  @brief  Shards as POSIX tar archives (`.tar`), each sample is stored as
+ *          `<name>.<ext>` followed by `<name>.pts` if it has landmarks.
+ *          Readable by any tar tool and by webdataset-style loaders. Names
+ *          are limited to 99 characters.
+ *  @author Christophe Ecabert
+ *  @date   12.11.18
+ *  @ingroup dataset
+ */
+class FK_EXPORTS TarShardSink : public ShardSink {
+ public:
+  /**
+   *  @name   TarShardSink
+   *  @fn     explicit TarShardSink(const std::string& prefix = "samples",
+                                    const uint64_t& shard_size = 1ULL << 30,
+                                    const size_t& n_thread = 1,
+                                    const size_t& capacity = 64)
+   *  @brief  Constructor
+   *  @param[in] prefix     Shard name prefix
+   *  @param[in] shard_size Shard size threshold, bytes
+   *  @param[in] n_thread   Number of I/O threads
+   *  @param[in] capacity   Maximum number of samples waiting to be written
+   */
+  explicit TarShardSink(const std::string& prefix = "samples",
+                        const uint64_t& shard_size = 1ULL << 30,
+                        const size_t& n_thread = 1,
+                        const size_t& capacity = 64);
+
+ protected:
+  /**
+   *  @name   Append
+   *  @fn     uint64_t Append(const std::string& name, const std::string& ext,
+                              const std::vector<uint8_t>& image,
+                              const std::string& annotation,
+                              std::ostream* stream) override
+   *  @brief  Append the sample's entries
+   *  @return Number of bytes written, 0 if the name is too long
+   */
+  uint64_t Append(const std::string& name,
+                  const std::string& ext,
+                  const std::vector<uint8_t>& image,
+                  const std::string& annotation,
+                  std::ostream* stream) override;
+
+  /**
+   *  @name   Trailer
+   *  @fn     void Trailer(std::ostream* stream) override
+   *  @brief  Write the end-of-archive marker
+   */
+  void Trailer(std::ostream* stream) override;
+
+  /**
+   *  @name   extension
+   *  @fn     const char* extension(void) const override
+   *  @brief  Shard extension
+   */
+  const char* extension(void) const override {
+    return "tar";
+  }
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_AUGMENTATION_SINK__ */
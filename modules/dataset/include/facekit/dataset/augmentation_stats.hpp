@@ -0,0 +1,234 @@
+/**
+ *  @file   augmentation_stats.hpp
+ *  @brief  Throughput and timing of each stage of an augmentation run
+ *  @ingroup dataset
+ *
+ *  @author Christophe Ecabert
+ *  @date   11.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_AUGMENTATION_STATS__
+#define __FACEKIT_AUGMENTATION_STATS__
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  AugmentationStats
+ *  @brief  Counters of the stages of an augmentation run (i.e. decoding,
+ *          each step, encoding), updated concurrently by the workers. Busy
+ *          time is summed over the threads, therefore `busy / n_input` is
+ *          the cost of an image in a stage whatever the parallelism, while
+ *          `n_input / elapsed` is the throughput actually reached. A stage
+ *          with a high cost is the one to scale or to fuse, a stage with a
+ *          high queue wait is starved or saturated. Progress is logged at
+ *          regular intervals by whichever worker notices the deadline, no
+ *          extra thread is involved.
+ *  @author Christophe Ecabert
+ *  @date   11.11.18
+ *  @ingroup dataset
+ */
+class FK_EXPORTS AugmentationStats {
+ public:
+
+#pragma mark -
+#pragma mark Type Definition
+
+  /**
+   *  @struct Snapshot
+   *  @brief  Counters of a stage at a given time
+   */
+  struct Snapshot {
+    /** Stage's name */
+    std::string name;
+    /** Number of samples consumed */
+    size_t n_input = 0;
+    /** Number of samples produced */
+    size_t n_output = 0;
+    /** Number of failures */
+    size_t n_error = 0;
+    /** Processing time summed over threads, ns */
+    int64_t busy = 0;
+    /** Time spent by samples waiting in the stage's queue, ns */
+    int64_t wait = 0;
+    /** Bytes read from disk */
+    uint64_t bytes_read = 0;
+    /** Bytes written on disk */
+    uint64_t bytes_written = 0;
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   AugmentationStats
+   *  @fn     AugmentationStats(const std::vector<std::string>& stages,
+                                const double& interval)
+   *  @brief  Constructor, starts the clock
+   *  @param[in] stages   Name of each stage
+   *  @param[in] interval Time between two progress reports in second, 0
+   *                      disables them
+   */
+  AugmentationStats(const std::vector<std::string>& stages,
+                    const double& interval);
+
+  /**
+   *  @name   AugmentationStats
+   *  @fn     AugmentationStats(const AugmentationStats& other) = delete
+   *  @brief  Copy constructor
+   */
+  AugmentationStats(const AugmentationStats& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     AugmentationStats& operator=(const AugmentationStats& rhs)
+                    = delete
+   *  @brief  Copy assignment
+   */
+  AugmentationStats& operator=(const AugmentationStats& rhs) = delete;
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   Add
+   *  @fn     void Add(const size_t& stage, const size_t& n_input,
+                       const size_t& n_output, const int64_t& busy)
+   *  @brief  Account work done by \p stage and report progress if due
+   *  @param[in] stage    Stage index
+   *  @param[in] n_input  Number of samples consumed
+   *  @param[in] n_output Number of samples produced
+   *  @param[in] busy     Processing time, ns
+   */
+  void Add(const size_t& stage,
+           const size_t& n_input,
+           const size_t& n_output,
+           const int64_t& busy);
+
+  /**
+   *  @name   AddError
+   *  @fn     void AddError(const size_t& stage)
+   *  @brief  Account a failure in \p stage
+   */
+  void AddError(const size_t& stage);
+
+  /**
+   *  @name   AddWait
+   *  @fn     void AddWait(const size_t& stage, const int64_t& wait)
+   *  @brief  Account time spent by a sample in the queue of \p stage, ns
+   */
+  void AddWait(const size_t& stage, const int64_t& wait);
+
+  /**
+   *  @name   AddRead
+   *  @fn     void AddRead(const size_t& stage, const uint64_t& bytes)
+   *  @brief  Account bytes read from disk by \p stage
+   */
+  void AddRead(const size_t& stage, const uint64_t& bytes);
+
+  /**
+   *  @name   AddWritten
+   *  @fn     void AddWritten(const size_t& stage, const uint64_t& bytes)
+   *  @brief  Account bytes written on disk by \p stage
+   */
+  void AddWritten(const size_t& stage, const uint64_t& bytes);
+
+  /**
+   *  @name   Report
+   *  @fn     void Report(void) const
+   *  @brief  Log a summary line for every stage
+   */
+  void Report(void) const;
+
+  /**
+   *  @name   FileSize
+   *  @fn     static uint64_t FileSize(const std::string& path)
+   *  @brief  Size of a file on disk
+   *  @param[in] path File
+   *  @return Size in bytes, 0 if the file can not be opened
+   */
+  static uint64_t FileSize(const std::string& path);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   size
+   *  @fn     size_t size(void) const
+   *  @brief  Number of stages
+   */
+  size_t size(void) const {
+    return names_.size();
+  }
+
+  /**
+   *  @name   get_stage
+   *  @fn     Snapshot get_stage(const size_t& stage) const
+   *  @brief  Current counters of \p stage
+   */
+  Snapshot get_stage(const size_t& stage) const;
+
+  /**
+   *  @name   get_elapsed
+   *  @fn     int64_t get_elapsed(void) const
+   *  @brief  Time since construction, ns
+   */
+  int64_t get_elapsed(void) const;
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /**
+   *  @struct Counters
+   *  @brief  Live counters of a stage
+   */
+  struct Counters {
+    /** Number of samples consumed */
+    std::atomic<size_t> n_input{0};
+    /** Number of samples produced */
+    std::atomic<size_t> n_output{0};
+    /** Number of failures */
+    std::atomic<size_t> n_error{0};
+    /** Processing time, ns */
+    std::atomic<int64_t> busy{0};
+    /** Queue wait, ns */
+    std::atomic<int64_t> wait{0};
+    /** Bytes read */
+    std::atomic<uint64_t> bytes_read{0};
+    /** Bytes written */
+    std::atomic<uint64_t> bytes_written{0};
+  };
+
+  /**
+   *  @name   Tick
+   *  @fn     void Tick(void)
+   *  @brief  Report progress if the interval elapsed, a single thread wins
+   */
+  void Tick(void);
+
+  /** Stages' name */
+  std::vector<std::string> names_;
+  /** Stages' counters */
+  std::unique_ptr<Counters[]> counters_;
+  /** Start time, ns */
+  int64_t start_;
+  /** Time between reports, ns, 0 if disabled */
+  int64_t interval_;
+  /** Time of the next report, ns */
+  std::atomic<int64_t> next_report_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_AUGMENTATION_STATS__ */
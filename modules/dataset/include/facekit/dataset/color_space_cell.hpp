@@ -21,21 +21,74 @@
  */
 namespace FaceKit {
   
+/**
+ *  @class  HSVScalingCell
+ *  @brief  Color jitter (brightness, contrast, saturation, hue). The
+ *          adjustments are linear in BGR, they are folded into a single
+ *          3x4 affine color matrix applied in one pass over the 8-bit
+ *          pixels, no HSV or floating point copy of the image is made.
+ *  @author Christophe Ecabert
+ *  @date   27.10.17
+ *  @ingroup dataset
+ */
 class FK_EXPORTS HSVScalingCell : public AugmentationCell {
  public:
   
+#pragma mark -
+#pragma mark Type Definition
+  
+  /**
+   *  @struct Jitter
+   *  @brief  Color adjustment of one sample
+   */
+  struct Jitter {
+    /** Brightness, scales every channel (i.e. the HSV value) */
+    double brightness = 1.0;
+    /** Contrast, scales around the mean luma */
+    double contrast = 1.0;
+    /** Saturation, 0 gives grayscale */
+    double saturation = 1.0;
+    /** Hue rotation around the gray axis, in degree */
+    double hue = 0.0;
+  };
+  
+  /**
+   *  @struct Range
+   *  @brief  Jitter ranges, factors are drawn within 1 +/- range and the
+   *          hue within +/- hue
+   */
+  struct Range {
+    /** Brightness */
+    double brightness = 0.0;
+    /** Contrast */
+    double contrast = 0.0;
+    /** Saturation */
+    double saturation = 0.0;
+    /** Hue, in degree */
+    double hue = 0.0;
+  };
+  
 #pragma mark -
 #pragma mark Initialization
   
   /**
    *  @name   HSVScalingCell
    *  @fn     HSVScalingCell(const double range, const size_t n_sample);
-   *  @brief  Constructor
+   *  @brief  Constructor, scale the value only
    *  @param[in] range  Scaling factor's range defined as 1 +/- range
-   *  @param[in] n_sample  Patch height
+   *  @param[in] n_sample  Number of sample to generate for each image
    */
   HSVScalingCell(const double range, const size_t n_sample);
   
+  /**
+   *  @name   HSVScalingCell
+   *  @fn     HSVScalingCell(const Range& range, const size_t n_sample)
+   *  @brief  Constructor
+   *  @param[in] range  Jitter ranges
+   *  @param[in] n_sample  Number of sample to generate for each image
+   */
+  HSVScalingCell(const Range& range, const size_t n_sample);
+  
   /**
    *  @name   ~HSVScalingCell
    *  @fn     ~HSVScalingCell(void) = default
@@ -61,6 +114,31 @@ class FK_EXPORTS HSVScalingCell : public AugmentationCell {
               const std::string& output,
               std::vector<std::string>* generated) const;
   
+  /**
+   *  @name   Transform
+   *  @fn     int Transform(const Sample& input,
+                            std::vector<Sample>* generated) const
+   *  @brief  Jitter the colors of an image already in memory
+   *  @param[in]  input     Sample to augment
+   *  @param[out] generated Generated samples are appended to it
+   *  @return -1 if error, 0 otherwise
+   */
+  int Transform(const Sample& input, std::vector<Sample>* generated) const;
+  
+  /**
+   *  @name   Apply
+   *  @fn     static int Apply(const Jitter& jitter, const cv::Mat& src,
+                               cv::Mat* dst)
+   *  @brief  Apply a color adjustment on an 8-bit BGR or gray image, can
+   *          run in place (\p dst == &src). Gray images only get brightness
+   *          and contrast.
+   *  @param[in]  jitter  Adjustment
+   *  @param[in]  src     Image to adjust
+   *  @param[out] dst     Adjusted image
+   *  @return -1 if the image is empty or not 8-bit, 0 otherwise
+   */
+  static int Apply(const Jitter& jitter, const cv::Mat& src, cv::Mat* dst);
+  
 #pragma mark -
 #pragma mark Accessors
   
@@ -73,11 +151,18 @@ class FK_EXPORTS HSVScalingCell : public AugmentationCell {
     return "HSVScalingCell";
   }
   
+  /**
+   *  @name   config
+   *  @fn     std::string config(void) const
+   *  @brief  Describe the operation and its parameters
+   */
+  std::string config(void) const;
+  
 #pragma mark -
 #pragma mark Private
 private:
   /** Range */
-  double range_;
+  Range range_;
   /** Number of sample to generate for each image */
   size_t n_sample_;
 };
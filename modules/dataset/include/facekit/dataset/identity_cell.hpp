@@ -65,6 +65,28 @@ class FK_EXPORTS IdentityCell : public AugmentationCell {
               const std::string& output,
               std::vector<std::string>* generated) const;
   
+  /**
+   *  @name   Transform
+   *  @fn     int Transform(const Sample& input,
+                            std::vector<Sample>* generated) const
+   *  @brief  Forward the input sample, image data is shared
+   *  @param[in]  input     Sample to augment
+   *  @param[out] generated Generated samples are appended to it
+   *  @return -1 if error, 0 otherwise
+   */
+  int Transform(const Sample& input, std::vector<Sample>* generated) const;
+  
+  /**
+   *  @name   Geometry
+   *  @fn     int Geometry(const cv::Size& size,
+                           std::vector<Warp>* warps) const
+   *  @brief  Identity warp
+   *  @param[in]  size  Input image size
+   *  @param[out] warps Warps are appended to it
+   *  @return -1 if error, 0 otherwise
+   */
+  int Geometry(const cv::Size& size, std::vector<Warp>* warps) const;
+  
 #pragma mark -
 #pragma mark Accessors
   
@@ -77,6 +99,15 @@ class FK_EXPORTS IdentityCell : public AugmentationCell {
     return "IdentityCell";
   }
   
+  /**
+   *  @name   is_geometric
+   *  @fn     bool is_geometric(void) const
+   *  @brief  Indicate if the cell implements `Geometry`
+   */
+  bool is_geometric(void) const {
+    return true;
+  }
+  
 };
 
 }  // namespace FaceKit
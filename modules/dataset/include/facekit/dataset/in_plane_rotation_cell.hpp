@@ -69,6 +69,28 @@ class FK_EXPORTS ImgInPlaneRotationCell : public AugmentationCell {
               const std::string& output,
               std::vector<std::string>* generated) const;
   
+  /**
+   *  @name   Transform
+   *  @fn     int Transform(const Sample& input,
+                            std::vector<Sample>* generated) const
+   *  @brief  Rotate an image already in memory
+   *  @param[in]  input     Sample to augment
+   *  @param[out] generated Generated samples are appended to it
+   *  @return -1 if error, 0 otherwise
+   */
+  int Transform(const Sample& input, std::vector<Sample>* generated) const;
+  
+  /**
+   *  @name   Geometry
+   *  @fn     int Geometry(const cv::Size& size,
+                           std::vector<Warp>* warps) const
+   *  @brief  Draw the random rotations as affine warps
+   *  @param[in]  size  Input image size
+   *  @param[out] warps Warps are appended to it
+   *  @return -1 if error, 0 otherwise
+   */
+  int Geometry(const cv::Size& size, std::vector<Warp>* warps) const;
+  
 #pragma mark -
 #pragma mark Accessors
   
@@ -81,6 +103,22 @@ class FK_EXPORTS ImgInPlaneRotationCell : public AugmentationCell {
     return "ImgInPlaneRotationCell";
   }
   
+  /**
+   *  @name   config
+   *  @fn     std::string config(void) const
+   *  @brief  Describe the operation and its parameters
+   */
+  std::string config(void) const;
+  
+  /**
+   *  @name   is_geometric
+   *  @fn     bool is_geometric(void) const
+   *  @brief  Indicate if the cell implements `Geometry`
+   */
+  bool is_geometric(void) const {
+    return true;
+  }
+  
 #pragma mark -
 #pragma mark Private
 private:
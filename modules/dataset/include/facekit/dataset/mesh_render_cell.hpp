@@ -0,0 +1,158 @@
+/**
+ *  @file   mesh_render_cell.hpp
+ *  @brief  Generate out-of-plane rotations by fitting a 3D face model and
+ *          re-rendering the face under a new pose
+ *  @ingroup dataset
+ *
+ *  @author Christophe Ecabert
+ *  @date   10.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_MESH_RENDER_CELL__
+#define __FACEKIT_MESH_RENDER_CELL__
+
+#include <string>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/dataset/augmentation_cell.hpp"
+#include "facekit/geometry/mesh.hpp"
+#include "facekit/model/pca_model.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  MeshRenderCell
+ *  @brief  Fit a shape model and a weak perspective camera to the landmarks
+ *          of a sample, then render the face rotated out of plane (yaw and
+ *          pitch around the head's centroid, optionally with a perturbed
+ *          shape) with the CPU rasterizer. The texture is sampled from the
+ *          input image through the fitted geometry, the background is left
+ *          untouched. Requires landmarks, they are moved with the face.
+ *  @author Christophe Ecabert
+ *  @date   10.11.18
+ *  @ingroup dataset
+ */
+class FK_EXPORTS MeshRenderCell : public AugmentationCell {
+ public:
+
+#pragma mark -
+#pragma mark Type Definition
+
+  /**
+   *  @struct Options
+   *  @brief  Pose and shape perturbations
+   */
+  struct Options {
+    /** Yaw upper bound in degree, uniformly sampled in [-yaw, yaw] */
+    double yaw = 30.0;
+    /** Pitch upper bound in degree, uniformly sampled in [-pitch, pitch] */
+    double pitch = 10.0;
+    /** Standard deviation of the shape perturbation, in prior units */
+    double shape_sigma = 0.0;
+    /** Number of shape coefficients estimated from the landmarks */
+    int n_component = 40;
+    /** Weight of the coefficients' regularization while fitting */
+    float eta = 0.1f;
+    /** Fitting stopping criterion */
+    float eps = 1e-4f;
+    /** Number of sample to generate for each image */
+    size_t n_sample = 5;
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   MeshRenderCell
+   *  @fn     MeshRenderCell(const PCAModel<float>* model,
+                             const Mesh<float>& topology,
+                             const std::vector<int>& landmarks,
+                             const Options& options)
+   *  @brief  Constructor
+   *  @param[in] model      Shape model, must outlive the cell
+   *  @param[in] topology   Mesh holding the model's triangulation
+   *  @param[in] landmarks  Vertex index of each annotated landmark, in the
+   *                        annotation's order
+   *  @param[in] options    Perturbations
+   */
+  MeshRenderCell(const PCAModel<float>* model,
+                 const Mesh<float>& topology,
+                 const std::vector<int>& landmarks,
+                 const Options& options);
+
+  /**
+   *  @name   ~MeshRenderCell
+   *  @fn     ~MeshRenderCell(void) = default
+   *  @brief  Destructor
+   */
+  ~MeshRenderCell(void) = default;
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   Process
+   *  @fn     int Process(const std::vector<std::string>& input,
+                          const std::string& output,
+                          std::vector<std::string>* generated) const
+   *  @brief  Run augmentation step on provided data
+   *  @param[in]  input     List of file to augment
+   *  @param[in]  output    Location where to place the generated samples
+   *  @param[out] generated List of path to the generated samples
+   *  @return -1 if error, 0 otherwise
+   */
+  int Process(const std::vector<std::string>& input,
+              const std::string& output,
+              std::vector<std::string>* generated) const;
+
+  /**
+   *  @name   Transform
+   *  @fn     int Transform(const Sample& input,
+                            std::vector<Sample>* generated) const
+   *  @brief  Re-render the face of an image already in memory
+   *  @param[in]  input     Sample to augment, with landmarks
+   *  @param[out] generated Generated samples are appended to it
+   *  @return -1 if error, 0 otherwise
+   */
+  int Transform(const Sample& input, std::vector<Sample>* generated) const;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   name
+   *  @fn     const char* name(void) const
+   *  @brief  Provide name of the operation
+   */
+  const char* name(void) const {
+    return "MeshRenderCell";
+  }
+
+  /**
+   *  @name   config
+   *  @fn     std::string config(void) const
+   *  @brief  Describe the operation and its parameters
+   */
+  std::string config(void) const;
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Shape model */
+  const PCAModel<float>* model_;
+  /** Triangulation */
+  Mesh<float> topology_;
+  /** Landmark sub-model, empty if the landmarks are invalid */
+  PCAModel<float>::Subset subset_;
+  /** Perturbations */
+  Options options_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_MESH_RENDER_CELL__ */
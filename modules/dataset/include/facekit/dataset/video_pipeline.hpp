@@ -0,0 +1,326 @@
+/**
+ *  @file   video_pipeline.hpp
+ *  @brief  Fit every face of a video stream: frames are decoded ahead, the
+ *          faces of a frame are fitted in parallel starting from their pose
+ *          in the previous frame and results are delivered in order
+ *  @ingroup dataset
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_VIDEO_PIPELINE__
+#define __FACEKIT_VIDEO_PIPELINE__
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/nd_array.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/model/camera.hpp"
+#include "facekit/model/pca_model.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Forward declaration */
+class MemoryBudget;
+class ThreadPool;
+
+/**
+ *  @class  VideoPipeline
+ *  @brief  End-to-end processing of a video given as a sequence of frames,
+ *          each with the landmarks of the faces it shows. Three stages
+ *          overlap on a `ThreadPool`:
+ *            - Decoding, up to `look_ahead` frames ahead of the oldest one
+ *              not delivered yet, any number of them concurrently.
+ *            - Fitting, one frame after the other since a face starts from
+ *              its pose (and shape) in the previous frame. The faces of a
+ *              frame are fitted in parallel.
+ *            - Generation of the fitted shapes of a frame with a single
+ *              matrix product, while the next frame is being fitted.
+ *          Results are handed to the callback in frame order. Faces are
+ *          tracked by id across frames and across calls to `Run`, so a live
+ *          stream can be processed in consecutive chunks.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup dataset
+ *  @tparam T    Data type
+ *  @tparam ProjType Type of camera projection
+ */
+template<typename T, template<typename U> class ProjType>
+class FK_EXPORTS VideoPipeline {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /** Camera */
+  using Cam = Camera<T, ProjType>;
+  /** Solver options */
+  using FitOptions = typename Cam::FitOptions;
+  /** Stopping statistics */
+  using FitSummary = typename Cam::FitSummary;
+  /** Landmark sub-model */
+  using Subset = typename PCAModel<T>::Subset;
+
+  /**
+   *  @struct Face
+   *  @brief  Landmarks of one face in a frame
+   */
+  struct Face {
+    /** Track identifier, the same face keeps it from frame to frame */
+    int id;
+    /** Landmark positions in pixels [2N x 1] or [1 x 2N], in the order of
+        the landmark sub-model */
+    cv::Mat landmarks;
+  };
+
+  /**
+   *  @struct Frame
+   *  @brief  One frame of the video
+   */
+  struct Frame {
+    /** Image file */
+    std::string path;
+    /** Faces seen in the frame */
+    std::vector<Face> faces;
+  };
+
+  /**
+   *  @struct FaceFit
+   *  @brief  Fitted face
+   */
+  struct FaceFit {
+    /** Track identifier */
+    int id = -1;
+    /** Result of the fit: -2 if numerical error, -1 if not converged, 0
+        otherwise */
+    int status = -1;
+    /** Camera solver statistics */
+    FitSummary summary;
+    /** Camera parameters [f cx cy qx qy qz qw tx ty tz] */
+    T camera[10];
+    /** Shape coefficients [n_shape x 1], empty if the shape is not fitted */
+    cv::Mat coef;
+  };
+
+  /**
+   *  @struct Result
+   *  @brief  Everything computed for one frame
+   */
+  struct Result {
+    /** Position of the frame in the input */
+    size_t index = 0;
+    /** Decoding status, faces are not fitted if it failed */
+    Status status;
+    /** Decoded frame (`kUInt8`, height x width x channels), empty unless
+        `keep_image` is set */
+    NDArray image;
+    /** Fitted faces, in the order of the frame's faces */
+    std::vector<FaceFit> faces;
+    /** Generated shapes, one column per face [dim x n_face], empty unless
+        `generate` is set */
+    cv::Mat shapes;
+  };
+
+  /**
+   *  @struct Options
+   *  @brief  Pipeline configuration
+   */
+  struct Options {
+    /** Maximum number of frames decoded and not delivered yet, 0 selects
+        twice the number of workers of the pool */
+    size_t look_ahead = 0;
+    /** Camera solver options, `warm_start` is set per face */
+    FitOptions fit;
+    /** Start faces seen in the previous frame from their last pose and
+        shape, otherwise every frame is fitted from scratch */
+    bool tracking = true;
+    /** Number of frames a face can be missing before its track is dropped */
+    size_t max_missed = 30;
+    /** Focal length in pixels of new tracks, 0 uses the frame's width */
+    T focal = T(0.0);
+    /** Number of shape coefficients jointly fitted with the camera, 0 fits
+        the camera on the mean shape only */
+    int n_shape = 0;
+    /** Weight of the coefficients' regularization `eta * |p|^2` */
+    T eta = T(1.0);
+    /** Shape fitting stopping criterion */
+    T eps = T(1e-3);
+    /** Generate the full shape of every fitted face */
+    bool generate = true;
+    /** Hand the decoded frame over with its result */
+    bool keep_image = false;
+    /** Pool running the stages, nullptr use the global pool */
+    ThreadPool* pool = nullptr;
+    /** Budget charged with the decoded frames until they are delivered,
+        nullptr use `MemoryBudget::Global()` */
+    MemoryBudget* budget = nullptr;
+  };
+
+  /**
+   *  @name   Callback
+   *  @brief  Invoked once per frame, in frame order. Calls are serialized
+   *          but may come from any thread, a slow callback holds the
+   *          decoding back once `look_ahead` frames are waiting.
+   */
+  using Callback = std::function<void(Result&& result)>;
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   VideoPipeline
+   *  @fn     VideoPipeline(void)
+   *  @brief  Constructor, default options
+   */
+  VideoPipeline(void);
+
+  /**
+   *  @name   VideoPipeline
+   *  @fn     explicit VideoPipeline(const Options& options)
+   *  @brief  Constructor
+   *  @param[in] options  Pipeline configuration
+   */
+  explicit VideoPipeline(const Options& options);
+
+  /**
+   *  @name   VideoPipeline
+   *  @fn     VideoPipeline(const VideoPipeline& other) = delete
+   *  @brief  Copy constructor
+   */
+  VideoPipeline(const VideoPipeline& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     VideoPipeline& operator=(const VideoPipeline& rhs) = delete
+   *  @brief  Assignment operator
+   */
+  VideoPipeline& operator=(const VideoPipeline& rhs) = delete;
+
+  /**
+   *  @name   ~VideoPipeline
+   *  @fn     ~VideoPipeline(void)
+   *  @brief  Destructor
+   */
+  ~VideoPipeline(void);
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   Run
+   *  @fn     Status Run(const PCAModel<T>& model, const Subset& landmarks,
+                         const std::vector<Frame>& frames,
+                         const Callback& callback)
+   *  @brief  Process \p frames, following the frames given to previous
+   *          calls. Returns once every frame has been delivered. Frames are
+   *          checked before any of them is decoded.
+   *  @param[in] model      Shape model
+   *  @param[in] landmarks  Landmark sub-model, see `PCAModel::BuildSubset`
+   *  @param[in] frames     Frames to process
+   *  @param[in] callback   Completion callback
+   *  @return kInvalidArgument if the model or a face is malformed, first
+   *          decoding error otherwise
+   */
+  Status Run(const PCAModel<T>& model,
+             const Subset& landmarks,
+             const std::vector<Frame>& frames,
+             const Callback& callback);
+
+  /**
+   *  @name   Reset
+   *  @fn     void Reset(void)
+   *  @brief  Drop every track, the next frame starts a new video
+   */
+  void Reset(void);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   options
+   *  @fn     const Options& options(void) const
+   *  @brief  Pipeline configuration
+   */
+  const Options& options(void) const {
+    return options_;
+  }
+
+  /**
+   *  @name   set_options
+   *  @fn     void set_options(const Options& options)
+   *  @brief  Set pipeline configuration, tracks are kept
+   */
+  void set_options(const Options& options) {
+    options_ = options;
+  }
+
+  /**
+   *  @name   n_track
+   *  @fn     size_t n_track(void) const
+   *  @brief  Number of faces currently tracked
+   */
+  size_t n_track(void) const {
+    return tracks_.size();
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /**
+   *  @struct Track
+   *  @brief  State of a face carried from frame to frame
+   */
+  struct Track {
+    /** Camera, pose of the last frame the face was seen in */
+    std::unique_ptr<Cam> camera;
+    /** Shape coefficients [n_shape x 1] */
+    cv::Mat coef;
+    /** Last frame the face was seen in */
+    size_t last = 0;
+    /** Pose and shape can be used as a starting point */
+    bool valid = false;
+  };
+
+  /**
+   *  @name   Fit
+   *  @fn     void Fit(const PCAModel<T>& model, const Subset& landmarks,
+                       const Frame& frame, const size_t& frame_id,
+                       const NDArray* image, Result* result)
+   *  @brief  Fit the faces of one frame, in parallel, and update the tracks
+   *  @param[in] model      Shape model
+   *  @param[in] landmarks  Landmark sub-model
+   *  @param[in] frame      Frame to fit
+   *  @param[in] frame_id   Position of the frame since the last `Reset`
+   *  @param[in] image      Decoded frame
+   *  @param[out] result    Receives the fitted faces
+   */
+  void Fit(const PCAModel<T>& model,
+           const Subset& landmarks,
+           const Frame& frame,
+           const size_t& frame_id,
+           const NDArray* image,
+           Result* result);
+
+  /** Configuration */
+  Options options_;
+  /** Tracked faces */
+  std::unordered_map<int, Track> tracks_;
+  /** Number of frames processed since the last `Reset` */
+  size_t n_frame_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_VIDEO_PIPELINE__ */
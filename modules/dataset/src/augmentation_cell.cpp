@@ -0,0 +1,237 @@
+/**
+ *  @file   augmentation_cell.cpp
+ *  @brief Interface for various augementation cells
+ *  @ingroup dataset
+ *
+ *  @author Christophe Ecabert
+ *  @date   08.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+
+#include "facekit/dataset/augmentation_cell.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/** Global seed */
+static std::atomic<uint64_t> global_seed(0);
+  
+/**
+ *  @name   HashName
+ *  @fn     static uint64_t HashName(const std::string& name)
+ *  @brief  FNV-1a of a sample name, finalized with SplitMix64
+ */
+static uint64_t HashName(const std::string& name) {
+  uint64_t h = 0xCBF29CE484222325ULL;
+  for (const char c : name) {
+    h ^= static_cast<uint8_t>(c);
+    h *= 0x100000001B3ULL;
+  }
+  h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+  return h ^ (h >> 31);
+}
+  
+/**
+ *  @name   SidecarPath
+ *  @fn     static std::string SidecarPath(const std::string& path)
+ *  @brief  Path of the annotation file of an image, extension replaced by
+ *          `pts`
+ */
+static std::string SidecarPath(const std::string& path) {
+  const size_t slash = path.find_last_of("/\\");
+  const size_t dot = path.rfind('.');
+  const bool has_ext = dot != std::string::npos &&
+                       (slash == std::string::npos || dot > slash);
+  return (has_ext ? path.substr(0, dot) : path) + ".pts";
+}
+  
+#pragma mark -
+#pragma mark Usage
+  
+/*
+ *  @name   Generator
+ *  @fn     static Random& Generator(void)
+ *  @brief  Random generator of the calling thread used by every cell
+ */
+AugmentationCell::Random& AugmentationCell::Generator(void) {
+  thread_local Random gen(global_seed.load());
+  return gen;
+}
+  
+/*
+ *  @name   Reseed
+ *  @fn     static void Reseed(const std::string& name)
+ *  @brief  Select the random stream of the sample \p name under the global
+ *          seed
+ *  @param[in] name Name of the sample about to be transformed
+ */
+void AugmentationCell::Reseed(const std::string& name) {
+  Generator().Seed(global_seed.load(), HashName(name));
+}
+  
+/*
+ *  @name   SetSeed
+ *  @fn     static void SetSeed(const uint64_t& seed)
+ *  @brief  Set the global seed of the augmentations
+ */
+void AugmentationCell::SetSeed(const uint64_t& seed) {
+  global_seed.store(seed);
+}
+  
+/*
+ *  @name   seed
+ *  @fn     static uint64_t seed(void)
+ *  @brief  Global seed of the augmentations
+ */
+uint64_t AugmentationCell::seed(void) {
+  return global_seed.load();
+}
+  
+#pragma mark -
+#pragma mark Annotations
+  
+/*
+ *  @name   MapAnnotations
+ *  @fn     static void MapAnnotations(const cv::Matx23d& transform,
+                                       const Sample& input, Sample* output)
+ *  @brief  Map the annotations of \p input into \p output with the warp
+ *          that generated it
+ *  @param[in]  transform Warp from \p input to \p output
+ *  @param[in]  input     Annotated sample
+ *  @param[out] output    Generated sample, its annotations are replaced
+ */
+void AugmentationCell::MapAnnotations(const cv::Matx23d& transform,
+                                      const Sample& input,
+                                      Sample* output) {
+  const cv::Matx23f m = transform;
+  output->landmarks.clear();
+  output->bboxes.clear();
+  if (!input.landmarks.empty()) {
+    cv::transform(input.landmarks, output->landmarks, m);
+  }
+  if (!input.bboxes.empty()) {
+    // Map the four corners of every box at once
+    const size_t n = input.bboxes.size();
+    std::vector<cv::Point2f> corners(4 * n);
+    for (size_t k = 0; k < n; ++k) {
+      const cv::Rect2f& b = input.bboxes[k];
+      corners[4 * k] = cv::Point2f(b.x, b.y);
+      corners[4 * k + 1] = cv::Point2f(b.x + b.width, b.y);
+      corners[4 * k + 2] = cv::Point2f(b.x, b.y + b.height);
+      corners[4 * k + 3] = cv::Point2f(b.x + b.width, b.y + b.height);
+    }
+    cv::transform(corners, corners, m);
+    output->bboxes.resize(n);
+    for (size_t k = 0; k < n; ++k) {
+      const cv::Point2f* c = &corners[4 * k];
+      const float x0 = std::min(std::min(c[0].x, c[1].x),
+                                std::min(c[2].x, c[3].x));
+      const float x1 = std::max(std::max(c[0].x, c[1].x),
+                                std::max(c[2].x, c[3].x));
+      const float y0 = std::min(std::min(c[0].y, c[1].y),
+                                std::min(c[2].y, c[3].y));
+      const float y1 = std::max(std::max(c[0].y, c[1].y),
+                                std::max(c[2].y, c[3].y));
+      output->bboxes[k] = cv::Rect2f(x0, y0, x1 - x0, y1 - y0);
+    }
+  }
+}
+  
+/*
+ *  @name   LoadAnnotations
+ *  @fn     static int LoadAnnotations(const std::string& path,
+                                       Sample* sample)
+ *  @brief  Load the landmarks of the image \p path from its sidecar file
+ *  @param[in]  path    Image path
+ *  @param[out] sample  Sample receiving the landmarks
+ *  @return -1 if the sidecar is malformed, 0 otherwise
+ */
+int AugmentationCell::LoadAnnotations(const std::string& path,
+                                      Sample* sample) {
+  sample->landmarks.clear();
+  std::ifstream stream(SidecarPath(path).c_str());
+  if (!stream.is_open()) {
+    return 0;
+  }
+  // Header till the opening brace, then one `x y` pair per line
+  std::string line;
+  size_t n_point = 0;
+  bool body = false;
+  while (std::getline(stream, line)) {
+    if (!body) {
+      if (line.compare(0, 9, "n_points:") == 0) {
+        std::istringstream str(line.substr(9));
+        if (!(str >> n_point)) {
+          return -1;
+        }
+      } else if (line.compare(0, 1, "{") == 0) {
+        body = true;
+        sample->landmarks.reserve(n_point);
+      }
+      continue;
+    }
+    if (line.compare(0, 1, "}") == 0) {
+      return sample->landmarks.size() == n_point ? 0 : -1;
+    }
+    std::istringstream str(line);
+    cv::Point2f p;
+    if (!(str >> p.x >> p.y)) {
+      return -1;
+    }
+    sample->landmarks.push_back(p);
+  }
+  return -1;
+}
+  
+/*
+ *  @name   SaveAnnotations
+ *  @fn     static int SaveAnnotations(const std::string& path,
+                                       const Sample& sample)
+ *  @brief  Write the landmarks of \p sample into the sidecar file of the
+ *          image \p path, nothing is written if there are none
+ *  @param[in]  path    Image path
+ *  @param[in]  sample  Annotated sample
+ *  @return -1 if error, 0 otherwise
+ */
+int AugmentationCell::SaveAnnotations(const std::string& path,
+                                      const Sample& sample) {
+  if (sample.landmarks.empty()) {
+    return 0;
+  }
+  std::ofstream stream(SidecarPath(path).c_str());
+  if (!stream.is_open()) {
+    return -1;
+  }
+  return AugmentationCell::WriteAnnotations(sample, &stream);
+}
+  
+/*
+ *  @name   WriteAnnotations
+ *  @fn     static int WriteAnnotations(const Sample& sample,
+                                        std::ostream* stream)
+ *  @brief  Write the landmarks of \p sample in the sidecar format
+ *  @param[in]  sample  Annotated sample
+ *  @param[out] stream  Where to write them
+ *  @return -1 if error, 0 otherwise
+ */
+int AugmentationCell::WriteAnnotations(const Sample& sample,
+                                       std::ostream* stream) {
+  *stream << "version: 1\n";
+  *stream << "n_points: " << sample.landmarks.size() << "\n{\n";
+  for (const auto& p : sample.landmarks) {
+    *stream << p.x << " " << p.y << "\n";
+  }
+  *stream << "}\n";
+  return stream->good() ? 0 : -1;
+}
+  
+}  // namespace FaceKit
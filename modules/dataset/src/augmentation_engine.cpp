@@ -8,9 +8,29 @@
  *  Copyright © 2017 Christophe Ecabert. All rights reserved.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "opencv2/core.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
+#include "opencv2/core/ocl.hpp"
+
 #include "facekit/dataset/augmentation_engine.hpp"
+#include "facekit/dataset/augmentation_sink.hpp"
+#include "facekit/dataset/augmentation_stats.hpp"
 #include "facekit/core/error.hpp"
 #include "facekit/core/logger.hpp"
+#include "facekit/core/task_group.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/trace.hpp"
+#include "facekit/core/utils/string.hpp"
 #include "facekit/io/file_io.hpp"
 #include "facekit/dataset/identity_cell.hpp"
 #include "facekit/dataset/in_plane_rotation_cell.hpp"
@@ -22,6 +42,541 @@
  *  @brief      Development space
  */
 namespace FaceKit {
+namespace internal {
+  
+/** Consecutive cells run as a single step */
+using Step = std::vector<const AugmentationCell*>;
+  
+/**
+ *  @name   BuildSteps
+ *  @fn     static std::vector<Step> BuildSteps(const std::vector<
+                std::pair<const AugmentationCell*, bool>>& seq)
+ *  @brief  Group runs of consecutive geometric cells into a single step
+ */
+static std::vector<Step> BuildSteps(
+        const std::vector<std::pair<const AugmentationCell*, bool>>& seq) {
+  std::vector<Step> steps;
+  for (size_t i = 0; i < seq.size(); ++i) {
+    const auto* cell = seq[i].first;
+    const bool fuse = i > 0 &&
+                      cell->is_geometric() &&
+                      seq[i - 1].first->is_geometric();
+    if (fuse) {
+      steps.back().push_back(cell);
+    } else {
+      steps.push_back({cell});
+    }
+  }
+  return steps;
+}
+  
+/**
+ *  @name   StageNames
+ *  @fn     static std::vector<std::string> StageNames(
+                const std::vector<Step>& steps)
+ *  @brief  Name of the stages of the in-memory modes: decoding, each step
+ *          (fused cells joined by '+') and encoding
+ */
+static std::vector<std::string> StageNames(const std::vector<Step>& steps) {
+  std::vector<std::string> names(1, "Decode");
+  for (const auto& step : steps) {
+    std::string name;
+    for (const auto* cell : step) {
+      name += (name.empty() ? "" : "+") + std::string(cell->name());
+    }
+    names.push_back(name);
+  }
+  names.push_back("Encode");
+  return names;
+}
+  
+/**
+ *  @name   ComposeWarps
+ *  @fn     static int ComposeWarps(const Step& step,
+                         const AugmentationCell::Sample& input,
+                         std::vector<AugmentationCell::Warp>* warps)
+ *  @brief  Compose the warps of every path through a step of geometric
+ *          cells, each cell draws from the same random stream as when it
+ *          runs alone
+ *  @return -1 if error, 0 otherwise
+ */
+static int ComposeWarps(const Step& step,
+                        const AugmentationCell::Sample& input,
+                        std::vector<AugmentationCell::Warp>* warps) {
+  using Warp = AugmentationCell::Warp;
+  warps->assign(1, Warp());
+  (*warps)[0].transform = cv::Matx23d(1.0, 0.0, 0.0, 0.0, 1.0, 0.0);
+  (*warps)[0].size = input.image.size();
+  std::vector<Warp> next, cell_warps;
+  int err = 0;
+  for (const auto* cell : step) {
+    next.clear();
+    for (const auto& w : *warps) {
+      // Same random stream as the unfused sample
+      cell_warps.clear();
+      AugmentationCell::Reseed(input.name + w.name);
+      if (cell->Geometry(w.size, &cell_warps) != 0) {
+        err = -1;
+        continue;
+      }
+      for (const auto& cw : cell_warps) {
+        next.push_back({AugmentationCell::Compose(cw.transform,
+                                                 w.transform),
+                        cw.size,
+                        w.name + cw.name});
+      }
+    }
+    warps->swap(next);
+  }
+  return err;
+}
+  
+/**
+ *  @name   ResampleOnDevice
+ *  @fn     static void ResampleOnDevice(const AugmentationCell::Sample& input,
+                         const std::vector<AugmentationCell::Warp>& warps,
+                         std::vector<AugmentationCell::Sample>* generated)
+ *  @brief  Resample every warp of an input with OpenCL. The input is
+ *          uploaded once into host-accessible (pinned) memory, all warps
+ *          are queued before the first download so the transfers of a
+ *          sample overlap with the kernels of the next ones.
+ */
+static void ResampleOnDevice(const AugmentationCell::Sample& input,
+                             const std::vector<AugmentationCell::Warp>& warps,
+                             std::vector<AugmentationCell::Sample>* generated) {
+  using Sample = AugmentationCell::Sample;
+  cv::UMat src(cv::USAGE_ALLOCATE_HOST_MEMORY);
+  input.image.copyTo(src);
+  std::vector<cv::UMat> dst;
+  dst.reserve(warps.size());
+  for (const auto& w : warps) {
+    dst.emplace_back(cv::USAGE_ALLOCATE_HOST_MEMORY);
+    cv::warpAffine(src, dst.back(), w.transform, w.size, cv::INTER_LINEAR);
+  }
+  for (size_t k = 0; k < warps.size(); ++k) {
+    Sample sample;
+    dst[k].copyTo(sample.image);
+    sample.name = input.name + warps[k].name;
+    AugmentationCell::MapAnnotations(warps[k].transform, input, &sample);
+    generated->push_back(std::move(sample));
+  }
+}
+  
+/**
+ *  @name   RunStep
+ *  @fn     static int RunStep(const Step& step,
+                               const AugmentationCell::Sample& input,
+                               const bool& device,
+                               std::vector<AugmentationCell::Sample>* generated)
+ *  @brief  Run a step on a sample. A run of geometric cells composes the
+ *          warps of every output then resamples the input once, only over
+ *          the output region. A single cell uses its own `Transform`
+ *          (i.e. flip/crop copies instead of interpolating). With \p device
+ *          every geometric step is resampled with OpenCL, integer warps
+ *          (flip/crop) give the same pixels as the copies.
+ *  @return -1 if error, 0 otherwise
+ */
+static int RunStep(const Step& step,
+                   const AugmentationCell::Sample& input,
+                   const bool& device,
+                   std::vector<AugmentationCell::Sample>* generated) {
+  using Sample = AugmentationCell::Sample;
+  using Warp = AugmentationCell::Warp;
+  const bool geometric = step[0]->is_geometric();
+  if (step.size() == 1 && !(device && geometric)) {
+    AugmentationCell::Reseed(input.name);
+    return step[0]->Transform(input, generated);
+  }
+  if (input.image.empty()) {
+    return -1;
+  }
+  std::vector<Warp> warps;
+  const int err = ComposeWarps(step, input, &warps);
+  if (device) {
+    ResampleOnDevice(input, warps, generated);
+    return err;
+  }
+  // Single resample per output
+  for (const auto& w : warps) {
+    Sample sample;
+    cv::warpAffine(input.image,
+                   sample.image,
+                   w.transform,
+                   w.size,
+                   cv::INTER_LINEAR);
+    sample.name = input.name + w.name;
+    AugmentationCell::MapAnnotations(w.transform, input, &sample);
+    generated->push_back(std::move(sample));
+  }
+  return err;
+}
+  
+/**
+ *  @name   SelectDevice
+ *  @fn     static bool SelectDevice(const bool& requested)
+ *  @brief  Enable OpenCL if requested and a device is available
+ *  @return True if geometric steps run on the device
+ */
+static bool SelectDevice(const bool& requested) {
+  if (!requested) {
+    return false;
+  }
+  if (cv::ocl::haveOpenCL()) {
+    cv::ocl::setUseOpenCL(true);
+  }
+  if (!cv::ocl::useOpenCL()) {
+    FACEKIT_LOG_INFO("No OpenCL device available, resampling on the CPU");
+    return false;
+  }
+  FACEKIT_LOG_INFO("Resampling on " << cv::ocl::Device::getDefault().name());
+  return true;
+}
+
+/**
+ *  @name   SampleBytes
+ *  @fn     static size_t SampleBytes(const AugmentationCell::Sample& sample)
+ *  @brief  Memory footprint of the pixels of a sample
+ */
+static size_t SampleBytes(const AugmentationCell::Sample& sample) {
+  return sample.image.total() * sample.image.elemSize();
+}
+  
+/**
+ *  @name   GroupByInput
+ *  @fn     static void GroupByInput(const std::vector<std::string>& input,
+                        const std::vector<std::string>& generated,
+                        std::vector<std::vector<std::string>>* output)
+ *  @brief  Assign every generated file to the input it derives from. Cells
+ *          append `_<tag>` to the name of their input, the owner is the
+ *          input with the longest name prefixing the generated one.
+ */
+static void GroupByInput(const std::vector<std::string>& input,
+                         const std::vector<std::string>& generated,
+                         std::vector<std::vector<std::string>>* output) {
+  std::unordered_map<std::string, size_t> owner;
+  for (size_t i = 0; i < input.size(); ++i) {
+    StringView file;
+    Path::SplitComponent(input[i], nullptr, &file, nullptr);
+    owner.emplace(std::string(file.data(), file.size()), i);
+  }
+  output->assign(input.size(), {});
+  for (const auto& path : generated) {
+    StringView file;
+    Path::SplitComponent(path, nullptr, &file, nullptr);
+    std::string name(file.data(), file.size());
+    while (true) {
+      const auto it = owner.find(name);
+      if (it != owner.end()) {
+        (*output)[it->second].push_back(path);
+        break;
+      }
+      const size_t pos = name.rfind('_');
+      if (pos == std::string::npos) {
+        break;
+      }
+      name.resize(pos);
+    }
+  }
+}
+  
+/**
+ *  @class  AugmentationPipeline
+ *  @brief  State shared by the tasks of `AugmentationEngine::RunPipelined`.
+ *          Stage `k` runs step `k`, samples leaving the last one are handed
+ *          to the sink. Each stage owns a FIFO drained by at most `width`
+ *          tasks. Every input holds a token until all its derived samples
+ *          are gone, releasing it starts decoding the next input. Every
+ *          sample also holds its part of the memory budget, decoding waits
+ *          for it while helping the pool drain the stages.
+ */
+class AugmentationPipeline {
+ public:
+  /** Sample */
+  using Sample = AugmentationCell::Sample;
+  
+  /**
+   *  @name   AugmentationPipeline
+   *  @fn     AugmentationPipeline(const std::vector<std::string>& input,
+                          const std::vector<Step>& steps,
+                          AugmentationSink* sink, const size_t& width,
+                          const bool& device, MemoryBudget* budget,
+                          AugmentationStats* stats, TaskGroup* group)
+   *  @brief  Constructor
+   *  @param[in] input  Files to augment
+   *  @param[in] steps  Augmentation steps
+   *  @param[in] sink   Opened sink receiving the final samples
+   *  @param[in] width  Maximum number of tasks draining a stage
+   *  @param[in] device Resample geometric steps with OpenCL
+   *  @param[in] budget Memory budget of the samples
+   *  @param[in] stats  Statistics, stage `k` is accounted in `k + 1`
+   *  @param[in] group  Group running the tasks, on the global pool
+   */
+  AugmentationPipeline(const std::vector<std::string>& input,
+                       const std::vector<Step>& steps,
+                       AugmentationSink* sink,
+                       const size_t& width,
+                       const bool& device,
+                       MemoryBudget* budget,
+                       AugmentationStats* stats,
+                       TaskGroup* group) : input_(input),
+                                           steps_(steps),
+                                           sink_(sink),
+                                           width_(width),
+                                           device_(device),
+                                           budget_(budget),
+                                           stats_(stats),
+                                           group_(group),
+                                           stages_(steps.size()),
+                                           ext_(input.size()),
+                                           pending_(new std::atomic<size_t>[
+                                                            input.size()]),
+                                           failed_(input.size(), 0),
+                                           next_(0),
+                                           n_error_(0) {}
+  
+  /**
+   *  @name   Start
+   *  @fn     void Start(const size_t& capacity)
+   *  @brief  Start decoding the first \p capacity inputs
+   */
+  void Start(const size_t& capacity) {
+    for (size_t k = 0; k < capacity; ++k) {
+      this->Next();
+    }
+  }
+  
+  /**
+   *  @name   n_error
+   *  @fn     size_t n_error(void) const
+   *  @brief  Number of failures, writes excluded
+   */
+  size_t n_error(void) const {
+    return n_error_.load();
+  }
+  
+  /**
+   *  @name   failed
+   *  @fn     const std::vector<uint8_t>& failed(void) const
+   *  @brief  Non zero for each input that failed, writes excluded
+   */
+  const std::vector<uint8_t>& failed(void) const {
+    return failed_;
+  }
+  
+ private:
+  /**
+   *  @struct Item
+   *  @brief  Sample waiting in a stage's queue
+   */
+  struct Item {
+    /** Sample */
+    Sample sample;
+    /** Input it derives from */
+    size_t input;
+    /** Time it entered its queue, ns */
+    int64_t queued;
+    /** Reservation of the sample's memory */
+    MemoryBudget::Token token;
+  };
+  
+  /**
+   *  @struct Stage
+   *  @brief  Queue of a stage
+   */
+  struct Stage {
+    /** Pending samples */
+    std::deque<Item> queue;
+    /** Number of tasks draining the queue */
+    size_t running = 0;
+    /** Synchronization */
+    std::mutex lock;
+  };
+  
+  /**
+   *  @name   Next
+   *  @fn     void Next(void)
+   *  @brief  Take a token, decode the next input if any
+   */
+  void Next(void) {
+    const size_t i = next_.fetch_add(1);
+    if (i < input_.size()) {
+      group_->Run([this, i](void) {
+        this->Decode(i);
+      });
+    }
+  }
+  
+  /**
+   *  @name   Decode
+   *  @fn     void Decode(const size_t& i)
+   *  @brief  Load input \p i and push it into the first stage
+   */
+  void Decode(const size_t& i) {
+    const int64_t start = Tracer::Now();
+    StringView file, ext;
+    Path::SplitComponent(input_[i], nullptr, &file, &ext);
+    ext_[i].assign(ext.data(), ext.size());
+    Item item;
+    item.sample.image = cv::imread(input_[i],
+                                   cv::ImreadModes::IMREAD_COLOR);
+    item.sample.name.assign(file.data(), file.size());
+    item.input = i;
+    stats_->AddRead(0, AugmentationStats::FileSize(input_[i]));
+    if (item.sample.image.empty() ||
+        AugmentationCell::LoadAnnotations(input_[i], &item.sample) != 0) {
+      stats_->AddError(0);
+      stats_->Add(0, 1, 0, Tracer::Now() - start);
+      this->Fail(i);
+      // Token released right away
+      this->Next();
+      return;
+    }
+    stats_->Add(0, 1, 1, Tracer::Now() - start);
+    // Stages are drained by the same pool, help them while over budget
+    budget_->Acquire(SampleBytes(item.sample),
+                     &ThreadPool::Get(),
+                     &item.token);
+    pending_[i].store(1);
+    this->Forward(0, std::move(item));
+  }
+  
+  /**
+   *  @name   Forward
+   *  @fn     void Forward(const size_t& stage, Item&& item)
+   *  @brief  Queue \p item in \p stage, or hand it to the sink once every
+   *          step is done
+   */
+  void Forward(const size_t& stage, Item&& item) {
+    if (stage < steps_.size()) {
+      this->Push(stage, std::move(item));
+    } else {
+      const size_t input = item.input;
+      sink_->Push(input,
+                  std::move(item.sample),
+                  ext_[input],
+                  std::move(item.token));
+      this->Release(input);
+    }
+  }
+  
+  /**
+   *  @name   Push
+   *  @fn     void Push(const size_t& stage, Item&& item)
+   *  @brief  Queue \p item in \p stage, add a task draining it if the
+   *          stage is not saturated
+   */
+  void Push(const size_t& stage, Item&& item) {
+    Stage& st = stages_[stage];
+    {
+      std::lock_guard<std::mutex> lock(st.lock);
+      item.queued = Tracer::Now();
+      st.queue.push_back(std::move(item));
+      if (st.running >= width_) {
+        return;
+      }
+      ++st.running;
+    }
+    group_->Run([this, stage](void) {
+      this->Drain(stage);
+    });
+  }
+  
+  /**
+   *  @name   Drain
+   *  @fn     void Drain(const size_t& stage)
+   *  @brief  Process the queue of \p stage till it is empty
+   */
+  void Drain(const size_t& stage) {
+    Stage& st = stages_[stage];
+    while (true) {
+      Item item;
+      {
+        std::lock_guard<std::mutex> lock(st.lock);
+        if (st.queue.empty()) {
+          --st.running;
+          return;
+        }
+        item = std::move(st.queue.front());
+        st.queue.pop_front();
+      }
+      const int64_t start = Tracer::Now();
+      stats_->AddWait(stage + 1, start - item.queued);
+      std::vector<Sample> out;
+      if (RunStep(steps_[stage], item.sample, device_, &out) != 0) {
+        stats_->AddError(stage + 1);
+        this->Fail(item.input);
+      }
+      stats_->Add(stage + 1, 1, out.size(), Tracer::Now() - start);
+      // Account children before releasing the parent
+      pending_[item.input].fetch_add(out.size());
+      for (auto& sample : out) {
+        // Derived samples never wait, only decoding brings memory in
+        Item child{std::move(sample), item.input, 0};
+        budget_->Charge(SampleBytes(child.sample), &child.token);
+        this->Forward(stage + 1, std::move(child));
+      }
+      item.sample.image.release();
+      item.token.Release();
+      this->Release(item.input);
+    }
+  }
+  
+  /**
+   *  @name   Fail
+   *  @fn     void Fail(const size_t& input)
+   *  @brief  Report a failure while augmenting \p input
+   */
+  void Fail(const size_t& input) {
+    n_error_.fetch_add(1);
+    std::lock_guard<std::mutex> lock(record_lock_);
+    failed_[input] = 1;
+  }
+  
+  /**
+   *  @name   Release
+   *  @fn     void Release(const size_t& input)
+   *  @brief  One sample derived from \p input is gone, release the token
+   *          if it was the last one
+   */
+  void Release(const size_t& input) {
+    if (pending_[input].fetch_sub(1) == 1) {
+      this->Next();
+    }
+  }
+  
+  /** Files to augment */
+  const std::vector<std::string>& input_;
+  /** Augmentation steps */
+  const std::vector<Step>& steps_;
+  /** Destination of the final samples */
+  AugmentationSink* sink_;
+  /** Maximum number of tasks per stage */
+  size_t width_;
+  /** Resample geometric steps with OpenCL */
+  bool device_;
+  /** Memory budget */
+  MemoryBudget* budget_;
+  /** Statistics */
+  AugmentationStats* stats_;
+  /** Tasks */
+  TaskGroup* group_;
+  /** Stages, one per step */
+  std::vector<Stage> stages_;
+  /** Extension of each input */
+  std::vector<std::string> ext_;
+  /** Number of live samples derived from each input */
+  std::unique_ptr<std::atomic<size_t>[]> pending_;
+  /** Failure flag of each input */
+  std::vector<uint8_t> failed_;
+  /** Synchronization of `failed_` */
+  std::mutex record_lock_;
+  /** Next input to decode */
+  std::atomic<size_t> next_;
+  /** Number of failures */
+  std::atomic<size_t> n_error_;
+};
+  
+}  // namespace internal
   
 #pragma mark -
 #pragma mark Initialization
@@ -68,11 +623,9 @@ AugmentationEngine::~AugmentationEngine(void) {
  */
 int AugmentationEngine::ScanForData(const std::string& folder,
                                      const std::vector<std::string>& exts) {
-  // Seek for every extension
+  // Seek for every extension in a single walk
   input_.clear();
-  for (const auto& e : exts) {
-    IO::SearchInFolder(folder, e, &input_);
-  }
+  IO::SearchInFolder(folder, exts, &input_);
   return input_.empty() ? -1 : 0;
 }
   
@@ -163,18 +716,356 @@ void AugmentationEngine::AddImgCornerCropCell(AugmentationEngine& engine,
  *  @param[in] output Location where to store the generated data
  */
 void AugmentationEngine::Run(const std::string& output) {
+  const std::string dir = output.back() == '/' ? output : output + "/";
+  if (!sink_->is_directory()) {
+    FACEKIT_LOG_WARNING("Run writes through the cells, the sink is only "
+                        "used by RunStreaming and RunPipelined");
+  }
+  AugmentationManifest manifest("");
+  std::vector<std::string> files;
+  std::vector<uint64_t> hash;
+  this->Select(dir, "Run", &manifest, &files, &hash);
+  std::vector<std::string> names;
+  for (const auto& e : sequence_) {
+    names.push_back(e.first->name());
+  }
+  AugmentationStats stats(names, report_interval_);
   std::vector<std::string> gen;
+  int err = 0;
   for (size_t i = 0; i < sequence_.size(); ++i) {
     // Get generator
     const auto* cell = sequence_[i].first;
     // Log
     FACEKIT_LOG_INFO("Performing step: " << cell->name());
     // Process
-    const auto input = i == 0 ? input_ : gen;
-    if (cell->Process(input, output, &gen) != 0) {
-      FACEKIT_LOG_ERROR("Error while generating data");
+    const auto input = i == 0 ? files : gen;
+    const size_t first = gen.size();
+    const int64_t start = Tracer::Now();
+    {
+      FACEKIT_TRACE_SCOPE(cell->name());
+      if (cell->Process(input, output, &gen) != 0) {
+        FACEKIT_LOG_ERROR("Error while generating data");
+        stats.AddError(i);
+        err = -1;
+      }
+    }
+    // Cells decode, process and encode at once, only their wall time is
+    // known
+    const int64_t busy = Tracer::Now() - start;
+    for (const auto& f : input) {
+      stats.AddRead(i, AugmentationStats::FileSize(f));
     }
+    for (size_t k = first; k < gen.size(); ++k) {
+      stats.AddWritten(i, AugmentationStats::FileSize(gen[k]));
+    }
+    stats.Add(i, input.size(), gen.size() - first, busy);
+  }
+  stats.Report();
+  if (this->IsIncremental("Run")) {
+    // Failures are not tied to an input, retry all of them next time
+    std::vector<std::vector<std::string>> outputs;
+    internal::GroupByInput(files, gen, &outputs);
+    const std::vector<uint8_t> failed(files.size(), err != 0 ? 1 : 0);
+    this->Commit(dir, "Run", files, hash, outputs, failed, &manifest);
   }
 }
   
+/*
+ *  @name   RunStreaming
+ *  @fn     void RunStreaming(const std::string& output)
+ *  @brief  Run data augmentation chain in memory, only the samples coming
+ *          out of the last cell are written into \p output
+ *  @param[in] output Location where to store the generated data
+ */
+void AugmentationEngine::RunStreaming(const std::string& output) {
+  using Sample = AugmentationCell::Sample;
+  FACEKIT_TRACE_SCOPE("AugmentationEngine::RunStreaming");
+  FACEKIT_LOG_INFO("Streaming " << input_.size() << " samples through "
+                   << sequence_.size() << " steps");
+  const std::string dir = output.back() == '/' ? output : output + "/";
+  AugmentationManifest manifest("");
+  std::vector<std::string> files;
+  std::vector<uint64_t> hash;
+  this->Select(dir, "RunStreaming", &manifest, &files, &hash);
+  // Runs of geometric cells are fused into a single warp
+  const auto steps = internal::BuildSteps(sequence_);
+  const bool device = internal::SelectDevice(device_);
+  const size_t n_step = steps.size();
+  AugmentationStats stats(internal::StageNames(steps), report_interval_);
+  // Final samples are encoded and written by the sink's I/O threads
+  AugmentationSink* sink = sink_.get();
+  if (sink->Open(dir, files.size(), &stats, n_step + 1) != 0) {
+    FACEKIT_LOG_ERROR("Can not open the output sink in " << dir);
+    return;
+  }
+  MemoryBudget* budget = budget_;
+  std::atomic<size_t> n_error(0);
+  // Each task fills its own slot
+  std::vector<uint8_t> failed(files.size(), 0);
+  TaskGroup group;
+  for (size_t i = 0; i < files.size(); ++i) {
+    group.Run([i, device, n_step, sink, budget, &files, &steps, &stats,
+               &n_error, &failed](void) {
+      // Decode once
+      int64_t start = Tracer::Now();
+      StringView file, ext;
+      Path::SplitComponent(files[i], nullptr, &file, &ext);
+      std::vector<Sample> samples(1);
+      samples[0].image = cv::imread(files[i], cv::ImreadModes::IMREAD_COLOR);
+      samples[0].name.assign(file.data(), file.size());
+      stats.AddRead(0, AugmentationStats::FileSize(files[i]));
+      if (samples[0].image.empty() ||
+          AugmentationCell::LoadAnnotations(files[i], &samples[0]) != 0) {
+        stats.AddError(0);
+        stats.Add(0, 1, 0, Tracer::Now() - start);
+        n_error.fetch_add(1);
+        failed[i] = 1;
+        return;
+      }
+      stats.Add(0, 1, 1, Tracer::Now() - start);
+      // Wait for the budget before augmenting, the tasks holding it never
+      // wait on it and make progress
+      MemoryBudget::Token token;
+      budget->Acquire(internal::SampleBytes(samples[0]), &token);
+      // Chain steps, each one consumes every sample of the previous one
+      std::vector<Sample> next;
+      for (size_t s = 0; s < n_step; ++s) {
+        next.clear();
+        for (const auto& sample : samples) {
+          start = Tracer::Now();
+          const size_t n_prev = next.size();
+          if (internal::RunStep(steps[s], sample, device, &next) != 0) {
+            stats.AddError(s + 1);
+            n_error.fetch_add(1);
+            failed[i] = 1;
+          }
+          stats.Add(s + 1, 1, next.size() - n_prev, Tracer::Now() - start);
+        }
+        samples.swap(next);
+        size_t bytes = 0;
+        for (const auto& sample : samples) {
+          bytes += internal::SampleBytes(sample);
+        }
+        token.Resize(bytes);
+      }
+      // Hand final samples over to the sink with their part of the budget
+      const std::string extension(ext.data(), ext.size());
+      for (auto& sample : samples) {
+        const size_t bytes = internal::SampleBytes(sample);
+        MemoryBudget::Token part;
+        budget->Charge(bytes, &part);
+        token.Resize(token.bytes() - std::min(bytes, token.bytes()));
+        sink->Push(i, std::move(sample), extension, std::move(part));
+      }
+    });
+  }
+  group.Wait();
+  this->Finish(dir, "RunStreaming", files, hash, failed, n_error.load(),
+               &stats, &manifest);
+}
+  
+/*
+ *  @name   RunPipelined
+ *  @fn     void RunPipelined(const std::string& output,
+                              const size_t& capacity = 0)
+ *  @brief  Run data augmentation chain in memory as a pipeline, stages
+ *          overlap and at most \p capacity inputs are in flight
+ *  @param[in] output   Location where to store the generated data
+ *  @param[in] capacity Maximum number of inputs in flight, 0 selects
+ *                      twice the number of workers of the pool
+ */
+void AugmentationEngine::RunPipelined(const std::string& output,
+                                      const size_t& capacity) {
+  FACEKIT_TRACE_SCOPE("AugmentationEngine::RunPipelined");
+  const size_t n_worker = std::max<size_t>(ThreadPool::Get().size(), 1);
+  const size_t cap = capacity == 0 ? 2 * n_worker : capacity;
+  FACEKIT_LOG_INFO("Pipelining " << input_.size() << " samples through "
+                   << sequence_.size() << " steps, " << cap << " in flight");
+  const std::string dir = output.back() == '/' ? output : output + "/";
+  AugmentationManifest manifest("");
+  std::vector<std::string> files;
+  std::vector<uint64_t> hash;
+  this->Select(dir, "RunPipelined", &manifest, &files, &hash);
+  const auto steps = internal::BuildSteps(sequence_);
+  const bool device = internal::SelectDevice(device_);
+  AugmentationStats stats(internal::StageNames(steps), report_interval_);
+  AugmentationSink* sink = sink_.get();
+  if (sink->Open(dir, files.size(), &stats, steps.size() + 1) != 0) {
+    FACEKIT_LOG_ERROR("Can not open the output sink in " << dir);
+    return;
+  }
+  TaskGroup group;
+  internal::AugmentationPipeline pipeline(files,
+                                          steps,
+                                          sink,
+                                          n_worker,
+                                          device,
+                                          budget_,
+                                          &stats,
+                                          &group);
+  pipeline.Start(std::min(cap, files.size()));
+  group.Wait();
+  this->Finish(dir, "RunPipelined", files, hash, pipeline.failed(),
+               pipeline.n_error(), &stats, &manifest);
+}
+  
+#pragma mark -
+#pragma mark Private
+  
+/*
+ *  @name   Select
+ *  @fn     void Select(const std::string& dir, const char* mode,
+                        AugmentationManifest* manifest,
+                        std::vector<std::string>* input,
+                        std::vector<uint64_t>* hash) const
+ *  @brief  Select the inputs to augment, only the ones not up to date in
+ *          the manifest of \p dir for incremental runs
+ *  @param[in] dir        Output folder, with trailing separator
+ *  @param[in] mode       Run mode
+ *  @param[out] manifest  Manifest of the previous run
+ *  @param[out] input     Inputs to augment
+ *  @param[out] hash      Content hash of each selected input
+ */
+void AugmentationEngine::Select(const std::string& dir,
+                                const char* mode,
+                                AugmentationManifest* manifest,
+                                std::vector<std::string>* input,
+                                std::vector<uint64_t>* hash) const {
+  input->clear();
+  hash->clear();
+  if (!this->IsIncremental(mode)) {
+    if (incremental_) {
+      FACEKIT_LOG_WARNING("Incremental runs need a directory sink, every "
+                          "input is augmented");
+    }
+    *input = input_;
+    return;
+  }
+  // Outputs only depend on the mode, the cells and the seed
+  std::string config = std::string(mode) + ";" +
+                       std::to_string(AugmentationCell::seed());
+  for (const auto& e : sequence_) {
+    config += ";" + e.first->config();
+  }
+  *manifest = AugmentationManifest(config);
+  manifest->Load(dir + AugmentationManifest::kFilename);
+  manifest->Retain(input_);
+  // Hash the inputs, far cheaper than decoding and augmenting them
+  std::vector<uint64_t> h(input_.size(), 0);
+  std::vector<uint8_t> todo(input_.size(), 1);
+  ThreadPool::Get().ParallelFor(0,
+                                input_.size(),
+                                16,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t i = first; i < last; ++i) {
+      if (AugmentationManifest::HashFile(input_[i], &h[i]) == 0 &&
+          manifest->IsUpToDate(input_[i], h[i])) {
+        todo[i] = 0;
+      }
+    }
+  });
+  for (size_t i = 0; i < input_.size(); ++i) {
+    if (todo[i]) {
+      input->push_back(input_[i]);
+      hash->push_back(h[i]);
+    }
+  }
+  FACEKIT_LOG_INFO("Incremental run, " << input->size() << " out of "
+                   << input_.size() << " inputs to augment");
+}
+  
+/*
+ *  @name   Finish
+ *  @fn     void Finish(const std::string& dir, const char* mode,
+                        const std::vector<std::string>& input,
+                        const std::vector<uint64_t>& hash,
+                        const std::vector<uint8_t>& failed,
+                        const size_t& n_error, AugmentationStats* stats,
+                        AugmentationManifest* manifest)
+ *  @brief  Close the sink once every sample has been handed over, report
+ *          and update the manifest of an in-memory run
+ *  @param[in] dir      Output folder, with trailing separator
+ *  @param[in] mode     Run mode
+ *  @param[in] input    Augmented inputs
+ *  @param[in] hash     Content hash of each input
+ *  @param[in] failed   Non zero for each input that failed before writing
+ *  @param[in] n_error  Number of failures before writing
+ *  @param[in] stats    Statistics of the run
+ *  @param[in,out] manifest Manifest to update
+ */
+void AugmentationEngine::Finish(const std::string& dir,
+                                const char* mode,
+                                const std::vector<std::string>& input,
+                                const std::vector<uint64_t>& hash,
+                                const std::vector<uint8_t>& failed,
+                                const size_t& n_error,
+                                AugmentationStats* stats,
+                                AugmentationManifest* manifest) {
+  // Wait for the I/O threads
+  if (sink_->Close() != 0) {
+    FACEKIT_LOG_ERROR("Error while finalizing the output in " << dir);
+  }
+  stats->Report();
+  std::vector<uint8_t> flags(failed);
+  for (size_t i = 0; i < flags.size(); ++i) {
+    flags[i] |= sink_->failed()[i];
+  }
+  this->Commit(dir, mode, input, hash, sink_->outputs(), flags, manifest);
+  const size_t n_fail = n_error + sink_->n_error();
+  if (n_fail != 0) {
+    FACEKIT_LOG_ERROR("Error while generating data, " << n_fail <<
+                      " failure(s)");
+  }
+  FACEKIT_LOG_INFO("Generated " << sink_->n_output() << " samples");
+}
+  
+/*
+ *  @name   Commit
+ *  @fn     void Commit(const std::string& dir, const char* mode,
+                        const std::vector<std::string>& input,
+                        const std::vector<uint64_t>& hash,
+                        const std::vector<std::vector<std::string>>& output,
+                        const std::vector<uint8_t>& failed,
+                        AugmentationManifest* manifest) const
+ *  @brief  Record the samples generated for each input that succeeded and
+ *          save the manifest
+ *  @param[in] dir      Output folder, with trailing separator
+ *  @param[in] mode     Run mode
+ *  @param[in] input    Augmented inputs
+ *  @param[in] hash     Content hash of each input
+ *  @param[in] output   Samples generated from each input
+ *  @param[in] failed   Non zero for each input that failed
+ *  @param[in,out] manifest Manifest to update
+ */
+void AugmentationEngine::Commit(
+        const std::string& dir,
+        const char* mode,
+        const std::vector<std::string>& input,
+        const std::vector<uint64_t>& hash,
+        const std::vector<std::vector<std::string>>& output,
+        const std::vector<uint8_t>& failed,
+        AugmentationManifest* manifest) const {
+  if (!this->IsIncremental(mode)) {
+    return;
+  }
+  // Failed inputs keep no entry, they are retried by the next run
+  for (size_t i = 0; i < input.size(); ++i) {
+    if (!failed[i]) {
+      manifest->Update(input[i], hash[i], output[i]);
+    }
+  }
+  manifest->Save(dir + AugmentationManifest::kFilename);
+}
+  
+/*
+ *  @name   IsIncremental
+ *  @fn     bool IsIncremental(const std::string& mode) const
+ *  @brief  Indicate if a run in \p mode is incremental. The manifest tracks
+ *          files, therefore the in-memory modes need a directory sink.
+ *  @param[in] mode Run mode
+ */
+bool AugmentationEngine::IsIncremental(const std::string& mode) const {
+  return incremental_ && (mode == "Run" || sink_->is_directory());
+}
+  
 }  // namespace FaceKit
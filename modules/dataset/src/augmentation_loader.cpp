@@ -0,0 +1,319 @@
+/**
+ *  @file   augmentation_loader.cpp
+ *  @brief Stream augmented batches for training, nothing is written on disk
+ *  @ingroup dataset
+ *
+ *  @author Christophe Ecabert
+ *  @date   07.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <random>
+
+#include "opencv2/core.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
+
+#include "facekit/dataset/augmentation_loader.hpp"
+#include "facekit/core/logger.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/trace.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @name   Mix
+ *  @fn     static uint64_t Mix(uint64_t x)
+ *  @brief  SplitMix64 finalizer, decorrelates consecutive seeds
+ */
+static uint64_t Mix(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   AugmentationLoader
+ *  @fn     AugmentationLoader(const std::vector<std::string>& files,
+                               const Options& options)
+ *  @brief  Constructor
+ *  @param[in] files    Images to draw samples from
+ *  @param[in] options  Configuration
+ */
+AugmentationLoader::AugmentationLoader(const std::vector<std::string>& files,
+                                       const Options& options) :
+        files_(files),
+        options_(options),
+        epoch_(0),
+        produced_(0),
+        consumed_(0),
+        stop_(false),
+        n_error_(0) {
+  options_.batch_size = std::max<size_t>(options_.batch_size, 1);
+  options_.n_prefetch = std::max<size_t>(options_.n_prefetch, 1);
+  slots_.resize(options_.n_prefetch);
+}
+
+/*
+ *  @name   ~AugmentationLoader
+ *  @fn     ~AugmentationLoader(void)
+ *  @brief  Destructor, stop prefetching
+ */
+AugmentationLoader::~AugmentationLoader(void) {
+  this->Stop();
+  for (auto& e : sequence_) {
+    if (e.second) {
+      delete e.first;
+      e.first = nullptr;
+    }
+  }
+}
+
+/*
+ *  @name   Register
+ *  @fn     void Register(const AugmentationCell* cell, const bool own_it)
+ *  @brief  Add new augmentation step, must be called before `StartEpoch`
+ *  @param[in]  cell    New augmentation step to add
+ *  @param[in]  own_it  Indicates if the loader take the ownership of the
+ *                      cell
+ */
+void AugmentationLoader::Register(const AugmentationCell* cell,
+                                  const bool own_it) {
+  sequence_.emplace_back(cell, own_it);
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   StartEpoch
+ *  @fn     int StartEpoch(const size_t& epoch)
+ *  @brief  Shuffle the inputs for \p epoch and start prefetching its
+ *          batches. The last incomplete batch is dropped.
+ *  @param[in] epoch  Epoch index
+ *  @return -1 if there is not enough data for a batch, 0 otherwise
+ */
+int AugmentationLoader::StartEpoch(const size_t& epoch) {
+  this->Stop();
+  if (this->n_batch() == 0) {
+    FACEKIT_LOG_ERROR("Not enough data for a single batch");
+    return -1;
+  }
+  // Input order
+  epoch_ = epoch;
+  order_.resize(files_.size());
+  std::iota(order_.begin(), order_.end(), size_t(0));
+  if (options_.shuffle) {
+    std::mt19937_64 gen(Mix(Mix(options_.seed) ^ epoch));
+    std::shuffle(order_.begin(), order_.end(), gen);
+  }
+  // Reset slots and start prefetching
+  for (auto& slot : slots_) {
+    slot.ready = false;
+  }
+  produced_ = 0;
+  consumed_ = 0;
+  stop_ = false;
+  worker_ = std::thread(&AugmentationLoader::Prefetch, this);
+  return 0;
+}
+
+/*
+ *  @name   Next
+ *  @fn     bool Next(NDArray* batch, std::vector<size_t>* index = nullptr)
+ *  @brief  Get the next batch of the epoch, blocks till it is ready
+ *  @param[in,out] batch  Batch [batch_size x height x width x 3]
+ *  @param[out] index     Optional, position in `files` of each sample
+ *  @return False once every batch of the epoch has been consumed
+ */
+bool AugmentationLoader::Next(NDArray* batch, std::vector<size_t>* index) {
+  std::unique_lock<std::mutex> lock(lock_);
+  if (!worker_.joinable() || consumed_ == this->n_batch()) {
+    return false;
+  }
+  Slot& slot = slots_[consumed_ % slots_.size()];
+  {
+    FACEKIT_TRACE_SCOPE("AugmentationLoader::Wait");
+    cond_.wait(lock, [&slot](void) {
+      return slot.ready;
+    });
+  }
+  // Exchange buffers, the slot gets the caller's previous batch back
+  std::swap(*batch, slot.batch);
+  if (index) {
+    *index = slot.index;
+  }
+  slot.ready = false;
+  ++consumed_;
+  cond_.notify_all();
+  return true;
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ *  @name   Stop
+ *  @fn     void Stop(void)
+ *  @brief  Stop the prefetch thread of the current epoch
+ */
+void AugmentationLoader::Stop(void) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+/*
+ *  @name   Prefetch
+ *  @fn     void Prefetch(void)
+ *  @brief  Fill the batches of the current epoch
+ */
+void AugmentationLoader::Prefetch(void) {
+  const size_t bs = options_.batch_size;
+  const size_t sample_size = options_.height * options_.width * 3;
+  for (size_t b = 0; b < this->n_batch(); ++b) {
+    Slot* slot = nullptr;
+    {
+      // Wait for a free slot (backpressure)
+      std::unique_lock<std::mutex> lock(lock_);
+      cond_.wait(lock, [this, b](void) {
+        return stop_ || b - consumed_ < slots_.size();
+      });
+      if (stop_) {
+        return;
+      }
+      slot = &slots_[b % slots_.size()];
+    }
+    // Fill it, samples are independent
+    FACEKIT_TRACE_SCOPE("AugmentationLoader::Prefetch");
+    slot->batch.Resize(DataType::kUInt8,
+                       {bs, options_.height, options_.width, size_t(3)});
+    slot->index.assign(order_.begin() + b * bs,
+                       order_.begin() + (b + 1) * bs);
+    uint8_t* data = slot->batch.AsFlat<uint8_t>().data();
+    ThreadPool::Get().ParallelFor(0,
+                                  bs,
+                                  1,
+                                  [&](const size_t& first,
+                                      const size_t& last) {
+      for (size_t i = first; i < last; ++i) {
+        uint8_t* dst = data + i * sample_size;
+        if (this->Produce(slot->index[i], b * bs + i, dst) != 0) {
+          std::memset(dst, 0, sample_size);
+          n_error_.fetch_add(1);
+        }
+      }
+    });
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      slot->ready = true;
+    }
+    cond_.notify_all();
+  }
+}
+
+/*
+ *  @name   Produce
+ *  @fn     int Produce(const size_t& file, const size_t& position,
+                        uint8_t* dst) const
+ *  @brief  Draw one augmented sample of \p file into \p dst. Each cell
+ *          picks one of its outputs, geometric cells are composed and
+ *          resampled once.
+ *  @param[in] file     Index in `files_`
+ *  @param[in] position Position of the sample in the epoch
+ *  @param[out] dst     Sample buffer [height x width x 3]
+ *  @return -1 if error, 0 otherwise
+ */
+int AugmentationLoader::Produce(const size_t& file,
+                                const size_t& position,
+                                uint8_t* dst) const {
+  using Sample = AugmentationCell::Sample;
+  using Warp = AugmentationCell::Warp;
+  const cv::Matx23d eye(1.0, 0.0, 0.0, 0.0, 1.0, 0.0);
+  cv::Mat img = cv::imread(files_[file], cv::ImreadModes::IMREAD_COLOR);
+  if (img.empty()) {
+    FACEKIT_LOG_WARNING("Can not load " << files_[file]);
+    return -1;
+  }
+  // Sample's draws only depend on seed, epoch and position
+  AugmentationCell::Random& gen = AugmentationCell::Generator();
+  gen.Seed(Mix(Mix(options_.seed) ^ epoch_), position);
+  // Pending warp, not applied yet
+  cv::Matx23d warp = eye;
+  cv::Size size = img.size();
+  bool pending = false;
+  std::vector<Warp> warps;
+  std::vector<Sample> samples;
+  for (const auto& step : sequence_) {
+    const AugmentationCell* cell = step.first;
+    if (cell->is_geometric()) {
+      warps.clear();
+      if (cell->Geometry(size, &warps) != 0 || warps.empty()) {
+        return -1;
+      }
+      std::uniform_int_distribution<size_t> pick(0, warps.size() - 1);
+      const Warp& w = warps[pick(gen)];
+      warp = AugmentationCell::Compose(w.transform, warp);
+      size = w.size;
+      pending = true;
+    } else {
+      if (pending) {
+        cv::Mat tmp;
+        cv::warpAffine(img, tmp, warp, size, cv::INTER_LINEAR);
+        img = tmp;
+        warp = eye;
+        pending = false;
+      }
+      Sample src;
+      src.image = img;
+      samples.clear();
+      if (cell->Transform(src, &samples) != 0 || samples.empty()) {
+        return -1;
+      }
+      std::uniform_int_distribution<size_t> pick(0, samples.size() - 1);
+      img = samples[pick(gen)].image;
+      size = img.size();
+    }
+  }
+  // Write into the batch, scaled to the requested size (pixel centers
+  // aligned as in cv::resize)
+  const int w = static_cast<int>(options_.width);
+  const int h = static_cast<int>(options_.height);
+  cv::Mat out(h, w, CV_8UC3, dst);
+  if (size.width == w && size.height == h) {
+    if (pending) {
+      cv::warpAffine(img, out, warp, out.size(), cv::INTER_LINEAR);
+    } else {
+      img.copyTo(out);
+    }
+  } else {
+    const double sx = double(w) / double(size.width);
+    const double sy = double(h) / double(size.height);
+    const cv::Matx23d scale(sx, 0.0, 0.5 * sx - 0.5,
+                            0.0, sy, 0.5 * sy - 0.5);
+    cv::warpAffine(img,
+                   out,
+                   AugmentationCell::Compose(scale, warp),
+                   out.size(),
+                   cv::INTER_LINEAR);
+  }
+  return out.data == dst ? 0 : -1;
+}
+
+}  // namespace FaceKit
@@ -0,0 +1,251 @@
+/**
+ *  @file   augmentation_manifest.cpp
+ *  @brief  Record of the samples generated from each input, allows
+ *          incremental augmentation runs
+ *  @ingroup dataset
+ *
+ *  @author Christophe Ecabert
+ *  @date   09.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <unordered_set>
+
+#include "facekit/dataset/augmentation_manifest.hpp"
+#include "facekit/core/logger.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Header of the manifest file */
+static const std::string kHeader = "facekit-augmentation-manifest 1";
+/** FNV-1a offset basis */
+static constexpr uint64_t kFnvBasis = 0xCBF29CE484222325ULL;
+/** FNV-1a prime */
+static constexpr uint64_t kFnvPrime = 0x100000001B3ULL;
+
+constexpr const char* AugmentationManifest::kFilename;
+
+/**
+ *  @name   ToHex
+ *  @fn     static std::string ToHex(const uint64_t& value)
+ *  @brief  Fixed width hexadecimal representation
+ */
+static std::string ToHex(const uint64_t& value) {
+  char buffer[17];
+  std::snprintf(buffer,
+                sizeof(buffer),
+                "%016llx",
+                static_cast<unsigned long long>(value));
+  return std::string(buffer);
+}
+
+/**
+ *  @name   FromHex
+ *  @fn     static bool FromHex(const std::string& str, uint64_t* value)
+ *  @brief  Parse a value written by `ToHex`
+ */
+static bool FromHex(const std::string& str, uint64_t* value) {
+  try {
+    size_t n = 0;
+    *value = std::stoull(str, &n, 16);
+    return n == str.size();
+  } catch (...) {
+    return false;
+  }
+}
+
+/**
+ *  @name   Exists
+ *  @fn     static bool Exists(const std::string& path)
+ *  @brief  Check if a file can be opened
+ */
+static bool Exists(const std::string& path) {
+  std::ifstream stream(path.c_str());
+  return stream.is_open();
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   AugmentationManifest
+ *  @fn     explicit AugmentationManifest(const std::string& config)
+ *  @brief  Constructor
+ *  @param[in] config Configuration of the run (cells and seed)
+ */
+AugmentationManifest::AugmentationManifest(const std::string& config) :
+        config_(kFnvBasis) {
+  for (const char c : config) {
+    config_ ^= static_cast<uint8_t>(c);
+    config_ *= kFnvPrime;
+  }
+}
+
+/*
+ *  @name   Load
+ *  @fn     int Load(const std::string& path)
+ *  @brief  Load the entries stored in \p path. Entries recorded with
+ *          another configuration are dropped.
+ *  @param[in] path Manifest file
+ *  @return -1 if the file can not be read, 0 otherwise
+ */
+int AugmentationManifest::Load(const std::string& path) {
+  entries_.clear();
+  std::ifstream stream(path.c_str());
+  if (!stream.is_open()) {
+    return -1;
+  }
+  std::string line;
+  if (!std::getline(stream, line) || line != kHeader) {
+    FACEKIT_LOG_WARNING("Unknown manifest format: " << path);
+    return -1;
+  }
+  // Configuration
+  uint64_t config = 0;
+  if (!std::getline(stream, line) ||
+      line.compare(0, 7, "config ") != 0 ||
+      !FromHex(line.substr(7), &config)) {
+    FACEKIT_LOG_WARNING("Corrupted manifest: " << path);
+    return -1;
+  }
+  if (config != config_) {
+    FACEKIT_LOG_INFO("Configuration changed, previous outputs are stale");
+    return 0;
+  }
+  // Entries: `input <hash> <path>` followed by its `output <path>` lines
+  Entry* entry = nullptr;
+  while (std::getline(stream, line)) {
+    if (line.compare(0, 6, "input ") == 0 && line.size() > 23) {
+      uint64_t hash = 0;
+      if (!FromHex(line.substr(6, 16), &hash)) {
+        entry = nullptr;
+        continue;
+      }
+      entry = &entries_[line.substr(23)];
+      entry->hash = hash;
+      entry->outputs.clear();
+    } else if (line.compare(0, 7, "output ") == 0 && entry) {
+      entry->outputs.push_back(line.substr(7));
+    }
+  }
+  return 0;
+}
+
+/*
+ *  @name   Save
+ *  @fn     int Save(const std::string& path) const
+ *  @brief  Write the entries into \p path
+ *  @param[in] path Manifest file
+ *  @return -1 if error, 0 otherwise
+ */
+int AugmentationManifest::Save(const std::string& path) const {
+  std::ofstream stream(path.c_str());
+  if (!stream.is_open()) {
+    FACEKIT_LOG_ERROR("Can not write manifest: " << path);
+    return -1;
+  }
+  stream << kHeader << "\n";
+  stream << "config " << ToHex(config_) << "\n";
+  for (const auto& e : entries_) {
+    stream << "input " << ToHex(e.second.hash) << " " << e.first << "\n";
+    for (const auto& out : e.second.outputs) {
+      stream << "output " << out << "\n";
+    }
+  }
+  return stream.good() ? 0 : -1;
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   HashFile
+ *  @fn     static int HashFile(const std::string& path, uint64_t* hash)
+ *  @brief  Content hash (FNV-1a, 64 bits) of a file
+ *  @param[in] path   File to hash
+ *  @param[out] hash  Hash
+ *  @return -1 if the file can not be read, 0 otherwise
+ */
+int AugmentationManifest::HashFile(const std::string& path, uint64_t* hash) {
+  std::ifstream stream(path.c_str(), std::ios_base::binary);
+  if (!stream.is_open()) {
+    return -1;
+  }
+  uint64_t h = kFnvBasis;
+  std::vector<char> buffer(1 << 16);
+  while (stream) {
+    stream.read(buffer.data(), buffer.size());
+    const std::streamsize n = stream.gcount();
+    for (std::streamsize k = 0; k < n; ++k) {
+      h ^= static_cast<uint8_t>(buffer[k]);
+      h *= kFnvPrime;
+    }
+  }
+  *hash = h;
+  return stream.eof() ? 0 : -1;
+}
+
+/*
+ *  @name   IsUpToDate
+ *  @fn     bool IsUpToDate(const std::string& input,
+                            const uint64_t& hash) const
+ *  @brief  Check if the samples of \p input are already generated
+ *  @param[in] input  Input's path
+ *  @param[in] hash   Current content hash of the input
+ *  @return True if the input is unchanged and all its outputs exist
+ */
+bool AugmentationManifest::IsUpToDate(const std::string& input,
+                                      const uint64_t& hash) const {
+  const auto it = entries_.find(input);
+  if (it == entries_.end() || it->second.hash != hash) {
+    return false;
+  }
+  for (const auto& out : it->second.outputs) {
+    if (!Exists(out)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ *  @name   Update
+ *  @fn     void Update(const std::string& input, const uint64_t& hash,
+                        const std::vector<std::string>& outputs)
+ *  @brief  Record the samples generated from \p input
+ *  @param[in] input    Input's path
+ *  @param[in] hash     Content hash of the input
+ *  @param[in] outputs  Generated samples
+ */
+void AugmentationManifest::Update(const std::string& input,
+                                  const uint64_t& hash,
+                                  const std::vector<std::string>& outputs) {
+  Entry& entry = entries_[input];
+  entry.hash = hash;
+  entry.outputs = outputs;
+}
+
+/*
+ *  @name   Retain
+ *  @fn     void Retain(const std::vector<std::string>& inputs)
+ *  @brief  Drop the entries of the inputs not listed in \p inputs
+ *  @param[in] inputs Current inputs
+ */
+void AugmentationManifest::Retain(const std::vector<std::string>& inputs) {
+  const std::unordered_set<std::string> keep(inputs.begin(), inputs.end());
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (keep.count(it->first) == 0) {
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+}  // namespace FaceKit
@@ -0,0 +1,544 @@
+/**
+ *  @file   augmentation_sink.cpp
+ *  @brief  Destination of the samples generated by an augmentation run
+ *  @ingroup dataset
+ *
+ *  @author Christophe Ecabert
+ *  @date   12.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <utility>
+
+#include "opencv2/core.hpp"
+#include "opencv2/imgcodecs.hpp"
+
+#include "facekit/dataset/augmentation_sink.hpp"
+#include "facekit/dataset/augmentation_stats.hpp"
+#include "facekit/core/logger.hpp"
+#include "facekit/core/trace.hpp"
+#include "facekit/core/utils/string.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Size of a tar block */
+static constexpr size_t kTarBlock = 512;
+
+/**
+ *  @name   WriteU64
+ *  @fn     static void WriteU64(const uint64_t& value, std::ostream* stream)
+ *  @brief  Write \p value as little endian whatever the host
+ */
+static void WriteU64(const uint64_t& value, std::ostream* stream) {
+  char buffer[8];
+  for (size_t k = 0; k < 8; ++k) {
+    buffer[k] = static_cast<char>((value >> (8 * k)) & 0xFF);
+  }
+  stream->write(buffer, 8);
+}
+
+/**
+ *  @name   TarOctal
+ *  @fn     static void TarOctal(const uint64_t& value, const size_t& size,
+                                 char* field)
+ *  @brief  Fill a numeric field of a tar header, zero padded octal followed
+ *          by a NUL
+ */
+static void TarOctal(const uint64_t& value, const size_t& size, char* field) {
+  std::snprintf(field, size, "%0*llo", static_cast<int>(size - 1),
+                static_cast<unsigned long long>(value));
+}
+
+/**
+ *  @name   TarEntry
+ *  @fn     static uint64_t TarEntry(const std::string& name, const char* data,
+                                     const size_t& size, std::ostream* stream)
+ *  @brief  Append a regular file entry (ustar header, data padded to a
+ *          block)
+ *  @return Number of bytes written, 0 if the name does not fit
+ */
+static uint64_t TarEntry(const std::string& name,
+                         const char* data,
+                         const size_t& size,
+                         std::ostream* stream) {
+  if (name.size() >= 100) {
+    return 0;
+  }
+  char header[kTarBlock];
+  std::memset(header, 0, kTarBlock);
+  std::memcpy(&header[0], name.data(), name.size());
+  TarOctal(0644, 8, &header[100]);     // Mode
+  TarOctal(0, 8, &header[108]);        // Owner
+  TarOctal(0, 8, &header[116]);        // Group
+  TarOctal(size, 12, &header[124]);    // Size
+  TarOctal(0, 12, &header[136]);       // Modification time
+  header[156] = '0';                   // Regular file
+  std::memcpy(&header[257], "ustar", 6);
+  std::memcpy(&header[263], "00", 2);
+  // Checksum is computed with its own field filled with spaces
+  std::memset(&header[148], ' ', 8);
+  unsigned int sum = 0;
+  for (size_t k = 0; k < kTarBlock; ++k) {
+    sum += static_cast<unsigned char>(header[k]);
+  }
+  TarOctal(sum, 7, &header[148]);
+  header[155] = ' ';
+  stream->write(header, kTarBlock);
+  stream->write(data, size);
+  const size_t pad = (kTarBlock - size % kTarBlock) % kTarBlock;
+  const char zeros[kTarBlock] = {0};
+  stream->write(zeros, pad);
+  return kTarBlock + size + pad;
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   AugmentationSink
+ *  @fn     AugmentationSink(const size_t& n_thread, const size_t& capacity)
+ *  @brief  Constructor
+ *  @param[in] n_thread Number of I/O threads
+ *  @param[in] capacity Maximum number of samples waiting to be written
+ */
+AugmentationSink::AugmentationSink(const size_t& n_thread,
+                                   const size_t& capacity) :
+        n_thread_(std::max<size_t>(n_thread, 1)),
+        capacity_(std::max<size_t>(capacity, 1)),
+        stop_(false),
+        stats_(nullptr),
+        stage_(0),
+        n_output_(0),
+        n_error_(0) {
+}
+
+/*
+ *  @name   ~AugmentationSink
+ *  @fn     virtual ~AugmentationSink(void)
+ *  @brief  Destructor, the sink must be closed
+ */
+AugmentationSink::~AugmentationSink(void) {
+  if (!workers_.empty()) {
+    // Derived part is already gone, pending samples are dropped
+    FACEKIT_LOG_ERROR("AugmentationSink destroyed while open");
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      queue_.clear();
+      stop_ = true;
+    }
+    not_empty_.notify_all();
+    for (auto& w : workers_) {
+      w.join();
+    }
+  }
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Open
+ *  @fn     int Open(const std::string& dir, const size_t& n_input,
+                     AugmentationStats* stats, const size_t& stage)
+ *  @brief  Start a run, spawn the I/O threads
+ *  @param[in] dir      Output folder, with trailing separator
+ *  @param[in] n_input  Number of inputs of the run
+ *  @param[in] stats    Statistics, writes are accounted in \p stage
+ *  @param[in] stage    Stage index in \p stats
+ *  @return -1 if error, 0 otherwise
+ */
+int AugmentationSink::Open(const std::string& dir,
+                           const size_t& n_input,
+                           AugmentationStats* stats,
+                           const size_t& stage) {
+  if (!workers_.empty() || this->Prepare(dir) != 0) {
+    return -1;
+  }
+  outputs_.assign(n_input, std::vector<std::string>());
+  failed_.assign(n_input, 0);
+  n_output_.store(0);
+  n_error_.store(0);
+  stats_ = stats;
+  stage_ = stage;
+  stop_ = false;
+  for (size_t k = 0; k < n_thread_; ++k) {
+    workers_.emplace_back(&AugmentationSink::Loop, this);
+  }
+  return 0;
+}
+
+/*
+ *  @name   Push
+ *  @fn     void Push(const size_t& input, Sample&& sample,
+                      const std::string& ext, MemoryBudget::Token&& token)
+ *  @brief  Queue \p sample for writing along with the budget it holds,
+ *          blocks while the queue is full
+ *  @param[in] input  Index of the input it derives from
+ *  @param[in] sample Sample to write
+ *  @param[in] ext    Image extension, selects the encoder
+ *  @param[in] token  Reservation of the sample's memory
+ */
+void AugmentationSink::Push(const size_t& input,
+                            Sample&& sample,
+                            const std::string& ext,
+                            MemoryBudget::Token&& token) {
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    not_full_.wait(lock, [this](void) {
+      return queue_.size() < capacity_;
+    });
+    queue_.push_back(Item{std::move(sample), input, ext, Tracer::Now(),
+                          std::move(token)});
+  }
+  not_empty_.notify_one();
+}
+
+/*
+ *  @name   Close
+ *  @fn     int Close(void)
+ *  @brief  Write the pending samples, stop the I/O threads and finalize
+ *          the output
+ *  @return -1 if error, 0 otherwise
+ */
+int AugmentationSink::Close(void) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    stop_ = true;
+  }
+  not_empty_.notify_all();
+  for (auto& w : workers_) {
+    w.join();
+  }
+  workers_.clear();
+  return this->Finish();
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ *  @name   Loop
+ *  @fn     void Loop(void)
+ *  @brief  Body of the I/O threads, drain the queue till the sink is
+ *          closed
+ */
+void AugmentationSink::Loop(void) {
+  while (true) {
+    Item item;
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      not_empty_.wait(lock, [this](void) {
+        return stop_ || !queue_.empty();
+      });
+      if (queue_.empty()) {
+        return;
+      }
+      item = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    not_full_.notify_one();
+    const int64_t start = Tracer::Now();
+    std::string location;
+    uint64_t bytes = 0;
+    const int err = this->Write(item.sample, item.ext, &location, &bytes);
+    // Pixels are not needed anymore, unblock the producers
+    item.sample.image.release();
+    item.token.Release();
+    if (stats_) {
+      stats_->AddWait(stage_, start - item.queued);
+      if (err != 0) {
+        stats_->AddError(stage_);
+      } else {
+        stats_->AddWritten(stage_, bytes);
+      }
+      stats_->Add(stage_, 1, err == 0 ? 1 : 0, Tracer::Now() - start);
+    }
+    std::lock_guard<std::mutex> lock(lock_);
+    if (err != 0) {
+      n_error_.fetch_add(1);
+      failed_[item.input] = 1;
+    } else {
+      n_output_.fetch_add(1);
+      outputs_[item.input].push_back(std::move(location));
+    }
+  }
+}
+
+#pragma mark -
+#pragma mark Directory
+
+/*
+ *  @name   DirectorySink
+ *  @fn     explicit DirectorySink(const size_t& n_thread = 1,
+                                   const size_t& capacity = 64)
+ *  @brief  Constructor
+ *  @param[in] n_thread Number of I/O threads
+ *  @param[in] capacity Maximum number of samples waiting to be written
+ */
+DirectorySink::DirectorySink(const size_t& n_thread,
+                             const size_t& capacity) :
+        AugmentationSink(n_thread, capacity) {
+}
+
+/*
+ *  @name   Prepare
+ *  @fn     int Prepare(const std::string& dir) override
+ *  @brief  Get ready to write into \p dir
+ *  @return 0
+ */
+int DirectorySink::Prepare(const std::string& dir) {
+  dir_ = dir;
+  return 0;
+}
+
+/*
+ *  @name   Write
+ *  @fn     int Write(const Sample& sample, const std::string& ext,
+                      std::string* location, uint64_t* bytes) override
+ *  @brief  Write \p sample as `<dir><name>.<ext>`
+ *  @return -1 if error, 0 otherwise
+ */
+int DirectorySink::Write(const Sample& sample,
+                         const std::string& ext,
+                         std::string* location,
+                         uint64_t* bytes) {
+  *location = dir_ + sample.name + "." + ext;
+  if (!cv::imwrite(*location, sample.image) ||
+      AugmentationCell::SaveAnnotations(*location, sample) != 0) {
+    return -1;
+  }
+  *bytes = AugmentationStats::FileSize(*location);
+  return 0;
+}
+
+/*
+ *  @name   Finish
+ *  @fn     int Finish(void) override
+ *  @brief  Nothing to finalize
+ *  @return 0
+ */
+int DirectorySink::Finish(void) {
+  return 0;
+}
+
+#pragma mark -
+#pragma mark Shards
+
+/*
+ *  @name   ShardSink
+ *  @fn     ShardSink(const std::string& prefix, const uint64_t& shard_size,
+                      const size_t& n_thread, const size_t& capacity)
+ *  @brief  Constructor
+ *  @param[in] prefix     Shard name prefix
+ *  @param[in] shard_size Shard size threshold, bytes
+ *  @param[in] n_thread   Number of I/O threads
+ *  @param[in] capacity   Maximum number of samples waiting to be written
+ */
+ShardSink::ShardSink(const std::string& prefix,
+                     const uint64_t& shard_size,
+                     const size_t& n_thread,
+                     const size_t& capacity) :
+        AugmentationSink(n_thread, capacity),
+        prefix_(prefix),
+        shard_size_(shard_size),
+        index_(0),
+        size_(0) {
+}
+
+/*
+ *  @name   Prepare
+ *  @fn     int Prepare(const std::string& dir) override
+ *  @brief  Get ready to write shards into \p dir, the first one is created
+ *          with the first sample
+ *  @return 0
+ */
+int ShardSink::Prepare(const std::string& dir) {
+  dir_ = dir;
+  index_ = 0;
+  size_ = 0;
+  return 0;
+}
+
+/*
+ *  @name   Write
+ *  @fn     int Write(const Sample& sample, const std::string& ext,
+                      std::string* location, uint64_t* bytes) override
+ *  @brief  Encode \p sample and append it to the current shard
+ *  @return -1 if error, 0 otherwise
+ */
+int ShardSink::Write(const Sample& sample,
+                     const std::string& ext,
+                     std::string* location,
+                     uint64_t* bytes) {
+  // Encoding is the expensive part, done without holding the shard
+  std::vector<uint8_t> image;
+  if (!cv::imencode("." + ext, sample.image, image)) {
+    return -1;
+  }
+  std::string annotation;
+  if (!sample.landmarks.empty()) {
+    std::ostringstream str;
+    if (AugmentationCell::WriteAnnotations(sample, &str) != 0) {
+      return -1;
+    }
+    annotation = str.str();
+  }
+  std::lock_guard<std::mutex> lock(shard_lock_);
+  if ((!stream_.is_open() || size_ >= shard_size_) && this->Roll() != 0) {
+    return -1;
+  }
+  const uint64_t n = this->Append(sample.name, ext, image, annotation,
+                                  &stream_);
+  if (n == 0 || !stream_.good()) {
+    return -1;
+  }
+  size_ += n;
+  *location = path_;
+  *bytes = n;
+  return 0;
+}
+
+/*
+ *  @name   Finish
+ *  @fn     int Finish(void) override
+ *  @brief  Close the current shard
+ *  @return -1 if error, 0 otherwise
+ */
+int ShardSink::Finish(void) {
+  if (!stream_.is_open()) {
+    return 0;
+  }
+  this->Trailer(&stream_);
+  const bool good = stream_.good();
+  stream_.close();
+  return good ? 0 : -1;
+}
+
+/*
+ *  @name   Roll
+ *  @fn     int Roll(void)
+ *  @brief  Close the current shard if any and open the next one
+ *  @return -1 if error, 0 otherwise
+ */
+int ShardSink::Roll(void) {
+  if (this->Finish() != 0) {
+    return -1;
+  }
+  path_ = dir_ + prefix_ + "-" + String::LeadingZero(index_++, 5) + "." +
+          this->extension();
+  stream_.clear();
+  stream_.open(path_.c_str(), std::ios_base::out |
+                              std::ios_base::binary |
+                              std::ios_base::trunc);
+  size_ = 0;
+  if (!stream_.is_open()) {
+    FACEKIT_LOG_ERROR("Can not open shard " << path_);
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ *  @name   RecordShardSink
+ *  @fn     explicit RecordShardSink(const std::string& prefix = "samples",
+                             const uint64_t& shard_size = 1ULL << 30,
+                             const size_t& n_thread = 1,
+                             const size_t& capacity = 64)
+ *  @brief  Constructor
+ */
+RecordShardSink::RecordShardSink(const std::string& prefix,
+                                 const uint64_t& shard_size,
+                                 const size_t& n_thread,
+                                 const size_t& capacity) :
+        ShardSink(prefix, shard_size, n_thread, capacity) {
+}
+
+/*
+ *  @name   Append
+ *  @fn     uint64_t Append(const std::string& name, const std::string& ext,
+                            const std::vector<uint8_t>& image,
+                            const std::string& annotation,
+                            std::ostream* stream) override
+ *  @brief  Append a record: name, image, annotation, each prefixed by its
+ *          size. The extension is kept in the name.
+ *  @return Number of bytes written
+ */
+uint64_t RecordShardSink::Append(const std::string& name,
+                                 const std::string& ext,
+                                 const std::vector<uint8_t>& image,
+                                 const std::string& annotation,
+                                 std::ostream* stream) {
+  const std::string key = name + "." + ext;
+  WriteU64(key.size(), stream);
+  stream->write(key.data(), key.size());
+  WriteU64(image.size(), stream);
+  stream->write(reinterpret_cast<const char*>(image.data()), image.size());
+  WriteU64(annotation.size(), stream);
+  stream->write(annotation.data(), annotation.size());
+  return 24 + key.size() + image.size() + annotation.size();
+}
+
+/*
+ *  @name   TarShardSink
+ *  @fn     explicit TarShardSink(const std::string& prefix = "samples",
+                                  const uint64_t& shard_size = 1ULL << 30,
+                                  const size_t& n_thread = 1,
+                                  const size_t& capacity = 64)
+ *  @brief  Constructor
+ */
+TarShardSink::TarShardSink(const std::string& prefix,
+                           const uint64_t& shard_size,
+                           const size_t& n_thread,
+                           const size_t& capacity) :
+        ShardSink(prefix, shard_size, n_thread, capacity) {
+}
+
+/*
+ *  @name   Append
+ *  @fn     uint64_t Append(const std::string& name, const std::string& ext,
+                            const std::vector<uint8_t>& image,
+                            const std::string& annotation,
+                            std::ostream* stream) override
+ *  @brief  Append `<name>.<ext>` then `<name>.pts` if there are landmarks
+ *  @return Number of bytes written, 0 if the name is too long
+ */
+uint64_t TarShardSink::Append(const std::string& name,
+                              const std::string& ext,
+                              const std::vector<uint8_t>& image,
+                              const std::string& annotation,
+                              std::ostream* stream) {
+  // Check both names before writing anything
+  if (name.size() + std::max<size_t>(ext.size(), 3) + 1 >= 100) {
+    FACEKIT_LOG_ERROR("Sample name too long for a tar entry: " << name);
+    return 0;
+  }
+  uint64_t n = TarEntry(name + "." + ext,
+                        reinterpret_cast<const char*>(image.data()),
+                        image.size(),
+                        stream);
+  if (!annotation.empty()) {
+    n += TarEntry(name + ".pts", annotation.data(), annotation.size(),
+                  stream);
+  }
+  return n;
+}
+
+/*
+ *  @name   Trailer
+ *  @fn     void Trailer(std::ostream* stream) override
+ *  @brief  Write the end-of-archive marker, two zero blocks
+ */
+void TarShardSink::Trailer(std::ostream* stream) {
+  const char zeros[2 * kTarBlock] = {0};
+  stream->write(zeros, 2 * kTarBlock);
+}
+
+}  // namespace FaceKit
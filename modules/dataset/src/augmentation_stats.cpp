@@ -0,0 +1,223 @@
+/**
+ *  @file   augmentation_stats.cpp
+ *  @brief  Throughput and timing of each stage of an augmentation run
+ *  @ingroup dataset
+ *
+ *  @author Christophe Ecabert
+ *  @date   11.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "facekit/dataset/augmentation_stats.hpp"
+#include "facekit/core/logger.hpp"
+#include "facekit/core/trace.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @name   Describe
+ *  @fn     static std::string Describe(const AugmentationStats::Snapshot& s,
+                                        const int64_t& elapsed)
+ *  @brief  One line summary of a stage: throughput, cost per image, queue
+ *          wait per image and disk traffic
+ */
+static std::string Describe(const AugmentationStats::Snapshot& s,
+                            const int64_t& elapsed) {
+  const double n = s.n_input > 0 ? double(s.n_input) : 1.0;
+  const double sec = elapsed > 0 ? double(elapsed) * 1e-9 : 1.0;
+  std::ostringstream str;
+  str << std::fixed << std::setprecision(1);
+  str << s.name << ": " << s.n_input << " in, " << s.n_output << " out";
+  if (s.n_error) {
+    str << ", " << s.n_error << " error(s)";
+  }
+  str << ", " << double(s.n_input) / sec << " img/s";
+  str << ", " << double(s.busy) * 1e-6 / n << " ms/img";
+  if (s.wait) {
+    str << ", wait " << double(s.wait) * 1e-6 / n << " ms/img";
+  }
+  if (s.bytes_read) {
+    str << ", read " << double(s.bytes_read) / double(1 << 20) << " MB";
+  }
+  if (s.bytes_written) {
+    str << ", written " << double(s.bytes_written) / double(1 << 20) << " MB";
+  }
+  return str.str();
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   AugmentationStats
+ *  @fn     AugmentationStats(const std::vector<std::string>& stages,
+                              const double& interval)
+ *  @brief  Constructor, starts the clock
+ *  @param[in] stages   Name of each stage
+ *  @param[in] interval Time between two progress reports in second, 0
+ *                      disables them
+ */
+AugmentationStats::AugmentationStats(const std::vector<std::string>& stages,
+                                     const double& interval) :
+        names_(stages),
+        counters_(new Counters[stages.size()]),
+        start_(Tracer::Now()),
+        interval_(interval > 0.0 ? static_cast<int64_t>(interval * 1e9) : 0),
+        next_report_(start_ + interval_) {
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Add
+ *  @fn     void Add(const size_t& stage, const size_t& n_input,
+                     const size_t& n_output, const int64_t& busy)
+ *  @brief  Account work done by \p stage and report progress if due
+ *  @param[in] stage    Stage index
+ *  @param[in] n_input  Number of samples consumed
+ *  @param[in] n_output Number of samples produced
+ *  @param[in] busy     Processing time, ns
+ */
+void AugmentationStats::Add(const size_t& stage,
+                            const size_t& n_input,
+                            const size_t& n_output,
+                            const int64_t& busy) {
+  Counters& c = counters_[stage];
+  c.n_input.fetch_add(n_input, std::memory_order_relaxed);
+  c.n_output.fetch_add(n_output, std::memory_order_relaxed);
+  c.busy.fetch_add(busy, std::memory_order_relaxed);
+  this->Tick();
+}
+
+/*
+ *  @name   AddError
+ *  @fn     void AddError(const size_t& stage)
+ *  @brief  Account a failure in \p stage
+ */
+void AugmentationStats::AddError(const size_t& stage) {
+  counters_[stage].n_error.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*
+ *  @name   AddWait
+ *  @fn     void AddWait(const size_t& stage, const int64_t& wait)
+ *  @brief  Account time spent by a sample in the queue of \p stage, ns
+ */
+void AugmentationStats::AddWait(const size_t& stage, const int64_t& wait) {
+  counters_[stage].wait.fetch_add(wait, std::memory_order_relaxed);
+}
+
+/*
+ *  @name   AddRead
+ *  @fn     void AddRead(const size_t& stage, const uint64_t& bytes)
+ *  @brief  Account bytes read from disk by \p stage
+ */
+void AugmentationStats::AddRead(const size_t& stage, const uint64_t& bytes) {
+  counters_[stage].bytes_read.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+/*
+ *  @name   AddWritten
+ *  @fn     void AddWritten(const size_t& stage, const uint64_t& bytes)
+ *  @brief  Account bytes written on disk by \p stage
+ */
+void AugmentationStats::AddWritten(const size_t& stage,
+                                   const uint64_t& bytes) {
+  counters_[stage].bytes_written.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+/*
+ *  @name   Report
+ *  @fn     void Report(void) const
+ *  @brief  Log a summary line for every stage
+ */
+void AugmentationStats::Report(void) const {
+  const int64_t elapsed = this->get_elapsed();
+  FACEKIT_LOG_INFO("Augmentation stats after " << std::fixed
+                   << std::setprecision(1) << double(elapsed) * 1e-9 << "s");
+  for (size_t k = 0; k < names_.size(); ++k) {
+    FACEKIT_LOG_INFO("  " << Describe(this->get_stage(k), elapsed));
+  }
+}
+
+/*
+ *  @name   FileSize
+ *  @fn     static uint64_t FileSize(const std::string& path)
+ *  @brief  Size of a file on disk
+ *  @param[in] path File
+ *  @return Size in bytes, 0 if the file can not be opened
+ */
+uint64_t AugmentationStats::FileSize(const std::string& path) {
+  std::ifstream stream(path.c_str(), std::ios_base::binary |
+                                     std::ios_base::ate);
+  if (!stream.is_open()) {
+    return 0;
+  }
+  const std::streamoff size = stream.tellg();
+  return size > 0 ? static_cast<uint64_t>(size) : 0;
+}
+
+#pragma mark -
+#pragma mark Accessors
+
+/*
+ *  @name   get_stage
+ *  @fn     Snapshot get_stage(const size_t& stage) const
+ *  @brief  Current counters of \p stage
+ */
+AugmentationStats::Snapshot
+AugmentationStats::get_stage(const size_t& stage) const {
+  const Counters& c = counters_[stage];
+  Snapshot s;
+  s.name = names_[stage];
+  s.n_input = c.n_input.load(std::memory_order_relaxed);
+  s.n_output = c.n_output.load(std::memory_order_relaxed);
+  s.n_error = c.n_error.load(std::memory_order_relaxed);
+  s.busy = c.busy.load(std::memory_order_relaxed);
+  s.wait = c.wait.load(std::memory_order_relaxed);
+  s.bytes_read = c.bytes_read.load(std::memory_order_relaxed);
+  s.bytes_written = c.bytes_written.load(std::memory_order_relaxed);
+  return s;
+}
+
+/*
+ *  @name   get_elapsed
+ *  @fn     int64_t get_elapsed(void) const
+ *  @brief  Time since construction, ns
+ */
+int64_t AugmentationStats::get_elapsed(void) const {
+  return Tracer::Now() - start_;
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ *  @name   Tick
+ *  @fn     void Tick(void)
+ *  @brief  Report progress if the interval elapsed, a single thread wins
+ */
+void AugmentationStats::Tick(void) {
+  if (interval_ == 0) {
+    return;
+  }
+  const int64_t now = Tracer::Now();
+  int64_t due = next_report_.load(std::memory_order_relaxed);
+  if (now < due) {
+    return;
+  }
+  if (next_report_.compare_exchange_strong(due, now + interval_)) {
+    this->Report();
+  }
+}
+
+}  // namespace FaceKit
@@ -8,8 +8,10 @@
  *  Copyright © 2017 Christophe Ecabert. All rights reserved.
  */
 
-#include <chrono>
+#include <cmath>
 #include <random>
+#include <string>
+#include <utility>
 
 #include "opencv2/core.hpp"
 #include "opencv2/imgcodecs.hpp"
@@ -17,6 +19,7 @@
 
 #include "facekit/dataset/color_space_cell.hpp"
 #include "facekit/core/utils/string.hpp"
+#include "facekit/core/task_group.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -30,11 +33,23 @@ namespace FaceKit {
 /*
  *  @name   HSVScalingCell
  *  @fn     HSVScalingCell(const double range, const size_t n_sample);
- *  @brief  Constructor
+ *  @brief  Constructor, scale the value only
  *  @param[in] range  Scaling factor's range defined as 1 +/- range
- *  @param[in] n_sample  Patch height
+ *  @param[in] n_sample  Number of sample to generate for each image
  */
 HSVScalingCell::HSVScalingCell(const double range,
+                               const size_t n_sample) : n_sample_(n_sample) {
+  range_.brightness = range;
+}
+  
+/*
+ *  @name   HSVScalingCell
+ *  @fn     HSVScalingCell(const Range& range, const size_t n_sample)
+ *  @brief  Constructor
+ *  @param[in] range  Jitter ranges
+ *  @param[in] n_sample  Number of sample to generate for each image
+ */
+HSVScalingCell::HSVScalingCell(const Range& range,
                                const size_t n_sample) : range_(range),
                                                         n_sample_(n_sample) {
 }
@@ -56,44 +71,184 @@ HSVScalingCell::HSVScalingCell(const double range,
 int HSVScalingCell::Process(const std::vector<std::string>& input,
                             const std::string& output,
                             std::vector<std::string>* generated) const {
-  int err = 0;
+  // Images are independent, process them concurrently. Each task fills its
+  // own slot to keep output order deterministic
+  std::vector<std::vector<std::string>> gen(input.size());
+  std::vector<int> errs(input.size(), 0);
+  TaskGroup group;
   for (size_t i = 0; i < input.size(); ++i) {
-    // Get filename
-    std::string dir, file, ext;
-    Path::SplitComponent(input[i], &dir, &file, &ext);
-    // Load image + convert to hsv
-    cv::Mat img = cv::imread(input[i], cv::ImreadModes::IMREAD_COLOR);
-    cv::Mat imgf, hsv_imgf;
-    img.convertTo(imgf, CV_64F);
-    cv::cvtColor(imgf, hsv_imgf, cv::COLOR_BGR2HSV);
-    
-    if (!imgf.empty()) {
-      // Create distribution
-      std::uniform_real_distribution<float> s_dist(-range_, range_);
-      // Create generator
-      auto seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-      std::mt19937 gen(static_cast<std::mt19937::result_type>(seed));
-      // Generate new samples
-      for (size_t i = 0; i < n_sample_; ++i) {
-        // Pick random scale
-        double scale =  1.0 + s_dist(gen);
-        
-        // Apply scaling
-        cv::Mat hsv_scaled, sample;
-        
-        
-        
-        cv::cvtColor(hsv_scaled, sample, cv::COLOR_HSV2BGR);
+    group.Run([this, i, &input, &output, &gen, &errs](void) {
+      // Get filename
+      StringView file, ext;
+      Path::SplitComponent(input[i], nullptr, &file, &ext);
+      // Load image
+      cv::Mat img = cv::imread(input[i], cv::ImreadModes::IMREAD_COLOR);
+      std::vector<Sample> samples;
+      const std::string name(file.data(), file.size());
+      Sample src;
+      src.image = img;
+      src.name = name;
+      AugmentationCell::Reseed(name);
+      if (AugmentationCell::LoadAnnotations(input[i], &src) == 0 &&
+          this->Transform(src, &samples) == 0) {
         // Save
-        std::string dest = output.back() == '/' ? output : output + "/";
-        dest += file + "_hsv" + String::LeadingZero(i, 3) +"." + ext;
-        cv::imwrite(dest, sample);
-        generated->push_back(dest);
+        for (const auto& sample : samples) {
+          std::string dest = output.back() == '/' ? output : output + "/";
+          dest.append(sample.name).append(".");
+          dest.append(ext.data(), ext.size());
+          cv::imwrite(dest, sample.image);
+          AugmentationCell::SaveAnnotations(dest, sample);
+          gen[i].push_back(dest);
+        }
+      } else {
+        errs[i] = -1;
       }
-    } else {
-      err |= -1;
-    }
+    });
+  }
+  group.Wait();
+  // Gather
+  int err = 0;
+  for (size_t i = 0; i < input.size(); ++i) {
+    generated->insert(generated->end(), gen[i].begin(), gen[i].end());
+    err |= errs[i];
   }
   return err;
 }
+  
+/*
+ *  @name   Transform
+ *  @fn     int Transform(const Sample& input,
+                          std::vector<Sample>* generated) const
+ *  @brief  Jitter the colors of an image already in memory
+ *  @param[in]  input     Sample to augment
+ *  @param[out] generated Generated samples are appended to it
+ *  @return -1 if error, 0 otherwise
+ */
+int HSVScalingCell::Transform(const Sample& input,
+                              std::vector<Sample>* generated) const {
+  if (input.image.empty()) {
+    return -1;
+  }
+  // Create distribution
+  using Dist = std::uniform_real_distribution<double>;
+  Dist b_dist(-range_.brightness, range_.brightness);
+  Dist c_dist(-range_.contrast, range_.contrast);
+  Dist s_dist(-range_.saturation, range_.saturation);
+  Dist h_dist(-range_.hue, range_.hue);
+  // Generator of the calling thread
+  Random& gen = AugmentationCell::Generator();
+  // Generate new samples
+  for (size_t i = 0; i < n_sample_; ++i) {
+    // Pick random adjustment
+    Jitter jitter;
+    jitter.brightness = 1.0 + b_dist(gen);
+    jitter.contrast = 1.0 + c_dist(gen);
+    jitter.saturation = 1.0 + s_dist(gen);
+    jitter.hue = h_dist(gen);
+    Sample sample;
+    if (Apply(jitter, input.image, &sample.image) != 0) {
+      return -1;
+    }
+    sample.name = input.name + "_hsv" + String::LeadingZero(i, 3);
+    // Photometric only, annotations are unchanged
+    sample.landmarks = input.landmarks;
+    sample.bboxes = input.bboxes;
+    generated->push_back(std::move(sample));
+  }
+  return 0;
+}
+  
+/*
+ *  @name   Apply
+ *  @fn     static int Apply(const Jitter& jitter, const cv::Mat& src,
+                             cv::Mat* dst)
+ *  @brief  Apply a color adjustment on an 8-bit BGR or gray image, can run
+ *          in place
+ *  @param[in]  jitter  Adjustment
+ *  @param[in]  src     Image to adjust
+ *  @param[out] dst     Adjusted image
+ *  @return -1 if the image is empty or not 8-bit, 0 otherwise
+ */
+int HSVScalingCell::Apply(const Jitter& jitter,
+                          const cv::Mat& src,
+                          cv::Mat* dst) {
+  const int cn = src.channels();
+  if (src.empty() || src.depth() != CV_8U || (cn != 1 && cn != 3)) {
+    return -1;
+  }
+  const double b = jitter.brightness;
+  const double c = jitter.contrast;
+  // Mean luma after brightness, contrast pivot
+  double mean = 0.0;
+  if (c != 1.0) {
+    const cv::Scalar m = cv::mean(src);
+    mean = cn == 1 ? m[0] : 0.114 * m[0] + 0.587 * m[1] + 0.299 * m[2];
+    mean *= b;
+  }
+  const double offset = (1.0 - c) * mean;
+  if (cn == 1) {
+    // Single LUT-like pass, saturated
+    src.convertTo(*dst, CV_8U, b * c, offset);
+    return 0;
+  }
+  // Saturation: s * I + (1 - s) * luma, BGR order
+  const double w[3] = {0.114, 0.587, 0.299};
+  const double s = jitter.saturation;
+  double sat[3][3];
+  for (int r = 0; r < 3; ++r) {
+    for (int k = 0; k < 3; ++k) {
+      sat[r][k] = (1.0 - s) * w[k] + (r == k ? s : 0.0);
+    }
+  }
+  // Hue: rotation around the gray axis (YIQ), rows/columns in BGR order
+  const double rad = jitter.hue * CV_PI / 180.0;
+  const double ch = std::cos(rad);
+  const double sh = std::sin(rad);
+  const double hue[3][3] = {
+    {0.114 + 0.886 * ch - 0.203 * sh,
+     0.587 - 0.588 * ch - 1.050 * sh,
+     0.299 - 0.300 * ch + 1.250 * sh},
+    {0.114 - 0.114 * ch + 0.292 * sh,
+     0.587 + 0.413 * ch + 0.035 * sh,
+     0.299 - 0.299 * ch - 0.328 * sh},
+    {0.114 - 0.114 * ch - 0.497 * sh,
+     0.587 - 0.587 * ch + 0.330 * sh,
+     0.299 + 0.701 * ch + 0.168 * sh}};
+  // Fold everything into out = b * c * sat * hue * x + offset
+  cv::Matx34f m;
+  for (int r = 0; r < 3; ++r) {
+    for (int k = 0; k < 3; ++k) {
+      double v = 0.0;
+      for (int j = 0; j < 3; ++j) {
+        v += sat[r][j] * hue[j][k];
+      }
+      m(r, k) = static_cast<float>(b * c * v);
+    }
+    m(r, 3) = static_cast<float>(offset);
+  }
+  // Single pass over the pixels, OpenCV runs 8-bit color matrices with SIMD
+  // fixed-point arithmetic and saturates the output. The matrix is built in
+  // single precision, OpenCV would otherwise convert it on every call.
+  cv::transform(src, *dst, m);
+  return 0;
+}
+
+  
+#pragma mark -
+#pragma mark Accessors
+  
+/*
+ *  @name   config
+ *  @fn     std::string config(void) const
+ *  @brief  Describe the operation and its parameters
+ */
+std::string HSVScalingCell::config(void) const {
+  return std::string(this->name()) + "(" +
+         std::to_string(range_.brightness) + "," +
+         std::to_string(range_.contrast) + "," +
+         std::to_string(range_.saturation) + "," +
+         std::to_string(range_.hue) + "," +
+         std::to_string(n_sample_) + ")";
+}
+  
 }  // namespace FaceKit
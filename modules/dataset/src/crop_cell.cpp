@@ -8,11 +8,22 @@
  *  Copyright © 2017 Christophe Ecabert. All rights reserved.
  */
 
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
 #include "opencv2/core.hpp"
 #include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
 
 #include "facekit/dataset/crop_cell.hpp"
 #include "facekit/core/utils/string.hpp"
+#include "facekit/core/task_group.hpp"
+#include "facekit/io/image_factory.hpp"
+#include "facekit/io/jpeg_image.hpp"
+#include "facekit/io/png_image.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -20,6 +31,140 @@
  */
 namespace FaceKit {
   
+/**
+ *  @name   CropOrigin
+ *  @fn     static cv::Point CropOrigin(const int& i, const cv::Size& size,
+                                        const int& width, const int& height)
+ *  @brief  Top left corner of the \p i-th patch: top left, top right,
+ *          bottom left, bottom right then center
+ */
+static cv::Point CropOrigin(const int& i,
+                            const cv::Size& size,
+                            const int& width,
+                            const int& height) {
+  switch (i) {
+    // Top left
+    case 0: return cv::Point(0, 0);
+    // Top right
+    case 1: return cv::Point(size.width - width - 1, 0);
+    // Bottom left
+    case 2: return cv::Point(0, size.height - height - 1);
+    // Bottom Right
+    case 3: return cv::Point(size.width - width - 1, size.height - height - 1);
+    // Center
+    default: return cv::Point((size.width - width) / 2,
+                              (size.height - height) / 2);
+  }
+}
+  
+/**
+ *  @name   RegionCodec
+ *  @fn     static Image* RegionCodec(const std::string& path)
+ *  @brief  Provide the calling thread's codec for \p path if its format
+ *          supports decoding a region (JPEG, PNG). Instances are reused by the
+ *          thread and never shared.
+ *  @param[in] path Image's path
+ *  @return Codec or nullptr if the format must go through OpenCV
+ */
+static Image* RegionCodec(const std::string& path) {
+  static thread_local std::unordered_map<std::string,
+                                         std::unique_ptr<Image>> codecs;
+  std::string ext = Path::Extension(path);
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  if (ext == "jpeg") {
+    ext = "jpg";
+  }
+  if (ext != "jpg" && ext != "png") {
+    return nullptr;
+  }
+  auto it = codecs.find(ext);
+  if (it == codecs.end()) {
+    Image* codec = ImageFactory::Get().CreateByExtension(ext);
+    it = codecs.emplace(ext, std::unique_ptr<Image>(codec)).first;
+  }
+  return it->second.get();
+}
+
+/**
+ *  @name   LoadRegion
+ *  @fn     static int LoadRegion(Image* codec, const std::string& path,
+                                  const cv::Rect& roi, cv::Mat* image)
+ *  @brief  Decode only \p roi of an image into a BGR matrix
+ *  @param[in]  codec JPEG or PNG codec
+ *  @param[in]  path  Image's path
+ *  @param[in]  roi   Region to decode
+ *  @param[out] image Decoded region, BGR
+ *  @return -1 if error, 0 otherwise
+ */
+static int LoadRegion(Image* codec,
+                      const std::string& path,
+                      const cv::Rect& roi,
+                      cv::Mat* image) {
+  const Image::Region region(roi.x, roi.y, roi.width, roi.height);
+  if (auto* jpg = dynamic_cast<JPEGImage*>(codec)) {
+    jpg->set_region(region);
+  } else if (auto* png = dynamic_cast<PNGImage*>(codec)) {
+    png->set_region(region);
+  } else {
+    return -1;
+  }
+  static thread_local NDArray pixels;
+  if (!codec->LoadInto(path, &pixels).Good()) {
+    return -1;
+  }
+  const int type = CV_8UC(static_cast<int>(codec->format()));
+  const cv::Mat rgb(static_cast<int>(codec->height()),
+                    static_cast<int>(codec->width()),
+                    type,
+                    pixels.AsFlat<uint8_t>().data());
+  switch (codec->format()) {
+    case Image::Format::kGrayscale:
+      cv::cvtColor(rgb, *image, cv::COLOR_GRAY2BGR);
+      break;
+    case Image::Format::kRGB:
+      cv::cvtColor(rgb, *image, cv::COLOR_RGB2BGR);
+      break;
+    case Image::Format::kRGBA:
+      cv::cvtColor(rgb, *image, cv::COLOR_RGBA2BGR);
+      break;
+    default:
+      return -1;
+  }
+  return 0;
+}
+
+/**
+ *  @name   ExtractPatches
+ *  @fn     static void ExtractPatches(const Sample& input,
+                                       const cv::Point& origin,
+                                       const std::vector<Warp>& warps,
+                                       std::vector<Sample>* generated)
+ *  @brief  Copy the patches described by \p warps out of \p input
+ *  @param[in]  input     Sample, its image may be a region of the original
+ *                        one starting at \p origin. Annotations are in the
+ *                        original image's frame.
+ *  @param[in]  origin    Position of \p input's image in the original one
+ *  @param[in]  warps     Translations of the patches, original image's frame
+ *  @param[out] generated Generated samples are appended to it
+ */
+static void ExtractPatches(const AugmentationCell::Sample& input,
+                           const cv::Point& origin,
+                           const std::vector<AugmentationCell::Warp>& warps,
+                           std::vector<AugmentationCell::Sample>* generated) {
+  for (const auto& w : warps) {
+    // Extract region, copied so the source can be released
+    const int x = -static_cast<int>(w.transform(0, 2)) - origin.x;
+    const int y = -static_cast<int>(w.transform(1, 2)) - origin.y;
+    AugmentationCell::Sample sample;
+    sample.image = input.image(cv::Rect(x, y,
+                                        w.size.width,
+                                        w.size.height)).clone();
+    sample.name = input.name + w.name;
+    AugmentationCell::MapAnnotations(w.transform, input, &sample);
+    generated->push_back(std::move(sample));
+  }
+}
+
 /*
  *  @name   ImageCropCell
  *  @fn     ImageCropCell(const int width, const int height)
@@ -46,59 +191,130 @@ ImageCropCell::ImageCropCell(const int width,
 int ImageCropCell::Process(const std::vector<std::string>& input,
                            const std::string& output,
                            std::vector<std::string>* generated) const {
-  int err = 0;
+  // Images are independent, process them concurrently. Each task fills its
+  // own slot to keep output order deterministic
+  std::vector<std::vector<std::string>> gen(input.size());
+  std::vector<int> errs(input.size(), 0);
+  TaskGroup group;
   for (size_t i = 0; i < input.size(); ++i) {
-    // Get filename
-    std::string dir, file, ext;
-    Path::SplitComponent(input[i], &dir, &file, &ext);
-    // Load image
-    cv::Mat img = cv::imread(input[i], cv::ImreadModes::IMREAD_COLOR);
-    if (!img.empty() && img.cols > width_ && img.rows > height_) {
-      cv::Rect roi;
-      roi.width = width_;
-      roi.height = height_;
-      for (int i = 0; i < 5; ++i) {
-        // Compute ROI
-        switch (i) {
-          // Top left
-          case 0: roi.x = 0;
-                  roi.y = 0;
-            break;
-            
-          // Top right
-          case 1: roi.x = img.cols - width_ - 1;
-                  roi.y = 0;
-            break;
-            
-          // Bottom left
-          case 2: roi.x = 0;
-                  roi.y = img.rows - height_ - 1;
-            break;
-          // Bottom Right
-          case 3: roi.x = img.cols - width_ - 1;
-                  roi.y = img.rows - height_ - 1;
-            break;
-          // Center
-          case 4: roi.x = (img.cols - width_) / 2;
-                  roi.y = (img.rows - height_) / 2;
-            break;
+    group.Run([this, i, &input, &output, &gen, &errs](void) {
+      // Get filename
+      StringView file, ext;
+      Path::SplitComponent(input[i], nullptr, &file, &ext);
+      Sample src;
+      src.name.assign(file.data(), file.size());
+      std::vector<Sample> samples;
+      int e = AugmentationCell::LoadAnnotations(input[i], &src);
+      // JPEG/PNG: decode only the bounding box of the patches, otherwise
+      // load the whole image
+      Image* codec = RegionCodec(input[i]);
+      Image::ImageInfo info;
+      if (e == 0 && codec && codec->ReadHeader(input[i], &info).Good()) {
+        std::vector<Warp> warps;
+        const cv::Size size(static_cast<int>(info.width),
+                            static_cast<int>(info.height));
+        e = this->Geometry(size, &warps);
+        if (e == 0) {
+          cv::Rect roi;
+          for (const auto& w : warps) {
+            const cv::Rect patch(-static_cast<int>(w.transform(0, 2)),
+                                 -static_cast<int>(w.transform(1, 2)),
+                                 w.size.width,
+                                 w.size.height);
+            roi = roi.area() > 0 ? (roi | patch) : patch;
+          }
+          e = LoadRegion(codec, input[i], roi, &src.image);
+          if (e == 0) {
+            ExtractPatches(src, roi.tl(), warps, &samples);
+          }
         }
-        // Extract region
-        cv::Mat sample = img(roi).clone();
+      } else if (e == 0) {
+        src.image = cv::imread(input[i], cv::ImreadModes::IMREAD_COLOR);
+        e = this->Transform(src, &samples);
+      }
+      if (e == 0) {
         // Save
-        std::string dest = output.back() == '/' ? output : output + "/";
-        dest += file + "_crop" + String::LeadingZero(i, 3) +"." + ext;
-        cv::imwrite(dest, sample);
-        generated->push_back(dest);
+        for (const auto& sample : samples) {
+          std::string dest = output.back() == '/' ? output : output + "/";
+          dest.append(sample.name).append(".");
+          dest.append(ext.data(), ext.size());
+          cv::imwrite(dest, sample.image);
+          AugmentationCell::SaveAnnotations(dest, sample);
+          gen[i].push_back(dest);
+        }
+      } else {
+        errs[i] = -1;
       }
-    } else {
-      err |= -1;
-    }
+    });
+  }
+  group.Wait();
+  // Gather
+  int err = 0;
+  for (size_t i = 0; i < input.size(); ++i) {
+    generated->insert(generated->end(), gen[i].begin(), gen[i].end());
+    err |= errs[i];
   }
-  
   return err;
 }
   
+/*
+ *  @name   Transform
+ *  @fn     int Transform(const Sample& input,
+                          std::vector<Sample>* generated) const
+ *  @brief  Extract the corner/center patches of an image already in memory
+ *  @param[in]  input     Sample to augment
+ *  @param[out] generated Generated samples are appended to it
+ *  @return -1 if error, 0 otherwise
+ */
+int ImageCropCell::Transform(const Sample& input,
+                             std::vector<Sample>* generated) const {
+  const cv::Mat& img = input.image;
+  std::vector<Warp> warps;
+  if (img.empty() || this->Geometry(img.size(), &warps) != 0) {
+    return -1;
+  }
+  ExtractPatches(input, cv::Point(0, 0), warps, generated);
+  return 0;
+}
   
+/*
+ *  @name   Geometry
+ *  @fn     int Geometry(const cv::Size& size,
+                         std::vector<Warp>* warps) const
+ *  @brief  Describe the patches as translations
+ *  @param[in]  size  Input image size
+ *  @param[out] warps Warps are appended to it
+ *  @return -1 if error, 0 otherwise
+ */
+int ImageCropCell::Geometry(const cv::Size& size,
+                            std::vector<Warp>* warps) const {
+  if (size.width <= width_ || size.height <= height_) {
+    return -1;
+  }
+  for (int i = 0; i < 5; ++i) {
+    const cv::Point org = CropOrigin(i, size, width_, height_);
+    Warp w;
+    w.transform = cv::Matx23d(1.0, 0.0, -org.x,
+                              0.0, 1.0, -org.y);
+    w.size = cv::Size(width_, height_);
+    w.name = "_crop" + String::LeadingZero(i, 3);
+    warps->push_back(std::move(w));
+  }
+  return 0;
+}
+
+  
+#pragma mark -
+#pragma mark Accessors
+  
+/*
+ *  @name   config
+ *  @fn     std::string config(void) const
+ *  @brief  Describe the operation and its parameters
+ */
+std::string ImageCropCell::config(void) const {
+  return std::string(this->name()) + "(" + std::to_string(width_) + "," +
+         std::to_string(height_) + ")";
+}
   
 }  // namespace FaceKit
@@ -8,11 +8,15 @@
  *  Copyright © 2017 Christophe Ecabert. All rights reserved.
  */
 
+#include <string>
+#include <utility>
+
 #include "opencv2/core.hpp"
 #include "opencv2/imgcodecs.hpp"
 
 #include "facekit/dataset/flip_cell.hpp"
 #include "facekit/core/utils/string.hpp"
+#include "facekit/core/task_group.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -49,38 +53,123 @@ ImgFlipCell::ImgFlipCell(const Direction direction) : dir_(direction) {
 int ImgFlipCell::Process(const std::vector<std::string>& input,
                          const std::string& output,
                          std::vector<std::string>* generated) const {
-  int err = 0;
+  // Images are independent, process them concurrently. Each task fills its
+  // own slot to keep output order deterministic
+  std::vector<std::vector<std::string>> gen(input.size());
+  std::vector<int> errs(input.size(), 0);
+  TaskGroup group;
   for (size_t i = 0; i < input.size(); ++i) {
-    // Get filename
-    std::string dir, file, ext;
-    Path::SplitComponent(input[i], &dir, &file, &ext);
-    // Load image
-    cv::Mat img = cv::imread(input[i], cv::ImreadModes::IMREAD_COLOR);
-    if (!img.empty()) {
-      if ((dir_ & Direction::kHorizontal) == Direction::kHorizontal) {
-        // Horizontal flip
-        cv::Mat himg;
-        cv::flip(img, himg, 1);
-        // Save it
-        std::string dest = output.back() == '/' ? output : output + "/";
-        dest += file + "_fh." + ext;
-        cv::imwrite(dest, himg);
-        generated->push_back(dest);
+    group.Run([this, i, &input, &output, &gen, &errs](void) {
+      // Get filename
+      StringView file, ext;
+      Path::SplitComponent(input[i], nullptr, &file, &ext);
+      // Load image
+      cv::Mat img = cv::imread(input[i], cv::ImreadModes::IMREAD_COLOR);
+      Sample src;
+      src.image = img;
+      src.name.assign(file.data(), file.size());
+      std::vector<Sample> samples;
+      if (AugmentationCell::LoadAnnotations(input[i], &src) == 0 &&
+          this->Transform(src, &samples) == 0) {
+        // Save them
+        for (const auto& sample : samples) {
+          std::string dest = output.back() == '/' ? output : output + "/";
+          dest.append(sample.name).append(".");
+          dest.append(ext.data(), ext.size());
+          cv::imwrite(dest, sample.image);
+          AugmentationCell::SaveAnnotations(dest, sample);
+          gen[i].push_back(dest);
+        }
+      } else {
+        errs[i] = -1;
       }
-      if ((dir_ & Direction::kVertical) == Direction::kVertical) {
-        // Vertical flip
-        cv::Mat vimg;
-        cv::flip(img, vimg, 0);
-        std::string dest = output.back() == '/' ? output : output + "/";
-        dest += file + "_fv." + ext;
-        cv::imwrite(dest, vimg);
-        generated->push_back(dest);
-      }
-    } else {
-      err |= -1;
-    }
+    });
+  }
+  group.Wait();
+  // Gather
+  int err = 0;
+  for (size_t i = 0; i < input.size(); ++i) {
+    generated->insert(generated->end(), gen[i].begin(), gen[i].end());
+    err |= errs[i];
   }
   return err;
 }
   
+/*
+ *  @name   Transform
+ *  @fn     int Transform(const Sample& input,
+                          std::vector<Sample>* generated) const
+ *  @brief  Flip an image already in memory
+ *  @param[in]  input     Sample to augment
+ *  @param[out] generated Generated samples are appended to it
+ *  @return -1 if error, 0 otherwise
+ */
+int ImgFlipCell::Transform(const Sample& input,
+                           std::vector<Sample>* generated) const {
+  std::vector<Warp> warps;
+  if (input.image.empty() ||
+      this->Geometry(input.image.size(), &warps) != 0) {
+    return -1;
+  }
+  for (const auto& w : warps) {
+    // Exact flip for the pixels, the warp maps the annotations
+    Sample sample;
+    const bool horizontal = w.transform(0, 0) < 0.0;
+    cv::flip(input.image, sample.image, horizontal ? 1 : 0);
+    sample.name = input.name + w.name;
+    AugmentationCell::MapAnnotations(w.transform, input, &sample);
+    generated->push_back(std::move(sample));
+  }
+  return 0;
+}
+  
+/*
+ *  @name   Geometry
+ *  @fn     int Geometry(const cv::Size& size,
+                         std::vector<Warp>* warps) const
+ *  @brief  Describe the flips as affine warps
+ *  @param[in]  size  Input image size
+ *  @param[out] warps Warps are appended to it
+ *  @return -1 if error, 0 otherwise
+ */
+int ImgFlipCell::Geometry(const cv::Size& size,
+                          std::vector<Warp>* warps) const {
+  if (size.width <= 0 || size.height <= 0) {
+    return -1;
+  }
+  if ((dir_ & Direction::kHorizontal) == Direction::kHorizontal) {
+    // x' = (w - 1) - x
+    Warp w;
+    w.transform = cv::Matx23d(-1.0, 0.0, size.width - 1.0,
+                              0.0, 1.0, 0.0);
+    w.size = size;
+    w.name = "_fh";
+    warps->push_back(std::move(w));
+  }
+  if ((dir_ & Direction::kVertical) == Direction::kVertical) {
+    // y' = (h - 1) - y
+    Warp w;
+    w.transform = cv::Matx23d(1.0, 0.0, 0.0,
+                              0.0, -1.0, size.height - 1.0);
+    w.size = size;
+    w.name = "_fv";
+    warps->push_back(std::move(w));
+  }
+  return 0;
+}
+
+  
+#pragma mark -
+#pragma mark Accessors
+  
+/*
+ *  @name   config
+ *  @fn     std::string config(void) const
+ *  @brief  Describe the operation and its parameters
+ */
+std::string ImgFlipCell::config(void) const {
+  return std::string(this->name()) + "(" +
+         std::to_string(static_cast<int>(dir_)) + ")";
+}
+  
 }  // namespace FaceKit
@@ -9,9 +9,11 @@
  */
 
 #include <fstream>
+#include <utility>
 
 #include "facekit/dataset/identity_cell.hpp"
 #include "facekit/core/utils/string.hpp"
+#include "facekit/core/task_group.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -33,26 +35,86 @@ namespace FaceKit {
 int IdentityCell::Process(const std::vector<std::string>& input,
                           const std::string& output,
                           std::vector<std::string>* generated) const {
+  // Files are independent, copy them concurrently. Each task fills its own
+  // slot to keep output order deterministic
+  std::vector<std::string> gen(input.size());
+  std::vector<int> errs(input.size(), 0);
+  TaskGroup group;
+  for (size_t i = 0; i < input.size(); ++i) {
+    group.Run([i, &input, &output, &gen, &errs](void) {
+      // Get filename
+      StringView file, ext;
+      Path::SplitComponent(input[i], nullptr, &file, &ext);
+      // Copy
+      std::string dest = output.back() == '/' ? output : output + "/";
+      dest.append(file.data(), file.size()).append("_id.");
+      dest.append(ext.data(), ext.size());
+      std::ifstream in_stream(input[i].c_str(), std::ios::binary);
+      std::ofstream out_stream(dest.c_str(), std::ios::binary);
+      if (in_stream.is_open() && out_stream.is_open()) {
+        // copy file
+        out_stream << in_stream.rdbuf();
+        // Annotations follow the image
+        Sample sample;
+        if (AugmentationCell::LoadAnnotations(input[i], &sample) != 0 ||
+            AugmentationCell::SaveAnnotations(dest, sample) != 0) {
+          errs[i] = -1;
+        }
+        gen[i] = std::move(dest);
+      } else {
+        errs[i] = -1;
+      }
+    });
+  }
+  group.Wait();
+  // Gather
   int err = 0;
   for (size_t i = 0; i < input.size(); ++i) {
-    // Get filename
-    std::string dir, file, ext;
-    Path::SplitComponent(input[i], &dir, &file, &ext);
-    // Copy
-    std::string dest = output.back() == '/' ? output : output + "/";
-    dest += file + "_id." + ext;
-    std::ifstream in_stream(input[i].c_str(), std::ios::binary);
-    std::ofstream out_stream(dest.c_str(), std::ios::binary);
-    if (in_stream.is_open() && out_stream.is_open()) {
-      // copy file
-      out_stream << in_stream.rdbuf();
-      // update generated list
-      generated->push_back(dest);
-    } else {
-      err |= -1;
+    if (errs[i] == 0) {
+      generated->push_back(gen[i]);
     }
+    err |= errs[i];
   }
   return err;
 }
   
+/*
+ *  @name   Transform
+ *  @fn     int Transform(const Sample& input,
+                          std::vector<Sample>* generated) const
+ *  @brief  Forward the input sample, image data is shared
+ *  @param[in]  input     Sample to augment
+ *  @param[out] generated Generated samples are appended to it
+ *  @return -1 if error, 0 otherwise
+ */
+int IdentityCell::Transform(const Sample& input,
+                            std::vector<Sample>* generated) const {
+  if (input.image.empty()) {
+    return -1;
+  }
+  generated->push_back({input.image,
+                        input.name + "_id",
+                        input.landmarks,
+                        input.bboxes});
+  return 0;
+}
+  
+/*
+ *  @name   Geometry
+ *  @fn     int Geometry(const cv::Size& size,
+                         std::vector<Warp>* warps) const
+ *  @brief  Identity warp
+ *  @param[in]  size  Input image size
+ *  @param[out] warps Warps are appended to it
+ *  @return -1 if error, 0 otherwise
+ */
+int IdentityCell::Geometry(const cv::Size& size,
+                           std::vector<Warp>* warps) const {
+  if (size.width <= 0 || size.height <= 0) {
+    return -1;
+  }
+  warps->push_back({cv::Matx23d(1.0, 0.0, 0.0, 0.0, 1.0, 0.0), size, "_id"});
+  return 0;
+}
+  
 }  // namespace FaceKit
@@ -8,8 +8,10 @@
  *  Copyright © 2017 Christophe Ecabert. All rights reserved.
  */
 
-#include <chrono>
+#include <algorithm>
 #include <random>
+#include <string>
+#include <utility>
 
 #include "opencv2/core.hpp"
 #include "opencv2/imgcodecs.hpp"
@@ -17,6 +19,7 @@
 
 #include "facekit/dataset/in_plane_rotation_cell.hpp"
 #include "facekit/core/utils/string.hpp"
+#include "facekit/core/task_group.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -54,52 +57,133 @@ range_(range), n_sample_(n_sample) {
 int ImgInPlaneRotationCell::Process(const std::vector<std::string>& input,
                                       const std::string& output,
                                       std::vector<std::string>* generated) const {
-  int err = 0;
+  // Images are independent, process them concurrently. Each task fills its
+  // own slot to keep output order deterministic
+  std::vector<std::vector<std::string>> gen(input.size());
+  std::vector<int> errs(input.size(), 0);
+  TaskGroup group;
   for (size_t i = 0; i < input.size(); ++i) {
-    // Get filename
-    std::string dir, file, ext;
-    Path::SplitComponent(input[i], &dir, &file, &ext);
-    // Load image
-    cv::Mat img = cv::imread(input[i], cv::ImreadModes::IMREAD_COLOR);
-    if (!img.empty()) {
-      // Create distribution
-      const float cx = float(img.cols) / 2.f;
-      const float cy = float(img.rows) / 2.f;
-      const float r = float(std::min(img.cols, img.rows)) / 2.f;
-      std::uniform_real_distribution<float> p_dist(0, r/2.f);
-      std::uniform_real_distribution<double> ang_dist(-range_, range_);
-      // Create generator
-      auto seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-      std::mt19937 gen(static_cast<std::mt19937::result_type>(seed));
-      // Generate new samples
-      for (size_t i = 0; i < n_sample_; ++i) {
-        // Pick rotation enter
-        cv::Point2f p;
-        p.x = cx + p_dist(gen);
-        p.y = cy + p_dist(gen);
-        // Select rotation angle
-        double ang = ang_dist(gen);
-        // Compute rotation matrix
-        cv::Mat rot = cv::getRotationMatrix2D(p, ang, 1.0);
-        // Warp
-        cv::Mat sample;
-        cv::warpAffine(img,
-                       sample,
-                       rot,
-                       cv::Size(img.cols, img.rows),
-                       cv::INTER_LINEAR);
+    group.Run([this, i, &input, &output, &gen, &errs](void) {
+      // Get filename
+      StringView file, ext;
+      Path::SplitComponent(input[i], nullptr, &file, &ext);
+      // Load image
+      cv::Mat img = cv::imread(input[i], cv::ImreadModes::IMREAD_COLOR);
+      std::vector<Sample> samples;
+      const std::string name(file.data(), file.size());
+      Sample src;
+      src.image = img;
+      src.name = name;
+      AugmentationCell::Reseed(name);
+      if (AugmentationCell::LoadAnnotations(input[i], &src) == 0 &&
+          this->Transform(src, &samples) == 0) {
         // Save
-        std::string dest = output.back() == '/' ? output : output + "/";
-        dest += file + "_rot" + String::LeadingZero(i, 3) +"." + ext;
-        cv::imwrite(dest, sample);
-        generated->push_back(dest);
+        for (const auto& sample : samples) {
+          std::string dest = output.back() == '/' ? output : output + "/";
+          dest.append(sample.name).append(".");
+          dest.append(ext.data(), ext.size());
+          cv::imwrite(dest, sample.image);
+          AugmentationCell::SaveAnnotations(dest, sample);
+          gen[i].push_back(dest);
+        }
+      } else {
+        errs[i] = -1;
       }
-    } else {
-      err |= -1;
-    }
+    });
+  }
+  group.Wait();
+  // Gather
+  int err = 0;
+  for (size_t i = 0; i < input.size(); ++i) {
+    generated->insert(generated->end(), gen[i].begin(), gen[i].end());
+    err |= errs[i];
   }
   return err;
 }
   
+/*
+ *  @name   Transform
+ *  @fn     int Transform(const Sample& input,
+                          std::vector<Sample>* generated) const
+ *  @brief  Rotate an image already in memory
+ *  @param[in]  input     Sample to augment
+ *  @param[out] generated Generated samples are appended to it
+ *  @return -1 if error, 0 otherwise
+ */
+int ImgInPlaneRotationCell::Transform(const Sample& input,
+                                      std::vector<Sample>* generated) const {
+  const cv::Mat& img = input.image;
+  std::vector<Warp> warps;
+  if (img.empty() || this->Geometry(img.size(), &warps) != 0) {
+    return -1;
+  }
+  for (const auto& w : warps) {
+    // Warp
+    Sample sample;
+    cv::warpAffine(img,
+                   sample.image,
+                   w.transform,
+                   w.size,
+                   cv::INTER_LINEAR);
+    sample.name = input.name + w.name;
+    AugmentationCell::MapAnnotations(w.transform, input, &sample);
+    generated->push_back(std::move(sample));
+  }
+  return 0;
+}
+  
+/*
+ *  @name   Geometry
+ *  @fn     int Geometry(const cv::Size& size,
+                         std::vector<Warp>* warps) const
+ *  @brief  Draw the random rotations as affine warps
+ *  @param[in]  size  Input image size
+ *  @param[out] warps Warps are appended to it
+ *  @return -1 if error, 0 otherwise
+ */
+int ImgInPlaneRotationCell::Geometry(const cv::Size& size,
+                                     std::vector<Warp>* warps) const {
+  if (size.width <= 0 || size.height <= 0) {
+    return -1;
+  }
+  // Create distribution
+  const float cx = float(size.width) / 2.f;
+  const float cy = float(size.height) / 2.f;
+  const float r = float(std::min(size.width, size.height)) / 2.f;
+  std::uniform_real_distribution<float> p_dist(0, r/2.f);
+  std::uniform_real_distribution<double> ang_dist(-range_, range_);
+  // Generator of the calling thread
+  Random& gen = AugmentationCell::Generator();
+  // Generate new samples
+  for (size_t i = 0; i < n_sample_; ++i) {
+    // Pick rotation enter
+    cv::Point2f p;
+    p.x = cx + p_dist(gen);
+    p.y = cy + p_dist(gen);
+    // Select rotation angle
+    double ang = ang_dist(gen);
+    // Compute rotation matrix
+    Warp w;
+    w.transform = cv::getRotationMatrix2D(p, ang, 1.0);
+    w.size = size;
+    w.name = "_rot" + String::LeadingZero(i, 3);
+    warps->push_back(std::move(w));
+  }
+  return 0;
+}
+
+  
+#pragma mark -
+#pragma mark Accessors
+  
+/*
+ *  @name   config
+ *  @fn     std::string config(void) const
+ *  @brief  Describe the operation and its parameters
+ */
+std::string ImgInPlaneRotationCell::config(void) const {
+  return std::string(this->name()) + "(" + std::to_string(range_) + "," +
+         std::to_string(n_sample_) + ")";
+}
   
 }  // namespace FaceKit
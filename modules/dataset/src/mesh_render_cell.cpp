@@ -0,0 +1,352 @@
+/**
+ *  @file   mesh_render_cell.cpp
+ *  @brief  Generate out-of-plane rotations by fitting a 3D face model and
+ *          re-rendering the face under a new pose
+ *  @ingroup dataset
+ *
+ *  @author Christophe Ecabert
+ *  @date   10.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <utility>
+
+#include "opencv2/core.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
+
+#include "facekit/dataset/mesh_render_cell.hpp"
+#include "facekit/core/logger.hpp"
+#include "facekit/core/utils/string.hpp"
+#include "facekit/core/task_group.hpp"
+#include "facekit/model/camera.hpp"
+#include "facekit/model/rasterizer.hpp"
+#include "facekit/model/weak_projection.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Camera used for fitting and rendering */
+using Cam = Camera<float, WeakProjection>;
+/** Renderer */
+using Renderer = Rasterizer<float, WeakProjection>;
+
+/**
+ *  @name   Rotate
+ *  @fn     static void Rotate(const float* src, const size_t& n,
+                               const double& yaw, const double& pitch,
+                               std::vector<Mesh<float>::Vertex>* dst)
+ *  @brief  Rotate the vertices \p src [3n] by \p yaw (around the model's
+ *          vertical axis) then \p pitch (around its horizontal axis), in
+ *          degree, about their centroid
+ */
+static void Rotate(const float* src,
+                   const size_t& n,
+                   const double& yaw,
+                   const double& pitch,
+                   std::vector<Mesh<float>::Vertex>* dst) {
+  // Centroid
+  double c[3] = {0.0, 0.0, 0.0};
+  for (size_t i = 0; i < n; ++i) {
+    c[0] += src[3 * i];
+    c[1] += src[3 * i + 1];
+    c[2] += src[3 * i + 2];
+  }
+  for (double& ci : c) {
+    ci /= std::max<double>(double(n), 1.0);
+  }
+  // R = Ry(yaw) * Rx(pitch)
+  const double a = yaw * CV_PI / 180.0;
+  const double b = pitch * CV_PI / 180.0;
+  const double ca = std::cos(a), sa = std::sin(a);
+  const double cb = std::cos(b), sb = std::sin(b);
+  const float r[9] = {float(ca), float(sa * sb), float(sa * cb),
+                      0.f, float(cb), float(-sb),
+                      float(-sa), float(ca * sb), float(ca * cb)};
+  dst->resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    const float x = src[3 * i] - float(c[0]);
+    const float y = src[3 * i + 1] - float(c[1]);
+    const float z = src[3 * i + 2] - float(c[2]);
+    auto& v = (*dst)[i];
+    v.x_ = r[0] * x + r[1] * y + r[2] * z + float(c[0]);
+    v.y_ = r[3] * x + r[4] * y + r[5] * z + float(c[1]);
+    v.z_ = r[6] * x + r[7] * y + r[8] * z + float(c[2]);
+  }
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   MeshRenderCell
+ *  @fn     MeshRenderCell(const PCAModel<float>* model,
+                           const Mesh<float>& topology,
+                           const std::vector<int>& landmarks,
+                           const Options& options)
+ *  @brief  Constructor
+ *  @param[in] model      Shape model, must outlive the cell
+ *  @param[in] topology   Mesh holding the model's triangulation
+ *  @param[in] landmarks  Vertex index of each annotated landmark, in the
+ *                        annotation's order
+ *  @param[in] options    Perturbations
+ */
+MeshRenderCell::MeshRenderCell(const PCAModel<float>* model,
+                               const Mesh<float>& topology,
+                               const std::vector<int>& landmarks,
+                               const Options& options) :
+        model_(model),
+        options_(options) {
+  topology_.ShareTopology(topology);
+  options_.n_component = std::max(std::min(options_.n_component,
+                                           model_->get_n_principle_component()),
+                                  1);
+  // Landmark sub-model, built once for every fit
+  Status s = model_->BuildSubset(landmarks, &subset_);
+  if (!s.Good() || model_->get_n_channels() != 3) {
+    FACEKIT_LOG_ERROR("Invalid shape model or landmarks");
+    subset_ = PCAModel<float>::Subset();
+  }
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Process
+ *  @fn     int Process(const std::vector<std::string>& input,
+                        const std::string& output,
+                        std::vector<std::string>* generated) const
+ *  @brief  Run augmentation step on provided data
+ *  @param[in]  input     List of file to augment
+ *  @param[in]  output    Location where to place the generated samples
+ *  @param[out] generated List of path to the generated samples
+ *  @return -1 if error, 0 otherwise
+ */
+int MeshRenderCell::Process(const std::vector<std::string>& input,
+                            const std::string& output,
+                            std::vector<std::string>* generated) const {
+  // Images are independent, process them concurrently. Each task fills its
+  // own slot to keep output order deterministic
+  std::vector<std::vector<std::string>> gen(input.size());
+  std::vector<int> errs(input.size(), 0);
+  TaskGroup group;
+  for (size_t i = 0; i < input.size(); ++i) {
+    group.Run([this, i, &input, &output, &gen, &errs](void) {
+      // Get filename
+      StringView file, ext;
+      Path::SplitComponent(input[i], nullptr, &file, &ext);
+      // Load image
+      cv::Mat img = cv::imread(input[i], cv::ImreadModes::IMREAD_COLOR);
+      std::vector<Sample> samples;
+      const std::string name(file.data(), file.size());
+      Sample src;
+      src.image = img;
+      src.name = name;
+      AugmentationCell::Reseed(name);
+      if (AugmentationCell::LoadAnnotations(input[i], &src) == 0 &&
+          this->Transform(src, &samples) == 0) {
+        // Save
+        for (const auto& sample : samples) {
+          std::string dest = output.back() == '/' ? output : output + "/";
+          dest.append(sample.name).append(".");
+          dest.append(ext.data(), ext.size());
+          cv::imwrite(dest, sample.image);
+          AugmentationCell::SaveAnnotations(dest, sample);
+          gen[i].push_back(dest);
+        }
+      } else {
+        errs[i] = -1;
+      }
+    });
+  }
+  group.Wait();
+  // Gather
+  int err = 0;
+  for (size_t i = 0; i < input.size(); ++i) {
+    generated->insert(generated->end(), gen[i].begin(), gen[i].end());
+    err |= errs[i];
+  }
+  return err;
+}
+
+/*
+ *  @name   Transform
+ *  @fn     int Transform(const Sample& input,
+                          std::vector<Sample>* generated) const
+ *  @brief  Re-render the face of an image already in memory
+ *  @param[in]  input     Sample to augment, with landmarks
+ *  @param[out] generated Generated samples are appended to it
+ *  @return -1 if error, 0 otherwise
+ */
+int MeshRenderCell::Transform(const Sample& input,
+                              std::vector<Sample>* generated) const {
+  const cv::Mat& img = input.image;
+  const size_t n_lms = subset_.vertex.size();
+  if (img.empty() || n_lms == 0 || input.landmarks.size() != n_lms) {
+    return -1;
+  }
+  // Fit camera then shape and camera jointly on the landmarks
+  const float w = float(img.cols);
+  const float h = float(img.rows);
+  Cam cam(std::max(w, h), w, h);
+  cv::Mat proj(2 * static_cast<int>(n_lms), 1, CV_32FC1);
+  for (size_t i = 0; i < n_lms; ++i) {
+    proj.at<float>(2 * i) = input.landmarks[i].x;
+    proj.at<float>(2 * i + 1) = input.landmarks[i].y;
+  }
+  cv::Mat p(options_.n_component, 1, CV_32FC1, cv::Scalar(0.f));
+  if (cam.From3Dto2D(subset_.mean, proj, options_.eps) < -1 ||
+      cam.FitShape(*model_,
+                   subset_,
+                   proj,
+                   options_.eta,
+                   options_.eps,
+                   &p) < -1) {
+    FACEKIT_LOG_WARNING("Can not fit " << input.name);
+    return -1;
+  }
+  // Draw every perturbation first, from the calling thread's generator
+  const size_t n = options_.n_sample;
+  const int K = model_->get_n_principle_component();
+  std::uniform_real_distribution<double> yaw_dist(-options_.yaw,
+                                                  options_.yaw);
+  std::uniform_real_distribution<double> pitch_dist(-options_.pitch,
+                                                    options_.pitch);
+  std::normal_distribution<float> shape_dist(0.f,
+                                             float(options_.shape_sigma));
+  Random& gen = AugmentationCell::Generator();
+  std::vector<double> yaw(n), pitch(n);
+  // Coefficients of every shape, the fitted one in the first column
+  cv::Mat coef(K, static_cast<int>(n + 1), CV_32FC1, cv::Scalar(0.f));
+  for (size_t i = 0; i < n; ++i) {
+    yaw[i] = yaw_dist(gen);
+    pitch[i] = pitch_dist(gen);
+  }
+  for (int k = 0; k < options_.n_component; ++k) {
+    float* row = coef.ptr<float>(k);
+    std::fill(row, row + n + 1, p.at<float>(k));
+    if (options_.shape_sigma > 0.0) {
+      for (size_t i = 1; i <= n; ++i) {
+        row[i] += shape_dist(gen);
+      }
+    }
+  }
+  // Generate all shapes at once, one GEMM
+  cv::Mat shapes;
+  Status s = model_->GenerateBatch(coef, &shapes);
+  if (!s.Good()) {
+    FACEKIT_LOG_ERROR(s.ToString());
+    return -1;
+  }
+  const size_t n_vertex = static_cast<size_t>(shapes.rows / 3);
+  auto Gather = [&shapes, &n_vertex](const size_t& c, float* dst) {
+    for (size_t v = 0; v < 3 * n_vertex; ++v) {
+      dst[v] = shapes.at<float>(static_cast<int>(v), static_cast<int>(c));
+    }
+  };
+  // Fitted shape seen by the fitted camera gives the texture coordinates
+  // of every vertex
+  cv::Mat vertex(static_cast<int>(3 * n_vertex), 1, CV_32FC1);
+  Gather(0, reinterpret_cast<float*>(vertex.data));
+  cv::Mat src_proj;
+  cam(vertex, &src_proj);
+  const float* uv = reinterpret_cast<const float*>(src_proj.data);
+  const auto& tri = topology_.get_triangle();
+  // Render each perturbation, samples are independent
+  std::vector<Sample> samples(n);
+  std::vector<int> errs(n, 0);
+  TaskGroup group;
+  for (size_t i = 0; i < n; ++i) {
+    group.Run([&, i](void) {
+      std::vector<float> shape(3 * n_vertex);
+      Gather(i + 1, shape.data());
+      Mesh<float> mesh(topology_);
+      Rotate(shape.data(), n_vertex, yaw[i], pitch[i], &mesh.get_vertex());
+      Renderer::Buffers buffers;
+      Renderer render(img.cols, img.rows);
+      if (!render.Render(mesh, cam, &buffers).Good()) {
+        errs[i] = -1;
+        return;
+      }
+      // Sampling positions, face pixels are interpolated from the source
+      // projection of their triangle, the background is kept
+      cv::Mat map_x(img.rows, img.cols, CV_32FC1);
+      cv::Mat map_y(img.rows, img.cols, CV_32FC1);
+      for (int y = 0; y < img.rows; ++y) {
+        const int* t_ptr = buffers.triangle.ptr<int>(y);
+        const cv::Vec2f* b_ptr = buffers.barycentric.ptr<cv::Vec2f>(y);
+        float* mx = map_x.ptr<float>(y);
+        float* my = map_y.ptr<float>(y);
+        for (int x = 0; x < img.cols; ++x) {
+          if (t_ptr[x] < 0) {
+            mx[x] = float(x);
+            my[x] = float(y);
+            continue;
+          }
+          const auto& t = tri[t_ptr[x]];
+          const float b1 = b_ptr[x][0];
+          const float b2 = b_ptr[x][1];
+          const float b0 = 1.f - b1 - b2;
+          mx[x] = (b0 * uv[2 * t.x_] + b1 * uv[2 * t.y_] +
+                   b2 * uv[2 * t.z_]);
+          my[x] = (b0 * uv[2 * t.x_ + 1] + b1 * uv[2 * t.y_ + 1] +
+                   b2 * uv[2 * t.z_ + 1]);
+        }
+      }
+      Sample& sample = samples[i];
+      cv::remap(img,
+                sample.image,
+                map_x,
+                map_y,
+                cv::INTER_LINEAR,
+                cv::BORDER_REPLICATE);
+      sample.name = input.name + "_3d" + String::LeadingZero(i, 3);
+      // Landmarks follow their vertex, boxes are forwarded
+      const float* pts = reinterpret_cast<const float*>(
+              render.projection().data);
+      sample.landmarks.resize(n_lms);
+      for (size_t l = 0; l < n_lms; ++l) {
+        const int v = subset_.vertex[l];
+        sample.landmarks[l] = cv::Point2f(pts[2 * v], pts[2 * v + 1]);
+      }
+      sample.bboxes = input.bboxes;
+    });
+  }
+  group.Wait();
+  for (size_t i = 0; i < n; ++i) {
+    if (errs[i] != 0) {
+      return -1;
+    }
+  }
+  for (auto& sample : samples) {
+    generated->push_back(std::move(sample));
+  }
+  return 0;
+}
+
+#pragma mark -
+#pragma mark Accessors
+
+/*
+ *  @name   config
+ *  @fn     std::string config(void) const
+ *  @brief  Describe the operation and its parameters
+ */
+std::string MeshRenderCell::config(void) const {
+  return std::string(this->name()) + "(" + std::to_string(options_.yaw) +
+         "," + std::to_string(options_.pitch) + "," +
+         std::to_string(options_.shape_sigma) + "," +
+         std::to_string(options_.n_component) + "," +
+         std::to_string(options_.eta) + "," +
+         std::to_string(options_.n_sample) + ")";
+}
+
+}  // namespace FaceKit
@@ -0,0 +1,462 @@
+/**
+ *  @file   video_pipeline.cpp
+ *  @brief  Fit every face of a video stream: frames are decoded ahead, the
+ *          faces of a frame are fitted in parallel starting from their pose
+ *          in the previous frame and results are delivered in order
+ *  @ingroup dataset
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "facekit/core/mem/memory_budget.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/trace.hpp"
+#include "facekit/core/types.hpp"
+#include "facekit/core/utils/string.hpp"
+#include "facekit/io/image_factory.hpp"
+#include "facekit/dataset/video_pipeline.hpp"
+#include "facekit/model/orthographic_projection.hpp"
+#include "facekit/model/perspective_projection.hpp"
+#include "facekit/model/weak_projection.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Number of faces fitted by one parallel task, a frame rarely shows more
+    than a handful of them */
+static constexpr size_t kFitGrain = 1;
+
+/**
+ *  @name   ShapeLandmarks
+ *  @fn     static void ShapeLandmarks(const PCAModel<T>& model,
+                            const typename PCAModel<T>::Subset& landmarks,
+                            const cv::Mat& coef, cv::Mat* pts)
+ *  @brief  Landmarks of the shape \p coef: mean + V_k * (prior .* coef)
+ *  @param[in] model      Shape model, provides the prior
+ *  @param[in] landmarks  Landmark sub-model
+ *  @param[in] coef       Leading shape coefficients [k x 1], mean if empty
+ *  @param[out] pts       Landmarks [3N x 1]
+ */
+template<typename T>
+static void ShapeLandmarks(const PCAModel<T>& model,
+                           const typename PCAModel<T>::Subset& landmarks,
+                           const cv::Mat& coef,
+                           cv::Mat* pts) {
+  const int k = static_cast<int>(coef.total());
+  const T* prior = reinterpret_cast<const T*>(model.get_prior().data);
+  const T* mean = reinterpret_cast<const T*>(landmarks.mean.data);
+  const cv::Mat& basis = landmarks.variation;
+  std::vector<T> w(k);
+  for (int j = 0; j < k; ++j) {
+    w[j] = prior[j] * coef.at<T>(j);
+  }
+  T* dst = reinterpret_cast<T*>(pts->data);
+  for (int r = 0; r < landmarks.mean.rows; ++r) {
+    const T* v = k > 0 ? basis.ptr<T>(r) : nullptr;
+    T acc = mean[r];
+    for (int j = 0; j < k; ++j) {
+      acc += v[j] * w[j];
+    }
+    dst[r] = acc;
+  }
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   VideoPipeline
+ *  @fn     VideoPipeline(void)
+ *  @brief  Constructor, default options
+ */
+template<typename T, template<typename U> class ProjType>
+VideoPipeline<T, ProjType>::VideoPipeline(void) : n_frame_(0) {
+}
+
+/*
+ *  @name   VideoPipeline
+ *  @fn     explicit VideoPipeline(const Options& options)
+ *  @brief  Constructor
+ *  @param[in] options  Pipeline configuration
+ */
+template<typename T, template<typename U> class ProjType>
+VideoPipeline<T, ProjType>::VideoPipeline(const Options& options) :
+        options_(options),
+        n_frame_(0) {
+}
+
+/*
+ *  @name   ~VideoPipeline
+ *  @fn     ~VideoPipeline(void)
+ *  @brief  Destructor
+ */
+template<typename T, template<typename U> class ProjType>
+VideoPipeline<T, ProjType>::~VideoPipeline(void) = default;
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Run
+ *  @fn     Status Run(const PCAModel<T>& model, const Subset& landmarks,
+                       const std::vector<Frame>& frames,
+                       const Callback& callback)
+ *  @brief  Process \p frames, following the frames given to previous calls
+ *  @param[in] model      Shape model
+ *  @param[in] landmarks  Landmark sub-model, see `PCAModel::BuildSubset`
+ *  @param[in] frames     Frames to process
+ *  @param[in] callback   Completion callback
+ *  @return kInvalidArgument if the model or a face is malformed, first
+ *          decoding error otherwise
+ */
+template<typename T, template<typename U> class ProjType>
+Status VideoPipeline<T, ProjType>::Run(const PCAModel<T>& model,
+                                       const Subset& landmarks,
+                                       const std::vector<Frame>& frames,
+                                       const Callback& callback) {
+  FACEKIT_TRACE_SCOPE("VideoPipeline::Run");
+  using TaskPriority = ThreadPool::TaskPriority;
+  const int type = cv::DataType<T>::type;
+  const int n_pts = landmarks.mean.rows / 3;
+  if (model.get_n_channels() != 3 || n_pts == 0 ||
+      landmarks.mean.type() != type || !landmarks.mean.isContinuous() ||
+      landmarks.mean.total() != size_t(3 * n_pts) || options_.n_shape < 0 ||
+      options_.n_shape > landmarks.variation.cols) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Model must describe 3D shapes, its landmark sub-model "
+                  "must hold at least `n_shape` components");
+  }
+  std::vector<int> ids;
+  for (const auto& frame : frames) {
+    ids.clear();
+    for (const auto& face : frame.faces) {
+      if (face.landmarks.type() != type || !face.landmarks.isContinuous() ||
+          face.landmarks.total() != size_t(2 * n_pts)) {
+        return Status(Status::Type::kInvalidArgument,
+                      "Faces must hold 2N landmark positions of the "
+                      "model's type");
+      }
+      ids.push_back(face.id);
+    }
+    std::sort(ids.begin(), ids.end());
+    if (std::adjacent_find(ids.begin(), ids.end()) != ids.end()) {
+      return Status(Status::Type::kInvalidArgument,
+                    "Face ids must be unique within a frame: " + frame.path);
+    }
+  }
+  if (frames.empty()) {
+    return Status();
+  }
+
+  /** Frame between decoding and delivery */
+  struct Slot {
+    /** Result so far */
+    Result result;
+    /** Decoded pixels, kept to decode the frames using this slot later */
+    NDArray pixels;
+    /** Reservation of the pixels */
+    MemoryBudget::Token token;
+    /** Decoding done */
+    bool decoded = false;
+    /** Fitting and generation done */
+    bool done = false;
+  };
+  ThreadPool& pool = options_.pool ? *options_.pool : ThreadPool::Get();
+  MemoryBudget* budget = options_.budget ?
+                         options_.budget :
+                         &MemoryBudget::Global();
+  const size_t n = frames.size();
+  const size_t window = options_.look_ahead ?
+                        options_.look_ahead :
+                        2 * std::max(pool.size(), size_t(1));
+  // Frames in flight are within [next_delivery, next_delivery + n_slot)
+  const size_t n_slot = std::min(window, n);
+  const size_t first_id = n_frame_;
+  std::vector<Slot> slots(n_slot);
+  Status status;
+  size_t in_flight = 0;
+  size_t next = 0;
+  size_t next_fit = 0;
+  size_t next_delivery = 0;
+  bool fitting = false;
+  bool delivering = false;
+  std::mutex mutex;
+  std::condition_variable cond;
+
+  // Deliver the completed frames in order, one thread at a time. The lock
+  // must be held.
+  auto deliver = [&](std::unique_lock<std::mutex>* lock) {
+    if (delivering) {
+      return;
+    }
+    delivering = true;
+    while (next_delivery < n && slots[next_delivery % n_slot].done) {
+      Slot& slot = slots[next_delivery % n_slot];
+      Result result(std::move(slot.result));
+      MemoryBudget::Token token(std::move(slot.token));
+      slot.result = Result();
+      slot.decoded = false;
+      slot.done = false;
+      lock->unlock();
+      callback(std::move(result));
+      token.Release();
+      lock->lock();
+      next_delivery += 1;
+      in_flight -= 1;
+    }
+    delivering = false;
+    cond.notify_all();
+  };
+  // Fit the frames one after the other, the lock must be held
+  std::function<void(const size_t&)> fit;
+  auto start_fit = [&](void) {
+    if (!fitting && next_fit < n && slots[next_fit % n_slot].decoded) {
+      fitting = true;
+      const size_t i = next_fit;
+      pool.Submit(TaskPriority::kNormal, [&fit, i](void) {
+        fit(i);
+      });
+    }
+  };
+  fit = [&](const size_t& i) {
+    Slot& slot = slots[i % n_slot];
+    Result& res = slot.result;
+    if (res.status.Good()) {
+      this->Fit(model, landmarks, frames[i], first_id + i, &slot.pixels,
+                &res);
+    }
+    if (options_.keep_image) {
+      res.image = std::move(slot.pixels);
+    } else {
+      slot.token.Release();
+    }
+    {
+      // Next frame can be fitted while the shapes of this one are generated
+      std::lock_guard<std::mutex> lock(mutex);
+      next_fit += 1;
+      fitting = false;
+      start_fit();
+    }
+    if (options_.generate && !res.faces.empty()) {
+      cv::Mat p = cv::Mat::zeros(landmarks.variation.cols,
+                                 static_cast<int>(res.faces.size()),
+                                 type);
+      for (size_t k = 0; k < res.faces.size(); ++k) {
+        const cv::Mat& coef = res.faces[k].coef;
+        if (!coef.empty()) {
+          coef.copyTo(p(cv::Rect(static_cast<int>(k), 0, 1, coef.rows)));
+        }
+      }
+      if (!model.GenerateBatch(p, &res.shapes).Good()) {
+        res.shapes.release();
+      }
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    slot.done = true;
+    deliver(&lock);
+  };
+  // Decode one frame into its slot
+  auto decode = [&](const size_t& i) {
+    Slot& slot = slots[i % n_slot];
+    Result& res = slot.result;
+    res.index = i;
+    std::string dir, file, ext;
+    Path::SplitComponent(frames[i].path, &dir, &file, &ext);
+    std::unique_ptr<Image> codec(ImageFactory::Get().CreateByExtension(ext));
+    if (codec) {
+      res.status = codec->LoadInto(frames[i].path, &slot.pixels);
+    } else {
+      res.status = Status(Status::Type::kInvalidArgument,
+                          "Unsupported image type: " + frames[i].path);
+    }
+    if (res.status.Good()) {
+      budget->Charge(slot.pixels.n_elems() *
+                     DataTypeDynamicSize(slot.pixels.type()),
+                     &slot.token);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!res.status.Good() && status.Good()) {
+      status = res.status;
+    }
+    slot.decoded = true;
+    start_fit();
+  };
+
+  // Decode ahead, at most `n_slot` frames alive at once and none while the
+  // budget is exhausted, unless nothing is in flight. The calling thread
+  // helps the pool while waiting so a video can be processed from a worker
+  auto can_dispatch = [&](void) {
+    return next < n &&
+           (in_flight == 0 || (in_flight < n_slot && !budget->exhausted()));
+  };
+  std::unique_lock<std::mutex> lock(mutex);
+  while (next < n || in_flight > 0) {
+    while (can_dispatch()) {
+      in_flight += 1;
+      const size_t i = next++;
+      pool.Submit(TaskPriority::kNormal, [&decode, i](void) {
+        decode(i);
+      });
+    }
+    lock.unlock();
+    const bool helped = pool.RunPendingTask();
+    lock.lock();
+    if (!helped) {
+      // Woken up by deliveries, which free a slot
+      cond.wait(lock, [&]() {
+        return in_flight == 0 || can_dispatch();
+      });
+    }
+  }
+  n_frame_ += n;
+  return status;
+}
+
+/*
+ *  @name   Reset
+ *  @fn     void Reset(void)
+ *  @brief  Drop every track, the next frame starts a new video
+ */
+template<typename T, template<typename U> class ProjType>
+void VideoPipeline<T, ProjType>::Reset(void) {
+  tracks_.clear();
+  n_frame_ = 0;
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ *  @name   Fit
+ *  @fn     void Fit(const PCAModel<T>& model, const Subset& landmarks,
+                     const Frame& frame, const size_t& frame_id,
+                     const NDArray* image, Result* result)
+ *  @brief  Fit the faces of one frame, in parallel, and update the tracks
+ *  @param[in] model      Shape model
+ *  @param[in] landmarks  Landmark sub-model
+ *  @param[in] frame      Frame to fit
+ *  @param[in] frame_id   Position of the frame since the last `Reset`
+ *  @param[in] image      Decoded frame
+ *  @param[out] result    Receives the fitted faces
+ */
+template<typename T, template<typename U> class ProjType>
+void VideoPipeline<T, ProjType>::Fit(const PCAModel<T>& model,
+                                     const Subset& landmarks,
+                                     const Frame& frame,
+                                     const size_t& frame_id,
+                                     const NDArray* image,
+                                     Result* result) {
+  FACEKIT_TRACE_SCOPE("VideoPipeline::Fit");
+  const int type = cv::DataType<T>::type;
+  const size_t n_face = frame.faces.size();
+  const T width = static_cast<T>(image->dim_size(1));
+  const T height = static_cast<T>(image->dim_size(0));
+  // Tracks are looked up sequentially, the faces are then independent
+  std::vector<Track*> tracks(n_face);
+  std::vector<uint8_t> warm(n_face, 0);
+  for (size_t k = 0; k < n_face; ++k) {
+    auto it = tracks_.find(frame.faces[k].id);
+    if (it == tracks_.end()) {
+      Track track;
+      track.camera.reset(new Cam(options_.focal > T(0.0) ?
+                                 options_.focal :
+                                 width,
+                                 width,
+                                 height));
+      it = tracks_.emplace(frame.faces[k].id, std::move(track)).first;
+    } else {
+      warm[k] = options_.tracking && it->second.valid &&
+                it->second.last + 1 == frame_id;
+    }
+    Track& track = it->second;
+    if (!warm[k] || track.coef.rows != options_.n_shape) {
+      // Start from the mean shape
+      if (options_.n_shape > 0) {
+        track.coef = cv::Mat::zeros(options_.n_shape, 1, type);
+      } else {
+        track.coef.release();
+      }
+    }
+    track.last = frame_id;
+    track.valid = true;
+    tracks[k] = &track;
+  }
+  // Forget the faces that left the video
+  for (auto it = tracks_.begin(); it != tracks_.end();) {
+    if (frame_id - it->second.last > options_.max_missed) {
+      it = tracks_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  result->faces.resize(n_face);
+  ThreadPool& pool = options_.pool ? *options_.pool : ThreadPool::Get();
+  pool.ParallelFor(0,
+                   n_face,
+                   kFitGrain,
+                   [&](const size_t& first, const size_t& last) {
+    cv::Mat pts(landmarks.mean.rows, 1, type);
+    for (size_t k = first; k < last; ++k) {
+      const Face& face = frame.faces[k];
+      Track& track = *tracks[k];
+      FaceFit& fit = result->faces[k];
+      FitOptions options = options_.fit;
+      options.warm_start = warm[k] != 0;
+      fit.id = face.id;
+      // Pose on the landmarks of the current shape, then refine both
+      ShapeLandmarks(model, landmarks, track.coef, &pts);
+      fit.status = track.camera->From3Dto2D(pts,
+                                            face.landmarks,
+                                            options,
+                                            &fit.summary);
+      if (options_.n_shape > 0 && fit.status != -2) {
+        fit.status = track.camera->FitShape(model,
+                                            landmarks,
+                                            face.landmarks,
+                                            options_.eta,
+                                            options_.eps,
+                                            &track.coef);
+        if (fit.status == -2) {
+          track.coef.setTo(T(0.0));
+        }
+        fit.coef = track.coef.clone();
+      }
+      if (fit.status == -2) {
+        // Diverged, next frame starts from scratch
+        track.valid = false;
+      }
+      track.camera->ToVector(fit.camera);
+    }
+  });
+}
+
+#pragma mark -
+#pragma mark Explicit Instantiation
+
+/** Float - Ortho */
+template class VideoPipeline<float, OrthographicProjection>;
+/** Double - Ortho */
+template class VideoPipeline<double, OrthographicProjection>;
+
+/** Float - Weak */
+template class VideoPipeline<float, WeakProjection>;
+/** Double - Weak */
+template class VideoPipeline<double, WeakProjection>;
+
+/** Float - Perspective */
+template class VideoPipeline<float, PerspectiveProjection>;
+/** Double - Perspective */
+template class VideoPipeline<double, PerspectiveProjection>;
+
+}  // namespace FaceKit
@@ -0,0 +1,415 @@
+/**
+ *  @file   bm_mesh.cpp
+ *  @brief Microbenchmark for Mesh I/O, normal computation, ray casting,
+ *         proximity queries, simplification and quantized storage
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   07.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "benchmark/benchmark.h"
+
+#include "facekit/core/math/fast_math.hpp"
+#include "facekit/core/sys/perf_counter.hpp"
+#include "facekit/geometry/bvh.hpp"
+#include "facekit/geometry/compact_mesh.hpp"
+#include "facekit/geometry/decimation.hpp"
+#include "facekit/geometry/laplacian.hpp"
+#include "facekit/geometry/point_query.hpp"
+#include "facekit/geometry/mesh.hpp"
+
+namespace FK = FaceKit;
+
+/**
+ *  @name   MakeSphere
+ *  @brief  Tessellate a unit sphere into `n` x `n` vertices, deterministic.
+ *  @param[in] n    Number of ring / segment
+ *  @param[out] mesh Generated mesh
+ */
+template<typename T>
+static void MakeSphere(const int n, FK::Mesh<T>* mesh) {
+  using Vertex = typename FK::Mesh<T>::Vertex;
+  using Triangle = typename FK::Mesh<T>::Triangle;
+  auto& vertex = mesh->get_vertex();
+  auto& tri = mesh->get_triangle();
+  vertex.clear();
+  tri.clear();
+  const T pi = T(3.14159265358979323846);
+  for (int r = 0; r < n; ++r) {
+    const T theta = pi * T(r + 1) / T(n + 1);
+    for (int s = 0; s < n; ++s) {
+      const T phi = T(2.0) * pi * T(s) / T(n);
+      vertex.emplace_back(Vertex(std::sin(theta) * std::cos(phi),
+                                 std::sin(theta) * std::sin(phi),
+                                 std::cos(theta)));
+    }
+  }
+  for (int r = 0; r < n - 1; ++r) {
+    for (int s = 0; s < n; ++s) {
+      const int a = r * n + s;
+      const int b = r * n + (s + 1) % n;
+      tri.emplace_back(Triangle(a, a + n, b));
+      tri.emplace_back(Triangle(b, a + n, b + n));
+    }
+  }
+}
+
+/**
+ *  @class  MeshFile
+ *  @brief  Sphere written once to `path`, removed when the benchmark ends
+ */
+class MeshFile {
+ public:
+  MeshFile(const int n, const std::string& path) : path_(path) {
+    FK::Mesh<float> mesh;
+    MakeSphere(n, &mesh);
+    ok_ = mesh.Save(path_) == 0;
+  }
+  ~MeshFile(void) {
+    std::remove(path_.c_str());
+  }
+  const std::string& path(void) const { return path_; }
+  bool ok(void) const { return ok_; }
+ private:
+  std::string path_;
+  bool ok_;
+};
+
+/** Load a sphere of `range(0)` x `range(0)` vertices from file */
+static void BM_MeshLoad(benchmark::State& state, const std::string& ext) {
+  const int n = static_cast<int>(state.range(0));
+  MeshFile file(n, "bm_mesh_fixture." + ext);
+  if (!file.ok()) {
+    state.SkipWithError(("Can not write fixture " + file.path()).c_str());
+    return;
+  }
+  FK::Mesh<float> mesh;
+  for (auto _ : state) {
+    if (mesh.Load(file.path()) != 0) {
+      state.SkipWithError(("Can not load " + file.path()).c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(mesh.get_vertex().data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n * n);
+}
+BENCHMARK_CAPTURE(BM_MeshLoad, obj, std::string("obj"))
+    ->Arg(64)->Arg(256)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_MeshLoad, ply, std::string("ply"))
+    ->Arg(64)->Arg(256)->Unit(benchmark::kMillisecond);
+
+/** Save a sphere of `range(0)` x `range(0)` vertices with normals */
+static void BM_MeshSave(benchmark::State& state, const std::string& ext) {
+  const int n = static_cast<int>(state.range(0));
+  const std::string path = "bm_mesh_save." + ext;
+  FK::Mesh<float> mesh;
+  MakeSphere(n, &mesh);
+  mesh.get_normal() = mesh.get_vertex();
+  for (auto _ : state) {
+    if (mesh.Save(path) != 0) {
+      state.SkipWithError(("Can not save " + path).c_str());
+      break;
+    }
+  }
+  std::remove(path.c_str());
+  state.SetItemsProcessed(int64_t(state.iterations()) * n * n);
+}
+BENCHMARK_CAPTURE(BM_MeshSave, obj, std::string("obj"))
+    ->Arg(64)->Arg(256)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_MeshSave, ply, std::string("ply"))
+    ->Arg(64)->Arg(256)->Unit(benchmark::kMillisecond);
+
+/** Vertex / triangle adjacency construction */
+static void BM_MeshBuildConnectivity(benchmark::State& state) {
+  const int n = static_cast<int>(state.range(0));
+  FK::Mesh<float> mesh;
+  MakeSphere(n, &mesh);
+  for (auto _ : state) {
+    mesh.BuildConnectivity();
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n * n);
+}
+BENCHMARK(BM_MeshBuildConnectivity)->Arg(64)->Arg(256)->Arg(1024);
+
+/**
+ *  Per-vertex normal computation with a given math policy, reports the
+ *  hardware counters of the calling thread when available
+ */
+template<typename T, typename Math>
+static void BM_MeshComputeVertexNormal(benchmark::State& state) {
+  const int n = static_cast<int>(state.range(0));
+  FK::Mesh<T> mesh;
+  MakeSphere(n, &mesh);
+  mesh.BuildConnectivity();
+  FK::PerfCounterRegion counters;
+  for (auto _ : state) {
+    mesh.template ComputeVertexNormal<Math>();
+    benchmark::DoNotOptimize(mesh.get_normal().data());
+  }
+  counters.Stop().Export(double(state.iterations()), &state.counters);
+  state.SetItemsProcessed(int64_t(state.iterations()) * n * n);
+}
+BENCHMARK_TEMPLATE(BM_MeshComputeVertexNormal, float, FK::PreciseMathPolicy)
+    ->Arg(64)->Arg(256);
+BENCHMARK_TEMPLATE(BM_MeshComputeVertexNormal, float, FK::FastMathPolicy)
+    ->Arg(64)->Arg(256);
+BENCHMARK_TEMPLATE(BM_MeshComputeVertexNormal, double, FK::PreciseMathPolicy)
+    ->Arg(64)->Arg(256);
+
+/**
+ *  Per-vertex normal computation from face normals, without connectivity.
+ *  Reports the hardware counters of the calling thread when available.
+ */
+template<typename T, typename FK::Mesh<T>::NormalWeighting W>
+static void BM_MeshComputeVertexNormalFromFaces(benchmark::State& state) {
+  const int n = static_cast<int>(state.range(0));
+  FK::Mesh<T> mesh;
+  MakeSphere(n, &mesh);
+  FK::PerfCounterRegion counters;
+  for (auto _ : state) {
+    mesh.ComputeVertexNormalFromFaces(W);
+    benchmark::DoNotOptimize(mesh.get_normal().data());
+  }
+  counters.Stop().Export(double(state.iterations()), &state.counters);
+  state.SetItemsProcessed(int64_t(state.iterations()) * n * n);
+}
+BENCHMARK_TEMPLATE(BM_MeshComputeVertexNormalFromFaces, float,
+                   FK::Mesh<float>::kAngleWeighting)->Arg(64)->Arg(256);
+BENCHMARK_TEMPLATE(BM_MeshComputeVertexNormalFromFaces, float,
+                   FK::Mesh<float>::kAreaWeighting)->Arg(64)->Arg(256);
+
+/** Normals and tangents in one pass over the faces */
+template<typename T>
+static void BM_MeshComputeTangentSpace(benchmark::State& state) {
+  const int n = static_cast<int>(state.range(0));
+  FK::Mesh<T> mesh;
+  MakeSphere(n, &mesh);
+  auto& tcoord = mesh.get_tex_coord();
+  for (const auto& v : mesh.get_vertex()) {
+    tcoord.emplace_back(std::atan2(v.y_, v.x_), v.z_);
+  }
+  for (auto _ : state) {
+    mesh.ComputeTangentSpace();
+    benchmark::DoNotOptimize(mesh.get_tangent().data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n * n);
+}
+BENCHMARK_TEMPLATE(BM_MeshComputeTangentSpace, float)->Arg(64)->Arg(256);
+
+/** Bounding box and centroid reduction */
+template<typename T>
+static void BM_MeshComputeBoundingBox(benchmark::State& state) {
+  const int n = static_cast<int>(state.range(0));
+  FK::Mesh<T> mesh;
+  MakeSphere(n, &mesh);
+  typename FK::Mesh<T>::Vertex centroid;
+  for (auto _ : state) {
+    mesh.ComputeBoundingBox(&centroid);
+    benchmark::DoNotOptimize(centroid);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n * n);
+}
+BENCHMARK_TEMPLATE(BM_MeshComputeBoundingBox, float)->Arg(256)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_MeshComputeBoundingBox, double)->Arg(256)->Arg(1024);
+
+/**
+ *  Quantized storage, decoding of a full mesh (positions and normals) vs
+ *  copying the same data in full precision
+ */
+static void BM_CompactMeshDecode(benchmark::State& state) {
+  const int n = static_cast<int>(state.range(0));
+  const bool compact = state.range(1) != 0;
+  FK::Mesh<float> mesh;
+  MakeSphere(n, &mesh);
+  mesh.BuildConnectivity();
+  mesh.ComputeVertexNormal();
+  FK::CompactMesh<float> storage;
+  storage.Encode(mesh);
+  FK::Mesh<float> out;
+  for (auto _ : state) {
+    if (compact) {
+      storage.Decode(&out);
+    } else {
+      out.get_vertex() = mesh.get_vertex();
+      out.get_normal() = mesh.get_normal();
+    }
+    benchmark::DoNotOptimize(out.get_vertex().data());
+  }
+  const size_t n_vert = mesh.get_vertex().size();
+  state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n_vert));
+  state.counters["bytes_per_vertex"] = (compact ?
+                                        storage.memory() / n_vert :
+                                        6 * sizeof(float));
+}
+BENCHMARK(BM_CompactMeshDecode)->Args({512, 1})->Args({512, 0});
+
+/** Triangle and vertex reordering */
+static void BM_MeshOptimizeLayout(benchmark::State& state) {
+  const int n = static_cast<int>(state.range(0));
+  std::vector<int> order;
+  for (auto _ : state) {
+    state.PauseTiming();
+    FK::Mesh<float> mesh;
+    MakeSphere(n, &mesh);
+    state.ResumeTiming();
+    mesh.OptimizeLayout(FK::Mesh<float>::kFirstUseLayout, &order);
+    benchmark::DoNotOptimize(order.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n * n);
+}
+BENCHMARK(BM_MeshOptimizeLayout)->Arg(64)->Arg(256)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ *  Interleaved vertex buffer, all vertices or one block modified, stored in
+ *  single or half precision (unit sphere, fits half precision)
+ */
+static void BM_MeshUpdateVertexBuffer(benchmark::State& state) {
+  using Format = FK::VertexBuffer::Format;
+  const int n = static_cast<int>(state.range(0));
+  const bool full = state.range(1) != 0;
+  const Format format = (state.range(2) != 0 ?
+                         FK::VertexBuffer::kFloat16 :
+                         FK::VertexBuffer::kFloat32);
+  FK::Mesh<float> mesh;
+  MakeSphere(n, &mesh);
+  mesh.BuildConnectivity();
+  mesh.ComputeVertexNormal();
+  mesh.UpdateVertexBuffer(format, format);
+  const size_t n_vert = mesh.get_vertex().size();
+  for (auto _ : state) {
+    mesh.MarkDirty(full ? 0 : n_vert / 2, full ? n_vert : n_vert / 2 + 1024);
+    benchmark::DoNotOptimize(mesh.UpdateVertexBuffer(format, format).data());
+  }
+  state.counters["bytes_per_vertex"] = mesh.get_vertex_buffer().stride();
+}
+BENCHMARK(BM_MeshUpdateVertexBuffer)->Args({512, 1, 0})->Args({512, 0, 0})
+    ->Args({512, 1, 1});
+
+/** Level of detail chain, 10x fewer vertices per level */
+static void BM_MeshDecimatorLOD(benchmark::State& state) {
+  const int n = static_cast<int>(state.range(0));
+  FK::Mesh<float> mesh;
+  MakeSphere(n, &mesh);
+  FK::MeshDecimator<float> decimator;
+  std::vector<FK::MeshDecimator<float>::Level> lod;
+  for (auto _ : state) {
+    decimator.BuildLOD(mesh, 3, 10.f, &lod);
+    benchmark::DoNotOptimize(lod.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n * n);
+}
+BENCHMARK(BM_MeshDecimatorLOD)->Arg(64)->Arg(256)
+    ->Unit(benchmark::kMillisecond);
+
+/** Cotangent Laplacian, full build or refresh after one moved block */
+static void BM_MeshLaplacian(benchmark::State& state) {
+  const int n = static_cast<int>(state.range(0));
+  const bool full = state.range(1) != 0;
+  FK::Mesh<float> mesh;
+  MakeSphere(n, &mesh);
+  mesh.BuildConnectivity();
+  FK::MeshLaplacian<float> laplacian;
+  laplacian.Build(mesh);
+  const size_t n_vert = mesh.get_vertex().size();
+  for (auto _ : state) {
+    if (full) {
+      laplacian.Build(mesh);
+    } else {
+      laplacian.MarkDirty(n_vert / 2, n_vert / 2 + 1024);
+      laplacian.Update(mesh);
+    }
+    benchmark::DoNotOptimize(laplacian.matrix().values().data());
+  }
+}
+BENCHMARK(BM_MeshLaplacian)->Args({512, 1})->Args({512, 0});
+
+/** BVH construction */
+static void BM_BVHBuild(benchmark::State& state) {
+  const int n = static_cast<int>(state.range(0));
+  FK::Mesh<float> mesh;
+  MakeSphere(n, &mesh);
+  FK::BVH<float> bvh;
+  for (auto _ : state) {
+    bvh.Build(mesh);
+    benchmark::DoNotOptimize(bvh.n_node());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) *
+                          int64_t(mesh.get_triangle().size()));
+}
+BENCHMARK(BM_BVHBuild)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+/** Ray casting from random points toward the sphere's center, one by one or
+ as a batch */
+static void BM_BVHIntersect(benchmark::State& state) {
+  const int n = static_cast<int>(state.range(0));
+  const bool batch = state.range(1) != 0;
+  FK::Mesh<float> mesh;
+  MakeSphere(n, &mesh);
+  FK::BVH<float> bvh;
+  bvh.Build(mesh);
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-2.f, 2.f);
+  std::vector<FK::BVH<float>::Ray> rays(1 << 14);
+  for (auto& r : rays) {
+    r.org = FK::Vector3<float>(dist(gen), dist(gen), dist(gen));
+    r.dir = FK::Vector3<float>(dist(gen), dist(gen), dist(gen)) * 0.1f -
+            r.org;
+  }
+  std::vector<FK::BVH<float>::Hit> hits(rays.size());
+  for (auto _ : state) {
+    if (batch) {
+      bvh.Intersect(rays, &hits);
+    } else {
+      for (size_t k = 0; k < rays.size(); ++k) {
+        bvh.Intersect(rays[k], &hits[k]);
+      }
+    }
+    benchmark::DoNotOptimize(hits.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) *
+                          int64_t(rays.size()));
+}
+BENCHMARK(BM_BVHIntersect)->Args({256, 0})->Args({256, 1})
+    ->Args({1024, 0})->Args({1024, 1});
+
+/** Closest point on the surface and 8 nearest vertices of random points
+ close to the surface, as scan points during registration */
+static void BM_PointQuery(benchmark::State& state) {
+  const int n = static_cast<int>(state.range(0));
+  const bool closest = state.range(1) != 0;
+  FK::Mesh<float> mesh;
+  MakeSphere(n, &mesh);
+  FK::PointQuery<float> query;
+  query.Build(mesh);
+  std::mt19937 gen(0);
+  std::normal_distribution<float> dir;
+  std::uniform_real_distribution<float> radius(0.95f, 1.05f);
+  std::vector<FK::Vector3<float>> pts(1 << 14);
+  for (auto& p : pts) {
+    p = FK::Vector3<float>(dir(gen), dir(gen), dir(gen));
+    p *= radius(gen) / p.Norm();
+  }
+  std::vector<FK::PointQuery<float>::Closest> res;
+  std::vector<int> index;
+  std::vector<float> sq_dist;
+  for (auto _ : state) {
+    if (closest) {
+      query.ClosestPoint(pts, &res);
+      benchmark::DoNotOptimize(res.data());
+    } else {
+      query.KNearestVertex(pts, 8, &index, &sq_dist);
+      benchmark::DoNotOptimize(index.data());
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(pts.size()));
+}
+BENCHMARK(BM_PointQuery)->Args({256, 1})->Args({256, 0})
+    ->Args({1024, 1})->Args({1024, 0});
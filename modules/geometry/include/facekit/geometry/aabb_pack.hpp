@@ -0,0 +1,223 @@
+/**
+ *  @file   aabb_pack.hpp
+ *  @brief  Structure of arrays packs of axis aligned bounding boxes and rays
+ *          with branchless slab tests
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   28.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_AABB_PACK__
+#define __FACEKIT_AABB_PACK__
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "facekit/geometry/aabb.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  AABBPack
+ *  @brief  `N` bounding boxes stored as structure of arrays, tested against
+ *          a single ray at once. Unset lanes never report a hit.
+ *  @author Christophe Ecabert
+ *  @date   28.10.18
+ *  @ingroup geometry
+ *  @tparam T Data type
+ *  @tparam N Number of boxes
+ */
+template<typename T, int N>
+class AABBPack {
+ public:
+
+  /**
+   *  @name AABBPack
+   *  @fn AABBPack(void)
+   *  @brief  Constructor, every lane is unset
+   */
+  AABBPack(void) {
+    this->Clear();
+  }
+
+  /**
+   *  @name Clear
+   *  @fn void Clear(void)
+   *  @brief  Unset every lane
+   */
+  void Clear(void) {
+    for (int k = 0; k < 3; ++k) {
+      std::fill(min_[k], min_[k] + N, T(0.0));
+      std::fill(max_[k], max_[k] + N, T(0.0));
+    }
+    valid_ = 0;
+  }
+
+  /**
+   *  @name Set
+   *  @fn void Set(const int& lane, const T* min, const T* max)
+   *  @brief  Set the box of a given lane
+   *  @param[in] lane Lane index
+   *  @param[in] min  Minimum corner (x, y, z)
+   *  @param[in] max  Maximum corner (x, y, z)
+   */
+  void Set(const int& lane, const T* min, const T* max) {
+    for (int k = 0; k < 3; ++k) {
+      min_[k][lane] = min[k];
+      max_[k][lane] = max[k];
+    }
+    valid_ |= 1u << lane;
+  }
+
+  /**
+   *  @name Set
+   *  @fn void Set(const int& lane, const AABB<T>& box)
+   *  @brief  Set the box of a given lane
+   *  @param[in] lane Lane index
+   *  @param[in] box  Bounding box
+   */
+  void Set(const int& lane, const AABB<T>& box) {
+    this->Set(lane, &box.min_.x_, &box.max_.x_);
+  }
+
+  /**
+   *  @name Intersect
+   *  @fn uint32_t Intersect(const T* org, const T* inv_dir, const T& t_max,
+                             T* t_near) const
+   *  @brief  Slab test of one ray against every box
+   *  @param[in] org      Ray origin (x, y, z)
+   *  @param[in] inv_dir  Inverse of the ray direction, must be finite (i.e.
+   *                      large value for null components)
+   *  @param[in] t_max    Maximum distance along the ray
+   *  @param[out] t_near  Entry distance of each box
+   *  @return Bit mask of the boxes hit within [0, t_max]
+   */
+  uint32_t Intersect(const T* org,
+                     const T* inv_dir,
+                     const T& t_max,
+                     T* t_near) const {
+    T t_far[N];
+    for (int l = 0; l < N; ++l) {
+      t_near[l] = T(0.0);
+      t_far[l] = t_max;
+    }
+    for (int k = 0; k < 3; ++k) {
+      for (int l = 0; l < N; ++l) {
+        const T t0 = (min_[k][l] - org[k]) * inv_dir[k];
+        const T t1 = (max_[k][l] - org[k]) * inv_dir[k];
+        t_near[l] = std::max(t_near[l], std::min(t0, t1));
+        t_far[l] = std::min(t_far[l], std::max(t0, t1));
+      }
+    }
+    uint32_t mask = 0;
+    for (int l = 0; l < N; ++l) {
+      mask |= static_cast<uint32_t>(t_near[l] <= t_far[l]) << l;
+    }
+    return mask & valid_;
+  }
+
+  /** Minimum corners, per axis */
+  alignas(16) T min_[3][N];
+  /** Maximum corners, per axis */
+  alignas(16) T max_[3][N];
+  /** Bit mask of the lanes set */
+  uint32_t valid_;
+};
+
+#if defined(__SSE2__) || defined(_M_X64)
+/*
+ *  @name Intersect
+ *  @fn uint32_t Intersect(const float* org, const float* inv_dir,
+                           const float& t_max, float* t_near) const
+ *  @brief  Slab test of one ray against four boxes, SSE2 version
+ */
+template<>
+inline uint32_t AABBPack<float, 4>::Intersect(const float* org,
+                                              const float* inv_dir,
+                                              const float& t_max,
+                                              float* t_near) const {
+  __m128 t_in = _mm_setzero_ps();
+  __m128 t_out = _mm_set1_ps(t_max);
+  for (int k = 0; k < 3; ++k) {
+    const __m128 o = _mm_set1_ps(org[k]);
+    const __m128 inv = _mm_set1_ps(inv_dir[k]);
+    const __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(min_[k]), o), inv);
+    const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(max_[k]), o), inv);
+    t_in = _mm_max_ps(t_in, _mm_min_ps(t0, t1));
+    t_out = _mm_min_ps(t_out, _mm_max_ps(t0, t1));
+  }
+  _mm_storeu_ps(t_near, t_in);
+  return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(t_in, t_out))) &
+         valid_;
+}
+#endif
+
+/** Four single precision boxes */
+using AABB4 = AABBPack<float, 4>;
+/** Eight single precision boxes */
+using AABB8 = AABBPack<float, 8>;
+
+/**
+ *  @class  RayPack
+ *  @brief  `N` rays stored as structure of arrays, tested against a single
+ *          box at once
+ *  @author Christophe Ecabert
+ *  @date   28.10.18
+ *  @ingroup geometry
+ *  @tparam T Data type
+ *  @tparam N Number of rays
+ */
+template<typename T, int N>
+class RayPack {
+ public:
+
+  /**
+   *  @name Intersect
+   *  @fn uint32_t Intersect(const T* min, const T* max) const
+   *  @brief  Slab test of every ray against one box
+   *  @param[in] min  Minimum corner (x, y, z)
+   *  @param[in] max  Maximum corner (x, y, z)
+   *  @return Bit mask of the rays hitting the box within [0, t_max]
+   */
+  uint32_t Intersect(const T* min, const T* max) const {
+    // Lanes are tested in a branchless loop, the mask is assembled afterward
+    // so the loop vectorizes
+    int hit[N];
+    for (int l = 0; l < N; ++l) {
+      T t_near = T(0.0);
+      T t_far = t_max_[l];
+      for (int k = 0; k < 3; ++k) {
+        const T t0 = (min[k] - org_[k][l]) * inv_dir_[k][l];
+        const T t1 = (max[k] - org_[k][l]) * inv_dir_[k][l];
+        t_near = std::max(t_near, std::min(t0, t1));
+        t_far = std::min(t_far, std::max(t0, t1));
+      }
+      hit[l] = static_cast<int>(t_near <= t_far);
+    }
+    uint32_t mask = 0;
+    for (int l = 0; l < N; ++l) {
+      mask |= static_cast<uint32_t>(hit[l]) << l;
+    }
+    return mask;
+  }
+
+  /** Origins, per axis */
+  alignas(16) T org_[3][N];
+  /** Inverse directions, per axis, must be finite */
+  alignas(16) T inv_dir_[3][N];
+  /** Maximum distances, negative for inactive rays */
+  alignas(16) T t_max_[N];
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_AABB_PACK__ */
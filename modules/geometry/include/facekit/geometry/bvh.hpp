@@ -0,0 +1,282 @@
+/**
+ *  @file   bvh.hpp
+ *  @brief  Bounding volume hierarchy over the triangles of a mesh, used for
+ *          ray casting (i.e. visibility, landmark projection)
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   26.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_BVH__
+#define __FACEKIT_BVH__
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/math/vector.hpp"
+#include "facekit/geometry/aabb.hpp"
+#include "facekit/geometry/aabb_pack.hpp"
+#include "facekit/geometry/mesh.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Forward declaration */
+template<typename T>
+class PointQuery;
+
+/**
+ *  @class  BVH
+ *  @brief  Binary tree of axis aligned bounding boxes over the triangles of
+ *          a mesh. Built top-down with binned surface area heuristic (SAH),
+ *          large nodes are binned and split in parallel. Nodes are stored
+ *          depth-first in a flat array: the first child of an inner node
+ *          directly follows it, leaves reference a contiguous range of
+ *          triangles stored in leaf order. The binary tree is collapsed into
+ *          a 4-wide tree for single ray queries, the four children boxes of
+ *          a node are tested at once.
+ *  @author Christophe Ecabert
+ *  @date   26.10.18
+ *  @ingroup geometry
+ */
+template<typename T>
+class FK_EXPORTS BVH {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /**
+   *  @struct Options
+   *  @brief  Construction parameters
+   */
+  struct Options {
+    /** Maximum number of triangles in a leaf */
+    size_t max_leaf_size = 4;
+    /** Cost of visiting a node relative to a ray / triangle test */
+    T traversal_cost = T(1.0);
+  };
+
+  /**
+   *  @struct Ray
+   *  @brief  Ray `org + t * dir` with t in [0, t_max]
+   */
+  struct Ray {
+    /** Origin */
+    Vector3<T> org;
+    /** Direction, does not need to be normalized */
+    Vector3<T> dir;
+    /** Maximum distance, in units of `dir` */
+    T t_max = std::numeric_limits<T>::max();
+  };
+
+  /**
+   *  @struct Hit
+   *  @brief  Closest intersection of a ray
+   */
+  struct Hit {
+    /** Index of the triangle in the mesh, -1 if nothing is hit */
+    int tri = -1;
+    /** Position along the ray */
+    T t = T(0.0);
+    /** Barycentric coordinates, point = (1 - u - v) * A + u * B + v * C */
+    T u = T(0.0);
+    /** Barycentric coordinates */
+    T v = T(0.0);
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name BVH
+   *  @fn BVH(void)
+   *  @brief  Constructor
+   */
+  BVH(void) = default;
+
+  /**
+   *  @name Build
+   *  @fn int Build(const Mesh<T>& mesh)
+   *  @brief  Build the hierarchy with default options
+   *  @param[in] mesh Mesh to index, its triangles are copied
+   *  @return -1 if error, 0 otherwise
+   */
+  int Build(const Mesh<T>& mesh) {
+    return this->Build(mesh, Options());
+  }
+
+  /**
+   *  @name Build
+   *  @fn int Build(const Mesh<T>& mesh, const Options& options)
+   *  @brief  Build the hierarchy
+   *  @param[in] mesh     Mesh to index, its triangles are copied
+   *  @param[in] options  Construction parameters
+   *  @return -1 if error, 0 otherwise
+   */
+  int Build(const Mesh<T>& mesh, const Options& options);
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name Intersect
+   *  @fn bool Intersect(const Ray& ray, Hit* hit) const
+   *  @brief  Find the closest triangle hit by a ray, both faces are
+   *          considered
+   *  @param[in] ray  Ray to cast
+   *  @param[out] hit Closest intersection
+   *  @return True if a triangle is hit
+   */
+  bool Intersect(const Ray& ray, Hit* hit) const;
+
+  /**
+   *  @name Intersect
+   *  @fn void Intersect(const std::vector<Ray>& rays,
+                         std::vector<Hit>* hits) const
+   *  @brief  Cast a batch of rays in parallel. Rays are traversed in packets
+   *          of consecutive rays, coherent rays (i.e. shared origin, close
+   *          directions) should be stored next to each other.
+   *  @param[in] rays Rays to cast
+   *  @param[out] hits Closest intersection of each ray
+   */
+  void Intersect(const std::vector<Ray>& rays, std::vector<Hit>* hits) const;
+
+  /**
+   *  @name Occluded
+   *  @fn bool Occluded(const Ray& ray) const
+   *  @brief  Check if a ray hits any triangle, stops at the first one found
+   *  @param[in] ray  Ray to cast
+   *  @return True if a triangle is hit
+   */
+  bool Occluded(const Ray& ray) const;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name n_node
+   *  @fn size_t n_node(void) const
+   *  @brief  Number of nodes in the tree
+   */
+  size_t n_node(void) const {
+    return nodes_.size();
+  }
+
+  /**
+   *  @name bbox
+   *  @fn AABB<T> bbox(void) const
+   *  @brief  Bounding box of the indexed triangles
+   */
+  AABB<T> bbox(void) const;
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Point queries traverse the same tree */
+  friend class PointQuery<T>;
+
+  /**
+   *  @struct Node
+   *  @brief  Flattened node, 32 bytes in single precision
+   */
+  struct Node {
+    /** Minimum corner */
+    T min[3];
+    /** Maximum corner */
+    T max[3];
+    /** Leaf: first triangle, inner node: index of the second child */
+    int32_t offset;
+    /** Leaf: number of triangles, inner node: -1 - split axis */
+    int32_t count;
+  };
+
+  /**
+   *  @struct Triangle
+   *  @brief  Triangle stored for intersection, first vertex and edges
+   */
+  struct Triangle {
+    /** First vertex */
+    Vector3<T> v0;
+    /** Edge v0 -> v1 */
+    Vector3<T> e1;
+    /** Edge v0 -> v2 */
+    Vector3<T> e2;
+  };
+
+  /**
+   *  @struct WideNode
+   *  @brief  Node of the 4-wide tree
+   */
+  struct WideNode {
+    /** Children bounds */
+    AABBPack<T, 4> box;
+    /** Leaf: first triangle, inner node: index of the child */
+    int32_t child[4];
+    /** Leaf: number of triangles, inner node: 0 */
+    int32_t count[4];
+  };
+
+  /** Construction state, see bvh.cpp */
+  struct BuildContext;
+
+  /**
+   *  @name BuildRange
+   *  @fn void BuildRange(BuildContext* ctx, const size_t& first,
+                          const size_t& last, const size_t& depth,
+                          const AABB<T>& box, const AABB<T>& center,
+                          std::vector<Node>* nodes) const
+   *  @brief  Build the subtree over primitives [first, last), appended to
+   *          `nodes`
+   *  @param[in] ctx    Construction state
+   *  @param[in] first  First primitive
+   *  @param[in] last   Past-the-end primitive
+   *  @param[in] depth  Depth of the subtree's root
+   *  @param[in] box    Bounds of the primitives
+   *  @param[in] center Bounds of the primitives' centers
+   *  @param[out] nodes Nodes
+   */
+  void BuildRange(BuildContext* ctx,
+                  const size_t& first,
+                  const size_t& last,
+                  const size_t& depth,
+                  const AABB<T>& box,
+                  const AABB<T>& center,
+                  std::vector<Node>* nodes) const;
+
+  /**
+   *  @name Collapse
+   *  @fn int32_t Collapse(const int32_t& node)
+   *  @brief  Convert the binary subtree rooted at inner node `node` into
+   *          wide nodes, appended to `wide_`
+   *  @return Index of the wide node
+   */
+  int32_t Collapse(const int32_t& node);
+
+  /**
+   *  @name IntersectPacket
+   *  @fn void IntersectPacket(const Ray* rays, const size_t& n,
+                               Hit* hits) const
+   *  @brief  Cast up to `kPacketSize` rays together
+   */
+  void IntersectPacket(const Ray* rays, const size_t& n, Hit* hits) const;
+
+  /** Nodes, depth-first */
+  std::vector<Node> nodes_;
+  /** 4-wide nodes, root first */
+  std::vector<WideNode> wide_;
+  /** Triangles in leaf order */
+  std::vector<Triangle> tri_;
+  /** Index in the mesh of each triangle in `tri_` */
+  std::vector<int> tri_index_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_BVH__ */
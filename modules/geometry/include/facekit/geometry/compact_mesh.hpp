@@ -0,0 +1,209 @@
+/**
+ *  @file   compact_mesh.hpp
+ *  @brief  Quantized copy of the per-vertex data of a mesh, for large
+ *          collections of instances
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_COMPACT_MESH__
+#define __FACEKIT_COMPACT_MESH__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/geometry/mesh.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  CompactMesh
+ *  @brief  Storage of a mesh with quantized per-vertex data, to keep many
+ *          fitted instances in memory or stream them through a batch at a
+ *          fraction of the bandwidth:
+ *            - Positions on 16 bits per axis, relative to the bounding box.
+ *            - Normals octahedral encoded on 2 x 16 bits.
+ *            - Colors on 8 bits per channel.
+ *          With single precision that is 14 bytes per vertex instead of 40.
+ *          The topology (triangulation, texture coordinates, connectivity)
+ *          is shared with the encoded mesh, not copied, so instances of a
+ *          model keep a single one. Tangents are not stored. Decoding is
+ *          vectorized with SSE2 when available.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup geometry
+ */
+template<typename T>
+class FK_EXPORTS CompactMesh {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /** Vertex */
+  using Vertex = typename Mesh<T>::Vertex;
+  /** Normal */
+  using Normal = typename Mesh<T>::Normal;
+  /** Vertex color */
+  using Color = typename Mesh<T>::Color;
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name CompactMesh
+   *  @fn CompactMesh(void)
+   *  @brief  Constructor, empty mesh
+   */
+  CompactMesh(void);
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name Encode
+   *  @fn int Encode(const Mesh<T>& mesh)
+   *  @brief  Quantize the vertices, normals and colors of \p mesh and share
+   *          its topology. Normals and colors are optional but must match
+   *          the number of vertices when present.
+   *  @param[in] mesh Mesh to encode
+   *  @return -1 if error, 0 otherwise
+   */
+  int Encode(const Mesh<T>& mesh);
+
+  /**
+   *  @name Decode
+   *  @fn void Decode(Mesh<T>* mesh) const
+   *  @brief  Restore a full precision mesh, sharing the encoded topology.
+   *          Tangents are cleared and every vertex is marked dirty.
+   *  @param[out] mesh  Decoded mesh
+   */
+  void Decode(Mesh<T>* mesh) const;
+
+  /**
+   *  @name DecodeVertex
+   *  @fn void DecodeVertex(const size_t& first, const size_t& last,
+                            Vertex* vertex) const
+   *  @brief  Decode the positions of vertices [first, last)
+   *  @param[in] first  First vertex
+   *  @param[in] last   Past-the-end vertex
+   *  @param[out] vertex  Decoded positions, `last - first` elements
+   */
+  void DecodeVertex(const size_t& first,
+                    const size_t& last,
+                    Vertex* vertex) const;
+
+  /**
+   *  @name DecodeNormal
+   *  @fn void DecodeNormal(const size_t& first, const size_t& last,
+                            Normal* normal) const
+   *  @brief  Decode the unit normals of vertices [first, last)
+   *  @param[in] first  First vertex
+   *  @param[in] last   Past-the-end vertex
+   *  @param[out] normal  Decoded normals, `last - first` elements
+   */
+  void DecodeNormal(const size_t& first,
+                    const size_t& last,
+                    Normal* normal) const;
+
+  /**
+   *  @name DecodeColor
+   *  @fn void DecodeColor(const size_t& first, const size_t& last,
+                           Color* color) const
+   *  @brief  Decode the colors of vertices [first, last)
+   *  @param[in] first  First vertex
+   *  @param[in] last   Past-the-end vertex
+   *  @param[out] color Decoded colors, `last - first` elements
+   */
+  void DecodeColor(const size_t& first,
+                   const size_t& last,
+                   Color* color) const;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name n_vertex
+   *  @fn size_t n_vertex(void) const
+   *  @brief  Number of vertices
+   */
+  size_t n_vertex(void) const {
+    return position_.size() / 3;
+  }
+
+  /**
+   *  @name has_normal
+   *  @fn bool has_normal(void) const
+   *  @brief  Indicate if normals are stored
+   */
+  bool has_normal(void) const {
+    return !normal_.empty();
+  }
+
+  /**
+   *  @name has_color
+   *  @fn bool has_color(void) const
+   *  @brief  Indicate if colors are stored
+   */
+  bool has_color(void) const {
+    return !color_.empty();
+  }
+
+  /**
+   *  @name step
+   *  @fn const T* step(void) const
+   *  @brief  Quantization step of each axis, the position error is at most
+   *          half of it
+   */
+  const T* step(void) const {
+    return step_;
+  }
+
+  /**
+   *  @name memory
+   *  @fn size_t memory(void) const
+   *  @brief  Bytes used by the quantized per-vertex data
+   */
+  size_t memory(void) const {
+    return (position_.capacity() * sizeof(uint16_t) +
+            normal_.capacity() * sizeof(int16_t) +
+            color_.capacity() * sizeof(uint8_t));
+  }
+
+  /**
+   *  @name topology
+   *  @fn const Mesh<T>& topology(void) const
+   *  @brief  Mesh without vertices holding the shared topology
+   */
+  const Mesh<T>& topology(void) const {
+    return topology_;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Position of the quantized origin, bounding box's minimum */
+  T origin_[3];
+  /** Quantization step of each axis */
+  T step_[3];
+  /** Quantized positions [3N] */
+  std::vector<uint16_t> position_;
+  /** Octahedral encoded normals [2N], empty if none */
+  std::vector<int16_t> normal_;
+  /** RGBA colors [4N], empty if none */
+  std::vector<uint8_t> color_;
+  /** Holder of the shared topology */
+  Mesh<T> topology_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_COMPACT_MESH__ */
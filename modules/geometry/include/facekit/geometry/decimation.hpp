@@ -0,0 +1,181 @@
+/**
+ *  @file   decimation.hpp
+ *  @brief  Mesh simplification with quadric error metric and level of
+ *          detail generation
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   30.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_DECIMATION__
+#define __FACEKIT_DECIMATION__
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/geometry/mesh.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  MeshDecimator
+ *  @brief  Simplify a mesh by successive half-edge collapses ordered by a
+ *          quadric error metric. Quadrics are built over positions and, when
+ *          available per vertex, texture coordinates and colors (Garland &
+ *          Heckbert, 1998) so attribute seams are preserved as well.
+ *          Collapses keep one of the edge's endpoints, therefore every
+ *          simplified mesh is made of a subset of the original vertices and
+ *          the levels of detail are nested. The index of the original
+ *          vertices is returned with each level, per-vertex data (i.e.
+ *          statistical model, landmarks) can be subsampled accordingly.
+ *  @author Christophe Ecabert
+ *  @date   30.10.18
+ *  @ingroup geometry
+ */
+template<typename T>
+class FK_EXPORTS MeshDecimator {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /**
+   *  @struct Options
+   *  @brief  Simplification parameters
+   */
+  struct Options {
+    /** Weight of texture coordinates and colors relative to positions,
+        which are normalized by the bounding box diagonal. 0 ignores them */
+    T attribute_weight = T(1.0);
+    /** Weight of the constraint keeping open boundaries in place */
+    T boundary_weight = T(100.0);
+    /** Minimum cosine between the normal of a face before and after a
+        collapse, prevents folds */
+    T min_normal_cos = T(0.2);
+    /** Maximum error of a collapse, simplification stops beyond it. Squared
+        distance relative to the bounding box diagonal */
+    T max_error = std::numeric_limits<T>::max();
+    /** Vertices that are never removed (i.e. landmarks) */
+    std::vector<int> preserved;
+  };
+
+  /**
+   *  @struct Level
+   *  @brief  Simplified mesh
+   */
+  struct Level {
+    /** Mesh */
+    Mesh<T> mesh;
+    /** Index in the original mesh of each vertex */
+    std::vector<int> vertex_index;
+    /** Largest collapse error reached */
+    T error = T(0.0);
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name MeshDecimator
+   *  @fn MeshDecimator(void)
+   *  @brief  Constructor with default options
+   */
+  MeshDecimator(void) = default;
+
+  /**
+   *  @name MeshDecimator
+   *  @fn explicit MeshDecimator(const Options& options)
+   *  @brief  Constructor
+   *  @param[in] options  Simplification parameters
+   */
+  explicit MeshDecimator(const Options& options) : options_(options) {}
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name Decimate
+   *  @fn int Decimate(const Mesh<T>& mesh, const size_t& n_vertex,
+                       Level* level) const
+   *  @brief  Simplify a mesh down to a given number of vertices
+   *  @param[in] mesh     Mesh to simplify
+   *  @param[in] n_vertex Target number of vertices, can be larger in the
+   *                      end if no valid collapse remains or `max_error` is
+   *                      reached
+   *  @param[out] level   Simplified mesh
+   *  @return -1 if error, 0 otherwise
+   */
+  int Decimate(const Mesh<T>& mesh, const size_t& n_vertex, Level* level) const;
+
+  /**
+   *  @name BuildLOD
+   *  @fn int BuildLOD(const Mesh<T>& mesh, const size_t& n_level,
+                       const T& factor, std::vector<Level>* lod) const
+   *  @brief  Generate a chain of nested levels of detail in a single
+   *          simplification run. Level 0 is the original mesh, level `k`
+   *          has `factor^k` times fewer vertices.
+   *  @param[in] mesh     Mesh to simplify
+   *  @param[in] n_level  Number of levels, including the original mesh
+   *  @param[in] factor   Reduction factor between two levels, > 1
+   *  @param[out] lod     Levels, finest first
+   *  @return -1 if error, 0 otherwise
+   */
+  int BuildLOD(const Mesh<T>& mesh,
+               const size_t& n_level,
+               const T& factor,
+               std::vector<Level>* lod) const;
+
+  /**
+   *  @name BuildLOD
+   *  @fn int BuildLOD(const Mesh<T>& mesh,
+                       const std::vector<size_t>& n_vertex,
+                       std::vector<Level>* lod) const
+   *  @brief  Generate nested levels of detail with explicit vertex counts
+   *  @param[in] mesh     Mesh to simplify
+   *  @param[in] n_vertex Target number of vertices of each level, in
+   *                      decreasing order
+   *  @param[out] lod     Levels, same order as `n_vertex`
+   *  @return -1 if error, 0 otherwise
+   */
+  int BuildLOD(const Mesh<T>& mesh,
+               const std::vector<size_t>& n_vertex,
+               std::vector<Level>* lod) const;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name options
+   *  @fn const Options& options(void) const
+   *  @brief  Simplification parameters
+   */
+  const Options& options(void) const {
+    return options_;
+  }
+
+  /**
+   *  @name options
+   *  @fn Options& options(void)
+   *  @brief  Simplification parameters
+   */
+  Options& options(void) {
+    return options_;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Simplification parameters */
+  Options options_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_DECIMATION__ */
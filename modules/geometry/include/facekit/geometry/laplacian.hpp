@@ -0,0 +1,198 @@
+/**
+ *  @file   laplacian.hpp
+ *  @brief  Discrete Laplace-Beltrami operator of a triangle mesh
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   01.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_LAPLACIAN__
+#define __FACEKIT_LAPLACIAN__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/math/sparse_matrix.hpp"
+#include "facekit/geometry/mesh.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  MeshLaplacian
+ *  @brief  Build the Laplacian of a mesh as a sparse CSR matrix together with
+ *          the lumped (barycentric) mass of each vertex. The matrix is the
+ *          positive semi-definite stiffness matrix L = D - W, where W holds
+ *          the edge weights and D their row sums, therefore `M + lambda * L`
+ *          is symmetric positive definite and can be solved with
+ *          `ConjugateGradient` (i.e. implicit smoothing, regularisation).
+ *          The sparsity pattern follows the mesh connectivity and is built
+ *          once, cotangent weights are cached per triangle and only the
+ *          triangles touching vertices flagged with `MarkDirty` are
+ *          recomputed by `Update`.
+ *  @author Christophe Ecabert
+ *  @date   01.11.18
+ *  @ingroup geometry
+ */
+template<typename T>
+class FK_EXPORTS MeshLaplacian {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /**
+   *  @enum Weighting
+   *  @brief  Edge weights
+   */
+  enum Weighting {
+    /** Graph Laplacian, every edge weights 1 */
+    kUniformWeighting = 0,
+    /** Half sum of the cotangents of the angles facing the edge */
+    kCotangentWeighting
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name MeshLaplacian
+   *  @fn explicit MeshLaplacian(const Weighting& weighting =
+                                 kCotangentWeighting)
+   *  @brief  Constructor
+   *  @param[in] weighting  Edge weights
+   */
+  explicit MeshLaplacian(const Weighting& weighting = kCotangentWeighting) :
+          weighting_(weighting) {}
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name Build
+   *  @fn int Build(const Mesh<T>& mesh)
+   *  @brief  Build the sparsity pattern from the mesh connectivity and
+   *          compute every weight. `Mesh::BuildConnectivity` must have been
+   *          called.
+   *  @param[in] mesh Mesh
+   *  @return -1 if error, 0 otherwise
+   */
+  int Build(const Mesh<T>& mesh);
+
+  /**
+   *  @name MarkDirty
+   *  @fn void MarkDirty(const size_t& first, const size_t& last)
+   *  @brief  Flag vertices [first, last) as moved, their weights are
+   *          recomputed by the next `Update`
+   *  @param[in] first  First modified vertex
+   *  @param[in] last   Past-the-end modified vertex
+   */
+  void MarkDirty(const size_t& first, const size_t& last);
+
+  /**
+   *  @name Update
+   *  @fn int Update(const Mesh<T>& mesh)
+   *  @brief  Refresh the weights of the triangles touching a dirty vertex
+   *          and the rows they contribute to, the sparsity pattern is
+   *          kept. Falls back to `Build` if the mesh size changed.
+   *  @param[in] mesh Mesh, with the same topology as in `Build`
+   *  @return -1 if error, 0 otherwise
+   */
+  int Update(const Mesh<T>& mesh);
+
+  /**
+   *  @name System
+   *  @fn int System(const T& lambda, SparseMatrix<T>* a) const
+   *  @brief  Assemble `M + lambda * L`, sharing the sparsity pattern of the
+   *          Laplacian. Positive definite for `lambda >= 0` as long as every
+   *          vertex belongs to a non-degenerate triangle.
+   *  @param[in] lambda Weight of the Laplacian
+   *  @param[out] a     System matrix, its pattern is reused if it matches
+   *  @return -1 if error, 0 otherwise
+   */
+  int System(const T& lambda, SparseMatrix<T>* a) const;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name matrix
+   *  @fn const SparseMatrix<T>& matrix(void) const
+   *  @brief  Laplacian, n_vertex x n_vertex
+   */
+  const SparseMatrix<T>& matrix(void) const {
+    return laplacian_;
+  }
+
+  /**
+   *  @name mass
+   *  @fn const std::vector<T>& mass(void) const
+   *  @brief  Lumped mass, a third of the area of the incident triangles
+   */
+  const std::vector<T>& mass(void) const {
+    return mass_;
+  }
+
+  /**
+   *  @name weighting
+   *  @fn const Weighting& weighting(void) const
+   *  @brief  Edge weights in use
+   */
+  const Weighting& weighting(void) const {
+    return weighting_;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+
+  /**
+   *  @name ComputeTriangles
+   *  @fn void ComputeTriangles(const Mesh<T>& mesh,
+                                const std::vector<int>& tri)
+   *  @brief  Compute the cached weights and area of a list of triangles,
+   *          all of them if `tri` is empty
+   */
+  void ComputeTriangles(const Mesh<T>& mesh, const std::vector<int>& tri);
+
+  /**
+   *  @name AssembleRows
+   *  @fn void AssembleRows(const Mesh<T>& mesh,
+                            const std::vector<int>& row)
+   *  @brief  Gather the cached triangle data into a list of rows, all of
+   *          them if `row` is empty
+   */
+  void AssembleRows(const Mesh<T>& mesh, const std::vector<int>& row);
+
+  /** Edge weights */
+  Weighting weighting_;
+  /** Laplacian */
+  SparseMatrix<T> laplacian_;
+  /** Lumped mass */
+  std::vector<T> mass_;
+  /** Per triangle: weight of the edge facing each corner, then area */
+  std::vector<T> tri_data_;
+  /** Per entry of the mesh's `vertex_tri`: position in the row's values of
+      the two other corners of the triangle, following the winding */
+  std::vector<int> slot_;
+  /** Dirty flag of each block of vertices */
+  std::vector<uint8_t> dirty_;
+  /** Last update each triangle was collected in */
+  std::vector<uint32_t> tri_stamp_;
+  /** Last update each row was collected in */
+  std::vector<uint32_t> row_stamp_;
+  /** Current update */
+  uint32_t stamp_ = 0;
+  /** Number of triangles at build time */
+  size_t n_tri_ = 0;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_LAPLACIAN__ */
@@ -11,11 +11,14 @@
 #ifndef __FACEKIT_MESH__
 #define __FACEKIT_MESH__
 
+#include <cstdint>
 #include <vector>
 
 #include "facekit/core/library_export.hpp"
+#include "facekit/core/refcounter.hpp"
 #include "facekit/core/math/vector.hpp"
 #include "facekit/geometry/aabb.hpp"
+#include "facekit/geometry/vertex_buffer.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -48,11 +51,89 @@ class FK_EXPORTS Mesh {
   using TCoord = Vector2<T>;
   /** Vertex color */
   using Color = Vector4<T>;
-  /** Tangente space */
-  using Tangent = Vector3<T>;
+  /** Tangent space, unit tangent and handedness of the bitangent in w */
+  using Tangent = Vector4<T>;
   /** Triangle */
   using Triangle = Vector3<int>;
 
+  /**
+   *  @enum   NormalWeighting
+   *  @brief  Weighting of face contributions in vertex normals
+   */
+  enum NormalWeighting {
+    /** Angle of the face at the vertex */
+    kAngleWeighting,
+    /** Area of the face */
+    kAreaWeighting
+  };
+
+  /**
+   *  @enum   VertexLayout
+   *  @brief  Vertex ordering used by `OptimizeLayout`
+   */
+  enum VertexLayout {
+    /** Order of first use by the reordered triangles */
+    kFirstUseLayout,
+    /** Morton (Z-order) curve over the bounding box */
+    kMortonLayout
+  };
+
+  /**
+   *  @class  Topology
+   *  @brief  Data shared by meshes with the same structure (i.e. instances
+   *          of a statistical model): triangulation, texture coordinates and
+   *          connectivity. Reference counted, shared topologies are never
+   *          modified, a mesh copies its topology before changing it.
+   */
+  class Topology : public RefCounter {
+   public:
+    /**
+     *  @name Topology
+     *  @fn Topology(void)
+     *  @brief  Constructor
+     */
+    Topology(void) = default;
+
+    /**
+     *  @name Clone
+     *  @fn Topology* Clone(void) const
+     *  @brief  Deep copy, with a reference count of one
+     */
+    Topology* Clone(void) const {
+      Topology* topo = new Topology();
+      topo->tex_coord_ = tex_coord_;
+      topo->tri_ = tri_;
+      topo->vertex_con_offset_ = vertex_con_offset_;
+      topo->vertex_con_ = vertex_con_;
+      topo->vertex_tri_offset_ = vertex_tri_offset_;
+      topo->vertex_tri_ = vertex_tri_;
+      return topo;
+    }
+
+    /** Texture coordinate */
+    std::vector<TCoord> tex_coord_;
+    /** Triangulation */
+    std::vector<Triangle> tri_;
+    /** Connectivity - start of each vertex's neighbours in `vertex_con_`,
+     n_vertex + 1 elements */
+    std::vector<size_t> vertex_con_offset_;
+    /** Connectivity - neighbouring vertices, sorted per vertex */
+    std::vector<int> vertex_con_;
+    /** Connectivity - start of each vertex's triangles in `vertex_tri_`,
+     n_vertex + 1 elements */
+    std::vector<size_t> vertex_tri_offset_;
+    /** Connectivity - triangles incident to each vertex, sorted per vertex */
+    std::vector<int> vertex_tri_;
+
+   protected:
+    /**
+     *  @name ~Topology
+     *  @fn ~Topology(void) override
+     *  @brief  Destructor, released through `Dec`
+     */
+    ~Topology(void) override = default;
+  };
+
 #pragma mark -
 #pragma mark Initialization
 
@@ -74,19 +155,37 @@ class FK_EXPORTS Mesh {
 
   /**
    *  @name Mesh
-   *  @fn Mesh(const Mesh<T>& other) = delete
-   *  @brief  Copy constructor
+   *  @fn Mesh(const Mesh<T>& other)
+   *  @brief  Copy constructor, per-vertex data is copied and the topology is
+   *          shared
    *  @param[in]  other Mesh to copy from
    */
-  Mesh(const Mesh<T>& other) = delete;
+  Mesh(const Mesh<T>& other);
+
+  /**
+   *  @name Mesh
+   *  @fn Mesh(Mesh<T>&& other)
+   *  @brief  Move constructor, `other` is left empty
+   *  @param[in]  other Mesh to move from
+   */
+  Mesh(Mesh<T>&& other);
 
   /**
    *  @name operator=
-   *  @fn Mesh& operator=(const Mesh& rhs) = delete
-   *  @brief  Assignment operator
+   *  @fn Mesh& operator=(const Mesh& rhs)
+   *  @brief  Assignment operator, per-vertex data is copied and the topology
+   *          is shared
    *  @param[in]  rhs   Mesh to assign from
    */
-  Mesh& operator=(const Mesh<T>& rhs) = delete;
+  Mesh& operator=(const Mesh<T>& rhs);
+
+  /**
+   *  @name operator=
+   *  @fn Mesh& operator=(Mesh&& rhs)
+   *  @brief  Move assignment operator, `rhs` is left empty
+   *  @param[in]  rhs   Mesh to move from
+   */
+  Mesh& operator=(Mesh<T>&& rhs);
 
   /**
    *  @name ~Mesh
@@ -98,7 +197,9 @@ class FK_EXPORTS Mesh {
   /**
    *  @name Load
    *  @fn virtual int Load(const std::string& filename)
-   *  @brief  Load mesh from supported file : .obj, .ply
+   *  @brief  Load mesh from supported file : .obj, .ply, .fkm. Meshes
+   *          stored as .fkm are loaded as saved (no recentering) with their
+   *          connectivity.
    *  @param[in]  filename  Path to the mesh file
    *  @return -1 if error, 0 otherwise
    */
@@ -107,7 +208,7 @@ class FK_EXPORTS Mesh {
   /**
    *  @name Save
    *  @fn virtual int Save(const std::string& filename)
-   *  @brief  Save mesh to supported file format: .ply/.obj
+   *  @brief  Save mesh to supported file format: .ply/.obj/.fkm
    *  @return -1 if error, 0 otherwise
    */
   int Save(const std::string& filename);
@@ -115,27 +216,160 @@ class FK_EXPORTS Mesh {
   /**
    *  @name BuildConnectivity
    *  @fn void BuildConnectivity(void)
-   *  @brief  Construct vertex connectivity (vertex connection) used later
-   *          in normal computation
+   *  @brief  Construct vertex connectivity (neighbouring vertices and
+   *          incident triangles) stored as compressed rows, used later in
+   *          normal computation
    */
   void BuildConnectivity(void);
 
+  /**
+   *  @name OptimizeLayout
+   *  @fn void OptimizeLayout(const VertexLayout& layout,
+                              std::vector<int>* vertex_order)
+   *  @brief  Reorder triangles for vertex cache reuse (Forsyth's linear-speed
+   *          optimizer) then vertices for locality. Every per-vertex
+   *          attribute is permuted and connectivity is rebuilt if present.
+   *  @param[in] layout         Vertex ordering
+   *  @param[out] vertex_order  Permutation applied, `vertex_order[new]` is
+   *                            the previous index of vertex `new`. Can be
+   *                            used to reorder data tied to the vertices
+   *                            (i.e. `PCAModel::ReorderVertex`)
+   */
+  void OptimizeLayout(const VertexLayout& layout,
+                      std::vector<int>* vertex_order);
+
+  /**
+   *  @name ShareTopology
+   *  @fn void ShareTopology(const Mesh<T>& other)
+   *  @brief  Use the topology of another mesh, per-vertex data is kept (i.e.
+   *          instance generated from a model with the model's topology)
+   *  @param[in] other  Mesh holding the topology
+   */
+  void ShareTopology(const Mesh<T>& other);
+
+  /**
+   *  @name SharesTopology
+   *  @fn bool SharesTopology(const Mesh<T>& other) const
+   *  @brief  Indicate if two meshes use the same topology object
+   *  @param[in] other  Mesh to compare with
+   *  @return True if the topology is shared
+   */
+  bool SharesTopology(const Mesh<T>& other) const {
+    return topo_ == other.topo_;
+  }
+
 #pragma mark -
 #pragma mark Usage
 
   /**
    *  @name ComputeVertexNormal
-   *  @fn void ComputeVertexNormal(void)
+   *  @fn template<typename Math> void ComputeVertexNormal(void)
    *  @brief  Compute normal for each vertex in the object
+   *  @tparam Math  Math policy, `FastMathPolicy` approximates normalization
+   *                and angle weighting (Available: `PreciseMathPolicy`,
+   *                `FastMathPolicy`)
    */
+  template<typename Math = PreciseMathPolicy>
   void ComputeVertexNormal(void);
 
+  /**
+   *  @name ComputeVertexNormalFromFaces
+   *  @fn template<typename Math> void ComputeVertexNormalFromFaces(
+                                          const NormalWeighting& weighting)
+   *  @brief  Compute normal for each vertex without connectivity. Each face
+   *          normal is computed once then added to its three vertices.
+   *          Degenerate faces do not contribute.
+   *  @param[in] weighting  Weighting of face contributions
+   *  @tparam Math  Math policy (Available: `PreciseMathPolicy`,
+   *                `FastMathPolicy`)
+   */
+  template<typename Math = PreciseMathPolicy>
+  void ComputeVertexNormalFromFaces(const NormalWeighting& weighting =
+                                    kAngleWeighting);
+
+  /**
+   *  @name ComputeTangentSpace
+   *  @fn template<typename Math> void ComputeTangentSpace(
+                                          const NormalWeighting& weighting)
+   *  @brief  Compute normal and tangent for each vertex in a single sweep
+   *          over the faces, reusing each face's normal and corner weights.
+   *          Follows MikkTSpace conventions: unit face tangents (dP/du)
+   *          weighted like the normals, orthogonalized against the vertex
+   *          normal, with the bitangent given by
+   *          `w * cross(normal, tangent)`. Texture coordinates can be given
+   *          per vertex or per face corner. Without them only normals are
+   *          computed and tangents are cleared.
+   *  @param[in] weighting  Weighting of face contributions
+   *  @tparam Math  Math policy (Available: `PreciseMathPolicy`,
+   *                `FastMathPolicy`)
+   */
+  template<typename Math = PreciseMathPolicy>
+  void ComputeTangentSpace(const NormalWeighting& weighting = kAngleWeighting);
+
   /**
    *  @name ComputeBoundingBox
-   *  @fn void ComputeBoundingBox(void)
-   *  @brief  Compute the bounding box of the mesh
+   *  @fn void ComputeBoundingBox(Vertex* centroid = nullptr)
+   *  @brief  Compute the bounding box of the mesh, and optionally the
+   *          centroid of its vertices, in a single parallel pass
+   *  @param[out] centroid  If not null, mean of the vertices
+   */
+  void ComputeBoundingBox(Vertex* centroid = nullptr);
+
+  /**
+   *  @name MarkDirty
+   *  @fn void MarkDirty(const size_t& first, const size_t& last)
+   *  @brief  Flag vertices [first, last) as modified (i.e. deformation),
+   *          picked up by `UpdateNormals`, `UpdateBoundingBox` and
+   *          `UpdateVertexBuffer`
+   *  @param[in] first  First modified vertex
+   *  @param[in] last   Past-the-end modified vertex
    */
-  void ComputeBoundingBox(void);
+  void MarkDirty(const size_t& first, const size_t& last);
+
+  /**
+   *  @name UpdateNormals
+   *  @fn template<typename Math> void UpdateNormals(void)
+   *  @brief  Recompute the normal of vertices sharing a face with a dirty
+   *          vertex, requires connectivity. Falls back to
+   *          `ComputeVertexNormal` if normals are not available.
+   *  @tparam Math  Math policy (Available: `PreciseMathPolicy`,
+   *                `FastMathPolicy`)
+   */
+  template<typename Math = PreciseMathPolicy>
+  void UpdateNormals(void);
+
+  /**
+   *  @name UpdateBoundingBox
+   *  @fn void UpdateBoundingBox(void)
+   *  @brief  Update the bounding box, only blocks of vertices holding dirty
+   *          vertices are visited
+   */
+  void UpdateBoundingBox(void);
+
+  /**
+   *  @name UpdateVertexBuffer
+   *  @fn const VertexBuffer& UpdateVertexBuffer(
+                const VertexBuffer::Format& position_format =
+                                                    VertexBuffer::kFloat32,
+                const VertexBuffer::Format& attribute_format =
+                                                    VertexBuffer::kFloat32)
+   *  @brief  Refresh the interleaved vertex buffer holding positions and,
+   *          when available for every vertex, normals, texture coordinates
+   *          and colors. Only blocks of vertices flagged by `MarkDirty` (or
+   *          whose normal changed in `UpdateNormals`) are repacked, the
+   *          whole buffer is rebuilt when the layout, the formats or the
+   *          number of vertices change.
+   *  @param[in] position_format  Storage of the positions, half precision
+   *                              keeps 11 significant bits and is meant for
+   *                              normalized meshes
+   *  @param[in] attribute_format Storage of normals, texture coordinates and
+   *                              colors, half precision halves their size
+   *  @return Interleaved buffer
+   */
+  const VertexBuffer& UpdateVertexBuffer(
+          const VertexBuffer::Format& position_format = VertexBuffer::kFloat32,
+          const VertexBuffer::Format& attribute_format =
+                                                      VertexBuffer::kFloat32);
 
 #pragma mark -
 #pragma mark Accessors
@@ -188,7 +422,7 @@ class FK_EXPORTS Mesh {
    *  @return Texture coordinate array
    */
   const std::vector<TCoord>& get_tex_coord(void) const {
-    return tex_coord_;
+    return topo_->tex_coord_;
   }
   
   /**
@@ -215,11 +449,13 @@ class FK_EXPORTS Mesh {
   /**
    *  @name get_tex_coord
    *  @fn std::vector<TCoord>& get_tex_coord(void)
-   *  @brief  Give reference to internal texture coordinate storage.
+   *  @brief  Give reference to internal texture coordinate storage. A shared
+   *          topology is copied first.
    *  @return Texture coordinate array
    */
   std::vector<TCoord>& get_tex_coord(void) {
-    return tex_coord_;
+    this->Detach();
+    return topo_->tex_coord_;
   }
 
   /**
@@ -251,18 +487,71 @@ class FK_EXPORTS Mesh {
    *  @return Triangle array
    */
   const std::vector<Triangle>& get_triangle(void) const {
-    return tri_;
+    return topo_->tri_;
   }
 
   /**
    *  @name get_triangle
    *  @fn std::vector<Triangle>& get_triangle(void)
-   *  @brief  Give reference to internal triangulation storage, can not be
-   *          modified.
+   *  @brief  Give reference to internal triangulation storage. A shared
+   *          topology is copied first.
    *  @return Triangle array
    */
   std::vector<Triangle>& get_triangle(void) {
-    return tri_;
+    this->Detach();
+    return topo_->tri_;
+  }
+
+  /**
+   *  @name get_vertex_con_offset
+   *  @fn const std::vector<size_t>& get_vertex_con_offset(void) const
+   *  @brief  Start of each vertex's neighbours in `get_vertex_con`,
+   *          `n_vertex + 1` entries. Empty until `BuildConnectivity`.
+   *  @return Neighbour offsets
+   */
+  const std::vector<size_t>& get_vertex_con_offset(void) const {
+    return topo_->vertex_con_offset_;
+  }
+
+  /**
+   *  @name get_vertex_con
+   *  @fn const std::vector<int>& get_vertex_con(void) const
+   *  @brief  Neighbouring vertices, sorted per vertex
+   *  @return Neighbours
+   */
+  const std::vector<int>& get_vertex_con(void) const {
+    return topo_->vertex_con_;
+  }
+
+  /**
+   *  @name get_vertex_tri_offset
+   *  @fn const std::vector<size_t>& get_vertex_tri_offset(void) const
+   *  @brief  Start of each vertex's triangles in `get_vertex_tri`,
+   *          `n_vertex + 1` entries. Empty until `BuildConnectivity`.
+   *  @return Incident triangle offsets
+   */
+  const std::vector<size_t>& get_vertex_tri_offset(void) const {
+    return topo_->vertex_tri_offset_;
+  }
+
+  /**
+   *  @name get_vertex_tri
+   *  @fn const std::vector<int>& get_vertex_tri(void) const
+   *  @brief  Triangles incident to each vertex, sorted per vertex
+   *  @return Incident triangles
+   */
+  const std::vector<int>& get_vertex_tri(void) const {
+    return topo_->vertex_tri_;
+  }
+
+  /**
+   *  @name get_vertex_buffer
+   *  @fn const VertexBuffer& get_vertex_buffer(void) const
+   *  @brief  Interleaved vertex buffer as of the last `UpdateVertexBuffer`
+   *  @return Interleaved buffer
+   */
+  const VertexBuffer& get_vertex_buffer(void) const {
+    return vertex_buffer_;
   }
 
   /**
@@ -289,31 +578,54 @@ class FK_EXPORTS Mesh {
     kObj,
     /** .ply */
     kPly,
+    /** .fkm, native binary format */
+    kFkm
   };
 
   /** Vertex */
   std::vector<Vertex> vertex_;
   /** Normal */
   std::vector<Normal> normal_;
-  /** Texture coordinate */
-  std::vector<TCoord> tex_coord_;
   /** Tangent coordinate */
   std::vector<Tangent> tangent_;
   /** Vertex color */
   std::vector<Color> vertex_color_;
-  /** Triangulation */
-  std::vector<Triangle> tri_;
-  /** Connectivity - vertex interconnection */
-  std::vector<std::vector<int>> vertex_con_;
+  /** Triangulation, texture coordinates and connectivity, never null */
+  RefPtr<Topology> topo_;
   /** Boundary box */
   AABB<T> bbox_;
   /** Wether or not the bounding box has been computed already or not */
   bool bbox_is_computed_;
+  /** Bounding box of each block of vertices */
+  std::vector<AABB<T>> block_bbox_;
+  /** Blocks of vertices whose normals are outdated */
+  std::vector<uint8_t> normal_dirty_;
+  /** Blocks of vertices whose bounding box is outdated */
+  std::vector<uint8_t> bbox_dirty_;
+  /** Interleaved copy of the per-vertex data */
+  VertexBuffer vertex_buffer_;
+  /** Blocks of vertices outdated in `vertex_buffer_`, empty if the whole
+      buffer needs to be rebuilt */
+  std::vector<uint8_t> buffer_dirty_;
   
 #pragma mark -
 #pragma mark Private
 private:
 
+  /**
+   *  @name EmptyTopology
+   *  @fn static RefPtr<Topology> EmptyTopology(void)
+   *  @brief  Topology shared by empty meshes, a new reference is returned
+   */
+  static RefPtr<Topology> EmptyTopology(void);
+
+  /**
+   *  @name Detach
+   *  @fn void Detach(void)
+   *  @brief  Copy the topology if it is shared, called before modifying it
+   */
+  void Detach(void);
+
   /**
    *  @name HashExt
    *  @fn FileExt HashExt(const std::string& ext)
@@ -335,7 +647,7 @@ private:
   /**
    *  @name SaveOBJ
    *  @fn int SaveOBJ(const std::string path) const
-   *  @brief SAve mesh to a .obj file
+   *  @brief  Save mesh to a .obj file, elements are formatted concurrently
    *  @param[in]  path  Path to .obj file
    *  @return -1 if error, 0 otherwise
    */
@@ -350,21 +662,69 @@ private:
    */
   int LoadPLY(const std::string& path);
 
+  /**
+   *  @name LoadBinaryPLY
+   *  @fn bool LoadBinaryPLY(const char* data, const size_t& length,
+                             int* error)
+   *  @brief  Bulk load of a binary .ply file stored in the host byte order
+   *          with scalar vertex properties and list face properties
+   *  @param[in]  data    File content
+   *  @param[in]  length  File size in bytes
+   *  @param[out] error   -1 if error, 0 otherwise
+   *  @return False if the file is not supported and must go through the
+   *          generic reader
+   */
+  bool LoadBinaryPLY(const char* data, const size_t& length, int* error);
+
   /**
    *  @name SavePLY
    *  @fn int SavePLY(const std::string path) const
-   *  @brief SAve mesh to a .ply file
+   *  @brief Save mesh to a binary .ply file in the host byte order, written
+   *         in bulk
    *  @param[in]  path  Path to .ply file
    *  @return -1 if error, 0 otherwise
    */
   int SavePLY(const std::string& path) const;
+
+  /**
+   *  @name LoadFKM
+   *  @fn int LoadFKM(const std::string& path)
+   *  @brief  Load mesh from native binary .fkm file, arrays are copied in
+   *          bulk from the mapped file
+   *  @param[in]  path  Path to .fkm file
+   *  @return -1 if error, 0 otherwise
+   */
+  int LoadFKM(const std::string& path);
+
+  /**
+   *  @name SaveFKM
+   *  @fn int SaveFKM(const std::string& path) const
+   *  @brief  Save mesh to native binary .fkm file: versioned header with
+   *          bounding box followed by 64 bytes aligned vertex, normal,
+   *          texture coordinate, triangle and connectivity arrays
+   *  @param[in]  path  Path to .fkm file
+   *  @return -1 if error, 0 otherwise
+   */
+  int SaveFKM(const std::string& path) const;
   
   /**
    *  @name   PlaceToOrigin
    *  @fn     void PlaceToOrigin(void)
    *  @brief  Place mest to world origin (i.e. remove center of graviaty).
+   *          The bounding box is computed along the way.
    */
   void PlaceToOrigin(void);
+
+  /**
+   *  @name   VertexNormal
+   *  @fn     template<typename Math> Normal VertexNormal(const size_t& v) const
+   *  @brief  Angle weighted normal of a vertex, from its incident triangles
+   *  @param[in] v  Vertex index
+   *  @tparam Math  Math policy
+   *  @return Normal
+   */
+  template<typename Math>
+  Normal VertexNormal(const size_t& v) const;
 };
 
 }  // namespace FaceKit
@@ -0,0 +1,227 @@
+/**
+ *  @file   point_query.hpp
+ *  @brief  Proximity queries against a mesh: closest point on the surface,
+ *          nearest vertices and vertices within a radius
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   27.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_POINT_QUERY__
+#define __FACEKIT_POINT_QUERY__
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/math/vector.hpp"
+#include "facekit/geometry/bvh.hpp"
+#include "facekit/geometry/mesh.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  PointQuery
+ *  @brief  Spatial index of a mesh answering proximity queries. Closest
+ *          points on the surface are found by traversing the triangle `BVH`
+ *          ordered by box distance, vertex queries (k nearest, radius) use a
+ *          balanced k-d tree over the vertices. Every query has a batched
+ *          version running in parallel.
+ *  @author Christophe Ecabert
+ *  @date   27.10.18
+ *  @ingroup geometry
+ */
+template<typename T>
+class FK_EXPORTS PointQuery {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /**
+   *  @struct Closest
+   *  @brief  Closest point on the surface
+   */
+  struct Closest {
+    /** Index of the triangle in the mesh, -1 if nothing is found */
+    int tri = -1;
+    /** Barycentric coordinates, point = (1 - u - v) * A + u * B + v * C */
+    T u = T(0.0);
+    /** Barycentric coordinates */
+    T v = T(0.0);
+    /** Closest point */
+    Vector3<T> point;
+    /** Squared distance to the query */
+    T sq_dist = std::numeric_limits<T>::max();
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name PointQuery
+   *  @fn PointQuery(void)
+   *  @brief  Constructor
+   */
+  PointQuery(void) = default;
+
+  /**
+   *  @name Build
+   *  @fn int Build(const Mesh<T>& mesh)
+   *  @brief  Index the triangles and vertices of a mesh, they are copied
+   *  @param[in] mesh Mesh to index
+   *  @return -1 if error, 0 otherwise
+   */
+  int Build(const Mesh<T>& mesh);
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name ClosestPoint
+   *  @fn bool ClosestPoint(const Vector3<T>& p, Closest* res,
+                  const T& max_dist = std::numeric_limits<T>::max()) const
+   *  @brief  Find the closest point on the surface
+   *  @param[in] p        Query point
+   *  @param[out] res     Closest point
+   *  @param[in] max_dist Search radius, the search stops early beyond it
+   *  @return True if a point is found within `max_dist`
+   */
+  bool ClosestPoint(const Vector3<T>& p,
+                    Closest* res,
+                    const T& max_dist = std::numeric_limits<T>::max()) const;
+
+  /**
+   *  @name ClosestPoint
+   *  @fn void ClosestPoint(const std::vector<Vector3<T>>& pts,
+                            std::vector<Closest>* res,
+                  const T& max_dist = std::numeric_limits<T>::max()) const
+   *  @brief  Find the closest point on the surface of a batch of points, in
+   *          parallel
+   *  @param[in] pts      Query points
+   *  @param[out] res     Closest point of each query
+   *  @param[in] max_dist Search radius
+   */
+  void ClosestPoint(const std::vector<Vector3<T>>& pts,
+                    std::vector<Closest>* res,
+                    const T& max_dist = std::numeric_limits<T>::max()) const;
+
+  /**
+   *  @name KNearestVertex
+   *  @fn void KNearestVertex(const Vector3<T>& p, const size_t& k,
+                              std::vector<int>* index,
+                              std::vector<T>* sq_dist) const
+   *  @brief  Find the `k` vertices closest to a point
+   *  @param[in] p        Query point
+   *  @param[in] k        Number of neighbours
+   *  @param[out] index   Vertex indices sorted by increasing distance, fewer
+   *                      than `k` if the mesh is smaller
+   *  @param[out] sq_dist Squared distances
+   */
+  void KNearestVertex(const Vector3<T>& p,
+                      const size_t& k,
+                      std::vector<int>* index,
+                      std::vector<T>* sq_dist) const;
+
+  /**
+   *  @name KNearestVertex
+   *  @fn void KNearestVertex(const std::vector<Vector3<T>>& pts,
+                              const size_t& k, std::vector<int>* index,
+                              std::vector<T>* sq_dist) const
+   *  @brief  Find the `k` vertices closest to a batch of points, in parallel
+   *  @param[in] pts      Query points
+   *  @param[in] k        Number of neighbours
+   *  @param[out] index   Row-major `pts.size()` x `k` vertex indices, padded
+   *                      with -1 if the mesh is smaller
+   *  @param[out] sq_dist Squared distances, same layout
+   */
+  void KNearestVertex(const std::vector<Vector3<T>>& pts,
+                      const size_t& k,
+                      std::vector<int>* index,
+                      std::vector<T>* sq_dist) const;
+
+  /**
+   *  @name RadiusVertex
+   *  @fn void RadiusVertex(const Vector3<T>& p, const T& radius,
+                            std::vector<int>* index,
+                            std::vector<T>* sq_dist) const
+   *  @brief  Find the vertices within a given distance of a point
+   *  @param[in] p        Query point
+   *  @param[in] radius   Search radius
+   *  @param[out] index   Vertex indices sorted by increasing distance
+   *  @param[out] sq_dist Squared distances
+   */
+  void RadiusVertex(const Vector3<T>& p,
+                    const T& radius,
+                    std::vector<int>* index,
+                    std::vector<T>* sq_dist) const;
+
+  /**
+   *  @name RadiusVertex
+   *  @fn void RadiusVertex(const std::vector<Vector3<T>>& pts,
+                            const T& radius,
+                            std::vector<std::vector<int>>* index,
+                            std::vector<std::vector<T>>* sq_dist) const
+   *  @brief  Find the vertices within a given distance of a batch of points,
+   *          in parallel
+   *  @param[in] pts      Query points
+   *  @param[in] radius   Search radius
+   *  @param[out] index   Vertex indices of each query
+   *  @param[out] sq_dist Squared distances of each query
+   */
+  void RadiusVertex(const std::vector<Vector3<T>>& pts,
+                    const T& radius,
+                    std::vector<std::vector<int>>* index,
+                    std::vector<std::vector<T>>* sq_dist) const;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name bvh
+   *  @fn const BVH<T>& bvh(void) const
+   *  @brief  Triangle hierarchy, can be used for ray casting as well
+   */
+  const BVH<T>& bvh(void) const {
+    return bvh_;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+
+  /**
+   *  @name Search
+   *  @fn template<typename Visitor> void Search(const Vector3<T>& p,
+                                                 const size_t& first,
+                                                 const size_t& last,
+                                                 Visitor* visitor) const
+   *  @brief  Visit the vertices of the k-d tree node [first, last) near
+   *          side first, subtrees farther than the visitor's radius are
+   *          skipped
+   */
+  template<typename Visitor>
+  void Search(const Vector3<T>& p,
+              const size_t& first,
+              const size_t& last,
+              Visitor* visitor) const;
+
+  /** Triangle hierarchy */
+  BVH<T> bvh_;
+  /** Vertices in k-d tree order */
+  std::vector<Vector3<T>> vertex_;
+  /** Index in the mesh of each vertex in `vertex_` */
+  std::vector<int> vertex_index_;
+  /** Split axis of the k-d tree node whose median is at a given position */
+  std::vector<uint8_t> axis_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_POINT_QUERY__ */
@@ -0,0 +1,285 @@
+/**
+ *  @file   vertex_buffer.hpp
+ *  @brief  Interleaved single or half precision vertex buffer, ready to be
+ *          uploaded to the GPU
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   31.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_VERTEX_BUFFER__
+#define __FACEKIT_VERTEX_BUFFER__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  VertexBuffer
+ *  @brief  Per-vertex attributes interleaved in a single aligned block.
+ *          Each vertex spans `stride` bytes (multiple of 16), the position
+ *          and component format (float or IEEE 754 half) of each attribute
+ *          in it is given by the layout.
+ *  @author Christophe Ecabert
+ *  @date   31.10.18
+ *  @ingroup geometry
+ */
+class FK_EXPORTS VertexBuffer {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /**
+   *  @enum Semantic
+   *  @brief  Meaning of an attribute
+   */
+  enum Semantic {
+    /** Position, 3 components */
+    kPosition = 0,
+    /** Normal, 3 components */
+    kNormal,
+    /** Texture coordinate, 2 components */
+    kTexCoord,
+    /** Color, 4 components */
+    kColor
+  };
+
+  /**
+   *  @enum Format
+   *  @brief  Storage of an attribute's components
+   */
+  enum Format {
+    /** Single precision, 4 bytes */
+    kFloat32 = 0,
+    /** IEEE 754 half precision, 2 bytes */
+    kFloat16
+  };
+
+  /**
+   *  @struct Attribute
+   *  @brief  Layout descriptor of one attribute
+   */
+  struct Attribute {
+    /** Meaning */
+    Semantic semantic;
+    /** Offset in bytes from the start of a vertex */
+    uint32_t offset;
+    /** Number of components */
+    uint32_t size;
+    /** Components' storage */
+    Format format;
+
+    /** Equality */
+    bool operator==(const Attribute& rhs) const {
+      return semantic == rhs.semantic && offset == rhs.offset &&
+             size == rhs.size && format == rhs.format;
+    }
+  };
+
+  /**
+   *  @name FormatSize
+   *  @fn static uint32_t FormatSize(const Format& format)
+   *  @brief  Size of a component in bytes
+   */
+  static uint32_t FormatSize(const Format& format) {
+    return format == kFloat16 ? 2 : 4;
+  }
+
+  /** Alignment of the buffer in bytes */
+  static constexpr size_t kAlignment = 64;
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name VertexBuffer
+   *  @fn VertexBuffer(void)
+   *  @brief  Constructor, empty buffer
+   */
+  VertexBuffer(void) = default;
+
+  /**
+   *  @name VertexBuffer
+   *  @fn VertexBuffer(const VertexBuffer& other)
+   *  @brief  Copy constructor
+   *  @param[in] other  Buffer to copy from
+   */
+  VertexBuffer(const VertexBuffer& other);
+
+  /**
+   *  @name VertexBuffer
+   *  @fn VertexBuffer(VertexBuffer&& other)
+   *  @brief  Move constructor, `other` is left empty
+   *  @param[in] other  Buffer to move from
+   */
+  VertexBuffer(VertexBuffer&& other);
+
+  /**
+   *  @name operator=
+   *  @fn VertexBuffer& operator=(const VertexBuffer& rhs)
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Buffer to assign from
+   */
+  VertexBuffer& operator=(const VertexBuffer& rhs);
+
+  /**
+   *  @name operator=
+   *  @fn VertexBuffer& operator=(VertexBuffer&& rhs)
+   *  @brief  Move assignment operator, `rhs` is left empty
+   *  @param[in] rhs  Buffer to move from
+   */
+  VertexBuffer& operator=(VertexBuffer&& rhs);
+
+  /**
+   *  @name ~VertexBuffer
+   *  @fn ~VertexBuffer(void)
+   *  @brief  Destructor
+   */
+  ~VertexBuffer(void);
+
+  /**
+   *  @name Reset
+   *  @fn void Reset(const std::vector<Attribute>& layout,
+                     const uint32_t& stride, const size_t& n_vertex)
+   *  @brief  Set the layout and allocate the storage, content is undefined.
+   *          Memory is reused when large enough.
+   *  @param[in] layout   Attributes
+   *  @param[in] stride   Size of a vertex in bytes, multiple of 16
+   *  @param[in] n_vertex Number of vertices
+   */
+  void Reset(const std::vector<Attribute>& layout,
+             const uint32_t& stride,
+             const size_t& n_vertex);
+
+  /**
+   *  @name Clear
+   *  @fn void Clear(void)
+   *  @brief  Release the storage and clear the layout
+   */
+  void Clear(void);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name Find
+   *  @fn const Attribute* Find(const Semantic& semantic) const
+   *  @brief  Look for an attribute in the layout
+   *  @param[in] semantic Attribute's meaning
+   *  @return Attribute or nullptr if not part of the layout
+   */
+  const Attribute* Find(const Semantic& semantic) const;
+
+  /**
+   *  @name vertex
+   *  @fn float* vertex(const size_t& i)
+   *  @brief  First component of the i-th vertex, only meaningful if the
+   *          layout is single precision
+   */
+  float* vertex(const size_t& i) {
+    return reinterpret_cast<float*>(data_ + i * stride_);
+  }
+
+  /**
+   *  @name vertex
+   *  @fn const float* vertex(const size_t& i) const
+   *  @brief  First component of the i-th vertex, only meaningful if the
+   *          layout is single precision
+   */
+  const float* vertex(const size_t& i) const {
+    return reinterpret_cast<const float*>(data_ + i * stride_);
+  }
+
+  /**
+   *  @name vertex_bytes
+   *  @fn uint8_t* vertex_bytes(const size_t& i)
+   *  @brief  First byte of the i-th vertex, attributes are at their
+   *          layout's offset
+   */
+  uint8_t* vertex_bytes(const size_t& i) {
+    return data_ + i * stride_;
+  }
+
+  /**
+   *  @name vertex_bytes
+   *  @fn const uint8_t* vertex_bytes(const size_t& i) const
+   *  @brief  First byte of the i-th vertex, attributes are at their
+   *          layout's offset
+   */
+  const uint8_t* vertex_bytes(const size_t& i) const {
+    return data_ + i * stride_;
+  }
+
+  /**
+   *  @name data
+   *  @fn const void* data(void) const
+   *  @brief  Start of the buffer, `kAlignment` bytes aligned
+   */
+  const void* data(void) const {
+    return data_;
+  }
+
+  /**
+   *  @name size
+   *  @fn size_t size(void) const
+   *  @brief  Size of the buffer in bytes
+   */
+  size_t size(void) const {
+    return n_vertex_ * stride_;
+  }
+
+  /**
+   *  @name n_vertex
+   *  @fn size_t n_vertex(void) const
+   *  @brief  Number of vertices
+   */
+  size_t n_vertex(void) const {
+    return n_vertex_;
+  }
+
+  /**
+   *  @name stride
+   *  @fn uint32_t stride(void) const
+   *  @brief  Size of a vertex in bytes
+   */
+  uint32_t stride(void) const {
+    return stride_;
+  }
+
+  /**
+   *  @name layout
+   *  @fn const std::vector<Attribute>& layout(void) const
+   *  @brief  Attributes of a vertex
+   */
+  const std::vector<Attribute>& layout(void) const {
+    return layout_;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Attributes */
+  std::vector<Attribute> layout_;
+  /** Storage */
+  uint8_t* data_ = nullptr;
+  /** Allocated bytes */
+  size_t capacity_ = 0;
+  /** Number of vertices */
+  size_t n_vertex_ = 0;
+  /** Size of a vertex in bytes */
+  uint32_t stride_ = 0;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_VERTEX_BUFFER__ */
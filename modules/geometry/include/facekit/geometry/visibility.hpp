@@ -0,0 +1,201 @@
+/**
+ *  @file   visibility.hpp
+ *  @brief  Vertex visibility and silhouette extraction of a mesh seen from a
+ *          viewpoint (i.e. occluded and contour landmarks)
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   06.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_VISIBILITY__
+#define __FACEKIT_VISIBILITY__
+
+#include <cstdint>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/math/vector.hpp"
+#include "facekit/geometry/bvh.hpp"
+#include "facekit/geometry/mesh.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  Visibility
+ *  @brief  Visibility queries of a mesh from a camera, run at every
+ *          iteration of a fit. Vertex visibility casts one ray per vertex
+ *          from the viewpoint, batched through the packet traversal of the
+ *          `BVH` (rays share their origin hence are coherent). Silhouettes
+ *          are the edges between a front and a back facing triangle, the
+ *          edge adjacency is built once per topology and the face normals
+ *          once per shape, a silhouette is then a single pass over the
+ *          edges and is cached until the view or the shape changes.
+ *  @author Christophe Ecabert
+ *  @date   06.11.18
+ *  @ingroup geometry
+ */
+template<typename T>
+class FK_EXPORTS Visibility {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /**
+   *  @struct View
+   *  @brief  Viewpoint in the mesh's reference frame
+   */
+  struct View {
+    /** Perspective: camera center. Parallel: direction pointing toward the
+        camera */
+    Vector3<T> eye;
+    /** Parallel projection (i.e. orthographic, weak perspective) */
+    bool parallel = false;
+  };
+
+  /**
+   *  @struct Options
+   *  @brief  Query parameters
+   */
+  struct Options {
+    /** Rays stop this fraction of their length before the vertex, so the
+        triangles around the vertex do not occlude it */
+    T eps = T(1e-3);
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name Visibility
+   *  @fn Visibility(void)
+   *  @brief  Constructor
+   */
+  Visibility(void) = default;
+
+  /**
+   *  @name Visibility
+   *  @fn explicit Visibility(const Options& options)
+   *  @brief  Constructor
+   *  @param[in] options  Query parameters
+   */
+  explicit Visibility(const Options& options) : options_(options) {}
+
+  /**
+   *  @name Build
+   *  @fn int Build(const Mesh<T>& mesh)
+   *  @brief  Index a mesh, to be called when its shape changes. The edge
+   *          adjacency is only rebuilt if the triangles changed.
+   *  @param[in] mesh Mesh to index, vertices and triangles are copied
+   *  @return -1 if error, 0 otherwise
+   */
+  int Build(const Mesh<T>& mesh);
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name Visible
+   *  @fn void Visible(const View& view, const std::vector<int>& vertex,
+                       std::vector<uint8_t>* visible) const
+   *  @brief  Check which vertices are seen from `view`, a vertex is visible
+   *          if nothing lies between it and the camera. Rays are cast in
+   *          parallel.
+   *  @param[in] view     Viewpoint
+   *  @param[in] vertex   Vertex indices (i.e. landmarks)
+   *  @param[out] visible 1 if visible, 0 if occluded or invalid, for each
+   *                      vertex
+   */
+  void Visible(const View& view,
+               const std::vector<int>& vertex,
+               std::vector<uint8_t>* visible) const;
+
+  /**
+   *  @name Silhouette
+   *  @fn const std::vector<int>& Silhouette(const View& view)
+   *  @brief  Vertices lying on the silhouette seen from `view`: shared by a
+   *          front and a back facing triangle, or on a border of a front
+   *          facing one. Triangles are front facing if wound counter
+   *          clockwise toward the camera. The result is cached, calling
+   *          again with the same view is free, therefore not reentrant.
+   *  @param[in] view Viewpoint
+   *  @return Silhouette vertices, sorted
+   */
+  const std::vector<int>& Silhouette(const View& view);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name bvh
+   *  @fn const BVH<T>& bvh(void) const
+   *  @brief  Hierarchy used for ray casting
+   */
+  const BVH<T>& bvh(void) const {
+    return bvh_;
+  }
+
+  /**
+   *  @name options
+   *  @fn const Options& options(void) const
+   *  @brief  Query parameters
+   */
+  const Options& options(void) const {
+    return options_;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+
+  /**
+   *  @struct Edge
+   *  @brief  Edge and its adjacent triangles
+   */
+  struct Edge {
+    /** Endpoints */
+    int v0;
+    int v1;
+    /** First triangle */
+    int f0;
+    /** Second triangle, -1 on a border */
+    int f1;
+  };
+
+  /**
+   *  @name BuildAdjacency
+   *  @fn void BuildAdjacency(const std::vector<Vector3<int>>& tri)
+   *  @brief  Pair the triangles sharing an edge
+   */
+  void BuildAdjacency(const std::vector<Vector3<int>>& tri);
+
+  /** Options */
+  Options options_;
+  /** Ray casting hierarchy */
+  BVH<T> bvh_;
+  /** Vertices */
+  std::vector<Vector3<T>> vertex_;
+  /** Triangles */
+  std::vector<Vector3<int>> tri_;
+  /** Face normals, not normalized */
+  std::vector<Vector3<T>> normal_;
+  /** Edges */
+  std::vector<Edge> edge_;
+  /** Diagonal of the bounding box, parallel rays start beyond it */
+  T extent_ = T(0.0);
+  /** Cached silhouette */
+  std::vector<int> silhouette_;
+  /** View of the cached silhouette */
+  View silhouette_view_;
+  /** Cached silhouette is valid */
+  bool silhouette_valid_ = false;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_VISIBILITY__ */
@@ -0,0 +1,913 @@
+/**
+ *  @file   bvh.cpp
+ *  @brief  Bounding volume hierarchy over the triangles of a mesh, used for
+ *          ray casting (i.e. visibility, landmark projection)
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   26.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/geometry/bvh.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Number of bins per axis used to evaluate the SAH */
+static constexpr size_t kBVHBin = 16;
+/** Nodes with more primitives are binned and split in parallel */
+static constexpr size_t kBVHParallelSize = 1 << 14;
+/** Depth after which nodes are split in halves, bounds the tree depth */
+static constexpr size_t kBVHMaxSAHDepth = 48;
+/** Traversal stack size, larger than the maximum depth */
+static constexpr size_t kBVHStackSize = 128;
+/** Number of rays traversed together */
+static constexpr size_t kPacketSize = 8;
+
+#pragma mark -
+#pragma mark Construction
+
+/**
+ *  @name   EmptyBox
+ *  @fn     template<typename T> static AABB<T> EmptyBox(void)
+ *  @brief  Bounding box neutral for union
+ */
+template<typename T>
+static AABB<T> EmptyBox(void) {
+  const T lo = std::numeric_limits<T>::lowest();
+  const T hi = std::numeric_limits<T>::max();
+  AABB<T> box;
+  box.min_ = Vector3<T>(hi, hi, hi);
+  box.max_ = Vector3<T>(lo, lo, lo);
+  return box;
+}
+
+/**
+ *  @name   Grow
+ *  @fn     template<typename T> static void Grow(const Vector3<T>& p,
+                                                  AABB<T>* box)
+ *  @brief  Extend a box to include a point, center is not updated
+ */
+template<typename T>
+static void Grow(const Vector3<T>& p, AABB<T>* box) {
+  box->min_.x_ = std::min(box->min_.x_, p.x_);
+  box->min_.y_ = std::min(box->min_.y_, p.y_);
+  box->min_.z_ = std::min(box->min_.z_, p.z_);
+  box->max_.x_ = std::max(box->max_.x_, p.x_);
+  box->max_.y_ = std::max(box->max_.y_, p.y_);
+  box->max_.z_ = std::max(box->max_.z_, p.z_);
+}
+
+/**
+ *  @name   Merge
+ *  @fn     template<typename T> static void Merge(const AABB<T>& src,
+                                                   AABB<T>* box)
+ *  @brief  Extend a box to include another one (possibly empty), center is
+ *          not updated
+ */
+template<typename T>
+static void Merge(const AABB<T>& src, AABB<T>* box) {
+  box->min_.x_ = std::min(box->min_.x_, src.min_.x_);
+  box->min_.y_ = std::min(box->min_.y_, src.min_.y_);
+  box->min_.z_ = std::min(box->min_.z_, src.min_.z_);
+  box->max_.x_ = std::max(box->max_.x_, src.max_.x_);
+  box->max_.y_ = std::max(box->max_.y_, src.max_.y_);
+  box->max_.z_ = std::max(box->max_.z_, src.max_.z_);
+}
+
+/**
+ *  @name   HalfArea
+ *  @fn     template<typename T> static T HalfArea(const AABB<T>& box)
+ *  @brief  Half of the surface area of a box, 0 for empty boxes
+ */
+template<typename T>
+static T HalfArea(const AABB<T>& box) {
+  const T dx = box.max_.x_ - box.min_.x_;
+  const T dy = box.max_.y_ - box.min_.y_;
+  const T dz = box.max_.z_ - box.min_.z_;
+  if (dx < T(0.0) || dy < T(0.0) || dz < T(0.0)) {
+    return T(0.0);
+  }
+  return dx * dy + dy * dz + dz * dx;
+}
+
+/**
+ *  @struct NodeBounds
+ *  @brief  Bounds of the primitives of a node and of their centers
+ */
+template<typename T>
+struct NodeBounds {
+  /** Primitives bounds */
+  AABB<T> box = EmptyBox<T>();
+  /** Centers bounds */
+  AABB<T> center = EmptyBox<T>();
+
+  /** Extend with a primitive */
+  void Add(const AABB<T>& prim) {
+    Merge(prim, &box);
+    Grow(prim.center_, &center);
+  }
+
+  /** Union */
+  NodeBounds& operator+=(const NodeBounds& rhs) {
+    Merge(rhs.box, &box);
+    Merge(rhs.center, &center);
+    return *this;
+  }
+};
+
+/**
+ *  @name   RangeBounds
+ *  @fn     template<typename T> static NodeBounds<T> RangeBounds(
+                                    const AABB<T>* prim, const size_t& first,
+                                    const size_t& last, const bool& parallel)
+ *  @brief  Bounds of primitives [first, last)
+ */
+template<typename T>
+static NodeBounds<T> RangeBounds(const AABB<T>* prim,
+                                 const size_t& first,
+                                 const size_t& last,
+                                 const bool& parallel) {
+  auto bounds = [&](const size_t& b, const size_t& e) {
+    NodeBounds<T> res;
+    for (size_t k = b; k < e; ++k) {
+      res.Add(prim[k]);
+    }
+    return res;
+  };
+  if (!parallel) {
+    return bounds(first, last);
+  }
+  return ThreadPool::Get().ParallelReduce(first,
+                                          last,
+                                          0,
+                                          NodeBounds<T>(),
+                                          bounds,
+                                          [](const NodeBounds<T>& a,
+                                             const NodeBounds<T>& b) {
+    NodeBounds<T> res = a;
+    res += b;
+    return res;
+  });
+}
+
+/**
+ *  @struct BinBox
+ *  @brief  Bounds of the primitives falling in a bin, lighter than `AABB`
+ *          since bins are created for every node
+ */
+template<typename T>
+struct BinBox {
+  /** Minimum corner */
+  T lo[3];
+  /** Maximum corner */
+  T hi[3];
+
+  /** Empty box */
+  void Clear(void) {
+    for (int k = 0; k < 3; ++k) {
+      lo[k] = std::numeric_limits<T>::max();
+      hi[k] = std::numeric_limits<T>::lowest();
+    }
+  }
+
+  /** Extend with a primitive */
+  void Add(const AABB<T>& box) {
+    const T* b_lo = &box.min_.x_;
+    const T* b_hi = &box.max_.x_;
+    for (int k = 0; k < 3; ++k) {
+      lo[k] = std::min(lo[k], b_lo[k]);
+      hi[k] = std::max(hi[k], b_hi[k]);
+    }
+  }
+
+  /** Extend with another bin */
+  void Add(const BinBox& box) {
+    for (int k = 0; k < 3; ++k) {
+      lo[k] = std::min(lo[k], box.lo[k]);
+      hi[k] = std::max(hi[k], box.hi[k]);
+    }
+  }
+
+  /** Half of the surface area, 0 if empty */
+  T HalfArea(void) const {
+    const T dx = hi[0] - lo[0];
+    const T dy = hi[1] - lo[1];
+    const T dz = hi[2] - lo[2];
+    return (dx < T(0.0) || dy < T(0.0) || dz < T(0.0)) ?
+           T(0.0) : dx * dy + dy * dz + dz * dx;
+  }
+};
+
+/**
+ *  @struct Bins
+ *  @brief  SAH bins along the split axis
+ */
+template<typename T>
+struct Bins {
+  /** Bounds of the primitives in each bin */
+  BinBox<T> box[kBVHBin];
+  /** Number of primitives in each bin */
+  size_t count[kBVHBin];
+  /** Number of bins in use */
+  size_t n_bin;
+
+  /**
+   *  @name   Bins
+   *  @fn     explicit Bins(const size_t& n = kBVHBin)
+   *  @brief  Constructor, empty bins
+   */
+  explicit Bins(const size_t& n = kBVHBin) : n_bin(n) {
+    for (size_t b = 0; b < n_bin; ++b) {
+      box[b].Clear();
+      count[b] = 0;
+    }
+  }
+
+  /** Merge */
+  Bins& operator+=(const Bins& rhs) {
+    for (size_t b = 0; b < n_bin; ++b) {
+      box[b].Add(rhs.box[b]);
+      count[b] += rhs.count[b];
+    }
+    return *this;
+  }
+};
+
+/**
+ *  @struct BuildContext
+ *  @brief  Construction state shared by all nodes
+ */
+template<typename T>
+struct BVH<T>::BuildContext {
+  /** Bounds of each triangle with its center and index, reordered as the
+   tree is built so nodes cover contiguous ranges */
+  std::vector<AABB<T>> prim;
+  /** Parameters */
+  Options options;
+};
+
+/**
+ *  @name   BinIndex
+ *  @fn     template<typename T> static size_t BinIndex(const T& c,
+                                              const T& lo, const T& scale,
+                                              const size_t& n_bin)
+ *  @brief  Bin of a center along one axis
+ */
+template<typename T>
+static size_t BinIndex(const T& c,
+                       const T& lo,
+                       const T& scale,
+                       const size_t& n_bin) {
+  const T b = (c - lo) * scale;
+  return b <= T(0.0) ? 0 : std::min(n_bin - 1, static_cast<size_t>(b));
+}
+
+/*
+ *  @name Build
+ *  @fn int Build(const Mesh<T>& mesh, const Options& options)
+ *  @brief  Build the hierarchy
+ *  @param[in] mesh     Mesh to index, its triangles are copied
+ *  @param[in] options  Construction parameters
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int BVH<T>::Build(const Mesh<T>& mesh, const Options& options) {
+  nodes_.clear();
+  wide_.clear();
+  tri_.clear();
+  tri_index_.clear();
+  const auto& vertex = mesh.get_vertex();
+  const auto& tri = mesh.get_triangle();
+  const int n_vertex = static_cast<int>(vertex.size());
+  if (tri.empty()) {
+    std::cout << "Error, can not build a BVH without triangles" << std::endl;
+    return -1;
+  }
+  // Primitive bounds
+  BuildContext ctx;
+  ctx.options = options;
+  ctx.options.max_leaf_size = std::max<size_t>(1, options.max_leaf_size);
+  ctx.prim.resize(tri.size());
+  bool valid = true;
+  for (size_t t = 0; t < tri.size() && valid; ++t) {
+    const int* idx = &tri[t].x_;
+    valid = (idx[0] >= 0 && idx[0] < n_vertex && idx[1] >= 0 &&
+             idx[1] < n_vertex && idx[2] >= 0 && idx[2] < n_vertex);
+  }
+  if (!valid) {
+    std::cout << "Error, triangle index out of range" << std::endl;
+    return -1;
+  }
+  ThreadPool::Get().ParallelFor(0,
+                                tri.size(),
+                                0,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t t = first; t < last; ++t) {
+      AABB<T> box = EmptyBox<T>();
+      Grow(vertex[tri[t].x_], &box);
+      Grow(vertex[tri[t].y_], &box);
+      Grow(vertex[tri[t].z_], &box);
+      box.center_ = (box.min_ + box.max_) * T(0.5);
+      box.index_ = static_cast<int>(t);
+      ctx.prim[t] = box;
+    }
+  });
+  // Tree
+  nodes_.reserve(2 * tri.size() / ctx.options.max_leaf_size + 1);
+  const NodeBounds<T> nb = RangeBounds(ctx.prim.data(), 0, tri.size(), true);
+  this->BuildRange(&ctx, 0, tri.size(), 0, nb.box, nb.center, &nodes_);
+  // Triangles in leaf order
+  tri_index_.resize(tri.size());
+  tri_.resize(tri.size());
+  ThreadPool::Get().ParallelFor(0,
+                                tri_.size(),
+                                0,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t k = first; k < last; ++k) {
+      tri_index_[k] = ctx.prim[k].index_;
+      const auto& f = tri[tri_index_[k]];
+      Triangle& dst = tri_[k];
+      dst.v0 = vertex[f.x_];
+      dst.e1 = vertex[f.y_] - vertex[f.x_];
+      dst.e2 = vertex[f.z_] - vertex[f.x_];
+    }
+  });
+  // Wide tree
+  wide_.reserve(nodes_.size() / 3 + 1);
+  const Node& root = nodes_[0];
+  if (root.count > 0) {
+    wide_.emplace_back();
+    wide_[0].box.Set(0, root.min, root.max);
+    wide_[0].child[0] = root.offset;
+    wide_[0].count[0] = root.count;
+  } else {
+    this->Collapse(0);
+  }
+  return 0;
+}
+
+/*
+ *  @name Collapse
+ *  @fn int32_t Collapse(const int32_t& node)
+ *  @brief  Convert the binary subtree rooted at inner node `node` into wide
+ *          nodes, appended to `wide_`
+ *  @return Index of the wide node
+ */
+template<typename T>
+int32_t BVH<T>::Collapse(const int32_t& node) {
+  const int32_t idx = static_cast<int32_t>(wide_.size());
+  wide_.emplace_back();
+  // Open the inner child with the largest area until four children are
+  // gathered
+  int32_t child[4] = {node + 1, nodes_[node].offset, -1, -1};
+  int n_child = 2;
+  while (n_child < 4) {
+    int best = -1;
+    T best_area = T(-1.0);
+    for (int c = 0; c < n_child; ++c) {
+      const Node& n = nodes_[child[c]];
+      if (n.count > 0) {
+        continue;
+      }
+      const T dx = n.max[0] - n.min[0];
+      const T dy = n.max[1] - n.min[1];
+      const T dz = n.max[2] - n.min[2];
+      const T area = dx * dy + dy * dz + dz * dx;
+      if (area > best_area) {
+        best_area = area;
+        best = c;
+      }
+    }
+    if (best < 0) {
+      break;
+    }
+    const int32_t open = child[best];
+    child[best] = open + 1;
+    child[n_child++] = nodes_[open].offset;
+  }
+  for (int c = 0; c < 4; ++c) {
+    wide_[idx].child[c] = 0;
+    wide_[idx].count[c] = 0;
+  }
+  for (int c = 0; c < n_child; ++c) {
+    const Node& n = nodes_[child[c]];
+    wide_[idx].box.Set(c, n.min, n.max);
+    if (n.count > 0) {
+      wide_[idx].child[c] = n.offset;
+      wide_[idx].count[c] = n.count;
+    } else {
+      // `wide_` may grow, no reference is kept
+      const int32_t w = this->Collapse(child[c]);
+      wide_[idx].child[c] = w;
+    }
+  }
+  return idx;
+}
+
+/*
+ *  @name BuildRange
+ *  @fn void BuildRange(BuildContext* ctx, const size_t& first,
+                        const size_t& last, const size_t& depth,
+                        const AABB<T>& box, const AABB<T>& center,
+                        std::vector<Node>* nodes) const
+ *  @brief  Build the subtree over primitives [first, last), appended to
+ *          `nodes`
+ */
+template<typename T>
+void BVH<T>::BuildRange(BuildContext* ctx,
+                        const size_t& first,
+                        const size_t& last,
+                        const size_t& depth,
+                        const AABB<T>& box,
+                        const AABB<T>& center,
+                        std::vector<Node>* nodes) const {
+  const size_t n = last - first;
+  const bool parallel = n >= kBVHParallelSize;
+  auto& pool = ThreadPool::Get();
+  AABB<T>* prim = ctx->prim.data();
+  NodeBounds<T> nb;
+  nb.box = box;
+  nb.center = center;
+  const size_t self = nodes->size();
+  nodes->push_back(Node());
+  {
+    Node& node = (*nodes)[self];
+    const T* lo = &nb.box.min_.x_;
+    const T* hi = &nb.box.max_.x_;
+    for (int k = 0; k < 3; ++k) {
+      node.min[k] = lo[k];
+      node.max[k] = hi[k];
+    }
+  }
+  auto make_leaf = [&](void) {
+    Node& node = (*nodes)[self];
+    node.offset = static_cast<int32_t>(first);
+    node.count = static_cast<int32_t>(n);
+  };
+  if (n <= 1) {
+    make_leaf();
+    return;
+  }
+  // Bin centers along the axis where they spread the most, small nodes use
+  // fewer bins
+  const size_t n_bin = std::min(kBVHBin, std::max<size_t>(4, n));
+  const int axis = static_cast<int>(AABB<T>::LongestAxis(nb.center));
+  const T c_lo = (&nb.center.min_.x_)[axis];
+  const T extent = (&nb.center.max_.x_)[axis] - c_lo;
+  const T scale = extent > T(0.0) ? T(n_bin) / extent : T(0.0);
+  size_t best_split = 0;
+  T best_cost = std::numeric_limits<T>::max();
+  if (scale > T(0.0) && depth < kBVHMaxSAHDepth) {
+    auto binning = [&](const size_t& b, const size_t& e) {
+      Bins<T> res(n_bin);
+      for (size_t k = b; k < e; ++k) {
+        const AABB<T>& box = prim[k];
+        const size_t bin = BinIndex((&box.center_.x_)[axis], c_lo, scale,
+                                    n_bin);
+        res.box[bin].Add(box);
+        res.count[bin] += 1;
+      }
+      return res;
+    };
+    auto merge_bins = [](const Bins<T>& a, const Bins<T>& b) {
+      Bins<T> res = a;
+      res += b;
+      return res;
+    };
+    const Bins<T> bins = parallel ?
+            pool.ParallelReduce(first, last, 0, Bins<T>(n_bin), binning,
+                                merge_bins) :
+            binning(first, last);
+    // Sweep split planes, cost relative to one triangle test
+    const T inv_area = T(1.0) / std::max(HalfArea(nb.box),
+                                         std::numeric_limits<T>::min());
+    T right_area[kBVHBin];
+    size_t right_count[kBVHBin];
+    BinBox<T> acc;
+    acc.Clear();
+    size_t cnt = 0;
+    for (size_t b = n_bin - 1; b > 0; --b) {
+      acc.Add(bins.box[b]);
+      cnt += bins.count[b];
+      right_area[b] = acc.HalfArea();
+      right_count[b] = cnt;
+    }
+    acc.Clear();
+    cnt = 0;
+    for (size_t b = 1; b < n_bin; ++b) {
+      acc.Add(bins.box[b - 1]);
+      cnt += bins.count[b - 1];
+      if (cnt == 0 || right_count[b] == 0) {
+        continue;
+      }
+      const T cost = ctx->options.traversal_cost +
+                     (acc.HalfArea() * T(cnt) +
+                      right_area[b] * T(right_count[b])) * inv_area;
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_split = b;
+      }
+    }
+  }
+  // Leaf when splitting does not pay off
+  const bool fits = n <= ctx->options.max_leaf_size;
+  if (fits && (best_split == 0 || best_cost >= T(n))) {
+    make_leaf();
+    return;
+  }
+  size_t mid;
+  NodeBounds<T> left, right;
+  if (best_split > 0) {
+    // Partition, children bounds are gathered on the way
+    auto is_left = [&](const AABB<T>& p) {
+      return BinIndex((&p.center_.x_)[axis], c_lo, scale, n_bin) < best_split;
+    };
+    size_t i = first;
+    size_t j = last;
+    while (true) {
+      while (i < j && is_left(prim[i])) {
+        left.Add(prim[i++]);
+      }
+      while (i < j && !is_left(prim[j - 1])) {
+        right.Add(prim[--j]);
+      }
+      if (i == j) {
+        break;
+      }
+      std::swap(prim[i], prim[j - 1]);
+      left.Add(prim[i++]);
+      right.Add(prim[--j]);
+    }
+    mid = i;
+  } else {
+    // No usable plane (i.e. coincident centers, maximum depth reached),
+    // halves along the longest axis
+    mid = first + n / 2;
+    std::nth_element(prim + first, prim + mid, prim + last,
+                     [&](const AABB<T>& p, const AABB<T>& q) {
+      return (&p.center_.x_)[axis] < (&q.center_.x_)[axis];
+    });
+    left = RangeBounds(prim, first, mid, parallel);
+    right = RangeBounds(prim, mid, last, parallel);
+  }
+  (*nodes)[self].count = -1 - axis;
+  if (parallel) {
+    // Second child in its own array, indices are shifted once appended
+    std::vector<Node> second;
+    pool.ParallelFor(0, 2, 1, [&](const size_t& b, const size_t& e) {
+      for (size_t k = b; k < e; ++k) {
+        if (k == 0) {
+          this->BuildRange(ctx, first, mid, depth + 1, left.box, left.center,
+                           nodes);
+        } else {
+          this->BuildRange(ctx, mid, last, depth + 1, right.box, right.center,
+                           &second);
+        }
+      }
+    });
+    const int32_t base = static_cast<int32_t>(nodes->size());
+    for (auto& node : second) {
+      if (node.count < 0) {
+        node.offset += base;
+      }
+    }
+    (*nodes)[self].offset = base;
+    nodes->insert(nodes->end(), second.begin(), second.end());
+  } else {
+    this->BuildRange(ctx, first, mid, depth + 1, left.box, left.center,
+                     nodes);
+    (*nodes)[self].offset = static_cast<int32_t>(nodes->size());
+    this->BuildRange(ctx, mid, last, depth + 1, right.box, right.center,
+                     nodes);
+  }
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/**
+ *  @name   InverseDir
+ *  @fn     template<typename T> static T InverseDir(const T& d)
+ *  @brief  Inverse of a direction component, large finite value for 0 so
+ *          slab tests never produce NaN
+ */
+template<typename T>
+static T InverseDir(const T& d) {
+  const T large = std::numeric_limits<T>::max();
+  return d != T(0.0) ? T(1.0) / d : (std::signbit(d) ? -large : large);
+}
+
+/**
+ *  @name   RayTriangle
+ *  @fn     template<typename T, typename Tri> static bool RayTriangle(
+                                      const Vector3<T>& org,
+                                      const Vector3<T>& dir,
+                                      const Tri& tri, const T& t_max,
+                                      T* t, T* u, T* v)
+ *  @brief  Moller-Trumbore intersection, both faces
+ *  @return True if the triangle is hit within [0, t_max]
+ */
+template<typename T, typename Tri>
+static bool RayTriangle(const Vector3<T>& org,
+                        const Vector3<T>& dir,
+                        const Tri& tri,
+                        const T& t_max,
+                        T* t,
+                        T* u,
+                        T* v) {
+  const Vector3<T> p = dir ^ tri.e2;
+  const T det = tri.e1 * p;
+  if (det == T(0.0)) {
+    return false;
+  }
+  const T inv_det = T(1.0) / det;
+  const Vector3<T> s = org - tri.v0;
+  *u = (s * p) * inv_det;
+  if (*u < T(0.0) || *u > T(1.0)) {
+    return false;
+  }
+  const Vector3<T> q = s ^ tri.e1;
+  *v = (dir * q) * inv_det;
+  if (*v < T(0.0) || *u + *v > T(1.0)) {
+    return false;
+  }
+  *t = (tri.e2 * q) * inv_det;
+  return *t >= T(0.0) && *t <= t_max;
+}
+
+/*
+ *  @name Intersect
+ *  @fn bool Intersect(const Ray& ray, Hit* hit) const
+ *  @brief  Find the closest triangle hit by a ray
+ *  @param[in] ray  Ray to cast
+ *  @param[out] hit Closest intersection
+ *  @return True if a triangle is hit
+ */
+template<typename T>
+bool BVH<T>::Intersect(const Ray& ray, Hit* hit) const {
+  *hit = Hit();
+  if (wide_.empty()) {
+    return false;
+  }
+  const T* o = &ray.org.x_;
+  const T inv[3] = {InverseDir(ray.dir.x_),
+                    InverseDir(ray.dir.y_),
+                    InverseDir(ray.dir.z_)};
+  T t_max = ray.t_max;
+  // Nodes are pushed with their entry distance, skipped once a closer hit
+  // is found
+  std::pair<int32_t, T> stack[kBVHStackSize];
+  size_t sp = 0;
+  stack[sp++] = std::make_pair(0, T(0.0));
+  while (sp > 0) {
+    const auto entry = stack[--sp];
+    if (entry.second > t_max) {
+      continue;
+    }
+    const WideNode& node = wide_[entry.first];
+    alignas(16) T t_near[4];
+    const uint32_t mask = node.box.Intersect(o, inv, t_max, t_near);
+    // Leaves first, inner children pushed farthest first
+    std::pair<int32_t, T> inner[4];
+    int n_inner = 0;
+    for (int c = 0; c < 4; ++c) {
+      if (!((mask >> c) & 1)) {
+        continue;
+      }
+      if (node.count[c] > 0) {
+        const int32_t end = node.child[c] + node.count[c];
+        for (int32_t k = node.child[c]; k < end; ++k) {
+          T t, u, v;
+          if (RayTriangle(ray.org, ray.dir, tri_[k], t_max, &t, &u, &v)) {
+            t_max = t;
+            hit->tri = tri_index_[k];
+            hit->t = t;
+            hit->u = u;
+            hit->v = v;
+          }
+        }
+      } else {
+        inner[n_inner++] = std::make_pair(node.child[c], t_near[c]);
+      }
+    }
+    for (int c = 1; c < n_inner; ++c) {
+      const std::pair<int32_t, T> e = inner[c];
+      int k = c;
+      for (; k > 0 && inner[k - 1].second < e.second; --k) {
+        inner[k] = inner[k - 1];
+      }
+      inner[k] = e;
+    }
+    for (int c = 0; c < n_inner; ++c) {
+      stack[sp++] = inner[c];
+    }
+  }
+  return hit->tri >= 0;
+}
+
+/*
+ *  @name Occluded
+ *  @fn bool Occluded(const Ray& ray) const
+ *  @brief  Check if a ray hits any triangle
+ *  @param[in] ray  Ray to cast
+ *  @return True if a triangle is hit
+ */
+template<typename T>
+bool BVH<T>::Occluded(const Ray& ray) const {
+  if (wide_.empty()) {
+    return false;
+  }
+  const T* o = &ray.org.x_;
+  const T inv[3] = {InverseDir(ray.dir.x_),
+                    InverseDir(ray.dir.y_),
+                    InverseDir(ray.dir.z_)};
+  int32_t stack[kBVHStackSize];
+  size_t sp = 0;
+  stack[sp++] = 0;
+  while (sp > 0) {
+    const WideNode& node = wide_[stack[--sp]];
+    alignas(16) T t_near[4];
+    const uint32_t mask = node.box.Intersect(o, inv, ray.t_max, t_near);
+    for (int c = 0; c < 4; ++c) {
+      if (!((mask >> c) & 1)) {
+        continue;
+      }
+      if (node.count[c] > 0) {
+        const int32_t end = node.child[c] + node.count[c];
+        for (int32_t k = node.child[c]; k < end; ++k) {
+          T t, u, v;
+          if (RayTriangle(ray.org, ray.dir, tri_[k], ray.t_max, &t, &u, &v)) {
+            return true;
+          }
+        }
+      } else {
+        stack[sp++] = node.child[c];
+      }
+    }
+  }
+  return false;
+}
+
+/*
+ *  @name Intersect
+ *  @fn void Intersect(const std::vector<Ray>& rays,
+                       std::vector<Hit>* hits) const
+ *  @brief  Cast a batch of rays in parallel
+ *  @param[in] rays Rays to cast
+ *  @param[out] hits Closest intersection of each ray
+ */
+template<typename T>
+void BVH<T>::Intersect(const std::vector<Ray>& rays,
+                       std::vector<Hit>* hits) const {
+  hits->assign(rays.size(), Hit());
+  const size_t n_packet = (rays.size() + kPacketSize - 1) / kPacketSize;
+  ThreadPool::Get().ParallelFor(0,
+                                n_packet,
+                                0,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t p = first; p < last; ++p) {
+      const size_t r = p * kPacketSize;
+      this->IntersectPacket(&rays[r],
+                            std::min(kPacketSize, rays.size() - r),
+                            &(*hits)[r]);
+    }
+  });
+}
+
+/*
+ *  @name IntersectPacket
+ *  @fn void IntersectPacket(const Ray* rays, const size_t& n,
+                             Hit* hits) const
+ *  @brief  Cast up to `kPacketSize` rays together. Rays are stored as
+ *          structure of arrays and every lane is processed without branches
+ *          so the loops vectorize, a node is visited if any ray of the
+ *          packet hits it.
+ */
+template<typename T>
+void BVH<T>::IntersectPacket(const Ray* rays,
+                             const size_t& n,
+                             Hit* hits) const {
+  if (nodes_.empty()) {
+    return;
+  }
+  RayPack<T, static_cast<int>(kPacketSize)> pack;
+  auto& org = pack.org_;
+  auto& t_max = pack.t_max_;
+  alignas(64) T dir[3][kPacketSize];
+  alignas(64) T hit_u[kPacketSize];
+  alignas(64) T hit_v[kPacketSize];
+  alignas(64) int32_t hit_k[kPacketSize];
+  for (size_t l = 0; l < kPacketSize; ++l) {
+    // Unused lanes never hit anything
+    const Ray& ray = rays[l < n ? l : 0];
+    const T* o = &ray.org.x_;
+    const T* d = &ray.dir.x_;
+    for (int k = 0; k < 3; ++k) {
+      org[k][l] = o[k];
+      dir[k][l] = d[k];
+      pack.inv_dir_[k][l] = InverseDir(d[k]);
+    }
+    t_max[l] = l < n ? ray.t_max : T(-1.0);
+    hit_u[l] = T(0.0);
+    hit_v[l] = T(0.0);
+    hit_k[l] = -1;
+  }
+  // Traversal order from the first ray
+  bool neg[3] = {dir[0][0] < T(0.0), dir[1][0] < T(0.0), dir[2][0] < T(0.0)};
+  int32_t stack[kBVHStackSize];
+  size_t sp = 0;
+  stack[sp++] = 0;
+  while (sp > 0) {
+    const int32_t idx = stack[--sp];
+    const Node& node = nodes_[idx];
+    if (!pack.Intersect(node.min, node.max)) {
+      continue;
+    }
+    if (node.count > 0) {
+      for (int32_t k = node.offset; k < node.offset + node.count; ++k) {
+        const Triangle& tri = tri_[k];
+        for (size_t l = 0; l < kPacketSize; ++l) {
+          // p = dir ^ e2
+          const T px = dir[1][l] * tri.e2.z_ - dir[2][l] * tri.e2.y_;
+          const T py = dir[2][l] * tri.e2.x_ - dir[0][l] * tri.e2.z_;
+          const T pz = dir[0][l] * tri.e2.y_ - dir[1][l] * tri.e2.x_;
+          const T det = tri.e1.x_ * px + tri.e1.y_ * py + tri.e1.z_ * pz;
+          const T inv_det = T(1.0) / det;
+          // s = org - v0, q = s ^ e1
+          const T sx = org[0][l] - tri.v0.x_;
+          const T sy = org[1][l] - tri.v0.y_;
+          const T sz = org[2][l] - tri.v0.z_;
+          const T u = (sx * px + sy * py + sz * pz) * inv_det;
+          const T qx = sy * tri.e1.z_ - sz * tri.e1.y_;
+          const T qy = sz * tri.e1.x_ - sx * tri.e1.z_;
+          const T qz = sx * tri.e1.y_ - sy * tri.e1.x_;
+          const T v = (dir[0][l] * qx + dir[1][l] * qy + dir[2][l] * qz) *
+                      inv_det;
+          const T t = (tri.e2.x_ * qx + tri.e2.y_ * qy + tri.e2.z_ * qz) *
+                      inv_det;
+          // Comparisons with NaN (det == 0) fail
+          const bool ok = (u >= T(0.0)) & (v >= T(0.0)) & (u + v <= T(1.0)) &
+                          (t >= T(0.0)) & (t <= t_max[l]) & (det != T(0.0));
+          t_max[l] = ok ? t : t_max[l];
+          hit_u[l] = ok ? u : hit_u[l];
+          hit_v[l] = ok ? v : hit_v[l];
+          hit_k[l] = ok ? k : hit_k[l];
+        }
+      }
+    } else {
+      const int axis = -1 - node.count;
+      if (neg[axis]) {
+        stack[sp++] = idx + 1;
+        stack[sp++] = node.offset;
+      } else {
+        stack[sp++] = node.offset;
+        stack[sp++] = idx + 1;
+      }
+    }
+  }
+  for (size_t l = 0; l < n; ++l) {
+    if (hit_k[l] >= 0) {
+      hits[l].tri = tri_index_[hit_k[l]];
+      hits[l].t = t_max[l];
+      hits[l].u = hit_u[l];
+      hits[l].v = hit_v[l];
+    }
+  }
+}
+
+/*
+ *  @name bbox
+ *  @fn AABB<T> bbox(void) const
+ *  @brief  Bounding box of the indexed triangles
+ */
+template<typename T>
+AABB<T> BVH<T>::bbox(void) const {
+  if (nodes_.empty()) {
+    return AABB<T>();
+  }
+  const Node& root = nodes_[0];
+  return AABB<T>(root.min[0], root.max[0],
+                 root.min[1], root.max[1],
+                 root.min[2], root.max[2]);
+}
+
+#pragma mark -
+#pragma mark Declaration
+
+/** Float BVH */
+template class BVH<float>;
+/** Double BVH */
+template class BVH<double>;
+
+}  // namespace FaceKit
@@ -0,0 +1,410 @@
+/**
+ *  @file   compact_mesh.cpp
+ *  @brief  Quantized copy of the per-vertex data of a mesh, for large
+ *          collections of instances
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/geometry/compact_mesh.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Number of vertices encoded / decoded by one parallel task */
+static constexpr size_t kCompactGrain = 4096;
+/** Largest quantized position */
+static constexpr int kPositionMax = 65535;
+/** Largest quantized normal component */
+static constexpr int kNormalMax = 32767;
+
+#pragma mark -
+#pragma mark Kernels
+
+/*
+ *  @name DecodePosition
+ *  @fn template<typename T> static void DecodePosition(const uint16_t* q,
+                                    const size_t& n, const T* origin,
+                                    const T* step, T* p)
+ *  @brief  Decode `n` packed (x, y, z) positions
+ */
+template<typename T>
+static void DecodePosition(const uint16_t* q,
+                           const size_t& n,
+                           const T* origin,
+                           const T* step,
+                           T* p) {
+  for (size_t i = 0; i < 3 * n; i += 3) {
+    p[i] = origin[0] + step[0] * T(q[i]);
+    p[i + 1] = origin[1] + step[1] * T(q[i + 1]);
+    p[i + 2] = origin[2] + step[2] * T(q[i + 2]);
+  }
+}
+
+/*
+ *  @name DecodeNormal
+ *  @fn template<typename T> static void DecodeNormal(const int16_t* q,
+                                                      const size_t& n, T* p)
+ *  @brief  Decode `n` octahedral normals into packed (x, y, z) unit vectors.
+ *          The lower hemisphere is folded over the diagonals of the
+ *          octahedron's projection.
+ */
+template<typename T>
+static void DecodeNormal(const int16_t* q, const size_t& n, T* p) {
+  const T s = T(1.0) / T(kNormalMax);
+  for (size_t i = 0; i < n; ++i, q += 2, p += 3) {
+    T x = T(q[0]) * s;
+    T y = T(q[1]) * s;
+    const T z = T(1.0) - std::abs(x) - std::abs(y);
+    const T t = std::max(-z, T(0.0));
+    x += x >= T(0.0) ? -t : t;
+    y += y >= T(0.0) ? -t : t;
+    const T inv = T(1.0) / std::sqrt(x * x + y * y + z * z);
+    p[0] = x * inv;
+    p[1] = y * inv;
+    p[2] = z * inv;
+  }
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+/*
+ *  @name DecodePosition
+ *  @fn static void DecodePosition(const uint16_t* q, const size_t& n,
+                                   const float* origin, const float* step,
+                                   float* p)
+ *  @brief  Decode `n` packed (x, y, z) positions, SSE2 version. Four
+ *          vertices span three registers whose lanes hold the axes
+ *          (x y z x), (y z x y) and (z x y z).
+ */
+static void DecodePosition(const uint16_t* q,
+                           const size_t& n,
+                           const float* origin,
+                           const float* step,
+                           float* p) {
+  const size_t n4 = n & ~size_t(3);
+  const __m128 o_r[3] = {_mm_setr_ps(origin[0], origin[1], origin[2],
+                                     origin[0]),
+                         _mm_setr_ps(origin[1], origin[2], origin[0],
+                                     origin[1]),
+                         _mm_setr_ps(origin[2], origin[0], origin[1],
+                                     origin[2])};
+  const __m128 s_r[3] = {_mm_setr_ps(step[0], step[1], step[2], step[0]),
+                         _mm_setr_ps(step[1], step[2], step[0], step[1]),
+                         _mm_setr_ps(step[2], step[0], step[1], step[2])};
+  const __m128i zero = _mm_setzero_si128();
+  for (size_t i = 0; i < n4; i += 4) {
+    const uint16_t* src = q + 3 * i;
+    float* dst = p + 3 * i;
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    const __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src +
+                                                                       8));
+    const __m128i v[3] = {_mm_unpacklo_epi16(a, zero),
+                          _mm_unpackhi_epi16(a, zero),
+                          _mm_unpacklo_epi16(b, zero)};
+    for (int r = 0; r < 3; ++r) {
+      const __m128 f = _mm_cvtepi32_ps(v[r]);
+      _mm_storeu_ps(dst + 4 * r, _mm_add_ps(o_r[r], _mm_mul_ps(s_r[r], f)));
+    }
+  }
+  DecodePosition<float>(q + 3 * n4, n - n4, origin, step, p + 3 * n4);
+}
+
+/*
+ *  @name DecodeNormal
+ *  @fn static void DecodeNormal(const int16_t* q, const size_t& n,
+                                 float* p)
+ *  @brief  Decode `n` octahedral normals, SSE2 version. Four normals are
+ *          decoded per iteration in (x, y, z) registers then transposed.
+ */
+static void DecodeNormal(const int16_t* q, const size_t& n, float* p) {
+  const size_t n4 = n & ~size_t(3);
+  const __m128 s = _mm_set1_ps(1.f / float(kNormalMax));
+  const __m128 one = _mm_set1_ps(1.f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 sign = _mm_set1_ps(-0.f);
+  for (size_t i = 0; i < n4; i += 4) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q +
+                                                                       2 * i));
+    // Sign extended (x0 y0 x1 y1) and (x2 y2 x3 y3)
+    const __m128 lo = _mm_mul_ps(_mm_cvtepi32_ps(
+                                   _mm_srai_epi32(_mm_unpacklo_epi16(v, v),
+                                                  16)), s);
+    const __m128 hi = _mm_mul_ps(_mm_cvtepi32_ps(
+                                   _mm_srai_epi32(_mm_unpackhi_epi16(v, v),
+                                                  16)), s);
+    __m128 x = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 y = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+    __m128 z = _mm_sub_ps(_mm_sub_ps(one, _mm_andnot_ps(sign, x)),
+                          _mm_andnot_ps(sign, y));
+    // Fold the lower hemisphere, x -= sign(x) * t with sign(0) = 1
+    const __m128 t = _mm_max_ps(_mm_sub_ps(zero, z), zero);
+    x = _mm_sub_ps(x, _mm_or_ps(t, _mm_and_ps(_mm_cmplt_ps(x, zero), sign)));
+    y = _mm_sub_ps(y, _mm_or_ps(t, _mm_and_ps(_mm_cmplt_ps(y, zero), sign)));
+    const __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x),
+                                                         _mm_mul_ps(y, y)),
+                                              _mm_mul_ps(z, z)));
+    x = _mm_div_ps(x, len);
+    y = _mm_div_ps(y, len);
+    z = _mm_div_ps(z, len);
+    __m128 w = zero;
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    // Overlapping stores, the last normal is written without its padding
+    float* dst = p + 3 * i;
+    _mm_storeu_ps(dst, x);
+    _mm_storeu_ps(dst + 3, y);
+    _mm_storeu_ps(dst + 6, z);
+    alignas(16) float last[4];
+    _mm_store_ps(last, w);
+    dst[9] = last[0];
+    dst[10] = last[1];
+    dst[11] = last[2];
+  }
+  DecodeNormal<float>(q + 2 * n4, n - n4, p + 3 * n4);
+}
+#endif
+
+/*
+ *  @name EncodeNormal
+ *  @fn template<typename T> static void EncodeNormal(const T* n,
+                                                      int16_t* q)
+ *  @brief  Octahedral encoding of one normal, a null normal maps to +z
+ */
+template<typename T>
+static void EncodeNormal(const T* n, int16_t* q) {
+  const T l1 = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+  T x = T(0.0);
+  T y = T(0.0);
+  if (l1 > T(0.0)) {
+    x = n[0] / l1;
+    y = n[1] / l1;
+    if (n[2] < T(0.0)) {
+      const T fx = (T(1.0) - std::abs(y)) * (x >= T(0.0) ? T(1.0) : T(-1.0));
+      const T fy = (T(1.0) - std::abs(x)) * (y >= T(0.0) ? T(1.0) : T(-1.0));
+      x = fx;
+      y = fy;
+    }
+  }
+  const T m = T(kNormalMax);
+  q[0] = static_cast<int16_t>(std::round(std::min(std::max(x, T(-1.0)),
+                                                  T(1.0)) * m));
+  q[1] = static_cast<int16_t>(std::round(std::min(std::max(y, T(-1.0)),
+                                                  T(1.0)) * m));
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name CompactMesh
+ *  @fn CompactMesh(void)
+ *  @brief  Constructor, empty mesh
+ */
+template<typename T>
+CompactMesh<T>::CompactMesh(void) : origin_{T(0.0), T(0.0), T(0.0)},
+                                    step_{T(0.0), T(0.0), T(0.0)} {
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name Encode
+ *  @fn int Encode(const Mesh<T>& mesh)
+ *  @brief  Quantize the vertices, normals and colors of \p mesh and share
+ *          its topology. Normals and colors are optional but must match
+ *          the number of vertices when present.
+ *  @param[in] mesh Mesh to encode
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int CompactMesh<T>::Encode(const Mesh<T>& mesh) {
+  const auto& vertex = mesh.get_vertex();
+  const auto& normal = mesh.get_normal();
+  const auto& color = mesh.get_vertex_color();
+  const size_t n_vert = vertex.size();
+  if ((!normal.empty() && normal.size() != n_vert) ||
+      (!color.empty() && color.size() != n_vert)) {
+    return -1;
+  }
+  // Quantization grid over the bounding box
+  T mn[3] = {std::numeric_limits<T>::max(),
+             std::numeric_limits<T>::max(),
+             std::numeric_limits<T>::max()};
+  T mx[3] = {std::numeric_limits<T>::lowest(),
+             std::numeric_limits<T>::lowest(),
+             std::numeric_limits<T>::lowest()};
+  for (const auto& v : vertex) {
+    mn[0] = std::min(mn[0], v.x_);
+    mn[1] = std::min(mn[1], v.y_);
+    mn[2] = std::min(mn[2], v.z_);
+    mx[0] = std::max(mx[0], v.x_);
+    mx[1] = std::max(mx[1], v.y_);
+    mx[2] = std::max(mx[2], v.z_);
+  }
+  T inv[3];
+  for (int k = 0; k < 3; ++k) {
+    origin_[k] = n_vert ? mn[k] : T(0.0);
+    step_[k] = n_vert ? (mx[k] - mn[k]) / T(kPositionMax) : T(0.0);
+    inv[k] = step_[k] > T(0.0) ? T(1.0) / step_[k] : T(0.0);
+  }
+  position_.resize(3 * n_vert);
+  normal_.resize(2 * normal.size());
+  color_.resize(4 * color.size());
+  ThreadPool::Get().ParallelFor(0,
+                                n_vert,
+                                kCompactGrain,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t i = first; i < last; ++i) {
+      const T p[3] = {vertex[i].x_, vertex[i].y_, vertex[i].z_};
+      for (int k = 0; k < 3; ++k) {
+        T v = std::round((p[k] - origin_[k]) * inv[k]);
+        v = std::min(std::max(v, T(0.0)), T(kPositionMax));
+        position_[3 * i + k] = static_cast<uint16_t>(v);
+      }
+    }
+    if (!normal.empty()) {
+      for (size_t i = first; i < last; ++i) {
+        const T n[3] = {normal[i].x_, normal[i].y_, normal[i].z_};
+        EncodeNormal(n, &normal_[2 * i]);
+      }
+    }
+    if (!color.empty()) {
+      for (size_t i = first; i < last; ++i) {
+        const T c[4] = {color[i].x_, color[i].y_, color[i].z_, color[i].w_};
+        for (int k = 0; k < 4; ++k) {
+          const T v = std::min(std::max(c[k], T(0.0)), T(1.0));
+          color_[4 * i + k] = static_cast<uint8_t>(std::round(v * T(255.0)));
+        }
+      }
+    }
+  });
+  position_.shrink_to_fit();
+  normal_.shrink_to_fit();
+  color_.shrink_to_fit();
+  topology_.ShareTopology(mesh);
+  return 0;
+}
+
+/*
+ *  @name Decode
+ *  @fn void Decode(Mesh<T>* mesh) const
+ *  @brief  Restore a full precision mesh, sharing the encoded topology.
+ *          Tangents are cleared and every vertex is marked dirty.
+ *  @param[out] mesh  Decoded mesh
+ */
+template<typename T>
+void CompactMesh<T>::Decode(Mesh<T>* mesh) const {
+  const size_t n_vert = this->n_vertex();
+  auto& vertex = mesh->get_vertex();
+  auto& normal = mesh->get_normal();
+  auto& color = mesh->get_vertex_color();
+  vertex.resize(n_vert);
+  normal.resize(this->has_normal() ? n_vert : 0);
+  color.resize(this->has_color() ? n_vert : 0);
+  mesh->get_tangent().clear();
+  mesh->ShareTopology(topology_);
+  ThreadPool::Get().ParallelFor(0,
+                                n_vert,
+                                kCompactGrain,
+                                [&](const size_t& first, const size_t& last) {
+    this->DecodeVertex(first, last, &vertex[first]);
+    if (!normal.empty()) {
+      this->DecodeNormal(first, last, &normal[first]);
+    }
+    if (!color.empty()) {
+      this->DecodeColor(first, last, &color[first]);
+    }
+  });
+  mesh->MarkDirty(0, n_vert);
+}
+
+/*
+ *  @name DecodeVertex
+ *  @fn void DecodeVertex(const size_t& first, const size_t& last,
+                          Vertex* vertex) const
+ *  @brief  Decode the positions of vertices [first, last)
+ *  @param[in] first  First vertex
+ *  @param[in] last   Past-the-end vertex
+ *  @param[out] vertex  Decoded positions, `last - first` elements
+ */
+template<typename T>
+void CompactMesh<T>::DecodeVertex(const size_t& first,
+                                  const size_t& last,
+                                  Vertex* vertex) const {
+  static_assert(sizeof(Vertex) == 3 * sizeof(T), "Vertex must be packed");
+  if (first >= last) {
+    return;
+  }
+  DecodePosition(&position_[3 * first],
+                 last - first,
+                 origin_,
+                 step_,
+                 reinterpret_cast<T*>(vertex));
+}
+
+/*
+ *  @name DecodeNormal
+ *  @fn void DecodeNormal(const size_t& first, const size_t& last,
+                          Normal* normal) const
+ *  @brief  Decode the unit normals of vertices [first, last)
+ *  @param[in] first  First vertex
+ *  @param[in] last   Past-the-end vertex
+ *  @param[out] normal  Decoded normals, `last - first` elements
+ */
+template<typename T>
+void CompactMesh<T>::DecodeNormal(const size_t& first,
+                                  const size_t& last,
+                                  Normal* normal) const {
+  static_assert(sizeof(Normal) == 3 * sizeof(T), "Normal must be packed");
+  if (first >= last) {
+    return;
+  }
+  FaceKit::DecodeNormal(&normal_[2 * first],
+                        last - first,
+                        reinterpret_cast<T*>(normal));
+}
+
+/*
+ *  @name DecodeColor
+ *  @fn void DecodeColor(const size_t& first, const size_t& last,
+                         Color* color) const
+ *  @brief  Decode the colors of vertices [first, last)
+ *  @param[in] first  First vertex
+ *  @param[in] last   Past-the-end vertex
+ *  @param[out] color Decoded colors, `last - first` elements
+ */
+template<typename T>
+void CompactMesh<T>::DecodeColor(const size_t& first,
+                                 const size_t& last,
+                                 Color* color) const {
+  const T s = T(1.0) / T(255.0);
+  for (size_t i = first; i < last; ++i, ++color) {
+    const uint8_t* c = &color_[4 * i];
+    *color = Color(T(c[0]) * s, T(c[1]) * s, T(c[2]) * s, T(c[3]) * s);
+  }
+}
+
+#pragma mark -
+#pragma mark Declaration
+
+/** Float */
+template class CompactMesh<float>;
+/** Double */
+template class CompactMesh<double>;
+
+}  // namespace FaceKit
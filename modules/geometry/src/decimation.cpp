@@ -0,0 +1,857 @@
+/**
+ *  @file   decimation.cpp
+ *  @brief  Mesh simplification with quadric error metric and level of
+ *          detail generation
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   30.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <utility>
+
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/geometry/decimation.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Largest quadric dimension: position, texture coordinate and color */
+static constexpr int kMaxQuadricDim = 8;
+
+#pragma mark -
+#pragma mark Quadric
+
+/**
+ *  @name   QuadricSize
+ *  @fn     static int QuadricSize(const int& d)
+ *  @brief  Number of coefficients of a packed quadric of dimension `d`:
+ *          upper triangle of A, b and c
+ */
+static int QuadricSize(const int& d) {
+  return (d * (d + 1)) / 2 + d + 1;
+}
+
+/**
+ *  @name   EvalQuadric
+ *  @fn     static double EvalQuadric(const double* q, const double* x,
+                                      const int& d)
+ *  @brief  Evaluate x'Ax + 2b'x + c
+ */
+static double EvalQuadric(const double* q, const double* x, const int& d) {
+  const double* b = q + (d * (d + 1)) / 2;
+  double err = b[d];
+  for (int i = 0; i < d; ++i) {
+    double row = *q++ * x[i];
+    for (int j = i + 1; j < d; ++j) {
+      row += 2.0 * *q++ * x[j];
+    }
+    err += x[i] * (row + 2.0 * b[i]);
+  }
+  return err;
+}
+
+/**
+ *  @name   AddFaceQuadric
+ *  @fn     static void AddFaceQuadric(const double* p, const double* q,
+                                       const double* r, const int& d,
+                                       double* quad)
+ *  @brief  Add the area weighted squared distance to the plane spanned by a
+ *          triangle in the d-dimensional feature space (Garland & Heckbert,
+ *          1998). Degenerate triangles are ignored.
+ */
+static void AddFaceQuadric(const double* p,
+                           const double* q,
+                           const double* r,
+                           const int& d,
+                           double* quad) {
+  // Orthonormal basis of the triangle's plane
+  double e1[kMaxQuadricDim], e2[kMaxQuadricDim];
+  double n1 = 0.0, d12 = 0.0;
+  for (int i = 0; i < d; ++i) {
+    e1[i] = q[i] - p[i];
+    e2[i] = r[i] - p[i];
+    n1 += e1[i] * e1[i];
+  }
+  if (n1 <= 0.0) {
+    return;
+  }
+  n1 = 1.0 / std::sqrt(n1);
+  for (int i = 0; i < d; ++i) {
+    e1[i] *= n1;
+    d12 += e1[i] * e2[i];
+  }
+  double n2 = 0.0;
+  for (int i = 0; i < d; ++i) {
+    e2[i] -= d12 * e1[i];
+    n2 += e2[i] * e2[i];
+  }
+  // Area, from the geometric part only
+  const double u[3] = {q[0] - p[0], q[1] - p[1], q[2] - p[2]};
+  const double v[3] = {r[0] - p[0], r[1] - p[1], r[2] - p[2]};
+  const double cx = u[1] * v[2] - u[2] * v[1];
+  const double cy = u[2] * v[0] - u[0] * v[2];
+  const double cz = u[0] * v[1] - u[1] * v[0];
+  const double w = 0.5 * std::sqrt(cx * cx + cy * cy + cz * cz);
+  if (n2 <= 0.0 || w <= 0.0) {
+    return;
+  }
+  n2 = 1.0 / std::sqrt(n2);
+  double pe1 = 0.0, pe2 = 0.0, pp = 0.0;
+  for (int i = 0; i < d; ++i) {
+    e2[i] *= n2;
+    pe1 += p[i] * e1[i];
+    pe2 += p[i] * e2[i];
+    pp += p[i] * p[i];
+  }
+  // A = I - e1e1' - e2e2', b = (p'e1)e1 + (p'e2)e2 - p,
+  // c = p'p - (p'e1)^2 - (p'e2)^2
+  for (int i = 0; i < d; ++i) {
+    for (int j = i; j < d; ++j) {
+      const double a = (i == j ? 1.0 : 0.0) - e1[i] * e1[j] - e2[i] * e2[j];
+      *quad++ += w * a;
+    }
+  }
+  for (int i = 0; i < d; ++i) {
+    *quad++ += w * (pe1 * e1[i] + pe2 * e2[i] - p[i]);
+  }
+  *quad += w * (pp - pe1 * pe1 - pe2 * pe2);
+}
+
+/**
+ *  @name   AddPlaneQuadric
+ *  @fn     static void AddPlaneQuadric(const double* n, const double& dist,
+                                        const double& w, const int& d,
+                                        double* quad)
+ *  @brief  Add the weighted squared distance to the plane n'x + dist = 0,
+ *          acting on positions only
+ */
+static void AddPlaneQuadric(const double* n,
+                            const double& dist,
+                            const double& w,
+                            const int& d,
+                            double* quad) {
+  for (int i = 0; i < d; ++i) {
+    for (int j = i; j < d; ++j) {
+      if (j < 3) {
+        *quad += w * n[i] * n[j];
+      }
+      ++quad;
+    }
+  }
+  for (int i = 0; i < 3; ++i) {
+    quad[i] += w * dist * n[i];
+  }
+  quad[d] += w * dist * dist;
+}
+
+#pragma mark -
+#pragma mark Collapse
+
+/**
+ *  @struct Candidate
+ *  @brief  Best collapse of a vertex, stale once the vertex' stamp changes
+ */
+struct Candidate {
+  /** Error */
+  double cost;
+  /** Removed vertex */
+  int u;
+  /** Kept vertex */
+  int v;
+  /** Stamp of `u` at evaluation time */
+  uint32_t stamp;
+
+  /** Order of the min-heap */
+  bool operator>(const Candidate& rhs) const {
+    return cost > rhs.cost;
+  }
+};
+
+/**
+ *  @struct Scratch
+ *  @brief  Temporary buffers of a candidate evaluation
+ */
+struct Scratch {
+  /** Neighbours of the removed vertex */
+  std::vector<int> ring_u;
+  /** Neighbours of the kept vertex */
+  std::vector<int> ring_v;
+  /** Cost of each collapse, with kept vertex */
+  std::vector<std::pair<double, int>> cost;
+};
+
+/**
+ *  @class  Collapser
+ *  @brief  Simplification state: dynamic vertex / triangle adjacency,
+ *          quadrics and priority queue of half-edge collapses
+ */
+template<typename T>
+class Collapser {
+ public:
+  /** Triangle */
+  using Triangle = typename Mesh<T>::Triangle;
+  /** Options */
+  using Options = typename MeshDecimator<T>::Options;
+  /** Level */
+  using Level = typename MeshDecimator<T>::Level;
+
+  /**
+   *  @name Init
+   *  @fn int Init(const Mesh<T>& mesh, const Options& options)
+   *  @brief  Compute quadrics and initial candidates
+   *  @return -1 if error, 0 otherwise
+   */
+  int Init(const Mesh<T>& mesh, const Options& options);
+
+  /**
+   *  @name Run
+   *  @fn void Run(const size_t& n_vertex)
+   *  @brief  Collapse until `n_vertex` vertices remain or no valid collapse
+   *          is left
+   */
+  void Run(const size_t& n_vertex);
+
+  /**
+   *  @name Extract
+   *  @fn void Extract(Level* level) const
+   *  @brief  Export the current state
+   */
+  void Extract(Level* level) const;
+
+ private:
+  /**
+   *  @name Ring
+   *  @fn void Ring(const int& u, std::vector<int>* ring) const
+   *  @brief  Sorted neighbours of a vertex
+   */
+  void Ring(const int& u, std::vector<int>* ring) const;
+
+  /**
+   *  @name Evaluate
+   *  @fn bool Evaluate(const int& u, Scratch* scratch,
+                        Candidate* cand) const
+   *  @brief  Find the best valid collapse of `u` into one of its neighbours
+   *  @return True if a valid collapse exists
+   */
+  bool Evaluate(const int& u, Scratch* scratch, Candidate* cand) const;
+
+  /**
+   *  @name IsValid
+   *  @fn bool IsValid(const int& u, const int& v,
+                       const std::vector<int>& ring_u,
+                       const std::vector<int>& ring_v) const
+   *  @brief  Check that collapsing `u` into `v` keeps the mesh manifold
+   *          and does not fold faces
+   */
+  bool IsValid(const int& u,
+               const int& v,
+               const std::vector<int>& ring_u,
+               const std::vector<int>& ring_v) const;
+
+  /**
+   *  @name Collapse
+   *  @fn void Collapse(const int& u, const int& v)
+   *  @brief  Remove `u`, its faces are attached to `v`
+   */
+  void Collapse(const int& u, const int& v);
+
+  /** Source mesh */
+  const Mesh<T>* mesh_ = nullptr;
+  /** Options */
+  Options options_;
+  /** Feature dimension */
+  int dim_ = 3;
+  /** Quadric size */
+  int q_size_ = 0;
+  /** Normalized features, `dim_` per vertex */
+  std::vector<double> feature_;
+  /** Quadrics, `q_size_` per vertex */
+  std::vector<double> quadric_;
+  /** Triangles, updated by collapses */
+  std::vector<Triangle> tri_;
+  /** Triangles still in use */
+  std::vector<uint8_t> tri_alive_;
+  /** Triangles attached to each vertex */
+  std::vector<std::vector<int>> vertex_tri_;
+  /** Vertex on an open boundary */
+  std::vector<uint8_t> boundary_;
+  /** Vertex that can not be removed */
+  std::vector<uint8_t> locked_;
+  /** Candidate version of each vertex */
+  std::vector<uint32_t> stamp_;
+  /** Min-heap of candidates */
+  std::vector<Candidate> heap_;
+  /** Number of vertices in use */
+  size_t n_live_ = 0;
+  /** Largest collapse error */
+  double error_ = 0.0;
+  /** Neighbours updated by a collapse */
+  std::vector<int> ring_;
+  /** Buffers of sequential evaluations */
+  Scratch scratch_;
+};
+
+/*
+ *  @name Init
+ *  @fn int Init(const Mesh<T>& mesh, const Options& options)
+ *  @brief  Compute quadrics and initial candidates
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int Collapser<T>::Init(const Mesh<T>& mesh, const Options& options) {
+  const auto& vertex = mesh.get_vertex();
+  const auto& tcoord = mesh.get_tex_coord();
+  const auto& color = mesh.get_vertex_color();
+  const int n_vertex = static_cast<int>(vertex.size());
+  mesh_ = &mesh;
+  options_ = options;
+  tri_ = mesh.get_triangle();
+  if (tri_.empty()) {
+    std::cout << "Error, can not decimate a mesh without triangles"
+              << std::endl;
+    return -1;
+  }
+  for (const auto& t : tri_) {
+    if (std::min({t.x_, t.y_, t.z_}) < 0 ||
+        std::max({t.x_, t.y_, t.z_}) >= n_vertex) {
+      std::cout << "Error, triangle index out of range" << std::endl;
+      return -1;
+    }
+  }
+  locked_.assign(n_vertex, 0);
+  for (const int& p : options.preserved) {
+    if (p < 0 || p >= n_vertex) {
+      std::cout << "Error, preserved vertex out of range" << std::endl;
+      return -1;
+    }
+    locked_[p] = 1;
+  }
+  // Features: positions normalized by the bounding box diagonal, per-vertex
+  // attributes scaled by their weight
+  const bool has_tcoord = tcoord.size() == vertex.size() &&
+                          options.attribute_weight > T(0.0);
+  const bool has_color = color.size() == vertex.size() &&
+                         options.attribute_weight > T(0.0);
+  dim_ = 3 + (has_tcoord ? 2 : 0) + (has_color ? 3 : 0);
+  q_size_ = QuadricSize(dim_);
+  double lo[3], hi[3];
+  for (int k = 0; k < 3; ++k) {
+    lo[k] = std::numeric_limits<double>::max();
+    hi[k] = std::numeric_limits<double>::lowest();
+  }
+  for (const auto& p : vertex) {
+    const T* x = &p.x_;
+    for (int k = 0; k < 3; ++k) {
+      lo[k] = std::min(lo[k], double(x[k]));
+      hi[k] = std::max(hi[k], double(x[k]));
+    }
+  }
+  double diag = 0.0;
+  for (int k = 0; k < 3; ++k) {
+    diag += (hi[k] - lo[k]) * (hi[k] - lo[k]);
+  }
+  const double scale = diag > 0.0 ? 1.0 / std::sqrt(diag) : 1.0;
+  const double w_attr = double(options.attribute_weight);
+  feature_.resize(size_t(n_vertex) * dim_);
+  for (int i = 0; i < n_vertex; ++i) {
+    double* f = &feature_[size_t(i) * dim_];
+    const T* x = &vertex[i].x_;
+    for (int k = 0; k < 3; ++k) {
+      *f++ = (double(x[k]) - lo[k]) * scale;
+    }
+    if (has_tcoord) {
+      *f++ = w_attr * double(tcoord[i].x_);
+      *f++ = w_attr * double(tcoord[i].y_);
+    }
+    if (has_color) {
+      *f++ = w_attr * double(color[i].x_);
+      *f++ = w_attr * double(color[i].y_);
+      *f++ = w_attr * double(color[i].z_);
+    }
+  }
+  // Adjacency
+  const int n_tri = static_cast<int>(tri_.size());
+  tri_alive_.assign(n_tri, 1);
+  vertex_tri_.assign(n_vertex, std::vector<int>());
+  for (int t = 0; t < n_tri; ++t) {
+    vertex_tri_[tri_[t].x_].push_back(t);
+    vertex_tri_[tri_[t].y_].push_back(t);
+    vertex_tri_[tri_[t].z_].push_back(t);
+  }
+  n_live_ = 0;
+  for (const auto& vt : vertex_tri_) {
+    n_live_ += vt.empty() ? 0 : 1;
+  }
+  // Face quadrics, accumulated per vertex in parallel
+  quadric_.assign(size_t(n_vertex) * q_size_, 0.0);
+  auto& pool = ThreadPool::Get();
+  pool.ParallelFor(0, n_vertex, 0, [&](const size_t& first,
+                                       const size_t& last) {
+    for (size_t i = first; i < last; ++i) {
+      double* q = &quadric_[i * q_size_];
+      for (const int& t : vertex_tri_[i]) {
+        const Triangle& tri = tri_[t];
+        AddFaceQuadric(&feature_[size_t(tri.x_) * dim_],
+                       &feature_[size_t(tri.y_) * dim_],
+                       &feature_[size_t(tri.z_) * dim_],
+                       dim_,
+                       q);
+      }
+    }
+  });
+  // Open boundaries: edges used by a single face, constrained by a plane
+  // orthogonal to the face
+  std::vector<std::pair<uint64_t, int>> edges;
+  edges.reserve(3 * tri_.size());
+  for (int t = 0; t < n_tri; ++t) {
+    const int* idx = &tri_[t].x_;
+    for (int k = 0; k < 3; ++k) {
+      const uint64_t a = static_cast<uint32_t>(idx[k]);
+      const uint64_t b = static_cast<uint32_t>(idx[(k + 1) % 3]);
+      edges.emplace_back(a < b ? (a << 32) | b : (b << 32) | a, 3 * t + k);
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+  boundary_.assign(n_vertex, 0);
+  const double w_bnd = double(options.boundary_weight);
+  for (size_t e = 0; e < edges.size(); ) {
+    size_t e_end = e + 1;
+    while (e_end < edges.size() && edges[e_end].first == edges[e].first) {
+      ++e_end;
+    }
+    if (e_end - e == 1) {
+      const int t = edges[e].second / 3;
+      const int k = edges[e].second % 3;
+      const int* idx = &tri_[t].x_;
+      const int a = idx[k];
+      const int b = idx[(k + 1) % 3];
+      const int c = idx[(k + 2) % 3];
+      boundary_[a] = 1;
+      boundary_[b] = 1;
+      const double* pa = &feature_[size_t(a) * dim_];
+      const double* pb = &feature_[size_t(b) * dim_];
+      const double* pc = &feature_[size_t(c) * dim_];
+      const double ab[3] = {pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2]};
+      const double ac[3] = {pc[0] - pa[0], pc[1] - pa[1], pc[2] - pa[2]};
+      const double fn[3] = {ab[1] * ac[2] - ab[2] * ac[1],
+                            ab[2] * ac[0] - ab[0] * ac[2],
+                            ab[0] * ac[1] - ab[1] * ac[0]};
+      double n[3] = {ab[1] * fn[2] - ab[2] * fn[1],
+                     ab[2] * fn[0] - ab[0] * fn[2],
+                     ab[0] * fn[1] - ab[1] * fn[0]};
+      const double len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      if (len > 0.0) {
+        n[0] /= len;
+        n[1] /= len;
+        n[2] /= len;
+        const double dist = -(n[0] * pa[0] + n[1] * pa[1] + n[2] * pa[2]);
+        const double w = w_bnd * (ab[0] * ab[0] + ab[1] * ab[1] +
+                                  ab[2] * ab[2]);
+        AddPlaneQuadric(n, dist, w, dim_, &quadric_[size_t(a) * q_size_]);
+        AddPlaneQuadric(n, dist, w, dim_, &quadric_[size_t(b) * q_size_]);
+      }
+    }
+    e = e_end;
+  }
+  // Initial candidates
+  stamp_.assign(n_vertex, 0);
+  std::vector<Candidate> cand(n_vertex);
+  std::vector<uint8_t> valid(n_vertex, 0);
+  pool.ParallelFor(0, n_vertex, 0, [&](const size_t& first,
+                                       const size_t& last) {
+    Scratch scratch;
+    for (size_t i = first; i < last; ++i) {
+      valid[i] = this->Evaluate(static_cast<int>(i), &scratch, &cand[i]);
+    }
+  });
+  heap_.clear();
+  for (int i = 0; i < n_vertex; ++i) {
+    if (valid[i]) {
+      heap_.push_back(cand[i]);
+    }
+  }
+  std::make_heap(heap_.begin(), heap_.end(), std::greater<Candidate>());
+  error_ = 0.0;
+  return 0;
+}
+
+/*
+ *  @name Ring
+ *  @fn void Ring(const int& u, std::vector<int>* ring) const
+ *  @brief  Sorted neighbours of a vertex
+ */
+template<typename T>
+void Collapser<T>::Ring(const int& u, std::vector<int>* ring) const {
+  ring->clear();
+  for (const int& t : vertex_tri_[u]) {
+    const int* idx = &tri_[t].x_;
+    for (int k = 0; k < 3; ++k) {
+      if (idx[k] != u) {
+        ring->push_back(idx[k]);
+      }
+    }
+  }
+  std::sort(ring->begin(), ring->end());
+  ring->erase(std::unique(ring->begin(), ring->end()), ring->end());
+}
+
+/*
+ *  @name Evaluate
+ *  @fn bool Evaluate(const int& u, Scratch* scratch, Candidate* cand) const
+ *  @brief  Find the best valid collapse of `u` into one of its neighbours,
+ *          candidates are validated by increasing cost
+ *  @return True if a valid collapse exists
+ */
+template<typename T>
+bool Collapser<T>::Evaluate(const int& u,
+                            Scratch* scratch,
+                            Candidate* cand) const {
+  if (locked_[u] || vertex_tri_[u].empty()) {
+    return false;
+  }
+  this->Ring(u, &scratch->ring_u);
+  const double* q_u = &quadric_[size_t(u) * q_size_];
+  scratch->cost.clear();
+  for (const int& v : scratch->ring_u) {
+    const double* f_v = &feature_[size_t(v) * dim_];
+    const double cost = (EvalQuadric(q_u, f_v, dim_) +
+                         EvalQuadric(&quadric_[size_t(v) * q_size_],
+                                     f_v,
+                                     dim_));
+    scratch->cost.emplace_back(std::max(cost, 0.0), v);
+  }
+  std::sort(scratch->cost.begin(), scratch->cost.end());
+  for (const auto& c : scratch->cost) {
+    this->Ring(c.second, &scratch->ring_v);
+    if (this->IsValid(u, c.second, scratch->ring_u, scratch->ring_v)) {
+      cand->cost = c.first;
+      cand->u = u;
+      cand->v = c.second;
+      cand->stamp = stamp_[u];
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ *  @name IsValid
+ *  @fn bool IsValid(const int& u, const int& v,
+                     const std::vector<int>& ring_u,
+                     const std::vector<int>& ring_v) const
+ *  @brief  Check that collapsing `u` into `v` keeps the mesh manifold
+ *          and does not fold faces
+ */
+template<typename T>
+bool Collapser<T>::IsValid(const int& u,
+                           const int& v,
+                           const std::vector<int>& ring_u,
+                           const std::vector<int>& ring_v) const {
+  // Faces on the edge, a boundary vertex only moves along the boundary
+  int n_shared = 0;
+  for (const int& t : vertex_tri_[u]) {
+    const Triangle& tri = tri_[t];
+    n_shared += (tri.x_ == v || tri.y_ == v || tri.z_ == v) ? 1 : 0;
+  }
+  if (n_shared == 0 || n_shared > 2 || (boundary_[u] && n_shared != 1)) {
+    return false;
+  }
+  // Link condition: common neighbours are the faces' opposite vertices
+  int n_common = 0;
+  auto it_u = ring_u.begin();
+  auto it_v = ring_v.begin();
+  while (it_u != ring_u.end() && it_v != ring_v.end()) {
+    if (*it_u < *it_v) {
+      ++it_u;
+    } else if (*it_v < *it_u) {
+      ++it_v;
+    } else {
+      ++n_common;
+      ++it_u;
+      ++it_v;
+    }
+  }
+  if (n_common != n_shared) {
+    return false;
+  }
+  // Avoid collapsing to a degenerate piece (i.e. tetrahedron, triangle)
+  const size_t n_ring = ring_u.size() + ring_v.size() - n_common - 2;
+  if (n_ring < (boundary_[v] ? 2 : 3)) {
+    return false;
+  }
+  // Folds
+  const auto& vertex = mesh_->get_vertex();
+  const T min_cos = options_.min_normal_cos;
+  for (const int& t : vertex_tri_[u]) {
+    const int* idx = &tri_[t].x_;
+    if (idx[0] == v || idx[1] == v || idx[2] == v) {
+      continue;
+    }
+    const int k = idx[0] == u ? 0 : (idx[1] == u ? 1 : 2);
+    const Vector3<T>& a = vertex[idx[(k + 1) % 3]];
+    const Vector3<T>& b = vertex[idx[(k + 2) % 3]];
+    const Vector3<T> n_old = (a - vertex[u]) ^ (b - vertex[u]);
+    const Vector3<T> n_new = (a - vertex[v]) ^ (b - vertex[v]);
+    const T l_old = n_old.Norm();
+    const T l_new = n_new.Norm();
+    if (l_new <= T(1e-6) * l_old || (n_old * n_new) < min_cos * l_old * l_new) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ *  @name Collapse
+ *  @fn void Collapse(const int& u, const int& v)
+ *  @brief  Remove `u`, its faces are attached to `v`
+ */
+template<typename T>
+void Collapser<T>::Collapse(const int& u, const int& v) {
+  for (const int& t : vertex_tri_[u]) {
+    int* idx = &tri_[t].x_;
+    if (idx[0] == v || idx[1] == v || idx[2] == v) {
+      // Face on the edge disappears
+      tri_alive_[t] = 0;
+      for (int k = 0; k < 3; ++k) {
+        if (idx[k] != u) {
+          auto& vt = vertex_tri_[idx[k]];
+          vt.erase(std::find(vt.begin(), vt.end(), t));
+        }
+      }
+    } else {
+      for (int k = 0; k < 3; ++k) {
+        idx[k] = idx[k] == u ? v : idx[k];
+      }
+      vertex_tri_[v].push_back(t);
+    }
+  }
+  vertex_tri_[u].clear();
+  // Error accumulates on the kept vertex
+  double* q_u = &quadric_[size_t(u) * q_size_];
+  double* q_v = &quadric_[size_t(v) * q_size_];
+  for (int k = 0; k < q_size_; ++k) {
+    q_v[k] += q_u[k];
+  }
+  n_live_ -= 1;
+  // Candidates of `v` and its neighbours changed
+  std::vector<int>& ring = ring_;
+  this->Ring(v, &ring);
+  ring.push_back(v);
+  for (const int& w : ring) {
+    stamp_[w] += 1;
+    Candidate cand;
+    if (this->Evaluate(w, &scratch_, &cand)) {
+      heap_.push_back(cand);
+      std::push_heap(heap_.begin(), heap_.end(), std::greater<Candidate>());
+    }
+  }
+  stamp_[u] += 1;
+}
+
+/*
+ *  @name Run
+ *  @fn void Run(const size_t& n_vertex)
+ *  @brief  Collapse until `n_vertex` vertices remain or no valid collapse
+ *          is left
+ */
+template<typename T>
+void Collapser<T>::Run(const size_t& n_vertex) {
+  const double max_error = double(options_.max_error);
+  while (n_live_ > n_vertex && !heap_.empty()) {
+    const Candidate top = heap_.front();
+    if (top.stamp != stamp_[top.u]) {
+      std::pop_heap(heap_.begin(), heap_.end(), std::greater<Candidate>());
+      heap_.pop_back();
+      continue;
+    }
+    if (top.cost > max_error) {
+      break;
+    }
+    std::pop_heap(heap_.begin(), heap_.end(), std::greater<Candidate>());
+    heap_.pop_back();
+    error_ = std::max(error_, top.cost);
+    this->Collapse(top.u, top.v);
+  }
+}
+
+/*
+ *  @name Extract
+ *  @fn void Extract(Level* level) const
+ *  @brief  Export the current state
+ */
+template<typename T>
+void Collapser<T>::Extract(Level* level) const {
+  const auto& vertex = mesh_->get_vertex();
+  const auto& normal = mesh_->get_normal();
+  const auto& tcoord = mesh_->get_tex_coord();
+  const auto& color = mesh_->get_vertex_color();
+  // Remaining vertices, original order is kept
+  std::vector<int> remap(vertex.size(), -1);
+  level->vertex_index.clear();
+  for (size_t i = 0; i < vertex.size(); ++i) {
+    if (!vertex_tri_[i].empty()) {
+      remap[i] = static_cast<int>(level->vertex_index.size());
+      level->vertex_index.push_back(static_cast<int>(i));
+    }
+  }
+  Mesh<T> mesh;
+  auto& m_vertex = mesh.get_vertex();
+  m_vertex.reserve(level->vertex_index.size());
+  for (const int& i : level->vertex_index) {
+    m_vertex.push_back(vertex[i]);
+  }
+  if (tcoord.size() == vertex.size()) {
+    auto& m_tcoord = mesh.get_tex_coord();
+    for (const int& i : level->vertex_index) {
+      m_tcoord.push_back(tcoord[i]);
+    }
+  }
+  if (color.size() == vertex.size()) {
+    auto& m_color = mesh.get_vertex_color();
+    for (const int& i : level->vertex_index) {
+      m_color.push_back(color[i]);
+    }
+  }
+  auto& m_tri = mesh.get_triangle();
+  for (size_t t = 0; t < tri_.size(); ++t) {
+    if (tri_alive_[t]) {
+      const Triangle& tri = tri_[t];
+      m_tri.emplace_back(remap[tri.x_], remap[tri.y_], remap[tri.z_]);
+    }
+  }
+  if (!normal.empty()) {
+    mesh.ComputeVertexNormalFromFaces();
+  }
+  level->mesh = std::move(mesh);
+  level->error = static_cast<T>(error_);
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name Decimate
+ *  @fn int Decimate(const Mesh<T>& mesh, const size_t& n_vertex,
+                     Level* level) const
+ *  @brief  Simplify a mesh down to a given number of vertices
+ *  @param[in] mesh     Mesh to simplify
+ *  @param[in] n_vertex Target number of vertices, can be larger in the
+ *                      end if no valid collapse remains or `max_error` is
+ *                      reached
+ *  @param[out] level   Simplified mesh
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int MeshDecimator<T>::Decimate(const Mesh<T>& mesh,
+                               const size_t& n_vertex,
+                               Level* level) const {
+  Collapser<T> collapser;
+  if (collapser.Init(mesh, options_)) {
+    return -1;
+  }
+  collapser.Run(n_vertex);
+  collapser.Extract(level);
+  return 0;
+}
+
+/*
+ *  @name BuildLOD
+ *  @fn int BuildLOD(const Mesh<T>& mesh, const size_t& n_level,
+                     const T& factor, std::vector<Level>* lod) const
+ *  @brief  Generate a chain of nested levels of detail in a single
+ *          simplification run. Level 0 is the original mesh, level `k`
+ *          has `factor^k` times fewer vertices.
+ *  @param[in] mesh     Mesh to simplify
+ *  @param[in] n_level  Number of levels, including the original mesh
+ *  @param[in] factor   Reduction factor between two levels, > 1
+ *  @param[out] lod     Levels, finest first
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int MeshDecimator<T>::BuildLOD(const Mesh<T>& mesh,
+                               const size_t& n_level,
+                               const T& factor,
+                               std::vector<Level>* lod) const {
+  if (n_level == 0 || factor <= T(1.0)) {
+    std::cout << "Error, LOD needs at least one level and a factor > 1"
+              << std::endl;
+    return -1;
+  }
+  std::vector<size_t> n_vertex;
+  double n = static_cast<double>(mesh.get_vertex().size());
+  for (size_t k = 1; k < n_level; ++k) {
+    n /= double(factor);
+    n_vertex.push_back(static_cast<size_t>(std::ceil(n)));
+  }
+  std::vector<Level> coarse;
+  if (!n_vertex.empty() && this->BuildLOD(mesh, n_vertex, &coarse)) {
+    return -1;
+  }
+  // Finest level is the original mesh, topology is shared
+  lod->clear();
+  lod->reserve(n_level);
+  lod->emplace_back();
+  lod->back().mesh = mesh;
+  lod->back().vertex_index.resize(mesh.get_vertex().size());
+  for (size_t i = 0; i < mesh.get_vertex().size(); ++i) {
+    lod->back().vertex_index[i] = static_cast<int>(i);
+  }
+  for (auto& level : coarse) {
+    lod->push_back(std::move(level));
+  }
+  return 0;
+}
+
+/*
+ *  @name BuildLOD
+ *  @fn int BuildLOD(const Mesh<T>& mesh,
+                     const std::vector<size_t>& n_vertex,
+                     std::vector<Level>* lod) const
+ *  @brief  Generate nested levels of detail with explicit vertex counts
+ *  @param[in] mesh     Mesh to simplify
+ *  @param[in] n_vertex Target number of vertices of each level, in
+ *                      decreasing order
+ *  @param[out] lod     Levels, same order as `n_vertex`
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int MeshDecimator<T>::BuildLOD(const Mesh<T>& mesh,
+                               const std::vector<size_t>& n_vertex,
+                               std::vector<Level>* lod) const {
+  if (!std::is_sorted(n_vertex.rbegin(), n_vertex.rend())) {
+    std::cout << "Error, LOD vertex counts must be decreasing" << std::endl;
+    return -1;
+  }
+  Collapser<T> collapser;
+  if (collapser.Init(mesh, options_)) {
+    return -1;
+  }
+  lod->resize(n_vertex.size());
+  for (size_t k = 0; k < n_vertex.size(); ++k) {
+    collapser.Run(n_vertex[k]);
+    collapser.Extract(&(*lod)[k]);
+  }
+  return 0;
+}
+
+#pragma mark -
+#pragma mark Declaration
+
+/** Float */
+template class MeshDecimator<float>;
+/** Double */
+template class MeshDecimator<double>;
+
+}  // namespace FaceKit
@@ -0,0 +1,353 @@
+/**
+ *  @file   laplacian.cpp
+ *  @brief  Discrete Laplace-Beltrami operator of a triangle mesh
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   01.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/geometry/laplacian.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Number of vertices sharing a dirty flag */
+static constexpr size_t kLaplacianBlockSize = 1024;
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name Build
+ *  @fn int Build(const Mesh<T>& mesh)
+ *  @brief  Build the sparsity pattern from the mesh connectivity and
+ *          compute every weight. `Mesh::BuildConnectivity` must have been
+ *          called.
+ *  @param[in] mesh Mesh
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int MeshLaplacian<T>::Build(const Mesh<T>& mesh) {
+  const size_t n_vert = mesh.get_vertex().size();
+  const size_t n_tri = mesh.get_triangle().size();
+  const auto& con_offset = mesh.get_vertex_con_offset();
+  const auto& con = mesh.get_vertex_con();
+  const auto& tri_offset = mesh.get_vertex_tri_offset();
+  const auto& vertex_tri = mesh.get_vertex_tri();
+  if (n_vert == 0 || n_tri == 0) {
+    std::cout << "Error, empty mesh" << std::endl;
+    return -1;
+  }
+  if (con_offset.size() != n_vert + 1 || tri_offset.size() != n_vert + 1 ||
+      vertex_tri.size() != 3 * n_tri) {
+    std::cout << "Error, mesh connectivity is not built" << std::endl;
+    return -1;
+  }
+  // Pattern: neighbours plus the diagonal, already in row/column order
+  using Triplet = typename SparseMatrix<T>::Triplet;
+  std::vector<Triplet> entries;
+  entries.reserve(con.size() + n_vert);
+  for (size_t v = 0; v < n_vert; ++v) {
+    const int r = static_cast<int>(v);
+    bool diag = false;
+    for (size_t k = con_offset[v]; k < con_offset[v + 1]; ++k) {
+      if (!diag && con[k] > r) {
+        entries.push_back({r, r, T(0.0)});
+        diag = true;
+      }
+      entries.push_back({r, con[k], T(0.0)});
+    }
+    if (!diag) {
+      entries.push_back({r, r, T(0.0)});
+    }
+  }
+  const int n = static_cast<int>(n_vert);
+  if (!laplacian_.FromTriplets(n, n, entries).Good()) {
+    std::cout << "Error, invalid connectivity" << std::endl;
+    return -1;
+  }
+  // Position of the two other corners of each incident triangle in the row
+  const auto& row_ptr = laplacian_.row_ptr();
+  const auto& col_idx = laplacian_.col_idx();
+  const auto& tri = mesh.get_triangle();
+  slot_.resize(2 * vertex_tri.size());
+  ThreadPool::Get().ParallelFor(0, n_vert, 0, [&](const size_t& first,
+                                                   const size_t& last) {
+    for (size_t v = first; v < last; ++v) {
+      auto row_first = col_idx.begin() + row_ptr[v];
+      auto row_last = col_idx.begin() + row_ptr[v + 1];
+      for (size_t k = tri_offset[v]; k < tri_offset[v + 1]; ++k) {
+        const int* idx = &(tri[vertex_tri[k]].x_);
+        const int c = idx[0] == static_cast<int>(v) ? 0 :
+                      (idx[1] == static_cast<int>(v) ? 1 : 2);
+        for (int e = 1; e < 3; ++e) {
+          auto it = std::lower_bound(row_first, row_last, idx[(c + e) % 3]);
+          slot_[2 * k + e - 1] = static_cast<int>(it - col_idx.begin());
+        }
+      }
+    }
+  });
+  n_tri_ = n_tri;
+  tri_data_.resize(4 * n_tri);
+  mass_.resize(n_vert);
+  dirty_.assign((n_vert + kLaplacianBlockSize - 1) / kLaplacianBlockSize, 0);
+  tri_stamp_.assign(n_tri, 0);
+  row_stamp_.assign(n_vert, 0);
+  stamp_ = 0;
+  this->ComputeTriangles(mesh, std::vector<int>());
+  this->AssembleRows(mesh, std::vector<int>());
+  return 0;
+}
+
+/*
+ *  @name MarkDirty
+ *  @fn void MarkDirty(const size_t& first, const size_t& last)
+ *  @brief  Flag vertices [first, last) as moved, their weights are
+ *          recomputed by the next `Update`
+ *  @param[in] first  First modified vertex
+ *  @param[in] last   Past-the-end modified vertex
+ */
+template<typename T>
+void MeshLaplacian<T>::MarkDirty(const size_t& first, const size_t& last) {
+  const size_t end = std::min(last, mass_.size());
+  if (first >= end) {
+    return;
+  }
+  for (size_t b = first / kLaplacianBlockSize;
+       b <= (end - 1) / kLaplacianBlockSize;
+       ++b) {
+    dirty_[b] = 1;
+  }
+}
+
+/*
+ *  @name Update
+ *  @fn int Update(const Mesh<T>& mesh)
+ *  @brief  Refresh the weights of the triangles touching a dirty vertex
+ *          and the rows they contribute to, the sparsity pattern is
+ *          kept. Falls back to `Build` if the mesh size changed.
+ *  @param[in] mesh Mesh, with the same topology as in `Build`
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int MeshLaplacian<T>::Update(const Mesh<T>& mesh) {
+  const size_t n_vert = mesh.get_vertex().size();
+  const auto& tri_offset = mesh.get_vertex_tri_offset();
+  const auto& vertex_tri = mesh.get_vertex_tri();
+  if (n_vert != mass_.size() || mesh.get_triangle().size() != n_tri_ ||
+      vertex_tri.size() != 3 * n_tri_) {
+    return this->Build(mesh);
+  }
+  size_t n_dirty = 0;
+  for (const auto& d : dirty_) {
+    n_dirty += d;
+  }
+  if (n_dirty == 0) {
+    return 0;
+  }
+  if (n_dirty == dirty_.size()) {
+    this->ComputeTriangles(mesh, std::vector<int>());
+    this->AssembleRows(mesh, std::vector<int>());
+  } else {
+    // Triangles touching a dirty block, then every vertex of them. Lists are
+    // deduplicated with stamps, sorting would cost more than the update
+    if (++stamp_ == 0) {
+      std::fill(tri_stamp_.begin(), tri_stamp_.end(), 0);
+      std::fill(row_stamp_.begin(), row_stamp_.end(), 0);
+      stamp_ = 1;
+    }
+    const auto& triangle = mesh.get_triangle();
+    std::vector<int> tri;
+    std::vector<int> row;
+    for (size_t b = 0; b < dirty_.size(); ++b) {
+      if (!dirty_[b]) {
+        continue;
+      }
+      const size_t v_first = b * kLaplacianBlockSize;
+      const size_t v_last = std::min(v_first + kLaplacianBlockSize, n_vert);
+      for (size_t k = tri_offset[v_first]; k < tri_offset[v_last]; ++k) {
+        const int t = vertex_tri[k];
+        if (tri_stamp_[t] == stamp_) {
+          continue;
+        }
+        tri_stamp_[t] = stamp_;
+        tri.push_back(t);
+        const int* idx = &(triangle[t].x_);
+        for (int e = 0; e < 3; ++e) {
+          if (row_stamp_[idx[e]] != stamp_) {
+            row_stamp_[idx[e]] = stamp_;
+            row.push_back(idx[e]);
+          }
+        }
+      }
+    }
+    if (!tri.empty()) {
+      this->ComputeTriangles(mesh, tri);
+      this->AssembleRows(mesh, row);
+    }
+  }
+  std::fill(dirty_.begin(), dirty_.end(), 0);
+  return 0;
+}
+
+/*
+ *  @name System
+ *  @fn int System(const T& lambda, SparseMatrix<T>* a) const
+ *  @brief  Assemble `M + lambda * L`, sharing the sparsity pattern of the
+ *          Laplacian. Positive definite for `lambda >= 0` as long as every
+ *          vertex belongs to a non-degenerate triangle.
+ *  @param[in] lambda Weight of the Laplacian
+ *  @param[out] a     System matrix, its pattern is reused if it matches
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int MeshLaplacian<T>::System(const T& lambda, SparseMatrix<T>* a) const {
+  if (mass_.empty()) {
+    std::cout << "Error, Laplacian is not built" << std::endl;
+    return -1;
+  }
+  if (a->rows() != laplacian_.rows() || a->cols() != laplacian_.cols() ||
+      a->row_ptr() != laplacian_.row_ptr() ||
+      a->col_idx() != laplacian_.col_idx()) {
+    *a = laplacian_;
+  }
+  const auto& row_ptr = laplacian_.row_ptr();
+  const auto& col_idx = laplacian_.col_idx();
+  const auto& src = laplacian_.values();
+  auto& dst = a->values();
+  ThreadPool::Get().ParallelFor(0, mass_.size(), 0, [&](const size_t& first,
+                                                        const size_t& last) {
+    for (size_t v = first; v < last; ++v) {
+      for (int k = row_ptr[v]; k < row_ptr[v + 1]; ++k) {
+        dst[k] = lambda * src[k];
+        if (col_idx[k] == static_cast<int>(v)) {
+          dst[k] += mass_[v];
+        }
+      }
+    }
+  });
+  return 0;
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ *  @name ComputeTriangles
+ *  @fn void ComputeTriangles(const Mesh<T>& mesh,
+                              const std::vector<int>& tri)
+ *  @brief  Compute the cached weights and area of a list of triangles,
+ *          all of them if `tri` is empty
+ */
+template<typename T>
+void MeshLaplacian<T>::ComputeTriangles(const Mesh<T>& mesh,
+                                        const std::vector<int>& tri) {
+  using Vertex = typename Mesh<T>::Vertex;
+  const auto& vertex = mesh.get_vertex();
+  const auto& triangle = mesh.get_triangle();
+  const size_t n = tri.empty() ? n_tri_ : tri.size();
+  ThreadPool::Get().ParallelFor(0, n, 0, [&](const size_t& first,
+                                             const size_t& last) {
+    for (size_t i = first; i < last; ++i) {
+      const size_t t = tri.empty() ? i : static_cast<size_t>(tri[i]);
+      const int* idx = &(triangle[t].x_);
+      T* data = &tri_data_[4 * t];
+      // Edge facing each corner
+      const Vertex e[3] = {vertex[idx[2]] - vertex[idx[1]],
+                           vertex[idx[0]] - vertex[idx[2]],
+                           vertex[idx[1]] - vertex[idx[0]]};
+      const Vertex c = e[0] ^ e[1];
+      const T area2 = c.Norm();
+      const T scale = (e[0] * e[0]) + (e[1] * e[1]) + (e[2] * e[2]);
+      if (!(area2 > std::numeric_limits<T>::epsilon() * scale)) {
+        // Degenerate, does not contribute
+        data[0] = data[1] = data[2] = data[3] = T(0.0);
+        continue;
+      }
+      // cot(angle at k) = -e(k+1).e(k+2) / |e(k+1) x e(k+2)|, halved
+      const T s = T(-0.5) / area2;
+      data[0] = s * (e[1] * e[2]);
+      data[1] = s * (e[2] * e[0]);
+      data[2] = s * (e[0] * e[1]);
+      data[3] = T(0.5) * area2;
+    }
+  });
+}
+
+/*
+ *  @name AssembleRows
+ *  @fn void AssembleRows(const Mesh<T>& mesh,
+                          const std::vector<int>& row)
+ *  @brief  Gather the cached triangle data into a list of rows, all of
+ *          them if `row` is empty
+ */
+template<typename T>
+void MeshLaplacian<T>::AssembleRows(const Mesh<T>& mesh,
+                                    const std::vector<int>& row) {
+  const auto& triangle = mesh.get_triangle();
+  const auto& tri_offset = mesh.get_vertex_tri_offset();
+  const auto& vertex_tri = mesh.get_vertex_tri();
+  const auto& row_ptr = laplacian_.row_ptr();
+  const auto& col_idx = laplacian_.col_idx();
+  auto& value = laplacian_.values();
+  const bool uniform = weighting_ == kUniformWeighting;
+  const size_t n = row.empty() ? mass_.size() : row.size();
+  ThreadPool::Get().ParallelFor(0, n, 0, [&](const size_t& first,
+                                             const size_t& last) {
+    for (size_t i = first; i < last; ++i) {
+      const size_t v = row.empty() ? i : static_cast<size_t>(row[i]);
+      const int r_first = row_ptr[v];
+      const int r_last = row_ptr[v + 1];
+      const int diag = static_cast<int>(
+              std::lower_bound(col_idx.begin() + r_first,
+                               col_idx.begin() + r_last,
+                               static_cast<int>(v)) - col_idx.begin());
+      T m = T(0.0);
+      if (uniform) {
+        std::fill(value.begin() + r_first, value.begin() + r_last, T(-1.0));
+        value[diag] = T(r_last - r_first - 1);
+        for (size_t k = tri_offset[v]; k < tri_offset[v + 1]; ++k) {
+          m += tri_data_[4 * vertex_tri[k] + 3];
+        }
+      } else {
+        std::fill(value.begin() + r_first, value.begin() + r_last, T(0.0));
+        T d = T(0.0);
+        for (size_t k = tri_offset[v]; k < tri_offset[v + 1]; ++k) {
+          const int* idx = &(triangle[vertex_tri[k]].x_);
+          const T* data = &tri_data_[4 * vertex_tri[k]];
+          const int c = idx[0] == static_cast<int>(v) ? 0 :
+                        (idx[1] == static_cast<int>(v) ? 1 : 2);
+          // Edge to the next corner faces the previous one and vice versa
+          const T w_next = data[(c + 2) % 3];
+          const T w_prev = data[(c + 1) % 3];
+          value[slot_[2 * k]] -= w_next;
+          value[slot_[2 * k + 1]] -= w_prev;
+          d += w_next + w_prev;
+          m += data[3];
+        }
+        value[diag] = d;
+      }
+      mass_[v] = m / T(3.0);
+    }
+  });
+}
+
+#pragma mark -
+#pragma mark Declaration
+
+/** Float */
+template class MeshLaplacian<float>;
+/** Double */
+template class MeshLaplacian<double>;
+
+}  // namespace FaceKit
@@ -8,14 +8,28 @@
  */
 
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
 #include <sstream>
-#ifdef __APPLE__
-#include <dispatch/dispatch.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
 #endif
 
 #include "ply.h"
 
+#include "facekit/core/half.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/sys/file_system.hpp"
+#include "facekit/core/sys/file_system_factory.hpp"
 #include "facekit/geometry/mesh.hpp"
 
 /**
@@ -101,7 +115,7 @@ struct PLYFace {
  *  @brief  Constructor
  */
 template<typename T>
-Mesh<T>::Mesh(void) : bbox_is_computed_(false) {
+Mesh<T>::Mesh(void) : topo_(EmptyTopology()), bbox_is_computed_(false) {
 }
 
 /*
@@ -111,18 +125,155 @@ Mesh<T>::Mesh(void) : bbox_is_computed_(false) {
  *            .obj, .ply, .tri
  */
 template<typename T>
-Mesh<T>::Mesh(const std::string& filename) : bbox_is_computed_(false){
+Mesh<T>::Mesh(const std::string& filename) : topo_(EmptyTopology()),
+                                             bbox_is_computed_(false) {
   if (this->Load(filename)) {
     std::cout << "Error while loading mesh from file : " + filename << std::endl;
   }
 }
 
 /*
- *  @name Mesh  @fn Meshid)
+ *  @name Mesh
+ *  @fn Mesh(const Mesh<T>& other)
+ *  @brief  Copy constructor, per-vertex data is copied and the topology is
+ *          shared
+ *  @param[in]  other Mesh to copy from
+ */
+template<typename T>
+Mesh<T>::Mesh(const Mesh<T>& other) :
+        vertex_(other.vertex_),
+        normal_(other.normal_),
+        tangent_(other.tangent_),
+        vertex_color_(other.vertex_color_),
+        topo_(other.topo_),
+        bbox_(other.bbox_),
+        bbox_is_computed_(other.bbox_is_computed_),
+        block_bbox_(other.block_bbox_),
+        normal_dirty_(other.normal_dirty_),
+        bbox_dirty_(other.bbox_dirty_),
+        vertex_buffer_(other.vertex_buffer_),
+        buffer_dirty_(other.buffer_dirty_) {
+}
+
+/*
+ *  @name Mesh
+ *  @fn Mesh(Mesh<T>&& other)
+ *  @brief  Move constructor, `other` is left empty
+ *  @param[in]  other Mesh to move from
+ */
+template<typename T>
+Mesh<T>::Mesh(Mesh<T>&& other) :
+        vertex_(std::move(other.vertex_)),
+        normal_(std::move(other.normal_)),
+        tangent_(std::move(other.tangent_)),
+        vertex_color_(std::move(other.vertex_color_)),
+        topo_(std::move(other.topo_)),
+        bbox_(other.bbox_),
+        bbox_is_computed_(other.bbox_is_computed_),
+        block_bbox_(std::move(other.block_bbox_)),
+        normal_dirty_(std::move(other.normal_dirty_)),
+        bbox_dirty_(std::move(other.bbox_dirty_)),
+        vertex_buffer_(std::move(other.vertex_buffer_)),
+        buffer_dirty_(std::move(other.buffer_dirty_)) {
+  other.topo_ = EmptyTopology();
+  other.bbox_is_computed_ = false;
+}
+
+/*
+ *  @name operator=
+ *  @fn Mesh& operator=(const Mesh& rhs)
+ *  @brief  Assignment operator, per-vertex data is copied and the topology
+ *          is shared
+ *  @param[in]  rhs   Mesh to assign from
+ */
+template<typename T>
+Mesh<T>& Mesh<T>::operator=(const Mesh<T>& rhs) {
+  if (this != &rhs) {
+    vertex_ = rhs.vertex_;
+    normal_ = rhs.normal_;
+    tangent_ = rhs.tangent_;
+    vertex_color_ = rhs.vertex_color_;
+    this->ShareTopology(rhs);
+    bbox_ = rhs.bbox_;
+    bbox_is_computed_ = rhs.bbox_is_computed_;
+    block_bbox_ = rhs.block_bbox_;
+    normal_dirty_ = rhs.normal_dirty_;
+    bbox_dirty_ = rhs.bbox_dirty_;
+    vertex_buffer_ = rhs.vertex_buffer_;
+    buffer_dirty_ = rhs.buffer_dirty_;
+  }
+  return *this;
+}
+
+/*
+ *  @name operator=
+ *  @fn Mesh& operator=(Mesh&& rhs)
+ *  @brief  Move assignment operator, `rhs` is left empty
+ *  @param[in]  rhs   Mesh to move from
+ */
+template<typename T>
+Mesh<T>& Mesh<T>::operator=(Mesh<T>&& rhs) {
+  if (this != &rhs) {
+    vertex_ = std::move(rhs.vertex_);
+    normal_ = std::move(rhs.normal_);
+    tangent_ = std::move(rhs.tangent_);
+    vertex_color_ = std::move(rhs.vertex_color_);
+    topo_.swap(rhs.topo_);
+    bbox_ = rhs.bbox_;
+    bbox_is_computed_ = rhs.bbox_is_computed_;
+    block_bbox_ = std::move(rhs.block_bbox_);
+    normal_dirty_ = std::move(rhs.normal_dirty_);
+    bbox_dirty_ = std::move(rhs.bbox_dirty_);
+    vertex_buffer_ = std::move(rhs.vertex_buffer_);
+    buffer_dirty_ = std::move(rhs.buffer_dirty_);
+    // Previous topology released with `rhs`
+    rhs.topo_ = EmptyTopology();
+    rhs.bbox_is_computed_ = false;
+  }
+  return *this;
+}
+
+/*
+ *  @name ~Mesh
+ *  @fn virtual ~Mesh(void)
  *  @brief  Destructor
  */
 template<typename T>
-Mesh<T>::~Mesh(void) {
+Mesh<T>::~Mesh(void) = default;
+
+/*
+ *  @name EmptyTopology
+ *  @fn static RefPtr<Topology> EmptyTopology(void)
+ *  @brief  Topology shared by empty meshes, a new reference is returned
+ */
+template<typename T>
+RefPtr<typename Mesh<T>::Topology> Mesh<T>::EmptyTopology(void) {
+  // Holds one reference for the lifetime of the program, never released
+  static Topology* empty = new Topology();
+  return RefPtr<Topology>::Share(empty);
+}
+
+/*
+ *  @name Detach
+ *  @fn void Detach(void)
+ *  @brief  Copy the topology if it is shared, called before modifying it
+ */
+template<typename T>
+void Mesh<T>::Detach(void) {
+  if (!topo_->IsOne()) {
+    topo_.reset(topo_->Clone());
+  }
+}
+
+/*
+ *  @name ShareTopology
+ *  @fn void ShareTopology(const Mesh<T>& other)
+ *  @brief  Use the topology of another mesh, per-vertex data is kept
+ *  @param[in] other  Mesh holding the topology
+ */
+template<typename T>
+void Mesh<T>::ShareTopology(const Mesh<T>& other) {
+  topo_ = other.topo_;
 }
 
 /*
@@ -138,12 +289,15 @@ int Mesh<T>::Load(const std::string& filename) {
   int err = -1;
   size_t pos = filename.rfind(".");
   if (pos != std::string::npos) {
-    // Ensure empty containter
+    // Ensure empty containter, the topology is replaced since other meshes
+    // may share it
     vertex_.clear();
     normal_.clear();
-    tex_coord_.clear();
-    tri_.clear();
-    vertex_con_.clear();
+    topo_.reset(new Topology());
+    block_bbox_.clear();
+    normal_dirty_.clear();
+    bbox_dirty_.clear();
+    buffer_dirty_.clear();
     //memset(bbox_, 0, sizeof(bbox_));
     std::string ext = filename.substr(pos + 1, filename.length());
     FileExt file_ext = this->HashExt(ext);
@@ -158,6 +312,11 @@ int Mesh<T>::Load(const std::string& filename) {
         err = this->LoadPLY(filename);
       }
         break;
+      // Native binary, loaded as saved
+      case kFkm: {
+        err = this->LoadFKM(filename);
+      }
+        break;
       // Not supported yet
       case kUndef:
       default:  std::cout << "Error, unsported extension type : " << ext;
@@ -165,9 +324,11 @@ int Mesh<T>::Load(const std::string& filename) {
         err = -1;
         break;
     }
-    if (!err) {
+    if (!err && file_ext != kFkm) {
       this->PlaceToOrigin();
       this->BuildConnectivity();
+    } else if (!err && topo_->vertex_tri_offset_.empty()) {
+      this->BuildConnectivity();
     }
   }
   if (!err && !bbox_is_computed_) {
@@ -202,6 +363,11 @@ int Mesh<T>::Save(const std::string& filename) {
         err = this->SaveOBJ(filename);
       }
         break;
+        // Native binary
+      case kFkm: {
+        err = this->SaveFKM(filename);
+      }
+        break;
 
         break;
         // Undef
@@ -218,29 +384,69 @@ int Mesh<T>::Save(const std::string& filename) {
 /*
  *  @name BuildConnectivity
  *  @fn void BuildConnectivity(void)
- *  @brief  Construct vertex connectivity (vertex connection) used later
- *          in normal computation
+ *  @brief  Construct vertex connectivity (neighbouring vertices and
+ *          incident triangles) stored as compressed rows, used later in
+ *          normal computation
  */
 template<typename T>
 void Mesh<T>::BuildConnectivity(void) {
-  // Init outter containter
-  assert(vertex_.size() != 0 && tri_.size() != 0);
-  vertex_con_.clear();
-  vertex_con_ = std::vector<std::vector<int>>(vertex_.size(),
-                                              std::vector<int>(0));
-  // Loop over all triangle
-  const int n_tri = static_cast<int>(tri_.size());
-  for (int i = 0; i < n_tri; ++i) {
-    int* tri_idx_ptr = &(tri_[i].x_);
+  this->Detach();
+  assert(vertex_.size() != 0 && topo_->tri_.size() != 0);
+  const size_t n_vert = vertex_.size();
+  const size_t n_tri = topo_->tri_.size();
+  // Incident triangles, counting sort over the faces. Sequential passes keep
+  // each row in increasing triangle order and are cheaper than atomics
+  topo_->vertex_tri_offset_.assign(n_vert + 1, 0);
+  for (const auto& tri : topo_->tri_) {
+    topo_->vertex_tri_offset_[tri.x_ + 1] += 1;
+    topo_->vertex_tri_offset_[tri.y_ + 1] += 1;
+    topo_->vertex_tri_offset_[tri.z_ + 1] += 1;
+  }
+  for (size_t v = 0; v < n_vert; ++v) {
+    topo_->vertex_tri_offset_[v + 1] += topo_->vertex_tri_offset_[v];
+  }
+  std::vector<size_t> cursor(topo_->vertex_tri_offset_.begin(),
+                             topo_->vertex_tri_offset_.end() - 1);
+  topo_->vertex_tri_.resize(3 * n_tri);
+  for (size_t t = 0; t < n_tri; ++t) {
+    const int* idx = &(topo_->tri_[t].x_);
     for (int e = 0; e < 3; ++e) {
-      int idx_in = tri_idx_ptr[e];
-      int idx_out_1 = tri_idx_ptr[(e + 1) % 3];
-      int idx_out_2 = tri_idx_ptr[(e + 2) % 3];
-      // Add to connectivity list
-      vertex_con_[idx_in].push_back(idx_out_1);
-      vertex_con_[idx_in].push_back(idx_out_2);
+      topo_->vertex_tri_[cursor[idx[e]]++] = static_cast<int>(t);
+    }
+  }
+  // Neighbours, each vertex gets twice its number of triangles as upper
+  // bound, duplicates are removed in place then rows are compacted
+  topo_->vertex_con_.resize(6 * n_tri);
+  topo_->vertex_con_offset_.resize(n_vert + 1);
+  topo_->vertex_con_offset_[0] = 0;
+  ThreadPool::Get().ParallelFor(0, n_vert, 0, [&](const size_t& first,
+                                                   const size_t& last) {
+    for (size_t v = first; v < last; ++v) {
+      const size_t t_first = topo_->vertex_tri_offset_[v];
+      const size_t t_last = topo_->vertex_tri_offset_[v + 1];
+      auto row = topo_->vertex_con_.begin() + 2 * t_first;
+      auto end = row;
+      for (size_t k = t_first; k < t_last; ++k) {
+        const int* idx = &(topo_->tri_[topo_->vertex_tri_[k]].x_);
+        for (int e = 0; e < 3; ++e) {
+          if (idx[e] != static_cast<int>(v)) {
+            *end++ = idx[e];
+          }
+        }
+      }
+      std::sort(row, end);
+      topo_->vertex_con_offset_[v + 1] = std::unique(row, end) - row;
     }
+  });
+  for (size_t v = 0; v < n_vert; ++v) {
+    // Destination never goes past the source, rows can be moved in order
+    auto row = topo_->vertex_con_.begin() + 2 * topo_->vertex_tri_offset_[v];
+    std::copy(row, row + topo_->vertex_con_offset_[v + 1],
+              topo_->vertex_con_.begin() + topo_->vertex_con_offset_[v]);
+    topo_->vertex_con_offset_[v + 1] += topo_->vertex_con_offset_[v];
   }
+  topo_->vertex_con_.resize(topo_->vertex_con_offset_[n_vert]);
+  topo_->vertex_con_.shrink_to_fit();
 }
 
 /*
@@ -257,75 +463,646 @@ typename Mesh<T>::FileExt Mesh<T>::HashExt(const std::string& ext) {
     fext = kObj;
   } else if (ext == "ply") {
     fext = kPly;
+  } else if (ext == "fkm") {
+    fext = kFkm;
   }
   return fext;
 }
 
+#pragma mark -
+#pragma mark File content
+
+/**
+ *  @name   MapContent
+ *  @fn     static bool MapContent(const std::string& path,
+                                   std::unique_ptr<ReadOnlyMemoryRegion>* region,
+                                   std::string* content, const char** data,
+                                   size_t* length)
+ *  @brief  Map a file in memory, fall back to reading it if mapping is not
+ *          supported
+ *  @param[in] path     Path to the file
+ *  @param[out] region  Mapped region, if mapped
+ *  @param[out] content File content, if read
+ *  @param[out] data    File content
+ *  @param[out] length  File size in bytes
+ *  @return False if the file can not be accessed
+ */
+static bool MapContent(const std::string& path,
+                       std::unique_ptr<ReadOnlyMemoryRegion>* region,
+                       std::string* content,
+                       const char** data,
+                       size_t* length) {
+  FileSystem* fs = FileSystemFactory::Get().RetrieveForPath(path);
+  if (fs != nullptr && fs->NewReadOnlyMemoryRegion(path, region).Good()) {
+    *data = reinterpret_cast<const char*>((*region)->data());
+    *length = (*region)->length();
+    return true;
+  }
+  std::ifstream stream(path, std::ios_base::in | std::ios_base::binary);
+  if (!stream.is_open()) {
+    return false;
+  }
+  content->assign(std::istreambuf_iterator<char>(stream),
+                  std::istreambuf_iterator<char>());
+  *data = content->data();
+  *length = content->size();
+  return true;
+}
+
+#pragma mark -
+#pragma mark OBJ parsing
+
+/** Powers of ten exactly representable in double precision */
+static const double kExactPow10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+  1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/** Smallest chunk of an OBJ file parsed by a single task, in bytes */
+static constexpr size_t kOBJChunkSize = 1 << 20;
+
+/**
+ *  @name   IsBlank
+ *  @fn     static inline bool IsBlank(const char c)
+ *  @brief  Check if a character separates tokens within a line
+ */
+static inline bool IsBlank(const char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ *  @name   SkipBlank
+ *  @fn     static inline const char* SkipBlank(const char* p, const char* end)
+ *  @brief  Move to the next token of the line
+ */
+static inline const char* SkipBlank(const char* p, const char* end) {
+  while (p < end && IsBlank(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+/**
+ *  @name   ParseReal
+ *  @fn     static const char* ParseReal(const char* p, const char* end,
+                                         double* value)
+ *  @brief  Parse a floating point number. Numbers with at most 19
+ *          significant digits and small exponents are converted exactly with
+ *          one multiplication (Clinger's fast path), others go through
+ *          `strtod`.
+ *  @param[in] p      Start of the number
+ *  @param[in] end    End of the buffer
+ *  @param[out] value Parsed number
+ *  @return Position after the number or nullptr if there is none
+ */
+static const char* ParseReal(const char* p, const char* end, double* value) {
+  const char* start = p;
+  bool neg = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    neg = *p == '-';
+    ++p;
+  }
+  uint64_t mantissa = 0;
+  int n_digit = 0;
+  int exponent = 0;
+  bool any = false;
+  bool exact = true;
+  for (; p < end && static_cast<unsigned>(*p - '0') < 10; ++p) {
+    any = true;
+    if (n_digit < 19) {
+      mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+      n_digit += mantissa != 0;
+    } else {
+      exact = false;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (++p; p < end && static_cast<unsigned>(*p - '0') < 10; ++p) {
+      any = true;
+      if (n_digit < 19) {
+        mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+        n_digit += mantissa != 0;
+        exponent -= 1;
+      } else {
+        exact = false;
+      }
+    }
+  }
+  if (any && p < end && (*p == 'e' || *p == 'E')) {
+    const char* q = p + 1;
+    bool neg_exp = false;
+    if (q < end && (*q == '-' || *q == '+')) {
+      neg_exp = *q == '-';
+      ++q;
+    }
+    if (q < end && static_cast<unsigned>(*q - '0') < 10) {
+      int e = 0;
+      for (; q < end && static_cast<unsigned>(*q - '0') < 10; ++q) {
+        e = e < 10000 ? e * 10 + (*q - '0') : e;
+      }
+      exponent += neg_exp ? -e : e;
+      p = q;
+    }
+  }
+  if (any && exact && mantissa < (uint64_t(1) << 53) &&
+      exponent >= -22 && exponent <= 22) {
+    double v = static_cast<double>(mantissa);
+    v = exponent < 0 ? v / kExactPow10[-exponent] : v * kExactPow10[exponent];
+    *value = neg ? -v : v;
+    return p;
+  }
+  // Slow path (long mantissa, large exponent, inf, nan), the buffer is not
+  // null terminated
+  char buffer[128];
+  size_t n = 0;
+  for (const char* q = start; q < end && n < sizeof(buffer) - 1 &&
+       !IsBlank(*q) && *q != '\n' && *q != '/'; ++q) {
+    buffer[n++] = *q;
+  }
+  buffer[n] = '\0';
+  char* stop = nullptr;
+  *value = std::strtod(buffer, &stop);
+  return stop == buffer ? nullptr : start + (stop - buffer);
+}
+
+/**
+ *  @name   ParseInt
+ *  @fn     static const char* ParseInt(const char* p, const char* end,
+                                        long* value)
+ *  @brief  Parse a signed integer
+ *  @param[in] p      Start of the number
+ *  @param[in] end    End of the buffer
+ *  @param[out] value Parsed number
+ *  @return Position after the number or nullptr if there is none
+ */
+static const char* ParseInt(const char* p, const char* end, long* value) {
+  bool neg = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    neg = *p == '-';
+    ++p;
+  }
+  const char* start = p;
+  long v = 0;
+  for (; p < end && static_cast<unsigned>(*p - '0') < 10; ++p) {
+    v = v * 10 + (*p - '0');
+  }
+  *value = neg ? -v : v;
+  return p == start ? nullptr : p;
+}
+
+/**
+ *  @name   ParseReals
+ *  @fn     template<typename T> static const char* ParseReals(const char* p,
+                                        const char* end, const int& n, T* dst)
+ *  @brief  Parse `n` blank separated floating point numbers
+ *  @return Position after the last number or nullptr on error
+ */
+template<typename T>
+static const char* ParseReals(const char* p,
+                              const char* end,
+                              const int& n,
+                              T* dst) {
+  for (int k = 0; k < n && p != nullptr; ++k) {
+    double v;
+    p = ParseReal(SkipBlank(p, end), end, &v);
+    dst[k] = static_cast<T>(v);
+  }
+  return p;
+}
+
+/**
+ *  @struct OBJChunk
+ *  @brief  Elements parsed from a range of lines of an OBJ file
+ *  @tparam T Data type
+ */
+template<typename T>
+struct OBJChunk {
+  /** Vertices */
+  std::vector<Vector3<T>> vertex;
+  /** Normals */
+  std::vector<Vector3<T>> normal;
+  /** Texture coordinates */
+  std::vector<Vector2<T>> tcoord;
+  /** Triangles, absolute indices are resolved, relative (negative) ones are
+   counted from the chunk's first vertex */
+  std::vector<Vector3<int>> tri;
+  /** Corners (3 * triangle + k) holding relative indices */
+  std::vector<size_t> relative;
+  /** Bounding box */
+  AABB<T> bbox;
+  /** Start of the first malformed line if any */
+  const char* error = nullptr;
+
+  /**
+   *  @name   Parse
+   *  @fn     void Parse(const char* begin, const char* end)
+   *  @brief  Parse complete lines in [begin, end). Lines are counted first
+   *          to reserve the containers.
+   */
+  void Parse(const char* begin, const char* end);
+};
+
+template<typename T>
+void OBJChunk<T>::Parse(const char* begin, const char* end) {
+  // Count elements to avoid reallocation
+  size_t n_v = 0, n_vn = 0, n_vt = 0, n_f = 0;
+  for (const char* p = begin; p < end;) {
+    p = SkipBlank(p, end);
+    if (p + 1 < end && p[0] == 'v') {
+      n_v += IsBlank(p[1]);
+      n_vn += p[1] == 'n';
+      n_vt += p[1] == 't';
+    } else if (p + 1 < end && p[0] == 'f' && IsBlank(p[1])) {
+      n_f += 1;
+    }
+    const void* nl = std::memchr(p, '\n', end - p);
+    p = nl ? reinterpret_cast<const char*>(nl) + 1 : end;
+  }
+  vertex.reserve(n_v);
+  normal.reserve(n_vn);
+  tcoord.reserve(n_vt);
+  tri.reserve(n_f);
+  bbox.min_ = Vector3<T>(std::numeric_limits<T>::max(),
+                         std::numeric_limits<T>::max(),
+                         std::numeric_limits<T>::max());
+  bbox.max_ = Vector3<T>(std::numeric_limits<T>::lowest(),
+                         std::numeric_limits<T>::lowest(),
+                         std::numeric_limits<T>::lowest());
+  // Parse
+  std::vector<long> corners;
+  for (const char* p = begin; p < end;) {
+    const char* line = p;
+    const void* nl = std::memchr(p, '\n', end - p);
+    const char* eol = nl ? reinterpret_cast<const char*>(nl) : end;
+    p = SkipBlank(p, eol);
+    bool ok = true;
+    if (eol - p > 1 && p[0] == 'v' && IsBlank(p[1])) {
+      // Vertex, optional w / colors are ignored
+      Vector3<T> v;
+      ok = ParseReals(p + 1, eol, 3, &v.x_) != nullptr;
+      vertex.push_back(v);
+      bbox.min_.x_ = std::min(bbox.min_.x_, v.x_);
+      bbox.min_.y_ = std::min(bbox.min_.y_, v.y_);
+      bbox.min_.z_ = std::min(bbox.min_.z_, v.z_);
+      bbox.max_.x_ = std::max(bbox.max_.x_, v.x_);
+      bbox.max_.y_ = std::max(bbox.max_.y_, v.y_);
+      bbox.max_.z_ = std::max(bbox.max_.z_, v.z_);
+    } else if (eol - p > 2 && p[0] == 'v' && p[1] == 'n' && IsBlank(p[2])) {
+      Vector3<T> n;
+      ok = ParseReals(p + 2, eol, 3, &n.x_) != nullptr;
+      normal.push_back(n);
+    } else if (eol - p > 2 && p[0] == 'v' && p[1] == 't' && IsBlank(p[2])) {
+      // Optional w is ignored
+      Vector2<T> t;
+      ok = ParseReals(p + 2, eol, 2, &t.x_) != nullptr;
+      tcoord.push_back(t);
+    } else if (eol - p > 1 && p[0] == 'f' && IsBlank(p[1])) {
+      // Corners are `v`, `v/vt`, `v//vn` or `v/vt/vn`, only `v` is kept
+      corners.clear();
+      const char* q = SkipBlank(p + 1, eol);
+      while (ok && q < eol) {
+        long idx = 0;
+        q = ParseInt(q, eol, &idx);
+        ok = q != nullptr && idx != 0;
+        if (ok) {
+          corners.push_back(idx);
+          while (q < eol && !IsBlank(*q)) {
+            ++q;
+          }
+          q = SkipBlank(q, eol);
+        }
+      }
+      ok = ok && corners.size() >= 3;
+      // Triangulate polygons as a fan
+      const size_t base = tri.size();
+      for (size_t k = 2; ok && k < corners.size(); ++k) {
+        const long c[3] = {corners[0], corners[k - 1], corners[k]};
+        Vector3<int> t;
+        int* dst = &t.x_;
+        for (int i = 0; i < 3; ++i) {
+          if (c[i] > 0) {
+            dst[i] = static_cast<int>(c[i] - 1);
+          } else {
+            dst[i] = static_cast<int>(vertex.size() + c[i]);
+            relative.push_back(3 * (base + k - 2) + i);
+          }
+        }
+        tri.push_back(t);
+      }
+    }
+    if (!ok && error == nullptr) {
+      error = line;
+    }
+    p = nl ? eol + 1 : end;
+  }
+}
+
 /*
  *  @name LoadOBJ
  *  @fn int LoadOBJ(const std::string& path)
- *  @brief  Load mesh from .obj file
+ *  @brief  Load mesh from .obj file. The file is mapped in memory and split
+ *          into chunks of lines parsed in parallel, then merged.
  *  @param[in]  path  Path to obj file
  *  @return -1 if error, 0 otherwise
  */
 template<typename T>
 int Mesh<T>::LoadOBJ(const std::string& path) {
-  int error = -1;
-  std::ifstream stream(path, std::ios_base::in);
-  if (stream.is_open()) {
-    // Init bbox
-    bbox_.min_.x_ = std::numeric_limits<T>::max();
-    bbox_.max_.x_ = std::numeric_limits<T>::lowest();
-    bbox_.min_.y_ = std::numeric_limits<T>::max();
-    bbox_.max_.y_ = std::numeric_limits<T>::lowest();
-    bbox_.min_.z_ = std::numeric_limits<T>::max();
-    bbox_.max_.z_ = std::numeric_limits<T>::lowest();
-    // Start to read
-    std::string line, key;
-    std::stringstream str_stream;
-    Vertex vertex;
-    Normal normal;
-    TCoord tcoord;
-    Triangle tri;
-    while (!stream.eof()) {
-      // Scan line
-      std::getline(stream, line);
-      if (!line.empty()) {
-        str_stream.str(line);
-        str_stream >> key;
-        if (key == "v") {
-          // Vertex
-          str_stream >> vertex;
-          vertex_.push_back(vertex);
-          // Compute boundary box
-          bbox_.min_.x_ = bbox_.min_.x_ < vertex.x_ ? bbox_.min_.x_ : vertex.x_;
-          bbox_.max_.x_ = bbox_.max_.x_ > vertex.x_ ? bbox_.max_.x_ : vertex.x_;
-          bbox_.min_.y_ = bbox_.min_.y_ < vertex.y_ ? bbox_.min_.y_ : vertex.y_;
-          bbox_.max_.y_ = bbox_.max_.y_ > vertex.y_ ? bbox_.max_.y_ : vertex.y_;
-          bbox_.min_.z_ = bbox_.min_.z_ < vertex.z_ ? bbox_.min_.z_ : vertex.z_;
-          bbox_.max_.z_ = bbox_.max_.z_ > vertex.z_ ? bbox_.max_.z_ : vertex.z_;
-        } else if (key == "vn") {
-          // Normal
-          str_stream >> normal;
-          normal_.push_back(normal);
-        } else if (key == "vt") {
-          // Texture coordinate
-          str_stream >> tcoord;
-          tex_coord_.push_back(tcoord);
-        } else if (key == "f") {
-          // Faces
-          str_stream >> tri;
-          tri -= 1;
-          tri_.push_back(tri);
+  // Map file
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  std::string content;
+  const char* data = nullptr;
+  size_t length = 0;
+  if (!MapContent(path, &region, &content, &data, &length)) {
+    return -1;
+  }
+  // Split on line boundaries
+  auto& pool = ThreadPool::Get();
+  const size_t n_chunk = std::max(size_t(1),
+                                  std::min(4 * (pool.size() + 1),
+                                           length / kOBJChunkSize));
+  std::vector<const char*> bounds(n_chunk + 1, data);
+  bounds[n_chunk] = data + length;
+  for (size_t k = 1; k < n_chunk; ++k) {
+    const char* p = std::max(bounds[k - 1], data + (k * length) / n_chunk);
+    const void* nl = std::memchr(p, '\n', bounds[n_chunk] - p);
+    bounds[k] = nl ? reinterpret_cast<const char*>(nl) + 1 : bounds[n_chunk];
+  }
+  std::vector<OBJChunk<T>> chunks(n_chunk);
+  pool.ParallelFor(0, n_chunk, 1, [&](const size_t& first, const size_t& last) {
+    for (size_t k = first; k < last; ++k) {
+      chunks[k].Parse(bounds[k], bounds[k + 1]);
+    }
+  });
+  // Merge
+  std::vector<size_t> off_v(n_chunk + 1, 0), off_vn(n_chunk + 1, 0);
+  std::vector<size_t> off_vt(n_chunk + 1, 0), off_f(n_chunk + 1, 0);
+  for (size_t k = 0; k < n_chunk; ++k) {
+    const auto& c = chunks[k];
+    if (c.error != nullptr) {
+      std::cout << "Error, malformed line " << 1 + std::count(data, c.error, '\n');
+      std::cout << " in " << path << std::endl;
+      return -1;
+    }
+    off_v[k + 1] = off_v[k] + c.vertex.size();
+    off_vn[k + 1] = off_vn[k] + c.normal.size();
+    off_vt[k + 1] = off_vt[k] + c.tcoord.size();
+    off_f[k + 1] = off_f[k] + c.tri.size();
+  }
+  vertex_.resize(off_v[n_chunk]);
+  normal_.resize(off_vn[n_chunk]);
+  topo_->tex_coord_.resize(off_vt[n_chunk]);
+  topo_->tri_.resize(off_f[n_chunk]);
+  const int n_vertex = static_cast<int>(vertex_.size());
+  std::atomic<bool> valid(true);
+  pool.ParallelFor(0, n_chunk, 1, [&](const size_t& first, const size_t& last) {
+    for (size_t k = first; k < last; ++k) {
+      auto& c = chunks[k];
+      std::copy(c.vertex.begin(), c.vertex.end(), vertex_.begin() + off_v[k]);
+      std::copy(c.normal.begin(), c.normal.end(), normal_.begin() + off_vn[k]);
+      std::copy(c.tcoord.begin(), c.tcoord.end(),
+                topo_->tex_coord_.begin() + off_vt[k]);
+      // Relative indices are counted from the chunk's first vertex
+      for (const auto& r : c.relative) {
+        (&c.tri[r / 3].x_)[r % 3] += static_cast<int>(off_v[k]);
+      }
+      for (const auto& t : c.tri) {
+        if (t.x_ < 0 || t.x_ >= n_vertex || t.y_ < 0 || t.y_ >= n_vertex ||
+            t.z_ < 0 || t.z_ >= n_vertex) {
+          valid = false;
         }
-        str_stream.clear();
       }
+      std::copy(c.tri.begin(), c.tri.end(), topo_->tri_.begin() + off_f[k]);
     }
-    bbox_.center_ = (bbox_.min_ + bbox_.max_) * T(0.5);
-    bbox_is_computed_ = true;
-    error = 0;
+  });
+  if (!valid) {
+    std::cout << "Error, face index out of range in " << path << std::endl;
+    return -1;
   }
-  return error;
+  // Bounding box
+  bbox_.min_.x_ = std::numeric_limits<T>::max();
+  bbox_.max_.x_ = std::numeric_limits<T>::lowest();
+  bbox_.min_.y_ = std::numeric_limits<T>::max();
+  bbox_.max_.y_ = std::numeric_limits<T>::lowest();
+  bbox_.min_.z_ = std::numeric_limits<T>::max();
+  bbox_.max_.z_ = std::numeric_limits<T>::lowest();
+  for (const auto& c : chunks) {
+    bbox_.min_.x_ = std::min(bbox_.min_.x_, c.bbox.min_.x_);
+    bbox_.min_.y_ = std::min(bbox_.min_.y_, c.bbox.min_.y_);
+    bbox_.min_.z_ = std::min(bbox_.min_.z_, c.bbox.min_.z_);
+    bbox_.max_.x_ = std::max(bbox_.max_.x_, c.bbox.max_.x_);
+    bbox_.max_.y_ = std::max(bbox_.max_.y_, c.bbox.max_.y_);
+    bbox_.max_.z_ = std::max(bbox_.max_.z_, c.bbox.max_.z_);
+  }
+  bbox_.center_ = (bbox_.min_ + bbox_.max_) * T(0.5);
+  bbox_is_computed_ = true;
+  return 0;
+}
+
+#pragma mark -
+#pragma mark Binary PLY
+
+/**
+ *  @enum   PLYType
+ *  @brief  Scalar types of PLY properties
+ */
+enum class PLYType {
+  /** Not supported */
+  kUnknown,
+  /** char / int8 */
+  kInt8,
+  /** uchar / uint8 */
+  kUInt8,
+  /** short / int16 */
+  kInt16,
+  /** ushort / uint16 */
+  kUInt16,
+  /** int / int32 */
+  kInt32,
+  /** uint / uint32 */
+  kUInt32,
+  /** float / float32 */
+  kFloat32,
+  /** double / float64 */
+  kFloat64
+};
+
+/**
+ *  @struct PLYProp
+ *  @brief  Property of a PLY element
+ */
+struct PLYProp {
+  /** Name */
+  std::string name;
+  /** Value type */
+  PLYType type = PLYType::kUnknown;
+  /** Type of the item count for list properties, kUnknown for scalars */
+  PLYType count_type = PLYType::kUnknown;
+};
+
+/**
+ *  @struct PLYElem
+ *  @brief  Element of a PLY file
+ */
+struct PLYElem {
+  /** Name */
+  std::string name;
+  /** Number of records */
+  size_t count = 0;
+  /** Properties */
+  std::vector<PLYProp> props;
+};
+
+/** Number of elements written at once in binary PLY */
+static constexpr size_t kPLYWriteBatch = 1 << 16;
+
+/**
+ *  @name   PLYTypeFromName
+ *  @fn     static PLYType PLYTypeFromName(const std::string& name)
+ *  @brief  Convert a property type name
+ */
+static PLYType PLYTypeFromName(const std::string& name) {
+  if (name == "char" || name == "int8") {
+    return PLYType::kInt8;
+  } else if (name == "uchar" || name == "uint8") {
+    return PLYType::kUInt8;
+  } else if (name == "short" || name == "int16") {
+    return PLYType::kInt16;
+  } else if (name == "ushort" || name == "uint16") {
+    return PLYType::kUInt16;
+  } else if (name == "int" || name == "int32") {
+    return PLYType::kInt32;
+  } else if (name == "uint" || name == "uint32") {
+    return PLYType::kUInt32;
+  } else if (name == "float" || name == "float32") {
+    return PLYType::kFloat32;
+  } else if (name == "double" || name == "float64") {
+    return PLYType::kFloat64;
+  }
+  return PLYType::kUnknown;
+}
+
+/**
+ *  @name   PLYTypeSize
+ *  @fn     static size_t PLYTypeSize(const PLYType& type)
+ *  @brief  Size in bytes of a property type
+ */
+static size_t PLYTypeSize(const PLYType& type) {
+  switch (type) {
+    case PLYType::kInt8:
+    case PLYType::kUInt8: return 1;
+    case PLYType::kInt16:
+    case PLYType::kUInt16: return 2;
+    case PLYType::kInt32:
+    case PLYType::kUInt32:
+    case PLYType::kFloat32: return 4;
+    case PLYType::kFloat64: return 8;
+    default: return 0;
+  }
+}
+
+/**
+ *  @name   ReadPLYScalar
+ *  @fn     template<typename T> static T ReadPLYScalar(const char* p,
+                                                        const PLYType& type)
+ *  @brief  Read a value stored in the host byte order and convert it
+ */
+template<typename T>
+static T ReadPLYScalar(const char* p, const PLYType& type) {
+  switch (type) {
+    case PLYType::kInt8: { int8_t v; std::memcpy(&v, p, 1); return T(v); }
+    case PLYType::kUInt8: { uint8_t v; std::memcpy(&v, p, 1); return T(v); }
+    case PLYType::kInt16: { int16_t v; std::memcpy(&v, p, 2); return T(v); }
+    case PLYType::kUInt16: { uint16_t v; std::memcpy(&v, p, 2); return T(v); }
+    case PLYType::kInt32: { int32_t v; std::memcpy(&v, p, 4); return T(v); }
+    case PLYType::kUInt32: { uint32_t v; std::memcpy(&v, p, 4); return T(v); }
+    case PLYType::kFloat32: { float v; std::memcpy(&v, p, 4); return T(v); }
+    case PLYType::kFloat64: { double v; std::memcpy(&v, p, 8); return T(v); }
+    default: return T(0);
+  }
+}
+
+/**
+ *  @name   NativePLYFormat
+ *  @fn     static const char* NativePLYFormat(void)
+ *  @brief  Binary PLY format matching the host byte order
+ */
+static const char* NativePLYFormat(void) {
+  const uint16_t one = 1;
+  uint8_t first;
+  std::memcpy(&first, &one, 1);
+  return first == 1 ? "binary_little_endian" : "binary_big_endian";
+}
+
+/**
+ *  @name   ParsePLYHeader
+ *  @fn     static bool ParsePLYHeader(const char* data, const size_t& length,
+                                       std::vector<PLYElem>* elems,
+                                       size_t* header_size)
+ *  @brief  Parse the header of a binary PLY file stored in the host byte
+ *          order
+ *  @param[in] data   File content
+ *  @param[in] length File size in bytes
+ *  @param[out] elems Elements
+ *  @param[out] header_size Size of the header in bytes
+ *  @return False if the file is not a binary PLY in the host byte order
+ */
+static bool ParsePLYHeader(const char* data,
+                           const size_t& length,
+                           std::vector<PLYElem>* elems,
+                           size_t* header_size) {
+  static const std::string kEnd = "end_header";
+  const char* end = std::search(data, data + length, kEnd.begin(), kEnd.end());
+  if (end == data + length) {
+    return false;
+  }
+  const void* nl = std::memchr(end, '\n', (data + length) - end);
+  if (nl == nullptr) {
+    return false;
+  }
+  *header_size = (reinterpret_cast<const char*>(nl) + 1) - data;
+  std::istringstream stream(std::string(data, end - data));
+  std::string line, key;
+  bool magic = false, format = false;
+  elems->clear();
+  while (std::getline(stream, line)) {
+    std::istringstream tokens(line);
+    if (!(tokens >> key)) {
+      continue;
+    }
+    if (key == "ply") {
+      magic = true;
+    } else if (key == "format") {
+      std::string fmt;
+      tokens >> fmt;
+      format = fmt == NativePLYFormat();
+    } else if (key == "element") {
+      PLYElem elem;
+      tokens >> elem.name >> elem.count;
+      elems->push_back(elem);
+    } else if (key == "property") {
+      if (elems->empty()) {
+        return false;
+      }
+      PLYProp prop;
+      std::string type;
+      tokens >> type;
+      if (type == "list") {
+        std::string count_type;
+        tokens >> count_type >> type;
+        prop.count_type = PLYTypeFromName(count_type);
+        if (prop.count_type == PLYType::kUnknown) {
+          return false;
+        }
+      }
+      tokens >> prop.name;
+      prop.type = PLYTypeFromName(type);
+      if (prop.type == PLYType::kUnknown) {
+        return false;
+      }
+      elems->back().props.push_back(prop);
+    }
+  }
+  return magic && format;
 }
 
 /*
@@ -338,6 +1115,17 @@ int Mesh<T>::LoadOBJ(const std::string& path) {
 template<typename T>
 int Mesh<T>::LoadPLY(const std::string& path) {
   int error = -1;
+  {
+    // Binary files in the host byte order are read in bulk
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    std::string content;
+    const char* data = nullptr;
+    size_t length = 0;
+    if (MapContent(path, &region, &content, &data, &length) &&
+        this->LoadBinaryPLY(data, length, &error)) {
+      return error;
+    }
+  }
   // Read ply file
   PlyFile* ply_file;
   int n_elem;
@@ -423,9 +1211,9 @@ int Mesh<T>::LoadPLY(const std::string& path) {
                            bbox_.max_.z_ :
                            vert.vertex.z_);
           // Normal if present
-          if ((vert.normal.x_ != -1.0f) &&
-              (vert.normal.y_ != -1.0f) &&
-              (vert.normal.z_ != -1.0f)) {
+          if ((vert.normal.x_ != T(-1.0)) &&
+              (vert.normal.y_ != T(-1.0)) &&
+              (vert.normal.z_ != T(-1.0))) {
             normal_.push_back(vert.normal);
           }
         }
@@ -446,13 +1234,13 @@ int Mesh<T>::LoadPLY(const std::string& path) {
             return error;
           }
           if (face.list_idx != nullptr) {
-            tri_.push_back(face.list_idx[0]);
+            topo_->tri_.push_back(face.list_idx[0]);
           }
           if (face.list_tcoord != nullptr) {
             assert(face.n_tcoord == 6);
-            tex_coord_.push_back(face.list_tcoord[0]);
-            tex_coord_.push_back(face.list_tcoord[1]);
-            tex_coord_.push_back(face.list_tcoord[2]);
+            topo_->tex_coord_.push_back(face.list_tcoord[0]);
+            topo_->tex_coord_.push_back(face.list_tcoord[1]);
+            topo_->tex_coord_.push_back(face.list_tcoord[2]);
           }
         }
       }
@@ -467,151 +1255,2027 @@ int Mesh<T>::LoadPLY(const std::string& path) {
   return error;
 }
 
+/** Number of elements formatted by a single task when writing OBJ */
+static constexpr size_t kOBJWriteBatch = 1 << 14;
+/** Room reserved for one formatted number, `snprintf` terminator included */
+static constexpr size_t kOBJMaxReal = 32;
+/** Room reserved for one line of an OBJ file */
+static constexpr size_t kOBJMaxLine = 128;
+
+/**
+ *  @name   FormatUInt
+ *  @fn     static char* FormatUInt(uint64_t value, char* p)
+ *  @brief  Write an unsigned integer in decimal
+ *  @param[in] value  Value to write
+ *  @param[in] p      Destination
+ *  @return Position after the last written character
+ */
+static char* FormatUInt(uint64_t value, char* p) {
+  char digit[20];
+  int n = 0;
+  do {
+    digit[n++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  while (n > 0) {
+    *p++ = digit[--n];
+  }
+  return p;
+}
+
+/**
+ *  @name   FormatReal
+ *  @fn     static char* FormatReal(const double& value, char* p)
+ *  @brief  Write a double with 17 significant digits, enough to read back
+ *          the same value. Needs `kOBJMaxReal` bytes at \p p.
+ *  @param[in] value  Value to write
+ *  @param[in] p      Destination
+ *  @return Position after the last written character
+ */
+static char* FormatReal(const double& value, char* p) {
+  return p + std::snprintf(p, kOBJMaxReal, "%.17g", value);
+}
+
+/**
+ *  @name   FormatReal
+ *  @fn     static char* FormatReal(const float& value, char* p)
+ *  @brief  Write a float with at most 9 significant digits, enough to read
+ *          back the same value, trailing zeros removed. The value is scaled
+ *          into a 9 digits integer with one exact power of ten in double
+ *          precision, whose rounding error is far below the float's
+ *          resolution. Values out of the exact powers' range go through
+ *          `snprintf`.
+ *  @param[in] value  Value to write
+ *  @param[in] p      Destination
+ *  @return Position after the last written character
+ */
+static char* FormatReal(const float& value, char* p) {
+  const double a = std::abs(static_cast<double>(value));
+  if (!(a > 0.0) || std::isinf(a)) {
+    // Zero, inf, nan
+    return p + std::snprintf(p, kOBJMaxReal, "%g", value);
+  }
+  // Decimal exponent estimated from the binary one, may be one too small
+  int e2 = 0;
+  std::frexp(a, &e2);
+  int e = static_cast<int>(std::floor((e2 - 1) * 0.30102999566398120));
+  int s = 8 - e;
+  if (s < -21 || s > 22) {
+    return p + std::snprintf(p, kOBJMaxReal, "%.9g", value);
+  }
+  auto scale = [&a](const int& k) -> uint64_t {
+    return static_cast<uint64_t>(std::llround(k < 0 ? a / kExactPow10[-k] :
+                                                      a * kExactPow10[k]));
+  };
+  uint64_t m = scale(s);
+  if (m >= 1000000000) {
+    e += 1;
+    m = scale(--s);
+  }
+  if (m >= 1000000000) {
+    // Rounded up to the next power of ten
+    e += 1;
+    m /= 10;
+  }
+  // Digits without trailing zeros
+  char digit[9];
+  for (int k = 8; k >= 0; --k) {
+    digit[k] = static_cast<char>('0' + m % 10);
+    m /= 10;
+  }
+  int n = 9;
+  while (n > 1 && digit[n - 1] == '0') {
+    --n;
+  }
+  if (value < 0.f) {
+    *p++ = '-';
+  }
+  if (e >= 0 && e < 9) {
+    // ddd.ddd
+    for (int k = 0; k <= e; ++k) {
+      *p++ = k < n ? digit[k] : '0';
+    }
+    if (n > e + 1) {
+      *p++ = '.';
+      p = std::copy(digit + e + 1, digit + n, p);
+    }
+  } else if (e < 0 && e >= -5) {
+    // 0.000ddd
+    *p++ = '0';
+    *p++ = '.';
+    p = std::fill_n(p, -e - 1, '0');
+    p = std::copy(digit, digit + n, p);
+  } else {
+    // d.ddde-xx
+    *p++ = digit[0];
+    if (n > 1) {
+      *p++ = '.';
+      p = std::copy(digit + 1, digit + n, p);
+    }
+    *p++ = 'e';
+    if (e < 0) {
+      *p++ = '-';
+    }
+    p = FormatUInt(static_cast<uint64_t>(std::abs(e)), p);
+  }
+  return p;
+}
+
+/**
+ *  @name   FormatOBJElement
+ *  @fn     template<typename T> static char* FormatOBJElement(
+                                    const char* tag, const T* value,
+                                    const int& n, char* p)
+ *  @brief  Write one line `tag v0 ... vn-1`
+ *  @param[in] tag    Element tag (i.e. `v`, `vn`)
+ *  @param[in] value  Values
+ *  @param[in] n      Number of values
+ *  @param[in] p      Destination, needs `kOBJMaxLine` bytes
+ *  @return Position after the line
+ */
+template<typename T>
+static char* FormatOBJElement(const char* tag,
+                              const T* value,
+                              const int& n,
+                              char* p) {
+  while (*tag != '\0') {
+    *p++ = *tag++;
+  }
+  for (int k = 0; k < n; ++k) {
+    *p++ = ' ';
+    p = FormatReal(value[k], p);
+  }
+  *p++ = '\n';
+  return p;
+}
+
 /*
  *  @name SaveOBJ
  *  @fn int SaveOBJ(const std::string path) const
- *  @brief SAve mesh to a .obj file
+ *  @brief  Save mesh to a .obj file. Elements are split into ranges
+ *          formatted concurrently into memory, then written in order
+ *          through a single stream, a wave of ranges at a time to bound the
+ *          memory used. Faces reference texture coordinates and normals
+ *          when there is one per vertex.
  *  @param[in]  path  Path to .obj file
  *  @return -1 if error, 0 otherwise
  */
 template<typename T>
 int Mesh<T>::SaveOBJ(const std::string& path) {
-  int err = -1;
-  std::ofstream stream(path, std::ios_base::out);
-  if (stream.is_open()) {
-    // Header
-    stream << "# Wavefront file written by FaceKit c++ library" << std::endl;
-
-    // Vertex
-    if (vertex_.size() > 0) {
-      size_t n_vert = vertex_.size();
-      for (size_t i = 0; i < n_vert; ++i) {
-        const Vertex& v = vertex_[i];
-        stream << "f " << v.x_ << " " << v.y_ << " " << v.z_ << std::endl;
-      }
-    }
-    // Normal
-    if (normal_.size() > 0) {
-      size_t n_norm = normal_.size();
-      for (size_t i = 0; i < n_norm; ++i) {
-        const Normal& n = normal_[i];
-        stream << "vn " << n.x_ << " " << n.y_ << " " << n.z_ << std::endl;
-      }
-    }
-    // Texture coordinate
-    if (tex_coord_.size() > 0) {
-      size_t n_tcoord = tex_coord_.size();
-      for (size_t i = 0; i < n_tcoord; ++i) {
-        const TCoord& tc = tex_coord_[i];
-        stream << "vt " << tc.x_ << " " << tc.y_ << std::endl;
-      }
+  std::ofstream stream(path, std::ios_base::out | std::ios_base::binary);
+  if (!stream.is_open()) {
+    return -1;
+  }
+  stream << "# Wavefront file written by FaceKit c++ library\n";
+  const auto& tcoord = topo_->tex_coord_;
+  const auto& tri = topo_->tri_;
+  const bool corner_vt = !tcoord.empty() && tcoord.size() == vertex_.size();
+  const bool corner_vn = !normal_.empty() && normal_.size() == vertex_.size();
+  // Ranges of each section, in file order
+  struct Range {
+    int section;
+    size_t first;
+    size_t last;
+  };
+  const size_t count[] = {vertex_.size(), normal_.size(), tcoord.size(),
+                          tri.size()};
+  std::vector<Range> ranges;
+  for (int s = 0; s < 4; ++s) {
+    for (size_t i = 0; i < count[s]; i += kOBJWriteBatch) {
+      ranges.push_back({s, i, std::min(i + kOBJWriteBatch, count[s])});
     }
-    // Tri
-    if (tri_.size() > 0) {
-      size_t n_tri = tri_.size();
-      for (size_t i = 0; i < n_tri; ++i) {
-        const Triangle & tri = tri_[i];
-        stream << "f " << tri.x_ << " " << tri.y_ << " " << tri.z_ << std::endl;
+  }
+  // Format a wave of ranges concurrently, then write it
+  auto& pool = ThreadPool::Get();
+  const size_t n_wave = 4 * (pool.size() + 1);
+  std::vector<std::vector<char>> buffers(std::min(n_wave, ranges.size()));
+  for (size_t r0 = 0; r0 < ranges.size() && stream.good(); r0 += n_wave) {
+    const size_t n = std::min(n_wave, ranges.size() - r0);
+    pool.ParallelFor(0, n, 1, [&](const size_t& first, const size_t& last) {
+      for (size_t k = first; k < last; ++k) {
+        const Range& r = ranges[r0 + k];
+        auto& buffer = buffers[k];
+        buffer.resize((r.last - r.first) * kOBJMaxLine);
+        char* p = buffer.data();
+        for (size_t i = r.first; i < r.last; ++i) {
+          if (r.section == 0) {
+            p = FormatOBJElement("v", &vertex_[i].x_, 3, p);
+          } else if (r.section == 1) {
+            p = FormatOBJElement("vn", &normal_[i].x_, 3, p);
+          } else if (r.section == 2) {
+            p = FormatOBJElement("vt", &tcoord[i].x_, 2, p);
+          } else {
+            // 1-based v, v/vt, v//vn or v/vt/vn
+            const int* idx = &tri[i].x_;
+            *p++ = 'f';
+            for (int c = 0; c < 3; ++c) {
+              const uint64_t v = static_cast<uint64_t>(idx[c]) + 1;
+              *p++ = ' ';
+              p = FormatUInt(v, p);
+              if (corner_vt || corner_vn) {
+                *p++ = '/';
+                p = corner_vt ? FormatUInt(v, p) : p;
+              }
+              if (corner_vn) {
+                *p++ = '/';
+                p = FormatUInt(v, p);
+              }
+            }
+            *p++ = '\n';
+          }
+        }
+        buffer.resize(p - buffer.data());
       }
+    });
+    for (size_t k = 0; k < n; ++k) {
+      stream.write(buffers[k].data(), buffers[k].size());
     }
-    // Done
-    err = stream.good() ? 0 : -1;
-    stream.close();
   }
-  return err;
+  // Done
+  stream.close();
+  return stream.fail() ? -1 : 0;
 }
 
 /*
- *  @name SavePLY
- *  @fn int SavePLY(const std::string& path) const
- *  @brief SAve mesh to a .ply file
- *  @param[in]  path  Path to .ply file
- *  @return -1 if error, 0 otherwise
+ *  @name LoadBinaryPLY
+ *  @fn bool LoadBinaryPLY(const char* data, const size_t& length,
+                           int* error)
+ *  @brief  Bulk load of a binary .ply file stored in the host byte order
+ *          with scalar vertex properties and list face properties
+ *  @param[in]  data    File content
+ *  @param[in]  length  File size in bytes
+ *  @param[out] error   -1 if error, 0 otherwise
+ *  @return False if the file is not supported and must go through the
+ *          generic reader
  */
 template<typename T>
-int Mesh<T>::SavePLY(const std::string& path) const {
-  int error = -1;
-  // TODO: Need to be implemented !
-  return error;
-}
-
-#pragma mark -
-#pragma mark Usage
-
-  /*
-   *  @name ComputeVertexNormal
-   *  @fn void ComputeVertexNormal(void)
-   *  @brief  Compute normal for each vertex in the object
-   */
-template<typename T>
-void Mesh<T>::ComputeVertexNormal(void) {
-  // Loop over all vertex
-  assert(vertex_con_.size() > 0);
-  const int n_vert = static_cast<int>(vertex_.size());
-  normal_.resize(n_vert, Mesh::Normal());
-#if defined(__APPLE__)
-  dispatch_apply(n_vert,
-                 dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT,
-                                           (unsigned long)NULL), ^(size_t v) {
-#else
-  #pragma omp parallel for
-  for (int v = 0; v < n_vert; ++v) {
-#endif
-   // Loop over all connect vertex
-   std::vector<int>& conn = vertex_con_[v];
-   const Vertex& A = vertex_[v];
-   const int n_conn = static_cast<int>(conn.size());
-   Normal weighted_n;
-   for (int j = 0; j < n_conn; j += 2) {
-     const Vertex& B = vertex_[conn[j]];
-     const Vertex& C = vertex_[conn[j+1]];
-     // Define edges AB, AC
-     Edge AB = B - A;
-     Edge AC = C - A;
-     // Compute surface's normal (triangle ABC)
-     Normal n = AB ^ AC;
-     n.Normalize();
-     // Stack each face contribution and weight with angle
-     AB.Normalize();
-     AC.Normalize();
-     const T angle = std::acos(AB * AC);
-     weighted_n += (n * angle);
-   }
-   // normalize and set
-   weighted_n.Normalize();
-   normal_[v] = weighted_n;
- }
-#if defined(__APPLE__)
-  );
-#endif
+bool Mesh<T>::LoadBinaryPLY(const char* data,
+                            const size_t& length,
+                            int* error) {
+  std::vector<PLYElem> elems;
+  size_t header_size = 0;
+  if (!ParsePLYHeader(data, length, &elems, &header_size)) {
+    return false;
+  }
+  // Check every element can be handled before touching the mesh
+  for (const auto& elem : elems) {
+    for (const auto& prop : elem.props) {
+      const bool is_list = prop.count_type != PLYType::kUnknown;
+      if (elem.name == "face") {
+        const bool index = ((prop.name == "vertex_indices" ||
+                             prop.name == "vertex_index") &&
+                            (prop.type == PLYType::kInt32 ||
+                             prop.type == PLYType::kUInt32));
+        const bool tcoord = (prop.name == "texcoord" &&
+                             (prop.type == PLYType::kFloat32 ||
+                              prop.type == PLYType::kFloat64));
+        if (!is_list || !(index || tcoord)) {
+          return false;
+        }
+      } else if (is_list) {
+        // Variable size records outside of faces
+        return false;
+      }
+    }
+  }
+  *error = -1;
+  const char* p = data + header_size;
+  const char* end = data + length;
+  for (const auto& elem : elems) {
+    if (elem.name == "face") {
+      topo_->tri_.resize(elem.count);
+      for (const auto& prop : elem.props) {
+        if (prop.name == "texcoord") {
+          topo_->tex_coord_.reserve(3 * elem.count);
+        }
+      }
+      for (size_t f = 0; f < elem.count; ++f) {
+        for (const auto& prop : elem.props) {
+          const size_t c_size = PLYTypeSize(prop.count_type);
+          const size_t v_size = PLYTypeSize(prop.type);
+          if (size_t(end - p) < c_size) {
+            return true;
+          }
+          const size_t n = ReadPLYScalar<size_t>(p, prop.count_type);
+          p += c_size;
+          if (size_t(end - p) < n * v_size) {
+            return true;
+          }
+          if (prop.name == "texcoord") {
+            if (n != 6) {
+              std::cout << "Error, texcoord must have 6 values" << std::endl;
+              return true;
+            }
+            for (size_t k = 0; k < 6; k += 2) {
+              const T u = ReadPLYScalar<T>(p + k * v_size, prop.type);
+              const T v = ReadPLYScalar<T>(p + (k + 1) * v_size, prop.type);
+              topo_->tex_coord_.push_back(TCoord(u, v));
+            }
+          } else {
+            if (n != 3) {
+              std::cout << "Support only triangle mesh !" << std::endl;
+              return true;
+            }
+            int* idx = &topo_->tri_[f].x_;
+            for (size_t k = 0; k < 3; ++k) {
+              idx[k] = ReadPLYScalar<int>(p + k * v_size, prop.type);
+            }
+          }
+          p += n * v_size;
+        }
+      }
+      continue;
+    }
+    // Fixed size records
+    size_t stride = 0;
+    std::vector<size_t> offset(elem.props.size());
+    for (size_t k = 0; k < elem.props.size(); ++k) {
+      offset[k] = stride;
+      stride += PLYTypeSize(elem.props[k].type);
+    }
+    if (stride != 0 && size_t(end - p) / stride < elem.count) {
+      return true;
+    }
+    if (elem.name == "vertex") {
+      // Look for position / normal
+      const char* names[] = {"x", "y", "z", "nx", "ny", "nz"};
+      int index[6] = {-1, -1, -1, -1, -1, -1};
+      for (size_t k = 0; k < elem.props.size(); ++k) {
+        for (int i = 0; i < 6; ++i) {
+          if (elem.props[k].name == names[i]) {
+            index[i] = static_cast<int>(k);
+          }
+        }
+      }
+      if (index[0] < 0 || index[1] < 0 || index[2] < 0) {
+        std::cout << "Error, vertex without position" << std::endl;
+        return true;
+      }
+      vertex_.resize(elem.count);
+      const PLYType native = sizeof(T) == 4 ? PLYType::kFloat32 :
+                                              PLYType::kFloat64;
+      if (stride == 3 * sizeof(T) && sizeof(Vertex) == stride &&
+          index[0] == 0 && index[1] == 1 && index[2] == 2 &&
+          elem.props[0].type == native && elem.props[1].type == native &&
+          elem.props[2].type == native) {
+        // Same layout, single copy
+        std::memcpy(static_cast<void*>(vertex_.data()), p, elem.count * stride);
+      } else {
+        for (size_t v = 0; v < elem.count; ++v) {
+          const char* rec = p + v * stride;
+          T* dst = &vertex_[v].x_;
+          for (int i = 0; i < 3; ++i) {
+            const auto& prop = elem.props[index[i]];
+            dst[i] = ReadPLYScalar<T>(rec + offset[index[i]], prop.type);
+          }
+        }
+      }
+      if (index[3] >= 0 && index[4] >= 0 && index[5] >= 0) {
+        normal_.resize(elem.count);
+        for (size_t v = 0; v < elem.count; ++v) {
+          const char* rec = p + v * stride;
+          T* dst = &normal_[v].x_;
+          for (int i = 0; i < 3; ++i) {
+            const auto& prop = elem.props[index[i + 3]];
+            dst[i] = ReadPLYScalar<T>(rec + offset[index[i + 3]], prop.type);
+          }
+        }
+      }
+      // Boundary box
+      bbox_.min_.x_ = std::numeric_limits<T>::max();
+      bbox_.max_.x_ = std::numeric_limits<T>::lowest();
+      bbox_.min_.y_ = std::numeric_limits<T>::max();
+      bbox_.max_.y_ = std::numeric_limits<T>::lowest();
+      bbox_.min_.z_ = std::numeric_limits<T>::max();
+      bbox_.max_.z_ = std::numeric_limits<T>::lowest();
+      for (const auto& v : vertex_) {
+        bbox_.min_.x_ = std::min(bbox_.min_.x_, v.x_);
+        bbox_.min_.y_ = std::min(bbox_.min_.y_, v.y_);
+        bbox_.min_.z_ = std::min(bbox_.min_.z_, v.z_);
+        bbox_.max_.x_ = std::max(bbox_.max_.x_, v.x_);
+        bbox_.max_.y_ = std::max(bbox_.max_.y_, v.y_);
+        bbox_.max_.z_ = std::max(bbox_.max_.z_, v.z_);
+      }
+      bbox_.center_ = (bbox_.min_ + bbox_.max_) * T(0.5);
+      bbox_is_computed_ = true;
+    }
+    // Other elements are skipped
+    p += elem.count * stride;
+  }
+  // Faces may reference any vertex
+  const int n_vertex = static_cast<int>(vertex_.size());
+  for (const auto& tri : topo_->tri_) {
+    if (tri.x_ < 0 || tri.x_ >= n_vertex || tri.y_ < 0 ||
+        tri.y_ >= n_vertex || tri.z_ < 0 || tri.z_ >= n_vertex) {
+      std::cout << "Error, face index out of range" << std::endl;
+      return true;
+    }
+  }
+  *error = 0;
+  return true;
+}
+
+/*
+ *  @name SavePLY
+ *  @fn int SavePLY(const std::string path) const
+ *  @brief Save mesh to a binary .ply file in the host byte order, written
+ *         in bulk
+ *  @param[in]  path  Path to .ply file
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int Mesh<T>::SavePLY(const std::string& path) const {
+  std::ofstream stream(path, std::ios_base::out | std::ios_base::binary);
+  if (!stream.is_open()) {
+    return -1;
+  }
+  const bool has_normal = (!normal_.empty() &&
+                           normal_.size() == vertex_.size());
+  const bool has_tcoord = (!topo_->tex_coord_.empty() &&
+                           topo_->tex_coord_.size() == 3 * topo_->tri_.size());
+  const char* type = sizeof(T) == 4 ? "float" : "double";
+  // Header
+  stream << "ply\nformat " << NativePLYFormat() << " 1.0\n";
+  stream << "element vertex " << vertex_.size() << "\n";
+  stream << "property " << type << " x\nproperty " << type << " y\n";
+  stream << "property " << type << " z\n";
+  if (has_normal) {
+    stream << "property " << type << " nx\nproperty " << type << " ny\n";
+    stream << "property " << type << " nz\n";
+  }
+  stream << "element face " << topo_->tri_.size() << "\n";
+  stream << "property list uchar int vertex_indices\n";
+  if (has_tcoord) {
+    stream << "property list uchar " << type << " texcoord\n";
+  }
+  stream << "end_header\n";
+  // Vertices
+  std::vector<char> buffer;
+  if (!has_normal && sizeof(Vertex) == 3 * sizeof(T)) {
+    stream.write(reinterpret_cast<const char*>(vertex_.data()),
+                 vertex_.size() * sizeof(Vertex));
+  } else {
+    const size_t stride = (has_normal ? 6 : 3) * sizeof(T);
+    for (size_t v0 = 0; v0 < vertex_.size(); v0 += kPLYWriteBatch) {
+      const size_t n = std::min(kPLYWriteBatch, vertex_.size() - v0);
+      buffer.resize(n * stride);
+      char* dst = buffer.data();
+      for (size_t v = v0; v < v0 + n; ++v, dst += stride) {
+        std::memcpy(dst, &vertex_[v].x_, 3 * sizeof(T));
+        if (has_normal) {
+          std::memcpy(dst + 3 * sizeof(T), &normal_[v].x_, 3 * sizeof(T));
+        }
+      }
+      stream.write(buffer.data(), buffer.size());
+    }
+  }
+  // Faces
+  const size_t stride = (1 + 3 * sizeof(int32_t) +
+                         (has_tcoord ? 1 + 6 * sizeof(T) : 0));
+  for (size_t f0 = 0; f0 < topo_->tri_.size(); f0 += kPLYWriteBatch) {
+    const size_t n = std::min(kPLYWriteBatch, topo_->tri_.size() - f0);
+    buffer.resize(n * stride);
+    char* dst = buffer.data();
+    for (size_t f = f0; f < f0 + n; ++f) {
+      *dst++ = 3;
+      const Triangle& tri = topo_->tri_[f];
+      const int32_t idx[3] = {tri.x_, tri.y_, tri.z_};
+      std::memcpy(dst, idx, sizeof(idx));
+      dst += sizeof(idx);
+      if (has_tcoord) {
+        *dst++ = 6;
+        for (size_t k = 0; k < 3; ++k) {
+          std::memcpy(dst, &topo_->tex_coord_[3 * f + k].x_, 2 * sizeof(T));
+          dst += 2 * sizeof(T);
+        }
+      }
+    }
+    stream.write(buffer.data(), buffer.size());
+  }
+  return stream.good() ? 0 : -1;
+}
+
+#pragma mark -
+#pragma mark Native binary format
+
+/** Magic number of .fkm files, "FKM" */
+static constexpr uint32_t kFKMMagic = 0x004D4B46;
+/** Current version of .fkm files, connectivity stored by version 1 (vertex
+ pairs) is ignored */
+static constexpr uint16_t kFKMVersion = 2;
+/** Size reserved for the header of .fkm files */
+static constexpr size_t kFKMHeaderSize = 128;
+/** Alignment of the arrays in .fkm files */
+static constexpr size_t kFKMAlignment = 64;
+/** Flag: bounding box is valid */
+static constexpr uint32_t kFKMHasBBox = 0x01;
+/** Flag: connectivity is stored */
+static constexpr uint32_t kFKMHasConnectivity = 0x02;
+
+/**
+ *  @struct FKMHeader
+ *  @brief  Header of .fkm files, stored in the host byte order
+ */
+struct FKMHeader {
+  /** Magic number */
+  uint32_t magic;
+  /** Format version */
+  uint16_t version;
+  /** Size of the scalar type (4: float, 8: double) */
+  uint16_t scalar_size;
+  /** Number of vertices */
+  uint64_t n_vertex;
+  /** Number of normals */
+  uint64_t n_normal;
+  /** Number of texture coordinates */
+  uint64_t n_tcoord;
+  /** Number of triangles */
+  uint64_t n_tri;
+  /** Number of neighbouring vertex entries */
+  uint64_t n_con;
+  /** Bounding box minimum */
+  double bbox_min[3];
+  /** Bounding box maximum */
+  double bbox_max[3];
+  /** Flags */
+  uint32_t flags;
+  /** Reserved */
+  uint32_t reserved;
+};
+static_assert(sizeof(FKMHeader) <= kFKMHeaderSize, "FKM header too large");
+
+/**
+ *  @enum   FKMArray
+ *  @brief  Arrays stored in .fkm files, in file order
+ */
+enum FKMArray {
+  /** Vertices, 3 scalars each */
+  kFKMVertex,
+  /** Normals, 3 scalars each */
+  kFKMNormal,
+  /** Texture coordinates, 2 scalars each */
+  kFKMTCoord,
+  /** Triangles, 3 int32 each */
+  kFKMTri,
+  /** Start of each vertex's neighbours, n_vertex + 1 uint64 */
+  kFKMConOffset,
+  /** Neighbouring vertices, int32 each */
+  kFKMCon,
+  /** Start of each vertex's triangles, n_vertex + 1 uint64 */
+  kFKMTriOffset,
+  /** Incident triangles, 3 * n_tri int32 */
+  kFKMTriRef,
+  /** Number of arrays */
+  kFKMNArray
+};
+
+/**
+ *  @name   FKMLayout
+ *  @fn     static size_t FKMLayout(const FKMHeader& header, size_t* offset,
+                                    size_t* size)
+ *  @brief  Position of the arrays of a .fkm file
+ *  @param[in] header   File header
+ *  @param[out] offset  Offset of each array
+ *  @param[out] size    Size in bytes of each array
+ *  @return File size
+ */
+static size_t FKMLayout(const FKMHeader& header, size_t* offset, size_t* size) {
+  const bool con = (header.flags & kFKMHasConnectivity) != 0;
+  size[kFKMVertex] = header.n_vertex * 3 * header.scalar_size;
+  size[kFKMNormal] = header.n_normal * 3 * header.scalar_size;
+  size[kFKMTCoord] = header.n_tcoord * 2 * header.scalar_size;
+  size[kFKMTri] = header.n_tri * 3 * sizeof(int32_t);
+  size[kFKMConOffset] = con ? (header.n_vertex + 1) * sizeof(uint64_t) : 0;
+  size[kFKMCon] = header.n_con * sizeof(int32_t);
+  // Triangle references appeared with version 2
+  const bool tri_ref = con && header.version >= 2;
+  size[kFKMTriOffset] = tri_ref ? (header.n_vertex + 1) * sizeof(uint64_t) : 0;
+  size[kFKMTriRef] = tri_ref ? 3 * header.n_tri * sizeof(int32_t) : 0;
+  size_t pos = kFKMHeaderSize;
+  for (int k = 0; k < kFKMNArray; ++k) {
+    pos = (pos + kFKMAlignment - 1) & ~(kFKMAlignment - 1);
+    offset[k] = pos;
+    pos += size[k];
+  }
+  return pos;
+}
+
+/**
+ *  @name   CopyScalars
+ *  @fn     template<typename T> static void CopyScalars(const char* src,
+                                                  const size_t& scalar_size,
+                                                  const size_t& n, T* dst)
+ *  @brief  Copy `n` scalars stored as float or double
+ */
+template<typename T>
+static void CopyScalars(const char* src,
+                        const size_t& scalar_size,
+                        const size_t& n,
+                        T* dst) {
+  if (n == 0) {
+    return;
+  } else if (scalar_size == sizeof(T)) {
+    std::memcpy(static_cast<void*>(dst), src, n * sizeof(T));
+  } else if (scalar_size == sizeof(float)) {
+    for (size_t k = 0; k < n; ++k) {
+      float v;
+      std::memcpy(&v, src + k * sizeof(float), sizeof(float));
+      dst[k] = static_cast<T>(v);
+    }
+  } else {
+    for (size_t k = 0; k < n; ++k) {
+      double v;
+      std::memcpy(&v, src + k * sizeof(double), sizeof(double));
+      dst[k] = static_cast<T>(v);
+    }
+  }
+}
+
+/**
+ *  @name   ReadFKMRows
+ *  @fn     static bool ReadFKMRows(const char* offset, const char* entry,
+                                    const size_t& n_row, const size_t& n_entry,
+                                    const int& n_value,
+                                    std::vector<size_t>* row_offset,
+                                    std::vector<int>* row_entry)
+ *  @brief  Read compressed rows and check their consistency
+ *  @param[in] offset     Stored row offsets (n_row + 1 uint64)
+ *  @param[in] entry      Stored entries (int32)
+ *  @param[in] n_row      Number of rows
+ *  @param[in] n_entry    Number of entries
+ *  @param[in] n_value    Entries must lie in [0, n_value)
+ *  @param[out] row_offset  Row offsets
+ *  @param[out] row_entry   Entries
+ *  @return False if rows are not valid
+ */
+static bool ReadFKMRows(const char* offset,
+                        const char* entry,
+                        const size_t& n_row,
+                        const size_t& n_entry,
+                        const int& n_value,
+                        std::vector<size_t>* row_offset,
+                        std::vector<int>* row_entry) {
+  row_offset->resize(n_row + 1);
+  for (size_t r = 0; r <= n_row; ++r) {
+    uint64_t v;
+    std::memcpy(&v, offset + r * sizeof(v), sizeof(v));
+    (*row_offset)[r] = static_cast<size_t>(v);
+    if ((r == 0 && v != 0) || (r > 0 && v < (*row_offset)[r - 1]) ||
+        v > n_entry) {
+      return false;
+    }
+  }
+  if (row_offset->back() != n_entry) {
+    return false;
+  }
+  row_entry->resize(n_entry);
+  if (n_entry > 0) {
+    std::memcpy(row_entry->data(), entry, n_entry * sizeof(int32_t));
+  }
+  for (const auto& e : *row_entry) {
+    if (e < 0 || e >= n_value) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ *  @name LoadFKM
+ *  @fn int LoadFKM(const std::string& path)
+ *  @brief  Load mesh from native binary .fkm file, arrays are copied in
+ *          bulk from the mapped file
+ *  @param[in]  path  Path to .fkm file
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int Mesh<T>::LoadFKM(const std::string& path) {
+  static_assert(sizeof(Vertex) == 3 * sizeof(T) &&
+                sizeof(TCoord) == 2 * sizeof(T) &&
+                sizeof(Triangle) == 3 * sizeof(int32_t),
+                "Unexpected mesh element layout");
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  std::string content;
+  const char* data = nullptr;
+  size_t length = 0;
+  if (!MapContent(path, &region, &content, &data, &length)) {
+    return -1;
+  }
+  // Header
+  FKMHeader header;
+  if (length < kFKMHeaderSize) {
+    std::cout << "Error, " << path << " is not a .fkm file" << std::endl;
+    return -1;
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (header.magic != kFKMMagic || header.version > kFKMVersion ||
+      (header.scalar_size != 4 && header.scalar_size != 8)) {
+    std::cout << "Error, " << path << " is not a supported .fkm file";
+    std::cout << std::endl;
+    return -1;
+  }
+  size_t offset[kFKMNArray], size[kFKMNArray];
+  if (FKMLayout(header, offset, size) > length) {
+    std::cout << "Error, " << path << " is truncated" << std::endl;
+    return -1;
+  }
+  // Arrays
+  vertex_.resize(header.n_vertex);
+  normal_.resize(header.n_normal);
+  topo_->tex_coord_.resize(header.n_tcoord);
+  topo_->tri_.resize(header.n_tri);
+  CopyScalars(data + offset[kFKMVertex], header.scalar_size,
+              3 * header.n_vertex, reinterpret_cast<T*>(vertex_.data()));
+  CopyScalars(data + offset[kFKMNormal], header.scalar_size,
+              3 * header.n_normal, reinterpret_cast<T*>(normal_.data()));
+  CopyScalars(data + offset[kFKMTCoord], header.scalar_size,
+              2 * header.n_tcoord,
+              reinterpret_cast<T*>(topo_->tex_coord_.data()));
+  if (!topo_->tri_.empty()) {
+    std::memcpy(static_cast<void*>(topo_->tri_.data()), data + offset[kFKMTri],
+                size[kFKMTri]);
+  }
+  const int n_vertex = static_cast<int>(header.n_vertex);
+  for (const auto& tri : topo_->tri_) {
+    if (tri.x_ < 0 || tri.x_ >= n_vertex || tri.y_ < 0 ||
+        tri.y_ >= n_vertex || tri.z_ < 0 || tri.z_ >= n_vertex) {
+      std::cout << "Error, face index out of range in " << path << std::endl;
+      return -1;
+    }
+  }
+  topo_->vertex_con_offset_.clear();
+  topo_->vertex_con_.clear();
+  topo_->vertex_tri_offset_.clear();
+  topo_->vertex_tri_.clear();
+  if ((header.flags & kFKMHasConnectivity) && header.version >= 2) {
+    if (!ReadFKMRows(data + offset[kFKMConOffset], data + offset[kFKMCon],
+                     header.n_vertex, header.n_con, n_vertex,
+                     &topo_->vertex_con_offset_, &topo_->vertex_con_) ||
+        !ReadFKMRows(data + offset[kFKMTriOffset], data + offset[kFKMTriRef],
+                     header.n_vertex, 3 * header.n_tri,
+                     static_cast<int>(header.n_tri),
+                     &topo_->vertex_tri_offset_, &topo_->vertex_tri_)) {
+      std::cout << "Error, invalid connectivity in " << path << std::endl;
+      topo_->vertex_con_offset_.clear();
+      topo_->vertex_con_.clear();
+      topo_->vertex_tri_offset_.clear();
+      topo_->vertex_tri_.clear();
+      return -1;
+    }
+  }
+  // Bounding box
+  if (header.flags & kFKMHasBBox) {
+    bbox_.min_ = Vertex(T(header.bbox_min[0]), T(header.bbox_min[1]),
+                        T(header.bbox_min[2]));
+    bbox_.max_ = Vertex(T(header.bbox_max[0]), T(header.bbox_max[1]),
+                        T(header.bbox_max[2]));
+    bbox_.center_ = (bbox_.min_ + bbox_.max_) * T(0.5);
+    bbox_is_computed_ = true;
+  } else {
+    bbox_is_computed_ = false;
+  }
+  return 0;
+}
+
+/*
+ *  @name SaveFKM
+ *  @fn int SaveFKM(const std::string& path) const
+ *  @brief  Save mesh to native binary .fkm file
+ *  @param[in]  path  Path to .fkm file
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int Mesh<T>::SaveFKM(const std::string& path) const {
+  std::ofstream stream(path, std::ios_base::out | std::ios_base::binary);
+  if (!stream.is_open()) {
+    return -1;
+  }
+  const Topology& topo = *topo_;
+  const bool has_con = (topo.vertex_con_offset_.size() == vertex_.size() + 1 &&
+                        topo.vertex_tri_offset_.size() == vertex_.size() + 1);
+  // Offsets are stored as uint64
+  std::vector<uint64_t> con_offset, tri_offset;
+  if (has_con) {
+    con_offset.assign(topo.vertex_con_offset_.begin(),
+                      topo.vertex_con_offset_.end());
+    tri_offset.assign(topo.vertex_tri_offset_.begin(),
+                      topo.vertex_tri_offset_.end());
+  }
+  // Header
+  FKMHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.magic = kFKMMagic;
+  header.version = kFKMVersion;
+  header.scalar_size = sizeof(T);
+  header.n_vertex = vertex_.size();
+  header.n_normal = normal_.size();
+  header.n_tcoord = topo_->tex_coord_.size();
+  header.n_tri = topo_->tri_.size();
+  header.n_con = has_con ? topo_->vertex_con_.size() : 0;
+  header.flags = has_con ? kFKMHasConnectivity : 0;
+  if (bbox_is_computed_) {
+    const T* min = &bbox_.min_.x_;
+    const T* max = &bbox_.max_.x_;
+    for (int k = 0; k < 3; ++k) {
+      header.bbox_min[k] = min[k];
+      header.bbox_max[k] = max[k];
+    }
+    header.flags |= kFKMHasBBox;
+  }
+  size_t offset[kFKMNArray], size[kFKMNArray];
+  FKMLayout(header, offset, size);
+  const char* arrays[kFKMNArray] = {
+    reinterpret_cast<const char*>(vertex_.data()),
+    reinterpret_cast<const char*>(normal_.data()),
+    reinterpret_cast<const char*>(topo_->tex_coord_.data()),
+    reinterpret_cast<const char*>(topo_->tri_.data()),
+    reinterpret_cast<const char*>(con_offset.data()),
+    reinterpret_cast<const char*>(topo_->vertex_con_.data()),
+    reinterpret_cast<const char*>(tri_offset.data()),
+    reinterpret_cast<const char*>(topo_->vertex_tri_.data())
+  };
+  char header_buffer[kFKMHeaderSize] = {0};
+  std::memcpy(header_buffer, &header, sizeof(header));
+  stream.write(header_buffer, kFKMHeaderSize);
+  const char padding[kFKMAlignment] = {0};
+  size_t pos = kFKMHeaderSize;
+  for (int k = 0; k < kFKMNArray; ++k) {
+    stream.write(padding, offset[k] - pos);
+    stream.write(arrays[k], size[k]);
+    pos = offset[k] + size[k];
+  }
+  return stream.good() ? 0 : -1;
+}
+
+#pragma mark -
+#pragma mark Layout
+
+/** Size of the simulated vertex cache used to score triangles */
+static constexpr int kVertexCacheSize = 32;
+
+/**
+ *  @name   ForsythOrder
+ *  @fn     template<typename Tri> static void ForsythOrder(
+                                        const std::vector<Tri>& tri,
+                                        const size_t& n_vertex,
+                                        std::vector<int>* order)
+ *  @brief  Triangle order maximizing post-transform vertex cache reuse.
+ *          Triangles are emitted greedily by score, a vertex scores high
+ *          when recently used (simulated LRU cache) and when few of its
+ *          triangles remain.
+ *  @see  T. Forsyth, "Linear-Speed Vertex Cache Optimisation", 2006
+ *  @param[in] tri      Triangles
+ *  @param[in] n_vertex Number of vertices
+ *  @param[out] order   Triangle indices in emission order
+ */
+template<typename Tri>
+static void ForsythOrder(const std::vector<Tri>& tri,
+                         const size_t& n_vertex,
+                         std::vector<int>* order) {
+  const size_t n_tri = tri.size();
+  // Score tables
+  float cache_score[kVertexCacheSize];
+  for (int k = 0; k < kVertexCacheSize; ++k) {
+    cache_score[k] = k < 3 ?
+            0.75f :
+            std::pow(1.f - float(k - 3) / float(kVertexCacheSize - 3), 1.5f);
+  }
+  float valence_score[kVertexCacheSize];
+  for (int k = 0; k < kVertexCacheSize; ++k) {
+    valence_score[k] = k > 0 ? 2.f / std::sqrt(float(k)) : 0.f;
+  }
+  // Remaining triangles of each vertex, removed by swapping with the last
+  // active one
+  std::vector<size_t> offset(n_vertex + 1, 0);
+  for (const auto& t : tri) {
+    offset[t.x_ + 1] += 1;
+    offset[t.y_ + 1] += 1;
+    offset[t.z_ + 1] += 1;
+  }
+  for (size_t v = 0; v < n_vertex; ++v) {
+    offset[v + 1] += offset[v];
+  }
+  std::vector<int> adj(offset[n_vertex]);
+  std::vector<int> n_active(n_vertex, 0);
+  for (size_t t = 0; t < n_tri; ++t) {
+    const int* idx = &tri[t].x_;
+    for (int e = 0; e < 3; ++e) {
+      adj[offset[idx[e]] + n_active[idx[e]]++] = static_cast<int>(t);
+    }
+  }
+  std::vector<int> cache_pos(n_vertex, -1);
+  std::vector<float> v_score(n_vertex);
+  auto score = [&](const int& v) {
+    const int n = n_active[v];
+    if (n == 0) {
+      return -1.f;
+    }
+    const int p = cache_pos[v];
+    const float s = p >= 0 ? cache_score[p] : 0.f;
+    return s + (n < kVertexCacheSize ? valence_score[n] :
+                                       2.f / std::sqrt(float(n)));
+  };
+  for (size_t v = 0; v < n_vertex; ++v) {
+    v_score[v] = score(static_cast<int>(v));
+  }
+  std::vector<float> t_score(n_tri);
+  std::vector<uint8_t> emitted(n_tri, 0);
+  int best = -1;
+  float best_score = -1.f;
+  for (size_t t = 0; t < n_tri; ++t) {
+    t_score[t] = (v_score[tri[t].x_] + v_score[tri[t].y_] +
+                  v_score[tri[t].z_]);
+    if (t_score[t] > best_score) {
+      best_score = t_score[t];
+      best = static_cast<int>(t);
+    }
+  }
+  // Cache holds up to three extra entries while a triangle is inserted
+  int cache[kVertexCacheSize + 3];
+  int n_cache = 0;
+  size_t cursor = 0;
+  order->clear();
+  order->reserve(n_tri);
+  while (best >= 0) {
+    order->push_back(best);
+    emitted[best] = 1;
+    const int* idx = &tri[best].x_;
+    for (int e = 0; e < 3; ++e) {
+      const int v = idx[e];
+      int* row = &adj[offset[v]];
+      const int n = n_active[v];
+      for (int k = 0; k < n; ++k) {
+        if (row[k] == best) {
+          std::swap(row[k], row[n - 1]);
+          break;
+        }
+      }
+      n_active[v] = n - 1;
+    }
+    // Move the triangle's vertices to the front of the cache
+    int next[kVertexCacheSize + 3];
+    int n_next = 0;
+    for (int e = 0; e < 3; ++e) {
+      next[n_next++] = idx[e];
+    }
+    for (int k = 0; k < n_cache; ++k) {
+      const int v = cache[k];
+      if (v != idx[0] && v != idx[1] && v != idx[2]) {
+        next[n_next++] = v;
+      }
+    }
+    // Rescore cached and evicted vertices, the best candidate is searched
+    // among their triangles
+    best = -1;
+    best_score = -1.f;
+    for (int k = 0; k < n_next; ++k) {
+      const int v = next[k];
+      cache_pos[v] = k < kVertexCacheSize ? k : -1;
+      const float s = score(v);
+      const float delta = s - v_score[v];
+      v_score[v] = s;
+      const int* row = &adj[offset[v]];
+      for (int j = 0; j < n_active[v]; ++j) {
+        const int t = row[j];
+        t_score[t] += delta;
+        if (t_score[t] > best_score) {
+          best_score = t_score[t];
+          best = t;
+        }
+      }
+    }
+    n_cache = std::min(n_next, kVertexCacheSize);
+    std::copy(next, next + n_cache, cache);
+    if (best < 0) {
+      // Nothing adjacent to the cache, continue with the next triangle left
+      while (cursor < n_tri && emitted[cursor]) {
+        ++cursor;
+      }
+      best = cursor < n_tri ? static_cast<int>(cursor) : -1;
+    }
+  }
+}
+
+/**
+ *  @name   SpreadBits
+ *  @fn     static uint32_t SpreadBits(uint32_t x)
+ *  @brief  Insert two zero bits between each of the 10 lowest bits of `x`
+ */
+static uint32_t SpreadBits(uint32_t x) {
+  x &= 0x3FF;
+  x = (x | (x << 16)) & 0x030000FF;
+  x = (x | (x << 8)) & 0x0300F00F;
+  x = (x | (x << 4)) & 0x030C30C3;
+  x = (x | (x << 2)) & 0x09249249;
+  return x;
+}
+
+/**
+ *  @name   PermuteVertexData
+ *  @fn     template<typename U> static void PermuteVertexData(
+                                            const std::vector<int>& order,
+                                            std::vector<U>* data)
+ *  @brief  Apply `data[new] = data[order[new]]`, attributes not matching
+ *          the number of vertices are left untouched
+ */
+template<typename U>
+static void PermuteVertexData(const std::vector<int>& order,
+                              std::vector<U>* data) {
+  if (data->size() != order.size()) {
+    return;
+  }
+  std::vector<U> out(data->size());
+  for (size_t k = 0; k < order.size(); ++k) {
+    out[k] = (*data)[order[k]];
+  }
+  data->swap(out);
+}
+
+/*
+ *  @name OptimizeLayout
+ *  @fn void OptimizeLayout(const VertexLayout& layout,
+                            std::vector<int>* vertex_order)
+ *  @brief  Reorder triangles for vertex cache reuse then vertices for
+ *          locality
+ *  @param[in] layout         Vertex ordering
+ *  @param[out] vertex_order  Permutation applied, `vertex_order[new]` is the
+ *                            previous index of vertex `new`
+ */
+template<typename T>
+void Mesh<T>::OptimizeLayout(const VertexLayout& layout,
+                             std::vector<int>* vertex_order) {
+  this->Detach();
+  const size_t n_vert = vertex_.size();
+  // Triangles
+  std::vector<int> tri_order;
+  ForsythOrder(topo_->tri_, n_vert, &tri_order);
+  std::vector<Triangle> tri(topo_->tri_.size());
+  for (size_t t = 0; t < tri_order.size(); ++t) {
+    tri[t] = topo_->tri_[tri_order[t]];
+  }
+  topo_->tri_.swap(tri);
+  // Vertices
+  vertex_order->resize(n_vert);
+  if (layout == kMortonLayout) {
+    Vertex lo(std::numeric_limits<T>::max(),
+              std::numeric_limits<T>::max(),
+              std::numeric_limits<T>::max());
+    Vertex hi(std::numeric_limits<T>::lowest(),
+              std::numeric_limits<T>::lowest(),
+              std::numeric_limits<T>::lowest());
+    for (const auto& v : vertex_) {
+      lo.x_ = std::min(lo.x_, v.x_);
+      lo.y_ = std::min(lo.y_, v.y_);
+      lo.z_ = std::min(lo.z_, v.z_);
+      hi.x_ = std::max(hi.x_, v.x_);
+      hi.y_ = std::max(hi.y_, v.y_);
+      hi.z_ = std::max(hi.z_, v.z_);
+    }
+    const T* l = &lo.x_;
+    const T* h = &hi.x_;
+    T scale[3];
+    for (int k = 0; k < 3; ++k) {
+      scale[k] = h[k] > l[k] ? T(1023.0) / (h[k] - l[k]) : T(0.0);
+    }
+    std::vector<uint32_t> code(n_vert);
+    for (size_t v = 0; v < n_vert; ++v) {
+      const T* p = &vertex_[v].x_;
+      uint32_t c = 0;
+      for (int k = 0; k < 3; ++k) {
+        c |= SpreadBits(static_cast<uint32_t>((p[k] - l[k]) * scale[k])) << k;
+      }
+      code[v] = c;
+      (*vertex_order)[v] = static_cast<int>(v);
+    }
+    std::stable_sort(vertex_order->begin(),
+                     vertex_order->end(),
+                     [&](const int& a, const int& b) {
+      return code[a] < code[b];
+    });
+  } else {
+    // First use, unreferenced vertices keep their relative order at the end
+    std::vector<int> remap(n_vert, -1);
+    int n = 0;
+    for (const auto& t : topo_->tri_) {
+      const int* idx = &t.x_;
+      for (int e = 0; e < 3; ++e) {
+        if (remap[idx[e]] < 0) {
+          remap[idx[e]] = n;
+          (*vertex_order)[n++] = idx[e];
+        }
+      }
+    }
+    for (size_t v = 0; v < n_vert; ++v) {
+      if (remap[v] < 0) {
+        (*vertex_order)[n++] = static_cast<int>(v);
+      }
+    }
+  }
+  // Apply
+  std::vector<int> remap(n_vert);
+  for (size_t k = 0; k < n_vert; ++k) {
+    remap[(*vertex_order)[k]] = static_cast<int>(k);
+  }
+  for (auto& t : topo_->tri_) {
+    t.x_ = remap[t.x_];
+    t.y_ = remap[t.y_];
+    t.z_ = remap[t.z_];
+  }
+  PermuteVertexData(*vertex_order, &vertex_);
+  PermuteVertexData(*vertex_order, &normal_);
+  PermuteVertexData(*vertex_order, &topo_->tex_coord_);
+  PermuteVertexData(*vertex_order, &tangent_);
+  PermuteVertexData(*vertex_order, &vertex_color_);
+  // Caches indexed by vertex, overall bounding box is unchanged
+  block_bbox_.clear();
+  normal_dirty_.clear();
+  bbox_dirty_.clear();
+  buffer_dirty_.clear();
+  if (!topo_->vertex_tri_offset_.empty()) {
+    this->BuildConnectivity();
+  }
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/** Number of vertices sharing a dirty flag / bounding box */
+static constexpr size_t kMeshBlockSize = 1024;
+
+  /*
+   *  @name ComputeVertexNormal
+   *  @fn template<typename Math> void ComputeVertexNormal(void)
+   *  @brief  Compute normal for each vertex in the object
+   *  @tparam Math  Math policy
+   */
+template<typename T>
+template<typename Math>
+void Mesh<T>::ComputeVertexNormal(void) {
+  // Loop over all vertex
+  assert(topo_->vertex_tri_offset_.size() == vertex_.size() + 1);
+  const size_t n_vert = vertex_.size();
+  normal_.resize(n_vert, Mesh::Normal());
+  ThreadPool::Get().ParallelFor(0,
+                                n_vert,
+                                0,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t v = first; v < last; ++v) {
+      normal_[v] = this->template VertexNormal<Math>(v);
+    }
+  });
+  normal_dirty_.assign((n_vert + kMeshBlockSize - 1) / kMeshBlockSize, 0);
+  buffer_dirty_.clear();
+}
+
+/*
+ *  @name   VertexNormal
+ *  @fn     template<typename Math> Normal VertexNormal(const size_t& v) const
+ *  @brief  Angle weighted normal of a vertex, from its incident triangles
+ *  @param[in] v  Vertex index
+ *  @tparam Math  Math policy
+ *  @return Normal
+ */
+template<typename T>
+template<typename Math>
+typename Mesh<T>::Normal Mesh<T>::VertexNormal(const size_t& v) const {
+  // Loop over all incident triangles
+  const Vertex& A = vertex_[v];
+  Normal weighted_n;
+  const Topology& topo = *topo_;
+  for (size_t k = topo.vertex_tri_offset_[v];
+       k < topo.vertex_tri_offset_[v + 1];
+       ++k) {
+    // Other corners in triangle's order
+    const int* idx = &(topo.tri_[topo.vertex_tri_[k]].x_);
+    const int e = idx[0] == static_cast<int>(v) ? 0 :
+                  (idx[1] == static_cast<int>(v) ? 1 : 2);
+    const Vertex& B = vertex_[idx[(e + 1) % 3]];
+    const Vertex& C = vertex_[idx[(e + 2) % 3]];
+    // Define edges AB, AC
+    Edge AB = B - A;
+    Edge AC = C - A;
+    // Compute surface's normal (triangle ABC)
+    Normal n = AB ^ AC;
+    n.template Normalize<Math>();
+    // Stack each face contribution and weight with angle
+    AB.template Normalize<Math>();
+    AC.template Normalize<Math>();
+    const T angle = Math::Acos(AB * AC);
+    weighted_n += (n * angle);
+  }
+  // normalize
+  weighted_n.template Normalize<Math>();
+  return weighted_n;
+}
+
+/** Minimum number of faces accumulated in a separate buffer */
+static constexpr size_t kNormalPartSize = 1 << 16;
+/** Maximum number of accumulation buffers, bounds the extra memory */
+static constexpr size_t kNormalMaxPart = 8;
+
+/**
+ *  @name FaceNormal
+ *  @fn template<typename T> static bool FaceNormal(const Vector3<T>& A,
+                                                    const Vector3<T>& B,
+                                                    const Vector3<T>& C,
+                                                    Vector3<T>* n)
+ *  @brief  Normal of a face, shared by the normal and tangent space passes
+ *  @param[in] A      First corner
+ *  @param[in] B      Second corner
+ *  @param[in] C      Third corner
+ *  @param[out] n     Face normal, its length is twice the face's area
+ *  @return False if the face is degenerate
+ */
+template<typename T>
+static inline bool FaceNormal(const Vector3<T>& A,
+                              const Vector3<T>& B,
+                              const Vector3<T>& C,
+                              Vector3<T>* n) {
+  *n = (A - C) ^ (B - A);
+  return (*n * *n) > T(0.0);
+}
+
+/**
+ *  @name CornerAngles
+ *  @fn template<typename T, typename Math> static void CornerAngles(
+                              const Vector3<T>& A, const Vector3<T>& B,
+                              const Vector3<T>& C, Vector3<T>* n, T* w)
+ *  @brief  Interior angles of a non-degenerate face, used as weights of its
+ *          contribution to each corner
+ *  @param[in] A      First corner
+ *  @param[in] B      Second corner
+ *  @param[in] C      Third corner
+ *  @param[in,out] n  Face normal, normalized
+ *  @param[out] w     Angle at each corner
+ */
+template<typename T, typename Math>
+static inline void CornerAngles(const Vector3<T>& A,
+                                const Vector3<T>& B,
+                                const Vector3<T>& C,
+                                Vector3<T>* n,
+                                T* w) {
+  // Edges normalized once per face
+  Vector3<T> AB = B - A;
+  Vector3<T> BC = C - B;
+  Vector3<T> CA = A - C;
+  n->template Normalize<Math>();
+  AB.template Normalize<Math>();
+  BC.template Normalize<Math>();
+  CA.template Normalize<Math>();
+  w[0] = Math::Acos(-(CA * AB));
+  w[1] = Math::Acos(-(AB * BC));
+  w[2] = Math::Acos(-(BC * CA));
+}
+
+/**
+ *  @name FacePartCount
+ *  @fn static size_t FacePartCount(const size_t& n_tri)
+ *  @brief  Number of parts faces are split in, each part is accumulated in
+ *          its own buffer
+ *  @param[in] n_tri  Number of faces
+ *  @return Number of parts
+ */
+static size_t FacePartCount(const size_t& n_tri) {
+  const size_t n_worker = ThreadPool::Get().size() + 1;
+  return std::max<size_t>(1, std::min(std::min(n_worker, kNormalMaxPart),
+                                      n_tri / kNormalPartSize));
+}
+
+/*
+ *  @name ComputeVertexNormalFromFaces
+ *  @fn template<typename Math> void ComputeVertexNormalFromFaces(
+                                        const NormalWeighting& weighting)
+ *  @brief  Compute normal for each vertex without connectivity
+ *  @param[in] weighting  Weighting of face contributions
+ *  @tparam Math  Math policy
+ */
+template<typename T>
+template<typename Math>
+void Mesh<T>::ComputeVertexNormalFromFaces(const NormalWeighting& weighting) {
+  const size_t n_vert = vertex_.size();
+  const size_t n_tri = topo_->tri_.size();
+  const bool area = weighting == kAreaWeighting;
+  auto& pool = ThreadPool::Get();
+  // Faces are split in parts accumulated in their own buffer, the first one
+  // directly in `normal_`
+  const size_t n_part = FacePartCount(n_tri);
+  normal_.assign(n_vert, Normal());
+  std::vector<std::vector<Normal>> acc(n_part - 1);
+  pool.ParallelFor(0, n_part, 1, [&](const size_t& first, const size_t& last) {
+    for (size_t p = first; p < last; ++p) {
+      Normal* sum = normal_.data();
+      if (p > 0) {
+        acc[p - 1].assign(n_vert, Normal());
+        sum = acc[p - 1].data();
+      }
+      const size_t t_first = (n_tri * p) / n_part;
+      const size_t t_last = (n_tri * (p + 1)) / n_part;
+      for (size_t t = t_first; t < t_last; ++t) {
+        const int* idx = &(topo_->tri_[t].x_);
+        const Vertex& A = vertex_[idx[0]];
+        const Vertex& B = vertex_[idx[1]];
+        const Vertex& C = vertex_[idx[2]];
+        Normal n;
+        if (!FaceNormal(A, B, C, &n)) {
+          continue;
+        }
+        if (area) {
+          sum[idx[0]] += n;
+          sum[idx[1]] += n;
+          sum[idx[2]] += n;
+        } else {
+          T w[3];
+          CornerAngles<T, Math>(A, B, C, &n, w);
+          sum[idx[0]] += n * w[0];
+          sum[idx[1]] += n * w[1];
+          sum[idx[2]] += n * w[2];
+        }
+      }
+    }
+  });
+  // Reduce parts and normalize
+  pool.ParallelFor(0, n_vert, 0, [&](const size_t& first, const size_t& last) {
+    for (size_t v = first; v < last; ++v) {
+      Normal& n = normal_[v];
+      for (const auto& a : acc) {
+        n += a[v];
+      }
+      n.template Normalize<Math>();
+    }
+  });
+  buffer_dirty_.clear();
 }
 
+/**
+ *  @struct TangentFrame
+ *  @brief  Accumulated normal, tangent and bitangent of a vertex
+ */
+template<typename T>
+struct TangentFrame {
+  /** Normal */
+  Vector3<T> n;
+  /** Tangent, direction of increasing u */
+  Vector3<T> t;
+  /** Bitangent, direction of increasing v */
+  Vector3<T> b;
+};
+
+/*
+ *  @name ComputeTangentSpace
+ *  @fn template<typename Math> void ComputeTangentSpace(
+                                        const NormalWeighting& weighting)
+ *  @brief  Compute normal and tangent for each vertex in a single sweep
+ *          over the faces
+ *  @param[in] weighting  Weighting of face contributions
+ *  @tparam Math  Math policy
+ */
+template<typename T>
+template<typename Math>
+void Mesh<T>::ComputeTangentSpace(const NormalWeighting& weighting) {
+  const size_t n_vert = vertex_.size();
+  const size_t n_tri = topo_->tri_.size();
+  const auto& tcoord = topo_->tex_coord_;
+  const bool per_vertex = n_vert != 0 && tcoord.size() == n_vert;
+  if (!per_vertex && (n_tri == 0 || tcoord.size() != 3 * n_tri)) {
+    // Tangents are undefined without texture coordinates
+    this->template ComputeVertexNormalFromFaces<Math>(weighting);
+    tangent_.clear();
+    return;
+  }
+  const bool area = weighting == kAreaWeighting;
+  auto& pool = ThreadPool::Get();
+  const size_t n_part = FacePartCount(n_tri);
+  std::vector<std::vector<TangentFrame<T>>> acc(n_part);
+  pool.ParallelFor(0, n_part, 1, [&](const size_t& first, const size_t& last) {
+    for (size_t p = first; p < last; ++p) {
+      acc[p].assign(n_vert, TangentFrame<T>());
+      TangentFrame<T>* sum = acc[p].data();
+      const size_t t_first = (n_tri * p) / n_part;
+      const size_t t_last = (n_tri * (p + 1)) / n_part;
+      for (size_t t = t_first; t < t_last; ++t) {
+        const int* idx = &(topo_->tri_[t].x_);
+        const Vertex& A = vertex_[idx[0]];
+        const Vertex& B = vertex_[idx[1]];
+        const Vertex& C = vertex_[idx[2]];
+        Normal n;
+        T w[3] = {T(1.0), T(1.0), T(1.0)};
+        if (!FaceNormal(A, B, C, &n)) {
+          continue;
+        }
+        const T scale = area ? n.Norm() : T(1.0);
+        if (!area) {
+          CornerAngles<T, Math>(A, B, C, &n, w);
+        }
+        for (int k = 0; k < 3; ++k) {
+          sum[idx[k]].n += n * w[k];
+        }
+        // Gradient of the parametrization, dP/du and dP/dv
+        const TCoord& ta = per_vertex ? tcoord[idx[0]] : tcoord[3 * t];
+        const TCoord& tb = per_vertex ? tcoord[idx[1]] : tcoord[3 * t + 1];
+        const TCoord& tc = per_vertex ? tcoord[idx[2]] : tcoord[3 * t + 2];
+        const T du1 = tb.x_ - ta.x_;
+        const T dv1 = tb.y_ - ta.y_;
+        const T du2 = tc.x_ - ta.x_;
+        const T dv2 = tc.y_ - ta.y_;
+        const T det = (du1 * dv2) - (du2 * dv1);
+        if (det == T(0.0)) {
+          // Degenerate parametrization, normal only
+          continue;
+        }
+        const Edge AB = B - A;
+        const Edge AC = C - A;
+        const T sign = det > T(0.0) ? T(1.0) : T(-1.0);
+        Edge ft = ((AB * dv2) - (AC * dv1)) * sign;
+        Edge fb = ((AC * du1) - (AB * du2)) * sign;
+        if (!((ft * ft) > T(0.0)) || !((fb * fb) > T(0.0))) {
+          continue;
+        }
+        // Unit directions weighted like the normal, i.e. by angle
+        ft.template Normalize<Math>();
+        fb.template Normalize<Math>();
+        for (int k = 0; k < 3; ++k) {
+          sum[idx[k]].t += ft * (w[k] * scale);
+          sum[idx[k]].b += fb * (w[k] * scale);
+        }
+      }
+    }
+  });
+  // Reduce parts, orthonormalize against the normal and set handedness
+  normal_.resize(n_vert);
+  tangent_.resize(n_vert);
+  pool.ParallelFor(0, n_vert, 0, [&](const size_t& first, const size_t& last) {
+    for (size_t v = first; v < last; ++v) {
+      TangentFrame<T> f = acc[0][v];
+      for (size_t p = 1; p < n_part; ++p) {
+        f.n += acc[p][v].n;
+        f.t += acc[p][v].t;
+        f.b += acc[p][v].b;
+      }
+      f.n.template Normalize<Math>();
+      f.t -= f.n * (f.n * f.t);
+      if (!((f.t * f.t) > T(1e-12) * (f.b * f.b))) {
+        // No usable direction, any vector orthogonal to the normal
+        const Edge axis = std::abs(f.n.x_) < T(0.9) ? Edge(1, 0, 0) :
+                                                     Edge(0, 1, 0);
+        f.t = f.n ^ axis;
+      }
+      f.t.template Normalize<Math>();
+      const T w = ((f.n ^ f.t) * f.b) < T(0.0) ? T(-1.0) : T(1.0);
+      normal_[v] = f.n;
+      tangent_[v] = Tangent(f.t.x_, f.t.y_, f.t.z_, w);
+    }
+  });
+  buffer_dirty_.clear();
+}
+
+#if defined(FACEKIT_FLOAT_ONLY)
+/** Accumulator of the vertex sum within a block, blocks are merged in
+    double precision */
+template<typename T>
+using BlockSum = T;
+#else
+/** Accumulator of the vertex sum within a block */
+template<typename T>
+using BlockSum = double;
+#endif
+
+/**
+ *  @struct VertexBounds
+ *  @brief  Bounds and sum of a range of vertices
+ */
+template<typename T>
+struct VertexBounds {
+  /** Minimum corner */
+  T min[3];
+  /** Maximum corner */
+  T max[3];
+  /** Sum of the vertices */
+  BlockSum<T> sum[3];
+
+  /**
+   *  @name VertexBounds
+   *  @fn VertexBounds(void)
+   *  @brief  Constructor, empty range
+   */
+  VertexBounds(void) {
+    for (int k = 0; k < 3; ++k) {
+      min[k] = std::numeric_limits<T>::max();
+      max[k] = std::numeric_limits<T>::lowest();
+      sum[k] = BlockSum<T>(0);
+    }
+  }
+};
+
+/**
+ *  @name ReduceVertex
+ *  @fn static void ReduceVertex(const T* p, const size_t& n,
+                                 VertexBounds<T>* res)
+ *  @brief  Bounds and sum of `n` packed (x, y, z) vertices
+ *  @param[in] p      Vertices
+ *  @param[in] n      Number of vertices
+ *  @param[out] res   Bounds and sum
+ */
+template<typename T>
+static void ReduceVertex(const T* p, const size_t& n, VertexBounds<T>* res) {
+  // Local accumulators, `res` could alias `p` otherwise
+  T mn[3] = {res->min[0], res->min[1], res->min[2]};
+  T mx[3] = {res->max[0], res->max[1], res->max[2]};
+  BlockSum<T> sum[3] = {res->sum[0], res->sum[1], res->sum[2]};
+  for (size_t i = 0; i < n; ++i, p += 3) {
+    for (int k = 0; k < 3; ++k) {
+      mn[k] = p[k] < mn[k] ? p[k] : mn[k];
+      mx[k] = p[k] > mx[k] ? p[k] : mx[k];
+      sum[k] += static_cast<BlockSum<T>>(p[k]);
+    }
+  }
+  for (int k = 0; k < 3; ++k) {
+    res->min[k] = mn[k];
+    res->max[k] = mx[k];
+    res->sum[k] = sum[k];
+  }
+}
+
+/**
+ *  @name TranslateVertex
+ *  @fn static void TranslateVertex(const T* d, const size_t& n, T* p)
+ *  @brief  Add a displacement to `n` packed (x, y, z) vertices
+ *  @param[in] d      Displacement
+ *  @param[in] n      Number of vertices
+ *  @param[in,out] p  Vertices
+ */
+template<typename T>
+static void TranslateVertex(const T* d, const size_t& n, T* p) {
+  for (size_t i = 0; i < n; ++i, p += 3) {
+    p[0] += d[0];
+    p[1] += d[1];
+    p[2] += d[2];
+  }
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+/*
+ *  @name ReduceVertex
+ *  @fn static void ReduceVertex(const float* p, const size_t& n,
+                                 VertexBounds<float>* res)
+ *  @brief  Bounds and sum of `n` packed (x, y, z) vertices, SSE2 version.
+ *          Four vertices span three registers whose lanes hold the axes
+ *          (x y z x), (y z x y) and (z x y z), they are folded back per axis
+ *          at the end. The sum stays in single precision lanes when built
+ *          with FACEKIT_FLOAT_ONLY.
+ */
+static void ReduceVertex(const float* p,
+                         const size_t& n,
+                         VertexBounds<float>* res) {
+  const size_t n4 = n & ~size_t(3);
+  if (n4 != 0) {
+    __m128 mn[3], mx[3];
+#if defined(FACEKIT_FLOAT_ONLY)
+    __m128 sum[3];
+#else
+    __m128d s_lo[3], s_hi[3];
+#endif
+    for (int r = 0; r < 3; ++r) {
+      mn[r] = _mm_set1_ps(std::numeric_limits<float>::max());
+      mx[r] = _mm_set1_ps(std::numeric_limits<float>::lowest());
+#if defined(FACEKIT_FLOAT_ONLY)
+      sum[r] = _mm_setzero_ps();
+#else
+      s_lo[r] = _mm_setzero_pd();
+      s_hi[r] = _mm_setzero_pd();
+#endif
+    }
+    for (size_t i = 0; i < n4; i += 4) {
+      const float* q = p + 3 * i;
+      for (int r = 0; r < 3; ++r) {
+        const __m128 v = _mm_loadu_ps(q + 4 * r);
+        mn[r] = _mm_min_ps(mn[r], v);
+        mx[r] = _mm_max_ps(mx[r], v);
+#if defined(FACEKIT_FLOAT_ONLY)
+        sum[r] = _mm_add_ps(sum[r], v);
+#else
+        s_lo[r] = _mm_add_pd(s_lo[r], _mm_cvtps_pd(v));
+        s_hi[r] = _mm_add_pd(s_hi[r], _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+#endif
+      }
+    }
+    alignas(16) float f_mn[12], f_mx[12];
+    alignas(16) BlockSum<float> d_sum[12];
+    for (int r = 0; r < 3; ++r) {
+      _mm_store_ps(f_mn + 4 * r, mn[r]);
+      _mm_store_ps(f_mx + 4 * r, mx[r]);
+#if defined(FACEKIT_FLOAT_ONLY)
+      _mm_store_ps(d_sum + 4 * r, sum[r]);
+#else
+      _mm_store_pd(d_sum + 4 * r, s_lo[r]);
+      _mm_store_pd(d_sum + 4 * r + 2, s_hi[r]);
+#endif
+    }
+    // Lane l of the flattened registers holds axis l % 3
+    for (int l = 0; l < 12; ++l) {
+      const int k = l % 3;
+      res->min[k] = std::min(res->min[k], f_mn[l]);
+      res->max[k] = std::max(res->max[k], f_mx[l]);
+      res->sum[k] += d_sum[l];
+    }
+  }
+  ReduceVertex<float>(p + 3 * n4, n - n4, res);
+}
+
+/*
+ *  @name TranslateVertex
+ *  @fn static void TranslateVertex(const float* d, const size_t& n,
+                                    float* p)
+ *  @brief  Add a displacement to `n` packed (x, y, z) vertices, SSE2 version
+ */
+static void TranslateVertex(const float* d, const size_t& n, float* p) {
+  const size_t n4 = n & ~size_t(3);
+  const __m128 d_r[3] = {_mm_setr_ps(d[0], d[1], d[2], d[0]),
+                         _mm_setr_ps(d[1], d[2], d[0], d[1]),
+                         _mm_setr_ps(d[2], d[0], d[1], d[2])};
+  for (size_t i = 0; i < n4; i += 4) {
+    float* q = p + 3 * i;
+    for (int r = 0; r < 3; ++r) {
+      _mm_storeu_ps(q + 4 * r, _mm_add_ps(_mm_loadu_ps(q + 4 * r), d_r[r]));
+    }
+  }
+  TranslateVertex<float>(d, n - n4, p + 3 * n4);
+}
+
+/*
+ *  @name ReduceVertex
+ *  @fn static void ReduceVertex(const double* p, const size_t& n,
+                                 VertexBounds<double>* res)
+ *  @brief  Bounds and sum of `n` packed (x, y, z) vertices, SSE2 version.
+ *          Two vertices span three registers whose lanes hold the axes
+ *          (x y), (z x) and (y z).
+ */
+static void ReduceVertex(const double* p,
+                         const size_t& n,
+                         VertexBounds<double>* res) {
+  const size_t n2 = n & ~size_t(1);
+  if (n2 != 0) {
+    __m128d mn[3], mx[3], sum[3];
+    for (int r = 0; r < 3; ++r) {
+      mn[r] = _mm_set1_pd(std::numeric_limits<double>::max());
+      mx[r] = _mm_set1_pd(std::numeric_limits<double>::lowest());
+      sum[r] = _mm_setzero_pd();
+    }
+    for (size_t i = 0; i < n2; i += 2) {
+      const double* q = p + 3 * i;
+      for (int r = 0; r < 3; ++r) {
+        const __m128d v = _mm_loadu_pd(q + 2 * r);
+        mn[r] = _mm_min_pd(mn[r], v);
+        mx[r] = _mm_max_pd(mx[r], v);
+        sum[r] = _mm_add_pd(sum[r], v);
+      }
+    }
+    alignas(16) double d_mn[6], d_mx[6], d_sum[6];
+    for (int r = 0; r < 3; ++r) {
+      _mm_store_pd(d_mn + 2 * r, mn[r]);
+      _mm_store_pd(d_mx + 2 * r, mx[r]);
+      _mm_store_pd(d_sum + 2 * r, sum[r]);
+    }
+    // Lane l of the flattened registers holds axis l % 3
+    for (int l = 0; l < 6; ++l) {
+      const int k = l % 3;
+      res->min[k] = std::min(res->min[k], d_mn[l]);
+      res->max[k] = std::max(res->max[k], d_mx[l]);
+      res->sum[k] += d_sum[l];
+    }
+  }
+  ReduceVertex<double>(p + 3 * n2, n - n2, res);
+}
+
+/*
+ *  @name TranslateVertex
+ *  @fn static void TranslateVertex(const double* d, const size_t& n,
+                                    double* p)
+ *  @brief  Add a displacement to `n` packed (x, y, z) vertices, SSE2 version
+ */
+static void TranslateVertex(const double* d, const size_t& n, double* p) {
+  const size_t n2 = n & ~size_t(1);
+  const __m128d d_r[3] = {_mm_setr_pd(d[0], d[1]),
+                          _mm_setr_pd(d[2], d[0]),
+                          _mm_setr_pd(d[1], d[2])};
+  for (size_t i = 0; i < n2; i += 2) {
+    double* q = p + 3 * i;
+    for (int r = 0; r < 3; ++r) {
+      _mm_storeu_pd(q + 2 * r, _mm_add_pd(_mm_loadu_pd(q + 2 * r), d_r[r]));
+    }
+  }
+  TranslateVertex<double>(d, n - n2, p + 3 * n2);
+}
+#endif
+
 /*
  *  @name ComputeBoundingBox
- *  @fn void ComputeBoundingBox(void)
- *  @brief  Compute the bounding box of the mesh
- */
-template<typename T>
-void Mesh<T>::ComputeBoundingBox(void) {
- // Init bbox
- bbox_.min_.x_ = std::numeric_limits<T>::max();
- bbox_.max_.x_ = std::numeric_limits<T>::lowest();
- bbox_.min_.y_ = std::numeric_limits<T>::max();
- bbox_.max_.y_ = std::numeric_limits<T>::lowest();
- bbox_.min_.z_ = std::numeric_limits<T>::max();
- bbox_.max_.z_ = std::numeric_limits<T>::lowest();
-
- for (auto v_it = this->vertex_.begin(); v_it != this->vertex_.end(); ++v_it) {
-   // Compute boundary box
-   bbox_.min_.x_ = bbox_.min_.x_ < v_it->x_ ? bbox_.min_.x_ : v_it->x_;
-   bbox_.max_.x_ = bbox_.max_.x_ > v_it->x_ ? bbox_.max_.x_ : v_it->x_;
-   bbox_.min_.y_ = bbox_.min_.y_ < v_it->y_ ? bbox_.min_.y_ : v_it->y_;
-   bbox_.max_.y_ = bbox_.max_.y_ > v_it->y_ ? bbox_.max_.y_ : v_it->y_;
-   bbox_.min_.z_ = bbox_.min_.z_ < v_it->z_ ? bbox_.min_.z_ : v_it->z_;
-   bbox_.max_.z_ = bbox_.max_.z_ > v_it->z_ ? bbox_.max_.z_ : v_it->z_;
- }
- bbox_.center_ = (bbox_.min_ + bbox_.max_) * T(0.5);
- bbox_is_computed_ = true;
+ *  @fn void ComputeBoundingBox(Vertex* centroid)
+ *  @brief  Compute the bounding box of the mesh, and optionally the
+ *          centroid of its vertices, in a single parallel pass. The bounds
+ *          of every block are kept for later updates.
+ *  @param[out] centroid  If not null, mean of the vertices
+ */
+template<typename T>
+void Mesh<T>::ComputeBoundingBox(Vertex* centroid) {
+  static_assert(sizeof(Vertex) == 3 * sizeof(T), "Vertex must be packed");
+  const size_t n_vert = vertex_.size();
+  const size_t n_block = (n_vert + kMeshBlockSize - 1) / kMeshBlockSize;
+  block_bbox_.resize(n_block);
+  bbox_dirty_.assign(n_block, 0);
+  std::vector<VertexBounds<T>> bounds(n_block);
+  const T* data = reinterpret_cast<const T*>(vertex_.data());
+  ThreadPool::Get().ParallelFor(0,
+                                n_block,
+                                0,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t b = first; b < last; ++b) {
+      const size_t v_first = b * kMeshBlockSize;
+      const size_t n = std::min(kMeshBlockSize, n_vert - v_first);
+      VertexBounds<T>& r = bounds[b];
+      ReduceVertex(data + 3 * v_first, n, &r);
+      block_bbox_[b].min_ = Vertex(r.min[0], r.min[1], r.min[2]);
+      block_bbox_[b].max_ = Vertex(r.max[0], r.max[1], r.max[2]);
+    }
+  });
+  // Merge blocks in order, the result does not depend on the scheduling
+  VertexBounds<T> all;
+  double sum[3] = {0.0, 0.0, 0.0};
+  for (const auto& r : bounds) {
+    for (int k = 0; k < 3; ++k) {
+      all.min[k] = std::min(all.min[k], r.min[k]);
+      all.max[k] = std::max(all.max[k], r.max[k]);
+      sum[k] += static_cast<double>(r.sum[k]);
+    }
+  }
+  bbox_.min_ = Vertex(all.min[0], all.min[1], all.min[2]);
+  bbox_.max_ = Vertex(all.max[0], all.max[1], all.max[2]);
+  bbox_.center_ = (bbox_.min_ + bbox_.max_) * T(0.5);
+  bbox_is_computed_ = true;
+  if (centroid) {
+    const double scale = n_vert != 0 ? 1.0 / static_cast<double>(n_vert) : 0.0;
+    *centroid = Vertex(static_cast<T>(sum[0] * scale),
+                       static_cast<T>(sum[1] * scale),
+                       static_cast<T>(sum[2] * scale));
+  }
+}
+
+/*
+ *  @name MarkDirty
+ *  @fn void MarkDirty(const size_t& first, const size_t& last)
+ *  @brief  Flag vertices [first, last) as modified
+ *  @param[in] first  First modified vertex
+ *  @param[in] last   Past-the-end modified vertex
+ */
+template<typename T>
+void Mesh<T>::MarkDirty(const size_t& first, const size_t& last) {
+  const size_t n_block = (vertex_.size() + kMeshBlockSize - 1) / kMeshBlockSize;
+  const size_t end = std::min(last, vertex_.size());
+  if (first >= end) {
+    return;
+  }
+  // Blocks without a known state are treated as dirty
+  normal_dirty_.resize(n_block, 1);
+  bbox_dirty_.resize(n_block, 1);
+  buffer_dirty_.resize(n_block, 1);
+  const size_t b_last = (end - 1) / kMeshBlockSize;
+  for (size_t b = first / kMeshBlockSize; b <= b_last; ++b) {
+    normal_dirty_[b] = 1;
+    bbox_dirty_[b] = 1;
+    buffer_dirty_[b] = 1;
+  }
+}
+
+/*
+ *  @name UpdateNormals
+ *  @fn template<typename Math> void UpdateNormals(void)
+ *  @brief  Recompute the normal of vertices sharing a face with a dirty
+ *          vertex
+ *  @tparam Math  Math policy
+ */
+template<typename T>
+template<typename Math>
+void Mesh<T>::UpdateNormals(void) {
+  assert(topo_->vertex_tri_offset_.size() == vertex_.size() + 1);
+  const size_t n_vert = vertex_.size();
+  const size_t n_block = (n_vert + kMeshBlockSize - 1) / kMeshBlockSize;
+  if (normal_.size() != n_vert || normal_dirty_.size() != n_block) {
+    this->template ComputeVertexNormal<Math>();
+    return;
+  }
+  // Vertices sharing a face with a dirty one
+  std::vector<int> affected;
+  for (size_t b = 0; b < n_block; ++b) {
+    if (!normal_dirty_[b]) {
+      continue;
+    }
+    const size_t v_last = std::min((b + 1) * kMeshBlockSize, n_vert);
+    for (size_t v = b * kMeshBlockSize; v < v_last; ++v) {
+      for (size_t k = topo_->vertex_tri_offset_[v];
+           k < topo_->vertex_tri_offset_[v + 1];
+           ++k) {
+        const Triangle& tri = topo_->tri_[topo_->vertex_tri_[k]];
+        affected.push_back(tri.x_);
+        affected.push_back(tri.y_);
+        affected.push_back(tri.z_);
+      }
+    }
+    normal_dirty_[b] = 0;
+  }
+  std::sort(affected.begin(), affected.end());
+  affected.erase(std::unique(affected.begin(), affected.end()),
+                 affected.end());
+  // Normals can change outside of the dirty blocks
+  if (buffer_dirty_.size() == n_block) {
+    for (const int& v : affected) {
+      buffer_dirty_[v / kMeshBlockSize] = 1;
+    }
+  }
+  ThreadPool::Get().ParallelFor(0,
+                                affected.size(),
+                                0,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t k = first; k < last; ++k) {
+      const size_t v = static_cast<size_t>(affected[k]);
+      normal_[v] = this->template VertexNormal<Math>(v);
+    }
+  });
+}
+
+/*
+ *  @name UpdateBoundingBox
+ *  @fn void UpdateBoundingBox(void)
+ *  @brief  Update the bounding box, only blocks of vertices holding dirty
+ *          vertices are visited
+ */
+template<typename T>
+void Mesh<T>::UpdateBoundingBox(void) {
+  const size_t n_vert = vertex_.size();
+  const size_t n_block = (n_vert + kMeshBlockSize - 1) / kMeshBlockSize;
+  if (block_bbox_.size() != n_block || bbox_dirty_.size() != n_block) {
+    block_bbox_.resize(n_block);
+    bbox_dirty_.assign(n_block, 1);
+  }
+  std::vector<size_t> dirty;
+  for (size_t b = 0; b < n_block; ++b) {
+    if (bbox_dirty_[b]) {
+      dirty.push_back(b);
+      bbox_dirty_[b] = 0;
+    }
+  }
+  // Bounding box of dirty blocks
+  ThreadPool::Get().ParallelFor(0,
+                                dirty.size(),
+                                0,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t k = first; k < last; ++k) {
+      const size_t b = dirty[k];
+      const size_t v_first = b * kMeshBlockSize;
+      const size_t n = std::min(kMeshBlockSize, n_vert - v_first);
+      VertexBounds<T> r;
+      ReduceVertex(reinterpret_cast<const T*>(&vertex_[v_first]), n, &r);
+      block_bbox_[b].min_ = Vertex(r.min[0], r.min[1], r.min[2]);
+      block_bbox_[b].max_ = Vertex(r.max[0], r.max[1], r.max[2]);
+    }
+  });
+  // Merge blocks
+  bbox_.min_.x_ = std::numeric_limits<T>::max();
+  bbox_.max_.x_ = std::numeric_limits<T>::lowest();
+  bbox_.min_.y_ = std::numeric_limits<T>::max();
+  bbox_.max_.y_ = std::numeric_limits<T>::lowest();
+  bbox_.min_.z_ = std::numeric_limits<T>::max();
+  bbox_.max_.z_ = std::numeric_limits<T>::lowest();
+  for (const auto& box : block_bbox_) {
+    bbox_.min_.x_ = std::min(bbox_.min_.x_, box.min_.x_);
+    bbox_.min_.y_ = std::min(bbox_.min_.y_, box.min_.y_);
+    bbox_.min_.z_ = std::min(bbox_.min_.z_, box.min_.z_);
+    bbox_.max_.x_ = std::max(bbox_.max_.x_, box.max_.x_);
+    bbox_.max_.y_ = std::max(bbox_.max_.y_, box.max_.y_);
+    bbox_.max_.z_ = std::max(bbox_.max_.z_, box.max_.z_);
+  }
+  bbox_.center_ = (bbox_.min_ + bbox_.max_) * T(0.5);
+  bbox_is_computed_ = true;
+}
+
+/**
+ *  @name PackComponents
+ *  @fn static uint8_t* PackComponents(const T* src, const size_t& n,
+                                       const VertexBuffer::Format& format,
+                                       uint8_t* dst)
+ *  @brief  Store `n` components in a vertex buffer format
+ *  @param[in] src    Components
+ *  @param[in] n      Number of components
+ *  @param[in] format Storage format
+ *  @param[out] dst   Where to store the components
+ *  @return Past-the-end of the stored components
+ */
+template<typename T>
+static uint8_t* PackComponents(const T* src,
+                               const size_t& n,
+                               const VertexBuffer::Format& format,
+                               uint8_t* dst) {
+  for (size_t k = 0; k < n; ++k) {
+    const float v = static_cast<float>(src[k]);
+    if (format == VertexBuffer::kFloat16) {
+      const uint16_t h = FloatToHalfBits(v);
+      std::memcpy(dst, &h, sizeof(h));
+      dst += sizeof(h);
+    } else {
+      std::memcpy(dst, &v, sizeof(v));
+      dst += sizeof(v);
+    }
+  }
+  return dst;
+}
+
+/*
+ *  @name UpdateVertexBuffer
+ *  @fn const VertexBuffer& UpdateVertexBuffer(
+                    const VertexBuffer::Format& position_format,
+                    const VertexBuffer::Format& attribute_format)
+ *  @brief  Refresh the interleaved vertex buffer, only outdated blocks of
+ *          vertices are repacked
+ *  @param[in] position_format  Storage of the positions
+ *  @param[in] attribute_format Storage of normals, texture coordinates and
+ *                              colors
+ *  @return Interleaved buffer
+ */
+template<typename T>
+const VertexBuffer&
+Mesh<T>::UpdateVertexBuffer(const VertexBuffer::Format& position_format,
+                            const VertexBuffer::Format& attribute_format) {
+  using Attribute = VertexBuffer::Attribute;
+  const size_t n_vert = vertex_.size();
+  const size_t n_block = (n_vert + kMeshBlockSize - 1) / kMeshBlockSize;
+  const auto& tcoord = topo_->tex_coord_;
+  const bool has_normal = !normal_.empty() && normal_.size() == n_vert;
+  const bool has_tcoord = !tcoord.empty() && tcoord.size() == n_vert;
+  const bool has_color = (!vertex_color_.empty() &&
+                          vertex_color_.size() == n_vert);
+  // Layout, vertices padded to 16 bytes
+  std::vector<Attribute> layout;
+  uint32_t offset = 0;
+  auto add = [&](const VertexBuffer::Semantic& semantic,
+                 const uint32_t& size,
+                 const VertexBuffer::Format& format) {
+    layout.push_back(Attribute{semantic, offset, size, format});
+    offset += size * VertexBuffer::FormatSize(format);
+  };
+  add(VertexBuffer::kPosition, 3, position_format);
+  if (has_normal) {
+    add(VertexBuffer::kNormal, 3, attribute_format);
+  }
+  if (has_tcoord) {
+    add(VertexBuffer::kTexCoord, 2, attribute_format);
+  }
+  if (has_color) {
+    add(VertexBuffer::kColor, 4, attribute_format);
+  }
+  const uint32_t stride = (offset + 15) & ~uint32_t(15);
+  if (layout != vertex_buffer_.layout() ||
+      stride != vertex_buffer_.stride() ||
+      n_vert != vertex_buffer_.n_vertex() ||
+      buffer_dirty_.size() != n_block) {
+    vertex_buffer_.Reset(layout, stride, n_vert);
+    buffer_dirty_.assign(n_block, 1);
+  }
+  std::vector<size_t> dirty;
+  for (size_t b = 0; b < n_block; ++b) {
+    if (buffer_dirty_[b]) {
+      dirty.push_back(b);
+      buffer_dirty_[b] = 0;
+    }
+  }
+  const size_t n_pad = stride - offset;
+  const VertexBuffer::Format& f_attr = attribute_format;
+  ThreadPool::Get().ParallelFor(0,
+                                dirty.size(),
+                                0,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t k = first; k < last; ++k) {
+      const size_t v_first = dirty[k] * kMeshBlockSize;
+      const size_t v_last = std::min(v_first + kMeshBlockSize, n_vert);
+      for (size_t v = v_first; v < v_last; ++v) {
+        uint8_t* dst = vertex_buffer_.vertex_bytes(v);
+        const T p[3] = {vertex_[v].x_, vertex_[v].y_, vertex_[v].z_};
+        dst = PackComponents(p, 3, position_format, dst);
+        if (has_normal) {
+          const T n[3] = {normal_[v].x_, normal_[v].y_, normal_[v].z_};
+          dst = PackComponents(n, 3, f_attr, dst);
+        }
+        if (has_tcoord) {
+          const T t[2] = {tcoord[v].x_, tcoord[v].y_};
+          dst = PackComponents(t, 2, f_attr, dst);
+        }
+        if (has_color) {
+          const T c[4] = {vertex_color_[v].x_, vertex_color_[v].y_,
+                          vertex_color_[v].z_, vertex_color_[v].w_};
+          dst = PackComponents(c, 4, f_attr, dst);
+        }
+        std::memset(dst, 0, n_pad);
+      }
+    }
+  });
+  return vertex_buffer_;
 }
                  
 /*
@@ -621,22 +3285,34 @@ void Mesh<T>::ComputeBoundingBox(void) {
  */
 template<typename T>
 void Mesh<T>::PlaceToOrigin(void) {
-  // Get center of gravity
-  Vertex cog;
-  for (const auto& v : this->vertex_) {
-    cog += v;
+  if (vertex_.empty()) {
+    return;
   }
-  cog /= static_cast<T>(this->vertex_.size());
+  // Bounds and center of gravity in one pass
+  Vertex cog;
+  this->ComputeBoundingBox(&cog);
   // Center all vertex
-  for (auto& v : this->vertex_) {
-    v -= cog;
-  }
+  const T d[3] = {-cog.x_, -cog.y_, -cog.z_};
+  T* data = reinterpret_cast<T*>(vertex_.data());
+  const size_t n_vert = vertex_.size();
+  const size_t n_block = block_bbox_.size();
+  ThreadPool::Get().ParallelFor(0,
+                                n_block,
+                                0,
+                                [&](const size_t& first, const size_t& last) {
+    const size_t v_first = first * kMeshBlockSize;
+    const size_t v_last = std::min(last * kMeshBlockSize, n_vert);
+    TranslateVertex(d, v_last - v_first, data + 3 * v_first);
+  });
   // Update bbox as well
-  if (bbox_is_computed_) {
-    bbox_.min_ -= cog;
-    bbox_.max_ -= cog;
-    bbox_.center_ -= cog;
+  bbox_.min_ -= cog;
+  bbox_.max_ -= cog;
+  bbox_.center_ -= cog;
+  for (auto& box : block_bbox_) {
+    box.min_ -= cog;
+    box.max_ -= cog;
   }
+  buffer_dirty_.clear();
 }
 
 #pragma mark -
@@ -644,8 +3320,32 @@ void Mesh<T>::PlaceToOrigin(void) {
 
 /** Float Mesh */
 template class Mesh<float>;
+template void Mesh<float>::ComputeVertexNormal<PreciseMathPolicy>(void);
+template void Mesh<float>::ComputeVertexNormal<FastMathPolicy>(void);
+template void Mesh<float>::ComputeVertexNormalFromFaces<PreciseMathPolicy>(
+                                            const NormalWeighting& weighting);
+template void Mesh<float>::ComputeVertexNormalFromFaces<FastMathPolicy>(
+                                            const NormalWeighting& weighting);
+template void Mesh<float>::ComputeTangentSpace<PreciseMathPolicy>(
+                                            const NormalWeighting& weighting);
+template void Mesh<float>::ComputeTangentSpace<FastMathPolicy>(
+                                            const NormalWeighting& weighting);
+template void Mesh<float>::UpdateNormals<PreciseMathPolicy>(void);
+template void Mesh<float>::UpdateNormals<FastMathPolicy>(void);
 /** Double Mesh */
 template class Mesh<double>;
+template void Mesh<double>::ComputeVertexNormal<PreciseMathPolicy>(void);
+template void Mesh<double>::ComputeVertexNormal<FastMathPolicy>(void);
+template void Mesh<double>::ComputeVertexNormalFromFaces<PreciseMathPolicy>(
+                                            const NormalWeighting& weighting);
+template void Mesh<double>::ComputeVertexNormalFromFaces<FastMathPolicy>(
+                                            const NormalWeighting& weighting);
+template void Mesh<double>::ComputeTangentSpace<PreciseMathPolicy>(
+                                            const NormalWeighting& weighting);
+template void Mesh<double>::ComputeTangentSpace<FastMathPolicy>(
+                                            const NormalWeighting& weighting);
+template void Mesh<double>::UpdateNormals<PreciseMathPolicy>(void);
+template void Mesh<double>::UpdateNormals<FastMathPolicy>(void);
 
 
 }  // namespace FaceKit
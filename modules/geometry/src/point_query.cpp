@@ -0,0 +1,593 @@
+/**
+ *  @file   point_query.cpp
+ *  @brief  Proximity queries against a mesh: closest point on the surface,
+ *          nearest vertices and vertices within a radius
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   27.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/geometry/point_query.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Maximum number of vertices in a k-d tree leaf */
+static constexpr size_t kKdLeafSize = 8;
+/** K-d tree nodes with more vertices build their children in parallel */
+static constexpr size_t kKdParallelSize = 1 << 14;
+/** BVH traversal stack size, larger than the maximum depth */
+static constexpr size_t kQueryStackSize = 128;
+
+#pragma mark -
+#pragma mark Helpers
+
+/**
+ *  @name   BoxSqDistance
+ *  @fn     template<typename T> static T BoxSqDistance(const T* p,
+                                                        const T* min,
+                                                        const T* max)
+ *  @brief  Squared distance between a point and a box given by its corners,
+ *          same as `AABB<T>::SquaredDistanceToPoint` on flattened nodes
+ */
+template<typename T>
+static T BoxSqDistance(const T* p, const T* min, const T* max) {
+  T sq_dist = T(0.0);
+  for (int i = 0; i < 3; ++i) {
+    const T d = std::max(min[i] - p[i], T(0.0)) +
+                std::max(p[i] - max[i], T(0.0));
+    sq_dist += d * d;
+  }
+  return sq_dist;
+}
+
+/**
+ *  @name   ClosestOnTriangle
+ *  @fn     template<typename T> static void ClosestOnTriangle(
+                                              const Vector3<T>& p,
+                                              const Vector3<T>& a,
+                                              const Vector3<T>& ab,
+                                              const Vector3<T>& ac,
+                                              T* u, T* v)
+ *  @brief  Barycentric coordinates of the point of triangle (a, a + ab,
+ *          a + ac) closest to `p`, by Voronoi region
+ *  @see "Real-Time Collision Detection" book, section 5.1.5
+ */
+template<typename T>
+static void ClosestOnTriangle(const Vector3<T>& p,
+                              const Vector3<T>& a,
+                              const Vector3<T>& ab,
+                              const Vector3<T>& ac,
+                              T* u,
+                              T* v) {
+  auto ratio = [](const T& num, const T& den) {
+    return den > T(0.0) ? num / den : T(0.0);
+  };
+  // Vertex A
+  const Vector3<T> ap = p - a;
+  const T d1 = ab * ap;
+  const T d2 = ac * ap;
+  if (d1 <= T(0.0) && d2 <= T(0.0)) {
+    *u = T(0.0);
+    *v = T(0.0);
+    return;
+  }
+  // Vertex B
+  const Vector3<T> bp = ap - ab;
+  const T d3 = ab * bp;
+  const T d4 = ac * bp;
+  if (d3 >= T(0.0) && d4 <= d3) {
+    *u = T(1.0);
+    *v = T(0.0);
+    return;
+  }
+  // Edge AB
+  const T vc = d1 * d4 - d3 * d2;
+  if (vc <= T(0.0) && d1 >= T(0.0) && d3 <= T(0.0)) {
+    *u = ratio(d1, d1 - d3);
+    *v = T(0.0);
+    return;
+  }
+  // Vertex C
+  const Vector3<T> cp = ap - ac;
+  const T d5 = ab * cp;
+  const T d6 = ac * cp;
+  if (d6 >= T(0.0) && d5 <= d6) {
+    *u = T(0.0);
+    *v = T(1.0);
+    return;
+  }
+  // Edge AC
+  const T vb = d5 * d2 - d1 * d6;
+  if (vb <= T(0.0) && d2 >= T(0.0) && d6 <= T(0.0)) {
+    *u = T(0.0);
+    *v = ratio(d2, d2 - d6);
+    return;
+  }
+  // Edge BC
+  const T va = d3 * d6 - d5 * d4;
+  if (va <= T(0.0) && (d4 - d3) >= T(0.0) && (d5 - d6) >= T(0.0)) {
+    const T w = ratio(d4 - d3, (d4 - d3) + (d5 - d6));
+    *u = T(1.0) - w;
+    *v = w;
+    return;
+  }
+  // Inside
+  const T den = va + vb + vc;
+  *u = ratio(vb, den);
+  *v = ratio(vc, den);
+}
+
+/**
+ *  @struct KNearestVisitor
+ *  @brief  Keep the `k` closest vertices in a max-heap
+ */
+template<typename T>
+struct KNearestVisitor {
+  /** Neighbours, (squared distance, index), farthest on top */
+  std::vector<std::pair<T, int>> heap;
+  /** Number of neighbours */
+  size_t k;
+
+  /** Current search radius */
+  T radius2(void) const {
+    return heap.size() < k ? std::numeric_limits<T>::max() : heap.front().first;
+  }
+
+  /** Candidate vertex */
+  void Add(const int& index, const T& sq_dist) {
+    if (heap.size() < k) {
+      heap.emplace_back(sq_dist, index);
+      std::push_heap(heap.begin(), heap.end());
+    } else if (sq_dist < heap.front().first) {
+      std::pop_heap(heap.begin(), heap.end());
+      heap.back() = std::make_pair(sq_dist, index);
+      std::push_heap(heap.begin(), heap.end());
+    }
+  }
+};
+
+/**
+ *  @struct RadiusVisitor
+ *  @brief  Collect every vertex within a fixed radius
+ */
+template<typename T>
+struct RadiusVisitor {
+  /** Neighbours, (squared distance, index) */
+  std::vector<std::pair<T, int>> found;
+  /** Squared radius */
+  T r2;
+
+  /** Current search radius */
+  T radius2(void) const {
+    return r2;
+  }
+
+  /** Candidate vertex */
+  void Add(const int& index, const T& sq_dist) {
+    if (sq_dist <= r2) {
+      found.emplace_back(sq_dist, index);
+    }
+  }
+};
+
+/**
+ *  @name   Unpack
+ *  @fn     template<typename T> static void Unpack(
+                                  std::vector<std::pair<T, int>>* pairs,
+                                  int* index, T* sq_dist)
+ *  @brief  Sort neighbours by distance and split them into two arrays
+ */
+template<typename T>
+static void Unpack(std::vector<std::pair<T, int>>* pairs,
+                   int* index,
+                   T* sq_dist) {
+  std::sort(pairs->begin(), pairs->end());
+  for (size_t k = 0; k < pairs->size(); ++k) {
+    sq_dist[k] = (*pairs)[k].first;
+    index[k] = (*pairs)[k].second;
+  }
+}
+
+/**
+ *  @name   BuildKdTree
+ *  @fn     template<typename T> static void BuildKdTree(
+                                          std::vector<Vector3<T>>* vertex,
+                                          std::vector<int>* index,
+                                          std::vector<uint8_t>* axis,
+                                          const size_t& first,
+                                          const size_t& last)
+ *  @brief  Arrange vertices [first, last) as an implicit balanced k-d tree:
+ *          the median along the widest axis splits the range and the two
+ *          halves are arranged recursively
+ */
+template<typename T>
+static void BuildKdTree(std::vector<Vector3<T>>* vertex,
+                        std::vector<int>* index,
+                        std::vector<uint8_t>* axis,
+                        const size_t& first,
+                        const size_t& last) {
+  const size_t n = last - first;
+  if (n <= kKdLeafSize) {
+    return;
+  }
+  // Widest axis
+  Vector3<T> lo = (*vertex)[first];
+  Vector3<T> hi = lo;
+  for (size_t k = first + 1; k < last; ++k) {
+    const Vector3<T>& p = (*vertex)[k];
+    lo.x_ = std::min(lo.x_, p.x_);
+    lo.y_ = std::min(lo.y_, p.y_);
+    lo.z_ = std::min(lo.z_, p.z_);
+    hi.x_ = std::max(hi.x_, p.x_);
+    hi.y_ = std::max(hi.y_, p.y_);
+    hi.z_ = std::max(hi.z_, p.z_);
+  }
+  const Vector3<T> ext = hi - lo;
+  int a = 0;
+  if (ext.y_ > ext.x_) {
+    a = 1;
+  }
+  if (ext.z_ > (&ext.x_)[a]) {
+    a = 2;
+  }
+  // Split on the median, vertices and their indices are permuted together
+  const size_t mid = first + n / 2;
+  std::vector<size_t> order(n);
+  for (size_t k = 0; k < n; ++k) {
+    order[k] = first + k;
+  }
+  const Vector3<T>* v = vertex->data();
+  std::nth_element(order.begin(),
+                   order.begin() + (mid - first),
+                   order.end(),
+                   [&](const size_t& i, const size_t& j) {
+    return (&v[i].x_)[a] < (&v[j].x_)[a];
+  });
+  std::vector<Vector3<T>> tmp_v(n);
+  std::vector<int> tmp_i(n);
+  for (size_t k = 0; k < n; ++k) {
+    tmp_v[k] = v[order[k]];
+    tmp_i[k] = (*index)[order[k]];
+  }
+  std::copy(tmp_v.begin(), tmp_v.end(), vertex->begin() + first);
+  std::copy(tmp_i.begin(), tmp_i.end(), index->begin() + first);
+  (*axis)[mid] = static_cast<uint8_t>(a);
+  // Children, disjoint ranges
+  if (n >= kKdParallelSize) {
+    ThreadPool::Get().ParallelFor(0,
+                                  2,
+                                  1,
+                                  [&](const size_t& b, const size_t& e) {
+      for (size_t c = b; c < e; ++c) {
+        if (c == 0) {
+          BuildKdTree(vertex, index, axis, first, mid);
+        } else {
+          BuildKdTree(vertex, index, axis, mid + 1, last);
+        }
+      }
+    });
+  } else {
+    BuildKdTree(vertex, index, axis, first, mid);
+    BuildKdTree(vertex, index, axis, mid + 1, last);
+  }
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name Build
+ *  @fn int Build(const Mesh<T>& mesh)
+ *  @brief  Index the triangles and vertices of a mesh, they are copied
+ *  @param[in] mesh Mesh to index
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int PointQuery<T>::Build(const Mesh<T>& mesh) {
+  vertex_.clear();
+  vertex_index_.clear();
+  axis_.clear();
+  if (bvh_.Build(mesh)) {
+    return -1;
+  }
+  vertex_ = mesh.get_vertex();
+  vertex_index_.resize(vertex_.size());
+  for (size_t k = 0; k < vertex_.size(); ++k) {
+    vertex_index_[k] = static_cast<int>(k);
+  }
+  axis_.assign(vertex_.size(), 0);
+  BuildKdTree(&vertex_, &vertex_index_, &axis_, 0, vertex_.size());
+  return 0;
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name ClosestPoint
+ *  @fn bool ClosestPoint(const Vector3<T>& p, Closest* res,
+                          const T& max_dist) const
+ *  @brief  Find the closest point on the surface
+ *  @param[in] p        Query point
+ *  @param[out] res     Closest point
+ *  @param[in] max_dist Search radius, the search stops early beyond it
+ *  @return True if a point is found within `max_dist`
+ */
+template<typename T>
+bool PointQuery<T>::ClosestPoint(const Vector3<T>& p,
+                                 Closest* res,
+                                 const T& max_dist) const {
+  using Node = typename BVH<T>::Node;
+  *res = Closest();
+  const auto& nodes = bvh_.nodes_;
+  if (nodes.empty()) {
+    return false;
+  }
+  // Squaring the default radius would overflow
+  T best = max_dist < std::sqrt(std::numeric_limits<T>::max()) ?
+           max_dist * max_dist :
+           std::numeric_limits<T>::max();
+  const T* q = &p.x_;
+  // Nodes are pushed with their distance so stale entries are skipped once
+  // a closer point is found
+  std::pair<int32_t, T> stack[kQueryStackSize];
+  size_t sp = 0;
+  const T d_root = BoxSqDistance(q, nodes[0].min, nodes[0].max);
+  if (d_root > best) {
+    return false;
+  }
+  stack[sp++] = std::make_pair(0, d_root);
+  while (sp > 0) {
+    const auto entry = stack[--sp];
+    if (entry.second > best) {
+      continue;
+    }
+    const Node& node = nodes[entry.first];
+    if (node.count > 0) {
+      for (int32_t k = node.offset; k < node.offset + node.count; ++k) {
+        const auto& tri = bvh_.tri_[k];
+        T u, v;
+        ClosestOnTriangle(p, tri.v0, tri.e1, tri.e2, &u, &v);
+        const Vector3<T> c = tri.v0 + tri.e1 * u + tri.e2 * v;
+        const Vector3<T> d = c - p;
+        const T dist = d * d;
+        if (dist <= best) {
+          best = dist;
+          res->tri = bvh_.tri_index_[k];
+          res->u = u;
+          res->v = v;
+          res->point = c;
+          res->sq_dist = dist;
+        }
+      }
+    } else {
+      // Nearest child last so it is visited first
+      const int32_t first = entry.first + 1;
+      const int32_t second = node.offset;
+      const T d_first = BoxSqDistance(q, nodes[first].min, nodes[first].max);
+      const T d_second = BoxSqDistance(q,
+                                       nodes[second].min,
+                                       nodes[second].max);
+      const bool first_near = d_first <= d_second;
+      const int32_t near = first_near ? first : second;
+      const int32_t far = first_near ? second : first;
+      const T d_near = first_near ? d_first : d_second;
+      const T d_far = first_near ? d_second : d_first;
+      if (d_far <= best) {
+        stack[sp++] = std::make_pair(far, d_far);
+      }
+      if (d_near <= best) {
+        stack[sp++] = std::make_pair(near, d_near);
+      }
+    }
+  }
+  return res->tri >= 0;
+}
+
+/*
+ *  @name ClosestPoint
+ *  @fn void ClosestPoint(const std::vector<Vector3<T>>& pts,
+                          std::vector<Closest>* res,
+                          const T& max_dist) const
+ *  @brief  Find the closest point on the surface of a batch of points, in
+ *          parallel
+ *  @param[in] pts      Query points
+ *  @param[out] res     Closest point of each query
+ *  @param[in] max_dist Search radius
+ */
+template<typename T>
+void PointQuery<T>::ClosestPoint(const std::vector<Vector3<T>>& pts,
+                                 std::vector<Closest>* res,
+                                 const T& max_dist) const {
+  res->resize(pts.size());
+  ThreadPool::Get().ParallelFor(0,
+                                pts.size(),
+                                0,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t k = first; k < last; ++k) {
+      this->ClosestPoint(pts[k], &(*res)[k], max_dist);
+    }
+  });
+}
+
+/*
+ *  @name Search
+ *  @fn template<typename Visitor> void Search(const Vector3<T>& p,
+                                               const size_t& first,
+                                               const size_t& last,
+                                               Visitor* visitor) const
+ *  @brief  Visit the vertices of the k-d tree node [first, last) near side
+ *          first, subtrees farther than the visitor's radius are skipped
+ */
+template<typename T>
+template<typename Visitor>
+void PointQuery<T>::Search(const Vector3<T>& p,
+                           const size_t& first,
+                           const size_t& last,
+                           Visitor* visitor) const {
+  const size_t n = last - first;
+  if (n <= kKdLeafSize) {
+    for (size_t k = first; k < last; ++k) {
+      const Vector3<T> d = vertex_[k] - p;
+      visitor->Add(vertex_index_[k], d * d);
+    }
+    return;
+  }
+  const size_t mid = first + n / 2;
+  const int a = axis_[mid];
+  const Vector3<T> d = vertex_[mid] - p;
+  visitor->Add(vertex_index_[mid], d * d);
+  // Left holds coordinates below or equal to the median, right above or
+  // equal
+  const T delta = (&p.x_)[a] - (&vertex_[mid].x_)[a];
+  if (delta < T(0.0)) {
+    this->Search(p, first, mid, visitor);
+    if (delta * delta <= visitor->radius2()) {
+      this->Search(p, mid + 1, last, visitor);
+    }
+  } else {
+    this->Search(p, mid + 1, last, visitor);
+    if (delta * delta <= visitor->radius2()) {
+      this->Search(p, first, mid, visitor);
+    }
+  }
+}
+
+/*
+ *  @name KNearestVertex
+ *  @fn void KNearestVertex(const Vector3<T>& p, const size_t& k,
+                            std::vector<int>* index,
+                            std::vector<T>* sq_dist) const
+ *  @brief  Find the `k` vertices closest to a point
+ *  @param[in] p        Query point
+ *  @param[in] k        Number of neighbours
+ *  @param[out] index   Vertex indices sorted by increasing distance
+ *  @param[out] sq_dist Squared distances
+ */
+template<typename T>
+void PointQuery<T>::KNearestVertex(const Vector3<T>& p,
+                                   const size_t& k,
+                                   std::vector<int>* index,
+                                   std::vector<T>* sq_dist) const {
+  KNearestVisitor<T> visitor;
+  visitor.k = k;
+  if (k > 0) {
+    visitor.heap.reserve(k);
+    this->Search(p, 0, vertex_.size(), &visitor);
+  }
+  index->resize(visitor.heap.size());
+  sq_dist->resize(visitor.heap.size());
+  Unpack(&visitor.heap, index->data(), sq_dist->data());
+}
+
+/*
+ *  @name KNearestVertex
+ *  @fn void KNearestVertex(const std::vector<Vector3<T>>& pts,
+                            const size_t& k, std::vector<int>* index,
+                            std::vector<T>* sq_dist) const
+ *  @brief  Find the `k` vertices closest to a batch of points, in parallel
+ *  @param[in] pts      Query points
+ *  @param[in] k        Number of neighbours
+ *  @param[out] index   Row-major `pts.size()` x `k` vertex indices
+ *  @param[out] sq_dist Squared distances, same layout
+ */
+template<typename T>
+void PointQuery<T>::KNearestVertex(const std::vector<Vector3<T>>& pts,
+                                   const size_t& k,
+                                   std::vector<int>* index,
+                                   std::vector<T>* sq_dist) const {
+  index->assign(pts.size() * k, -1);
+  sq_dist->assign(pts.size() * k, std::numeric_limits<T>::max());
+  if (k == 0) {
+    return;
+  }
+  ThreadPool::Get().ParallelFor(0,
+                                pts.size(),
+                                0,
+                                [&](const size_t& first, const size_t& last) {
+    KNearestVisitor<T> visitor;
+    visitor.k = k;
+    visitor.heap.reserve(k);
+    for (size_t i = first; i < last; ++i) {
+      visitor.heap.clear();
+      this->Search(pts[i], 0, vertex_.size(), &visitor);
+      Unpack(&visitor.heap, &(*index)[i * k], &(*sq_dist)[i * k]);
+    }
+  });
+}
+
+/*
+ *  @name RadiusVertex
+ *  @fn void RadiusVertex(const Vector3<T>& p, const T& radius,
+                          std::vector<int>* index,
+                          std::vector<T>* sq_dist) const
+ *  @brief  Find the vertices within a given distance of a point
+ *  @param[in] p        Query point
+ *  @param[in] radius   Search radius
+ *  @param[out] index   Vertex indices sorted by increasing distance
+ *  @param[out] sq_dist Squared distances
+ */
+template<typename T>
+void PointQuery<T>::RadiusVertex(const Vector3<T>& p,
+                                 const T& radius,
+                                 std::vector<int>* index,
+                                 std::vector<T>* sq_dist) const {
+  RadiusVisitor<T> visitor;
+  visitor.r2 = radius * radius;
+  this->Search(p, 0, vertex_.size(), &visitor);
+  index->resize(visitor.found.size());
+  sq_dist->resize(visitor.found.size());
+  Unpack(&visitor.found, index->data(), sq_dist->data());
+}
+
+/*
+ *  @name RadiusVertex
+ *  @fn void RadiusVertex(const std::vector<Vector3<T>>& pts,
+                          const T& radius,
+                          std::vector<std::vector<int>>* index,
+                          std::vector<std::vector<T>>* sq_dist) const
+ *  @brief  Find the vertices within a given distance of a batch of points,
+ *          in parallel
+ *  @param[in] pts      Query points
+ *  @param[in] radius   Search radius
+ *  @param[out] index   Vertex indices of each query
+ *  @param[out] sq_dist Squared distances of each query
+ */
+template<typename T>
+void PointQuery<T>::RadiusVertex(const std::vector<Vector3<T>>& pts,
+                                 const T& radius,
+                                 std::vector<std::vector<int>>* index,
+                                 std::vector<std::vector<T>>* sq_dist) const {
+  index->resize(pts.size());
+  sq_dist->resize(pts.size());
+  ThreadPool::Get().ParallelFor(0,
+                                pts.size(),
+                                0,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t i = first; i < last; ++i) {
+      this->RadiusVertex(pts[i], radius, &(*index)[i], &(*sq_dist)[i]);
+    }
+  });
+}
+
+#pragma mark -
+#pragma mark Declaration
+
+/** Float point query */
+template class PointQuery<float>;
+/** Double point query */
+template class PointQuery<double>;
+
+}  // namespace FaceKit
@@ -0,0 +1,154 @@
+/**
+ *  @file   vertex_buffer.cpp
+ *  @brief  Interleaved single or half precision vertex buffer, ready to be
+ *          uploaded to the GPU
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   31.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cstring>
+#include <utility>
+
+#include "facekit/core/mem/memory.hpp"
+#include "facekit/geometry/vertex_buffer.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+constexpr size_t VertexBuffer::kAlignment;
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name VertexBuffer
+ *  @fn VertexBuffer(const VertexBuffer& other)
+ *  @brief  Copy constructor
+ *  @param[in] other  Buffer to copy from
+ */
+VertexBuffer::VertexBuffer(const VertexBuffer& other) {
+  *this = other;
+}
+
+/*
+ *  @name VertexBuffer
+ *  @fn VertexBuffer(VertexBuffer&& other)
+ *  @brief  Move constructor, `other` is left empty
+ *  @param[in] other  Buffer to move from
+ */
+VertexBuffer::VertexBuffer(VertexBuffer&& other) {
+  *this = std::move(other);
+}
+
+/*
+ *  @name operator=
+ *  @fn VertexBuffer& operator=(const VertexBuffer& rhs)
+ *  @brief  Assignment operator
+ *  @param[in] rhs  Buffer to assign from
+ */
+VertexBuffer& VertexBuffer::operator=(const VertexBuffer& rhs) {
+  if (this != &rhs) {
+    this->Reset(rhs.layout_, rhs.stride_, rhs.n_vertex_);
+    if (rhs.data_) {
+      std::memcpy(data_, rhs.data_, rhs.size());
+    }
+  }
+  return *this;
+}
+
+/*
+ *  @name operator=
+ *  @fn VertexBuffer& operator=(VertexBuffer&& rhs)
+ *  @brief  Move assignment operator, `rhs` is left empty
+ *  @param[in] rhs  Buffer to move from
+ */
+VertexBuffer& VertexBuffer::operator=(VertexBuffer&& rhs) {
+  if (this != &rhs) {
+    this->Clear();
+    layout_ = std::move(rhs.layout_);
+    std::swap(data_, rhs.data_);
+    std::swap(capacity_, rhs.capacity_);
+    std::swap(n_vertex_, rhs.n_vertex_);
+    std::swap(stride_, rhs.stride_);
+    rhs.layout_.clear();
+  }
+  return *this;
+}
+
+/*
+ *  @name ~VertexBuffer
+ *  @fn ~VertexBuffer(void)
+ *  @brief  Destructor
+ */
+VertexBuffer::~VertexBuffer(void) {
+  this->Clear();
+}
+
+/*
+ *  @name Reset
+ *  @fn void Reset(const std::vector<Attribute>& layout,
+                   const uint32_t& stride, const size_t& n_vertex)
+ *  @brief  Set the layout and allocate the storage, content is undefined.
+ *          Memory is reused when large enough.
+ *  @param[in] layout   Attributes
+ *  @param[in] stride   Size of a vertex in bytes, multiple of 16
+ *  @param[in] n_vertex Number of vertices
+ */
+void VertexBuffer::Reset(const std::vector<Attribute>& layout,
+                         const uint32_t& stride,
+                         const size_t& n_vertex) {
+  const size_t n_byte = n_vertex * stride;
+  if (n_byte > capacity_) {
+    Mem::FreeAligned(data_);
+    data_ = reinterpret_cast<uint8_t*>(Mem::MallocAligned(n_byte,
+                                                          kAlignment));
+    capacity_ = n_byte;
+  }
+  layout_ = layout;
+  stride_ = stride;
+  n_vertex_ = n_vertex;
+}
+
+/*
+ *  @name Clear
+ *  @fn void Clear(void)
+ *  @brief  Release the storage and clear the layout
+ */
+void VertexBuffer::Clear(void) {
+  if (data_) {
+    Mem::FreeAligned(data_);
+  }
+  data_ = nullptr;
+  capacity_ = 0;
+  n_vertex_ = 0;
+  stride_ = 0;
+  layout_.clear();
+}
+
+#pragma mark -
+#pragma mark Accessors
+
+/*
+ *  @name Find
+ *  @fn const Attribute* Find(const Semantic& semantic) const
+ *  @brief  Look for an attribute in the layout
+ *  @param[in] semantic Attribute's meaning
+ *  @return Attribute or nullptr if not part of the layout
+ */
+const VertexBuffer::Attribute*
+VertexBuffer::Find(const Semantic& semantic) const {
+  for (const auto& attr : layout_) {
+    if (attr.semantic == semantic) {
+      return &attr;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace FaceKit
@@ -0,0 +1,246 @@
+/**
+ *  @file   visibility.cpp
+ *  @brief  Vertex visibility and silhouette extraction of a mesh seen from a
+ *          viewpoint (i.e. occluded and contour landmarks)
+ *  @ingroup geometry
+ *
+ *  @author Christophe Ecabert
+ *  @date   06.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/geometry/visibility.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Number of triangles processed by one parallel task */
+static constexpr size_t kFaceGrain = 4096;
+
+#pragma mark -
+#pragma mark Helpers
+
+/**
+ *  @name   EdgeKey
+ *  @fn     static uint64_t EdgeKey(const int& a, const int& b)
+ *  @brief  Key of an undirected edge, smallest vertex first
+ */
+static uint64_t EdgeKey(const int& a, const int& b) {
+  const uint64_t lo = static_cast<uint32_t>(std::min(a, b));
+  const uint64_t hi = static_cast<uint32_t>(std::max(a, b));
+  return (lo << 32) | hi;
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name Build
+ *  @fn int Build(const Mesh<T>& mesh)
+ *  @brief  Index a mesh, to be called when its shape changes. The edge
+ *          adjacency is only rebuilt if the triangles changed.
+ *  @param[in] mesh Mesh to index, vertices and triangles are copied
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int Visibility<T>::Build(const Mesh<T>& mesh) {
+  silhouette_valid_ = false;
+  if (bvh_.Build(mesh) != 0) {
+    std::cout << "Error, can not index the mesh" << std::endl;
+    return -1;
+  }
+  const auto& tri = mesh.get_triangle();
+  vertex_ = mesh.get_vertex();
+  // Topology is usually shared by every instance of a model, adjacency is
+  // rebuilt only when it differs
+  const bool same = tri.size() == tri_.size() &&
+          std::equal(tri.begin(), tri.end(), tri_.begin(),
+                     [](const Vector3<int>& a, const Vector3<int>& b) {
+                       return a.x_ == b.x_ && a.y_ == b.y_ && a.z_ == b.z_;
+                     });
+  if (!same) {
+    tri_ = tri;
+    this->BuildAdjacency(tri_);
+  }
+  // Face normals
+  normal_.resize(tri_.size());
+  ThreadPool::Get().ParallelFor(0,
+                                tri_.size(),
+                                kFaceGrain,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t f = first; f < last; ++f) {
+      const auto& a = vertex_[tri_[f].x_];
+      const auto& b = vertex_[tri_[f].y_];
+      const auto& c = vertex_[tri_[f].z_];
+      normal_[f] = (b - a) ^ (c - a);
+    }
+  });
+  // Extent
+  Vector3<T> lo = vertex_[0];
+  Vector3<T> hi = vertex_[0];
+  for (const auto& v : vertex_) {
+    lo.x_ = std::min(lo.x_, v.x_);
+    lo.y_ = std::min(lo.y_, v.y_);
+    lo.z_ = std::min(lo.z_, v.z_);
+    hi.x_ = std::max(hi.x_, v.x_);
+    hi.y_ = std::max(hi.y_, v.y_);
+    hi.z_ = std::max(hi.z_, v.z_);
+  }
+  extent_ = (hi - lo).Norm();
+  return 0;
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name Visible
+ *  @fn void Visible(const View& view, const std::vector<int>& vertex,
+                     std::vector<uint8_t>* visible) const
+ *  @brief  Check which vertices are seen from `view`
+ *  @param[in] view     Viewpoint
+ *  @param[in] vertex   Vertex indices (i.e. landmarks)
+ *  @param[out] visible 1 if visible, 0 if occluded or invalid, for each
+ *                      vertex
+ */
+template<typename T>
+void Visibility<T>::Visible(const View& view,
+                            const std::vector<int>& vertex,
+                            std::vector<uint8_t>* visible) const {
+  using Ray = typename BVH<T>::Ray;
+  using Hit = typename BVH<T>::Hit;
+  visible->assign(vertex.size(), 0);
+  const int n_vertex = static_cast<int>(vertex_.size());
+  // Parallel rays start outside of the mesh
+  Vector3<T> offset = view.eye;
+  if (view.parallel) {
+    offset.Normalize();
+    offset *= T(2.0) * extent_;
+  }
+  // Rays from the camera toward each vertex, stopped right before it
+  std::vector<Ray> rays;
+  std::vector<size_t> index;
+  rays.reserve(vertex.size());
+  index.reserve(vertex.size());
+  for (size_t i = 0; i < vertex.size(); ++i) {
+    const int v = vertex[i];
+    if (v < 0 || v >= n_vertex) {
+      continue;
+    }
+    Ray r;
+    r.org = view.parallel ? vertex_[v] + offset : view.eye;
+    r.dir = vertex_[v] - r.org;
+    r.t_max = T(1.0) - options_.eps;
+    rays.push_back(r);
+    index.push_back(i);
+  }
+  std::vector<Hit> hits;
+  bvh_.Intersect(rays, &hits);
+  for (size_t k = 0; k < hits.size(); ++k) {
+    (*visible)[index[k]] = hits[k].tri < 0 ? 1 : 0;
+  }
+}
+
+/*
+ *  @name Silhouette
+ *  @fn const std::vector<int>& Silhouette(const View& view)
+ *  @brief  Vertices lying on the silhouette seen from `view`
+ *  @param[in] view Viewpoint
+ *  @return Silhouette vertices, sorted
+ */
+template<typename T>
+const std::vector<int>& Visibility<T>::Silhouette(const View& view) {
+  if (silhouette_valid_ && view.parallel == silhouette_view_.parallel &&
+      view.eye.x_ == silhouette_view_.eye.x_ &&
+      view.eye.y_ == silhouette_view_.eye.y_ &&
+      view.eye.z_ == silhouette_view_.eye.z_) {
+    return silhouette_;
+  }
+  // Facing of each triangle
+  std::vector<uint8_t> front(tri_.size());
+  ThreadPool::Get().ParallelFor(0,
+                                tri_.size(),
+                                kFaceGrain,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t f = first; f < last; ++f) {
+      const Vector3<T> to_eye = view.parallel ?
+                                view.eye :
+                                view.eye - vertex_[tri_[f].x_];
+      front[f] = (normal_[f] * to_eye) > T(0.0) ? 1 : 0;
+    }
+  });
+  // Edges between front and back facing triangles, or front facing borders
+  std::vector<uint8_t> mark(vertex_.size(), 0);
+  for (const auto& e : edge_) {
+    const bool sil = e.f1 < 0 ? front[e.f0] != 0 : front[e.f0] != front[e.f1];
+    if (sil) {
+      mark[e.v0] = 1;
+      mark[e.v1] = 1;
+    }
+  }
+  silhouette_.clear();
+  for (size_t v = 0; v < mark.size(); ++v) {
+    if (mark[v]) {
+      silhouette_.push_back(static_cast<int>(v));
+    }
+  }
+  silhouette_view_ = view;
+  silhouette_valid_ = true;
+  return silhouette_;
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ *  @name BuildAdjacency
+ *  @fn void BuildAdjacency(const std::vector<Vector3<int>>& tri)
+ *  @brief  Pair the triangles sharing an edge. Non-manifold edges keep
+ *          their first two triangles.
+ */
+template<typename T>
+void Visibility<T>::BuildAdjacency(const std::vector<Vector3<int>>& tri) {
+  // Sort the half edges by key, consecutive entries share the edge
+  std::vector<std::pair<uint64_t, int>> half(3 * tri.size());
+  for (size_t f = 0; f < tri.size(); ++f) {
+    const int* idx = &tri[f].x_;
+    for (int k = 0; k < 3; ++k) {
+      half[3 * f + k] = {EdgeKey(idx[k], idx[(k + 1) % 3]),
+                         static_cast<int>(f)};
+    }
+  }
+  std::sort(half.begin(), half.end());
+  edge_.clear();
+  for (size_t i = 0; i < half.size();) {
+    size_t j = i + 1;
+    while (j < half.size() && half[j].first == half[i].first) {
+      ++j;
+    }
+    Edge e;
+    e.v0 = static_cast<int>(half[i].first >> 32);
+    e.v1 = static_cast<int>(half[i].first & 0xFFFFFFFF);
+    e.f0 = half[i].second;
+    e.f1 = j - i > 1 ? half[i + 1].second : -1;
+    edge_.push_back(e);
+    i = j;
+  }
+}
+
+#pragma mark -
+#pragma mark Explicit instantiation
+
+/** Float */
+template class Visibility<float>;
+/** Double */
+template class Visibility<double>;
+
+}  // namespace FaceKit
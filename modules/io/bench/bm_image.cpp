@@ -0,0 +1,126 @@
+/**
+ *  @file   bm_image.cpp
+ *  @brief Microbenchmark for image codecs
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   07.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#include "benchmark/benchmark.h"
+
+#include "facekit/io/bitmap_image.hpp"
+#include "facekit/io/jpeg_image.hpp"
+#include "facekit/io/png_image.hpp"
+#include "facekit/io/tga_image.hpp"
+
+namespace FK = FaceKit;
+
+/** Seed used to generate fixture data, keep runs comparable */
+static constexpr unsigned kSeed = 0x5EED;
+
+/**
+ *  @class  SyntheticImage
+ *  @brief  Codec `I` filled with a reproducible pattern: smooth gradient plus
+ *          low amplitude noise, close to natural image statistics.
+ *  @tparam I Image codec
+ */
+template<typename I>
+class SyntheticImage : public I {
+ public:
+  /** Initialize a `width` x `height` RGB image */
+  SyntheticImage(const size_t& width, const size_t& height) {
+    this->width_ = width;
+    this->height_ = height;
+    this->format_ = FK::Image::Format::kRGB;
+    this->buffer_.Resize(FK::DataType::kUInt8, {height, width, 3});
+    std::mt19937 gen(kSeed);
+    std::uniform_int_distribution<int> noise(-8, 8);
+    uint8_t* ptr = this->data();
+    for (size_t r = 0; r < height; ++r) {
+      for (size_t c = 0; c < width; ++c) {
+        const int base[3] = {int((255 * c) / width),
+                             int((255 * r) / height),
+                             int((255 * (r + c)) / (width + height))};
+        for (int k = 0; k < 3; ++k) {
+          const int v = base[k] + noise(gen);
+          *ptr++ = static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+        }
+      }
+    }
+  }
+};
+
+/** Encode a synthetic image with codec `I` */
+template<typename I>
+static std::string EncodeFixture(const size_t& width, const size_t& height) {
+  SyntheticImage<I> image(width, height);
+  std::stringstream stream;
+  image.Save(stream);
+  return stream.str();
+}
+
+/** Build an uncompressed true-color TGA stream, BGR pixel order */
+static std::string TGAFixture(const size_t& width, const size_t& height) {
+  std::string hdr(18, '\0');
+  hdr[2] = 2;   // Uncompressed true-color
+  hdr[12] = static_cast<char>(width & 0xFF);
+  hdr[13] = static_cast<char>((width >> 8) & 0xFF);
+  hdr[14] = static_cast<char>(height & 0xFF);
+  hdr[15] = static_cast<char>((height >> 8) & 0xFF);
+  hdr[16] = 24;
+  SyntheticImage<FK::PNGImage> image(width, height);
+  const char* px = reinterpret_cast<const char*>(image.data());
+  return hdr + std::string(px, px + (width * height * 3));
+}
+
+/** Decode an in-memory stream with codec `I` */
+template<typename I>
+static void BM_ImageDecode(benchmark::State& state) {
+  const size_t n = static_cast<size_t>(state.range(0));
+  const std::string data = std::is_same<I, FK::TGAImage>::value ?
+                           TGAFixture(n, n) :
+                           EncodeFixture<I>(n, n);
+  I image;
+  for (auto _ : state) {
+    std::istringstream stream(data);
+    auto s = image.Load(stream);
+    if (!s.Good()) {
+      state.SkipWithError(s.ToString().c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(image.data());
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * n * n * 3);
+  state.counters["encoded_bytes"] = static_cast<double>(data.size());
+}
+BENCHMARK_TEMPLATE(BM_ImageDecode, FK::BMPImage)->Arg(256)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_ImageDecode, FK::JPEGImage)->Arg(256)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_ImageDecode, FK::PNGImage)->Arg(256)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_ImageDecode, FK::TGAImage)->Arg(256)->Arg(1024);
+
+/** Encode a synthetic image with codec `I` into memory */
+template<typename I>
+static void BM_ImageEncode(benchmark::State& state) {
+  const size_t n = static_cast<size_t>(state.range(0));
+  SyntheticImage<I> image(n, n);
+  for (auto _ : state) {
+    std::ostringstream stream;
+    auto s = image.Save(stream);
+    if (!s.Good()) {
+      state.SkipWithError(s.ToString().c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(stream.tellp());
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * n * n * 3);
+}
+BENCHMARK_TEMPLATE(BM_ImageEncode, FK::BMPImage)->Arg(256)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_ImageEncode, FK::JPEGImage)->Arg(256)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_ImageEncode, FK::PNGImage)->Arg(256)->Arg(1024);
@@ -67,14 +67,34 @@ class BMPImage : public Image {
    */
   ~BMPImage(void) override;
   
+  /** Expose file based overload hidden by the one below */
+  using Image::LoadInto;
+
   /**
-   *  @name Load
-   *  @fn Status Load(std::istream& stream) override
-   *  @brief  Load image from dist
+   *  @name LoadInto
+   *  @fn Status LoadInto(std::istream& stream, NDArray* dst) override
+   *  @brief  Decode image into a caller provided array
    *  @param[in]  stream  Binary stream from where to load the ressource
+   *  @param[out] dst     Where to decode the pixels
+   *  @return Operation status
+   */
+  Status LoadInto(std::istream& stream, NDArray* dst) override;
+
+  /**
+   *  @name Map
+   *  @fn Status Map(const std::string& filename, const ChannelOrder& order,
+                     NDArray* dst) override
+   *  @brief  Map uncompressed top-down files without padding directly, i.e.
+   *          8 bits grayscale or BGR(A) when `order` is `kBGR`. Other files
+   *          are decoded.
+   *  @param[in]  filename  Path to ressource on the disk
+   *  @param[in]  order     Requested channel order, ignored for grayscale
+   *  @param[out] dst       Pixels
    *  @return Operation status
    */
-  Status Load(std::istream& stream) override;
+  Status Map(const std::string& filename,
+             const ChannelOrder& order,
+             NDArray* dst) override;
   
   /**
    *  @name Save
@@ -84,6 +104,18 @@ class BMPImage : public Image {
    *  @return Operation status
    */
   Status Save(std::ostream& stream) const override;
+
+ protected:
+
+  /**
+   *  @name ParseHeader
+   *  @fn Status ParseHeader(std::istream& stream, ImageInfo* info) override
+   *  @brief  Parse image header without decoding the pixels
+   *  @param[in]  stream  Binary stream from where to read the header
+   *  @param[out] info    Image properties
+   *  @return Operation status
+   */
+  Status ParseHeader(std::istream& stream, ImageInfo* info) override;
   
 #pragma mark -
 #pragma mark Private
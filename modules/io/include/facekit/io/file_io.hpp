@@ -11,18 +11,26 @@
 #ifndef __FACEKIT_FILE_IO__
 #define __FACEKIT_FILE_IO__
 
+#include <cstdint>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <functional>
+#include <future>
 
 #include "opencv2/core/core.hpp"
 
 #include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
 
 /**
  *  @namespace  FaceKit
  *  @brief      Development space
  */
 namespace FaceKit {
+
+/** Forward declaration */
+class Serializable;
   
 /**
  *  @class  IO
@@ -33,7 +41,63 @@ namespace FaceKit {
  */
 class FK_EXPORTS IO {
  public:
-  
+
+#pragma mark -
+#pragma mark Type definition
+
+  /**
+   *  @enum   Codec
+   *  @brief  Compression codec of matrix blocks
+   */
+  enum class Codec : uint8_t {
+    /** Chunked but not compressed */
+    kNone = 0,
+    /** Deflate, always available */
+    kZlib = 1,
+    /** Zstandard, if built with libzstd */
+    kZstd = 2,
+    /** LZ4, if built with liblz4 */
+    kLz4 = 3
+  };
+
+  /**
+   *  @enum   Filter
+   *  @brief  Transformation applied to the elements before compression
+   */
+  enum class Filter : uint8_t {
+    /** None */
+    kNone = 0,
+    /** Byte shuffle, groups the k-th byte of every element */
+    kShuffle = 1,
+    /** Difference with the previous element followed by a byte shuffle */
+    kDeltaShuffle = 2
+  };
+
+  /**
+   *  @struct CompressionOptions
+   *  @brief  Compressed matrix block parameters
+   */
+  struct CompressionOptions {
+    /** Codec */
+    Codec codec = Codec::kZlib;
+    /** Filter */
+    Filter filter = Filter::kShuffle;
+    /** Compression level, negative for codec's default */
+    int level = -1;
+    /** Uncompressed chunk size in bytes (at least 4 KB), chunks are
+     (de)compressed in parallel */
+    size_t chunk_size = 1 << 20;
+  };
+
+  /**
+   *  @name IsCodecAvailable
+   *  @fn static bool IsCodecAvailable(const Codec& codec)
+   *  @brief  Indicate if a compression codec is compiled in
+   *  @param[in] codec  Codec
+   *  @return True if available
+   */
+  static bool IsCodecAvailable(const Codec& codec);
+
 #pragma mark -
 #pragma mark File I/0
   
@@ -92,6 +156,21 @@ class FK_EXPORTS IO {
    *  @return -1 if error, 0 otherwise
    */
   static int SaveMat(std::ostream& stream, const cv::Mat& matrix);
+
+  /**
+   *  @name SaveMat
+   *  @fn static int SaveMat(std::ostream& stream, const cv::Mat& matrix,
+                             const CompressionOptions& options)
+   *  @brief  Save a \p matrix into a given stream as independently
+   *          compressed chunks, `LoadMat` decompresses them in parallel
+   *  @param[in]  stream  Binary stream where to write
+   *  @param[in]  matrix  Matrix to write
+   *  @param[in]  options Compression parameters
+   *  @return -1 if error (i.e. codec not available), 0 otherwise
+   */
+  static int SaveMat(std::ostream& stream,
+                     const cv::Mat& matrix,
+                     const CompressionOptions& options);
   
   /**
    *  @name SaveTypedMat
@@ -126,7 +205,102 @@ class FK_EXPORTS IO {
    */
   template<typename T>
   static int SaveTypedMat(const std::string& filename, const cv::Mat& matrix);
+
+  /**
+   *  @name SaveAlignedMat
+   *  @fn static int SaveAlignedMat(std::ostream& stream, const cv::Mat& matrix)
+   *  @brief  Save a \p matrix with its data aligned on `kMatAlignment` bytes
+   *          from the beginning of the stream, so it can be mapped back with
+   *          `MapMat`. Blocks are read by `LoadMat` as well.
+   *  @param[in]  stream  Binary stream where to write
+   *  @param[in]  matrix  Matrix to write
+   *  @return -1 if error, 0 otherwise
+   */
+  static int SaveAlignedMat(std::ostream& stream, const cv::Mat& matrix);
+
+  /**
+   *  @name MapMat
+   *  @fn static Status MapMat(const std::string& path, size_t* offset,
+                               cv::Mat* matrix)
+   *  @brief  Load a matrix stored at a given position of a file without
+   *          copying its data: the region is mapped in memory and shared
+   *          between every process using the same file. The matrix is
+   *          read-only. Blocks not written by `SaveAlignedMat` are copied.
+   *  @param[in]  path    Path to the file
+   *  @param[in,out] offset Position of the block, moved past it on success
+   *  @param[out] matrix  Loaded matrix
+   *  @return Operation status
+   */
+  static Status MapMat(const std::string& path,
+                       size_t* offset,
+                       cv::Mat* matrix);
+
+  /**
+   *  @name MapTypedMat
+   *  @fn static Status MapTypedMat(const std::string& path, size_t* offset,
+                                    cv::Mat* matrix)
+   *  @brief  Same as `MapMat` for a specific type, blocks stored with another
+   *          type are loaded and converted
+   *  @tparam T Desired type for matrix
+   *  @param[in]  path    Path to the file
+   *  @param[in,out] offset Position of the block, moved past it on success
+   *  @param[out] matrix  Loaded matrix
+   *  @return Operation status
+   */
+  template<typename T>
+  static Status MapTypedMat(const std::string& path,
+                            size_t* offset,
+                            cv::Mat* matrix);
+
+  /**
+   *  @name MapRawMat
+   *  @fn static Status MapRawMat(const std::string& path,
+                                  const size_t& offset, const int& rows,
+                                  const int& cols, const int& type,
+                                  cv::Mat* matrix)
+   *  @brief  Load a matrix whose elements are stored without header at a
+   *          given position of a file (i.e. a section written by
+   *          `SectionWriter`). The region is mapped when \p offset is a
+   *          multiple of the element size, read otherwise.
+   *  @param[in]  path    Path to the file
+   *  @param[in]  offset  Position of the first element
+   *  @param[in]  rows    Rows
+   *  @param[in]  cols    Columns
+   *  @param[in]  type    OpenCV type of the stored elements
+   *  @param[out] matrix  Loaded matrix
+   *  @return Operation status
+   */
+  static Status MapRawMat(const std::string& path,
+                          const size_t& offset,
+                          const int& rows,
+                          const int& cols,
+                          const int& type,
+                          cv::Mat* matrix);
+
+  /** Data alignment of blocks written by `SaveAlignedMat` */
+  static constexpr size_t kMatAlignment = 64;
   
+#pragma mark -
+#pragma mark Asynchronous loading
+
+  /**
+   *  @name LoadAsync
+   *  @fn static std::future<Status> LoadAsync(const std::string& path,
+                                               Serializable* object)
+   *  @brief  Load an object on the global `ThreadPool`. The whole file is
+   *          read ahead in a single request into a pooled buffer, then
+   *          deserialized from memory, therefore independent loads overlap
+   *          with each other and with the caller. Remote paths are
+   *          supported through the registered file systems.
+   *  @param[in]  path    File to load from
+   *  @param[out] object  Object to load, must stay alive and untouched until
+   *                      the future is ready
+   *  @return Future holding the operation status. Do not block on it from
+   *          a pool's worker.
+   */
+  static std::future<Status> LoadAsync(const std::string& path,
+                                       Serializable* object);
+
 #pragma mark -
 #pragma mark Stream Utility
   
@@ -161,11 +335,56 @@ class FK_EXPORTS IO {
                                          const std::string& ext,
                                          std::vector<std::string>* files)
    *  @brief  Search recursively from a root folder for files with a specific
-   *          extension
+   *          extension. Folders are scanned in parallel, the order of
+   *          `files` is unspecified.
    */
   static void SearchInFolder(const std::string& root,
                              const std::string& ext,
                              std::vector<std::string>* files);
+
+  /**
+   *  @name   SearchInFolder
+   *  @fn     static void SearchInFolder(const std::string& root,
+                                 const std::vector<std::string>& exts,
+                                 std::vector<std::string>* files)
+   *  @brief  Search recursively from a root folder for files matching one of
+   *          the extensions, the tree is walked only once. Folders are
+   *          scanned in parallel, the order of `files` is unspecified.
+   */
+  static void SearchInFolder(const std::string& root,
+                             const std::vector<std::string>& exts,
+                             std::vector<std::string>* files);
+
+  /**
+   *  @name   SearchInFolder
+   *  @fn     static int SearchInFolder(const std::string& root,
+                      const std::vector<std::string>& exts,
+                      const std::function<bool(const std::string&)>& callback)
+   *  @brief  Search recursively from a root folder for files matching one of
+   *          the extensions and stream them to `callback` while the scan is
+   *          still running. Calls are serialized, returning false stops the
+   *          search.
+   *  @return -1 if error, 0 otherwise
+   */
+  static int SearchInFolder(const std::string& root,
+                            const std::vector<std::string>& exts,
+                            const std::function<bool(const std::string&)>& callback);
+
+  /**
+   *  @name   GlobInFolder
+   *  @fn     static int GlobInFolder(const std::string& root,
+                      const std::vector<std::string>& patterns,
+                      const std::function<bool(const std::string&)>& callback)
+   *  @brief  Search recursively from a root folder for files whose name
+   *          matches one of the glob patterns (i.e. `img_*.jp?g`, see
+   *          `Path::Match`) and stream them to `callback` while the scan is
+   *          still running. Calls are serialized, returning false stops the
+   *          search.
+   *  @return -1 if error, 0 otherwise
+   */
+  static int GlobInFolder(const std::string& root,
+                          const std::vector<std::string>& patterns,
+                          const std::function<bool(const std::string&)>& callback);
 };
   
 }  // namespace FaceKit
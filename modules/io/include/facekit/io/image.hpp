@@ -25,6 +25,9 @@
  *  @brief      Development space
  */
 namespace FaceKit {
+
+/** Forward declaration */
+class ImageWriter;
   
 /**
  *  @class  Image
@@ -51,6 +54,79 @@ class Image {
     /** Color - RGBA */
     kRGBA = 4
   };
+
+  /**
+   *  @enum   ChannelOrder
+   *  @brief  Memory order of the color channels
+   */
+  enum class ChannelOrder : char {
+    /** Red first, layout produced by the decoders */
+    kRGB,
+    /** Blue first, native layout of BMP/TGA files and OpenCV */
+    kBGR
+  };
+
+  /**
+   *  @struct ImageInfo
+   *  @brief  Image properties available without decoding the pixels
+   */
+  struct ImageInfo {
+    /** Image width */
+    size_t width;
+    /** Image height */
+    size_t height;
+    /** Image format, i.e. number of channels */
+    Format format;
+
+    /**
+     *  @name   ImageInfo
+     *  @fn     ImageInfo(void)
+     *  @brief  Constructor
+     */
+    ImageInfo(void) : width(0), height(0), format(kGrayscale) {}
+  };
+
+  /**
+   *  @struct Region
+   *  @brief  Rectangle of the image to decode, empty for the whole image
+   */
+  struct Region {
+    /** Left column */
+    size_t x;
+    /** Top row */
+    size_t y;
+    /** Width, 0 for the whole image */
+    size_t width;
+    /** Height, 0 for the whole image */
+    size_t height;
+
+    /**
+     *  @name   Region
+     *  @fn     Region(void)
+     *  @brief  Constructor, whole image
+     */
+    Region(void) : x(0), y(0), width(0), height(0) {}
+
+    /**
+     *  @name   Region
+     *  @fn     Region(const size_t& x, const size_t& y, const size_t& width,
+                       const size_t& height)
+     *  @brief  Constructor
+     */
+    Region(const size_t& x,
+           const size_t& y,
+           const size_t& width,
+           const size_t& height) : x(x), y(y), width(width), height(height) {}
+
+    /**
+     *  @name   empty
+     *  @fn     bool empty(void) const
+     *  @brief  Indicate if the whole image is selected
+     */
+    bool empty(void) const {
+      return width == 0 || height == 0;
+    }
+  };
   
 #pragma mark -
 #pragma mark Initialization
@@ -60,7 +136,7 @@ class Image {
    *  @fn Image(void)
    *  @brief  Constructor
    */
-  Image(void) : format_(kGrayscale), width_(0), height_(0) {}
+  Image(void) : format_(kGrayscale), width_(0), height_(0), level_(-1) {}
   
   /**
    *  @name   Image
@@ -69,7 +145,8 @@ class Image {
    *  @param[in] alloc  Allocator to use for the underlying image buffer
    */
   explicit Image(Allocator* alloc) : format_(kGrayscale),
-                                     width_(0), height_(0), buffer_(alloc) {}
+                                     width_(0), height_(0), level_(-1),
+                                     buffer_(alloc) {}
   
   /**
    *  @name ~Image
@@ -89,13 +166,81 @@ class Image {
   
   /**
    *  @name Load
-   *  @fn virtual Status Load(std::istream& stream) = 0
-   *  @brief  Load image from dist
+   *  @fn virtual Status Load(std::istream& stream)
+   *  @brief  Load image from dist into the image's own buffer
    *  @param[in]  stream  Binary stream from where to load the ressource
    *  @return Operation status
    */
-  virtual Status Load(std::istream& stream) = 0;
+  virtual Status Load(std::istream& stream);
+
+  /**
+   *  @name LoadInto
+   *  @fn Status LoadInto(const std::string& filename, NDArray* dst)
+   *  @brief  Decode image from disk into a caller provided array. See
+   *          `LoadInto(std::istream&, NDArray*)`.
+   *  @param[in]  filename  Path to ressource on the disk
+   *  @param[out] dst       Where to decode the pixels
+   *  @return Operation status
+   */
+  Status LoadInto(const std::string& filename, NDArray* dst);
+
+  /**
+   *  @name LoadInto
+   *  @fn virtual Status LoadInto(std::istream& stream, NDArray* dst) = 0
+   *  @brief  Decode image into a caller provided array of shape
+   *          [Height x Width x Format] and type kUInt8. `dst` keeps its
+   *          allocator and is only reallocated if its size does not match,
+   *          therefore decoding same-sized images into the same array does not
+   *          allocate. `width`, `height` and `format` describe `dst`
+   *          afterwards, the image's own buffer is left untouched.
+   *  @param[in]  stream  Binary stream from where to load the ressource
+   *  @param[out] dst     Where to decode the pixels
+   *  @return Operation status
+   */
+  virtual Status LoadInto(std::istream& stream, NDArray* dst) = 0;
+
+  /**
+   *  @name Map
+   *  @fn virtual Status Map(const std::string& filename,
+                             const ChannelOrder& order, NDArray* dst)
+   *  @brief  Expose the pixels of an image file in `dst` without decoding
+   *          nor copying them when the file already stores them as
+   *          top-down rows with `order` channels and no padding. `dst` is then
+   *          a copy-on-write view over a memory mapping of the file (pages
+   *          are loaded on demand). Otherwise the image is decoded into `dst`
+   *          like `LoadInto`, with red and blue swapped for `kBGR`.
+   *  @param[in]  filename  Path to ressource on the disk
+   *  @param[in]  order     Requested channel order, ignored for grayscale
+   *  @param[out] dst       Pixels
+   *  @return Operation status
+   */
+  virtual Status Map(const std::string& filename,
+                     const ChannelOrder& order,
+                     NDArray* dst);
   
+  /**
+   *  @name ReadHeader
+   *  @fn Status ReadHeader(const std::string& filename, ImageInfo* info)
+   *  @brief  Probe image dimensions/format without decoding the pixels
+   *  @param[in]  filename  Path to ressource on the disk
+   *  @param[out] info      Image properties
+   *  @return Operation status
+   */
+  Status ReadHeader(const std::string& filename, ImageInfo* info);
+
+  /**
+   *  @name ReadHeader
+   *  @fn Status ReadHeader(std::istream& stream, ImageInfo* info)
+   *  @brief  Probe image dimensions/format by parsing only the header. The
+   *          stream is rewound to its initial position afterward, therefore
+   *          it can be decoded right away (i.e. into a pre-allocated array
+   *          with `LoadInto`). The image itself is not modified.
+   *  @param[in]  stream  Binary stream from where to read the header
+   *  @param[out] info    Image properties
+   *  @return Operation status
+   */
+  Status ReadHeader(std::istream& stream, ImageInfo* info);
+
   /**
    *  @name Save
    *  @fn virtual Status Save(const std::string& filename) const
@@ -113,6 +258,17 @@ class Image {
    *  @return Operation status
    */
   virtual Status Save(std::ostream& stream) const = 0;
+
+  /**
+   *  @name CreateWriter
+   *  @fn virtual ImageWriter* CreateWriter(void) const
+   *  @brief  Create a streaming encoder for this format, accepting the image
+   *          by strips of rows. Caller takes ownership.
+   *  @return Writer instance or nullptr if the format does not support it
+   */
+  virtual ImageWriter* CreateWriter(void) const {
+    return nullptr;
+  }
   
 #pragma mark -
 #pragma mark accessors
@@ -147,6 +303,30 @@ class Image {
     return height_;
   }
   
+  /**
+   *  @name   set_compression_level
+   *  @fn     void set_compression_level(const int& level)
+   *  @brief  Set the size / speed trade-off used by `Save` and `CreateWriter`,
+   *          in [0, 100]. Lossless codecs (PNG) spend more time for smaller
+   *          files as the level increases, lossy codecs (JPEG, WebP) use it as
+   *          quality. Negative selects the codec default. Ignored by BMP, TGA
+   *          and QOI.
+   *  @param[in] level  Compression level
+   */
+  void set_compression_level(const int& level) {
+    level_ = level;
+  }
+
+  /**
+   *  @name   compression_level
+   *  @fn     const int& compression_level(void) const
+   *  @brief  Provide compression level, negative for the codec default
+   *  @return Compression level
+   */
+  const int& compression_level(void) const {
+    return level_;
+  }
+
   /**
    *  @name   data
    *  @fn     const uint8_t* data(void) const
@@ -168,12 +348,26 @@ class Image {
   }
   
  protected:
+
+  /**
+   *  @name ParseHeader
+   *  @fn virtual Status ParseHeader(std::istream& stream, ImageInfo* info) = 0
+   *  @brief  Parse format specific header, called by `ReadHeader` which takes
+   *          care of restoring the stream position.
+   *  @param[in]  stream  Binary stream from where to read the header
+   *  @param[out] info    Image properties
+   *  @return Operation status
+   */
+  virtual Status ParseHeader(std::istream& stream, ImageInfo* info) = 0;
+
   /** Image format */
   Format format_;
   /** Image width */
   size_t width_;
   /** Image height */
   size_t height_;
+  /** Compression level used by the encoders, negative for default */
+  int level_;
   /** Image buffer */
   NDArray buffer_;
 };
@@ -0,0 +1,169 @@
+/**
+ *  @file   image_batch_loader.hpp
+ *  @brief  Decode a batch of image files in parallel
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   17.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_IMAGE_BATCH_LOADER__
+#define __FACEKIT_IMAGE_BATCH_LOADER__
+
+#include <vector>
+#include <string>
+#include <functional>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/core/nd_array.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Forward declaration */
+class Allocator;
+class ImageCache;
+class MemoryBudget;
+class ThreadPool;
+
+/**
+ *  @class  ImageBatchLoader
+ *  @brief  Read and decode a list of image files on a `ThreadPool`. Each task
+ *          reads one file into a pooled buffer and decodes it with a codec
+ *          instance cached per worker thread (selected by file extension).
+ *          The number of files being read, decoded or waiting for delivery
+ *          is bounded, which caps the memory used by a batch. Decoded
+ *          pixels are charged to a memory budget until delivered, no new
+ *          file is started while it is exhausted.
+ *  @author Christophe Ecabert
+ *  @date   17.10.18
+ *  @ingroup io
+ */
+class FK_EXPORTS ImageBatchLoader {
+ public:
+
+  /**
+   *  @struct Options
+   *  @brief  Loader configuration
+   */
+  struct Options {
+    /** Maximum number of images in flight (read, decoded or not delivered) */
+    size_t max_in_flight = 32;
+    /** Deliver images in the order of the input list, otherwise as they
+     complete */
+    bool ordered = false;
+    /** Allocator for file content and pixels, nullptr use
+     `pooled_cpu_allocator` */
+    Allocator* allocator = nullptr;
+    /** Pool running the tasks, nullptr use the global pool */
+    ThreadPool* pool = nullptr;
+    /** Cache of decoded images, nullptr decode every file. Images delivered
+     from the cache share its buffer until they are modified */
+    ImageCache* cache = nullptr;
+    /** Budget charged with the decoded pixels until they are delivered,
+     nullptr use `MemoryBudget::Global()` */
+    MemoryBudget* budget = nullptr;
+  };
+
+  /**
+   *  @name   Callback
+   *  @brief  Invoked once per image with its position in the batch, the
+   *          decoding status and its pixels (`kUInt8`, height x width x
+   *          channels). Calls are serialized but may come from any thread.
+   */
+  using Callback = std::function<void(const size_t& index,
+                                      const Status& status,
+                                      NDArray&& image)>;
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   ImageBatchLoader
+   *  @fn     ImageBatchLoader(void)
+   *  @brief  Constructor with default options
+   */
+  ImageBatchLoader(void);
+
+  /**
+   *  @name   ImageBatchLoader
+   *  @fn     explicit ImageBatchLoader(const Options& options)
+   *  @brief  Constructor
+   *  @param[in] options  Loader configuration
+   */
+  explicit ImageBatchLoader(const Options& options);
+
+  /**
+   *  @name   ImageBatchLoader
+   *  @fn     ImageBatchLoader(const ImageBatchLoader& other) = delete
+   *  @brief  Copy constructor
+   */
+  ImageBatchLoader(const ImageBatchLoader& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     ImageBatchLoader& operator=(const ImageBatchLoader& rhs) = delete
+   *  @brief  Assignment operator
+   */
+  ImageBatchLoader& operator=(const ImageBatchLoader& rhs) = delete;
+
+  /**
+   *  @name   ~ImageBatchLoader
+   *  @fn     ~ImageBatchLoader(void) = default
+   *  @brief  Destructor
+   */
+  ~ImageBatchLoader(void) = default;
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   Load
+   *  @fn     Status Load(const std::vector<std::string>& paths,
+                          const Callback& callback)
+   *  @brief  Decode every image in `paths`, `callback` is invoked for each of
+   *          them. Returns once all images have been reported.
+   *  @param[in] paths    Images to load
+   *  @param[in] callback Completion callback
+   *  @return kGood if every image has been decoded, first error otherwise
+   */
+  Status Load(const std::vector<std::string>& paths, const Callback& callback);
+
+  /**
+   *  @name   Load
+   *  @fn     Status Load(const std::vector<std::string>& paths,
+                          std::vector<NDArray>* images)
+   *  @brief  Decode every image in `paths` and gather them in order
+   *  @param[in] paths    Images to load
+   *  @param[out] images  Decoded images
+   *  @return kGood if every image has been decoded, first error otherwise
+   */
+  Status Load(const std::vector<std::string>& paths,
+              std::vector<NDArray>* images);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   options
+   *  @fn     const Options& options(void) const
+   *  @brief  Loader configuration
+   */
+  const Options& options(void) const {
+    return options_;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Configuration */
+  Options options_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_IMAGE_BATCH_LOADER__ */
@@ -0,0 +1,315 @@
+/**
+ *  @file   image_cache.hpp
+ *  @brief  In-memory cache of decoded images shared between threads
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_IMAGE_CACHE__
+#define __FACEKIT_IMAGE_CACHE__
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/nd_array.hpp"
+#include "facekit/core/refcounter.hpp"
+#include "facekit/core/status.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Forward declaration */
+class Allocator;
+
+/**
+ *  @class  ImageCache
+ *  @brief  Least recently used cache of decoded images (`kUInt8`, height x
+ *          width x channels) keyed by path, modification time and scale.
+ *          Entries are spread over shards with their own lock, therefore
+ *          threads looking up different images do not contend. An image is
+ *          decoded once even if requested concurrently, and stays pinned as
+ *          long as a handle references it. Idle entries are evicted once the
+ *          memory budget is exceeded.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup io
+ *  @details Files modified on disk get a new key, the stale entry is never
+ *           hit again and ages out of the cache.
+ */
+class FK_EXPORTS ImageCache {
+ private:
+  /** Cache entry, forward declaration */
+  class Entry;
+
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /**
+   *  @struct Options
+   *  @brief  Cache configuration
+   */
+  struct Options {
+    /** Memory budget in bytes, shared evenly among the shards */
+    size_t budget = size_t(256) << 20;
+    /** Number of shards */
+    size_t n_shard = 16;
+    /** Allocator for the pixels, nullptr use `pooled_cpu_allocator` */
+    Allocator* allocator = nullptr;
+  };
+
+  /**
+   *  @class  Handle
+   *  @brief  Pin a cached image, it stays alive as long as a handle
+   *          references it even if evicted in the meantime. Pixels are
+   *          shared between threads, therefore only const access is given.
+   *          Copies of `image()` share the buffer until they are modified.
+   */
+  class FK_EXPORTS Handle {
+   public:
+    /**
+     *  @name   Handle
+     *  @fn     Handle(void)
+     *  @brief  Constructor, empty handle
+     */
+    Handle(void) = default;
+
+    /**
+     *  @name   image
+     *  @fn     const NDArray& image(void) const
+     *  @brief  Decoded pixels, must not be empty
+     */
+    const NDArray& image(void) const;
+
+    /**
+     *  @name   operator bool
+     *  @fn     explicit operator bool(void) const
+     *  @brief  Indicate if the handle references an image
+     */
+    explicit operator bool(void) const {
+      return entry_ != nullptr;
+    }
+
+   private:
+    friend class ImageCache;
+
+    /**
+     *  @name   Handle
+     *  @fn     explicit Handle(RefPtr<Entry> entry)
+     *  @brief  Constructor, take over the reference held by `entry`
+     */
+    explicit Handle(RefPtr<Entry> entry) : entry_(std::move(entry)) {}
+
+    /** Referenced entry */
+    RefPtr<Entry> entry_;
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   Get
+   *  @fn     static ImageCache& Get(void)
+   *  @brief  Process-wide cache with default options
+   */
+  static ImageCache& Get(void);
+
+  /**
+   *  @name   ImageCache
+   *  @fn     ImageCache(void)
+   *  @brief  Constructor with default options
+   */
+  ImageCache(void);
+
+  /**
+   *  @name   ImageCache
+   *  @fn     explicit ImageCache(const Options& options)
+   *  @brief  Constructor
+   *  @param[in] options  Cache configuration
+   */
+  explicit ImageCache(const Options& options);
+
+  /**
+   *  @name   ImageCache
+   *  @fn     ImageCache(const ImageCache& other) = delete
+   *  @brief  Copy constructor
+   */
+  ImageCache(const ImageCache& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     ImageCache& operator=(const ImageCache& rhs) = delete
+   *  @brief  Assignment operator
+   */
+  ImageCache& operator=(const ImageCache& rhs) = delete;
+
+  /**
+   *  @name   ~ImageCache
+   *  @fn     ~ImageCache(void)
+   *  @brief  Destructor, images still pinned are released with their last
+   *          handle
+   */
+  ~ImageCache(void);
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   Acquire
+   *  @fn     Status Acquire(const std::string& path, const float& scale,
+                             Handle* image)
+   *  @brief  Get the image stored in `path`, resized by `scale`, decoding it
+   *          on first use. Concurrent calls for the same image decode it
+   *          once, the others wait for it.
+   *  @param[in] path   Image file, any path supported by `FileSystemFactory`
+   *  @param[in] scale  Resize factor applied after decoding (area
+   *                    interpolation), 1 to keep the original size
+   *  @param[out] image Pinned image
+   *  @return kInvalidArgument if the file can not be found, decoded or the
+   *          scale is not positive. Failures are not cached.
+   */
+  Status Acquire(const std::string& path, const float& scale, Handle* image);
+
+  /**
+   *  @name   Acquire
+   *  @fn     Status Acquire(const std::string& path, Handle* image)
+   *  @brief  Get the image stored in `path` at its original size
+   *  @param[in] path   Image file
+   *  @param[out] image Pinned image
+   *  @return Operation status
+   */
+  Status Acquire(const std::string& path, Handle* image) {
+    return this->Acquire(path, 1.f, image);
+  }
+
+  /**
+   *  @name   Clear
+   *  @fn     void Clear(void)
+   *  @brief  Drop every cached image, pinned ones are released when their
+   *          last handle goes away
+   */
+  void Clear(void);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   budget
+   *  @fn     size_t budget(void) const
+   *  @brief  Memory budget in bytes
+   */
+  size_t budget(void) const;
+
+  /**
+   *  @name   set_budget
+   *  @fn     void set_budget(const size_t& budget)
+   *  @brief  Set the memory budget in bytes, least recently used idle
+   *          images are evicted until it is met. Pinned images are never
+   *          evicted, the budget can therefore be exceeded temporarily.
+   */
+  void set_budget(const size_t& budget);
+
+  /**
+   *  @name   size
+   *  @fn     size_t size(void) const
+   *  @brief  Memory used by the decoded images in bytes
+   */
+  size_t size(void) const;
+
+  /**
+   *  @name   n_entry
+   *  @fn     size_t n_entry(void) const
+   *  @brief  Number of cached images, including the ones being decoded
+   */
+  size_t n_entry(void) const;
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Least recently used first */
+  using LruList = std::list<Entry*>;
+
+  /**
+   *  @class  Entry
+   *  @brief  Cached image. The cache holds one reference, every handle one
+   *          more
+   */
+  class Entry : public RefCounter {
+   public:
+    /** Key in the shard */
+    std::string key;
+    /** Decoded pixels */
+    NDArray image;
+    /** Memory footprint */
+    size_t bytes = 0;
+    /** Position in the shard's LRU list */
+    LruList::iterator lru;
+    /** Decoding is done, `image` is set on success */
+    bool loaded = false;
+    /** Decoded and accounted in the shard's size, guarded by its lock */
+    bool resident = false;
+    /** Serialize decoding */
+    std::mutex load_mutex;
+
+   protected:
+    /**
+     *  @name   ~Entry
+     *  @fn     ~Entry(void) override = default
+     *  @brief  Destructor
+     */
+    ~Entry(void) override = default;
+  };
+
+  /**
+   *  @struct Shard
+   *  @brief  Independent part of the cache
+   */
+  struct Shard {
+    /** Entries by key */
+    std::unordered_map<std::string, RefPtr<Entry>> entries;
+    /** Entries by last access, most recent at the back */
+    LruList lru;
+    /** Memory used by loaded entries */
+    size_t size = 0;
+    /** Protect the shard */
+    mutable std::mutex lock;
+  };
+
+  /**
+   *  @name   Load
+   *  @fn     Status Load(const std::string& path, const float& scale,
+                          Entry* entry) const
+   *  @brief  Decode and resize the image of `entry`
+   */
+  Status Load(const std::string& path, const float& scale, Entry* entry) const;
+
+  /**
+   *  @name   Evict
+   *  @fn     void Evict(Shard* shard) const
+   *  @brief  Drop least recently used idle entries of `shard` until its part
+   *          of the budget is met, the shard's lock must be held
+   */
+  void Evict(Shard* shard) const;
+
+  /** Configuration */
+  Options options_;
+  /** Shards */
+  std::unique_ptr<Shard[]> shards_;
+  /** Memory budget */
+  std::atomic<size_t> budget_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_IMAGE_CACHE__ */
@@ -11,9 +11,10 @@
 #ifndef __FACEKIT_IMAGE_FACOTRY__
 #define __FACEKIT_IMAGE_FACOTRY__
 
-#include <unordered_set>
+#include <string>
 
 #include "facekit/core/library_export.hpp"
+#include "facekit/core/utils/static_registry.hpp"
 #include "facekit/io/image.hpp"
 
 /**
@@ -74,15 +75,33 @@ public:
    *  @return Pointer to an instance of the given type, nullptr if type is 
    *  unknown
    */
-  Image* CreateByExtension(const std::string& extension);
+  Image* CreateByExtension(const std::string& extension) {
+    return this->CreateByExtension(extension.c_str());
+  }
+
+  /**
+   *  @name CreateByExtension
+   *  @fn Image* CreateByExtension(const char* extension)
+   *  @brief  Create an image based on the extension type, the lookup does not
+   *          allocate
+   *  @param[in]  extension  Image extension (type)
+   *  @return Pointer to an instance of the given type, nullptr if type is
+   *  unknown
+   */
+  Image* CreateByExtension(const char* extension);
   
   /**
    *  @name Register
-   *  @fn void Register(const ImageProxy* object)
-   *  @brief  Register a type of image with a given proxy.
+   *  @fn static void Register(const ImageProxy* object)
+   *  @brief  Register a type of image with a given proxy. Neither allocates
+   *          nor builds the factory, therefore it is cheap to call from
+   *          static constructors.
    *  @param[in]  object  Object to register
    */
-  void Register(const ImageProxy* object);
+  static void Register(const ImageProxy* object);
+
+  /** Maximum number of registered image types */
+  static constexpr size_t kMaxProxy = 32;
   
  private:
   
@@ -93,8 +112,8 @@ public:
    */
   ImageFactory(void) = default;
   
-  /** List of all unique registered image's proxies */
-  std::unordered_set<const ImageProxy*> proxies_;
+  /** Registered image's proxies, constant-initialized */
+  static StaticRegistry<const ImageProxy*, kMaxProxy> proxies_;
 };
   
 /**
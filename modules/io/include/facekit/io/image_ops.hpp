@@ -0,0 +1,127 @@
+/**
+ *  @file   image_ops.hpp
+ *  @brief  Native resize and Gaussian pyramid on 8 bits images
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   19.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_IMAGE_OPS__
+#define __FACEKIT_IMAGE_OPS__
+
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/nd_array.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/io/image.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  ImageOps
+ *  @brief  Geometric operations on `kUInt8` images of shape
+ *          [Height x Width x Channels] (or [Height x Width]) such as the
+ *          buffers produced by `Image`. Rows are processed concurrently on
+ *          the default `ThreadPool`, inner loops use SSE2 when available.
+ *  @author Christophe Ecabert
+ *  @date   19.10.18
+ *  @ingroup io
+ *  @details Outputs are resized with `NDArray::Resize`, therefore they keep
+ *           the allocator they have been created with and same-sized
+ *           outputs are reused. Output can alias the input.
+ */
+class FK_EXPORTS ImageOps {
+ public:
+
+  /**
+   *  @enum   Interpolation
+   *  @brief  Resampling method
+   */
+  enum class Interpolation : char {
+    /** Bilinear, pixel centers aligned (same as OpenCV's INTER_LINEAR) */
+    kBilinear,
+    /** Average over the covered source area when shrinking, bilinear when
+     enlarging (same as OpenCV's INTER_AREA) */
+    kArea
+  };
+
+  /**
+   *  @name   Resize
+   *  @fn     static Status Resize(const NDArray& src, const size_t& width,
+                                   const size_t& height,
+                                   const Interpolation& interp, NDArray* dst)
+   *  @brief  Resample `src` to `width` x `height`
+   *  @param[in] src    Image to resize
+   *  @param[in] width  Output width
+   *  @param[in] height Output height
+   *  @param[in] interp Resampling method
+   *  @param[out] dst   Resized image
+   *  @return kInvalidArgument if `src` is not an 8 bits image or the output
+   *          is empty
+   */
+  static Status Resize(const NDArray& src,
+                       const size_t& width,
+                       const size_t& height,
+                       const Interpolation& interp,
+                       NDArray* dst);
+
+  /**
+   *  @name   Resize
+   *  @fn     static Status Resize(const Image& src, const size_t& width,
+                                   const size_t& height,
+                                   const Interpolation& interp, NDArray* dst)
+   *  @brief  Resample an image's own buffer to `width` x `height`
+   *  @param[in] src    Image to resize
+   *  @param[in] width  Output width
+   *  @param[in] height Output height
+   *  @param[in] interp Resampling method
+   *  @param[out] dst   Resized image
+   *  @return kInvalidArgument if `src` is empty or the output is empty
+   */
+  static Status Resize(const Image& src,
+                       const size_t& width,
+                       const size_t& height,
+                       const Interpolation& interp,
+                       NDArray* dst);
+
+  /**
+   *  @name   PyrDown
+   *  @fn     static Status PyrDown(const NDArray& src, NDArray* dst)
+   *  @brief  Blur with a 5x5 Gaussian kernel then drop every other row and
+   *          column. Output is (W + 1) / 2 x (H + 1) / 2, borders are
+   *          reflected (same as OpenCV's pyrDown).
+   *  @param[in] src  Image to downsample
+   *  @param[out] dst Downsampled image
+   *  @return kInvalidArgument if `src` is not an 8 bits image
+   */
+  static Status PyrDown(const NDArray& src, NDArray* dst);
+
+  /**
+   *  @name   BuildPyramid
+   *  @fn     static Status BuildPyramid(const NDArray& src,
+                                         const size_t& n_level,
+                                         std::vector<NDArray>* pyramid)
+   *  @brief  Gaussian pyramid, level 0 shares `src`'s buffer and each next
+   *          level is `PyrDown` of the previous one. Stops early when a level
+   *          would be a single pixel. Existing levels in `pyramid` are reused
+   *          as output, therefore building pyramids of same-sized images
+   *          does not allocate.
+   *  @param[in] src      Base image
+   *  @param[in] n_level  Maximum number of levels, including the base
+   *  @param[in,out] pyramid  Levels
+   *  @return kInvalidArgument if `src` is not an 8 bits image
+   */
+  static Status BuildPyramid(const NDArray& src,
+                             const size_t& n_level,
+                             std::vector<NDArray>* pyramid);
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_IMAGE_OPS__ */
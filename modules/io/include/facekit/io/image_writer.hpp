@@ -0,0 +1,197 @@
+/**
+ *  @file   image_writer.hpp
+ *  @brief  Streaming image encoder interface, accept horizontal strips
+ *          incrementally
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   16.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_IMAGE_WRITER__
+#define __FACEKIT_IMAGE_WRITER__
+
+#include <cstdint>
+#include <ostream>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/io/image.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  ImageWriter
+ *  @brief  Streaming encoder. Rows are provided top to bottom by strips of
+ *          any height, each strip is encoded and pushed to the stream before
+ *          the call returns. Therefore the whole image never needs to be in
+ *          memory. Instances are created with `Image::CreateWriter`.
+ *  @author Christophe Ecabert
+ *  @date   16.10.18
+ *  @ingroup io
+ */
+class FK_EXPORTS ImageWriter {
+ public:
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   ImageWriter
+   *  @fn     ImageWriter(void)
+   *  @brief  Constructor
+   */
+  ImageWriter(void);
+
+  /**
+   *  @name   ImageWriter
+   *  @fn     ImageWriter(const ImageWriter& other) = delete
+   *  @brief  Copy constructor
+   */
+  ImageWriter(const ImageWriter& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     ImageWriter& operator=(const ImageWriter& rhs) = delete
+   *  @brief  Assignment operator
+   */
+  ImageWriter& operator=(const ImageWriter& rhs) = delete;
+
+  /**
+   *  @name   ~ImageWriter
+   *  @fn     virtual ~ImageWriter(void) = default
+   *  @brief  Destructor, an unfinished image is discarded
+   */
+  virtual ~ImageWriter(void) = default;
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   Open
+   *  @fn     Status Open(std::ostream* stream, const size_t& width,
+                          const size_t& height, const Image::Format& format)
+   *  @brief  Start a new image, write its header into `stream`
+   *  @param[in] stream Where to write the encoded image, must outlive the
+   *                    writer or the call to `Close`
+   *  @param[in] width  Image width
+   *  @param[in] height Image height
+   *  @param[in] format Image format
+   *  @return Operation status
+   */
+  Status Open(std::ostream* stream,
+              const size_t& width,
+              const size_t& height,
+              const Image::Format& format);
+
+  /**
+   *  @name   Write
+   *  @fn     Status Write(const uint8_t* rows, const size_t& n_rows)
+   *  @brief  Encode the next `n_rows` rows. Rows are packed, i.e. the stride
+   *          is width * format bytes.
+   *  @param[in] rows   Pixels of the strip
+   *  @param[in] n_rows Number of rows in the strip
+   *  @return Operation status, kOutOfRange if more rows than the image height
+   *          are provided
+   */
+  Status Write(const uint8_t* rows, const size_t& n_rows);
+
+  /**
+   *  @name   Close
+   *  @fn     Status Close(void)
+   *  @brief  Finalize the image once all rows have been written
+   *  @return Operation status
+   */
+  Status Close(void);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   width
+   *  @fn     const size_t& width(void) const
+   *  @brief  Provide image width
+   */
+  const size_t& width(void) const {
+    return width_;
+  }
+
+  /**
+   *  @name   height
+   *  @fn     const size_t& height(void) const
+   *  @brief  Provide image height
+   */
+  const size_t& height(void) const {
+    return height_;
+  }
+
+  /**
+   *  @name   format
+   *  @fn     const Image::Format& format(void) const
+   *  @brief  Provide image format
+   */
+  const Image::Format& format(void) const {
+    return format_;
+  }
+
+  /**
+   *  @name   rows_written
+   *  @fn     const size_t& rows_written(void) const
+   *  @brief  Number of rows encoded so far
+   */
+  const size_t& rows_written(void) const {
+    return row_;
+  }
+
+#pragma mark -
+#pragma mark Protected
+ protected:
+
+  /**
+   *  @name   OpenImpl
+   *  @fn     virtual Status OpenImpl(void) = 0
+   *  @brief  Codec specific initialization, properties are already set
+   *  @return Operation status
+   */
+  virtual Status OpenImpl(void) = 0;
+
+  /**
+   *  @name   WriteImpl
+   *  @fn     virtual Status WriteImpl(const uint8_t* rows,
+                                       const size_t& n_rows) = 0
+   *  @brief  Codec specific encoding of a strip, size is already checked
+   *  @param[in] rows   Pixels of the strip
+   *  @param[in] n_rows Number of rows in the strip
+   *  @return Operation status
+   */
+  virtual Status WriteImpl(const uint8_t* rows, const size_t& n_rows) = 0;
+
+  /**
+   *  @name   CloseImpl
+   *  @fn     virtual Status CloseImpl(void) = 0
+   *  @brief  Codec specific finalization
+   *  @return Operation status
+   */
+  virtual Status CloseImpl(void) = 0;
+
+  /** Output stream */
+  std::ostream* stream_;
+  /** Image width */
+  size_t width_;
+  /** Image height */
+  size_t height_;
+  /** Image format */
+  Image::Format format_;
+  /** Rows written so far */
+  size_t row_;
+  /** Indicate if an image is being written */
+  bool open_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_IMAGE_WRITER__ */
@@ -35,10 +35,10 @@ class FK_EXPORTS JPEGImage : public Image {
   
   /**
    *  @name JPEGImage
-   *  @fn JPEGImage(void) = default
+   *  @fn JPEGImage(void)
    *  @brief  Constructor
    */
-  JPEGImage(void) = default;
+  JPEGImage(void) : scale_(1), max_dimension_(0) {}
   
   /**
    *  @name JPEGImage
@@ -64,14 +64,18 @@ class FK_EXPORTS JPEGImage : public Image {
    */
   ~JPEGImage(void) override = default;
   
+  /** Expose file based overload hidden by the one below */
+  using Image::LoadInto;
+
   /**
-   *  @name Load
-   *  @fn Status Load(std::istream& stream) override
-   *  @brief  Load image from dist
+   *  @name LoadInto
+   *  @fn Status LoadInto(std::istream& stream, NDArray* dst) override
+   *  @brief  Decode image into a caller provided array
    *  @param[in]  stream  Binary stream from where to load the ressource
+   *  @param[out] dst     Where to decode the pixels
    *  @return Operation status
    */
-  Status Load(std::istream& stream) override;
+  Status LoadInto(std::istream& stream, NDArray* dst) override;
   
   /**
    *  @name Save
@@ -81,6 +85,102 @@ class FK_EXPORTS JPEGImage : public Image {
    *  @return Operation status
    */
   Status Save(std::ostream& stream) const override;
+
+  /**
+   *  @name CreateWriter
+   *  @fn ImageWriter* CreateWriter(void) const override
+   *  @brief  Create a streaming encoder, caller takes ownership
+   *  @return Writer instance
+   */
+  ImageWriter* CreateWriter(void) const override;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   set_scale
+   *  @fn     void set_scale(const size_t& denom)
+   *  @brief  Decode at 1/`denom` of the original resolution using libjpeg's
+   *          DCT scaling, decoding cost drops roughly with `denom`^2.
+   *          Supported values are 1, 2, 4 and 8, others are rounded down.
+   *  @param[in] denom  Downscaling factor
+   */
+  void set_scale(const size_t& denom) {
+    scale_ = denom;
+  }
+
+  /**
+   *  @name   scale
+   *  @fn     const size_t& scale(void) const
+   *  @brief  Provide downscaling factor
+   */
+  const size_t& scale(void) const {
+    return scale_;
+  }
+
+  /**
+   *  @name   set_max_dimension
+   *  @fn     void set_max_dimension(const size_t& dim)
+   *  @brief  Pick the smallest downscaling factor such that the largest side
+   *          of the decoded image does not exceed `dim` (1/8 at most). Takes
+   *          precedence over `set_scale`, 0 disables it.
+   *  @param[in] dim  Maximum width/height of the decoded image
+   */
+  void set_max_dimension(const size_t& dim) {
+    max_dimension_ = dim;
+  }
+
+  /**
+   *  @name   max_dimension
+   *  @fn     const size_t& max_dimension(void) const
+   *  @brief  Provide maximum decoded dimension, 0 if disabled
+   */
+  const size_t& max_dimension(void) const {
+    return max_dimension_;
+  }
+  
+  /**
+   *  @name   set_region
+   *  @fn     void set_region(const Region& region)
+   *  @brief  Decode only \p region, given in decoded (i.e. scaled)
+   *          coordinates. Rows above it are skipped without inverse DCT,
+   *          decoding stops after its last row and only the iMCU columns
+   *          covering it are reconstructed (libjpeg-turbo). `ReadHeader`
+   *          still reports the whole image. Empty region decodes everything.
+   *  @param[in] region Rectangle to decode
+   */
+  void set_region(const Region& region) {
+    region_ = region;
+  }
+  
+  /**
+   *  @name   region
+   *  @fn     const Region& region(void) const
+   *  @brief  Provide decoded region, empty if the whole image is decoded
+   */
+  const Region& region(void) const {
+    return region_;
+  }
+
+ protected:
+
+  /**
+   *  @name ParseHeader
+   *  @fn Status ParseHeader(std::istream& stream, ImageInfo* info) override
+   *  @brief  Parse image header without decoding the pixels
+   *  @param[in]  stream  Binary stream from where to read the header
+   *  @param[out] info    Image properties
+   *  @return Operation status
+   */
+  Status ParseHeader(std::istream& stream, ImageInfo* info) override;
+
+ private:
+  /** Downscaling factor */
+  size_t scale_;
+  /** Maximum decoded dimension, 0 if unused */
+  size_t max_dimension_;
+  /** Decoded region, empty for the whole image */
+  Region region_;
 };
 }  // namespace FaceKit
 #endif /* __FACEKIT_JPEG_IMAGE__ */
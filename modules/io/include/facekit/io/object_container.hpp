@@ -0,0 +1,271 @@
+/**
+ *  @file   object_container.hpp
+ *  @brief  Indexed file of serialized objects, a table of content written
+ *          after the objects gives direct access to each of them
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   21.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_OBJECT_CONTAINER__
+#define __FACEKIT_OBJECT_CONTAINER__
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/nd_array.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/io/serializable.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Forward declaration */
+class RandomAccessFile;
+
+/**
+ *  @class  ObjectContainer
+ *  @brief  Read side of an indexed object file. The layout stays compatible
+ *          with the linear one (`ObjectHeader` + payload for each object),
+ *          the table of content being stored as a last object with the
+ *          reserved ID `kTocId`:
+ *
+ *          [Header|Object]...[Header|Entry...|toc size|container size|magic]
+ *
+ *          The table is loaded once by `Open`, afterward every object is
+ *          located in O(1) and read with a single positional read or mapped
+ *          in memory. Files without table of content are indexed by walking
+ *          the object headers once.
+ *  @author Christophe Ecabert
+ *  @date   21.10.18
+ *  @ingroup io
+ */
+class FK_EXPORTS ObjectContainer {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /** Reserved object ID of the table of content */
+  static constexpr size_t kTocId = static_cast<size_t>(-2);
+
+  /**
+   *  @struct Entry
+   *  @brief  Location of an object's payload (i.e. after its header)
+   */
+  struct Entry {
+    /** Object ID */
+    size_t id;
+    /** Payload position relative to the start of the container */
+    size_t offset;
+    /** Payload size in bytes */
+    size_t size;
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name   ObjectContainer
+   *  @fn     ObjectContainer(void)
+   *  @brief  Constructor
+   */
+  ObjectContainer(void);
+
+  /**
+   *  @name   ObjectContainer
+   *  @fn     ObjectContainer(const ObjectContainer& other) = delete
+   *  @brief  Copy constructor
+   */
+  ObjectContainer(const ObjectContainer& other) = delete;
+
+  /**
+   *  @name   operator=
+   *  @fn     ObjectContainer& operator=(const ObjectContainer& rhs) = delete
+   *  @brief  Assignment operator
+   */
+  ObjectContainer& operator=(const ObjectContainer& rhs) = delete;
+
+  /**
+   *  @name   ~ObjectContainer
+   *  @fn     ~ObjectContainer(void)
+   *  @brief  Destructor
+   */
+  ~ObjectContainer(void);
+
+  /**
+   *  @name   Open
+   *  @fn     Status Open(const std::string& path)
+   *  @brief  Open a file through the file system registered for `path` and
+   *          load its table of content
+   *  @param[in] path File to open, can be remote
+   *  @return Operation status
+   */
+  Status Open(const std::string& path);
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   Find
+   *  @fn     Status Find(const size_t& id, Entry* entry) const
+   *  @brief  Locate the first object with a given ID
+   *  @param[in] id     Object ID
+   *  @param[out] entry Object location
+   *  @return kNotFound if no such object
+   */
+  Status Find(const size_t& id, Entry* entry) const;
+
+  /**
+   *  @name   Read
+   *  @fn     Status Read(const size_t& id, NDArray* section) const
+   *  @brief  Read the payload of an object in a single request
+   *  @param[in] id       Object ID
+   *  @param[out] section `kUInt8` array holding the payload, keeps its
+   *                      allocator
+   *  @return Operation status
+   */
+  Status Read(const size_t& id, NDArray* section) const;
+
+  /**
+   *  @name   Map
+   *  @fn     Status Map(const size_t& id, NDArray* section) const
+   *  @brief  Map the payload of an object in memory, pages are loaded on
+   *          demand. Falls back to `Read` for file systems without mapping
+   *          support (i.e. remote files).
+   *  @param[in] id       Object ID
+   *  @param[out] section Read-only `kUInt8` array over the payload
+   *  @return Operation status
+   */
+  Status Map(const size_t& id, NDArray* section) const;
+
+  /**
+   *  @name   Load
+   *  @fn     Status Load(const size_t& id, Serializable* object) const
+   *  @brief  Deserialize an object from its payload
+   *  @param[in] id       Object ID
+   *  @param[out] object  Object to load
+   *  @return Operation status
+   */
+  Status Load(const size_t& id, Serializable* object) const;
+
+  /**
+   *  @name   ReadToc
+   *  @fn     static Status ReadToc(std::istream& stream, size_t* base,
+                                    std::vector<Entry>* entries)
+   *  @brief  Read the table of content of a container stored at the end of
+   *          a seekable stream. The stream position is restored.
+   *  @param[in] stream   Binary stream
+   *  @param[out] base    Position of the container's start in `stream`
+   *  @param[out] entries Table of content
+   *  @return kNotFound if the stream has no table of content
+   */
+  static Status ReadToc(std::istream& stream,
+                        size_t* base,
+                        std::vector<Entry>* entries);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   entries
+   *  @fn     const std::vector<Entry>& entries(void) const
+   *  @brief  Provide every object in file order
+   */
+  const std::vector<Entry>& entries(void) const {
+    return entries_;
+  }
+
+  /**
+   *  @name   indexed
+   *  @fn     bool indexed(void) const
+   *  @brief  Indicate if the file has a table of content
+   */
+  bool indexed(void) const {
+    return indexed_;
+  }
+
+ private:
+  /** File path */
+  std::string path_;
+  /** Opened file */
+  std::unique_ptr<RandomAccessFile> file_;
+  /** Position of the container's start in the file */
+  size_t base_;
+  /** Objects in file order */
+  std::vector<Entry> entries_;
+  /** ID -> position in `entries_` of its first occurrence */
+  std::unordered_map<size_t, size_t> index_;
+  /** Table of content present */
+  bool indexed_;
+};
+
+/**
+ *  @class  ObjectContainerWriter
+ *  @brief  Write side of an indexed object file, see `ObjectContainer`
+ *  @author Christophe Ecabert
+ *  @date   21.10.18
+ *  @ingroup io
+ */
+class FK_EXPORTS ObjectContainerWriter {
+ public:
+
+  /**
+   *  @name   ObjectContainerWriter
+   *  @fn     explicit ObjectContainerWriter(std::ostream* stream)
+   *  @brief  Constructor, the container starts at the current position
+   *  @param[in] stream Seekable binary stream, must outlive the writer
+   */
+  explicit ObjectContainerWriter(std::ostream* stream);
+
+  /**
+   *  @name   Add
+   *  @fn     Status Add(const size_t& id, const Serializable& object)
+   *  @brief  Append an object
+   *  @param[in] id     Object ID
+   *  @param[in] object Object to serialize
+   *  @return Operation status
+   */
+  Status Add(const size_t& id, const Serializable& object);
+
+  /**
+   *  @name   Add
+   *  @fn     Status Add(const std::string& classname,
+                         const Serializable& object)
+   *  @brief  Append an object registered in the `ObjectManager`
+   *  @param[in] classname  Object's class name
+   *  @param[in] object     Object to serialize
+   *  @return kNotFound if `classname` is not registered
+   */
+  Status Add(const std::string& classname, const Serializable& object);
+
+  /**
+   *  @name   Close
+   *  @fn     Status Close(void)
+   *  @brief  Write the table of content, no object can be added afterward
+   *  @return Operation status
+   */
+  Status Close(void);
+
+ private:
+  /** Output */
+  std::ostream* stream_;
+  /** Start of the container */
+  std::streampos base_;
+  /** Objects written so far */
+  std::vector<ObjectContainer::Entry> entries_;
+  /** Table of content written */
+  bool closed_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_OBJECT_CONTAINER__ */
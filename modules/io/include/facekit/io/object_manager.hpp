@@ -13,6 +13,10 @@
 #ifndef __FACEKIT_OBJECT_MANAGER__
 #define __FACEKIT_OBJECT_MANAGER__
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 #include <unordered_map>
 
@@ -31,6 +35,13 @@ namespace FaceKit {
  *  @brief  Gather all object's suporting read/write to file with registration
  *          mechanism. The purpose is to be able to automatically generate new
  *          unique object IDs.
+ *          Registration only appends the proxy to a constant-initialized
+ *          array, it neither allocates nor builds the manager. The lookup
+ *          tables are built lazily by the first query following a
+ *          registration and published as an immutable snapshot, lookups are
+ *          then O(1) and lock-free. Registrations are rare (static
+ *          initialization, plugins) therefore older snapshots are kept alive
+ *          until destruction.
  *  @author Christophe Ecabert
  *  @date   24.09.17
  *  @ingroup io
@@ -92,19 +103,23 @@ class FK_EXPORTS ObjectManager {
 #pragma mark -
 #pragma mark Usage
   
+  /** Maximum number of registered objects */
+  static constexpr size_t kMaxObject = 256;
+
   /**
    *  @name Register
-   *  @fn void Register(const ObjectProxy* proxy)
+   *  @fn static void Register(const ObjectProxy* proxy)
    *  @brief  Add new entry in the manager
-   *  @param[in]  proxy New proxy to register with this manager
-   *  @throw  FaceKit::FKError if ID already registered.
+   *  @param[in]  proxy New proxy to register with this manager, must outlive
+   *                    the manager
+   *  @throw  FaceKit::FKError if ID already registered or too many objects.
    */
-  void Register(const ObjectProxy* proxy);
+  static void Register(const ObjectProxy* proxy);
   
   /**
    *  @name GetId
    *  @fn size_t GetId(const std::string& classname) const
-   *  @brief  Retrive the Id of a given class name
+   *  @brief  Retrive the Id of a given class name, lock-free
    *  @param[in]  classname Class name to query
    *  @return Object's ID, if none matching class if founded ID=MAX(size_t)
    */
@@ -112,26 +127,49 @@ class FK_EXPORTS ObjectManager {
   
   /**
    *  @name GetName
-   *  @fn std::string GetName(const size_t id) const
-   *  @brief  Retrive the name of a given class ID
+   *  @fn const std::string& GetName(const size_t id) const
+   *  @brief  Retrive the name of a given class ID, lock-free
    *  @param[in]  id Object's ID to query
    *  @return Object's name, or empty if unknown ID.
    */
-  std::string GetName(const size_t id) const;
+  const std::string& GetName(const size_t id) const;
   
  private:
+
+  /**
+   *  @struct Registry
+   *  @brief  Immutable snapshot of the registered objects
+   */
+  struct Registry {
+    /** Number of proxies included */
+    size_t n_proxy = 0;
+    /** Class name -> ID */
+    std::unordered_map<std::string, size_t> ids;
+    /** ID -> class name */
+    std::unordered_map<size_t, std::string> names;
+  };
   
   /**
    *  @name ObjectManager
    *  @fn ObjectManager(void)
    *  @brief  Constructor
    */
-  ObjectManager(void) = default;
-  
-  /** Registered proxies */
-  std::vector<const ObjectProxy*> proxies_;
-  /** Look up table for already registered proxies */
-  std::unordered_map<std::string, size_t> id_table_;
+  ObjectManager(void);
+
+  /**
+   *  @name Snapshot
+   *  @fn const Registry* Snapshot(void) const
+   *  @brief  Current tables, rebuilt if objects have been registered since
+   *          the last query
+   */
+  const Registry* Snapshot(void) const;
+  
+  /** Current snapshot, read without lock */
+  mutable std::atomic<const Registry*> registry_;
+  /** Every snapshot published so far, owns them */
+  mutable std::vector<std::unique_ptr<const Registry>> snapshots_;
+  /** Serialize snapshot updates */
+  mutable std::mutex lock_;
 };
 
 }  // namespace FaceKit
@@ -9,7 +9,7 @@
  *  Copyright © 2017 Christophe Ecabert. All rights reserved.
  */
 
-#include <string>
+#include <cstddef>
 
 #ifndef __FACEKIT_OBJECT_PROXY__
 #define __FACEKIT_OBJECT_PROXY__
@@ -33,12 +33,13 @@ class ObjectProxy {
   
   /**
    *  @name ObjectProxy
-   *  @fn ObjectProxy(const std::string& classname, const size_t id)
+   *  @fn ObjectProxy(const char* classname, const size_t id)
    *  @brief  Constructor
-   *  @param[in]  classname  Class name to be represented by this proxy
+   *  @param[in]  classname  Class name to be represented by this proxy, must
+   *                         outlive the proxy (i.e. string literal)
    *  @param[in]  id          Object's unique ID
    */
-  ObjectProxy(const std::string& classname, const size_t id);
+  ObjectProxy(const char* classname, const size_t id);
   
   /**
    *  @name ~ObjectProxy
@@ -49,11 +50,11 @@ class ObjectProxy {
   
   /**
    *  @name get_class_name
-   *  @fn const std::string& get_classname(void) const 
+   *  @fn const char* get_classname(void) const
    *  @brief  Provide the name of the class represented by this proxy
    *  @return Class name
    */
-  const std::string& get_classname(void) const {
+  const char* get_classname(void) const {
     return classname_;
   }
   
@@ -69,7 +70,7 @@ class ObjectProxy {
   
  private:
   /** Class represented by this proxy */
-  std::string classname_;
+  const char* classname_;
   /** Object ID */
   size_t id_;
 };
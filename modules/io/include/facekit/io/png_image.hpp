@@ -66,14 +66,18 @@ class FK_EXPORTS PNGImage : public Image {
    */
   ~PNGImage(void) override = default;
   
+  /** Expose file based overload hidden by the one below */
+  using Image::LoadInto;
+
   /**
-   *  @name Load
-   *  @fn Status Load(std::istream& stream) override
-   *  @brief  Load image from dist
+   *  @name LoadInto
+   *  @fn Status LoadInto(std::istream& stream, NDArray* dst) override
+   *  @brief  Decode image into a caller provided array
    *  @param[in]  stream  Binary stream from where to load the ressource
+   *  @param[out] dst     Where to decode the pixels
    *  @return Operation status
    */
-  Status Load(std::istream& stream) override;
+  Status LoadInto(std::istream& stream, NDArray* dst) override;
   
   /**
    *  @name Save
@@ -83,6 +87,55 @@ class FK_EXPORTS PNGImage : public Image {
    *  @return Operation status
    */
   Status Save(std::ostream& stream) const override;
+
+  /**
+   *  @name CreateWriter
+   *  @fn ImageWriter* CreateWriter(void) const override
+   *  @brief  Create a streaming encoder, caller takes ownership
+   *  @return Writer instance
+   */
+  ImageWriter* CreateWriter(void) const override;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   set_region
+   *  @fn     void set_region(const Region& region)
+   *  @brief  Decode only \p region. Rows are inflated up to its last one
+   *          only, the remaining of the stream is never read (non interlaced
+   *          images). `ReadHeader` still reports the whole image. Empty
+   *          region decodes everything.
+   *  @param[in] region Rectangle to decode
+   */
+  void set_region(const Region& region) {
+    region_ = region;
+  }
+
+  /**
+   *  @name   region
+   *  @fn     const Region& region(void) const
+   *  @brief  Provide decoded region, empty if the whole image is decoded
+   */
+  const Region& region(void) const {
+    return region_;
+  }
+
+ protected:
+
+  /**
+   *  @name ParseHeader
+   *  @fn Status ParseHeader(std::istream& stream, ImageInfo* info) override
+   *  @brief  Parse image header without decoding the pixels
+   *  @param[in]  stream  Binary stream from where to read the header
+   *  @param[out] info    Image properties
+   *  @return Operation status
+   */
+  Status ParseHeader(std::istream& stream, ImageInfo* info) override;
+
+ private:
+  /** Decoded region, empty for the whole image */
+  Region region_;
 };
   
   
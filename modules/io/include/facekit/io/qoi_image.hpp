@@ -0,0 +1,115 @@
+/**
+ *  @file   qoi_image.hpp
+ *  @brief QOI Image object
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   20.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_QOI_IMAGE__
+#define __FACEKIT_QOI_IMAGE__
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/io/image.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  QOIImage
+ *  @brief  QOI ("Quite OK Image") object, lossless format encoded and decoded
+ *          in a single pass, much faster than PNG for intermediate data.
+ *          Grayscale images are stored as RGB since the format has no gray
+ *          layout, they are therefore loaded back as `kRGB`.
+ *  @author Christophe Ecabert
+ *  @date   20.10.18
+ *  @ingroup io
+ *  @see https://qoiformat.org/qoi-specification.pdf
+ */
+class FK_EXPORTS QOIImage : public Image {
+ public:
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name QOIImage
+   *  @fn QOIImage(void) = default
+   *  @brief  Constructor
+   */
+  QOIImage(void) = default;
+
+  /**
+   *  @name QOIImage
+   *  @fn QOIImage(const QOIImage& other) = delete
+   *  @brief  Copy Constructor
+   *  @param[in]  other Object to copy
+   */
+  QOIImage(const QOIImage& other) = delete;
+
+  /**
+   *  @name operator=
+   *  @fn QOIImage& operator=(const QOIImage& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in]  rhs Object to assign form
+   *  @return Newly assign object
+   */
+  QOIImage& operator=(const QOIImage& rhs) = delete;
+
+  /**
+   *  @name ~QOIImage
+   *  @fn ~QOIImage(void) override = default
+   *  @brief  Destructor
+   */
+  ~QOIImage(void) override = default;
+
+  /** Expose file based overload hidden by the one below */
+  using Image::LoadInto;
+
+  /**
+   *  @name LoadInto
+   *  @fn Status LoadInto(std::istream& stream, NDArray* dst) override
+   *  @brief  Decode image into a caller provided array
+   *  @param[in]  stream  Binary stream from where to load the ressource
+   *  @param[out] dst     Where to decode the pixels
+   *  @return Operation status
+   */
+  Status LoadInto(std::istream& stream, NDArray* dst) override;
+
+  /**
+   *  @name Save
+   *  @fn Status Save(std::ostream& stream) const override
+   *  @brief  Save image into a given stream
+   *  @param[in]  stream  Binary stream to where to save the ressource
+   *  @return Operation status
+   */
+  Status Save(std::ostream& stream) const override;
+
+  /**
+   *  @name CreateWriter
+   *  @fn ImageWriter* CreateWriter(void) const override
+   *  @brief  Create a streaming encoder, caller takes ownership
+   *  @return Writer instance
+   */
+  ImageWriter* CreateWriter(void) const override;
+
+ protected:
+
+  /**
+   *  @name ParseHeader
+   *  @fn Status ParseHeader(std::istream& stream, ImageInfo* info) override
+   *  @brief  Parse image header without decoding the pixels
+   *  @param[in]  stream  Binary stream from where to read the header
+   *  @param[out] info    Image properties
+   *  @return Operation status
+   */
+  Status ParseHeader(std::istream& stream, ImageInfo* info) override;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_QOI_IMAGE__ */
@@ -0,0 +1,260 @@
+/**
+ *  @file   record_file.hpp
+ *  @brief  Sharded files of length-prefixed records protected by CRC, used
+ *          to pack millions of small samples into a few large files
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   25.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_RECORD_FILE__
+#define __FACEKIT_RECORD_FILE__
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Forward declaration */
+class RandomAccessFile;
+
+/**
+ *  @class  RecordWriter
+ *  @brief  Append records to shards named `<prefix>-00000.fkrec`,
+ *          `<prefix>-00001.fkrec`, ... A new shard is started once the
+ *          current one would exceed the shard size. Each record is stored
+ *          as:
+ *
+ *          [u64 length|u32 crc(length)|payload|u32 crc(payload)]
+ *
+ *          with masked CRC-32 checksums.
+ *  @author Christophe Ecabert
+ *  @date   25.10.18
+ *  @ingroup io
+ */
+class FK_EXPORTS RecordWriter {
+ public:
+
+  /**
+   *  @struct Options
+   *  @brief  Writer configuration
+   */
+  struct Options {
+    /** Maximum shard size in bytes, a single larger record gets its own
+     shard */
+    size_t shard_size = size_t(256) << 20;
+  };
+
+  /**
+   *  @name   RecordWriter
+   *  @fn     RecordWriter(void)
+   *  @brief  Constructor
+   */
+  RecordWriter(void);
+
+  /**
+   *  @name   ~RecordWriter
+   *  @fn     ~RecordWriter(void)
+   *  @brief  Destructor, close the current shard
+   */
+  ~RecordWriter(void);
+
+  /**
+   *  @name   Open
+   *  @fn     Status Open(const std::string& prefix, const Options& options)
+   *  @brief  Start a new set of shards, the first one is created with the
+   *          first record
+   *  @param[in] prefix   Shard path prefix (i.e. `/data/train`)
+   *  @param[in] options  Configuration
+   *  @return Operation status
+   */
+  Status Open(const std::string& prefix, const Options& options);
+
+  /**
+   *  @name   Write
+   *  @fn     Status Write(const void* data, const size_t& n)
+   *  @brief  Append a record
+   *  @param[in] data Record content
+   *  @param[in] n    Record size in bytes
+   *  @return Operation status
+   */
+  Status Write(const void* data, const size_t& n);
+
+  /**
+   *  @name   Write
+   *  @fn     Status Write(const std::string& record)
+   *  @brief  Append a record
+   *  @param[in] record Record content
+   *  @return Operation status
+   */
+  Status Write(const std::string& record) {
+    return this->Write(record.data(), record.size());
+  }
+
+  /**
+   *  @name   Close
+   *  @fn     Status Close(void)
+   *  @brief  Flush and close the current shard
+   *  @return Operation status
+   */
+  Status Close(void);
+
+  /**
+   *  @name   shards
+   *  @fn     const std::vector<std::string>& shards(void) const
+   *  @brief  Shards written so far
+   */
+  const std::vector<std::string>& shards(void) const {
+    return shards_;
+  }
+
+ private:
+  /**
+   *  @name   NextShard
+   *  @fn     Status NextShard(void)
+   *  @brief  Close the current shard and open the next one
+   */
+  Status NextShard(void);
+
+  /** Path prefix */
+  std::string prefix_;
+  /** Configuration */
+  Options options_;
+  /** Current shard */
+  std::ofstream stream_;
+  /** Bytes in the current shard */
+  size_t shard_size_;
+  /** Shards */
+  std::vector<std::string> shards_;
+};
+
+/**
+ *  @class  RecordReader
+ *  @brief  Stream records out of a list of shards written by
+ *          `RecordWriter`. Shards are read sequentially with large requests
+ *          through the registered file systems (remote storage included).
+ *          Records can be shuffled across shards: shard order is permuted,
+ *          several shards are interleaved and records go through a shuffle
+ *          buffer.
+ *  @author Christophe Ecabert
+ *  @date   25.10.18
+ *  @ingroup io
+ */
+class FK_EXPORTS RecordReader {
+ public:
+
+  /**
+   *  @struct Options
+   *  @brief  Reader configuration
+   */
+  struct Options {
+    /** Size of each read request in bytes */
+    size_t buffer_size = size_t(4) << 20;
+    /** Permute shard order */
+    bool shuffle_shards = false;
+    /** Number of shards read in a round-robin fashion */
+    size_t n_interleave = 1;
+    /** Number of records drawn from at random, 0 keeps the file order */
+    size_t shuffle_buffer = 0;
+    /** Seed of the shuffling */
+    uint64_t seed = 0;
+    /** Verify checksums */
+    bool verify_checksum = true;
+  };
+
+  /**
+   *  @name   ListShards
+   *  @fn     static Status ListShards(const std::string& prefix,
+                                       std::vector<std::string>* shards)
+   *  @brief  Find the shards written with a given prefix, sorted by index
+   *  @param[in] prefix   Shard path prefix
+   *  @param[out] shards  Shard paths
+   *  @return kNotFound if there is none
+   */
+  static Status ListShards(const std::string& prefix,
+                           std::vector<std::string>* shards);
+
+  /**
+   *  @name   RecordReader
+   *  @fn     RecordReader(void)
+   *  @brief  Constructor
+   */
+  RecordReader(void);
+
+  /**
+   *  @name   ~RecordReader
+   *  @fn     ~RecordReader(void)
+   *  @brief  Destructor
+   */
+  ~RecordReader(void);
+
+  /**
+   *  @name   Open
+   *  @fn     Status Open(const std::vector<std::string>& shards,
+                          const Options& options)
+   *  @brief  Start reading a list of shards
+   *  @param[in] shards   Shard paths
+   *  @param[in] options  Configuration
+   *  @return Operation status
+   */
+  Status Open(const std::vector<std::string>& shards, const Options& options);
+
+  /**
+   *  @name   Next
+   *  @fn     Status Next(std::string* record)
+   *  @brief  Read the next record
+   *  @param[out] record  Record content
+   *  @return kOutOfRange once every record has been read, kInternalError
+   *          for corrupted records
+   */
+  Status Next(std::string* record);
+
+ private:
+  /** Opened shard */
+  struct Shard;
+
+  /**
+   *  @name   ReadRecord
+   *  @fn     Status ReadRecord(std::string* record)
+   *  @brief  Read the next record in file order (interleaved shards)
+   */
+  Status ReadRecord(std::string* record);
+
+  /**
+   *  @name   OpenNextShard
+   *  @fn     Status OpenNextShard(std::unique_ptr<Shard>* shard)
+   *  @brief  Open the next shard in the list, nullptr when there is none
+   */
+  Status OpenNextShard(std::unique_ptr<Shard>* shard);
+
+  /** Shards to read */
+  std::vector<std::string> paths_;
+  /** Next shard to open */
+  size_t next_;
+  /** Shards being read */
+  std::vector<std::unique_ptr<Shard>> active_;
+  /** Round-robin position */
+  size_t cursor_;
+  /** Shuffle buffer */
+  std::vector<std::string> pool_;
+  /** Random generator */
+  std::mt19937_64 rng_;
+  /** Configuration */
+  Options options_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_RECORD_FILE__ */
@@ -0,0 +1,232 @@
+/**
+ *  @file   section.hpp
+ *  @brief  Versioned layout of serialized objects made of tagged sections
+ *          listed in a table, readers only decode the sections they need
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   23.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_SECTION__
+#define __FACEKIT_SECTION__
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @struct Section
+ *  @brief  Entry of the section table
+ *  @ingroup io
+ */
+struct Section {
+  /** Section tag, unique within an object */
+  uint32_t tag;
+  /** Payload position relative to the start of the object */
+  uint64_t offset;
+  /** Payload size in bytes */
+  uint64_t size;
+};
+
+/**
+ *  @class  SectionWriter
+ *  @brief  Write an object as a table of sections followed by their
+ *          payloads:
+ *
+ *          [magic|version|n|(tag, reserved, offset, size)...|payload...]
+ *
+ *          Payloads start on `kAlignment` bytes boundaries of the stream so
+ *          they can be mapped in memory. Object size is derived from the
+ *          declared sections, nothing has to be maintained by hand.
+ *  @author Christophe Ecabert
+ *  @date   23.10.18
+ *  @ingroup io
+ */
+class FK_EXPORTS SectionWriter {
+ public:
+
+  /** Function writing a section payload */
+  using Callback = std::function<int(std::ostream&)>;
+
+  /** Payload alignment */
+  static constexpr size_t kAlignment = 64;
+
+  /**
+   *  @name   SectionWriter
+   *  @fn     explicit SectionWriter(const uint16_t& version)
+   *  @brief  Constructor
+   *  @param[in] version  Object's schema version, stored for the readers
+   */
+  explicit SectionWriter(const uint16_t& version);
+
+  /**
+   *  @name   Add
+   *  @fn     void Add(const uint32_t& tag, const size_t& size,
+                       const Callback& callback)
+   *  @brief  Declare a section
+   *  @param[in] tag      Section tag
+   *  @param[in] size     Number of bytes `callback` writes
+   *  @param[in] callback Write the payload, returns 0 on success
+   */
+  void Add(const uint32_t& tag, const size_t& size, const Callback& callback);
+
+  /**
+   *  @name   Add
+   *  @fn     void Add(const uint32_t& tag, const void* data,
+                       const size_t& size)
+   *  @brief  Declare a section holding raw bytes
+   *  @param[in] tag  Section tag
+   *  @param[in] data Payload, must stay valid until `Write` returns
+   *  @param[in] size Payload size in bytes
+   */
+  void Add(const uint32_t& tag, const void* data, const size_t& size);
+
+  /**
+   *  @name   Write
+   *  @fn     int Write(std::ostream& stream) const
+   *  @brief  Write the table and every section
+   *  @param[in] stream Binary stream
+   *  @return -1 if error (i.e. a callback did not write its declared size),
+   *          0 otherwise
+   */
+  int Write(std::ostream& stream) const;
+
+  /**
+   *  @name   Size
+   *  @fn     size_t Size(void) const
+   *  @brief  Object size in bytes, upper bound since the alignment padding
+   *          depends on the stream position
+   *  @return Object size
+   */
+  size_t Size(void) const;
+
+ private:
+  /** Schema version */
+  uint16_t version_;
+  /** Declared sections */
+  std::vector<Section> sections_;
+  /** Payload writers */
+  std::vector<Callback> callbacks_;
+};
+
+/**
+ *  @class  SectionReader
+ *  @brief  Read the table of an object written by `SectionWriter` and give
+ *          access to its sections in any order, skipped sections are never
+ *          read. The stream must be seekable.
+ *  @author Christophe Ecabert
+ *  @date   23.10.18
+ *  @ingroup io
+ */
+class FK_EXPORTS SectionReader {
+ public:
+
+  /**
+   *  @name   SectionReader
+   *  @fn     SectionReader(void)
+   *  @brief  Constructor
+   */
+  SectionReader(void);
+
+  /**
+   *  @name   IsSectioned
+   *  @fn     static bool IsSectioned(std::istream& stream)
+   *  @brief  Check if the stream is positioned at an object written by
+   *          `SectionWriter`, the position is left unchanged
+   *  @param[in] stream Binary stream
+   *  @return True if the magic number matches
+   */
+  static bool IsSectioned(std::istream& stream);
+
+  /**
+   *  @name   Open
+   *  @fn     Status Open(std::istream* stream)
+   *  @brief  Read the section table, the stream is left after it
+   *  @param[in] stream Binary stream positioned at the object, must outlive
+   *                    the reader
+   *  @return kNotFound if the object is not sectioned
+   */
+  Status Open(std::istream* stream);
+
+  /**
+   *  @name   Find
+   *  @fn     const Section* Find(const uint32_t& tag) const
+   *  @brief  Look for a section
+   *  @param[in] tag  Section tag
+   *  @return Section or nullptr if absent
+   */
+  const Section* Find(const uint32_t& tag) const;
+
+  /**
+   *  @name   Seek
+   *  @fn     Status Seek(const uint32_t& tag, size_t* size = nullptr)
+   *  @brief  Move the stream to the payload of a section
+   *  @param[in] tag    Section tag
+   *  @param[out] size  Optional payload size
+   *  @return kNotFound if absent
+   */
+  Status Seek(const uint32_t& tag, size_t* size = nullptr);
+
+  /**
+   *  @name   Read
+   *  @fn     Status Read(const uint32_t& tag, void* data, const size_t& size)
+   *  @brief  Read a raw section
+   *  @param[in] tag    Section tag
+   *  @param[out] data  Buffer
+   *  @param[in] size   Expected payload size in bytes
+   *  @return kNotFound if absent, kInvalidArgument if the size differs
+   */
+  Status Read(const uint32_t& tag, void* data, const size_t& size);
+
+  /**
+   *  @name   Finish
+   *  @fn     void Finish(void)
+   *  @brief  Move the stream right after the object
+   */
+  void Finish(void);
+
+  /**
+   *  @name   version
+   *  @fn     uint16_t version(void) const
+   *  @brief  Object's schema version
+   */
+  uint16_t version(void) const {
+    return version_;
+  }
+
+  /**
+   *  @name   start
+   *  @fn     size_t start(void) const
+   *  @brief  Position of the object in the stream
+   */
+  size_t start(void) const {
+    return start_;
+  }
+
+ private:
+  /** Stream */
+  std::istream* stream_;
+  /** Object position */
+  size_t start_;
+  /** Object size */
+  size_t size_;
+  /** Schema version */
+  uint16_t version_;
+  /** Sections */
+  std::vector<Section> sections_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_SECTION__ */
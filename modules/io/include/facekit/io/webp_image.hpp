@@ -0,0 +1,107 @@
+/**
+ *  @file   webp_image.hpp
+ *  @brief WebP Image object
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   20.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_WEBP_IMAGE__
+#define __FACEKIT_WEBP_IMAGE__
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/io/image.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  WebPImage
+ *  @brief  WebP object backed by libwebp, lossy compression for compact
+ *          outputs. Quality is selected with `set_compression_level`
+ *          (default 90). Grayscale images are stored as RGB since the format
+ *          has no gray layout, they are therefore loaded back as `kRGB`.
+ *          Only available when libwebp is found at configure time.
+ *  @author Christophe Ecabert
+ *  @date   20.10.18
+ *  @ingroup io
+ */
+class FK_EXPORTS WebPImage : public Image {
+ public:
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   *  @name WebPImage
+   *  @fn WebPImage(void) = default
+   *  @brief  Constructor
+   */
+  WebPImage(void) = default;
+
+  /**
+   *  @name WebPImage
+   *  @fn WebPImage(const WebPImage& other) = delete
+   *  @brief  Copy Constructor
+   *  @param[in]  other Object to copy
+   */
+  WebPImage(const WebPImage& other) = delete;
+
+  /**
+   *  @name operator=
+   *  @fn WebPImage& operator=(const WebPImage& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in]  rhs Object to assign form
+   *  @return Newly assign object
+   */
+  WebPImage& operator=(const WebPImage& rhs) = delete;
+
+  /**
+   *  @name ~WebPImage
+   *  @fn ~WebPImage(void) override = default
+   *  @brief  Destructor
+   */
+  ~WebPImage(void) override = default;
+
+  /** Expose file based overload hidden by the one below */
+  using Image::LoadInto;
+
+  /**
+   *  @name LoadInto
+   *  @fn Status LoadInto(std::istream& stream, NDArray* dst) override
+   *  @brief  Decode image into a caller provided array
+   *  @param[in]  stream  Binary stream from where to load the ressource
+   *  @param[out] dst     Where to decode the pixels
+   *  @return Operation status
+   */
+  Status LoadInto(std::istream& stream, NDArray* dst) override;
+
+  /**
+   *  @name Save
+   *  @fn Status Save(std::ostream& stream) const override
+   *  @brief  Save image into a given stream
+   *  @param[in]  stream  Binary stream to where to save the ressource
+   *  @return Operation status
+   */
+  Status Save(std::ostream& stream) const override;
+
+ protected:
+
+  /**
+   *  @name ParseHeader
+   *  @fn Status ParseHeader(std::istream& stream, ImageInfo* info) override
+   *  @brief  Parse image header without decoding the pixels
+   *  @param[in]  stream  Binary stream from where to read the header
+   *  @param[out] info    Image properties
+   *  @return Operation status
+   */
+  Status ParseHeader(std::istream& stream, ImageInfo* info) override;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_WEBP_IMAGE__ */
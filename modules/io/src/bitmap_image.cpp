@@ -11,10 +11,12 @@
 #include <iostream>
 #include <algorithm>
 #include <cassert>
+#include <fstream>
 
 #include "facekit/io/bitmap_image.hpp"
 #include "facekit/io/image_factory.hpp"
 #include "facekit/core/logger.hpp"
+#include "pixel_conversion.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -237,6 +239,25 @@ bool IsColorTableGray(const std::vector<uint>& table) {
   return true;
 }
  
+/**
+ *  @name   IsColorTableIdentity
+ *  @fn     bool IsColorTableIdentity(const std::vector<uint32_t>& table)
+ *  @brief  Check if a color table maps every 8 bits index to the same gray
+ *          level, i.e. indices are the pixel values
+ *  @return True if identity, false otherwise
+ */
+bool IsColorTableIdentity(const std::vector<uint32_t>& table) {
+  if (table.size() != 256) {
+    return false;
+  }
+  for (uint32_t k = 0; k < 256; ++k) {
+    if (table[k] != ((k << 16) | (k << 8) | k)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 /**
  *  @name   GenerateGrayColorTable
  *  @fn     void GenerateGrayColorTable(const size_t& bpp, std::vector<uint32_t>* table)
@@ -368,137 +389,6 @@ void BMPHeader::Clear(void) {
   color = false;
 }
   
-/** 3bytes pixel */
-struct Pixel3 {
-  uint8_t b;
-  uint8_t g;
-  uint8_t r;
-  
-  Pixel3(void) = default;
-  Pixel3(uint8_t r, uint8_t g, uint8_t b) : r(r), g(g), b(b) {}
-};
-/** 4bytes pixel */
-struct Pixel4 {
-  uint8_t b;
-  uint8_t g;
-  uint8_t r;
-  uint8_t a;
-  
-  Pixel4(void) = default;
-  Pixel4(uint8_t r, uint8_t g, uint8_t b, uint8_t a) : r(r), g(g), b(b), a(a) {}
-};
-  
-/** Swap B<->R channel */
-struct SwapChannel {
-  Pixel3 operator()(Pixel3 p) const {
-    return Pixel3(p.b, p.g, p.r);
-  }
-  Pixel4 operator()(Pixel4 p) const {
-    return Pixel4(p.b, p.g, p.r, p.a);
-  }
-};
-  
-/** Convert to grayscale */
-struct ConvertToGray {
-#define CV_DESCALE(x, n) (((x) + (1 << ((n) -1))) >> (n))
-  uint8_t operator()(Pixel3 p) const {
-    uint8_t v = (1868 * p.b) + (9617 * p.g) + (4899 * p.r);
-    return CV_DESCALE(v, 14);
-  }
-  uint8_t operator()(Pixel4 p) const {
-    uint8_t v = (1868 * p.b) + (9617 * p.g) + (4899 * p.r);
-    return CV_DESCALE(v, 14);
-  }
-#undef CV_DESCALE
-};
-  
-/**
- *  @def  WRITE_PIXEL
- *  @brief Set pixel value `v` at position `add`
- */
-#define WRITE_PIXEL(add, v)         \
-  add[0] = (v & 0x000000FF);        \
-  add[1] = (v & 0x0000FF00) >> 8;   \
-  add[2] = (v & 0x00FF0000) >> 16
-  
-/**
- *  @name   FillRow4
- *  @brief  Convert Bitmap from index to color table value
- *  @param[in] hdr  Bitmap header
- *  @param[in] width  Image width in pixels
- *  @param[in] idx  List of color table's index (from file)
- *  @param[out] data  Decoded pixel's value
- */
-void FillRow4(const BMPHeader& hdr,
-              const size_t& width,
-              const uint8_t* idx,
-              uint8_t* data) {
-  uint8_t* end = hdr.color ? data + width * 3 : data + width;
-  uint8_t step = hdr.color ? 6 : 2;
-  uint8_t hstep = step / 2;
-  
-  if (hdr.color) {
-    // Color entry
-    while ((data += step) < end) {
-      int cidx = *idx++;
-      *((uint32_t*)(data - step)) = hdr.table[cidx >> 4];
-      *((uint32_t*)(data - hstep)) = hdr.table[cidx & 0x0F];
-    }
-    int cidx = idx[0];  // Add last element of the row
-    *((uint32_t*)(data - step)) = hdr.table[cidx >> 4];
-    if (data == end) {
-      uint8_t* ptr = data - hstep;
-      auto& c = hdr.table[cidx & 0x0F];
-      WRITE_PIXEL(ptr, c);
-    }
-  } else {
-    // Grayscale entry
-    while ((data += step) < end) {
-      int cidx = *idx++;
-      *((uint8_t*)(data - step)) = hdr.table[cidx >> 4] & 0x000000FF;
-      *((uint8_t*)(data - hstep)) = hdr.table[cidx & 0x0F] & 0x000000FF;
-    }
-    int cidx = idx[0];  // Add last element of the row
-    *((uint8_t*)(data - step)) = hdr.table[cidx >> 4] & 0x000000FF;
-    if (data == end) {
-      uint8_t* ptr = data - hstep;
-      *ptr = hdr.table[cidx & 0x0F] & 0x000000FF;
-    }
-  }
-}
-  
-/**
- *  @name   FillRow8
- *  @brief  Convert Bitmap from index to color table value
- *  @param[in] hdr  Bitmap header
- *  @param[in] width  Image width in pixels
- *  @param[in] idx  List of color table's index (from file)
- *  @param[out] data  Decoded pixel's value
- */
-void FillRow8(const BMPHeader& hdr,
-              const size_t& width,
-              const uint8_t* idx,
-              uint8_t* data) {
-  uint8_t* end = hdr.color ? data + width * 3 : data + width;
-  uint8_t step = hdr.color ? 3 : 1;
-  if (hdr.color) {
-    // Color entry
-    while ((data += step) < end) {
-      int cidx = *idx++;
-      *((uint32_t*)(data - step)) = hdr.table[cidx >> 4];
-    }
-    // Add last element of the row
-    uint8_t* ptr = data - step;
-    uint32_t c = hdr.table[idx[0]];
-    WRITE_PIXEL(ptr, c);
-  } else {
-    // Grayscale entry
-    for (size_t k = 0; k < width; ++k) {
-      data[k] = hdr.table[idx[k]] & 0xFF;
-    }
-  }
-}
-  
 #pragma mark -
 #pragma mark Initialization
   
@@ -521,13 +411,14 @@ BMPImage::~BMPImage(void) {
 }
   
 /*
- *  @name Load
- *  @fn Status Load(std::istream& stream) override
- *  @brief  Load image from dist
+ *  @name LoadInto
+ *  @fn Status LoadInto(std::istream& stream, NDArray* dst) override
+ *  @brief  Decode image into a caller provided array
  *  @param[in]  stream  Binary stream from where to load the ressource
+ *  @param[out] dst     Where to decode the pixels
  *  @return Operation status
  */
-Status BMPImage::Load(std::istream& stream) {
+Status BMPImage::LoadInto(std::istream& stream, NDArray* dst) {
   Status status;
   if (stream.good()) {
     // Save stream pos, in order to move to pixel array later on
@@ -544,76 +435,63 @@ Status BMPImage::Load(std::istream& stream) {
                        bpp == 32 ? Format::kRGBA : Format::kRGB  :
                        Format::kGrayscale);
       // Allocate buffer
-      buffer_.Resize(DataType::kUInt8,
-                     {this->height_, this->width_, this->format_});
+      dst->Resize(DataType::kUInt8,
+                  {this->height_, this->width_, this->format_});
       // Move to begining of pixel arry
       auto pa = p + static_cast<std::streamoff>(header_->offset);
       stream.seekg(pa);
       
       // Define some prop
-      int step = (int)(buffer_.dim_size(1) * buffer_.dim_size(2));
+      int step = (int)(dst->dim_size(1) * dst->dim_size(2));
       const size_t src_pitch = (((this->width_ * bpp) + 31) / 32) * 4;
-      auto* ptr = buffer_.AsFlat<uint8_t>().data();
+      auto* ptr = dst->AsFlat<uint8_t>().data();
       if (this->header_->dib.height > 0) {
         // Origin at bottom left
         ptr += (this->height_ - 1) * step;
         step = -step;
       }
-      // Start decoding
-      std::vector<uint8_t> buff(src_pitch);
+      // Start decoding, row buffers are kept per thread to avoid
+      // reallocating them for every image
+      static thread_local std::vector<uint8_t> buff;
+      static thread_local std::vector<uint8_t> indices;
+      buff.resize(src_pitch);
+      const size_t channels = static_cast<size_t>(this->format_);
+      if (bpp <= 8) {
+        // Pad color table so any index in the file is valid
+        if (header_->table.size() < (size_t(1) << bpp)) {
+          header_->table.resize(size_t(1) << bpp, 0);
+        }
+        indices.resize(this->width_);
+      }
+      const uint32_t* table = header_->table.data();
       switch (bpp) {
         // 4 bits per pixel
         case 4: {
-          // Read rows
           for (size_t k = 0; k < this->height_; ++k, ptr += step) {
-            // Read data to buffer
             stream.read(reinterpret_cast<char*>(buff.data()), src_pitch);
-            // Fill
-            FillRow4(*header_, this->width_, buff.data(), ptr);
+            internal::UnpackNibbles(buff.data(), this->width_, indices.data());
+            internal::PaletteLookup(indices.data(), this->width_, table,
+                                    channels, ptr);
           }
         }
           break;
           
         // 8 bits per pixel
         case 8: {
-          // Read rows
           for (size_t k = 0; k < this->height_; ++k, ptr += step) {
-            // Read data to buffer
             stream.read(reinterpret_cast<char*>(buff.data()), src_pitch);
-            // Fill
-            FillRow8(*header_, this->width_, buff.data(), ptr);
+            internal::PaletteLookup(buff.data(), this->width_, table,
+                                    channels, ptr);
           }
         }
           break;
           
-        // 24 bit per pixel
-        case 24: {
-          auto* bptr = reinterpret_cast<Pixel3*>(buff.data());
-          auto bstep = this->width_;
-          for (size_t k = 0; k < this->height_; ++k, ptr += step) {
-            // Read data to buffer
-            stream.read(reinterpret_cast<char*>(buff.data()), src_pitch);
-            // Copy to buffer
-            std::transform(bptr,
-                           bptr + bstep,
-                           reinterpret_cast<Pixel3*>(ptr),
-                           SwapChannel());
-          }
-        }
-          break;
-          
-        // 32bit per pixel
+        // 24 / 32 bits per pixel, BGR(A) -> RGB(A)
+        case 24:
         case 32: {
-          auto* bptr = reinterpret_cast<Pixel3*>(buff.data());
-          auto bstep = this->width_;
           for (size_t k = 0; k < this->height_; ++k, ptr += step) {
-            // Read data to buffer
             stream.read(reinterpret_cast<char*>(buff.data()), src_pitch);
-            // Copy to buffer
-            std::transform(bptr,
-                           bptr + bstep,
-                           reinterpret_cast<Pixel3*>(ptr),
-                           SwapChannel());
+            internal::SwapRedBlue(buff.data(), this->width_, channels, ptr);
           }
         }
           break;
@@ -628,6 +506,88 @@ Status BMPImage::Load(std::istream& stream) {
   return status;
 }
 
+/*
+ *  @name Map
+ *  @fn Status Map(const std::string& filename, const ChannelOrder& order,
+                   NDArray* dst) override
+ *  @brief  Map uncompressed top-down files without padding directly, i.e.
+ *          8 bits grayscale or BGR(A) when `order` is `kBGR`. Other files
+ *          are decoded.
+ *  @param[in]  filename  Path to ressource on the disk
+ *  @param[in]  order     Requested channel order, ignored for grayscale
+ *  @param[out] dst       Pixels
+ *  @return Operation status
+ */
+Status BMPImage::Map(const std::string& filename,
+                     const ChannelOrder& order,
+                     NDArray* dst) {
+  std::ifstream stream(filename.c_str(),
+                       std::ios_base::in | std::ios_base::binary);
+  if (!stream.is_open()) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Can not open: " + filename);
+  }
+  header_->Clear();
+  Status status = header_->Load(stream);
+  if (!status.Good()) {
+    return status;
+  }
+  const DIBHeader& dib = header_->dib;
+  const size_t bpp = static_cast<size_t>(dib.bpp);
+  const size_t width = static_cast<size_t>(std::abs(dib.width));
+  const size_t height = static_cast<size_t>(std::abs(dib.height));
+  // Pixels can be used as is if rows are stored top-down (negative height),
+  // uncompressed and in the requested layout
+  size_t channels = 0;
+  if (dib.comp == DIBHeader::CompType::kRGB && dib.height < 0) {
+    if (bpp == 8 && !header_->color && IsColorTableIdentity(header_->table)) {
+      channels = 1;
+    } else if ((bpp == 24 || bpp == 32) && order == ChannelOrder::kBGR) {
+      channels = bpp / 8;
+    }
+  }
+  // Rows are padded to 4 bytes, a view can not skip the padding
+  const size_t pitch = (((width * bpp) + 31) / 32) * 4;
+  if (channels != 0 && pitch == width * channels) {
+    Status s = dst->MapFile(filename,
+                            DataType::kUInt8,
+                            {height, width, channels},
+                            static_cast<size_t>(header_->offset),
+                            NDArray::MapMode::kCopyOnWrite);
+    if (s.Good()) {
+      this->width_ = width;
+      this->height_ = height;
+      this->format_ = static_cast<Format>(channels);
+      return s;
+    }
+  }
+  return Image::Map(filename, order, dst);
+}
+
+/*
+ *  @name ParseHeader
+ *  @fn Status ParseHeader(std::istream& stream, ImageInfo* info) override
+ *  @brief  Parse image header without decoding the pixels
+ *  @param[in]  stream  Binary stream from where to read the header
+ *  @param[out] info    Image properties
+ *  @return Operation status
+ */
+Status BMPImage::ParseHeader(std::istream& stream, ImageInfo* info) {
+  // Use a local header, the image stays untouched
+  BMPHeader header;
+  header.Clear();
+  Status status = header.Load(stream);
+  if (status.Good()) {
+    const auto bpp = header.dib.bpp;
+    info->width = header.dib.width;
+    info->height = std::abs(header.dib.height);
+    info->format = (header.color ?
+                    bpp == 32 ? Format::kRGBA : Format::kRGB  :
+                    Format::kGrayscale);
+  }
+  return status;
+}
+
 /*
  *  @name Save
  *  @fn Status Save(std::ostream& stream) const override
@@ -685,24 +645,11 @@ Status BMPImage::Save(std::ostream& stream) const {
     auto step = this->width_ * this->format_;
     auto* ptr = this->data();
     ptr += (this->height_ - 1) * step;
+    std::vector<uint8_t> buff(step);
     for (int k = (int)this->height_ - 1; k >= 0; --k, ptr -= step) {
-      std::vector<uint8_t> buff(ptr, ptr + step);
-      if (this->format_ == Format::kGrayscale) {
-        // Grayscale, pixel value is also the color table index, so just copy
-        // one row to the buffer
-        std::copy(ptr, ptr + step, buff.begin());
-      } else {
-        auto* src = buff.data();
-        auto* dst = &src[2];
-        uint8_t tmp;
-        for (size_t n = 0; n < this->width_; ++n) {
-          tmp = *src;
-          *src = *dst;
-          *dst = tmp;
-          src += this->format_;
-          dst += this->format_;
-        }
-      }
+      // Grayscale pixel value is also the color table index and is copied
+      // as is, color is converted to BGR(A)
+      internal::SwapRedBlue(ptr, this->width_, this->format_, buff.data());
       // Write
       stream.write(reinterpret_cast<const char*>(buff.data()), step);
       // Add padding ?
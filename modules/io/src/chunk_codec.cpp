@@ -0,0 +1,466 @@
+/**
+ *  @file   chunk_codec.cpp
+ *  @brief  Private chunked compression of raw buffers used by the matrix
+ *          serialization. Chunks are filtered and compressed independently
+ *          so they can be processed in parallel.
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   22.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+
+#include "zlib.h"
+#ifdef FACEKIT_HAS_ZSTD
+#include "zstd.h"
+#endif
+#ifdef FACEKIT_HAS_LZ4
+#include "lz4.h"
+#endif
+
+#include "chunk_codec.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/trace.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+namespace internal {
+
+#pragma mark -
+#pragma mark Filters
+
+/**
+ *  @name   DeltaEncode
+ *  @fn     static void DeltaEncode(uint8_t* data, const size_t& n)
+ *  @brief  Replace each element by its difference with the previous one,
+ *          computed on the unsigned integer of the same width (i.e. bit
+ *          pattern of floats) so it is exactly reversible
+ *  @param[in,out] data Elements
+ *  @param[in] n        Number of elements
+ *  @tparam T Unsigned integer of element width
+ */
+template<typename T>
+static void DeltaEncode(uint8_t* data, const size_t& n) {
+  T prev = 0;
+  for (size_t i = 0; i < n; ++i) {
+    T v;
+    std::memcpy(&v, data + i * sizeof(T), sizeof(T));
+    const T d = static_cast<T>(v - prev);
+    std::memcpy(data + i * sizeof(T), &d, sizeof(T));
+    prev = v;
+  }
+}
+
+/**
+ *  @name   DeltaDecode
+ *  @fn     static void DeltaDecode(uint8_t* data, const size_t& n)
+ *  @brief  Reverse `DeltaEncode`
+ *  @param[in,out] data Elements
+ *  @param[in] n        Number of elements
+ *  @tparam T Unsigned integer of element width
+ */
+template<typename T>
+static void DeltaDecode(uint8_t* data, const size_t& n) {
+  T prev = 0;
+  for (size_t i = 0; i < n; ++i) {
+    T d;
+    std::memcpy(&d, data + i * sizeof(T), sizeof(T));
+    prev = static_cast<T>(prev + d);
+    std::memcpy(data + i * sizeof(T), &prev, sizeof(T));
+  }
+}
+
+/**
+ *  @name   Delta
+ *  @fn     static void Delta(uint8_t* data, const size_t& n,
+                              const size_t& elem_size, const bool& encode)
+ *  @brief  Dispatch delta filter on element width
+ *  @param[in,out] data   Buffer
+ *  @param[in] n          Buffer size in bytes
+ *  @param[in] elem_size  Element size in bytes
+ *  @param[in] encode     True to encode, false to decode
+ */
+static void Delta(uint8_t* data,
+                  const size_t& n,
+                  const size_t& elem_size,
+                  const bool& encode) {
+  const size_t n_elem = n / elem_size;
+  switch (elem_size) {
+    case 1: encode ?
+            DeltaEncode<uint8_t>(data, n_elem) :
+            DeltaDecode<uint8_t>(data, n_elem);
+      break;
+    case 2: encode ?
+            DeltaEncode<uint16_t>(data, n_elem) :
+            DeltaDecode<uint16_t>(data, n_elem);
+      break;
+    case 4: encode ?
+            DeltaEncode<uint32_t>(data, n_elem) :
+            DeltaDecode<uint32_t>(data, n_elem);
+      break;
+    default: encode ?
+             DeltaEncode<uint64_t>(data, n_elem) :
+             DeltaDecode<uint64_t>(data, n_elem);
+      break;
+  }
+}
+
+/**
+ *  @name   Shuffle
+ *  @fn     static void Shuffle(const uint8_t* src, const size_t& n,
+                                const size_t& elem_size, uint8_t* dst)
+ *  @brief  Group the k-th byte of every element together. Exponents and
+ *          high bytes of floats end up in long, similar runs.
+ *  @param[in] src        Elements
+ *  @param[in] n          Buffer size in bytes
+ *  @param[in] elem_size  Element size in bytes
+ *  @param[out] dst       Shuffled bytes, must not overlap `src`
+ */
+static void Shuffle(const uint8_t* src,
+                    const size_t& n,
+                    const size_t& elem_size,
+                    uint8_t* dst) {
+  const size_t n_elem = n / elem_size;
+  for (size_t b = 0; b < elem_size; ++b) {
+    uint8_t* d = dst + b * n_elem;
+    const uint8_t* s = src + b;
+    for (size_t i = 0; i < n_elem; ++i, s += elem_size) {
+      d[i] = *s;
+    }
+  }
+}
+
+/**
+ *  @name   Unshuffle
+ *  @fn     static void Unshuffle(const uint8_t* src, const size_t& n,
+                                  const size_t& elem_size, uint8_t* dst)
+ *  @brief  Reverse `Shuffle`
+ *  @param[in] src        Shuffled bytes
+ *  @param[in] n          Buffer size in bytes
+ *  @param[in] elem_size  Element size in bytes
+ *  @param[out] dst       Elements, must not overlap `src`
+ */
+static void Unshuffle(const uint8_t* src,
+                      const size_t& n,
+                      const size_t& elem_size,
+                      uint8_t* dst) {
+  const size_t n_elem = n / elem_size;
+  for (size_t b = 0; b < elem_size; ++b) {
+    const uint8_t* s = src + b * n_elem;
+    uint8_t* d = dst + b;
+    for (size_t i = 0; i < n_elem; ++i, d += elem_size) {
+      *d = s[i];
+    }
+  }
+}
+
+#pragma mark -
+#pragma mark Codecs
+
+/**
+ *  @name   Compress
+ *  @fn     static size_t Compress(const uint8_t& codec, const int& level,
+                                   const uint8_t* src, const size_t& n,
+                                   std::vector<uint8_t>* dst)
+ *  @brief  Compress a chunk
+ *  @param[in] codec  Codec
+ *  @param[in] level  Compression level, negative for default
+ *  @param[in] src    Chunk
+ *  @param[in] n      Chunk size in bytes
+ *  @param[out] dst   Compressed chunk, resized to its bound
+ *  @return Compressed size, 0 if the chunk can not be compressed
+ */
+static size_t Compress(const uint8_t& codec,
+                       const int& level,
+                       const uint8_t* src,
+                       const size_t& n,
+                       std::vector<uint8_t>* dst) {
+  switch (codec) {
+    case kChunkCodecZlib: {
+      uLongf len = compressBound(static_cast<uLong>(n));
+      dst->resize(len);
+      const int lvl = level < 0 ? Z_DEFAULT_COMPRESSION : std::min(level, 9);
+      return compress2(dst->data(), &len, src, static_cast<uLong>(n), lvl) ==
+             Z_OK ? static_cast<size_t>(len) : 0;
+    }
+#ifdef FACEKIT_HAS_ZSTD
+    case kChunkCodecZstd: {
+      dst->resize(ZSTD_compressBound(n));
+      const int lvl = level < 0 ? ZSTD_CLEVEL_DEFAULT :
+                      std::min(level, ZSTD_maxCLevel());
+      const size_t len = ZSTD_compress(dst->data(), dst->size(), src, n, lvl);
+      return ZSTD_isError(len) ? 0 : len;
+    }
+#endif
+#ifdef FACEKIT_HAS_LZ4
+    case kChunkCodecLz4: {
+      dst->resize(static_cast<size_t>(LZ4_compressBound(static_cast<int>(n))));
+      const int len = LZ4_compress_default(reinterpret_cast<const char*>(src),
+                                           reinterpret_cast<char*>(dst->data()),
+                                           static_cast<int>(n),
+                                           static_cast<int>(dst->size()));
+      return len > 0 ? static_cast<size_t>(len) : 0;
+    }
+#endif
+    default:
+      return 0;
+  }
+}
+
+/**
+ *  @name   Decompress
+ *  @fn     static bool Decompress(const uint8_t& codec, const uint8_t* src,
+                                   const size_t& n, uint8_t* dst,
+                                   const size_t& raw)
+ *  @brief  Decompress a chunk
+ *  @param[in] codec  Codec
+ *  @param[in] src    Compressed chunk
+ *  @param[in] n      Compressed size in bytes
+ *  @param[out] dst   Decompressed chunk
+ *  @param[in] raw    Decompressed size in bytes
+ *  @return True on success
+ */
+static bool Decompress(const uint8_t& codec,
+                       const uint8_t* src,
+                       const size_t& n,
+                       uint8_t* dst,
+                       const size_t& raw) {
+  switch (codec) {
+    case kChunkCodecZlib: {
+      uLongf len = static_cast<uLongf>(raw);
+      return uncompress(dst, &len, src, static_cast<uLong>(n)) == Z_OK &&
+             len == raw;
+    }
+#ifdef FACEKIT_HAS_ZSTD
+    case kChunkCodecZstd:
+      return ZSTD_decompress(dst, raw, src, n) == raw;
+#endif
+#ifdef FACEKIT_HAS_LZ4
+    case kChunkCodecLz4:
+      return LZ4_decompress_safe(reinterpret_cast<const char*>(src),
+                                 reinterpret_cast<char*>(dst),
+                                 static_cast<int>(n),
+                                 static_cast<int>(raw)) ==
+             static_cast<int>(raw);
+#endif
+    default:
+      return false;
+  }
+}
+
+/*
+ *  @name   IsChunkCodecAvailable
+ *  @fn     bool IsChunkCodecAvailable(const uint8_t& codec)
+ *  @brief  Indicate if a codec is compiled in
+ *  @param[in] codec  Codec, see `ChunkCodecId`
+ *  @return True if available
+ */
+bool IsChunkCodecAvailable(const uint8_t& codec) {
+  switch (codec) {
+    case kChunkCodecNone:
+    case kChunkCodecZlib:
+      return true;
+#ifdef FACEKIT_HAS_ZSTD
+    case kChunkCodecZstd:
+      return true;
+#endif
+#ifdef FACEKIT_HAS_LZ4
+    case kChunkCodecLz4:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+/**
+ *  @name   CheckParams
+ *  @fn     static Status CheckParams(const ChunkParams& params,
+                                      const size_t& n)
+ *  @brief  Validate encoding parameters
+ *  @param[in] params Parameters
+ *  @param[in] n      Buffer size in bytes
+ *  @return kInvalidArgument / kUnimplemented on error
+ */
+static Status CheckParams(const ChunkParams& params, const size_t& n) {
+  const size_t e = params.elem_size;
+  if ((e != 1 && e != 2 && e != 4 && e != 8) || n % e != 0 ||
+      params.chunk_size == 0 || params.chunk_size % e != 0 ||
+      params.chunk_size > std::numeric_limits<int32_t>::max() ||
+      params.filter > kChunkFilterDeltaShuffle) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Invalid chunk parameters");
+  }
+  if (!IsChunkCodecAvailable(params.codec)) {
+    return Status(Status::Type::kUnimplemented,
+                  "Compression codec not available: " +
+                  std::to_string(params.codec));
+  }
+  return Status();
+}
+
+#pragma mark -
+#pragma mark Chunks
+
+/*
+ *  @name   EncodeChunks
+ *  @fn     Status EncodeChunks(const uint8_t* src, const size_t& n,
+                                const ChunkParams& params,
+                                std::vector<uint32_t>* sizes,
+                                std::vector<uint8_t>* payload)
+ *  @brief  Split a buffer into chunks, filter and compress them in parallel.
+ *          Chunks that do not shrink are stored filtered but uncompressed,
+ *          their encoded size equals their raw size.
+ *  @param[in] src      Buffer, `n` multiple of `params.elem_size`
+ *  @param[in] n        Buffer size in bytes
+ *  @param[in] params   Encoding parameters
+ *  @param[out] sizes   Encoded size of each chunk
+ *  @param[out] payload Concatenated encoded chunks
+ *  @return Operation status
+ */
+Status EncodeChunks(const uint8_t* src,
+                    const size_t& n,
+                    const ChunkParams& params,
+                    std::vector<uint32_t>* sizes,
+                    std::vector<uint8_t>* payload) {
+  FACEKIT_TRACE_SCOPE("EncodeChunks");
+  Status s = CheckParams(params, n);
+  if (!s.Good()) {
+    return s;
+  }
+  const size_t cs = params.chunk_size;
+  const size_t n_chunk = (n + cs - 1) / cs;
+  std::vector<std::vector<uint8_t>> chunks(n_chunk);
+  sizes->assign(n_chunk, 0);
+  ThreadPool::Get().ParallelFor(0,
+                                n_chunk,
+                                1,
+                                [&](const size_t& first, const size_t& last) {
+    std::vector<uint8_t> filtered;
+    std::vector<uint8_t> shuffled;
+    for (size_t k = first; k < last; ++k) {
+      const size_t raw = std::min(cs, n - k * cs);
+      const uint8_t* data = src + k * cs;
+      if (params.filter != kChunkFilterNone) {
+        filtered.assign(data, data + raw);
+        if (params.filter == kChunkFilterDeltaShuffle) {
+          Delta(filtered.data(), raw, params.elem_size, true);
+        }
+        data = filtered.data();
+        if (params.elem_size > 1) {
+          shuffled.resize(raw);
+          Shuffle(filtered.data(), raw, params.elem_size, shuffled.data());
+          data = shuffled.data();
+        }
+      }
+      auto& chunk = chunks[k];
+      size_t len = 0;
+      if (params.codec != kChunkCodecNone) {
+        len = Compress(params.codec, params.level, data, raw, &chunk);
+      }
+      if (len == 0 || len >= raw) {
+        // Does not shrink, store it
+        chunk.assign(data, data + raw);
+        len = raw;
+      }
+      chunk.resize(len);
+      (*sizes)[k] = static_cast<uint32_t>(len);
+    }
+  });
+  size_t total = 0;
+  for (const auto& c : chunks) {
+    total += c.size();
+  }
+  payload->clear();
+  payload->reserve(total);
+  for (const auto& c : chunks) {
+    payload->insert(payload->end(), c.begin(), c.end());
+  }
+  return s;
+}
+
+/*
+ *  @name   DecodeChunks
+ *  @fn     Status DecodeChunks(const uint8_t* payload,
+                                const std::vector<uint32_t>& sizes,
+                                const ChunkParams& params, uint8_t* dst,
+                                const size_t& n)
+ *  @brief  Decompress and unfilter chunks in parallel, straight into the
+ *          destination buffer
+ *  @param[in] payload  Concatenated encoded chunks
+ *  @param[in] sizes    Encoded size of each chunk
+ *  @param[in] params   Encoding parameters, `level` is ignored
+ *  @param[out] dst     Decoded buffer
+ *  @param[in] n        Decoded buffer size in bytes
+ *  @return Operation status
+ */
+Status DecodeChunks(const uint8_t* payload,
+                    const std::vector<uint32_t>& sizes,
+                    const ChunkParams& params,
+                    uint8_t* dst,
+                    const size_t& n) {
+  FACEKIT_TRACE_SCOPE("DecodeChunks");
+  Status s = CheckParams(params, n);
+  if (!s.Good()) {
+    return s;
+  }
+  const size_t cs = params.chunk_size;
+  const size_t n_chunk = (n + cs - 1) / cs;
+  if (sizes.size() != n_chunk) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Chunk count does not match buffer size");
+  }
+  // Chunk start positions in the payload
+  std::vector<size_t> start(n_chunk + 1, 0);
+  for (size_t k = 0; k < n_chunk; ++k) {
+    start[k + 1] = start[k] + sizes[k];
+  }
+  std::atomic<bool> ok(true);
+  ThreadPool::Get().ParallelFor(0,
+                                n_chunk,
+                                1,
+                                [&](const size_t& first, const size_t& last) {
+    const bool shuffled = params.filter != kChunkFilterNone &&
+                          params.elem_size > 1;
+    std::vector<uint8_t> tmp;
+    for (size_t k = first; k < last && ok; ++k) {
+      const size_t raw = std::min(cs, n - k * cs);
+      const uint8_t* src = payload + start[k];
+      uint8_t* out = dst + k * cs;
+      // Shuffled chunks are decoded in a scratch buffer first
+      uint8_t* data = out;
+      if (shuffled) {
+        tmp.resize(raw);
+        data = tmp.data();
+      }
+      if (sizes[k] == raw) {
+        std::memcpy(data, src, raw);
+      } else if (!Decompress(params.codec, src, sizes[k], data, raw)) {
+        ok = false;
+        break;
+      }
+      if (shuffled) {
+        Unshuffle(data, raw, params.elem_size, out);
+      }
+      if (params.filter == kChunkFilterDeltaShuffle) {
+        Delta(out, raw, params.elem_size, false);
+      }
+    }
+  });
+  if (!ok) {
+    return Status(Status::Type::kInternalError,
+                  "Error while decompressing chunk");
+  }
+  return s;
+}
+
+}  // namespace internal
+}  // namespace FaceKit
@@ -0,0 +1,122 @@
+/**
+ *  @file   chunk_codec.hpp
+ *  @brief  Private chunked compression of raw buffers used by the matrix
+ *          serialization. Chunks are filtered and compressed independently
+ *          so they can be processed in parallel.
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   22.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_CHUNK_CODEC__
+#define __FACEKIT_CHUNK_CODEC__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "facekit/core/status.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+namespace internal {
+
+/** Codec identifiers, stored on disk */
+enum ChunkCodecId : uint8_t {
+  /** Chunks stored as is */
+  kChunkCodecNone = 0,
+  /** Deflate, always available */
+  kChunkCodecZlib = 1,
+  /** Zstandard, needs FACEKIT_HAS_ZSTD */
+  kChunkCodecZstd = 2,
+  /** LZ4, needs FACEKIT_HAS_LZ4 */
+  kChunkCodecLz4 = 3
+};
+
+/** Filter identifiers, stored on disk */
+enum ChunkFilterId : uint8_t {
+  /** No filter */
+  kChunkFilterNone = 0,
+  /** Group the n-th byte of every element together */
+  kChunkFilterShuffle = 1,
+  /** Difference with the previous element, then shuffle */
+  kChunkFilterDeltaShuffle = 2
+};
+
+/**
+ *  @struct ChunkParams
+ *  @brief  Chunked encoding parameters
+ */
+struct ChunkParams {
+  /** Codec, see `ChunkCodecId` */
+  uint8_t codec;
+  /** Filter, see `ChunkFilterId` */
+  uint8_t filter;
+  /** Compression level, negative for codec's default */
+  int level;
+  /** Element size in bytes used by the filters: 1, 2, 4 or 8 */
+  size_t elem_size;
+  /** Uncompressed chunk size in bytes, multiple of `elem_size` */
+  size_t chunk_size;
+};
+
+/**
+ *  @name   IsChunkCodecAvailable
+ *  @fn     bool IsChunkCodecAvailable(const uint8_t& codec)
+ *  @brief  Indicate if a codec is compiled in
+ *  @param[in] codec  Codec, see `ChunkCodecId`
+ *  @return True if available
+ */
+bool IsChunkCodecAvailable(const uint8_t& codec);
+
+/**
+ *  @name   EncodeChunks
+ *  @fn     Status EncodeChunks(const uint8_t* src, const size_t& n,
+                                const ChunkParams& params,
+                                std::vector<uint32_t>* sizes,
+                                std::vector<uint8_t>* payload)
+ *  @brief  Split a buffer into chunks, filter and compress them in parallel.
+ *          Chunks that do not shrink are stored filtered but uncompressed,
+ *          their encoded size equals their raw size.
+ *  @param[in] src      Buffer, `n` multiple of `params.elem_size`
+ *  @param[in] n        Buffer size in bytes
+ *  @param[in] params   Encoding parameters
+ *  @param[out] sizes   Encoded size of each chunk
+ *  @param[out] payload Concatenated encoded chunks
+ *  @return Operation status
+ */
+Status EncodeChunks(const uint8_t* src,
+                    const size_t& n,
+                    const ChunkParams& params,
+                    std::vector<uint32_t>* sizes,
+                    std::vector<uint8_t>* payload);
+
+/**
+ *  @name   DecodeChunks
+ *  @fn     Status DecodeChunks(const uint8_t* payload,
+                                const std::vector<uint32_t>& sizes,
+                                const ChunkParams& params, uint8_t* dst,
+                                const size_t& n)
+ *  @brief  Decompress and unfilter chunks in parallel, straight into the
+ *          destination buffer
+ *  @param[in] payload  Concatenated encoded chunks
+ *  @param[in] sizes    Encoded size of each chunk
+ *  @param[in] params   Encoding parameters, `level` is ignored
+ *  @param[out] dst     Decoded buffer
+ *  @param[in] n        Decoded buffer size in bytes
+ *  @return Operation status
+ */
+Status DecodeChunks(const uint8_t* payload,
+                    const std::vector<uint32_t>& sizes,
+                    const ChunkParams& params,
+                    uint8_t* dst,
+                    const size_t& n);
+
+}  // namespace internal
+}  // namespace FaceKit
+#endif /* __FACEKIT_CHUNK_CODEC__ */
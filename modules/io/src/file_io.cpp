@@ -8,15 +8,27 @@
  *  Copyright © 2017 Christophe Ecabert. All rights reserved.
  */
 
-#include <fstream>
-#include <stack>
+#if defined(__APPLE__) || defined(__linux__)
+#define IS_POSIX
+#endif
 
-#include "tinydir.h"
+#include <algorithm>
+#include <fstream>
 
 #include "facekit/io/file_io.hpp"
+#include "chunk_codec.hpp"
 #include "facekit/core/logger.hpp"
+#include "facekit/core/nd_array.hpp"
+#include "facekit/core/mem/allocator.hpp"
+#include "facekit/core/sys/batch_file_reader.hpp"
+#include "facekit/core/sys/file_system.hpp"
+#include "facekit/core/sys/file_system_factory.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/trace.hpp"
+#include "facekit/io/object_container.hpp"
 #include "facekit/io/object_header.hpp"
 #include "facekit/io/object_manager.hpp"
+#include "facekit/io/serializable.hpp"
 
 
 /**
@@ -25,6 +37,191 @@
  */
 namespace FaceKit {
   
+#pragma mark -
+#pragma mark Matrix block
+
+constexpr size_t IO::kMatAlignment;
+
+/** First field of blocks written by `SaveAlignedMat`, never a valid type */
+static constexpr int kAlignedMatTag = -2;
+/** First field of compressed blocks, never a valid type */
+static constexpr int kCompressedMatTag = -3;
+/** Smallest compressed chunk, per chunk overhead dominates below */
+static constexpr size_t kMinMatChunkSize = 4096;
+
+/**
+ *  @struct MatHeader
+ *  @brief  Matrix block properties
+ */
+struct MatHeader {
+  /** OpenCV type */
+  int type = -1;
+  /** Rows */
+  int rows = -1;
+  /** Columns */
+  int cols = -1;
+  /** Data aligned for mapping */
+  bool aligned = false;
+  /** Data stored as compressed chunks */
+  bool compressed = false;
+  /** Chunks parameters, if compressed */
+  internal::ChunkParams chunk = {0, 0, -1, 1, 1};
+  /** Encoded size of each chunk, if compressed */
+  std::vector<uint32_t> sizes;
+};
+
+/**
+ *  @name   ReadMatHeader
+ *  @fn     static bool ReadMatHeader(std::istream& stream, MatHeader* hdr)
+ *  @brief  Read the header of a matrix block, either plain (type, rows,
+ *          cols), aligned (tag, type, rows, cols, padding) or compressed
+ *          (tag, type, rows, cols, codec, filter, reserved, chunk size,
+ *          number of chunks, chunk sizes). The stream is left at the first
+ *          element.
+ *  @param[in] stream Binary stream
+ *  @param[out] hdr   Block properties
+ *  @return True on success
+ */
+static bool ReadMatHeader(std::istream& stream, MatHeader* hdr) {
+  int first = -1;
+  stream.read(reinterpret_cast<char*>(&first), sizeof(first));
+  hdr->aligned = first == kAlignedMatTag;
+  hdr->compressed = first == kCompressedMatTag;
+  if (hdr->aligned || hdr->compressed) {
+    stream.read(reinterpret_cast<char*>(&hdr->type), sizeof(hdr->type));
+  } else {
+    hdr->type = first;
+  }
+  stream.read(reinterpret_cast<char*>(&hdr->rows), sizeof(hdr->rows));
+  stream.read(reinterpret_cast<char*>(&hdr->cols), sizeof(hdr->cols));
+  if (hdr->aligned) {
+    int pad = 0;
+    stream.read(reinterpret_cast<char*>(&pad), sizeof(pad));
+    stream.ignore(pad);
+  }
+  if (hdr->compressed) {
+    uint8_t codec[4];
+    uint32_t chunk[2];
+    stream.read(reinterpret_cast<char*>(codec), sizeof(codec));
+    stream.read(reinterpret_cast<char*>(chunk), sizeof(chunk));
+    if (!stream.good()) {
+      return false;
+    }
+    hdr->chunk.codec = codec[0];
+    hdr->chunk.filter = codec[1];
+    hdr->chunk.elem_size = CV_ELEM_SIZE1(hdr->type);
+    hdr->chunk.chunk_size = chunk[0];
+    hdr->sizes.resize(chunk[1]);
+    stream.read(reinterpret_cast<char*>(hdr->sizes.data()),
+                chunk[1] * sizeof(uint32_t));
+  }
+  return stream.good() && hdr->type >= 0 && hdr->rows >= 0 && hdr->cols >= 0;
+}
+
+/**
+ *  @name   ToDataType
+ *  @fn     static DataType ToDataType(const int& depth)
+ *  @brief  Convert OpenCV depth to data type
+ *  @param[in] depth  OpenCV depth
+ *  @return Data type or kUnknown if not supported
+ */
+static DataType ToDataType(const int& depth) {
+  switch (depth) {
+    case CV_8S: return DataType::kInt8;
+    case CV_8U: return DataType::kUInt8;
+    case CV_16S: return DataType::kInt16;
+    case CV_16U: return DataType::kUInt16;
+    case CV_32S: return DataType::kInt32;
+    case CV_32F: return DataType::kFloat;
+    case CV_64F: return DataType::kDouble;
+    default: return DataType::kUnknown;
+  }
+}
+
+/**
+ *  @name   ReadMatData
+ *  @fn     static bool ReadMatData(std::istream& stream, const MatHeader& hdr,
+                                    cv::Mat* matrix)
+ *  @brief  Read the elements of a block, compressed chunks are decoded in
+ *          parallel
+ *  @param[in] stream Binary stream, positioned after the header
+ *  @param[in] hdr    Block properties
+ *  @param[out] matrix  Loaded matrix
+ *  @return True on success
+ */
+static bool ReadMatData(std::istream& stream,
+                        const MatHeader& hdr,
+                        cv::Mat* matrix) {
+  // Init container
+  matrix->create(hdr.rows, hdr.cols, hdr.type);
+  const size_t n = matrix->total() * matrix->elemSize();
+  if (!hdr.compressed) {
+    stream.read(reinterpret_cast<char*>(matrix->data), n);
+    return stream.good();
+  }
+  size_t n_payload = 0;
+  for (const auto& sz : hdr.sizes) {
+    n_payload += sz;
+  }
+  // Single read of every chunk, then decode them concurrently
+  std::vector<uint8_t> payload(n_payload);
+  stream.read(reinterpret_cast<char*>(payload.data()), n_payload);
+  return stream.good() && internal::DecodeChunks(payload.data(),
+                                                 hdr.sizes,
+                                                 hdr.chunk,
+                                                 matrix->data,
+                                                 n).Good();
+}
+
+/**
+ *  @name   MapData
+ *  @fn     static bool MapData(const std::string& path, const size_t& offset,
+                                const int& rows, const int& cols,
+                                const int& type, cv::Mat* matrix)
+ *  @brief  Map contiguous matrix elements stored in a file
+ *  @param[in] path   Path to the file
+ *  @param[in] offset Position of the first element
+ *  @param[in] rows   Rows
+ *  @param[in] cols   Columns
+ *  @param[in] type   OpenCV type
+ *  @param[out] matrix  Mapped matrix
+ *  @return True if mapped, false if the region can not be mapped (i.e.
+ *          empty, unsupported type or misaligned)
+ */
+static bool MapData(const std::string& path,
+                    const size_t& offset,
+                    const int& rows,
+                    const int& cols,
+                    const int& type,
+                    cv::Mat* matrix) {
+  const int cn = CV_MAT_CN(type);
+  const DataType dtype = ToDataType(CV_MAT_DEPTH(type));
+  if (rows <= 0 || cols <= 0 || dtype == DataType::kUnknown) {
+    return false;
+  }
+  NDArrayDims dims({static_cast<size_t>(rows), static_cast<size_t>(cols)});
+  if (cn > 1) {
+    dims.AddDim(static_cast<size_t>(cn));
+  }
+  NDArray array;
+  return array.MapFile(path, dtype, dims, offset).Good() &&
+         array.AsCvMat(matrix).Good();
+}
+
+/*
+ *  @name IsCodecAvailable
+ *  @fn static bool IsCodecAvailable(const Codec& codec)
+ *  @brief  Indicate if a compression codec is compiled in
+ *  @param[in] codec  Codec
+ *  @return True if available
+ */
+bool IO::IsCodecAvailable(const Codec& codec) {
+  return internal::IsChunkCodecAvailable(static_cast<uint8_t>(codec));
+}
+
+#pragma mark -
+#pragma mark File I/0
+
 /*
  *  @name LoadMat
  *  @fn int LoadMat(std::istream& stream, cv::Mat* matrix)
@@ -35,20 +232,9 @@ namespace FaceKit {
  */
 int IO::LoadMat(std::istream& stream, cv::Mat* matrix) {
   int err = -1;
-  if (stream.good()) {
-    int type = -1, r = -1, c = -1;
-    stream.read(reinterpret_cast<char*>(&type), sizeof(type));
-    stream.read(reinterpret_cast<char*>(&r), sizeof(r));
-    stream.read(reinterpret_cast<char*>(&c), sizeof(c));
-    if (type != -1) {
-      // Init container
-      matrix->create(r, c, type);
-      // Read data
-      stream.read(reinterpret_cast<char*>(matrix->data),
-                  matrix->total() * matrix->elemSize());
-      // Sanity check
-      err = stream.good() ? 0 : -1;
-    }
+  MatHeader hdr;
+  if (stream.good() && ReadMatHeader(stream, &hdr)) {
+    err = ReadMatData(stream, hdr, matrix) ? 0 : -1;
   }
   return err;
 }
@@ -66,21 +252,13 @@ int IO::LoadMat(std::istream& stream, cv::Mat* matrix) {
 template<typename T>
 int IO::LoadTypedMat(std::istream& stream, cv::Mat* matrix) {
   int err = -1;
-  if (stream.good()) {
-    int type = -1, r = -1, c = -1;
-    stream.read(reinterpret_cast<char*>(&type), sizeof(type));
-    stream.read(reinterpret_cast<char*>(&r), sizeof(r));
-    stream.read(reinterpret_cast<char*>(&c), sizeof(c));
-    if (type != -1) {
-      // Init container
-      cv::Mat buff(r, c, type);
-      // Read data
-      stream.read(reinterpret_cast<char*>(buff.data),
-                  buff.total() * buff.elemSize());
-      // Convert
+  MatHeader hdr;
+  if (stream.good() && ReadMatHeader(stream, &hdr)) {
+    cv::Mat buff;
+    err = ReadMatData(stream, hdr, &buff) ? 0 : -1;
+    // Convert
+    if (err == 0) {
       buff.convertTo(*matrix, cv::DataType<T>::type);
-      // Sanity check
-      err = stream.good() ? 0 : -1;
     }
   }
   return err;
@@ -166,6 +344,61 @@ int IO::SaveMat(std::ostream& stream, const cv::Mat& matrix) {
   return err;
 }
   
+/*
+ *  @name SaveMat
+ *  @fn static int SaveMat(std::ostream& stream, const cv::Mat& matrix,
+                           const CompressionOptions& options)
+ *  @brief  Save a \p matrix into a given stream as independently
+ *          compressed chunks, `LoadMat` decompresses them in parallel
+ *  @param[in]  stream  Binary stream where to write
+ *  @param[in]  matrix  Matrix to write
+ *  @param[in]  options Compression parameters
+ *  @return -1 if error (i.e. codec not available), 0 otherwise
+ */
+int IO::SaveMat(std::ostream& stream,
+                const cv::Mat& matrix,
+                const CompressionOptions& options) {
+  int err = -1;
+  if (stream.good()) {
+    const cv::Mat m = matrix.isContinuous() ? matrix : matrix.clone();
+    // Chunks hold whole elements
+    internal::ChunkParams params;
+    params.codec = static_cast<uint8_t>(options.codec);
+    params.filter = static_cast<uint8_t>(options.filter);
+    params.level = options.level;
+    params.elem_size = m.elemSize1();
+    params.chunk_size = (std::max(options.chunk_size, kMinMatChunkSize) /
+                         params.elem_size) * params.elem_size;
+    std::vector<uint32_t> sizes;
+    std::vector<uint8_t> payload;
+    Status s = internal::EncodeChunks(m.data,
+                                      m.total() * m.elemSize(),
+                                      params,
+                                      &sizes,
+                                      &payload);
+    if (!s.Good()) {
+      FACEKIT_LOG_ERROR(s.ToString());
+      return err;
+    }
+    // Save properties
+    const int hdr[4] = {kCompressedMatTag, m.type(), m.rows, m.cols};
+    const uint8_t codec[4] = {params.codec, params.filter, 0, 0};
+    const uint32_t chunk[2] = {static_cast<uint32_t>(params.chunk_size),
+                               static_cast<uint32_t>(sizes.size())};
+    stream.write(reinterpret_cast<const char*>(hdr), sizeof(hdr));
+    stream.write(reinterpret_cast<const char*>(codec), sizeof(codec));
+    stream.write(reinterpret_cast<const char*>(chunk), sizeof(chunk));
+    stream.write(reinterpret_cast<const char*>(sizes.data()),
+                 sizes.size() * sizeof(uint32_t));
+    // Save data
+    stream.write(reinterpret_cast<const char*>(payload.data()),
+                 payload.size());
+    // Sanity check
+    err = stream.good() ? 0 : -1;
+  }
+  return err;
+}
+
 /*
  *  @name SaveTypedMat
  *  @fn static int SaveTypedMat(std::ostream& stream, const cv::Mat& matrix)
@@ -249,6 +482,220 @@ template int IO::SaveTypedMat<int32_t>(const std::string& filename, const cv::Ma
 template int IO::SaveTypedMat<float>(const std::string& filename, const cv::Mat& matrix);
 template int IO::SaveTypedMat<double>(const std::string& filename, const cv::Mat& matrix);
   
+/*
+ *  @name SaveAlignedMat
+ *  @fn static int SaveAlignedMat(std::ostream& stream, const cv::Mat& matrix)
+ *  @brief  Save a \p matrix with its data aligned on `kMatAlignment` bytes
+ *          from the beginning of the stream, so it can be mapped back with
+ *          `MapMat`. Blocks are read by `LoadMat` as well.
+ *  @param[in]  stream  Binary stream where to write
+ *  @param[in]  matrix  Matrix to write
+ *  @return -1 if error, 0 otherwise
+ */
+int IO::SaveAlignedMat(std::ostream& stream, const cv::Mat& matrix) {
+  int err = -1;
+  if (stream.good()) {
+    const cv::Mat m = matrix.isContinuous() ? matrix : matrix.clone();
+    const int hdr[4] = {kAlignedMatTag, m.type(), m.rows, m.cols};
+    // Padding up to the next aligned position, none for streams without
+    // position (i.e. pipes)
+    const auto pos = stream.tellp();
+    int pad = 0;
+    if (pos != std::streampos(-1)) {
+      const size_t start = static_cast<size_t>(pos) + sizeof(hdr) + sizeof(pad);
+      pad = static_cast<int>((kMatAlignment - start % kMatAlignment) %
+                             kMatAlignment);
+    }
+    const char zeros[kMatAlignment] = {0};
+    stream.write(reinterpret_cast<const char*>(hdr), sizeof(hdr));
+    stream.write(reinterpret_cast<const char*>(&pad), sizeof(pad));
+    stream.write(zeros, pad);
+    // Save data
+    stream.write(reinterpret_cast<const char*>(m.data),
+                 m.total() * m.elemSize());
+    // Sanity check
+    err = stream.good() ? 0 : -1;
+  }
+  return err;
+}
+
+/*
+ *  @name MapMat
+ *  @fn static Status MapMat(const std::string& path, size_t* offset,
+                             cv::Mat* matrix)
+ *  @brief  Load a matrix stored at a given position of a file without
+ *          copying its data: the region is mapped in memory and shared
+ *          between every process using the same file. The matrix is
+ *          read-only. Blocks not written by `SaveAlignedMat` are copied.
+ *  @param[in]  path    Path to the file
+ *  @param[in,out] offset Position of the block, moved past it on success
+ *  @param[out] matrix  Loaded matrix
+ *  @return Operation status
+ */
+Status IO::MapMat(const std::string& path, size_t* offset, cv::Mat* matrix) {
+  std::ifstream stream(path.c_str(), std::ios_base::binary);
+  if (!stream.is_open()) {
+    return Status(Status::Type::kNotFound, "Can not open file: " + path);
+  }
+  stream.seekg(*offset);
+  MatHeader hdr;
+  if (!ReadMatHeader(stream, &hdr)) {
+    return Status(Status::Type::kInternalError,
+                  "Error while reading matrix header in: " + path);
+  }
+  const size_t pos = static_cast<size_t>(stream.tellg());
+  if (hdr.aligned && MapData(path, pos, hdr.rows, hdr.cols, hdr.type, matrix)) {
+    *offset = pos + static_cast<size_t>(hdr.rows) * hdr.cols *
+              CV_ELEM_SIZE(hdr.type);
+    return Status();
+  }
+  // Plain or compressed block, read it
+  if (!ReadMatData(stream, hdr, matrix)) {
+    return Status(Status::Type::kInternalError,
+                  "Error while reading matrix in: " + path);
+  }
+  *offset = static_cast<size_t>(stream.tellg());
+  return Status();
+}
+
+/*
+ *  @name MapTypedMat
+ *  @fn static Status MapTypedMat(const std::string& path, size_t* offset,
+                                  cv::Mat* matrix)
+ *  @brief  Same as `MapMat` for a specific type, blocks stored with another
+ *          type are loaded and converted
+ *  @tparam T Desired type for matrix
+ *  @param[in]  path    Path to the file
+ *  @param[in,out] offset Position of the block, moved past it on success
+ *  @param[out] matrix  Loaded matrix
+ *  @return Operation status
+ */
+template<typename T>
+Status IO::MapTypedMat(const std::string& path,
+                       size_t* offset,
+                       cv::Mat* matrix) {
+  cv::Mat buff;
+  Status s = IO::MapMat(path, offset, &buff);
+  if (s.Good()) {
+    if (buff.depth() == cv::DataType<T>::depth) {
+      *matrix = buff;
+    } else {
+      buff.convertTo(*matrix, cv::DataType<T>::type);
+    }
+  }
+  return s;
+}
+
+template Status IO::MapTypedMat<uint8_t>(const std::string& path, size_t* offset, cv::Mat* matrix);
+template Status IO::MapTypedMat<int8_t>(const std::string& path, size_t* offset, cv::Mat* matrix);
+template Status IO::MapTypedMat<uint16_t>(const std::string& path, size_t* offset, cv::Mat* matrix);
+template Status IO::MapTypedMat<int16_t>(const std::string& path, size_t* offset, cv::Mat* matrix);
+template Status IO::MapTypedMat<int32_t>(const std::string& path, size_t* offset, cv::Mat* matrix);
+template Status IO::MapTypedMat<float>(const std::string& path, size_t* offset, cv::Mat* matrix);
+template Status IO::MapTypedMat<double>(const std::string& path, size_t* offset, cv::Mat* matrix);
+
+/*
+ *  @name MapRawMat
+ *  @fn static Status MapRawMat(const std::string& path, const size_t& offset,
+                                const int& rows, const int& cols,
+                                const int& type, cv::Mat* matrix)
+ *  @brief  Load a matrix whose elements are stored without header at a
+ *          given position of a file (i.e. a section written by
+ *          `SectionWriter`). The region is mapped when \p offset is a
+ *          multiple of the element size, read otherwise.
+ *  @param[in]  path    Path to the file
+ *  @param[in]  offset  Position of the first element
+ *  @param[in]  rows    Rows
+ *  @param[in]  cols    Columns
+ *  @param[in]  type    OpenCV type of the stored elements
+ *  @param[out] matrix  Loaded matrix
+ *  @return Operation status
+ */
+Status IO::MapRawMat(const std::string& path,
+                     const size_t& offset,
+                     const int& rows,
+                     const int& cols,
+                     const int& type,
+                     cv::Mat* matrix) {
+  if (rows < 0 || cols < 0 || type < 0) {
+    return Status(Status::Type::kInvalidArgument, "Invalid matrix shape");
+  }
+  if (MapData(path, offset, rows, cols, type, matrix)) {
+    return Status();
+  }
+  std::ifstream stream(path.c_str(), std::ios_base::binary);
+  if (!stream.is_open()) {
+    return Status(Status::Type::kNotFound, "Can not open file: " + path);
+  }
+  stream.seekg(offset);
+  matrix->create(rows, cols, type);
+  stream.read(reinterpret_cast<char*>(matrix->data),
+              matrix->total() * matrix->elemSize());
+  if (!stream.good()) {
+    return Status(Status::Type::kInternalError,
+                  "Error while reading matrix in: " + path);
+  }
+  return Status();
+}
+
+#pragma mark -
+#pragma mark Asynchronous loading
+
+/*
+ *  @name LoadAsync
+ *  @fn static std::future<Status> LoadAsync(const std::string& path,
+                                             Serializable* object)
+ *  @brief  Load an object on the global `ThreadPool`. The whole file is
+ *          read ahead in a single request into a pooled buffer, then
+ *          deserialized from memory, therefore independent loads overlap
+ *          with each other and with the caller. Remote paths are
+ *          supported through the registered file systems.
+ *  @param[in]  path    File to load from
+ *  @param[out] object  Object to load, must stay alive and untouched until
+ *                      the future is ready
+ *  @return Future holding the operation status. Do not block on it from
+ *          a pool's worker.
+ */
+std::future<Status> IO::LoadAsync(const std::string& path,
+                                  Serializable* object) {
+  using TaskPriority = ThreadPool::TaskPriority;
+  return ThreadPool::Get().Enqueue(TaskPriority::kNormal, [path, object]() {
+    FACEKIT_TRACE_SCOPE("IO::LoadAsync");
+    FileSystem* fs = FileSystemFactory::Get().RetrieveForPath(path);
+    if (fs == nullptr) {
+      return Status(Status::Type::kUnimplemented,
+                    "No file system registered for: " + path);
+    }
+    std::unique_ptr<RandomAccessFile> file;
+    size_t size = 0;
+    Status s = fs->NewRandomAccessFile(path, &file);
+    if (s.Good()) {
+      s = file->Size(&size);
+    }
+    if (!s.Good()) {
+      return s;
+    }
+    // Read ahead, buffer goes back to the pool once the object is loaded
+    NDArray content(DataType::kUInt8,
+                    {size},
+                    GetAllocator("pooled_cpu_allocator"));
+    if (size > 0) {
+      size_t n_read = 0;
+      char* ptr = reinterpret_cast<char*>(content.AsFlat<uint8_t>().data());
+      s = file->Read(0, size, ptr, &n_read);
+      if (!s.Good()) {
+        return s;
+      }
+    }
+    MemoryStream stream(content);
+    if (object->Load(stream) != 0) {
+      return Status(Status::Type::kInternalError,
+                    "Error while loading object from: " + path);
+    }
+    return s;
+  });
+}
+
 #pragma mark -
 #pragma mark Stream Utility
   
@@ -262,6 +709,21 @@ template int IO::SaveTypedMat<double>(const std::string& filename, const cv::Mat
  */
 int IO::ScanStream(std::istream& stream, const size_t& id) {
   int err = -1;
+  size_t base = 0;
+  std::vector<ObjectContainer::Entry> entries;
+  if (stream.good() &&
+      ObjectContainer::ReadToc(stream, &base, &entries).Good()) {
+    // Indexed stream, jump to the first matching object after the current
+    // position
+    const size_t pos = static_cast<size_t>(stream.tellg());
+    for (const auto& e : entries) {
+      if (e.id == id && base + e.offset >= pos + sizeof(size_t) * 2) {
+        stream.seekg(base + e.offset);
+        return 0;
+      }
+    }
+    return err;
+  }
   if (stream.good()) {
     ObjectHeader hdr;
     // Iterate till finding the object or reaching the end of stream
@@ -292,8 +754,10 @@ int IO::StreamContent(std::istream& stream,
     while (stream.good()) {
       // Get object info
       stream >> hdr;
-      // Print content
-      FACEKIT_LOG_INFO(ObjectManager::Get().GetName(hdr.get_id()));
+      // Print content, table of content is not an object
+      if (hdr.get_id() != ObjectContainer::kTocId) {
+        FACEKIT_LOG_INFO(ObjectManager::Get().GetName(hdr.get_id()));
+      }
       // Move to the next one
       stream.seekg(hdr.get_size(), std::ios_base::cur);
     }
@@ -311,46 +775,91 @@ int IO::StreamContent(std::istream& stream,
                                      const std::string& ext,
                                      std::vector<std::string>* files)
  *  @brief  Search recursively from a root folder for files with a specific
- *          extension
+ *          extension. Folders are scanned in parallel, the order of
+ *          `files` is unspecified.
  */
 void IO::SearchInFolder(const std::string& root,
                         const std::string& ext,
                         std::vector<std::string>* files) {
-  std::stack<std::string> stack;
-  stack.push(root);
-  tinydir_dir dir;
-  tinydir_file file;
-  // Start recursive search
-  while (!stack.empty()) {
-    // Get actual folder
-    std::string path = stack.top();
-    stack.pop();
-    // Open it
-    tinydir_open(&dir, path.c_str());
-    // Iterate over content
-    while (dir.has_next) {
-      // Read file
-      tinydir_readfile(&dir, &file);
-      // File or folder ?
-      const auto file_str = std::string(file.name);
-      const auto name = std::string(dir.path) + "/" + file_str;
-      if (file.is_dir && (file_str != "." && file_str != "..")) {
-        // Add to stack
-        stack.push(name);
-      } else {
-        // Check if match extension
-        auto p = name.rfind(ext);
-        if (p != std::string::npos) {
-          // Add to the list if file matching extension
-          files->push_back(name);
-        }
-      }
-      // Move to the next file/folder
-      tinydir_next(&dir);
-    }
-    // Done iterating over folder, close it
-    tinydir_close(&dir);
+  IO::SearchInFolder(root, std::vector<std::string>(1, ext), files);
+}
+
+/*
+ *  @name   SearchInFolder
+ *  @fn     static void SearchInFolder(const std::string& root,
+                             const std::vector<std::string>& exts,
+                             std::vector<std::string>* files)
+ *  @brief  Search recursively from a root folder for files matching one of
+ *          the extensions, the tree is walked only once. Folders are
+ *          scanned in parallel, the order of `files` is unspecified.
+ */
+void IO::SearchInFolder(const std::string& root,
+                        const std::vector<std::string>& exts,
+                        std::vector<std::string>* files) {
+  // Callbacks are serialized, no need for extra locking
+  IO::SearchInFolder(root, exts, [files](const std::string& f) {
+    files->push_back(f);
+    return true;
+  });
+}
+
+/*
+ *  @name   SearchInFolder
+ *  @fn     static int SearchInFolder(const std::string& root,
+                  const std::vector<std::string>& exts,
+                  const std::function<bool(const std::string&)>& callback)
+ *  @brief  Search recursively from a root folder for files matching one of
+ *          the extensions and stream them to `callback` while the scan is
+ *          still running. Calls are serialized, returning false stops the
+ *          search.
+ *  @return -1 if error, 0 otherwise
+ */
+int IO::SearchInFolder(const std::string& root,
+                       const std::vector<std::string>& exts,
+                       const std::function<bool(const std::string&)>& callback) {
+#ifdef IS_POSIX
+  FileSystem* fs = FileSystemFactory::Get().Retrieve("Posix");
+#else
+  FileSystem* fs = FileSystemFactory::Get().Retrieve("Windows");
+#endif
+  FileSystem::WalkOptions opts;
+  opts.extensions = exts;
+  Status s = fs->WalkDir(root, opts, callback);
+  if (!s.Good()) {
+    FACEKIT_LOG_ERROR(s.Message());
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ *  @name   GlobInFolder
+ *  @fn     static int GlobInFolder(const std::string& root,
+                  const std::vector<std::string>& patterns,
+                  const std::function<bool(const std::string&)>& callback)
+ *  @brief  Search recursively from a root folder for files whose name
+ *          matches one of the glob patterns (i.e. `img_*.jp?g`, see
+ *          `Path::Match`) and stream them to `callback` while the scan is
+ *          still running. Calls are serialized, returning false stops the
+ *          search.
+ *  @return -1 if error, 0 otherwise
+ */
+int IO::GlobInFolder(const std::string& root,
+                     const std::vector<std::string>& patterns,
+                     const std::function<bool(const std::string&)>& callback) {
+#ifdef IS_POSIX
+  FileSystem* fs = FileSystemFactory::Get().Retrieve("Posix");
+#else
+  FileSystem* fs = FileSystemFactory::Get().Retrieve("Windows");
+#endif
+  FileSystem::WalkOptions opts;
+  opts.patterns = patterns;
+  Status s = fs->WalkDir(root, opts, callback);
+  if (!s.Good()) {
+    FACEKIT_LOG_ERROR(s.Message());
+    return -1;
   }
+  return 0;
 }
   
 }  // namespace FaceKit
@@ -10,6 +10,8 @@
 
 #include "facekit/io/image.hpp"
 #include "facekit/io/image_factory.hpp"
+#include "facekit/core/trace.hpp"
+#include "pixel_conversion.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -26,6 +28,7 @@ namespace FaceKit {
  *  @return Operation status
  */
 Status Image::Load(const std::string& filename) {
+  FACEKIT_TRACE_SCOPE("Image::Load");
   Status status;
   std::ifstream stream(filename.c_str(),
                        std::ios_base::in | std::ios_base::binary);
@@ -38,6 +41,105 @@ Status Image::Load(const std::string& filename) {
   return status;
 }
   
+/*
+ *  @name Load
+ *  @fn virtual Status Load(std::istream& stream)
+ *  @brief  Load image from dist into the image's own buffer
+ *  @param[in]  stream  Binary stream from where to load the ressource
+ *  @return Operation status
+ */
+Status Image::Load(std::istream& stream) {
+  return this->LoadInto(stream, &buffer_);
+}
+
+/*
+ *  @name LoadInto
+ *  @fn Status LoadInto(const std::string& filename, NDArray* dst)
+ *  @brief  Decode image from disk into a caller provided array. See
+ *          `LoadInto(std::istream&, NDArray*)`.
+ *  @param[in]  filename  Path to ressource on the disk
+ *  @param[out] dst       Where to decode the pixels
+ *  @return Operation status
+ */
+Status Image::LoadInto(const std::string& filename, NDArray* dst) {
+  FACEKIT_TRACE_SCOPE("Image::LoadInto");
+  Status status;
+  std::ifstream stream(filename.c_str(),
+                       std::ios_base::in | std::ios_base::binary);
+  if (stream.is_open()) {
+    status = this->LoadInto(stream, dst);
+  } else {
+    status = Status(Status::Type::kInvalidArgument,
+                    "Can not open: " + filename);
+  }
+  return status;
+}
+  
+/*
+ *  @name Map
+ *  @fn virtual Status Map(const std::string& filename,
+                           const ChannelOrder& order, NDArray* dst)
+ *  @brief  Expose the pixels of an image file, default implementation
+ *          decodes the image
+ *  @param[in]  filename  Path to ressource on the disk
+ *  @param[in]  order     Requested channel order, ignored for grayscale
+ *  @param[out] dst       Pixels
+ *  @return Operation status
+ */
+Status Image::Map(const std::string& filename,
+                  const ChannelOrder& order,
+                  NDArray* dst) {
+  Status status = this->LoadInto(filename, dst);
+  if (status.Good() && order == ChannelOrder::kBGR &&
+      format_ != Format::kGrayscale) {
+    uint8_t* ptr = dst->AsFlat<uint8_t>().data();
+    internal::SwapRedBlue(ptr, width_ * height_, format_, ptr);
+  }
+  return status;
+}
+
+/*
+ *  @name ReadHeader
+ *  @fn Status ReadHeader(const std::string& filename, ImageInfo* info)
+ *  @brief  Probe image dimensions/format without decoding the pixels
+ *  @param[in]  filename  Path to ressource on the disk
+ *  @param[out] info      Image properties
+ *  @return Operation status
+ */
+Status Image::ReadHeader(const std::string& filename, ImageInfo* info) {
+  Status status;
+  std::ifstream stream(filename.c_str(),
+                       std::ios_base::in | std::ios_base::binary);
+  if (stream.is_open()) {
+    status = this->ReadHeader(stream, info);
+  } else {
+    status = Status(Status::Type::kInvalidArgument,
+                    "Can not open: " + filename);
+  }
+  return status;
+}
+
+/*
+ *  @name ReadHeader
+ *  @fn Status ReadHeader(std::istream& stream, ImageInfo* info)
+ *  @brief  Probe image dimensions/format by parsing only the header. The
+ *          stream is rewound to its initial position afterward.
+ *  @param[in]  stream  Binary stream from where to read the header
+ *  @param[out] info    Image properties
+ *  @return Operation status
+ */
+Status Image::ReadHeader(std::istream& stream, ImageInfo* info) {
+  if (!stream.good()) {
+    return Status(Status::Type::kInvalidArgument, "Stream has errors");
+  }
+  const auto pos = stream.tellg();
+  Status status = this->ParseHeader(stream, info);
+  // Parser may have hit the end of the stream, rewind anyway
+  stream.clear();
+  stream.seekg(pos);
+  return status;
+}
+
 /*
  *  @name Save
  *  @fn virtual Status Save(const std::string& filename) const
@@ -46,6 +148,7 @@ Status Image::Load(const std::string& filename) {
  *  @return Operation status
  */
 Status Image::Save(const std::string& filename) const {
+  FACEKIT_TRACE_SCOPE("Image::Save");
   Status status;
   std::ofstream stream(filename.c_str(),
                        std::ios_base::out | std::ios_base::binary);
@@ -64,7 +167,7 @@ Status Image::Save(const std::string& filename) const {
  *  @brief  Constructor
  */
 ImageProxy::ImageProxy(void) {
-  ImageFactory::Get().Register(this);
+  ImageFactory::Register(this);
 }
   
 }  // namespace FaceKit
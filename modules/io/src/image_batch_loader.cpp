@@ -0,0 +1,268 @@
+/**
+ *  @file   image_batch_loader.cpp
+ *  @brief  Decode a batch of image files in parallel
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   17.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "facekit/io/image_batch_loader.hpp"
+#include "facekit/io/image.hpp"
+#include "facekit/io/image_cache.hpp"
+#include "facekit/io/image_factory.hpp"
+#include "facekit/core/sys/batch_file_reader.hpp"
+#include "facekit/core/sys/file_system.hpp"
+#include "facekit/core/sys/file_system_factory.hpp"
+#include "facekit/core/mem/allocator.hpp"
+#include "facekit/core/mem/memory_budget.hpp"
+#include "facekit/core/utils/string.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/trace.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#pragma mark -
+#pragma mark Helpers
+
+/**
+ *  @name   ReadContent
+ *  @brief  Read an entire file into a one dimensional `kUInt8` array
+ *  @param[in] path       File to read
+ *  @param[in] allocator  Allocator for the content
+ *  @param[out] content   File's content
+ *  @return Operation status
+ */
+static Status ReadContent(const std::string& path,
+                          Allocator* allocator,
+                          NDArray* content) {
+  FileSystem* fs = FileSystemFactory::Get().RetrieveForPath(path);
+  if (fs == nullptr) {
+    return Status(Status::Type::kUnimplemented,
+                  "No file system registered for: " + path);
+  }
+  std::unique_ptr<RandomAccessFile> file;
+  size_t size = 0;
+  Status s = fs->NewRandomAccessFile(path, &file);
+  if (s.Good()) {
+    s = file->Size(&size);
+  }
+  if (s.Good()) {
+    *content = NDArray(DataType::kUInt8, {size}, allocator);
+    if (size > 0) {
+      size_t n_read = 0;
+      char* ptr = reinterpret_cast<char*>(content->AsFlat<uint8_t>().data());
+      s = file->Read(0, size, ptr, &n_read);
+    }
+  }
+  return s;
+}
+
+/**
+ *  @name   GetCodec
+ *  @brief  Provide the calling thread's codec instance for a given extension.
+ *          Instances are created once per thread and reused afterward, they
+ *          are never shared between threads.
+ *  @param[in] path Image's path
+ *  @return Codec or nullptr if the extension is not supported
+ */
+static Image* GetCodec(const std::string& path) {
+  static thread_local std::unordered_map<std::string,
+                                         std::unique_ptr<Image>> codecs;
+  std::string ext = Path::Extension(path);
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  auto it = codecs.find(ext);
+  if (it == codecs.end()) {
+    Image* codec = ImageFactory::Get().CreateByExtension(ext);
+    it = codecs.emplace(ext, std::unique_ptr<Image>(codec)).first;
+  }
+  return it->second.get();
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   ImageBatchLoader
+ *  @fn     ImageBatchLoader(void)
+ *  @brief  Constructor with default options
+ */
+ImageBatchLoader::ImageBatchLoader(void) : ImageBatchLoader(Options()) {
+}
+
+/*
+ *  @name   ImageBatchLoader
+ *  @fn     explicit ImageBatchLoader(const Options& options)
+ *  @brief  Constructor
+ *  @param[in] options  Loader configuration
+ */
+ImageBatchLoader::ImageBatchLoader(const Options& options) :
+        options_(options) {
+  options_.max_in_flight = std::max(options_.max_in_flight, size_t(1));
+  if (options_.allocator == nullptr) {
+    options_.allocator = GetAllocator("pooled_cpu_allocator");
+  }
+  if (options_.budget == nullptr) {
+    options_.budget = &MemoryBudget::Global();
+  }
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Load
+ *  @fn     Status Load(const std::vector<std::string>& paths,
+                        const Callback& callback)
+ *  @brief  Decode every image in `paths`, `callback` is invoked for each of
+ *          them. Returns once all images have been reported.
+ *  @param[in] paths    Images to load
+ *  @param[in] callback Completion callback
+ *  @return kGood if every image has been decoded, first error otherwise
+ */
+Status ImageBatchLoader::Load(const std::vector<std::string>& paths,
+                              const Callback& callback) {
+  FACEKIT_TRACE_SCOPE("ImageBatchLoader::Load");
+  using TaskPriority = ThreadPool::TaskPriority;
+  /** Decoded image waiting for delivery */
+  struct Result {
+    Status status;
+    NDArray image;
+    MemoryBudget::Token token;
+  };
+  ThreadPool& pool = options_.pool ? *options_.pool : ThreadPool::Get();
+  const size_t limit = options_.max_in_flight;
+  const bool ordered = options_.ordered;
+  Allocator* allocator = options_.allocator;
+  ImageCache* cache = options_.cache;
+  MemoryBudget* budget = options_.budget;
+  Status status;
+  size_t in_flight = 0;
+  std::mutex mutex;
+  std::mutex cb_mutex;
+  std::condition_variable cond;
+  // Completed images waiting for their predecessors (ordered delivery)
+  std::map<size_t, Result> pending;
+  size_t next_delivery = 0;
+  // Read + decode one image
+  auto load = [&](const size_t& index) {
+    NDArray image(allocator);
+    Status s;
+    if (cache != nullptr) {
+      ImageCache::Handle cached;
+      s = cache->Acquire(paths[index], &cached);
+      if (s.Good()) {
+        image = cached.image();
+      }
+    } else {
+      NDArray content;
+      Status rs = ReadContent(paths[index], allocator, &content);
+      if (rs.Good()) {
+        Image* codec = GetCodec(paths[index]);
+        if (codec != nullptr) {
+          MemoryStream stream(content);
+          rs = codec->LoadInto(stream, &image);
+        } else {
+          rs = Status(Status::Type::kInvalidArgument,
+                      "Unsupported image type: " + paths[index]);
+        }
+      }
+      s = rs;
+      // Encoded data goes back to the pool before delivery
+    }
+    if (!s.Good()) {
+      image = NDArray();
+    }
+    // Cached pixels are accounted by the cache itself
+    MemoryBudget::Token token;
+    if (cache == nullptr) {
+      budget->Charge(image.n_elems() * DataTypeDynamicSize(image.type()),
+                     &token);
+    }
+    size_t n_delivered = 0;
+    {
+      std::lock_guard<std::mutex> lock(cb_mutex);
+      if (!ordered) {
+        callback(index, s, std::move(image));
+        n_delivered = 1;
+      } else {
+        pending.emplace(index, Result{s, std::move(image), std::move(token)});
+        auto it = pending.begin();
+        while (it != pending.end() && it->first == next_delivery) {
+          // Delivered pixels belong to the caller, the budget is released
+          callback(it->first, it->second.status, std::move(it->second.image));
+          it = pending.erase(it);
+          next_delivery += 1;
+          n_delivered += 1;
+        }
+      }
+    }
+    token.Release();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!s.Good() && status.Good()) {
+      status = s;
+    }
+    in_flight -= n_delivered;
+    cond.notify_all();
+  };
+  // Dispatch tasks, at most `limit` images alive at once and none while the
+  // budget is exhausted, unless nothing is in flight. The calling thread
+  // helps the pool while waiting so the batch can be loaded from a worker
+  size_t next = 0;
+  auto can_dispatch = [&](void) {
+    return next < paths.size() &&
+           (in_flight == 0 || (in_flight < limit && !budget->exhausted()));
+  };
+  std::unique_lock<std::mutex> lock(mutex);
+  while (next < paths.size() || in_flight > 0) {
+    while (can_dispatch()) {
+      in_flight += 1;
+      pool.Submit(TaskPriority::kNormal, load, next++);
+    }
+    lock.unlock();
+    const bool helped = pool.RunPendingTask();
+    lock.lock();
+    if (!helped) {
+      // Woken up by our own deliveries, which give budget back
+      cond.wait(lock, [&]() {
+        return in_flight == 0 || can_dispatch();
+      });
+    }
+  }
+  return status;
+}
+
+/*
+ *  @name   Load
+ *  @fn     Status Load(const std::vector<std::string>& paths,
+                        std::vector<NDArray>* images)
+ *  @brief  Decode every image in `paths` and gather them in order
+ *  @param[in] paths    Images to load
+ *  @param[out] images  Decoded images
+ *  @return kGood if every image has been decoded, first error otherwise
+ */
+Status ImageBatchLoader::Load(const std::vector<std::string>& paths,
+                              std::vector<NDArray>* images) {
+  images->clear();
+  images->resize(paths.size());
+  return this->Load(paths, [images](const size_t& index,
+                                    const Status& status,
+                                    NDArray&& image) {
+    (*images)[index] = std::move(image);
+  });
+}
+
+}  // namespace FaceKit
@@ -0,0 +1,346 @@
+/**
+ *  @file   image_cache.cpp
+ *  @brief  In-memory cache of decoded images shared between threads
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+#include "facekit/io/image_cache.hpp"
+#include "facekit/io/image.hpp"
+#include "facekit/io/image_factory.hpp"
+#include "facekit/io/image_ops.hpp"
+#include "facekit/core/sys/batch_file_reader.hpp"
+#include "facekit/core/sys/file_system.hpp"
+#include "facekit/core/sys/file_system_factory.hpp"
+#include "facekit/core/mem/allocator.hpp"
+#include "facekit/core/utils/string.hpp"
+#include "facekit/core/trace.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#pragma mark -
+#pragma mark Helpers
+
+/**
+ *  @name   MakeKey
+ *  @brief  Cache key of an image
+ *  @param[in] path   Image's path
+ *  @param[in] mtime  Last modification of the file
+ *  @param[in] scale  Resize factor
+ *  @return Key
+ */
+static std::string MakeKey(const std::string& path,
+                           const int64_t& mtime,
+                           const float& scale) {
+  uint32_t bits;
+  std::memcpy(&bits, &scale, sizeof(bits));
+  return path + '\n' + std::to_string(mtime) + '\n' + std::to_string(bits);
+}
+
+#pragma mark -
+#pragma mark Handle
+
+/*
+ *  @name   image
+ *  @fn     const NDArray& image(void) const
+ *  @brief  Decoded pixels, must not be empty
+ */
+const NDArray& ImageCache::Handle::image(void) const {
+  return entry_->image;
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   Get
+ *  @fn     static ImageCache& Get(void)
+ *  @brief  Process-wide cache with default options
+ */
+ImageCache& ImageCache::Get(void) {
+  static ImageCache cache;
+  return cache;
+}
+
+/*
+ *  @name   ImageCache
+ *  @fn     ImageCache(void)
+ *  @brief  Constructor with default options
+ */
+ImageCache::ImageCache(void) : ImageCache(Options()) {
+}
+
+/*
+ *  @name   ImageCache
+ *  @fn     explicit ImageCache(const Options& options)
+ *  @brief  Constructor
+ *  @param[in] options  Cache configuration
+ */
+ImageCache::ImageCache(const Options& options) : options_(options),
+                                                 budget_(options.budget) {
+  options_.n_shard = std::max(options_.n_shard, size_t(1));
+  if (options_.allocator == nullptr) {
+    options_.allocator = GetAllocator("pooled_cpu_allocator");
+  }
+  shards_.reset(new Shard[options_.n_shard]);
+}
+
+/*
+ *  @name   ~ImageCache
+ *  @fn     ~ImageCache(void)
+ *  @brief  Destructor, images still pinned are released with their last
+ *          handle
+ */
+ImageCache::~ImageCache(void) {
+  this->Clear();
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Acquire
+ *  @fn     Status Acquire(const std::string& path, const float& scale,
+                           Handle* image)
+ *  @brief  Get the image stored in `path`, resized by `scale`, decoding it
+ *          on first use. Concurrent calls for the same image decode it
+ *          once, the others wait for it.
+ *  @param[in] path   Image file, any path supported by `FileSystemFactory`
+ *  @param[in] scale  Resize factor applied after decoding (area
+ *                    interpolation), 1 to keep the original size
+ *  @param[out] image Pinned image
+ *  @return kInvalidArgument if the file can not be found, decoded or the
+ *          scale is not positive. Failures are not cached.
+ */
+Status ImageCache::Acquire(const std::string& path,
+                           const float& scale,
+                           Handle* image) {
+  FACEKIT_TRACE_SCOPE("ImageCache::Acquire");
+  if (!(scale > 0.f)) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Scale must be positive");
+  }
+  // Modification time is part of the key, edited files are decoded again
+  FileSystem* fs = FileSystemFactory::Get().RetrieveForPath(path);
+  if (fs == nullptr) {
+    return Status(Status::Type::kUnimplemented,
+                  "No file system registered for: " + path);
+  }
+  FileProperty prop;
+  Status s = fs->FileProp(path, &prop);
+  if (!s.Good()) {
+    return s;
+  }
+  const std::string key = MakeKey(path, prop.mtime, scale);
+  Shard& shard = shards_[std::hash<std::string>()(key) % options_.n_shard];
+  // Find or insert the entry, take a reference for the caller
+  RefPtr<Entry> entry;
+  {
+    std::lock_guard<std::mutex> lock(shard.lock);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+      auto e = MakeRef<Entry>();
+      e->key = key;
+      e->lru = shard.lru.insert(shard.lru.end(), e.get());
+      it = shard.entries.emplace(key, std::move(e)).first;
+    } else {
+      shard.lru.splice(shard.lru.end(), shard.lru, it->second->lru);
+    }
+    entry = it->second;
+  }
+  // Decode once, concurrent callers wait on the entry
+  {
+    std::lock_guard<std::mutex> lock(entry->load_mutex);
+    if (!entry->loaded) {
+      s = this->Load(path, scale, entry.get());
+      entry->loaded = s.Good();
+      // Account for it only if not dropped by `Clear` meanwhile
+      std::lock_guard<std::mutex> s_lock(shard.lock);
+      auto it = shard.entries.find(key);
+      const bool cached = it != shard.entries.end() && it->second == entry;
+      if (s.Good() && cached) {
+        entry->resident = true;
+        shard.size += entry->bytes;
+        this->Evict(&shard);
+      } else if (!s.Good() && cached) {
+        // Do not cache failures, the next call tries again
+        shard.lru.erase(entry->lru);
+        shard.entries.erase(it);
+      }
+    }
+  }
+  if (!s.Good()) {
+    return s;
+  }
+  *image = Handle(std::move(entry));
+  return s;
+}
+
+/*
+ *  @name   Clear
+ *  @fn     void Clear(void)
+ *  @brief  Drop every cached image, pinned ones are released when their
+ *          last handle goes away
+ */
+void ImageCache::Clear(void) {
+  for (size_t k = 0; k < options_.n_shard; ++k) {
+    Shard& shard = shards_[k];
+    std::lock_guard<std::mutex> lock(shard.lock);
+    shard.lru.clear();
+    shard.entries.clear();
+    shard.size = 0;
+  }
+}
+
+#pragma mark -
+#pragma mark Accessors
+
+/*
+ *  @name   budget
+ *  @fn     size_t budget(void) const
+ *  @brief  Memory budget in bytes
+ */
+size_t ImageCache::budget(void) const {
+  return budget_.load(std::memory_order_relaxed);
+}
+
+/*
+ *  @name   set_budget
+ *  @fn     void set_budget(const size_t& budget)
+ *  @brief  Set the memory budget in bytes, least recently used idle
+ *          images are evicted until it is met
+ */
+void ImageCache::set_budget(const size_t& budget) {
+  budget_.store(budget, std::memory_order_relaxed);
+  for (size_t k = 0; k < options_.n_shard; ++k) {
+    std::lock_guard<std::mutex> lock(shards_[k].lock);
+    this->Evict(&shards_[k]);
+  }
+}
+
+/*
+ *  @name   size
+ *  @fn     size_t size(void) const
+ *  @brief  Memory used by the decoded images in bytes
+ */
+size_t ImageCache::size(void) const {
+  size_t size = 0;
+  for (size_t k = 0; k < options_.n_shard; ++k) {
+    std::lock_guard<std::mutex> lock(shards_[k].lock);
+    size += shards_[k].size;
+  }
+  return size;
+}
+
+/*
+ *  @name   n_entry
+ *  @fn     size_t n_entry(void) const
+ *  @brief  Number of cached images, including the ones being decoded
+ */
+size_t ImageCache::n_entry(void) const {
+  size_t n = 0;
+  for (size_t k = 0; k < options_.n_shard; ++k) {
+    std::lock_guard<std::mutex> lock(shards_[k].lock);
+    n += shards_[k].entries.size();
+  }
+  return n;
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ *  @name   Load
+ *  @fn     Status Load(const std::string& path, const float& scale,
+                        Entry* entry) const
+ *  @brief  Decode and resize the image of `entry`
+ */
+Status ImageCache::Load(const std::string& path,
+                        const float& scale,
+                        Entry* entry) const {
+  FACEKIT_TRACE_SCOPE("ImageCache::Load");
+  std::string ext = Path::Extension(path);
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  std::unique_ptr<Image> codec(ImageFactory::Get().CreateByExtension(ext));
+  if (codec == nullptr) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Unsupported image type: " + path);
+  }
+  // Read the whole file, it can live on any registered file system
+  FileSystem* fs = FileSystemFactory::Get().RetrieveForPath(path);
+  std::unique_ptr<RandomAccessFile> file;
+  size_t size = 0;
+  Status s = fs->NewRandomAccessFile(path, &file);
+  if (s.Good()) {
+    s = file->Size(&size);
+  }
+  NDArray image(options_.allocator);
+  if (s.Good()) {
+    NDArray content(DataType::kUInt8, {size}, options_.allocator);
+    if (size > 0) {
+      size_t n_read = 0;
+      char* ptr = reinterpret_cast<char*>(content.AsFlat<uint8_t>().data());
+      s = file->Read(0, size, ptr, &n_read);
+    }
+    if (s.Good()) {
+      MemoryStream stream(content);
+      s = codec->LoadInto(stream, &image);
+    }
+  }
+  if (s.Good() && scale != 1.f) {
+    const size_t w = image.dim_size(1);
+    const size_t h = image.dim_size(0);
+    const size_t sw = std::max(size_t(std::lround(w * scale)), size_t(1));
+    const size_t sh = std::max(size_t(std::lround(h * scale)), size_t(1));
+    NDArray resized(options_.allocator);
+    s = ImageOps::Resize(image,
+                         sw,
+                         sh,
+                         ImageOps::Interpolation::kArea,
+                         &resized);
+    image = std::move(resized);
+  }
+  if (s.Good()) {
+    entry->bytes = image.n_elems();
+    entry->image = std::move(image);
+  }
+  return s;
+}
+
+/*
+ *  @name   Evict
+ *  @fn     void Evict(Shard* shard) const
+ *  @brief  Drop least recently used idle entries of `shard` until its part
+ *          of the budget is met, the shard's lock must be held
+ */
+void ImageCache::Evict(Shard* shard) const {
+  const size_t budget = budget_.load(std::memory_order_relaxed) /
+                        options_.n_shard;
+  auto it = shard->lru.begin();
+  while (shard->size > budget && it != shard->lru.end()) {
+    // Idle: decoded and only referenced by the cache
+    Entry* e = *it;
+    if (e->resident && e->IsOne()) {
+      shard->size -= e->bytes;
+      it = shard->lru.erase(it);
+      shard->entries.erase(shard->entries.find(e->key));
+    } else {
+      ++it;
+    }
+  }
+}
+
+}  // namespace FaceKit
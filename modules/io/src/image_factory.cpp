@@ -8,6 +8,8 @@
  *  Copyright © 2018 Christophe Ecabert. All rights reserved.
  */
 
+#include <cstring>
+
 #include "facekit/io/image_factory.hpp"
 
 /**
@@ -15,6 +17,10 @@
  *  @brief      Development space
  */
 namespace FaceKit {
+
+/** Registered image's proxies */
+StaticRegistry<const ImageProxy*, ImageFactory::kMaxProxy>
+ImageFactory::proxies_;
   
 #pragma mark
 #pragma mark Initialization
@@ -34,34 +40,33 @@ ImageFactory& ImageFactory::Get(void) {
   
 /*
  *  @name CreateByExtension
- *  @fn Image* CreateByExtension(const std::string& extension)
- *  @brief  Create an image based on the extension type
+ *  @fn Image* CreateByExtension(const char* extension)
+ *  @brief  Create an image based on the extension type, the lookup does not
+ *          allocate
  *  @param[in]  extension  Image extension (type)
  *  @return Pointer to an instance of the given type, nullptr if type is
  *  unknown
  */
-Image* ImageFactory::CreateByExtension(const std::string& extension) {
-  Image* img = nullptr;
-  for (const auto* proxy : proxies_) {
-    if (proxy->Extension() == extension) {
-      img = proxy->Create();
-      break;
-    }
-  }
-  return img;
+Image* ImageFactory::CreateByExtension(const char* extension) {
+  const ImageProxy* const* proxy =
+          proxies_.FindIf([extension](const ImageProxy* p) {
+            return std::strcmp(p->Extension(), extension) == 0;
+          });
+  return proxy ? (*proxy)->Create() : nullptr;
 }
 
 /*
  *  @name Register
- *  @fn void Register(const ImageProxy* object)
+ *  @fn static void Register(const ImageProxy* object)
  *  @brief  Register a type of image with a given proxy.
  *  @param[in]  object  Object to register
  */
 void ImageFactory::Register(const ImageProxy* object) {
   // Alreay registered ?
-  auto it = proxies_.find(object);
-  if (it == proxies_.end()) {
-    proxies_.insert(object);
+  if (proxies_.FindIf([object](const ImageProxy* p) {
+        return p == object;
+      }) == nullptr) {
+    proxies_.Add(object);
   }
 }
   
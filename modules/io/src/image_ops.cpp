@@ -0,0 +1,596 @@
+/**
+ *  @file   image_ops.cpp
+ *  @brief  Native resize and Gaussian pyramid on 8 bits images
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   19.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "facekit/io/image_ops.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/trace.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Number of output rows processed by a task */
+static constexpr size_t kRowGrain = 16;
+
+/**
+ *  @struct Plane
+ *  @brief  Contiguous 8 bits image
+ */
+struct Plane {
+  /** First pixel */
+  const uint8_t* data;
+  /** Number of rows */
+  size_t height;
+  /** Number of columns */
+  size_t width;
+  /** Number of channels */
+  size_t channels;
+};
+
+#pragma mark -
+#pragma mark Row kernels
+
+/**
+ *  @name   BlendRows
+ *  @brief  dst = round(r0 + (r1 - r0) * w)
+ *  @param[in] r0   First row
+ *  @param[in] r1   Second row
+ *  @param[in] w    Weight of the second row
+ *  @param[in] n    Number of elements
+ *  @param[out] dst Output
+ */
+static void BlendRows(const float* r0,
+                      const float* r1,
+                      const float& w,
+                      const size_t& n,
+                      uint8_t* dst) {
+  size_t i = 0;
+#ifdef HAS_SSE2
+  const __m128 vw = _mm_set1_ps(w);
+  const __m128 half = _mm_set1_ps(0.5f);
+  for (; i + 16 <= n; i += 16) {
+    __m128i v[4];
+    for (size_t k = 0; k < 4; ++k) {
+      const __m128 a = _mm_loadu_ps(r0 + i + 4 * k);
+      const __m128 b = _mm_loadu_ps(r1 + i + 4 * k);
+      const __m128 r = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), vw));
+      v[k] = _mm_cvttps_epi32(_mm_add_ps(r, half));
+    }
+    const __m128i lo = _mm_packs_epi32(v[0], v[1]);
+    const __m128i hi = _mm_packs_epi32(v[2], v[3]);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(lo, hi));
+  }
+#endif
+  for (; i < n; ++i) {
+    const float r = r0[i] + (r1[i] - r0[i]) * w;
+    dst[i] = static_cast<uint8_t>(std::min(r + 0.5f, 255.f));
+  }
+}
+
+/**
+ *  @name   AccumulateRow
+ *  @brief  acc += w * row
+ *  @param[in] row  Row to add
+ *  @param[in] w    Weight
+ *  @param[in] n    Number of elements
+ *  @param[in,out] acc  Accumulator
+ */
+static void AccumulateRow(const float* row,
+                          const float& w,
+                          const size_t& n,
+                          float* acc) {
+  size_t i = 0;
+#ifdef HAS_SSE2
+  const __m128 vw = _mm_set1_ps(w);
+  for (; i + 4 <= n; i += 4) {
+    const __m128 a = _mm_loadu_ps(acc + i);
+    const __m128 r = _mm_loadu_ps(row + i);
+    _mm_storeu_ps(acc + i, _mm_add_ps(a, _mm_mul_ps(r, vw)));
+  }
+#endif
+  for (; i < n; ++i) {
+    acc[i] += w * row[i];
+  }
+}
+
+/**
+ *  @name   GaussianRows
+ *  @brief  dst = (r0 + 4 r1 + 6 r2 + 4 r3 + r4 + 128) >> 8
+ *  @param[in] r    Five consecutive rows
+ *  @param[in] n    Number of elements
+ *  @param[out] dst Output
+ */
+static void GaussianRows(const int32_t* const r[5],
+                         const size_t& n,
+                         uint8_t* dst) {
+  size_t i = 0;
+#ifdef HAS_SSE2
+  const __m128i bias = _mm_set1_epi32(128);
+  for (; i + 8 <= n; i += 8) {
+    __m128i v[2];
+    for (size_t k = 0; k < 2; ++k) {
+      const size_t j = i + 4 * k;
+#define LOAD_ROW(p) _mm_loadu_si128(reinterpret_cast<const __m128i*>((p) + j))
+      const __m128i a = _mm_add_epi32(LOAD_ROW(r[0]), LOAD_ROW(r[4]));
+      const __m128i b = _mm_add_epi32(LOAD_ROW(r[1]), LOAD_ROW(r[3]));
+      const __m128i c = LOAD_ROW(r[2]);
+#undef LOAD_ROW
+      __m128i s = _mm_add_epi32(a, _mm_slli_epi32(b, 2));
+      s = _mm_add_epi32(s, _mm_add_epi32(_mm_slli_epi32(c, 2),
+                                         _mm_slli_epi32(c, 1)));
+      v[k] = _mm_srli_epi32(_mm_add_epi32(s, bias), 8);
+    }
+    const __m128i p = _mm_packs_epi32(v[0], v[1]);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(p, p));
+  }
+#endif
+  for (; i < n; ++i) {
+    const int32_t s = r[0][i] + 4 * r[1][i] + 6 * r[2][i] + 4 * r[3][i] +
+                      r[4][i];
+    dst[i] = static_cast<uint8_t>((s + 128) >> 8);
+  }
+}
+
+#pragma mark -
+#pragma mark Bilinear
+
+/**
+ *  @name   LinearCoordinate
+ *  @brief  Source position of a destination index with aligned pixel
+ *          centers
+ *  @param[in] d      Destination index
+ *  @param[in] scale  Source / destination size ratio
+ *  @param[in] n      Source size
+ *  @param[out] i0    First source index, clamped
+ *  @param[out] i1    Second source index, clamped
+ *  @param[out] w     Weight of `i1`
+ *  @return Unclamped first source index
+ */
+static long LinearCoordinate(const size_t& d,
+                             const double& scale,
+                             const size_t& n,
+                             size_t* i0,
+                             size_t* i1,
+                             float* w) {
+  const double s = (static_cast<double>(d) + 0.5) * scale - 0.5;
+  const double f = std::floor(s);
+  const long v = static_cast<long>(f);
+  const long last = static_cast<long>(n) - 1;
+  *w = static_cast<float>(s - f);
+  *i0 = static_cast<size_t>(std::min(std::max(v, 0L), last));
+  *i1 = static_cast<size_t>(std::min(std::max(v + 1, 0L), last));
+  return v;
+}
+
+/**
+ *  @name   ResizeBilinear
+ *  @brief  Bilinear resampling, two passes: horizontal interpolation of the
+ *          needed source rows (cached) then vertical blending.
+ */
+static void ResizeBilinear(const Plane& src,
+                           const size_t& width,
+                           const size_t& height,
+                           uint8_t* dst) {
+  const size_t c = src.channels;
+  const size_t n = width * c;
+  const double sx = static_cast<double>(src.width) / width;
+  const double sy = static_cast<double>(src.height) / height;
+  // Horizontal table, shared by every rows
+  std::vector<size_t> x0(width), x1(width);
+  std::vector<float> wx(width);
+  for (size_t x = 0; x < width; ++x) {
+    LinearCoordinate(x, sx, src.width, &x0[x], &x1[x], &wx[x]);
+    x0[x] *= c;
+    x1[x] *= c;
+  }
+  ThreadPool::Get().ParallelFor(0,
+                                height,
+                                kRowGrain,
+                                [&](const size_t& first, const size_t& last) {
+    // Interpolated source rows, slot selected by row parity
+    std::vector<float> rows(2 * n);
+    long tags[2] = {-2, -2};
+    auto fill = [&](const long& v, const size_t& y) -> const float* {
+      const size_t slot = static_cast<size_t>(v + 2) & 1;
+      float* h = &rows[slot * n];
+      if (tags[slot] != v) {
+        const uint8_t* s = src.data + y * src.width * c;
+        for (size_t x = 0; x < width; ++x) {
+          const uint8_t* p0 = s + x0[x];
+          const uint8_t* p1 = s + x1[x];
+          for (size_t k = 0; k < c; ++k) {
+            const float a = p0[k];
+            h[x * c + k] = a + (p1[k] - a) * wx[x];
+          }
+        }
+        tags[slot] = v;
+      }
+      return h;
+    };
+    for (size_t y = first; y < last; ++y) {
+      size_t y0, y1;
+      float wy;
+      const long v = LinearCoordinate(y, sy, src.height, &y0, &y1, &wy);
+      const float* r0 = fill(v, y0);
+      const float* r1 = fill(v + 1, y1);
+      BlendRows(r0, r1, wy, n, dst + y * n);
+    }
+  });
+}
+
+#pragma mark -
+#pragma mark Area
+
+/**
+ *  @struct AreaTable
+ *  @brief  Source indices and coverage of every destination index along an
+ *          axis, stored contiguously (`offset[d]` to `offset[d + 1]`)
+ */
+struct AreaTable {
+  /** Start of each destination index */
+  std::vector<size_t> offset;
+  /** Source index */
+  std::vector<size_t> index;
+  /** Normalized coverage */
+  std::vector<float> weight;
+
+  /** Build table for a `n` to `d` reduction */
+  AreaTable(const size_t& n, const size_t& d) {
+    const double scale = static_cast<double>(n) / d;
+    offset.reserve(d + 1);
+    for (size_t k = 0; k < d; ++k) {
+      offset.push_back(index.size());
+      const double start = k * scale;
+      const double end = std::min((k + 1) * scale, static_cast<double>(n));
+      const size_t s0 = static_cast<size_t>(std::floor(start));
+      const size_t s1 = std::min(static_cast<size_t>(std::ceil(end)), n);
+      for (size_t s = s0; s < s1; ++s) {
+        const double w = (std::min(end, s + 1.0) -
+                          std::max(start, static_cast<double>(s))) / scale;
+        if (w > 1e-6) {
+          index.push_back(s);
+          weight.push_back(static_cast<float>(w));
+        }
+      }
+    }
+    offset.push_back(index.size());
+  }
+};
+
+/**
+ *  @name   ResizeArea
+ *  @brief  Area averaging for reduction in both directions
+ */
+static void ResizeArea(const Plane& src,
+                       const size_t& width,
+                       const size_t& height,
+                       uint8_t* dst) {
+  const size_t c = src.channels;
+  const size_t n = width * c;
+  const AreaTable tx(src.width, width);
+  const AreaTable ty(src.height, height);
+  ThreadPool::Get().ParallelFor(0,
+                                height,
+                                kRowGrain,
+                                [&](const size_t& first, const size_t& last) {
+    std::vector<float> row(n);
+    std::vector<float> acc(n);
+    for (size_t y = first; y < last; ++y) {
+      std::fill(acc.begin(), acc.end(), 0.f);
+      for (size_t j = ty.offset[y]; j < ty.offset[y + 1]; ++j) {
+        // Horizontal reduction of one source row
+        const uint8_t* s = src.data + ty.index[j] * src.width * c;
+        for (size_t x = 0; x < width; ++x) {
+          float* h = &row[x * c];
+          std::fill(h, h + c, 0.f);
+          for (size_t i = tx.offset[x]; i < tx.offset[x + 1]; ++i) {
+            const uint8_t* p = s + tx.index[i] * c;
+            const float w = tx.weight[i];
+            for (size_t k = 0; k < c; ++k) {
+              h[k] += w * p[k];
+            }
+          }
+        }
+        AccumulateRow(row.data(), ty.weight[j], n, acc.data());
+      }
+      // Weights sum to one, blending with itself only rounds
+      BlendRows(acc.data(), acc.data(), 0.f, n, dst + y * n);
+    }
+  });
+}
+
+#pragma mark -
+#pragma mark Pyramid
+
+/**
+ *  @name   Reflect101
+ *  @brief  Border index, reflected without repeating the edge (dcb|abcd|cba)
+ */
+static size_t Reflect101(long i, const size_t& n) {
+  const long last = static_cast<long>(n) - 1;
+  if (last == 0) {
+    return 0;
+  }
+  while (i < 0 || i > last) {
+    i = i < 0 ? -i : 2 * last - i;
+  }
+  return static_cast<size_t>(i);
+}
+
+/**
+ *  @name   PyrDownImpl
+ *  @brief  5x5 Gaussian blur + decimation, separable integer passes
+ */
+static void PyrDownImpl(const Plane& src,
+                        const size_t& width,
+                        const size_t& height,
+                        uint8_t* dst) {
+  const size_t c = src.channels;
+  const size_t n = width * c;
+  // Horizontal taps of each output column
+  std::vector<size_t> tab(5 * width);
+  for (size_t x = 0; x < width; ++x) {
+    for (long k = 0; k < 5; ++k) {
+      tab[5 * x + k] = Reflect101(2 * static_cast<long>(x) + k - 2,
+                                  src.width) * c;
+    }
+  }
+  ThreadPool::Get().ParallelFor(0,
+                                height,
+                                kRowGrain,
+                                [&](const size_t& first, const size_t& last) {
+    // Filtered source rows, slot selected by row index modulo 5
+    std::vector<int32_t> rows(5 * n);
+    long tags[5] = {-3, -3, -3, -3, -3};
+    const int32_t* r[5];
+    for (size_t y = first; y < last; ++y) {
+      for (long k = 0; k < 5; ++k) {
+        const long v = 2 * static_cast<long>(y) + k - 2;
+        const size_t slot = static_cast<size_t>(v + 5) % 5;
+        int32_t* h = &rows[slot * n];
+        if (tags[slot] != v) {
+          const uint8_t* s = src.data + Reflect101(v, src.height) *
+                                        src.width * c;
+          for (size_t x = 0; x < width; ++x) {
+            const size_t* t = &tab[5 * x];
+            for (size_t j = 0; j < c; ++j) {
+              h[x * c + j] = s[t[0] + j] + 4 * s[t[1] + j] + 6 * s[t[2] + j] +
+                             4 * s[t[3] + j] + s[t[4] + j];
+            }
+          }
+          tags[slot] = v;
+        }
+        r[k] = h;
+      }
+      GaussianRows(r, n, dst + y * n);
+    }
+  });
+}
+
+#pragma mark -
+#pragma mark Helpers
+
+/**
+ *  @name   CheckImage
+ *  @brief  Validate an 8 bits image array and describe it
+ *  @param[in] a      Array
+ *  @param[out] plane Image description, `data` is not set
+ *  @return kInvalidArgument if not an image
+ */
+static Status CheckImage(const NDArray& a, Plane* plane) {
+  if (a.type() != DataType::kUInt8 || (a.dims() != 2 && a.dims() != 3)) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Expect kUInt8 array of shape [H x W] or [H x W x C]");
+  }
+  plane->height = a.dim_size(0);
+  plane->width = a.dim_size(1);
+  plane->channels = a.dims() == 3 ? a.dim_size(2) : 1;
+  if (plane->height == 0 || plane->width == 0 || plane->channels == 0) {
+    return Status(Status::Type::kInvalidArgument, "Empty image");
+  }
+  return Status();
+}
+
+/**
+ *  @name   Prepare
+ *  @brief  Give a contiguous reference on `src`, held in `keep`. Holding a
+ *          reference makes `dst->Resize` allocate a new buffer when `dst`
+ *          aliases `src`.
+ */
+static const uint8_t* Prepare(const NDArray& src, NDArray* keep) {
+  if (src.IsContiguous()) {
+    *keep = src;
+  } else {
+    src.DeepCopy(keep);
+  }
+  const NDArray& k = *keep;
+  return k.AsFlat<uint8_t>().data();
+}
+
+/**
+ *  @name   ResizePlane
+ *  @brief  Dispatch resize on a given image
+ */
+static Status ResizePlane(const Plane& src,
+                          const size_t& rank,
+                          const size_t& width,
+                          const size_t& height,
+                          const ImageOps::Interpolation& interp,
+                          NDArray* dst) {
+  if (width == 0 || height == 0) {
+    return Status(Status::Type::kInvalidArgument, "Empty output size");
+  }
+  if (rank == 2) {
+    dst->Resize(DataType::kUInt8, {height, width});
+  } else {
+    dst->Resize(DataType::kUInt8, {height, width, src.channels});
+  }
+  uint8_t* out = dst->AsFlat<uint8_t>().data();
+  if (interp == ImageOps::Interpolation::kArea &&
+      width <= src.width && height <= src.height) {
+    ResizeArea(src, width, height, out);
+  } else {
+    ResizeBilinear(src, width, height, out);
+  }
+  return Status();
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Resize
+ *  @fn     static Status Resize(const NDArray& src, const size_t& width,
+                                 const size_t& height,
+                                 const Interpolation& interp, NDArray* dst)
+ *  @brief  Resample `src` to `width` x `height`
+ *  @param[in] src    Image to resize
+ *  @param[in] width  Output width
+ *  @param[in] height Output height
+ *  @param[in] interp Resampling method
+ *  @param[out] dst   Resized image
+ *  @return kInvalidArgument if `src` is not an 8 bits image or the output
+ *          is empty
+ */
+Status ImageOps::Resize(const NDArray& src,
+                        const size_t& width,
+                        const size_t& height,
+                        const Interpolation& interp,
+                        NDArray* dst) {
+  FACEKIT_TRACE_SCOPE("ImageOps::Resize");
+  Plane plane;
+  Status s = CheckImage(src, &plane);
+  if (!s.Good()) {
+    return s;
+  }
+  NDArray keep;
+  plane.data = Prepare(src, &keep);
+  return ResizePlane(plane, src.dims(), width, height, interp, dst);
+}
+
+/*
+ *  @name   Resize
+ *  @fn     static Status Resize(const Image& src, const size_t& width,
+                                 const size_t& height,
+                                 const Interpolation& interp, NDArray* dst)
+ *  @brief  Resample an image's own buffer to `width` x `height`
+ *  @param[in] src    Image to resize
+ *  @param[in] width  Output width
+ *  @param[in] height Output height
+ *  @param[in] interp Resampling method
+ *  @param[out] dst   Resized image
+ *  @return kInvalidArgument if `src` is empty or the output is empty
+ */
+Status ImageOps::Resize(const Image& src,
+                        const size_t& width,
+                        const size_t& height,
+                        const Interpolation& interp,
+                        NDArray* dst) {
+  FACEKIT_TRACE_SCOPE("ImageOps::Resize");
+  if (src.data() == nullptr || src.width() == 0 || src.height() == 0) {
+    return Status(Status::Type::kInvalidArgument, "Empty image");
+  }
+  Plane plane;
+  plane.data = src.data();
+  plane.height = src.height();
+  plane.width = src.width();
+  plane.channels = static_cast<size_t>(src.format());
+  return ResizePlane(plane, 3, width, height, interp, dst);
+}
+
+/*
+ *  @name   PyrDown
+ *  @fn     static Status PyrDown(const NDArray& src, NDArray* dst)
+ *  @brief  Blur with a 5x5 Gaussian kernel then drop every other row and
+ *          column
+ *  @param[in] src  Image to downsample
+ *  @param[out] dst Downsampled image
+ *  @return kInvalidArgument if `src` is not an 8 bits image
+ */
+Status ImageOps::PyrDown(const NDArray& src, NDArray* dst) {
+  FACEKIT_TRACE_SCOPE("ImageOps::PyrDown");
+  Plane plane;
+  Status s = CheckImage(src, &plane);
+  if (!s.Good()) {
+    return s;
+  }
+  NDArray keep;
+  plane.data = Prepare(src, &keep);
+  const size_t width = (plane.width + 1) / 2;
+  const size_t height = (plane.height + 1) / 2;
+  if (src.dims() == 2) {
+    dst->Resize(DataType::kUInt8, {height, width});
+  } else {
+    dst->Resize(DataType::kUInt8, {height, width, plane.channels});
+  }
+  PyrDownImpl(plane, width, height, dst->AsFlat<uint8_t>().data());
+  return Status();
+}
+
+/*
+ *  @name   BuildPyramid
+ *  @fn     static Status BuildPyramid(const NDArray& src,
+                                       const size_t& n_level,
+                                       std::vector<NDArray>* pyramid)
+ *  @brief  Gaussian pyramid, level 0 shares `src`'s buffer and each next
+ *          level is `PyrDown` of the previous one
+ *  @param[in] src      Base image
+ *  @param[in] n_level  Maximum number of levels, including the base
+ *  @param[in,out] pyramid  Levels
+ *  @return kInvalidArgument if `src` is not an 8 bits image
+ */
+Status ImageOps::BuildPyramid(const NDArray& src,
+                              const size_t& n_level,
+                              std::vector<NDArray>* pyramid) {
+  FACEKIT_TRACE_SCOPE("ImageOps::BuildPyramid");
+  Plane plane;
+  Status s = CheckImage(src, &plane);
+  if (!s.Good()) {
+    return s;
+  }
+  if (n_level == 0) {
+    pyramid->clear();
+    return s;
+  }
+  if (pyramid->empty()) {
+    pyramid->emplace_back();
+  }
+  (*pyramid)[0] = src;
+  size_t k = 1;
+  for (; k < n_level; ++k) {
+    const NDArray& prev = (*pyramid)[k - 1];
+    if (prev.dim_size(0) == 1 && prev.dim_size(1) == 1) {
+      break;
+    }
+    if (pyramid->size() <= k) {
+      pyramid->emplace_back();
+    }
+    s = PyrDown((*pyramid)[k - 1], &(*pyramid)[k]);
+    if (!s.Good()) {
+      return s;
+    }
+  }
+  pyramid->resize(k);
+  return s;
+}
+
+}  // namespace FaceKit
@@ -0,0 +1,120 @@
+/**
+ *  @file   image_writer.cpp
+ *  @brief  Streaming image encoder interface, accept horizontal strips
+ *          incrementally
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   16.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include "facekit/io/image_writer.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   ImageWriter
+ *  @fn     ImageWriter(void)
+ *  @brief  Constructor
+ */
+ImageWriter::ImageWriter(void) : stream_(nullptr),
+                                 width_(0),
+                                 height_(0),
+                                 format_(Image::Format::kGrayscale),
+                                 row_(0),
+                                 open_(false) {
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Open
+ *  @fn     Status Open(std::ostream* stream, const size_t& width,
+                        const size_t& height, const Image::Format& format)
+ *  @brief  Start a new image, write its header into `stream`
+ *  @param[in] stream Where to write the encoded image
+ *  @param[in] width  Image width
+ *  @param[in] height Image height
+ *  @param[in] format Image format
+ *  @return Operation status
+ */
+Status ImageWriter::Open(std::ostream* stream,
+                         const size_t& width,
+                         const size_t& height,
+                         const Image::Format& format) {
+  if (open_) {
+    return Status(Status::Type::kAlreadyExists, "Writer is already open");
+  }
+  if (stream == nullptr || !stream->good()) {
+    return Status(Status::Type::kInvalidArgument, "Stream has errors");
+  }
+  if (width == 0 || height == 0) {
+    return Status(Status::Type::kInvalidArgument, "Empty image");
+  }
+  stream_ = stream;
+  width_ = width;
+  height_ = height;
+  format_ = format;
+  row_ = 0;
+  Status s = this->OpenImpl();
+  open_ = s.Good();
+  return s;
+}
+
+/*
+ *  @name   Write
+ *  @fn     Status Write(const uint8_t* rows, const size_t& n_rows)
+ *  @brief  Encode the next `n_rows` rows. Rows are packed, i.e. the stride
+ *          is width * format bytes.
+ *  @param[in] rows   Pixels of the strip
+ *  @param[in] n_rows Number of rows in the strip
+ *  @return Operation status
+ */
+Status ImageWriter::Write(const uint8_t* rows, const size_t& n_rows) {
+  if (!open_) {
+    return Status(Status::Type::kInvalidArgument, "Writer is not open");
+  }
+  if (row_ + n_rows > height_) {
+    return Status(Status::Type::kOutOfRange,
+                  "Strip goes past the end of the image");
+  }
+  if (n_rows == 0) {
+    return Status();
+  }
+  Status s = this->WriteImpl(rows, n_rows);
+  if (s.Good()) {
+    row_ += n_rows;
+  }
+  return s;
+}
+
+/*
+ *  @name   Close
+ *  @fn     Status Close(void)
+ *  @brief  Finalize the image once all rows have been written
+ *  @return Operation status
+ */
+Status ImageWriter::Close(void) {
+  if (!open_) {
+    return Status(Status::Type::kInvalidArgument, "Writer is not open");
+  }
+  if (row_ != height_) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Missing rows: " + std::to_string(height_ - row_));
+  }
+  open_ = false;
+  Status s = this->CloseImpl();
+  stream_ = nullptr;
+  return s;
+}
+
+}  // namespace FaceKit
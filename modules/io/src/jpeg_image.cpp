@@ -9,13 +9,17 @@
  */
 
 #include <setjmp.h>
-#include <vector>
+#include <algorithm>
 #include <cstdio> // In order to have size_t define in jpeglib.h
+#include <cstring>
+#include <vector>
 
 #include "jpeglib.h"
+#include "jerror.h"
 
 #include "facekit/io/jpeg_image.hpp"
 #include "facekit/io/image_factory.hpp"
+#include "facekit/io/image_writer.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -53,103 +57,314 @@ void ErrorExit(j_common_ptr cinfo) {
   longjmp(myerr->setjmp_buffer, 1);
 }
 
+/**
+ *  @struct StreamSource
+ *  @brief  libjpeg data source pulling from a std::istream through a fixed
+ *          size buffer, avoid loading the whole stream in memory.
+ */
+struct StreamSource {
+  /** Buffer size */
+  enum {kBufferSize = 16384};
+  /** "public" fields */
+  struct jpeg_source_mgr pub;
+  /** Stream to read from */
+  std::istream* stream;
+  /** Read buffer */
+  JOCTET buffer[kBufferSize];
+};
+
+/*
+ * Nothing to do, buffer is filled on demand
+ */
+void InitSource(j_decompress_ptr cinfo) {
+}
+
+/*
+ * Refill the buffer from the stream, insert a fake EOI marker at the end of
+ * the stream like libjpeg's own stdio source does.
+ */
+boolean FillInputBuffer(j_decompress_ptr cinfo) {
+  StreamSource* src = (StreamSource*) cinfo->src;
+  src->stream->read(reinterpret_cast<char*>(src->buffer),
+                    StreamSource::kBufferSize);
+  size_t n = static_cast<size_t>(src->stream->gcount());
+  if (n == 0) {
+    WARNMS(cinfo, JWRN_JPEG_EOF);
+    src->buffer[0] = (JOCTET) 0xFF;
+    src->buffer[1] = (JOCTET) JPEG_EOI;
+    n = 2;
+  }
+  src->pub.next_input_byte = src->buffer;
+  src->pub.bytes_in_buffer = n;
+  return TRUE;
+}
+
+/*
+ * Skip `num_bytes` of data (i.e. APPn markers)
+ */
+void SkipInputData(j_decompress_ptr cinfo, long num_bytes) {
+  StreamSource* src = (StreamSource*) cinfo->src;
+  if (num_bytes > 0) {
+    while (num_bytes > (long) src->pub.bytes_in_buffer) {
+      num_bytes -= (long) src->pub.bytes_in_buffer;
+      FillInputBuffer(cinfo);
+    }
+    src->pub.next_input_byte += (size_t) num_bytes;
+    src->pub.bytes_in_buffer -= (size_t) num_bytes;
+  }
+}
+
+/*
+ * Nothing to release
+ */
+void TermSource(j_decompress_ptr cinfo) {
+}
+
+/**
+ *  @struct DecoderContext
+ *  @brief  Decompression object reused across images by a given thread,
+ *          libjpeg keeps its permanent pool alive between images.
+ */
+struct DecoderContext {
+  /** Decompression parameters */
+  struct jpeg_decompress_struct cinfo;
+  /** Error handler, must live as long as `cinfo` */
+  ErrorManager jerr;
+  /** Data source */
+  StreamSource source;
+
+  /**
+   *  @name   DecoderContext
+   *  @fn     DecoderContext(void)
+   *  @brief  Constructor
+   */
+  DecoderContext(void) {
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jpeg_create_decompress(&cinfo);
+    // Once created, errors jump back into LoadInto
+    jerr.pub.error_exit = ErrorExit;
+    source.pub.init_source = InitSource;
+    source.pub.fill_input_buffer = FillInputBuffer;
+    source.pub.skip_input_data = SkipInputData;
+    source.pub.resync_to_restart = jpeg_resync_to_restart;
+    source.pub.term_source = TermSource;
+    source.pub.bytes_in_buffer = 0;
+    source.pub.next_input_byte = nullptr;
+    source.stream = nullptr;
+    cinfo.src = &source.pub;
+  }
+
+  /**
+   *  @name   ~DecoderContext
+   *  @fn     ~DecoderContext(void)
+   *  @brief  Destructor
+   */
+  ~DecoderContext(void) {
+    jpeg_destroy_decompress(&cinfo);
+  }
+
+  /**
+   *  @name   Get
+   *  @fn     static DecoderContext& Get(void)
+   *  @brief  Context of the calling thread
+   */
+  static DecoderContext& Get(void) {
+    static thread_local DecoderContext ctx;
+    return ctx;
+  }
+};
+
+/** Maximum number of scanlines requested per jpeg_read_scanlines call */
+static constexpr JDIMENSION kMaxRowsPerRead = 16;
+
+/**
+ *  @name   SetupScaling
+ *  @fn     void SetupScaling(const size_t& scale, const size_t& max_dim,
+                              struct jpeg_decompress_struct* cinfo)
+ *  @brief  Select DCT scaling, must be called after `jpeg_read_header` which
+ *          resets the decompression parameters.
+ *  @param[in] scale    Requested downscaling factor
+ *  @param[in] max_dim  Maximum output dimension, 0 if unused
+ *  @param[in,out] cinfo  Decompression parameters
+ */
+void SetupScaling(const size_t& scale,
+                  const size_t& max_dim,
+                  struct jpeg_decompress_struct* cinfo) {
+  // Only 1/1, 1/2, 1/4, 1/8 are supported by every libjpeg flavour
+  unsigned int denom = 1;
+  if (max_dim > 0) {
+    const size_t dim = std::max(cinfo->image_width, cinfo->image_height);
+    while (denom < 8 && (dim + denom - 1) / denom > max_dim) {
+      denom *= 2;
+    }
+  } else {
+    while (denom < 8 && denom * 2 <= scale) {
+      denom *= 2;
+    }
+  }
+  cinfo->scale_num = 1;
+  cinfo->scale_denom = denom;
+}
+
+/**
+ *  @name   DecodeRegion
+ *  @fn     bool DecodeRegion(const Image::Region& region,
+                              struct jpeg_decompress_struct* cinfo,
+                              NDArray* dst)
+ *  @brief  Decode \p region only, must be called right after
+ *          `jpeg_start_decompress`. With libjpeg-turbo the rows above are
+ *          skipped (entropy decoding only) and only the iMCU columns
+ *          covering the region are reconstructed. Decoding stops after the
+ *          last row of the region, the decompressor is aborted.
+ *  @param[in] region     Rectangle to decode, in output coordinates
+ *  @param[in,out] cinfo  Started decompressor
+ *  @param[out] dst       Region's pixels
+ *  @return False if \p region does not fit in the image
+ */
+bool DecodeRegion(const Image::Region& region,
+                  struct jpeg_decompress_struct* cinfo,
+                  NDArray* dst) {
+  if (region.x + region.width > cinfo->output_width ||
+      region.y + region.height > cinfo->output_height) {
+    jpeg_abort_decompress(cinfo);
+    return false;
+  }
+  const size_t n_comp = static_cast<size_t>(cinfo->output_components);
+  dst->Resize(DataType::kUInt8, {region.height, region.width, n_comp});
+  JDIMENSION x0 = 0;
+#ifdef LIBJPEG_TURBO_VERSION
+  // Output rows are narrowed to the iMCU columns covering the region, `x0`
+  // is moved to the closest iMCU boundary
+  JDIMENSION width = static_cast<JDIMENSION>(region.width);
+  x0 = static_cast<JDIMENSION>(region.x);
+  jpeg_crop_scanline(cinfo, &x0, &width);
+  jpeg_skip_scanlines(cinfo, static_cast<JDIMENSION>(region.y));
+#endif
+  // Scanlines are decoded in a scratch buffer, only the region's columns
+  // are copied out
+  const size_t stride = cinfo->output_width * n_comp;
+  const size_t offset = (region.x - x0) * n_comp;
+  const size_t dst_stride = region.width * n_comp;
+  static thread_local std::vector<JSAMPLE> scratch;
+  scratch.resize(kMaxRowsPerRead * stride);
+  JSAMPROW rows[kMaxRowsPerRead];
+  for (JDIMENSION r = 0; r < kMaxRowsPerRead; ++r) {
+    rows[r] = &scratch[r * stride];
+  }
+  auto* ptr = dst->AsFlat<uint8_t>().data();
+  const size_t last = region.y + region.height;
+  while (cinfo->output_scanline < last) {
+    const size_t first = cinfo->output_scanline;
+    const JDIMENSION n = jpeg_read_scanlines(cinfo,
+                                             rows,
+                                             std::min<JDIMENSION>(
+                                                kMaxRowsPerRead,
+                                                last - first));
+    for (JDIMENSION r = 0; r < n; ++r) {
+      if (first + r >= region.y) {
+        std::memcpy(&ptr[(first + r - region.y) * dst_stride],
+                    rows[r] + offset,
+                    dst_stride);
+      }
+    }
+  }
+  // Remaining rows are never decoded
+  jpeg_abort_decompress(cinfo);
+  return true;
+}
+
+/**
+ *  @name   Quality
+ *  @fn     int Quality(const int& level)
+ *  @brief  Encoder quality for a given compression level
+ *  @param[in] level  Compression level, negative for default (i.e. 100)
+ *  @return Quality in [1, 100]
+ */
+int Quality(const int& level) {
+  return level < 0 ? 100 : std::min(std::max(level, 1), 100);
+}
+
 
 #pragma mark -
 #pragma mark Initialization
   
 /*
- *  @name Load
- *  @fn Status Load(std::istream& stream) override
- *  @brief  Load image from dist
+ *  @name LoadInto
+ *  @fn Status LoadInto(std::istream& stream, NDArray* dst) override
+ *  @brief  Decode image into a caller provided array
  *  @param[in]  stream  Binary stream from where to load the ressource
+ *  @param[out] dst     Where to decode the pixels
  *  @return Operation status
  */
-Status JPEGImage::Load(std::istream& stream) {
+Status JPEGImage::LoadInto(std::istream& stream, NDArray* dst) {
   Status status;
   if (stream.good()) {
-    int err = -1;
-    // Can not read from streams, but can read from memory. Therefore
-    // load the whole file into memory and then decode it
-    // Get stream lenght
-    auto start_pos = stream.tellg();
-    stream.seekg(0, std::ios_base::end);
-    auto lengh = stream.tellg();
-    // Return to start
-    stream.seekg(start_pos);
-    // Load raw data in memory
-    std::vector<unsigned char> buffer(lengh);
-    stream.read(reinterpret_cast<char*>(buffer.data()), lengh);
-    if (stream.good()) {
-      // This struct contains the JPEG decompression parameters and pointers to
-      // working space (which is allocated as needed by the JPEG library).
-      struct jpeg_decompress_struct cinfo;
-      // We use our private extension JPEG error handler.
-      // Note that this struct must live as long as the main JPEG parameter
-      // struct, to avoid dangling-pointer problems.
-      ErrorManager jerr;
-      // Step 1: allocate and initialize JPEG decompression object
-      // We set up the normal JPEG error routines, then override error_exit.
-      cinfo.err = jpeg_std_error(&jerr.pub);
-      jerr.pub.error_exit = ErrorExit;
-      // Establish the setjmp return context for my_error_exit to use.
-      if (setjmp(jerr.setjmp_buffer)) {
-        // If we get here, the JPEG code has signaled an error.
-        // We need to clean up the JPEG object, close the input file, and
-        // return.
-        jpeg_destroy_decompress(&cinfo);
+    // Must survive longjmp
+    volatile int err = -1;
+    // Decoder is reused by the calling thread, data are pulled from the
+    // stream on demand and decoded straight into `dst`.
+    DecoderContext& ctx = DecoderContext::Get();
+    struct jpeg_decompress_struct& cinfo = ctx.cinfo;
+    ctx.source.stream = &stream;
+    ctx.source.pub.bytes_in_buffer = 0;
+    ctx.source.pub.next_input_byte = nullptr;
+    ctx.jerr.pub.num_warnings = 0;
+    // Establish the setjmp return context for my_error_exit to use.
+    if (setjmp(ctx.jerr.setjmp_buffer)) {
+      // If we get here, the JPEG code has signaled an error. Reset the
+      // decompression object so the context can be reused.
+      jpeg_abort_decompress(&cinfo);
+    } else {
+      // Read file parameters with jpeg_read_header()
+      jpeg_read_header(&cinfo, TRUE);
+      // Reduced resolution decoding if requested
+      SetupScaling(scale_, max_dimension_, &cinfo);
+      // Start decompressor
+      jpeg_start_decompress(&cinfo);
+      // After jpeg_start_decompress() we have the correct scaled output image
+      // dimensions available.
+      this->format_ = static_cast<Image::Format>(cinfo.output_components);
+      if (!region_.empty()) {
+        if (DecodeRegion(region_, &cinfo, dst)) {
+          this->width_ = region_.width;
+          this->height_ = region_.height;
+          err = !ctx.jerr.pub.num_warnings ? 0 : -1;
+        } else {
+          err = -2;
+        }
       } else {
-        // Now we can initialize the JPEG decompression object.
-        jpeg_create_decompress(&cinfo);
-        // Step 2: specify data source (eg, a file)
-        jpeg_mem_src (&cinfo, buffer.data(), buffer.size());
-        // Step 3: read file parameters with jpeg_read_header()
-        jpeg_read_header(&cinfo, TRUE);
-        // Step 5: Start decompressor
-        jpeg_start_decompress(&cinfo);
-        // We may need to do some setup of our own at this point before reading
-        // the data.  After jpeg_start_decompress() we have the correct scaled
-        // output image dimensions available, as well as the output colormap
-        // if we asked for color quantization.
-        // In this example, we need to make an output work buffer of the right
-        // size.
         // JSAMPLEs per row in output buffer
-        int row_stride = cinfo.output_width * cinfo.output_components;
-        // Allocate buffer + define color space
+        const size_t row_stride = (cinfo.output_width *
+                                   cinfo.output_components);
+        // Define destination + color space
         this->width_ = cinfo.output_width;
         this->height_ = cinfo.output_height;
-        this->format_ = static_cast<Image::Format>(cinfo.output_components);
-        this->buffer_.Resize(DataType::kUInt8,
-                             {this->height_, this->width_, this->format_});
-        // Single row buffer
-        JSAMPARRAY work_buffer;
-        work_buffer = (*cinfo.mem->alloc_sarray)((j_common_ptr) &cinfo,
-                                                 JPOOL_IMAGE,
-                                                 row_stride,
-                                                 1);
-        // Step 6: while (scan lines remain to be read)
-        //           jpeg_read_scanlines(...);
-        // Here we use the library's state variable cinfo.output_scanline as the
-        // loop counter, so that we don't have to keep track ourselves.
-        auto* ptr = this->data();
-        int i = 0;
+        dst->Resize(DataType::kUInt8,
+                    {this->height_, this->width_, this->format_});
+        // Decode scanlines directly into the destination, several rows per
+        // call so the decoder can emit a whole iMCU row at once
+        auto* ptr = dst->AsFlat<uint8_t>().data();
+        JSAMPROW rows[kMaxRowsPerRead];
         while (cinfo.output_scanline < cinfo.output_height) {
-          // jpeg_read_scanlines expects an array of pointers to scanlines.
-          // Here the array is only one element long, but you could ask for
-          // more than one scanline at a time if that's more convenient.
-          jpeg_read_scanlines(&cinfo, work_buffer, 1);
-          // Assume put_scanline_someplace wants a pointer and sample count.
-          std::copy_n(work_buffer[0], row_stride, &ptr[i * row_stride]);
-          ++i;
+          const JDIMENSION n = std::min<JDIMENSION>(kMaxRowsPerRead,
+                                                    cinfo.output_height -
+                                                    cinfo.output_scanline);
+          for (JDIMENSION r = 0; r < n; ++r) {
+            rows[r] = &ptr[(cinfo.output_scanline + r) * row_stride];
+          }
+          jpeg_read_scanlines(&cinfo, rows, n);
         }
-        // Step 7: Finish decompression
+        // Finish decompression, object goes back to its initial state
         jpeg_finish_decompress(&cinfo);
-        // Step 8: Release JPEG decompression object
-        jpeg_destroy_decompress(&cinfo);
         // Check errors
-        err = !jerr.pub.num_warnings ? 0 : -1;
+        err = !ctx.jerr.pub.num_warnings ? 0 : -1;
       }
     }
-    if (err != 0) {
+    ctx.source.stream = nullptr;
+    if (err == -2) {
+      status = Status(Status::Type::kInvalidArgument,
+                      "Region is outside of the image");
+    } else if (err != 0) {
       status = Status(Status::Type::kInternalError, "Error while reading JPEG");
     }
   } else {
@@ -158,6 +373,43 @@ Status JPEGImage::Load(std::istream& stream) {
   return status;
 }
 
+/*
+ *  @name ParseHeader
+ *  @fn Status ParseHeader(std::istream& stream, ImageInfo* info) override
+ *  @brief  Parse image header without decoding the pixels
+ *  @param[in]  stream  Binary stream from where to read the header
+ *  @param[out] info    Image properties
+ *  @return Operation status
+ */
+Status JPEGImage::ParseHeader(std::istream& stream, ImageInfo* info) {
+  // Must survive longjmp
+  volatile int err = -1;
+  DecoderContext& ctx = DecoderContext::Get();
+  struct jpeg_decompress_struct& cinfo = ctx.cinfo;
+  ctx.source.stream = &stream;
+  ctx.source.pub.bytes_in_buffer = 0;
+  ctx.source.pub.next_input_byte = nullptr;
+  ctx.jerr.pub.num_warnings = 0;
+  if (setjmp(ctx.jerr.setjmp_buffer) == 0) {
+    // Read markers up to the start of the compressed data only
+    jpeg_read_header(&cinfo, TRUE);
+    SetupScaling(scale_, max_dimension_, &cinfo);
+    // Output dimensions/components as LoadInto would produce them
+    jpeg_calc_output_dimensions(&cinfo);
+    info->width = cinfo.output_width;
+    info->height = cinfo.output_height;
+    info->format = static_cast<Image::Format>(cinfo.output_components);
+    err = !ctx.jerr.pub.num_warnings ? 0 : -1;
+  }
+  // Reset the decompression object so the context can be reused.
+  jpeg_abort_decompress(&cinfo);
+  ctx.source.stream = nullptr;
+  if (err != 0) {
+    return Status(Status::Type::kInternalError, "Error while reading JPEG");
+  }
+  return Status();
+}
+
 /*
  *  @name Save
  *  @fn Status Save(std::ostream& stream) const override
@@ -212,8 +464,9 @@ Status JPEGImage::Save(std::ostream& stream) const {
     // since the defaults depend on the source color space.)
     jpeg_set_defaults(&cinfo);
     // Now you can set any non-default parameters you wish to.
-    // Here we just illustrate the use of quality (quantization table) scaling:
-    jpeg_set_quality(&cinfo, 100, TRUE /* limit to baseline-JPEG values */);
+    // Quality (quantization table) scaling, best quality by default
+    jpeg_set_quality(&cinfo, Quality(level_),
+                     TRUE /* limit to baseline-JPEG values */);
     
     // Step 4: Start compressor
     // TRUE ensures that we will write a complete interchange-JPEG file.
@@ -258,6 +511,182 @@ Status JPEGImage::Save(std::ostream& stream) const {
   return status;
 }
   
+#pragma mark -
+#pragma mark Streaming writer
+
+/**
+ *  @struct StreamDestination
+ *  @brief  libjpeg destination pushing compressed data to a std::ostream
+ *          through a fixed size buffer
+ */
+struct StreamDestination {
+  /** Buffer size */
+  enum {kBufferSize = 16384};
+  /** "public" fields */
+  struct jpeg_destination_mgr pub;
+  /** Stream to write to */
+  std::ostream* stream;
+  /** Write buffer */
+  JOCTET buffer[kBufferSize];
+};
+
+/*
+ * Prepare buffer before the first write
+ */
+void InitDestination(j_compress_ptr cinfo) {
+  StreamDestination* dest = (StreamDestination*) cinfo->dest;
+  dest->pub.next_output_byte = dest->buffer;
+  dest->pub.free_in_buffer = StreamDestination::kBufferSize;
+}
+
+/*
+ * Buffer is full, flush it entirely (free_in_buffer is meaningless here)
+ */
+boolean EmptyOutputBuffer(j_compress_ptr cinfo) {
+  StreamDestination* dest = (StreamDestination*) cinfo->dest;
+  dest->stream->write(reinterpret_cast<const char*>(dest->buffer),
+                      StreamDestination::kBufferSize);
+  if (!dest->stream->good()) {
+    ERREXIT(cinfo, JERR_FILE_WRITE);
+  }
+  dest->pub.next_output_byte = dest->buffer;
+  dest->pub.free_in_buffer = StreamDestination::kBufferSize;
+  return TRUE;
+}
+
+/*
+ * Flush remaining data
+ */
+void TermDestination(j_compress_ptr cinfo) {
+  StreamDestination* dest = (StreamDestination*) cinfo->dest;
+  const size_t n = StreamDestination::kBufferSize - dest->pub.free_in_buffer;
+  if (n > 0) {
+    dest->stream->write(reinterpret_cast<const char*>(dest->buffer), n);
+  }
+  dest->stream->flush();
+  if (!dest->stream->good()) {
+    ERREXIT(cinfo, JERR_FILE_WRITE);
+  }
+}
+
+/**
+ *  @class  JPEGImageWriter
+ *  @brief  Streaming JPEG encoder, scanlines are compressed as they come and
+ *          the output is flushed every `StreamDestination::kBufferSize` bytes
+ */
+class JPEGImageWriter : public ImageWriter {
+ public:
+  /**
+   *  @name   JPEGImageWriter
+   *  @fn     explicit JPEGImageWriter(const int& level)
+   *  @brief  Constructor
+   *  @param[in] level  Quality, negative for default
+   */
+  explicit JPEGImageWriter(const int& level) : level_(level),
+                                               created_(false) {}
+
+  /**
+   *  @name   ~JPEGImageWriter
+   *  @fn     ~JPEGImageWriter(void) override
+   *  @brief  Destructor
+   */
+  ~JPEGImageWriter(void) override {
+    if (created_) {
+      jpeg_destroy_compress(&cinfo_);
+    }
+  }
+
+ protected:
+  /** Initialize compressor and write header */
+  Status OpenImpl(void) override {
+    J_COLOR_SPACE space = JCS_UNKNOWN;
+    if (format_ == Image::Format::kGrayscale) {
+      space = JCS_GRAYSCALE;
+    } else if (format_ == Image::Format::kRGB) {
+      space = JCS_RGB;
+#ifdef JCS_EXTENSIONS
+    } else if (format_ == Image::Format::kRGBA) {
+      // libjpeg-turbo drops the alpha channel
+      space = JCS_EXT_RGBA;
+#endif
+    } else {
+      return Status(Status::Type::kInvalidArgument, "Unsupported format");
+    }
+    if (!created_) {
+      cinfo_.err = jpeg_std_error(&jerr_.pub);
+      jpeg_create_compress(&cinfo_);
+      jerr_.pub.error_exit = ErrorExit;
+      dest_.pub.init_destination = InitDestination;
+      dest_.pub.empty_output_buffer = EmptyOutputBuffer;
+      dest_.pub.term_destination = TermDestination;
+      cinfo_.dest = &dest_.pub;
+      created_ = true;
+    }
+    dest_.stream = stream_;
+    cinfo_.image_width = static_cast<JDIMENSION>(width_);
+    cinfo_.image_height = static_cast<JDIMENSION>(height_);
+    cinfo_.input_components = static_cast<int>(format_);
+    cinfo_.in_color_space = space;
+    if (setjmp(jerr_.setjmp_buffer)) {
+      jpeg_abort_compress(&cinfo_);
+      return Status(Status::Type::kInternalError, "Error while writing JPEG");
+    }
+    jpeg_set_defaults(&cinfo_);
+    jpeg_set_quality(&cinfo_, Quality(level_),
+                     TRUE /* limit to baseline-JPEG values */);
+    jpeg_start_compress(&cinfo_, TRUE);
+    return Status();
+  }
+
+  /** Compress a strip */
+  Status WriteImpl(const uint8_t* rows, const size_t& n_rows) override {
+    const size_t stride = width_ * format_;
+    if (setjmp(jerr_.setjmp_buffer)) {
+      jpeg_abort_compress(&cinfo_);
+      open_ = false;
+      return Status(Status::Type::kInternalError, "Error while writing JPEG");
+    }
+    size_t r = 0;
+    while (r < n_rows) {
+      JSAMPROW row = const_cast<JSAMPROW>(&rows[r * stride]);
+      r += jpeg_write_scanlines(&cinfo_, &row, 1);
+    }
+    return Status();
+  }
+
+  /** Finish compression, flush trailer */
+  Status CloseImpl(void) override {
+    if (setjmp(jerr_.setjmp_buffer)) {
+      jpeg_abort_compress(&cinfo_);
+      return Status(Status::Type::kInternalError, "Error while writing JPEG");
+    }
+    jpeg_finish_compress(&cinfo_);
+    return Status();
+  }
+
+ private:
+  /** Compression parameters */
+  struct jpeg_compress_struct cinfo_;
+  /** Error handler */
+  ErrorManager jerr_;
+  /** Output */
+  StreamDestination dest_;
+  /** Quality */
+  int level_;
+  /** Indicate if `cinfo_` has been created */
+  bool created_;
+};
+
+/*
+ *  @name CreateWriter
+ *  @fn ImageWriter* CreateWriter(void) const override
+ *  @brief  Create a streaming encoder, caller takes ownership
+ *  @return Writer instance
+ */
+ImageWriter* JPEGImage::CreateWriter(void) const {
+  return new JPEGImageWriter(level_);
+}
+
 #pragma mark -
 #pragma mark Registration
   
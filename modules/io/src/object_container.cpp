@@ -0,0 +1,427 @@
+/**
+ *  @file   object_container.cpp
+ *  @brief  Indexed file of serialized objects, a table of content written
+ *          after the objects gives direct access to each of them
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   21.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <limits>
+
+#include "facekit/io/object_container.hpp"
+#include "facekit/io/object_header.hpp"
+#include "facekit/io/object_manager.hpp"
+#include "facekit/core/sys/batch_file_reader.hpp"
+#include "facekit/core/sys/file_system.hpp"
+#include "facekit/core/sys/file_system_factory.hpp"
+#include "facekit/core/trace.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#pragma mark -
+#pragma mark Layout
+
+constexpr size_t ObjectContainer::kTocId;
+
+/** Last bytes of an indexed container, "FKOBJTOC" in little endian */
+static constexpr uint64_t kTocMagic = 0x434F544A424F4B46ULL;
+/** Trailer size: table size, container size, magic */
+static constexpr size_t kTrailerSize = 3 * sizeof(uint64_t);
+/** Table entry size: id, offset, size */
+static constexpr size_t kEntrySize = 3 * sizeof(uint64_t);
+/** Object header size, see `ObjectHeader` */
+static constexpr size_t kHeaderSize = 2 * sizeof(size_t);
+
+/**
+ *  @name   ParseTrailer
+ *  @brief  Validate a trailer read from the end of a file
+ *  @param[in] trailer    Trailer
+ *  @param[in] file_size  File size
+ *  @param[out] toc_size  Table size including the trailer
+ *  @param[out] base      Start of the container in the file
+ *  @return True if the trailer is valid
+ */
+static bool ParseTrailer(const uint64_t* trailer,
+                         const size_t& file_size,
+                         size_t* toc_size,
+                         size_t* base) {
+  const uint64_t n = trailer[0];
+  const uint64_t container = trailer[1];
+  if (trailer[2] != kTocMagic || n < kTrailerSize ||
+      (n - kTrailerSize) % kEntrySize != 0 ||
+      container > file_size || n + kHeaderSize > container) {
+    return false;
+  }
+  *toc_size = static_cast<size_t>(n);
+  *base = file_size - static_cast<size_t>(container);
+  return true;
+}
+
+/**
+ *  @name   ParseEntries
+ *  @brief  Convert raw table entries
+ *  @param[in] data     Entries, `kEntrySize` bytes each
+ *  @param[in] n        Number of entries
+ *  @param[out] entries Table of content
+ */
+static void ParseEntries(const uint64_t* data,
+                         const size_t& n,
+                         std::vector<ObjectContainer::Entry>* entries) {
+  entries->resize(n);
+  for (size_t k = 0; k < n; ++k, data += 3) {
+    auto& e = (*entries)[k];
+    e.id = static_cast<size_t>(data[0]);
+    e.offset = static_cast<size_t>(data[1]);
+    e.size = static_cast<size_t>(data[2]);
+  }
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ *  @name   ObjectContainer
+ *  @fn     ObjectContainer(void)
+ *  @brief  Constructor
+ */
+ObjectContainer::ObjectContainer(void) : base_(0), indexed_(false) {
+}
+
+/*
+ *  @name   ~ObjectContainer
+ *  @fn     ~ObjectContainer(void)
+ *  @brief  Destructor
+ */
+ObjectContainer::~ObjectContainer(void) = default;
+
+/*
+ *  @name   Open
+ *  @fn     Status Open(const std::string& path)
+ *  @brief  Open a file through the file system registered for `path` and
+ *          load its table of content
+ *  @param[in] path File to open, can be remote
+ *  @return Operation status
+ */
+Status ObjectContainer::Open(const std::string& path) {
+  FACEKIT_TRACE_SCOPE("ObjectContainer::Open");
+  FileSystem* fs = FileSystemFactory::Get().RetrieveForPath(path);
+  if (fs == nullptr) {
+    return Status(Status::Type::kUnimplemented,
+                  "No file system registered for: " + path);
+  }
+  path_ = path;
+  base_ = 0;
+  indexed_ = false;
+  entries_.clear();
+  index_.clear();
+  Status s = fs->NewRandomAccessFile(path, &file_);
+  size_t size = 0;
+  if (s.Good()) {
+    s = file_->Size(&size);
+  }
+  if (!s.Good()) {
+    return s;
+  }
+  size_t n_read = 0;
+  // Table of content, two reads: trailer then entries
+  uint64_t trailer[3] = {0, 0, 0};
+  size_t toc_size = 0;
+  if (size >= kTrailerSize &&
+      file_->Read(size - kTrailerSize,
+                  kTrailerSize,
+                  reinterpret_cast<char*>(trailer),
+                  &n_read).Good() &&
+      ParseTrailer(trailer, size, &toc_size, &base_)) {
+    const size_t n = (toc_size - kTrailerSize) / kEntrySize;
+    std::vector<uint64_t> data(3 * n);
+    if (n > 0) {
+      s = file_->Read(size - toc_size,
+                      n * kEntrySize,
+                      reinterpret_cast<char*>(data.data()),
+                      &n_read);
+      if (!s.Good()) {
+        return s;
+      }
+    }
+    ParseEntries(data.data(), n, &entries_);
+    indexed_ = true;
+  } else {
+    // Legacy file, walk the headers once
+    size_t pos = 0;
+    while (pos + kHeaderSize <= size) {
+      size_t hdr[2];
+      s = file_->Read(pos, kHeaderSize, reinterpret_cast<char*>(hdr), &n_read);
+      if (!s.Good()) {
+        return s;
+      }
+      const size_t payload = pos + kHeaderSize;
+      if (hdr[1] > size - payload) {
+        return Status(Status::Type::kInternalError,
+                      "Truncated object in: " + path);
+      }
+      if (hdr[0] != kTocId) {
+        entries_.push_back(Entry{hdr[0], payload, hdr[1]});
+      }
+      pos = payload + hdr[1];
+    }
+  }
+  // Keep first occurrence, same as a linear scan
+  for (size_t k = 0; k < entries_.size(); ++k) {
+    index_.emplace(entries_[k].id, k);
+  }
+  return Status();
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Find
+ *  @fn     Status Find(const size_t& id, Entry* entry) const
+ *  @brief  Locate the first object with a given ID
+ *  @param[in] id     Object ID
+ *  @param[out] entry Object location
+ *  @return kNotFound if no such object
+ */
+Status ObjectContainer::Find(const size_t& id, Entry* entry) const {
+  auto it = index_.find(id);
+  if (it == index_.end()) {
+    return Status(Status::Type::kNotFound,
+                  "No object with ID: " + std::to_string(id));
+  }
+  *entry = entries_[it->second];
+  return Status();
+}
+
+/*
+ *  @name   Read
+ *  @fn     Status Read(const size_t& id, NDArray* section) const
+ *  @brief  Read the payload of an object in a single request
+ *  @param[in] id       Object ID
+ *  @param[out] section `kUInt8` array holding the payload, keeps its
+ *                      allocator
+ *  @return Operation status
+ */
+Status ObjectContainer::Read(const size_t& id, NDArray* section) const {
+  FACEKIT_TRACE_SCOPE("ObjectContainer::Read");
+  Entry e;
+  Status s = this->Find(id, &e);
+  if (!s.Good()) {
+    return s;
+  }
+  section->Resize(DataType::kUInt8, {e.size});
+  if (e.size > 0) {
+    size_t n_read = 0;
+    char* ptr = reinterpret_cast<char*>(section->AsFlat<uint8_t>().data());
+    s = file_->Read(base_ + e.offset, e.size, ptr, &n_read);
+  }
+  return s;
+}
+
+/*
+ *  @name   Map
+ *  @fn     Status Map(const size_t& id, NDArray* section) const
+ *  @brief  Map the payload of an object in memory, pages are loaded on
+ *          demand. Falls back to `Read` for file systems without mapping
+ *          support (i.e. remote files).
+ *  @param[in] id       Object ID
+ *  @param[out] section Read-only `kUInt8` array over the payload
+ *  @return Operation status
+ */
+Status ObjectContainer::Map(const size_t& id, NDArray* section) const {
+  Entry e;
+  Status s = this->Find(id, &e);
+  if (!s.Good()) {
+    return s;
+  }
+  if (e.size > 0 &&
+      section->MapFile(path_,
+                       DataType::kUInt8,
+                       {e.size},
+                       base_ + e.offset,
+                       NDArray::MapMode::kReadOnly).Good()) {
+    return s;
+  }
+  return this->Read(id, section);
+}
+
+/*
+ *  @name   Load
+ *  @fn     Status Load(const size_t& id, Serializable* object) const
+ *  @brief  Deserialize an object from its payload
+ *  @param[in] id       Object ID
+ *  @param[out] object  Object to load
+ *  @return Operation status
+ */
+Status ObjectContainer::Load(const size_t& id, Serializable* object) const {
+  NDArray section;
+  Status s = this->Read(id, &section);
+  if (!s.Good()) {
+    return s;
+  }
+  MemoryStream stream(section);
+  if (object->Load(stream) != 0) {
+    return Status(Status::Type::kInternalError,
+                  "Error while loading object with ID: " + std::to_string(id));
+  }
+  return s;
+}
+
+/*
+ *  @name   ReadToc
+ *  @fn     static Status ReadToc(std::istream& stream, size_t* base,
+                                  std::vector<Entry>* entries)
+ *  @brief  Read the table of content of a container stored at the end of
+ *          a seekable stream. The stream position is restored.
+ *  @param[in] stream   Binary stream
+ *  @param[out] base    Position of the container's start in `stream`
+ *  @param[out] entries Table of content
+ *  @return kNotFound if the stream has no table of content
+ */
+Status ObjectContainer::ReadToc(std::istream& stream,
+                                size_t* base,
+                                std::vector<Entry>* entries) {
+  Status s(Status::Type::kNotFound, "No table of content");
+  const auto pos = stream.tellg();
+  stream.seekg(0, std::ios_base::end);
+  const auto end = stream.tellg();
+  if (pos != std::streampos(-1) && end != std::streampos(-1) &&
+      static_cast<size_t>(end) >= kTrailerSize) {
+    const size_t size = static_cast<size_t>(end);
+    uint64_t trailer[3];
+    size_t toc_size = 0;
+    stream.seekg(size - kTrailerSize);
+    stream.read(reinterpret_cast<char*>(trailer), kTrailerSize);
+    if (stream.good() && ParseTrailer(trailer, size, &toc_size, base)) {
+      const size_t n = (toc_size - kTrailerSize) / kEntrySize;
+      std::vector<uint64_t> data(3 * n);
+      stream.seekg(size - toc_size);
+      stream.read(reinterpret_cast<char*>(data.data()), n * kEntrySize);
+      if (stream.good()) {
+        ParseEntries(data.data(), n, entries);
+        s.Clear();
+      }
+    }
+  }
+  stream.clear();
+  stream.seekg(pos);
+  return s;
+}
+
+#pragma mark -
+#pragma mark Writer
+
+/*
+ *  @name   ObjectContainerWriter
+ *  @fn     explicit ObjectContainerWriter(std::ostream* stream)
+ *  @brief  Constructor, the container starts at the current position
+ *  @param[in] stream Seekable binary stream, must outlive the writer
+ */
+ObjectContainerWriter::ObjectContainerWriter(std::ostream* stream) :
+        stream_(stream),
+        base_(stream->tellp()),
+        closed_(false) {
+}
+
+/*
+ *  @name   Add
+ *  @fn     Status Add(const size_t& id, const Serializable& object)
+ *  @brief  Append an object
+ *  @param[in] id     Object ID
+ *  @param[in] object Object to serialize
+ *  @return Operation status
+ */
+Status ObjectContainerWriter::Add(const size_t& id,
+                                  const Serializable& object) {
+  if (closed_) {
+    return Status(Status::Type::kInvalidArgument, "Container already closed");
+  }
+  if (id == ObjectContainer::kTocId) {
+    return Status(Status::Type::kInvalidArgument, "Reserved object ID");
+  }
+  const size_t estimate = object.ComputeObjectSize();
+  const auto hdr = stream_->tellp();
+  *stream_ << ObjectHeader(id, estimate);
+  const auto start = stream_->tellp();
+  if (object.Save(*stream_) != 0 || !stream_->good()) {
+    return Status(Status::Type::kInternalError,
+                  "Error while writing object with ID: " + std::to_string(id));
+  }
+  // Actual size is recorded, ComputeObjectSize can be an upper bound (i.e.
+  // alignment padding). Header is patched to keep linear scan working.
+  const auto end = stream_->tellp();
+  const size_t size = static_cast<size_t>(end - start);
+  if (size != estimate) {
+    stream_->seekp(hdr);
+    *stream_ << ObjectHeader(id, size);
+    stream_->seekp(end);
+  }
+  entries_.push_back(ObjectContainer::Entry{
+          id,
+          static_cast<size_t>(start - base_),
+          size});
+  return stream_->good() ?
+         Status() :
+         Status(Status::Type::kInternalError,
+                "Error while writing object with ID: " + std::to_string(id));
+}
+
+/*
+ *  @name   Add
+ *  @fn     Status Add(const std::string& classname,
+                       const Serializable& object)
+ *  @brief  Append an object registered in the `ObjectManager`
+ *  @param[in] classname  Object's class name
+ *  @param[in] object     Object to serialize
+ *  @return kNotFound if `classname` is not registered
+ */
+Status ObjectContainerWriter::Add(const std::string& classname,
+                                  const Serializable& object) {
+  const size_t id = ObjectManager::Get().GetId(classname);
+  if (id == std::numeric_limits<size_t>::max()) {
+    return Status(Status::Type::kNotFound,
+                  "Unregistered object: " + classname);
+  }
+  return this->Add(id, object);
+}
+
+/*
+ *  @name   Close
+ *  @fn     Status Close(void)
+ *  @brief  Write the table of content, no object can be added afterward
+ *  @return Operation status
+ */
+Status ObjectContainerWriter::Close(void) {
+  if (closed_) {
+    return Status(Status::Type::kInvalidArgument, "Container already closed");
+  }
+  const size_t n = entries_.size();
+  std::vector<uint64_t> data;
+  data.reserve(3 * n + 3);
+  for (const auto& e : entries_) {
+    data.push_back(e.id);
+    data.push_back(e.offset);
+    data.push_back(e.size);
+  }
+  const size_t toc_size = n * kEntrySize + kTrailerSize;
+  const auto pos = stream_->tellp();
+  data.push_back(toc_size);
+  data.push_back(static_cast<size_t>(pos - base_) + kHeaderSize + toc_size);
+  data.push_back(kTocMagic);
+  *stream_ << ObjectHeader(ObjectContainer::kTocId, toc_size);
+  stream_->write(reinterpret_cast<const char*>(data.data()), toc_size);
+  stream_->flush();
+  closed_ = true;
+  return stream_->good() ?
+         Status() :
+         Status(Status::Type::kInternalError, "Error while writing container");
+}
+
+}  // namespace FaceKit
@@ -50,8 +50,8 @@ ObjectHeader::ObjectHeader(const size_t id,
  *  @return Output stream to support chaining
  */
 std::ostream& operator<<(std::ostream& os, const ObjectHeader& header) {
-  os.write(reinterpret_cast<const char*>(header.id_), sizeof(header.id_));
-  os.write(reinterpret_cast<const char*>(header.size_), sizeof(header.size_));
+  os.write(reinterpret_cast<const char*>(&header.id_), sizeof(header.id_));
+  os.write(reinterpret_cast<const char*>(&header.size_), sizeof(header.size_));
   return os;
 }
 
@@ -65,8 +65,8 @@ std::ostream& operator<<(std::ostream& os, const ObjectHeader& header) {
  *  @return Output stream to support chaining
  */
 std::istream& operator>>(std::istream& is, ObjectHeader& header) {
-  is.read(reinterpret_cast<char*>(header.id_), sizeof(header.id_));
-  is.read(reinterpret_cast<char*>(header.size_), sizeof(header.size_));
+  is.read(reinterpret_cast<char*>(&header.id_), sizeof(header.id_));
+  is.read(reinterpret_cast<char*>(&header.size_), sizeof(header.size_));
   return is;
 }
   
@@ -9,18 +9,21 @@
  *  Copyright © 2017 Christophe Ecabert. All rights reserved.
  */
 
-#include <algorithm>
 #include <limits>
 #include <cstring>
 
 #include "facekit/io/object_manager.hpp"
 #include "facekit/core/error.hpp"
+#include "facekit/core/utils/static_registry.hpp"
 
 /**
  *  @namespace  FaceKit
  *  @brief      Development space
  */
 namespace FaceKit {
+
+/** Registered proxies, constant-initialized */
+static StaticRegistry<const ObjectProxy*, ObjectManager::kMaxObject> proxies;
   
 #pragma mark -
 #pragma mark Initialization
@@ -35,6 +38,14 @@ ObjectManager& ObjectManager::Get(void) {
   static ObjectManager manager;
   return manager;
 }
+
+/*
+ *  @name ObjectManager
+ *  @fn ObjectManager(void)
+ *  @brief  Constructor
+ */
+ObjectManager::ObjectManager(void) : registry_(nullptr) {
+}
   
 #pragma mark -
 #pragma mark Usage
@@ -42,26 +53,22 @@ ObjectManager& ObjectManager::Get(void) {
   
 /*
  *  @name Register
- *  @fn void Register(const ObjectProxy* proxy)
+ *  @fn static void Register(const ObjectProxy* proxy)
  *  @brief  Add new entry in the manager
  *  @param[in]  proxy New proxy to register with this manager
- *  @throw  ::FKError if ID already registered.
+ *  @throw  ::FKError if ID already registered or too many objects.
  */
 void ObjectManager::Register(const ObjectProxy* proxy) {
   // Trying to add an existing ID ?
-  const size_t& id = proxy->get_id();
-  auto it = std::find_if(proxies_.begin(),
-                         proxies_.end(),
-                         [&](const ObjectProxy* p) {
-                           return p->get_id() == id ? true : false;
-                         });
-  if (it == proxies_.end()) {
-    // Not registered -> add it
-    proxies_.push_back(proxy);
-  } else {
-    // Already in, throw execption
+  const size_t id = proxy->get_id();
+  const bool taken = proxies.FindIf([id](const ObjectProxy* p) {
+    return p->get_id() == id;
+  }) != nullptr;
+  if (taken || !proxies.Add(proxy)) {
     std::string msg = "Object with ID: " + std::to_string(id);
-    msg += " has already been registered, please choose a different ID";
+    msg += taken ?
+           " has already been registered, please choose a different ID" :
+           " can not be registered, too many objects";
     Status s(Status::Type::kAlreadyExists, msg);
     throw Error(s, FUNC_NAME);
   }
@@ -70,35 +77,62 @@ void ObjectManager::Register(const ObjectProxy* proxy) {
 /*
  *  @name GetId
  *  @fn size_t GetId(const std::string& classname) const
- *  @brief  Retrive the Id of a given class name
+ *  @brief  Retrive the Id of a given class name, lock-free
  *  @param[in]  classname Class name to quary
  *  @return Object's ID, if none matching class if founded ID=MAX(size_t)
  */
 size_t ObjectManager::GetId(const std::string& classname) const {
-  
-  const auto& it = id_table_.find(classname);
-  size_t id = (it == id_table_.end() ?
-               std::numeric_limits<size_t>::max() :
-               it->second);
-  return id;
+  const Registry* registry = this->Snapshot();
+  const auto it = registry->ids.find(classname);
+  return (it == registry->ids.end() ?
+          std::numeric_limits<size_t>::max() :
+          it->second);
 }
   
 /*
  *  @name GetName
- *  @fn std::string GetName(const size_t id) const
- *  @brief  Retrive the name of a given class ID
+ *  @fn const std::string& GetName(const size_t id) const
+ *  @brief  Retrive the name of a given class ID, lock-free
  *  @param[in]  id Object's ID to query
  *  @return Object's name, or empty if unknown ID.
  */
-std::string ObjectManager::GetName(const size_t id) const {
-  std::string name = "";
-  for (const auto* p : proxies_) {
-    if (p->get_id() == id) {
-      name = p->get_classname();
-      break;
+const std::string& ObjectManager::GetName(const size_t id) const {
+  static const std::string empty;
+  const Registry* registry = this->Snapshot();
+  const auto it = registry->names.find(id);
+  return it == registry->names.end() ? empty : it->second;
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ *  @name Snapshot
+ *  @fn const Registry* Snapshot(void) const
+ *  @brief  Current tables, rebuilt if objects have been registered since
+ *          the last query
+ */
+const ObjectManager::Registry* ObjectManager::Snapshot(void) const {
+  const Registry* registry = registry_.load(std::memory_order_acquire);
+  const size_t n = proxies.size();
+  if (registry == nullptr || registry->n_proxy < n) {
+    std::lock_guard<std::mutex> lock(lock_);
+    registry = registry_.load(std::memory_order_relaxed);
+    if (registry == nullptr || registry->n_proxy < n) {
+      // Publish a new snapshot, readers holding the current one are not
+      // disturbed
+      Registry* next = new Registry();
+      next->n_proxy = n;
+      for (size_t k = 0; k < n; ++k) {
+        next->ids.emplace(proxies[k]->get_classname(), proxies[k]->get_id());
+        next->names.emplace(proxies[k]->get_id(), proxies[k]->get_classname());
+      }
+      snapshots_.emplace_back(next);
+      registry_.store(next, std::memory_order_release);
+      registry = next;
     }
   }
-  return name;
+  return registry;
 }
   
 }  // namespace FaceKit
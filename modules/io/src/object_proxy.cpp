@@ -20,14 +20,15 @@ namespace FaceKit {
   
 /*
  *  @name ObjectProxy
- *  @fn ObjectProxy(const std::string& classname, const size_t id)
+ *  @fn ObjectProxy(const char* classname, const size_t id)
  *  @brief  Constructor
- *  @param[in]  classname  Class name to be represented by this proxy
+ *  @param[in]  classname  Class name to be represented by this proxy, must
+ *                         outlive the proxy
  *  @param[in]  id          Object's unique ID
  */
-ObjectProxy::ObjectProxy(const std::string& classname,
+ObjectProxy::ObjectProxy(const char* classname,
                          const size_t id) : classname_(classname), id_(id) {
-  ObjectManager::Get().Register(this);
+  ObjectManager::Register(this);
 }
   
 }  // namespace FaceKit
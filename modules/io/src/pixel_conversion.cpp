@@ -0,0 +1,290 @@
+/**
+ *  @file   pixel_conversion.cpp
+ *  @brief  Private pixel format conversions shared by the image codecs. Hot
+ *          loops use SIMD kernels selected at runtime.
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   18.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAS_NEON
+#include <arm_neon.h>
+#endif
+
+#include "facekit/core/sys/cpu_info.hpp"
+#include "pixel_conversion.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+namespace internal {
+
+#pragma mark -
+#pragma mark Scalar kernels
+
+/** BGR <-> RGB */
+static void SwapRB3(const uint8_t* src, uint8_t* dst, const size_t& n) {
+  for (size_t k = 0; k < n; ++k, src += 3, dst += 3) {
+    const uint8_t c0 = src[0];
+    const uint8_t c2 = src[2];
+    dst[0] = c2;
+    dst[1] = src[1];
+    dst[2] = c0;
+  }
+}
+
+/** BGRA <-> RGBA */
+static void SwapRB4(const uint8_t* src, uint8_t* dst, const size_t& n) {
+  for (size_t k = 0; k < n; ++k, src += 4, dst += 4) {
+    const uint8_t c0 = src[0];
+    const uint8_t c2 = src[2];
+    dst[0] = c2;
+    dst[1] = src[1];
+    dst[2] = c0;
+    dst[3] = src[3];
+  }
+}
+
+#ifdef HAS_NEON
+#pragma mark -
+#pragma mark Neon kernels
+
+/** BGR <-> RGB, 16 pixels at a time */
+static void NeonSwapRB3(const uint8_t* src, uint8_t* dst, const size_t& n) {
+  size_t k = 0;
+  for (; k + 16 <= n; k += 16) {
+    uint8x16x3_t v = vld3q_u8(src + 3 * k);
+    const uint8x16_t tmp = v.val[0];
+    v.val[0] = v.val[2];
+    v.val[2] = tmp;
+    vst3q_u8(dst + 3 * k, v);
+  }
+  SwapRB3(src + 3 * k, dst + 3 * k, n - k);
+}
+
+/** BGRA <-> RGBA, 16 pixels at a time */
+static void NeonSwapRB4(const uint8_t* src, uint8_t* dst, const size_t& n) {
+  size_t k = 0;
+  for (; k + 16 <= n; k += 16) {
+    uint8x16x4_t v = vld4q_u8(src + 4 * k);
+    const uint8x16_t tmp = v.val[0];
+    v.val[0] = v.val[2];
+    v.val[2] = tmp;
+    vst4q_u8(dst + 4 * k, v);
+  }
+  SwapRB4(src + 4 * k, dst + 4 * k, n - k);
+}
+#endif
+
+#pragma mark -
+#pragma mark Dispatch
+
+/**
+ *  @name   Kernels
+ *  @fn     static const PixelKernels& Kernels(void)
+ *  @brief  Kernels selected for this CPU, detected on first use
+ *  @return Kernels
+ */
+static const PixelKernels& Kernels(void) {
+  static const PixelKernels kernels = []() {
+#ifdef HAS_NEON
+    PixelKernels k{&NeonSwapRB3, &NeonSwapRB4};
+#else
+    PixelKernels k{&SwapRB3, &SwapRB4};
+#endif
+    PixelKernels ks;
+    if (CpuInfo::Get().Has(CpuInfo::Feature::kSsse3) &&
+        Ssse3PixelKernels(&ks)) {
+      k = ks;
+    }
+    return k;
+  }();
+  return kernels;
+}
+
+#pragma mark -
+#pragma mark Conversions
+
+/*
+ *  @name   SwapRedBlue
+ *  @fn     void SwapRedBlue(const uint8_t* src, const size_t& n_pixel,
+                             const size_t& channels, uint8_t* dst)
+ *  @brief  Exchange first and third channel (BGR(A) <-> RGB(A)). Works in
+ *          place when `src == dst`. Single channel data is copied.
+ *  @param[in] src      Packed pixels
+ *  @param[in] n_pixel  Number of pixels
+ *  @param[in] channels Number of channels, 1, 3 or 4
+ *  @param[out] dst     Converted pixels
+ */
+void SwapRedBlue(const uint8_t* src,
+                 const size_t& n_pixel,
+                 const size_t& channels,
+                 uint8_t* dst) {
+  switch (channels) {
+    case 3: Kernels().swap_rb3(src, dst, n_pixel);
+      break;
+    case 4: Kernels().swap_rb4(src, dst, n_pixel);
+      break;
+    default:
+      if (src != dst) {
+        std::memcpy(dst, src, n_pixel * channels);
+      }
+  }
+}
+
+/*
+ *  @name   FlipRows
+ *  @fn     void FlipRows(uint8_t* data, const size_t& n_row,
+                          const size_t& stride)
+ *  @brief  Flip an image upside-down in place (bottom-up <-> top-down)
+ *  @param[in,out] data Image
+ *  @param[in] n_row    Number of rows
+ *  @param[in] stride   Row size in bytes
+ */
+void FlipRows(uint8_t* data, const size_t& n_row, const size_t& stride) {
+  if (n_row < 2) {
+    return;
+  }
+  uint8_t* top = data;
+  uint8_t* bottom = data + (n_row - 1) * stride;
+  for (; top < bottom; top += stride, bottom -= stride) {
+    std::swap_ranges(top, top + stride, bottom);
+  }
+}
+
+/*
+ *  @name   PaletteLookup
+ *  @fn     void PaletteLookup(const uint8_t* index, const size_t& n_pixel,
+                               const uint32_t* palette, const size_t& channels,
+                               uint8_t* dst)
+ *  @brief  Replace color indices by their palette entries
+ *  @param[in] index    Color indices, one byte per pixel
+ *  @param[in] n_pixel  Number of pixels
+ *  @param[in] palette  Entries with channels packed in memory order (i.e.
+ *                      R, G, B, A bytes), must hold every possible index
+ *  @param[in] channels Number of channels written per pixel, 1, 3 or 4
+ *  @param[out] dst     Decoded pixels
+ */
+void PaletteLookup(const uint8_t* index,
+                   const size_t& n_pixel,
+                   const uint32_t* palette,
+                   const size_t& channels,
+                   uint8_t* dst) {
+  // Constant sized copies compile to single loads / stores
+  switch (channels) {
+    case 1: {
+      for (size_t k = 0; k < n_pixel; ++k) {
+        std::memcpy(&dst[k], &palette[index[k]], 1);
+      }
+    }
+      break;
+    case 3: {
+      for (size_t k = 0; k < n_pixel; ++k) {
+        std::memcpy(&dst[3 * k], &palette[index[k]], 3);
+      }
+    }
+      break;
+    case 4: {
+      for (size_t k = 0; k < n_pixel; ++k) {
+        std::memcpy(&dst[4 * k], &palette[index[k]], 4);
+      }
+    }
+      break;
+    default:
+      break;
+  }
+}
+
+/*
+ *  @name   UnpackNibbles
+ *  @fn     void UnpackNibbles(const uint8_t* src, const size_t& n,
+                               uint8_t* dst)
+ *  @brief  Expand 4 bits per pixel indices (high nibble first) to one byte
+ *          per pixel
+ *  @param[in] src  Packed indices
+ *  @param[in] n    Number of indices
+ *  @param[out] dst Unpacked indices
+ */
+void UnpackNibbles(const uint8_t* src, const size_t& n, uint8_t* dst) {
+  const size_t n_pair = n / 2;
+  for (size_t k = 0; k < n_pair; ++k) {
+    dst[2 * k] = src[k] >> 4;
+    dst[2 * k + 1] = src[k] & 0x0F;
+  }
+  if (n & 1) {
+    dst[n - 1] = src[n_pair] >> 4;
+  }
+}
+
+/*
+ *  @name   ExpandTgaRle
+ *  @fn     size_t ExpandTgaRle(const uint8_t* src, const size_t& size,
+                                const size_t& bpp, const size_t& n_pixel,
+                                uint8_t* dst)
+ *  @brief  Decode TGA run-length packets. Runs may cross row boundaries.
+ *  @param[in] src      Encoded data
+ *  @param[in] size     Encoded data size in bytes
+ *  @param[in] bpp      Bytes per pixel
+ *  @param[in] n_pixel  Number of pixels to decode
+ *  @param[out] dst     Decoded pixels, `n_pixel * bpp` bytes
+ *  @return Number of bytes consumed, 0 if `src` is truncated or corrupted
+ */
+size_t ExpandTgaRle(const uint8_t* src,
+                    const size_t& size,
+                    const size_t& bpp,
+                    const size_t& n_pixel,
+                    uint8_t* dst) {
+  size_t pos = 0;
+  size_t n = 0;
+  while (n < n_pixel) {
+    if (pos >= size) {
+      return 0;
+    }
+    // Packet header, bit 7 selects run-length / raw, bits 6-0 count - 1
+    const uint8_t hdr = src[pos++];
+    const size_t count = std::min(size_t(hdr & 0x7F) + 1, n_pixel - n);
+    if (hdr & 0x80) {
+      // One pixel repeated `count` times
+      if (bpp > size - pos) {
+        return 0;
+      }
+      const uint8_t* px = &src[pos];
+      pos += bpp;
+      if (bpp == 1) {
+        std::memset(dst, px[0], count);
+      } else {
+        // Copy first pixel, then double the filled range
+        std::memcpy(dst, px, bpp);
+        size_t filled = bpp;
+        const size_t len = count * bpp;
+        while (filled < len) {
+          const size_t m = std::min(filled, len - filled);
+          std::memcpy(dst + filled, dst, m);
+          filled += m;
+        }
+      }
+    } else {
+      // `count` raw pixels
+      const size_t len = count * bpp;
+      if (len > size - pos) {
+        return 0;
+      }
+      std::memcpy(dst, &src[pos], len);
+      pos += len;
+    }
+    dst += count * bpp;
+    n += count;
+  }
+  return pos;
+}
+
+}  // namespace internal
+}  // namespace FaceKit
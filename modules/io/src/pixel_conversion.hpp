@@ -0,0 +1,126 @@
+/**
+ *  @file   pixel_conversion.hpp
+ *  @brief  Private pixel format conversions shared by the image codecs. Hot
+ *          loops use SIMD kernels selected at runtime.
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   18.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_PIXEL_CONVERSION__
+#define __FACEKIT_PIXEL_CONVERSION__
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+namespace internal {
+
+/**
+ *  @struct  PixelKernels
+ *  @brief  Table of channel swizzle kernels. `src` and `dst` may be equal but
+ *          must not partially overlap.
+ */
+struct PixelKernels {
+  /** BGR <-> RGB on `n` pixels */
+  void (*swap_rb3)(const uint8_t* src, uint8_t* dst, const size_t& n);
+  /** BGRA <-> RGBA on `n` pixels */
+  void (*swap_rb4)(const uint8_t* src, uint8_t* dst, const size_t& n);
+};
+
+/**
+ *  @name   Ssse3PixelKernels
+ *  @fn     bool Ssse3PixelKernels(PixelKernels* kernels)
+ *  @brief  Provide SSSE3 kernels, defined in a translation unit compiled with
+ *          SSSE3 enabled
+ *  @param[out] kernels Kernels
+ *  @return False if not available for this target
+ */
+bool Ssse3PixelKernels(PixelKernels* kernels);
+
+/**
+ *  @name   SwapRedBlue
+ *  @fn     void SwapRedBlue(const uint8_t* src, const size_t& n_pixel,
+                             const size_t& channels, uint8_t* dst)
+ *  @brief  Exchange first and third channel (BGR(A) <-> RGB(A)). Works in
+ *          place when `src == dst`. Single channel data is copied.
+ *  @param[in] src      Packed pixels
+ *  @param[in] n_pixel  Number of pixels
+ *  @param[in] channels Number of channels, 1, 3 or 4
+ *  @param[out] dst     Converted pixels
+ */
+void SwapRedBlue(const uint8_t* src,
+                 const size_t& n_pixel,
+                 const size_t& channels,
+                 uint8_t* dst);
+
+/**
+ *  @name   FlipRows
+ *  @fn     void FlipRows(uint8_t* data, const size_t& n_row,
+                          const size_t& stride)
+ *  @brief  Flip an image upside-down in place (bottom-up <-> top-down)
+ *  @param[in,out] data Image
+ *  @param[in] n_row    Number of rows
+ *  @param[in] stride   Row size in bytes
+ */
+void FlipRows(uint8_t* data, const size_t& n_row, const size_t& stride);
+
+/**
+ *  @name   PaletteLookup
+ *  @fn     void PaletteLookup(const uint8_t* index, const size_t& n_pixel,
+                               const uint32_t* palette, const size_t& channels,
+                               uint8_t* dst)
+ *  @brief  Replace color indices by their palette entries
+ *  @param[in] index    Color indices, one byte per pixel
+ *  @param[in] n_pixel  Number of pixels
+ *  @param[in] palette  Entries with channels packed in memory order (i.e.
+ *                      R, G, B, A bytes), must hold every possible index
+ *  @param[in] channels Number of channels written per pixel, 1, 3 or 4
+ *  @param[out] dst     Decoded pixels
+ */
+void PaletteLookup(const uint8_t* index,
+                   const size_t& n_pixel,
+                   const uint32_t* palette,
+                   const size_t& channels,
+                   uint8_t* dst);
+
+/**
+ *  @name   UnpackNibbles
+ *  @fn     void UnpackNibbles(const uint8_t* src, const size_t& n,
+                               uint8_t* dst)
+ *  @brief  Expand 4 bits per pixel indices (high nibble first) to one byte
+ *          per pixel
+ *  @param[in] src  Packed indices
+ *  @param[in] n    Number of indices
+ *  @param[out] dst Unpacked indices
+ */
+void UnpackNibbles(const uint8_t* src, const size_t& n, uint8_t* dst);
+
+/**
+ *  @name   ExpandTgaRle
+ *  @fn     size_t ExpandTgaRle(const uint8_t* src, const size_t& size,
+                                const size_t& bpp, const size_t& n_pixel,
+                                uint8_t* dst)
+ *  @brief  Decode TGA run-length packets. Runs may cross row boundaries.
+ *  @param[in] src      Encoded data
+ *  @param[in] size     Encoded data size in bytes
+ *  @param[in] bpp      Bytes per pixel
+ *  @param[in] n_pixel  Number of pixels to decode
+ *  @param[out] dst     Decoded pixels, `n_pixel * bpp` bytes
+ *  @return Number of bytes consumed, 0 if `src` is truncated or corrupted
+ */
+size_t ExpandTgaRle(const uint8_t* src,
+                    const size_t& size,
+                    const size_t& bpp,
+                    const size_t& n_pixel,
+                    uint8_t* dst);
+
+}  // namespace internal
+}  // namespace FaceKit
+#endif /* __FACEKIT_PIXEL_CONVERSION__ */
@@ -0,0 +1,111 @@
+/**
+ *  @file   pixel_conversion_ssse3.cpp
+ *  @brief  SSSE3 channel swizzle kernels, this file is compiled with SSSE3
+ *          enabled and only called after runtime detection.
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   18.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#if defined(__SSSE3__) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#define HAS_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#include "pixel_conversion.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+namespace internal {
+
+#ifdef HAS_SSSE3
+
+/**
+ *  @name   Ssse3SwapRB3
+ *  @brief  BGR <-> RGB, 5 pixels per 16 bytes shuffle. The 16th byte belongs
+ *          to the next pixel and is written back unchanged.
+ */
+static void Ssse3SwapRB3(const uint8_t* src, uint8_t* dst, const size_t& n) {
+  const __m128i mask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7,
+                                     6, 11, 10, 9, 14, 13, 12, 15);
+  size_t k = 0;
+  // Keep at least one pixel after the block so the 16 bytes load is valid
+  for (; k + 6 <= n; k += 5) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                     _mm_shuffle_epi8(v, mask));
+    src += 15;
+    dst += 15;
+  }
+  for (; k < n; ++k, src += 3, dst += 3) {
+    const uint8_t c0 = src[0];
+    const uint8_t c2 = src[2];
+    dst[0] = c2;
+    dst[1] = src[1];
+    dst[2] = c0;
+  }
+}
+
+/**
+ *  @name   Ssse3SwapRB4
+ *  @brief  BGRA <-> RGBA, 8 pixels at a time
+ */
+static void Ssse3SwapRB4(const uint8_t* src, uint8_t* dst, const size_t& n) {
+  const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7,
+                                     10, 9, 8, 11, 14, 13, 12, 15);
+  size_t k = 0;
+  for (; k + 8 <= n; k += 8, src += 32, dst += 32) {
+    const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src +
+                                                                         16));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                     _mm_shuffle_epi8(v0, mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16),
+                     _mm_shuffle_epi8(v1, mask));
+  }
+  for (; k < n; ++k, src += 4, dst += 4) {
+    const uint8_t c0 = src[0];
+    const uint8_t c2 = src[2];
+    dst[0] = c2;
+    dst[1] = src[1];
+    dst[2] = c0;
+    dst[3] = src[3];
+  }
+}
+
+/*
+ *  @name   Ssse3PixelKernels
+ *  @fn     bool Ssse3PixelKernels(PixelKernels* kernels)
+ *  @brief  Provide SSSE3 kernels
+ *  @param[out] kernels Kernels
+ *  @return True
+ */
+bool Ssse3PixelKernels(PixelKernels* kernels) {
+  kernels->swap_rb3 = &Ssse3SwapRB3;
+  kernels->swap_rb4 = &Ssse3SwapRB4;
+  return true;
+}
+
+#else
+
+/*
+ *  @name   Ssse3PixelKernels
+ *  @fn     bool Ssse3PixelKernels(PixelKernels* kernels)
+ *  @brief  Provide SSSE3 kernels, not available for this target
+ *  @param[out] kernels Kernels
+ *  @return False
+ */
+bool Ssse3PixelKernels(PixelKernels* kernels) {
+  return false;
+}
+
+#endif
+
+}  // namespace internal
+}  // namespace FaceKit
@@ -9,12 +9,15 @@
  */
 
 #include <setjmp.h>
+#include <algorithm>
+#include <cstring>
 #include <vector>
 
 #include "png.h"
 
 #include "facekit/io/png_image.hpp"
 #include "facekit/io/image_factory.hpp"
+#include "facekit/io/image_writer.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -114,17 +117,101 @@ int PNGColorTypeConverter(const Image::Format& format) {
   return -1;
 }
 
+/**
+ *  @name   SetCompressionLevel
+ *  @fn     void SetCompressionLevel(const int& level, png_structp png_ptr)
+ *  @brief  Map a [0, 100] compression level to zlib level and row filters.
+ *          Low levels use a single cheap filter instead of the per-row
+ *          adaptive selection, which dominates the encoding time.
+ *  @param[in] level        Compression level, negative keeps libpng defaults
+ *  @param[in,out] png_ptr  Encoder
+ */
+void SetCompressionLevel(const int& level, png_structp png_ptr) {
+  if (level < 0) {
+    return;
+  }
+  const int zlevel = (std::min(level, 100) * 9 + 50) / 100;
+  png_set_compression_level(png_ptr, zlevel);
+  int filters = PNG_ALL_FILTERS;
+  if (zlevel == 0) {
+    filters = PNG_FILTER_NONE;
+  } else if (zlevel <= 3) {
+    filters = PNG_FILTER_SUB;
+  }
+  png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, filters);
+}
+
+/**
+ *  @name   DecodeRegion
+ *  @fn     void DecodeRegion(png_structp png_ptr, const Image::Region& region,
+                              const size_t& n_comp, const size_t& height,
+                              const int& n_pass, const size_t& row_bytes,
+                              NDArray* dst)
+ *  @brief  Decode \p region into `dst`. Non interlaced images are read row by
+ *          row and decoding stops after the region's last row, interlaced
+ *          images need every pass therefore they are fully decoded and the
+ *          region copied out.
+ *  @param[in] png_ptr    Reader, header already parsed
+ *  @param[in] region     Rectangle to decode, must fit in the image
+ *  @param[in] n_comp     Number of channels
+ *  @param[in] height     Image height
+ *  @param[in] n_pass     Number of interlacing passes
+ *  @param[in] row_bytes  Size of a decoded row
+ *  @param[out] dst       Region's pixels
+ */
+void DecodeRegion(png_structp png_ptr,
+                  const Image::Region& region,
+                  const size_t& n_comp,
+                  const size_t& height,
+                  const int& n_pass,
+                  const size_t& row_bytes,
+                  NDArray* dst) {
+  const size_t offset = region.x * n_comp;
+  const size_t dst_stride = region.width * n_comp;
+  dst->Resize(DataType::kUInt8, {region.height, region.width, n_comp});
+  auto* ptr = dst->AsFlat<uint8_t>().data();
+  static thread_local std::vector<png_byte> scratch;
+  if (n_pass == 1) {
+    // Rows above the region still go through inflate + unfiltering, rows
+    // below are never read
+    scratch.resize(row_bytes);
+    const size_t last = region.y + region.height;
+    for (size_t r = 0; r < last; ++r) {
+      png_read_row(png_ptr, scratch.data(), nullptr);
+      if (r >= region.y) {
+        std::memcpy(&ptr[(r - region.y) * dst_stride],
+                    &scratch[offset],
+                    dst_stride);
+      }
+    }
+  } else {
+    scratch.resize(row_bytes * height);
+    static thread_local std::vector<png_bytep> rows;
+    rows.resize(height);
+    for (size_t r = 0; r < height; ++r) {
+      rows[r] = &scratch[r * row_bytes];
+    }
+    png_read_image(png_ptr, rows.data());
+    for (size_t r = 0; r < region.height; ++r) {
+      std::memcpy(&ptr[r * dst_stride],
+                  rows[region.y + r] + offset,
+                  dst_stride);
+    }
+  }
+}
+
 #pragma mark -
 #pragma mark Initialization
   
 /*
- *  @name Load
- *  @fn Status Load(std::istream& stream) override
- *  @brief  Load image from dist
+ *  @name LoadInto
+ *  @fn Status LoadInto(std::istream& stream, NDArray* dst) override
+ *  @brief  Decode image into a caller provided array
  *  @param[in]  stream  Binary stream from where to load the ressource
+ *  @param[out] dst     Where to decode the pixels
  *  @return Operation status
  */
-Status PNGImage::Load(std::istream& stream) {
+Status PNGImage::LoadInto(std::istream& stream, NDArray* dst) {
   Status status;
   if (stream.good()) {
     // Read PNG Signature
@@ -167,22 +254,39 @@ Status PNGImage::Load(std::istream& stream) {
             if (colorType == PNG_COLOR_TYPE_PALETTE) {
               png_set_palette_to_rgb(png_ptr);
             }
+            // Let libpng deinterlace when reading the whole image
+            const int n_pass = png_set_interlace_handling(png_ptr);
             // Update info
             png_read_update_info(png_ptr, info_ptr);
             // Set prop
             this->width_ = static_cast<size_t>(width);
             this->height_ = static_cast<size_t>(height);
             this->format_ = PNGFormatConverter(colorType);
-            // Allocate
-            this->buffer_.Resize(DataType::kUInt8,
-                                 {this->height_, this->width_, this->format_});
-            // Read info + one line at a time
             const size_t bytesPerRow = png_get_rowbytes(png_ptr, info_ptr);
-            auto* ptr = this->data();
-            for (size_t r = 0; r < this->height_; ++r) {
-              png_read_row(png_ptr, &ptr[r * bytesPerRow], nullptr);
+            if (region_.empty()) {
+              // Allocate
+              dst->Resize(DataType::kUInt8,
+                          {this->height_, this->width_, this->format_});
+              // Decode all rows in a single call directly into `dst`, the
+              // row pointers table is kept per thread
+              auto* ptr = dst->AsFlat<uint8_t>().data();
+              static thread_local std::vector<png_bytep> rows;
+              rows.resize(this->height_);
+              for (size_t r = 0; r < this->height_; ++r) {
+                rows[r] = &ptr[r * bytesPerRow];
+              }
+              png_read_image(png_ptr, rows.data());
+              err = 0;
+            } else if (region_.x + region_.width <= this->width_ &&
+                       region_.y + region_.height <= this->height_) {
+              DecodeRegion(png_ptr, region_, this->format_, this->height_,
+                           n_pass, bytesPerRow, dst);
+              this->width_ = region_.width;
+              this->height_ = region_.height;
+              err = 0;
+            } else {
+              err = -2;
             }
-            err = 0;
           }
         }
       }
@@ -190,7 +294,10 @@ Status PNGImage::Load(std::istream& stream) {
     // release reading struct
     png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
     // Update status
-    if (err == -1) {
+    if (err == -2) {
+      status = Status(Status::Type::kInvalidArgument,
+                      "Region is outside of the image");
+    } else if (err == -1) {
       status = Status(Status::Type::kInternalError, "Error while reading PNG");
     }
   } else {
@@ -199,6 +306,61 @@ Status PNGImage::Load(std::istream& stream) {
   return status;
 }
 
+/*
+ *  @name ParseHeader
+ *  @fn Status ParseHeader(std::istream& stream, ImageInfo* info) override
+ *  @brief  Parse image header without decoding the pixels
+ *  @param[in]  stream  Binary stream from where to read the header
+ *  @param[out] info    Image properties
+ *  @return Operation status
+ */
+Status PNGImage::ParseHeader(std::istream& stream, ImageInfo* info) {
+  int err = -1;
+  png_structp png_ptr = nullptr;
+  png_infop info_ptr = nullptr;
+  enum {kPngSignatureLength = 8};
+  // Read signature + Check
+  unsigned char signature[kPngSignatureLength];
+  stream.read(reinterpret_cast<char*>(&signature[0]), kPngSignatureLength);
+  if (stream.good() && png_check_sig(signature, kPngSignatureLength)) {
+    png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,
+                                     nullptr,
+                                     nullptr,
+                                     nullptr);
+    if (png_ptr) {
+      info_ptr = png_create_info_struct(png_ptr);
+      if (info_ptr) {
+        png_set_read_fn(png_ptr, &stream, ReadData);
+        png_set_sig_bytes(png_ptr, kPngSignatureLength);
+        // Read chunks up to the image data, pixels are left untouched
+        png_read_info(png_ptr, info_ptr);
+        png_uint_32 width = 0;
+        png_uint_32 height = 0;
+        int bitDepth = 0;
+        int colorType = -1;
+        png_uint_32 retval = png_get_IHDR(png_ptr,
+                                          info_ptr,
+                                          &width,
+                                          &height,
+                                          &bitDepth,
+                                          &colorType,
+                                          nullptr, nullptr, nullptr);
+        if (retval == 1) {
+          info->width = static_cast<size_t>(width);
+          info->height = static_cast<size_t>(height);
+          info->format = PNGFormatConverter(colorType);
+          err = 0;
+        }
+      }
+    }
+  }
+  png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
+  if (err == -1) {
+    return Status(Status::Type::kInternalError, "Error while reading PNG");
+  }
+  return Status();
+}
+
 /**
  *  @name Save
  *  @fn Status Save(std::ostream& stream) const override
@@ -230,6 +392,7 @@ Status PNGImage::Save(std::ostream& stream) const {
                      PNG_INTERLACE_NONE,
                      PNG_COMPRESSION_TYPE_DEFAULT,
                      PNG_FILTER_TYPE_DEFAULT);
+        SetCompressionLevel(level_, png_ptr);
         png_write_info(png_ptr, info_ptr);
         
         // Write image data, one row at a time
@@ -256,6 +419,129 @@ Status PNGImage::Save(std::ostream& stream) const {
 }
   
 
+#pragma mark -
+#pragma mark Streaming writer
+
+/**
+ *  @class  PNGImageWriter
+ *  @brief  Streaming PNG encoder, rows are compressed as they come
+ */
+class PNGImageWriter : public ImageWriter {
+ public:
+  /**
+   *  @name   PNGImageWriter
+   *  @fn     explicit PNGImageWriter(const int& level)
+   *  @brief  Constructor
+   *  @param[in] level  Compression level, negative for default
+   */
+  explicit PNGImageWriter(const int& level) : png_ptr_(nullptr),
+                                              info_ptr_(nullptr),
+                                              level_(level) {}
+
+  /**
+   *  @name   ~PNGImageWriter
+   *  @fn     ~PNGImageWriter(void) override
+   *  @brief  Destructor
+   */
+  ~PNGImageWriter(void) override {
+    Release();
+  }
+
+ protected:
+  /** Initialize encoder and write header */
+  Status OpenImpl(void) override {
+    Release();
+    const int colorType = PNGColorTypeConverter(format_);
+    if (colorType == -1) {
+      return Status(Status::Type::kInvalidArgument, "Unsupported format");
+    }
+    png_ptr_ = png_create_write_struct(PNG_LIBPNG_VER_STRING,
+                                       nullptr, nullptr, nullptr);
+    if (png_ptr_) {
+      info_ptr_ = png_create_info_struct(png_ptr_);
+    }
+    if (png_ptr_ == nullptr || info_ptr_ == nullptr) {
+      Release();
+      return Status(Status::Type::kInternalError, "Error while writing PNG");
+    }
+    if (setjmp(png_jmpbuf(png_ptr_))) {
+      Release();
+      return Status(Status::Type::kInternalError, "Error while writing PNG");
+    }
+    png_set_write_fn(png_ptr_, stream_, WriteData, FlushData);
+    png_set_IHDR(png_ptr_, info_ptr_,
+                 static_cast<png_uint_32>(width_),
+                 static_cast<png_uint_32>(height_),
+                 8, colorType,
+                 PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT,
+                 PNG_FILTER_TYPE_DEFAULT);
+    SetCompressionLevel(level_, png_ptr_);
+    png_write_info(png_ptr_, info_ptr_);
+    return Status();
+  }
+
+  /** Compress a strip */
+  Status WriteImpl(const uint8_t* rows, const size_t& n_rows) override {
+    const size_t stride = width_ * format_;
+    rows_.resize(n_rows);
+    for (size_t r = 0; r < n_rows; ++r) {
+      rows_[r] = const_cast<png_bytep>(&rows[r * stride]);
+    }
+    if (setjmp(png_jmpbuf(png_ptr_))) {
+      return Status(Status::Type::kInternalError, "Error while writing PNG");
+    }
+    png_write_rows(png_ptr_, rows_.data(), static_cast<png_uint_32>(n_rows));
+    return stream_->good() ?
+           Status() :
+           Status(Status::Type::kInternalError, "Error while writing PNG");
+  }
+
+  /** Write trailing chunks */
+  Status CloseImpl(void) override {
+    Status s;
+    if (setjmp(png_jmpbuf(png_ptr_))) {
+      s = Status(Status::Type::kInternalError, "Error while writing PNG");
+    } else {
+      png_write_end(png_ptr_, nullptr);
+      if (!stream_->good()) {
+        s = Status(Status::Type::kInternalError, "Error while writing PNG");
+      }
+    }
+    Release();
+    return s;
+  }
+
+ private:
+  /** Destroy encoder */
+  void Release(void) {
+    if (png_ptr_) {
+      png_destroy_write_struct(&png_ptr_, &info_ptr_);
+    }
+    png_ptr_ = nullptr;
+    info_ptr_ = nullptr;
+  }
+
+  /** Encoder */
+  png_structp png_ptr_;
+  /** Header info */
+  png_infop info_ptr_;
+  /** Row pointers of the current strip */
+  std::vector<png_bytep> rows_;
+  /** Compression level */
+  int level_;
+};
+
+/*
+ *  @name CreateWriter
+ *  @fn ImageWriter* CreateWriter(void) const override
+ *  @brief  Create a streaming encoder, caller takes ownership
+ *  @return Writer instance
+ */
+ImageWriter* PNGImage::CreateWriter(void) const {
+  return new PNGImageWriter(level_);
+}
+
 #pragma mark -
 #pragma mark Registration
   
@@ -0,0 +1,489 @@
+/**
+ *  @file   qoi_image.cpp
+ *  @brief QOI Image object
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   20.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "facekit/io/qoi_image.hpp"
+#include "facekit/io/image_factory.hpp"
+#include "facekit/io/image_writer.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#pragma mark -
+#pragma mark QOI Format
+
+/** Header size in bytes */
+static constexpr size_t kQoiHeaderSize = 14;
+/** End marker size in bytes (7 x 0x00 + 0x01) */
+static constexpr size_t kQoiPaddingSize = 8;
+/** Largest image accepted by the decoder, same as the reference one */
+static constexpr size_t kQoiMaxPixels = 400000000;
+/** Strip height used by `Save`, bounds the size of the output buffer */
+static constexpr size_t kQoiRowsPerStrip = 64;
+
+/** Operation tags */
+enum QOIOp : uint8_t {
+  /** 6 bits index in the color cache */
+  kOpIndex = 0x00,
+  /** 2 bits per channel difference with previous pixel */
+  kOpDiff = 0x40,
+  /** 6 bits green difference, 4 bits red/blue difference relative to green */
+  kOpLuma = 0x80,
+  /** 6 bits run-length of the previous pixel */
+  kOpRun = 0xC0,
+  /** Full RGB value */
+  kOpRGB = 0xFE,
+  /** Full RGBA value */
+  kOpRGBA = 0xFF
+};
+
+/**
+ *  @struct QOIPixel
+ *  @brief  RGBA pixel
+ */
+struct QOIPixel {
+  /** Red */
+  uint8_t r;
+  /** Green */
+  uint8_t g;
+  /** Blue */
+  uint8_t b;
+  /** Alpha */
+  uint8_t a;
+
+  /** Equality */
+  bool operator==(const QOIPixel& rhs) const {
+    return r == rhs.r && g == rhs.g && b == rhs.b && a == rhs.a;
+  }
+
+  /** Position in the color cache */
+  size_t Hash(void) const {
+    return (r * 3 + g * 5 + b * 7 + a * 11) & 63;
+  }
+};
+
+/**
+ *  @struct QOIHeader
+ *  @brief  QOI file header, integers are big endian
+ */
+struct QOIHeader {
+  /** Image width */
+  uint32_t width;
+  /** Image height */
+  uint32_t height;
+  /** Number of channels, 3 or 4 */
+  uint8_t channels;
+  /** 0: sRGB with linear alpha, 1: all channels linear */
+  uint8_t colorspace;
+
+  /**
+   *  @name   Read
+   *  @fn     bool Read(std::istream& stream)
+   *  @brief  Read and validate header
+   *  @param[in] stream Binary stream
+   *  @return True if the header is valid
+   */
+  bool Read(std::istream& stream) {
+    uint8_t buff[kQoiHeaderSize];
+    stream.read(reinterpret_cast<char*>(buff), kQoiHeaderSize);
+    if (!stream.good() || std::memcmp(buff, "qoif", 4) != 0) {
+      return false;
+    }
+    width = ReadU32(&buff[4]);
+    height = ReadU32(&buff[8]);
+    channels = buff[12];
+    colorspace = buff[13];
+    return width != 0 && height != 0 &&
+           (channels == 3 || channels == 4) &&
+           height <= kQoiMaxPixels / width;
+  }
+
+  /**
+   *  @name   Write
+   *  @fn     void Write(std::ostream& stream) const
+   *  @brief  Write header
+   *  @param[in] stream Binary stream
+   */
+  void Write(std::ostream& stream) const {
+    uint8_t buff[kQoiHeaderSize] = {'q', 'o', 'i', 'f'};
+    WriteU32(width, &buff[4]);
+    WriteU32(height, &buff[8]);
+    buff[12] = channels;
+    buff[13] = colorspace;
+    stream.write(reinterpret_cast<const char*>(buff), kQoiHeaderSize);
+  }
+
+ private:
+  /** Big endian read */
+  static uint32_t ReadU32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+           (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+  }
+
+  /** Big endian write */
+  static void WriteU32(const uint32_t& v, uint8_t* p) {
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
+  }
+};
+
+/**
+ *  @name   DecodeQoi
+ *  @fn     bool DecodeQoi(const uint8_t* chunks, const size_t& size,
+                           const size_t& n_pixel, uint8_t* dst)
+ *  @brief  Decode the chunks following the header
+ *  @param[in] chunks   Encoded pixels, including the end marker
+ *  @param[in] size     Size of `chunks` in bytes
+ *  @param[in] n_pixel  Number of pixels to decode
+ *  @param[out] dst     Decoded pixels, `C` bytes per pixel
+ *  @tparam C Number of output channels
+ *  @return False if `chunks` is truncated
+ */
+template<size_t C>
+bool DecodeQoi(const uint8_t* chunks,
+               const size_t& size,
+               const size_t& n_pixel,
+               uint8_t* dst) {
+  // The end marker guarantees that the operands of the last chunk can be
+  // read without checking every byte
+  if (size < kQoiPaddingSize) {
+    return false;
+  }
+  const size_t end = size - kQoiPaddingSize;
+  QOIPixel index[64] = {};
+  QOIPixel px = {0, 0, 0, 255};
+  size_t pos = 0;
+  size_t run = 0;
+  for (size_t k = 0; k < n_pixel; ++k, dst += C) {
+    if (run > 0) {
+      --run;
+    } else {
+      if (pos >= end) {
+        return false;
+      }
+      const uint8_t b1 = chunks[pos++];
+      if (b1 == kOpRGB) {
+        px.r = chunks[pos];
+        px.g = chunks[pos + 1];
+        px.b = chunks[pos + 2];
+        pos += 3;
+      } else if (b1 == kOpRGBA) {
+        px.r = chunks[pos];
+        px.g = chunks[pos + 1];
+        px.b = chunks[pos + 2];
+        px.a = chunks[pos + 3];
+        pos += 4;
+      } else {
+        switch (b1 & 0xC0) {
+          case kOpIndex: px = index[b1];
+            break;
+          case kOpDiff: {
+            px.r += ((b1 >> 4) & 0x03) - 2;
+            px.g += ((b1 >> 2) & 0x03) - 2;
+            px.b += (b1 & 0x03) - 2;
+          }
+            break;
+          case kOpLuma: {
+            const uint8_t b2 = chunks[pos++];
+            const int vg = (b1 & 0x3F) - 32;
+            px.r += vg - 8 + ((b2 >> 4) & 0x0F);
+            px.g += vg;
+            px.b += vg - 8 + (b2 & 0x0F);
+          }
+            break;
+          default: run = b1 & 0x3F;
+            break;
+        }
+      }
+      index[px.Hash()] = px;
+    }
+    dst[0] = px.r;
+    dst[1] = px.g;
+    dst[2] = px.b;
+    if (C == 4) {
+      dst[3] = px.a;
+    }
+  }
+  return true;
+}
+
+#pragma mark -
+#pragma mark Streaming writer
+
+/**
+ *  @class  QOIImageWriter
+ *  @brief  Streaming QOI encoder, the encoder state (previous pixel, color
+ *          cache and pending run) carries over strips
+ */
+class QOIImageWriter : public ImageWriter {
+ public:
+  /**
+   *  @name   QOIImageWriter
+   *  @fn     QOIImageWriter(void)
+   *  @brief  Constructor
+   */
+  QOIImageWriter(void) : run_(0) {}
+
+ protected:
+  /** Reset encoder and write header */
+  Status OpenImpl(void) override {
+    if (format_ != Image::Format::kGrayscale &&
+        format_ != Image::Format::kRGB &&
+        format_ != Image::Format::kRGBA) {
+      return Status(Status::Type::kInvalidArgument, "Unsupported format");
+    }
+    if (width_ == 0 || height_ > kQoiMaxPixels / width_) {
+      return Status(Status::Type::kInvalidArgument, "Image too large for QOI");
+    }
+    QOIHeader header;
+    header.width = static_cast<uint32_t>(width_);
+    header.height = static_cast<uint32_t>(height_);
+    header.channels = format_ == Image::Format::kRGBA ? 4 : 3;
+    header.colorspace = 0;
+    header.Write(*stream_);
+    std::fill(index_, index_ + 64, QOIPixel{0, 0, 0, 0});
+    prev_ = QOIPixel{0, 0, 0, 255};
+    run_ = 0;
+    return stream_->good() ?
+           Status() :
+           Status(Status::Type::kInternalError, "Error while writing QOI");
+  }
+
+  /** Encode a strip */
+  Status WriteImpl(const uint8_t* rows, const size_t& n_rows) override {
+    const size_t n_pixel = n_rows * width_;
+    // Worst case is one RGBA chunk per pixel
+    buffer_.resize(n_pixel * 5);
+    uint8_t* out = buffer_.data();
+    switch (format_) {
+      case Image::Format::kGrayscale: out = Encode<1>(rows, n_pixel, out);
+        break;
+      case Image::Format::kRGB: out = Encode<3>(rows, n_pixel, out);
+        break;
+      default: out = Encode<4>(rows, n_pixel, out);
+        break;
+    }
+    stream_->write(reinterpret_cast<const char*>(buffer_.data()),
+                   out - buffer_.data());
+    return stream_->good() ?
+           Status() :
+           Status(Status::Type::kInternalError, "Error while writing QOI");
+  }
+
+  /** Flush pending run and write end marker */
+  Status CloseImpl(void) override {
+    uint8_t buff[1 + kQoiPaddingSize] = {};
+    size_t n = 0;
+    if (run_ > 0) {
+      buff[n++] = static_cast<uint8_t>(kOpRun | (run_ - 1));
+      run_ = 0;
+    }
+    buff[n + kQoiPaddingSize - 1] = 0x01;
+    stream_->write(reinterpret_cast<const char*>(buff), n + kQoiPaddingSize);
+    stream_->flush();
+    return stream_->good() ?
+           Status() :
+           Status(Status::Type::kInternalError, "Error while writing QOI");
+  }
+
+ private:
+  /**
+   *  @name   Encode
+   *  @brief  Encode `n` pixels with `C` channels (grayscale is replicated)
+   *  @return Past-the-end of the encoded data
+   */
+  template<size_t C>
+  uint8_t* Encode(const uint8_t* src, const size_t& n, uint8_t* out) {
+    QOIPixel px = prev_;
+    for (size_t k = 0; k < n; ++k, src += C) {
+      px.r = src[0];
+      px.g = src[C == 1 ? 0 : 1];
+      px.b = src[C == 1 ? 0 : 2];
+      if (C == 4) {
+        px.a = src[3];
+      }
+      if (px == prev_) {
+        if (++run_ == 62) {
+          *out++ = static_cast<uint8_t>(kOpRun | (run_ - 1));
+          run_ = 0;
+        }
+        continue;
+      }
+      if (run_ > 0) {
+        *out++ = static_cast<uint8_t>(kOpRun | (run_ - 1));
+        run_ = 0;
+      }
+      const size_t h = px.Hash();
+      if (index_[h] == px) {
+        *out++ = static_cast<uint8_t>(kOpIndex | h);
+      } else {
+        index_[h] = px;
+        if (px.a == prev_.a) {
+          const int8_t vr = static_cast<int8_t>(px.r - prev_.r);
+          const int8_t vg = static_cast<int8_t>(px.g - prev_.g);
+          const int8_t vb = static_cast<int8_t>(px.b - prev_.b);
+          const int8_t vg_r = static_cast<int8_t>(vr - vg);
+          const int8_t vg_b = static_cast<int8_t>(vb - vg);
+          if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+            *out++ = static_cast<uint8_t>(kOpDiff | (vr + 2) << 4 |
+                                          (vg + 2) << 2 | (vb + 2));
+          } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 &&
+                     vg_b > -9 && vg_b < 8) {
+            *out++ = static_cast<uint8_t>(kOpLuma | (vg + 32));
+            *out++ = static_cast<uint8_t>((vg_r + 8) << 4 | (vg_b + 8));
+          } else {
+            out[0] = kOpRGB;
+            out[1] = px.r;
+            out[2] = px.g;
+            out[3] = px.b;
+            out += 4;
+          }
+        } else {
+          out[0] = kOpRGBA;
+          out[1] = px.r;
+          out[2] = px.g;
+          out[3] = px.b;
+          out[4] = px.a;
+          out += 5;
+        }
+      }
+      prev_ = px;
+    }
+    return out;
+  }
+
+  /** Color cache */
+  QOIPixel index_[64];
+  /** Previous pixel */
+  QOIPixel prev_;
+  /** Number of repetitions of `prev_` not written yet */
+  size_t run_;
+  /** Encoded strip */
+  std::vector<uint8_t> buffer_;
+};
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name LoadInto
+ *  @fn Status LoadInto(std::istream& stream, NDArray* dst) override
+ *  @brief  Decode image into a caller provided array
+ *  @param[in]  stream  Binary stream from where to load the ressource
+ *  @param[out] dst     Where to decode the pixels
+ *  @return Operation status
+ */
+Status QOIImage::LoadInto(std::istream& stream, NDArray* dst) {
+  if (!stream.good()) {
+    return Status(Status::Type::kInvalidArgument, "Stream has errors");
+  }
+  QOIHeader header;
+  if (!header.Read(stream)) {
+    return Status(Status::Type::kInternalError, "Error while reading QOI");
+  }
+  // Chunks size is unknown, decode from the remaining bytes. Buffer is kept
+  // per thread to avoid reallocating it for every image
+  static thread_local std::vector<uint8_t> chunks;
+  const auto start = stream.tellg();
+  stream.seekg(0, std::ios_base::end);
+  const auto size = static_cast<size_t>(stream.tellg() - start);
+  stream.seekg(start);
+  chunks.resize(size);
+  stream.read(reinterpret_cast<char*>(chunks.data()), size);
+  if (!stream.good()) {
+    return Status(Status::Type::kInternalError, "Error while reading QOI");
+  }
+  this->width_ = header.width;
+  this->height_ = header.height;
+  this->format_ = static_cast<Format>(header.channels);
+  dst->Resize(DataType::kUInt8,
+              {this->height_, this->width_, this->format_});
+  const size_t n_pixel = this->width_ * this->height_;
+  uint8_t* ptr = dst->AsFlat<uint8_t>().data();
+  const bool ok = header.channels == 4 ?
+                  DecodeQoi<4>(chunks.data(), size, n_pixel, ptr) :
+                  DecodeQoi<3>(chunks.data(), size, n_pixel, ptr);
+  return ok ?
+         Status() :
+         Status(Status::Type::kInternalError, "Error while reading QOI");
+}
+
+/*
+ *  @name ParseHeader
+ *  @fn Status ParseHeader(std::istream& stream, ImageInfo* info) override
+ *  @brief  Parse image header without decoding the pixels
+ *  @param[in]  stream  Binary stream from where to read the header
+ *  @param[out] info    Image properties
+ *  @return Operation status
+ */
+Status QOIImage::ParseHeader(std::istream& stream, ImageInfo* info) {
+  QOIHeader header;
+  if (!header.Read(stream)) {
+    return Status(Status::Type::kInternalError, "Error while reading QOI");
+  }
+  info->width = header.width;
+  info->height = header.height;
+  info->format = static_cast<Format>(header.channels);
+  return Status();
+}
+
+/*
+ *  @name Save
+ *  @fn Status Save(std::ostream& stream) const override
+ *  @brief  Save image into a given stream
+ *  @param[in]  stream  Binary stream to where to save the ressource
+ *  @return Operation status
+ */
+Status QOIImage::Save(std::ostream& stream) const {
+  if (!stream.good() || this->data() == nullptr) {
+    return Status(Status::Type::kInvalidArgument, "Stream has errors");
+  }
+  QOIImageWriter writer;
+  Status status = writer.Open(&stream,
+                              this->width_,
+                              this->height_,
+                              this->format_);
+  const size_t stride = this->width_ * this->format_;
+  for (size_t r = 0; status.Good() && r < this->height_;
+       r += kQoiRowsPerStrip) {
+    const size_t n = std::min(kQoiRowsPerStrip, this->height_ - r);
+    status = writer.Write(&this->data()[r * stride], n);
+  }
+  if (status.Good()) {
+    status = writer.Close();
+  }
+  return status;
+}
+
+/*
+ *  @name CreateWriter
+ *  @fn ImageWriter* CreateWriter(void) const override
+ *  @brief  Create a streaming encoder, caller takes ownership
+ *  @return Writer instance
+ */
+ImageWriter* QOIImage::CreateWriter(void) const {
+  return new QOIImageWriter();
+}
+
+#pragma mark -
+#pragma mark Registration
+
+/** Add qoi implementation to the image factory */
+REGISTER_IMAGE_IMPL(QOIImage, "qoi");
+
+}  // namespace FaceKit
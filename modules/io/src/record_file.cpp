@@ -0,0 +1,468 @@
+/**
+ *  @file   record_file.cpp
+ *  @brief  Sharded files of length-prefixed records protected by CRC, used
+ *          to pack millions of small samples into a few large files
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   25.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "zlib.h"
+
+#include "facekit/io/record_file.hpp"
+#include "facekit/core/sys/file_system.hpp"
+#include "facekit/core/sys/file_system_factory.hpp"
+#include "facekit/core/utils/string.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#pragma mark -
+#pragma mark Format
+
+/** Shard extension */
+static const char* kShardExt = "fkrec";
+/** Length and its checksum */
+static constexpr size_t kRecordHeaderSize = sizeof(uint64_t) + sizeof(uint32_t);
+/** Payload checksum */
+static constexpr size_t kRecordFooterSize = sizeof(uint32_t);
+
+/**
+ *  @name   MaskedCrc
+ *  @fn     static uint32_t MaskedCrc(const void* data, const size_t& n)
+ *  @brief  CRC-32 rotated and offset, so that checksums of data holding
+ *          checksums stay well distributed
+ *  @param[in] data Bytes
+ *  @param[in] n    Number of bytes
+ *  @return Masked checksum
+ */
+static uint32_t MaskedCrc(const void* data, const size_t& n) {
+  uLong crc = crc32(0L, Z_NULL, 0);
+  const Bytef* ptr = reinterpret_cast<const Bytef*>(data);
+  size_t done = 0;
+  while (done < n) {
+    const uInt len = static_cast<uInt>(std::min<size_t>(n - done, 1u << 30));
+    crc = crc32(crc, ptr + done, len);
+    done += len;
+  }
+  const uint32_t c = static_cast<uint32_t>(crc);
+  return ((c >> 15) | (c << 17)) + 0xA282EAD8u;
+}
+
+#pragma mark -
+#pragma mark Writer
+
+/*
+ *  @name   RecordWriter
+ *  @fn     RecordWriter(void)
+ *  @brief  Constructor
+ */
+RecordWriter::RecordWriter(void) : shard_size_(0) {
+}
+
+/*
+ *  @name   ~RecordWriter
+ *  @fn     ~RecordWriter(void)
+ *  @brief  Destructor, close the current shard
+ */
+RecordWriter::~RecordWriter(void) {
+  this->Close();
+}
+
+/*
+ *  @name   Open
+ *  @fn     Status Open(const std::string& prefix, const Options& options)
+ *  @brief  Start a new set of shards, the first one is created with the
+ *          first record
+ *  @param[in] prefix   Shard path prefix (i.e. `/data/train`)
+ *  @param[in] options  Configuration
+ *  @return Operation status
+ */
+Status RecordWriter::Open(const std::string& prefix, const Options& options) {
+  Status s = this->Close();
+  prefix_ = prefix;
+  options_ = options;
+  shards_.clear();
+  return s;
+}
+
+/*
+ *  @name   Write
+ *  @fn     Status Write(const void* data, const size_t& n)
+ *  @brief  Append a record
+ *  @param[in] data Record content
+ *  @param[in] n    Record size in bytes
+ *  @return Operation status
+ */
+Status RecordWriter::Write(const void* data, const size_t& n) {
+  if (prefix_.empty()) {
+    return Status(Status::Type::kInvalidArgument, "Writer is not opened");
+  }
+  const size_t rec_size = kRecordHeaderSize + n + kRecordFooterSize;
+  if (!stream_.is_open() ||
+      (shard_size_ > 0 && shard_size_ + rec_size > options_.shard_size)) {
+    Status s = this->NextShard();
+    if (!s.Good()) {
+      return s;
+    }
+  }
+  const uint64_t length = n;
+  const uint32_t length_crc = MaskedCrc(&length, sizeof(length));
+  const uint32_t data_crc = MaskedCrc(data, n);
+  stream_.write(reinterpret_cast<const char*>(&length), sizeof(length));
+  stream_.write(reinterpret_cast<const char*>(&length_crc),
+                sizeof(length_crc));
+  stream_.write(reinterpret_cast<const char*>(data), n);
+  stream_.write(reinterpret_cast<const char*>(&data_crc), sizeof(data_crc));
+  shard_size_ += rec_size;
+  if (!stream_.good()) {
+    return Status(Status::Type::kInternalError,
+                  "Error while writing record in: " + shards_.back());
+  }
+  return Status();
+}
+
+/*
+ *  @name   Close
+ *  @fn     Status Close(void)
+ *  @brief  Flush and close the current shard
+ *  @return Operation status
+ */
+Status RecordWriter::Close(void) {
+  if (stream_.is_open()) {
+    stream_.close();
+    if (!stream_.good()) {
+      stream_.clear();
+      return Status(Status::Type::kInternalError,
+                    "Error while closing: " + shards_.back());
+    }
+  }
+  return Status();
+}
+
+/*
+ *  @name   NextShard
+ *  @fn     Status NextShard(void)
+ *  @brief  Close the current shard and open the next one
+ */
+Status RecordWriter::NextShard(void) {
+  Status s = this->Close();
+  if (!s.Good()) {
+    return s;
+  }
+  shards_.push_back(prefix_ + "-" + String::LeadingZero(shards_.size(), 5) +
+                    "." + kShardExt);
+  stream_.open(shards_.back().c_str(), std::ios_base::binary);
+  shard_size_ = 0;
+  if (!stream_.is_open()) {
+    stream_.clear();
+    return Status(Status::Type::kInternalError,
+                  "Can not create shard: " + shards_.back());
+  }
+  return s;
+}
+
+#pragma mark -
+#pragma mark Reader
+
+/**
+ *  @struct RecordReader::Shard
+ *  @brief  Opened shard with its read-ahead buffer
+ */
+struct RecordReader::Shard {
+  /** Path */
+  std::string path;
+  /** File */
+  std::unique_ptr<RandomAccessFile> file;
+  /** File size */
+  size_t size = 0;
+  /** Position of the next read request */
+  size_t pos = 0;
+  /** Read-ahead buffer */
+  std::vector<char> buffer;
+  /** First valid byte in `buffer` */
+  size_t head = 0;
+  /** End of the valid bytes in `buffer` */
+  size_t tail = 0;
+
+  /**
+   *  @name   AtEnd
+   *  @fn     bool AtEnd(void) const
+   *  @brief  Indicate if every byte has been consumed
+   */
+  bool AtEnd(void) const {
+    return head == tail && pos == size;
+  }
+
+  /**
+   *  @name   Read
+   *  @fn     Status Read(size_t n, char* dst)
+   *  @brief  Consume bytes, large requests bypass the buffer
+   *  @param[in] n      Number of bytes
+   *  @param[out] dst   Destination
+   *  @return kOutOfRange if the shard ends before
+   */
+  Status Read(size_t n, char* dst) {
+    while (n > 0) {
+      if (head < tail) {
+        const size_t len = std::min(n, tail - head);
+        std::memcpy(dst, buffer.data() + head, len);
+        head += len;
+        dst += len;
+        n -= len;
+        continue;
+      }
+      if (pos == size) {
+        return Status(Status::Type::kOutOfRange, "Truncated shard: " + path);
+      }
+      size_t n_read = 0;
+      if (n >= buffer.size()) {
+        const size_t len = std::min(n, size - pos);
+        Status s = file->Read(pos, len, dst, &n_read);
+        if (!s.Good()) {
+          return s;
+        }
+        pos += len;
+        dst += len;
+        n -= len;
+      } else {
+        const size_t len = std::min(buffer.size(), size - pos);
+        Status s = file->Read(pos, len, buffer.data(), &n_read);
+        if (!s.Good()) {
+          return s;
+        }
+        pos += len;
+        head = 0;
+        tail = len;
+      }
+    }
+    return Status();
+  }
+};
+
+/*
+ *  @name   ListShards
+ *  @fn     static Status ListShards(const std::string& prefix,
+                                     std::vector<std::string>* shards)
+ *  @brief  Find the shards written with a given prefix, sorted by index
+ *  @param[in] prefix   Shard path prefix
+ *  @param[out] shards  Shard paths
+ *  @return kNotFound if there is none
+ */
+Status RecordReader::ListShards(const std::string& prefix,
+                                std::vector<std::string>* shards) {
+  std::string dir = Path::Dirname(prefix);
+  if (dir.empty()) {
+    dir = ".";
+  }
+  FileSystem* fs = FileSystemFactory::Get().RetrieveForPath(dir);
+  if (fs == nullptr) {
+    return Status(Status::Type::kUnimplemented,
+                  "No file system registered for: " + prefix);
+  }
+  std::vector<std::string> files;
+  Status s = fs->ListDir(dir, &files);
+  if (!s.Good()) {
+    return s;
+  }
+  // <base>-NNNNN.fkrec
+  const std::string base = Path::Basename(prefix) + "-";
+  shards->clear();
+  for (const auto& f : files) {
+    const std::string name = Path::Basename(f);
+    if (name.compare(0, base.size(), base) == 0 &&
+        Path::Extension(name) == kShardExt &&
+        name.size() == base.size() + 5 + 1 + std::strlen(kShardExt)) {
+      shards->push_back(f);
+    }
+  }
+  if (shards->empty()) {
+    return Status(Status::Type::kNotFound, "No shard for: " + prefix);
+  }
+  std::sort(shards->begin(), shards->end());
+  return s;
+}
+
+/*
+ *  @name   RecordReader
+ *  @fn     RecordReader(void)
+ *  @brief  Constructor
+ */
+RecordReader::RecordReader(void) : next_(0), cursor_(0) {
+}
+
+/*
+ *  @name   ~RecordReader
+ *  @fn     ~RecordReader(void)
+ *  @brief  Destructor
+ */
+RecordReader::~RecordReader(void) = default;
+
+/*
+ *  @name   Open
+ *  @fn     Status Open(const std::vector<std::string>& shards,
+                        const Options& options)
+ *  @brief  Start reading a list of shards
+ *  @param[in] shards   Shard paths
+ *  @param[in] options  Configuration
+ *  @return Operation status
+ */
+Status RecordReader::Open(const std::vector<std::string>& shards,
+                          const Options& options) {
+  if (options.buffer_size == 0) {
+    return Status(Status::Type::kInvalidArgument, "Empty read buffer");
+  }
+  paths_ = shards;
+  options_ = options;
+  options_.n_interleave = std::max<size_t>(options.n_interleave, 1);
+  rng_.seed(options.seed);
+  if (options.shuffle_shards) {
+    std::shuffle(paths_.begin(), paths_.end(), rng_);
+  }
+  next_ = 0;
+  cursor_ = 0;
+  pool_.clear();
+  active_.clear();
+  // Open the interleaved shards upfront, errors show up early
+  while (active_.size() < options_.n_interleave && next_ < paths_.size()) {
+    std::unique_ptr<Shard> shard;
+    Status s = this->OpenNextShard(&shard);
+    if (!s.Good()) {
+      return s;
+    }
+    active_.push_back(std::move(shard));
+  }
+  return Status();
+}
+
+/*
+ *  @name   Next
+ *  @fn     Status Next(std::string* record)
+ *  @brief  Read the next record
+ *  @param[out] record  Record content
+ *  @return kOutOfRange once every record has been read, kInternalError
+ *          for corrupted records
+ */
+Status RecordReader::Next(std::string* record) {
+  if (options_.shuffle_buffer == 0) {
+    return this->ReadRecord(record);
+  }
+  // Refill the shuffle buffer, then draw one record from it
+  while (pool_.size() < options_.shuffle_buffer) {
+    std::string rec;
+    Status s = this->ReadRecord(&rec);
+    if (s.Code() == Status::Type::kOutOfRange) {
+      break;
+    } else if (!s.Good()) {
+      return s;
+    }
+    pool_.push_back(std::move(rec));
+  }
+  if (pool_.empty()) {
+    return Status(Status::Type::kOutOfRange, "No more records");
+  }
+  std::uniform_int_distribution<size_t> pick(0, pool_.size() - 1);
+  std::swap(pool_[pick(rng_)], pool_.back());
+  record->swap(pool_.back());
+  pool_.pop_back();
+  return Status();
+}
+
+/*
+ *  @name   ReadRecord
+ *  @fn     Status ReadRecord(std::string* record)
+ *  @brief  Read the next record in file order (interleaved shards)
+ */
+Status RecordReader::ReadRecord(std::string* record) {
+  while (!active_.empty()) {
+    cursor_ = cursor_ % active_.size();
+    Shard* shard = active_[cursor_].get();
+    if (shard->AtEnd()) {
+      // Replace with the next shard, if any
+      std::unique_ptr<Shard> next;
+      Status s = this->OpenNextShard(&next);
+      if (!s.Good()) {
+        return s;
+      }
+      if (next) {
+        active_[cursor_] = std::move(next);
+      } else {
+        active_.erase(active_.begin() + cursor_);
+      }
+      continue;
+    }
+    // Header
+    char header[kRecordHeaderSize];
+    uint64_t length = 0;
+    uint32_t crc = 0;
+    Status s = shard->Read(kRecordHeaderSize, header);
+    if (!s.Good()) {
+      return Status(Status::Type::kInternalError,
+                    "Truncated record in: " + shard->path);
+    }
+    std::memcpy(&length, header, sizeof(length));
+    std::memcpy(&crc, header + sizeof(length), sizeof(crc));
+    if (options_.verify_checksum && crc != MaskedCrc(&length, sizeof(length))) {
+      return Status(Status::Type::kInternalError,
+                    "Corrupted record length in: " + shard->path);
+    }
+    // Payload
+    record->resize(length);
+    s = shard->Read(length, length > 0 ? &(*record)[0] : nullptr);
+    if (s.Good()) {
+      s = shard->Read(kRecordFooterSize, reinterpret_cast<char*>(&crc));
+    }
+    if (!s.Good()) {
+      return Status(Status::Type::kInternalError,
+                    "Truncated record in: " + shard->path);
+    }
+    if (options_.verify_checksum && crc != MaskedCrc(record->data(), length)) {
+      return Status(Status::Type::kInternalError,
+                    "Corrupted record in: " + shard->path);
+    }
+    cursor_ += 1;
+    return s;
+  }
+  return Status(Status::Type::kOutOfRange, "No more records");
+}
+
+/*
+ *  @name   OpenNextShard
+ *  @fn     Status OpenNextShard(std::unique_ptr<Shard>* shard)
+ *  @brief  Open the next shard in the list, nullptr when there is none
+ */
+Status RecordReader::OpenNextShard(std::unique_ptr<Shard>* shard) {
+  shard->reset();
+  if (next_ >= paths_.size()) {
+    return Status();
+  }
+  const std::string& path = paths_[next_++];
+  FileSystem* fs = FileSystemFactory::Get().RetrieveForPath(path);
+  if (fs == nullptr) {
+    return Status(Status::Type::kUnimplemented,
+                  "No file system registered for: " + path);
+  }
+  std::unique_ptr<Shard> s(new Shard());
+  s->path = path;
+  Status status = fs->NewRandomAccessFile(path, &s->file);
+  if (status.Good()) {
+    status = s->file->Size(&s->size);
+  }
+  if (!status.Good()) {
+    return status;
+  }
+  s->buffer.resize(std::min(options_.buffer_size, std::max<size_t>(s->size,
+                                                                   1)));
+  *shard = std::move(s);
+  return status;
+}
+
+}  // namespace FaceKit
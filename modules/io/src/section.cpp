@@ -0,0 +1,296 @@
+/**
+ *  @file   section.cpp
+ *  @brief  Versioned layout of serialized objects made of tagged sections
+ *          listed in a table, readers only decode the sections they need
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   23.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+
+#include "facekit/io/section.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#pragma mark -
+#pragma mark Layout
+
+constexpr size_t SectionWriter::kAlignment;
+
+/** First bytes of a sectioned object, "FKSC" in little endian */
+static constexpr uint32_t kSectionMagic = 0x43534B46;
+/** Magic, version and number of sections */
+static constexpr size_t kPreambleSize = 8;
+/** Table entry: tag, reserved, offset, size */
+static constexpr size_t kEntrySize = 24;
+
+#pragma mark -
+#pragma mark Writer
+
+/*
+ *  @name   SectionWriter
+ *  @fn     explicit SectionWriter(const uint16_t& version)
+ *  @brief  Constructor
+ *  @param[in] version  Object's schema version, stored for the readers
+ */
+SectionWriter::SectionWriter(const uint16_t& version) : version_(version) {
+}
+
+/*
+ *  @name   Add
+ *  @fn     void Add(const uint32_t& tag, const size_t& size,
+                     const Callback& callback)
+ *  @brief  Declare a section
+ *  @param[in] tag      Section tag
+ *  @param[in] size     Number of bytes `callback` writes
+ *  @param[in] callback Write the payload, returns 0 on success
+ */
+void SectionWriter::Add(const uint32_t& tag,
+                        const size_t& size,
+                        const Callback& callback) {
+  sections_.push_back(Section{tag, 0, size});
+  callbacks_.push_back(callback);
+}
+
+/*
+ *  @name   Add
+ *  @fn     void Add(const uint32_t& tag, const void* data,
+                     const size_t& size)
+ *  @brief  Declare a section holding raw bytes
+ *  @param[in] tag  Section tag
+ *  @param[in] data Payload, must stay valid until `Write` returns
+ *  @param[in] size Payload size in bytes
+ */
+void SectionWriter::Add(const uint32_t& tag,
+                        const void* data,
+                        const size_t& size) {
+  this->Add(tag, size, [data, size](std::ostream& stream) {
+    stream.write(reinterpret_cast<const char*>(data), size);
+    return stream.good() ? 0 : -1;
+  });
+}
+
+/*
+ *  @name   Write
+ *  @fn     int Write(std::ostream& stream) const
+ *  @brief  Write the table and every section
+ *  @param[in] stream Binary stream
+ *  @return -1 if error (i.e. a callback did not write its declared size),
+ *          0 otherwise
+ */
+int SectionWriter::Write(std::ostream& stream) const {
+  if (!stream.good()) {
+    return -1;
+  }
+  // Place payloads, aligned on the stream position when it is known
+  const auto pos = stream.tellp();
+  const bool seekable = pos != std::streampos(-1);
+  const size_t start = seekable ? static_cast<size_t>(pos) : 0;
+  std::vector<Section> table = sections_;
+  size_t cursor = kPreambleSize + table.size() * kEntrySize;
+  for (auto& s : table) {
+    cursor += (kAlignment - (start + cursor) % kAlignment) % kAlignment;
+    s.offset = cursor;
+    cursor += s.size;
+  }
+  // Table
+  const uint32_t magic = kSectionMagic;
+  const uint16_t n = static_cast<uint16_t>(table.size());
+  const uint32_t reserved = 0;
+  stream.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+  stream.write(reinterpret_cast<const char*>(&version_), sizeof(version_));
+  stream.write(reinterpret_cast<const char*>(&n), sizeof(n));
+  for (const auto& s : table) {
+    stream.write(reinterpret_cast<const char*>(&s.tag), sizeof(s.tag));
+    stream.write(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+    stream.write(reinterpret_cast<const char*>(&s.offset), sizeof(s.offset));
+    stream.write(reinterpret_cast<const char*>(&s.size), sizeof(s.size));
+  }
+  // Payloads
+  const char zeros[kAlignment] = {0};
+  cursor = kPreambleSize + table.size() * kEntrySize;
+  for (size_t k = 0; k < table.size() && stream.good(); ++k) {
+    stream.write(zeros, table[k].offset - cursor);
+    if (callbacks_[k](stream) != 0) {
+      return -1;
+    }
+    cursor = table[k].offset + table[k].size;
+    if (seekable && static_cast<size_t>(stream.tellp()) != start + cursor) {
+      return -1;
+    }
+  }
+  return stream.good() ? 0 : -1;
+}
+
+/*
+ *  @name   Size
+ *  @fn     size_t Size(void) const
+ *  @brief  Object size in bytes, upper bound since the alignment padding
+ *          depends on the stream position
+ *  @return Object size
+ */
+size_t SectionWriter::Size(void) const {
+  size_t sz = kPreambleSize + sections_.size() * kEntrySize;
+  for (const auto& s : sections_) {
+    sz += s.size + kAlignment - 1;
+  }
+  return sz;
+}
+
+#pragma mark -
+#pragma mark Reader
+
+/*
+ *  @name   SectionReader
+ *  @fn     SectionReader(void)
+ *  @brief  Constructor
+ */
+SectionReader::SectionReader(void) : stream_(nullptr),
+                                     start_(0),
+                                     size_(0),
+                                     version_(0) {
+}
+
+/*
+ *  @name   IsSectioned
+ *  @fn     static bool IsSectioned(std::istream& stream)
+ *  @brief  Check if the stream is positioned at an object written by
+ *          `SectionWriter`, the position is left unchanged
+ *  @param[in] stream Binary stream
+ *  @return True if the magic number matches
+ */
+bool SectionReader::IsSectioned(std::istream& stream) {
+  uint32_t magic = 0;
+  const auto pos = stream.tellg();
+  stream.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+  const bool match = stream.good() && magic == kSectionMagic;
+  stream.clear();
+  stream.seekg(pos);
+  return match;
+}
+
+/*
+ *  @name   Open
+ *  @fn     Status Open(std::istream* stream)
+ *  @brief  Read the section table, the stream is left after it
+ *  @param[in] stream Binary stream positioned at the object, must outlive
+ *                    the reader
+ *  @return kNotFound if the object is not sectioned
+ */
+Status SectionReader::Open(std::istream* stream) {
+  stream_ = stream;
+  sections_.clear();
+  const auto pos = stream->tellg();
+  uint32_t magic = 0;
+  uint16_t n = 0;
+  stream->read(reinterpret_cast<char*>(&magic), sizeof(magic));
+  stream->read(reinterpret_cast<char*>(&version_), sizeof(version_));
+  stream->read(reinterpret_cast<char*>(&n), sizeof(n));
+  if (pos == std::streampos(-1) || !stream->good() || magic != kSectionMagic) {
+    return Status(Status::Type::kNotFound, "Not a sectioned object");
+  }
+  start_ = static_cast<size_t>(pos);
+  size_ = kPreambleSize + n * kEntrySize;
+  sections_.resize(n);
+  for (auto& s : sections_) {
+    uint32_t reserved;
+    stream->read(reinterpret_cast<char*>(&s.tag), sizeof(s.tag));
+    stream->read(reinterpret_cast<char*>(&reserved), sizeof(reserved));
+    stream->read(reinterpret_cast<char*>(&s.offset), sizeof(s.offset));
+    stream->read(reinterpret_cast<char*>(&s.size), sizeof(s.size));
+    size_ = std::max(size_, static_cast<size_t>(s.offset + s.size));
+  }
+  if (!stream->good()) {
+    return Status(Status::Type::kInternalError,
+                  "Error while reading section table");
+  }
+  return Status();
+}
+
+/*
+ *  @name   Find
+ *  @fn     const Section* Find(const uint32_t& tag) const
+ *  @brief  Look for a section
+ *  @param[in] tag  Section tag
+ *  @return Section or nullptr if absent
+ */
+const Section* SectionReader::Find(const uint32_t& tag) const {
+  for (const auto& s : sections_) {
+    if (s.tag == tag) {
+      return &s;
+    }
+  }
+  return nullptr;
+}
+
+/*
+ *  @name   Seek
+ *  @fn     Status Seek(const uint32_t& tag, size_t* size = nullptr)
+ *  @brief  Move the stream to the payload of a section
+ *  @param[in] tag    Section tag
+ *  @param[out] size  Optional payload size
+ *  @return kNotFound if absent
+ */
+Status SectionReader::Seek(const uint32_t& tag, size_t* size) {
+  const Section* s = this->Find(tag);
+  if (s == nullptr) {
+    return Status(Status::Type::kNotFound,
+                  "No section with tag: " + std::to_string(tag));
+  }
+  stream_->clear();
+  stream_->seekg(start_ + s->offset);
+  if (size) {
+    *size = static_cast<size_t>(s->size);
+  }
+  return Status();
+}
+
+/*
+ *  @name   Read
+ *  @fn     Status Read(const uint32_t& tag, void* data, const size_t& size)
+ *  @brief  Read a raw section
+ *  @param[in] tag    Section tag
+ *  @param[out] data  Buffer
+ *  @param[in] size   Expected payload size in bytes
+ *  @return kNotFound if absent, kInvalidArgument if the size differs
+ */
+Status SectionReader::Read(const uint32_t& tag,
+                           void* data,
+                           const size_t& size) {
+  size_t n = 0;
+  Status s = this->Seek(tag, &n);
+  if (!s.Good()) {
+    return s;
+  }
+  if (n != size) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Unexpected size for section: " + std::to_string(tag));
+  }
+  stream_->read(reinterpret_cast<char*>(data), size);
+  if (!stream_->good()) {
+    return Status(Status::Type::kInternalError,
+                  "Error while reading section: " + std::to_string(tag));
+  }
+  return s;
+}
+
+/*
+ *  @name   Finish
+ *  @fn     void Finish(void)
+ *  @brief  Move the stream right after the object
+ */
+void SectionReader::Finish(void) {
+  if (stream_) {
+    stream_->clear();
+    stream_->seekg(start_ + size_);
+  }
+}
+
+}  // namespace FaceKit
@@ -8,10 +8,14 @@
  *  Copyright © 2018 Christophe Ecabert. All rights reserved.
  */
 
+#include <fstream>
 #include <iostream>
+#include <vector>
 
 #include "facekit/io/tga_image.hpp"
 #include "facekit/io/image_factory.hpp"
+#include "facekit/io/image_writer.hpp"
+#include "pixel_conversion.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -241,48 +245,62 @@ TGAImage::~TGAImage(void) {
 }
   
 /*
- *  @name Load
- *  @fn Status Load(std::istream& stream) override
- *  @brief  Load image from dist
+ *  @name LoadInto
+ *  @fn Status LoadInto(std::istream& stream, NDArray* dst) override
+ *  @brief  Decode image into a caller provided array
  *  @param[in]  stream  Binary stream from where to load the ressource
+ *  @param[out] dst     Where to decode the pixels
  *  @return Operation status
  */
-Status TGAImage::Load(std::istream& stream) {
+Status TGAImage::LoadInto(std::istream& stream, NDArray* dst) {
   Status status;
   if (stream.good()) {
     int err = -1;
     // Read header
     stream >> *header_;
-    if (header_->image_type == 2 || header_->image_type == 3) {
-      // Handle only color or grayscale image for the moment
+    const int type = header_->image_type;
+    if (type == 2 || type == 3 || type == 10 || type == 11) {
+      // Handle only color or grayscale image for the moment, uncompressed
+      // (2, 3) or run-length encoded (10, 11)
       // Define image prop
       this->width_ = static_cast<size_t>(header_->image_spec.width);
       this->height_ = static_cast<size_t>(header_->image_spec.height);
       this->format_ = static_cast<Format>(header_->image_spec.pixel_depth / 8);
       // Allocate buffer
-      this->buffer_.Resize(DataType::kUInt8,
-                           {this->height_, this->width_, this->format_});
+      dst->Resize(DataType::kUInt8,
+                  {this->height_, this->width_, this->format_});
+      // Skip image ID
+      stream.ignore(header_->id_length);
       // Read data
-      int bpp = (header_->image_spec.pixel_depth + 7) / 8;
-      const size_t sz = (this->width_  * this->height_ * bpp);
-      auto* ptr = this->data();
-      stream.read(reinterpret_cast<char*>(ptr), sz);
-      if (this->format_ != Format::kGrayscale) {
+      size_t bpp = (header_->image_spec.pixel_depth + 7) / 8;
+      const size_t n_pixel = this->width_ * this->height_;
+      auto* ptr = dst->AsFlat<uint8_t>().data();
+      if (type < 9) {
+        stream.read(reinterpret_cast<char*>(ptr), n_pixel * bpp);
+        err = stream.good() ? 0 : -1;
+      } else {
+        // Packets size is unknown, decode from the remaining bytes. Buffer is
+        // kept per thread to avoid reallocating it for every image
+        static thread_local std::vector<uint8_t> rle;
+        const auto start = stream.tellg();
+        stream.seekg(0, std::ios_base::end);
+        const auto size = static_cast<size_t>(stream.tellg() - start);
+        stream.seekg(start);
+        rle.resize(size);
+        stream.read(reinterpret_cast<char*>(rle.data()), size);
+        if (stream.good()) {
+          err = internal::ExpandTgaRle(rle.data(), size, bpp, n_pixel, ptr) ?
+                0 : -1;
+        }
+      }
+      if (err == 0) {
         // Convert image pixel format (BGR -> RGB or BGRA -> RGBA)
-        auto* src = ptr;
-        auto* dst = &src[2];
-        uint8_t tmp;
-        const size_t n_elem = this->width_ * this->height_;
-        for (size_t n = 0; n < n_elem; ++n) {
-          tmp = *src;
-          *src = *dst;
-          *dst = tmp;
-          src += bpp;
-          dst += bpp;
+        internal::SwapRedBlue(ptr, n_pixel, bpp, ptr);
+        // Bit 5 of the descriptor is clear for bottom-left origin
+        if ((header_->image_spec.image_descriptor & 0x20) == 0) {
+          internal::FlipRows(ptr, this->height_, this->width_ * bpp);
         }
       }
-      // Sanity check
-      err = stream.good() ? 0 : -1;
     }
     if (err != 0) {
       status = Status(Status::Type::kInternalError, "Error while reading TGA");
@@ -293,6 +311,92 @@ Status TGAImage::Load(std::istream& stream) {
   return status;
 }
   
+/*
+ *  @name Map
+ *  @fn Status Map(const std::string& filename, const ChannelOrder& order,
+                   NDArray* dst) override
+ *  @brief  Map uncompressed top-down files without padding directly, i.e.
+ *          8 bits grayscale or BGR(A) when `order` is `kBGR`. Other files
+ *          are decoded.
+ *  @param[in]  filename  Path to ressource on the disk
+ *  @param[in]  order     Requested channel order, ignored for grayscale
+ *  @param[out] dst       Pixels
+ *  @return Operation status
+ */
+Status TGAImage::Map(const std::string& filename,
+                     const ChannelOrder& order,
+                     NDArray* dst) {
+  std::ifstream stream(filename.c_str(),
+                       std::ios_base::in | std::ios_base::binary);
+  if (!stream.is_open()) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Can not open: " + filename);
+  }
+  TGAHeader header;
+  stream >> header;
+  if (!stream.good()) {
+    return Status(Status::Type::kInternalError, "Error while reading TGA");
+  }
+  const TGAImageSpec& spec = header.image_spec;
+  const size_t depth = spec.pixel_depth;
+  // Pixels can be used as is if uncompressed, stored left-to-right from the
+  // top-left corner and in the requested layout
+  size_t channels = 0;
+  if ((spec.image_descriptor & 0x30) == 0x20) {
+    if (header.image_type == 3 && depth == 8) {
+      channels = 1;
+    } else if (header.image_type == 2 && (depth == 24 || depth == 32) &&
+               order == ChannelOrder::kBGR) {
+      channels = depth / 8;
+    }
+  }
+  if (channels != 0) {
+    // Pixels follow the header, image ID and color map
+    const auto& cmap = header.color_map_spec;
+    size_t offset = 18 + header.id_length;
+    if (header.color_map_type == 1) {
+      offset += cmap.n_entry * ((cmap.n_bit_per_pixel + 7) / 8);
+    }
+    const size_t width = spec.width;
+    const size_t height = spec.height;
+    Status s = dst->MapFile(filename,
+                            DataType::kUInt8,
+                            {height, width, channels},
+                            offset,
+                            NDArray::MapMode::kCopyOnWrite);
+    if (s.Good()) {
+      this->width_ = width;
+      this->height_ = height;
+      this->format_ = static_cast<Format>(channels);
+      return s;
+    }
+  }
+  return Image::Map(filename, order, dst);
+}
+
+/*
+ *  @name ParseHeader
+ *  @fn Status ParseHeader(std::istream& stream, ImageInfo* info) override
+ *  @brief  Parse image header without decoding the pixels
+ *  @param[in]  stream  Binary stream from where to read the header
+ *  @param[out] info    Image properties
+ *  @return Operation status
+ */
+Status TGAImage::ParseHeader(std::istream& stream, ImageInfo* info) {
+  TGAHeader header;
+  stream >> header;
+  // Handle only color or grayscale image for the moment
+  const int type = header.image_type;
+  if (!stream.good() ||
+      (type != 2 && type != 3 && type != 10 && type != 11)) {
+    return Status(Status::Type::kInternalError, "Error while reading TGA");
+  }
+  info->width = static_cast<size_t>(header.image_spec.width);
+  info->height = static_cast<size_t>(header.image_spec.height);
+  info->format = static_cast<Format>(header.image_spec.pixel_depth / 8);
+  return Status();
+}
+
 /*
  *  @name Save
  *  @fn Status Save(std::ostream& stream) const override
@@ -309,20 +413,8 @@ Status TGAImage::Save(std::ostream& stream) const {
     // Do copy since the method is marked as 'const'
     size_t bpp = static_cast<size_t>(this->format_);
     size_t n_pixel = this->width_ * this->height_;
-    auto* ptr = this->data();
-    std::vector<uint8_t> buffer(ptr, ptr + (n_pixel * bpp));
-    if (this->format_ != Format::kGrayscale) {
-      auto* src = buffer.data();
-      auto* dst = &src[2];
-      uint8_t tmp = 0;
-      for (size_t n = 0; n < n_pixel; ++n) {
-        tmp = *src;
-        *src = *dst;
-        *dst = tmp;
-        src += bpp;
-        dst += bpp;
-      }
-    }
+    std::vector<uint8_t> buffer(n_pixel * bpp);
+    internal::SwapRedBlue(this->data(), n_pixel, bpp, buffer.data());
     // Write
     stream.write(reinterpret_cast<const char*>(buffer.data()),
                  this->width_ * this->height_ * bpp);
@@ -335,6 +427,80 @@ Status TGAImage::Save(std::ostream& stream) const {
   return status;
 }
   
+#pragma mark -
+#pragma mark Streaming writer
+
+/**
+ *  @class  TGAImageWriter
+ *  @brief  Streaming TGA encoder (uncompressed, top-left origin)
+ */
+class TGAImageWriter : public ImageWriter {
+ protected:
+  /** Write header */
+  Status OpenImpl(void) override {
+    if (width_ > 0xFFFF || height_ > 0xFFFF) {
+      return Status(Status::Type::kInvalidArgument, "Image too large for TGA");
+    }
+    TGAHeader header;
+    header.id_length = 0;
+    header.color_map_type = 0;
+    header.image_type = format_ == Image::Format::kGrayscale ? 3 : 2;
+    header.image_spec.x_origin = 0;
+    header.image_spec.y_origin = 0;
+    header.image_spec.width = static_cast<unsigned short>(width_);
+    header.image_spec.height = static_cast<unsigned short>(height_);
+    header.image_spec.pixel_depth = static_cast<unsigned char>(format_ * 8);
+    // Top-left origin, alpha depth
+    header.image_spec.image_descriptor = static_cast<unsigned char>(
+            0x20 | (format_ == Image::Format::kRGBA ? 8 : 0));
+    *stream_ << header;
+    return stream_->good() ?
+           Status() :
+           Status(Status::Type::kInternalError, "Error while writing TGA");
+  }
+
+  /** Swap channels and write a strip */
+  Status WriteImpl(const uint8_t* rows, const size_t& n_rows) override {
+    const size_t bpp = static_cast<size_t>(format_);
+    const size_t stride = width_ * bpp;
+    if (format_ == Image::Format::kGrayscale) {
+      stream_->write(reinterpret_cast<const char*>(rows), n_rows * stride);
+    } else {
+      // RGB -> BGR or RGBA -> BGRA, one row at a time
+      buffer_.resize(stride);
+      for (size_t r = 0; r < n_rows; ++r) {
+        internal::SwapRedBlue(&rows[r * stride], width_, bpp, buffer_.data());
+        stream_->write(reinterpret_cast<const char*>(buffer_.data()), stride);
+      }
+    }
+    return stream_->good() ?
+           Status() :
+           Status(Status::Type::kInternalError, "Error while writing TGA");
+  }
+
+  /** Nothing to finalize */
+  Status CloseImpl(void) override {
+    stream_->flush();
+    return stream_->good() ?
+           Status() :
+           Status(Status::Type::kInternalError, "Error while writing TGA");
+  }
+
+ private:
+  /** Row with swapped channels */
+  std::vector<uint8_t> buffer_;
+};
+
+/*
+ *  @name CreateWriter
+ *  @fn ImageWriter* CreateWriter(void) const override
+ *  @brief  Create a streaming encoder, caller takes ownership
+ *  @return Writer instance
+ */
+ImageWriter* TGAImage::CreateWriter(void) const {
+  return new TGAImageWriter();
+}
+
 #pragma mark -
 #pragma mark Registration
   
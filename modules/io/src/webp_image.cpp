@@ -0,0 +1,173 @@
+/**
+ *  @file   webp_image.cpp
+ *  @brief WebP Image object
+ *  @ingroup io
+ *
+ *  @author Christophe Ecabert
+ *  @date   20.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "webp/decode.h"
+#include "webp/encode.h"
+
+#include "facekit/io/webp_image.hpp"
+#include "facekit/io/image_factory.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+#pragma mark -
+#pragma mark Helper
+
+/** Bytes needed to read the features of any WebP flavour (VP8/VP8L/VP8X) */
+static constexpr size_t kWebPProbeSize = 64;
+/** Quality used when no compression level is set */
+static constexpr int kWebPDefaultQuality = 90;
+
+/**
+ *  @name   ReadFeatures
+ *  @fn     static bool ReadFeatures(const uint8_t* data, const size_t& size,
+                                     Image::ImageInfo* info)
+ *  @brief  Extract image properties from the beginning of a WebP stream
+ *  @param[in] data   Encoded data
+ *  @param[in] size   Data size in bytes
+ *  @param[out] info  Image properties
+ *  @return True on success
+ */
+static bool ReadFeatures(const uint8_t* data,
+                         const size_t& size,
+                         Image::ImageInfo* info) {
+  WebPBitstreamFeatures features;
+  if (WebPGetFeatures(data, size, &features) != VP8_STATUS_OK) {
+    return false;
+  }
+  info->width = static_cast<size_t>(features.width);
+  info->height = static_cast<size_t>(features.height);
+  info->format = features.has_alpha ?
+                 Image::Format::kRGBA :
+                 Image::Format::kRGB;
+  return true;
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name LoadInto
+ *  @fn Status LoadInto(std::istream& stream, NDArray* dst) override
+ *  @brief  Decode image into a caller provided array
+ *  @param[in]  stream  Binary stream from where to load the ressource
+ *  @param[out] dst     Where to decode the pixels
+ *  @return Operation status
+ */
+Status WebPImage::LoadInto(std::istream& stream, NDArray* dst) {
+  if (!stream.good()) {
+    return Status(Status::Type::kInvalidArgument, "Stream has errors");
+  }
+  // libwebp decodes from memory only. Buffer is kept per thread to avoid
+  // reallocating it for every image
+  static thread_local std::vector<uint8_t> data;
+  const auto start = stream.tellg();
+  stream.seekg(0, std::ios_base::end);
+  const auto size = static_cast<size_t>(stream.tellg() - start);
+  stream.seekg(start);
+  data.resize(size);
+  stream.read(reinterpret_cast<char*>(data.data()), size);
+  ImageInfo info;
+  if (!stream.good() || !ReadFeatures(data.data(), size, &info)) {
+    return Status(Status::Type::kInternalError, "Error while reading WebP");
+  }
+  this->width_ = info.width;
+  this->height_ = info.height;
+  this->format_ = info.format;
+  dst->Resize(DataType::kUInt8,
+              {this->height_, this->width_, this->format_});
+  // Decode straight into the output array
+  uint8_t* ptr = dst->AsFlat<uint8_t>().data();
+  const int stride = static_cast<int>(this->width_ * this->format_);
+  const size_t n = this->width_ * this->height_ * this->format_;
+  const uint8_t* out = this->format_ == Format::kRGBA ?
+          WebPDecodeRGBAInto(data.data(), size, ptr, n, stride) :
+          WebPDecodeRGBInto(data.data(), size, ptr, n, stride);
+  return out != nullptr ?
+         Status() :
+         Status(Status::Type::kInternalError, "Error while reading WebP");
+}
+
+/*
+ *  @name ParseHeader
+ *  @fn Status ParseHeader(std::istream& stream, ImageInfo* info) override
+ *  @brief  Parse image header without decoding the pixels
+ *  @param[in]  stream  Binary stream from where to read the header
+ *  @param[out] info    Image properties
+ *  @return Operation status
+ */
+Status WebPImage::ParseHeader(std::istream& stream, ImageInfo* info) {
+  uint8_t buff[kWebPProbeSize];
+  stream.read(reinterpret_cast<char*>(buff), kWebPProbeSize);
+  const size_t n = static_cast<size_t>(stream.gcount());
+  if (!ReadFeatures(buff, n, info)) {
+    return Status(Status::Type::kInternalError, "Error while reading WebP");
+  }
+  return Status();
+}
+
+/*
+ *  @name Save
+ *  @fn Status Save(std::ostream& stream) const override
+ *  @brief  Save image into a given stream
+ *  @param[in]  stream  Binary stream to where to save the ressource
+ *  @return Operation status
+ */
+Status WebPImage::Save(std::ostream& stream) const {
+  if (!stream.good() || this->data() == nullptr) {
+    return Status(Status::Type::kInvalidArgument, "Stream has errors");
+  }
+  if (this->width_ > WEBP_MAX_DIMENSION || this->height_ > WEBP_MAX_DIMENSION) {
+    return Status(Status::Type::kInvalidArgument, "Image too large for WebP");
+  }
+  const int w = static_cast<int>(this->width_);
+  const int h = static_cast<int>(this->height_);
+  const float quality = static_cast<float>(level_ < 0 ?
+                                           kWebPDefaultQuality :
+                                           std::min(level_, 100));
+  const uint8_t* src = this->data();
+  std::vector<uint8_t> rgb;
+  if (this->format_ == Format::kGrayscale) {
+    // No grayscale layout, replicate the channel
+    const size_t n_pixel = this->width_ * this->height_;
+    rgb.resize(3 * n_pixel);
+    for (size_t k = 0; k < n_pixel; ++k) {
+      std::fill(&rgb[3 * k], &rgb[3 * k + 3], src[k]);
+    }
+    src = rgb.data();
+  }
+  uint8_t* out = nullptr;
+  const size_t size = this->format_ == Format::kRGBA ?
+          WebPEncodeRGBA(src, w, h, 4 * w, quality, &out) :
+          WebPEncodeRGB(src, w, h, 3 * w, quality, &out);
+  Status status;
+  if (size != 0) {
+    stream.write(reinterpret_cast<const char*>(out), size);
+  }
+  if (size == 0 || !stream.good()) {
+    status = Status(Status::Type::kInternalError, "Error while writing WebP");
+  }
+  WebPFree(out);
+  return status;
+}
+
+#pragma mark -
+#pragma mark Registration
+
+/** Add webp implementation to the image factory */
+REGISTER_IMAGE_IMPL(WebPImage, "webp");
+
+}  // namespace FaceKit
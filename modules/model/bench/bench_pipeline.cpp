@@ -0,0 +1,384 @@
+/**
+ *  @file   bench_pipeline.cpp
+ *  @brief  End-to-end benchmark: image decode, camera fit, PCA generation and
+ *          encoding over a dataset at a given concurrency. Results are
+ *          reported as JSON to be tracked across releases.
+ *  @ingroup model
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#if defined(__APPLE__) || defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/cmd_parser.hpp"
+#include "facekit/core/logger.hpp"
+#include "facekit/core/mem/allocator.hpp"
+#include "facekit/core/sys/file_system_factory.hpp"
+#include "facekit/core/utils/string.hpp"
+#include "facekit/io/image_factory.hpp"
+#include "facekit/model/camera.hpp"
+#include "facekit/model/pca_model_factory.hpp"
+#include "facekit/model/perspective_projection.hpp"
+
+namespace FK = FaceKit;
+
+using Cam = FK::Camera<float, FK::PerspectiveProjection>;
+using Point3 = Cam::Point3;
+using Point2 = Cam::Point2;
+using Factory = FK::PCAModelFactory<float>;
+using Clock = std::chrono::steady_clock;
+
+/** Number of landmarks used to fit the camera, as in common annotations */
+static constexpr size_t kLandmark = 68;
+
+/**
+ *  @struct Sample
+ *  @brief  Latencies of one item in milliseconds
+ */
+struct Sample {
+  /** Whole pipeline */
+  double total = 0.0;
+  /** Image decoding */
+  double decode = 0.0;
+  /** Camera fitting */
+  double fit = 0.0;
+  /** Instance generation */
+  double generate = 0.0;
+  /** Image encoding */
+  double save = 0.0;
+};
+
+/**
+ *  @name   Elapsed
+ *  @fn     static double Elapsed(Clock::time_point* start)
+ *  @brief  Milliseconds since `start`, which is moved to now
+ */
+static double Elapsed(Clock::time_point* start) {
+  const auto now = Clock::now();
+  const std::chrono::duration<double, std::milli> dt = now - *start;
+  *start = now;
+  return dt.count();
+}
+
+/**
+ *  @name   Percentile
+ *  @fn     static double Percentile(std::vector<double>* v, const double& p)
+ *  @brief  Nearest-rank percentile `p` in [0, 1], `v` is sorted in place
+ */
+static double Percentile(std::vector<double>* v, const double& p) {
+  if (v->empty()) {
+    return 0.0;
+  }
+  std::sort(v->begin(), v->end());
+  const size_t k = static_cast<size_t>(p * double(v->size() - 1) + 0.5);
+  return (*v)[std::min(k, v->size() - 1)];
+}
+
+/**
+ *  @name   WriteString
+ *  @fn     static void WriteString(std::ostream& out, const std::string& str)
+ *  @brief  Write a quoted and escaped JSON string
+ */
+static void WriteString(std::ostream& out, const std::string& str) {
+  out << '"';
+  for (const char c : str) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out << ' ';
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+/**
+ *  @name   WriteStage
+ *  @fn     static void WriteStage(std::ostream& out, const char* name,
+                                   std::vector<double>* v, const bool& last)
+ *  @brief  Write the latency percentiles of a stage
+ */
+static void WriteStage(std::ostream& out,
+                       const char* name,
+                       std::vector<double>* v,
+                       const bool& last) {
+  const double p50 = Percentile(v, 0.5);
+  const double p99 = Percentile(v, 0.99);
+  out << "    \"" << name << "\": {\"p50_ms\": " << p50 << ", \"p99_ms\": "
+      << p99 << ", \"max_ms\": " << (v->empty() ? 0.0 : v->back()) << "}"
+      << (last ? "\n" : ",\n");
+}
+
+/**
+ *  @name   PeakRss
+ *  @fn     static size_t PeakRss(void)
+ *  @brief  Peak resident set size of the process in bytes, 0 if unknown
+ */
+static size_t PeakRss(void) {
+#if defined(__APPLE__)
+  struct rusage usage;
+  return getrusage(RUSAGE_SELF, &usage) == 0 ? size_t(usage.ru_maxrss) : 0;
+#elif defined(__linux__)
+  struct rusage usage;
+  return getrusage(RUSAGE_SELF, &usage) == 0 ?
+         size_t(usage.ru_maxrss) * 1024 : 0;
+#else
+  return 0;
+#endif
+}
+
+/**
+ *  @name   Landmarks
+ *  @fn     static FK::Status Landmarks(const Factory::Model& model,
+                                        std::vector<Point3>* pts,
+                                        size_t* dim)
+ *  @brief  Pick `kLandmark` vertices evenly spread over the model's mean
+ *          shape, the dataset does not carry annotations
+ *  @param[in] model  Shape model
+ *  @param[out] pts   Landmarks
+ *  @param[out] dim   Dimension of the model's instances
+ */
+static FK::Status Landmarks(const Factory::Model& model,
+                            std::vector<Point3>* pts,
+                            size_t* dim) {
+  if (model.get_n_channels() != 3) {
+    return FK::Status(FK::Status::Type::kInvalidArgument,
+                      "Model must describe 3D shapes");
+  }
+  cv::Mat p = cv::Mat::zeros(model.get_n_principle_component(), 1, CV_32F);
+  cv::Mat mean;
+  auto s = model.GenerateBatch(p, &mean);
+  if (s.Good()) {
+    *dim = size_t(mean.rows);
+    const size_t n_vertex = *dim / 3;
+    const size_t n = std::min(kLandmark, n_vertex);
+    const float* v = mean.ptr<float>();
+    pts->clear();
+    for (size_t k = 0; k < n; ++k) {
+      const size_t i = (k * n_vertex) / n;
+      pts->emplace_back(v[3 * i], v[3 * i + 1], v[3 * i + 2]);
+    }
+  }
+  return s;
+}
+
+int main(const int argc, const char** argv) {
+  using ArgState = FK::CmdLineParser::ArgState;
+  FK::CmdLineParser parser;
+  parser.AddArgument("-i", ArgState::kNeeded, "Dataset folder (images)");
+  parser.AddArgument("-m", ArgState::kNeeded, "Shape model file");
+  parser.AddArgument("-n", ArgState::kNeeded, "Registered model name");
+  parser.AddArgument("-c",
+                     ArgState::kOptional,
+                     "Concurrency, number of items in flight (default: cores)");
+  parser.AddArgument("-r",
+                     ArgState::kOptional,
+                     "Number of passes over the dataset (default: 1)");
+  parser.AddArgument("-o",
+                     ArgState::kOptional,
+                     "Output folder, images are encoded in memory if omitted");
+  parser.AddArgument("-j",
+                     ArgState::kOptional,
+                     "Output JSON file (default: stdout)");
+  int err = parser.ParseCmdLine(argc, argv);
+  if (err) {
+    FACEKIT_LOG_ERROR("Unable to parse command line!");
+    return err;
+  }
+  std::string folder, model_path, model_name, conc, rep, output, json;
+  parser.HasArgument("-i", &folder);
+  parser.HasArgument("-m", &model_path);
+  parser.HasArgument("-n", &model_name);
+  parser.HasArgument("-c", &conc);
+  parser.HasArgument("-r", &rep);
+  parser.HasArgument("-o", &output);
+  parser.HasArgument("-j", &json);
+  size_t n_worker = conc.empty() ? std::thread::hardware_concurrency() :
+                    size_t(std::atoi(conc.c_str()));
+  n_worker = std::max(n_worker, size_t(1));
+  const size_t n_pass = size_t(std::max(rep.empty() ?
+                                        1 :
+                                        std::atoi(rep.c_str()), 1));
+
+  // Dataset, only files with a registered image format
+  std::vector<std::string> files;
+  {
+    FK::FileSystem* fs = FK::FileSystemFactory::Get().RetrieveForPath(folder);
+    std::vector<std::string> content;
+    if (!fs || !fs->ListDirRecursively(folder, &content).Good()) {
+      FACEKIT_LOG_ERROR("Unable to scan " << folder);
+      return -1;
+    }
+    for (const auto& f : content) {
+      std::string dir, file, ext;
+      FK::Path::SplitComponent(f, &dir, &file, &ext);
+      std::unique_ptr<FK::Image> img(FK::ImageFactory::Get()
+                                     .CreateByExtension(ext));
+      if (img) {
+        files.push_back(f);
+      }
+    }
+    std::sort(files.begin(), files.end());
+  }
+  if (files.empty()) {
+    FACEKIT_LOG_ERROR("No images found in " << folder);
+    return -1;
+  }
+  // Model and landmarks
+  Factory::LoadOptions options;
+  options.name = model_name;
+  Factory::Handle model;
+  auto s = Factory::Get().Acquire(model_path, options, &model);
+  std::vector<Point3> landmarks;
+  size_t dim = 0;
+  if (s.Good()) {
+    s = Landmarks(*model, &landmarks, &dim);
+  }
+  if (!s.Good()) {
+    FACEKIT_LOG_ERROR("Unable to load model: " << s.ToString());
+    return -1;
+  }
+  // Object extent, places the synthetic face in front of the camera
+  float extent = 0.f;
+  for (const auto& p : landmarks) {
+    extent = std::max(extent, std::max(std::abs(p.x_), std::abs(p.y_)));
+  }
+
+  // Run, each worker processes one item at a time
+  FK::EnableAllocatorStatistics(true);
+  FK::DefaultCpuAllocator()->ClearStatistics();
+  const size_t n_item = files.size() * n_pass;
+  std::vector<Sample> samples(n_item);
+  std::vector<uint8_t> success(n_item, 0);
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    Factory::Model::Workspace ws;
+    std::vector<float> instance(dim);
+    std::vector<Point2> proj;
+    std::ostringstream stream;
+    for (size_t k = next.fetch_add(1); k < n_item; k = next.fetch_add(1)) {
+      const std::string& path = files[k % files.size()];
+      Sample& sample = samples[k];
+      const auto start = Clock::now();
+      auto t = start;
+      // Decode
+      std::string dir, file, ext;
+      FK::Path::SplitComponent(path, &dir, &file, &ext);
+      std::unique_ptr<FK::Image> image(FK::ImageFactory::Get()
+                                       .CreateByExtension(ext));
+      if (!image || !image->Load(path).Good()) {
+        continue;
+      }
+      sample.decode = Elapsed(&t);
+      // Fit the camera on landmarks seen from a pose varying with the item
+      const float w = float(image->width());
+      const float h = float(image->height());
+      Cam gt(w, w, h);
+      Cam cam(w, w, h);
+      float param[10];
+      gt.ToVector(param);
+      param[3] = 0.02f * float(k % 11) - 0.1f;
+      param[4] = 0.03f * float(k % 7) - 0.09f;
+      param[5] = 0.01f * float(k % 5);
+      param[6] = 1.f;
+      param[7] = 0.f;
+      param[8] = 0.f;
+      param[9] = 4.f * extent;
+      gt.FromVector(param);
+      gt(landmarks, &proj);
+      const int fit = cam.From3Dto2D(landmarks, proj, 1e-6f);
+      sample.fit = Elapsed(&t);
+      // Generate a random instance
+      cv::RNG rng(uint64_t(k) + 1);
+      model->Generate(&rng, &ws, instance.data());
+      sample.generate = Elapsed(&t);
+      // Encode
+      FK::Status save;
+      if (output.empty()) {
+        stream.str("");
+        save = image->Save(stream);
+      } else {
+        save = image->Save(output + "/" + file + "_" + std::to_string(k) +
+                           "." + ext);
+      }
+      sample.save = Elapsed(&t);
+      sample.total = std::chrono::duration<double, std::milli>(Clock::now() -
+                                                               start).count();
+      success[k] = (fit == 0 && save.Good()) ? 1 : 0;
+    }
+  };
+  const auto run_start = Clock::now();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < n_worker; ++i) {
+    threads.emplace_back(worker);
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  const double wall = std::chrono::duration<double>(Clock::now() -
+                                                    run_start).count();
+
+  // Report
+  std::vector<double> total, decode, fit, generate, save;
+  for (size_t k = 0; k < n_item; ++k) {
+    if (success[k]) {
+      total.push_back(samples[k].total);
+      decode.push_back(samples[k].decode);
+      fit.push_back(samples[k].fit);
+      generate.push_back(samples[k].generate);
+      save.push_back(samples[k].save);
+    }
+  }
+  FK::AllocatorStatistic stats;
+  FK::DefaultCpuAllocator()->GatherStatistics(&stats);
+  std::ofstream json_file;
+  if (!json.empty()) {
+    json_file.open(json.c_str());
+    if (!json_file.is_open()) {
+      FACEKIT_LOG_ERROR("Unable to open " << json);
+      return -1;
+    }
+  }
+  std::ostream& out = json.empty() ? std::cout : json_file;
+  out << "{\n  \"dataset\": ";
+  WriteString(out, folder);
+  out << ",\n  \"model\": ";
+  WriteString(out, model_path);
+  out << ",\n  \"concurrency\": " << n_worker
+      << ",\n  \"items\": " << n_item
+      << ",\n  \"failures\": " << (n_item - total.size())
+      << ",\n  \"wall_s\": " << wall
+      << ",\n  \"throughput_items_per_s\": "
+      << (wall > 0.0 ? double(total.size()) / wall : 0.0)
+      << ",\n  \"latency\": {\n";
+  WriteStage(out, "total", &total, false);
+  WriteStage(out, "decode", &decode, false);
+  WriteStage(out, "fit", &fit, false);
+  WriteStage(out, "generate", &generate, false);
+  WriteStage(out, "save", &save, true);
+  out << "  },\n  \"memory\": {\"allocator_peak_bytes\": "
+      << stats.max_used_bytes << ", \"allocator_n_alloc\": " << stats.n_alloc
+      << ", \"peak_rss_bytes\": " << PeakRss() << "}\n}" << std::endl;
+  return total.empty() ? -1 : 0;
+}
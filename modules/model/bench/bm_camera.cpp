@@ -0,0 +1,325 @@
+/**
+ *  @file   bm_camera.cpp
+ *  @brief Microbenchmark for Camera pose estimation
+ *  @ingroup model
+ *
+ *  @author Christophe Ecabert
+ *  @date   07.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "facekit/model/camera.hpp"
+#include "facekit/model/camera_batch_fitter.hpp"
+#include "facekit/model/orthographic_projection.hpp"
+#include "facekit/model/perspective_projection.hpp"
+#include "facekit/model/rasterizer.hpp"
+#include "facekit/model/weak_projection.hpp"
+
+namespace FK = FaceKit;
+
+/** Seed used to generate fixture data, keep runs comparable */
+static constexpr unsigned kSeed = 0x5EED;
+
+/**
+ *  Estimate the pose from `range(0)` 3D-2D correspondences. Projections are
+ *  generated from a known pose, the camera is reset before each estimation.
+ */
+template<typename T, template<typename U> class ProjType>
+static void BM_CameraFrom3Dto2D(benchmark::State& state) {
+  using Cam = FK::Camera<T, ProjType>;
+  using Point3 = typename Cam::Point3;
+  using Point2 = typename Cam::Point2;
+  const size_t n = static_cast<size_t>(state.range(0));
+  // Reproducible point cloud, roughly face sized
+  std::mt19937 gen(kSeed);
+  std::uniform_real_distribution<T> dist(T(-80.0), T(80.0));
+  std::vector<Point3> pts(n);
+  for (auto& p : pts) {
+    p = Point3(dist(gen), dist(gen), dist(gen) * T(0.5));
+  }
+  // Ground truth pose: [f cx cy qx qy qz qw tx ty tz]
+  Cam gt(T(700.0), T(640.0), T(480.0));
+  T param[10];
+  gt.ToVector(param);
+  param[3] = T(0.1); param[4] = T(0.2); param[5] = T(0.05); param[6] = T(1.0);
+  param[7] = T(5.0); param[8] = T(-3.0); param[9] = T(400.0);
+  gt.FromVector(param);
+  std::vector<Point2> proj;
+  gt(pts, &proj);
+  // Estimate
+  Cam cam(T(700.0), T(640.0), T(480.0));
+  T init[10];
+  cam.ToVector(init);
+  for (auto _ : state) {
+    cam.FromVector(init);
+    benchmark::DoNotOptimize(cam.From3Dto2D(pts, proj, T(1e-6)));
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n);
+}
+BENCHMARK_TEMPLATE(BM_CameraFrom3Dto2D, float, FK::OrthographicProjection)
+    ->Arg(68)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_CameraFrom3Dto2D, float, FK::WeakProjection)
+    ->Arg(68)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_CameraFrom3Dto2D, float, FK::PerspectiveProjection)
+    ->Arg(68)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_CameraFrom3Dto2D, double, FK::PerspectiveProjection)
+    ->Arg(68)->Arg(1024);
+
+/**
+ *  Estimate the pose from `range(0)` noisy 3D-2D correspondences, 10% of
+ *  them being outliers. `range(1)` selects the solver: 0 Gauss-Newton,
+ *  otherwise Levenberg-Marquardt with `Loss` = range(1) - 1. The number of
+ *  accepted steps is reported as a counter.
+ */
+template<typename T, template<typename U> class ProjType>
+static void BM_CameraFrom3Dto2DNoisy(benchmark::State& state) {
+  using Cam = FK::Camera<T, ProjType>;
+  using Point3 = typename Cam::Point3;
+  using Point2 = typename Cam::Point2;
+  const size_t n = static_cast<size_t>(state.range(0));
+  std::mt19937 gen(kSeed);
+  std::uniform_real_distribution<T> dist(T(-80.0), T(80.0));
+  std::normal_distribution<T> noise(T(0.0), T(1.5));
+  std::vector<Point3> pts(n);
+  for (auto& p : pts) {
+    p = Point3(dist(gen), dist(gen), dist(gen) * T(0.5));
+  }
+  Cam gt(T(700.0), T(640.0), T(480.0));
+  T param[10];
+  gt.ToVector(param);
+  param[3] = T(0.1); param[4] = T(0.2); param[5] = T(0.05); param[6] = T(1.0);
+  param[7] = T(5.0); param[8] = T(-3.0); param[9] = T(400.0);
+  gt.FromVector(param);
+  std::vector<Point2> proj;
+  gt(pts, &proj);
+  for (size_t i = 0; i < n; ++i) {
+    const T scale = (i % 10) == 0 ? T(40.0) : T(1.0);
+    proj[i].x_ += scale * noise(gen);
+    proj[i].y_ += scale * noise(gen);
+  }
+  cv::Mat p3s(int(3 * n), 1, cv::DataType<T>::type, (void*)pts.data());
+  cv::Mat p2s(int(2 * n), 1, cv::DataType<T>::type, (void*)proj.data());
+  typename Cam::FitOptions options;
+  typename Cam::FitSummary summary;
+  if (state.range(1) > 0) {
+    options.loss = static_cast<typename Cam::Loss>(state.range(1) - 1);
+  }
+  Cam cam(T(700.0), T(640.0), T(480.0));
+  T init[10];
+  cam.ToVector(init);
+  for (auto _ : state) {
+    cam.FromVector(init);
+    if (state.range(1) == 0) {
+      benchmark::DoNotOptimize(cam.From3Dto2D(p3s, p2s, T(1e-6)));
+    } else {
+      benchmark::DoNotOptimize(cam.From3Dto2D(p3s, p2s, options, &summary));
+    }
+  }
+  state.counters["steps"] = summary.n_iter;
+  state.SetItemsProcessed(int64_t(state.iterations()) * n);
+}
+BENCHMARK_TEMPLATE(BM_CameraFrom3Dto2DNoisy, float, FK::PerspectiveProjection)
+    ->ArgsProduct({{68, 1024}, {0, 1, 2, 3}});
+
+/**
+ *  Fit `range(0)` cameras of 68 landmarks each, as in a crowded frame.
+ *  `range(1)` 0 fits them one after the other, 1 with `CameraBatchFitter`.
+ */
+template<typename T, template<typename U> class ProjType>
+static void BM_CameraBatchFit(benchmark::State& state) {
+  using Cam = FK::Camera<T, ProjType>;
+  using Fitter = FK::CameraBatchFitter<T, ProjType>;
+  using Point3 = typename Cam::Point3;
+  using Point2 = typename Cam::Point2;
+  const size_t n_face = static_cast<size_t>(state.range(0));
+  const size_t n = 68;
+  std::mt19937 gen(kSeed);
+  std::uniform_real_distribution<T> dist(T(-80.0), T(80.0));
+  std::vector<std::vector<Point3>> pts(n_face, std::vector<Point3>(n));
+  std::vector<std::vector<Point2>> proj(n_face);
+  std::vector<std::unique_ptr<Cam>> cams;
+  std::vector<typename Fitter::Problem> problems(n_face);
+  Cam gt(T(700.0), T(640.0), T(480.0));
+  T param[10];
+  T init[10];
+  gt.ToVector(init);
+  for (size_t f = 0; f < n_face; ++f) {
+    for (auto& p : pts[f]) {
+      p = Point3(dist(gen), dist(gen), dist(gen) * T(0.5));
+    }
+    std::copy(init, init + 10, param);
+    param[3] = T(0.1); param[4] = T(0.2); param[5] = T(0.05);
+    param[6] = T(1.0); param[7] = dist(gen); param[8] = dist(gen);
+    param[9] = T(400.0);
+    gt.FromVector(param);
+    gt(pts[f], &proj[f]);
+    cams.emplace_back(new Cam(T(700.0), T(640.0), T(480.0)));
+    problems[f].pts = cv::Mat(int(3 * n), 1, cv::DataType<T>::type,
+                              (void*)pts[f].data());
+    problems[f].proj = cv::Mat(int(2 * n), 1, cv::DataType<T>::type,
+                               (void*)proj[f].data());
+    problems[f].camera = cams.back().get();
+  }
+  Fitter fitter;
+  std::vector<int> status;
+  for (auto _ : state) {
+    for (auto& c : cams) {
+      c->FromVector(init);
+    }
+    if (state.range(1) == 0) {
+      for (auto& p : problems) {
+        benchmark::DoNotOptimize(p.camera->From3Dto2D(p.pts,
+                                                      p.proj,
+                                                      fitter.options(),
+                                                      nullptr));
+      }
+    } else {
+      fitter.Fit(problems, &status, nullptr);
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n_face);
+}
+BENCHMARK_TEMPLATE(BM_CameraBatchFit, float, FK::PerspectiveProjection)
+    ->ArgsProduct({{8, 64, 512}, {0, 1}})->UseRealTime();
+
+/**
+ *  Track a slowly moving face over 100 frames of `range(0)` landmarks.
+ *  `range(1)` 1 warm starts each frame from the previous pose, 0 runs a
+ *  full fit per frame.
+ */
+template<typename T, template<typename U> class ProjType>
+static void BM_CameraTrack(benchmark::State& state) {
+  using Cam = FK::Camera<T, ProjType>;
+  using Point3 = typename Cam::Point3;
+  using Point2 = typename Cam::Point2;
+  const size_t n = static_cast<size_t>(state.range(0));
+  const int n_frame = 100;
+  std::mt19937 gen(kSeed);
+  std::uniform_real_distribution<T> dist(T(-80.0), T(80.0));
+  std::vector<Point3> pts(n);
+  for (auto& p : pts) {
+    p = Point3(dist(gen), dist(gen), dist(gen) * T(0.5));
+  }
+  cv::Mat p3s(int(3 * n), 1, cv::DataType<T>::type, (void*)pts.data());
+  // Smooth trajectory
+  Cam gt(T(700.0), T(640.0), T(480.0));
+  T init[10];
+  gt.ToVector(init);
+  std::vector<std::vector<Point2>> proj(n_frame);
+  for (int f = 0; f < n_frame; ++f) {
+    T param[10];
+    std::copy(init, init + 10, param);
+    param[3] = T(0.002) * f; param[4] = T(0.1) + T(0.001) * f;
+    param[5] = T(0.0); param[6] = T(1.0);
+    param[7] = T(0.2) * f; param[8] = T(-3.0); param[9] = T(400.0);
+    gt.FromVector(param);
+    gt(pts, &proj[f]);
+  }
+  typename Cam::FitOptions options;
+  options.warm_start = state.range(1) != 0;
+  Cam cam(T(700.0), T(640.0), T(480.0));
+  for (auto _ : state) {
+    cam.FromVector(init);
+    for (int f = 0; f < n_frame; ++f) {
+      cv::Mat p2s(int(2 * n), 1, cv::DataType<T>::type,
+                  (void*)proj[f].data());
+      // First frame has no previous pose
+      options.warm_start = state.range(1) != 0 && f > 0;
+      benchmark::DoNotOptimize(cam.From3Dto2D(p3s, p2s, options, nullptr));
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n_frame);
+}
+BENCHMARK_TEMPLATE(BM_CameraTrack, float, FK::PerspectiveProjection)
+    ->ArgsProduct({{68}, {0, 1}});
+
+/**
+ *  Project `range(0)` points into a preallocated buffer with the complete
+ *  camera transformation.
+ */
+template<typename T, template<typename U> class ProjType>
+static void BM_CameraProject(benchmark::State& state) {
+  using Cam = FK::Camera<T, ProjType>;
+  const int n = static_cast<int>(state.range(0));
+  std::mt19937 gen(kSeed);
+  std::uniform_real_distribution<T> dist(T(-80.0), T(80.0));
+  cv::Mat pts(3 * n, 1, cv::DataType<T>::type);
+  auto* p = reinterpret_cast<T*>(pts.data);
+  for (int i = 0; i < n; ++i) {
+    p[3 * i] = dist(gen);
+    p[3 * i + 1] = dist(gen);
+    p[3 * i + 2] = dist(gen) * T(0.5);
+  }
+  Cam cam(T(700.0), T(640.0), T(480.0));
+  T param[10];
+  cam.ToVector(param);
+  param[3] = T(0.1); param[4] = T(0.2); param[5] = T(0.05); param[6] = T(1.0);
+  param[7] = T(5.0); param[8] = T(-3.0); param[9] = T(400.0);
+  cam.FromVector(param);
+  cv::Mat proj(2 * n, 1, cv::DataType<T>::type);
+  for (auto _ : state) {
+    cam(pts, &proj);
+    benchmark::DoNotOptimize(proj.data);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n);
+}
+BENCHMARK_TEMPLATE(BM_CameraProject, float, FK::OrthographicProjection)
+    ->Arg(68)->Arg(50000);
+BENCHMARK_TEMPLATE(BM_CameraProject, float, FK::WeakProjection)
+    ->Arg(68)->Arg(50000);
+BENCHMARK_TEMPLATE(BM_CameraProject, float, FK::PerspectiveProjection)
+    ->Arg(68)->Arg(50000);
+BENCHMARK_TEMPLATE(BM_CameraProject, double, FK::PerspectiveProjection)
+    ->Arg(68)->Arg(50000);
+
+/**
+ *  Rasterize a `range(0)` x `range(0)` grid folded on a sphere cap (i.e.
+ *  face sized and self occluding) into a 640 x 480 image.
+ */
+template<typename T, template<typename U> class ProjType>
+static void BM_RasterizerRender(benchmark::State& state) {
+  using Cam = FK::Camera<T, ProjType>;
+  using Raster = FK::Rasterizer<T, ProjType>;
+  const int g = static_cast<int>(state.range(0));
+  FK::Mesh<T> mesh;
+  auto& vertex = mesh.get_vertex();
+  auto& tri = mesh.get_triangle();
+  for (int r = 0; r < g; ++r) {
+    for (int c = 0; c < g; ++c) {
+      const T u = T(2.0) * T(c) / T(g - 1) - T(1.0);
+      const T v = T(2.0) * T(r) / T(g - 1) - T(1.0);
+      typename FK::Mesh<T>::Vertex p;
+      p.x_ = T(80.0) * u;
+      p.y_ = T(80.0) * v;
+      p.z_ = T(-40.0) * (u * u + v * v);
+      vertex.push_back(p);
+      if (r > 0 && c > 0) {
+        const int i = r * g + c;
+        tri.emplace_back(i - g - 1, i - g, i);
+        tri.emplace_back(i - g - 1, i, i - 1);
+      }
+    }
+  }
+  Cam cam(T(700.0), T(640.0), T(480.0));
+  T param[10];
+  cam.ToVector(param);
+  param[3] = T(0.1); param[4] = T(0.4); param[5] = T(0.05); param[6] = T(1.0);
+  param[7] = T(0.0); param[8] = T(0.0); param[9] = T(400.0);
+  cam.FromVector(param);
+  Raster raster(640, 480);
+  typename Raster::Buffers buffers;
+  for (auto _ : state) {
+    raster.Render(mesh, cam, &buffers);
+    benchmark::DoNotOptimize(buffers.depth.data);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * tri.size());
+}
+BENCHMARK_TEMPLATE(BM_RasterizerRender, float, FK::PerspectiveProjection)
+    ->Arg(64)->Arg(256);
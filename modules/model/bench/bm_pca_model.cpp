@@ -0,0 +1,312 @@
+/**
+ *  @file   bm_pca_model.cpp
+ *  @brief Microbenchmark for PCAModel instance generation, alone, combined
+ *         with other models or on the GPU
+ *  @ingroup model
+ *
+ *  @author Christophe Ecabert
+ *  @date   07.09.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/nd_array.hpp"
+#include "facekit/model/combined_pca_model.hpp"
+#include "facekit/model/device_pca_model.hpp"
+#include "facekit/model/pca_model.hpp"
+#include "facekit/model/texture_pca_model.hpp"
+
+namespace FK = FaceKit;
+
+/** Seed used to generate fixture data, keep runs comparable */
+static constexpr uint64_t kSeed = 0x5EED;
+
+/**
+ *  @class  SyntheticPCAModel
+ *  @brief  PCA model with `n_vertex` 3D vertices and `n_comp` components
+ *          filled with reproducible values.
+ */
+template<typename T>
+class SyntheticPCAModel : public FK::PCAModel<T> {
+ public:
+  SyntheticPCAModel(const int n_vertex, const int n_comp) {
+    const int type = cv::DataType<T>::type;
+    cv::RNG rng(kSeed);
+    this->mean_.create(3 * n_vertex, 1, type);
+    this->variation_.create(3 * n_vertex, n_comp, type);
+    this->prior_.create(n_comp, 1, type);
+    rng.fill(this->mean_, cv::RNG::NORMAL, T(0.0), T(50.0));
+    rng.fill(this->variation_, cv::RNG::NORMAL, T(0.0), T(1.0));
+    rng.fill(this->prior_, cv::RNG::UNIFORM, T(0.1), T(10.0));
+    this->n_channels_ = 3;
+    this->n_principle_component_ = n_comp;
+  }
+
+  void Generate(const cv::Mat& p, FK::Mesh<T>* instance) override {}
+  void Generate(FK::Mesh<T>* instance) override {}
+  using FK::PCAModel<T>::Generate;
+};
+
+/**
+ *  Generate an instance from a fixed coefficient vector. `range(0)` vertices,
+ *  `range(1)` components, `range(2)` selects the variation storage: 0 full
+ *  precision, otherwise `QuantizedMatrix::Format` + 1.
+ */
+template<typename T>
+static void BM_PCAModelGenerate(benchmark::State& state) {
+  using Format = FK::QuantizedMatrix::Format;
+  const int n_vertex = static_cast<int>(state.range(0));
+  const int n_comp = static_cast<int>(state.range(1));
+  SyntheticPCAModel<T> model(n_vertex, n_comp);
+  if (state.range(2) != 0) {
+    auto s = model.QuantizeVariation(static_cast<Format>(state.range(2) - 1));
+    if (!s.Good()) {
+      state.SkipWithError(s.ToString().c_str());
+      return;
+    }
+  }
+  cv::Mat p(n_comp, 1, cv::DataType<T>::type);
+  cv::RNG rng(kSeed + 1);
+  rng.fill(p, cv::RNG::NORMAL, T(0.0), T(1.0));
+  std::vector<T> instance(3 * n_vertex);
+  for (auto _ : state) {
+    model.Generate(p, instance.data());
+    benchmark::DoNotOptimize(instance.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n_vertex);
+}
+BENCHMARK_TEMPLATE(BM_PCAModelGenerate, float)
+    ->ArgsProduct({{5000, 50000}, {80, 200}, {0, 1, 2, 3}});
+BENCHMARK_TEMPLATE(BM_PCAModelGenerate, double)
+    ->ArgsProduct({{5000, 50000}, {80, 200}, {0}});
+
+/**
+ *  Generate random instances with a caller-owned workspace and generator.
+ *  `range(0)` vertices, `range(1)` components.
+ */
+template<typename T>
+static void BM_PCAModelGenerateRandom(benchmark::State& state) {
+  const int n_vertex = static_cast<int>(state.range(0));
+  const int n_comp = static_cast<int>(state.range(1));
+  SyntheticPCAModel<T> model(n_vertex, n_comp);
+  typename FK::PCAModel<T>::Workspace ws;
+  cv::RNG rng(kSeed + 2);
+  std::vector<T> instance(3 * n_vertex);
+  for (auto _ : state) {
+    model.Generate(&rng, &ws, instance.data());
+    benchmark::DoNotOptimize(instance.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n_vertex);
+}
+BENCHMARK_TEMPLATE(BM_PCAModelGenerateRandom, float)
+    ->ArgsProduct({{5000, 50000}, {80, 200}});
+
+/**
+ *  Generate an instance from the leading components only. `range(0)`
+ *  vertices, `range(1)` components used out of 200, `range(2)` 1 to use the
+ *  transposed variation.
+ */
+template<typename T>
+static void BM_PCAModelGenerateTruncated(benchmark::State& state) {
+  const int n_vertex = static_cast<int>(state.range(0));
+  const int k = static_cast<int>(state.range(1));
+  SyntheticPCAModel<T> model(n_vertex, 200);
+  if (state.range(2) != 0) {
+    model.TransposeVariation();
+  }
+  typename FK::PCAModel<T>::Workspace ws;
+  cv::Mat p(200, 1, cv::DataType<T>::type);
+  cv::RNG rng(kSeed + 3);
+  rng.fill(p, cv::RNG::NORMAL, T(0.0), T(1.0));
+  std::vector<T> instance(3 * n_vertex);
+  for (auto _ : state) {
+    model.Generate(p, k, &ws, instance.data());
+    benchmark::DoNotOptimize(instance.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n_vertex);
+}
+BENCHMARK_TEMPLATE(BM_PCAModelGenerateTruncated, float)
+    ->ArgsProduct({{50000}, {10, 50, 200}, {0, 1}});
+
+/**
+ *  Generate a subset of evenly spread vertices (i.e. landmarks). `range(0)`
+ *  vertices, `range(1)` size of the subset.
+ */
+template<typename T>
+static void BM_PCAModelGenerateSubset(benchmark::State& state) {
+  const int n_vertex = static_cast<int>(state.range(0));
+  const int n_subset = static_cast<int>(state.range(1));
+  SyntheticPCAModel<T> model(n_vertex, 80);
+  std::vector<int> ids(n_subset);
+  for (int i = 0; i < n_subset; ++i) {
+    ids[i] = static_cast<int>((int64_t(i) * n_vertex) / n_subset);
+  }
+  cv::Mat p(80, 1, cv::DataType<T>::type);
+  cv::RNG rng(kSeed + 4);
+  rng.fill(p, cv::RNG::NORMAL, T(0.0), T(1.0));
+  std::vector<T> instance(3 * n_subset);
+  for (auto _ : state) {
+    model.GenerateSubset(p, ids, instance.data());
+    benchmark::DoNotOptimize(instance.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n_subset);
+}
+BENCHMARK_TEMPLATE(BM_PCAModelGenerateSubset, float)
+    ->ArgsProduct({{50000}, {68, 200}});
+
+/**
+ *  Generate the sum of an identity and an expression model. `range(0)`
+ *  vertices, `range(1)` expression components (identity has 80),
+ *  `range(2)` 1 to use a `CombinedPCAModel`, 0 to generate each model then
+ *  add them.
+ */
+template<typename T>
+static void BM_CombinedPCAModelGenerate(benchmark::State& state) {
+  const int n_vertex = static_cast<int>(state.range(0));
+  const int n_exp = static_cast<int>(state.range(1));
+  const bool combined = state.range(2) != 0;
+  SyntheticPCAModel<T> identity(n_vertex, 80);
+  SyntheticPCAModel<T> expression(n_vertex, n_exp);
+  FK::CombinedPCAModel<T> model;
+  auto s = model.Build({&identity, &expression});
+  if (!s.Good()) {
+    state.SkipWithError(s.ToString().c_str());
+    return;
+  }
+  typename FK::PCAModel<T>::Workspace ws;
+  cv::Mat p(80 + n_exp, 1, cv::DataType<T>::type);
+  cv::RNG rng(kSeed + 5);
+  rng.fill(p, cv::RNG::NORMAL, T(0.0), T(1.0));
+  const cv::Mat p_id = p.rowRange(0, 80).clone();
+  const cv::Mat p_exp = p.rowRange(80, 80 + n_exp).clone();
+  std::vector<T> instance(3 * n_vertex);
+  std::vector<T> offset(3 * n_vertex);
+  for (auto _ : state) {
+    if (combined) {
+      model.Generate(p, instance.data());
+    } else {
+      identity.Generate(p_id, &ws, instance.data());
+      expression.Generate(p_exp, &ws, offset.data());
+      for (size_t i = 0; i < instance.size(); ++i) {
+        instance[i] += offset[i];
+      }
+    }
+    benchmark::DoNotOptimize(instance.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n_vertex);
+}
+BENCHMARK_TEMPLATE(BM_CombinedPCAModelGenerate, float)
+    ->ArgsProduct({{50000}, {30, 80}, {0, 1}});
+
+/**
+ *  Generate `range(1)` instances of `range(0)` vertices at once, on the CPU
+ *  (`range(2)` = 0) or on the GPU (`range(2)` = 1, skipped without device)
+ */
+template<typename T>
+static void BM_PCAModelGenerateBatch(benchmark::State& state) {
+  const int n_vertex = static_cast<int>(state.range(0));
+  const int n_batch = static_cast<int>(state.range(1));
+  const bool device = state.range(2) != 0;
+  SyntheticPCAModel<T> model(n_vertex, 80);
+  FK::DevicePCAModel<T> d_model;
+  if (device) {
+    auto s = d_model.Upload(model);
+    if (!s.Good()) {
+      state.SkipWithError(s.ToString().c_str());
+      return;
+    }
+  }
+  cv::Mat p(80, n_batch, cv::DataType<T>::type);
+  cv::RNG rng(kSeed + 9);
+  rng.fill(p, cv::RNG::NORMAL, T(0.0), T(1.0));
+  cv::Mat instances;
+  for (auto _ : state) {
+    if (device) {
+      d_model.GenerateBatch(p, &instances);
+    } else {
+      model.GenerateBatch(p, &instances);
+    }
+    benchmark::DoNotOptimize(instances.data);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n_batch);
+}
+BENCHMARK_TEMPLATE(BM_PCAModelGenerateBatch, float)
+    ->ArgsProduct({{50000}, {64, 1024}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ *  Add a batch of new samples to a model. `range(0)` vertices, `range(1)`
+ *  components, `range(2)` samples per batch.
+ */
+template<typename T>
+static void BM_PCAModelUpdate(benchmark::State& state) {
+  const int n_vertex = static_cast<int>(state.range(0));
+  const int n_comp = static_cast<int>(state.range(1));
+  const int n_batch = static_cast<int>(state.range(2));
+  cv::Mat samples(3 * n_vertex, n_batch, cv::DataType<T>::type);
+  cv::RNG rng(kSeed + 7);
+  rng.fill(samples, cv::RNG::NORMAL, T(0.0), T(50.0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    SyntheticPCAModel<T> m(n_vertex, n_comp);
+    m.set_n_sample(200);
+    state.ResumeTiming();
+    m.Update(samples, n_comp);
+    benchmark::DoNotOptimize(m.get_prior().data);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * n_batch);
+}
+BENCHMARK_TEMPLATE(BM_PCAModelUpdate, float)
+    ->ArgsProduct({{50000}, {80}, {1, 16}});
+
+/**
+ *  @class  SyntheticTextureModel
+ *  @brief  RGB texture model of `size` x `size` pixels and `n_comp`
+ *          components around mid-grey.
+ */
+template<typename T>
+class SyntheticTextureModel : public FK::TexturePCAModel<T> {
+ public:
+  SyntheticTextureModel(const int size, const int n_comp) {
+    const int type = cv::DataType<T>::type;
+    const int dim = 3 * size * size;
+    cv::RNG rng(kSeed + 5);
+    this->mean_.create(dim, 1, type);
+    this->variation_.create(dim, n_comp, type);
+    this->prior_.create(n_comp, 1, type);
+    rng.fill(this->mean_, cv::RNG::UNIFORM, T(64.0), T(192.0));
+    rng.fill(this->variation_, cv::RNG::NORMAL, T(0.0), T(1.0));
+    rng.fill(this->prior_, cv::RNG::UNIFORM, T(0.1), T(10.0));
+    this->n_channels_ = 3;
+    this->n_principle_component_ = n_comp;
+    this->SetSize(size, size);
+  }
+};
+
+/**
+ *  Generate an 8-bit texture. `range(0)` texture width/height, `range(1)`
+ *  components, `range(2)` half resolution if non zero.
+ */
+template<typename T>
+static void BM_TexturePCAModelGenerate(benchmark::State& state) {
+  const int size = static_cast<int>(state.range(0));
+  const int n_comp = static_cast<int>(state.range(1));
+  const bool half = state.range(2) != 0;
+  SyntheticTextureModel<T> model(size, n_comp);
+  cv::Mat p(n_comp, 1, cv::DataType<T>::type);
+  cv::RNG rng(kSeed + 6);
+  rng.fill(p, cv::RNG::NORMAL, T(0.0), T(1.0));
+  typename FK::TexturePCAModel<T>::Workspace ws;
+  FK::NDArray image;
+  for (auto _ : state) {
+    model.Generate(p, half, &ws, &image);
+    benchmark::DoNotOptimize(image.AsFlat<uint8_t>().data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * size * size);
+}
+BENCHMARK_TEMPLATE(BM_TexturePCAModelGenerate, float)
+    ->ArgsProduct({{512, 1024}, {80}, {0, 1}});
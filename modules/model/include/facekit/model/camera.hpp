@@ -11,12 +11,15 @@
 #ifndef __FACEKIT_CAMERA__
 #define __FACEKIT_CAMERA__
 
+#include <atomic>
+#include <mutex>
 #include <vector>
 
 #include "facekit/core/library_export.hpp"
 #include "facekit/core/math/vector.hpp"
 #include "facekit/core/math/quaternion.hpp"
 #include "facekit/core/math/matrix.hpp"
+#include "facekit/model/pca_model.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -42,6 +45,114 @@ class FK_EXPORTS Camera {
   /** 2D Points */
   using Point2 = typename ProjType<T>::Point2;
 
+  /**
+   * @enum  Loss
+   * @brief Robust loss applied to the reprojection error of each point
+   */
+  enum Loss {
+    /** Least squares */
+    kSquaredLoss = 0,
+    /** Quadratic up to `loss_scale` pixels, linear beyond */
+    kHuberLoss,
+    /** Logarithmic, strongly discards outliers beyond `loss_scale` */
+    kCauchyLoss
+  };
+
+  /**
+   * @enum  Termination
+   * @brief Reason why the Levenberg-Marquardt solver stopped
+   */
+  enum Termination {
+    /** Gradient below `gradient_tol` */
+    kGradientTolerance = 0,
+    /** Relative cost decrease below `cost_tol` */
+    kCostTolerance,
+    /** `max_iter` steps taken */
+    kMaxIteration,
+    /** Damping diverged */
+    kNumericalError
+  };
+
+  /**
+   * @struct  FitOptions
+   * @brief   Levenberg-Marquardt configuration
+   */
+  struct FitOptions {
+    /** Robust loss */
+    Loss loss = kSquaredLoss;
+    /** Scale of the robust loss, in pixels */
+    T loss_scale = T(2.0);
+    /** Initial damping */
+    T lambda = T(1e-3);
+    /** Lower bound of the damped diagonal */
+    T min_diagonal = T(1e-6);
+    /** Maximum number of steps, accepted or not */
+    int max_iter = 100;
+    /** Stop when the largest gradient component is below */
+    T gradient_tol = T(1e-6);
+    /** Stop when an accepted step decreases the cost by less than this
+        fraction */
+    T cost_tol = T(1e-6);
+    /** Tracking: start from the current pose (i.e. previous frame) instead
+        of reinitializing the depth */
+    bool warm_start = false;
+    /** Tracking: maximum number of steps from the current pose */
+    int warm_max_iter = 10;
+    /** Tracking: reprojection error (RMS, pixels) above which the warm
+        start is considered diverged and a full initialization is run */
+    T warm_max_rms = T(10.0);
+  };
+
+  /**
+   * @struct  FitSummary
+   * @brief   Stopping statistics of the Levenberg-Marquardt solver
+   */
+  struct FitSummary {
+    /** Accepted steps */
+    int n_iter = 0;
+    /** Rejected steps */
+    int n_rejected = 0;
+    /** Cost before optimization */
+    T initial_cost = T(0.0);
+    /** Cost at the solution */
+    T final_cost = T(0.0);
+    /** Largest gradient component at the last evaluated point */
+    T gradient_norm = T(0.0);
+    /** Final damping */
+    T lambda = T(0.0);
+    /** Stopping reason */
+    Termination termination = kMaxIteration;
+    /** Started from the current pose */
+    bool warm_started = false;
+    /** Warm start diverged, fully reinitialized */
+    bool fallback = false;
+  };
+
+  /**
+   * @struct  ShapeBlock
+   * @brief   Contribution of one view to the normal equations of a shape
+   *          shared by several cameras, the camera parameters eliminated
+   *          with the Schur complement of their block
+   */
+  struct ShapeBlock {
+    /** Reduced shape system J_s'J_s - H_sc H_cc^-1 H_cs [k x k] */
+    cv::Mat s;
+    /** Reduced right hand side J_s'e - H_sc H_cc^-1 J_c'e [k x 1] */
+    cv::Mat r;
+    /** H_cc^-1 H_cs, for back-substitution [n_cam x k] */
+    cv::Mat w;
+    /** H_cc^-1 J_c'e, for back-substitution [n_cam x 1] */
+    cv::Mat w_g;
+    /** Workspace: cross block H_cs = J_c'J_s [n_cam x k] */
+    cv::Mat h_cs;
+    /** Workspace: shape Jacobian [2N x k] */
+    cv::Mat j_shape;
+    /** Workspace: residual [2N x 1] */
+    cv::Mat err;
+    /** Sum of the squared reprojection error */
+    T sq_error = T(0.0);
+  };
+
 #pragma mark -
 #pragma mark Initialization
 
@@ -146,6 +257,96 @@ class FK_EXPORTS Camera {
                  const cv::Mat& proj,
                  const T eps);
 
+  /**
+   * @name  From3Dto2D
+   * @fn    int From3Dto2D(const cv::Mat& pts, const cv::Mat& proj,
+                           const FitOptions& options, FitSummary* summary)
+   * @brief Initialize camera transformation (R, T) from a set of matching
+   *        pairs 3D-2D with Levenberg-Marquardt. The damping adapts to the
+   *        agreement between predicted and actual cost decrease, points are
+   *        reweighted by a robust loss and the solver stops once the
+   *        gradient or the relative decrease is small enough. With
+   *        `warm_start` (video tracking) it first refines the current pose
+   *        with a small step budget and only reinitializes if the error
+   *        stays above `warm_max_rms`.
+   * @param[in] pts     List of 3D points [3N x 1] or [1 x 3N]
+   * @param[in] proj    List of corresponding projected points [2N x 1] or
+   *                    [1 x 2N]
+   * @param[in] options Solver options
+   * @param[out] summary  Stopping statistics, can be nullptr
+   * @return    -2 if numerical error, -1 if not converged, 0 otherwise (or
+   *            if the warm start error is below `warm_max_rms`)
+   */
+  int From3Dto2D(const cv::Mat& pts,
+                 const cv::Mat& proj,
+                 const FitOptions& options,
+                 FitSummary* summary);
+
+  /**
+   * @name  FitShape
+   * @fn    int FitShape(const PCAModel<T>& model,
+                         const typename PCAModel<T>::Subset& landmarks,
+                         const cv::Mat& proj, const T eta, const T eps,
+                         cv::Mat* p)
+   * @brief Jointly estimate the camera and the shape coefficients \p p from
+   *        2D landmarks with Gauss-Newton. The shape Jacobian is computed
+   *        analytically through the landmark sub-basis and the normal
+   *        equations are assembled per block (camera, cross, shape),
+   *        therefore the cost is O(n_landmark * k^2) regardless of the
+   *        model's size.
+   * @param[in] model       Shape model, provides the prior
+   * @param[in] landmarks   Landmark sub-model, see `PCAModel::BuildSubset`
+   * @param[in] proj        Landmark positions [2N x 1]
+   * @param[in] eta         Weight of the coefficients' regularization
+   *                        `eta * |p|^2`
+   * @param[in] eps         Stopping criterion
+   * @param[in,out] p       Shape coefficients, initial guess [k x 1]. Only
+   *                        the first k components are optimized, all of
+   *                        them starting from the mean if empty.
+   * @return    -2 if numerical error, -1 if not converged, 0 otherwise
+   */
+  int FitShape(const PCAModel<T>& model,
+               const typename PCAModel<T>::Subset& landmarks,
+               const cv::Mat& proj,
+               const T eta,
+               const T eps,
+               cv::Mat* p);
+
+  /**
+   * @name  EliminateCamera
+   * @fn    int EliminateCamera(const cv::Mat& basis, const T* prior,
+                                const cv::Mat& pts, const cv::Mat& proj,
+                                const int& k, ShapeBlock* block) const
+   * @brief Gauss-Newton normal equations of this view for a shape shared
+   *        with other views (i.e. multi-view or video fitting). The camera
+   *        parameters are eliminated locally with the Schur complement of
+   *        their small block, only the reduced k x k system is left to be
+   *        summed over the views. See `SharedShapeFitter`.
+   * @param[in] basis   Landmark sub-basis [3N x K], K >= k
+   * @param[in] prior   Prior of each component
+   * @param[in] pts     Current landmarks [3N x 1]
+   * @param[in] proj    Landmark positions in this view [2N x 1]
+   * @param[in] k       Number of optimized coefficients
+   * @param[out] block  Reduced system of this view, memory is reused
+   * @return    -2 if the camera block is singular, 0 otherwise
+   */
+  int EliminateCamera(const cv::Mat& basis,
+                      const T* prior,
+                      const cv::Mat& pts,
+                      const cv::Mat& proj,
+                      const int& k,
+                      ShapeBlock* block) const;
+
+  /**
+   * @name  BackSubstitute
+   * @fn    void BackSubstitute(const ShapeBlock& block, const T* dp)
+   * @brief Recover and apply the camera increment of this view once the
+   *        shared shape increment \p dp is known
+   * @param[in] block   Reduced system computed by `EliminateCamera`
+   * @param[in] dp      Shape coefficients increment [k]
+   */
+  void BackSubstitute(const ShapeBlock& block, const T* dp);
+
 #pragma mark -
 #pragma mark Usage
 
@@ -174,12 +375,30 @@ class FK_EXPORTS Camera {
    * @name  operator()
    * @fn    void operator()(const cv::Mat& pts,
                             cv::Mat* proj) const
-   * @brief Project a list of \p pts with complete transformation
+   * @brief Project a list of \p pts with complete transformation. Points
+   *        are processed by blocks stored as structure of arrays, rotated,
+   *        translated and projected by SIMD kernels and written directly in
+   *        \p proj. Large lists are split over the default thread pool.
    * @param[in] pts     3D Points to project [3N x 1] or [1 x 3N]
-   * @param[out] proj   Projected 2D points [2N x 1]
+   * @param[out] proj   Projected 2D points [2N x 1], reused if already
+   *                    allocated with the right size and type
    */
   void operator()(const cv::Mat& pts, cv::Mat* proj) const;
 
+  /**
+   * @name  operator()
+   * @fn    void operator()(const cv::Mat& pts, cv::Mat* proj,
+                            cv::Mat* depth) const
+   * @brief Project a list of \p pts with complete transformation and keep
+   *        their depth in the camera's reference frame (i.e. z after
+   *        rotation and translation), needed for visibility.
+   * @param[in] pts     3D Points to project [3N x 1] or [1 x 3N]
+   * @param[out] proj   Projected 2D points [2N x 1], reused if already
+   *                    allocated with the right size and type
+   * @param[out] depth  Depth of each point [N x 1], skipped if nullptr
+   */
+  void operator()(const cv::Mat& pts, cv::Mat* proj, cv::Mat* depth) const;
+
 #pragma mark -
 #pragma mark Accessors
 
@@ -226,13 +445,27 @@ class FK_EXPORTS Camera {
   /**
    * @name  get_rotation
    * @fn    Quaternion<T>& get_rotation(void)
-   * @brief Provide view transformation (Rotation only)
+   * @brief Provide view transformation (Rotation only). The rotation matrix
+   *        is marked as outdated and rebuilt on its next use, therefore the
+   *        reference must not be modified once the camera is used again.
    * @return  Rotation as quaternion
    */
   Quaternion<T>& get_rotation(void) {
+    this->InvalidateRotation();
     return rot_;
   }
 
+  /**
+   * @name  set_rotation
+   * @fn    void set_rotation(const Quaternion<T>& rot)
+   * @brief Set view transformation (Rotation only)
+   * @param[in] rot Normalized rotation
+   */
+  void set_rotation(const Quaternion<T>& rot) {
+    rot_ = rot;
+    this->InvalidateRotation();
+  }
+
   /**
    * @name  get_rotation_matrix
    * @fn    const Matrix3<T>& get_rotation_matrix(void) const
@@ -240,7 +473,7 @@ class FK_EXPORTS Camera {
    * @return  Rotation matrix
    */
   const Matrix3<T>& get_rotation_matrix(void) const {
-    return rotm_;
+    return this->RotationMatrix();
   }
 
   /**
@@ -299,16 +532,110 @@ class FK_EXPORTS Camera {
 #pragma mark Private
  private:
 
+  /**
+   * @name  PlaceInFront
+   * @fn    void PlaceInFront(const cv::Mat& pts)
+   * @brief Move the camera away along z so that the object lies in front
+   */
+  void PlaceInFront(const cv::Mat& pts);
+
+  /**
+   * @name  Optimize
+   * @fn    int Optimize(const cv::Mat& pts, const cv::Mat& proj,
+                         const FitOptions& options, const int& max_iter,
+                         FitSummary* stat)
+   * @brief Levenberg-Marquardt iterations from the current pose
+   * @return    -2 if numerical error, -1 if not converged, 0 otherwise
+   */
+  int Optimize(const cv::Mat& pts,
+               const cv::Mat& proj,
+               const FitOptions& options,
+               const int& max_iter,
+               FitSummary* stat);
+
+  /**
+   * @name  NormalEquations
+   * @fn    T NormalEquations(const cv::Mat& pts, const cv::Mat& proj,
+                              const FitOptions& options, T* h, T* g) const
+   * @brief Accumulate the robustly weighted J'WJ and J'We in one pass over
+   *        the points, only the cost if \p h is nullptr
+   * @return    Cost
+   */
+  T NormalEquations(const cv::Mat& pts,
+                    const cv::Mat& proj,
+                    const FitOptions& options,
+                    T* h,
+                    T* g) const;
+
+  /**
+   * @name  ApplyUpdate
+   * @fn    void ApplyUpdate(const T* delta, const int& n)
+   * @brief Apply an increment of the \p n optimized parameters
+   */
+  void ApplyUpdate(const T* delta, const int& n);
+
+  /**
+   * @name  ShapeJacobian
+   * @fn    T ShapeJacobian(const cv::Mat& basis, const T* prior,
+                            const cv::Mat& pts, const cv::Mat& proj,
+                            const int& k, T* h_cc, T* g_c, T* h_cs,
+                            cv::Mat* j_shape, cv::Mat* err) const
+   * @brief Residual, camera normal equations, cross block and shape
+   *        Jacobian of the joint camera / shape problem in one pass
+   * @return    Sum of the squared error
+   */
+  T ShapeJacobian(const cv::Mat& basis,
+                  const T* prior,
+                  const cv::Mat& pts,
+                  const cv::Mat& proj,
+                  const int& k,
+                  T* h_cc,
+                  T* g_c,
+                  T* h_cs,
+                  cv::Mat* j_shape,
+                  cv::Mat* err) const;
+
+  /**
+   * @name  InvalidateRotation
+   * @fn    void InvalidateRotation(void)
+   * @brief Mark the cached rotation matrix as outdated
+   */
+  void InvalidateRotation(void) {
+    rot_dirty_.store(true, std::memory_order_release);
+  }
+
+  /**
+   * @name  RotationMatrix
+   * @fn    const Matrix3<T>& RotationMatrix(void) const
+   * @brief Rotation matrix, rebuilt from the quaternion only when it changed
+   *        since the last call. Can be called concurrently.
+   * @return  Rotation matrix
+   */
+  const Matrix3<T>& RotationMatrix(void) const {
+    if (rot_dirty_.load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> lock(rot_lock_);
+      if (rot_dirty_.load(std::memory_order_relaxed)) {
+        rot_.ToRotationMatrix(&rotm_);
+        rot_dirty_.store(false, std::memory_order_release);
+      }
+    }
+    return rotm_;
+  }
+
   /** Translation */
   Vector3<T> t_;
   /** Rotation */
   Quaternion<T> rot_;
-  /** Rotation Matrix */
-  Matrix3<T> rotm_;
+  /** Rotation Matrix, cache of `rot_` */
+  mutable Matrix3<T> rotm_;
   /** Projection */
   ProjType<T> p_;
   /** Axis inversion */
   T ax_[3];
+  /** Indicate `rotm_` needs to be rebuilt */
+  mutable std::atomic<bool> rot_dirty_;
+  /** Serialize rebuilds of `rotm_` */
+  mutable std::mutex rot_lock_;
 };
 
 
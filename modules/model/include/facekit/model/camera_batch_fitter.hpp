@@ -0,0 +1,135 @@
+/**
+ *  @file   facekit/model/camera_batch_fitter.hpp
+ *  @brief  Fit many cameras at once (i.e. every face of a frame)
+ *  @ingroup    model
+ *
+ *  @author Christophe Ecabert
+ *  @date   02.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_CAMERA_BATCH_FITTER__
+#define __FACEKIT_CAMERA_BATCH_FITTER__
+
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/model/camera.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ * @class   CameraBatchFitter
+ * @brief   Fit one camera per set of 3D-2D correspondences, problems are
+ *          spread over the global `ThreadPool`. Each fit runs the
+ *          Levenberg-Marquardt solver of `Camera` which keeps its normal
+ *          equations and fixed-size solve on the stack, therefore fits do
+ *          not allocate nor share state.
+ * @author  Christophe Ecabert
+ * @date    02.11.18
+ * @ingroup model
+ * @tparam T    Data type
+ * @tparam ProjType Type of camera projection
+ */
+template<typename T, template<typename U> class ProjType>
+class FK_EXPORTS CameraBatchFitter {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /** Camera */
+  using Cam = Camera<T, ProjType>;
+  /** Solver options */
+  using FitOptions = typename Cam::FitOptions;
+  /** Stopping statistics */
+  using FitSummary = typename Cam::FitSummary;
+
+  /**
+   * @struct    Problem
+   * @brief     One set of correspondences and the camera to fit, the camera
+   *            is used as initial guess
+   */
+  struct Problem {
+    /** 3D points [3N x 1] or [1 x 3N] */
+    cv::Mat pts;
+    /** Projected points [2N x 1] or [1 x 2N] */
+    cv::Mat proj;
+    /** Camera to fit */
+    Cam* camera;
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   * @name  CameraBatchFitter
+   * @fn    CameraBatchFitter(void)
+   * @brief Constructor, default solver options
+   */
+  CameraBatchFitter(void) = default;
+
+  /**
+   * @name  CameraBatchFitter
+   * @fn    explicit CameraBatchFitter(const FitOptions& options)
+   * @brief Constructor
+   * @param[in] options Solver options shared by every problem
+   */
+  explicit CameraBatchFitter(const FitOptions& options) : options_(options) {}
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   * @name  Fit
+   * @fn    Status Fit(const std::vector<Problem>& problems,
+                       std::vector<int>* status,
+                       std::vector<FitSummary>* summary) const
+   * @brief Fit every camera concurrently. Problems are checked before any
+   *        fit starts.
+   * @param[in] problems    Problems, cameras must be distinct
+   * @param[out] status     Per problem result of `Camera::From3Dto2D`
+   * @param[out] summary    Per problem statistics, can be nullptr
+   * @return    kInvalidArgument if a problem is malformed
+   */
+  Status Fit(const std::vector<Problem>& problems,
+             std::vector<int>* status,
+             std::vector<FitSummary>* summary) const;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   * @name  options
+   * @fn    const FitOptions& options(void) const
+   * @brief Solver options
+   */
+  const FitOptions& options(void) const {
+    return options_;
+  }
+
+  /**
+   * @name  set_options
+   * @fn    void set_options(const FitOptions& options)
+   * @brief Set solver options
+   */
+  void set_options(const FitOptions& options) {
+    options_ = options;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Solver options */
+  FitOptions options_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_CAMERA_BATCH_FITTER__ */
@@ -0,0 +1,166 @@
+/**
+ *  @file   facekit/model/combined_pca_model.hpp
+ *  @brief  Evaluate several PCA models (i.e. identity and expression) in a
+ *          single pass
+ *  @ingroup model
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_COMBINED_PCA_MODEL__
+#define __FACEKIT_COMBINED_PCA_MODEL__
+
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/model/pca_model.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ * @class   CombinedPCAModel
+ * @brief   Sum of several PCA models sharing the same output (i.e. identity
+ *          plus expression blend shapes), evaluated with one matrix-vector
+ *          product instead of one `Generate` per model. The means are summed
+ *          and the bases concatenated with their prior folded into the
+ *          columns, so an instance is a single copy of the mean followed by
+ *          one pass over the concatenated basis. Costs one copy of every
+ *          basis in memory, the models themselves are not referenced after
+ *          `Build`. Coefficients are the models' coefficients concatenated
+ *          in the order of the models.
+ * @author  Christophe Ecabert
+ * @date    15.11.18
+ * @ingroup model
+ * @tparam T    Data type
+ */
+template<typename T>
+class FK_EXPORTS CombinedPCAModel {
+ public:
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   * @name  CombinedPCAModel
+   * @fn    CombinedPCAModel(void)
+   * @brief Constructor, empty combination
+   */
+  CombinedPCAModel(void) = default;
+
+  /**
+   * @name  Build
+   * @fn    Status Build(const std::vector<const PCAModel<T>*>& models)
+   * @brief Combine \p models, they must all be loaded and generate
+   *        instances of the same dimension
+   * @param[in] models  Models to combine, in coefficient order
+   * @return    kInvalidArgument if a model is missing, empty or of another
+   *            dimension
+   */
+  Status Build(const std::vector<const PCAModel<T>*>& models);
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   * @name  Generate
+   * @fn    Status Generate(const cv::Mat& p, T* instance) const
+   * @brief Generate the sum of the models' instances, reentrant
+   * @param[in] p           Concatenated coefficients [k x 1] or [1 x k]
+   * @param[out] instance   Generated instance [dim]
+   * @return    kInvalidArgument if \p p does not match the combination
+   */
+  Status Generate(const cv::Mat& p, T* instance) const;
+
+  /**
+   * @name  GenerateBatch
+   * @fn    Status GenerateBatch(const cv::Mat& p, cv::Mat* instances) const
+   * @brief Generate several instances at once with a single matrix-matrix
+   *        product
+   * @param[in] p           Concatenated coefficients, one instance per
+   *                        column [k x N]
+   * @param[out] instances  Generated instances, one per column [dim x N]
+   * @return    kInvalidArgument if \p p does not match the combination
+   */
+  Status GenerateBatch(const cv::Mat& p, cv::Mat* instances) const;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   * @name  n_model
+   * @fn    size_t n_model(void) const
+   * @brief Number of combined models
+   */
+  size_t n_model(void) const {
+    return offset_.empty() ? 0 : offset_.size() - 1;
+  }
+
+  /**
+   * @name  n_component
+   * @fn    int n_component(void) const
+   * @brief Total number of coefficients
+   */
+  int n_component(void) const {
+    return basis_.cols;
+  }
+
+  /**
+   * @name  offset
+   * @fn    int offset(const size_t& model) const
+   * @brief Position of the first coefficient of a model in the concatenated
+   *        coefficients, `offset(n_model())` is the total
+   * @param[in] model   Model index
+   */
+  int offset(const size_t& model) const {
+    return offset_[model];
+  }
+
+  /**
+   * @name  dim
+   * @fn    int dim(void) const
+   * @brief Dimension of an instance
+   */
+  int dim(void) const {
+    return mean_.rows;
+  }
+
+  /**
+   * @name  mean
+   * @fn    const cv::Mat& mean(void) const
+   * @brief Summed means [dim x 1]
+   */
+  const cv::Mat& mean(void) const {
+    return mean_;
+  }
+
+  /**
+   * @name  basis
+   * @fn    const cv::Mat& basis(void) const
+   * @brief Concatenated prescaled bases [dim x k]
+   */
+  const cv::Mat& basis(void) const {
+    return basis_;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Summed means [dim x 1] */
+  cv::Mat mean_;
+  /** Concatenated bases, prior folded in [dim x k] */
+  cv::Mat basis_;
+  /** First coefficient of each model, plus the total */
+  std::vector<int> offset_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_COMBINED_PCA_MODEL__ */
@@ -0,0 +1,171 @@
+/**
+ *  @file   facekit/model/device_pca_model.hpp
+ *  @brief  PCA model resident in GPU memory for large batch synthesis
+ *  @ingroup model
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_DEVICE_PCA_MODEL__
+#define __FACEKIT_DEVICE_PCA_MODEL__
+
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/math/device_linear_algebra.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/model/combined_pca_model.hpp"
+#include "facekit/model/pca_model.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ * @class   DevicePCAModel
+ * @brief   Copy of a PCA model (or a `CombinedPCAModel`) kept in device
+ *          memory, generating batches of instances on the GPU. The
+ *          prescaled basis is stored with the mean as an extra column, the
+ *          coefficients receive a matching row of ones, hence a batch is a
+ *          single GEMM. Large batches are split in column blocks processed
+ *          on two streams: while one block is multiplied, the other one's
+ *          coefficients and instances travel through pinned host buffers.
+ *          Requires FaceKit to be built with CUDA (see
+ *          `DeviceStream::IsAvailable`), operations return `kUnimplemented`
+ *          otherwise.
+ * @author  Christophe Ecabert
+ * @date    15.11.18
+ * @ingroup model
+ * @tparam T    Data type
+ */
+template<typename T>
+class FK_EXPORTS DevicePCAModel {
+ public:
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   * @name  DevicePCAModel
+   * @fn    DevicePCAModel(void)
+   * @brief Constructor, empty model
+   */
+  DevicePCAModel(void) : dim_(0), n_component_(0) {}
+
+  /**
+   * @name  Upload
+   * @fn    Status Upload(const PCAModel<T>& model)
+   * @brief Copy \p model to the device, with its prior folded into the basis
+   * @param[in] model   Loaded model
+   * @return    kInvalidArgument if the model is empty or not continuous,
+   *            kUnimplemented without CUDA
+   */
+  Status Upload(const PCAModel<T>& model);
+
+  /**
+   * @name  Upload
+   * @fn    Status Upload(const CombinedPCAModel<T>& model)
+   * @brief Copy a combination of models to the device
+   * @param[in] model   Built combination
+   * @return    kInvalidArgument if the combination is empty, kUnimplemented
+   *            without CUDA
+   */
+  Status Upload(const CombinedPCAModel<T>& model);
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   * @name  GenerateBatch
+   * @fn    Status GenerateBatch(const cv::Mat& p, cv::Mat* instances)
+   * @brief Generate several instances at once, same output as
+   *        `PCAModel::GenerateBatch`. Not reentrant, streams and staging
+   *        buffers are owned by the model.
+   * @param[in] p           Coefficients, one instance per column [k x N]
+   * @param[out] instances  Generated instances, one per column [dim x N]
+   * @return    kInvalidArgument if \p p does not match the model
+   */
+  Status GenerateBatch(const cv::Mat& p, cv::Mat* instances);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   * @name  dim
+   * @fn    int dim(void) const
+   * @brief Dimension of an instance
+   */
+  int dim(void) const {
+    return dim_;
+  }
+
+  /**
+   * @name  n_component
+   * @fn    int n_component(void) const
+   * @brief Number of coefficients
+   */
+  int n_component(void) const {
+    return n_component_;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+
+  /**
+   * @struct    Slot
+   * @brief     Resources of one in-flight block
+   */
+  struct Slot {
+    /** Stream the block is processed on */
+    DeviceStream stream;
+    /** Pinned coefficients [k + 1 x n] */
+    PinnedBuffer h_coef;
+    /** Pinned instances [dim x n] */
+    PinnedBuffer h_inst;
+    /** Device coefficients */
+    DeviceMatrix<T> d_coef;
+    /** Device instances */
+    DeviceMatrix<T> d_inst;
+    /** First column of the block */
+    int first = 0;
+    /** Number of columns, 0 if the slot is idle */
+    int count = 0;
+  };
+
+  /**
+   * @name  UploadBasis
+   * @fn    Status UploadBasis(const cv::Mat& basis, const cv::Mat& prior,
+                               const cv::Mat& mean)
+   * @brief Append the mean to the basis scaled by \p prior and copy it
+   * @param[in] basis   Basis [dim x k]
+   * @param[in] prior   Scale of each column [k], empty for none
+   * @param[in] mean    Mean [dim]
+   */
+  Status UploadBasis(const cv::Mat& basis,
+                     const cv::Mat& prior,
+                     const cv::Mat& mean);
+
+  /**
+   * @name  Drain
+   * @fn    Status Drain(Slot* slot, cv::Mat* instances)
+   * @brief Wait for the block of \p slot and copy it into \p instances
+   */
+  Status Drain(Slot* slot, cv::Mat* instances);
+
+  /** Basis and mean [dim x k + 1] */
+  DeviceMatrix<T> basis_;
+  /** Dimension of an instance */
+  int dim_;
+  /** Number of coefficients */
+  int n_component_;
+  /** Double buffering */
+  Slot slot_[2];
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_DEVICE_PCA_MODEL__ */
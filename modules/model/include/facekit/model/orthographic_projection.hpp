@@ -11,6 +11,7 @@
 #ifndef __FACEKIT_ORTHOGRAPHIC_PROJECTION_MODEL__
 #define __FACEKIT_ORTHOGRAPHIC_PROJECTION_MODEL__
 
+#include <cstddef>
 #include <vector>
 
 #include "opencv2/core.hpp"
@@ -137,6 +138,25 @@ class FK_EXPORTS OrthographicProjection {
   void operator()(const std::vector<Point3>& pts,
                   std::vector<Point2>* proj) const;
 
+  /**
+   * @name  operator()
+   * @fn    void operator()(const T* x, const T* y, const T* z,
+                            const size_t& n, T* proj) const
+   * @brief Project a batch of points stored as separated x, y and z streams
+   *        (structure of arrays). Branch free loop the compiler vectorizes.
+   * @param[in] x       X components, `n` elements
+   * @param[in] y       Y components, `n` elements
+   * @param[in] z       Z components, `n` elements
+   * @param[in] n       Number of points
+   * @param[out] proj   Interleaved 2D points, 2 * `n` elements, must be
+   *                    allocated by the caller
+   */
+  void operator()(const T* x,
+                  const T* y,
+                  const T* z,
+                  const size_t& n,
+                  T* proj) const;
+
 #pragma mark -
 #pragma mark Accessors
 
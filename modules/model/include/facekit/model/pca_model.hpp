@@ -12,10 +12,13 @@
 #define __FACEKIT_PCA_MODEL__
 
 #include <iostream>
+#include <vector>
 
 #include "opencv2/core/core.hpp"
 
 #include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/core/math/quantized_matrix.hpp"
 #include "facekit/io/serializable.hpp"
 #include "facekit/geometry/mesh.hpp"
 
@@ -37,6 +40,38 @@ template<typename T>
 class FK_EXPORTS PCAModel : public Serializable {
  public:
 
+#pragma mark -
+#pragma mark Type definition
+
+  /**
+   * @struct    Workspace
+   * @brief     Scratch buffers used by \p Generate. Owned by the caller, one
+   *            per thread, so a single model can be shared by concurrent
+   *            threads. Buffers are allocated on first use and reused.
+   */
+  struct Workspace {
+    /** Coefficients scaled by the prior */
+    cv::Mat coef;
+    /** Random coefficients */
+    cv::Mat p;
+  };
+
+  /**
+   * @struct    Subset
+   * @brief     Mean and variation rows of a subset of vertices (i.e.
+   *            landmarks), gathered once by \p BuildSubset so that
+   *            generating them costs O(n_subset * k) instead of
+   *            O(n_vertex * k).
+   */
+  struct Subset {
+    /** Vertex indices, in output order */
+    std::vector<int> vertex;
+    /** Gathered mean [n_subset * n_channels x 1] */
+    cv::Mat mean;
+    /** Gathered variation [n_subset * n_channels x k] */
+    cv::Mat variation;
+  };
+
 #pragma mark -
 #pragma mark Initialization
 
@@ -56,6 +91,20 @@ class FK_EXPORTS PCAModel : public Serializable {
    */
   virtual int Load(std::istream& stream);
 
+  /**
+   * @name  Load
+   * @fn    int Load(std::istream& stream, const int& n_component)
+   * @brief Load only the first \p n_component principal components from a
+   *        given binary \p stream. With sectioned models the discarded
+   *        columns of the variation are skipped instead of being read
+   *        when rows are wide enough.
+   * @param[in] stream      Binary stream to load model from
+   * @param[in] n_component Number of components to keep, negative to keep
+   *                        all of them
+   * @return    -1 if error, 0 otherwise
+   */
+  int Load(std::istream& stream, const int& n_component);
+
   /**
    * @name  Save
    * @fn    virtual int Save(std::ostream& stream) const
@@ -65,30 +114,115 @@ class FK_EXPORTS PCAModel : public Serializable {
    */
   virtual int Save(std::ostream& stream) const;
 
+  /**
+   * @name  Map
+   * @fn    Status Map(const std::string& path, const size_t& offset)
+   * @brief Load from a file without copying the mean, variation and prior,
+   *        they are mapped read-only and shared through the page cache with
+   *        every process using the same file, i.e. one worker per core pays
+   *        for the model once. Models saved before aligned blocks, or stored
+   *        with another type than \p T, are copied, see \p IsShared.
+   * @param[in] path    Path to the file
+   * @param[in] offset  Position of the model in the file (i.e. where `Save`
+   *                    started writing)
+   * @return    Operation status
+   */
+  Status Map(const std::string& path, const size_t& offset);
+
   /**
    * @name  ComputeObjectSize
    * @fn    virtual size_t ComputeObjectSize(void) const
-   * @brief Compute object size in byte
+   * @brief Compute object size in byte, derived from the sections written
+   *        by `Save`. Upper bound since the alignment padding depends on the
+   *        stream position
    * @return    Object's size
    */
   virtual size_t ComputeObjectSize(void) const;
 
+  /**
+   * @name  IsShared
+   * @fn    bool IsShared(void) const
+   * @brief Indicate if the mean, variation and prior are all mapped from
+   *        the file by \p Map, rather than private copies
+   * @return    True if shared
+   */
+  bool IsShared(void) const {
+    return shared_;
+  }
+
 #pragma mark -
 #pragma mark Usage
 
   /**
    * @name  Generate
    * @fn    virtual void Generate(const cv::Mat& p, T* instance)
-   * @brief Generate an instance given a set of coefficients \p p.
+   * @brief Generate an instance given a set of coefficients \p p. Uses a
+   *        per-thread workspace.
    * @param[in] p   Nodel's coefficients
    * @param[out] instance   Generated instance
    */
   virtual void Generate(const cv::Mat& p, T* instance);
 
+  /**
+   * @name  Generate
+   * @fn    void Generate(const cv::Mat& p, Workspace* ws, T* instance) const
+   * @brief Generate an instance given a set of coefficients \p p,
+   *        reentrant.
+   * @param[in] p           Nodel's coefficients
+   * @param[in,out] ws      Caller's scratch buffers
+   * @param[out] instance   Generated instance
+   */
+  void Generate(const cv::Mat& p, Workspace* ws, T* instance) const;
+
+  /**
+   * @name  Generate
+   * @fn    void Generate(cv::RNG* rng, Workspace* ws, T* instance) const
+   * @brief Generate a random instance, coefficients are drawn from a
+   *        standard normal distribution with the caller's generator.
+   *        Reentrant, the generator is not reseeded.
+   * @param[in,out] rng     Random number generator
+   * @param[in,out] ws      Caller's scratch buffers
+   * @param[out] instance   Randomly generated instance
+   */
+  void Generate(cv::RNG* rng, Workspace* ws, T* instance) const;
+
+  /**
+   * @name  Generate
+   * @fn    void Generate(const cv::Mat& p, const int& k, T* instance)
+   * @brief Generate an instance using only the first \p k components, i.e.
+   *        coarse fitting iterations. Uses a per-thread workspace.
+   * @param[in] p   Nodel's coefficients, at least \p k of them
+   * @param[in] k   Number of leading components to use
+   * @param[out] instance   Generated instance
+   */
+  void Generate(const cv::Mat& p, const int& k, T* instance);
+
+  /**
+   * @name  Generate
+   * @fn    void Generate(const cv::Mat& p, const int& k, Workspace* ws,
+                          T* instance) const
+   * @brief Generate an instance using only the first \p k components,
+   *        reentrant. Cost is proportional to \p k once the variation is
+   *        transposed (see \p TransposeVariation), otherwise the leading
+   *        columns are gathered from the row-major variation. Always uses
+   *        the full precision variation.
+   * @param[in] p           Nodel's coefficients, at least \p k of them
+   * @param[in] k           Number of leading components to use
+   * @param[in,out] ws      Caller's scratch buffers
+   * @param[out] instance   Generated instance
+   */
+  void Generate(const cv::Mat& p,
+                const int& k,
+                Workspace* ws,
+                T* instance) const;
+
   /**
    * @name  Generate
    * @fn    void Generate(const cv::Mat& p, Mesh<T>* instance)
    * @brief Generate an instance given a set of coefficients \p p.
+   *        Implementations flag the vertices they write with
+   *        `Mesh::MarkDirty`, normals and bounding box can then be refreshed
+   *        with `Mesh::UpdateNormals` / `Mesh::UpdateBoundingBox`.
    * @param[in] p   Nodel's coefficients
    * @param[out] instance   Generated instance
    */
@@ -97,7 +231,8 @@ class FK_EXPORTS PCAModel : public Serializable {
   /**
    * @name  Generate
    * @fn    virtual void Generate(T* instance)
-   * @brief Generate a random instance
+   * @brief Generate a random instance. Uses a per-thread workspace and
+   *        generator, seeded once per thread.
    * @param[out] instance   Randomly generated instance
    */
   virtual void Generate(T* instance);
@@ -110,6 +245,194 @@ class FK_EXPORTS PCAModel : public Serializable {
    */
   virtual void Generate(Mesh<T>* instance) = 0;
 
+  /**
+   * @name  GenerateBatch
+   * @fn    Status GenerateBatch(const cv::Mat& p, cv::Mat* instances) const
+   * @brief Generate several instances at once. The prior is applied to the
+   *        coefficients (unless the variation is prescaled) then all
+   *        instances are synthesized with a single matrix-matrix product,
+   *        which reads the variation once instead of once per instance.
+   *        Always uses the full precision variation.
+   * @param[in] p           Coefficients, one instance per column [k x N]
+   * @param[out] instances  Generated instances, one per column [dim x N]
+   * @return    kInvalidArgument if \p p does not match the model
+   */
+  Status GenerateBatch(const cv::Mat& p, cv::Mat* instances) const;
+
+  /**
+   * @name  BuildSubset
+   * @fn    Status BuildSubset(const std::vector<int>& vertex_ids,
+                               Subset* subset) const
+   * @brief Gather the mean and variation rows of a set of vertices
+   * @param[in] vertex_ids  Vertex indices, duplicates allowed
+   * @param[out] subset     Gathered sub-model
+   * @return    kInvalidArgument if an index is out of range
+   */
+  Status BuildSubset(const std::vector<int>& vertex_ids, Subset* subset) const;
+
+  /**
+   * @name  GenerateSubset
+   * @fn    void GenerateSubset(const cv::Mat& p, const Subset& subset,
+                                Workspace* ws, T* instance) const
+   * @brief Generate only the vertices of \p subset, reentrant
+   * @param[in] p           Nodel's coefficients
+   * @param[in] subset      Sub-model built by \p BuildSubset
+   * @param[in,out] ws      Caller's scratch buffers
+   * @param[out] instance   Generated vertices, in the subset's order
+   *                        [n_subset * n_channels]
+   */
+  void GenerateSubset(const cv::Mat& p,
+                      const Subset& subset,
+                      Workspace* ws,
+                      T* instance) const;
+
+  /**
+   * @name  GenerateSubset
+   * @fn    Status GenerateSubset(const cv::Mat& p,
+                                  const std::vector<int>& vertex_ids,
+                                  T* instance)
+   * @brief Generate only the vertices in \p vertex_ids. The gathered
+   *        sub-model is cached and rebuilt only when the indices change,
+   *        therefore not reentrant (see the \p Subset overload).
+   * @param[in] p           Nodel's coefficients
+   * @param[in] vertex_ids  Vertex indices
+   * @param[out] instance   Generated vertices, in the order of
+   *                        \p vertex_ids [n_subset * n_channels]
+   * @return    kInvalidArgument if an index is out of range
+   */
+  Status GenerateSubset(const cv::Mat& p,
+                        const std::vector<int>& vertex_ids,
+                        T* instance);
+
+  /**
+   * @name  PrescaleVariation
+   * @fn    Status PrescaleVariation(void)
+   * @brief Store a copy of the variation with the prior folded into its
+   *        columns, \p Generate then reduces to a single matrix-vector
+   *        product accumulated on the mean. Costs one extra variation in
+   *        memory, the original is kept for serialization. Once enabled, the
+   *        copy is rebuilt by \p Load, \p Map and \p ReorderVertex.
+   * @return    Operation status
+   */
+  Status PrescaleVariation(void);
+
+  /**
+   * @name  ClearPrescaledVariation
+   * @fn    void ClearPrescaledVariation(void)
+   * @brief Go back to applying the prior on each generation
+   */
+  void ClearPrescaledVariation(void);
+
+  /**
+   * @name  IsPrescaled
+   * @fn    bool IsPrescaled(void) const
+   * @brief Indicate if generation uses the prescaled variation
+   * @return    True if prescaled
+   */
+  bool IsPrescaled(void) const {
+    return !s_variation_.empty();
+  }
+
+  /**
+   * @name  TransposeVariation
+   * @fn    Status TransposeVariation(void)
+   * @brief Store a copy of the variation with one component per row, the
+   *        first \p k components are then a contiguous block and truncated
+   *        generation reads only them. Costs one extra variation in memory.
+   *        Once enabled, the copy is rebuilt by \p Load, \p Map and
+   *        \p ReorderVertex.
+   * @return    Operation status
+   */
+  Status TransposeVariation(void);
+
+  /**
+   * @name  ClearTransposedVariation
+   * @fn    void ClearTransposedVariation(void)
+   * @brief Release the transposed copy of the variation
+   */
+  void ClearTransposedVariation(void) {
+    t_variation_.release();
+  }
+
+  /**
+   * @name  IsTransposed
+   * @fn    bool IsTransposed(void) const
+   * @brief Indicate if a transposed variation is available for truncated
+   *        generation
+   * @return    True if transposed
+   */
+  bool IsTransposed(void) const {
+    return !t_variation_.empty();
+  }
+
+  /**
+   * @name  QuantizeVariation
+   * @fn    Status QuantizeVariation(const QuantizedMatrix::Format& format)
+   * @brief Store a reduced precision copy of the variation used by
+   *        \p Generate, cutting the memory traffic of the generation loop
+   *        by 2x (fp16, bf16) or 4x (int8). The full precision variation is
+   *        kept for serialization. The prescaled variation is quantized when
+   *        enabled.
+   * @param[in] format  Storage format
+   * @return    Operation status
+   */
+  Status QuantizeVariation(const QuantizedMatrix::Format& format);
+
+  /**
+   * @name  ReorderVertex
+   * @fn    Status ReorderVertex(const std::vector<int>& vertex_order)
+   * @brief Permute the mean and the rows of the variation to follow a new
+   *        vertex order, i.e. the permutation returned by
+   *        `Mesh::OptimizeLayout` on the model's topology. Mapped data is
+   *        copied, quantized variation is rebuilt with the same format.
+   * @param[in] vertex_order    `vertex_order[new]` is the previous index of
+   *                            vertex `new`
+   * @return    Operation status
+   */
+  Status ReorderVertex(const std::vector<int>& vertex_order);
+
+  /**
+   * @name  Update
+   * @fn    Status Update(const cv::Mat& samples, const int& max_component)
+   * @brief Add new \p samples (i.e. registered scans) to the model without
+   *        the previous data, following the incremental SVD of Brand with
+   *        mean update (Ross et al.). The centered batch and the mean shift
+   *        are split into their projection on the current basis and an
+   *        orthogonal residual (thin QR), the small (k + m + 1) square core
+   *        matrix is decomposed and rotates the extended basis. Cost is
+   *        O(dim * (k + m)^2) per batch, batches can be streamed one scan at
+   *        a time. Requires the number of samples the model was built from,
+   *        see \p set_n_sample; an empty model is built from scratch. Mapped
+   *        data is copied, enabled derived copies of the variation are
+   *        rebuilt.
+   * @param[in] samples         New samples, one per column [dim x m]
+   * @param[in] max_component   Number of components kept, negative to keep
+   *                            the current number (every non-degenerate one
+   *                            for an empty model)
+   * @return    kInvalidArgument if the dimensions do not match or the sample
+   *            count is unknown, kInternalError if a decomposition fails
+   */
+  Status Update(const cv::Mat& samples, const int& max_component);
+
+  /**
+   * @name  ClearQuantizedVariation
+   * @fn    void ClearQuantizedVariation(void)
+   * @brief Go back to full precision generation
+   */
+  void ClearQuantizedVariation(void) {
+    q_variation_ = QuantizedMatrix();
+  }
+
+  /**
+   * @name  IsQuantized
+   * @fn    bool IsQuantized(void) const
+   * @brief Indicate if generation uses the reduced precision variation
+   * @return    True if quantized
+   */
+  bool IsQuantized(void) const {
+    return q_variation_.rows() > 0;
+  }
+
 #pragma mark -
 #pragma mark Protected
 
@@ -133,6 +456,58 @@ class FK_EXPORTS PCAModel : public Serializable {
     return n_principle_component_;
   }
 
+  /**
+   * @name  get_n_sample
+   * @fn    size_t get_n_sample(void) const
+   * @brief Number of samples the model is built from, used by \p Update
+   * @return    Number of samples, 0 if unknown
+   */
+  size_t get_n_sample(void) const {
+    return n_sample_;
+  }
+
+  /**
+   * @name  set_n_sample
+   * @fn    void set_n_sample(const size_t& n_sample)
+   * @brief Set the number of samples the model is built from, it is not
+   *        stored in the model's file and must be set after \p Load before
+   *        calling \p Update
+   * @param[in] n_sample    Number of samples
+   */
+  void set_n_sample(const size_t& n_sample) {
+    n_sample_ = n_sample;
+  }
+
+  /**
+   * @name  get_prior
+   * @fn    const cv::Mat& get_prior(void) const
+   * @brief Provide the standard deviation of each principle component
+   * @return    Prior [k x 1] or [1 x k]
+   */
+  const cv::Mat& get_prior(void) const {
+    return prior_;
+  }
+
+  /**
+   * @name  get_mean
+   * @fn    const cv::Mat& get_mean(void) const
+   * @brief Provide the model's mean
+   * @return    Mean [dim x 1]
+   */
+  const cv::Mat& get_mean(void) const {
+    return mean_;
+  }
+
+  /**
+   * @name  get_variation
+   * @fn    const cv::Mat& get_variation(void) const
+   * @brief Provide the full precision variation, one component per column
+   * @return    Variation [dim x k]
+   */
+  const cv::Mat& get_variation(void) const {
+    return variation_;
+  }
+
 #pragma mark -
 #pragma mark Protected
  protected:
@@ -141,12 +516,24 @@ class FK_EXPORTS PCAModel : public Serializable {
   cv::Mat mean_;
   /** Variation */
   cv::Mat variation_;
+  /** Variation scaled by the prior, empty if not used */
+  cv::Mat s_variation_;
+  /** Variation with one component per row [k x dim], empty if not used */
+  cv::Mat t_variation_;
+  /** Reduced precision variation, empty if not used */
+  QuantizedMatrix q_variation_;
   /** Prior */
   cv::Mat prior_;
+  /** Last sub-model used by \p GenerateSubset */
+  Subset subset_;
   /** Channels */
   int n_channels_;
   /** Number of principal components */
   int n_principle_component_;
+  /** Mean, variation and prior are mapped from a file */
+  bool shared_ = false;
+  /** Number of samples the model is built from, 0 if unknown */
+  size_t n_sample_ = 0;
 
 };
 
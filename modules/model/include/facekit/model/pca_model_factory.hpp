@@ -11,7 +11,17 @@
 #ifndef __FACEKIT_PCA_MODEL_FACTORY__
 #define __FACEKIT_PCA_MODEL_FACTORY__
 
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "facekit/core/library_export.hpp"
+#include "facekit/core/refcounter.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/core/utils/static_registry.hpp"
 #include "facekit/model/pca_model.hpp"
 
 /**
@@ -22,7 +32,11 @@ namespace FaceKit {
 
 /**
  * @class   PCAModelFactory
- * @brief   Manager for PCAModel based instance
+ * @brief   Manager for PCAModel based instance. Also holds a process-wide
+ *          cache of loaded models keyed by path and load options: models
+ *          are loaded on first use, shared read-only through reference
+ *          counted handles and evicted once idle when the cache exceeds its
+ *          memory budget.
  * @author  Christophe Ecabert
  * @date    15/08/2017
  * @ingroup model
@@ -38,6 +52,138 @@ class FK_EXPORTS PCAModelFactory {
   /** Model Type */
   using Model = PCAModel<T>;
 
+  /**
+   * @struct    LoadOptions
+   * @brief     How a cached model is created and loaded, part of the cache
+   *            key
+   */
+  struct LoadOptions {
+    /** Registered model name, see `PCAModelProxy::Name` */
+    std::string name;
+    /** Number of components to keep, negative to keep all of them. Ignored
+        when mapping */
+    int n_component = -1;
+    /** Map the file read-only instead of copying it, see `PCAModel::Map` */
+    bool map = false;
+    /** Position of the model in the file */
+    size_t offset = 0;
+    /** Fold the prior into the variation, see
+        `PCAModel::PrescaleVariation` */
+    bool prescale = false;
+  };
+
+ private:
+  /** Cache entry, forward declaration */
+  class Entry;
+
+ public:
+
+  /**
+   * @class Handle
+   * @brief Shared reference on a cached model. The model stays alive as
+   *        long as a handle references it, even if evicted in the meantime.
+   *        Models are shared between threads, therefore only const access
+   *        is given (i.e. `Generate` with a caller's workspace).
+   */
+  class FK_EXPORTS Handle {
+   public:
+    /**
+     * @name  Handle
+     * @fn    Handle(void)
+     * @brief Constructor, empty handle
+     */
+    Handle(void) : entry_(nullptr) {}
+
+    /**
+     * @name  Handle
+     * @fn    Handle(const Handle& other)
+     * @brief Copy constructor, share the same model
+     * @param[in] other Object to copy from
+     */
+    Handle(const Handle& other);
+
+    /**
+     * @name  Handle
+     * @fn    Handle(Handle&& other)
+     * @brief Move constructor
+     * @param[in] other Object to move from
+     */
+    Handle(Handle&& other);
+
+    /**
+     * @name  operator=
+     * @fn    Handle& operator=(const Handle& rhs)
+     * @brief Assignment operator
+     * @param[in] rhs Object to assign from
+     * @return    Newly assigned object
+     */
+    Handle& operator=(const Handle& rhs);
+
+    /**
+     * @name  operator=
+     * @fn    Handle& operator=(Handle&& rhs)
+     * @brief Move assignment operator
+     * @param[in] rhs Object to move assign from
+     * @return    Newly moved-assign object
+     */
+    Handle& operator=(Handle&& rhs);
+
+    /**
+     * @name  ~Handle
+     * @fn    ~Handle(void)
+     * @brief Destructor, release the reference
+     */
+    ~Handle(void);
+
+    /**
+     * @name  get
+     * @fn    const Model* get(void) const
+     * @brief Referenced model
+     * @return    Model or nullptr if empty
+     */
+    const Model* get(void) const;
+
+    /**
+     * @name  operator->
+     * @fn    const Model* operator->(void) const
+     * @brief Access the referenced model
+     */
+    const Model* operator->(void) const {
+      return this->get();
+    }
+
+    /**
+     * @name  operator*
+     * @fn    const Model& operator*(void) const
+     * @brief Access the referenced model
+     */
+    const Model& operator*(void) const {
+      return *this->get();
+    }
+
+    /**
+     * @name  operator bool
+     * @fn    explicit operator bool(void) const
+     * @brief Indicate if the handle references a model
+     */
+    explicit operator bool(void) const {
+      return entry_ != nullptr;
+    }
+
+   private:
+    friend class PCAModelFactory<T>;
+
+    /**
+     * @name  Handle
+     * @fn    explicit Handle(RefPtr<Entry> entry)
+     * @brief Constructor, take over the reference held by \p entry
+     */
+    explicit Handle(RefPtr<Entry> entry) : entry_(std::move(entry)) {}
+
+    /** Referenced entry */
+    RefPtr<Entry> entry_;
+  };
+
 #pragma mark -
 #pragma mark Initialization
 
@@ -51,10 +197,10 @@ class FK_EXPORTS PCAModelFactory {
 
   /**
    * @name  ~PCAModelFactory
-   * @fn    ~PCAModelFactory(void) = default
-   * @brief Destructor
+   * @fn    ~PCAModelFactory(void)
+   * @brief Destructor, release the cached models
    */
-  ~PCAModelFactory(void) = default;
+  ~PCAModelFactory(void);
 
   /**
    * @name  PCAModelFactory
@@ -102,18 +248,132 @@ class FK_EXPORTS PCAModelFactory {
    */
   Model* CreateByName(const std::string& name) const;
 
+  /** Maximum number of registered model types */
+  static constexpr size_t kMaxProxy = 32;
+
   /**
    * @name  Register
-   * @fn    void Register(const PCAModelProxy<T>* proxy)
-   * @brief Register a new \p proxy with the factory
+   * @fn    static void Register(const PCAModelProxy<T>* proxy)
+   * @brief Register a new \p proxy with the factory. Neither allocates nor
+   *        builds the factory, therefore it is cheap to call from static
+   *        constructors.
    * @param[in] proxy Proxy to register
    */
-  void Register(const PCAModelProxy<T>* proxy);
+  static void Register(const PCAModelProxy<T>* proxy);
+
+  /**
+   * @name  Acquire
+   * @fn    Status Acquire(const std::string& path, const LoadOptions& options,
+                           Handle* model)
+   * @brief Get the model stored in \p path from the cache, loading it on
+   *        first use. Concurrent calls for the same model load it once, the
+   *        others wait for it.
+   * @param[in] path    Path to the model's file
+   * @param[in] options How to create and load the model
+   * @param[out] model  Shared model
+   * @return    kInvalidArgument if the name is not registered, kInternalError
+   *            if loading failed. Failures are not cached.
+   */
+  Status Acquire(const std::string& path,
+                 const LoadOptions& options,
+                 Handle* model);
+
+  /**
+   * @name  Preload
+   * @fn    void Preload(const std::vector<std::pair<std::string,
+                         LoadOptions>>& models)
+   * @brief Load \p models into the cache in the background, on the global
+   *        `ThreadPool` with low priority. Failures are logged.
+   * @param[in] models  List of path and options
+   */
+  void Preload(const std::vector<std::pair<std::string, LoadOptions>>& models);
+
+  /**
+   * @name  ClearCache
+   * @fn    void ClearCache(void)
+   * @brief Drop every cached model, models still referenced by a handle are
+   *        released when their last handle goes away
+   */
+  void ClearCache(void);
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   * @name  cache_budget
+   * @fn    size_t cache_budget(void) const
+   * @brief Memory budget of the cache in bytes
+   */
+  size_t cache_budget(void) const;
+
+  /**
+   * @name  set_cache_budget
+   * @fn    void set_cache_budget(const size_t& budget)
+   * @brief Set the memory budget of the cache in bytes, least recently used
+   *        idle models are evicted until it is met. Models referenced by a
+   *        handle are never evicted, the budget can therefore be exceeded
+   *        temporarily.
+   */
+  void set_cache_budget(const size_t& budget);
+
+  /**
+   * @name  cache_size
+   * @fn    size_t cache_size(void) const
+   * @brief Memory used by the cached models in bytes (estimated)
+   */
+  size_t cache_size(void) const;
 
 #pragma mark -
 #pragma mark Private
  private:
 
+  /**
+   * @class Entry
+   * @brief Cached model. The cache holds one reference, every handle one
+   *        more
+   */
+  class Entry : public RefCounter {
+   public:
+    /** Model, nullptr until loaded */
+    Model* model = nullptr;
+    /** Estimated memory footprint */
+    size_t bytes = 0;
+    /** Last access, for LRU eviction */
+    uint64_t last_use = 0;
+    /** Loading is done, `model` is set on success */
+    bool loaded = false;
+    /** Serialize loading */
+    std::mutex load_mutex;
+
+   protected:
+    /**
+     * @name  ~Entry
+     * @fn    ~Entry(void) override
+     * @brief Destructor, release the model
+     */
+    ~Entry(void) override {
+      delete model;
+    }
+  };
+
+  /**
+   * @name  Load
+   * @fn    Status Load(const std::string& path, const LoadOptions& options,
+                        Entry* entry) const
+   * @brief Create and load the model of \p entry
+   */
+  Status Load(const std::string& path,
+              const LoadOptions& options,
+              Entry* entry) const;
+
+  /**
+   * @name  Evict
+   * @fn    void Evict(void)
+   * @brief Drop least recently used idle entries until the budget is met,
+   *        `cache_mutex_` must be held
+   */
+  void Evict(void);
+
   /**
    * @name  PCAModelFactory
    * @fn    PCAModelFactory(void) = default
@@ -121,8 +381,18 @@ class FK_EXPORTS PCAModelFactory {
    */
   PCAModelFactory(void) = default;
 
-  /** Proxies */
-  std::vector<const PCAModelProxy<T>*> proxies_;
+  /** Proxies, constant-initialized */
+  static StaticRegistry<const PCAModelProxy<T>*, kMaxProxy> proxies_;
+  /** Cached models, by key (path + options) */
+  std::map<std::string, RefPtr<Entry>> cache_;
+  /** Protect `cache_`, `size_`, `budget_` and `clock_` */
+  mutable std::mutex cache_mutex_;
+  /** Memory used by loaded entries */
+  size_t size_ = 0;
+  /** Memory budget, unlimited by default */
+  size_t budget_ = static_cast<size_t>(-1);
+  /** Access counter */
+  uint64_t clock_ = 0;
 };
 
 }  // namepsace FaceKit
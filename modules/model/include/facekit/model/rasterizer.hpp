@@ -0,0 +1,250 @@
+/**
+ *  @file   facekit/model/rasterizer.hpp
+ *  @brief  CPU rasterization of a mesh seen by a camera into depth, triangle
+ *          index and barycentric buffers
+ *  @ingroup model
+ *
+ *  @author Christophe Ecabert
+ *  @date   05.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_RASTERIZER__
+#define __FACEKIT_RASTERIZER__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/geometry/mesh.hpp"
+#include "facekit/model/camera.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ * @class   Rasterizer
+ * @brief   Tile based z-buffer rasterizer, replaces a GPU context for
+ *          visibility and photometric fitting. Vertices are projected once,
+ *          triangles are set up concurrently (edge functions, bounding box,
+ *          culling), binned into square tiles, then every tile is
+ *          rasterized independently on the global `ThreadPool`, four pixels
+ *          at a time with SSE when available. Tiles never share pixels,
+ *          hence no synchronization while rasterizing. Within a tile
+ *          triangles are processed in mesh order and ties keep the first
+ *          one, so the output is deterministic.
+ * @author  Christophe Ecabert
+ * @date    05.11.18
+ * @ingroup model
+ * @tparam T    Data type
+ * @tparam ProjType Type of camera projection
+ */
+template<typename T, template<typename U> class ProjType>
+class FK_EXPORTS Rasterizer {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /** Camera */
+  using Cam = Camera<T, ProjType>;
+
+  /**
+   * @struct    Options
+   * @brief     Rasterization configuration
+   */
+  struct Options {
+    /** Discard triangles facing away from the camera, i.e. with a negative
+        signed area (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0) in image
+        coordinates */
+    bool cull_backface = false;
+    /** Perspective only, triangles with a vertex closer than this (or
+        behind the camera) are discarded */
+    T z_near = T(1e-3);
+  };
+
+  /**
+   * @struct    Buffers
+   * @brief     Per-pixel outputs, row major [height x width]
+   */
+  struct Buffers {
+    /** Depth in the camera's reference frame (CV_32F), +inf where empty */
+    cv::Mat depth;
+    /** Index of the visible triangle (CV_32S), -1 where empty */
+    cv::Mat triangle;
+    /** Barycentric weights of the second and third vertex of the visible
+        triangle (CV_32FC2), the first one is 1 - b1 - b2. Perspective
+        correct with perspective cameras. */
+    cv::Mat barycentric;
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   * @name  Rasterizer
+   * @fn    Rasterizer(const int& width, const int& height)
+   * @brief Constructor
+   * @param[in] width   Image width
+   * @param[in] height  Image height
+   */
+  Rasterizer(const int& width, const int& height) : width_(width),
+                                                    height_(height) {}
+
+  /**
+   * @name  Rasterizer
+   * @fn    Rasterizer(const int& width, const int& height,
+                       const Options& options)
+   * @brief Constructor
+   * @param[in] width   Image width
+   * @param[in] height  Image height
+   * @param[in] options Rasterization options
+   */
+  Rasterizer(const int& width, const int& height, const Options& options) :
+          width_(width), height_(height), options_(options) {}
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   * @name  Render
+   * @fn    Status Render(const Mesh<T>& mesh, const Cam& camera,
+                          Buffers* buffers)
+   * @brief Rasterize \p mesh seen by \p camera. Buffers are reused if
+   *        already allocated with the right size. Projected vertices and
+   *        their depth are kept for `Visibility`.
+   * @param[in] mesh        Mesh to render
+   * @param[in] camera      Camera
+   * @param[out] buffers    Depth, triangle and barycentric buffers
+   * @return    kInvalidArgument if the image size is invalid or a triangle
+   *            references a missing vertex
+   */
+  Status Render(const Mesh<T>& mesh, const Cam& camera, Buffers* buffers);
+
+  /**
+   * @name  Visibility
+   * @fn    void Visibility(const Buffers& buffers,
+                            const std::vector<int>& vertex,
+                            const T& tolerance,
+                            std::vector<uint8_t>* visible) const
+   * @brief Check which \p vertex (i.e. landmarks) are visible in the last
+   *        `Render`: projected inside the image and not further than the
+   *        z-buffer at their pixel by more than \p tolerance
+   * @param[in] buffers     Output of the last `Render`
+   * @param[in] vertex      Vertex indices
+   * @param[in] tolerance   Depth tolerance, in model units
+   * @param[out] visible    1 if visible, 0 otherwise, for each vertex
+   */
+  void Visibility(const Buffers& buffers,
+                  const std::vector<int>& vertex,
+                  const T& tolerance,
+                  std::vector<uint8_t>* visible) const;
+
+  /**
+   * @name  SampleColor
+   * @fn    Status SampleColor(const Buffers& buffers, const cv::Mat& image,
+                               const T& tolerance, Mesh<T>* mesh,
+                               std::vector<uint8_t>* visible) const
+   * @brief Color every vertex of the mesh given to the last `Render` with
+   *        \p image, i.e. the frame a model has been fitted on. Vertices
+   *        already projected by `Render` are tested against the z-buffer
+   *        (see `Visibility`) and the visible ones are bilinearly sampled,
+   *        eight at a time with AVX2 gathers when available. Vertices are
+   *        processed concurrently on the global `ThreadPool`.
+   * @param[in] buffers     Output of the last `Render`
+   * @param[in] image       Image of the render's size, CV_8UC1, CV_8UC3
+   *                        (BGR) or CV_8UC4 (BGRA)
+   * @param[in] tolerance   Depth tolerance, in model units
+   * @param[in,out] mesh    Rendered mesh, receives its vertex colors: RGB
+   *                        in [0, 1], alpha 1 if visible. Hidden vertices
+   *                        are transparent black.
+   * @param[out] visible    1 if visible, 0 otherwise, for each vertex. Can
+   *                        be nullptr
+   * @return    kInvalidArgument if \p image or \p mesh does not match the
+   *            last `Render`
+   */
+  Status SampleColor(const Buffers& buffers,
+                     const cv::Mat& image,
+                     const T& tolerance,
+                     Mesh<T>* mesh,
+                     std::vector<uint8_t>* visible) const;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   * @name  projection
+   * @fn    const cv::Mat& projection(void) const
+   * @brief Vertices projected by the last `Render` [2N x 1]
+   */
+  const cv::Mat& projection(void) const {
+    return proj_;
+  }
+
+  /**
+   * @name  options
+   * @fn    const Options& options(void) const
+   * @brief Rasterization options
+   */
+  const Options& options(void) const {
+    return options_;
+  }
+
+  /**
+   * @name  set_options
+   * @fn    void set_options(const Options& options)
+   * @brief Set rasterization options
+   */
+  void set_options(const Options& options) {
+    options_ = options;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+
+  /**
+   * @struct    Setup
+   * @brief     Triangle ready for rasterization: normalized edge functions
+   *            l_k(x, y) = a_k * x + b_k * y + c_k giving the screen space
+   *            barycentric coordinates, per vertex weights for perspective
+   *            correction and pixel bounding box
+   */
+  struct Setup {
+    /** Edge functions */
+    float a[3];
+    float b[3];
+    float c[3];
+    /** Perspective weight, 1 / z or 1 */
+    float q[3];
+    /** Depth numerator, 1 or z */
+    float d[3];
+    /** Pixel bounding box, inclusive min / exclusive max */
+    int x0, y0, x1, y1;
+  };
+
+  /** Image width */
+  int width_;
+  /** Image height */
+  int height_;
+  /** Options */
+  Options options_;
+  /** Projected vertices of the last render */
+  cv::Mat proj_;
+  /** Vertex depth of the last render */
+  cv::Mat depth_;
+  /** Triangle setups, empty bounding box if discarded */
+  std::vector<Setup> setup_;
+  /** Triangles overlapping each tile, in mesh order */
+  std::vector<std::vector<int>> bins_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_RASTERIZER__ */
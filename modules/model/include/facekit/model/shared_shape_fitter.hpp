@@ -0,0 +1,170 @@
+/**
+ *  @file   facekit/model/shared_shape_fitter.hpp
+ *  @brief  Fit one shape seen by several cameras (i.e. multi-view rig or
+ *          video frames)
+ *  @ingroup    model
+ *
+ *  @author Christophe Ecabert
+ *  @date   03.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_SHARED_SHAPE_FITTER__
+#define __FACEKIT_SHARED_SHAPE_FITTER__
+
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/model/camera.hpp"
+#include "facekit/model/pca_model.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ * @class   SharedShapeFitter
+ * @brief   Jointly estimate one set of shape coefficients and one camera per
+ *          view with Gauss-Newton. The normal equations are block sparse:
+ *          each camera only couples with the shape. Every view eliminates
+ *          its camera block locally (Schur complement, see
+ *          `Camera::EliminateCamera`) concurrently on the global
+ *          `ThreadPool`, the reduced k x k systems are summed and solved
+ *          once, then the camera increments are back-substituted. The cost
+ *          of an iteration is linear in the number of views instead of
+ *          cubic for the dense system.
+ * @author  Christophe Ecabert
+ * @date    03.11.18
+ * @ingroup model
+ * @tparam T    Data type
+ * @tparam ProjType Type of camera projection
+ */
+template<typename T, template<typename U> class ProjType>
+class FK_EXPORTS SharedShapeFitter {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /** Camera */
+  using Cam = Camera<T, ProjType>;
+  /** Landmark sub-model */
+  using Subset = typename PCAModel<T>::Subset;
+
+  /**
+   * @struct    View
+   * @brief     Landmarks observed by one camera, the camera is used as
+   *            initial guess
+   */
+  struct View {
+    /** Landmark positions [2N x 1] */
+    cv::Mat proj;
+    /** Camera of this view */
+    Cam* camera;
+  };
+
+  /**
+   * @struct    FitOptions
+   * @brief     Solver configuration
+   */
+  struct FitOptions {
+    /** Weight of the coefficients' regularization `eta * |p|^2` */
+    T eta = T(1.0);
+    /** Stop when the RMS reprojection error changes by less than this, in
+        pixels */
+    T eps = T(1e-3);
+    /** Maximum number of iterations */
+    int max_iter = 100;
+  };
+
+  /**
+   * @struct    FitSummary
+   * @brief     Stopping statistics
+   */
+  struct FitSummary {
+    /** Iterations taken */
+    int n_iter = 0;
+    /** RMS reprojection error over every view, before the last update */
+    T rms = T(0.0);
+    /** Stopped on `eps` before `max_iter` */
+    bool converged = false;
+  };
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   * @name  SharedShapeFitter
+   * @fn    SharedShapeFitter(void)
+   * @brief Constructor, default solver options
+   */
+  SharedShapeFitter(void) = default;
+
+  /**
+   * @name  SharedShapeFitter
+   * @fn    explicit SharedShapeFitter(const FitOptions& options)
+   * @brief Constructor
+   * @param[in] options Solver options
+   */
+  explicit SharedShapeFitter(const FitOptions& options) : options_(options) {}
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   * @name  Fit
+   * @fn    Status Fit(const PCAModel<T>& model, const Subset& landmarks,
+                       const std::vector<View>& views, cv::Mat* p,
+                       FitSummary* summary) const
+   * @brief Estimate the shared shape coefficients and every camera
+   * @param[in] model       Shape model, provides the prior
+   * @param[in] landmarks   Landmark sub-model, see `PCAModel::BuildSubset`
+   * @param[in] views       Views, cameras must be distinct
+   * @param[in,out] p       Shape coefficients, initial guess [k x 1]. Only
+   *                        the first k components are optimized, all of
+   *                        them starting from the mean if empty.
+   * @param[out] summary    Stopping statistics, can be nullptr
+   * @return    kInvalidArgument if a view is malformed, kInternalError if
+   *            the system is singular
+   */
+  Status Fit(const PCAModel<T>& model,
+             const Subset& landmarks,
+             const std::vector<View>& views,
+             cv::Mat* p,
+             FitSummary* summary) const;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   * @name  options
+   * @fn    const FitOptions& options(void) const
+   * @brief Solver options
+   */
+  const FitOptions& options(void) const {
+    return options_;
+  }
+
+  /**
+   * @name  set_options
+   * @fn    void set_options(const FitOptions& options)
+   * @brief Set solver options
+   */
+  void set_options(const FitOptions& options) {
+    options_ = options;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Solver options */
+  FitOptions options_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_SHARED_SHAPE_FITTER__ */
@@ -0,0 +1,239 @@
+/**
+ *  @file   facekit/model/texture_pca_model.hpp
+ *  @brief  Statistical texture model generating straight into 8-bit images
+ *  @ingroup model
+ *
+ *  @author Christophe Ecabert
+ *  @date   04.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_TEXTURE_PCA_MODEL__
+#define __FACEKIT_TEXTURE_PCA_MODEL__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "opencv2/core/core.hpp"
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/nd_array.hpp"
+#include "facekit/core/status.hpp"
+#include "facekit/io/image.hpp"
+#include "facekit/model/pca_model.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ * @class   TexturePCAModel
+ * @brief   PCA model of a texture map stored as interleaved pixels
+ *          [height x width x n_channels] in 8-bit intensity units (i.e.
+ *          [0, 255] unless `intensity_scale` says otherwise). Instances are
+ *          generated by bands of rows: the band of the basis is multiplied
+ *          with the coefficients into a small tile kept in cache, then
+ *          rounded and saturated to `uint8_t` (optionally box filtered to
+ *          half resolution) straight into the destination. Bands are spread
+ *          over the global `ThreadPool`, no full-size floating point
+ *          instance is ever materialized.
+ * @author  Christophe Ecabert
+ * @date    04.11.18
+ * @ingroup model
+ * @tparam T    Data type
+ */
+template<typename T>
+class FK_EXPORTS TexturePCAModel : public PCAModel<T> {
+ public:
+
+#pragma mark -
+#pragma mark Type definition
+
+  /** Scratch buffers */
+  using Workspace = typename PCAModel<T>::Workspace;
+
+#pragma mark -
+#pragma mark Initialization
+
+  /**
+   * @name  TexturePCAModel
+   * @fn    TexturePCAModel(void)
+   * @brief Constructor, texture size must be set with `SetSize` once the
+   *        model is loaded
+   */
+  TexturePCAModel(void) : width_(0), height_(0), scale_(T(1.0)) {}
+
+  /**
+   * @name  TexturePCAModel
+   * @fn    TexturePCAModel(const size_t& width, const size_t& height)
+   * @brief Constructor
+   * @param[in] width   Texture width
+   * @param[in] height  Texture height
+   */
+  TexturePCAModel(const size_t& width, const size_t& height) :
+          width_(width), height_(height), scale_(T(1.0)) {}
+
+  /**
+   * @name  ~TexturePCAModel
+   * @fn    ~TexturePCAModel(void) override = default
+   * @brief Destructor
+   */
+  ~TexturePCAModel(void) override = default;
+
+  /**
+   * @name  SetSize
+   * @fn    Status SetSize(const size_t& width, const size_t& height)
+   * @brief Set the texture layout of the loaded model
+   * @param[in] width   Texture width
+   * @param[in] height  Texture height
+   * @return    kInvalidArgument if width * height * n_channels does not
+   *            match the model's dimension or the number of channels is not
+   *            an image format (1, 3 or 4)
+   */
+  Status SetSize(const size_t& width, const size_t& height);
+
+#pragma mark -
+#pragma mark Usage
+
+  /** Generic generation into floating point buffers */
+  using PCAModel<T>::Generate;
+
+  /**
+   * @name  Generate
+   * @fn    Status Generate(const cv::Mat& p, const bool& half,
+                            Workspace* ws, NDArray* image) const
+   * @brief Generate a texture given a set of coefficients \p p, reentrant
+   * @param[in] p           Model's coefficients
+   * @param[in] half        If true, output is box filtered to half the
+   *                        resolution (odd last row/column dropped)
+   * @param[in,out] ws      Caller's scratch buffers
+   * @param[out] image      Texture of type kUInt8 and shape [height x width
+   *                        x n_channels], same layout as `Image::LoadInto`.
+   *                        Reallocated only if its size does not match.
+   * @return    kInvalidArgument if the texture size is not set or \p p does
+   *            not match the model
+   */
+  Status Generate(const cv::Mat& p,
+                  const bool& half,
+                  Workspace* ws,
+                  NDArray* image) const;
+
+  /**
+   * @name  Generate
+   * @fn    Status Generate(const cv::Mat& p, const bool& half,
+                            NDArray* image)
+   * @brief Generate a texture given a set of coefficients \p p. Uses a
+   *        per-thread workspace.
+   * @param[in] p           Model's coefficients
+   * @param[in] half        If true, output is at half the resolution
+   * @param[out] image      Texture [height x width x n_channels]
+   * @return    kInvalidArgument if the texture size is not set or \p p does
+   *            not match the model
+   */
+  Status Generate(const cv::Mat& p, const bool& half, NDArray* image);
+
+  /**
+   * @name  Generate
+   * @fn    Status Generate(const cv::Mat& p, const bool& half, Image* image)
+   * @brief Generate a texture given a set of coefficients \p p into the
+   *        pixel buffer of an existing \p image (i.e. before `Save`). Uses a
+   *        per-thread workspace.
+   * @param[in] p           Model's coefficients
+   * @param[in] half        If true, output is at half the resolution
+   * @param[in,out] image   Image whose width, height and format match the
+   *                        generated texture
+   * @return    kInvalidArgument if \p image does not match the texture
+   */
+  Status Generate(const cv::Mat& p, const bool& half, Image* image);
+
+  /**
+   * @name  Generate
+   * @fn    void Generate(const cv::Mat& p, Mesh<T>* instance) override
+   * @brief Textures live in image space, not supported
+   * @param[in] p           Model's coefficients
+   * @param[out] instance   Left untouched
+   */
+  void Generate(const cv::Mat& p, Mesh<T>* instance) override;
+
+  /**
+   * @name  Generate
+   * @fn    void Generate(Mesh<T>* instance) override
+   * @brief Textures live in image space, not supported
+   * @param[out] instance   Left untouched
+   */
+  void Generate(Mesh<T>* instance) override;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   * @name  width
+   * @fn    const size_t& width(void) const
+   * @brief Texture width
+   */
+  const size_t& width(void) const {
+    return width_;
+  }
+
+  /**
+   * @name  height
+   * @fn    const size_t& height(void) const
+   * @brief Texture height
+   */
+  const size_t& height(void) const {
+    return height_;
+  }
+
+  /**
+   * @name  intensity_scale
+   * @fn    const T& intensity_scale(void) const
+   * @brief Factor applied to the model's values before saturation
+   */
+  const T& intensity_scale(void) const {
+    return scale_;
+  }
+
+  /**
+   * @name  set_intensity_scale
+   * @fn    void set_intensity_scale(const T& scale)
+   * @brief Set the factor applied to the model's values before saturation,
+   *        i.e. 255 for a model built on [0, 1] intensities
+   */
+  void set_intensity_scale(const T& scale) {
+    scale_ = scale;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+
+  /**
+   * @name  CheckInput
+   * @fn    Status CheckInput(const cv::Mat& p) const
+   * @brief Check the texture layout and the coefficients
+   */
+  Status CheckInput(const cv::Mat& p) const;
+
+  /**
+   * @name  Render
+   * @fn    void Render(const cv::Mat& p, const bool& half, Workspace* ws,
+                        uint8_t* dst) const
+   * @brief Generate the texture band by band into \p dst
+   */
+  void Render(const cv::Mat& p,
+              const bool& half,
+              Workspace* ws,
+              uint8_t* dst) const;
+
+  /** Texture width */
+  size_t width_;
+  /** Texture height */
+  size_t height_;
+  /** Intensity scale */
+  T scale_;
+};
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_TEXTURE_PCA_MODEL__ */
@@ -8,16 +8,25 @@
  *  Copyright (c) 2017 Christophe Ecabert. All rights reserved.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
 #include "opencv2/core.hpp"
 #include "opencv2/calib3d/calib3d.hpp"
 #include "opencv2/highgui.hpp"
 
 #include "facekit/core/logger.hpp"
+#include "facekit/core/mem/cv_allocator.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/trace.hpp"
 #include "facekit/model/camera.hpp"
 #include "facekit/model/orthographic_projection.hpp"
 #include "facekit/model/weak_projection.hpp"
 #include "facekit/model/perspective_projection.hpp"
 #include "facekit/core/math/linear_algebra.hpp"
+#include "facekit/core/math/point_transform.hpp"
 #include "facekit/io/file_io.hpp"
 
 /**
@@ -26,6 +35,11 @@
  */
 namespace FaceKit {
   
+/** Number of points projected at once, structure of arrays fits in L1 */
+static constexpr size_t kProjectionBlock = 256;
+/** Number of points projected by one parallel task */
+static constexpr size_t kProjectionGrain = 8 * kProjectionBlock;
+  
 #pragma mark -
 #pragma mark Initialization
 
@@ -41,8 +55,8 @@ template<typename T, template<typename U> class ProjType>
 Camera<T, ProjType>::Camera(const T focal,
                             const T width,
                             const T height) : p_(focal, width, height),
-                                              ax_{T(1.0), T(1.0), T(1.0)} {
-  rot_.ToRotationMatrix(&rotm_);
+                                              ax_{T(1.0), T(1.0), T(1.0)},
+                                              rot_dirty_(true) {
   t_.z_ = focal;
 }
 
@@ -79,13 +93,16 @@ void Camera<T, ProjType>::ToVector(T* vector) const {
 template<typename T, template<typename U> class ProjType>
 void Camera<T, ProjType>::FromVector(const T* vector) {
   p_.FromVector(vector);
-  // Rot
-  rot_.v_.x_ = vector[3];
-  rot_.v_.y_ = vector[4];
-  rot_.v_.z_ = vector[5];
-  rot_.q_ = vector[6];
-  rot_.Normalize();
-  rot_.ToRotationMatrix(&rotm_);
+  // Rot, matrix rebuilt on next use and only if the rotation did change
+  if (rot_.v_.x_ != vector[3] || rot_.v_.y_ != vector[4] ||
+      rot_.v_.z_ != vector[5] || rot_.q_ != vector[6]) {
+    rot_.v_.x_ = vector[3];
+    rot_.v_.y_ = vector[4];
+    rot_.v_.z_ = vector[5];
+    rot_.q_ = vector[6];
+    rot_.Normalize();
+    this->InvalidateRotation();
+  }
   // T
   t_.x_ = vector[7];
   t_.y_ = vector[8];
@@ -119,18 +136,146 @@ int Camera<T, ProjType>::From3Dto2D(const std::vector<Point3>& pts,
   return this->From3Dto2D(p3s, p2s, eps);
 }
 
+/**
+ * @name  FactorSpd
+ * @fn    template<typename T, int N> static bool FactorSpd(const T* a, T* l)
+ * @brief In-register Cholesky decomposition a = L L' of a small symmetric
+ *        positive definite matrix, no allocation nor shared state so that
+ *        many cameras can be fitted concurrently
+ * @param[in] a   Row-major matrix [N x N]
+ * @param[out] l  Lower triangular factor, row-major [N x N]
+ * @return    False if \p a is not positive definite
+ */
+template<typename T, int N>
+static bool FactorSpd(const T* a, T* l) {
+  for (int i = 0; i < N; ++i) {
+    for (int j = 0; j <= i; ++j) {
+      T sum = a[i * N + j];
+      for (int k = 0; k < j; ++k) {
+        sum -= l[i * N + k] * l[j * N + k];
+      }
+      if (i == j) {
+        if (!(sum > T(0.0))) {
+          return false;
+        }
+        l[i * N + i] = std::sqrt(sum);
+      } else {
+        l[i * N + j] = sum / l[j * N + j];
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * @name  SolveFactoredSpd
+ * @fn    template<typename T, int N> static void SolveFactoredSpd(
+                                          const T* l, const T* b, T* x)
+ * @brief Solve L L' x = b with the factor computed by `FactorSpd`
+ * @param[in] l   Lower triangular factor [N x N]
+ * @param[in] b   Right hand side [N]
+ * @param[out] x  Solution [N], can be \p b
+ */
+template<typename T, int N>
+static void SolveFactoredSpd(const T* l, const T* b, T* x) {
+  // L y = b, then L' x = y
+  for (int i = 0; i < N; ++i) {
+    T sum = b[i];
+    for (int k = 0; k < i; ++k) {
+      sum -= l[i * N + k] * x[k];
+    }
+    x[i] = sum / l[i * N + i];
+  }
+  for (int i = N - 1; i >= 0; --i) {
+    T sum = x[i];
+    for (int k = i + 1; k < N; ++k) {
+      sum -= l[k * N + i] * x[k];
+    }
+    x[i] = sum / l[i * N + i];
+  }
+}
+
+/**
+ * @name  SolveSpd
+ * @fn    template<typename T, int N> static bool SolveSpd(const T* a,
+                                                           const T* b, T* x)
+ * @brief Solve the small symmetric positive definite system a x = b with an
+ *        in-register Cholesky decomposition
+ * @param[in] a   Row-major matrix [N x N]
+ * @param[in] b   Right hand side [N]
+ * @param[out] x  Solution [N]
+ * @return    False if \p a is not positive definite
+ */
+template<typename T, int N>
+static bool SolveSpd(const T* a, const T* b, T* x) {
+  T l[N * N];
+  if (!FactorSpd<T, N>(a, &l[0])) {
+    return false;
+  }
+  SolveFactoredSpd<T, N>(&l[0], b, x);
+  return true;
+}
+
 /*
  * @struct  JacobianHelper
- * @brief   Helper functor to compute projection jacobian matrix
+ * @brief   Fixed-size Jacobian kernels of a projection. Each specialization
+ *          provides `kCols`, the number of optimized parameters, `Row` the
+ *          two Jacobian rows of one point and `Projection` the derivative
+ *          of the image point w.r.t. the camera space point.
  * @tparam T Data type
  * @tparam ProjType Projection type (ortho, weak, perspective)
  */
 template<typename T, template<typename U> class ProjType>
-struct JacobianHelper {
-  void operator()(const cv::Mat& pts,
-                  const Camera<T, ProjType>* camera,
-                  cv::Mat* j_proj) {}
-};
+struct JacobianHelper;
+
+/**
+ * @name  AccumulateRows
+ * @fn    template<typename T, int N> static void AccumulateRows(const T* jx,
+                                   const T* jy, const T w, const T ex,
+                                   const T ey, T* h, T* g)
+ * @brief Add the weighted contribution of one point to the upper triangle of
+ *        J'WJ and to J'We. \p N is known at compile time so the loops are
+ *        fully unrolled.
+ * @param[in] jx      Jacobian row of the x coordinate [N]
+ * @param[in] jy      Jacobian row of the y coordinate [N]
+ * @param[in] w       Weight of the point
+ * @param[in] ex      Residual along x
+ * @param[in] ey      Residual along y
+ * @param[in,out] h   Row-major J'WJ [N x N], upper triangle only
+ * @param[in,out] g   J'We [N]
+ */
+template<typename T, int N>
+static inline void AccumulateRows(const T* jx,
+                                  const T* jy,
+                                  const T w,
+                                  const T ex,
+                                  const T ey,
+                                  T* h,
+                                  T* g) {
+  for (int a = 0; a < N; ++a) {
+    const T wjx = w * jx[a];
+    const T wjy = w * jy[a];
+    g[a] += wjx * ex + wjy * ey;
+    for (int b = a; b < N; ++b) {
+      h[a * N + b] += wjx * jx[b] + wjy * jy[b];
+    }
+  }
+}
+
+/**
+ * @name  SymmetrizeUpper
+ * @fn    template<typename T, int N> static void SymmetrizeUpper(T* h)
+ * @brief Mirror the upper triangle of \p h into its lower triangle
+ * @param[in,out] h   Row-major matrix [N x N]
+ */
+template<typename T, int N>
+static inline void SymmetrizeUpper(T* h) {
+  for (int a = 1; a < N; ++a) {
+    for (int b = 0; b < a; ++b) {
+      h[a * N + b] = h[b * N + a];
+    }
+  }
+}
 
 /*
  * @struct  JacobianHelper
@@ -140,53 +285,47 @@ struct JacobianHelper {
  */
 template<typename T>
 struct JacobianHelper<T, OrthographicProjection> {
-  void operator()(const cv::Mat& pts,
-                  const Camera<T, OrthographicProjection>* camera,
-                  cv::Mat* j_proj) {
-    // Access vertex
-    const auto* ptr3d = reinterpret_cast<const Vector3<T>*>(pts.data);
-    const int n3 = std::max(pts.cols, pts.rows) / 3;
-    // Access camera properties
-    const int nc = camera->get_n_parameter();
-    const auto& q = camera->get_rotation();
-    const auto& rot = camera->get_rotation_matrix();
-    const auto& t = camera->get_translation();
-    const T f = camera->get_focal_length();
-    const T* ax = camera->get_axis_inversion();
-    // Fill Jacobian
-    j_proj->create(2 * n3, nc - 1, cv::DataType<T>::type);
-    for (int i = 0; i < n3; i++) {
-      int ix = 2 * i;
-      int iy = ix + 1;
-      // Untransformed vertex
-      auto v = ptr3d[i];
-      v.x_ *= ax[0];
-      v.y_ *= ax[1];
-      v.z_ *= ax[2];
-      // Transformed vertex
-      const auto vx = (rot * v) + t;
-      // Q1 derivative
-      T dvx_dq = T(2.0) * (q.v_.y_ * v.y_ + q.v_.z_ * v.z_);
-      T dvy_dq = T(2.0) * (q.v_.y_ * v.x_ - T(2.0) * q.v_.x_ * v.y_ - q.q_ * v.z_);
-      j_proj->at<T>(ix, 0) = f * dvx_dq;
-      j_proj->at<T>(iy, 0) = f * dvy_dq;
-      // Q2 derivative
-      dvx_dq = T(2.0) * (-T(2.0) * q.v_.y_ * v.x_ + q.v_.x_ * v.y_ + q.q_ * v.z_);
-      dvy_dq = T(2.0) * (q.v_.x_ * v.x_ + q.v_.z_ * v.z_);
-      j_proj->at<T>(ix, 1) = f * dvx_dq;
-      j_proj->at<T>(iy, 1) = f * dvy_dq;
-      // Q3 derivative
-      dvx_dq = T(2.0) * (-T(2.0) * q.v_.z_ * v.x_ - q.q_ * v.y_ + q.v_.x_ * v.z_);
-      dvy_dq = T(2.0) * (q.q_ * v.x_ - T(2.0) * q.v_.z_ * v.y_ + q.v_.y_ * v.z_);
-      j_proj->at<T>(ix, 2) = f * dvx_dq;
-      j_proj->at<T>(iy, 2) = f * dvy_dq;
-      // Tx derivative
-      j_proj->at<T>(ix, 3) = T(1.0);
-      j_proj->at<T>(iy, 3) = T(0.0);
-      // Ty derivative
-      j_proj->at<T>(ix, 4) = T(0.0);
-      j_proj->at<T>(iy, 4) = T(1.0);
-    }
+  /** Number of optimized parameters: rotation + Tx, Ty */
+  static constexpr int kCols = 5;
+
+  /** Jacobian rows of one point, \p v axis inverted, \p vx transformed */
+  static void Row(const Vector3<T>& v,
+                  const Vector3<T>& vx,
+                  const Quaternion<T>& q,
+                  const T f,
+                  T (&jx)[kCols],
+                  T (&jy)[kCols]) {
+    // Q1 derivative
+    T dvx_dq = T(2.0) * (q.v_.y_ * v.y_ + q.v_.z_ * v.z_);
+    T dvy_dq = T(2.0) * (q.v_.y_ * v.x_ - T(2.0) * q.v_.x_ * v.y_ - q.q_ * v.z_);
+    jx[0] = f * dvx_dq;
+    jy[0] = f * dvy_dq;
+    // Q2 derivative
+    dvx_dq = T(2.0) * (-T(2.0) * q.v_.y_ * v.x_ + q.v_.x_ * v.y_ + q.q_ * v.z_);
+    dvy_dq = T(2.0) * (q.v_.x_ * v.x_ + q.v_.z_ * v.z_);
+    jx[1] = f * dvx_dq;
+    jy[1] = f * dvy_dq;
+    // Q3 derivative
+    dvx_dq = T(2.0) * (-T(2.0) * q.v_.z_ * v.x_ - q.q_ * v.y_ + q.v_.x_ * v.z_);
+    dvy_dq = T(2.0) * (q.q_ * v.x_ - T(2.0) * q.v_.z_ * v.y_ + q.v_.y_ * v.z_);
+    jx[2] = f * dvx_dq;
+    jy[2] = f * dvy_dq;
+    // Tx derivative
+    jx[3] = T(1.0);
+    jy[3] = T(0.0);
+    // Ty derivative
+    jx[4] = T(0.0);
+    jy[4] = T(1.0);
+  }
+
+  /** Derivative of the image point w.r.t. the camera space point [2 x 3] */
+  static void Projection(const Vector3<T>& vx, const T f, T (&d)[6]) {
+    d[0] = f;
+    d[1] = T(0.0);
+    d[2] = T(0.0);
+    d[3] = T(0.0);
+    d[4] = f;
+    d[5] = T(0.0);
   }
 };
 
@@ -198,56 +337,50 @@ struct JacobianHelper<T, OrthographicProjection> {
  */
 template<typename T>
 struct JacobianHelper<T, WeakProjection> {
-  void operator()(const cv::Mat& pts,
-                  const Camera<T, WeakProjection>* camera,
-                  cv::Mat* j_proj) {
-    // Access vertex
-    const auto* ptr3d = reinterpret_cast<const Vector3<T>*>(pts.data);
-    const int n3 = std::max(pts.cols, pts.rows) / 3;
-    // Access camera properties
-    const int nc = camera->get_n_parameter();
-    const auto& q = camera->get_rotation();
-    const auto& rot = camera->get_rotation_matrix();
-    const auto& t = camera->get_translation();
-    const T f = camera->get_focal_length();
-    const T* ax = camera->get_axis_inversion();
-    // Fill Jacobian
-    j_proj->create(2 * n3, nc - 1, cv::DataType<T>::type);
-    for (int i = 0; i < n3; i++) {
-      int ix = 2 * i;
-      int iy = ix + 1;
-      // Untransformed vertex
-      auto v = ptr3d[i];
-      v.x_ *= ax[0];
-      v.y_ *= ax[1];
-      v.z_ *= ax[2];
-      // Transformed vertex
-      const auto vx = (rot * v) + t;
-      // f derivative
-      j_proj->at<T>(ix, 0) = vx.x_;
-      j_proj->at<T>(iy, 0) = vx.y_;
-      // Q1 derivative
-      T dvx_dq = T(2.0) * (q.v_.y_ * v.y_ + q.v_.z_ * v.z_);
-      T dvy_dq = T(2.0) * (q.v_.y_ * v.x_ - T(2.0) * q.v_.x_ * v.y_ - q.q_ * v.z_);
-      j_proj->at<T>(ix, 1) = f * dvx_dq;
-      j_proj->at<T>(iy, 1) = f * dvy_dq;
-      // Q2 derivative
-      dvx_dq = T(2.0) * (-T(2.0) * q.v_.y_ * v.x_ + q.v_.x_ * v.y_ + q.q_ * v.z_);
-      dvy_dq = T(2.0) * (q.v_.x_ * v.x_ + q.v_.z_ * v.z_);
-      j_proj->at<T>(ix, 2) = f * dvx_dq;
-      j_proj->at<T>(iy, 2) = f * dvy_dq;
-      // Q3 derivative
-      dvx_dq = T(2.0) * (-T(2.0) * q.v_.z_ * v.x_ - q.q_ * v.y_ + q.v_.x_ * v.z_);
-      dvy_dq = T(2.0) * (q.q_ * v.x_ - T(2.0) * q.v_.z_ * v.y_ + q.v_.y_ * v.z_);
-      j_proj->at<T>(ix, 3) = f * dvx_dq;
-      j_proj->at<T>(iy, 3) = f * dvy_dq;
-      // Tx derivative
-      j_proj->at<T>(ix, 4) = f;
-      j_proj->at<T>(iy, 4) = T(0.0);
-      // Ty derivative
-      j_proj->at<T>(ix, 5) = T(0.0);
-      j_proj->at<T>(iy, 5) = f;
-    }
+  /** Number of optimized parameters: focal + rotation + Tx, Ty */
+  static constexpr int kCols = 6;
+
+  /** Jacobian rows of one point, \p v axis inverted, \p vx transformed */
+  static void Row(const Vector3<T>& v,
+                  const Vector3<T>& vx,
+                  const Quaternion<T>& q,
+                  const T f,
+                  T (&jx)[kCols],
+                  T (&jy)[kCols]) {
+    // f derivative
+    jx[0] = vx.x_;
+    jy[0] = vx.y_;
+    // Q1 derivative
+    T dvx_dq = T(2.0) * (q.v_.y_ * v.y_ + q.v_.z_ * v.z_);
+    T dvy_dq = T(2.0) * (q.v_.y_ * v.x_ - T(2.0) * q.v_.x_ * v.y_ - q.q_ * v.z_);
+    jx[1] = f * dvx_dq;
+    jy[1] = f * dvy_dq;
+    // Q2 derivative
+    dvx_dq = T(2.0) * (-T(2.0) * q.v_.y_ * v.x_ + q.v_.x_ * v.y_ + q.q_ * v.z_);
+    dvy_dq = T(2.0) * (q.v_.x_ * v.x_ + q.v_.z_ * v.z_);
+    jx[2] = f * dvx_dq;
+    jy[2] = f * dvy_dq;
+    // Q3 derivative
+    dvx_dq = T(2.0) * (-T(2.0) * q.v_.z_ * v.x_ - q.q_ * v.y_ + q.v_.x_ * v.z_);
+    dvy_dq = T(2.0) * (q.q_ * v.x_ - T(2.0) * q.v_.z_ * v.y_ + q.v_.y_ * v.z_);
+    jx[3] = f * dvx_dq;
+    jy[3] = f * dvy_dq;
+    // Tx derivative
+    jx[4] = f;
+    jy[4] = T(0.0);
+    // Ty derivative
+    jx[5] = T(0.0);
+    jy[5] = f;
+  }
+
+  /** Derivative of the image point w.r.t. the camera space point [2 x 3] */
+  static void Projection(const Vector3<T>& vx, const T f, T (&d)[6]) {
+    d[0] = f;
+    d[1] = T(0.0);
+    d[2] = T(0.0);
+    d[3] = T(0.0);
+    d[4] = f;
+    d[5] = T(0.0);
   }
 };
 
@@ -259,63 +392,58 @@ struct JacobianHelper<T, WeakProjection> {
  */
 template<typename T>
 struct JacobianHelper<T, PerspectiveProjection> {
-  void operator()(const cv::Mat& pts,
-                  const Camera<T, PerspectiveProjection>* camera,
-                  cv::Mat* j_proj) {
-    // Access vertex
-    const auto* ptr3d = reinterpret_cast<const Vector3<T>*>(pts.data);
-    const int n3 = std::max(pts.cols, pts.rows) / 3;
-    // Access camera properties
-    const int nc = camera->get_n_parameter();
-    const auto& q = camera->get_rotation();
-    const auto& rot = camera->get_rotation_matrix();
-    const auto& t = camera->get_translation();
-    const T f = camera->get_focal_length();
-    const T* ax = camera->get_axis_inversion();
-    // Fill Jacobian
-    j_proj->create(2 * n3, nc, cv::DataType<T>::type);
-    for (int i = 0; i < n3; i++) {
-      int ix = 2 * i;
-      int iy = ix + 1;
-      // Untransformed vertex
-      auto v = ptr3d[i];
-      v.x_ *= ax[0];
-      v.y_ *= ax[1];
-      v.z_ *= ax[2];
-      // Transformed vertex
-      const auto vx = (rot * v) + t;
-      const T ivzz = T(1.0) / (vx.z_ * vx.z_);
-      // f derivative
-      j_proj->at<T>(ix, 0) = vx.x_ / vx.z_;
-      j_proj->at<T>(iy, 0) = vx.y_ / vx.z_;
-      // Q1 derivative
-      T dvx_dq = T(2.0) * (q.v_.y_ * v.y_ + q.v_.z_ * v.z_);
-      T dvy_dq = T(2.0) * (q.v_.y_ * v.x_ - T(2.0) * q.v_.x_ * v.y_ - q.q_ * v.z_);
-      T dvz_dq = T(2.0) * (q.v_.z_ * v.x_ + q.q_ * v.y_  - T(2.0) * q.v_.x_ * v.z_);
-      j_proj->at<T>(ix, 1) = f * (dvx_dq * vx.z_ - vx.x_ * dvz_dq) * ivzz;
-      j_proj->at<T>(iy, 1) = f * (dvy_dq * vx.z_ - vx.y_ * dvz_dq) * ivzz;
-      // Q2 derivative
-      dvx_dq = T(2.0) * (-T(2.0) * q.v_.y_ * v.x_ + q.v_.x_ * v.y_ + q.q_ * v.z_);
-      dvy_dq = T(2.0) * (q.v_.x_ * v.x_ + q.v_.z_ * v.z_);
-      dvz_dq = T(2.0) * (-q.q_ * v.x_ + q.v_.z_ * v.y_ - T(2.0) * q.v_.y_ * v.z_);
-      j_proj->at<T>(ix, 2) = f * (dvx_dq * vx.z_ - vx.x_ * dvz_dq) * ivzz;
-      j_proj->at<T>(iy, 2) = f * (dvy_dq * vx.z_ - vx.y_ * dvz_dq) * ivzz;
-      // Q3 derivative
-      dvx_dq = T(2.0) * (-T(2.0) * q.v_.z_ * v.x_ - q.q_ * v.y_ + q.v_.x_ * v.z_);
-      dvy_dq = T(2.0) * (q.q_ * v.x_ - T(2.0) * q.v_.z_ * v.y_ + q.v_.y_ * v.z_);
-      dvz_dq = T(2.0) * (q.v_.x_ * v.x_ + q.v_.y_ * v.y_);
-      j_proj->at<T>(ix, 3) = f * (dvx_dq * vx.z_ - vx.x_ * dvz_dq) * ivzz;
-      j_proj->at<T>(iy, 3) = f * (dvy_dq * vx.z_ - vx.y_ * dvz_dq) * ivzz;
-      // Tx derivative
-      j_proj->at<T>(ix, 4) = f / vx.z_;
-      j_proj->at<T>(iy, 4) = T(0.0);
-      // Ty derivative
-      j_proj->at<T>(ix, 5) = T(0.0);
-      j_proj->at<T>(iy, 5) = f / vx.z_;
-      // Tz derivative
-      j_proj->at<T>(ix, 6) = -f * (vx.x_ * ivzz);
-      j_proj->at<T>(iy, 6) = -f * (vx.y_ * ivzz);
-    }
+  /** Number of optimized parameters: focal + rotation + T */
+  static constexpr int kCols = 7;
+
+  /** Jacobian rows of one point, \p v axis inverted, \p vx transformed */
+  static void Row(const Vector3<T>& v,
+                  const Vector3<T>& vx,
+                  const Quaternion<T>& q,
+                  const T f,
+                  T (&jx)[kCols],
+                  T (&jy)[kCols]) {
+    const T ivzz = T(1.0) / (vx.z_ * vx.z_);
+    // f derivative
+    jx[0] = vx.x_ / vx.z_;
+    jy[0] = vx.y_ / vx.z_;
+    // Q1 derivative
+    T dvx_dq = T(2.0) * (q.v_.y_ * v.y_ + q.v_.z_ * v.z_);
+    T dvy_dq = T(2.0) * (q.v_.y_ * v.x_ - T(2.0) * q.v_.x_ * v.y_ - q.q_ * v.z_);
+    T dvz_dq = T(2.0) * (q.v_.z_ * v.x_ + q.q_ * v.y_  - T(2.0) * q.v_.x_ * v.z_);
+    jx[1] = f * (dvx_dq * vx.z_ - vx.x_ * dvz_dq) * ivzz;
+    jy[1] = f * (dvy_dq * vx.z_ - vx.y_ * dvz_dq) * ivzz;
+    // Q2 derivative
+    dvx_dq = T(2.0) * (-T(2.0) * q.v_.y_ * v.x_ + q.v_.x_ * v.y_ + q.q_ * v.z_);
+    dvy_dq = T(2.0) * (q.v_.x_ * v.x_ + q.v_.z_ * v.z_);
+    dvz_dq = T(2.0) * (-q.q_ * v.x_ + q.v_.z_ * v.y_ - T(2.0) * q.v_.y_ * v.z_);
+    jx[2] = f * (dvx_dq * vx.z_ - vx.x_ * dvz_dq) * ivzz;
+    jy[2] = f * (dvy_dq * vx.z_ - vx.y_ * dvz_dq) * ivzz;
+    // Q3 derivative
+    dvx_dq = T(2.0) * (-T(2.0) * q.v_.z_ * v.x_ - q.q_ * v.y_ + q.v_.x_ * v.z_);
+    dvy_dq = T(2.0) * (q.q_ * v.x_ - T(2.0) * q.v_.z_ * v.y_ + q.v_.y_ * v.z_);
+    dvz_dq = T(2.0) * (q.v_.x_ * v.x_ + q.v_.y_ * v.y_);
+    jx[3] = f * (dvx_dq * vx.z_ - vx.x_ * dvz_dq) * ivzz;
+    jy[3] = f * (dvy_dq * vx.z_ - vx.y_ * dvz_dq) * ivzz;
+    // Tx derivative
+    jx[4] = f / vx.z_;
+    jy[4] = T(0.0);
+    // Ty derivative
+    jx[5] = T(0.0);
+    jy[5] = f / vx.z_;
+    // Tz derivative
+    jx[6] = -f * (vx.x_ * ivzz);
+    jy[6] = -f * (vx.y_ * ivzz);
+  }
+
+  /** Derivative of the image point w.r.t. the camera space point [2 x 3] */
+  static void Projection(const Vector3<T>& vx, const T f, T (&d)[6]) {
+    const T iz = T(1.0) / vx.z_;
+    d[0] = f * iz;
+    d[1] = T(0.0);
+    d[2] = -f * vx.x_ * iz * iz;
+    d[3] = T(0.0);
+    d[4] = f * iz;
+    d[5] = -f * vx.y_ * iz * iz;
   }
 };
 
@@ -338,83 +466,460 @@ template<typename T, template<typename U> class ProjType>
 int Camera<T, ProjType>::From3Dto2D(const cv::Mat& pts,
                                     const cv::Mat& proj,
                                     const T eps) {
-  using LA = LinearAlgebra<T>;
-  using Solver = typename LinearAlgebra<T>::SquareLinearSolver;
-  using TType = typename LinearAlgebra<T>::TransposeType;
+  FACEKIT_TRACE_SCOPE("Camera::From3Dto2D");
   int err = -1;
   const int N = 100;
+  assert((std::max(proj.rows, proj.cols) / 2) ==
+         (std::max(pts.rows, pts.cols) / 3));
+  // Ensure the object lie in front of the camera while before optimizing.
+  this->PlaceInFront(pts);
+  // Init solver
+  constexpr int kc = JacobianHelper<T, ProjType>::kCols;
+  FitOptions options;   // Squared loss
+  T h[kc * kc];       // Hessian J'J
+  T g[kc];            // Steepest descent J'e
+  T update[kc];       // Parameter update
+  int iter = 0;
+  T res = std::numeric_limits<T>::max();
+  T prev_res = std::numeric_limits<T>::min();
+  while (iter < N && std::abs(res - prev_res) > eps) {
+    // Project, error and Jacobian in a single pass
+    const T cost = this->NormalEquations(pts, proj, options, &h[0], &g[0]);
+    // Compute increment, normal equations J'J are symmetric positive
+    // definite -> Cholesky
+    if (SolveSpd<T, kc>(&h[0], &g[0], &update[0])) {
+      // Push update to camera
+      this->ApplyUpdate(&update[0], kc);
+      // Inc counter
+      ++iter;
+      // Compute residual, cost is half the squared error
+      prev_res = res;
+      res = std::sqrt(T(2.0) * cost);
+    } else {
+      err = -2;
+      break;
+    }
+  }
+  err = (err == -2) ? err : iter == N ? -1 : 0;
+  return err;
+};
+
+/*
+ * @name  From3Dto2D
+ * @fn    int From3Dto2D(const cv::Mat& pts, const cv::Mat& proj,
+                         const FitOptions& options, FitSummary* summary)
+ * @brief Initialize camera transformation (R, T) from a set of matching pairs
+ *        3D-2D with Levenberg-Marquardt and a robust loss
+ * @param[in] pts     List of 3D points [3N x 1] or [1 x 3N]
+ * @param[in] proj    List of corresponding projected points [2N x 1] or
+ *                    [1 x 2N]
+ * @param[in] options Solver options
+ * @param[out] summary  Stopping statistics, can be nullptr
+ * @return    -2 if numerical error, -1 if not converged, 0 otherwise
+ */
+template<typename T, template<typename U> class ProjType>
+int Camera<T, ProjType>::From3Dto2D(const cv::Mat& pts,
+                                    const cv::Mat& proj,
+                                    const FitOptions& options,
+                                    FitSummary* summary) {
+  FACEKIT_TRACE_SCOPE("Camera::From3Dto2D");
   const int n3 = std::max(pts.rows, pts.cols) / 3;
   assert((std::max(proj.rows, proj.cols) / 2) == n3);
-  // Ensure the object lie in front of the camera while before optimizing.
-  T min_z = std::numeric_limits<T>::max();
-  T max_z = -min_z;
-  const auto* ptr3d = reinterpret_cast<Vector3<T>*>(pts.data);
+  FitSummary stat;
+  int err = -1;
+  if (options.warm_start) {
+    // Tracking, start from the current pose with a small budget
+    const Vector3<T> t = t_;
+    const Quaternion<T> rot = rot_;
+    T proj_param[3];
+    p_.ToVector(&proj_param[0]);
+    err = this->Optimize(pts, proj, options, options.warm_max_iter, &stat);
+    const T max_cost = T(0.5) * options.warm_max_rms * options.warm_max_rms *
+                       T(n3);
+    stat.warm_started = true;
+    if (err != -2 && stat.final_cost <= max_cost) {
+      if (summary) {
+        *summary = stat;
+      }
+      return 0;
+    }
+    // Diverged, full initialization from the pose given by the caller
+    t_ = t;
+    rot_ = rot;
+    this->InvalidateRotation();
+    p_.FromVector(&proj_param[0]);
+    const FitSummary warm = stat;
+    stat = FitSummary();
+    stat.warm_started = true;
+    stat.fallback = true;
+    stat.n_iter = warm.n_iter;
+    stat.n_rejected = warm.n_rejected;
+  }
+  this->PlaceInFront(pts);
+  FitSummary cold;
+  err = this->Optimize(pts, proj, options, options.max_iter, &cold);
+  cold.n_iter += stat.n_iter;
+  cold.n_rejected += stat.n_rejected;
+  cold.warm_started = stat.warm_started;
+  cold.fallback = stat.fallback;
+  if (summary) {
+    *summary = cold;
+  }
+  return err;
+}
+
+/*
+ * @name  Optimize
+ * @fn    int Optimize(const cv::Mat& pts, const cv::Mat& proj,
+                       const FitOptions& options, const int& max_iter,
+                       FitSummary* stat)
+ * @brief Levenberg-Marquardt iterations from the current pose
+ * @param[in] pts     List of 3D points [3N x 1] or [1 x 3N]
+ * @param[in] proj    List of corresponding projected points
+ * @param[in] options Solver options
+ * @param[in] max_iter  Maximum number of steps
+ * @param[out] stat   Stopping statistics
+ * @return    -2 if numerical error, -1 if not converged, 0 otherwise
+ */
+template<typename T, template<typename U> class ProjType>
+int Camera<T, ProjType>::Optimize(const cv::Mat& pts,
+                                  const cv::Mat& proj,
+                                  const FitOptions& options,
+                                  const int& max_iter,
+                                  FitSummary* stat) {
+  constexpr int kc = JacobianHelper<T, ProjType>::kCols;
+  T h[kc * kc];
+  T g[kc];
+  T a[kc * kc];       // Damped J'WJ
+  T delta[kc];
+  FitSummary& st = *stat;
+  st = FitSummary();
+  st.lambda = options.lambda;
+  T nu = T(2.0);
+  auto gradient_norm = [&]() {
+    T g_max = T(0.0);
+    for (int i = 0; i < kc; ++i) {
+      g_max = std::max(g_max, std::abs(g[i]));
+    }
+    return g_max;
+  };
+  T cost = this->NormalEquations(pts, proj, options, &h[0], &g[0]);
+  st.initial_cost = cost;
+  st.gradient_norm = gradient_norm();
+  int err = -1;
+  int n_step = 0;
+  while (n_step < max_iter) {
+    // First order optimality
+    if (st.gradient_norm <= options.gradient_tol) {
+      st.termination = kGradientTolerance;
+      err = 0;
+      break;
+    }
+    // Marquardt damping on the diagonal
+    std::copy(&h[0], &h[0] + kc * kc, &a[0]);
+    for (int i = 0; i < kc; ++i) {
+      a[i * kc + i] += st.lambda * std::max(h[i * kc + i],
+                                              options.min_diagonal);
+    }
+    ++n_step;
+    if (!SolveSpd<T, kc>(&a[0], &g[0], &delta[0])) {
+      st.lambda *= nu;
+      nu *= T(2.0);
+      ++st.n_rejected;
+      continue;
+    }
+    // Decrease predicted by the damped model
+    T pred = T(0.0);
+    for (int i = 0; i < kc; ++i) {
+      const T d = st.lambda * std::max(h[i * kc + i], options.min_diagonal);
+      pred += delta[i] * (d * delta[i] + g[i]);
+    }
+    pred *= T(0.5);
+    // Trial step, previous state kept for rollback
+    const Vector3<T> t = t_;
+    const Quaternion<T> rot = rot_;
+    T proj_param[3];
+    p_.ToVector(&proj_param[0]);
+    this->ApplyUpdate(&delta[0], kc);
+    const T new_cost = this->NormalEquations(pts, proj, options,
+                                             nullptr, nullptr);
+    const T rho = (cost - new_cost) / pred;
+    if (pred > T(0.0) && rho > T(0.0) && std::isfinite(new_cost)) {
+      // Accepted, trust the model more
+      const T r = T(2.0) * rho - T(1.0);
+      st.lambda *= std::max(T(1.0) / T(3.0), T(1.0) - r * r * r);
+      nu = T(2.0);
+      ++st.n_iter;
+      const T decrease = cost - new_cost;
+      const T prev_cost = cost;
+      cost = this->NormalEquations(pts, proj, options, &h[0], &g[0]);
+      st.gradient_norm = gradient_norm();
+      if (decrease <= options.cost_tol * prev_cost) {
+        st.termination = kCostTolerance;
+        err = 0;
+        break;
+      }
+    } else {
+      // Rejected, roll back and damp more
+      t_ = t;
+      rot_ = rot;
+      this->InvalidateRotation();
+      p_.FromVector(&proj_param[0]);
+      st.lambda *= nu;
+      nu *= T(2.0);
+      ++st.n_rejected;
+      if (!std::isfinite(st.lambda)) {
+        st.termination = kNumericalError;
+        err = -2;
+        break;
+      }
+    }
+  }
+  st.final_cost = cost;
+  return err;
+}
+
+/*
+ * @name  PlaceInFront
+ * @fn    void PlaceInFront(const cv::Mat& pts)
+ * @brief Move the camera away along z so that the object lies in front of
+ *        it
+ * @param[in] pts     List of 3D points [3N x 1] or [1 x 3N]
+ */
+template<typename T, template<typename U> class ProjType>
+void Camera<T, ProjType>::PlaceInFront(const cv::Mat& pts) {
+  const int n3 = std::max(pts.rows, pts.cols) / 3;
+  T max_z = -std::numeric_limits<T>::max();
+  const auto* ptr3d = reinterpret_cast<const Vector3<T>*>(pts.data);
   for (int i = 0; i < n3; ++i) {
-    const auto& p3d = ptr3d[i];
-    // Minimum 3D
-    min_z = p3d.z_ < min_z ? p3d.z_ : min_z;
-    // Maximum 3D
-    max_z = p3d.z_ > max_z ? p3d.z_ : max_z;
+    max_z = std::max(max_z, ptr3d[i].z_);
   }
-  min_z *= ax_[2];
   max_z *= ax_[2];
   this->t_.z_ = max_z > T(0.0) ? max_z : -max_z;
   this->t_.z_ *= T(2.0);
-  // Init solver
-  const int nc = this->get_n_parameter();
+}
+
+/*
+ * @name  NormalEquations
+ * @fn    T NormalEquations(const cv::Mat& pts, const cv::Mat& proj,
+                            const FitOptions& options, T* h, T* g) const
+ * @brief Project every point and accumulate the robustly weighted normal
+ *        equations J'WJ and J'We in a single pass, without storing the
+ *        Jacobian
+ * @param[in] pts     List of 3D points [3N x 1] or [1 x 3N]
+ * @param[in] proj    Target projections [2N x 1] or [1 x 2N]
+ * @param[in] options Loss function
+ * @param[out] h      J'WJ [kCols x kCols], skipped if nullptr
+ * @param[out] g      J'We [kCols], skipped if nullptr
+ * @return    Cost, half the sum of the robust loss of each point
+ */
+template<typename T, template<typename U> class ProjType>
+T Camera<T, ProjType>::NormalEquations(const cv::Mat& pts,
+                                       const cv::Mat& proj,
+                                       const FitOptions& options,
+                                       T* h,
+                                       T* g) const {
+  using Helper = JacobianHelper<T, ProjType>;
+  constexpr int kc = Helper::kCols;
+  const int n3 = std::max(pts.rows, pts.cols) / 3;
+  const Matrix3<T>& rotm = this->RotationMatrix();
+  const auto* ptr3d = reinterpret_cast<const Vector3<T>*>(pts.data);
+  const auto* ptr2d = reinterpret_cast<const T*>(proj.data);
+  const T f = this->get_focal_length();
+  const T k2 = options.loss_scale * options.loss_scale;
+  if (h) {
+    std::fill(h, h + kc * kc, T(0.0));
+    std::fill(g, g + kc, T(0.0));
+  }
+  T cost = T(0.0);
+  for (int i = 0; i < n3; ++i) {
+    auto v = ptr3d[i];
+    v.x_ *= ax_[0];
+    v.y_ *= ax_[1];
+    v.z_ *= ax_[2];
+    const auto vx = (rotm * v) + t_;
+    Point2 pt;
+    p_(vx, &pt);
+    const T ex = ptr2d[2 * i] - pt.x_;
+    const T ey = ptr2d[2 * i + 1] - pt.y_;
+    // Robust loss rho(s) of the squared error and its derivative as weight
+    const T sq = ex * ex + ey * ey;
+    T w = T(1.0);
+    switch (options.loss) {
+      case kHuberLoss:
+        if (sq > k2) {
+          const T r = std::sqrt(sq);
+          w = options.loss_scale / r;
+          cost += T(2.0) * options.loss_scale * r - k2;
+        } else {
+          cost += sq;
+        }
+        break;
+      case kCauchyLoss:
+        w = T(1.0) / (T(1.0) + sq / k2);
+        cost += k2 * std::log1p(sq / k2);
+        break;
+      default:
+        cost += sq;
+        break;
+    }
+    if (h == nullptr) {
+      continue;
+    }
+    // Jacobian rows straight into the upper part of J'WJ
+    T jx[kc];
+    T jy[kc];
+    Helper::Row(v, vx, rot_, f, jx, jy);
+    AccumulateRows<T, kc>(&jx[0], &jy[0], w, ex, ey, h, g);
+  }
+  if (h) {
+    SymmetrizeUpper<T, kc>(h);
+  }
+  return T(0.5) * cost;
+}
+
+/*
+ * @name  ApplyUpdate
+ * @fn    void ApplyUpdate(const T* delta, const int& n)
+ * @brief Apply a parameter increment [f] q1 q2 q3 tx ty [tz], the rotation
+ *        increment is composed with the current rotation
+ * @param[in] delta   Increment
+ * @param[in] n       Number of optimized parameters
+ */
+template<typename T, template<typename U> class ProjType>
+void Camera<T, ProjType>::ApplyUpdate(const T* delta, const int& n) {
   const int idx_q_update = this->p_.get_n_parameter() == 1 ? 1 : 0;
   T p_cam[10];
-  cv::Mat j_proj;
-  cv::Mat err_proj;   // Projection error
-  cv::Mat curr_proj;  // Current projection (2d pts)
-  cv::Mat hessian;    // Hessian
-  cv::Mat sd;
-  cv::Mat update;     // Parameter update
+  auto dq = *(reinterpret_cast<const Quaternion<T>*>(&delta[idx_q_update]));
+  dq.q_ = T(1.0);
+  dq.Normalize();
+  auto &q = reinterpret_cast<Quaternion<T>*>(&p_cam[3])[0];
+  p_cam[0] = idx_q_update == 1 ? this->get_focal_length() + delta[0] :
+                                 this->get_focal_length();
+  p_cam[1] = p_.get_principal_point_x();
+  p_cam[2] = p_.get_principal_point_y();
+  q = dq * rot_;
+  p_cam[7] = this->t_.x_ + delta[idx_q_update + 3];
+  p_cam[8] = this->t_.y_ + delta[idx_q_update + 4];
+  p_cam[9] = n == this->get_n_parameter() ?
+             this->t_.z_ + delta[idx_q_update + 5] :
+             this->t_.z_;
+  this->FromVector(&p_cam[0]);
+}
+
+/*
+ * @name  FitShape
+ * @fn    int FitShape(const PCAModel<T>& model,
+                       const typename PCAModel<T>::Subset& landmarks,
+                       const cv::Mat& proj, const T eta, const T eps,
+                       cv::Mat* p)
+ * @brief Jointly estimate the camera and the shape coefficients \p p from
+ *        2D landmarks with Gauss-Newton
+ * @param[in] model       Shape model, provides the prior
+ * @param[in] landmarks   Landmark sub-model, see `PCAModel::BuildSubset`
+ * @param[in] proj        Landmark positions [2N x 1]
+ * @param[in] eta         Weight of the coefficients' regularization
+ * @param[in] eps         Stopping criterion
+ * @param[in,out] p       Shape coefficients, initial guess [k x 1]
+ * @return    -2 if numerical error, -1 if not converged, 0 otherwise
+ */
+template<typename T, template<typename U> class ProjType>
+int Camera<T, ProjType>::FitShape(const PCAModel<T>& model,
+                                  const typename PCAModel<T>::Subset& landmarks,
+                                  const cv::Mat& proj,
+                                  const T eta,
+                                  const T eps,
+                                  cv::Mat* p) {
+  FACEKIT_TRACE_SCOPE("Camera::FitShape");
+  // Temporaries of the iterations come from the pool
+  ScopedCvAllocator pool(CvAllocator::Pooled());
+  using LA = LinearAlgebra<T>;
+  using Solver = typename LinearAlgebra<T>::CholeskySolver;
+  using TType = typename LinearAlgebra<T>::TransposeType;
+  const int type = cv::DataType<T>::type;
+  const cv::Mat& basis = landmarks.variation;
+  const int n3 = landmarks.mean.rows / 3;
+  assert(model.get_n_channels() == 3);
+  assert((std::max(proj.rows, proj.cols) / 2) == n3);
+  if (p->empty()) {
+    p->create(basis.cols, 1, type);
+    p->setTo(T(0.0));
+  }
+  const int k = static_cast<int>(p->total());
+  assert(p->isContinuous() && k <= basis.cols);
+  T* coef = reinterpret_cast<T*>(p->data);
+  const T* prior = reinterpret_cast<const T*>(model.get_prior().data);
+  const T* mean = reinterpret_cast<const T*>(landmarks.mean.data);
+  // Init solver
+  constexpr int kc = JacobianHelper<T, ProjType>::kCols;
+  int err = -1;
+  const int N = 100;
+  std::vector<T> w(k);
+  cv::Mat pts(3 * n3, 1, type);  // Current landmarks
+  cv::Mat j_shape;
+  cv::Mat err_proj;
+  T h_cc[kc * kc];               // Camera block of J'J, fixed size
+  T sd_c[kc];                    // Camera block of J'e
+  std::vector<T> h_cs(kc * k);   // Camera / shape block of J'J
+  cv::Mat h_ss, sd_s;
+  const int n_param = kc + k;
+  cv::Mat hessian(n_param, n_param, type);
+  cv::Mat sd(n_param, 1, type);
+  cv::Mat update;
   int iter = 0;
-  static Solver solver;
+  Solver solver;
   T res = std::numeric_limits<T>::max();
   T prev_res = std::numeric_limits<T>::min();
-  const T cx = p_.get_principal_point_x();
-  const T cy = p_.get_principal_point_y();
-  // Helper functor for Jacobian computation
-  JacobianHelper<T, ProjType> jhelper;
   while (iter < N && std::abs(res - prev_res) > eps) {
-    // Updated focal
-    const T f = this->get_focal_length();
-    // Project
-    this->operator()(pts, &curr_proj);
-    // Compute err
-    err_proj = proj - curr_proj;
-    // Fill jacobian focal + rotation + T
-    jhelper(pts, this, &j_proj);
-    // Compute Hessian + Sd
-    LA::Gemm(j_proj, TType::kTranspose, T(1.0),
-             j_proj, TType::kNoTranspose, T(0.0), &hessian);
-    LA::Gemv(j_proj, TType::kTranspose, T(1.0), err_proj, T(0.0), &sd);
+    // Landmarks for the current coefficients: mean + V * (prior .* p)
+    for (int j = 0; j < k; ++j) {
+      w[j] = prior[j] * coef[j];
+    }
+    T* dst = reinterpret_cast<T*>(pts.data);
+    for (int r = 0; r < 3 * n3; ++r) {
+      const T* v = basis.ptr<T>(r);
+      T acc = mean[r];
+      for (int j = 0; j < k; ++j) {
+        acc += v[j] * w[j];
+      }
+      dst[r] = acc;
+    }
+    // Project, error and both Jacobian blocks in a single pass
+    const T sq = this->ShapeJacobian(basis, prior, pts, proj, k, &h_cc[0],
+                                     &sd_c[0], h_cs.data(), &j_shape,
+                                     &err_proj);
+    // Shape block, [Jc Js] is never formed
+    LA::Gemm(j_shape, TType::kTranspose, T(1.0),
+             j_shape, TType::kNoTranspose, T(0.0), &h_ss);
+    LA::Gemv(j_shape, TType::kTranspose, T(1.0), err_proj, T(0.0), &sd_s);
+    for (int a = 0; a < kc; ++a) {
+      T* row = hessian.ptr<T>(a);
+      std::copy(&h_cc[a * kc], &h_cc[a * kc] + kc, row);
+      std::copy(&h_cs[a * k], &h_cs[a * k] + k, row + kc);
+      for (int j = 0; j < k; ++j) {
+        hessian.at<T>(kc + j, a) = h_cs[a * k + j];
+      }
+      sd.at<T>(a) = sd_c[a];
+    }
+    h_ss.copyTo(hessian(cv::Rect(kc, kc, k, k)));
+    for (int j = 0; j < k; ++j) {
+      hessian.at<T>(kc + j, kc + j) += eta;
+      sd.at<T>(kc + j) = sd_s.at<T>(j) - eta * coef[j];
+    }
     // Compute increment
     solver.Solve(hessian, sd, &update);
     if (!update.empty()) {
       // update camera
-      auto dq = *(update.ptr<const Quaternion<T>>(idx_q_update));
-      dq.q_ = T(1.0);
-      dq.Normalize();
-      auto &q = reinterpret_cast<Quaternion<T>*>(&p_cam[3])[0];
-      p_cam[0] = idx_q_update == 1 ? f + update.at<T>(0) : f;
-      p_cam[1] = cx;
-      p_cam[2] = cy;
-      q = dq * rot_;
-      p_cam[7] = this->t_.x_ + update.at<T>(idx_q_update + 3);
-      p_cam[8] = this->t_.y_ + update.at<T>(idx_q_update + 4);
-      p_cam[9] = update.rows == nc ?
-                 this->t_.z_ + update.at<T>(idx_q_update + 5) :
-                 this->t_.z_;
-      // Push update to camera
-      this->FromVector(&p_cam[0]);
+      this->ApplyUpdate(reinterpret_cast<const T*>(update.data), kc);
+      // update shape
+      for (int j = 0; j < k; ++j) {
+        coef[j] += update.at<T>(kc + j);
+      }
       // Inc counter
       ++iter;
       // Compute residual
       prev_res = res;
-      res = LA::L2Norm(err_proj);
+      res = std::sqrt(sq);
     } else {
       err = -2;
       break;
@@ -422,7 +927,201 @@ int Camera<T, ProjType>::From3Dto2D(const cv::Mat& pts,
   }
   err = (err == -2) ? err : iter == N ? -1 : 0;
   return err;
-};
+}
+
+/*
+ * @name  EliminateCamera
+ * @fn    int EliminateCamera(const cv::Mat& basis, const T* prior,
+                              const cv::Mat& pts, const cv::Mat& proj,
+                              const int& k, ShapeBlock* block) const
+ * @brief Gauss-Newton normal equations of this view for a shape shared with
+ *        other views, the camera parameters are eliminated with the Schur
+ *        complement of their block
+ * @param[in] basis   Landmark sub-basis [3N x K], K >= k
+ * @param[in] prior   Prior of each component
+ * @param[in] pts     Current landmarks [3N x 1]
+ * @param[in] proj    Landmark positions in this view [2N x 1]
+ * @param[in] k       Number of optimized coefficients
+ * @param[out] block  Reduced system of this view
+ * @return    -2 if the camera block is singular, 0 otherwise
+ */
+template<typename T, template<typename U> class ProjType>
+int Camera<T, ProjType>::EliminateCamera(const cv::Mat& basis,
+                                         const T* prior,
+                                         const cv::Mat& pts,
+                                         const cv::Mat& proj,
+                                         const int& k,
+                                         ShapeBlock* block) const {
+  using LA = LinearAlgebra<T>;
+  using TType = typename LinearAlgebra<T>::TransposeType;
+  constexpr int kc = JacobianHelper<T, ProjType>::kCols;
+  const int type = cv::DataType<T>::type;
+  T h_cc[kc * kc];
+  T g_c[kc];
+  block->h_cs.create(kc, k, type);
+  T* h_cs = reinterpret_cast<T*>(block->h_cs.data);
+  block->sq_error = this->ShapeJacobian(basis, prior, pts, proj, k, &h_cc[0],
+                                        &g_c[0], h_cs, &block->j_shape,
+                                        &block->err);
+  // Camera block is tiny, factorize it in registers
+  T l[kc * kc];
+  if (!FactorSpd<T, kc>(&h_cc[0], &l[0])) {
+    return -2;
+  }
+  // W = H_cc^-1 H_cs, column by column, and w_g = H_cc^-1 J_c'e
+  block->w.create(kc, k, type);
+  block->w_g.create(kc, 1, type);
+  T* w = reinterpret_cast<T*>(block->w.data);
+  for (int j = 0; j < k; ++j) {
+    T b[kc];
+    for (int a = 0; a < kc; ++a) {
+      b[a] = h_cs[a * k + j];
+    }
+    SolveFactoredSpd<T, kc>(&l[0], &b[0], &b[0]);
+    for (int a = 0; a < kc; ++a) {
+      w[a * k + j] = b[a];
+    }
+  }
+  SolveFactoredSpd<T, kc>(&l[0], &g_c[0],
+                          reinterpret_cast<T*>(block->w_g.data));
+  // S = J_s'J_s - H_cs' W, r = J_s'e - H_cs' w_g
+  LA::Gemm(block->j_shape, TType::kTranspose, T(1.0),
+           block->j_shape, TType::kNoTranspose, T(0.0), &block->s);
+  LA::Gemm(block->h_cs, TType::kTranspose, T(-1.0),
+           block->w, TType::kNoTranspose, T(1.0), &block->s);
+  LA::Gemv(block->j_shape, TType::kTranspose, T(1.0), block->err,
+           T(0.0), &block->r);
+  LA::Gemv(block->h_cs, TType::kTranspose, T(-1.0), block->w_g,
+           T(1.0), &block->r);
+  return 0;
+}
+
+/*
+ * @name  BackSubstitute
+ * @fn    void BackSubstitute(const ShapeBlock& block, const T* dp)
+ * @brief Recover and apply the camera increment of this view once the
+ *        shared shape increment is known: dc = w_g - W * dp
+ * @param[in] block   Reduced system computed by `EliminateCamera`
+ * @param[in] dp      Shape coefficients increment [k]
+ */
+template<typename T, template<typename U> class ProjType>
+void Camera<T, ProjType>::BackSubstitute(const ShapeBlock& block,
+                                         const T* dp) {
+  constexpr int kc = JacobianHelper<T, ProjType>::kCols;
+  const int k = block.w.cols;
+  const T* w = reinterpret_cast<const T*>(block.w.data);
+  const T* w_g = reinterpret_cast<const T*>(block.w_g.data);
+  T dc[kc];
+  for (int a = 0; a < kc; ++a) {
+    T acc = w_g[a];
+    for (int j = 0; j < k; ++j) {
+      acc -= w[a * k + j] * dp[j];
+    }
+    dc[a] = acc;
+  }
+  this->ApplyUpdate(&dc[0], kc);
+}
+
+/*
+ * @name  ShapeJacobian
+ * @fn    T ShapeJacobian(const cv::Mat& basis, const T* prior,
+                          const cv::Mat& pts, const cv::Mat& proj,
+                          const int& k, T* h_cc, T* g_c, T* h_cs,
+                          cv::Mat* j_shape, cv::Mat* err) const
+ * @brief Project the landmarks, compute their error and both Jacobian blocks
+ *        in a single pass. The camera block goes straight into its normal
+ *        equations, the shape block is dProj/dX * R * diag(ax) * V_i *
+ *        diag(prior).
+ * @param[in] basis     Landmark sub-basis [3N x K], K >= k
+ * @param[in] prior     Prior of each component
+ * @param[in] pts       Current landmarks [3N x 1]
+ * @param[in] proj      Target landmark positions [2N x 1]
+ * @param[in] k         Number of optimized coefficients
+ * @param[out] h_cc     J_c'J_c [kCols x kCols]
+ * @param[out] g_c      J_c'e [kCols]
+ * @param[out] h_cs     J_c'J_s [kCols x k]
+ * @param[out] j_shape  J_s [2N x k]
+ * @param[out] err      Residual e [2N x 1]
+ * @return    Sum of the squared error
+ */
+template<typename T, template<typename U> class ProjType>
+T Camera<T, ProjType>::ShapeJacobian(const cv::Mat& basis,
+                                     const T* prior,
+                                     const cv::Mat& pts,
+                                     const cv::Mat& proj,
+                                     const int& k,
+                                     T* h_cc,
+                                     T* g_c,
+                                     T* h_cs,
+                                     cv::Mat* j_shape,
+                                     cv::Mat* err) const {
+  using Helper = JacobianHelper<T, ProjType>;
+  constexpr int kc = Helper::kCols;
+  const int type = cv::DataType<T>::type;
+  const int n3 = static_cast<int>(pts.total()) / 3;
+  const T f = this->get_focal_length();
+  const T* target = reinterpret_cast<const T*>(proj.data);
+  j_shape->create(2 * n3, k, type);
+  err->create(2 * n3, 1, type);
+  std::fill(h_cc, h_cc + kc * kc, T(0.0));
+  std::fill(g_c, g_c + kc, T(0.0));
+  std::fill(h_cs, h_cs + kc * k, T(0.0));
+  T* e = reinterpret_cast<T*>(err->data);
+  T sq = T(0.0);
+  const Matrix3<T>& rotm = this->RotationMatrix();
+  const Vector3<T> rc[3] = {rotm * Vector3<T>(ax_[0], T(0.0), T(0.0)),
+                            rotm * Vector3<T>(T(0.0), ax_[1], T(0.0)),
+                            rotm * Vector3<T>(T(0.0), T(0.0), ax_[2])};
+  const auto* ptr3d = reinterpret_cast<const Vector3<T>*>(pts.data);
+  for (int i = 0; i < n3; ++i) {
+    auto v = ptr3d[i];
+    v.x_ *= ax_[0];
+    v.y_ *= ax_[1];
+    v.z_ *= ax_[2];
+    const auto vx = (rotm * v) + t_;
+    Point2 pt;
+    p_(vx, &pt);
+    const T ex = target[2 * i] - pt.x_;
+    const T ey = target[2 * i + 1] - pt.y_;
+    e[2 * i] = ex;
+    e[2 * i + 1] = ey;
+    sq += ex * ex + ey * ey;
+    // Camera rows
+    T jcx[kc];
+    T jcy[kc];
+    Helper::Row(v, vx, rot_, f, jcx, jcy);
+    AccumulateRows<T, kc>(&jcx[0], &jcy[0], T(1.0), ex, ey, h_cc, g_c);
+    // Shape rows
+    T d[6];
+    Helper::Projection(vx, f, d);
+    T m[6];
+    for (int r = 0; r < 2; ++r) {
+      for (int c = 0; c < 3; ++c) {
+        m[3 * r + c] = (d[3 * r] * rc[c].x_ +
+                        d[3 * r + 1] * rc[c].y_ +
+                        d[3 * r + 2] * rc[c].z_);
+      }
+    }
+    const T* v0 = basis.ptr<T>(3 * i);
+    const T* v1 = basis.ptr<T>(3 * i + 1);
+    const T* v2 = basis.ptr<T>(3 * i + 2);
+    T* jx = j_shape->ptr<T>(2 * i);
+    T* jy = j_shape->ptr<T>(2 * i + 1);
+    for (int j = 0; j < k; ++j) {
+      jx[j] = prior[j] * (m[0] * v0[j] + m[1] * v1[j] + m[2] * v2[j]);
+      jy[j] = prior[j] * (m[3] * v0[j] + m[4] * v1[j] + m[5] * v2[j]);
+    }
+    // Cross block
+    for (int a = 0; a < kc; ++a) {
+      T* hcs = &h_cs[a * k];
+      for (int j = 0; j < k; ++j) {
+        hcs[j] += jcx[a] * jx[j] + jcy[a] * jy[j];
+      }
+    }
+  }
+  SymmetrizeUpper<T, kc>(h_cc);
+  return sq;
+}
 
 
 #pragma mark -
@@ -445,7 +1144,7 @@ void Camera<T, ProjType>::operator()(const Point3& pts,
   q.x_ *= ax_[0];
   q.y_ *= ax_[1];
   q.z_ *= ax_[2];
-  q = (rotm_ * q) + t_;
+  q = (this->RotationMatrix() * q) + t_;
   // Projection
   p_(q, proj);
 }
@@ -464,7 +1163,6 @@ void Camera<T, ProjType>::operator()(const std::vector<Point3>& pts,
                                      std::vector<Point2>* proj) const {
   // Init
   proj->resize(pts.size());
-  std::vector<Point3> ps(pts.size());
   cv::Mat pts3(int(pts.size() * 3),
                1,
                cv::DataType<T>::type,
@@ -488,20 +1186,63 @@ void Camera<T, ProjType>::operator()(const std::vector<Point3>& pts,
 template<typename T, template<typename U> class ProjType>
 void Camera<T, ProjType>::operator()(const cv::Mat& pts,
                                      cv::Mat* proj) const {
+  this->operator()(pts, proj, nullptr);
+}
+
+/*
+ * @name  operator()
+ * @fn    void operator()(const cv::Mat& pts, cv::Mat* proj,
+                          cv::Mat* depth) const
+ * @brief Project a list of \p pts with complete transformation and keep
+ *        their depth in the camera's reference frame
+ * @param[in] pts     3D Points to project [3N x 1] or [1 x 3N]
+ * @param[out] proj   Projected 2D points [2N x 1]
+ * @param[out] depth  Depth of each point [N x 1], skipped if nullptr
+ */
+template<typename T, template<typename U> class ProjType>
+void Camera<T, ProjType>::operator()(const cv::Mat& pts,
+                                     cv::Mat* proj,
+                                     cv::Mat* depth) const {
   // Init
   assert(pts.rows % 3 == 0 || pts.cols % 3 == 0);
   const int n = std::max(pts.cols, pts.rows) / 3;
   proj->create(2 * n, 1, cv::DataType<T>::type);
-  const auto* src = reinterpret_cast<const Point3*>(pts.data);
-  auto* dst = reinterpret_cast<Point2*>(proj->data);
-  for (int i = 0; i < n; ++i) {
-    auto v = src[i];
-    v.x_ *= ax_[0];
-    v.y_ *= ax_[1];
-    v.z_ *= ax_[2];
-    const auto vx = (rotm_ * v) + t_;
-    p_(vx, &dst[i]);
+  const auto* src = reinterpret_cast<const T*>(pts.data);
+  auto* dst = reinterpret_cast<T*>(proj->data);
+  T* zdst = nullptr;
+  if (depth) {
+    depth->create(n, 1, cv::DataType<T>::type);
+    zdst = reinterpret_cast<T*>(depth->data);
   }
+  // Fold axis inversion into the rotation: R * diag(ax)
+  const T* r = this->RotationMatrix().data();
+  const T rs[9] = {r[0] * ax_[0], r[1] * ax_[0], r[2] * ax_[0],
+                   r[3] * ax_[1], r[4] * ax_[1], r[5] * ax_[1],
+                   r[6] * ax_[2], r[7] * ax_[2], r[8] * ax_[2]};
+  const T t[3] = {t_.x_, t_.y_, t_.z_};
+  ThreadPool::Get().ParallelFor(0,
+                                static_cast<size_t>(n),
+                                kProjectionGrain,
+                                [&](const size_t& first, const size_t& last) {
+    // Block-wise: transpose to SoA, transform, project straight into `proj`
+    alignas(64) T x[kProjectionBlock];
+    alignas(64) T y[kProjectionBlock];
+    alignas(64) T z[kProjectionBlock];
+    for (size_t b = first; b < last; b += kProjectionBlock) {
+      const size_t nb = std::min(kProjectionBlock, last - b);
+      const T* in = src + 3 * b;
+      for (size_t i = 0; i < nb; ++i) {
+        x[i] = in[3 * i];
+        y[i] = in[3 * i + 1];
+        z[i] = in[3 * i + 2];
+      }
+      TransformPointsSoa(&rs[0], &t[0], x, y, z, x, y, z, nb);
+      p_(x, y, z, nb, dst + 2 * b);
+      if (zdst) {
+        std::copy(z, z + nb, zdst + b);
+      }
+    }
+  });
 }
 
 #pragma mark -
@@ -515,18 +1256,19 @@ void Camera<T, ProjType>::operator()(const cv::Mat& pts,
  */
 template<typename T, template<typename U> class ProjType>
 Matrix4<T> Camera<T, ProjType>::get_view_transform(void) const {
+  const Matrix3<T>& rotm = this->RotationMatrix();
   Matrix4<T> n_mat;
-  n_mat[0] = rotm_[0];
-  n_mat[4] = rotm_[3];
-  n_mat[8] = rotm_[6];
+  n_mat[0] = rotm[0];
+  n_mat[4] = rotm[3];
+  n_mat[8] = rotm[6];
   n_mat[12] = t_.x_;
-  n_mat[1] = rotm_[1];
-  n_mat[5] = rotm_[4];
-  n_mat[9] = rotm_[7];
+  n_mat[1] = rotm[1];
+  n_mat[5] = rotm[4];
+  n_mat[9] = rotm[7];
   n_mat[13] = t_.y_;
-  n_mat[2] = rotm_[2];
-  n_mat[6] = rotm_[5];
-  n_mat[10] = rotm_[8];
+  n_mat[2] = rotm[2];
+  n_mat[6] = rotm[5];
+  n_mat[10] = rotm[8];
   n_mat[14] = t_.z_;
   return n_mat;
 }
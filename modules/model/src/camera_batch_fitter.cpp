@@ -0,0 +1,101 @@
+/**
+ *  @file   camera_batch_fitter.cpp
+ *  @brief  Fit many cameras at once (i.e. every face of a frame)
+ *  @ingroup    model
+ *
+ *  @author Christophe Ecabert
+ *  @date   02.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/trace.hpp"
+#include "facekit/model/camera_batch_fitter.hpp"
+#include "facekit/model/orthographic_projection.hpp"
+#include "facekit/model/perspective_projection.hpp"
+#include "facekit/model/weak_projection.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Number of problems fitted by one parallel task, a landmark fit is a few
+    tens of microseconds */
+static constexpr size_t kFitGrain = 4;
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ * @name  Fit
+ * @fn    Status Fit(const std::vector<Problem>& problems,
+                     std::vector<int>* status,
+                     std::vector<FitSummary>* summary) const
+ * @brief Fit every camera concurrently
+ * @param[in] problems    Problems, cameras must be distinct
+ * @param[out] status     Per problem result of `Camera::From3Dto2D`
+ * @param[out] summary    Per problem statistics, can be nullptr
+ * @return    kInvalidArgument if a problem is malformed
+ */
+template<typename T, template<typename U> class ProjType>
+Status CameraBatchFitter<T, ProjType>::Fit(const std::vector<Problem>& problems,
+                                           std::vector<int>* status,
+                                           std::vector<FitSummary>* summary)
+                                           const {
+  FACEKIT_TRACE_SCOPE("CameraBatchFitter::Fit");
+  const int type = cv::DataType<T>::type;
+  for (const auto& p : problems) {
+    const int n3 = static_cast<int>(p.pts.total()) / 3;
+    if (p.camera == nullptr || p.pts.type() != type ||
+        p.proj.type() != type || !p.pts.isContinuous() ||
+        !p.proj.isContinuous() || p.pts.total() != size_t(3 * n3) ||
+        p.proj.total() != size_t(2 * n3)) {
+      return Status(Status::Type::kInvalidArgument,
+                    "Problem must hold 3N points, 2N projections of the "
+                    "camera's type and a camera");
+    }
+  }
+  status->assign(problems.size(), -1);
+  std::vector<FitSummary> stats(summary ? problems.size() : 0);
+  ThreadPool::Get().ParallelFor(0,
+                                problems.size(),
+                                kFitGrain,
+                                [&](const size_t& first, const size_t& last) {
+    FitSummary dummy;
+    for (size_t i = first; i < last; ++i) {
+      const auto& p = problems[i];
+      (*status)[i] = p.camera->From3Dto2D(p.pts,
+                                          p.proj,
+                                          options_,
+                                          summary ? &stats[i] : &dummy);
+    }
+  });
+  if (summary) {
+    summary->swap(stats);
+  }
+  return Status();
+}
+
+#pragma mark -
+#pragma mark Explicit Instantiation
+
+/** Float - Ortho */
+template class CameraBatchFitter<float, OrthographicProjection>;
+/** Double - Ortho */
+template class CameraBatchFitter<double, OrthographicProjection>;
+
+/** Float - Weak */
+template class CameraBatchFitter<float, WeakProjection>;
+/** Double - Weak */
+template class CameraBatchFitter<double, WeakProjection>;
+
+/** Float - Perspective */
+template class CameraBatchFitter<float, PerspectiveProjection>;
+/** Double - Perspective */
+template class CameraBatchFitter<double, PerspectiveProjection>;
+
+}  // namespace FaceKit
@@ -0,0 +1,177 @@
+/**
+ *  @file   combined_pca_model.cpp
+ *  @brief  Evaluate several PCA models (i.e. identity and expression) in a
+ *          single pass
+ *  @ingroup model
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <utility>
+
+#include "facekit/core/math/linear_algebra.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/trace.hpp"
+#include "facekit/model/combined_pca_model.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Number of basis rows gathered by one parallel task */
+static constexpr size_t kCombineGrain = 1024;
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ * @name  Build
+ * @fn    Status Build(const std::vector<const PCAModel<T>*>& models)
+ * @brief Combine \p models, they must all be loaded and generate
+ *        instances of the same dimension
+ * @param[in] models  Models to combine, in coefficient order
+ * @return    kInvalidArgument if a model is missing, empty or of another
+ *            dimension
+ */
+template<typename T>
+Status
+CombinedPCAModel<T>::Build(const std::vector<const PCAModel<T>*>& models) {
+  if (models.empty()) {
+    return Status(Status::Type::kInvalidArgument, "No model to combine");
+  }
+  const int type = cv::DataType<T>::type;
+  const size_t dim = models[0] ? models[0]->get_mean().total() : 0;
+  std::vector<int> offset(1, 0);
+  for (const auto* m : models) {
+    if (m == nullptr || m->get_mean().empty()) {
+      return Status(Status::Type::kInvalidArgument,
+                    "Models must be loaded");
+    }
+    const cv::Mat& mean = m->get_mean();
+    const cv::Mat& var = m->get_variation();
+    const cv::Mat& prior = m->get_prior();
+    if (mean.type() != type || var.type() != type || prior.type() != type ||
+        !mean.isContinuous() || !var.isContinuous() ||
+        !prior.isContinuous()) {
+      return Status(Status::Type::kInvalidArgument,
+                    "Models must be continuous and of the combination's type");
+    }
+    if (mean.total() != dim || static_cast<size_t>(var.rows) != dim ||
+        prior.total() != static_cast<size_t>(var.cols)) {
+      return Status(Status::Type::kInvalidArgument,
+                    "Models must generate instances of the same dimension");
+    }
+    offset.push_back(offset.back() + var.cols);
+  }
+  // Summed means and concatenated, prescaled, bases
+  const int n_row = static_cast<int>(dim);
+  mean_.create(n_row, 1, type);
+  basis_.create(n_row, offset.back(), type);
+  ThreadPool::Get().ParallelFor(0,
+                                dim,
+                                kCombineGrain,
+                                [&](const size_t& first, const size_t& last) {
+    T* mean = reinterpret_cast<T*>(mean_.data);
+    std::fill(mean + first, mean + last, T(0.0));
+    for (size_t i = 0; i < models.size(); ++i) {
+      const cv::Mat& var = models[i]->get_variation();
+      const T* src_m = reinterpret_cast<const T*>(models[i]->get_mean().data);
+      const T* prior = reinterpret_cast<const T*>(models[i]->get_prior().data);
+      for (size_t r = first; r < last; ++r) {
+        const T* src = reinterpret_cast<const T*>(var.data) + r * var.cols;
+        T* dst = reinterpret_cast<T*>(basis_.data) + r * basis_.cols +
+                 offset[i];
+        for (int c = 0; c < var.cols; ++c) {
+          dst[c] = src[c] * prior[c];
+        }
+        mean[r] += src_m[r];
+      }
+    }
+  });
+  offset_ = std::move(offset);
+  return Status();
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ * @name  Generate
+ * @fn    Status Generate(const cv::Mat& p, T* instance) const
+ * @brief Generate the sum of the models' instances, reentrant
+ * @param[in] p           Concatenated coefficients [k x 1] or [1 x k]
+ * @param[out] instance   Generated instance [dim]
+ * @return    kInvalidArgument if \p p does not match the combination
+ */
+template<typename T>
+Status CombinedPCAModel<T>::Generate(const cv::Mat& p, T* instance) const {
+  FACEKIT_TRACE_SCOPE("CombinedPCAModel::Generate");
+  using LA = typename FaceKit::LinearAlgebra<T>;
+  using TType = typename FaceKit::LinearAlgebra<T>::TransposeType;
+  if (basis_.empty() || p.type() != cv::DataType<T>::type ||
+      p.total() != static_cast<size_t>(basis_.cols) ||
+      (p.rows != 1 && p.cols != 1)) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Coefficients must be a vector of the combination's size");
+  }
+  const cv::Mat coef = p.isContinuous() ? p : p.clone();
+  cv::Mat out(mean_.rows, 1, cv::DataType<T>::type, (void*)instance);
+  mean_.copyTo(out);
+  LA::Gemv(basis_, TType::kNoTranspose, T(1.0), coef, T(1.0), &out);
+  return Status();
+}
+
+/*
+ * @name  GenerateBatch
+ * @fn    Status GenerateBatch(const cv::Mat& p, cv::Mat* instances) const
+ * @brief Generate several instances at once with a single matrix-matrix
+ *        product
+ * @param[in] p           Concatenated coefficients, one instance per
+ *                        column [k x N]
+ * @param[out] instances  Generated instances, one per column [dim x N]
+ * @return    kInvalidArgument if \p p does not match the combination
+ */
+template<typename T>
+Status CombinedPCAModel<T>::GenerateBatch(const cv::Mat& p,
+                                          cv::Mat* instances) const {
+  FACEKIT_TRACE_SCOPE("CombinedPCAModel::GenerateBatch");
+  using LA = typename FaceKit::LinearAlgebra<T>;
+  using TType = typename FaceKit::LinearAlgebra<T>::TransposeType;
+  if (basis_.empty() || p.empty() || p.rows != basis_.cols ||
+      p.type() != cv::DataType<T>::type) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Coefficients must be a k x N matrix of the combination's "
+                  "type");
+  }
+  const cv::Mat coef = p.isContinuous() ? p : p.clone();
+  // Mean broadcast to every instance, then one GEMM
+  const T* mean = reinterpret_cast<const T*>(mean_.data);
+  instances->create(mean_.rows, p.cols, cv::DataType<T>::type);
+  for (int r = 0; r < mean_.rows; ++r) {
+    T* dst = instances->ptr<T>(r);
+    std::fill(dst, dst + p.cols, mean[r]);
+  }
+  LA::Gemm(basis_,
+           TType::kNoTranspose,
+           T(1.0),
+           coef,
+           TType::kNoTranspose,
+           T(1.0),
+           instances);
+  return Status();
+}
+
+#pragma mark -
+#pragma mark Explicit Instantiation
+
+/** Float */
+template class CombinedPCAModel<float>;
+/** Double */
+template class CombinedPCAModel<double>;
+
+}  // namespace FaceKit
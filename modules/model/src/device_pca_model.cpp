@@ -0,0 +1,254 @@
+/**
+ *  @file   device_pca_model.cpp
+ *  @brief  PCA model resident in GPU memory for large batch synthesis
+ *  @ingroup model
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/trace.hpp"
+#include "facekit/model/device_pca_model.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Size of the instances generated by one block, in bytes */
+static constexpr size_t kDeviceBlockBytes = 64 << 20;
+/** Number of rows copied by one parallel task */
+static constexpr size_t kDeviceCopyGrain = 1024;
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ * @name  Upload
+ * @fn    Status Upload(const PCAModel<T>& model)
+ * @brief Copy \p model to the device, with its prior folded into the basis
+ * @param[in] model   Loaded model
+ * @return    kInvalidArgument if the model is empty or not continuous,
+ *            kUnimplemented without CUDA
+ */
+template<typename T>
+Status DevicePCAModel<T>::Upload(const PCAModel<T>& model) {
+  if (model.get_mean().empty() || model.get_prior().empty()) {
+    return Status(Status::Type::kInvalidArgument, "Model must be loaded");
+  }
+  return this->UploadBasis(model.get_variation(),
+                           model.get_prior(),
+                           model.get_mean());
+}
+
+/*
+ * @name  Upload
+ * @fn    Status Upload(const CombinedPCAModel<T>& model)
+ * @brief Copy a combination of models to the device
+ * @param[in] model   Built combination
+ * @return    kInvalidArgument if the combination is empty, kUnimplemented
+ *            without CUDA
+ */
+template<typename T>
+Status DevicePCAModel<T>::Upload(const CombinedPCAModel<T>& model) {
+  if (model.basis().empty()) {
+    return Status(Status::Type::kInvalidArgument, "Models must be combined");
+  }
+  return this->UploadBasis(model.basis(), cv::Mat(), model.mean());
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ * @name  GenerateBatch
+ * @fn    Status GenerateBatch(const cv::Mat& p, cv::Mat* instances)
+ * @brief Generate several instances at once, same output as
+ *        `PCAModel::GenerateBatch`. Not reentrant, streams and staging
+ *        buffers are owned by the model.
+ * @param[in] p           Coefficients, one instance per column [k x N]
+ * @param[out] instances  Generated instances, one per column [dim x N]
+ * @return    kInvalidArgument if \p p does not match the model
+ */
+template<typename T>
+Status DevicePCAModel<T>::GenerateBatch(const cv::Mat& p,
+                                        cv::Mat* instances) {
+  FACEKIT_TRACE_SCOPE("DevicePCAModel::GenerateBatch");
+  using DLA = DeviceLinearAlgebra<T>;
+  using TType = typename DeviceLinearAlgebra<T>::TransposeType;
+  if (basis_.empty()) {
+    return Status(Status::Type::kInvalidArgument, "Model must be uploaded");
+  }
+  if (p.empty() || p.rows != n_component_ ||
+      p.type() != cv::DataType<T>::type) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Coefficients must be a k x N matrix of the model's type");
+  }
+  const int k = n_component_ + 1;
+  const int block = static_cast<int>(std::max(size_t(1),
+                                              std::min(size_t(p.cols),
+                                                       kDeviceBlockBytes /
+                                                       (dim_ * sizeof(T)))));
+  Status status;
+  for (auto& s : slot_) {
+    s.count = 0;
+    if (status.Good()) {
+      status = s.stream.Init();
+    }
+    if (status.Good()) {
+      status = s.h_coef.Resize(size_t(k) * block * sizeof(T));
+    }
+    if (status.Good()) {
+      status = s.h_inst.Resize(size_t(dim_) * block * sizeof(T));
+    }
+  }
+  if (!status.Good()) {
+    return status;
+  }
+  instances->create(dim_, p.cols, cv::DataType<T>::type);
+  // Blocks alternate between slots, a slot is drained before being reused
+  for (int j = 0, b = 0; j < p.cols && status.Good(); j += block, ++b) {
+    Slot& s = slot_[b % 2];
+    status = this->Drain(&s, instances);
+    const int n = std::min(block, p.cols - j);
+    // Coefficients with a row of ones selecting the mean
+    T* coef = static_cast<T*>(s.h_coef.data());
+    for (int r = 0; r < n_component_; ++r) {
+      const T* src = p.ptr<T>(r) + j;
+      std::copy(src, src + n, coef + size_t(r) * n);
+    }
+    std::fill(coef + size_t(n_component_) * n, coef + size_t(k) * n, T(1.0));
+    if (status.Good()) {
+      status = s.d_coef.Create(k, n);
+    }
+    if (status.Good()) {
+      status = s.d_coef.Upload(coef, &s.stream);
+    }
+    if (status.Good()) {
+      status = DLA::Gemm(basis_,
+                         TType::kNoTranspose,
+                         T(1.0),
+                         s.d_coef,
+                         TType::kNoTranspose,
+                         T(0.0),
+                         &s.d_inst,
+                         &s.stream);
+    }
+    if (status.Good()) {
+      status = s.d_inst.Download(static_cast<T*>(s.h_inst.data()),
+                                 &s.stream);
+    }
+    s.first = j;
+    s.count = n;
+  }
+  // Blocks still in flight, always waited for as they use the buffers
+  for (auto& s : slot_) {
+    Status drain = this->Drain(&s, instances);
+    if (status.Good()) {
+      status = drain;
+    }
+  }
+  return status;
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ * @name  UploadBasis
+ * @fn    Status UploadBasis(const cv::Mat& basis, const cv::Mat& prior,
+                             const cv::Mat& mean)
+ * @brief Append the mean to the basis scaled by \p prior and copy it
+ * @param[in] basis   Basis [dim x k]
+ * @param[in] prior   Scale of each column [k], empty for none
+ * @param[in] mean    Mean [dim]
+ */
+template<typename T>
+Status DevicePCAModel<T>::UploadBasis(const cv::Mat& basis,
+                                      const cv::Mat& prior,
+                                      const cv::Mat& mean) {
+  const int type = cv::DataType<T>::type;
+  if (basis.type() != type || mean.type() != type ||
+      (!prior.empty() && prior.type() != type) || !basis.isContinuous() ||
+      !mean.isContinuous() || !prior.isContinuous()) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Model must be continuous and of the model's type");
+  }
+  if (mean.total() != static_cast<size_t>(basis.rows) ||
+      (!prior.empty() && prior.total() != static_cast<size_t>(basis.cols))) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Mean, basis and prior dimensions do not agree");
+  }
+  // Basis with the prior folded in, mean as last column
+  cv::Mat host(basis.rows, basis.cols + 1, type);
+  ThreadPool::Get().ParallelFor(0,
+                                basis.rows,
+                                kDeviceCopyGrain,
+                                [&](const size_t& first, const size_t& last) {
+    const T* scale = prior.empty() ? nullptr :
+                     reinterpret_cast<const T*>(prior.data);
+    const T* m = reinterpret_cast<const T*>(mean.data);
+    for (size_t r = first; r < last; ++r) {
+      const T* src = basis.ptr<T>(static_cast<int>(r));
+      T* dst = host.ptr<T>(static_cast<int>(r));
+      for (int c = 0; c < basis.cols; ++c) {
+        dst[c] = scale ? src[c] * scale[c] : src[c];
+      }
+      dst[basis.cols] = m[r];
+    }
+  });
+  Status status = basis_.Upload(host);
+  if (status.Good()) {
+    dim_ = basis.rows;
+    n_component_ = basis.cols;
+  } else {
+    dim_ = 0;
+    n_component_ = 0;
+  }
+  return status;
+}
+
+/*
+ * @name  Drain
+ * @fn    Status Drain(Slot* slot, cv::Mat* instances)
+ * @brief Wait for the block of \p slot and copy it into \p instances
+ */
+template<typename T>
+Status DevicePCAModel<T>::Drain(Slot* slot, cv::Mat* instances) {
+  if (slot->count == 0) {
+    return Status();
+  }
+  const int first = slot->first;
+  const int n = slot->count;
+  slot->count = 0;
+  Status status = slot->stream.Synchronize();
+  if (status.Good()) {
+    const T* src = static_cast<const T*>(slot->h_inst.data());
+    ThreadPool::Get().ParallelFor(0,
+                                  dim_,
+                                  kDeviceCopyGrain,
+                                  [&](const size_t& begin, const size_t& end) {
+      for (size_t r = begin; r < end; ++r) {
+        std::copy(src + r * n,
+                  src + (r + 1) * n,
+                  instances->ptr<T>(static_cast<int>(r)) + first);
+      }
+    });
+  }
+  return status;
+}
+
+#pragma mark -
+#pragma mark Explicit Instantiation
+
+/** Float */
+template class DevicePCAModel<float>;
+/** Double */
+template class DevicePCAModel<double>;
+
+}  // namespace FaceKit
@@ -102,6 +102,35 @@ void OrthographicProjection<T>::operator()(const std::vector<Point3>& pts,
   }
 }
 
+/*
+ * @name  operator()
+ * @fn    void operator()(const T* x, const T* y, const T* z,
+                          const size_t& n, T* proj) const
+ * @brief Project a batch of points stored as separated x, y and z streams
+ *        (structure of arrays)
+ * @param[in] x       X components, `n` elements
+ * @param[in] y       Y components, `n` elements
+ * @param[in] z       Z components, `n` elements
+ * @param[in] n       Number of points
+ * @param[out] proj   Interleaved 2D points, 2 * `n` elements, must be
+ *                    allocated by the caller
+ */
+template<typename T>
+void OrthographicProjection<T>::operator()(const T* x,
+                                           const T* y,
+                                           const T* z,
+                                           const size_t& n,
+                                           T* proj) const {
+  // Depth is dropped
+  const T f = this->focal_;
+  const T cx = this->cx_;
+  const T cy = this->cy_;
+  for (size_t i = 0; i < n; ++i) {
+    proj[2 * i] = f * x[i] + cx;
+    proj[2 * i + 1] = f * y[i] + cy;
+  }
+}
+
 #pragma mark -
 #pragma mark Explicit Instantiation
 
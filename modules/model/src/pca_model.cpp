@@ -8,12 +8,20 @@
  *  Copyright (c) 2017 Christophe Ecabert. All rights reserved.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <limits>
+#include <vector>
 
 #include "facekit/model/pca_model.hpp"
 #include "facekit/model/pca_model_factory.hpp"
 #include "facekit/core/math/linear_algebra.hpp"
+#include "facekit/core/trace.hpp"
 #include "facekit/io/file_io.hpp"
+#include "facekit/io/section.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -21,6 +29,135 @@
  */
 namespace FaceKit {
 
+#pragma mark -
+#pragma mark Sections
+
+/** Schema version written by `Save` */
+static constexpr uint16_t kPCAModelVersion = 1;
+
+/** Sections of a model */
+enum PCAModelSection : uint32_t {
+  /** int32: n_channels, then type, rows, cols of mean, variation, prior */
+  kPCAShape = 1,
+  /** Mean elements */
+  kPCAMean = 2,
+  /** Variation elements, row major with one column per component */
+  kPCAVariation = 3,
+  /** Prior elements, one row per component */
+  kPCAPrior = 4
+};
+
+/** Number of int32 in `kPCAShape` */
+static constexpr size_t kPCAShapeSize = 10;
+
+/** Smallest skipped row part worth a seek instead of a sequential read */
+static constexpr size_t kMinRowSkip = 4096;
+
+/**
+ * @name  AddMatSection
+ * @fn    static void AddMatSection(const uint32_t& tag, const cv::Mat& m,
+                                    SectionWriter* writer)
+ * @brief Declare a section holding the elements of a matrix, written row by
+ *        row so it does not need to be continuous
+ * @param[in] tag     Section tag
+ * @param[in] m       Matrix, must outlive the writer
+ * @param[in,out] writer  Writer
+ */
+static void AddMatSection(const uint32_t& tag,
+                          const cv::Mat& m,
+                          SectionWriter* writer) {
+  const cv::Mat* mat = &m;
+  writer->Add(tag, m.total() * m.elemSize(), [mat](std::ostream& stream) {
+    const size_t row_size = mat->cols * mat->elemSize();
+    for (int r = 0; r < mat->rows; ++r) {
+      stream.write(reinterpret_cast<const char*>(mat->ptr(r)), row_size);
+    }
+    return stream.good() ? 0 : -1;
+  });
+}
+
+/**
+ * @name  ReadMatSection
+ * @fn    static int ReadMatSection(const uint32_t& tag, const int* shape,
+                                    const int& max_rows, const int& max_cols,
+                                    SectionReader* reader, std::istream& stream,
+                                    cv::Mat* m)
+ * @brief Read the leading block of a matrix section. Discarded columns are
+ *        skipped with a seek per row when they are large enough, otherwise
+ *        rows are read and cropped.
+ * @param[in] tag       Section tag
+ * @param[in] shape     Stored type, rows, cols
+ * @param[in] max_rows  Rows to keep
+ * @param[in] max_cols  Columns to keep
+ * @param[in] reader    Section table
+ * @param[in] stream    Binary stream
+ * @param[out] m        Loaded matrix, stored type
+ * @return    -1 if error, 0 otherwise
+ */
+static int ReadMatSection(const uint32_t& tag,
+                          const int* shape,
+                          const int& max_rows,
+                          const int& max_cols,
+                          SectionReader* reader,
+                          std::istream& stream,
+                          cv::Mat* m) {
+  size_t size = 0;
+  if (!reader->Seek(tag, &size).Good() || shape[0] < 0 ||
+      size != static_cast<size_t>(shape[1]) * shape[2] *
+              CV_ELEM_SIZE(shape[0])) {
+    return -1;
+  }
+  const int rows = std::min(shape[1], max_rows);
+  const int cols = std::min(shape[2], max_cols);
+  m->create(rows, cols, shape[0]);
+  const size_t row_size = shape[2] * m->elemSize();
+  const size_t keep = cols * m->elemSize();
+  if (keep == row_size) {
+    stream.read(reinterpret_cast<char*>(m->data), rows * row_size);
+  } else if (row_size - keep >= kMinRowSkip) {
+    for (int r = 0; r < rows && stream.good(); ++r) {
+      stream.read(reinterpret_cast<char*>(m->ptr(r)), keep);
+      if (r + 1 < rows) {
+        stream.seekg(row_size - keep, std::ios_base::cur);
+      }
+    }
+  } else {
+    std::vector<char> buffer(row_size);
+    for (int r = 0; r < rows && stream.good(); ++r) {
+      stream.read(buffer.data(), row_size);
+      std::memcpy(m->ptr(r), buffer.data(), keep);
+    }
+  }
+  return stream.good() ? 0 : -1;
+}
+
+/**
+ * @name  ToType
+ * @fn    template<typename T> static void ToType(cv::Mat* m)
+ * @brief Convert a matrix to the model's type if needed
+ * @param[in,out] m Matrix
+ */
+template<typename T>
+static void ToType(cv::Mat* m) {
+  if (m->depth() != cv::DataType<T>::depth) {
+    cv::Mat buff;
+    m->convertTo(buff, cv::DataType<T>::type);
+    *m = buff;
+  }
+}
+
+/**
+ * @name  IsFileBacked
+ * @fn    static bool IsFileBacked(const cv::Mat& m)
+ * @brief Indicate if a matrix wraps a mapped file region, mapped blocks
+ *        are attached to their `NDArray` buffer
+ * @param[in] m Matrix
+ * @return    True if the data is not a private allocation
+ */
+static bool IsFileBacked(const cv::Mat& m) {
+  return m.u != nullptr && m.u->userdata != nullptr;
+}
+
 #pragma mark -
 #pragma mark Initialization
 
@@ -33,22 +170,138 @@ namespace FaceKit {
  */
 template<typename T>
 int PCAModel<T>::Load(std::istream& stream) {
+  return this->Load(stream, -1);
+}
+
+/*
+ * @name  Load
+ * @fn    int Load(std::istream& stream, const int& n_component)
+ * @brief Load only the first \p n_component principal components from a
+ *        given binary \p stream. With sectioned models the discarded
+ *        columns of the variation are skipped instead of being read
+ *        when rows are wide enough.
+ * @param[in] stream      Binary stream to load model from
+ * @param[in] n_component Number of components to keep, negative to keep
+ *                        all of them
+ * @return    -1 if error, 0 otherwise
+ */
+template<typename T>
+int PCAModel<T>::Load(std::istream& stream, const int& n_component) {
+  FACEKIT_TRACE_SCOPE("PCAModel::Load");
+  const bool prescale = this->IsPrescaled();
+  const bool transpose = this->IsTransposed();
   int err = -1;
-  if (stream.good()) {
-    // Load
+  if (!stream.good()) {
+    return err;
+  }
+  const int n_max = n_component < 0 ? std::numeric_limits<int>::max() :
+                                      n_component;
+  if (SectionReader::IsSectioned(stream)) {
+    SectionReader reader;
+    int shape[kPCAShapeSize];
+    if (!reader.Open(&stream).Good()) {
+      return err;
+    }
+    if (reader.Read(kPCAShape, shape, sizeof(shape)).Good()) {
+      const int all = std::numeric_limits<int>::max();
+      // Only touch the leading components, prior is either a row or a column
+      const bool row_prior = shape[8] == 1;
+      err = ReadMatSection(kPCAMean, &shape[1], all, all, &reader, stream,
+                           &mean_);
+      err |= ReadMatSection(kPCAVariation, &shape[4], all, n_max, &reader,
+                            stream, &variation_);
+      err |= ReadMatSection(kPCAPrior,
+                            &shape[7],
+                            row_prior ? all : n_max,
+                            row_prior ? n_max : all,
+                            &reader,
+                            stream,
+                            &prior_);
+      n_channels_ = shape[0];
+      ToType<T>(&mean_);
+      ToType<T>(&variation_);
+      ToType<T>(&prior_);
+    }
+    reader.Finish();
+  } else {
+    // Models saved before sections
     err = IO::LoadTypedMat<T>(stream, &mean_);
     err |= IO::LoadTypedMat<T>(stream, &variation_);
     err |= IO::LoadTypedMat<T>(stream, &prior_);
     // Channels
     stream.read(reinterpret_cast<char*>(&n_channels_), sizeof(n_channels_));
-    // Init vars
-    n_principle_component_ = variation_.cols;
-    // Sanity check
-    err |= stream.good() ? 0 : -1;
+    if (err == 0 && n_max < variation_.cols) {
+      variation_ = variation_.colRange(0, n_max).clone();
+      prior_ = prior_.rows == 1 ?
+               prior_.colRange(0, std::min(n_max, prior_.cols)).clone() :
+               prior_.rowRange(0, std::min(n_max, prior_.rows)).clone();
+    }
+  }
+  // Init vars
+  n_principle_component_ = variation_.cols;
+  q_variation_ = QuantizedMatrix();
+  s_variation_.release();
+  t_variation_.release();
+  subset_ = Subset();
+  shared_ = false;
+  n_sample_ = 0;
+  // Sanity check
+  err |= stream.good() ? 0 : -1;
+  if (err == 0 && prescale) {
+    err = this->PrescaleVariation().Good() ? 0 : -1;
+  }
+  if (err == 0 && transpose) {
+    err = this->TransposeVariation().Good() ? 0 : -1;
   }
   return err;
 }
 
+/**
+ * @name  BuildWriter
+ * @fn    static SectionWriter BuildWriter(const cv::Mat& mean,
+                                           const cv::Mat& variation,
+                                           const cv::Mat& prior,
+                                           const int* shape)
+ * @brief Declare the sections of a model
+ * @param[in] mean      Mean
+ * @param[in] variation Variation
+ * @param[in] prior     Prior
+ * @param[in] shape     `kPCAShape` content
+ * @return    Writer, arguments must outlive it
+ */
+static SectionWriter BuildWriter(const cv::Mat& mean,
+                                 const cv::Mat& variation,
+                                 const cv::Mat& prior,
+                                 const int* shape) {
+  SectionWriter writer(kPCAModelVersion);
+  writer.Add(kPCAShape, shape, kPCAShapeSize * sizeof(int));
+  AddMatSection(kPCAMean, mean, &writer);
+  AddMatSection(kPCAVariation, variation, &writer);
+  AddMatSection(kPCAPrior, prior, &writer);
+  return writer;
+}
+
+/**
+ * @name  FillShape
+ * @fn    static void FillShape(const cv::Mat& mean, const cv::Mat& variation,
+                                const cv::Mat& prior, const int& n_channels,
+                                int* shape)
+ * @brief Fill the `kPCAShape` section
+ */
+static void FillShape(const cv::Mat& mean,
+                      const cv::Mat& variation,
+                      const cv::Mat& prior,
+                      const int& n_channels,
+                      int* shape) {
+  const cv::Mat* mats[3] = {&mean, &variation, &prior};
+  shape[0] = n_channels;
+  for (int k = 0; k < 3; ++k) {
+    shape[1 + 3 * k] = mats[k]->type();
+    shape[2 + 3 * k] = mats[k]->rows;
+    shape[3 + 3 * k] = mats[k]->cols;
+  }
+}
+
 /*
  * @name  Save
  * @fn    virtual int Save(std::istream& stream) const
@@ -60,33 +313,115 @@ template<typename T>
 int PCAModel<T>::Save(std::ostream& stream) const {
   int err = -1;
   if (stream.good()) {
-    // Mean, var, prior
-    err = IO::SaveMat(stream, mean_);
-    err |= IO::SaveMat(stream, variation_);
-    err |= IO::SaveMat(stream, prior_);
-    // Channels
-    stream.write(reinterpret_cast<const char*>(&n_channels_),
-                 sizeof(n_channels_));
-    // Sanity check
-    err |= stream.good() ? 0 : -1;
+    // Sections are aligned so they can be mapped back by `Map`
+    int shape[kPCAShapeSize];
+    FillShape(mean_, variation_, prior_, n_channels_, shape);
+    err = BuildWriter(mean_, variation_, prior_, shape).Write(stream);
   }
   return err;
 }
 
+/*
+ * @name  Map
+ * @fn    Status Map(const std::string& path, const size_t& offset)
+ * @brief Load from a file without copying the mean, variation and prior,
+ *        they are mapped in memory and shared with every process using the
+ *        same file.
+ * @param[in] path    Path to the file
+ * @param[in] offset  Position of the model in the file (i.e. where `Save`
+ *                    started writing)
+ * @return    Operation status
+ */
+template<typename T>
+Status PCAModel<T>::Map(const std::string& path, const size_t& offset) {
+  FACEKIT_TRACE_SCOPE("PCAModel::Map");
+  const bool prescale = this->IsPrescaled();
+  const bool transpose = this->IsTransposed();
+  std::ifstream stream(path.c_str(), std::ios_base::binary);
+  if (!stream.is_open()) {
+    return Status(Status::Type::kNotFound, "Can not open file: " + path);
+  }
+  stream.seekg(offset);
+  Status s;
+  if (SectionReader::IsSectioned(stream)) {
+    SectionReader reader;
+    int shape[kPCAShapeSize];
+    s = reader.Open(&stream);
+    if (s.Good()) {
+      s = reader.Read(kPCAShape, shape, sizeof(shape));
+    }
+    const uint32_t tags[3] = {kPCAMean, kPCAVariation, kPCAPrior};
+    cv::Mat* mats[3] = {&mean_, &variation_, &prior_};
+    for (int k = 0; k < 3 && s.Good(); ++k) {
+      const Section* section = reader.Find(tags[k]);
+      if (section == nullptr) {
+        return Status(Status::Type::kInternalError,
+                      "Missing section in model: " + path);
+      }
+      const int* shp = &shape[1 + 3 * k];
+      s = IO::MapRawMat(path, offset + section->offset, shp[1], shp[2],
+                        shp[0], mats[k]);
+      ToType<T>(mats[k]);
+    }
+    if (s.Good()) {
+      n_channels_ = shape[0];
+    }
+  } else {
+    // Models saved before sections
+    stream.close();
+    size_t pos = offset;
+    s = IO::MapTypedMat<T>(path, &pos, &mean_);
+    if (s.Good()) {
+      s = IO::MapTypedMat<T>(path, &pos, &variation_);
+    }
+    if (s.Good()) {
+      s = IO::MapTypedMat<T>(path, &pos, &prior_);
+    }
+    if (s.Good()) {
+      // Channels
+      stream.open(path.c_str(), std::ios_base::binary);
+      stream.seekg(pos);
+      stream.read(reinterpret_cast<char*>(&n_channels_), sizeof(n_channels_));
+      if (!stream.good()) {
+        s = Status(Status::Type::kInternalError,
+                   "Error while reading model in: " + path);
+      }
+    }
+  }
+  if (!s.Good()) {
+    return s;
+  }
+  // Init vars
+  n_principle_component_ = variation_.cols;
+  q_variation_ = QuantizedMatrix();
+  s_variation_.release();
+  t_variation_.release();
+  subset_ = Subset();
+  n_sample_ = 0;
+  shared_ = IsFileBacked(mean_) && IsFileBacked(variation_) &&
+            IsFileBacked(prior_);
+  if (prescale) {
+    s = this->PrescaleVariation();
+  }
+  if (s.Good() && transpose) {
+    s = this->TransposeVariation();
+  }
+  return s;
+}
+
 /*
  * @name  ComputeObjectSize
  * @fn    virtual int ComputeObjectSize(void) const
- * @brief Compute object size in byte
+ * @brief Compute object size in byte, derived from the sections written
+ *        by `Save`. Upper bound since the alignment padding depends on the
+ *        stream position
  * @return    Object's size
  */
 template<typename T>
 size_t PCAModel<T>::ComputeObjectSize(void) const {
-  size_t sz = 9 * sizeof(int);
-  sz += mean_.total() * mean_.elemSize();
-  sz += variation_.total() * variation_.elemSize();
-  sz += prior_.total() * prior_.elemSize();
-  sz += sizeof(n_channels_);
-  return sz;
+  int shape[kPCAShapeSize];
+  FillShape(mean_, variation_, prior_, n_channels_, shape);
+  return BuildWriter(mean_, variation_, prior_, shape).Size();
 }
 
 #pragma mark -
@@ -95,12 +430,31 @@ size_t PCAModel<T>::ComputeObjectSize(void) const {
 /*
  * @name  Generate
  * @fn    virtual void Generate(const cv::Mat& p, T* instance)
- * @brief Generate an instance given a set of coefficients \p p.
+ * @brief Generate an instance given a set of coefficients \p p. Uses a
+ *        per-thread workspace.
  * @param[in] p   Nodel's coefficients
  * @param[out] instance   Generated instance
  */
 template<typename T>
 void PCAModel<T>::Generate(const cv::Mat& p, T* instance) {
+  thread_local Workspace ws;
+  this->Generate(p, &ws, instance);
+}
+
+/*
+ * @name  Generate
+ * @fn    void Generate(const cv::Mat& p, Workspace* ws, T* instance) const
+ * @brief Generate an instance given a set of coefficients \p p,
+ *        reentrant.
+ * @param[in] p           Nodel's coefficients
+ * @param[in,out] ws      Caller's scratch buffers
+ * @param[out] instance   Generated instance
+ */
+template<typename T>
+void PCAModel<T>::Generate(const cv::Mat& p,
+                           Workspace* ws,
+                           T* instance) const {
+  FACEKIT_TRACE_SCOPE("PCAModel::Generate");
   using LA = typename FaceKit::LinearAlgebra<T>;
   using TType = typename FaceKit::LinearAlgebra<T>::TransposeType;
   // Init containter access
@@ -109,48 +463,566 @@ void PCAModel<T>::Generate(const cv::Mat& p, T* instance) {
               cv::DataType<T>::type,
               (void*)instance);
   mean_.copyTo(out);
-  // Generate instance
-  static cv::Mat buff;
-  LA::Sbmv(prior_, T(1.0), p, T(0.0), &buff);
-  LA::Gemv(variation_,
-           TType::kNoTranspose,
-           T(1.0),
-           buff,
-           T(1.0),
-           &out);
+  // Generate instance, prior is already in the basis when prescaled
+  const cv::Mat* coef = &p;
+  if (!this->IsPrescaled()) {
+    LA::Sbmv(prior_, T(1.0), p, T(0.0), &ws->coef);
+    coef = &ws->coef;
+  }
+  if (this->IsQuantized()) {
+    LA::Gemv(q_variation_, TType::kNoTranspose, T(1.0), *coef, T(1.0), &out);
+  } else {
+    LA::Gemv(this->IsPrescaled() ? s_variation_ : variation_,
+             TType::kNoTranspose,
+             T(1.0),
+             *coef,
+             T(1.0),
+             &out);
+  }
 }
 
 /*
  * @name  Generate
- * @fn    virtual void Generate(T* instance)
- * @brief Generate a random instance
- * @param[out] instance   Randomly generated instance
+ * @fn    void Generate(const cv::Mat& p, const int& k, T* instance)
+ * @brief Generate an instance using only the first \p k components, i.e.
+ *        coarse fitting iterations. Uses a per-thread workspace.
+ * @param[in] p   Nodel's coefficients, at least \p k of them
+ * @param[in] k   Number of leading components to use
+ * @param[out] instance   Generated instance
  */
 template<typename T>
-void PCAModel<T>::Generate(T* instance) {
+void PCAModel<T>::Generate(const cv::Mat& p, const int& k, T* instance) {
+  thread_local Workspace ws;
+  this->Generate(p, k, &ws, instance);
+}
+
+/*
+ * @name  Generate
+ * @fn    void Generate(const cv::Mat& p, const int& k, Workspace* ws,
+                        T* instance) const
+ * @brief Generate an instance using only the first \p k components,
+ *        reentrant.
+ * @param[in] p           Nodel's coefficients, at least \p k of them
+ * @param[in] k           Number of leading components to use
+ * @param[in,out] ws      Caller's scratch buffers
+ * @param[out] instance   Generated instance
+ */
+template<typename T>
+void PCAModel<T>::Generate(const cv::Mat& p,
+                           const int& k,
+                           Workspace* ws,
+                           T* instance) const {
+  FACEKIT_TRACE_SCOPE("PCAModel::GenerateTruncated");
   using LA = typename FaceKit::LinearAlgebra<T>;
   using TType = typename FaceKit::LinearAlgebra<T>::TransposeType;
-  // Init containter access
   cv::Mat out(mean_.rows,
               mean_.cols,
               cv::DataType<T>::type,
               (void*)instance);
   mean_.copyTo(out);
-  // Create random parameters
-  cv::theRNG().state = static_cast<uint64_t>(cv::getTickCount());
-  static cv::Mat p(variation_.cols, 1, cv::DataType<T>::type);
-  cv::randn(p, T(0.0), T(1.0));
-  // Generate instance
-  static cv::Mat buff;
-  LA::Sbmv(prior_, T(1.0), p, T(0.0), &buff);
-  LA::Gemv(variation_,
+  const int n = std::min(std::max(k, 0), std::min(n_principle_component_,
+                                                  static_cast<int>(p.total())));
+  if (n == 0) {
+    return;
+  }
+  // Prior on the leading coefficients only
+  const T* prior = reinterpret_cast<const T*>(prior_.data);
+  ws->coef.create(n, 1, cv::DataType<T>::type);
+  T* coef = reinterpret_cast<T*>(ws->coef.data);
+  for (int i = 0; i < n; ++i) {
+    coef[i] = prior[i] * p.at<T>(i);
+  }
+  if (this->IsTransposed()) {
+    // Leading components are a contiguous block
+    LA::Gemv(t_variation_.rowRange(0, n),
+             TType::kTranspose,
+             T(1.0),
+             ws->coef,
+             T(1.0),
+             &out);
+  } else {
+    T* dst = reinterpret_cast<T*>(out.data);
+    for (int r = 0; r < variation_.rows; ++r) {
+      const T* v = variation_.ptr<T>(r);
+      T acc = T(0.0);
+      for (int i = 0; i < n; ++i) {
+        acc += v[i] * coef[i];
+      }
+      dst[r] += acc;
+    }
+  }
+}
+
+/*
+ * @name  Generate
+ * @fn    virtual void Generate(T* instance)
+ * @brief Generate a random instance. Uses a per-thread workspace and
+ *        generator, seeded once per thread.
+ * @param[out] instance   Randomly generated instance
+ */
+template<typename T>
+void PCAModel<T>::Generate(T* instance) {
+  thread_local Workspace ws;
+  thread_local cv::RNG rng(static_cast<uint64_t>(cv::getTickCount()));
+  this->Generate(&rng, &ws, instance);
+}
+
+/*
+ * @name  Generate
+ * @fn    void Generate(cv::RNG* rng, Workspace* ws, T* instance) const
+ * @brief Generate a random instance, coefficients are drawn from a
+ *        standard normal distribution with the caller's generator.
+ * @param[in,out] rng     Random number generator
+ * @param[in,out] ws      Caller's scratch buffers
+ * @param[out] instance   Randomly generated instance
+ */
+template<typename T>
+void PCAModel<T>::Generate(cv::RNG* rng, Workspace* ws, T* instance) const {
+  ws->p.create(variation_.cols, 1, cv::DataType<T>::type);
+  rng->fill(ws->p, cv::RNG::NORMAL, T(0.0), T(1.0));
+  this->Generate(ws->p, ws, instance);
+}
+
+/*
+ * @name  GenerateBatch
+ * @fn    Status GenerateBatch(const cv::Mat& p, cv::Mat* instances) const
+ * @brief Generate several instances at once with a single matrix-matrix
+ *        product
+ * @param[in] p           Coefficients, one instance per column [k x N]
+ * @param[out] instances  Generated instances, one per column [dim x N]
+ * @return    kInvalidArgument if \p p does not match the model
+ */
+template<typename T>
+Status PCAModel<T>::GenerateBatch(const cv::Mat& p,
+                                  cv::Mat* instances) const {
+  FACEKIT_TRACE_SCOPE("PCAModel::GenerateBatch");
+  using LA = typename FaceKit::LinearAlgebra<T>;
+  using TType = typename FaceKit::LinearAlgebra<T>::TransposeType;
+  if (p.empty() || p.rows != variation_.cols ||
+      p.type() != cv::DataType<T>::type) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Coefficients must be a k x N matrix of the model's type");
+  }
+  if (!mean_.isContinuous() || !variation_.isContinuous() ||
+      !prior_.isContinuous() || prior_.total() != static_cast<size_t>(p.rows)) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Model must be loaded and continuous");
+  }
+  // Prior folded into the coefficients, k x N is far smaller than the basis
+  cv::Mat buff = p;
+  if (!this->IsPrescaled()) {
+    const T* prior = reinterpret_cast<const T*>(prior_.data);
+    buff = cv::Mat(p.rows, p.cols, p.type());
+    for (int r = 0; r < p.rows; ++r) {
+      const T* src = p.ptr<T>(r);
+      T* dst = buff.ptr<T>(r);
+      for (int c = 0; c < p.cols; ++c) {
+        dst[c] = prior[r] * src[c];
+      }
+    }
+  } else if (!p.isContinuous()) {
+    buff = p.clone();
+  }
+  // Mean broadcast to every instance, then one GEMM
+  const int dim = static_cast<int>(mean_.total());
+  const T* mean = reinterpret_cast<const T*>(mean_.data);
+  instances->create(dim, p.cols, cv::DataType<T>::type);
+  for (int r = 0; r < dim; ++r) {
+    T* dst = instances->ptr<T>(r);
+    std::fill(dst, dst + p.cols, mean[r]);
+  }
+  LA::Gemm(this->IsPrescaled() ? s_variation_ : variation_,
            TType::kNoTranspose,
            T(1.0),
            buff,
+           TType::kNoTranspose,
+           T(1.0),
+           instances);
+  return Status();
+}
+
+/*
+ * @name  BuildSubset
+ * @fn    Status BuildSubset(const std::vector<int>& vertex_ids,
+                             Subset* subset) const
+ * @brief Gather the mean and variation rows of a set of vertices
+ * @param[in] vertex_ids  Vertex indices, duplicates allowed
+ * @param[out] subset     Gathered sub-model
+ * @return    kInvalidArgument if an index is out of range
+ */
+template<typename T>
+Status PCAModel<T>::BuildSubset(const std::vector<int>& vertex_ids,
+                                Subset* subset) const {
+  const size_t n_ch = static_cast<size_t>(std::max(n_channels_, 1));
+  const size_t n_vertex = mean_.total() / n_ch;
+  if (!mean_.isContinuous() || !variation_.isContinuous() ||
+      static_cast<size_t>(variation_.rows) != mean_.total()) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Model must be loaded and continuous");
+  }
+  for (const int& v : vertex_ids) {
+    if (v < 0 || static_cast<size_t>(v) >= n_vertex) {
+      return Status(Status::Type::kInvalidArgument,
+                    "Vertex index out of range");
+    }
+  }
+  const int n_row = static_cast<int>(vertex_ids.size() * n_ch);
+  subset->vertex = vertex_ids;
+  subset->mean.create(n_row, 1, mean_.type());
+  subset->variation.create(n_row, variation_.cols, variation_.type());
+  const size_t row = variation_.cols * variation_.elemSize();
+  const T* src_m = reinterpret_cast<const T*>(mean_.data);
+  T* dst_m = reinterpret_cast<T*>(subset->mean.data);
+  for (size_t i = 0; i < vertex_ids.size(); ++i) {
+    const size_t src = vertex_ids[i] * n_ch;
+    std::memcpy(dst_m + i * n_ch, src_m + src, n_ch * sizeof(T));
+    std::memcpy(subset->variation.data + i * n_ch * row,
+                variation_.data + src * row,
+                n_ch * row);
+  }
+  return Status();
+}
+
+/*
+ * @name  GenerateSubset
+ * @fn    void GenerateSubset(const cv::Mat& p, const Subset& subset,
+                              Workspace* ws, T* instance) const
+ * @brief Generate only the vertices of \p subset, reentrant
+ * @param[in] p           Nodel's coefficients
+ * @param[in] subset      Sub-model built by \p BuildSubset
+ * @param[in,out] ws      Caller's scratch buffers
+ * @param[out] instance   Generated vertices, in the subset's order
+ */
+template<typename T>
+void PCAModel<T>::GenerateSubset(const cv::Mat& p,
+                                 const Subset& subset,
+                                 Workspace* ws,
+                                 T* instance) const {
+  FACEKIT_TRACE_SCOPE("PCAModel::GenerateSubset");
+  using LA = typename FaceKit::LinearAlgebra<T>;
+  using TType = typename FaceKit::LinearAlgebra<T>::TransposeType;
+  if (subset.vertex.empty()) {
+    return;
+  }
+  cv::Mat out(subset.mean.rows,
+              1,
+              cv::DataType<T>::type,
+              (void*)instance);
+  subset.mean.copyTo(out);
+  LA::Sbmv(prior_, T(1.0), p, T(0.0), &ws->coef);
+  LA::Gemv(subset.variation,
+           TType::kNoTranspose,
+           T(1.0),
+           ws->coef,
            T(1.0),
            &out);
 }
 
+/*
+ * @name  GenerateSubset
+ * @fn    Status GenerateSubset(const cv::Mat& p,
+                                const std::vector<int>& vertex_ids,
+                                T* instance)
+ * @brief Generate only the vertices in \p vertex_ids, with a cached
+ *        sub-model
+ * @param[in] p           Nodel's coefficients
+ * @param[in] vertex_ids  Vertex indices
+ * @param[out] instance   Generated vertices, in the order of \p vertex_ids
+ * @return    kInvalidArgument if an index is out of range
+ */
+template<typename T>
+Status PCAModel<T>::GenerateSubset(const cv::Mat& p,
+                                   const std::vector<int>& vertex_ids,
+                                   T* instance) {
+  thread_local Workspace ws;
+  if (subset_.vertex != vertex_ids || subset_.mean.empty()) {
+    Status s = this->BuildSubset(vertex_ids, &subset_);
+    if (!s.Good()) {
+      subset_ = Subset();
+      return s;
+    }
+  }
+  this->GenerateSubset(p, subset_, &ws, instance);
+  return Status();
+}
+
+/*
+ * @name  PrescaleVariation
+ * @fn    Status PrescaleVariation(void)
+ * @brief Store a copy of the variation with the prior folded into its
+ *        columns
+ * @return    Operation status
+ */
+template<typename T>
+Status PCAModel<T>::PrescaleVariation(void) {
+  if (variation_.empty() || !variation_.isContinuous() ||
+      !prior_.isContinuous() ||
+      prior_.total() != static_cast<size_t>(variation_.cols)) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Variation and prior must be loaded and continuous");
+  }
+  const T* prior = reinterpret_cast<const T*>(prior_.data);
+  s_variation_.create(variation_.rows, variation_.cols, variation_.type());
+  for (int r = 0; r < variation_.rows; ++r) {
+    const T* src = variation_.ptr<T>(r);
+    T* dst = s_variation_.ptr<T>(r);
+    for (int c = 0; c < variation_.cols; ++c) {
+      dst[c] = src[c] * prior[c];
+    }
+  }
+  if (this->IsQuantized()) {
+    return this->QuantizeVariation(q_variation_.format());
+  }
+  return Status();
+}
+
+/*
+ * @name  ClearPrescaledVariation
+ * @fn    void ClearPrescaledVariation(void)
+ * @brief Go back to applying the prior on each generation
+ */
+template<typename T>
+void PCAModel<T>::ClearPrescaledVariation(void) {
+  if (!this->IsPrescaled()) {
+    return;
+  }
+  s_variation_.release();
+  if (this->IsQuantized()) {
+    // Quantized copy holds the prior as well
+    this->QuantizeVariation(q_variation_.format());
+  }
+}
+
+/*
+ * @name  TransposeVariation
+ * @fn    Status TransposeVariation(void)
+ * @brief Store a copy of the variation with one component per row
+ * @return    Operation status
+ */
+template<typename T>
+Status PCAModel<T>::TransposeVariation(void) {
+  if (variation_.empty()) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Variation must be loaded");
+  }
+  cv::transpose(variation_, t_variation_);
+  return Status();
+}
+
+/*
+ * @name  QuantizeVariation
+ * @fn    Status QuantizeVariation(const QuantizedMatrix::Format& format)
+ * @brief Store a reduced precision copy of the variation used by
+ *        \p Generate, cutting the memory traffic of the generation loop
+ *        by 2x (fp16, bf16) or 4x (int8). The full precision variation is
+ *        kept for serialization.
+ * @param[in] format  Storage format
+ * @return    Operation status
+ */
+template<typename T>
+Status PCAModel<T>::QuantizeVariation(const QuantizedMatrix::Format& format) {
+  const cv::Mat& variation = this->IsPrescaled() ? s_variation_ : variation_;
+  if (variation.empty() || !variation.isContinuous()) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Variation must be loaded and continuous");
+  }
+  return q_variation_.Quantize(reinterpret_cast<const T*>(variation.data),
+                               variation.rows,
+                               variation.cols,
+                               format);
+}
+
+/*
+ * @name  ReorderVertex
+ * @fn    Status ReorderVertex(const std::vector<int>& vertex_order)
+ * @brief Permute the mean and the rows of the variation to follow a new
+ *        vertex order
+ * @param[in] vertex_order    `vertex_order[new]` is the previous index of
+ *                            vertex `new`
+ * @return    Operation status
+ */
+template<typename T>
+Status PCAModel<T>::ReorderVertex(const std::vector<int>& vertex_order) {
+  const size_t n_elem = mean_.total();
+  const size_t n_ch = static_cast<size_t>(std::max(n_channels_, 1));
+  if (!mean_.isContinuous() || !variation_.isContinuous() ||
+      static_cast<size_t>(variation_.rows) != n_elem ||
+      vertex_order.size() * n_ch != n_elem) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Vertex order does not match the model's dimensions");
+  }
+  const size_t n_vertex = vertex_order.size();
+  std::vector<uint8_t> seen(n_vertex, 0);
+  for (const int& v : vertex_order) {
+    if (v < 0 || static_cast<size_t>(v) >= n_vertex || seen[v]) {
+      return Status(Status::Type::kInvalidArgument,
+                    "Vertex order is not a permutation");
+    }
+    seen[v] = 1;
+  }
+  // New buffers, mapped data is left untouched
+  cv::Mat mean(mean_.rows, mean_.cols, mean_.type());
+  cv::Mat variation(variation_.rows, variation_.cols, variation_.type());
+  const size_t row = variation_.cols * variation_.elemSize();
+  const T* src_m = reinterpret_cast<const T*>(mean_.data);
+  T* dst_m = reinterpret_cast<T*>(mean.data);
+  for (size_t v = 0; v < n_vertex; ++v) {
+    const size_t src = vertex_order[v] * n_ch;
+    std::memcpy(dst_m + v * n_ch, src_m + src, n_ch * sizeof(T));
+    std::memcpy(variation.data + v * n_ch * row,
+                variation_.data + src * row,
+                n_ch * row);
+  }
+  mean_ = mean;
+  variation_ = variation;
+  subset_ = Subset();
+  shared_ = false;
+  if (this->IsTransposed()) {
+    Status s = this->TransposeVariation();
+    if (!s.Good()) {
+      return s;
+    }
+  }
+  if (this->IsPrescaled()) {
+    // Requantizes as well
+    return this->PrescaleVariation();
+  }
+  if (this->IsQuantized()) {
+    return this->QuantizeVariation(q_variation_.format());
+  }
+  return Status();
+}
+
+/*
+ * @name  Update
+ * @fn    Status Update(const cv::Mat& samples, const int& max_component)
+ * @brief Add new \p samples to the model without the previous data
+ *        (incremental SVD with mean update)
+ * @param[in] samples         New samples, one per column [dim x m]
+ * @param[in] max_component   Number of components kept, negative to keep
+ *                            the current number
+ * @return    Operation status
+ */
+template<typename T>
+Status PCAModel<T>::Update(const cv::Mat& samples, const int& max_component) {
+  FACEKIT_TRACE_SCOPE("PCAModel::Update");
+  using LA = typename FaceKit::LinearAlgebra<T>;
+  using TType = typename FaceKit::LinearAlgebra<T>::TransposeType;
+  const int type = cv::DataType<T>::type;
+  const bool empty = mean_.empty();
+  const int dim = empty ? samples.rows : static_cast<int>(mean_.total());
+  const int m = samples.cols;
+  const int k = empty ? 0 : variation_.cols;
+  if (samples.type() != type || samples.rows != dim || m == 0 ||
+      dim <= m) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Samples must be [dim x m] of the model's type, with "
+                  "m < dim");
+  }
+  if (!empty && (n_sample_ == 0 || variation_.rows != dim ||
+                 prior_.total() != static_cast<size_t>(k))) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Number of samples of the model is unknown, see "
+                  "set_n_sample");
+  }
+  // New mean, mu' = (n mu + m mu_b) / (n + m)
+  const T n = empty ? T(0.0) : static_cast<T>(n_sample_);
+  const T n_new = n + T(m);
+  cv::Mat mu_b;
+  cv::reduce(samples, mu_b, 1, cv::REDUCE_AVG, type);
+  cv::Mat mean = mu_b.clone();
+  if (!empty) {
+    mean = (n * mean_.reshape(1, dim) + T(m) * mu_b) / n_new;
+  }
+  // Centered batch, augmented with the mean shift when updating:
+  // B = [X - mu_b, sqrt(n m / (n + m)) (mu_b - mu)]
+  const int n_col = empty ? m : m + 1;
+  cv::Mat b(dim, n_col, type);
+  for (int j = 0; j < m; ++j) {
+    b.col(j) = samples.col(j) - mu_b;
+  }
+  if (!empty) {
+    b.col(m) = std::sqrt(n * T(m) / n_new) * (mu_b - mean_.reshape(1, dim));
+  }
+  // Split B into its projection on the basis and an orthogonal residual,
+  // B = U L + Q R
+  cv::Mat variation = variation_.isContinuous() ? variation_ :
+                                                  variation_.clone();
+  cv::Mat l;
+  cv::Mat h = b;
+  if (k > 0) {
+    LA::Gemm(variation, TType::kTranspose, T(1.0),
+             b, TType::kNoTranspose, T(0.0), &l);
+    h = b.clone();
+    LA::Gemm(variation, TType::kNoTranspose, T(-1.0),
+             l, TType::kNoTranspose, T(1.0), &h);
+  }
+  cv::Mat q, r;
+  typename LA::QR qr;
+  Status s = qr.Compute(h, &q, &r);
+  if (!s.Good()) {
+    return s;
+  }
+  // Core matrix [diag(sv) L; 0 R], with sv = prior * sqrt(n - 1)
+  const int n_core = k + n_col;
+  cv::Mat core(n_core, n_core, type, cv::Scalar(0.0));
+  if (k > 0) {
+    const T scale = std::sqrt(std::max(n - T(1.0), T(0.0)));
+    const T* prior = reinterpret_cast<const T*>(prior_.data);
+    for (int i = 0; i < k; ++i) {
+      core.at<T>(i, i) = prior[i] * scale;
+    }
+    l.copyTo(core(cv::Rect(k, 0, n_col, k)));
+  }
+  r.copyTo(core(cv::Rect(k, k, n_col, n_col)));
+  cv::Mat u, sv;
+  typename LA::SVD svd;
+  s = svd.Compute(core, &u, &sv, nullptr);
+  if (!s.Good()) {
+    return s;
+  }
+  // Number of components, at most n' - 1 carry variance
+  int n_comp = max_component >= 0 ? max_component : (empty ? n_core : k);
+  n_comp = std::min(n_comp, n_core);
+  n_comp = std::min(n_comp, std::max(static_cast<int>(n_new) - 1, 1));
+  // Rotate the extended basis, U' = [U Q] u
+  cv::Mat u_c = u.colRange(0, n_comp).clone();
+  cv::Mat basis;
+  LA::Gemm(q, TType::kNoTranspose, T(1.0),
+           u_c.rowRange(k, n_core), TType::kNoTranspose, T(0.0), &basis);
+  if (k > 0) {
+    LA::Gemm(variation, TType::kNoTranspose, T(1.0),
+             u_c.rowRange(0, k), TType::kNoTranspose, T(1.0), &basis);
+  }
+  // Standard deviation of each component
+  cv::Mat prior(n_comp, 1, type);
+  const T inv = T(1.0) / std::sqrt(std::max(n_new - T(1.0), T(1.0)));
+  for (int i = 0; i < n_comp; ++i) {
+    prior.at<T>(i) = sv.at<T>(i) * inv;
+  }
+  mean_ = mean;
+  variation_ = basis;
+  prior_ = prior;
+  n_principle_component_ = n_comp;
+  n_sample_ = static_cast<size_t>(n_new);
+  subset_ = Subset();
+  shared_ = false;
+  if (this->IsTransposed()) {
+    s = this->TransposeVariation();
+    if (!s.Good()) {
+      return s;
+    }
+  }
+  if (this->IsPrescaled()) {
+    // Requantizes as well
+    return this->PrescaleVariation();
+  }
+  if (this->IsQuantized()) {
+    return this->QuantizeVariation(q_variation_.format());
+  }
+  return Status();
+}
+
 #pragma mark -
 #pragma mark Proxy
 
@@ -161,7 +1033,7 @@ void PCAModel<T>::Generate(T* instance) {
  */
 template<typename T>
 PCAModelProxy<T>::PCAModelProxy(void) {
-  PCAModelFactory<T>::Get().Register(this);
+  PCAModelFactory<T>::Register(this);
 }
 
 #pragma mark -
@@ -8,6 +8,13 @@
  *  Copyright (c) 2017 Christophe Ecabert. All rights reserved.
  */
 
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "facekit/core/logger.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/trace.hpp"
 #include "facekit/model/pca_model_factory.hpp"
 
 /**
@@ -15,7 +22,102 @@
  *  @brief      Development space
  */
 namespace FaceKit {
-  
+
+/** Registered proxies */
+template<typename T>
+StaticRegistry<const PCAModelProxy<T>*, PCAModelFactory<T>::kMaxProxy>
+PCAModelFactory<T>::proxies_;
+
+/**
+ * @name  CacheKey
+ * @brief Build the cache key of a model
+ * @param[in] path    Path to the model's file
+ * @param[in] options Load options
+ * @return    Key
+ */
+template<typename Options>
+static std::string CacheKey(const std::string& path, const Options& options) {
+  std::ostringstream key;
+  key << path << '\n' << options.name << '\n' << options.n_component << ':'
+      << options.map << ':' << options.offset << ':' << options.prescale;
+  return key.str();
+}
+
+#pragma mark -
+#pragma mark Handle
+
+/*
+ * @name  Handle
+ * @fn    Handle(const Handle& other)
+ * @brief Copy constructor, share the same model
+ * @param[in] other Object to copy from
+ */
+template<typename T>
+PCAModelFactory<T>::Handle::Handle(const Handle& other) :
+        entry_(other.entry_) {
+}
+
+/*
+ * @name  Handle
+ * @fn    Handle(Handle&& other)
+ * @brief Move constructor
+ * @param[in] other Object to move from
+ */
+template<typename T>
+PCAModelFactory<T>::Handle::Handle(Handle&& other) :
+        entry_(std::move(other.entry_)) {
+}
+
+/*
+ * @name  operator=
+ * @fn    Handle& operator=(const Handle& rhs)
+ * @brief Assignment operator
+ * @param[in] rhs Object to assign from
+ * @return    Newly assigned object
+ */
+template<typename T>
+typename PCAModelFactory<T>::Handle&
+PCAModelFactory<T>::Handle::operator=(const Handle& rhs) {
+  entry_ = rhs.entry_;
+  return *this;
+}
+
+/*
+ * @name  operator=
+ * @fn    Handle& operator=(Handle&& rhs)
+ * @brief Move assignment operator
+ * @param[in] rhs Object to move assign from
+ * @return    Newly moved-assign object
+ */
+template<typename T>
+typename PCAModelFactory<T>::Handle&
+PCAModelFactory<T>::Handle::operator=(Handle&& rhs) {
+  if (this != &rhs) {
+    entry_ = std::move(rhs.entry_);
+  }
+  return *this;
+}
+
+/*
+ * @name  ~Handle
+ * @fn    ~Handle(void)
+ * @brief Destructor, release the reference
+ */
+template<typename T>
+PCAModelFactory<T>::Handle::~Handle(void) = default;
+
+/*
+ * @name  get
+ * @fn    const Model* get(void) const
+ * @brief Referenced model
+ * @return    Model or nullptr if empty
+ */
+template<typename T>
+const typename PCAModelFactory<T>::Model*
+PCAModelFactory<T>::Handle::get(void) const {
+  return entry_ ? entry_->model : nullptr;
+}
+
 #pragma mark -
 #pragma mark Initialization
 
@@ -31,6 +133,16 @@ PCAModelFactory<T>& PCAModelFactory<T>::Get(void) {
   return factory;
 }
 
+/*
+ * @name  ~PCAModelFactory
+ * @fn    ~PCAModelFactory(void)
+ * @brief Destructor, release the cached models
+ */
+template<typename T>
+PCAModelFactory<T>::~PCAModelFactory(void) {
+  this->ClearCache();
+}
+
 #pragma mark -
 #pragma mark Usage
 
@@ -44,26 +156,229 @@ PCAModelFactory<T>& PCAModelFactory<T>::Get(void) {
 template<typename T>
 typename PCAModelFactory<T>::Model*
 PCAModelFactory<T>::CreateByName(const std::string& name) const {
-  Model* model = nullptr;
   const char* cname = name.c_str();
-  for (auto& p : proxies_) {
-    if (strcmp(cname, p->Name()) == 0) {
-      model = p->Create();
-      break;
-    }
-  }
-  return model;
+  const PCAModelProxy<T>* const* proxy =
+          proxies_.FindIf([cname](const PCAModelProxy<T>* p) {
+            return strcmp(cname, p->Name()) == 0;
+          });
+  return proxy ? (*proxy)->Create() : nullptr;
 }
 
 /*
  * @name  Register
- * @fn    void Register(const PCAModelProxy<T>* proxy)
+ * @fn    static void Register(const PCAModelProxy<T>* proxy)
  * @brief Register a new \p proxy with the factory
  * @param[in] proxy Proxy to register
  */
 template<typename T>
 void PCAModelFactory<T>::Register(const PCAModelProxy<T>* proxy) {
-  proxies_.push_back(proxy);
+  if (!proxies_.Add(proxy)) {
+    FACEKIT_LOG_ERROR("Too many model types, " << proxy->Name()
+                      << " is not registered");
+  }
+}
+
+/*
+ * @name  Acquire
+ * @fn    Status Acquire(const std::string& path, const LoadOptions& options,
+                         Handle* model)
+ * @brief Get the model stored in \p path from the cache, loading it on
+ *        first use. Concurrent calls for the same model load it once, the
+ *        others wait for it.
+ * @param[in] path    Path to the model's file
+ * @param[in] options How to create and load the model
+ * @param[out] model  Shared model
+ * @return    kInvalidArgument if the name is not registered, kInternalError
+ *            if loading failed. Failures are not cached.
+ */
+template<typename T>
+Status PCAModelFactory<T>::Acquire(const std::string& path,
+                                   const LoadOptions& options,
+                                   Handle* model) {
+  FACEKIT_TRACE_SCOPE("PCAModelFactory::Acquire");
+  const std::string key = CacheKey(path, options);
+  // Find or insert the entry, take a reference for the caller
+  RefPtr<Entry> entry;
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto it = cache_.find(key);
+    if (it == cache_.end()) {
+      it = cache_.emplace(key, MakeRef<Entry>()).first;
+    }
+    entry = it->second;
+    entry->last_use = ++clock_;
+  }
+  // Load once, concurrent callers wait on the entry
+  Status s;
+  {
+    std::lock_guard<std::mutex> lock(entry->load_mutex);
+    if (!entry->loaded) {
+      s = this->Load(path, options, entry.get());
+      entry->loaded = s.Good();
+      // Account for it only if not dropped by `ClearCache` meanwhile
+      std::lock_guard<std::mutex> c_lock(cache_mutex_);
+      auto it = cache_.find(key);
+      const bool cached = it != cache_.end() && it->second == entry;
+      if (s.Good() && cached) {
+        size_ += entry->bytes;
+        this->Evict();
+      } else if (!s.Good() && cached) {
+        // Do not cache failures, the next call tries again
+        cache_.erase(it);
+      }
+    }
+  }
+  if (!s.Good()) {
+    return s;
+  }
+  *model = Handle(std::move(entry));
+  return s;
+}
+
+/*
+ * @name  Preload
+ * @fn    void Preload(const std::vector<std::pair<std::string,
+                       LoadOptions>>& models)
+ * @brief Load \p models into the cache in the background, on the global
+ *        `ThreadPool` with low priority. Failures are logged.
+ * @param[in] models  List of path and options
+ */
+template<typename T>
+void PCAModelFactory<T>::Preload(const std::vector<std::pair<std::string,
+                                 LoadOptions>>& models) {
+  using TaskPriority = ThreadPool::TaskPriority;
+  auto load = [this](const std::string& path, const LoadOptions& options) {
+    Handle model;
+    Status s = this->Acquire(path, options, &model);
+    if (!s.Good()) {
+      FACEKIT_LOG_ERROR("Preload failed for " << path << ": "
+                        << s.ToString());
+    }
+  };
+  for (const auto& m : models) {
+    ThreadPool::Get().Submit(TaskPriority::kLow, load, m.first, m.second);
+  }
+}
+
+/*
+ * @name  ClearCache
+ * @fn    void ClearCache(void)
+ * @brief Drop every cached model, models still referenced by a handle are
+ *        released when their last handle goes away
+ */
+template<typename T>
+void PCAModelFactory<T>::ClearCache(void) {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  cache_.clear();
+  size_ = 0;
+}
+
+#pragma mark -
+#pragma mark Accessors
+
+/*
+ * @name  cache_budget
+ * @fn    size_t cache_budget(void) const
+ * @brief Memory budget of the cache in bytes
+ */
+template<typename T>
+size_t PCAModelFactory<T>::cache_budget(void) const {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  return budget_;
+}
+
+/*
+ * @name  set_cache_budget
+ * @fn    void set_cache_budget(const size_t& budget)
+ * @brief Set the memory budget of the cache in bytes, least recently used
+ *        idle models are evicted until it is met
+ */
+template<typename T>
+void PCAModelFactory<T>::set_cache_budget(const size_t& budget) {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  budget_ = budget;
+  this->Evict();
+}
+
+/*
+ * @name  cache_size
+ * @fn    size_t cache_size(void) const
+ * @brief Memory used by the cached models in bytes (estimated)
+ */
+template<typename T>
+size_t PCAModelFactory<T>::cache_size(void) const {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  return size_;
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ * @name  Load
+ * @fn    Status Load(const std::string& path, const LoadOptions& options,
+                      Entry* entry) const
+ * @brief Create and load the model of \p entry
+ */
+template<typename T>
+Status PCAModelFactory<T>::Load(const std::string& path,
+                                const LoadOptions& options,
+                                Entry* entry) const {
+  Model* model = this->CreateByName(options.name);
+  if (model == nullptr) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Unknown model type: " + options.name);
+  }
+  Status s;
+  if (options.map) {
+    s = model->Map(path, options.offset);
+  } else {
+    std::ifstream stream(path.c_str(), std::ios_base::binary);
+    if (!stream.is_open() ||
+        !stream.seekg(static_cast<std::streamoff>(options.offset)) ||
+        model->Load(stream, options.n_component) != 0) {
+      s = Status(Status::Type::kInternalError, "Can not load model: " + path);
+    }
+  }
+  if (s.Good() && options.prescale) {
+    s = model->PrescaleVariation();
+  }
+  if (!s.Good()) {
+    delete model;
+    return s;
+  }
+  // Prescaling keeps a second copy of the variation
+  const size_t bytes = model->ComputeObjectSize();
+  entry->bytes = options.prescale ? 2 * bytes : bytes;
+  entry->model = model;
+  return s;
+}
+
+/*
+ * @name  Evict
+ * @fn    void Evict(void)
+ * @brief Drop least recently used idle entries until the budget is met,
+ *        `cache_mutex_` must be held
+ */
+template<typename T>
+void PCAModelFactory<T>::Evict(void) {
+  while (size_ > budget_) {
+    // Idle: loaded and only referenced by the cache
+    auto victim = cache_.end();
+    for (auto it = cache_.begin(); it != cache_.end(); ++it) {
+      const Entry* e = it->second.get();
+      if (e->loaded && e->IsOne() &&
+          (victim == cache_.end() ||
+           e->last_use < victim->second->last_use)) {
+        victim = it;
+      }
+    }
+    if (victim == cache_.end()) {
+      break;
+    }
+    size_ -= victim->second->bytes;
+    cache_.erase(victim);
+  }
 }
 
 #pragma mark -
@@ -0,0 +1,586 @@
+/**
+ *  @file   rasterizer.cpp
+ *  @brief  CPU rasterization of a mesh seen by a camera into depth, triangle
+ *          index and barycentric buffers
+ *  @ingroup model
+ *
+ *  @author Christophe Ecabert
+ *  @date   05.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define HAS_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define HAS_AVX2
+#include <immintrin.h>
+#endif
+
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/trace.hpp"
+#include "facekit/model/orthographic_projection.hpp"
+#include "facekit/model/perspective_projection.hpp"
+#include "facekit/model/rasterizer.hpp"
+#include "facekit/model/weak_projection.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Tile size in pixels, a tile of every buffer fits in L1 */
+static constexpr int kTileSize = 32;
+/** Number of triangles set up by one parallel task */
+static constexpr size_t kSetupGrain = 4096;
+/** Number of vertices colored by one parallel task */
+static constexpr size_t kColorGrain = 2048;
+/** Number of vertices sampled at once */
+static constexpr int kColorBlock = 8;
+
+/**
+ *  @name   SampleBilinear
+ *  @fn     static void SampleBilinear(const cv::Mat& image, float u, float v,
+                                       float* bgr, const int& stride)
+ *  @brief  Bilinear sample of an 8-bit image at (u, v), in pixel index
+ *          coordinates, clamped to the border
+ *  @param[in] image  Image with 1, 3 or 4 channels
+ *  @param[in] u      Horizontal position
+ *  @param[in] v      Vertical position
+ *  @param[out] bgr   First three channels, gray is replicated
+ *  @param[in] stride Distance between two channels in \p bgr
+ */
+static void SampleBilinear(const cv::Mat& image,
+                           float u,
+                           float v,
+                           float* bgr,
+                           const int& stride) {
+  const int ch = image.channels();
+  u = std::min(std::max(u, 0.f), static_cast<float>(image.cols - 1));
+  v = std::min(std::max(v, 0.f), static_cast<float>(image.rows - 1));
+  const int x0 = static_cast<int>(u);
+  const int y0 = static_cast<int>(v);
+  const int x1 = std::min(x0 + 1, image.cols - 1);
+  const int y1 = std::min(y0 + 1, image.rows - 1);
+  const float ax = u - static_cast<float>(x0);
+  const float ay = v - static_cast<float>(y0);
+  const uint8_t* r0 = image.ptr<uint8_t>(y0);
+  const uint8_t* r1 = image.ptr<uint8_t>(y1);
+  for (int c = 0; c < 3; ++c) {
+    const int k = ch == 1 ? 0 : c;
+    const float p00 = r0[x0 * ch + k];
+    const float p01 = r0[x1 * ch + k];
+    const float p10 = r1[x0 * ch + k];
+    const float p11 = r1[x1 * ch + k];
+    const float top = p00 + ax * (p01 - p00);
+    const float bottom = p10 + ax * (p11 - p10);
+    bgr[c * stride] = top + ay * (bottom - top);
+  }
+}
+
+#ifdef HAS_AVX2
+/**
+ *  @name   SampleBilinear8
+ *  @fn     static void SampleBilinear8(const cv::Mat& image, const float* u,
+                                        const float* v, float* bgr)
+ *  @brief  Bilinear sample of eight positions at once, see
+ *          `SampleBilinear`. Each tap is gathered as a 32-bit word starting
+ *          at its first channel, therefore every tap must be followed by
+ *          at least four bytes of the image.
+ *  @param[in] image  Image with 1, 3 or 4 channels
+ *  @param[in] u      Horizontal positions [8]
+ *  @param[in] v      Vertical positions [8]
+ *  @param[out] bgr   First three channels, planar [3 x 8]
+ */
+static void SampleBilinear8(const cv::Mat& image,
+                            const float* u,
+                            const float* v,
+                            float* bgr) {
+  const int ch = image.channels();
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.f);
+  const __m256 uu = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(u), zero),
+                                  _mm256_set1_ps(float(image.cols - 1)));
+  const __m256 vv = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(v), zero),
+                                  _mm256_set1_ps(float(image.rows - 1)));
+  const __m256 fu = _mm256_floor_ps(uu);
+  const __m256 fv = _mm256_floor_ps(vv);
+  const __m256 ax = _mm256_sub_ps(uu, fu);
+  const __m256 ay = _mm256_sub_ps(vv, fv);
+  const __m256i x0 = _mm256_cvttps_epi32(fu);
+  const __m256i y0 = _mm256_cvttps_epi32(fv);
+  const __m256i i_one = _mm256_set1_epi32(1);
+  const __m256i x1 = _mm256_min_epi32(_mm256_add_epi32(x0, i_one),
+                                      _mm256_set1_epi32(image.cols - 1));
+  const __m256i y1 = _mm256_min_epi32(_mm256_add_epi32(y0, i_one),
+                                      _mm256_set1_epi32(image.rows - 1));
+  // Byte offset of each tap
+  const __m256i n_ch = _mm256_set1_epi32(ch);
+  const __m256i step = _mm256_set1_epi32(static_cast<int>(image.step[0]));
+  const __m256i c0 = _mm256_mullo_epi32(x0, n_ch);
+  const __m256i c1 = _mm256_mullo_epi32(x1, n_ch);
+  const __m256i r0 = _mm256_mullo_epi32(y0, step);
+  const __m256i r1 = _mm256_mullo_epi32(y1, step);
+  const int* base = reinterpret_cast<const int*>(image.data);
+  const __m256i t00 = _mm256_i32gather_epi32(base,
+                                             _mm256_add_epi32(r0, c0),
+                                             1);
+  const __m256i t01 = _mm256_i32gather_epi32(base,
+                                             _mm256_add_epi32(r0, c1),
+                                             1);
+  const __m256i t10 = _mm256_i32gather_epi32(base,
+                                             _mm256_add_epi32(r1, c0),
+                                             1);
+  const __m256i t11 = _mm256_i32gather_epi32(base,
+                                             _mm256_add_epi32(r1, c1),
+                                             1);
+  // Tap weights
+  const __m256 bx = _mm256_sub_ps(one, ax);
+  const __m256 by = _mm256_sub_ps(one, ay);
+  const __m256 w00 = _mm256_mul_ps(bx, by);
+  const __m256 w01 = _mm256_mul_ps(ax, by);
+  const __m256 w10 = _mm256_mul_ps(bx, ay);
+  const __m256 w11 = _mm256_mul_ps(ax, ay);
+  const __m256i mask = _mm256_set1_epi32(0xFF);
+  for (int c = 0; c < 3; ++c) {
+    const __m128i shift = _mm_cvtsi32_si128(ch == 1 ? 0 : 8 * c);
+    auto channel = [&](const __m256i& t) {
+      return _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(t, shift),
+                                                 mask));
+    };
+    __m256 acc = _mm256_mul_ps(w00, channel(t00));
+    acc = _mm256_add_ps(acc, _mm256_mul_ps(w01, channel(t01)));
+    acc = _mm256_add_ps(acc, _mm256_mul_ps(w10, channel(t10)));
+    acc = _mm256_add_ps(acc, _mm256_mul_ps(w11, channel(t11)));
+    _mm256_storeu_ps(bgr + c * kColorBlock, acc);
+  }
+}
+#endif
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ * @name  Render
+ * @fn    Status Render(const Mesh<T>& mesh, const Cam& camera,
+                        Buffers* buffers)
+ * @brief Rasterize \p mesh seen by \p camera
+ * @param[in] mesh        Mesh to render
+ * @param[in] camera      Camera
+ * @param[out] buffers    Depth, triangle and barycentric buffers
+ * @return    kInvalidArgument if the image size is invalid or a triangle
+ *            references a missing vertex
+ */
+template<typename T, template<typename U> class ProjType>
+Status Rasterizer<T, ProjType>::Render(const Mesh<T>& mesh,
+                                       const Cam& camera,
+                                       Buffers* buffers) {
+  FACEKIT_TRACE_SCOPE("Rasterizer::Render");
+  constexpr bool perspective = std::is_same<ProjType<T>,
+                                            PerspectiveProjection<T>>::value;
+  const auto& vertex = mesh.get_vertex();
+  const auto& tri = mesh.get_triangle();
+  const int n_vertex = static_cast<int>(vertex.size());
+  if (width_ <= 0 || height_ <= 0) {
+    return Status(Status::Type::kInvalidArgument, "Invalid image size");
+  }
+  for (const auto& t : tri) {
+    if (t.x_ < 0 || t.y_ < 0 || t.z_ < 0 ||
+        t.x_ >= n_vertex || t.y_ >= n_vertex || t.z_ >= n_vertex) {
+      return Status(Status::Type::kInvalidArgument,
+                    "Triangle references a missing vertex");
+    }
+  }
+  // Init buffers
+  buffers->depth.create(height_, width_, CV_32FC1);
+  buffers->depth.setTo(std::numeric_limits<float>::infinity());
+  buffers->triangle.create(height_, width_, CV_32SC1);
+  buffers->triangle.setTo(-1);
+  buffers->barycentric.create(height_, width_, CV_32FC2);
+  buffers->barycentric.setTo(0.f);
+  // Project vertices, keep depth
+  cv::Mat pts(3 * n_vertex,
+              1,
+              cv::DataType<T>::type,
+              const_cast<void*>(reinterpret_cast<const void*>(vertex.data())));
+  camera(pts, &proj_, &depth_);
+  const T* xy = reinterpret_cast<const T*>(proj_.data);
+  const T* zv = reinterpret_cast<const T*>(depth_.data);
+  // Set up triangles concurrently, discarded ones get an empty bounding box
+  const size_t n_tri = tri.size();
+  setup_.resize(n_tri);
+  ThreadPool::Get().ParallelFor(0,
+                                n_tri,
+                                kSetupGrain,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t i = first; i < last; ++i) {
+      const int idx[3] = {tri[i].x_, tri[i].y_, tri[i].z_};
+      Setup& s = setup_[i];
+      s.x0 = s.x1 = s.y0 = s.y1 = 0;
+      T x[3], y[3], z[3];
+      for (int k = 0; k < 3; ++k) {
+        x[k] = xy[2 * idx[k]];
+        y[k] = xy[2 * idx[k] + 1];
+        z[k] = zv[idx[k]];
+      }
+      if (perspective && (z[0] < options_.z_near ||
+                          z[1] < options_.z_near ||
+                          z[2] < options_.z_near)) {
+        continue;
+      }
+      const T area = (x[1] - x[0]) * (y[2] - y[0]) -
+                     (y[1] - y[0]) * (x[2] - x[0]);
+      if (!(std::abs(area) > T(0.0)) || !std::isfinite(area) ||
+          (options_.cull_backface && area < T(0.0))) {
+        continue;
+      }
+      // Pixel (i, j) is sampled at its center (i + 0.5, j + 0.5)
+      const T lo_x = std::min({x[0], x[1], x[2]});
+      const T hi_x = std::max({x[0], x[1], x[2]});
+      const T lo_y = std::min({y[0], y[1], y[2]});
+      const T hi_y = std::max({y[0], y[1], y[2]});
+      const T w = static_cast<T>(width_);
+      const T h = static_cast<T>(height_);
+      auto clamp = [](const T& v, const T& lo, const T& hi) {
+        return std::min(std::max(v, lo), hi);
+      };
+      s.x0 = static_cast<int>(std::ceil(clamp(lo_x - T(0.5), T(0.0), w)));
+      s.x1 = static_cast<int>(std::floor(clamp(hi_x - T(0.5), T(-1.0), w)));
+      s.y0 = static_cast<int>(std::ceil(clamp(lo_y - T(0.5), T(0.0), h)));
+      s.y1 = static_cast<int>(std::floor(clamp(hi_y - T(0.5), T(-1.0), h)));
+      s.x1 = std::min(s.x1 + 1, width_);
+      s.y1 = std::min(s.y1 + 1, height_);
+      if (s.x0 >= s.x1 || s.y0 >= s.y1) {
+        s.x0 = s.x1 = s.y0 = s.y1 = 0;
+        continue;
+      }
+      // l_k = area(p, v_k+1, v_k+2) / area
+      const T inv = T(1.0) / area;
+      for (int k = 0; k < 3; ++k) {
+        const int k1 = (k + 1) % 3;
+        const int k2 = (k + 2) % 3;
+        s.a[k] = static_cast<float>((y[k1] - y[k2]) * inv);
+        s.b[k] = static_cast<float>((x[k2] - x[k1]) * inv);
+        s.c[k] = static_cast<float>((x[k1] * y[k2] - x[k2] * y[k1]) * inv);
+        s.q[k] = perspective ? static_cast<float>(T(1.0) / z[k]) : 1.f;
+        s.d[k] = perspective ? 1.f : static_cast<float>(z[k]);
+      }
+    }
+  });
+  // Bin triangles into tiles, in mesh order
+  const int n_tx = (width_ + kTileSize - 1) / kTileSize;
+  const int n_ty = (height_ + kTileSize - 1) / kTileSize;
+  bins_.resize(n_tx * n_ty);
+  for (auto& b : bins_) {
+    b.clear();
+  }
+  for (size_t i = 0; i < n_tri; ++i) {
+    const Setup& s = setup_[i];
+    if (s.x0 >= s.x1) {
+      continue;
+    }
+    for (int ty = s.y0 / kTileSize; ty <= (s.y1 - 1) / kTileSize; ++ty) {
+      for (int tx = s.x0 / kTileSize; tx <= (s.x1 - 1) / kTileSize; ++tx) {
+        bins_[ty * n_tx + tx].push_back(static_cast<int>(i));
+      }
+    }
+  }
+  // Rasterize tiles concurrently, tiles do not share pixels
+  const int stride = width_;
+  float* depth = reinterpret_cast<float*>(buffers->depth.data);
+  int32_t* index = reinterpret_cast<int32_t*>(buffers->triangle.data);
+  float* bary = reinterpret_cast<float*>(buffers->barycentric.data);
+  ThreadPool::Get().ParallelFor(0,
+                                bins_.size(),
+                                1,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t t = first; t < last; ++t) {
+      const int tx0 = static_cast<int>(t % n_tx) * kTileSize;
+      const int ty0 = static_cast<int>(t / n_tx) * kTileSize;
+      const int tx1 = std::min(tx0 + kTileSize, width_);
+      const int ty1 = std::min(ty0 + kTileSize, height_);
+      for (const int id : bins_[t]) {
+        const Setup& s = setup_[id];
+        const int x0 = std::max(s.x0, tx0);
+        const int x1 = std::min(s.x1, tx1);
+        const int y0 = std::max(s.y0, ty0);
+        const int y1 = std::min(s.y1, ty1);
+        // Tiles start on a multiple of 4, full groups stay in the tile
+        const int xa = x0 & ~3;
+        const int xe = std::min(tx1, (x1 + 3) & ~3);
+        for (int py = y0; py < y1; ++py) {
+          const float fy = static_cast<float>(py) + 0.5f;
+          const float r0 = s.b[0] * fy + s.c[0];
+          const float r1 = s.b[1] * fy + s.c[1];
+          const float r2 = s.b[2] * fy + s.c[2];
+          float* z_row = depth + py * stride;
+          int32_t* i_row = index + py * stride;
+          float* b_row = bary + 2 * py * stride;
+          int px = xa;
+#ifdef HAS_SSE2
+          const __m128 offset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+          const __m128 zero = _mm_setzero_ps();
+          const __m128 one = _mm_set1_ps(1.f);
+          const __m128i vid = _mm_set1_epi32(id);
+          for (; px + 4 <= xe; px += 4) {
+            const __m128 fx = _mm_add_ps(_mm_set1_ps(float(px)), offset);
+            const __m128 l0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s.a[0]), fx),
+                                         _mm_set1_ps(r0));
+            const __m128 l1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s.a[1]), fx),
+                                         _mm_set1_ps(r1));
+            const __m128 l2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s.a[2]), fx),
+                                         _mm_set1_ps(r2));
+            const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(l0, zero),
+                                                        _mm_cmpge_ps(l1, zero)),
+                                             _mm_cmpge_ps(l2, zero));
+            if (_mm_movemask_ps(inside) == 0) {
+              continue;
+            }
+            // Perspective correction, q = 1 and d = z for affine cameras
+            const __m128 w0 = _mm_mul_ps(l0, _mm_set1_ps(s.q[0]));
+            const __m128 w1 = _mm_mul_ps(l1, _mm_set1_ps(s.q[1]));
+            const __m128 w2 = _mm_mul_ps(l2, _mm_set1_ps(s.q[2]));
+            const __m128 inv = _mm_div_ps(one,
+                                          _mm_add_ps(_mm_add_ps(w0, w1), w2));
+            const __m128 num = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(l0, _mm_set1_ps(s.d[0])),
+                               _mm_mul_ps(l1, _mm_set1_ps(s.d[1]))),
+                    _mm_mul_ps(l2, _mm_set1_ps(s.d[2])));
+            const __m128 z = _mm_mul_ps(num, inv);
+            const __m128 z_old = _mm_loadu_ps(z_row + px);
+            const __m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(z, z_old));
+            if (_mm_movemask_ps(pass) == 0) {
+              continue;
+            }
+            // Select new values where the depth test passes
+            _mm_storeu_ps(z_row + px, _mm_or_ps(_mm_and_ps(pass, z),
+                                                _mm_andnot_ps(pass, z_old)));
+            const __m128i mask = _mm_castps_si128(pass);
+            __m128i* i_dst = reinterpret_cast<__m128i*>(i_row + px);
+            const __m128i i_old = _mm_loadu_si128(i_dst);
+            _mm_storeu_si128(i_dst, _mm_or_si128(_mm_and_si128(mask, vid),
+                                                 _mm_andnot_si128(mask,
+                                                                  i_old)));
+            const __m128 b1 = _mm_mul_ps(w1, inv);
+            const __m128 b2 = _mm_mul_ps(w2, inv);
+            const __m128 m_lo = _mm_unpacklo_ps(pass, pass);
+            const __m128 m_hi = _mm_unpackhi_ps(pass, pass);
+            float* b_dst = b_row + 2 * px;
+            const __m128 b_lo = _mm_loadu_ps(b_dst);
+            const __m128 b_hi = _mm_loadu_ps(b_dst + 4);
+            _mm_storeu_ps(b_dst,
+                          _mm_or_ps(_mm_and_ps(m_lo, _mm_unpacklo_ps(b1, b2)),
+                                    _mm_andnot_ps(m_lo, b_lo)));
+            _mm_storeu_ps(b_dst + 4,
+                          _mm_or_ps(_mm_and_ps(m_hi, _mm_unpackhi_ps(b1, b2)),
+                                    _mm_andnot_ps(m_hi, b_hi)));
+          }
+#endif
+          for (; px < x1; ++px) {
+            const float fx = static_cast<float>(px) + 0.5f;
+            const float l0 = s.a[0] * fx + r0;
+            const float l1 = s.a[1] * fx + r1;
+            const float l2 = s.a[2] * fx + r2;
+            if (l0 < 0.f || l1 < 0.f || l2 < 0.f) {
+              continue;
+            }
+            const float w1 = l1 * s.q[1];
+            const float w2 = l2 * s.q[2];
+            const float inv = 1.f / (l0 * s.q[0] + w1 + w2);
+            const float z = (l0 * s.d[0] + l1 * s.d[1] + l2 * s.d[2]) * inv;
+            if (z < z_row[px]) {
+              z_row[px] = z;
+              i_row[px] = id;
+              b_row[2 * px] = w1 * inv;
+              b_row[2 * px + 1] = w2 * inv;
+            }
+          }
+        }
+      }
+    }
+  });
+  return Status();
+}
+
+/*
+ * @name  Visibility
+ * @fn    void Visibility(const Buffers& buffers,
+                          const std::vector<int>& vertex,
+                          const T& tolerance,
+                          std::vector<uint8_t>* visible) const
+ * @brief Check which \p vertex are visible in the last `Render`
+ * @param[in] buffers     Output of the last `Render`
+ * @param[in] vertex      Vertex indices
+ * @param[in] tolerance   Depth tolerance, in model units
+ * @param[out] visible    1 if visible, 0 otherwise, for each vertex
+ */
+template<typename T, template<typename U> class ProjType>
+void Rasterizer<T, ProjType>::Visibility(const Buffers& buffers,
+                                         const std::vector<int>& vertex,
+                                         const T& tolerance,
+                                         std::vector<uint8_t>* visible) const {
+  constexpr bool perspective = std::is_same<ProjType<T>,
+                                            PerspectiveProjection<T>>::value;
+  visible->assign(vertex.size(), 0);
+  const cv::Mat& zbuffer = buffers.depth;
+  const int n_vertex = depth_.rows;
+  const T* xy = reinterpret_cast<const T*>(proj_.data);
+  const T* zv = reinterpret_cast<const T*>(depth_.data);
+  for (size_t i = 0; i < vertex.size(); ++i) {
+    const int v = vertex[i];
+    if (v < 0 || v >= n_vertex || (perspective && zv[v] < options_.z_near)) {
+      continue;
+    }
+    const T x = std::floor(xy[2 * v]);
+    const T y = std::floor(xy[2 * v + 1]);
+    if (!(x >= T(0.0) && x < T(zbuffer.cols) &&
+          y >= T(0.0) && y < T(zbuffer.rows))) {
+      continue;
+    }
+    const float z = zbuffer.at<float>(static_cast<int>(y),
+                                      static_cast<int>(x));
+    (*visible)[i] = zv[v] <= T(z) + tolerance ? 1 : 0;
+  }
+}
+
+/*
+ * @name  SampleColor
+ * @fn    Status SampleColor(const Buffers& buffers, const cv::Mat& image,
+                             const T& tolerance, Mesh<T>* mesh,
+                             std::vector<uint8_t>* visible) const
+ * @brief Color every vertex of the mesh given to the last `Render` with
+ *        \p image
+ * @param[in] buffers     Output of the last `Render`
+ * @param[in] image       Image of the render's size, CV_8UC1, CV_8UC3
+ *                        (BGR) or CV_8UC4 (BGRA)
+ * @param[in] tolerance   Depth tolerance, in model units
+ * @param[in,out] mesh    Rendered mesh, receives its vertex colors
+ * @param[out] visible    1 if visible, 0 otherwise, for each vertex. Can
+ *                        be nullptr
+ * @return    kInvalidArgument if \p image or \p mesh does not match the
+ *            last `Render`
+ */
+template<typename T, template<typename U> class ProjType>
+Status Rasterizer<T, ProjType>::SampleColor(const Buffers& buffers,
+                                            const cv::Mat& image,
+                                            const T& tolerance,
+                                            Mesh<T>* mesh,
+                                            std::vector<uint8_t>* visible)
+                                            const {
+  FACEKIT_TRACE_SCOPE("Rasterizer::SampleColor");
+  using Color = typename Mesh<T>::Color;
+  constexpr bool perspective = std::is_same<ProjType<T>,
+                                            PerspectiveProjection<T>>::value;
+  const int n_vertex = depth_.rows;
+  const int ch = image.channels();
+  if (image.depth() != CV_8U || (ch != 1 && ch != 3 && ch != 4) ||
+      image.cols != width_ || image.rows != height_ ||
+      buffers.depth.cols != width_ || buffers.depth.rows != height_) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Image must be 8-bit with 1, 3 or 4 channels and of the "
+                  "rendered size");
+  }
+  if (mesh->get_vertex().size() != static_cast<size_t>(n_vertex)) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Mesh must be the one given to the last Render");
+  }
+  auto& color = mesh->get_vertex_color();
+  color.resize(n_vertex);
+  if (visible) {
+    visible->resize(n_vertex);
+  }
+  const cv::Mat& zbuffer = buffers.depth;
+  const T* xy = reinterpret_cast<const T*>(proj_.data);
+  const T* zv = reinterpret_cast<const T*>(depth_.data);
+  const T w = static_cast<T>(width_);
+  const T h = static_cast<T>(height_);
+  // Last rows may not leave room for a 32-bit gather after a tap
+  const float gather_v = ch == 4 ?
+                         std::numeric_limits<float>::max() :
+                         static_cast<float>(height_ - 2);
+  const T scale = T(1.0) / T(255.0);
+  ThreadPool::Get().ParallelFor(0,
+                                static_cast<size_t>(n_vertex),
+                                kColorGrain,
+                                [&](const size_t& first, const size_t& last) {
+    float u[kColorBlock];
+    float v[kColorBlock];
+    float bgr[3 * kColorBlock];
+    uint8_t vis[kColorBlock];
+    for (size_t b = first; b < last; b += kColorBlock) {
+      const int n = static_cast<int>(std::min(last - b,
+                                              size_t(kColorBlock)));
+      bool gather = n == kColorBlock;
+      for (int k = 0; k < n; ++k) {
+        // Same test as `Visibility`
+        const size_t i = b + k;
+        const T x = std::floor(xy[2 * i]);
+        const T y = std::floor(xy[2 * i + 1]);
+        vis[k] = 0;
+        if ((!perspective || zv[i] >= options_.z_near) &&
+            x >= T(0.0) && x < w && y >= T(0.0) && y < h) {
+          const float z = zbuffer.at<float>(static_cast<int>(y),
+                                            static_cast<int>(x));
+          vis[k] = zv[i] <= T(z) + tolerance ? 1 : 0;
+        }
+        // Pixel (i, j) is centered on (i + 0.5, j + 0.5)
+        u[k] = vis[k] ? static_cast<float>(xy[2 * i]) - 0.5f : 0.f;
+        v[k] = vis[k] ? static_cast<float>(xy[2 * i + 1]) - 0.5f : 0.f;
+        gather &= v[k] < gather_v;
+      }
+#ifdef HAS_AVX2
+      if (gather) {
+        SampleBilinear8(image, u, v, bgr);
+      } else
+#endif
+      {
+        for (int k = 0; k < n; ++k) {
+          if (vis[k]) {
+            SampleBilinear(image, u[k], v[k], &bgr[k], kColorBlock);
+          }
+        }
+      }
+      for (int k = 0; k < n; ++k) {
+        color[b + k] = vis[k] ?
+                       Color(T(bgr[2 * kColorBlock + k]) * scale,
+                             T(bgr[kColorBlock + k]) * scale,
+                             T(bgr[k]) * scale,
+                             T(1.0)) :
+                       Color(T(0.0), T(0.0), T(0.0), T(0.0));
+        if (visible) {
+          (*visible)[b + k] = vis[k];
+        }
+      }
+    }
+  });
+  // Colors are part of the interleaved vertex buffer
+  mesh->MarkDirty(0, static_cast<size_t>(n_vertex));
+  return Status();
+}
+
+#pragma mark -
+#pragma mark Explicit Instantiation
+
+/** Float - Ortho */
+template class Rasterizer<float, OrthographicProjection>;
+/** Double - Ortho */
+template class Rasterizer<double, OrthographicProjection>;
+
+/** Float - Weak */
+template class Rasterizer<float, WeakProjection>;
+/** Double - Weak */
+template class Rasterizer<double, WeakProjection>;
+
+/** Float - Perspective */
+template class Rasterizer<float, PerspectiveProjection>;
+/** Double - Perspective */
+template class Rasterizer<double, PerspectiveProjection>;
+
+}  // namespace FaceKit
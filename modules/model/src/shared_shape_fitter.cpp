@@ -0,0 +1,197 @@
+/**
+ *  @file   shared_shape_fitter.cpp
+ *  @brief  Fit one shape seen by several cameras (i.e. multi-view rig or
+ *          video frames)
+ *  @ingroup    model
+ *
+ *  @author Christophe Ecabert
+ *  @date   03.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "facekit/core/math/linear_algebra.hpp"
+#include "facekit/core/mem/cv_allocator.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/trace.hpp"
+#include "facekit/model/orthographic_projection.hpp"
+#include "facekit/model/perspective_projection.hpp"
+#include "facekit/model/shared_shape_fitter.hpp"
+#include "facekit/model/weak_projection.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Number of views processed by one parallel task, eliminating a camera is
+    O(n_landmark * k^2) */
+static constexpr size_t kViewGrain = 1;
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ * @name  Fit
+ * @fn    Status Fit(const PCAModel<T>& model, const Subset& landmarks,
+                     const std::vector<View>& views, cv::Mat* p,
+                     FitSummary* summary) const
+ * @brief Estimate the shared shape coefficients and every camera
+ * @param[in] model       Shape model, provides the prior
+ * @param[in] landmarks   Landmark sub-model, see `PCAModel::BuildSubset`
+ * @param[in] views       Views, cameras must be distinct
+ * @param[in,out] p       Shape coefficients, initial guess [k x 1]
+ * @param[out] summary    Stopping statistics, can be nullptr
+ * @return    kInvalidArgument if a view is malformed, kInternalError if
+ *            the system is singular
+ */
+template<typename T, template<typename U> class ProjType>
+Status SharedShapeFitter<T, ProjType>::Fit(const PCAModel<T>& model,
+                                           const Subset& landmarks,
+                                           const std::vector<View>& views,
+                                           cv::Mat* p,
+                                           FitSummary* summary) const {
+  FACEKIT_TRACE_SCOPE("SharedShapeFitter::Fit");
+  // Temporaries of the iterations come from the pool
+  ScopedCvAllocator pool(CvAllocator::Pooled());
+  using Solver = typename LinearAlgebra<T>::CholeskySolver;
+  using ShapeBlock = typename Cam::ShapeBlock;
+  const int type = cv::DataType<T>::type;
+  const cv::Mat& basis = landmarks.variation;
+  const int n3 = landmarks.mean.rows / 3;
+  if (model.get_n_channels() != 3 || views.empty()) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Shape model and at least one view are required");
+  }
+  for (const auto& v : views) {
+    if (v.camera == nullptr || v.proj.type() != type ||
+        !v.proj.isContinuous() || v.proj.total() != size_t(2 * n3)) {
+      return Status(Status::Type::kInvalidArgument,
+                    "View must hold 2N projections of the model's type and "
+                    "a camera");
+    }
+  }
+  if (p->empty()) {
+    p->create(basis.cols, 1, type);
+    p->setTo(T(0.0));
+  }
+  const int k = static_cast<int>(p->total());
+  if (!p->isContinuous() || p->type() != type || k > basis.cols) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Coefficients must be a continuous vector of at most "
+                  "n_principal_component elements");
+  }
+  T* coef = reinterpret_cast<T*>(p->data);
+  const T* prior = reinterpret_cast<const T*>(model.get_prior().data);
+  const T* mean = reinterpret_cast<const T*>(landmarks.mean.data);
+  // Init solver
+  const size_t n_view = views.size();
+  std::vector<ShapeBlock> blocks(n_view);
+  std::vector<int> status(n_view);
+  std::vector<T> w(k);
+  cv::Mat pts(3 * n3, 1, type);
+  cv::Mat a(k, k, type);
+  cv::Mat b(k, 1, type);
+  cv::Mat dp;
+  Solver solver;
+  FitSummary stat;
+  T res = std::numeric_limits<T>::max();
+  T prev_res = std::numeric_limits<T>::min();
+  while (stat.n_iter < options_.max_iter &&
+         std::abs(res - prev_res) > options_.eps) {
+    // Shared landmarks: mean + V * (prior .* p)
+    for (int j = 0; j < k; ++j) {
+      w[j] = prior[j] * coef[j];
+    }
+    T* dst = reinterpret_cast<T*>(pts.data);
+    for (int r = 0; r < 3 * n3; ++r) {
+      const T* v = basis.ptr<T>(r);
+      T acc = mean[r];
+      for (int j = 0; j < k; ++j) {
+        acc += v[j] * w[j];
+      }
+      dst[r] = acc;
+    }
+    // Eliminate every camera concurrently
+    ThreadPool::Get().ParallelFor(0,
+                                  n_view,
+                                  kViewGrain,
+                                  [&](const size_t& first,
+                                      const size_t& last) {
+      for (size_t i = first; i < last; ++i) {
+        status[i] = views[i].camera->EliminateCamera(basis, prior, pts,
+                                                     views[i].proj, k,
+                                                     &blocks[i]);
+      }
+    });
+    // Reduced system: sum_v S_v + eta I, sum_v r_v - eta p
+    a.setTo(T(0.0));
+    b.setTo(T(0.0));
+    T sq = T(0.0);
+    for (size_t i = 0; i < n_view; ++i) {
+      if (status[i] != 0) {
+        return Status(Status::Type::kInternalError,
+                      "Camera block is singular");
+      }
+      a += blocks[i].s;
+      b += blocks[i].r;
+      sq += blocks[i].sq_error;
+    }
+    for (int j = 0; j < k; ++j) {
+      a.at<T>(j, j) += options_.eta;
+      b.at<T>(j) -= options_.eta * coef[j];
+    }
+    solver.Solve(a, b, &dp);
+    if (dp.empty()) {
+      return Status(Status::Type::kInternalError,
+                    "Reduced shape system is not positive definite");
+    }
+    // Back-substitute the cameras, then update the shape
+    const T* dp_ptr = reinterpret_cast<const T*>(dp.data);
+    ThreadPool::Get().ParallelFor(0,
+                                  n_view,
+                                  kViewGrain,
+                                  [&](const size_t& first,
+                                      const size_t& last) {
+      for (size_t i = first; i < last; ++i) {
+        views[i].camera->BackSubstitute(blocks[i], dp_ptr);
+      }
+    });
+    for (int j = 0; j < k; ++j) {
+      coef[j] += dp_ptr[j];
+    }
+    ++stat.n_iter;
+    prev_res = res;
+    res = std::sqrt(sq / T(n3 * n_view));
+  }
+  stat.rms = res;
+  stat.converged = std::abs(res - prev_res) <= options_.eps;
+  if (summary) {
+    *summary = stat;
+  }
+  return Status();
+}
+
+#pragma mark -
+#pragma mark Explicit Instantiation
+
+/** Float - Ortho */
+template class SharedShapeFitter<float, OrthographicProjection>;
+/** Double - Ortho */
+template class SharedShapeFitter<double, OrthographicProjection>;
+
+/** Float - Weak */
+template class SharedShapeFitter<float, WeakProjection>;
+/** Double - Weak */
+template class SharedShapeFitter<double, WeakProjection>;
+
+/** Float - Perspective */
+template class SharedShapeFitter<float, PerspectiveProjection>;
+/** Double - Perspective */
+template class SharedShapeFitter<double, PerspectiveProjection>;
+
+}  // namespace FaceKit
@@ -0,0 +1,336 @@
+/**
+ *  @file   texture_pca_model.cpp
+ *  @brief  Statistical texture model generating straight into 8-bit images
+ *  @ingroup model
+ *
+ *  @author Christophe Ecabert
+ *  @date   04.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "facekit/core/logger.hpp"
+#include "facekit/core/math/linear_algebra.hpp"
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/core/trace.hpp"
+#include "facekit/model/texture_pca_model.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Target number of values generated per band, the floating point tile
+    stays in L1 between the product and the saturation */
+static constexpr size_t kBandSize = 4096;
+
+/**
+ * @name  Saturate
+ * @fn    template<typename T> static void Saturate(const T* src,
+                                                    const T& scale,
+                                                    const size_t& n,
+                                                    uint8_t* dst)
+ * @brief Round and clamp to [0, 255], branch free so the compiler
+ *        vectorizes it. NaN gives 0.
+ * @param[in] src     Values
+ * @param[in] scale   Factor applied before rounding
+ * @param[in] n       Number of values
+ * @param[out] dst    Saturated values
+ */
+template<typename T>
+static void Saturate(const T* src,
+                     const T& scale,
+                     const size_t& n,
+                     uint8_t* dst) {
+  for (size_t i = 0; i < n; ++i) {
+    T v = std::max(T(0.0), src[i] * scale + T(0.5));
+    dst[i] = static_cast<uint8_t>(std::min(T(255.0), v));
+  }
+}
+
+/**
+ * @name  SaturateHalf
+ * @fn    template<typename T> static void SaturateHalf(const T* src,
+                                   const T& scale, const size_t& width,
+                                   const size_t& n_rows, const int& n_ch,
+                                   uint8_t* dst)
+ * @brief Average 2x2 blocks of pixels then round and clamp to [0, 255]
+ * @param[in] src     Full resolution rows [n_rows x width x n_ch], n_rows
+ *                    is even
+ * @param[in] scale   Factor applied before rounding
+ * @param[in] width   Full resolution width
+ * @param[in] n_rows  Number of full resolution rows
+ * @param[in] n_ch    Number of channels
+ * @param[out] dst    Half resolution rows [n_rows/2 x width/2 x n_ch]
+ */
+template<typename T>
+static void SaturateHalf(const T* src,
+                         const T& scale,
+                         const size_t& width,
+                         const size_t& n_rows,
+                         const int& n_ch,
+                         uint8_t* dst) {
+  const size_t stride = width * n_ch;
+  const size_t half_w = width / 2;
+  const T s = T(0.25) * scale;
+  for (size_t r = 0; r + 1 < n_rows; r += 2) {
+    const T* r0 = src + r * stride;
+    const T* r1 = r0 + stride;
+    uint8_t* out = dst + (r / 2) * half_w * n_ch;
+    for (size_t x = 0; x < half_w; ++x) {
+      for (int c = 0; c < n_ch; ++c) {
+        const size_t i = 2 * x * n_ch + c;
+        const T sum = r0[i] + r0[i + n_ch] + r1[i] + r1[i + n_ch];
+        T v = std::max(T(0.0), sum * s + T(0.5));
+        out[x * n_ch + c] = static_cast<uint8_t>(std::min(T(255.0), v));
+      }
+    }
+  }
+}
+
+#pragma mark -
+#pragma mark Initialization
+
+/*
+ * @name  SetSize
+ * @fn    Status SetSize(const size_t& width, const size_t& height)
+ * @brief Set the texture layout of the loaded model
+ * @param[in] width   Texture width
+ * @param[in] height  Texture height
+ * @return    kInvalidArgument if the layout does not match the model
+ */
+template<typename T>
+Status TexturePCAModel<T>::SetSize(const size_t& width, const size_t& height) {
+  const int n_ch = this->n_channels_;
+  if ((n_ch != 1 && n_ch != 3 && n_ch != 4) ||
+      width * height * n_ch != this->mean_.total()) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Texture size does not match the model's dimension");
+  }
+  width_ = width;
+  height_ = height;
+  return Status();
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ * @name  Generate
+ * @fn    Status Generate(const cv::Mat& p, const bool& half,
+                          Workspace* ws, NDArray* image) const
+ * @brief Generate a texture given a set of coefficients \p p, reentrant
+ * @param[in] p           Model's coefficients
+ * @param[in] half        If true, output is at half the resolution
+ * @param[in,out] ws      Caller's scratch buffers
+ * @param[out] image      Texture [height x width x n_channels]
+ * @return    kInvalidArgument if the texture size is not set or \p p does
+ *            not match the model
+ */
+template<typename T>
+Status TexturePCAModel<T>::Generate(const cv::Mat& p,
+                                    const bool& half,
+                                    Workspace* ws,
+                                    NDArray* image) const {
+  Status s = this->CheckInput(p);
+  if (!s.Good()) {
+    return s;
+  }
+  const size_t out_w = half ? width_ / 2 : width_;
+  const size_t out_h = half ? height_ / 2 : height_;
+  image->Resize(DataType::kUInt8,
+                {out_h, out_w, static_cast<size_t>(this->n_channels_)});
+  if (out_w != 0 && out_h != 0) {
+    this->Render(p, half, ws, image->AsFlat<uint8_t>().data());
+  }
+  return Status();
+}
+
+/*
+ * @name  Generate
+ * @fn    Status Generate(const cv::Mat& p, const bool& half,
+                          NDArray* image)
+ * @brief Generate a texture given a set of coefficients \p p. Uses a
+ *        per-thread workspace.
+ * @param[in] p           Model's coefficients
+ * @param[in] half        If true, output is at half the resolution
+ * @param[out] image      Texture [height x width x n_channels]
+ * @return    kInvalidArgument if the texture size is not set or \p p does
+ *            not match the model
+ */
+template<typename T>
+Status TexturePCAModel<T>::Generate(const cv::Mat& p,
+                                    const bool& half,
+                                    NDArray* image) {
+  thread_local Workspace ws;
+  return this->Generate(p, half, &ws, image);
+}
+
+/*
+ * @name  Generate
+ * @fn    Status Generate(const cv::Mat& p, const bool& half, Image* image)
+ * @brief Generate a texture given a set of coefficients \p p into the
+ *        pixel buffer of an existing \p image
+ * @param[in] p           Model's coefficients
+ * @param[in] half        If true, output is at half the resolution
+ * @param[in,out] image   Image whose size and format match the texture
+ * @return    kInvalidArgument if \p image does not match the texture
+ */
+template<typename T>
+Status TexturePCAModel<T>::Generate(const cv::Mat& p,
+                                    const bool& half,
+                                    Image* image) {
+  Status s = this->CheckInput(p);
+  if (!s.Good()) {
+    return s;
+  }
+  const size_t out_w = half ? width_ / 2 : width_;
+  const size_t out_h = half ? height_ / 2 : height_;
+  if (image->width() != out_w || image->height() != out_h ||
+      static_cast<int>(image->format()) != this->n_channels_) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Image does not match the texture's size and format");
+  }
+  if (out_w != 0 && out_h != 0) {
+    thread_local Workspace ws;
+    this->Render(p, half, &ws, image->data());
+  }
+  return Status();
+}
+
+/*
+ * @name  Generate
+ * @fn    void Generate(const cv::Mat& p, Mesh<T>* instance) override
+ * @brief Textures live in image space, not supported
+ * @param[in] p           Model's coefficients
+ * @param[out] instance   Left untouched
+ */
+template<typename T>
+void TexturePCAModel<T>::Generate(const cv::Mat& p, Mesh<T>* instance) {
+  FACEKIT_LOG_ERROR("TexturePCAModel can not generate a mesh");
+}
+
+/*
+ * @name  Generate
+ * @fn    void Generate(Mesh<T>* instance) override
+ * @brief Textures live in image space, not supported
+ * @param[out] instance   Left untouched
+ */
+template<typename T>
+void TexturePCAModel<T>::Generate(Mesh<T>* instance) {
+  FACEKIT_LOG_ERROR("TexturePCAModel can not generate a mesh");
+}
+
+#pragma mark -
+#pragma mark Private
+
+/*
+ * @name  CheckInput
+ * @fn    Status CheckInput(const cv::Mat& p) const
+ * @brief Check the texture layout and the coefficients
+ * @param[in] p   Model's coefficients
+ * @return    kInvalidArgument if the texture size is not set or \p p does
+ *            not match the model
+ */
+template<typename T>
+Status TexturePCAModel<T>::CheckInput(const cv::Mat& p) const {
+  if (width_ == 0 || height_ == 0 ||
+      width_ * height_ * this->n_channels_ != this->mean_.total()) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Texture size is not set or does not match the model");
+  }
+  if (p.type() != cv::DataType<T>::type || !p.isContinuous() ||
+      p.total() != size_t(this->variation_.cols)) {
+    return Status(Status::Type::kInvalidArgument,
+                  "Coefficients do not match the model");
+  }
+  return Status();
+}
+
+/*
+ * @name  Render
+ * @fn    void Render(const cv::Mat& p, const bool& half, Workspace* ws,
+                      uint8_t* dst) const
+ * @brief Generate the texture band by band into \p dst
+ * @param[in] p       Model's coefficients, checked
+ * @param[in] half    If true, output is at half the resolution
+ * @param[in,out] ws  Caller's scratch buffers
+ * @param[out] dst    Interleaved 8-bit pixels, allocated by the caller
+ */
+template<typename T>
+void TexturePCAModel<T>::Render(const cv::Mat& p,
+                                const bool& half,
+                                Workspace* ws,
+                                uint8_t* dst) const {
+  FACEKIT_TRACE_SCOPE("TexturePCAModel::Generate");
+  using LA = typename FaceKit::LinearAlgebra<T>;
+  using TType = typename FaceKit::LinearAlgebra<T>::TransposeType;
+  const int type = cv::DataType<T>::type;
+  const int n_ch = this->n_channels_;
+  const size_t stride = width_ * n_ch;
+  const size_t out_w = half ? width_ / 2 : width_;
+  const size_t out_h = half ? height_ / 2 : height_;
+  const T* mean = reinterpret_cast<const T*>(this->mean_.data);
+  if (this->IsQuantized()) {
+    // Quantized basis can not be split by rows, generate at once
+    ws->p.create(this->mean_.rows, this->mean_.cols, type);
+    PCAModel<T>::Generate(p, ws, reinterpret_cast<T*>(ws->p.data));
+    const T* src = reinterpret_cast<const T*>(ws->p.data);
+    if (half) {
+      SaturateHalf(src, scale_, width_, 2 * out_h, n_ch, dst);
+    } else {
+      Saturate(src, scale_, stride * height_, dst);
+    }
+    return;
+  }
+  // Coefficients, prior is already in the basis when prescaled
+  const cv::Mat* coef = &p;
+  if (!this->IsPrescaled()) {
+    LA::Sbmv(this->prior_, T(1.0), p, T(0.0), &ws->coef);
+    coef = &ws->coef;
+  }
+  const cv::Mat& basis = this->IsPrescaled() ? this->s_variation_ :
+                                               this->variation_;
+  // Bands of an even number of rows, so that half resolution blocks never
+  // straddle two bands
+  const size_t band = std::max<size_t>(2, (kBandSize / stride) & ~size_t(1));
+  const size_t n_row = half ? 2 * out_h : height_;
+  const size_t n_band = (n_row + band - 1) / band;
+  ThreadPool::Get().ParallelFor(0,
+                                n_band,
+                                1,
+                                [&](const size_t& first, const size_t& last) {
+    std::vector<T> tile(band * stride);
+    for (size_t b = first; b < last; ++b) {
+      const size_t r0 = b * band;
+      const size_t nr = std::min(band, n_row - r0);
+      const int e0 = static_cast<int>(r0 * stride);
+      const int e1 = static_cast<int>((r0 + nr) * stride);
+      // tile = mean + V_band * coef
+      cv::Mat out(e1 - e0, 1, type, tile.data());
+      std::copy(mean + e0, mean + e1, tile.data());
+      LA::Gemv(basis.rowRange(e0, e1), TType::kNoTranspose, T(1.0), *coef,
+               T(1.0), &out);
+      if (half) {
+        SaturateHalf(tile.data(), scale_, width_, nr, n_ch,
+                     dst + (r0 / 2) * out_w * n_ch);
+      } else {
+        Saturate(tile.data(), scale_, nr * stride, dst + r0 * stride);
+      }
+    }
+  });
+}
+
+#pragma mark -
+#pragma mark Explicit instantiation
+
+/** Float */
+template class TexturePCAModel<float>;
+/** Double */
+template class TexturePCAModel<double>;
+
+}  // namespace FaceKit
@@ -345,6 +345,8 @@ int main(const int argc, const char** argv) {
       params.n_max_fitness_generation = 10;
       params.percentage_fitness = 0.1;
       FK::GeneticSolver<T> solver(100, 16, fcn);
+      std::ofstream log("log.txt");
+      solver.set_observer(FK::GeneticSolver<T>::CsvObserver(&log));
       solver.Solve(params);
       
       // Print solution
@@ -375,6 +377,8 @@ int main(const int argc, const char** argv) {
       params.n_max_fitness_generation = 5;
       params.percentage_fitness = 0.0;
       FK::GeneticSolver<T> solver(50, data.size(), fcn);
+      std::ofstream log("log.txt");
+      solver.set_observer(FK::GeneticSolver<T>::CsvObserver(&log));
       solver.Solve(params);
 
       // Print solution
@@ -11,6 +11,7 @@
 #ifndef __FACEKIT_CHROMOSOME__
 #define __FACEKIT_CHROMOSOME__
 
+#include <algorithm>
 #include <cstdio>
 #include <vector>
 #include <iostream>
@@ -24,9 +25,16 @@
  */
 namespace FaceKit {
   
+/** Forward declaration */
+template<typename T>
+class Population;
+  
 /**
  *  @class  Chromosome
- *  @brief  Chromosome abstraction for Genetic Algorithm solver
+ *  @brief  Chromosome abstraction for Genetic Algorithm solver. Genes are
+ *          stored in the chromosome until it is added to a `Population`, the
+ *          chromosome is then a view on its row of the population's
+ *          contiguous genome.
  *  @author Christophe Ecabert
  *  @date   09/04/18
  *  @ingroup optimisation
@@ -45,7 +53,11 @@ class FK_EXPORTS Chromosome {
    *  @brief  Constructor
    *  @param[in] size Size of the chromosome
    */
-  Chromosome(const size_t& size) : state_(size) {}
+  Chromosome(const size_t& size) : own_(size),
+                                   state_(own_.data()),
+                                   size_(size),
+                                   fitness_(0.0),
+                                   dirty_(true) {}
   
   /**
    *  @name   Chromosome
@@ -104,6 +116,16 @@ class FK_EXPORTS Chromosome {
    */
   virtual void Mutate(const size_t& i) = 0;
   
+  /**
+   *  @name   Invalidate
+   *  @fn     void Invalidate(void)
+   *  @brief  Indicate the genes were modified outside of the `Population`
+   *          (i.e. through `at()`), the fitness is then evaluated again
+   */
+  void Invalidate(void) {
+    dirty_ = true;
+  }
+  
 #pragma mark -
 #pragma mark Accessors
   
@@ -114,7 +136,7 @@ class FK_EXPORTS Chromosome {
    *  @return Size
    */
   size_t size(void) const {
-    return state_.size();
+    return size_;
   }
   
   /**
@@ -139,13 +161,56 @@ class FK_EXPORTS Chromosome {
     return state_[i];
   }
   
+  /**
+   *  @name   data
+   *  @fn     const T* data(void) const
+   *  @brief  Access the genes, `size()` contiguous values
+   *  @return Genes
+   */
+  const T* data(void) const {
+    return state_;
+  }
+  
+  /**
+   *  @name   data
+   *  @fn     T* data(void)
+   *  @brief  Access the genes, `size()` contiguous values
+   *  @return Genes
+   */
+  T* data(void) {
+    return state_;
+  }
   
 #pragma mark -
 #pragma mark Protected
   
  protected:
-  /** Chromosome state */
-  std::vector<T> state_;
+  /** Own storage, used until bound to a population */
+  std::vector<T> own_;
+  /** Genes, either `own_` or a row of the population's genome */
+  T* state_;
+  /** Number of genes */
+  size_t size_;
+  
+ private:
+  /** Last fitness evaluated */
+  T fitness_;
+  /** Indicate if the genes changed since `fitness_` was evaluated */
+  bool dirty_;
+  /** Population binds chromosomes to its genome */
+  friend class Population<T>;
+  
+  /**
+   *  @name   Bind
+   *  @fn     void Bind(T* genes)
+   *  @brief  Move the genes to an external storage of `size()` values
+   *  @param[in] genes  New storage, must outlive the chromosome
+   */
+  void Bind(T* genes) {
+    std::copy(state_, state_ + size_, genes);
+    state_ = genes;
+    std::vector<T>().swap(own_);
+  }
 };
 
 }  // namespace FaceKit
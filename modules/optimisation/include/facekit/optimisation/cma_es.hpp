@@ -0,0 +1,162 @@
+/**
+ *  @file   cma_es.hpp
+ *  @brief Covariance matrix adaptation evolution strategy
+ *  @ingroup optimisation
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_CMA_ES__
+#define __FACEKIT_CMA_ES__
+
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/math/philox.hpp"
+#include "facekit/optimisation/continuous_solver.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/**
+ *  @class  CmaEs
+ *  @brief  (mu/mu_w, lambda)-CMA-ES with rank-one and rank-mu updates of
+ *          the covariance. The eigen decomposition of the covariance is
+ *          refreshed lazily, every O(dim / lambda) iterations.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup optimisation
+ *  @tparam T Data type
+ */
+template<typename T>
+class FK_EXPORTS CmaEs : public ContinuousSolver<T> {
+ public:
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+  /**
+   *  @name   CmaEs
+   *  @fn     CmaEs(const std::vector<T>& mean, const T& sigma,
+                    const size_t& lambda, const uint64_t& seed)
+   *  @brief  Constructor
+   *  @param[in] mean   Initial mean of the search distribution
+   *  @param[in] sigma  Initial step size
+   *  @param[in] lambda Number of candidates per iteration, 0 for the default
+   *                    4 + 3 * ln(dim)
+   *  @param[in] seed   Seed
+   */
+  CmaEs(const std::vector<T>& mean,
+        const T& sigma,
+        const size_t& lambda,
+        const uint64_t& seed);
+  
+  /**
+   *  @name   ~CmaEs
+   *  @fn     ~CmaEs(void) override = default
+   *  @brief  Destructor
+   */
+  ~CmaEs(void) override = default;
+  
+#pragma mark -
+#pragma mark Accessors
+  
+  /**
+   *  @name   mean
+   *  @fn     const std::vector<T>& mean(void) const
+   *  @brief  Mean of the search distribution
+   */
+  const std::vector<T>& mean(void) const {
+    return mean_;
+  }
+  
+  /**
+   *  @name   sigma
+   *  @fn     const T& sigma(void) const
+   *  @brief  Current step size
+   */
+  const T& sigma(void) const {
+    return sigma_;
+  }
+  
+#pragma mark -
+#pragma mark Protected
+ protected:
+  
+  /**
+   *  @name   Sample
+   *  @fn     void Sample(T* candidates) override
+   *  @brief  Draw `lambda` candidates from N(mean, sigma^2 C)
+   *  @param[out] candidates  Where to write them, [lambda x dim]
+   */
+  void Sample(T* candidates) override;
+  
+  /**
+   *  @name   Update
+   *  @fn     void Update(const T* candidates, const T* cost) override
+   *  @brief  Update mean, evolution paths, covariance and step size
+   *  @param[in] candidates Candidates, [lambda x dim]
+   *  @param[in] cost       Cost of each candidate
+   */
+  void Update(const T* candidates, const T* cost) override;
+  
+ private:
+  
+  /**
+   *  @name   Decompose
+   *  @fn     void Decompose(void)
+   *  @brief  Eigen decomposition of the covariance, C = B D^2 B'
+   */
+  void Decompose(void);
+  
+  /** Number of parents */
+  size_t mu_;
+  /** Recombination weights */
+  std::vector<T> weight_;
+  /** Variance effective selection mass */
+  T mueff_;
+  /** Learning rate of the covariance path */
+  T cc_;
+  /** Learning rate of the step size path */
+  T cs_;
+  /** Learning rate of the rank-one update */
+  T c1_;
+  /** Learning rate of the rank-mu update */
+  T cmu_;
+  /** Step size damping */
+  T damps_;
+  /** Expectation of ||N(0, I)|| */
+  T chi_n_;
+  /** Mean */
+  std::vector<T> mean_;
+  /** Step size */
+  T sigma_;
+  /** Covariance path */
+  std::vector<T> pc_;
+  /** Step size path */
+  std::vector<T> ps_;
+  /** Covariance, [dim x dim] */
+  std::vector<T> c_;
+  /** Eigen vectors of the covariance, in column */
+  std::vector<T> b_;
+  /** Square root of the eigen values */
+  std::vector<T> d_;
+  /** Inverse square root of the covariance, [dim x dim] */
+  std::vector<T> inv_sqrt_c_;
+  /** Selected candidates order */
+  std::vector<size_t> order_;
+  /** Number of iterations */
+  size_t iter_;
+  /** Iteration of the last eigen decomposition */
+  size_t eigen_iter_;
+  /** Generator */
+  Philox4x32 generator_;
+};
+  
+}  // namespace FaceKit
+#endif /* __FACEKIT_CMA_ES__ */
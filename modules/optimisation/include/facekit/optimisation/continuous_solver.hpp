@@ -0,0 +1,208 @@
+/**
+ *  @file   continuous_solver.hpp
+ *  @brief Interface for population based solvers of continuous problems
+ *  @ingroup optimisation
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_CONTINUOUS_SOLVER__
+#define __FACEKIT_CONTINUOUS_SOLVER__
+
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/**
+ *  @class  ContinuousSolver
+ *  @brief  Population based minimisation of a cost over R^n with a batch
+ *          ask / tell interface: `Ask` provides `lambda` candidates stored
+ *          contiguously, one after the other ([lambda x dim], row-major),
+ *          the caller evaluates them (i.e. all at once with
+ *          `PCAModel::GenerateBatch` on the transposed matrix) and reports
+ *          the costs with `Tell`. `Minimize` runs the loop with the cost
+ *          evaluated concurrently on the shared `ThreadPool`.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup optimisation
+ *  @tparam T Data type
+ */
+template<typename T>
+class FK_EXPORTS ContinuousSolver {
+ public:
+  
+#pragma mark -
+#pragma mark Type definition
+  
+  /** Cost of one candidate of `dim` values, must be thread-safe */
+  using Objective = std::function<T(const T*)>;
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+  /**
+   *  @name   ContinuousSolver
+   *  @fn     ContinuousSolver(const size_t& dim, const size_t& lambda)
+   *  @brief  Constructor
+   *  @param[in] dim    Problem dimension
+   *  @param[in] lambda Number of candidates per iteration
+   */
+  ContinuousSolver(const size_t& dim, const size_t& lambda);
+  
+  /**
+   *  @name   ContinuousSolver
+   *  @fn     ContinuousSolver(const ContinuousSolver& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  ContinuousSolver(const ContinuousSolver& other) = delete;
+  
+  /**
+   *  @name   operator=
+   *  @fn     ContinuousSolver& operator=(const ContinuousSolver& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  ContinuousSolver& operator=(const ContinuousSolver& rhs) = delete;
+  
+  /**
+   *  @name   ~ContinuousSolver
+   *  @fn     virtual ~ContinuousSolver(void) = default
+   *  @brief  Destructor
+   */
+  virtual ~ContinuousSolver(void) = default;
+  
+#pragma mark -
+#pragma mark Usage
+  
+  /**
+   *  @name   Ask
+   *  @fn     const T* Ask(void)
+   *  @brief  Generate the candidates of the next iteration
+   *  @return Candidates, [lambda x dim] row-major, valid until the next call
+   */
+  const T* Ask(void);
+  
+  /**
+   *  @name   Tell
+   *  @fn     void Tell(const T* cost)
+   *  @brief  Report the cost of the candidates given by the last `Ask`
+   *  @param[in] cost Cost of each candidate, `lambda` values
+   */
+  void Tell(const T* cost);
+  
+  /**
+   *  @name   Minimize
+   *  @fn     size_t Minimize(const Objective& objective,
+                              const size_t& max_iter, const T& target)
+   *  @brief  Iterate until the best cost reaches `target` or `max_iter`
+   *          iterations are done. Candidates are evaluated concurrently.
+   *  @param[in] objective  Cost function
+   *  @param[in] max_iter   Maximum number of iterations
+   *  @param[in] target     Cost to reach
+   *  @return Number of iterations done
+   */
+  size_t Minimize(const Objective& objective,
+                  const size_t& max_iter,
+                  const T& target);
+  
+#pragma mark -
+#pragma mark Accessors
+  
+  /**
+   *  @name   dim
+   *  @fn     size_t dim(void) const
+   *  @brief  Problem dimension
+   */
+  size_t dim(void) const {
+    return dim_;
+  }
+  
+  /**
+   *  @name   lambda
+   *  @fn     size_t lambda(void) const
+   *  @brief  Number of candidates per iteration
+   */
+  size_t lambda(void) const {
+    return lambda_;
+  }
+  
+  /**
+   *  @name   best
+   *  @fn     const std::vector<T>& best(void) const
+   *  @brief  Best candidate seen so far
+   */
+  const std::vector<T>& best(void) const {
+    return best_;
+  }
+  
+  /**
+   *  @name   best_cost
+   *  @fn     const T& best_cost(void) const
+   *  @brief  Cost of the best candidate seen so far
+   */
+  const T& best_cost(void) const {
+    return best_cost_;
+  }
+  
+  /**
+   *  @name   n_evaluation
+   *  @fn     size_t n_evaluation(void) const
+   *  @brief  Number of candidates evaluated so far
+   */
+  size_t n_evaluation(void) const {
+    return n_eval_;
+  }
+  
+#pragma mark -
+#pragma mark Protected
+ protected:
+  
+  /**
+   *  @name   Sample
+   *  @fn     virtual void Sample(T* candidates) = 0
+   *  @brief  Generate `lambda` candidates
+   *  @param[out] candidates  Where to write them, [lambda x dim]
+   */
+  virtual void Sample(T* candidates) = 0;
+  
+  /**
+   *  @name   Update
+   *  @fn     virtual void Update(const T* candidates, const T* cost) = 0
+   *  @brief  Update the search distribution given the evaluated candidates
+   *  @param[in] candidates Candidates, [lambda x dim]
+   *  @param[in] cost       Cost of each candidate
+   */
+  virtual void Update(const T* candidates, const T* cost) = 0;
+  
+  /** Problem dimension */
+  size_t dim_;
+  /** Number of candidates per iteration */
+  size_t lambda_;
+  
+ private:
+  /** Candidates of the current iteration, [lambda x dim] */
+  std::vector<T> candidate_;
+  /** Cost of the candidates, used by `Minimize` */
+  std::vector<T> cost_;
+  /** Best candidate */
+  std::vector<T> best_;
+  /** Best cost */
+  T best_cost_;
+  /** Number of evaluations */
+  size_t n_eval_;
+};
+  
+}  // namespace FaceKit
+#endif /* __FACEKIT_CONTINUOUS_SOLVER__ */
@@ -0,0 +1,130 @@
+/**
+ *  @file   differential_evolution.hpp
+ *  @brief Differential evolution solver for continuous problems
+ *  @ingroup optimisation
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_DIFFERENTIAL_EVOLUTION__
+#define __FACEKIT_DIFFERENTIAL_EVOLUTION__
+
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/math/philox.hpp"
+#include "facekit/optimisation/continuous_solver.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/**
+ *  @class  DifferentialEvolution
+ *  @brief  DE/rand/1/bin solver. The first `Ask` provides the initial
+ *          population drawn uniformly within the bounds, the following ones
+ *          one trial vector per member. A trial replaces its member when its
+ *          cost is not worse.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup optimisation
+ *  @tparam T Data type
+ */
+template<typename T>
+class FK_EXPORTS DifferentialEvolution : public ContinuousSolver<T> {
+ public:
+  
+#pragma mark -
+#pragma mark Type definition
+  
+  /**
+   *  @struct Parameters
+   *  @brief  Solver's parameters
+   */
+  struct Parameters {
+    /** Differential weight, in [0, 2] */
+    T weight;
+    /** Crossover probability, in [0, 1] */
+    T crossover;
+    /** Seed */
+    uint64_t seed;
+    
+    /**
+     *  @name   Parameters
+     *  @fn     Parameters(void)
+     *  @brief  Constructor
+     */
+    Parameters(void) : weight(T(0.8)), crossover(T(0.9)), seed(0) {}
+  };
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+  /**
+   *  @name   DifferentialEvolution
+   *  @fn     DifferentialEvolution(const std::vector<T>& lower,
+                                    const std::vector<T>& upper,
+                                    const size_t& pop_size,
+                                    const Parameters& params)
+   *  @brief  Constructor
+   *  @param[in] lower    Lower bound of each dimension
+   *  @param[in] upper    Upper bound of each dimension
+   *  @param[in] pop_size Population size, at least 4
+   *  @param[in] params   Solver's parameters
+   */
+  DifferentialEvolution(const std::vector<T>& lower,
+                        const std::vector<T>& upper,
+                        const size_t& pop_size,
+                        const Parameters& params);
+  
+  /**
+   *  @name   ~DifferentialEvolution
+   *  @fn     ~DifferentialEvolution(void) override = default
+   *  @brief  Destructor
+   */
+  ~DifferentialEvolution(void) override = default;
+  
+#pragma mark -
+#pragma mark Protected
+ protected:
+  
+  /**
+   *  @name   Sample
+   *  @fn     void Sample(T* candidates) override
+   *  @brief  Generate one trial vector per member
+   *  @param[out] candidates  Where to write them, [lambda x dim]
+   */
+  void Sample(T* candidates) override;
+  
+  /**
+   *  @name   Update
+   *  @fn     void Update(const T* candidates, const T* cost) override
+   *  @brief  Replace members by their trial when it is not worse
+   *  @param[in] candidates Candidates, [lambda x dim]
+   *  @param[in] cost       Cost of each candidate
+   */
+  void Update(const T* candidates, const T* cost) override;
+  
+ private:
+  /** Lower bounds */
+  std::vector<T> lower_;
+  /** Upper bounds */
+  std::vector<T> upper_;
+  /** Parameters */
+  Parameters params_;
+  /** Population, [lambda x dim] */
+  std::vector<T> x_;
+  /** Cost of each member */
+  std::vector<T> cost_;
+  /** Indicate if the population has been evaluated */
+  bool init_;
+  /** Generator */
+  Philox4x32 generator_;
+};
+  
+}  // namespace FaceKit
+#endif /* __FACEKIT_DIFFERENTIAL_EVOLUTION__ */
@@ -0,0 +1,144 @@
+/**
+ *  @file   fitness_cache.hpp
+ *  @brief Memoisation of chromosome fitness
+ *  @ingroup optimisation
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_FITNESS_CACHE__
+#define __FACEKIT_FITNESS_CACHE__
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/**
+ *  @class  FitnessCache
+ *  @brief  Fitness of already evaluated genomes, keyed by a hash of the
+ *          genes. Genes are stored along to reject hash collisions. The
+ *          cache is emptied once it reaches its capacity, old generations
+ *          are unlikely to come back. `Find` can be called concurrently,
+ *          `Insert` can not.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup optimisation
+ *  @tparam T Data type
+ */
+template<typename T>
+class FK_EXPORTS FitnessCache {
+ public:
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+  /**
+   *  @name   FitnessCache
+   *  @fn     explicit FitnessCache(const size_t& capacity)
+   *  @brief  Constructor
+   *  @param[in] capacity Maximum number of genomes stored
+   */
+  explicit FitnessCache(const size_t& capacity);
+  
+  /**
+   *  @name   FitnessCache
+   *  @fn     FitnessCache(const FitnessCache& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  FitnessCache(const FitnessCache& other) = delete;
+  
+  /**
+   *  @name   operator=
+   *  @fn     FitnessCache& operator=(const FitnessCache& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  FitnessCache& operator=(const FitnessCache& rhs) = delete;
+  
+  /**
+   *  @name   ~FitnessCache
+   *  @fn     ~FitnessCache(void) = default
+   *  @brief  Destructor
+   */
+  ~FitnessCache(void) = default;
+  
+#pragma mark -
+#pragma mark Usage
+  
+  /**
+   *  @name   Find
+   *  @fn     bool Find(const T* genes, const size_t& n, T* fitness) const
+   *  @brief  Look for the fitness of a genome
+   *  @param[in] genes    Genes
+   *  @param[in] n        Number of genes
+   *  @param[out] fitness Fitness, if found
+   *  @return True if found, false otherwise
+   */
+  bool Find(const T* genes, const size_t& n, T* fitness) const;
+  
+  /**
+   *  @name   Insert
+   *  @fn     void Insert(const T* genes, const size_t& n, const T& fitness)
+   *  @brief  Add the fitness of a genome
+   *  @param[in] genes    Genes
+   *  @param[in] n        Number of genes
+   *  @param[in] fitness  Fitness
+   */
+  void Insert(const T* genes, const size_t& n, const T& fitness);
+  
+  /**
+   *  @name   Clear
+   *  @fn     void Clear(void)
+   *  @brief  Remove every entries, i.e. when the fitness function changes
+   */
+  void Clear(void) {
+    entries_.clear();
+  }
+  
+#pragma mark -
+#pragma mark Accessors
+  
+  /**
+   *  @name   size
+   *  @fn     size_t size(void) const
+   *  @brief  Number of genomes stored
+   */
+  size_t size(void) const {
+    return entries_.size();
+  }
+  
+#pragma mark -
+#pragma mark Private
+ private:
+  
+  /**
+   *  @struct Entry
+   *  @brief  Cached genome
+   */
+  struct Entry {
+    /** Fitness */
+    T fitness;
+    /** Genes */
+    std::vector<T> genes;
+  };
+  
+  /** Maximum number of entries */
+  size_t capacity_;
+  /** Genomes, by hash */
+  std::unordered_map<uint64_t, Entry> entries_;
+};
+  
+}  // namespace FaceKit
+#endif /* __FACEKIT_FITNESS_CACHE__ */
@@ -12,6 +12,9 @@
 #ifndef __FACEKIT_GENETIC_SOLVER__
 #define __FACEKIT_GENETIC_SOLVER__
 
+#include <functional>
+#include <ostream>
+
 #include "facekit/core/library_export.hpp"
 #include "facekit/optimisation/population.hpp"
 
@@ -63,13 +66,24 @@ class FK_EXPORTS GeneticSolver {
     T percentage_fitness;
     /** Number of generation at maximum fitness before stopping */
     size_t n_max_fitness_generation;
+    /** Parent selection strategy */
+    typename Population<T>::Selection selection;
+    /** Number of chromosomes competing in a tournament */
+    size_t tournament_size;
+    /** Number of fittest chromosomes carried over unchanged (elitism) */
+    size_t n_elite;
+    /** Fraction of the population replaced at each generation, 1 for a
+     generational algorithm, less for a steady state one */
+    T replacement;
     
     /**
      *  @name   Parameters
      *  @fn     Parameters(void)
      *  @brief  Cnstructor
      */
-    Parameters(void) : p_crossover(0.8), p_mutation(0.02), max_generation(50), percentage_fitness(5.0), n_max_fitness_generation(5) {}
+    Parameters(void) : p_crossover(0.8), p_mutation(0.02), max_generation(50), percentage_fitness(5.0), n_max_fitness_generation(5),
+      selection(Population<T>::Selection::kRoulette), tournament_size(2),
+      n_elite(0), replacement(1.0) {}
   };
   
   /**
@@ -83,6 +97,25 @@ class FK_EXPORTS GeneticSolver {
     kConverged
   };
   
+  /**
+   *  @struct GenerationStats
+   *  @brief  Metrics of one generation, reported to the `Observer`
+   *  @ingroup optimisation
+   */
+  struct GenerationStats {
+    /** Generation index, starting at 1 */
+    size_t generation;
+    /** Average fitness */
+    T average_fitness;
+    /** Maximum fitness */
+    T maximum_fitness;
+    /** Time spent generating and evaluating the generation, in ms */
+    double time_ms;
+  };
+  
+  /** Callback invoked by `Solve` after each generation */
+  using Observer = std::function<void(const GenerationStats&)>;
+  
 #pragma mark -
 #pragma mark Initialisation
   
@@ -134,6 +167,47 @@ class FK_EXPORTS GeneticSolver {
    */
   ConvergenceType Solve(const Parameters& params);
   
+  /**
+   *  @name   Evolve
+   *  @fn     T Evolve(const Parameters& params, T* average = nullptr)
+   *  @brief  Generate and evaluate the next generation (crossover, mutation,
+   *          fitness), without checking any convergence criterion. The
+   *          `n_elite` fittest chromosomes, or the fraction not replaced
+   *          in steady state, are carried over and not evaluated again.
+   *  @param[in] params   Configuration
+   *  @param[out] average Average fitness of the new generation, if not
+   *                      nullptr
+   *  @return Maximum fitness of the new generation
+   */
+  T Evolve(const Parameters& params, T* average = nullptr);
+  
+  /**
+   *  @name   Emigrate
+   *  @fn     void Emigrate(const size_t& n, std::vector<T>* genes,
+                            std::vector<T>* fitness) const
+   *  @brief  Copy the `n` fittest chromosomes of the current generation
+   *  @param[in] n          Number of chromosomes
+   *  @param[out] genes     Genes, one chromosome after the other
+   *  @param[out] fitness   Fitness of each chromosome
+   */
+  void Emigrate(const size_t& n,
+                std::vector<T>* genes,
+                std::vector<T>* fitness) const {
+    curr_population_->Export(n, genes, fitness);
+  }
+  
+  /**
+   *  @name   Immigrate
+   *  @fn     void Immigrate(const std::vector<T>& genes,
+                             const std::vector<T>& fitness)
+   *  @brief  Replace the least fit chromosomes of the current generation
+   *  @param[in] genes    Genes, one chromosome after the other
+   *  @param[in] fitness  Fitness of each chromosome
+   */
+  void Immigrate(const std::vector<T>& genes, const std::vector<T>& fitness) {
+    curr_population_->Import(genes, fitness);
+  }
+  
   /**
    *  @name   BestFitness
    *  @fn     ChromosomeType* BestFitness(void) const
@@ -142,28 +216,61 @@ class FK_EXPORTS GeneticSolver {
    */
   ChromosomeType* BestFitness(void) const;
   
+  /**
+   *  @name   CsvObserver
+   *  @fn     static Observer CsvObserver(std::ostream* stream)
+   *  @brief  Create an observer writing "generation,average,maximum,time_ms"
+   *          lines to `stream`. Lines are not flushed, the stream's own
+   *          buffering applies.
+   *  @param[in] stream Output stream, must outlive the solve
+   *  @return Observer
+   */
+  static Observer CsvObserver(std::ostream* stream);
+  
 #pragma mark -
 #pragma mark Accessors
   
+  /**
+   *  @name   set_observer
+   *  @fn     void set_observer(const Observer& observer)
+   *  @brief  Define the callback invoked after each generation by `Solve`,
+   *          empty to disable. Nothing is measured nor reported by default.
+   *  @param[in] observer Callback
+   */
+  void set_observer(const Observer& observer) {
+    observer_ = observer;
+  }
+  
+  /**
+   *  @name   maximum_fitness
+   *  @fn     T maximum_fitness(void) const
+   *  @brief  Maximum fitness of the current generation
+   */
+  T maximum_fitness(void) const {
+    return curr_population_->maximum_fitness();
+  }
+  
 #pragma mark -
 #pragma mark Private
 private:
   
   /**
    *  @name   CrossOver
-   *  @fn     void CrossOver(const T& rate)
+   *  @fn     void CrossOver(const T& rate, const size_t& n_survivor)
    *  @brief  Perform crossover
-   *  @param[in] rate Crossover rate
+   *  @param[in] rate       Crossover rate
+   *  @param[in] n_survivor Number of fittest chromosomes carried over
    */
-  void CrossOver(const T& rate);
+  void CrossOver(const T& rate, const size_t& n_survivor);
   
   /**
    *  @name   Mutate
-   *  @fn     void Mutate(const T& rate)
-   *  @brief  Perform mutation
-   *  @param[in] rate Mutation rate
+   *  @fn     void Mutate(const T& rate, const size_t& n_survivor)
+   *  @brief  Perform mutation, survivors are not mutated
+   *  @param[in] rate       Mutation rate
+   *  @param[in] n_survivor Number of fittest chromosomes carried over
    */
-  void Mutate(const T& rate);
+  void Mutate(const T& rate, const size_t& n_survivor);
   
   
   
@@ -172,8 +279,12 @@ private:
   Population<T>* curr_population_;
   /** Next population */
   Population<T>* next_population_;
+  /** Fitness of the genomes of the last generations */
+  FitnessCache<T> cache_;
   /** Chromosome length */
   size_t chromo_length_;
+  /** Per generation callback */
+  Observer observer_;
 };
   
 }  // namespace FaceKit
@@ -0,0 +1,169 @@
+/**
+ *  @file   island_solver.hpp
+ *  @brief Island model genetic algorithm solver
+ *  @ingroup optimisation
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_ISLAND_SOLVER__
+#define __FACEKIT_ISLAND_SOLVER__
+
+#include <memory>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/optimisation/genetic_solver.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/**
+ *  @class  IslandSolver
+ *  @brief  Several populations (islands) evolve independently and
+ *          concurrently, every `interval` generations the `n_migrant`
+ *          fittest chromosomes of each island replace the least fit ones of
+ *          the next island (ring topology). Islands only exchange flat gene
+ *          buffers, see `GeneticSolver::Emigrate / Immigrate`.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup optimisation
+ *  @tparam T Data type
+ */
+template<typename T>
+class FK_EXPORTS IslandSolver {
+ public:
+  
+#pragma mark -
+#pragma mark Type definition
+  
+  /** Solver of one island */
+  using Solver = GeneticSolver<T>;
+  /** Chromosome */
+  using ChromosomeType = typename Solver::ChromosomeType;
+  /** Chromosome constructor callback */
+  using ChromosomeCtor = typename Solver::ChromosomeCtor;
+  /** Convergence */
+  using ConvergenceType = typename Solver::ConvergenceType;
+  
+  /**
+   *  @struct Parameters
+   *  @brief  Solver configuration
+   *  @ingroup optimisation
+   */
+  struct Parameters {
+    /** Configuration of the islands, only `fitness_target` and
+     `max_generation` are used as stopping criteria */
+    typename Solver::Parameters island;
+    /** Number of generations between migrations */
+    size_t interval;
+    /** Number of chromosomes sent by each island at every migration */
+    size_t n_migrant;
+    
+    /**
+     *  @name   Parameters
+     *  @fn     Parameters(void)
+     *  @brief  Constructor
+     */
+    Parameters(void) : interval(10), n_migrant(2) {}
+  };
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+  /**
+   *  @name   IslandSolver
+   *  @fn     IslandSolver(const size_t& n_island, const size_t& pop_size,
+                           const size_t& chromo_size,
+                           const ChromosomeCtor& ctor)
+   *  @brief  Constructor
+   *  @param[in] n_island     Number of islands
+   *  @param[in] pop_size     Population size of each island
+   *  @param[in] chromo_size  Size of one chromosome
+   *  @param[in] ctor         Callback creating a derived chromosome
+   */
+  IslandSolver(const size_t& n_island,
+               const size_t& pop_size,
+               const size_t& chromo_size,
+               const ChromosomeCtor& ctor);
+  
+  /**
+   *  @name   IslandSolver
+   *  @fn     IslandSolver(const IslandSolver& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  IslandSolver(const IslandSolver& other) = delete;
+  
+  /**
+   *  @name   operator=
+   *  @fn     IslandSolver& operator=(const IslandSolver& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  IslandSolver& operator=(const IslandSolver& rhs) = delete;
+  
+  /**
+   *  @name   ~IslandSolver
+   *  @fn     ~IslandSolver(void) = default
+   *  @brief  Destructor
+   */
+  ~IslandSolver(void) = default;
+  
+#pragma mark -
+#pragma mark Usage
+  
+  /**
+   *  @name   Solve
+   *  @fn     ConvergenceType Solve(const Parameters& params)
+   *  @brief  Evolve every islands until one reaches the fitness target or
+   *          the maximum number of generations is reached
+   *  @param[in] params Configuration
+   *  @return Convergence type
+   */
+  ConvergenceType Solve(const Parameters& params);
+  
+  /**
+   *  @name   BestFitness
+   *  @fn     ChromosomeType* BestFitness(void) const
+   *  @brief  Give the chromosome with the best fitness over all islands
+   *  @return Chromosome with solution
+   */
+  ChromosomeType* BestFitness(void) const;
+  
+#pragma mark -
+#pragma mark Accessors
+  
+  /**
+   *  @name   size
+   *  @fn     size_t size(void) const
+   *  @brief  Number of islands
+   */
+  size_t size(void) const {
+    return islands_.size();
+  }
+  
+#pragma mark -
+#pragma mark Private
+ private:
+  
+  /**
+   *  @name   Migrate
+   *  @fn     void Migrate(const size_t& n_migrant)
+   *  @brief  Send the fittest chromosomes of each island to the next one
+   *  @param[in] n_migrant  Number of chromosomes sent by each island
+   */
+  void Migrate(const size_t& n_migrant);
+  
+  /** Islands */
+  std::vector<std::unique_ptr<Solver>> islands_;
+};
+  
+}  // namespace FaceKit
+#endif /* __FACEKIT_ISLAND_SOLVER__ */
@@ -16,7 +16,9 @@
 #include <random>
 
 #include "facekit/core/library_export.hpp"
+#include "facekit/core/math/philox.hpp"
 #include "facekit/optimisation/chromosome.hpp"
+#include "facekit/optimisation/fitness_cache.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -43,6 +45,17 @@ class FK_EXPORTS Population {
   using ChromosomeType = Chromosome<T>;
   /** Chromosome constructor */
   using ChromosomeCtor = std::function<ChromosomeType*(const size_t&)>;
+  
+  /**
+   *  @enum   Selection
+   *  @brief  Parent selection strategy
+   */
+  enum class Selection : int8_t {
+    /** Fitness proportionate, "Roulette Wheel" */
+    kRoulette = 0,
+    /** Fittest of a few chromosomes drawn uniformly */
+    kTournament
+  };
  
 #pragma mark -
 #pragma mark Initialisation
@@ -95,7 +108,12 @@ class FK_EXPORTS Population {
    *  @name   Fitness
    *  @fn     T Fitness(void)
    *  @brief  Compute the fitness for each chromosomes in the populutation and 
-   *          return the average fitness
+   *          return the average fitness. Chromosomes are evaluated
+   *          concurrently on the shared `ThreadPool`, therefore
+   *          `Chromosome::Fitness` must be thread-safe. Chromosomes unchanged
+   *          since their last evaluation (i.e. copied from a parent without
+   *          crossover nor mutation) or found in the fitness cache are not
+   *          evaluated again.
    *  @return Average fitness for the population
    */
   T Fitness(void);
@@ -104,25 +122,99 @@ class FK_EXPORTS Population {
    *  @name   CrossOver
    *  @fn     void CrossOver(const T& rate, ChromosomeType* f_sibling, ChromosomeType* s_sibling)
    *  @brief  Perform crossover on this population based on each chromosomes 
-   *          fitness. The selection of the parents are done with a "Roulette
-   *          Wheel".
+   *          fitness. The parents are selected according to `set_selection`.
    *  @param[in]  rate  Cross over rate
    *  @param[out] f_sibling First sibling to be generrate by the crossover
    *  @param[out] s_sibling Second sibling generated, if nullptr not used.
    */
   void CrossOver(const T& rate, ChromosomeType* f_sibling, ChromosomeType* s_sibling);
   
+  /**
+   *  @name   CrossOver
+   *  @fn     void CrossOver(const T& rate, Population<T>* next,
+                             const size_t& n_survivor = 0)
+   *  @brief  Generate the chromosomes of `next`. The `n_survivor` fittest
+   *          chromosomes of this population are copied unchanged, with their
+   *          fitness, at the beginning of `next` (elitism / steady state),
+   *          the others are generated by crossover. Offsprings are bred
+   *          concurrently, each one with its own random stream, therefore
+   *          the outcome does not depend on the number of threads.
+   *  @param[in]  rate        Cross over rate
+   *  @param[out] next        Population to fill, same size and chromosome
+   *                          length
+   *  @param[in]  n_survivor  Number of chromosomes carried over
+   */
+  void CrossOver(const T& rate,
+                 Population<T>* next,
+                 const size_t& n_survivor = 0);
+  
   /**
    *  @name   Mutate
-   *  @fn     void Mutate(const T& rate)
-   *  @brief  Call mutation function on the population
+   *  @fn     void Mutate(const T& rate, const size_t& first = 0)
+   *  @brief  Call mutation function on the population, each gene is mutated
+   *          with probability `rate`. Chromosomes are mutated concurrently,
+   *          therefore `Chromosome::Mutate` must be thread-safe.
    *  @param[in]  rate  Rate of mutation
+   *  @param[in]  first First chromosome to mutate, i.e. to spare survivors
    */
-  void Mutate(const T& rate);
+  void Mutate(const T& rate, const size_t& first = 0);
+
+  /**
+   *  @name   Export
+   *  @fn     void Export(const size_t& n, std::vector<T>* genes,
+                          std::vector<T>* fitness) const
+   *  @brief  Copy the `n` fittest chromosomes, i.e. for migration.
+   *          Fitness needs to be up to date.
+   *  @param[in] n          Number of chromosomes to export
+   *  @param[out] genes     Genes, one chromosome after the other
+   *  @param[out] fitness   Fitness of each exported chromosome
+   */
+  void Export(const size_t& n,
+              std::vector<T>* genes,
+              std::vector<T>* fitness) const;
+  
+  /**
+   *  @name   Import
+   *  @fn     void Import(const std::vector<T>& genes,
+                          const std::vector<T>& fitness)
+   *  @brief  Replace the least fit chromosomes by the given ones (see
+   *          `Export`) and update the fitness statistics. Fitness needs to
+   *          be up to date.
+   *  @param[in] genes    Genes, one chromosome after the other
+   *  @param[in] fitness  Fitness of each imported chromosome
+   */
+  void Import(const std::vector<T>& genes, const std::vector<T>& fitness);
 
 #pragma mark -
 #pragma mark Accessors
   
+  /**
+   *  @name   set_fitness_cache
+   *  @fn     void set_fitness_cache(FitnessCache<T>* cache)
+   *  @brief  Share a fitness cache, i.e. between successive generations.
+   *          Does not take ownership.
+   *  @param[in] cache  Cache to use, nullptr to disable
+   */
+  void set_fitness_cache(FitnessCache<T>* cache) {
+    cache_ = cache;
+  }
+  
+  /**
+   *  @name   set_selection
+   *  @fn     void set_selection(const Selection& selection,
+                                 const size_t& tournament_size = 2)
+   *  @brief  Define how parents are selected. Roulette draws use an alias
+   *          table built by `Fitness`, therefore each draw is O(1).
+   *  @param[in] selection        Selection strategy
+   *  @param[in] tournament_size  Number of chromosomes competing in a
+   *                              tournament
+   */
+  void set_selection(const Selection& selection,
+                     const size_t& tournament_size = 2) {
+    selection_ = selection;
+    tournament_size_ = tournament_size > 0 ? tournament_size : 1;
+  }
+  
   /**
    *  @name   size
    *  @fn     size_t size(void) const
@@ -203,27 +295,118 @@ class FK_EXPORTS Population {
  private:
   
   /**
-   *  @name   RouletteWheel
-   *  @fn     void RouletteWheel(size_t* p1, size_t* p2)
-   *  @brief  Select two parents using the "Roulette Wheel" concept. 
+   *  @struct FitnessStats
+   *  @brief  Partial fitness statistics of a range of chromosomes
+   */
+  struct FitnessStats {
+    /** Sum of the fitness */
+    T sum;
+    /** Maximum fitness */
+    T max;
+    /** Index of the first chromosome with the maximum fitness */
+    size_t idx;
+  };
+  
+  /**
+   *  @name   Breed
+   *  @fn     void Breed(const T& rate, Philox4x32* rng,
+                         ChromosomeType* f_sibling,
+                         ChromosomeType* s_sibling) const
+   *  @brief  Select two parents and generate one or two siblings
+   *  @param[in]  rate  Cross over rate
+   *  @param[in,out] rng  Random generator
+   *  @param[out] f_sibling First sibling
+   *  @param[out] s_sibling Second sibling, if nullptr not used.
+   */
+  void Breed(const T& rate,
+             Philox4x32* rng,
+             ChromosomeType* f_sibling,
+             ChromosomeType* s_sibling) const;
+  
+  /**
+   *  @name   Rank
+   *  @fn     void Rank(const size_t& n, const bool& fittest,
+                        std::vector<size_t>* index) const
+   *  @brief  Select the `n` fittest (or least fit) chromosomes, ordered.
+   *          Fitness needs to be up to date.
+   *  @param[in] n        Number of chromosomes to select
+   *  @param[in] fittest  Select the fittest if true, the least fit otherwise
+   *  @param[out] index   Chromosome indexes, the first `n` are selected
+   */
+  void Rank(const size_t& n,
+            const bool& fittest,
+            std::vector<size_t>* index) const;
+  
+  /**
+   *  @name   BuildAliasTable
+   *  @fn     void BuildAliasTable(const T& sum)
+   *  @brief  Build the alias table of the fitness proportionate distribution
+   *          (Vose's method), called once fitness is up to date
+   *  @param[in] sum  Sum of the fitness
+   */
+  void BuildAliasTable(const T& sum);
+  
+  /**
+   *  @name   Uniform
+   *  @fn     size_t Uniform(Philox4x32* rng) const
+   *  @brief  Draw a chromosome index uniformly
+   *  @param[in,out] rng  Random generator
+   *  @return Chromosome index
+   */
+  size_t Uniform(Philox4x32* rng) const;
+  
+  /**
+   *  @name   Select
+   *  @fn     size_t Select(Philox4x32* rng) const
+   *  @brief  Draw one parent, in O(1) for roulette selection and
+   *          O(tournament size) for tournament selection
+   *  @param[in,out] rng  Random generator
+   *  @return Chromosome index
+   */
+  size_t Select(Philox4x32* rng) const;
+  
+  /**
+   *  @name   SelectParents
+   *  @fn     void SelectParents(Philox4x32* rng, size_t* p1,
+                                 size_t* p2) const
+   *  @brief  Select two parents, distinct if possible.
    *          Fitness needs to be up to date.
+   *  @param[in,out] rng  Random generator
    *  @param[out] p1  First parent index
    *  @param[out] p2  Second parent index
    */
-  void RouletteWheel(size_t* p1, size_t* p2);
+  void SelectParents(Philox4x32* rng, size_t* p1, size_t* p2) const;
   
-  /** List of chromosomes */
+  /** List of chromosomes, views on `genome_` */
   std::vector<ChromosomeType*> popultation_;
+  /** Genes of all chromosomes, [Population size x Chromosome length] */
+  std::vector<T> genome_;
+  /** Chromosome length */
+  size_t length_;
   /** Chromosome's fitness */
   std::vector<T> fitness_;
   /** Maximum fitness for the current population */
   T max_fitness_;
   /** Chromosome index with the maximum fitness */
   size_t max_fitness_idx_;
-  /** Random generator, crossover + mutation */
-  std::mt19937_64 generator_;
-  /** Distribution */
-  std::uniform_real_distribution<T> dist_;
+  /** Parent selection strategy */
+  Selection selection_;
+  /** Number of chromosomes competing in a tournament */
+  size_t tournament_size_;
+  /** Fitness cache, not owned */
+  FitnessCache<T>* cache_;
+  /** Indicate which chromosome was evaluated by the last `Fitness` call */
+  std::vector<uint8_t> evaluated_;
+  /** Alias table, probability to keep the drawn entry */
+  std::vector<T> alias_prob_;
+  /** Alias table, entry picked otherwise */
+  std::vector<size_t> alias_idx_;
+  /** Random generator, serial crossover */
+  Philox4x32 generator_;
+  /** Seed of the random streams */
+  uint64_t seed_;
+  /** Number of parallel crossover / mutation performed, selects the streams */
+  uint64_t step_;
 };
   
   
@@ -0,0 +1,277 @@
+/**
+ *  @file   cma_es.cpp
+ *  @brief Covariance matrix adaptation evolution strategy
+ *  @ingroup optimisation
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+
+#include "facekit/core/logger.hpp"
+#include "facekit/core/math/linear_algebra.hpp"
+#include "facekit/optimisation/cma_es.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+/*
+ *  @name   CmaEs
+ *  @fn     CmaEs(const std::vector<T>& mean, const T& sigma,
+ *                const size_t& lambda, const uint64_t& seed)
+ *  @brief  Constructor
+ *  @param[in] mean   Initial mean of the search distribution
+ *  @param[in] sigma  Initial step size
+ *  @param[in] lambda Number of candidates per iteration, 0 for the default
+ *                    4 + 3 * ln(dim)
+ *  @param[in] seed   Seed
+ */
+template<typename T>
+CmaEs<T>::CmaEs(const std::vector<T>& mean,
+                const T& sigma,
+                const size_t& lambda,
+                const uint64_t& seed) :
+        ContinuousSolver<T>(mean.size(),
+                            lambda != 0 ?
+                            lambda :
+                            4 + size_t(3.0 * std::log(double(mean.size())))),
+        mean_(mean),
+        sigma_(sigma),
+        pc_(mean.size(), T(0.0)),
+        ps_(mean.size(), T(0.0)),
+        c_(mean.size() * mean.size(), T(0.0)),
+        b_(mean.size() * mean.size(), T(0.0)),
+        d_(mean.size(), T(1.0)),
+        inv_sqrt_c_(mean.size() * mean.size(), T(0.0)),
+        order_(this->lambda_),
+        iter_(0),
+        eigen_iter_(0),
+        generator_(seed, 0) {
+  const T n = T(this->dim_);
+  // Log-linear recombination weights, normalized
+  mu_ = this->lambda_ / 2;
+  weight_.resize(mu_);
+  for (size_t i = 0; i < mu_; ++i) {
+    weight_[i] = std::log(T(mu_) + T(0.5)) - std::log(T(i + 1));
+  }
+  const T sw = std::accumulate(weight_.begin(), weight_.end(), T(0.0));
+  T sw2 = T(0.0);
+  for (auto& w : weight_) {
+    w /= sw;
+    sw2 += w * w;
+  }
+  mueff_ = T(1.0) / sw2;
+  // Learning rates
+  cc_ = (T(4.0) + mueff_ / n) / (n + T(4.0) + T(2.0) * mueff_ / n);
+  cs_ = (mueff_ + T(2.0)) / (n + mueff_ + T(5.0));
+  c1_ = T(2.0) / ((n + T(1.3)) * (n + T(1.3)) + mueff_);
+  cmu_ = std::min(T(1.0) - c1_,
+                  T(2.0) * (mueff_ - T(2.0) + T(1.0) / mueff_) /
+                  ((n + T(2.0)) * (n + T(2.0)) + mueff_));
+  damps_ = T(1.0) + cs_ +
+           T(2.0) * std::max(T(0.0),
+                             std::sqrt((mueff_ - T(1.0)) / (n + T(1.0))) -
+                             T(1.0));
+  chi_n_ = std::sqrt(n) * (T(1.0) - T(1.0) / (T(4.0) * n) +
+                           T(1.0) / (T(21.0) * n * n));
+  // C = B = C^-1/2 = I
+  for (size_t i = 0; i < this->dim_; ++i) {
+    c_[i * this->dim_ + i] = T(1.0);
+    b_[i * this->dim_ + i] = T(1.0);
+    inv_sqrt_c_[i * this->dim_ + i] = T(1.0);
+  }
+}
+  
+#pragma mark -
+#pragma mark Protected
+  
+/*
+ *  @name   Sample
+ *  @fn     void Sample(T* candidates)
+ *  @brief  Draw `lambda` candidates from N(mean, sigma^2 C)
+ *  @param[out] candidates  Where to write them, [lambda x dim]
+ */
+template<typename T>
+void CmaEs<T>::Sample(T* candidates) {
+  const size_t n = this->dim_;
+  std::normal_distribution<T> normal(T(0.0), T(1.0));
+  std::vector<T> dz(n);
+  for (size_t k = 0; k < this->lambda_; ++k) {
+    // x = m + sigma * B * D * z
+    for (size_t j = 0; j < n; ++j) {
+      dz[j] = d_[j] * normal(generator_);
+    }
+    T* x = &candidates[k * n];
+    std::copy(mean_.begin(), mean_.end(), x);
+    for (size_t j = 0; j < n; ++j) {
+      const T s = sigma_ * dz[j];
+      const T* bj = &b_[j * n];
+      for (size_t i = 0; i < n; ++i) {
+        x[i] += s * bj[i];
+      }
+    }
+  }
+}
+  
+/*
+ *  @name   Update
+ *  @fn     void Update(const T* candidates, const T* cost)
+ *  @brief  Update mean, evolution paths, covariance and step size
+ *  @param[in] candidates Candidates, [lambda x dim]
+ *  @param[in] cost       Cost of each candidate
+ */
+template<typename T>
+void CmaEs<T>::Update(const T* candidates, const T* cost) {
+  const size_t n = this->dim_;
+  ++iter_;
+  // Select the mu best candidates
+  std::iota(order_.begin(), order_.end(), 0);
+  std::partial_sort(order_.begin(), order_.begin() + mu_, order_.end(),
+                    [&](const size_t& a, const size_t& b) {
+                      return cost[a] < cost[b];
+                    });
+  // Selected steps, y_k = (x_k - m) / sigma, and their recombination
+  std::vector<T> y(mu_ * n);
+  std::vector<T> step(n, T(0.0));
+  for (size_t k = 0; k < mu_; ++k) {
+    const T* x = &candidates[order_[k] * n];
+    T* yk = &y[k * n];
+    for (size_t i = 0; i < n; ++i) {
+      yk[i] = (x[i] - mean_[i]) / sigma_;
+      step[i] += weight_[k] * yk[i];
+    }
+  }
+  for (size_t i = 0; i < n; ++i) {
+    mean_[i] += sigma_ * step[i];
+  }
+  // Step size path, ps = (1 - cs) ps + sqrt(cs (2 - cs) mueff) C^-1/2 step
+  const T a_s = std::sqrt(cs_ * (T(2.0) - cs_) * mueff_);
+  T ps_norm = T(0.0);
+  for (size_t i = 0; i < n; ++i) {
+    const T* row = &inv_sqrt_c_[i * n];
+    T v = T(0.0);
+    for (size_t j = 0; j < n; ++j) {
+      v += row[j] * step[j];
+    }
+    ps_[i] = (T(1.0) - cs_) * ps_[i] + a_s * v;
+    ps_norm += ps_[i] * ps_[i];
+  }
+  ps_norm = std::sqrt(ps_norm);
+  // Stall the covariance path while the step size grows quickly
+  const T decay = std::pow(T(1.0) - cs_, T(2.0 * iter_));
+  const bool hsig = (ps_norm / std::sqrt(T(1.0) - decay) / chi_n_ <
+                     T(1.4) + T(2.0) / T(n + 1));
+  const T a_c = hsig ? std::sqrt(cc_ * (T(2.0) - cc_) * mueff_) : T(0.0);
+  for (size_t i = 0; i < n; ++i) {
+    pc_[i] = (T(1.0) - cc_) * pc_[i] + a_c * step[i];
+  }
+  // Covariance, rank-one and rank-mu updates
+  const T c_old = T(1.0) - c1_ - cmu_ +
+                  (hsig ? T(0.0) : c1_ * cc_ * (T(2.0) - cc_));
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j <= i; ++j) {
+      T rank_mu = T(0.0);
+      for (size_t k = 0; k < mu_; ++k) {
+        rank_mu += weight_[k] * y[k * n + i] * y[k * n + j];
+      }
+      const T v = c_old * c_[i * n + j] +
+                  c1_ * pc_[i] * pc_[j] +
+                  cmu_ * rank_mu;
+      c_[i * n + j] = v;
+      c_[j * n + i] = v;
+    }
+  }
+  // Step size
+  sigma_ *= std::exp((cs_ / damps_) * (ps_norm / chi_n_ - T(1.0)));
+  // Eigen decomposition, O(n^3), amortized over several iterations
+  const T gap = T(1.0) / ((c1_ + cmu_) * T(n) * T(10.0));
+  if (T(iter_ - eigen_iter_) > gap) {
+    this->Decompose();
+    eigen_iter_ = iter_;
+  }
+}
+  
+#pragma mark -
+#pragma mark Private
+  
+/*
+ *  @name   Decompose
+ *  @fn     void Decompose(void)
+ *  @brief  Eigen decomposition of the covariance, C = B D^2 B'
+ */
+template<typename T>
+void CmaEs<T>::Decompose(void) {
+  using LA = LinearAlgebra<T>;
+  const int n = static_cast<int>(this->dim_);
+  std::vector<T> a(c_);
+  std::vector<T> w(n);
+  std::vector<T> z(n * n);
+  std::vector<int> isuppz(2 * n);
+  std::vector<T> work(26 * n);
+  std::vector<int> iwork(10 * n);
+  typename LA::Lapack::sym_eig_params p;
+  p.k_jobz = 'V';
+  p.k_range = 'A';
+  p.k_uplo = 'U';
+  p.k_n = n;
+  p.k_a = a.data();
+  p.k_lda = n;
+  p.k_vl = T(0.0);
+  p.k_vu = T(0.0);
+  p.k_il = 0;
+  p.k_iu = 0;
+  p.k_abstol = T(-1.0);
+  p.k_found = 0;
+  p.k_w = w.data();
+  p.k_z = z.data();
+  p.k_ldz = n;
+  p.k_isuppz = isuppz.data();
+  p.k_work = work.data();
+  p.k_lwork = static_cast<int>(work.size());
+  p.k_iwork = iwork.data();
+  p.k_liwork = static_cast<int>(iwork.size());
+  p.k_info = 0;
+  LA::Lapack::SymEigCall(p);
+  if (p.k_info != 0) {
+    FACEKIT_LOG_ERROR("Covariance eigen decomposition failed, info: " <<
+                      p.k_info);
+    return;
+  }
+  b_.swap(z);
+  const T eps = std::numeric_limits<T>::epsilon();
+  for (int i = 0; i < n; ++i) {
+    d_[i] = std::sqrt(std::max(w[i], eps));
+  }
+  // C^-1/2 = B D^-1 B'
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      T v = T(0.0);
+      for (int k = 0; k < n; ++k) {
+        v += b_[k * n + i] * b_[k * n + j] / d_[k];
+      }
+      inv_sqrt_c_[i * n + j] = v;
+    }
+  }
+}
+  
+#pragma mark -
+#pragma mark Explicit instantiation
+  
+/** Float */
+template class CmaEs<float>;
+/** Double */
+template class CmaEs<double>;
+  
+}  // namespace FaceKit
@@ -0,0 +1,118 @@
+/**
+ *  @file   continuous_solver.cpp
+ *  @brief Interface for population based solvers of continuous problems
+ *  @ingroup optimisation
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/optimisation/continuous_solver.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+/*
+ *  @name   ContinuousSolver
+ *  @fn     ContinuousSolver(const size_t& dim, const size_t& lambda)
+ *  @brief  Constructor
+ *  @param[in] dim    Problem dimension
+ *  @param[in] lambda Number of candidates per iteration
+ */
+template<typename T>
+ContinuousSolver<T>::ContinuousSolver(const size_t& dim,
+                                      const size_t& lambda) :
+        dim_(dim),
+        lambda_(lambda),
+        candidate_(dim * lambda),
+        cost_(lambda),
+        best_(dim, T(0.0)),
+        best_cost_(std::numeric_limits<T>::max()),
+        n_eval_(0) {
+}
+  
+#pragma mark -
+#pragma mark Usage
+  
+/*
+ *  @name   Ask
+ *  @fn     const T* Ask(void)
+ *  @brief  Generate the candidates of the next iteration
+ *  @return Candidates, [lambda x dim] row-major, valid until the next call
+ */
+template<typename T>
+const T* ContinuousSolver<T>::Ask(void) {
+  this->Sample(candidate_.data());
+  return candidate_.data();
+}
+  
+/*
+ *  @name   Tell
+ *  @fn     void Tell(const T* cost)
+ *  @brief  Report the cost of the candidates given by the last `Ask`
+ *  @param[in] cost Cost of each candidate, `lambda` values
+ */
+template<typename T>
+void ContinuousSolver<T>::Tell(const T* cost) {
+  // Track best candidate
+  const size_t k = std::min_element(cost, cost + lambda_) - cost;
+  if (cost[k] < best_cost_) {
+    best_cost_ = cost[k];
+    std::copy(&candidate_[k * dim_], &candidate_[(k + 1) * dim_],
+              best_.begin());
+  }
+  n_eval_ += lambda_;
+  this->Update(candidate_.data(), cost);
+}
+  
+/*
+ *  @name   Minimize
+ *  @fn     size_t Minimize(const Objective& objective,
+ *                          const size_t& max_iter, const T& target)
+ *  @brief  Iterate until the best cost reaches `target` or `max_iter`
+ *          iterations are done. Candidates are evaluated concurrently.
+ *  @param[in] objective  Cost function
+ *  @param[in] max_iter   Maximum number of iterations
+ *  @param[in] target     Cost to reach
+ *  @return Number of iterations done
+ */
+template<typename T>
+size_t ContinuousSolver<T>::Minimize(const Objective& objective,
+                                     const size_t& max_iter,
+                                     const T& target) {
+  auto& pool = ThreadPool::Get();
+  size_t it = 0;
+  while (it < max_iter && best_cost_ > target) {
+    const T* x = this->Ask();
+    // One candidate per chunk, the cost of an evaluation is unknown
+    pool.ParallelFor(0, lambda_, 1, [&](const size_t& first,
+                                        const size_t& last) {
+      for (size_t k = first; k < last; ++k) {
+        cost_[k] = objective(x + k * dim_);
+      }
+    });
+    this->Tell(cost_.data());
+    ++it;
+  }
+  return it;
+}
+  
+#pragma mark -
+#pragma mark Explicit instantiation
+  
+/** Float */
+template class ContinuousSolver<float>;
+/** Double */
+template class ContinuousSolver<double>;
+  
+}  // namespace FaceKit
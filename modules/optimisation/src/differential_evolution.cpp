@@ -0,0 +1,134 @@
+/**
+ *  @file   differential_evolution.cpp
+ *  @brief Differential evolution solver for continuous problems
+ *  @ingroup optimisation
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <random>
+
+#include "facekit/optimisation/differential_evolution.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+/*
+ *  @name   DifferentialEvolution
+ *  @fn     DifferentialEvolution(const std::vector<T>& lower,
+ *                                const std::vector<T>& upper,
+ *                                const size_t& pop_size,
+ *                                const Parameters& params)
+ *  @brief  Constructor
+ *  @param[in] lower    Lower bound of each dimension
+ *  @param[in] upper    Upper bound of each dimension
+ *  @param[in] pop_size Population size, at least 4
+ *  @param[in] params   Solver's parameters
+ */
+template<typename T>
+DifferentialEvolution<T>::
+DifferentialEvolution(const std::vector<T>& lower,
+                      const std::vector<T>& upper,
+                      const size_t& pop_size,
+                      const Parameters& params) :
+        ContinuousSolver<T>(lower.size(), pop_size),
+        lower_(lower),
+        upper_(upper),
+        params_(params),
+        x_(lower.size() * pop_size),
+        cost_(pop_size),
+        init_(false),
+        generator_(params.seed, 0) {
+  assert(lower.size() == upper.size());
+  assert(pop_size >= 4);
+}
+  
+#pragma mark -
+#pragma mark Protected
+  
+/*
+ *  @name   Sample
+ *  @fn     void Sample(T* candidates)
+ *  @brief  Generate one trial vector per member
+ *  @param[out] candidates  Where to write them, [lambda x dim]
+ */
+template<typename T>
+void DifferentialEvolution<T>::Sample(T* candidates) {
+  const size_t n = this->dim_;
+  const size_t np = this->lambda_;
+  if (!init_) {
+    // Initial population, uniform within the bounds
+    std::uniform_real_distribution<T> u(T(0.0), T(1.0));
+    for (size_t i = 0; i < np; ++i) {
+      for (size_t j = 0; j < n; ++j) {
+        x_[i * n + j] = lower_[j] + u(generator_) * (upper_[j] - lower_[j]);
+      }
+    }
+    std::copy(x_.begin(), x_.end(), candidates);
+    return;
+  }
+  std::uniform_int_distribution<size_t> pick(0, np - 1);
+  std::uniform_int_distribution<size_t> pick_dim(0, n - 1);
+  std::uniform_real_distribution<T> u(T(0.0), T(1.0));
+  for (size_t i = 0; i < np; ++i) {
+    // Three distinct members, all different from i
+    size_t r0, r1, r2;
+    do { r0 = pick(generator_); } while (r0 == i);
+    do { r1 = pick(generator_); } while (r1 == i || r1 == r0);
+    do { r2 = pick(generator_); } while (r2 == i || r2 == r0 || r2 == r1);
+    const T* a = &x_[r0 * n];
+    const T* b = &x_[r1 * n];
+    const T* c = &x_[r2 * n];
+    const T* xi = &x_[i * n];
+    T* trial = &candidates[i * n];
+    // Binomial crossover, at least one dimension comes from the mutant
+    const size_t jrand = pick_dim(generator_);
+    for (size_t j = 0; j < n; ++j) {
+      if (j == jrand || u(generator_) < params_.crossover) {
+        const T v = a[j] + params_.weight * (b[j] - c[j]);
+        trial[j] = std::min(std::max(v, lower_[j]), upper_[j]);
+      } else {
+        trial[j] = xi[j];
+      }
+    }
+  }
+}
+  
+/*
+ *  @name   Update
+ *  @fn     void Update(const T* candidates, const T* cost)
+ *  @brief  Replace members by their trial when it is not worse
+ *  @param[in] candidates Candidates, [lambda x dim]
+ *  @param[in] cost       Cost of each candidate
+ */
+template<typename T>
+void DifferentialEvolution<T>::Update(const T* candidates, const T* cost) {
+  const size_t n = this->dim_;
+  for (size_t i = 0; i < this->lambda_; ++i) {
+    if (!init_ || cost[i] <= cost_[i]) {
+      cost_[i] = cost[i];
+      std::copy(&candidates[i * n], &candidates[(i + 1) * n], &x_[i * n]);
+    }
+  }
+  init_ = true;
+}
+  
+#pragma mark -
+#pragma mark Explicit instantiation
+  
+/** Float */
+template class DifferentialEvolution<float>;
+/** Double */
+template class DifferentialEvolution<double>;
+  
+}  // namespace FaceKit
@@ -0,0 +1,111 @@
+/**
+ *  @file   fitness_cache.cpp
+ *  @brief Memoisation of chromosome fitness
+ *  @ingroup optimisation
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+
+#include "facekit/optimisation/fitness_cache.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/**
+ *  @name   Hash
+ *  @fn     template<typename T> static uint64_t Hash(const T* genes,
+                                                      const size_t& n)
+ *  @brief  FNV-1a hash of the genes' bytes
+ *  @param[in] genes  Genes
+ *  @param[in] n      Number of genes
+ *  @tparam T Data type
+ *  @return Hash value
+ */
+template<typename T>
+static uint64_t Hash(const T* genes, const size_t& n) {
+  const uint8_t* ptr = reinterpret_cast<const uint8_t*>(genes);
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (size_t k = 0; k < n * sizeof(T); ++k) {
+    h = (h ^ ptr[k]) * 0x100000001b3ull;
+  }
+  return h;
+}
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+/*
+ *  @name   FitnessCache
+ *  @fn     explicit FitnessCache(const size_t& capacity)
+ *  @brief  Constructor
+ *  @param[in] capacity Maximum number of genomes stored
+ */
+template<typename T>
+FitnessCache<T>::FitnessCache(const size_t& capacity) : capacity_(capacity) {
+  entries_.reserve(capacity);
+}
+  
+#pragma mark -
+#pragma mark Usage
+  
+/*
+ *  @name   Find
+ *  @fn     bool Find(const T* genes, const size_t& n, T* fitness) const
+ *  @brief  Look for the fitness of a genome
+ *  @param[in] genes    Genes
+ *  @param[in] n        Number of genes
+ *  @param[out] fitness Fitness, if found
+ *  @return True if found, false otherwise
+ */
+template<typename T>
+bool FitnessCache<T>::Find(const T* genes, const size_t& n, T* fitness) const {
+  auto it = entries_.find(Hash(genes, n));
+  if (it == entries_.end() ||
+      it->second.genes.size() != n ||
+      !std::equal(genes, genes + n, it->second.genes.begin())) {
+    return false;
+  }
+  *fitness = it->second.fitness;
+  return true;
+}
+  
+/*
+ *  @name   Insert
+ *  @fn     void Insert(const T* genes, const size_t& n, const T& fitness)
+ *  @brief  Add the fitness of a genome
+ *  @param[in] genes    Genes
+ *  @param[in] n        Number of genes
+ *  @param[in] fitness  Fitness
+ */
+template<typename T>
+void FitnessCache<T>::Insert(const T* genes,
+                             const size_t& n,
+                             const T& fitness) {
+  if (capacity_ == 0) {
+    return;
+  }
+  if (entries_.size() >= capacity_) {
+    entries_.clear();
+  }
+  // On collision the most recent genome wins
+  Entry& e = entries_[Hash(genes, n)];
+  e.fitness = fitness;
+  e.genes.assign(genes, genes + n);
+}
+  
+#pragma mark -
+#pragma mark Explicit instantiation
+  
+/** Float */
+template class FitnessCache<float>;
+/** Double */
+template class FitnessCache<double>;
+  
+}  // namespace FaceKit
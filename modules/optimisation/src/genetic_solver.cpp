@@ -9,7 +9,9 @@
  *  Copyright © 2018 Christophe Ecabert. All rights reserved.
  */
 
-#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 
 #include "facekit/optimisation/genetic_solver.hpp"
 
@@ -37,10 +39,13 @@ GeneticSolver<T>::GeneticSolver(const size_t& pop_size,
                                 const ChromosomeCtor& ctor) :
   curr_population_(new Population<T>(pop_size)),
   next_population_(new Population<T>(pop_size)),
+  cache_(4 * pop_size),
   chromo_length_(chromo_size) {
   // Init population
     curr_population_->Create(chromo_size, ctor);
     next_population_->Create(chromo_size, ctor);
+    curr_population_->set_fitness_cache(&cache_);
+    next_population_->set_fitness_cache(&cache_);
 }
   
 /*
@@ -70,7 +75,9 @@ GeneticSolver<T>::~GeneticSolver(void) {
 template<typename T>
 typename GeneticSolver<T>::ConvergenceType
 GeneticSolver<T>::Solve(const Parameters& params) {
-  std::ofstream stream("log.txt");
+  using Clock = std::chrono::steady_clock;
+  curr_population_->set_selection(params.selection, params.tournament_size);
+  next_population_->set_selection(params.selection, params.tournament_size);
   // Compute fitness
   // T avg_fit_begin = curr_population_->Fitness();
   size_t n_gen = 0;
@@ -81,14 +88,21 @@ GeneticSolver<T>::Solve(const Parameters& params) {
   while(n_gen < params.max_generation &&
         prev_max_fit < params.fitness_target &&
         hist_max_fit_cnt < params.n_max_fitness_generation) {
-    // Perform CrossOver / Mutation / Fitness
-    this->CrossOver(params.p_crossover);
-    this->Mutate(params.p_mutation);
-    T avg_fit_next = next_population_->Fitness();
-    T next_max_fit = next_population_->maximum_fitness();
-    // Alternate current <-> next generation
-    std::swap(curr_population_, next_population_);
+    // Perform CrossOver / Mutation / Fitness, timed only if observed
+    T avg_fit_next = 0.0;
+    const auto start = observer_ ? Clock::now() : Clock::time_point();
+    T next_max_fit = this->Evolve(params, &avg_fit_next);
     n_gen++;
+    if (observer_) {
+      const std::chrono::duration<double, std::milli> dt = Clock::now() -
+                                                            start;
+      GenerationStats stats;
+      stats.generation = n_gen;
+      stats.average_fitness = avg_fit_next;
+      stats.maximum_fitness = next_max_fit;
+      stats.time_ms = dt.count();
+      observer_(stats);
+    }
     prev_max_fit = next_max_fit;
     if (prev_max_fit > max_max_fit) {
       max_max_fit = prev_max_fit;
@@ -102,14 +116,59 @@ GeneticSolver<T>::Solve(const Parameters& params) {
         hist_max_fit_cnt = 0;
       }
     }
-    
-    stream << avg_fit_next << "," << next_max_fit << std::endl;
-    
   }
   return (n_gen == params.max_generation ?
           ConvergenceType::kReachMaxGeneration : ConvergenceType::kConverged);
 }
   
+/*
+ *  @name   Evolve
+ *  @fn     T Evolve(const Parameters& params, T* average = nullptr)
+ *  @brief  Generate and evaluate the next generation (crossover, mutation,
+ *          fitness), without checking any convergence criterion. The
+ *          `n_elite` fittest chromosomes, or the fraction not replaced
+ *          in steady state, are carried over and not evaluated again.
+ *  @param[in] params   Configuration
+ *  @param[out] average Average fitness of the new generation, if not
+ *                      nullptr
+ *  @return Maximum fitness of the new generation
+ */
+template<typename T>
+T GeneticSolver<T>::Evolve(const Parameters& params, T* average) {
+  // Number of chromosomes carried over
+  const size_t n = curr_population_->size();
+  const T replaced = std::min(std::max(params.replacement, T(0.0)), T(1.0));
+  const size_t n_new = static_cast<size_t>(std::ceil(replaced * T(n)));
+  const size_t n_survivor = std::min(std::max(params.n_elite, n - n_new), n);
+  this->CrossOver(params.p_crossover, n_survivor);
+  this->Mutate(params.p_mutation, n_survivor);
+  const T avg = next_population_->Fitness();
+  if (average) {
+    *average = avg;
+  }
+  // Alternate current <-> next generation
+  std::swap(curr_population_, next_population_);
+  return curr_population_->maximum_fitness();
+}
+  
+/*
+ *  @name   CsvObserver
+ *  @fn     static Observer CsvObserver(std::ostream* stream)
+ *  @brief  Create an observer writing "generation,average,maximum,time_ms"
+ *          lines to `stream`. Lines are not flushed, the stream's own
+ *          buffering applies.
+ *  @param[in] stream Output stream, must outlive the solve
+ *  @return Observer
+ */
+template<typename T>
+typename GeneticSolver<T>::Observer
+GeneticSolver<T>::CsvObserver(std::ostream* stream) {
+  return [stream](const GenerationStats& stats) {
+    *stream << stats.generation << "," << stats.average_fitness << ","
+            << stats.maximum_fitness << "," << stats.time_ms << "\n";
+  };
+}
+  
 /*
  *  @name   BestFitness
  *  @fn     ChromosomeType* BestFitness(void) const
@@ -129,34 +188,26 @@ GeneticSolver<T>::BestFitness(void) const {
   
 /*
  *  @name   CrossOver
- *  @fn     void CrossOver(const T& rate)
+ *  @fn     void CrossOver(const T& rate, const size_t& n_survivor)
  *  @brief  Perform crossover
- *  @param[in] rate Crossover rate
+ *  @param[in] rate       Crossover rate
+ *  @param[in] n_survivor Number of fittest chromosomes carried over
  */
 template<typename T>
-void GeneticSolver<T>::CrossOver(const T& rate) {
-  // Loop overall
-  size_t k = 0;
-  /*for (; k < curr_population_->size() - 2; k += 2) {
-    auto* s1 = next_population_->at(k);
-    auto* s2 = next_population_->at(k+1);
-    curr_population_->CrossOver(rate, s1, s2);
-  }*/
-  for (;k < curr_population_->size(); ++k) {
-    auto* s1 = next_population_->at(k);
-    curr_population_->CrossOver(rate, s1, nullptr);
-  }
+void GeneticSolver<T>::CrossOver(const T& rate, const size_t& n_survivor) {
+  curr_population_->CrossOver(rate, next_population_, n_survivor);
 }
   
 /*
  *  @name   Mutate
- *  @fn     void Mutate(const T& rate)
- *  @brief  Perform mutation
- *  @param[in] rate Mutation rate
+ *  @fn     void Mutate(const T& rate, const size_t& n_survivor)
+ *  @brief  Perform mutation, survivors are not mutated
+ *  @param[in] rate       Mutation rate
+ *  @param[in] n_survivor Number of fittest chromosomes carried over
  */
 template<typename T>
-void GeneticSolver<T>::Mutate(const T& rate) {
-  next_population_->Mutate(rate);
+void GeneticSolver<T>::Mutate(const T& rate, const size_t& n_survivor) {
+  next_population_->Mutate(rate, n_survivor);
 }
   
 #pragma mark -
@@ -0,0 +1,143 @@
+/**
+ *  @file   island_solver.cpp
+ *  @brief Island model genetic algorithm solver
+ *  @ingroup optimisation
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+
+#include "facekit/core/task_group.hpp"
+#include "facekit/optimisation/island_solver.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+/*
+ *  @name   IslandSolver
+ *  @fn     IslandSolver(const size_t& n_island, const size_t& pop_size,
+ *                       const size_t& chromo_size,
+ *                       const ChromosomeCtor& ctor)
+ *  @brief  Constructor
+ *  @param[in] n_island     Number of islands
+ *  @param[in] pop_size     Population size of each island
+ *  @param[in] chromo_size  Size of one chromosome
+ *  @param[in] ctor         Callback creating a derived chromosome
+ */
+template<typename T>
+IslandSolver<T>::IslandSolver(const size_t& n_island,
+                              const size_t& pop_size,
+                              const size_t& chromo_size,
+                              const ChromosomeCtor& ctor) {
+  for (size_t k = 0; k < n_island; ++k) {
+    islands_.emplace_back(new Solver(pop_size, chromo_size, ctor));
+  }
+}
+  
+#pragma mark -
+#pragma mark Usage
+  
+/*
+ *  @name   Solve
+ *  @fn     ConvergenceType Solve(const Parameters& params)
+ *  @brief  Evolve every islands until one reaches the fitness target or
+ *          the maximum number of generations is reached
+ *  @param[in] params Configuration
+ *  @return Convergence type
+ */
+template<typename T>
+typename IslandSolver<T>::ConvergenceType
+IslandSolver<T>::Solve(const Parameters& params) {
+  const auto& island = params.island;
+  const size_t interval = std::max(params.interval, size_t(1));
+  std::vector<T> best(islands_.size(), T(0.0));
+  size_t n_gen = 0;
+  bool converged = false;
+  while (n_gen < island.max_generation && !converged) {
+    // Evolve islands independently until the next migration
+    const size_t n = std::min(interval, island.max_generation - n_gen);
+    TaskGroup group;
+    for (size_t i = 0; i < islands_.size(); ++i) {
+      group.Run([&, i]() {
+        for (size_t g = 0; g < n; ++g) {
+          best[i] = islands_[i]->Evolve(island);
+          if (best[i] >= island.fitness_target) {
+            break;
+          }
+        }
+      });
+    }
+    group.Wait();
+    n_gen += n;
+    converged = *std::max_element(best.begin(),
+                                  best.end()) >= island.fitness_target;
+    if (!converged && n_gen < island.max_generation) {
+      this->Migrate(params.n_migrant);
+    }
+  }
+  return (converged ?
+          ConvergenceType::kConverged : ConvergenceType::kReachMaxGeneration);
+}
+  
+/*
+ *  @name   BestFitness
+ *  @fn     ChromosomeType* BestFitness(void) const
+ *  @brief  Give the chromosome with the best fitness over all islands
+ *  @return Chromosome with solution
+ */
+template<typename T>
+typename IslandSolver<T>::ChromosomeType*
+IslandSolver<T>::BestFitness(void) const {
+  size_t best = 0;
+  for (size_t k = 1; k < islands_.size(); ++k) {
+    if (islands_[k]->maximum_fitness() > islands_[best]->maximum_fitness()) {
+      best = k;
+    }
+  }
+  return islands_[best]->BestFitness();
+}
+  
+#pragma mark -
+#pragma mark Private
+  
+/*
+ *  @name   Migrate
+ *  @fn     void Migrate(const size_t& n_migrant)
+ *  @brief  Send the fittest chromosomes of each island to the next one
+ *  @param[in] n_migrant  Number of chromosomes sent by each island
+ */
+template<typename T>
+void IslandSolver<T>::Migrate(const size_t& n_migrant) {
+  const size_t n = islands_.size();
+  if (n < 2 || n_migrant == 0) {
+    return;
+  }
+  // Collect every emigrant before replacing, an island must not forward the
+  // immigrants it just received
+  std::vector<std::vector<T>> genes(n), fitness(n);
+  for (size_t i = 0; i < n; ++i) {
+    islands_[i]->Emigrate(n_migrant, &genes[i], &fitness[i]);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    islands_[(i + 1) % n]->Immigrate(genes[i], fitness[i]);
+  }
+}
+  
+#pragma mark -
+#pragma mark Explicit instantiation
+  
+/** Float */
+template class IslandSolver<float>;
+/** Double */
+template class IslandSolver<double>;
+  
+}  // namespace FaceKit
@@ -8,9 +8,12 @@
  *  Copyright © 2018 Christophe Ecabert. All rights reserved.
  */
 
+#include <algorithm>
 #include <chrono>
 #include <limits>
 
+#include "facekit/core/math/philox.hpp"
+#include "facekit/core/thread_pool.hpp"
 #include "facekit/optimisation/population.hpp"
 
 /**
@@ -21,6 +24,22 @@ namespace FaceKit {
   
 using clock = std::chrono::high_resolution_clock;
   
+/** Number of chromosomes processed by one parallel task */
+static constexpr size_t kGrain = 4;
+  
+/**
+ *  @name   Uniform01
+ *  @fn     template<typename T> static T Uniform01(Philox4x32* rng)
+ *  @brief  Draw a number uniformly in [0, 1)
+ *  @param[in,out] rng  Random generator
+ *  @tparam T Data type
+ *  @return Random number
+ */
+template<typename T>
+static T Uniform01(Philox4x32* rng) {
+  return static_cast<T>((*rng)() >> 8) * T(1.0 / 16777216.0);
+}
+  
 #pragma mark -
 #pragma mark Initialisation
   
@@ -34,8 +53,16 @@ using clock = std::chrono::high_resolution_clock;
 template<typename T>
 Population<T>::Population(const size_t& size) :
   popultation_(size),
+  length_(0),
   fitness_(size),
-  generator_(clock::now().time_since_epoch().count()) {
+  max_fitness_(0.0),
+  max_fitness_idx_(0),
+  selection_(Selection::kRoulette),
+  tournament_size_(2),
+  cache_(nullptr),
+  seed_(clock::now().time_since_epoch().count()),
+  step_(0) {
+  generator_.Seed(seed_, ~uint64_t(0));
 }
   
 /*
@@ -47,6 +74,9 @@ Population<T>::Population(const size_t& size) :
  */
 template<typename T>
 void Population<T>::Create(const size_t& size, const ChromosomeCtor& ctor) {
+  // Genome, one row per chromosome
+  length_ = size;
+  genome_.assign(popultation_.size() * size, T(0.0));
   // Iterate over all chromosomes
   for (size_t k = 0; k < popultation_.size(); ++k) {
     // Check if element already init
@@ -55,6 +85,7 @@ void Population<T>::Create(const size_t& size, const ChromosomeCtor& ctor) {
     }
     // Init
     auto* obj = ctor(size);
+    obj->Bind(&genome_[k * size]);
     obj->Init();
     popultation_[k] = obj;
   }
@@ -86,19 +117,65 @@ Population<T>::~Population(void) {
  */
 template<typename T>
 T Population<T>::Fitness(void) {
-  T avg = T(0.0);
-  max_fitness_ = 0.0;
-  max_fitness_idx_ = 0;
-  for (size_t k = 0; k < popultation_.size(); ++k) {
-    T fitness = popultation_[k]->Fitness();
-    fitness_[k] = fitness;
-    avg += fitness;
-    if (fitness > max_fitness_) {
-      max_fitness_ = fitness;
-      max_fitness_idx_ = k;
+  // Evaluate each chromosome concurrently, one chromosome per chunk since the
+  // cost of a single evaluation is unknown. Unchanged chromosomes reuse their
+  // previous fitness and known genomes are looked up in the cache. Statistics
+  // are reduced along, partials are combined in range order therefore the
+  // first chromosome with the maximum fitness is selected, as with a serial
+  // scan.
+  evaluated_.assign(popultation_.size(), 0);
+  FitnessStats init;
+  init.sum = T(0.0);
+  init.max = T(0.0);
+  init.idx = 0;
+  auto evaluate = [&](const size_t& first, const size_t& last) {
+    FitnessStats part = init;
+    for (size_t k = first; k < last; ++k) {
+      auto* c = popultation_[k];
+      if (c->dirty_ &&
+          (cache_ == nullptr || !cache_->Find(c->data(),
+                                              c->size(),
+                                              &c->fitness_))) {
+        c->fitness_ = c->Fitness();
+        evaluated_[k] = 1;
+      }
+      c->dirty_ = false;
+      const T fitness = c->fitness_;
+      fitness_[k] = fitness;
+      part.sum += fitness;
+      if (fitness > part.max) {
+        part.max = fitness;
+        part.idx = k;
+      }
+    }
+    return part;
+  };
+  auto combine = [](const FitnessStats& lhs, const FitnessStats& rhs) {
+    FitnessStats res = rhs.max > lhs.max ? rhs : lhs;
+    res.sum = lhs.sum + rhs.sum;
+    return res;
+  };
+  auto& pool = ThreadPool::Get();
+  const FitnessStats stats = pool.ParallelReduce(0,
+                                                 popultation_.size(),
+                                                 1,
+                                                 init,
+                                                 evaluate,
+                                                 combine);
+  max_fitness_ = stats.max;
+  max_fitness_idx_ = stats.idx;
+  // Remember new genomes, serial since the cache is not thread-safe
+  if (cache_ != nullptr) {
+    for (size_t k = 0; k < popultation_.size(); ++k) {
+      if (evaluated_[k]) {
+        const auto* c = popultation_[k];
+        cache_->Insert(c->data(), c->size(), c->fitness_);
+      }
     }
   }
-  return avg / static_cast<T>(popultation_.size());
+  // Selection table is built once per generation
+  this->BuildAliasTable(stats.sum);
+  return stats.sum / static_cast<T>(popultation_.size());
 }
   
 /*
@@ -106,8 +183,7 @@ T Population<T>::Fitness(void) {
  *  @fn     void CrossOver(const T& rate, ChromosomeType* f_signling,
  *                         ChromosomeType* s_sibling) const
  *  @brief  Perform crossover on this population based on each chromosomes
- *          fitness. The selection of the parents are done with a "Roulette
- *          Wheel".
+ *          fitness. The parents are selected according to `set_selection`.
  *  @param[in]  rate  Cross over rate
  *  @param[out] f_sibling First sibling to be generrate by the crossover
  *  @param[out] s_sibling Second sibling generated, if nullptr not used.
@@ -116,105 +192,341 @@ template<typename T>
 void Population<T>::CrossOver(const T& rate,
                               ChromosomeType* f_sibling,
                               ChromosomeType* s_sibling) {
-  // Select parents - Roulette wheel
+  this->Breed(rate, &generator_, f_sibling, s_sibling);
+}
+  
+/*
+ *  @name   CrossOver
+ *  @fn     void CrossOver(const T& rate, Population<T>* next,
+ *                         const size_t& n_survivor = 0)
+ *  @brief  Generate the chromosomes of `next`. The `n_survivor` fittest
+ *          chromosomes of this population are copied unchanged, with their
+ *          fitness, at the beginning of `next` (elitism / steady state), the
+ *          others are generated by crossover. Offsprings are bred
+ *          concurrently, each one with its own random stream, therefore the
+ *          outcome does not depend on the number of threads.
+ *  @param[in]  rate        Cross over rate
+ *  @param[out] next        Population to fill, same size and chromosome
+ *                          length
+ *  @param[in]  n_survivor  Number of chromosomes carried over
+ */
+template<typename T>
+void Population<T>::CrossOver(const T& rate,
+                              Population<T>* next,
+                              const size_t& n_survivor) {
+  const uint64_t step = step_++;
+  // Survivors
+  std::vector<size_t> idx;
+  this->Rank(n_survivor, true, &idx);
+  const size_t n_keep = std::min(n_survivor, next->size());
+  for (size_t k = 0; k < n_keep; ++k) {
+    const auto* src = popultation_[idx[k]];
+    auto* dst = next->popultation_[k];
+    std::copy(src->data(), src->data() + length_, dst->data());
+    dst->fitness_ = src->fitness_;
+    dst->dirty_ = src->dirty_;
+  }
+  // Offsprings
+  ThreadPool::Get().ParallelFor(n_keep,
+                                next->size(),
+                                kGrain,
+                                [&](const size_t& first, const size_t& last) {
+    for (size_t k = first; k < last; ++k) {
+      Philox4x32 rng(seed_, (step << 32) | k);
+      this->Breed(rate, &rng, next->popultation_[k], nullptr);
+    }
+  });
+}
+  
+/*
+ *  @name   Mutate
+ *  @fn     void Mutate(const T& rate, const size_t& first = 0)
+ *  @brief  Call mutation function on the population
+ *  @param[in]  rate  Rate of mutation
+ *  @param[in]  first First chromosome to mutate, i.e. to spare survivors
+ */
+template<typename T>
+void Population<T>::Mutate(const T& rate, const size_t& first) {
+  if (rate <= T(0.0) || length_ == 0 || first >= popultation_.size()) {
+    return;
+  }
+  // Each gene mutates independently with probability `rate`, the gap between
+  // two mutated genes is therefore geometric. Draw the gaps rather than one
+  // number per gene. Chromosomes are mutated concurrently, each one with its
+  // own random stream.
+  const uint64_t step = step_++;
+  const double p = std::min(static_cast<double>(rate), 1.0);
+  ThreadPool::Get().ParallelFor(first,
+                                popultation_.size(),
+                                kGrain,
+                                [&](const size_t& begin, const size_t& end) {
+    std::geometric_distribution<size_t> gap(p);
+    for (size_t c = begin; c < end; ++c) {
+      Philox4x32 rng(seed_, (step << 32) | c);
+      auto* chromosome = popultation_[c];
+      for (size_t k = gap(rng); k < length_; k += gap(rng) + 1) {
+        chromosome->Mutate(k);
+        chromosome->dirty_ = true;
+      }
+    }
+  });
+}
+  
+  
+/*
+ *  @name   Export
+ *  @fn     void Export(const size_t& n, std::vector<T>* genes,
+ *                      std::vector<T>* fitness) const
+ *  @brief  Copy the `n` fittest chromosomes, i.e. for migration.
+ *          Fitness needs to be up to date.
+ *  @param[in] n          Number of chromosomes to export
+ *  @param[out] genes     Genes, one chromosome after the other
+ *  @param[out] fitness   Fitness of each exported chromosome
+ */
+template<typename T>
+void Population<T>::Export(const size_t& n,
+                           std::vector<T>* genes,
+                           std::vector<T>* fitness) const {
+  const size_t m = std::min(n, popultation_.size());
+  std::vector<size_t> idx;
+  this->Rank(m, true, &idx);
+  genes->resize(m * length_);
+  fitness->resize(m);
+  for (size_t k = 0; k < m; ++k) {
+    const T* src = popultation_[idx[k]]->data();
+    std::copy(src, src + length_, genes->data() + k * length_);
+    fitness->at(k) = fitness_[idx[k]];
+  }
+}
+  
+/*
+ *  @name   Import
+ *  @fn     void Import(const std::vector<T>& genes,
+ *                      const std::vector<T>& fitness)
+ *  @brief  Replace the least fit chromosomes by the given ones (see
+ *          `Export`) and update the fitness statistics. Fitness needs to
+ *          be up to date.
+ *  @param[in] genes    Genes, one chromosome after the other
+ *  @param[in] fitness  Fitness of each imported chromosome
+ */
+template<typename T>
+void Population<T>::Import(const std::vector<T>& genes,
+                           const std::vector<T>& fitness) {
+  const size_t m = std::min(fitness.size(), popultation_.size());
+  std::vector<size_t> idx;
+  this->Rank(m, false, &idx);
+  for (size_t k = 0; k < m; ++k) {
+    auto* c = popultation_[idx[k]];
+    const T* src = genes.data() + k * length_;
+    std::copy(src, src + length_, c->data());
+    c->fitness_ = fitness[k];
+    c->dirty_ = false;
+  }
+  // Every chromosome is clean, only refresh the statistics
+  this->Fitness();
+}
+  
+#pragma mark -
+#pragma mark Private
+  
+/*
+ *  @name   Breed
+ *  @fn     void Breed(const T& rate, Philox4x32* rng,
+ *                     ChromosomeType* f_sibling,
+ *                     ChromosomeType* s_sibling) const
+ *  @brief  Select two parents and generate one or two siblings
+ *  @param[in]  rate  Cross over rate
+ *  @param[in,out] rng  Random generator
+ *  @param[out] f_sibling First sibling
+ *  @param[out] s_sibling Second sibling, if nullptr not used.
+ */
+template<typename T>
+void Population<T>::Breed(const T& rate,
+                          Philox4x32* rng,
+                          ChromosomeType* f_sibling,
+                          ChromosomeType* s_sibling) const {
+  // Select parents
   size_t p1 = 0, p2 = 0;
-  this->RouletteWheel(&p1, &p2);
+  this->SelectParents(rng, &p1, &p2);
   // Perform crossover if needed or transfer the parents to the siblings
   auto* f_parent = popultation_[p1];
   auto* s_parent = popultation_[p2];
-  T p_co = dist_(generator_);
+  T p_co = Uniform01<T>(rng);
+  const T* f_genes = f_parent->data();
+  const T* s_genes = s_parent->data();
+  const size_t n = f_sibling->size();
   if (p_co <= rate) {
-    // Do crossover
-    T length = static_cast<T>(f_sibling->size());
-    size_t t1 = static_cast<size_t>(dist_(generator_) * (length - 1.0));
-    size_t t2 = static_cast<size_t>(dist_(generator_) * (length - 1.0));
+    // Two points crossover, exchange [t_min, t_max]
+    T length = static_cast<T>(n);
+    size_t t1 = static_cast<size_t>(Uniform01<T>(rng) * (length - 1.0));
+    size_t t2 = static_cast<size_t>(Uniform01<T>(rng) * (length - 1.0));
     size_t t_min = std::min(t1, t2);
-    size_t t_max = std::max(t1, t2);
-    for (size_t k = 0; k < f_parent->size(); ++k) {
-      if (k < t_min || k > t_max) {
-        f_sibling->at(k) = f_parent->at(k);
-        if (s_sibling) {
-          s_sibling->at(k) = s_parent->at(k);
-        }
-      } else {
-        f_sibling->at(k) = s_parent->at(k);
-        if (s_sibling) {
-          s_sibling->at(k) = f_parent->at(k);
-        }
-      }
+    size_t t_max = std::max(t1, t2) + 1;
+    T* dst = f_sibling->data();
+    std::copy(f_genes, f_genes + t_min, dst);
+    std::copy(s_genes + t_min, s_genes + t_max, dst + t_min);
+    std::copy(f_genes + t_max, f_genes + n, dst + t_max);
+    f_sibling->dirty_ = true;
+    if (s_sibling) {
+      dst = s_sibling->data();
+      std::copy(s_genes, s_genes + t_min, dst);
+      std::copy(f_genes + t_min, f_genes + t_max, dst + t_min);
+      std::copy(s_genes + t_max, s_genes + n, dst + t_max);
+      s_sibling->dirty_ = true;
     }
   } else {
-    // Copy chromosome without doing crossover
-    for (size_t k = 0; k < f_parent->size(); ++k) {
-      f_sibling->at(k) = f_parent->at(k);
-      if (s_sibling) {
-        s_sibling->at(k) = s_parent->at(k);
-      }
+    // Copy chromosome without doing crossover, fitness is inherited
+    std::copy(f_genes, f_genes + n, f_sibling->data());
+    f_sibling->fitness_ = f_parent->fitness_;
+    f_sibling->dirty_ = f_parent->dirty_;
+    if (s_sibling) {
+      std::copy(s_genes, s_genes + n, s_sibling->data());
+      s_sibling->fitness_ = s_parent->fitness_;
+      s_sibling->dirty_ = s_parent->dirty_;
     }
   }
 }
   
 /*
- *  @name   Mutate
- *  @fn     void Mutate(const T& rate)
- *  @brief  Call mutation function on the population
- *  @param[in]  rate  Rate of mutation
+ *  @name   Rank
+ *  @fn     void Rank(const size_t& n, const bool& fittest,
+ *                    std::vector<size_t>* index) const
+ *  @brief  Select the `n` fittest (or least fit) chromosomes, ordered.
+ *          Fitness needs to be up to date.
+ *  @param[in] n        Number of chromosomes to select
+ *  @param[in] fittest  Select the fittest if true, the least fit otherwise
+ *  @param[out] index   Chromosome indexes, the first `n` are selected
  */
 template<typename T>
-void Population<T>::Mutate(const T& rate) {
-  // Loop over all chromosome in the population
-  for (size_t k = 0; k < popultation_.size(); ++k) {
-    auto* c = popultation_[k];
-    // Loop over all gene
-    for (size_t i = 0; i < c->size(); ++i) {
-      T p_m = dist_(generator_);
-      if (p_m <= rate) {
-        // Mutate the ith gene
-        c->Mutate(i);
-      }
+void Population<T>::Rank(const size_t& n,
+                         const bool& fittest,
+                         std::vector<size_t>* index) const {
+  const size_t m = std::min(n, popultation_.size());
+  index->resize(popultation_.size());
+  for (size_t k = 0; k < index->size(); ++k) {
+    index->at(k) = k;
+  }
+  std::partial_sort(index->begin(), index->begin() + m, index->end(),
+                    [&](const size_t& a, const size_t& b) {
+    return fittest ? fitness_[a] > fitness_[b] : fitness_[a] < fitness_[b];
+  });
+}
+  
+/*
+ *  @name   BuildAliasTable
+ *  @fn     void BuildAliasTable(const T& sum)
+ *  @brief  Build the alias table of the fitness proportionate distribution
+ *          (Vose's method), called once fitness is up to date
+ *  @param[in] sum  Sum of the fitness
+ */
+template<typename T>
+void Population<T>::BuildAliasTable(const T& sum) {
+  const size_t n = fitness_.size();
+  alias_prob_.resize(n);
+  alias_idx_.resize(n);
+  if (!(sum > T(0.0))) {
+    // No information, uniform selection
+    std::fill(alias_prob_.begin(), alias_prob_.end(), T(1.0));
+    for (size_t k = 0; k < n; ++k) {
+      alias_idx_[k] = k;
+    }
+    return;
+  }
+  // Scale probabilities so that the average is one, then pair each
+  // underfull entry with an overfull one
+  std::vector<size_t> small, large;
+  small.reserve(n);
+  large.reserve(n);
+  const T scale = static_cast<T>(n) / sum;
+  for (size_t k = 0; k < n; ++k) {
+    alias_prob_[k] = fitness_[k] * scale;
+    alias_idx_[k] = k;
+    if (alias_prob_[k] < T(1.0)) {
+      small.push_back(k);
+    } else {
+      large.push_back(k);
     }
   }
+  while (!small.empty() && !large.empty()) {
+    const size_t s = small.back();
+    const size_t l = large.back();
+    small.pop_back();
+    alias_idx_[s] = l;
+    alias_prob_[l] -= T(1.0) - alias_prob_[s];
+    if (alias_prob_[l] < T(1.0)) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // Leftovers are only due to rounding errors, they are full
+  for (const auto& k : small) {
+    alias_prob_[k] = T(1.0);
+  }
+  for (const auto& k : large) {
+    alias_prob_[k] = T(1.0);
+  }
 }
   
+/*
+ *  @name   Uniform
+ *  @fn     size_t Uniform(Philox4x32* rng) const
+ *  @brief  Draw a chromosome index uniformly
+ *  @param[in,out] rng  Random generator
+ *  @return Chromosome index
+ */
+template<typename T>
+size_t Population<T>::Uniform(Philox4x32* rng) const {
+  const size_t n = popultation_.size();
+  const size_t k = static_cast<size_t>(Uniform01<T>(rng) * static_cast<T>(n));
+  return std::min(k, n - 1);
+}
   
-#pragma mark -
-#pragma mark Private
+/*
+ *  @name   Select
+ *  @fn     size_t Select(Philox4x32* rng) const
+ *  @brief  Draw one parent, in O(1) for roulette selection and
+ *          O(tournament size) for tournament selection
+ *  @param[in,out] rng  Random generator
+ *  @return Chromosome index
+ */
+template<typename T>
+size_t Population<T>::Select(Philox4x32* rng) const {
+  if (selection_ == Selection::kTournament) {
+    size_t best = this->Uniform(rng);
+    for (size_t k = 1; k < tournament_size_; ++k) {
+      const size_t c = this->Uniform(rng);
+      if (fitness_[c] > fitness_[best]) {
+        best = c;
+      }
+    }
+    return best;
+  }
+  // Roulette, fitness not evaluated yet: uniform
+  if (alias_prob_.size() != popultation_.size()) {
+    return this->Uniform(rng);
+  }
+  const size_t k = this->Uniform(rng);
+  return Uniform01<T>(rng) < alias_prob_[k] ? k : alias_idx_[k];
+}
   
 /*
- *  @name   RouletteWheel
- *  @fn     void RouletteWheel(size_t* p1, size_t* p2)
- *  @brief  Select two parents using the "Roulette Wheel" concept.
+ *  @name   SelectParents
+ *  @fn     void SelectParents(Philox4x32* rng, size_t* p1,
+ *                             size_t* p2) const
+ *  @brief  Select two parents, distinct if possible.
  *          Fitness needs to be up to date.
+ *  @param[in,out] rng  Random generator
  *  @param[out] p1  First parent index
  *  @param[out] p2  Second parent index
  */
 template<typename T>
-void Population<T>::RouletteWheel(size_t* p1, size_t* p2) {
-  // Compute fitness proportion
-  static std::vector<T> fit_prop(fitness_.size());
-  T sum = std::accumulate(fitness_.begin(), fitness_.end(), T(0.0));
-  sum += std::numeric_limits<T>::epsilon();
-  fit_prop[0] = fitness_[0] / sum;
-  for (size_t k = 1; k < fitness_.size(); ++k) {
-    fit_prop[k] = (fitness_[k] / sum) + fit_prop[k-1];
-  }
-  // Select parents
-  int cnt = -1;
+void Population<T>::SelectParents(Philox4x32* rng,
+                                  size_t* p1,
+                                  size_t* p2) const {
+  *p1 = this->Select(rng);
+  int cnt = 0;
   do {
-    T first = dist_(generator_);
-    T second = dist_(generator_);
-    bool p1_set = false, p2_set = false;
-    // Find matching index
-    for (size_t k = 0; k < fitness_.size(); ++k) {
-      if (!p1_set && first <= fit_prop[k]) {
-        *p1 = k;
-        p1_set = true;
-      }
-      if (!p2_set && second <= fit_prop[k]) {
-        *p2 = k;
-        p2_set = true;
-      }
-    }
+    *p2 = this->Select(rng);
     cnt++;
   } while (*p1 == *p2 && cnt < 5);
 }
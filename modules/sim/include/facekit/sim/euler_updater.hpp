@@ -22,7 +22,10 @@ namespace FaceKit {
   
 /**
  *  @class  EulerUpdater
- *  @brief  Simple newton mechanic updater
+ *  @brief  Simple newton mechanic updater. Coordinate streams of a block
+ *          are processed one after the other with vectorizable loops.
+ *          Optionally ages the particles in the same pass, replacing a
+ *          separate `TimeUpdater`.
  *  @author Christophe Ecabert
  *  @date   01.10.18
  *  @ingroup sim
@@ -39,11 +42,16 @@ public:
   
   /**
    *  @name   EulerUpdater
-   *  @fn     explicit EulerUpdater(const Acc& acceleration)
+   *  @fn     explicit EulerUpdater(const Acc& acceleration,
+                                    const bool& lifetime = false)
    *  @brief  Constructor
    *  @param[in] acceleration Global acceleration (i.e. gravity)
+   *  @param[in] lifetime     If `true` particles' lifetime is updated as
+   *                          well and expired ones are killed, same as
+   *                          `TimeUpdater` but within a single pass
    */
-  explicit EulerUpdater(const Acc& acceleration);
+  explicit EulerUpdater(const Acc& acceleration,
+                        const bool& lifetime = false);
   
   /**
    *  @name   EulerUpdater
@@ -73,17 +81,41 @@ public:
 #pragma mark Usage
   
   /**
-   *  @name   Update
-   *  @fn     void Update(const T& dt, Particles<T>* particles)
-   *  @brief  Update particles hold by a given container.
+   *  @name   Prepare
+   *  @fn     void Prepare(const T& dt, Particles<T>* particles) override
+   *  @brief  Fill the acceleration stream if the container changed
    *  @param[in] dt Time variation
    *  @param[in,out] particles  Particles to be updated.
    */
-  void Update(const T& dt, Particles<T>* particles);
+  void Prepare(const T& dt, Particles<T>* particles) override;
+
+  /**
+   *  @name   UpdateBlock
+   *  @fn     void UpdateBlock(const T& dt, const size_t& first,
+                               const size_t& last, Particles<T>* particles,
+                               std::vector<size_t>* expired) override
+   *  @brief  Update the alive particles in [first, last)
+   *  @param[in] dt       Time variation
+   *  @param[in] first    First particle
+   *  @param[in] last     Past-the-end particle
+   *  @param[in,out] particles  Particles to be updated.
+   *  @param[out] expired Particles to kill, appended in increasing order
+   */
+  void UpdateBlock(const T& dt,
+                   const size_t& first,
+                   const size_t& last,
+                   Particles<T>* particles,
+                   std::vector<size_t>* expired) override;
   
  private:
   /** Acceleration */
   Acc acc_;
+  /** Update lifetime as well */
+  bool lifetime_;
+  /** Container whose acceleration stream holds `acc_` */
+  const Particles<T>* filled_;
+  /** Number of particles in `filled_` when it was filled */
+  size_t n_filled_;
 };
 
 }  // namespace FaceKit
@@ -11,6 +11,7 @@
 #ifndef __FACEKIT_GENERATOR__
 #define __FACEKIT_GENERATOR__
 
+#include <cstdint>
 #include <vector>
 
 #include "facekit/core/library_export.hpp"
@@ -34,6 +35,13 @@ namespace FaceKit {
 template<typename T>
 class IGenerator : public RefCounter {
  public:
+
+  /**
+   *  @name   IGenerator
+   *  @fn     IGenerator()
+   *  @brief  Constructor, each instance draws from its own random stream
+   */
+  IGenerator();
   
   /**
    *  @name   ~IGenerator
@@ -56,6 +64,77 @@ class IGenerator : public RefCounter {
                         const size_t start_id,
                         const size_t& end_id,
                         Particles<T>* particles) = 0;
+
+  /**
+   *  @name   set_seed
+   *  @fn     void set_seed(const uint64_t& seed)
+   *  @brief  Set the global seed and rewind the sequence
+   *  @param[in] seed Seed
+   */
+  void set_seed(const uint64_t& seed) {
+    seed_ = seed;
+    step_ = 0;
+  }
+
+ protected:
+
+  /**
+   *  @name   Uniform
+   *  @fn     void Uniform(const uint32_t& step, const size_t& first,
+                           const size_t& last, T* u) const
+   *  @brief  Draw uniform samples in [0, 1) for the particles in
+   *          [first, last). Values are given by a counter-based generator
+   *          (Philox4x32) keyed by the seed and indexed by (particle, step,
+   *          instance), therefore ranges can be filled concurrently and the
+   *          result does not depend on how they are split.
+   *  @param[in] step   Emission step, see `NextStep`
+   *  @param[in] first  First particle
+   *  @param[in] last   Past-the-end particle
+   *  @param[out] u     Samples, indexed by particle
+   */
+  void Uniform(const uint32_t& step,
+               const size_t& first,
+               const size_t& last,
+               T* u) const;
+
+  /**
+   *  @name   Uniform
+   *  @fn     void Uniform(const uint32_t& step, const size_t& first,
+                           const size_t& last, T* u0, T* u1, T* u2) const
+   *  @brief  Draw three independent uniform samples in [0, 1) for each
+   *          particle in [first, last), see `Uniform`.
+   *  @param[in] step   Emission step, see `NextStep`
+   *  @param[in] first  First particle
+   *  @param[in] last   Past-the-end particle
+   *  @param[out] u0    First samples, indexed by particle
+   *  @param[out] u1    Second samples, indexed by particle
+   *  @param[out] u2    Third samples, indexed by particle
+   */
+  void Uniform(const uint32_t& step,
+               const size_t& first,
+               const size_t& last,
+               T* u0,
+               T* u1,
+               T* u2) const;
+
+  /**
+   *  @name   NextStep
+   *  @fn     uint32_t NextStep()
+   *  @brief  Counter of `Generate` calls, selects fresh samples for every
+   *          emission
+   *  @return Step to use for the current emission
+   */
+  uint32_t NextStep() {
+    return static_cast<uint32_t>(step_++);
+  }
+
+ private:
+  /** Seed */
+  uint64_t seed_;
+  /** Number of emissions */
+  uint64_t step_;
+  /** Instance identifier, selects the stream */
+  uint32_t id_;
 };
 
 /**
@@ -130,7 +209,7 @@ class FK_EXPORTS Emitter {
 #pragma mark Private
  private:
   /** Generators */
-  std::vector<IGenerator<T>*> gen_;
+  std::vector<RefPtr<IGenerator<T>>> gen_;
   /** Emission rate */
   T rate_;
 };
@@ -0,0 +1,128 @@
+/**
+ *  @file   mesh_collision_updater.hpp
+ *  @brief Collide particles against a triangle mesh
+ *  @ingroup sim
+ *
+ *  @author Christophe Ecabert
+ *  @date   14.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_MESH_COLLISION_UPDATER__
+#define __FACEKIT_MESH_COLLISION_UPDATER__
+
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/math/vector.hpp"
+#include "facekit/geometry/mesh.hpp"
+#include "facekit/geometry/point_query.hpp"
+#include "facekit/sim/updater.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/**
+ *  @class  MeshCollisionUpdater
+ *  @brief  Collide particles, seen as spheres of a given radius, against
+ *          the surface of a static mesh. The closest point on the surface is
+ *          found through the mesh `BVH` (see `PointQuery`), a particle
+ *          closer than its radius to the front side of a triangle, or behind
+ *          it, is moved back onto the front side and the normal part of its
+ *          velocity is reflected.
+ *  @author Christophe Ecabert
+ *  @date   14.11.18
+ *  @ingroup sim
+ *  @tparam T Data type
+ */
+template<typename T>
+class MeshCollisionUpdater : public IUpdater<T> {
+ public:
+#pragma mark -
+#pragma mark Initialisation
+  
+  /**
+   *  @name   MeshCollisionUpdater
+   *  @fn     MeshCollisionUpdater(const T& radius,
+                                   const T& restitution = T(0.5))
+   *  @brief  Constructor
+   *  @param[in] radius       Particle radius
+   *  @param[in] restitution  Fraction of the normal velocity kept after a
+   *                          bounce, in [0, 1]
+   */
+  MeshCollisionUpdater(const T& radius, const T& restitution = T(0.5));
+  
+  /**
+   *  @name   MeshCollisionUpdater
+   *  @fn     MeshCollisionUpdater(const MeshCollisionUpdater& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  MeshCollisionUpdater(const MeshCollisionUpdater& other) = delete;
+  
+  /**
+   *  @name   operator=
+   *  @fn     MeshCollisionUpdater& operator=(const MeshCollisionUpdater& rhs)
+                    = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  MeshCollisionUpdater& operator=(const MeshCollisionUpdater& rhs) = delete;
+  
+  /**
+   *  @name   ~MeshCollisionUpdater
+   *  @fn     ~MeshCollisionUpdater() = default
+   *  @brief  Destructor
+   */
+  ~MeshCollisionUpdater() = default;
+  
+  /**
+   *  @name   Build
+   *  @fn     int Build(const Mesh<T>& mesh)
+   *  @brief  Set the obstacle, the mesh is indexed and can be released
+   *          afterward
+   *  @param[in] mesh Obstacle
+   *  @return -1 if error, 0 otherwise
+   */
+  int Build(const Mesh<T>& mesh);
+  
+#pragma mark -
+#pragma mark Usage
+  
+  /**
+   *  @name   UpdateBlock
+   *  @fn     void UpdateBlock(const T& dt, const size_t& first,
+                               const size_t& last, Particles<T>* particles,
+                               std::vector<size_t>* expired) override
+   *  @brief  Collide the alive particles in [first, last)
+   *  @param[in] dt       Time variation
+   *  @param[in] first    First particle
+   *  @param[in] last     Past-the-end particle
+   *  @param[in,out] particles  Particles to be updated.
+   *  @param[out] expired Particles to kill, appended in increasing order
+   */
+  void UpdateBlock(const T& dt,
+                   const size_t& first,
+                   const size_t& last,
+                   Particles<T>* particles,
+                   std::vector<size_t>* expired) override;
+  
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Particle radius */
+  T radius_;
+  /** Restitution coefficient */
+  T restitution_;
+  /** Closest point queries */
+  PointQuery<T> query_;
+  /** Unit normal of each triangle */
+  std::vector<Vector3<T>> normal_;
+};
+  
+}  // namespace FaceKit
+#endif /* __FACEKIT_MESH_COLLISION_UPDATER__ */
@@ -0,0 +1,136 @@
+/**
+ *  @file   particle_collision_updater.hpp
+ *  @brief Resolve overlaps between particles
+ *  @ingroup sim
+ *
+ *  @author Christophe Ecabert
+ *  @date   14.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_PARTICLE_COLLISION_UPDATER__
+#define __FACEKIT_PARTICLE_COLLISION_UPDATER__
+
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/sim/spatial_grid.hpp"
+#include "facekit/sim/updater.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/**
+ *  @class  ParticleCollisionUpdater
+ *  @brief  Push apart overlapping particles, seen as spheres of a given
+ *          radius. Alive particles are indexed in a `SpatialGrid` once per
+ *          step, each particle then moves itself by half of the overlap
+ *          with each of its neighbors as they were at the beginning of the
+ *          step (Jacobi iteration), therefore blocks are independent.
+ *  @author Christophe Ecabert
+ *  @date   14.11.18
+ *  @ingroup sim
+ *  @tparam T Data type
+ */
+template<typename T>
+class ParticleCollisionUpdater : public IUpdater<T> {
+ public:
+#pragma mark -
+#pragma mark Initialisation
+  
+  /**
+   *  @name   ParticleCollisionUpdater
+   *  @fn     ParticleCollisionUpdater(const T& radius,
+                                       const T& stiffness = T(1.0))
+   *  @brief  Constructor
+   *  @param[in] radius     Particle radius
+   *  @param[in] stiffness  Fraction of the overlap resolved per step, in
+   *                        (0, 1]
+   */
+  ParticleCollisionUpdater(const T& radius, const T& stiffness = T(1.0));
+  
+  /**
+   *  @name   ParticleCollisionUpdater
+   *  @fn     ParticleCollisionUpdater(const ParticleCollisionUpdater& other)
+                    = delete
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  ParticleCollisionUpdater(const ParticleCollisionUpdater& other) = delete;
+  
+  /**
+   *  @name   operator=
+   *  @fn     ParticleCollisionUpdater& operator=(
+                    const ParticleCollisionUpdater& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  ParticleCollisionUpdater&
+  operator=(const ParticleCollisionUpdater& rhs) = delete;
+  
+  /**
+   *  @name   ~ParticleCollisionUpdater
+   *  @fn     ~ParticleCollisionUpdater() = default
+   *  @brief  Destructor
+   */
+  ~ParticleCollisionUpdater() = default;
+  
+#pragma mark -
+#pragma mark Usage
+  
+  /**
+   *  @name   Prepare
+   *  @fn     void Prepare(const T& dt, Particles<T>* particles) override
+   *  @brief  Index the alive particles
+   *  @param[in] dt Time variation
+   *  @param[in,out] particles  Particles to be updated.
+   */
+  void Prepare(const T& dt, Particles<T>* particles) override;
+  
+  /**
+   *  @name   UpdateBlock
+   *  @fn     void UpdateBlock(const T& dt, const size_t& first,
+                               const size_t& last, Particles<T>* particles,
+                               std::vector<size_t>* expired) override
+   *  @brief  Resolve the overlaps of the alive particles in [first, last)
+   *  @param[in] dt       Time variation
+   *  @param[in] first    First particle
+   *  @param[in] last     Past-the-end particle
+   *  @param[in,out] particles  Particles to be updated.
+   *  @param[out] expired Particles to kill, appended in increasing order
+   */
+  void UpdateBlock(const T& dt,
+                   const size_t& first,
+                   const size_t& last,
+                   Particles<T>* particles,
+                   std::vector<size_t>* expired) override;
+  
+#pragma mark -
+#pragma mark Accessors
+  
+  /**
+   *  @name   get_grid
+   *  @fn     const SpatialGrid<T>& get_grid() const
+   *  @brief  Grid of the alive particles, built at the last step
+   */
+  const SpatialGrid<T>& get_grid() const {
+    return grid_;
+  }
+  
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Particle radius */
+  T radius_;
+  /** Fraction of the overlap resolved per step */
+  T stiffness_;
+  /** Neighbor index, cells are one diameter wide */
+  SpatialGrid<T> grid_;
+};
+  
+}  // namespace FaceKit
+#endif /* __FACEKIT_PARTICLE_COLLISION_UPDATER__ */
@@ -15,6 +15,7 @@
 
 #include "facekit/core/library_export.hpp"
 #include "facekit/core/math/vector.hpp"
+#include "facekit/core/math/vector_array.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -24,7 +25,12 @@ namespace FaceKit {
   
 /**
  *  @class  Particles
- *  @brief  Container holding various particles.
+ *  @brief  Container holding various particles. Properties are stored as
+ *          structure of arrays: each coordinate of position, velocity and
+ *          acceleration is a separate stream aligned and padded to
+ *          `Vector3Array::kAlignment`, so updaters can process them with
+ *          plain vectorizable loops. Alive particles are kept packed in
+ *          `[0, n_alive)`, therefore no per-particle flag is stored.
  *  @author Christophe Ecabert
  *  @date   19.09.18
  *  @ingroup sim
@@ -35,7 +41,7 @@ class FK_EXPORTS Particles {
  public:
   
   /** Properties type */
-  using PropType = Vector3<T>;
+  using PropType = Vector3Array<T>;
   
 #pragma mark -
 #pragma mark Initialization
@@ -97,6 +103,17 @@ class FK_EXPORTS Particles {
    *  @param[in] idx  Index of the particle to change state
    */
   void Wake(const size_t& idx);
+
+  /**
+   *  @name   Wake
+   *  @fn     void Wake(const size_t& first, const size_t& last)
+   *  @brief  Turn alive the dead particles in [first, last). When the range
+   *          starts right after the alive ones (i.e. particles generated by
+   *          an `Emitter`) no data is moved.
+   *  @param[in] first  First particle, must be dead
+   *  @param[in] last   Past-the-end particle
+   */
+  void Wake(const size_t& first, const size_t& last);
   
   /**
    *  @name   Kill
@@ -105,67 +122,79 @@ class FK_EXPORTS Particles {
    *  @param[in] idx  Index of the particle to change state
    */
   void Kill(const size_t& idx);
+
+  /**
+   *  @name   Kill
+   *  @fn     void Kill(const std::vector<size_t>& idx)
+   *  @brief  Kill a set of particles in one compaction pass. Holes left by
+   *          the killed particles are filled with the last alive ones
+   *          (unstable partition), each property stream is then processed
+   *          once. Properties of dead particles are left unspecified.
+   *  @param[in] idx  Indices of alive particles to kill, in increasing order
+   *                  and without duplicates
+   */
+  void Kill(const std::vector<size_t>& idx);
   
 #pragma mark -
 #pragma mark Accessors
   
   /**
    *  @name   get_position
-   *  @fn     std::vector<PropType>& get_position() const
+   *  @fn     PropType& get_position() const
    *  @brief  Provide mutable access to position
-   *  @return Vector of particle's position
+   *  @return Particle's position streams
    */
-  std::vector<PropType>& get_position() {
+  PropType& get_position() {
     return position_;
   }
   
   /**
    *  @name   get_position
-   *  @fn     std::vector<PropType>& get_position() const
+   *  @fn     PropType& get_position() const
    *  @brief  Provide mutable access to position
-   *  @return Vector of particle's position
+   *  @return Particle's position streams
    */
-  const std::vector<PropType>& get_position() const {
+  const PropType& get_position() const {
     return position_;
   }
   
   /**
    *  @name   get_velocity
-   *  @fn     std::vector<PropType>& get_velocity() const
+   *  @fn     PropType& get_velocity() const
    *  @brief  Provide mutable access to velocity
-   *  @return Vector of particle's velocity
+   *  @return Particle's velocity streams
    */
-  std::vector<PropType>& get_velocity() {
+  PropType& get_velocity() {
     return velocity_;
   }
   
   /**
    *  @name   get_velocity
-   *  @fn     std::vector<PropType>& get_velocity() const
+   *  @fn     PropType& get_velocity() const
    *  @brief  Provide immutable access to velocity
-   *  @return Vector of particle's velocity
+   *  @return Particle's velocity streams
    */
-  const std::vector<PropType>& get_velocity() const {
+  const PropType& get_velocity() const {
     return velocity_;
   }
   
   /**
    *  @name   get_acceleration
-   *  @fn     std::vector<PropType>& get_acceleration() const
+   *  @fn     PropType& get_acceleration() const
    *  @brief  Provide mutable access to acceleration
-   *  @return Vector of particle's acceleration
+   *  @return Particle's acceleration streams
    */
-  std::vector<PropType>& get_acceleration() {
+  PropType& get_acceleration() {
     return acceleration_;
   }
   
   /**
    *  @name   get_acceleration
-   *  @fn     std::vector<PropType>& get_acceleration() const
+   *  @fn     PropType& get_acceleration() const
    *  @brief  Provide immutable access to acceleration
-   *  @return Vector of particle's acceleration
+   *  @return Particle's acceleration streams
    */
-  const std::vector<PropType>& get_acceleration() const {
+  const PropType& get_acceleration() const {
     return acceleration_;
   }
   
@@ -228,6 +257,17 @@ class FK_EXPORTS Particles {
   size_t get_n_particle() const {
     return n_particle_;
   }
+  
+  /**
+   *  @name   is_alive
+   *  @fn     bool is_alive(const size_t& idx) const
+   *  @brief  Indicate if a given particle is alive
+   *  @param[in] idx  Index of the particle
+   *  @return True if alive
+   */
+  bool is_alive(const size_t& idx) const {
+    return idx < n_alive_;
+  }
 
 #pragma mark -
 #pragma mark Private
@@ -243,19 +283,17 @@ class FK_EXPORTS Particles {
   void Swap(const size_t& a, const size_t& b);
   
   /** Acceleration */
-  std::vector<PropType> acceleration_;
+  PropType acceleration_;
   /** Velocity */
-  std::vector<PropType> velocity_;
+  PropType velocity_;
   /** Position */
-  std::vector<PropType> position_;
+  PropType position_;
   /** Time */
   std::vector<T> time_;
-  /** Alive flags */
-  std::vector<bool> alive_;
-  /** Number of alive particle */
-  size_t n_alive_;
+  /** Number of alive particle, alive ones are in [0, n_alive_) */
+  size_t n_alive_ = 0;
   /** Total number of particle */
-  size_t n_particle_;
+  size_t n_particle_ = 0;
 };
   
   
@@ -0,0 +1,219 @@
+/**
+ *  @file   simulation.hpp
+ *  @brief Fixed time step particle simulation driver
+ *  @ingroup sim
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_SIMULATION__
+#define __FACEKIT_SIMULATION__
+
+#include <memory>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/math/vector_array.hpp"
+#include "facekit/core/task_group.hpp"
+#include "facekit/sim/generator.hpp"
+#include "facekit/sim/particles.hpp"
+#include "facekit/sim/updater_pipeline.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/**
+ *  @class  Simulation
+ *  @brief  Drive emitters and updaters with a fixed time step whatever the
+ *          frame rate. Frame time is accumulated and consumed by whole
+ *          steps, at most `max_substep` per frame (the excess is dropped to
+ *          avoid falling behind forever), the remainder gives the
+ *          interpolation factor used for rendering. Particles are double
+ *          buffered: the steps of a frame run in the background on a copy
+ *          while the caller renders the last completed state, which is
+ *          published at the next `Advance` or `Wait`. Rendering is therefore
+ *          one frame behind the simulation.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup sim
+ *  @tparam T Data type
+ */
+template<typename T>
+class FK_EXPORTS Simulation {
+ public:
+#pragma mark -
+#pragma mark Initialisation
+  
+  /**
+   *  @name   Simulation
+   *  @fn     Simulation(const size_t& n_particle, const T& step,
+                         const size_t& max_substep = 4)
+   *  @brief  Constructor
+   *  @param[in] n_particle   Maximum number of particles
+   *  @param[in] step         Fixed time step
+   *  @param[in] max_substep  Maximum number of steps per frame
+   */
+  Simulation(const size_t& n_particle,
+             const T& step,
+             const size_t& max_substep = 4);
+  
+  /**
+   *  @name   Simulation
+   *  @fn     Simulation(const Simulation& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  Simulation(const Simulation& other) = delete;
+  
+  /**
+   *  @name   operator=
+   *  @fn     Simulation& operator=(const Simulation& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  Simulation& operator=(const Simulation& rhs) = delete;
+  
+  /**
+   *  @name   ~Simulation
+   *  @fn     ~Simulation()
+   *  @brief  Destructor, wait for the running steps
+   */
+  ~Simulation();
+  
+#pragma mark -
+#pragma mark Usage
+  
+  /**
+   *  @name   AddEmitter
+   *  @fn     void AddEmitter(Emitter<T>* emitter)
+   *  @brief  Add an emitter, called at every step before the updaters.
+   *          Takes ownership.
+   *  @param[in] emitter  Emitter to add
+   */
+  void AddEmitter(Emitter<T>* emitter);
+  
+  /**
+   *  @name   AddUpdater
+   *  @fn     void AddUpdater(IUpdater<T>* updater)
+   *  @brief  Add an updater, updaters are fused into a single pass per step
+   *          (see `UpdaterPipeline`)
+   *  @param[in] updater  Updater to add
+   */
+  void AddUpdater(IUpdater<T>* updater);
+  
+  /**
+   *  @name   Advance
+   *  @fn     size_t Advance(const T& dt)
+   *  @brief  Publish the steps of the previous frame, then account `dt`
+   *          and start the resulting steps in the background
+   *  @param[in] dt Frame time
+   *  @return Number of steps started
+   */
+  size_t Advance(const T& dt);
+  
+  /**
+   *  @name   Wait
+   *  @fn     void Wait()
+   *  @brief  Wait for the running steps and publish their result
+   */
+  void Wait();
+  
+  /**
+   *  @name   Interpolate
+   *  @fn     void Interpolate(Vector3Array<T>* position) const
+   *  @brief  Position of the alive particles of the published state at
+   *          `alpha` between the previous step and the last one. Particles
+   *          are reordered when killed, therefore the previous position is
+   *          recovered from the velocity (p - v * step) rather than from an
+   *          older buffer.
+   *  @param[out] position  Interpolated positions, `get_n_alive()` entries
+   */
+  void Interpolate(Vector3Array<T>* position) const;
+  
+#pragma mark -
+#pragma mark Accessors
+  
+  /**
+   *  @name   get_state
+   *  @fn     const Particles<T>& get_state() const
+   *  @brief  Last published state, safe to read while steps are running
+   */
+  const Particles<T>& get_state() const {
+    return state_[front_];
+  }
+  
+  /**
+   *  @name   get_alpha
+   *  @fn     const T& get_alpha() const
+   *  @brief  Interpolation factor of the published state, in [0, 1)
+   */
+  const T& get_alpha() const {
+    return alpha_;
+  }
+  
+  /**
+   *  @name   get_time
+   *  @fn     const T& get_time() const
+   *  @brief  Simulated time of the published state
+   */
+  const T& get_time() const {
+    return time_;
+  }
+  
+  /**
+   *  @name   get_step
+   *  @fn     const T& get_step() const
+   *  @brief  Fixed time step
+   */
+  const T& get_step() const {
+    return step_;
+  }
+  
+#pragma mark -
+#pragma mark Private
+ private:
+  
+  /**
+   *  @name   Step
+   *  @fn     void Step(Particles<T>* particles)
+   *  @brief  Run one fixed step: emit, then update
+   *  @param[in,out] particles  State to advance
+   */
+  void Step(Particles<T>* particles);
+  
+  /** States, published and in progress */
+  Particles<T> state_[2];
+  /** Index of the published state */
+  int front_;
+  /** Emitters */
+  std::vector<std::unique_ptr<Emitter<T>>> emitter_;
+  /** Fused updaters */
+  RefPtr<UpdaterPipeline<T>> pipeline_;
+  /** Running steps */
+  TaskGroup group_;
+  /** Indicate if steps are running */
+  bool pending_;
+  /** Fixed step */
+  T step_;
+  /** Maximum number of steps per frame */
+  size_t max_substep_;
+  /** Frame time not consumed yet */
+  T acc_;
+  /** Interpolation factor of the published state */
+  T alpha_;
+  /** Simulated time of the published state */
+  T time_;
+  /** Interpolation factor of the running steps */
+  T next_alpha_;
+  /** Simulated time at the end of the running steps */
+  T next_time_;
+};
+  
+}  // namespace FaceKit
+#endif /* __FACEKIT_SIMULATION__ */
@@ -0,0 +1,209 @@
+/**
+ *  @file   snapshot_writer.hpp
+ *  @brief Stream particle positions to disk
+ *  @ingroup sim
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_SNAPSHOT_WRITER__
+#define __FACEKIT_SNAPSHOT_WRITER__
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/math/vector_array.hpp"
+#include "facekit/sim/particles.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/**
+ *  @class  SnapshotWriter
+ *  @brief  Record the position of the alive particles at every call to
+ *          `Record`. The step only copies the positions into one of two
+ *          frame buffers, encoding and writing happen on a background thread
+ *          while the next step computes. `Record` only blocks if the disk
+ *          can not keep up with the simulation.
+ *
+ *  File layout, little endian:
+ *  - Header: "FKPS", version (u32), encoding (u8), sizeof(T) (u8)
+ *  - Frame: time (T), number of particles n (u64), keyframe (u8),
+ *    payload size (u64), payload
+ *
+ *  Payload per encoding, SoA (all x, then y, then z):
+ *  - kRaw: n * 3 values of type T
+ *  - kQuantized: per axis min / extent (2 * T), then n * 3 u16 mapped to
+ *    [min, min + extent]
+ *  - kDelta: positions rounded to multiple of `quantum` (i32), stored as
+ *    zigzag varint of the difference with the previous frame. A frame is a
+ *    keyframe (difference with 0) when the number of particles changed,
+ *    since particles can only be matched by index between equal sized
+ *    frames.
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  @ingroup sim
+ *  @tparam T Data type
+ */
+template<typename T>
+class FK_EXPORTS SnapshotWriter {
+ public:
+  
+  /**
+   *  @enum   Encoding
+   *  @brief  Position encoding
+   */
+  enum class Encoding : uint8_t {
+    /** Full precision */
+    kRaw = 0,
+    /** 16 bits per component, relative to the frame's bounding box */
+    kQuantized = 1,
+    /** Fixed precision, difference with previous frame */
+    kDelta = 2
+  };
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+  /**
+   *  @name   SnapshotWriter
+   *  @fn     SnapshotWriter()
+   *  @brief  Constructor
+   */
+  SnapshotWriter();
+  
+  /**
+   *  @name   SnapshotWriter
+   *  @fn     SnapshotWriter(const SnapshotWriter& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  SnapshotWriter(const SnapshotWriter& other) = delete;
+  
+  /**
+   *  @name   operator=
+   *  @fn     SnapshotWriter& operator=(const SnapshotWriter& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  SnapshotWriter& operator=(const SnapshotWriter& rhs) = delete;
+  
+  /**
+   *  @name   ~SnapshotWriter
+   *  @fn     ~SnapshotWriter()
+   *  @brief  Destructor, close the stream if still open
+   */
+  ~SnapshotWriter();
+  
+#pragma mark -
+#pragma mark Usage
+  
+  /**
+   *  @name   Open
+   *  @fn     int Open(const std::string& path, const Encoding& encoding,
+                       const T& quantum = T(1e-4))
+   *  @brief  Create the output file and start the writing thread
+   *  @param[in] path     Output file
+   *  @param[in] encoding Position encoding
+   *  @param[in] quantum  Precision of the `kDelta` encoding
+   *  @return -1 if error, 0 otherwise
+   */
+  int Open(const std::string& path,
+           const Encoding& encoding,
+           const T& quantum = T(1e-4));
+  
+  /**
+   *  @name   Record
+   *  @fn     int Record(const T& time, const Particles<T>& particles)
+   *  @brief  Queue the position of the alive particles for writing
+   *  @param[in] time       Simulation time
+   *  @param[in] particles  Particles to record
+   *  @return -1 if not opened or if writing failed, 0 otherwise
+   */
+  int Record(const T& time, const Particles<T>& particles);
+  
+  /**
+   *  @name   Close
+   *  @fn     int Close()
+   *  @brief  Write the pending frames, stop the writing thread and close
+   *          the file
+   *  @return -1 if any frame could not be written, 0 otherwise
+   */
+  int Close();
+  
+#pragma mark -
+#pragma mark Private
+ private:
+  
+  /**
+   *  @struct Frame
+   *  @brief  Recorded state
+   */
+  struct Frame {
+    /** Simulation time */
+    T time;
+    /** Number of particles */
+    size_t n;
+    /** Position, `n` first entries are valid */
+    Vector3Array<T> position;
+  };
+  
+  /**
+   *  @name   Loop
+   *  @fn     void Loop()
+   *  @brief  Body of the writing thread
+   */
+  void Loop();
+  
+  /**
+   *  @name   Encode
+   *  @fn     void Encode(const Frame& frame, bool* keyframe)
+   *  @brief  Encode a frame into `payload_`
+   *  @param[in] frame      Frame to encode
+   *  @param[out] keyframe  Indicate if the frame is independent of the
+   *                        previous one
+   */
+  void Encode(const Frame& frame, bool* keyframe);
+  
+  /** Output */
+  std::ofstream stream_;
+  /** Encoding */
+  Encoding encoding_;
+  /** Precision of kDelta */
+  T quantum_;
+  /** Frame buffers */
+  Frame frame_[2];
+  /** Indicate if a frame buffer waits to be written */
+  bool full_[2];
+  /** Next frame buffer filled by `Record` */
+  int write_;
+  /** Indicate the writing thread must stop once idle */
+  bool stop_;
+  /** Indicate a write failed */
+  bool error_;
+  /** Protect the frame state */
+  std::mutex mutex_;
+  /** Signal a frame buffer change of state */
+  std::condition_variable cond_;
+  /** Writing thread */
+  std::thread worker_;
+  /** Encoded frame */
+  std::vector<uint8_t> payload_;
+  /** Previous quantized frame for kDelta */
+  std::vector<int32_t> previous_;
+};
+  
+}  // namespace FaceKit
+#endif /* __FACEKIT_SNAPSHOT_WRITER__ */
@@ -0,0 +1,256 @@
+/**
+ *  @file   spatial_grid.hpp
+ *  @brief Uniform spatial hash grid for particle neighbor queries
+ *  @ingroup sim
+ *
+ *  @author Christophe Ecabert
+ *  @date   14.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_SPATIAL_GRID__
+#define __FACEKIT_SPATIAL_GRID__
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/core/math/vector_array.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/**
+ *  @class  SpatialGrid
+ *  @brief  Uniform grid of cubic cells hashed into a table of buckets, an
+ *          unbounded domain therefore costs memory proportional to the
+ *          number of points only. Points are bucketed with a parallel
+ *          counting sort on the bucket id and copied in bucket order, so a
+ *          neighbor query reads contiguous memory. Meant to be rebuilt at
+ *          every step.
+ *  @author Christophe Ecabert
+ *  @date   14.11.18
+ *  @ingroup sim
+ *  @tparam T Data type
+ */
+template<typename T>
+class FK_EXPORTS SpatialGrid {
+ public:
+#pragma mark -
+#pragma mark Initialisation
+
+  /**
+   *  @name   SpatialGrid
+   *  @fn     explicit SpatialGrid(const T& cell_size)
+   *  @brief  Constructor
+   *  @param[in] cell_size  Length of the cells' side, queries are limited to
+   *                        a radius of at most one cell
+   */
+  explicit SpatialGrid(const T& cell_size);
+
+  /**
+   *  @name   SpatialGrid
+   *  @fn     SpatialGrid(const SpatialGrid& other) = default
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  SpatialGrid(const SpatialGrid& other) = default;
+
+  /**
+   *  @name   operator=
+   *  @fn     SpatialGrid& operator=(const SpatialGrid& rhs) = default
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  SpatialGrid& operator=(const SpatialGrid& rhs) = default;
+
+  /**
+   *  @name   ~SpatialGrid
+   *  @fn     ~SpatialGrid() = default
+   *  @brief  Destructor
+   */
+  ~SpatialGrid() = default;
+
+#pragma mark -
+#pragma mark Usage
+
+  /**
+   *  @name   Build
+   *  @fn     void Build(const Vector3Array<T>& points, const size_t& n)
+   *  @brief  Index the first `n` points (i.e. the alive particles)
+   *  @param[in] points Points to index, copied
+   *  @param[in] n      Number of points to index
+   */
+  void Build(const Vector3Array<T>& points, const size_t& n);
+
+  /**
+   *  @name   ForEachNeighbor
+   *  @fn     template<typename F> void ForEachNeighbor(const T& x, const T& y,
+                                    const T& z, const T& radius, F&& fn) const
+   *  @brief  Visit every indexed point within `radius` of (x, y, z). Can be
+   *          called concurrently.
+   *  @param[in] x      Query x coordinate
+   *  @param[in] y      Query y coordinate
+   *  @param[in] z      Query z coordinate
+   *  @param[in] radius Search radius, at most `cell_size`
+   *  @param[in] fn     Called for each point found with the signature
+   *                    `void(const size_t& index, const T& dx, const T& dy,
+   *                    const T& dz, const T& sq_dist)`, where `index` is the
+   *                    position given to `Build` and (dx, dy, dz) the offset
+   *                    from the query to the point as indexed
+   *  @tparam F Callable type
+   */
+  template<typename F>
+  void ForEachNeighbor(const T& x,
+                       const T& y,
+                       const T& z,
+                       const T& radius,
+                       F&& fn) const;
+
+#pragma mark -
+#pragma mark Accessors
+
+  /**
+   *  @name   cell_size
+   *  @fn     const T& cell_size() const
+   *  @brief  Length of the cells' side
+   */
+  const T& cell_size() const {
+    return cell_;
+  }
+
+  /**
+   *  @name   size
+   *  @fn     size_t size() const
+   *  @brief  Number of indexed points
+   */
+  size_t size() const {
+    return index_.size();
+  }
+
+  /**
+   *  @name   get_point
+   *  @fn     const Vector3Array<T>& get_point() const
+   *  @brief  Indexed points in bucket order, see `get_index`
+   */
+  const Vector3Array<T>& get_point() const {
+    return point_;
+  }
+
+  /**
+   *  @name   get_index
+   *  @fn     const std::vector<uint32_t>& get_index() const
+   *  @brief  Original position of the indexed points in bucket order
+   */
+  const std::vector<uint32_t>& get_index() const {
+    return index_;
+  }
+
+#pragma mark -
+#pragma mark Private
+ private:
+
+  /**
+   *  @name   Bucket
+   *  @fn     size_t Bucket(const int64_t& ix, const int64_t& iy,
+                            const int64_t& iz) const
+   *  @brief  Bucket holding a given cell
+   */
+  size_t Bucket(const int64_t& ix, const int64_t& iy, const int64_t& iz) const {
+    const uint64_t h = (uint64_t(ix) * 73856093u) ^
+                       (uint64_t(iy) * 19349663u) ^
+                       (uint64_t(iz) * 83492791u);
+    return static_cast<size_t>(h) & mask_;
+  }
+
+  /**
+   *  @name   Cell
+   *  @fn     int64_t Cell(const T& v) const
+   *  @brief  Cell coordinate of a point coordinate
+   */
+  int64_t Cell(const T& v) const {
+    return static_cast<int64_t>(std::floor(v * inv_cell_));
+  }
+
+  /** Cell side */
+  T cell_;
+  /** Inverse of the cell side */
+  T inv_cell_;
+  /** Number of buckets minus one, power of two */
+  size_t mask_;
+  /** First point of each bucket, `mask_ + 2` entries */
+  std::vector<uint32_t> start_;
+  /** Original position of the points, in bucket order */
+  std::vector<uint32_t> index_;
+  /** Points, in bucket order */
+  Vector3Array<T> point_;
+  /** Bucket of each point, in input order */
+  std::vector<uint32_t> bucket_;
+};
+
+#pragma mark -
+#pragma mark Implementation
+
+/*
+ *  @name   ForEachNeighbor
+ *  @fn     template<typename F> void ForEachNeighbor(const T& x, const T& y,
+                                  const T& z, const T& radius, F&& fn) const
+ *  @brief  Visit every indexed point within `radius` of (x, y, z). Can be
+ *          called concurrently.
+ */
+template<typename T>
+template<typename F>
+void SpatialGrid<T>::ForEachNeighbor(const T& x,
+                                     const T& y,
+                                     const T& z,
+                                     const T& radius,
+                                     F&& fn) const {
+  assert(radius <= cell_);
+  if (index_.empty()) {
+    return;
+  }
+  // Radius is at most one cell, at most 27 cells / buckets to visit. Cells
+  // hashed into the same bucket must be visited once.
+  size_t visited[27];
+  size_t n_visited = 0;
+  const int64_t x0 = this->Cell(x - radius), x1 = this->Cell(x + radius);
+  const int64_t y0 = this->Cell(y - radius), y1 = this->Cell(y + radius);
+  const int64_t z0 = this->Cell(z - radius), z1 = this->Cell(z + radius);
+  const T sq_radius = radius * radius;
+  const T* px = point_.x();
+  const T* py = point_.y();
+  const T* pz = point_.z();
+  for (int64_t iz = z0; iz <= z1; ++iz) {
+    for (int64_t iy = y0; iy <= y1; ++iy) {
+      for (int64_t ix = x0; ix <= x1; ++ix) {
+        const size_t b = this->Bucket(ix, iy, iz);
+        bool seen = false;
+        for (size_t k = 0; k < n_visited; ++k) {
+          seen |= visited[k] == b;
+        }
+        if (seen || n_visited == 27) {
+          continue;
+        }
+        visited[n_visited++] = b;
+        for (uint32_t k = start_[b]; k < start_[b + 1]; ++k) {
+          const T dx = px[k] - x;
+          const T dy = py[k] - y;
+          const T dz = pz[k] - z;
+          const T d = dx * dx + dy * dy + dz * dz;
+          if (d <= sq_radius) {
+            fn(size_t(index_[k]), dx, dy, dz, d);
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace FaceKit
+#endif /* __FACEKIT_SPATIAL_GRID__ */
@@ -11,6 +11,8 @@
 #ifndef __FACEKIT_TIME_UPDATER__
 #define __FACEKIT_TIME_UPDATER__
 
+#include <vector>
+
 #include "facekit/core/library_export.hpp"
 #include "facekit/sim/updater.hpp"
 
@@ -22,7 +24,9 @@ namespace FaceKit {
   
 /**
  *  @class  TimeUpdater
- *  @brief  Update lifetime of particles
+ *  @brief  Update lifetime of particles. Alive particles are aged block
+ *          by block and the expired ones are killed afterward, therefore
+ *          the outcome does not depend on the order of the updates.
  *  @author Christophe Ecabert
  *  @date   01.10.18
  *  @ingroup sim
@@ -69,13 +73,41 @@ class TimeUpdater : public IUpdater<T> {
 #pragma mark Usage
   
   /**
-   *  @name   Update
-   *  @fn     void Update(const T& dt, Particles<T>* particles)
-   *  @brief  Update particles hold by a given container.
-   *  @param[in] dt Time variation
+   *  @name   UpdateBlock
+   *  @fn     void UpdateBlock(const T& dt, const size_t& first,
+                               const size_t& last, Particles<T>* particles,
+                               std::vector<size_t>* expired) override
+   *  @brief  Update the lifetime of the alive particles in [first, last)
+   *  @param[in] dt       Time variation
+   *  @param[in] first    First particle
+   *  @param[in] last     Past-the-end particle
    *  @param[in,out] particles  Particles to be updated.
+   *  @param[out] expired Particles to kill, appended in increasing order
+   */
+  void UpdateBlock(const T& dt,
+                   const size_t& first,
+                   const size_t& last,
+                   Particles<T>* particles,
+                   std::vector<size_t>* expired) override;
+
+  /**
+   *  @name   Age
+   *  @fn     static void Age(const T& dt, const size_t& first,
+                              const size_t& last, T* time,
+                              std::vector<size_t>* expired)
+   *  @brief  Decrease the lifetime of the particles in [first, last) and
+   *          list the ones reaching the end of their life
+   *  @param[in] dt       Time variation
+   *  @param[in] first    First particle
+   *  @param[in] last     Past-the-end particle
+   *  @param[in,out] time Lifetime stream
+   *  @param[out] expired Expired particles, appended in increasing order
    */
-  void Update(const T& dt, Particles<T>* particles);
+  static void Age(const T& dt,
+                  const size_t& first,
+                  const size_t& last,
+                  T* time,
+                  std::vector<size_t>* expired);
 };
   
 }  // namespace FaceKit
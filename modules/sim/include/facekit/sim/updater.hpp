@@ -11,6 +11,8 @@
 #ifndef __FACEKIT_UPDATER__
 #define __FACEKIT_UPDATER__
 
+#include <vector>
+
 #include "facekit/core/refcounter.hpp"
 #include "facekit/sim/particles.hpp"
 
@@ -23,7 +25,12 @@ namespace FaceKit {
 
 /**
  *  @class  IUpdater
- *  @brief  Particle updater interface
+ *  @brief  Particle updater interface. Updaters work on blocks of alive
+ *          particles: `UpdateBlock` only touches the particles of the given
+ *          range and reports the ones to kill instead of killing them,
+ *          therefore blocks can be processed concurrently and several
+ *          updaters can be chained on the same block while it is in cache
+ *          (see `UpdaterPipeline`).
  *  @author Christophe Ecabert
  *  @date   01.10.18
  *  @ingroup sim
@@ -42,12 +49,44 @@ public:
   
   /**
    *  @name   Update
-   *  @fn     virtual void Update(const T& dt, Particles<T>* particles) = 0
-   *  @brief  Update particles hold by a given container.
+   *  @fn     virtual void Update(const T& dt, Particles<T>* particles)
+   *  @brief  Update particles hold by a given container. Calls `Prepare`,
+   *          then `UpdateBlock` on blocks of alive particles split over the
+   *          `ThreadPool` and finally kills the expired particles.
+   *  @param[in] dt Time variation
+   *  @param[in,out] particles  Particles to be updated.
+   */
+  virtual void Update(const T& dt, Particles<T>* particles);
+
+  /**
+   *  @name   Prepare
+   *  @fn     virtual void Prepare(const T& dt, Particles<T>* particles)
+   *  @brief  Called once per step before any block is updated, for work
+   *          that is not local to a block
    *  @param[in] dt Time variation
    *  @param[in,out] particles  Particles to be updated.
    */
-  virtual void Update(const T& dt, Particles<T>* particles) = 0;
+  virtual void Prepare(const T& dt, Particles<T>* particles) {}
+
+  /**
+   *  @name   UpdateBlock
+   *  @fn     virtual void UpdateBlock(const T& dt, const size_t& first,
+                                       const size_t& last,
+                                       Particles<T>* particles,
+                                       std::vector<size_t>* expired) = 0
+   *  @brief  Update the alive particles in [first, last). Can be called
+   *          concurrently on disjoint ranges.
+   *  @param[in] dt       Time variation
+   *  @param[in] first    First particle
+   *  @param[in] last     Past-the-end particle
+   *  @param[in,out] particles  Particles to be updated.
+   *  @param[out] expired Particles to kill, appended in increasing order
+   */
+  virtual void UpdateBlock(const T& dt,
+                           const size_t& first,
+                           const size_t& last,
+                           Particles<T>* particles,
+                           std::vector<size_t>* expired) = 0;
 };
 }  // namespace FaceKit
 #endif /* __FACEKIT_UPDATER__ */
@@ -0,0 +1,122 @@
+/**
+ *  @file   updater_pipeline.hpp
+ *  @brief Chain of particle updaters applied block by block
+ *  @ingroup sim
+ *
+ *  @author Christophe Ecabert
+ *  @date   13.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#ifndef __FACEKIT_UPDATER_PIPELINE__
+#define __FACEKIT_UPDATER_PIPELINE__
+
+#include <vector>
+
+#include "facekit/core/library_export.hpp"
+#include "facekit/sim/updater.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/**
+ *  @class  UpdaterPipeline
+ *  @brief  Compose several updaters into a single pass. Alive particles are
+ *          split into small tiles and every updater is applied to a tile
+ *          before moving to the next one, therefore a tile is loaded once
+ *          per step whatever the number of updaters instead of once per
+ *          updater. Expired particles are killed once the whole pass is
+ *          done.
+ *  @author Christophe Ecabert
+ *  @date   13.11.18
+ *  @ingroup sim
+ *  @tparam T Data type
+ */
+template<typename T>
+class UpdaterPipeline : public IUpdater<T> {
+ public:
+#pragma mark -
+#pragma mark Initialisation
+  
+  /**
+   *  @name   UpdaterPipeline
+   *  @fn     UpdaterPipeline() = default
+   *  @brief  Constructor
+   */
+  UpdaterPipeline() = default;
+  
+  /**
+   *  @name   UpdaterPipeline
+   *  @fn     UpdaterPipeline(const UpdaterPipeline& other) = delete
+   *  @brief  Copy constructor
+   *  @param[in] other  Object to copy from
+   */
+  UpdaterPipeline(const UpdaterPipeline& other) = delete;
+  
+  /**
+   *  @name   operator=
+   *  @fn     UpdaterPipeline& operator=(const UpdaterPipeline& rhs) = delete
+   *  @brief  Assignment operator
+   *  @param[in] rhs  Object to assign from
+   *  @return Newly assigned object
+   */
+  UpdaterPipeline& operator=(const UpdaterPipeline& rhs) = delete;
+  
+  /**
+   *  @name   ~UpdaterPipeline
+   *  @fn     ~UpdaterPipeline()
+   *  @brief  Destructor
+   */
+  ~UpdaterPipeline();
+  
+#pragma mark -
+#pragma mark Usage
+  
+  /**
+   *  @name   AddUpdater
+   *  @fn     void AddUpdater(IUpdater<T>* updater)
+   *  @brief  Append a given `updater` to this pipeline, updaters are applied
+   *          in insertion order.
+   *  @param[in] updater  Updater to add to this pipeline.
+   */
+  void AddUpdater(IUpdater<T>* updater);
+  
+  /**
+   *  @name   Prepare
+   *  @fn     void Prepare(const T& dt, Particles<T>* particles) override
+   *  @brief  Prepare every updater
+   *  @param[in] dt Time variation
+   *  @param[in,out] particles  Particles to be updated.
+   */
+  void Prepare(const T& dt, Particles<T>* particles) override;
+  
+  /**
+   *  @name   UpdateBlock
+   *  @fn     void UpdateBlock(const T& dt, const size_t& first,
+                               const size_t& last, Particles<T>* particles,
+                               std::vector<size_t>* expired) override
+   *  @brief  Apply every updater tile by tile on [first, last)
+   *  @param[in] dt       Time variation
+   *  @param[in] first    First particle
+   *  @param[in] last     Past-the-end particle
+   *  @param[in,out] particles  Particles to be updated.
+   *  @param[out] expired Particles to kill, appended in increasing order
+   */
+  void UpdateBlock(const T& dt,
+                   const size_t& first,
+                   const size_t& last,
+                   Particles<T>* particles,
+                   std::vector<size_t>* expired) override;
+  
+#pragma mark -
+#pragma mark Private
+ private:
+  /** Updaters */
+  std::vector<RefPtr<IUpdater<T>>> upd_;
+};
+  
+}  // namespace FaceKit
+#endif /* __FACEKIT_UPDATER_PIPELINE__ */
@@ -8,9 +8,7 @@
  *  Copyright © 2018 Christophe Ecabert. All rights reserved.
  */
 
-#include <random>
-
-
+#include "facekit/core/thread_pool.hpp"
 #include "facekit/sim/box_generator.hpp"
 
 /**
@@ -19,6 +17,9 @@
  */
 namespace FaceKit {
   
+/** Number of particles generated by one parallel task */
+static constexpr size_t kGrain = 4096;
+  
 #pragma mark -
 #pragma mark Initialisation
   
@@ -55,16 +56,22 @@ void PositionBoxGenerator<T>::Generate(const T& dt,
                                        const size_t start_id,
                                        const size_t& end_id,
                                        Particles<T>* particles) {
-  // Create distribution
-  std::uniform_real_distribution<T> dist;
-  std::mt19937 gen;
-  // Generate particles
+  // Generate particles, draw uniform samples in place then map them into
+  // the box
   auto& pos = particles->get_position();
-  for (size_t i = start_id; i < end_id; ++i) {
-    pos[i].x_ = min_.x_ + dist(gen) * side_.x_;
-    pos[i].y_ = min_.y_ + dist(gen) * side_.y_;
-    pos[i].z_ = min_.z_ + dist(gen) * side_.z_;
-  }
+  T* px = pos.x();
+  T* py = pos.y();
+  T* pz = pos.z();
+  const uint32_t step = this->NextStep();
+  ThreadPool::Get().ParallelFor(start_id, end_id, kGrain,
+                                [&](const size_t& first, const size_t& last) {
+    this->Uniform(step, first, last, px, py, pz);
+    for (size_t i = first; i < last; ++i) {
+      px[i] = min_.x_ + px[i] * side_.x_;
+      py[i] = min_.y_ + py[i] * side_.y_;
+      pz[i] = min_.z_ + pz[i] * side_.z_;
+    }
+  });
 }
   
 #pragma mark -
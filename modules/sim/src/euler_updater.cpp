@@ -8,7 +8,10 @@
  *  Copyright © 2018 Christophe Ecabert. All rights reserved.
  */
 
+#include <algorithm>
+
 #include "facekit/sim/euler_updater.hpp"
+#include "facekit/sim/time_updater.hpp"
 
 /**
  *  @namespace  FaceKit
@@ -16,35 +19,103 @@
  */
 namespace FaceKit {
   
+/**
+ *  @name   Integrate
+ *  @fn     static void Integrate(const T& a, const T& dt, const size_t& first,
+                                  const size_t& last, T* vel, T* pos)
+ *  @brief  Update one coordinate stream of the particles in [first, last)
+ *  @param[in] a      Acceleration along the coordinate
+ *  @param[in] dt     Time variation
+ *  @param[in] first  First particle
+ *  @param[in] last   Past-the-end particle
+ *  @param[in,out] vel  Velocity stream
+ *  @param[in,out] pos  Position stream
+ */
+template<typename T>
+static void Integrate(const T& a,
+                      const T& dt,
+                      const size_t& first,
+                      const size_t& last,
+                      T* vel,
+                      T* pos) {
+  const T dv = a * dt * T(0.5);
+  for (size_t i = first; i < last; ++i) {
+    // Update velocity: v(t) = a*t + v0
+    vel[i] += dv;
+    // Update position: x(t) = 0.5 * a * t^2 + v0*t + x0
+    pos[i] += vel[i] * dt;
+  }
+}
+  
 /*
  *  @name   EulerUpdater
- *  @fn     explicit EulerUpdater(const Acc& acceleration)
+ *  @fn     explicit EulerUpdater(const Acc& acceleration,
+                                  const bool& lifetime = false)
  *  @brief  Constructor
  *  @param[in] acceleration Global acceleration (i.e. gravity)
+ *  @param[in] lifetime     If `true` particles' lifetime is updated as
+ *                          well and expired ones are killed, same as
+ *                          `TimeUpdater` but within a single pass
  */
 template<typename T>
-EulerUpdater<T>::EulerUpdater(const Acc& acceleration) : acc_(acceleration) {}
+EulerUpdater<T>::EulerUpdater(const Acc& acceleration,
+                              const bool& lifetime) : acc_(acceleration),
+                                                      lifetime_(lifetime),
+                                                      filled_(nullptr),
+                                                      n_filled_(0) {}
   
 /*
- *  @name   Update
- *  @fn     void Update(const T& dt, Particles<T>* particles)
- *  @brief  Update particles hold by a given container.
+ *  @name   Prepare
+ *  @fn     void Prepare(const T& dt, Particles<T>* particles) override
+ *  @brief  Fill the acceleration stream if the container changed
  *  @param[in] dt Time variation
  *  @param[in,out] particles  Particles to be updated.
  */
 template<typename T>
-void EulerUpdater<T>::Update(const T& dt, Particles<T>* particles) {
-  auto end = particles->get_n_particle();
-  auto& acc = particles->get_acceleration();
+void EulerUpdater<T>::Prepare(const T& dt, Particles<T>* particles) {
+  // Acceleration is constant and shared by every particle, swapping
+  // particles keeps it therefore the stream is only written when the
+  // container changes.
+  if (filled_ != particles || n_filled_ != particles->get_n_particle()) {
+    auto& acc = particles->get_acceleration();
+    const size_t n = particles->get_n_particle();
+    std::fill(acc.x(), acc.x() + n, acc_.x_);
+    std::fill(acc.y(), acc.y() + n, acc_.y_);
+    std::fill(acc.z(), acc.z() + n, acc_.z_);
+    filled_ = particles;
+    n_filled_ = n;
+  }
+}
+
+/*
+ *  @name   UpdateBlock
+ *  @fn     void UpdateBlock(const T& dt, const size_t& first,
+                             const size_t& last, Particles<T>* particles,
+                             std::vector<size_t>* expired) override
+ *  @brief  Update the alive particles in [first, last)
+ *  @param[in] dt       Time variation
+ *  @param[in] first    First particle
+ *  @param[in] last     Past-the-end particle
+ *  @param[in,out] particles  Particles to be updated.
+ *  @param[out] expired Particles to kill, appended in increasing order
+ */
+template<typename T>
+void EulerUpdater<T>::UpdateBlock(const T& dt,
+                                  const size_t& first,
+                                  const size_t& last,
+                                  Particles<T>* particles,
+                                  std::vector<size_t>* expired) {
   auto& vel = particles->get_velocity();
   auto& pos = particles->get_position();
-  for (size_t i = 0; i < end; ++i) {
-    // Update acc, i.e. constant
-    acc[i] = acc_;
-    // Update velocity: v(t) = a*t + v0
-    vel[i] += acc_ * dt * T(0.5);
-    // Update position: x(t) = 0.5 * a * t^2 + v0*t + x0
-    pos[i] += vel[i] * dt;
+  Integrate(acc_.x_, dt, first, last, vel.x(), pos.x());
+  Integrate(acc_.y_, dt, first, last, vel.y(), pos.y());
+  Integrate(acc_.z_, dt, first, last, vel.z(), pos.z());
+  if (lifetime_) {
+    TimeUpdater<T>::Age(dt,
+                        first,
+                        last,
+                        particles->get_time().data(),
+                        expired);
   }
 }
   
@@ -8,6 +8,9 @@
  *  Copyright © 2018 Christophe Ecabert. All rights reserved.
  */
 
+#include <atomic>
+
+#include "facekit/core/math/philox.hpp"
 #include "facekit/sim/generator.hpp"
 
 /**
@@ -15,7 +18,105 @@
  *  @brief      Development space
  */
 namespace FaceKit {
-  
+
+/** Number of generators created, gives each one its own stream */
+static std::atomic<uint32_t> n_generator(0);
+
+/** Scale mapping the 24 upper bits of a random word into [0, 1) */
+static constexpr double kUnit = 1.0 / 16777216.0;
+
+#pragma mark -
+#pragma mark IGenerator
+
+/*
+ *  @name   IGenerator
+ *  @fn     IGenerator()
+ *  @brief  Constructor, each instance draws from its own random stream
+ */
+template<typename T>
+IGenerator<T>::IGenerator() : seed_(0),
+                              step_(0),
+                              id_(n_generator.fetch_add(1)) {}
+
+/*
+ *  @name   Uniform
+ *  @fn     void Uniform(const uint32_t& step, const size_t& first,
+                         const size_t& last, T* u) const
+ *  @brief  Draw uniform samples in [0, 1) for the particles in
+ *          [first, last). Values are given by a counter-based generator
+ *          (Philox4x32) keyed by the seed and indexed by (particle, step,
+ *          instance), therefore ranges can be filled concurrently and the
+ *          result does not depend on how they are split.
+ *  @param[in] step   Emission step, see `NextStep`
+ *  @param[in] first  First particle
+ *  @param[in] last   Past-the-end particle
+ *  @param[out] u     Samples, indexed by particle
+ */
+template<typename T>
+void IGenerator<T>::Uniform(const uint32_t& step,
+                            const size_t& first,
+                            const size_t& last,
+                            T* u) const {
+  const uint32_t key[2] = {static_cast<uint32_t>(seed_),
+                           static_cast<uint32_t>(seed_ >> 32)};
+  const T scale = T(kUnit);
+  // Each block gives 4 words, one block covers 4 particles
+  const uint64_t b_first = first / 4;
+  const uint64_t b_last = (last + 3) / 4;
+  for (uint64_t b = b_first; b < b_last; ++b) {
+    const uint32_t ctr[4] = {static_cast<uint32_t>(b),
+                             static_cast<uint32_t>(b >> 32),
+                             step,
+                             id_};
+    uint32_t out[4];
+    Philox4x32::Block(ctr, key, out);
+    for (size_t k = 0; k < 4; ++k) {
+      const size_t i = b * 4 + k;
+      if (i >= first && i < last) {
+        u[i] = T(out[k] >> 8) * scale;
+      }
+    }
+  }
+}
+
+/*
+ *  @name   Uniform
+ *  @fn     void Uniform(const uint32_t& step, const size_t& first,
+                         const size_t& last, T* u0, T* u1, T* u2) const
+ *  @brief  Draw three independent uniform samples in [0, 1) for each
+ *          particle in [first, last), see `Uniform`.
+ *  @param[in] step   Emission step, see `NextStep`
+ *  @param[in] first  First particle
+ *  @param[in] last   Past-the-end particle
+ *  @param[out] u0    First samples, indexed by particle
+ *  @param[out] u1    Second samples, indexed by particle
+ *  @param[out] u2    Third samples, indexed by particle
+ */
+template<typename T>
+void IGenerator<T>::Uniform(const uint32_t& step,
+                            const size_t& first,
+                            const size_t& last,
+                            T* u0,
+                            T* u1,
+                            T* u2) const {
+  const uint32_t key[2] = {static_cast<uint32_t>(seed_),
+                           static_cast<uint32_t>(seed_ >> 32)};
+  const T scale = T(kUnit);
+  // One block per particle, the high bit of the last word separates these
+  // streams from the single sample ones
+  for (size_t i = first; i < last; ++i) {
+    const uint32_t ctr[4] = {static_cast<uint32_t>(i),
+                             static_cast<uint32_t>(uint64_t(i) >> 32),
+                             step,
+                             id_ | 0x80000000u};
+    uint32_t out[4];
+    Philox4x32::Block(ctr, key, out);
+    u0[i] = T(out[0] >> 8) * scale;
+    u1[i] = T(out[1] >> 8) * scale;
+    u2[i] = T(out[2] >> 8) * scale;
+  }
+}
+
 #pragma mark -
 #pragma mark Initialisation
   
@@ -26,7 +127,7 @@ namespace FaceKit {
  *  @param[in]  rate  Emission rate, speed at which the particles are emitted
  */
 template<typename T>
-Emitter<T>::Emitter(const T& rate) : gen_(0, nullptr), rate_(rate) {}
+Emitter<T>::Emitter(const T& rate) : gen_(), rate_(rate) {}
   
 /*
  *  @name   ~Emitter
@@ -34,11 +135,7 @@ Emitter<T>::Emitter(const T& rate) : gen_(0, nullptr), rate_(rate) {}
  *  @brief  Destructor
  */
 template<typename T>
-Emitter<T>::~Emitter() {
-  for (auto* g : gen_) {
-    g->Dec();
-  }
-}
+Emitter<T>::~Emitter() = default;
   
 #pragma mark -
 #pragma mark Usage
@@ -57,13 +154,11 @@ void Emitter<T>::Emit(const T& dt, Particles<T>* particles) const {
   const auto start = particles->get_n_alive();
   const auto end = std::min(start + max_new_p, particles->get_n_particle() - 1);
   // Call generators
-  for (auto* g : gen_) {
+  for (const auto& g : gen_) {
     g->Generate(dt, start, end, particles);
   }
-  // Wake new particles
-  for (size_t i = start; i < end; ++i) {
-    particles->Wake(i);
-  }
+  // Wake new particles, generated right after the alive ones
+  particles->Wake(start, end);
 }
   
 /*
@@ -74,13 +169,16 @@ void Emitter<T>::Emit(const T& dt, Particles<T>* particles) const {
  */
 template<typename T>
 void Emitter<T>::AddGenerator(IGenerator<T>* generator) {
-  generator->Inc();
-  gen_.push_back(generator);
+  gen_.push_back(RefPtr<IGenerator<T>>::Share(generator));
 }
   
 #pragma mark -
 #pragma mark Explicit instantiation
   
+/** Float */
+template class IGenerator<float>;
+/** Double */
+template class IGenerator<double>;
 /** Float */
 template class Emitter<float>;
 /** Double */
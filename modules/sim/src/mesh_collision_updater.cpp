@@ -0,0 +1,145 @@
+/**
+ *  @file   mesh_collision_updater.cpp
+ *  @brief Collide particles against a triangle mesh
+ *  @ingroup sim
+ *
+ *  @author Christophe Ecabert
+ *  @date   14.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cmath>
+
+#include "facekit/core/logger.hpp"
+#include "facekit/sim/mesh_collision_updater.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+/*
+ *  @name   MeshCollisionUpdater
+ *  @fn     MeshCollisionUpdater(const T& radius,
+                                 const T& restitution = T(0.5))
+ *  @brief  Constructor
+ *  @param[in] radius       Particle radius
+ *  @param[in] restitution  Fraction of the normal velocity kept after a
+ *                          bounce, in [0, 1]
+ */
+template<typename T>
+MeshCollisionUpdater<T>::MeshCollisionUpdater(const T& radius,
+                                              const T& restitution) :
+        radius_(radius),
+        restitution_(restitution) {}
+  
+/*
+ *  @name   Build
+ *  @fn     int Build(const Mesh<T>& mesh)
+ *  @brief  Set the obstacle, the mesh is indexed and can be released
+ *          afterward
+ *  @param[in] mesh Obstacle
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int MeshCollisionUpdater<T>::Build(const Mesh<T>& mesh) {
+  if (query_.Build(mesh)) {
+    FACEKIT_LOG_ERROR("Unable to index obstacle");
+    return -1;
+  }
+  // Triangle normals, degenerated triangles get a null normal and never
+  // push particles
+  const auto& vertex = mesh.get_vertex();
+  const auto& tri = mesh.get_triangle();
+  normal_.resize(tri.size());
+  for (size_t t = 0; t < tri.size(); ++t) {
+    const auto& a = vertex[tri[t].x_];
+    const auto& b = vertex[tri[t].y_];
+    const auto& c = vertex[tri[t].z_];
+    const T ux = b.x_ - a.x_, uy = b.y_ - a.y_, uz = b.z_ - a.z_;
+    const T vx = c.x_ - a.x_, vy = c.y_ - a.y_, vz = c.z_ - a.z_;
+    Vector3<T> n(uy * vz - uz * vy, uz * vx - ux * vz, ux * vy - uy * vx);
+    const T len = std::sqrt(n.x_ * n.x_ + n.y_ * n.y_ + n.z_ * n.z_);
+    if (len > T(0.0)) {
+      n.x_ /= len;
+      n.y_ /= len;
+      n.z_ /= len;
+    }
+    normal_[t] = n;
+  }
+  return 0;
+}
+  
+#pragma mark -
+#pragma mark Usage
+  
+/*
+ *  @name   UpdateBlock
+ *  @fn     void UpdateBlock(const T& dt, const size_t& first,
+                             const size_t& last, Particles<T>* particles,
+                             std::vector<size_t>* expired) override
+ *  @brief  Collide the alive particles in [first, last)
+ *  @param[in] dt       Time variation
+ *  @param[in] first    First particle
+ *  @param[in] last     Past-the-end particle
+ *  @param[in,out] particles  Particles to be updated.
+ *  @param[out] expired Particles to kill, appended in increasing order
+ */
+template<typename T>
+void MeshCollisionUpdater<T>::UpdateBlock(const T& dt,
+                                          const size_t& first,
+                                          const size_t& last,
+                                          Particles<T>* particles,
+                                          std::vector<size_t>* expired) {
+  if (normal_.empty()) {
+    return;
+  }
+  auto& pos = particles->get_position();
+  auto& vel = particles->get_velocity();
+  T* px = pos.x();
+  T* py = pos.y();
+  T* pz = pos.z();
+  T* vx = vel.x();
+  T* vy = vel.y();
+  T* vz = vel.z();
+  typename PointQuery<T>::Closest res;
+  for (size_t i = first; i < last; ++i) {
+    const Vector3<T> p(px[i], py[i], pz[i]);
+    if (!query_.ClosestPoint(p, &res, radius_)) {
+      continue;
+    }
+    // Signed distance to the triangle's plane
+    const Vector3<T>& n = normal_[res.tri];
+    const T dist = ((p.x_ - res.point.x_) * n.x_ +
+                    (p.y_ - res.point.y_) * n.y_ +
+                    (p.z_ - res.point.z_) * n.z_);
+    if (dist >= radius_) {
+      continue;
+    }
+    // Move onto the front side, touching the surface
+    const T push = radius_ - dist;
+    px[i] += push * n.x_;
+    py[i] += push * n.y_;
+    pz[i] += push * n.z_;
+    // Reflect the velocity going into the surface
+    const T vn = vx[i] * n.x_ + vy[i] * n.y_ + vz[i] * n.z_;
+    if (vn < T(0.0)) {
+      const T k = (T(1.0) + restitution_) * vn;
+      vx[i] -= k * n.x_;
+      vy[i] -= k * n.y_;
+      vz[i] -= k * n.z_;
+    }
+  }
+}
+  
+#pragma mark -
+#pragma mark Explicit instantiation
+  
+template class MeshCollisionUpdater<float>;
+template class MeshCollisionUpdater<double>;
+  
+}  // namespace FaceKit
@@ -0,0 +1,114 @@
+/**
+ *  @file   particle_collision_updater.cpp
+ *  @brief Resolve overlaps between particles
+ *  @ingroup sim
+ *
+ *  @author Christophe Ecabert
+ *  @date   14.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cmath>
+
+#include "facekit/sim/particle_collision_updater.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+/*
+ *  @name   ParticleCollisionUpdater
+ *  @fn     ParticleCollisionUpdater(const T& radius,
+                                     const T& stiffness = T(1.0))
+ *  @brief  Constructor
+ *  @param[in] radius     Particle radius
+ *  @param[in] stiffness  Fraction of the overlap resolved per step, in
+ *                        (0, 1]
+ */
+template<typename T>
+ParticleCollisionUpdater<T>::
+ParticleCollisionUpdater(const T& radius,
+                         const T& stiffness) : radius_(radius),
+                                               stiffness_(stiffness),
+                                               grid_(T(2.0) * radius) {}
+  
+#pragma mark -
+#pragma mark Usage
+  
+/*
+ *  @name   Prepare
+ *  @fn     void Prepare(const T& dt, Particles<T>* particles) override
+ *  @brief  Index the alive particles
+ *  @param[in] dt Time variation
+ *  @param[in,out] particles  Particles to be updated.
+ */
+template<typename T>
+void ParticleCollisionUpdater<T>::Prepare(const T& dt,
+                                          Particles<T>* particles) {
+  grid_.Build(particles->get_position(), particles->get_n_alive());
+}
+  
+/*
+ *  @name   UpdateBlock
+ *  @fn     void UpdateBlock(const T& dt, const size_t& first,
+                             const size_t& last, Particles<T>* particles,
+                             std::vector<size_t>* expired) override
+ *  @brief  Resolve the overlaps of the alive particles in [first, last)
+ *  @param[in] dt       Time variation
+ *  @param[in] first    First particle
+ *  @param[in] last     Past-the-end particle
+ *  @param[in,out] particles  Particles to be updated.
+ *  @param[out] expired Particles to kill, appended in increasing order
+ */
+template<typename T>
+void ParticleCollisionUpdater<T>::UpdateBlock(const T& dt,
+                                              const size_t& first,
+                                              const size_t& last,
+                                              Particles<T>* particles,
+                                              std::vector<size_t>* expired) {
+  // Neighbors are read from the grid's copy, particles only move themselves
+  auto& pos = particles->get_position();
+  T* px = pos.x();
+  T* py = pos.y();
+  T* pz = pos.z();
+  const T diameter = T(2.0) * radius_;
+  const T gain = T(0.5) * stiffness_;
+  for (size_t i = first; i < last; ++i) {
+    const T x = px[i];
+    const T y = py[i];
+    const T z = pz[i];
+    T dx = T(0.0), dy = T(0.0), dz = T(0.0);
+    // Offsets are computed from the grid's copy, i.e. neighbors as they
+    // were at the beginning of the step
+    grid_.ForEachNeighbor(x, y, z, diameter, [&](const size_t& j,
+                                                 const T& ox,
+                                                 const T& oy,
+                                                 const T& oz,
+                                                 const T& sq_dist) {
+      if (j == i || sq_dist <= T(0.0)) {
+        return;
+      }
+      const T d = std::sqrt(sq_dist);
+      const T s = gain * (diameter - d) / d;
+      dx -= s * ox;
+      dy -= s * oy;
+      dz -= s * oz;
+    });
+    px[i] += dx;
+    py[i] += dy;
+    pz[i] += dz;
+  }
+}
+  
+#pragma mark -
+#pragma mark Explicit instantiation
+  
+template class ParticleCollisionUpdater<float>;
+template class ParticleCollisionUpdater<double>;
+  
+}  // namespace FaceKit
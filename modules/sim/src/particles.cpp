@@ -9,6 +9,8 @@
  */
 
 #include <cassert>
+#include <initializer_list>
+#include <utility>
 
 #include "facekit/sim/particles.hpp"
 
@@ -18,6 +20,22 @@
  */
 namespace FaceKit {
   
+/**
+ *  @name   Move
+ *  @fn     static void Move(const size_t* dst, const size_t* src,
+                             const size_t& n, T* stream)
+ *  @brief  Copy `stream[src[k]]` into `stream[dst[k]]` for k in [0, n)
+ */
+template<typename T>
+static void Move(const size_t* dst,
+                 const size_t* src,
+                 const size_t& n,
+                 T* stream) {
+  for (size_t k = 0; k < n; ++k) {
+    stream[dst[k]] = stream[src[k]];
+  }
+}
+  
 #pragma mark -
 #pragma mark Initialization
   
@@ -45,10 +63,10 @@ template<typename T>
 void Particles<T>::Generate(const size_t& n_particle) {
   n_particle_ = n_particle;
   n_alive_ = 0;
-  acceleration_.resize(n_particle_);  // Default ctor set to {0, 0, 0, 0};
-  velocity_.resize(n_particle_);
-  position_.resize(n_particle_);
-  alive_.resize(n_particle_, false);  // Particle are not alive at begining
+  acceleration_.Resize(n_particle_);  // New entries are set to {0, 0, 0}
+  velocity_.Resize(n_particle_);
+  position_.Resize(n_particle_);
+  time_.resize(n_particle_, T(0.0));
 }
 
 /*
@@ -60,11 +78,30 @@ void Particles<T>::Generate(const size_t& n_particle) {
 template<typename T>
 void Particles<T>::Wake(const size_t& idx) {
   assert(n_alive_ < n_particle_);
-  this->alive_[idx] = true;
   this->Swap(idx, n_alive_);
   ++n_alive_;
 }
 
+/*
+ *  @name   Wake
+ *  @fn     void Wake(const size_t& first, const size_t& last)
+ *  @brief  Turn alive the dead particles in [first, last). When the range
+ *          starts right after the alive ones (i.e. particles generated by
+ *          an `Emitter`) no data is moved.
+ *  @param[in] first  First particle, must be dead
+ *  @param[in] last   Past-the-end particle
+ */
+template<typename T>
+void Particles<T>::Wake(const size_t& first, const size_t& last) {
+  assert(first >= n_alive_ && last <= n_particle_);
+  if (first != n_alive_) {
+    for (size_t i = first; i < last; ++i) {
+      this->Swap(i, n_alive_ + (i - first));
+    }
+  }
+  n_alive_ += last > first ? last - first : 0;
+}
+
 /*
  *  @name   Kill
  *  @fn     void Kill(const size_t& idx)
@@ -74,10 +111,53 @@ void Particles<T>::Wake(const size_t& idx) {
 template<typename T>
 void Particles<T>::Kill(const size_t& idx) {
   assert(n_alive_ > 0);
-  this->alive_[idx] = false;
   this->Swap(idx, n_alive_ - 1);
   --n_alive_;
 }
+
+/*
+ *  @name   Kill
+ *  @fn     void Kill(const std::vector<size_t>& idx)
+ *  @brief  Kill a set of particles in one compaction pass. Holes left by
+ *          the killed particles are filled with the last alive ones
+ *          (unstable partition), each property stream is then processed
+ *          once. Properties of dead particles are left unspecified.
+ *  @param[in] idx  Indices of alive particles to kill, in increasing order
+ *                  and without duplicates
+ */
+template<typename T>
+void Particles<T>::Kill(const std::vector<size_t>& idx) {
+  if (idx.empty()) {
+    return;
+  }
+  assert(idx.size() <= n_alive_ && idx.back() < n_alive_);
+  // Plan the moves: the first hole takes the last alive particle, dead
+  // particles already at the end of the range are simply dropped
+  std::vector<size_t> dst, src;
+  dst.reserve(idx.size());
+  src.reserve(idx.size());
+  size_t end = n_alive_;
+  size_t lo = 0;
+  size_t hi = idx.size();
+  while (lo < hi) {
+    if (idx[hi - 1] == end - 1) {
+      --hi;
+      --end;
+    } else {
+      dst.push_back(idx[lo++]);
+      src.push_back(--end);
+    }
+  }
+  n_alive_ = end;
+  // Apply them stream by stream
+  const size_t n = dst.size();
+  for (PropType* p : {&acceleration_, &velocity_, &position_}) {
+    Move(dst.data(), src.data(), n, p->x());
+    Move(dst.data(), src.data(), n, p->y());
+    Move(dst.data(), src.data(), n, p->z());
+  }
+  Move(dst.data(), src.data(), n, time_.data());
+}
   
   
 #pragma mark -
@@ -92,11 +172,13 @@ void Particles<T>::Kill(const size_t& idx) {
  */
 template<typename T>
 void Particles<T>::Swap(const size_t& a, const size_t& b) {
-  // Swap properties
-  std::swap(acceleration_[a], acceleration_[b]);
-  std::swap(velocity_[a], velocity_[b]);
-  std::swap(position_[a], position_[b]);
-  std::swap(alive_[a], alive_[b]);
+  // Swap properties, stream by stream
+  for (PropType* p : {&acceleration_, &velocity_, &position_}) {
+    std::swap(p->x()[a], p->x()[b]);
+    std::swap(p->y()[a], p->y()[b]);
+    std::swap(p->z()[a], p->z()[b]);
+  }
+  std::swap(time_[a], time_[b]);
 }
   
   
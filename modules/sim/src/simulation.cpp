@@ -0,0 +1,199 @@
+/**
+ *  @file   simulation.cpp
+ *  @brief Fixed time step particle simulation driver
+ *  @ingroup sim
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <cmath>
+
+#include "facekit/sim/simulation.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+/*
+ *  @name   Simulation
+ *  @fn     Simulation(const size_t& n_particle, const T& step,
+                       const size_t& max_substep = 4)
+ *  @brief  Constructor
+ *  @param[in] n_particle   Maximum number of particles
+ *  @param[in] step         Fixed time step
+ *  @param[in] max_substep  Maximum number of steps per frame
+ */
+template<typename T>
+Simulation<T>::Simulation(const size_t& n_particle,
+                          const T& step,
+                          const size_t& max_substep) :
+        front_(0),
+        pipeline_(new UpdaterPipeline<T>()),
+        pending_(false),
+        step_(step),
+        max_substep_(max_substep),
+        acc_(T(0.0)),
+        alpha_(T(0.0)),
+        time_(T(0.0)),
+        next_alpha_(T(0.0)),
+        next_time_(T(0.0)) {
+  state_[0].Generate(n_particle);
+  state_[1].Generate(n_particle);
+}
+  
+/*
+ *  @name   ~Simulation
+ *  @fn     ~Simulation()
+ *  @brief  Destructor, wait for the running steps
+ */
+template<typename T>
+Simulation<T>::~Simulation() {
+  this->Wait();
+}
+  
+#pragma mark -
+#pragma mark Usage
+  
+/*
+ *  @name   AddEmitter
+ *  @fn     void AddEmitter(Emitter<T>* emitter)
+ *  @brief  Add an emitter, called at every step before the updaters.
+ *          Takes ownership.
+ *  @param[in] emitter  Emitter to add
+ */
+template<typename T>
+void Simulation<T>::AddEmitter(Emitter<T>* emitter) {
+  this->Wait();
+  emitter_.emplace_back(emitter);
+}
+  
+/*
+ *  @name   AddUpdater
+ *  @fn     void AddUpdater(IUpdater<T>* updater)
+ *  @brief  Add an updater, updaters are fused into a single pass per step
+ *          (see `UpdaterPipeline`)
+ *  @param[in] updater  Updater to add
+ */
+template<typename T>
+void Simulation<T>::AddUpdater(IUpdater<T>* updater) {
+  this->Wait();
+  pipeline_->AddUpdater(updater);
+}
+  
+/*
+ *  @name   Advance
+ *  @fn     size_t Advance(const T& dt)
+ *  @brief  Publish the steps of the previous frame, then account `dt`
+ *          and start the resulting steps in the background
+ *  @param[in] dt Frame time
+ *  @return Number of steps started
+ */
+template<typename T>
+size_t Simulation<T>::Advance(const T& dt) {
+  this->Wait();
+  // Consume accumulated time by whole steps
+  acc_ += dt;
+  size_t n_step = static_cast<size_t>(acc_ / step_);
+  if (n_step > max_substep_) {
+    // Can not keep up, drop the excess
+    n_step = max_substep_;
+    acc_ = std::fmod(acc_, step_) + T(n_step) * step_;
+  }
+  acc_ -= T(n_step) * step_;
+  next_alpha_ = acc_ / step_;
+  next_time_ = time_ + T(n_step) * step_;
+  if (n_step == 0) {
+    alpha_ = next_alpha_;
+    return 0;
+  }
+  // Run on a copy of the published state
+  Particles<T>* back = &state_[1 - front_];
+  *back = state_[front_];
+  pending_ = true;
+  group_.Run([this, back, n_step]() {
+    for (size_t k = 0; k < n_step; ++k) {
+      this->Step(back);
+    }
+  });
+  return n_step;
+}
+  
+/*
+ *  @name   Wait
+ *  @fn     void Wait()
+ *  @brief  Wait for the running steps and publish their result
+ */
+template<typename T>
+void Simulation<T>::Wait() {
+  if (!pending_) {
+    return;
+  }
+  group_.Wait();
+  pending_ = false;
+  front_ = 1 - front_;
+  alpha_ = next_alpha_;
+  time_ = next_time_;
+}
+  
+/*
+ *  @name   Interpolate
+ *  @fn     void Interpolate(Vector3Array<T>* position) const
+ *  @brief  Position of the alive particles of the published state at
+ *          `alpha` between the previous step and the last one. Particles
+ *          are reordered when killed, therefore the previous position is
+ *          recovered from the velocity (p - v * step) rather than from an
+ *          older buffer.
+ *  @param[out] position  Interpolated positions, `get_n_alive()` entries
+ */
+template<typename T>
+void Simulation<T>::Interpolate(Vector3Array<T>* position) const {
+  const Particles<T>& s = state_[front_];
+  const size_t n = s.get_n_alive();
+  const T k = (alpha_ - T(1.0)) * step_;
+  position->Resize(n);
+  const auto& p = s.get_position();
+  const auto& v = s.get_velocity();
+  for (size_t i = 0; i < n; ++i) {
+    position->x()[i] = p.x()[i] + k * v.x()[i];
+  }
+  for (size_t i = 0; i < n; ++i) {
+    position->y()[i] = p.y()[i] + k * v.y()[i];
+  }
+  for (size_t i = 0; i < n; ++i) {
+    position->z()[i] = p.z()[i] + k * v.z()[i];
+  }
+}
+  
+#pragma mark -
+#pragma mark Private
+  
+/*
+ *  @name   Step
+ *  @fn     void Step(Particles<T>* particles)
+ *  @brief  Run one fixed step: emit, then update
+ *  @param[in,out] particles  State to advance
+ */
+template<typename T>
+void Simulation<T>::Step(Particles<T>* particles) {
+  for (const auto& e : emitter_) {
+    e->Emit(step_, particles);
+  }
+  pipeline_->Update(step_, particles);
+}
+  
+#pragma mark -
+#pragma mark Explicit instantiation
+  
+/** Float */
+template class Simulation<float>;
+/** Double */
+template class Simulation<double>;
+  
+}  // namespace FaceKit
@@ -0,0 +1,326 @@
+/**
+ *  @file   snapshot_writer.cpp
+ *  @brief Stream particle positions to disk
+ *  @ingroup sim
+ *
+ *  @author Christophe Ecabert
+ *  @date   15.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "facekit/core/logger.hpp"
+#include "facekit/sim/snapshot_writer.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/** File format version */
+static constexpr uint32_t kVersion = 1;
+  
+/**
+ *  @name   Append
+ *  @fn     static void Append(const void* data, const size_t& size,
+                               std::vector<uint8_t>* buffer)
+ *  @brief  Append raw bytes to a buffer
+ *  @param[in] data     Bytes to append
+ *  @param[in] size     Number of bytes
+ *  @param[in,out] buffer Where to append
+ */
+static void Append(const void* data,
+                   const size_t& size,
+                   std::vector<uint8_t>* buffer) {
+  const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data);
+  buffer->insert(buffer->end(), ptr, ptr + size);
+}
+  
+/**
+ *  @name   AppendVarint
+ *  @fn     static void AppendVarint(const int32_t& value,
+                                     std::vector<uint8_t>* buffer)
+ *  @brief  Append a signed value as zigzag varint
+ *  @param[in] value      Value to append
+ *  @param[in,out] buffer Where to append
+ */
+static void AppendVarint(const int32_t& value, std::vector<uint8_t>* buffer) {
+  uint32_t v = (static_cast<uint32_t>(value) << 1) ^
+               static_cast<uint32_t>(value >> 31);
+  while (v >= 0x80) {
+    buffer->push_back(static_cast<uint8_t>(v | 0x80));
+    v >>= 7;
+  }
+  buffer->push_back(static_cast<uint8_t>(v));
+}
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+/*
+ *  @name   SnapshotWriter
+ *  @fn     SnapshotWriter()
+ *  @brief  Constructor
+ */
+template<typename T>
+SnapshotWriter<T>::SnapshotWriter() : encoding_(Encoding::kRaw),
+                                      quantum_(T(1e-4)),
+                                      full_{false, false},
+                                      write_(0),
+                                      stop_(false),
+                                      error_(false) {
+}
+  
+/*
+ *  @name   ~SnapshotWriter
+ *  @fn     ~SnapshotWriter()
+ *  @brief  Destructor, close the stream if still open
+ */
+template<typename T>
+SnapshotWriter<T>::~SnapshotWriter() {
+  this->Close();
+}
+  
+#pragma mark -
+#pragma mark Usage
+  
+/*
+ *  @name   Open
+ *  @fn     int Open(const std::string& path, const Encoding& encoding,
+                     const T& quantum = T(1e-4))
+ *  @brief  Create the output file and start the writing thread
+ *  @param[in] path     Output file
+ *  @param[in] encoding Position encoding
+ *  @param[in] quantum  Precision of the `kDelta` encoding
+ *  @return -1 if error, 0 otherwise
+ */
+template<typename T>
+int SnapshotWriter<T>::Open(const std::string& path,
+                            const Encoding& encoding,
+                            const T& quantum) {
+  this->Close();
+  stream_.open(path, std::ios_base::out | std::ios_base::binary);
+  if (!stream_.is_open()) {
+    FACEKIT_LOG_ERROR("Unable to open: " << path);
+    return -1;
+  }
+  encoding_ = encoding;
+  quantum_ = quantum;
+  full_[0] = full_[1] = false;
+  write_ = 0;
+  stop_ = false;
+  error_ = false;
+  previous_.clear();
+  // Header
+  const uint8_t enc = static_cast<uint8_t>(encoding_);
+  const uint8_t size = sizeof(T);
+  stream_.write("FKPS", 4);
+  stream_.write(reinterpret_cast<const char*>(&kVersion), sizeof(kVersion));
+  stream_.write(reinterpret_cast<const char*>(&enc), 1);
+  stream_.write(reinterpret_cast<const char*>(&size), 1);
+  if (!stream_.good()) {
+    FACEKIT_LOG_ERROR("Unable to write header: " << path);
+    stream_.close();
+    return -1;
+  }
+  worker_ = std::thread(&SnapshotWriter<T>::Loop, this);
+  return 0;
+}
+  
+/*
+ *  @name   Record
+ *  @fn     int Record(const T& time, const Particles<T>& particles)
+ *  @brief  Queue the position of the alive particles for writing
+ *  @param[in] time       Simulation time
+ *  @param[in] particles  Particles to record
+ *  @return -1 if not opened or if writing failed, 0 otherwise
+ */
+template<typename T>
+int SnapshotWriter<T>::Record(const T& time, const Particles<T>& particles) {
+  if (!worker_.joinable()) {
+    return -1;
+  }
+  // Wait for a free buffer, only if the writer is two frames behind
+  const int k = write_;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [&]() { return !full_[k]; });
+    if (error_) {
+      return -1;
+    }
+  }
+  // The buffer belongs to this thread until flagged as full
+  Frame& f = frame_[k];
+  const size_t n = particles.get_n_alive();
+  const auto& pos = particles.get_position();
+  f.time = time;
+  f.n = n;
+  if (f.position.size() < n) {
+    f.position.Resize(n);
+  }
+  std::copy(pos.x(), pos.x() + n, f.position.x());
+  std::copy(pos.y(), pos.y() + n, f.position.y());
+  std::copy(pos.z(), pos.z() + n, f.position.z());
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    full_[k] = true;
+  }
+  cond_.notify_all();
+  write_ = 1 - k;
+  return 0;
+}
+  
+/*
+ *  @name   Close
+ *  @fn     int Close()
+ *  @brief  Write the pending frames, stop the writing thread and close
+ *          the file
+ *  @return -1 if any frame could not be written, 0 otherwise
+ */
+template<typename T>
+int SnapshotWriter<T>::Close() {
+  if (!worker_.joinable()) {
+    return 0;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  worker_.join();
+  stream_.flush();
+  error_ |= !stream_.good();
+  stream_.close();
+  if (error_) {
+    FACEKIT_LOG_ERROR("Unable to write particle snapshots");
+    return -1;
+  }
+  return 0;
+}
+  
+#pragma mark -
+#pragma mark Private
+  
+/*
+ *  @name   Loop
+ *  @fn     void Loop()
+ *  @brief  Body of the writing thread
+ */
+template<typename T>
+void SnapshotWriter<T>::Loop() {
+  // Frames are consumed in the order they are produced
+  int k = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [&]() { return full_[k] || stop_; });
+      if (!full_[k]) {
+        break;
+      }
+    }
+    const Frame& f = frame_[k];
+    bool keyframe = true;
+    bool ok = !error_;
+    if (ok) {
+      this->Encode(f, &keyframe);
+      const uint64_t n = f.n;
+      const uint8_t key = keyframe ? 1 : 0;
+      const uint64_t size = payload_.size();
+      stream_.write(reinterpret_cast<const char*>(&f.time), sizeof(T));
+      stream_.write(reinterpret_cast<const char*>(&n), sizeof(n));
+      stream_.write(reinterpret_cast<const char*>(&key), sizeof(key));
+      stream_.write(reinterpret_cast<const char*>(&size), sizeof(size));
+      stream_.write(reinterpret_cast<const char*>(payload_.data()),
+                    payload_.size());
+      ok = stream_.good();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      error_ |= !ok;
+      full_[k] = false;
+    }
+    cond_.notify_all();
+    k = 1 - k;
+  }
+}
+  
+/*
+ *  @name   Encode
+ *  @fn     void Encode(const Frame& frame, bool* keyframe)
+ *  @brief  Encode a frame into `payload_`
+ *  @param[in] frame      Frame to encode
+ *  @param[out] keyframe  Indicate if the frame is independent of the
+ *                        previous one
+ */
+template<typename T>
+void SnapshotWriter<T>::Encode(const Frame& frame, bool* keyframe) {
+  const size_t n = frame.n;
+  const T* axis[3] = {frame.position.x(),
+                      frame.position.y(),
+                      frame.position.z()};
+  payload_.clear();
+  *keyframe = true;
+  switch (encoding_) {
+    case Encoding::kRaw: {
+      for (const T* a : axis) {
+        Append(a, n * sizeof(T), &payload_);
+      }
+    }
+      break;
+      
+    case Encoding::kQuantized: {
+      std::vector<uint16_t> q(n);
+      for (const T* a : axis) {
+        T lo = n ? a[0] : T(0.0);
+        T hi = lo;
+        for (size_t i = 1; i < n; ++i) {
+          lo = std::min(lo, a[i]);
+          hi = std::max(hi, a[i]);
+        }
+        const T extent = hi - lo;
+        const T scale = extent > T(0.0) ? T(65535.0) / extent : T(0.0);
+        for (size_t i = 0; i < n; ++i) {
+          q[i] = static_cast<uint16_t>((a[i] - lo) * scale + T(0.5));
+        }
+        Append(&lo, sizeof(T), &payload_);
+        Append(&extent, sizeof(T), &payload_);
+        Append(q.data(), n * sizeof(uint16_t), &payload_);
+      }
+    }
+      break;
+      
+    case Encoding::kDelta: {
+      // Particles match by index only if no particle was added or removed
+      *keyframe = previous_.size() != 3 * n;
+      if (*keyframe) {
+        previous_.assign(3 * n, 0);
+      }
+      const T inv = T(1.0) / quantum_;
+      int32_t* prev = previous_.data();
+      for (const T* a : axis) {
+        for (size_t i = 0; i < n; ++i) {
+          const int32_t q = static_cast<int32_t>(std::lround(a[i] * inv));
+          AppendVarint(q - prev[i], &payload_);
+          prev[i] = q;
+        }
+        prev += n;
+      }
+    }
+      break;
+  }
+}
+  
+#pragma mark -
+#pragma mark Explicit instantiation
+  
+/** Float */
+template class SnapshotWriter<float>;
+/** Double */
+template class SnapshotWriter<double>;
+  
+}  // namespace FaceKit
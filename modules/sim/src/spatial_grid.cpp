@@ -0,0 +1,134 @@
+/**
+ *  @file   spatial_grid.cpp
+ *  @brief Uniform spatial hash grid for particle neighbor queries
+ *  @ingroup sim
+ *
+ *  @author Christophe Ecabert
+ *  @date   14.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/sim/spatial_grid.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+
+/** Number of points processed by one parallel task */
+static constexpr size_t kGrain = 4096;
+
+#pragma mark -
+#pragma mark Initialisation
+
+/*
+ *  @name   SpatialGrid
+ *  @fn     explicit SpatialGrid(const T& cell_size)
+ *  @brief  Constructor
+ *  @param[in] cell_size  Length of the cells' side, queries are limited to
+ *                        a radius of at most one cell
+ */
+template<typename T>
+SpatialGrid<T>::SpatialGrid(const T& cell_size) : cell_(cell_size),
+                                                  inv_cell_(T(1.0) / cell_size),
+                                                  mask_(0) {
+  assert(cell_size > T(0.0));
+}
+
+#pragma mark -
+#pragma mark Usage
+
+/*
+ *  @name   Build
+ *  @fn     void Build(const Vector3Array<T>& points, const size_t& n)
+ *  @brief  Index the first `n` points (i.e. the alive particles)
+ *  @param[in] points Points to index, copied
+ *  @param[in] n      Number of points to index
+ */
+template<typename T>
+void SpatialGrid<T>::Build(const Vector3Array<T>& points, const size_t& n) {
+  assert(n <= points.size());
+  auto& pool = ThreadPool::Get();
+  // At least one bucket per point, power of two
+  size_t n_bucket = 1;
+  while (n_bucket < n) {
+    n_bucket <<= 1;
+  }
+  mask_ = n_bucket - 1;
+  index_.resize(n);
+  bucket_.resize(n);
+  point_.Resize(n);
+  const T* x = points.x();
+  const T* y = points.y();
+  const T* z = points.z();
+  // Count points per bucket
+  std::unique_ptr<std::atomic<uint32_t>[]> count;
+  count.reset(new std::atomic<uint32_t>[n_bucket]);
+  pool.ParallelFor(0, n_bucket, kGrain, [&](const size_t& first,
+                                            const size_t& last) {
+    for (size_t b = first; b < last; ++b) {
+      count[b].store(0, std::memory_order_relaxed);
+    }
+  });
+  pool.ParallelFor(0, n, kGrain, [&](const size_t& first,
+                                     const size_t& last) {
+    for (size_t i = first; i < last; ++i) {
+      const size_t b = this->Bucket(this->Cell(x[i]),
+                                    this->Cell(y[i]),
+                                    this->Cell(z[i]));
+      bucket_[i] = static_cast<uint32_t>(b);
+      count[b].fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+  // Exclusive prefix sum, the counters become the insertion cursors
+  start_.resize(n_bucket + 1);
+  uint32_t offset = 0;
+  for (size_t b = 0; b < n_bucket; ++b) {
+    start_[b] = offset;
+    offset += count[b].load(std::memory_order_relaxed);
+    count[b].store(start_[b], std::memory_order_relaxed);
+  }
+  start_[n_bucket] = offset;
+  // Scatter
+  pool.ParallelFor(0, n, kGrain, [&](const size_t& first,
+                                     const size_t& last) {
+    for (size_t i = first; i < last; ++i) {
+      const uint32_t k = count[bucket_[i]].fetch_add(1,
+                                                    std::memory_order_relaxed);
+      index_[k] = static_cast<uint32_t>(i);
+    }
+  });
+  // Order within a bucket depends on the schedule, sort it so the result is
+  // reproducible, then gather the points in bucket order
+  T* px = point_.x();
+  T* py = point_.y();
+  T* pz = point_.z();
+  pool.ParallelFor(0, n_bucket, kGrain, [&](const size_t& first,
+                                            const size_t& last) {
+    for (size_t b = first; b < last; ++b) {
+      std::sort(index_.begin() + start_[b], index_.begin() + start_[b + 1]);
+      for (uint32_t k = start_[b]; k < start_[b + 1]; ++k) {
+        px[k] = x[index_[k]];
+        py[k] = y[index_[k]];
+        pz[k] = z[index_[k]];
+      }
+    }
+  });
+}
+
+#pragma mark -
+#pragma mark Explicit instantiation
+
+/** Float */
+template class SpatialGrid<float>;
+/** Double */
+template class SpatialGrid<double>;
+
+}  // namespace FaceKit
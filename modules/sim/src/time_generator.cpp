@@ -8,8 +8,7 @@
  *  Copyright © 2018 Christophe Ecabert. All rights reserved.
  */
 
-#include <random>
-
+#include "facekit/core/thread_pool.hpp"
 #include "facekit/sim/time_generator.hpp"
 
 /**
@@ -18,6 +17,9 @@
  */
 namespace FaceKit {
   
+/** Number of particles generated by one parallel task */
+static constexpr size_t kGrain = 4096;
+  
 #pragma mark -
 #pragma mark Initialisation
   
@@ -52,14 +54,17 @@ void TimeGenerator<T>::Generate(const T& dt,
                                 const size_t start_id,
                                 const size_t& end_id,
                                 Particles<T>* particles) {
-  // Create distribution
-  std::uniform_real_distribution<T> dist;
-  std::mt19937 gen;
-  // Generate particles
-  auto& time = particles->get_time();
-  for (size_t i = start_id; i < end_id; ++i) {
-    time[i] = min_ + dist(gen) * delta_;
-  }
+  // Generate particles, draw uniform samples in place then map them into
+  // the lifetime range
+  T* time = particles->get_time().data();
+  const uint32_t step = this->NextStep();
+  ThreadPool::Get().ParallelFor(start_id, end_id, kGrain,
+                                [&](const size_t& first, const size_t& last) {
+    this->Uniform(step, first, last, time);
+    for (size_t i = first; i < last; ++i) {
+      time[i] = min_ + time[i] * delta_;
+    }
+  });
 }
   
 #pragma mark -
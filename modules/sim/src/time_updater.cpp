@@ -17,26 +17,53 @@
 namespace FaceKit {
   
 /*
- *  @name   Update
- *  @fn     void Update(const T& dt, Particles<T>* particles)
- *  @brief  Update particles hold by a given container.
- *  @param[in] dt Time variation
+ *  @name   UpdateBlock
+ *  @fn     void UpdateBlock(const T& dt, const size_t& first,
+                             const size_t& last, Particles<T>* particles,
+                             std::vector<size_t>* expired) override
+ *  @brief  Update the lifetime of the alive particles in [first, last)
+ *  @param[in] dt       Time variation
+ *  @param[in] first    First particle
+ *  @param[in] last     Past-the-end particle
  *  @param[in,out] particles  Particles to be updated.
+ *  @param[out] expired Particles to kill, appended in increasing order
  */
 template<typename T>
-void TimeUpdater<T>::Update(const T& dt, Particles<T>* particles) {
-  auto end = particles->get_n_particle();
-  auto& time = particles->get_time();
-  for (size_t i = 0; i < end; ++i) {
-    // Update time for particle `i`
+void TimeUpdater<T>::UpdateBlock(const T& dt,
+                                 const size_t& first,
+                                 const size_t& last,
+                                 Particles<T>* particles,
+                                 std::vector<size_t>* expired) {
+  TimeUpdater<T>::Age(dt, first, last, particles->get_time().data(), expired);
+}
+
+/*
+ *  @name   Age
+ *  @fn     static void Age(const T& dt, const size_t& first,
+                            const size_t& last, T* time,
+                            std::vector<size_t>* expired)
+ *  @brief  Decrease the lifetime of the particles in [first, last) and
+ *          list the ones reaching the end of their life
+ *  @param[in] dt       Time variation
+ *  @param[in] first    First particle
+ *  @param[in] last     Past-the-end particle
+ *  @param[in,out] time Lifetime stream
+ *  @param[out] expired Expired particles, appended in increasing order
+ */
+template<typename T>
+void TimeUpdater<T>::Age(const T& dt,
+                         const size_t& first,
+                         const size_t& last,
+                         T* time,
+                         std::vector<size_t>* expired) {
+  // Update time, plain loop over the stream
+  for (size_t i = first; i < last; ++i) {
     time[i] -= dt;
-    // Does particle reach end of lifetime ?
+  }
+  // Does particle reach end of lifetime ? Range is still in cache
+  for (size_t i = first; i < last; ++i) {
     if (time[i] < T(0.0)) {
-      // Kill particles
-      particles->Kill(i);
-      end = (particles->get_n_alive() < particles->get_n_particle() ?
-             particles->get_n_alive() :
-             particles->get_n_particle());
+      expired->push_back(i);
     }
   }
 }
@@ -0,0 +1,57 @@
+/**
+ *  @file   updater.cpp
+ *  @brief Particle updater interface
+ *  @ingroup sim
+ *
+ *  @author Christophe Ecabert
+ *  @date   01.10.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include "facekit/core/thread_pool.hpp"
+#include "facekit/sim/updater.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/** Number of particles processed by one parallel task */
+static constexpr size_t kGrain = 4096;
+  
+/*
+ *  @name   Update
+ *  @fn     virtual void Update(const T& dt, Particles<T>* particles)
+ *  @brief  Update particles hold by a given container. Calls `Prepare`,
+ *          then `UpdateBlock` on blocks of alive particles split over the
+ *          `ThreadPool` and finally kills the expired particles.
+ *  @param[in] dt Time variation
+ *  @param[in,out] particles  Particles to be updated.
+ */
+template<typename T>
+void IUpdater<T>::Update(const T& dt, Particles<T>* particles) {
+  using Index = std::vector<size_t>;
+  this->Prepare(dt, particles);
+  const Index expired = ThreadPool::Get().ParallelReduce(
+          size_t(0), particles->get_n_alive(), kGrain, Index(),
+          [&](const size_t& first, const size_t& last) {
+            Index idx;
+            this->UpdateBlock(dt, first, last, particles, &idx);
+            return idx;
+          },
+          [](Index lhs, const Index& rhs) {
+            lhs.insert(lhs.end(), rhs.begin(), rhs.end());
+            return lhs;
+          });
+  // Kill particles reaching end of lifetime
+  particles->Kill(expired);
+}
+  
+#pragma mark -
+#pragma mark Explicit instantiation
+  
+template class IUpdater<float>;
+template class IUpdater<double>;
+  
+}  // namespace FaceKit
@@ -0,0 +1,104 @@
+/**
+ *  @file   updater_pipeline.cpp
+ *  @brief Chain of particle updaters applied block by block
+ *  @ingroup sim
+ *
+ *  @author Christophe Ecabert
+ *  @date   13.11.18
+ *  Copyright © 2018 Christophe Ecabert. All rights reserved.
+ */
+
+#include <algorithm>
+
+#include "facekit/sim/updater_pipeline.hpp"
+
+/**
+ *  @namespace  FaceKit
+ *  @brief      Development space
+ */
+namespace FaceKit {
+  
+/** Number of particles in a tile, the streams of a tile fit in L1 */
+static constexpr size_t kTile = 512;
+  
+#pragma mark -
+#pragma mark Initialisation
+  
+/*
+ *  @name   ~UpdaterPipeline
+ *  @fn     ~UpdaterPipeline()
+ *  @brief  Destructor
+ */
+template<typename T>
+UpdaterPipeline<T>::~UpdaterPipeline() = default;
+  
+#pragma mark -
+#pragma mark Usage
+  
+/*
+ *  @name   AddUpdater
+ *  @fn     void AddUpdater(IUpdater<T>* updater)
+ *  @brief  Append a given `updater` to this pipeline, updaters are applied
+ *          in insertion order.
+ *  @param[in] updater  Updater to add to this pipeline.
+ */
+template<typename T>
+void UpdaterPipeline<T>::AddUpdater(IUpdater<T>* updater) {
+  upd_.push_back(RefPtr<IUpdater<T>>::Share(updater));
+}
+  
+/*
+ *  @name   Prepare
+ *  @fn     void Prepare(const T& dt, Particles<T>* particles) override
+ *  @brief  Prepare every updater
+ *  @param[in] dt Time variation
+ *  @param[in,out] particles  Particles to be updated.
+ */
+template<typename T>
+void UpdaterPipeline<T>::Prepare(const T& dt, Particles<T>* particles) {
+  for (const auto& u : upd_) {
+    u->Prepare(dt, particles);
+  }
+}
+  
+/*
+ *  @name   UpdateBlock
+ *  @fn     void UpdateBlock(const T& dt, const size_t& first,
+                             const size_t& last, Particles<T>* particles,
+                             std::vector<size_t>* expired) override
+ *  @brief  Apply every updater tile by tile on [first, last)
+ *  @param[in] dt       Time variation
+ *  @param[in] first    First particle
+ *  @param[in] last     Past-the-end particle
+ *  @param[in,out] particles  Particles to be updated.
+ *  @param[out] expired Particles to kill, appended in increasing order
+ */
+template<typename T>
+void UpdaterPipeline<T>::UpdateBlock(const T& dt,
+                                     const size_t& first,
+                                     const size_t& last,
+                                     Particles<T>* particles,
+                                     std::vector<size_t>* expired) {
+  for (size_t b = first; b < last; b += kTile) {
+    const size_t e = std::min(last, b + kTile);
+    const size_t n_expired = expired->size();
+    for (const auto& u : upd_) {
+      u->UpdateBlock(dt, b, e, particles, expired);
+    }
+    // Several updaters can expire particles of the same tile, keep the list
+    // ordered and without duplicates
+    if (upd_.size() > 1 && expired->size() > n_expired) {
+      auto begin = expired->begin() + n_expired;
+      std::sort(begin, expired->end());
+      expired->erase(std::unique(begin, expired->end()), expired->end());
+    }
+  }
+}
+  
+#pragma mark -
+#pragma mark Explicit instantiation
+  
+template class UpdaterPipeline<float>;
+template class UpdaterPipeline<double>;
+  
+}  // namespace FaceKit
@@ -8,9 +8,7 @@
  *  Copyright © 2018 Christophe Ecabert. All rights reserved.
  */
 
-#include <random>
-
-
+#include "facekit/core/thread_pool.hpp"
 #include "facekit/sim/velocity_generator.hpp"
 
 /**
@@ -19,6 +17,9 @@
  */
 namespace FaceKit {
   
+/** Number of particles generated by one parallel task */
+static constexpr size_t kGrain = 4096;
+  
 #pragma mark -
 #pragma mark Initialisation
   
@@ -53,16 +54,22 @@ void VelocityGenerator<T>::Generate(const T& dt,
                                        const size_t start_id,
                                        const size_t& end_id,
                                        Particles<T>* particles) {
-  // Create distribution
-  std::uniform_real_distribution<T> dist;
-  std::mt19937 gen;
-  // Generate particles
+  // Generate particles, draw uniform samples in place then map them into
+  // the velocity range
   auto& vel = particles->get_velocity();
-  for (size_t i = start_id; i < end_id; ++i) {
-    vel[i].x_ = min_.x_ + dist(gen) * delta_.x_;
-    vel[i].y_ = min_.y_ + dist(gen) * delta_.y_;
-    vel[i].z_ = min_.z_ + dist(gen) * delta_.z_;
-  }
+  T* vx = vel.x();
+  T* vy = vel.y();
+  T* vz = vel.z();
+  const uint32_t step = this->NextStep();
+  ThreadPool::Get().ParallelFor(start_id, end_id, kGrain,
+                                [&](const size_t& first, const size_t& last) {
+    this->Uniform(step, first, last, vx, vy, vz);
+    for (size_t i = first; i < last; ++i) {
+      vx[i] = min_.x_ + vx[i] * delta_.x_;
+      vy[i] = min_.y_ + vy[i] * delta_.y_;
+      vz[i] = min_.z_ + vz[i] * delta_.z_;
+    }
+  });
 }
   
 #pragma mark -